@@ -0,0 +1,793 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Throughput and latency benchmark of the logger, one mode per build.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    bench_main.c
+ * @brief   Logger benchmark app (bench/), machine-readable results on the console
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Each pass clears the log, writes BENCH_WARMUP_RECORDS untimed records,
+ *          then submits BENCH_RECORDS sample records as fast as the ring takes
+ *          them and syncs. Append latency is submit to the writer's append of the
+ *          record (its block group in batch mode), so it includes ring and batch
+ *          wait. Every pass prints one line "BENCH {json}"; the run ends with
+ *          "BENCH_DONE". tools/enc_log_bench.py collects them. With
+ *          BENCH_CURRENT_MA every pass runs once at each OPTIGA current limit;
+ *          optiga_uj_per_record_max is the limit times BENCH_VDD_MV over the
+ *          OPTIGA busy time, an upper bound where no power meter is fitted.
+ *
+ * @note    Workloads: every pass runs once per record size (BENCH_RECORD_SIZES) and
+ *          sync policy (BENCH_SYNC_EVERY), the same for every storage build, so
+ *          backends compare on identical input. With BENCH_POWER_CUT the run ends
+ *          with a software reset in the middle of a write burst; the next boot
+ *          prints "BENCH_CUT {json}" with the mount and recovery time and how much
+ *          of the synced log came back, then "BENCH_DONE".
+ *
+ * @note    BENCH_CRASH_CYCLES (LOG_CRASH_TEST) ends the run with crash cycles
+ *          instead: each one clears the log, writes synced bursts while counting
+ *          the passes through the crash points of log_crash.h, then arms a random
+ *          point and keeps writing until it resets the chip. The boot after it
+ *          scans the log and prints "BENCH_CRASH {json}": recovery time, records
+ *          lost, seq gaps, undecryptable units. The last boot prints the totals as
+ *          "BENCH_CRASH_DONE {json}", then "BENCH_DONE".
+ *
+ * @note    With LOG_PM (BENCH_PM) the logger runs under esp_pm and every line
+ *          also carries the energy per record, estimated from the time the clocks
+ *          were held (store I/O, OPTIGA I2C) and spent in light sleep. To see the
+ *          sleep of a battery-powered logger, pace the records with
+ *          BENCH_INTERVAL_MS instead of submitting them as fast as possible.
+ *
+ * @note    With LOG_PSRAM (BENCH_PSRAM) the bulk buffers are in PSRAM; psram_bytes
+ *          says how much. Compare the throughput against an internal RAM build.
+ *
+ * @note    Before the passes, "BENCH_SIMD {json}" times the keystream XOR and
+ *          block copy kernels of log_simd.h against the scalar XOR and memcpy.
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_app_desc.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#include "optiga_entropy.h"
+#include "optiga_trust.h"
+
+#include "enc_log.h"
+#include "log_crash.h"
+#include "log_pm.h"
+#include "log_reader.h"
+#include "log_record.h"
+#include "log_simd.h"
+#include "log_wear.h"
+
+// Timed records per pass
+#ifndef BENCH_RECORDS
+#define BENCH_RECORDS           512
+#endif
+// Untimed records first: key epoch, IV nonce, file allocation
+#ifndef BENCH_WARMUP_RECORDS
+#define BENCH_WARMUP_RECORDS    16
+#endif
+#ifndef BENCH_PASSES
+#define BENCH_PASSES            3
+#endif
+#define BENCH_SYNC_TIMEOUT_MS   30000
+// Record sizes in bytes, each a workload (0: the sample record as encoded). Other sizes
+// cut the sample record or pad it with zeros, up to PLAINTEXT_MAX
+#ifndef BENCH_RECORD_SIZES
+#define BENCH_RECORD_SIZES      0
+#endif
+// Sync policies, each a workload: enc_log_sync() after every N records (0: once per pass)
+#ifndef BENCH_SYNC_EVERY
+#define BENCH_SYNC_EVERY        0
+#endif
+// Wait between two timed records in ms (0: as fast as the ring takes them)
+#ifndef BENCH_INTERVAL_MS
+#define BENCH_INTERVAL_MS       0
+#endif
+// Injected power cut at the end of the run (software reset, see BENCH_CUT_*)
+#ifndef BENCH_POWER_CUT
+#define BENCH_POWER_CUT         0
+#endif
+#define BENCH_CUT_MAGIC         0x43555442u     // "BCUT"
+#define BENCH_CUT_SYNC_EVERY    16
+#define BENCH_CUT_MAX_SYNCS     16
+#define BENCH_CUT_JITTER_MS     20
+// Crash cycles at the end of the run (0: none), bursts as for the power cut
+#ifndef BENCH_CRASH_CYCLES
+#define BENCH_CRASH_CYCLES      0
+#endif
+#define BENCH_CRASH_MAGIC       0x43524342u     // "BCRC"
+// Armed records written before a cycle counts as not fired, per unarmed one
+#define BENCH_CRASH_ARMED_X     4
+#if BENCH_CRASH_CYCLES > 0 && !LOG_CRASH_TEST
+#error "BENCH_CRASH_CYCLES needs LOG_CRASH_TEST"
+#endif
+#if BENCH_CRASH_CYCLES > 0 && BENCH_POWER_CUT
+#error "BENCH_CRASH_CYCLES and BENCH_POWER_CUT both end the run with a reset, pick one"
+#endif
+// Latency histogram: bucket i counts [2^i, 2^(i+1)) us, the last one everything above
+#define BENCH_HIST_BUCKETS      22
+// XOR / copy kernels (log_simd.h): bytes per call and calls, timed once per run
+#define BENCH_SIMD_BYTES        4096
+#define BENCH_SIMD_ITERATIONS   256
+// OPTIGA supply for the energy bound
+#ifndef BENCH_VDD_MV
+#define BENCH_VDD_MV            3300
+#endif
+
+#ifndef BENCH_MODE_NAME
+#define BENCH_MODE_NAME         "record"
+#endif
+#ifndef BENCH_STORAGE_NAME
+#define BENCH_STORAGE_NAME      "flash"
+#endif
+
+// Timed records use seq 1..BENCH_RECORDS, warm-up records the seqs after them
+#define BENCH_WARMUP_SEQ        (BENCH_RECORDS + 1)
+#define BENCH_NO_LATENCY        UINT32_MAX
+
+// --------------------
+// Globals
+// --------------------
+static const char *TAG = "BENCH";
+static int64_t s_submit_us[BENCH_RECORDS];
+static uint32_t s_latency_us[BENCH_RECORDS];    // written by the writer task
+#ifdef BENCH_CURRENT_MA
+static const uint8_t s_current_ma[] = { BENCH_CURRENT_MA };
+#endif
+static const uint16_t s_record_sizes[] = { BENCH_RECORD_SIZES };
+static const uint16_t s_sync_every[] = { BENCH_SYNC_EVERY };
+
+typedef struct {
+    uint32_t magic;
+    uint32_t synced_bytes;      // log size after the last enc_log_sync() before the cut
+    uint32_t synced_records;
+    uint32_t unsynced_records;  // submitted after it
+    uint32_t cut_after_ms;      // wait between the last submit and the reset
+} bench_cut_t;
+
+// Not initialised at boot: carries the cut through the software reset
+static RTC_NOINIT_ATTR bench_cut_t s_cut;
+
+#if BENCH_CRASH_CYCLES > 0
+typedef struct {
+    uint32_t magic;
+    uint32_t cycle;             // cycles started
+    uint32_t first_seq;         // first record of the cycle
+    uint32_t synced_seq;        // last record an enc_log_sync() returned for (0: none)
+    uint32_t submitted_seq;     // last record submitted (set before the submit)
+    // Totals over the cycles
+    uint32_t fired[LOG_CRASH_POINTS];
+    uint32_t not_fired;         // cycles without a reset: point not reached, sync timed out
+    uint32_t inconsistent;      // cycles with gaps, undecryptable units or lost synced records
+    uint32_t lost_synced;
+    uint32_t lost_unsynced;
+    uint32_t lost_unsynced_max;
+    uint32_t recover_ms;        // boot mount and open
+    uint32_t recover_ms_max;
+} bench_crash_t;
+
+// Not initialised at boot: carries the cycles through their resets
+static RTC_NOINIT_ATTR bench_crash_t s_crash;
+#endif
+
+typedef struct {
+    uint16_t record_size;       // 0: sample record as encoded
+    uint16_t sync_every;        // 0: one sync at the end of the pass
+} bench_workload_t;
+
+typedef struct {
+    uint64_t elapsed_us;
+    uint32_t record_bytes;
+    uint32_t appended;
+    uint32_t log_bytes;
+    uint32_t optiga_requests;
+    uint32_t dropped;
+    uint32_t errors;
+    uint32_t p50_us;
+    uint32_t p95_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+    uint32_t hist[BENCH_HIST_BUCKETS];
+    uint32_t syncs;             // enc_log_sync() calls of the sync policy
+    uint32_t current_ma;
+    uint32_t optiga_mean_us;
+    uint64_t optiga_busy_us;    // mean times samples on the log instances
+    uint64_t store_bytes;       // bytes passed to the log store (log_wear.h)
+    uint64_t flash_programmed;  // bytes programmed on the storage partition
+    uint64_t flash_erased;      // bytes erased on the storage partition
+#if LOG_PM
+    double energy_uj;           // estimate of log_pm_energy_uj()
+    uint64_t clocks_held_us;    // store I/O and I2C transfers under a lock
+    uint64_t sleep_us;          // light sleep
+#endif
+} bench_result_t;
+
+// --------------------
+// Measurement
+// --------------------
+static void on_append(uint32_t first_seq, uint32_t count, void *ctx)
+{
+    (void)ctx;
+    const int64_t now_us = esp_timer_get_time();
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t seq = first_seq + i;
+        if (seq >= 1 && seq <= BENCH_RECORDS) {
+            s_latency_us[seq - 1] = (uint32_t)(now_us - s_submit_us[seq - 1]);
+        }
+    }
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    const uint32_t x = *(const uint32_t *)a;
+    const uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest rank of the sorted latencies
+static uint32_t percentile(const uint32_t *sorted, uint32_t n, uint32_t pct)
+{
+    if (n == 0) {
+        return 0;
+    }
+    const uint32_t rank = (pct * n + 99) / 100;
+    return sorted[(rank > 0) ? rank - 1 : 0];
+}
+
+// OPTIGA requests on the log instances plus TRNG refills of the entropy pool
+static uint32_t optiga_requests(void)
+{
+    enc_log_stats_t st;
+    optiga_entropy_stats_t pool;
+    enc_log_get_stats(&st);
+    optiga_entropy_get_stats(&pool);
+    return st.optiga_samples + pool.refills + pool.refill_errors;
+}
+
+static uint32_t hist_bucket(uint32_t us)
+{
+    uint32_t b = 0;
+    while (us > 1 && b < BENCH_HIST_BUCKETS - 1) {
+        us >>= 1;
+        b++;
+    }
+    return b;
+}
+
+static bool submit_sample(uint32_t seq, uint16_t record_size, uint32_t *bytes)
+{
+    uint8_t msg[PLAINTEXT_MAX] = {0};
+    size_t len = log_record_encode(msg, sizeof(msg), LOG_RECORD_FORMAT, seq,
+                                   (uint64_t)(esp_timer_get_time() / 1000));
+    if (len == 0) {
+        return false;
+    }
+    if (record_size > 0) {
+        len = (record_size < PLAINTEXT_MAX) ? record_size : PLAINTEXT_MAX;
+    }
+    // Wait for room instead of counting drops: the writer sets the pace
+    enc_log_stats_t st;
+    enc_log_get_stats(&st);
+    while (st.ring_depth >= LOG_RING_SLOTS - 1) {
+        vTaskDelay(1);
+        enc_log_get_stats(&st);
+    }
+    if (seq >= 1 && seq <= BENCH_RECORDS) {
+        s_submit_us[seq - 1] = esp_timer_get_time();
+    }
+    *bytes += (uint32_t)len;
+    return enc_log_submit(msg, len, seq, false);
+}
+
+static bool run_pass(const bench_workload_t *w, bench_result_t *res)
+{
+    memset(res, 0, sizeof(*res));
+    enc_log_clear();
+    uint32_t warmup_bytes = 0;
+    for (uint32_t i = 0; i < BENCH_WARMUP_RECORDS; i++) {
+        submit_sample(BENCH_WARMUP_SEQ + i, w->record_size, &warmup_bytes);
+    }
+    if (!enc_log_sync(BENCH_SYNC_TIMEOUT_MS)) {
+        ESP_LOGE(TAG, "warm-up sync timed out");
+        return false;
+    }
+
+    for (uint32_t i = 0; i < BENCH_RECORDS; i++) {
+        s_latency_us[i] = BENCH_NO_LATENCY;
+    }
+    enc_log_stats_t before;
+    enc_log_reset_latency();
+    enc_log_get_stats(&before);
+    log_wear_stats_t wear_before;
+    log_wear_get_stats(&wear_before, 0);
+    const uint32_t requests_before = optiga_requests();
+    const uint32_t size_before = enc_log_size();
+#if LOG_PM
+    log_pm_stats_t pm_before;
+    log_pm_get_stats(&pm_before);
+#endif
+
+    const int64_t t0 = esp_timer_get_time();
+    bool synced = true;
+    for (uint32_t seq = 1; seq <= BENCH_RECORDS; seq++) {
+        if (!submit_sample(seq, w->record_size, &res->record_bytes)) {
+            res->dropped++;
+        }
+        if (w->sync_every > 0 && seq % w->sync_every == 0 && seq < BENCH_RECORDS) {
+            synced = enc_log_sync(BENCH_SYNC_TIMEOUT_MS) && synced;
+            res->syncs++;
+        }
+        if (BENCH_INTERVAL_MS > 0) {
+            vTaskDelay(pdMS_TO_TICKS(BENCH_INTERVAL_MS));
+        }
+    }
+    synced = enc_log_sync(BENCH_SYNC_TIMEOUT_MS) && synced;
+    res->syncs++;
+    res->elapsed_us = (uint64_t)(esp_timer_get_time() - t0);
+#if LOG_PM
+    log_pm_stats_t pm_after;
+    log_pm_get_stats(&pm_after);
+    res->energy_uj = log_pm_energy_uj(&pm_before, &pm_after);
+    res->clocks_held_us = (pm_after.io_us - pm_before.io_us) + (pm_after.i2c_us - pm_before.i2c_us);
+    res->sleep_us = pm_after.sleep_us - pm_before.sleep_us;
+#endif
+
+    enc_log_stats_t after;
+    enc_log_get_stats(&after);
+    res->optiga_requests = optiga_requests() - requests_before;
+    res->log_bytes = enc_log_size() - size_before;
+    res->dropped += after.dropped - before.dropped;
+    res->errors = after.write_errors - before.write_errors;
+    res->current_ma = after.current_ma;
+    res->optiga_mean_us = after.optiga_mean_us;
+    res->optiga_busy_us = (uint64_t)after.optiga_mean_us * after.optiga_samples;
+    log_wear_stats_t wear_after;
+    log_wear_get_stats(&wear_after, 0);
+    res->store_bytes = wear_after.logical_bytes - wear_before.logical_bytes;
+    res->flash_programmed = wear_after.programmed_bytes - wear_before.programmed_bytes;
+    res->flash_erased = wear_after.erased_bytes - wear_before.erased_bytes;
+
+    // Records without a latency were never appended (write errors)
+    for (uint32_t i = 0; i < BENCH_RECORDS; i++) {
+        if (s_latency_us[i] != BENCH_NO_LATENCY) {
+            res->hist[hist_bucket(s_latency_us[i])]++;
+            s_latency_us[res->appended++] = s_latency_us[i];
+        }
+    }
+    qsort(s_latency_us, res->appended, sizeof(s_latency_us[0]), compare_u32);
+    res->p50_us = percentile(s_latency_us, res->appended, 50);
+    res->p95_us = percentile(s_latency_us, res->appended, 95);
+    res->p99_us = percentile(s_latency_us, res->appended, 99);
+    res->max_us = (res->appended > 0) ? s_latency_us[res->appended - 1] : 0;
+    if (!synced) {
+        ESP_LOGE(TAG, "sync timed out");
+    }
+    return synced;
+}
+
+// One JSON object per line, so the host can parse the console stream
+static void print_result(unsigned pass, const bench_workload_t *w, const bench_result_t *res)
+{
+    const esp_app_desc_t *app = esp_app_get_description();
+    const double seconds = (res->elapsed_us > 0) ? (double)res->elapsed_us / 1e6 : 1.0;
+    // mV x mA x us = pJ
+    const double uj = (double)BENCH_VDD_MV * res->current_ma * (double)res->optiga_busy_us / 1e6;
+    enc_log_stats_t st;
+    enc_log_get_stats(&st);
+    // Histogram up to its last non-empty bucket
+    char hist[BENCH_HIST_BUCKETS * 11 + 3] = "[";
+    size_t buckets = BENCH_HIST_BUCKETS;
+    while (buckets > 1 && res->hist[buckets - 1] == 0) {
+        buckets--;
+    }
+    for (size_t i = 0; i < buckets; i++) {
+        const size_t used = strlen(hist);
+        snprintf(hist + used, sizeof(hist) - used, "%s%lu", i ? "," : "",
+                 (unsigned long)res->hist[i]);
+    }
+    const size_t used = strlen(hist);
+    snprintf(hist + used, sizeof(hist) - used, "]");
+    // Energy keys only in LOG_PM builds, the host treats missing ones as not measured
+    char pm[96] = "";
+#if LOG_PM
+    const double elapsed = (res->elapsed_us > 0) ? (double)res->elapsed_us : 1.0;
+    snprintf(pm, sizeof(pm), ",\"uj_per_record\":%.2f,\"clocks_held_pct\":%.1f,\"light_sleep_pct\":%.1f",
+             res->energy_uj / BENCH_RECORDS, 100.0 * res->clocks_held_us / elapsed,
+             100.0 * res->sleep_us / elapsed);
+#endif
+    printf("BENCH {\"app\":\"%s\",\"idf\":\"%s\",\"mode\":\"%s\",\"storage\":\"%s\","
+           "\"batch_records\":%u,\"record_size\":%u,\"sync_every\":%u,\"syncs\":%lu,"
+           "\"pass\":%u,\"records\":%u,\"appended\":%lu,\"elapsed_us\":%llu,"
+           "\"records_per_s\":%.1f,\"bytes_per_s\":%.1f,\"log_bytes_per_s\":%.1f,"
+           "\"latency_us\":{\"p50\":%lu,\"p95\":%lu,\"p99\":%lu,\"max\":%lu},"
+           "\"optiga_requests_per_record\":%.3f,\"log_bytes_per_record\":%.2f,"
+           "\"current_ma\":%lu,\"optiga_mean_us\":%lu,\"optiga_uj_per_record_max\":%.2f,"
+           "\"dropped\":%lu,\"errors\":%lu,\"write_amplification\":%.3f,"
+           "\"flash_erased_per_record\":%.1f,\"flash_programmed_per_record\":%.1f,"
+           "\"latency_hist_log2_us\":%s,\"boot_mount_ms\":%lu,\"boot_open_ms\":%lu,"
+           "\"interval_ms\":%u,\"buffer_bytes\":%lu,\"psram_bytes\":%lu%s}\n",
+           app->version, app->idf_ver, BENCH_MODE_NAME, BENCH_STORAGE_NAME,
+           (unsigned)(LOG_BATCH_MODE ? LOG_BATCH_RECORDS : 1), (unsigned)w->record_size,
+           (unsigned)w->sync_every, (unsigned long)res->syncs, pass,
+           (unsigned)BENCH_RECORDS, (unsigned long)res->appended,
+           (unsigned long long)res->elapsed_us, BENCH_RECORDS / seconds,
+           res->record_bytes / seconds, res->log_bytes / seconds,
+           (unsigned long)res->p50_us, (unsigned long)res->p95_us,
+           (unsigned long)res->p99_us, (unsigned long)res->max_us,
+           (double)res->optiga_requests / BENCH_RECORDS,
+           (double)res->log_bytes / BENCH_RECORDS, (unsigned long)res->current_ma,
+           (unsigned long)res->optiga_mean_us, uj / BENCH_RECORDS, (unsigned long)res->dropped,
+           (unsigned long)res->errors,
+           res->store_bytes ? (double)res->flash_programmed / res->store_bytes : 0.0,
+           (double)res->flash_erased / BENCH_RECORDS,
+           (double)res->flash_programmed / BENCH_RECORDS, hist,
+           (unsigned long)st.boot_mount_ms, (unsigned long)st.boot_open_ms,
+           (unsigned)BENCH_INTERVAL_MS, (unsigned long)st.buffer_bytes,
+           (unsigned long)st.buffer_psram_bytes, pm);
+    fflush(stdout);
+}
+
+#if BENCH_POWER_CUT
+// Synced bursts, then records in flight and a reset at a random point of their write.
+// Only a software reset: the supply stays up, so a page program is never torn halfway
+static void inject_power_cut(void)
+{
+    const uint16_t size = s_record_sizes[0];
+    uint32_t bytes = 0;
+    uint32_t seq = BENCH_WARMUP_SEQ + BENCH_WARMUP_RECORDS;
+
+    enc_log_clear();
+    memset(&s_cut, 0, sizeof(s_cut));
+    const uint32_t syncs = 1 + esp_random() % BENCH_CUT_MAX_SYNCS;
+    for (uint32_t i = 0; i < syncs * BENCH_CUT_SYNC_EVERY; i++) {
+        submit_sample(seq++, size, &bytes);
+        if ((i + 1) % BENCH_CUT_SYNC_EVERY == 0) {
+            if (!enc_log_sync(BENCH_SYNC_TIMEOUT_MS)) {
+                ESP_LOGE(TAG, "power cut: sync timed out, not injected");
+                return;
+            }
+            s_cut.synced_records = i + 1;
+        }
+    }
+    s_cut.synced_bytes = enc_log_size();
+    s_cut.unsynced_records = 1 + esp_random() % (BENCH_CUT_SYNC_EVERY - 1);
+    s_cut.cut_after_ms = esp_random() % (BENCH_CUT_JITTER_MS + 1);
+    for (uint32_t i = 0; i < s_cut.unsynced_records; i++) {
+        submit_sample(seq++, size, &bytes);
+    }
+    s_cut.magic = BENCH_CUT_MAGIC;
+    vTaskDelay(pdMS_TO_TICKS(s_cut.cut_after_ms));
+    esp_restart();
+}
+
+// Boot after inject_power_cut(): what the store recovered and how long it took
+static void report_power_cut(void)
+{
+    enc_log_stats_t st;
+    enc_log_get_stats(&st);
+    const uint32_t recovered = enc_log_size();
+    const uint32_t lost = (recovered < s_cut.synced_bytes) ? s_cut.synced_bytes - recovered : 0;
+    printf("BENCH_CUT {\"mode\":\"%s\",\"storage\":\"%s\",\"boot_mount_ms\":%lu,"
+           "\"boot_open_ms\":%lu,\"synced_records\":%lu,\"unsynced_records\":%lu,"
+           "\"cut_after_ms\":%lu,\"synced_bytes\":%lu,\"recovered_bytes\":%lu,"
+           "\"lost_synced_bytes\":%lu}\n",
+           BENCH_MODE_NAME, BENCH_STORAGE_NAME, (unsigned long)st.boot_mount_ms,
+           (unsigned long)st.boot_open_ms, (unsigned long)s_cut.synced_records,
+           (unsigned long)s_cut.unsynced_records, (unsigned long)s_cut.cut_after_ms,
+           (unsigned long)s_cut.synced_bytes, (unsigned long)recovered, (unsigned long)lost);
+    fflush(stdout);
+}
+#endif
+
+#if BENCH_CRASH_CYCLES > 0
+typedef struct {
+    uint32_t expected;          // next seq
+    uint32_t records;
+    uint32_t gaps;              // seqs out of order or missing in between
+    uint32_t unparsed;
+} crash_scan_t;
+
+static bool crash_scan_record(const log_reader_record_t *rec, void *ctx)
+{
+    crash_scan_t *scan = (crash_scan_t *)ctx;
+    log_record_fields_t f;
+    scan->records++;
+    if (!log_record_fields(rec->data, rec->len, &f)) {
+        scan->unparsed++;
+        return true;
+    }
+    if (f.seq != scan->expected) {
+        scan->gaps++;
+    }
+    scan->expected = (uint32_t)f.seq + 1;
+    return true;
+}
+
+// Records of one phase; false if a sync timed out. Returns only if no crash fired.
+static bool crash_phase(uint32_t records)
+{
+    uint32_t bytes = 0;
+    for (uint32_t i = 0; i < records; i++) {
+        const uint32_t seq = s_crash.submitted_seq + 1;
+        s_crash.submitted_seq = seq;
+        submit_sample(seq, 0, &bytes);
+        if ((i + 1) % BENCH_CUT_SYNC_EVERY == 0) {
+            if (!enc_log_sync(BENCH_SYNC_TIMEOUT_MS)) {
+                return false;
+            }
+            s_crash.synced_seq = seq;
+        }
+    }
+    return true;
+}
+
+// One cycle: returns only if no crash point fired
+static void inject_crash(void)
+{
+    log_crash_point_t point;
+    enc_log_clear();
+    s_crash.first_seq = s_crash.submitted_seq + 1;
+    s_crash.synced_seq = 0;
+    log_crash_reset_hits();
+    const uint32_t records = (1 + esp_random() % BENCH_CUT_MAX_SYNCS) * BENCH_CUT_SYNC_EVERY;
+    if (!crash_phase(records)) {
+        ESP_LOGE(TAG, "crash cycle %lu: sync timed out", (unsigned long)s_crash.cycle);
+        return;
+    }
+    if (!log_crash_arm(LOG_CRASH_ALL, &point)) {
+        ESP_LOGE(TAG, "crash cycle %lu: no crash point passed", (unsigned long)s_crash.cycle);
+        return;
+    }
+    // The countdown is at most the passes of the unarmed phase, but bursts differ
+    if (crash_phase(records * BENCH_CRASH_ARMED_X)) {
+        (void)enc_log_sync(BENCH_SYNC_TIMEOUT_MS);
+    }
+    log_crash_disarm();
+    ESP_LOGW(TAG, "crash cycle %lu: %s not reached", (unsigned long)s_crash.cycle,
+             log_crash_point_name(point));
+}
+
+// Boot after a crash point fired: scan the log, compare it with what was submitted
+static void report_crash(log_crash_point_t point)
+{
+    enc_log_stats_t st;
+    enc_log_get_stats(&st);
+    crash_scan_t scan = {.expected = s_crash.first_seq};
+    log_reader_stats_t rs;
+    enc_log_snapshot_t snap;
+    enc_log_snapshot_open(&snap);
+    const bool ok = log_reader_scan(enc_log_snapshot_read, &snap, INDEX_NO_EPOCH, 0, snap.size,
+                                    crash_scan_record, &scan, &rs);
+    enc_log_snapshot_close(&snap);
+
+    // Records after the last one recovered are lost; before it they show up as gaps
+    const uint32_t last = scan.expected - 1;
+    const uint32_t lost_synced = (s_crash.synced_seq > last) ? s_crash.synced_seq - last : 0;
+    const uint32_t kept = (last > s_crash.synced_seq) ? last : s_crash.synced_seq;
+    const uint32_t lost_unsynced = (s_crash.submitted_seq > kept) ? s_crash.submitted_seq - kept : 0;
+    const uint32_t errors = rs.errors + scan.unparsed + (ok ? 0 : 1);
+    const bool consistent = scan.gaps == 0 && errors == 0 && lost_synced == 0;
+    const uint32_t recover_ms = st.boot_mount_ms + st.boot_open_ms;
+
+    s_crash.fired[point]++;
+    s_crash.inconsistent += consistent ? 0 : 1;
+    s_crash.lost_synced += lost_synced;
+    s_crash.lost_unsynced += lost_unsynced;
+    if (lost_unsynced > s_crash.lost_unsynced_max) {
+        s_crash.lost_unsynced_max = lost_unsynced;
+    }
+    s_crash.recover_ms += recover_ms;
+    if (recover_ms > s_crash.recover_ms_max) {
+        s_crash.recover_ms_max = recover_ms;
+    }
+    printf("BENCH_CRASH {\"mode\":\"%s\",\"storage\":\"%s\",\"cycle\":%lu,\"point\":\"%s\","
+           "\"boot_mount_ms\":%lu,\"boot_open_ms\":%lu,\"recover_ms\":%lu,\"verify_ms\":%lu,"
+           "\"submitted\":%lu,\"synced\":%lu,\"recovered\":%lu,\"lost_synced\":%lu,"
+           "\"lost_unsynced\":%lu,\"gaps\":%lu,\"errors\":%lu,\"consistent\":%s}\n",
+           BENCH_MODE_NAME, BENCH_STORAGE_NAME, (unsigned long)s_crash.cycle,
+           log_crash_point_name(point), (unsigned long)st.boot_mount_ms,
+           (unsigned long)st.boot_open_ms, (unsigned long)recover_ms,
+           (unsigned long)(rs.elapsed_us / 1000),
+           (unsigned long)(s_crash.submitted_seq - s_crash.first_seq + 1),
+           (unsigned long)(s_crash.synced_seq ? s_crash.synced_seq - s_crash.first_seq + 1 : 0),
+           (unsigned long)scan.records, (unsigned long)lost_synced,
+           (unsigned long)lost_unsynced, (unsigned long)scan.gaps, (unsigned long)errors,
+           consistent ? "true" : "false");
+    fflush(stdout);
+}
+
+// Runs the remaining cycles (each one resets unless its point was not reached), then
+// prints the totals
+static void run_crash_cycles(void)
+{
+    s_crash.magic = BENCH_CRASH_MAGIC;
+    while (s_crash.cycle < BENCH_CRASH_CYCLES) {
+        s_crash.cycle++;
+        inject_crash();
+        s_crash.not_fired++;
+    }
+    s_crash.magic = 0;
+
+    uint32_t fired = 0;
+    for (unsigned p = 0; p < LOG_CRASH_POINTS; p++) {
+        fired += s_crash.fired[p];
+    }
+    const double n = (fired > 0) ? fired : 1;
+    printf("BENCH_CRASH_DONE {\"mode\":\"%s\",\"storage\":\"%s\",\"cycles\":%lu,"
+           "\"fired\":%lu,\"fired_append\":%lu,\"fired_sync\":%lu,\"fired_index\":%lu,"
+           "\"fired_rotate\":%lu,\"not_fired\":%lu,\"inconsistent\":%lu,\"lost_synced\":%lu,"
+           "\"lost_unsynced_mean\":%.2f,\"lost_unsynced_max\":%lu,\"recover_ms_mean\":%.1f,"
+           "\"recover_ms_max\":%lu}\n",
+           BENCH_MODE_NAME, BENCH_STORAGE_NAME, (unsigned long)s_crash.cycle,
+           (unsigned long)fired, (unsigned long)s_crash.fired[LOG_CRASH_APPEND],
+           (unsigned long)s_crash.fired[LOG_CRASH_SYNC], (unsigned long)s_crash.fired[LOG_CRASH_INDEX],
+           (unsigned long)s_crash.fired[LOG_CRASH_ROTATE], (unsigned long)s_crash.not_fired,
+           (unsigned long)s_crash.inconsistent, (unsigned long)s_crash.lost_synced,
+           s_crash.lost_unsynced / n, (unsigned long)s_crash.lost_unsynced_max,
+           s_crash.recover_ms / n, (unsigned long)s_crash.recover_ms_max);
+    fflush(stdout);
+}
+#endif
+
+// Keystream XOR and block copy: the scalar kernels and memcpy against the ones the logger
+// uses (PIE on ESP32-S3 with LOG_SIMD)
+static void report_simd(void)
+{
+    log_simd_bench_t res;
+    if (!log_simd_bench(BENCH_SIMD_BYTES, BENCH_SIMD_ITERATIONS, &res)) {
+        ESP_LOGW(TAG, "XOR / copy benchmark: out of memory");
+        return;
+    }
+    const double mb = (double)res.bytes * BENCH_SIMD_ITERATIONS;    // bytes per us = MB/s
+    printf("BENCH_SIMD {\"vector\":%s,\"bytes\":%lu,\"iterations\":%u,"
+           "\"xor_scalar_us\":%lu,\"xor_us\":%lu,\"memcpy_us\":%lu,\"copy_us\":%lu,"
+           "\"xor_scalar_mb_s\":%.1f,\"xor_mb_s\":%.1f,\"memcpy_mb_s\":%.1f,\"copy_mb_s\":%.1f}\n",
+           res.vector ? "true" : "false", (unsigned long)res.bytes, (unsigned)BENCH_SIMD_ITERATIONS,
+           (unsigned long)res.xor_scalar_us, (unsigned long)res.xor_us,
+           (unsigned long)res.copy_memcpy_us, (unsigned long)res.copy_us,
+           mb / (res.xor_scalar_us ? res.xor_scalar_us : 1), mb / (res.xor_us ? res.xor_us : 1),
+           mb / (res.copy_memcpy_us ? res.copy_memcpy_us : 1), mb / (res.copy_us ? res.copy_us : 1));
+    fflush(stdout);
+}
+
+// --------------------
+// Main
+// --------------------
+// OPTIGA bring-up, run by enc_log_init() (see enc_log_optiga_init_t)
+static bool start_optiga(void)
+{
+    optiga_trust_init();
+    if (optiga_entropy_start() != OPTIGA_LIB_SUCCESS) {
+        ESP_LOGW(TAG, "entropy pool not started, IVs use direct TRNG commands");
+    }
+    return true;
+}
+
+void app_main(void)
+{
+    // Read before anything can overwrite it
+    const bool after_cut = s_cut.magic == BENCH_CUT_MAGIC && esp_reset_reason() == ESP_RST_SW;
+    s_cut.magic = 0;
+#if BENCH_CRASH_CYCLES > 0
+    // Before enc_log_init(): the crash state is only valid after an injected reset
+    log_crash_point_t crashed = LOG_CRASH_APPEND;
+    const bool after_crash = log_crash_init(&crashed) && s_crash.magic == BENCH_CRASH_MAGIC;
+    if (!after_crash) {
+        memset(&s_crash, 0, sizeof(s_crash));
+    }
+#endif
+    ESP_LOGI(TAG, "logger benchmark: mode=%s storage=%s, %u records x %u passes",
+             BENCH_MODE_NAME, BENCH_STORAGE_NAME, (unsigned)BENCH_RECORDS,
+             (unsigned)BENCH_PASSES);
+#if LOG_PM
+    if (!log_pm_init()) {
+        ESP_LOGW(TAG, "power management not configured, no energy estimate");
+    }
+#endif
+    // Mounts the storage as well
+    if (!enc_log_init(start_optiga) || !enc_log_wait_ready(UINT32_MAX)) {
+        ESP_LOGE(TAG, "log init failed");
+        return;
+    }
+#if BENCH_POWER_CUT
+    if (after_cut) {
+        report_power_cut();
+        printf("BENCH_DONE\n");
+        fflush(stdout);
+        return;
+    }
+#else
+    (void)after_cut;
+#endif
+#if BENCH_CRASH_CYCLES > 0
+    if (after_crash) {
+        report_crash(crashed);
+        run_crash_cycles();     // does not return until the cycles are done
+        printf("BENCH_DONE\n");
+        fflush(stdout);
+        return;
+    }
+#endif
+    report_simd();
+    // Per-group console lines would be part of the measured time
+    esp_log_level_set("ENC_LOG", ESP_LOG_WARN);
+    esp_log_level_set("LOG_STORE", ESP_LOG_WARN);
+    enc_log_set_append_cb(on_append, NULL);
+
+#ifdef BENCH_CURRENT_MA
+    // Each limit is an OPTIGA NVM write; the configured one is put back at the end
+    optiga_trust_current_limit_t configured;
+    optiga_trust_get_current_limit(&configured);
+    const size_t currents = sizeof(s_current_ma) / sizeof(s_current_ma[0]);
+#else
+    const size_t currents = 1;
+#endif
+    const size_t sizes = sizeof(s_record_sizes) / sizeof(s_record_sizes[0]);
+    const size_t policies = sizeof(s_sync_every) / sizeof(s_sync_every[0]);
+    bool ok = true;
+    for (unsigned pass = 1; pass <= BENCH_PASSES && ok; pass++) {
+        for (size_t i = 0; i < sizes * policies && ok; i++) {
+            const bench_workload_t w = {
+                .record_size = s_record_sizes[i / policies],
+                .sync_every = s_sync_every[i % policies],
+            };
+            for (size_t c = 0; c < currents && ok; c++) {
+#ifdef BENCH_CURRENT_MA
+                if (optiga_trust_set_current_limit(s_current_ma[c]) != OPTIGA_LIB_SUCCESS) {
+                    ESP_LOGE(TAG, "current limit %u mA not set", (unsigned)s_current_ma[c]);
+                    ok = false;
+                    continue;
+                }
+#endif
+                bench_result_t res;
+                ok = run_pass(&w, &res);
+                print_result(pass, &w, &res);
+            }
+        }
+    }
+#ifdef BENCH_CURRENT_MA
+    if (configured.milliamps != 0) {
+        (void)optiga_trust_set_current_limit(configured.milliamps);
+    }
+#endif
+#if BENCH_POWER_CUT
+    if (ok) {
+        inject_power_cut();     // does not return unless it failed
+    }
+#endif
+#if BENCH_CRASH_CYCLES > 0
+    if (ok) {
+        run_crash_cycles();
+    }
+#endif
+    printf("BENCH_DONE\n");
+    fflush(stdout);
+}
@@ -0,0 +1,4 @@
+CONFIG_PM_ENABLE=y
+CONFIG_PM_LIGHT_SLEEP_CALLBACKS=y
+CONFIG_FREERTOS_USE_TICKLESS_IDLE=y
+CONFIG_OPTIGA_TRUST_M_PM_LOCK=y
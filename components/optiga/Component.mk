@@ -1,7 +1,8 @@
 #
 # Component Makefile
 #
-COMPONENT_ADD_INCLUDEDIRS := optiga-trust-m/optiga/include
+COMPONENT_ADD_INCLUDEDIRS := optiga-trust-m/optiga/include \
+                             optiga-trust-m/examples/utilities/include
 
 COMPONENT_SRCDIRS := optiga-trust-m/pal/esp32_freertos \
                      optiga-trust-m/optiga/cmd \
@@ -0,0 +1,75 @@
+/**
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* @{
+*/
+#ifndef _TRUSTM_CRYPT_H_
+#define _TRUSTM_CRYPT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "optiga/optiga_crypt.h"
+#include "optiga_sync.h"
+
+/// Crypt instances kept by the mbedtls ALT port, i.e. concurrent ALT calls before a caller blocks
+/// (CONFIG_OPTIGA_TRUST_M_MBEDTLS_CRYPT_INSTANCES)
+#ifndef TRUSTM_CRYPT_POOL_SIZE
+#define TRUSTM_CRYPT_POOL_SIZE      (2U)
+#endif
+
+/**
+ * \brief Takes a long-lived crypt instance for one ALT operation, blocking while all are taken.
+ *
+ * \details
+ * Instances are created on first use with #optiga_sync_callback and kept for the lifetime of the
+ * application, so a TLS handshake pays neither create/destroy nor a registration per operation.
+ * Arm *pp_sync with optiga_sync_begin() before each request and wait on it afterwards.
+ *
+ * Safe to call from several tasks: each caller owns its instance and completion object until
+ * trustm_crypt_release(), and the requests of different callers queue in the OPTIGA command
+ * scheduler. Take the instance right before the request so host side work stays outside.
+ *
+ * \param[out] pp_sync      Completion object of the instance
+ *
+ * \retval     Crypt instance, NULL if it could not be created
+ */
+optiga_crypt_t * trustm_crypt_acquire(optiga_sync_t ** pp_sync);
+
+/**
+ * \brief Hands an instance taken by trustm_crypt_acquire() back to the pool.
+ *
+ * \param[in] me            Crypt instance, NULL is ignored
+ */
+void trustm_crypt_release(optiga_crypt_t * me);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TRUSTM_CRYPT_H_ */
+
+/**
+* @}
+*/
@@ -0,0 +1,131 @@
+/**
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* @{
+*/
+#ifndef _TRUSTM_ECDH_POOL_H_
+#define _TRUSTM_ECDH_POOL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mbedtls/ecp.h"
+#include "optiga/optiga_crypt.h"
+
+/// Ephemeral key pairs kept ready (CONFIG_OPTIGA_TRUST_M_ECDH_KEY_POOL_SIZE). Slot i holds its private key in
+/// session context 0xE102 - i, counting down so the library's own session assignment (from 0xE100 up) is met last
+#ifndef TRUSTM_ECDH_POOL_SIZE
+#define TRUSTM_ECDH_POOL_SIZE           (2U)
+#endif
+
+/// Curve of the pooled key pairs, as mbedtls group and as OPTIGA curve (CONFIG_OPTIGA_TRUST_M_ECDH_KEY_POOL_CURVE)
+#ifndef TRUSTM_ECDH_POOL_GROUP
+#define TRUSTM_ECDH_POOL_GROUP          MBEDTLS_ECP_DP_SECP256R1
+#define TRUSTM_ECDH_POOL_CURVE          OPTIGA_ECC_CURVE_NIST_P_256
+#endif
+
+/// A taken key pair not used for a shared secret within this time belongs to an aborted handshake and is replaced
+#ifndef TRUSTM_ECDH_POOL_HOLD_MS
+#define TRUSTM_ECDH_POOL_HOLD_MS        (60000U)
+#endif
+
+/// FreeRTOS priority of the refill task, just above idle like the entropy pool
+#ifndef TRUSTM_ECDH_POOL_TASK_PRIORITY
+#define TRUSTM_ECDH_POOL_TASK_PRIORITY  (1U)
+#endif
+
+/// Longest public key kept per slot, DER BIT STRING header included (P-384: 3 + 97 bytes)
+#define TRUSTM_ECDH_POOL_PUBLIC_KEY_BYTES   (100U)
+
+#if (TRUSTM_ECDH_POOL_SIZE < 1U) || (TRUSTM_ECDH_POOL_SIZE > 3U)
+#error "TRUSTM_ECDH_POOL_SIZE must be 1..3, 0xE103 stays with the key pairs generated on demand"
+#endif
+
+/** @brief ECDH key pool counters */
+typedef struct trustm_ecdh_pool_stats
+{
+    /// Key pairs ready to be taken
+    uint32_t ready;
+    /// Key generations served from the pool
+    uint32_t hits;
+    /// Key generations of the pool curve that found no key pair ready
+    uint32_t misses;
+    /// Key pairs generated in the background
+    uint32_t refills;
+    /// Failed background generations
+    uint32_t refill_errors;
+    /// Taken key pairs replaced after #TRUSTM_ECDH_POOL_HOLD_MS without a shared secret
+    uint32_t reclaimed;
+} trustm_ecdh_pool_stats_t;
+
+/**
+ * \brief Creates the refill task and starts generating key pairs.
+ *
+ * \details
+ * Call once after optiga_trust_init(). Each generation takes an instance of the ALT port pool
+ * (trustm_crypt_acquire()) at #OPTIGA_CMD_PRIORITY_LOW, so it queues behind application requests.
+ *
+ * \retval    #OPTIGA_LIB_SUCCESS the pool is filling
+ * \retval    #OPTIGA_CRYPT_ERROR the task could not be created
+ */
+optiga_lib_status_t trustm_ecdh_pool_start(void);
+
+/**
+ * \brief Takes a ready key pair of the given curve, never blocks.
+ *
+ * \details
+ * The private key stays in its session context until trustm_ecdh_pool_release().
+ *
+ * \param[in]     gid              Curve of the handshake
+ * \param[out]    p_public_key     Public key as DER BIT STRING, as returned by optiga_crypt_ecc_generate_keypair()
+ * \param[in,out] p_length         Size of p_public_key in, public key length out
+ *
+ * \retval    Session context OID of the private key
+ * \retval    0 no key pair of this curve ready, generate one on demand
+ */
+uint16_t trustm_ecdh_pool_take(mbedtls_ecp_group_id gid, uint8_t * p_public_key, uint16_t * p_length);
+
+/**
+ * \brief Marks the key pair in session context oid as used, the refill task replaces it.
+ *
+ * \param[in] oid           OID returned by trustm_ecdh_pool_take(), other OIDs are ignored
+ */
+void trustm_ecdh_pool_release(uint16_t oid);
+
+/**
+ * \brief Copies the pool counters.
+ *
+ * \param[out] p_stats      Counters
+ */
+void trustm_ecdh_pool_get_stats(trustm_ecdh_pool_stats_t * p_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TRUSTM_ECDH_POOL_H_ */
+
+/**
+* @}
+*/
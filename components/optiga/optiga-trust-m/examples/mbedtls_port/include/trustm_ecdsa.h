@@ -0,0 +1,88 @@
+/**
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* @{
+*/
+#ifndef _TRUSTM_ECDSA_H_
+#define _TRUSTM_ECDSA_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mbedtls/ecp.h"
+
+/// Length of r or s on the largest curve OPTIGA supports (NIST P-521)
+#define TRUSTM_ECDSA_MAX_COMPONENT_BYTES    (66U)
+
+/**
+ * \brief Signs a digest with the device key and returns the signature as raw r || s.
+ *
+ * \details
+ * Uses the key in CONFIG_OPTIGA_TRUST_M_PRIVKEY_SLOT like mbedtls_ecdsa_sign(). The DER
+ * signature from OPTIGA is converted in fixed-size stack buffers without any heap
+ * allocation, for callers that send raw signatures (e.g. JWS, COSE).
+ *
+ * \param[in]     gid         Curve of the device key, sets the length of r and s
+ * \param[in]     buf         Digest
+ * \param[in]     blen        Digest length
+ * \param[out]    rs          r and s, each left padded with zeros to the curve length
+ * \param[in,out] rs_len      Size of rs in, 2 * curve length out
+ *
+ * \retval    0 on success
+ * \retval    MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE curve not supported by OPTIGA
+ * \retval    MBEDTLS_ERR_ECP_BUFFER_TOO_SMALL rs is too small
+ * \retval    MBEDTLS_ERR_ECP_BAD_INPUT_DATA the OPTIGA request failed
+ */
+int trustm_ecdsa_sign_raw(mbedtls_ecp_group_id gid, const unsigned char * buf, size_t blen,
+                          unsigned char * rs, size_t * rs_len);
+
+/**
+ * \brief Verifies a raw r || s signature of a digest on OPTIGA, without heap allocation.
+ *
+ * \details
+ * Always runs on OPTIGA, the dispatch policy of mbedtls_ecdsa_verify() does not apply.
+ *
+ * \param[in] grp          Curve
+ * \param[in] buf          Digest
+ * \param[in] blen         Digest length
+ * \param[in] Q            Public key
+ * \param[in] rs           r and s, each of the curve length
+ * \param[in] rs_len       2 * curve length
+ *
+ * \retval    0 the signature is valid
+ * \retval    MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE curve not supported by OPTIGA
+ * \retval    MBEDTLS_ERR_ECP_BAD_INPUT_DATA wrong rs_len, invalid signature or failed OPTIGA request
+ */
+int trustm_ecdsa_verify_raw(mbedtls_ecp_group * grp, const unsigned char * buf, size_t blen,
+                            const mbedtls_ecp_point * Q, const unsigned char * rs, size_t rs_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TRUSTM_ECDSA_H_ */
+
+/**
+* @}
+*/
@@ -0,0 +1,156 @@
+/**
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* @{
+*/
+#ifndef _TRUSTM_OFFLOAD_H_
+#define _TRUSTM_OFFLOAD_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mbedtls/ecp.h"
+
+/// Operations with a dispatch policy; none of them needs a key kept in OPTIGA
+typedef enum trustm_offload_op
+{
+    /// mbedtls_ecdsa_verify(), a public key verify
+    TRUSTM_OFFLOAD_ECDSA_VERIFY = 0,
+    /// mbedtls_ecdh_gen_public() with the matching mbedtls_ecdh_compute_shared(), an ephemeral key
+    TRUSTM_OFFLOAD_ECDH,
+    TRUSTM_OFFLOAD_OPS
+} trustm_offload_op_t;
+
+/// Where an operation runs
+typedef enum trustm_offload_mode
+{
+    /// Always on OPTIGA
+    TRUSTM_OFFLOAD_OPTIGA = 0,
+    /// Always in mbedtls on the ESP32 (MPI accelerator)
+    TRUSTM_OFFLOAD_HOST = 1,
+    /// On the path with the lower measured time, OPTIGA queueing included
+    TRUSTM_OFFLOAD_AUTO = 2
+} trustm_offload_mode_t;
+
+/// Curves OPTIGA supports, MBEDTLS_ECP_DP_SECP256R1 to MBEDTLS_ECP_DP_BP512R1; others always run on the host
+#define TRUSTM_OFFLOAD_CURVES               (6U)
+
+/// In auto mode every this many calls run on the slower path, so its time follows load changes
+#ifndef TRUSTM_OFFLOAD_PROBE_INTERVAL
+#define TRUSTM_OFFLOAD_PROBE_INTERVAL       (32U)
+#endif
+
+/** @brief Benchmark result of one operation on one curve */
+typedef struct trustm_offload_result
+{
+    /// Mean time on OPTIGA [us], 0 if the path failed
+    uint32_t optiga_us;
+    /// Mean time on the host [us], 0 if the path failed
+    uint32_t host_us;
+} trustm_offload_result_t;
+
+/**
+ * \brief Sets the policy of an operation on one curve.
+ *
+ * \param[in] op          Operation
+ * \param[in] gid         Curve, MBEDTLS_ECP_DP_NONE for all curves
+ * \param[in] mode        Policy
+ */
+void trustm_offload_set(trustm_offload_op_t op, mbedtls_ecp_group_id gid, trustm_offload_mode_t mode);
+
+/**
+ * \brief Picks the path of the next call of op on curve gid.
+ *
+ * \retval    #TRUSTM_OFFLOAD_OPTIGA or #TRUSTM_OFFLOAD_HOST
+ */
+trustm_offload_mode_t trustm_offload_select(trustm_offload_op_t op, mbedtls_ecp_group_id gid);
+
+/**
+ * \brief Feeds the time of a completed call into the moving average used by #TRUSTM_OFFLOAD_AUTO.
+ *
+ * \param[in] op          Operation
+ * \param[in] gid         Curve
+ * \param[in] path        Path the call ran on
+ * \param[in] time_us     Duration of the call [us]
+ */
+void trustm_offload_record(trustm_offload_op_t op, mbedtls_ecp_group_id gid, trustm_offload_mode_t path,
+                           uint32_t time_us);
+
+/**
+ * \brief ECDSA verify in mbedtls on the host (SEC1 4.1.4), for the #TRUSTM_OFFLOAD_HOST path.
+ *
+ * \retval    0 if the signature is valid, MBEDTLS_ERR_ECP_VERIFY_FAILED or another mbedtls error
+ */
+int trustm_offload_ecdsa_verify_host(mbedtls_ecp_group * grp, const unsigned char * buf, size_t blen,
+                                     const mbedtls_ecp_point * Q, const mbedtls_mpi * r, const mbedtls_mpi * s);
+
+/**
+ * \brief Ephemeral ECDH key pair in mbedtls on the host; d receives the private scalar.
+ */
+int trustm_offload_ecdh_gen_public_host(mbedtls_ecp_group * grp, mbedtls_mpi * d, mbedtls_ecp_point * Q,
+                                        int (*f_rng)(void *, unsigned char *, size_t), void * p_rng);
+
+/**
+ * \brief ECDH shared secret in mbedtls on the host, for a d made by trustm_offload_ecdh_gen_public_host().
+ */
+int trustm_offload_ecdh_compute_shared_host(mbedtls_ecp_group * grp, mbedtls_mpi * z, const mbedtls_ecp_point * Q,
+                                            const mbedtls_mpi * d,
+                                            int (*f_rng)(void *, unsigned char *, size_t), void * p_rng);
+
+/**
+ * \brief Tells whether d holds a private scalar made on the host.
+ *
+ * \details
+ * The OPTIGA path of mbedtls_ecdh_gen_public() keeps the private key in an OPTIGA session
+ * context and leaves d at 0 (or at the OID with OPTIGA_TRUSTM_EXTRACT_OID_FROM_PRIVKEY), so
+ * mbedtls_ecdh_compute_shared() follows the path the key was made on.
+ */
+int trustm_offload_is_host_key(const mbedtls_ecp_group * grp, const mbedtls_mpi * d);
+
+/**
+ * \brief Times op on curve gid on both paths and seeds the auto policy with the means.
+ *
+ * \details
+ * Keys and signatures are made on the host, so the OPTIGA key slots are not touched. ECDH times
+ * one key pair plus one shared secret. Blocks for iterations calls on each path.
+ *
+ * \param[in]  op          Operation
+ * \param[in]  gid         Curve, one of the #TRUSTM_OFFLOAD_CURVES OPTIGA supports
+ * \param[in]  iterations  Calls per path
+ * \param[out] p_result    Mean times
+ *
+ * \retval    0 on success, else the mbedtls error of the host key setup
+ */
+int trustm_offload_benchmark(trustm_offload_op_t op, mbedtls_ecp_group_id gid, uint32_t iterations,
+                             trustm_offload_result_t * p_result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TRUSTM_OFFLOAD_H_ */
+
+/**
+* @}
+*/
@@ -0,0 +1,106 @@
+/**
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* @{
+*/
+#ifndef _TRUSTM_SSL_ASYNC_H_
+#define _TRUSTM_SSL_ASYNC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "mbedtls/ssl.h"
+#include "optiga/optiga_crypt.h"
+
+/** @brief Asynchronous signature counters */
+typedef struct trustm_ssl_async_stats
+{
+    /// Signatures started on OPTIGA
+    uint32_t started;
+    /// Signatures handed to mbedtls
+    uint32_t completed;
+    /// Certificates without an EC key, signed by mbedtls itself
+    uint32_t fallthrough;
+    /// Handshakes ended while their signature was still running
+    uint32_t cancelled;
+    /// Requests OPTIGA refused or failed
+    uint32_t errors;
+    /// Resume calls that found the signature still running
+    uint32_t in_progress;
+} trustm_ssl_async_stats_t;
+
+/**
+ * \brief Lets the TLS server handshakes of conf sign with an OPTIGA key without blocking.
+ *
+ * \details
+ * Installs mbedtls_ssl_conf_async_private_cb() callbacks (MBEDTLS_SSL_ASYNC_PRIVATE). The
+ * ServerKeyExchange signature starts on OPTIGA and mbedtls_ssl_handshake() returns
+ * MBEDTLS_ERR_SSL_ASYNC_IN_PROGRESS meanwhile, so the task can serve other connections or
+ * let the logger run. Call mbedtls_ssl_handshake() again to collect the signature; it returns
+ * the same code until OPTIGA is done, or block for it with trustm_ssl_async_wait().
+ *
+ * Give mbedtls_ssl_conf_own_cert() the certificate and its public key: the private key stays
+ * in OPTIGA. EC keys sign with ECDSA. RSA-2048 keys sign PKCS#1 v1.5 with SHA-256/384/512
+ * and decrypt the premaster of the RSA key exchange; both queue at
+ * #TRUSTM_SSL_ASYNC_RSA_PRIORITY, so the AES commands of the logger are not held up behind
+ * them. Other keys fall through to mbedtls.
+ *
+ * mbedtls only calls these callbacks on the server side of TLS 1.2. A client signs its
+ * CertificateVerify through mbedtls_pk_sign(), i.e. the blocking ECDSA ALT port.
+ *
+ * \param[in] conf          Server configuration
+ * \param[in] key_id        OPTIGA key of the certificate, e.g. OPTIGA_KEY_ID_E0F0 or
+ *                          OPTIGA_KEY_ID_E0FC
+ */
+void trustm_ssl_async_setup(mbedtls_ssl_config * conf, optiga_key_id_t key_id);
+
+/**
+ * \brief Blocks until the private key operation of ssl's handshake has finished, or
+ *        timeout_ms passed.
+ *
+ * \param[in] ssl           Server context whose handshake returned MBEDTLS_ERR_SSL_ASYNC_IN_PROGRESS
+ * \param[in] timeout_ms    Longest wait, #OPTIGA_SYNC_WAIT_FOREVER for no limit
+ *
+ * \retval    0 no signature running: call mbedtls_ssl_handshake() again
+ * \retval    MBEDTLS_ERR_SSL_ASYNC_IN_PROGRESS still running
+ */
+int trustm_ssl_async_wait(mbedtls_ssl_context * ssl, uint32_t timeout_ms);
+
+/**
+ * \brief Copies the counters.
+ *
+ * \param[out] p_stats      Counters
+ */
+void trustm_ssl_async_get_stats(trustm_ssl_async_stats_t * p_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TRUSTM_SSL_ASYNC_H_ */
+
+/**
+* @}
+*/
@@ -0,0 +1,118 @@
+/**
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* @{
+*/
+#ifndef _TRUSTM_TLS_SESSION_H_
+#define _TRUSTM_TLS_SESSION_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "mbedtls/ssl.h"
+
+/// Largest serialized session kept per host. Sessions with the peer certificate
+/// (MBEDTLS_SSL_KEEP_PEER_CERTIFICATE) usually exceed it and are not stored
+#ifndef TRUSTM_TLS_SESSION_MAX_BYTES
+#define TRUSTM_TLS_SESSION_MAX_BYTES        (1024U)
+#endif
+
+/// No session stored for the host, or the stored one is corrupted
+#define TRUSTM_TLS_SESSION_ERR_NOT_FOUND    (-0x0E00)
+/// NVS could not be opened or written
+#define TRUSTM_TLS_SESSION_ERR_STORAGE      (-0x0E02)
+
+/** @brief Session cache counters */
+typedef struct trustm_tls_session_stats
+{
+    /// Stored sessions handed to mbedtls_ssl_set_session(), i.e. resumptions offered
+    uint32_t restored;
+    /// Connections without a usable stored session
+    uint32_t misses;
+    /// Sessions written to NVS
+    uint32_t saved;
+    /// Saves skipped because NVS already held the same session (resumed handshakes)
+    uint32_t unchanged;
+    /// Sessions not stored: too large, not serializable or NVS failure
+    uint32_t errors;
+} trustm_tls_session_stats_t;
+
+/**
+ * \brief Offers the session stored for host to the next handshake of ssl.
+ *
+ * \details
+ * Call after mbedtls_ssl_setup() and before mbedtls_ssl_handshake(). When the server accepts the
+ * session ID or ticket, the handshake is abbreviated: no OPTIGA ECDSA sign with the device key
+ * and no ECDH. When it refuses, mbedtls falls back to a full handshake by itself.
+ *
+ * \param[in] ssl           Client context
+ * \param[in] host          Server name the session belongs to
+ *
+ * \retval    0 a stored session was set
+ * \retval    #TRUSTM_TLS_SESSION_ERR_NOT_FOUND nothing stored for host, a full handshake follows
+ * \retval    Other mbedtls error of mbedtls_ssl_session_load() or mbedtls_ssl_set_session()
+ */
+int trustm_tls_session_restore(mbedtls_ssl_context * ssl, const char * host);
+
+/**
+ * \brief Stores the session of ssl for host in NVS.
+ *
+ * \details
+ * Call once the handshake has completed; with TLS 1.3 the ticket comes after the handshake,
+ * so call it after the first application data has been read. NVS is only written when the
+ * session differs from the stored one, so a resumed connection costs no flash write.
+ *
+ * \param[in] ssl           Client context after a successful handshake
+ * \param[in] host          Server name the session belongs to
+ *
+ * \retval    0 stored or already stored
+ * \retval    #TRUSTM_TLS_SESSION_ERR_STORAGE NVS failure
+ * \retval    Other mbedtls error of mbedtls_ssl_get_session() or mbedtls_ssl_session_save()
+ */
+int trustm_tls_session_save(const mbedtls_ssl_context * ssl, const char * host);
+
+/**
+ * \brief Deletes the session stored for host, e.g. after the server rejected the client.
+ *
+ * \param[in] host          Server name the session belongs to
+ */
+void trustm_tls_session_forget(const char * host);
+
+/**
+ * \brief Copies the cache counters.
+ *
+ * \param[out] p_stats      Counters
+ */
+void trustm_tls_session_get_stats(trustm_tls_session_stats_t * p_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TRUSTM_TLS_SESSION_H_ */
+
+/**
+* @}
+*/
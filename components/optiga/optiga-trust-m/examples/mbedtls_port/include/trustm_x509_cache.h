@@ -0,0 +1,147 @@
+/**
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* @{
+*/
+#ifndef _TRUSTM_X509_CACHE_H_
+#define _TRUSTM_X509_CACHE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "mbedtls/ssl.h"
+#include "mbedtls/x509_crt.h"
+
+/// Verified chains kept in RAM, the least recently used is replaced
+#ifndef TRUSTM_X509_CACHE_ENTRIES
+#define TRUSTM_X509_CACHE_ENTRIES           (4U)
+#endif
+
+/// Longest time a verified chain is trusted without being verified again [s]. Bounds how long a
+/// revocation that reaches neither the hook nor trustm_x509_cache_revoke() goes unnoticed
+#ifndef TRUSTM_X509_CACHE_MAX_AGE_S
+#define TRUSTM_X509_CACHE_MAX_AGE_S         (24U * 3600U)
+#endif
+
+/// The trust anchor could not be read from OPTIGA or parsed
+#define TRUSTM_X509_CACHE_ERR_ANCHOR        (-0x0E10)
+
+/**
+ * \brief Revocation hook, asked on every cache hit and after every successful verification.
+ *
+ * \param[in] p_ctx         Context given to trustm_x509_cache_set_revocation_hook()
+ * \param[in] p_chain       Peer chain, leaf first
+ *
+ * \retval    0 not revoked
+ * \retval    Other a certificate of the chain is revoked, the connection must not be used
+ */
+typedef int (*trustm_x509_cache_revoked_t)(void * p_ctx, const mbedtls_x509_crt * p_chain);
+
+/** @brief Verification cache counters */
+typedef struct trustm_x509_cache_stats
+{
+    /// Chains accepted from the cache, without trust anchor read and signature verifies
+    uint32_t hits;
+    /// Chains verified against the trust anchor
+    uint32_t verified;
+    /// Verifications that failed
+    uint32_t failed;
+    /// Entries dropped because the first certificate of the chain expired or the maximum age passed
+    uint32_t expired;
+    /// Chains rejected by the revocation hook or dropped by trustm_x509_cache_revoke()
+    uint32_t revoked;
+} trustm_x509_cache_stats_t;
+
+/**
+ * \brief Defers the server certificate check of conf to trustm_x509_cache_verify().
+ *
+ * \details
+ * Sets MBEDTLS_SSL_VERIFY_NONE: mbedtls still checks the ServerKeyExchange signature with the key
+ * of the server certificate, but neither the chain nor the host name. The application must call
+ * trustm_x509_cache_verify() after every handshake and must not send anything before it returned 0.
+ *
+ * \param[in] conf          Client configuration
+ */
+void trustm_x509_cache_setup(mbedtls_ssl_config * conf);
+
+/**
+ * \brief Verifies the server chain of a finished handshake, from the cache when possible.
+ *
+ * \details
+ * The cache is keyed by the SHA-256 of the chain as received and of host. A hit skips the trust
+ * anchor read from OPTIGA and the signature verifies of the chain (ECDSA on OPTIGA with
+ * MBEDTLS_ECDSA_VERIFY_ALT). A miss runs mbedtls_x509_crt_verify() against the certificate in
+ * anchor_oid and caches the chain on success until the first certificate of chain or anchor
+ * expires, at most #TRUSTM_X509_CACHE_MAX_AGE_S. Needs MBEDTLS_SSL_KEEP_PEER_CERTIFICATE.
+ *
+ * \param[in]  ssl          Client context after mbedtls_ssl_handshake() returned 0
+ * \param[in]  host         Server name to check the certificate against
+ * \param[in]  anchor_oid   Data object holding the trust anchor, e.g. 0xE0E8
+ * \param[out] p_flags      MBEDTLS_X509_BADCERT_xxx of the verification, 0 on success
+ *
+ * \retval    0 the chain is trusted for host
+ * \retval    MBEDTLS_ERR_X509_CERT_VERIFY_FAILED see p_flags; MBEDTLS_X509_BADCERT_REVOKED from the hook
+ * \retval    #TRUSTM_X509_CACHE_ERR_ANCHOR the trust anchor could not be read
+ * \retval    Other mbedtls error
+ */
+int trustm_x509_cache_verify(const mbedtls_ssl_context * ssl, const char * host, uint16_t anchor_oid,
+                             uint32_t * p_flags);
+
+/**
+ * \brief Sets the revocation hook, NULL removes it.
+ *
+ * \param[in] hook          Called without locks held; may use the network, e.g. to ask an OCSP responder
+ * \param[in] p_ctx         Context passed to hook
+ */
+void trustm_x509_cache_set_revocation_hook(trustm_x509_cache_revoked_t hook, void * p_ctx);
+
+/**
+ * \brief Drops every cached chain that contains p_crt, so the next connection verifies again.
+ *
+ * \param[in] p_crt         Revoked certificate (leaf, intermediate or root); only p_crt itself is used
+ */
+void trustm_x509_cache_revoke(const mbedtls_x509_crt * p_crt);
+
+/**
+ * \brief Drops all cached chains, e.g. after the trust anchor was updated.
+ */
+void trustm_x509_cache_flush(void);
+
+/**
+ * \brief Copies the cache counters.
+ *
+ * \param[out] p_stats      Counters
+ */
+void trustm_x509_cache_get_stats(trustm_x509_cache_stats_t * p_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TRUSTM_X509_CACHE_H_ */
+
+/**
+* @}
+*/
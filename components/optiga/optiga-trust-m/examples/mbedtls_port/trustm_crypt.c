@@ -0,0 +1,103 @@
+/**
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* @{
+*/
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "trustm_crypt.h"
+
+typedef struct trustm_crypt_slot
+{
+    optiga_crypt_t * me;
+    optiga_sync_t sync;
+    bool_t in_use;
+} trustm_crypt_slot_t;
+
+static trustm_crypt_slot_t trustm_crypt_pool[TRUSTM_CRYPT_POOL_SIZE];
+// Counts the free slots, created on the first acquire
+static SemaphoreHandle_t trustm_crypt_free;
+static StaticSemaphore_t trustm_crypt_free_buffer;
+static portMUX_TYPE trustm_crypt_lock = portMUX_INITIALIZER_UNLOCKED;
+
+optiga_crypt_t * trustm_crypt_acquire(optiga_sync_t ** pp_sync)
+{
+    trustm_crypt_slot_t * p_slot = NULL;
+    uint32_t index;
+
+    portENTER_CRITICAL(&trustm_crypt_lock);
+    if (NULL == trustm_crypt_free)
+    {
+        trustm_crypt_free = xSemaphoreCreateCountingStatic(TRUSTM_CRYPT_POOL_SIZE, TRUSTM_CRYPT_POOL_SIZE,
+                                                           &trustm_crypt_free_buffer);
+    }
+    portEXIT_CRITICAL(&trustm_crypt_lock);
+
+    (void)xSemaphoreTake(trustm_crypt_free, portMAX_DELAY);
+
+    portENTER_CRITICAL(&trustm_crypt_lock);
+    for (index = 0; index < TRUSTM_CRYPT_POOL_SIZE; index++)
+    {
+        if (FALSE == trustm_crypt_pool[index].in_use)
+        {
+            p_slot = &trustm_crypt_pool[index];
+            p_slot->in_use = TRUE;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&trustm_crypt_lock);
+
+    // Only the owner of the slot gets here, so the instance is created once
+    if (NULL == p_slot->me)
+    {
+        p_slot->me = optiga_crypt_create(0, optiga_sync_callback, &p_slot->sync);
+        if (NULL == p_slot->me)
+        {
+            p_slot->in_use = FALSE;
+            (void)xSemaphoreGive(trustm_crypt_free);
+            return (NULL);
+        }
+    }
+    *pp_sync = &p_slot->sync;
+    return (p_slot->me);
+}
+
+void trustm_crypt_release(optiga_crypt_t * me)
+{
+    uint32_t index;
+
+    for (index = 0; (NULL != me) && (index < TRUSTM_CRYPT_POOL_SIZE); index++)
+    {
+        if (me == trustm_crypt_pool[index].me)
+        {
+            trustm_crypt_pool[index].in_use = FALSE;
+            (void)xSemaphoreGive(trustm_crypt_free);
+            break;
+        }
+    }
+}
+
+/**
+* @}
+*/
@@ -35,32 +35,24 @@
 #include "optiga/optiga_util.h"
 #include "optiga/pal/pal_os_timer.h"
 #include "optiga/common/optiga_lib_common.h"
+#include "optiga_sync.h"
+#include "trustm_crypt.h"
+#include "trustm_offload.h"
+#ifdef TRUSTM_ECDH_POOL_ENABLED
+#include "trustm_ecdh_pool.h"
+#endif
 
 #define PRINT_ECDH_PUBLICKEY   0
 
-// We use here Session Context ID 0xE103 (you can choose between 0xE100 - E104)
+// We use here Session Context ID 0xE103 (you can choose between 0xE100 - E104),
+// the pregenerated key pairs of trustm_ecdh_pool.c count down from 0xE102
 #define OPTIGA_TRUSTM_KEYID_TO_STORE_PRIVATE_KEY  0xE103
 
-/**
- * Callback when optiga_crypt_xxxx operation is completed asynchronously
- */
-static volatile optiga_lib_status_t crypt_event_completed_status;
-
-//lint --e{818} suppress "argument "context" is not used in the sample provided"
-static void optiga_crypt_event_completed(void * context, optiga_lib_status_t return_status)
-{
-	crypt_event_completed_status = return_status;
-    if (NULL != context)
-    {
-        // callback to upper layer here
-    }
-}
-
 #ifdef MBEDTLS_ECDH_GEN_PUBLIC_ALT
 /*
  * Generate public key: simple wrapper around mbedtls_ecp_gen_keypair
  */
-int mbedtls_ecdh_gen_public(mbedtls_ecp_group *grp, mbedtls_mpi *d,
+static int trustm_ecdh_gen_public_optiga(mbedtls_ecp_group *grp, mbedtls_mpi *d,
 		mbedtls_ecp_point *Q, int (*f_rng)(void *, unsigned char *, size_t),
 		void *p_rng) {
 
@@ -71,7 +63,9 @@ int mbedtls_ecdh_gen_public(mbedtls_ecp_group *grp, mbedtls_mpi *d,
 	optiga_ecc_curve_t curve_id;
 	optiga_key_id_t optiga_key_id = OPTIGA_TRUSTM_KEYID_TO_STORE_PRIVATE_KEY;
 	optiga_crypt_t * me = NULL;
+	optiga_sync_t * p_sync = NULL;
     optiga_lib_status_t crypt_sync_status = OPTIGA_CRYPT_ERROR;
+	uint16_t pooled_oid = 0;
 
 	//checking group against the supported curves of OPTIGA Trust M
 	if ((grp->id <  MBEDTLS_ECP_DP_SECP256R1) ||
@@ -105,55 +99,106 @@ int mbedtls_ecdh_gen_public(mbedtls_ecp_group *grp, mbedtls_mpi *d,
 		public_key_offset = 4;
 	}
 
-	me = optiga_crypt_create(0, optiga_crypt_event_completed, NULL);
-	if (NULL == me)
+#if defined(TRUSTM_ECDH_POOL_ENABLED) && !defined(OPTIGA_TRUSTM_EXTRACT_OID_FROM_PRIVKEY)
+	// A key pair generated in the background spares the handshake the OPTIGA key generation
 	{
-		return_status = MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
-		goto cleanup;
+		uint16_t pooled_len = sizeof(public_key);
+		pooled_oid = trustm_ecdh_pool_take(grp->id, public_key, &pooled_len);
+		public_key_len = pooled_len;
 	}
+#endif
 
-	crypt_event_completed_status = OPTIGA_LIB_BUSY;
+	if (0U == pooled_oid)
+	{
+		me = trustm_crypt_acquire(&p_sync);
+		if (NULL == me)
+		{
+			return_status = MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
+			goto cleanup;
+		}
 
-	//invoke optiga command to generate a key pair.
-	crypt_sync_status = optiga_crypt_ecc_generate_keypair(me, curve_id,
-			(optiga_key_usage_t) (OPTIGA_KEY_USAGE_KEY_AGREEMENT | OPTIGA_KEY_USAGE_AUTHENTICATION),
-			FALSE, &optiga_key_id, public_key, (uint16_t *) &public_key_len);
+		optiga_sync_begin(p_sync);
 
-	if (OPTIGA_LIB_SUCCESS != crypt_sync_status)
-	{
-		return_status = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
-		goto cleanup;
-	}
+		//invoke optiga command to generate a key pair.
+		crypt_sync_status = optiga_crypt_ecc_generate_keypair(me, curve_id,
+				(optiga_key_usage_t) (OPTIGA_KEY_USAGE_KEY_AGREEMENT | OPTIGA_KEY_USAGE_AUTHENTICATION),
+				FALSE, &optiga_key_id, public_key, (uint16_t *) &public_key_len);
 
-	while (OPTIGA_LIB_BUSY == crypt_event_completed_status)
-	{
-		pal_os_timer_delay_in_milliseconds(10);
+		if (OPTIGA_LIB_SUCCESS != crypt_sync_status)
+		{
+			return_status = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+			goto cleanup;
+		}
+
+		optiga_sync_wait(p_sync);
+
+		if (p_sync->status != OPTIGA_LIB_SUCCESS)
+		{
+			return_status = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+			goto cleanup;
+		}
 	}
 
-	if (crypt_event_completed_status != OPTIGA_LIB_SUCCESS)
+	//store public key generated from optiga into mbedtls structure .
+	if (mbedtls_ecp_point_read_binary(grp, Q, (unsigned char *) &public_key[public_key_offset], (size_t) public_key_len - public_key_offset) != 0)
 	{
 		return_status = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
 		goto cleanup;
 	}
 
-	//store public key generated from optiga into mbedtls structure .
-	if (mbedtls_ecp_point_read_binary(grp, Q, (unsigned char *) &public_key[public_key_offset], (size_t) public_key_len - public_key_offset) != 0)
+#ifndef OPTIGA_TRUSTM_EXTRACT_OID_FROM_PRIVKEY
+	// The private key stays in the session context; d = 0 (0xE103) or the pooled OID sends the shared secret to OPTIGA too
+	if (mbedtls_mpi_lset(d, pooled_oid) != 0)
 	{
-		return_status = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+		return_status = MBEDTLS_ERR_ECP_ALLOC_FAILED;
 		goto cleanup;
 	}
+#endif
 
 	return_status = 0;
 cleanup:
-	// destroy crypt instances
+	// hand the crypt instance back to the pool
 	if (me != NULL)
 	{
-		(void)optiga_crypt_destroy(me);
+		trustm_crypt_release(me);
 	}
+#ifdef TRUSTM_ECDH_POOL_ENABLED
+	if ((0 != return_status) && (0U != pooled_oid))
+	{
+		trustm_ecdh_pool_release(pooled_oid);
+	}
+#endif
 
 	return return_status;
 
 }
+
+/*
+ * Ephemeral key pair: OPTIGA or mbedtls on the host, as trustm_offload_select() picks
+ */
+int mbedtls_ecdh_gen_public(mbedtls_ecp_group *grp, mbedtls_mpi *d,
+		mbedtls_ecp_point *Q, int (*f_rng)(void *, unsigned char *, size_t),
+		void *p_rng) {
+
+	trustm_offload_mode_t path = trustm_offload_select(TRUSTM_OFFLOAD_ECDH, grp->id);
+	uint32_t start_us = pal_os_timer_get_time_in_microseconds();
+	int return_status;
+
+	if (TRUSTM_OFFLOAD_HOST == path)
+	{
+		return_status = trustm_offload_ecdh_gen_public_host(grp, d, Q, f_rng, p_rng);
+	}
+	else
+	{
+		return_status = trustm_ecdh_gen_public_optiga(grp, d, Q, f_rng, p_rng);
+	}
+	if (0 == return_status)
+	{
+		trustm_offload_record(TRUSTM_OFFLOAD_ECDH, grp->id, path,
+		                      pal_os_timer_get_time_in_microseconds() - start_us);
+	}
+	return return_status;
+}
 #endif
 
 
@@ -161,7 +206,7 @@ cleanup:
 /*
  * Compute shared secret (SEC1 3.3.1)
  */
-int mbedtls_ecdh_compute_shared(mbedtls_ecp_group *grp, mbedtls_mpi *z,
+static int trustm_ecdh_compute_shared_optiga(mbedtls_ecp_group *grp, mbedtls_mpi *z,
 		const mbedtls_ecp_point *Q, const mbedtls_mpi *d,
 		int (*f_rng)(void *, unsigned char *, size_t), void *p_rng) {
 
@@ -172,6 +217,7 @@ int mbedtls_ecdh_compute_shared(mbedtls_ecp_group *grp, mbedtls_mpi *z,
 	uint8_t buf[150];
 	uint8_t publickey_offset = 3;
 	optiga_crypt_t * me = NULL;
+	optiga_sync_t * p_sync = NULL;
     optiga_lib_status_t crypt_sync_status = OPTIGA_CRYPT_ERROR;
 
 #ifdef OPTIGA_TRUSTM_EXTRACT_OID_FROM_PRIVKEY
@@ -258,16 +304,26 @@ int mbedtls_ecdh_compute_shared(mbedtls_ecp_group *grp, mbedtls_mpi *z,
 	   return_status = MBEDTLS_ERR_ECP_ALLOC_FAILED;
         goto cleanup;
     }
+#else
+	//d = 0 stands for 0xE103, else it is the OID of a pooled key pair
+	if (mbedtls_mpi_cmp_int(d, 0) != 0)
+	{
+		optiga_key_id = (uint16_t)d->p[0];
+		if((mbedtls_mpi_bitlen(d) > 16) || (optiga_key_id < 0xe100) || (optiga_key_id > 0xe103)) {
+			return_status = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+			goto cleanup;
+		}
+	}
 #endif
 
-	me = optiga_crypt_create(0, optiga_crypt_event_completed, NULL);
+	me = trustm_crypt_acquire(&p_sync);
 	if (NULL == me)
 	{
 		return_status = MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
 		goto cleanup;
 	}
 
-	crypt_event_completed_status = OPTIGA_LIB_BUSY;
+	optiga_sync_begin(p_sync);
 	//Invoke OPTIGA command to generate shared secret and store in the OID/buffer.
 	crypt_sync_status = optiga_crypt_ecdh(me, optiga_key_id , &pk, 1, buf);
 
@@ -278,12 +334,9 @@ int mbedtls_ecdh_compute_shared(mbedtls_ecp_group *grp, mbedtls_mpi *z,
 	}
 
 	 //Wait until the optiga_crypt_ecdh operation is completed
-	while (OPTIGA_LIB_BUSY == crypt_event_completed_status)
-	{
-		pal_os_timer_delay_in_milliseconds(10);
-	}
+	optiga_sync_wait(p_sync);
 
-	if (crypt_event_completed_status != OPTIGA_LIB_SUCCESS)
+	if (p_sync->status != OPTIGA_LIB_SUCCESS)
 	{
 		return_status = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
 		goto cleanup;
@@ -293,14 +346,35 @@ int mbedtls_ecdh_compute_shared(mbedtls_ecp_group *grp, mbedtls_mpi *z,
 	return_status = 0;
 
 cleanup:
-	// destroy crypt instances
+	// hand the crypt instance back to the pool
 	if (me != NULL)
 	{
-    	(void)optiga_crypt_destroy(me);
+    	trustm_crypt_release(me);
 	}
+#ifdef TRUSTM_ECDH_POOL_ENABLED
+	// an ephemeral key is spent by one shared secret, successful or not
+	if (me != NULL)
+	{
+		trustm_ecdh_pool_release(optiga_key_id);
+	}
+#endif
 	return return_status;
 
 }
+
+/*
+ * Shared secret on the path the private key was made on
+ */
+int mbedtls_ecdh_compute_shared(mbedtls_ecp_group *grp, mbedtls_mpi *z,
+		const mbedtls_ecp_point *Q, const mbedtls_mpi *d,
+		int (*f_rng)(void *, unsigned char *, size_t), void *p_rng) {
+
+	if (trustm_offload_is_host_key(grp, d))
+	{
+		return trustm_offload_ecdh_compute_shared_host(grp, z, Q, d, f_rng, p_rng);
+	}
+	return trustm_ecdh_compute_shared_optiga(grp, z, Q, d, f_rng, p_rng);
+}
 #endif
 
 #endif
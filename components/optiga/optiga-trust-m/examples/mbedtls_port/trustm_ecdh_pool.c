@@ -0,0 +1,228 @@
+/**
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* @{
+*/
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "optiga/pal/pal_os_timer.h"
+#include "optiga_sync.h"
+#include "trustm_crypt.h"
+#include "trustm_ecdh_pool.h"
+
+#define TRUSTM_ECDH_POOL_TASK_STACK_BYTES   (3072U)
+// Back off after a failed generation, the handshake that misses generates on demand
+#define TRUSTM_ECDH_POOL_RETRY_MS           (100U)
+#define TRUSTM_ECDH_POOL_OID(index)         ((uint16_t)(0xE102U - (index)))
+
+#define TRUSTM_ECDH_POOL_EMPTY              (0U)
+#define TRUSTM_ECDH_POOL_READY              (1U)
+#define TRUSTM_ECDH_POOL_TAKEN              (2U)
+
+typedef struct trustm_ecdh_pool_slot
+{
+    uint8_t public_key[TRUSTM_ECDH_POOL_PUBLIC_KEY_BYTES];
+    uint16_t length;
+    uint8_t state;
+    // Time of the take, for the hold time of TAKEN slots
+    uint32_t taken_us;
+} trustm_ecdh_pool_slot_t;
+
+// Slots and counters, guarded by trustm_ecdh_pool_lock. Only the refill task writes EMPTY slots
+static trustm_ecdh_pool_slot_t trustm_ecdh_pool[TRUSTM_ECDH_POOL_SIZE];
+static trustm_ecdh_pool_stats_t trustm_ecdh_pool_counters;
+static portMUX_TYPE trustm_ecdh_pool_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t trustm_ecdh_pool_task_handle;
+
+// Generates the key pair of slot index into its session context
+static bool_t trustm_ecdh_pool_fill(uint32_t index)
+{
+    uint8_t public_key[TRUSTM_ECDH_POOL_PUBLIC_KEY_BYTES];
+    uint16_t length = sizeof(public_key);
+    optiga_key_id_t key_id = (optiga_key_id_t)TRUSTM_ECDH_POOL_OID(index);
+    optiga_crypt_t * me;
+    optiga_sync_t * p_sync = NULL;
+    optiga_lib_status_t return_status = OPTIGA_CRYPT_ERROR;
+
+    me = trustm_crypt_acquire(&p_sync);
+    if (NULL != me)
+    {
+        // Refills are never urgent, the instance goes back to the ALT port at normal priority
+        OPTIGA_CRYPT_SET_PRIORITY(me, OPTIGA_CMD_PRIORITY_LOW);
+        return_status = OPTIGA_SYNC_CALL(p_sync, OPTIGA_SYNC_WAIT_FOREVER,
+                                         optiga_crypt_ecc_generate_keypair(me, TRUSTM_ECDH_POOL_CURVE,
+                                             (optiga_key_usage_t)(OPTIGA_KEY_USAGE_KEY_AGREEMENT |
+                                                                  OPTIGA_KEY_USAGE_AUTHENTICATION),
+                                             FALSE, &key_id, public_key, &length));
+        OPTIGA_CRYPT_SET_PRIORITY(me, OPTIGA_CMD_PRIORITY_NORMAL);
+        trustm_crypt_release(me);
+    }
+
+    portENTER_CRITICAL(&trustm_ecdh_pool_lock);
+    if (OPTIGA_LIB_SUCCESS == return_status)
+    {
+        memcpy(trustm_ecdh_pool[index].public_key, public_key, length);
+        trustm_ecdh_pool[index].length = length;
+        trustm_ecdh_pool[index].state = TRUSTM_ECDH_POOL_READY;
+        trustm_ecdh_pool_counters.ready++;
+        trustm_ecdh_pool_counters.refills++;
+    }
+    else
+    {
+        trustm_ecdh_pool_counters.refill_errors++;
+    }
+    portEXIT_CRITICAL(&trustm_ecdh_pool_lock);
+
+    return ((OPTIGA_LIB_SUCCESS == return_status) ? TRUE : FALSE);
+}
+
+static void trustm_ecdh_pool_task(void * p_arg)
+{
+    uint32_t index;
+    bool_t empty;
+    trustm_ecdh_pool_slot_t * p_slot;
+
+    (void)p_arg;
+    while (1)
+    {
+        // Woken by each release, and after the hold time to look for abandoned key pairs
+        (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TRUSTM_ECDH_POOL_HOLD_MS));
+
+        for (index = 0; index < TRUSTM_ECDH_POOL_SIZE; index++)
+        {
+            p_slot = &trustm_ecdh_pool[index];
+            portENTER_CRITICAL(&trustm_ecdh_pool_lock);
+            if ((TRUSTM_ECDH_POOL_TAKEN == p_slot->state) &&
+                ((pal_os_timer_get_time_in_microseconds() - p_slot->taken_us) >= (TRUSTM_ECDH_POOL_HOLD_MS * 1000U)))
+            {
+                p_slot->state = TRUSTM_ECDH_POOL_EMPTY;
+                trustm_ecdh_pool_counters.reclaimed++;
+            }
+            empty = (TRUSTM_ECDH_POOL_EMPTY == p_slot->state) ? TRUE : FALSE;
+            portEXIT_CRITICAL(&trustm_ecdh_pool_lock);
+
+            if ((TRUE == empty) && (FALSE == trustm_ecdh_pool_fill(index)))
+            {
+                vTaskDelay(pdMS_TO_TICKS(TRUSTM_ECDH_POOL_RETRY_MS));
+                (void)xTaskNotifyGive(trustm_ecdh_pool_task_handle);
+                break;
+            }
+        }
+    }
+}
+
+optiga_lib_status_t trustm_ecdh_pool_start(void)
+{
+    optiga_lib_status_t return_status = OPTIGA_CRYPT_ERROR;
+
+    do
+    {
+        if (NULL != trustm_ecdh_pool_task_handle)
+        {
+            return_status = OPTIGA_LIB_SUCCESS;
+            break;
+        }
+        if (pdPASS != xTaskCreate(trustm_ecdh_pool_task, "trustm_ecdh_pool", TRUSTM_ECDH_POOL_TASK_STACK_BYTES,
+                                  NULL, TRUSTM_ECDH_POOL_TASK_PRIORITY, &trustm_ecdh_pool_task_handle))
+        {
+            trustm_ecdh_pool_task_handle = NULL;
+            break;
+        }
+        // First fill
+        (void)xTaskNotifyGive(trustm_ecdh_pool_task_handle);
+        return_status = OPTIGA_LIB_SUCCESS;
+    } while (FALSE);
+
+    return (return_status);
+}
+
+uint16_t trustm_ecdh_pool_take(mbedtls_ecp_group_id gid, uint8_t * p_public_key, uint16_t * p_length)
+{
+    uint16_t oid = 0;
+    uint32_t index;
+    trustm_ecdh_pool_slot_t * p_slot;
+
+    do
+    {
+        if ((TRUSTM_ECDH_POOL_GROUP != gid) || (NULL == trustm_ecdh_pool_task_handle))
+        {
+            break;
+        }
+        portENTER_CRITICAL(&trustm_ecdh_pool_lock);
+        for (index = 0; index < TRUSTM_ECDH_POOL_SIZE; index++)
+        {
+            p_slot = &trustm_ecdh_pool[index];
+            if ((TRUSTM_ECDH_POOL_READY == p_slot->state) && (p_slot->length <= *p_length))
+            {
+                memcpy(p_public_key, p_slot->public_key, p_slot->length);
+                *p_length = p_slot->length;
+                p_slot->state = TRUSTM_ECDH_POOL_TAKEN;
+                p_slot->taken_us = pal_os_timer_get_time_in_microseconds();
+                oid = TRUSTM_ECDH_POOL_OID(index);
+                trustm_ecdh_pool_counters.ready--;
+                trustm_ecdh_pool_counters.hits++;
+                break;
+            }
+        }
+        if (0U == oid)
+        {
+            trustm_ecdh_pool_counters.misses++;
+        }
+        portEXIT_CRITICAL(&trustm_ecdh_pool_lock);
+    } while (FALSE);
+
+    return (oid);
+}
+
+void trustm_ecdh_pool_release(uint16_t oid)
+{
+    uint32_t index = TRUSTM_ECDH_POOL_OID(0) - (uint32_t)oid;
+
+    // A slot already reclaimed and refilled keeps its new key pair
+    if ((oid <= TRUSTM_ECDH_POOL_OID(0)) && (index < TRUSTM_ECDH_POOL_SIZE))
+    {
+        portENTER_CRITICAL(&trustm_ecdh_pool_lock);
+        if (TRUSTM_ECDH_POOL_TAKEN == trustm_ecdh_pool[index].state)
+        {
+            trustm_ecdh_pool[index].state = TRUSTM_ECDH_POOL_EMPTY;
+        }
+        portEXIT_CRITICAL(&trustm_ecdh_pool_lock);
+        if (NULL != trustm_ecdh_pool_task_handle)
+        {
+            (void)xTaskNotifyGive(trustm_ecdh_pool_task_handle);
+        }
+    }
+}
+
+void trustm_ecdh_pool_get_stats(trustm_ecdh_pool_stats_t * p_stats)
+{
+    portENTER_CRITICAL(&trustm_ecdh_pool_lock);
+    *p_stats = trustm_ecdh_pool_counters;
+    portEXIT_CRITICAL(&trustm_ecdh_pool_lock);
+}
+
+/**
+* @}
+*/
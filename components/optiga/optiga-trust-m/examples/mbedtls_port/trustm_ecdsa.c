@@ -29,13 +29,16 @@
 #if defined(MBEDTLS_ECDSA_C)
 
 #include "mbedtls/ecdsa.h"
-#include "mbedtls/asn1write.h"
 
 #include <string.h>
 #include "optiga/optiga_crypt.h"
 #include "optiga/optiga_util.h"
 #include "optiga/pal/pal_os_timer.h"
 #include "optiga/common/optiga_lib_common.h"
+#include "optiga_sync.h"
+#include "trustm_crypt.h"
+#include "trustm_offload.h"
+#include "trustm_ecdsa.h"
 
 #define PRINT_SIGNATURE   0
 #define PRINT_HASH        0
@@ -45,41 +48,111 @@
 #define CONFIG_OPTIGA_TRUST_M_PRIVKEY_SLOT OPTIGA_KEY_ID_E0F0
 #endif
 
-static volatile optiga_lib_status_t crypt_event_completed_status;
+// Length of r and s on curve gid, 0 if OPTIGA does not support the curve
+static size_t trustm_ecdsa_component_size(mbedtls_ecp_group_id gid)
+{
+	switch (gid)
+	{
+		case MBEDTLS_ECP_DP_SECP256R1:
+		case MBEDTLS_ECP_DP_BP256R1:
+			return 32;
+		case MBEDTLS_ECP_DP_SECP384R1:
+		case MBEDTLS_ECP_DP_BP384R1:
+			return 48;
+		case MBEDTLS_ECP_DP_BP512R1:
+			return 64;
+		case MBEDTLS_ECP_DP_SECP521R1:
+			return 66;
+		default:
+			return 0;
+	}
+}
 
-//lint --e{818} suppress "argument "context" is not used in the sample provided"
-static void optiga_crypt_event_completed(void * context, optiga_lib_status_t return_status)
+/*
+ * OPTIGA signatures are two concatenated DER INTEGERs. At most 67 bytes each,
+ * so the length always fits the short form.
+ */
+static int trustm_ecdsa_der_to_rs(const uint8_t * der, size_t der_len, uint8_t * rs, size_t size)
 {
-	crypt_event_completed_status = return_status;
-    if (NULL != context)
-    {
-        // callback to upper layer here
-    }
+	const uint8_t * p = der;
+	const uint8_t * end = der + der_len;
+	uint8_t * out = rs;
+	size_t len;
+	int i;
+
+	memset(rs, 0x00, 2 * size);
+	for (i = 0; i < 2; i++, out += size)
+	{
+		if (((end - p) < 2) || (0x02 != p[0]) || (p[1] > (end - p - 2)))
+		{
+			return MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+		}
+		len = p[1];
+		p += 2;
+		// drop the sign byte and any other leading zero
+		while ((len > 0) && (0x00 == *p))
+		{
+			p++;
+			len--;
+		}
+		if (len > size)
+		{
+			return MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+		}
+		memcpy(out + size - len, p, len);
+		p += len;
+	}
+	return 0;
 }
 
-#if defined(MBEDTLS_ECDSA_SIGN_ALT)
-int mbedtls_ecdsa_sign( mbedtls_ecp_group *grp, mbedtls_mpi *r, mbedtls_mpi *s,
-                const mbedtls_mpi *d, const unsigned char *buf, size_t blen,
-                int (*f_rng)(void *, unsigned char *, size_t), void *p_rng )
+static size_t trustm_ecdsa_rs_to_der(const uint8_t * rs, size_t size, uint8_t * der)
 {
+	const uint8_t * in = rs;
+	uint8_t * p = der;
+	size_t len;
+	int i;
 
+	for (i = 0; i < 2; i++, in += size)
+	{
+		len = size;
+		while ((len > 1) && (0x00 == in[size - len]))
+		{
+			len--;
+		}
+		*p++ = 0x02;
+		// a set top bit needs a zero byte to keep the INTEGER positive
+		*p++ = (uint8_t)(len + ((in[size - len] & 0x80) ? 1 : 0));
+		if (in[size - len] & 0x80)
+		{
+			*p++ = 0x00;
+		}
+		memcpy(p, &in[size - len], len);
+		p += len;
+	}
+	return (size_t)(p - der);
+}
+
+int trustm_ecdsa_sign_raw(mbedtls_ecp_group_id gid, const unsigned char * buf, size_t blen,
+                          unsigned char * rs, size_t * rs_len)
+{
     int return_status = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
-    uint8_t der_signature[150];
+    uint8_t der_signature[2 * (TRUSTM_ECDSA_MAX_COMPONENT_BYTES + 3)];
     uint16_t dslen = sizeof(der_signature);
-    uint8_t *p = der_signature;
-    const uint8_t * end = NULL;
+    size_t size = trustm_ecdsa_component_size(gid);
     optiga_crypt_t * me = NULL;
+    optiga_sync_t * p_sync = NULL;
     optiga_lib_status_t crypt_sync_status = OPTIGA_CRYPT_ERROR;
 
-    end = (der_signature + dslen);
-    memset(der_signature, 0x00, sizeof(der_signature));
-
-    me = optiga_crypt_create(0, optiga_crypt_event_completed, NULL);
-    if (NULL == me)
-    {
-    	return_status = MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
-    	goto cleanup;
-    }
+	if (0 == size)
+	{
+		return_status = MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
+		goto cleanup;
+	}
+	if (*rs_len < 2 * size)
+	{
+		return_status = MBEDTLS_ERR_ECP_BUFFER_TOO_SMALL;
+		goto cleanup;
+	}
 
 #if (PRINT_HASH==1)
 	for(int x=0; x<blen;)
@@ -90,8 +163,15 @@ int mbedtls_ecdsa_sign( mbedtls_ecp_group *grp, mbedtls_mpi *r, mbedtls_mpi *s,
 		x+=8;
 	}
 #endif
+	me = trustm_crypt_acquire(&p_sync);
+	if (NULL == me)
+	{
+		return_status = MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
+		goto cleanup;
+	}
+
 	// Reset the status variable (updated via callback, when requested operation is finiesh, or timeout)
-	crypt_event_completed_status = OPTIGA_LIB_BUSY;
+	optiga_sync_begin(p_sync);
 
 	// Signing data with the Secure Element
 	crypt_sync_status = optiga_crypt_ecdsa_sign(me, (unsigned char *)buf, blen, CONFIG_OPTIGA_TRUST_M_PRIVKEY_SLOT, der_signature, &dslen);
@@ -101,20 +181,17 @@ int mbedtls_ecdsa_sign( mbedtls_ecp_group *grp, mbedtls_mpi *r, mbedtls_mpi *s,
 		goto cleanup;
 	}
 
-	//Wait until the optiga_crypt_ecdsa_verify is completed
-	while (OPTIGA_LIB_BUSY == crypt_event_completed_status)
-	{
-		pal_os_timer_delay_in_milliseconds(10);
-	}
+	//Wait until the optiga_crypt_ecdsa_sign is completed
+	optiga_sync_wait(p_sync);
 
-	if(crypt_event_completed_status!= OPTIGA_LIB_SUCCESS)
+	if(p_sync->status!= OPTIGA_LIB_SUCCESS)
 	{
 		return_status = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
 		goto cleanup;
 	}
 
 #if (PRINT_SIGNATURE==1)
-	for(int x=0; x<sizeof(der_signature);)
+	for(int x=0; x<dslen;)
 	{
 		printf(("%.2X %.2X %.2X %.2X %.2X %.2X %.2X %.2X \r\n",
 				der_signature[x],der_signature[x+1],
@@ -125,35 +202,48 @@ int mbedtls_ecdsa_sign( mbedtls_ecp_group *grp, mbedtls_mpi *r, mbedtls_mpi *s,
 	}
 #endif
 
-	return_status = mbedtls_asn1_get_mpi(&p, end, r);
+	return_status = trustm_ecdsa_der_to_rs(der_signature, dslen, rs, size);
 	if (0 != return_status)
 	{
 		goto cleanup;
 	}
+	*rs_len = 2 * size;
 
-	return_status = mbedtls_asn1_get_mpi(&p, end, s);
-	if (0 != return_status)
-	{
-		goto cleanup;
-	}
-
-	return_status = 0;
 cleanup:
-	// destroy crypt instances
+	// hand the crypt instance back to the pool
 	if (me != NULL)
 	{
-		(void)optiga_crypt_destroy(me);
+		trustm_crypt_release(me);
 	}
 
     return return_status;
+}
 
+#if defined(MBEDTLS_ECDSA_SIGN_ALT)
+int mbedtls_ecdsa_sign( mbedtls_ecp_group *grp, mbedtls_mpi *r, mbedtls_mpi *s,
+                const mbedtls_mpi *d, const unsigned char *buf, size_t blen,
+                int (*f_rng)(void *, unsigned char *, size_t), void *p_rng )
+{
+    uint8_t rs[2 * TRUSTM_ECDSA_MAX_COMPONENT_BYTES];
+    size_t rs_len = sizeof(rs);
+    int return_status;
+
+    return_status = trustm_ecdsa_sign_raw(grp->id, buf, blen, rs, &rs_len);
+    if (0 == return_status)
+    {
+        // r and s always have the curve length, so reused MPIs keep their limbs
+        return_status = mbedtls_mpi_read_binary(r, rs, rs_len / 2);
+    }
+    if (0 == return_status)
+    {
+        return_status = mbedtls_mpi_read_binary(s, &rs[rs_len / 2], rs_len / 2);
+    }
+    return return_status;
 }
 #endif
 
-#if defined(MBEDTLS_ECDSA_VERIFY_ALT)
-int mbedtls_ecdsa_verify( mbedtls_ecp_group *grp,
-                  const unsigned char *buf, size_t blen,
-                  const mbedtls_ecp_point *Q, const mbedtls_mpi *r, const mbedtls_mpi *s)
+int trustm_ecdsa_verify_raw(mbedtls_ecp_group * grp, const unsigned char * buf, size_t blen,
+                            const mbedtls_ecp_point * Q, const unsigned char * rs, size_t rs_len)
 {
 
     int return_status = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
@@ -161,23 +251,13 @@ int mbedtls_ecdsa_verify( mbedtls_ecp_group *grp,
     public_key_from_host_t public_key;
     uint8_t public_key_out [150];
 	uint8_t publickey_offset = 3;
-    uint8_t signature [150];
-    uint8_t * p = NULL;
+    uint8_t signature [2 * (TRUSTM_ECDSA_MAX_COMPONENT_BYTES + 3)];
     size_t  signature_len = 0;
     size_t public_key_len = 0;
     uint8_t truncated_hash_length;
     
     optiga_crypt_t * me = NULL;
-
-    p = signature + sizeof(signature);
-    memset(signature, 0x00, sizeof(signature));
-
-    me = optiga_crypt_create(0, optiga_crypt_event_completed, NULL);
-    if (NULL == me)
-    {
-    	return_status = MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
-    	goto cleanup;
-    }
+    optiga_sync_t * p_sync = NULL;
 
 	if ((grp->id <  MBEDTLS_ECP_DP_SECP256R1) ||
 		 (grp->id > MBEDTLS_ECP_DP_BP512R1))
@@ -185,6 +265,11 @@ int mbedtls_ecdsa_verify( mbedtls_ecp_group *grp,
 		return_status = MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
 		goto cleanup;
 	}
+	if (rs_len != 2 * trustm_ecdsa_component_size(grp->id))
+	{
+		return_status = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+		goto cleanup;
+	}
 
 	public_key.key_type = OPTIGA_ECC_CURVE_NIST_P_256;
 	truncated_hash_length = 32; //maximum bytes of hash length for the curve
@@ -216,8 +301,7 @@ int mbedtls_ecdsa_verify( mbedtls_ecp_group *grp,
 		publickey_offset = 4;
 	}
 	
-    signature_len = mbedtls_asn1_write_mpi( &p, signature, s );
-	signature_len += mbedtls_asn1_write_mpi( &p, signature, r );
+	signature_len = trustm_ecdsa_rs_to_der(rs, rs_len / 2, signature);
 
 #if (PRINT_SIGNATURE==1)
 	for(int x=0; x<sizeof(signature);)
@@ -279,9 +363,15 @@ int mbedtls_ecdsa_verify( mbedtls_ecp_group *grp,
 #undef pubk(a)
 #endif
 
-	crypt_event_completed_status = OPTIGA_LIB_BUSY;
+	me = trustm_crypt_acquire(&p_sync);
+	if (NULL == me)
+	{
+		return_status = MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
+		goto cleanup;
+	}
+	optiga_sync_begin(p_sync);
 	crypt_sync_status = optiga_crypt_ecdsa_verify ( me, (uint8_t *) buf, blen,
-													 (uint8_t *) p, signature_len,
+													 signature, signature_len,
 													  OPTIGA_CRYPT_HOST_DATA, (void *)&public_key );
 
 	if (OPTIGA_LIB_SUCCESS != crypt_sync_status)
@@ -291,26 +381,71 @@ int mbedtls_ecdsa_verify( mbedtls_ecp_group *grp,
 	}
 
 	//Wait until the optiga_crypt_ecdsa_verify is completed
-	while (OPTIGA_LIB_BUSY == crypt_event_completed_status)
-	{
-		pal_os_timer_delay_in_milliseconds(10);
-	}
+	optiga_sync_wait(p_sync);
 
-	if ( crypt_event_completed_status != OPTIGA_LIB_SUCCESS )
+	if ( p_sync->status != OPTIGA_LIB_SUCCESS )
 	{
 		return_status = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
 		goto cleanup;
 	}
 	return_status = 0;
 cleanup:
-	// destroy crypt instances
+	// hand the crypt instance back to the pool
 	if (me != NULL)
 	{
-		(void)optiga_crypt_destroy(me);
+		trustm_crypt_release(me);
 	}
     return return_status;
 
 }
+
+#if defined(MBEDTLS_ECDSA_VERIFY_ALT)
+static int trustm_ecdsa_verify_optiga( mbedtls_ecp_group *grp,
+                  const unsigned char *buf, size_t blen,
+                  const mbedtls_ecp_point *Q, const mbedtls_mpi *r, const mbedtls_mpi *s)
+{
+    uint8_t rs[2 * TRUSTM_ECDSA_MAX_COMPONENT_BYTES];
+    size_t size = trustm_ecdsa_component_size(grp->id);
+
+    if (0 == size)
+    {
+        return MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
+    }
+    // r or s longer than the curve can't be valid
+    if ((0 != mbedtls_mpi_write_binary(r, rs, size)) ||
+        (0 != mbedtls_mpi_write_binary(s, &rs[size], size)))
+    {
+        return MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+    }
+    return trustm_ecdsa_verify_raw(grp, buf, blen, Q, rs, 2 * size);
+}
+
+/*
+ * Public key verify: OPTIGA or mbedtls on the host, as trustm_offload_select() picks
+ */
+int mbedtls_ecdsa_verify( mbedtls_ecp_group *grp,
+                  const unsigned char *buf, size_t blen,
+                  const mbedtls_ecp_point *Q, const mbedtls_mpi *r, const mbedtls_mpi *s)
+{
+    trustm_offload_mode_t path = trustm_offload_select(TRUSTM_OFFLOAD_ECDSA_VERIFY, grp->id);
+    uint32_t start_us = pal_os_timer_get_time_in_microseconds();
+    int return_status;
+
+    if (TRUSTM_OFFLOAD_HOST == path)
+    {
+        return_status = trustm_offload_ecdsa_verify_host(grp, buf, blen, Q, r, s);
+    }
+    else
+    {
+        return_status = trustm_ecdsa_verify_optiga(grp, buf, blen, Q, r, s);
+    }
+    if (0 == return_status)
+    {
+        trustm_offload_record(TRUSTM_OFFLOAD_ECDSA_VERIFY, grp->id, path,
+                              pal_os_timer_get_time_in_microseconds() - start_us);
+    }
+    return return_status;
+}
 #endif
 
 #if defined(MBEDTLS_ECDSA_GENKEY_ALT)
@@ -326,14 +461,8 @@ int mbedtls_ecdsa_genkey( mbedtls_ecdsa_context *ctx, mbedtls_ecp_group_id gid,
     mbedtls_ecp_group *grp = &ctx->grp;
     uint16_t privkey_oid = OPTIGA_KEY_ID_E0F0;
     optiga_crypt_t * me = NULL;
+    optiga_sync_t * p_sync = NULL;
 
-    me = optiga_crypt_create(0, optiga_crypt_event_completed, NULL);
-    if (NULL == me)
-    {
-        return_status = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
-        goto cleanup;
-    }
- 
     mbedtls_ecp_group_load( &ctx->grp, gid );
  
     //checking group against the supported curves of OPTIGA Trust M
@@ -365,8 +494,15 @@ int mbedtls_ecdsa_genkey( mbedtls_ecdsa_context *ctx, mbedtls_ecp_group_id gid,
 	{
 		curve_id = OPTIGA_ECC_CURVE_BRAIN_POOL_P_512R1;
 	}
+    me = trustm_crypt_acquire(&p_sync);
+    if (NULL == me)
+    {
+        return_status = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+        goto cleanup;
+    }
+
     //invoke optiga command to generate a key pair.
-    crypt_event_completed_status = OPTIGA_LIB_BUSY;
+    optiga_sync_begin(p_sync);
     crypt_sync_status = optiga_crypt_ecc_generate_keypair( me, curve_id,
                                                 (optiga_key_usage_t)( OPTIGA_KEY_USAGE_KEY_AGREEMENT | OPTIGA_KEY_USAGE_AUTHENTICATION ),
                                                 FALSE,
@@ -379,10 +515,7 @@ int mbedtls_ecdsa_genkey( mbedtls_ecdsa_context *ctx, mbedtls_ecp_group_id gid,
         goto cleanup;
     }
 
-    while (OPTIGA_LIB_BUSY == crypt_event_completed_status)
-    {
-    	pal_os_timer_delay_in_milliseconds(5);
-    }
+    optiga_sync_wait(p_sync);
 
     //store public key generated from optiga into mbedtls structure .
     if (mbedtls_ecp_point_read_binary( grp, &ctx->Q,(unsigned char *)&public_key[3],(size_t )public_key_len-3 ) != 0)
@@ -392,10 +525,10 @@ int mbedtls_ecdsa_genkey( mbedtls_ecdsa_context *ctx, mbedtls_ecp_group_id gid,
     }
     return_status = 0;
 cleanup:
-	// destroy crypt instances
+	// hand the crypt instance back to the pool
 	if (me != NULL)
 	{
-		(void)optiga_crypt_destroy(me);
+		trustm_crypt_release(me);
 	}
 
     return return_status;
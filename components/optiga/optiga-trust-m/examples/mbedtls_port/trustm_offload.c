@@ -0,0 +1,421 @@
+/**
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* @{
+*/
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_random.h"
+#include "mbedtls/ecdsa.h"
+#include "mbedtls/ecdh.h"
+#include "optiga/pal/pal_os_timer.h"
+#include "trustm_offload.h"
+
+#ifndef CONFIG_OPTIGA_TRUST_M_ECDSA_VERIFY_OFFLOAD
+#define CONFIG_OPTIGA_TRUST_M_ECDSA_VERIFY_OFFLOAD      TRUSTM_OFFLOAD_AUTO
+#endif
+
+#ifndef CONFIG_OPTIGA_TRUST_M_ECDH_OFFLOAD
+#define CONFIG_OPTIGA_TRUST_M_ECDH_OFFLOAD              TRUSTM_OFFLOAD_OPTIGA
+#endif
+
+#define TRUSTM_OFFLOAD_ROW(mode)    { (mode), (mode), (mode), (mode), (mode), (mode) }
+// Weight of a new sample in the moving average is 1/2^TRUSTM_OFFLOAD_EWMA_SHIFT
+#define TRUSTM_OFFLOAD_EWMA_SHIFT   (3U)
+
+static uint8_t trustm_offload_mode[TRUSTM_OFFLOAD_OPS][TRUSTM_OFFLOAD_CURVES] =
+{
+    TRUSTM_OFFLOAD_ROW(CONFIG_OPTIGA_TRUST_M_ECDSA_VERIFY_OFFLOAD),
+    TRUSTM_OFFLOAD_ROW(CONFIG_OPTIGA_TRUST_M_ECDH_OFFLOAD)
+};
+// Moving average per path, indexed by TRUSTM_OFFLOAD_OPTIGA/TRUSTM_OFFLOAD_HOST, 0 until measured [us]
+static uint32_t trustm_offload_ewma_us[TRUSTM_OFFLOAD_OPS][TRUSTM_OFFLOAD_CURVES][2];
+static uint32_t trustm_offload_calls[TRUSTM_OFFLOAD_OPS][TRUSTM_OFFLOAD_CURVES];
+static portMUX_TYPE trustm_offload_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Index into the policy tables, TRUSTM_OFFLOAD_CURVES for curves OPTIGA does not support
+static uint32_t trustm_offload_curve_index(mbedtls_ecp_group_id gid)
+{
+    if ((gid < MBEDTLS_ECP_DP_SECP256R1) || (gid > MBEDTLS_ECP_DP_BP512R1))
+    {
+        return (TRUSTM_OFFLOAD_CURVES);
+    }
+    return ((uint32_t)(gid - MBEDTLS_ECP_DP_SECP256R1));
+}
+
+static int trustm_offload_rng(void * p_rng, unsigned char * p_out, size_t length)
+{
+    (void)p_rng;
+    esp_fill_random(p_out, length);
+    return (0);
+}
+
+// Affine x coordinate of a point, without touching the mbedtls_ecp_point members
+static int trustm_offload_point_x(const mbedtls_ecp_group * grp, const mbedtls_ecp_point * p_point, mbedtls_mpi * x)
+{
+    unsigned char encoded[1 + 2 * MBEDTLS_ECP_MAX_BYTES];
+    size_t length = 0;
+    int ret;
+
+    ret = mbedtls_ecp_point_write_binary(grp, p_point, MBEDTLS_ECP_PF_UNCOMPRESSED, &length,
+                                         encoded, sizeof(encoded));
+    if (0 == ret)
+    {
+        ret = mbedtls_mpi_read_binary(x, &encoded[1], (length - 1) / 2);
+    }
+    return (ret);
+}
+
+// Hash to integer modulo n as in SEC1 4.1.3 step 5
+static int trustm_offload_hash_to_mpi(const mbedtls_ecp_group * grp, mbedtls_mpi * e,
+                                      const unsigned char * buf, size_t blen)
+{
+    size_t n_size = (grp->nbits + 7) / 8;
+    size_t use_size = (blen > n_size) ? n_size : blen;
+    int ret;
+
+    MBEDTLS_MPI_CHK(mbedtls_mpi_read_binary(e, buf, use_size));
+    if ((use_size * 8) > grp->nbits)
+    {
+        MBEDTLS_MPI_CHK(mbedtls_mpi_shift_r(e, (use_size * 8) - grp->nbits));
+    }
+    if (mbedtls_mpi_cmp_mpi(e, &grp->N) >= 0)
+    {
+        MBEDTLS_MPI_CHK(mbedtls_mpi_sub_mpi(e, e, &grp->N));
+    }
+cleanup:
+    return (ret);
+}
+
+void trustm_offload_set(trustm_offload_op_t op, mbedtls_ecp_group_id gid, trustm_offload_mode_t mode)
+{
+    uint32_t index = trustm_offload_curve_index(gid);
+    uint32_t curve;
+
+    for (curve = 0; (op < TRUSTM_OFFLOAD_OPS) && (curve < TRUSTM_OFFLOAD_CURVES); curve++)
+    {
+        if ((MBEDTLS_ECP_DP_NONE == gid) || (curve == index))
+        {
+            trustm_offload_mode[op][curve] = (uint8_t)mode;
+        }
+    }
+}
+
+trustm_offload_mode_t trustm_offload_select(trustm_offload_op_t op, mbedtls_ecp_group_id gid)
+{
+    uint32_t index = trustm_offload_curve_index(gid);
+    trustm_offload_mode_t path;
+    trustm_offload_mode_t faster;
+    const uint32_t * p_ewma;
+
+    if ((op >= TRUSTM_OFFLOAD_OPS) || (TRUSTM_OFFLOAD_CURVES == index))
+    {
+        return (TRUSTM_OFFLOAD_HOST);
+    }
+    path = (trustm_offload_mode_t)trustm_offload_mode[op][index];
+    if (TRUSTM_OFFLOAD_AUTO == path)
+    {
+        portENTER_CRITICAL(&trustm_offload_lock);
+        p_ewma = trustm_offload_ewma_us[op][index];
+        // Measure each path once, then prefer the faster one and probe the other now and then
+        if (0 == p_ewma[TRUSTM_OFFLOAD_OPTIGA])
+        {
+            path = TRUSTM_OFFLOAD_OPTIGA;
+        }
+        else if (0 == p_ewma[TRUSTM_OFFLOAD_HOST])
+        {
+            path = TRUSTM_OFFLOAD_HOST;
+        }
+        else
+        {
+            faster = (p_ewma[TRUSTM_OFFLOAD_HOST] < p_ewma[TRUSTM_OFFLOAD_OPTIGA]) ?
+                     TRUSTM_OFFLOAD_HOST : TRUSTM_OFFLOAD_OPTIGA;
+            path = faster;
+            if (0 == (++trustm_offload_calls[op][index] % TRUSTM_OFFLOAD_PROBE_INTERVAL))
+            {
+                path = (TRUSTM_OFFLOAD_HOST == faster) ? TRUSTM_OFFLOAD_OPTIGA : TRUSTM_OFFLOAD_HOST;
+            }
+        }
+        portEXIT_CRITICAL(&trustm_offload_lock);
+    }
+    return (path);
+}
+
+void trustm_offload_record(trustm_offload_op_t op, mbedtls_ecp_group_id gid, trustm_offload_mode_t path,
+                           uint32_t time_us)
+{
+    uint32_t index = trustm_offload_curve_index(gid);
+    uint32_t * p_ewma;
+
+    if ((op < TRUSTM_OFFLOAD_OPS) && (TRUSTM_OFFLOAD_CURVES != index) && (path <= TRUSTM_OFFLOAD_HOST))
+    {
+        portENTER_CRITICAL(&trustm_offload_lock);
+        p_ewma = &trustm_offload_ewma_us[op][index][path];
+        if (0 == *p_ewma)
+        {
+            *p_ewma = (0 == time_us) ? 1U : time_us;
+        }
+        else
+        {
+            *p_ewma = (uint32_t)((int32_t)*p_ewma + (((int32_t)time_us - (int32_t)*p_ewma) >> TRUSTM_OFFLOAD_EWMA_SHIFT));
+        }
+        portEXIT_CRITICAL(&trustm_offload_lock);
+    }
+}
+
+int trustm_offload_ecdsa_verify_host(mbedtls_ecp_group * grp, const unsigned char * buf, size_t blen,
+                                     const mbedtls_ecp_point * Q, const mbedtls_mpi * r, const mbedtls_mpi * s)
+{
+    mbedtls_mpi e, s_inv, u1, u2, x;
+    mbedtls_ecp_point R;
+    int ret;
+
+    mbedtls_mpi_init(&e);
+    mbedtls_mpi_init(&s_inv);
+    mbedtls_mpi_init(&u1);
+    mbedtls_mpi_init(&u2);
+    mbedtls_mpi_init(&x);
+    mbedtls_ecp_point_init(&R);
+
+    // r and s in [1, n-1]
+    if ((mbedtls_mpi_cmp_int(r, 1) < 0) || (mbedtls_mpi_cmp_mpi(r, &grp->N) >= 0) ||
+        (mbedtls_mpi_cmp_int(s, 1) < 0) || (mbedtls_mpi_cmp_mpi(s, &grp->N) >= 0))
+    {
+        ret = MBEDTLS_ERR_ECP_VERIFY_FAILED;
+        goto cleanup;
+    }
+
+    // R = (e / s) G + (r / s) Q
+    MBEDTLS_MPI_CHK(trustm_offload_hash_to_mpi(grp, &e, buf, blen));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_inv_mod(&s_inv, s, &grp->N));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&u1, &e, &s_inv));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&u1, &u1, &grp->N));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&u2, r, &s_inv));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&u2, &u2, &grp->N));
+    MBEDTLS_MPI_CHK(mbedtls_ecp_muladd(grp, &R, &u1, &grp->G, &u2, Q));
+    if (mbedtls_ecp_is_zero(&R))
+    {
+        ret = MBEDTLS_ERR_ECP_VERIFY_FAILED;
+        goto cleanup;
+    }
+
+    // Valid if x(R) mod n == r
+    MBEDTLS_MPI_CHK(trustm_offload_point_x(grp, &R, &x));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&x, &x, &grp->N));
+    if (0 != mbedtls_mpi_cmp_mpi(&x, r))
+    {
+        ret = MBEDTLS_ERR_ECP_VERIFY_FAILED;
+    }
+
+cleanup:
+    mbedtls_mpi_free(&e);
+    mbedtls_mpi_free(&s_inv);
+    mbedtls_mpi_free(&u1);
+    mbedtls_mpi_free(&u2);
+    mbedtls_mpi_free(&x);
+    mbedtls_ecp_point_free(&R);
+    return (ret);
+}
+
+int trustm_offload_ecdh_gen_public_host(mbedtls_ecp_group * grp, mbedtls_mpi * d, mbedtls_ecp_point * Q,
+                                        int (*f_rng)(void *, unsigned char *, size_t), void * p_rng)
+{
+    return (mbedtls_ecp_gen_keypair(grp, d, Q, f_rng, p_rng));
+}
+
+int trustm_offload_ecdh_compute_shared_host(mbedtls_ecp_group * grp, mbedtls_mpi * z, const mbedtls_ecp_point * Q,
+                                            const mbedtls_mpi * d,
+                                            int (*f_rng)(void *, unsigned char *, size_t), void * p_rng)
+{
+    mbedtls_ecp_point P;
+    int ret;
+
+    mbedtls_ecp_point_init(&P);
+    MBEDTLS_MPI_CHK(mbedtls_ecp_check_pubkey(grp, Q));
+    // mbedtls blinds the multiplication with f_rng, fall back to the host RNG without one
+    MBEDTLS_MPI_CHK(mbedtls_ecp_mul(grp, &P, d, Q, (NULL != f_rng) ? f_rng : trustm_offload_rng, p_rng));
+    if (mbedtls_ecp_is_zero(&P))
+    {
+        ret = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+        goto cleanup;
+    }
+    MBEDTLS_MPI_CHK(trustm_offload_point_x(grp, &P, z));
+cleanup:
+    mbedtls_ecp_point_free(&P);
+    return (ret);
+}
+
+int trustm_offload_is_host_key(const mbedtls_ecp_group * grp, const mbedtls_mpi * d)
+{
+    // An OPTIGA key leaves at most a 16 bit OID in d, a host scalar has about the bit length of n
+    return ((mbedtls_mpi_bitlen(d) > 16U) && (0 == mbedtls_ecp_check_privkey(grp, d)));
+}
+
+// Host ECDSA signature of buf with d, to give the benchmark a valid signature
+static int trustm_offload_sign_host(mbedtls_ecp_group * grp, mbedtls_mpi * r, mbedtls_mpi * s,
+                                    const mbedtls_mpi * d, const unsigned char * buf, size_t blen)
+{
+    mbedtls_mpi k, e;
+    mbedtls_ecp_point R;
+    int ret;
+
+    mbedtls_mpi_init(&k);
+    mbedtls_mpi_init(&e);
+    mbedtls_ecp_point_init(&R);
+    do
+    {
+        // r = x(k G) mod n, s = (e + r d) / k mod n
+        MBEDTLS_MPI_CHK(mbedtls_ecp_gen_privkey(grp, &k, trustm_offload_rng, NULL));
+        MBEDTLS_MPI_CHK(mbedtls_ecp_mul(grp, &R, &k, &grp->G, trustm_offload_rng, NULL));
+        MBEDTLS_MPI_CHK(trustm_offload_point_x(grp, &R, r));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(r, r, &grp->N));
+        MBEDTLS_MPI_CHK(trustm_offload_hash_to_mpi(grp, &e, buf, blen));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(s, r, d));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_add_mpi(s, s, &e));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_inv_mod(&k, &k, &grp->N));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(s, s, &k));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(s, s, &grp->N));
+    } while ((0 == mbedtls_mpi_cmp_int(r, 0)) || (0 == mbedtls_mpi_cmp_int(s, 0)));
+cleanup:
+    mbedtls_mpi_free(&k);
+    mbedtls_mpi_free(&e);
+    mbedtls_ecp_point_free(&R);
+    return (ret);
+}
+
+// One call of op on the path the current policy selects
+static int trustm_offload_bench_call(trustm_offload_op_t op, mbedtls_ecp_group * grp, const unsigned char * hash,
+                                     const mbedtls_ecp_point * Q, const mbedtls_mpi * r, const mbedtls_mpi * s)
+{
+    int ret = MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
+
+    if (TRUSTM_OFFLOAD_ECDSA_VERIFY == op)
+    {
+        ret = mbedtls_ecdsa_verify(grp, hash, (grp->nbits + 7) / 8, Q, r, s);
+    }
+    else
+    {
+        mbedtls_mpi d, z;
+        mbedtls_ecp_point own_Q;
+
+        mbedtls_mpi_init(&d);
+        mbedtls_mpi_init(&z);
+        mbedtls_ecp_point_init(&own_Q);
+        ret = mbedtls_ecdh_gen_public(grp, &d, &own_Q, trustm_offload_rng, NULL);
+        if (0 == ret)
+        {
+            ret = mbedtls_ecdh_compute_shared(grp, &z, Q, &d, trustm_offload_rng, NULL);
+        }
+        mbedtls_mpi_free(&d);
+        mbedtls_mpi_free(&z);
+        mbedtls_ecp_point_free(&own_Q);
+    }
+    return (ret);
+}
+
+int trustm_offload_benchmark(trustm_offload_op_t op, mbedtls_ecp_group_id gid, uint32_t iterations,
+                             trustm_offload_result_t * p_result)
+{
+    uint32_t index = trustm_offload_curve_index(gid);
+    unsigned char hash[MBEDTLS_ECP_MAX_BYTES];
+    mbedtls_ecp_group grp;
+    mbedtls_mpi d, r, s;
+    mbedtls_ecp_point Q;
+    uint8_t saved_mode;
+    uint32_t path;
+    uint32_t count;
+    uint32_t done;
+    uint32_t start_us;
+    uint64_t total_us;
+    int ret;
+
+    memset(p_result, 0, sizeof(*p_result));
+    if ((op >= TRUSTM_OFFLOAD_OPS) || (TRUSTM_OFFLOAD_CURVES == index) || (0 == iterations))
+    {
+        return (MBEDTLS_ERR_ECP_BAD_INPUT_DATA);
+    }
+
+    mbedtls_ecp_group_init(&grp);
+    mbedtls_mpi_init(&d);
+    mbedtls_mpi_init(&r);
+    mbedtls_mpi_init(&s);
+    mbedtls_ecp_point_init(&Q);
+
+    // Host key pair: the verify key, or the peer of the ECDH exchange
+    MBEDTLS_MPI_CHK(mbedtls_ecp_group_load(&grp, gid));
+    MBEDTLS_MPI_CHK(mbedtls_ecp_gen_keypair(&grp, &d, &Q, trustm_offload_rng, NULL));
+    esp_fill_random(hash, sizeof(hash));
+    if (TRUSTM_OFFLOAD_ECDSA_VERIFY == op)
+    {
+        MBEDTLS_MPI_CHK(trustm_offload_sign_host(&grp, &r, &s, &d, hash, (grp.nbits + 7) / 8));
+    }
+
+    saved_mode = trustm_offload_mode[op][index];
+    for (path = TRUSTM_OFFLOAD_OPTIGA; path <= TRUSTM_OFFLOAD_HOST; path++)
+    {
+        trustm_offload_mode[op][index] = (uint8_t)path;
+        total_us = 0;
+        done = 0;
+        for (count = 0; count < iterations; count++)
+        {
+            start_us = pal_os_timer_get_time_in_microseconds();
+            if (0 == trustm_offload_bench_call(op, &grp, hash, &Q, &r, &s))
+            {
+                total_us += pal_os_timer_get_time_in_microseconds() - start_us;
+                done++;
+            }
+        }
+        if (done == iterations)
+        {
+            if (TRUSTM_OFFLOAD_OPTIGA == path)
+            {
+                p_result->optiga_us = (uint32_t)(total_us / done);
+            }
+            else
+            {
+                p_result->host_us = (uint32_t)(total_us / done);
+            }
+        }
+    }
+    trustm_offload_mode[op][index] = saved_mode;
+
+    // The calls above fed the moving averages; restart them from the clean means
+    portENTER_CRITICAL(&trustm_offload_lock);
+    trustm_offload_ewma_us[op][index][TRUSTM_OFFLOAD_OPTIGA] = p_result->optiga_us;
+    trustm_offload_ewma_us[op][index][TRUSTM_OFFLOAD_HOST] = p_result->host_us;
+    portEXIT_CRITICAL(&trustm_offload_lock);
+    ret = 0;
+
+cleanup:
+    mbedtls_ecp_group_free(&grp);
+    mbedtls_mpi_free(&d);
+    mbedtls_mpi_free(&r);
+    mbedtls_mpi_free(&s);
+    mbedtls_ecp_point_free(&Q);
+    return (ret);
+}
+
+/**
+* @}
+*/
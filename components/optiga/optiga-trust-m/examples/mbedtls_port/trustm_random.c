@@ -43,29 +43,26 @@
 #include "optiga/optiga_crypt.h"
 #include "optiga/optiga_util.h"
 #include "optiga/common/optiga_lib_common.h"
-
-optiga_lib_status_t crypt_event_completed_status;
-
-//lint --e{818} suppress "argument "context" is not used in the sample provided"
-static void optiga_crypt_event_completed(void * context, optiga_lib_status_t return_status)
-{
-    crypt_event_completed_status = return_status;
-    if (NULL != context)
-    {
-        // callback to upper layer here
-    }
-}
+#include "optiga_sync.h"
+#include "optiga_entropy.h"
+#include "trustm_crypt.h"
 
 int mbedtls_hardware_poll( void *data,
                            unsigned char *output, size_t len, size_t *olen )
 {
     int error = 0;
     optiga_crypt_t * me = NULL;
+    optiga_sync_t * p_sync = NULL;
     optiga_lib_status_t command_queue_status = OPTIGA_CRYPT_ERROR;
 
-    if (olen != NULL)
+    if ((olen != NULL) && (len <= 0xFFFFU) && (TRUE == optiga_entropy_take(output, (uint16_t)len)))
+    {
+        // Served from the pool refilled at idle time, no TRNG command on the handshake path
+        *olen = len;
+    }
+    else if (olen != NULL)
     {
-        me = optiga_crypt_create(0, optiga_crypt_event_completed, NULL);
+        me = trustm_crypt_acquire(&p_sync);
         if (NULL == me)
         {
             // MBEDTLS_ERR_PK_FEATURE_UNAVAILABLE
@@ -73,7 +70,7 @@ int mbedtls_hardware_poll( void *data,
         }
         else
         {
-            crypt_event_completed_status = OPTIGA_LIB_BUSY;
+            optiga_sync_begin(p_sync);
             command_queue_status = optiga_crypt_random(me, OPTIGA_RNG_TYPE_TRNG, output, len);
             if( command_queue_status != OPTIGA_LIB_SUCCESS)
             {
@@ -83,12 +80,9 @@ int mbedtls_hardware_poll( void *data,
 
             if (!error)
             {
-                while (OPTIGA_LIB_BUSY == crypt_event_completed_status)
-                {
-                    pal_os_timer_delay_in_milliseconds(5);
-                }
+                optiga_sync_wait(p_sync);
 
-                if(crypt_event_completed_status!= OPTIGA_LIB_SUCCESS)
+                if(p_sync->status!= OPTIGA_LIB_SUCCESS)
                 {
                     // MBEDTLS_ERR_PK_FEATURE_UNAVAILABLE
                     error = -0x0034;
@@ -99,7 +93,7 @@ int mbedtls_hardware_poll( void *data,
                 }
             }
         }
-      optiga_crypt_destroy(me); //CCW => Seems to be missing?
+      trustm_crypt_release(me);
     }
 
     return error;
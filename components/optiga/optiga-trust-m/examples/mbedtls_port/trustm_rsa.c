@@ -59,6 +59,8 @@
 #include "optiga/optiga_crypt.h"
 #include "optiga/optiga_util.h"
 #include "optiga/common/optiga_lib_common.h"
+#include "optiga_sync.h"
+#include "trustm_crypt.h"
 #include "optiga/pal/pal_os_memory.h"
 #include "optiga/pal/pal_os_timer.h"
 
@@ -75,6 +77,10 @@
 #define TRUSTM_RSA_PUBLIC_KEY_MAX_SIZE       (300)
 #define TRUSTM_RSA_SIGNATURE_LEN_MAX_SIZE    (300)
 #define TRUSTM_RSA_NEGATIVE_INTEGER          (0x7F)
+#ifndef TRUSTM_RSA_PRIORITY
+// Queue priority of private key operations: AES logger commands queued meanwhile go first
+#define TRUSTM_RSA_PRIORITY                  OPTIGA_CMD_PRIORITY_LOW
+#endif
 
 #ifndef CONFIG_OPTIGA_TRUST_M_PRIVKEY_SLOT
 #define CONFIG_OPTIGA_TRUST_M_PRIVKEY_SLOT 		(0xE0FC)
@@ -97,8 +103,6 @@
 #define TRUSTM_RSA_GET_LENGTH_FIELD_INBYTES(value) \
          ((value > 0xFF)? 0x02 : 0x01);
 
-static volatile optiga_lib_status_t crypt_event_completed_status;
-
 /* constant-time buffer comparison */
 static inline int mbedtls_safer_memcmp( const void *a, const void *b, size_t n )
 {
@@ -113,15 +117,6 @@ static inline int mbedtls_safer_memcmp( const void *a, const void *b, size_t n )
     return( diff );
 }
 
-static void optiga_crypt_event_completed(void * context, optiga_lib_status_t return_status)
-{
-    crypt_event_completed_status = return_status;
-    if (NULL != context)
-    {
-        // callback to upper layer here
-    }
-}
-
 static void mbedtls_rsa_create_public_key_bit_string_format(const uint8_t * n_buffer,
                                                             uint16_t n_length,
                                                             const uint8_t * e_buffer,
@@ -1387,6 +1382,7 @@ int mbedtls_rsa_rsaes_pkcs1_v15_encrypt( mbedtls_rsa_context *ctx,
 {
     optiga_lib_status_t crypt_sync_status = OPTIGA_CRYPT_ERROR;
     optiga_crypt_t * me_crypt = NULL;
+    optiga_sync_t * p_sync = NULL;
     int return_status = MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
     public_key_from_host_t public_key_from_host;
     uint8_t * bit_string_pb_key = NULL;
@@ -1404,13 +1400,6 @@ int mbedtls_rsa_rsaes_pkcs1_v15_encrypt( mbedtls_rsa_context *ctx,
     if( mode == MBEDTLS_RSA_PRIVATE && ctx->padding != MBEDTLS_RSA_PKCS_V15 )
         return( MBEDTLS_ERR_RSA_BAD_INPUT_DATA );
 
-    me_crypt = optiga_crypt_create(0, optiga_crypt_event_completed, NULL);
-    if (NULL == me_crypt)
-    {
-        return_status = MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
-        goto cleanup;
-    }
-
     modulus_length = ctx->len;
 
     bit_string_pb_key = pal_os_calloc(1,TRUSTM_RSA_PUBLIC_KEY_MAX_SIZE);
@@ -1453,7 +1442,13 @@ int mbedtls_rsa_rsaes_pkcs1_v15_encrypt( mbedtls_rsa_context *ctx,
 
     public_key_from_host.public_key = bit_string_pb_key;
 
-    crypt_event_completed_status = OPTIGA_LIB_BUSY;
+    me_crypt = trustm_crypt_acquire(&p_sync);
+    if (NULL == me_crypt)
+    {
+        return_status = MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
+        goto cleanup;
+    }
+    optiga_sync_begin(p_sync);
     crypt_sync_status = optiga_crypt_rsa_encrypt_message(me_crypt,
 															OPTIGA_RSAES_PKCS1_V15,
 															input,
@@ -1470,21 +1465,17 @@ int mbedtls_rsa_rsaes_pkcs1_v15_encrypt( mbedtls_rsa_context *ctx,
     }
 
     //Wait until optiga_crypt_rsa_sign is completed
-    while (OPTIGA_LIB_BUSY == crypt_event_completed_status)
-    {
-        //Wait until the optiga_crypt_rsa_sign operation is completed
-    	pal_os_timer_delay_in_milliseconds(5);
-    }
-    if (OPTIGA_LIB_SUCCESS != crypt_event_completed_status )
+    optiga_sync_wait(p_sync);
+    if (OPTIGA_LIB_SUCCESS != p_sync->status )
     {
         goto cleanup;
     }
     return_status = 0;
 cleanup:
-	// destroy crypt instances
+	// hand the crypt instance back to the pool
 	if (me_crypt != NULL)
 	{
-		(void)optiga_crypt_destroy(me_crypt);
+		trustm_crypt_release(me_crypt);
 	}
 	pal_os_free(modulus_buffer);
 	pal_os_free(bit_string_pb_key);
@@ -1688,6 +1679,7 @@ int mbedtls_rsa_rsaes_pkcs1_v15_decrypt( mbedtls_rsa_context *ctx,
 {
     optiga_lib_status_t crypt_sync_status = OPTIGA_CRYPT_ERROR;
     optiga_crypt_t * me_crypt = NULL;
+    optiga_sync_t * p_sync = NULL;
     int return_status = MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
 
     RSA_VALIDATE_RET( ctx != NULL );
@@ -1697,13 +1689,14 @@ int mbedtls_rsa_rsaes_pkcs1_v15_decrypt( mbedtls_rsa_context *ctx,
     RSA_VALIDATE_RET( input != NULL );
     RSA_VALIDATE_RET( olen != NULL );
 
-    me_crypt = optiga_crypt_create(0, optiga_crypt_event_completed, NULL);
+    me_crypt = trustm_crypt_acquire(&p_sync);
     if (NULL == me_crypt)
     {
         return_status = MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
         goto cleanup;
     }
-    crypt_event_completed_status = OPTIGA_LIB_BUSY;
+    OPTIGA_CRYPT_SET_PRIORITY(me_crypt, TRUSTM_RSA_PRIORITY);
+    optiga_sync_begin(p_sync);
     crypt_sync_status = optiga_crypt_rsa_decrypt_and_export(me_crypt,
                                                             OPTIGA_RSAES_PKCS1_V15,
                                                             input,
@@ -1719,21 +1712,18 @@ int mbedtls_rsa_rsaes_pkcs1_v15_decrypt( mbedtls_rsa_context *ctx,
     }
 
     //Wait until optiga_crypt_rsa_sign is completed
-    while (OPTIGA_LIB_BUSY == crypt_event_completed_status)
-    {
-        //Wait until the optiga_crypt_rsa_sign operation is completed
-    	pal_os_timer_delay_in_milliseconds(5);
-    }
-    if (crypt_event_completed_status != OPTIGA_LIB_SUCCESS )
+    optiga_sync_wait(p_sync);
+    if (p_sync->status != OPTIGA_LIB_SUCCESS )
     {
         goto cleanup;
     }
     return_status = 0;
 cleanup:
-    // destroy crypt instances
+    // hand the crypt instance back to the pool
     if (me_crypt != NULL)
     {
-        (void)optiga_crypt_destroy(me_crypt);
+        OPTIGA_CRYPT_SET_PRIORITY(me_crypt, OPTIGA_CMD_PRIORITY_NORMAL);
+        trustm_crypt_release(me_crypt);
     }
 
     return (return_status);
@@ -1924,6 +1914,7 @@ int mbedtls_rsa_rsassa_pkcs1_v15_sign( mbedtls_rsa_context *ctx,
     optiga_rsa_signature_scheme_t signature_scheme;
     optiga_lib_status_t crypt_sync_status = OPTIGA_CRYPT_ERROR;
     optiga_crypt_t * me_crypt = NULL;
+    optiga_sync_t * p_sync = NULL;
     uint8_t * signature_buffer = NULL;
     uint16_t  signature_len = 0;
     int return_status = MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
@@ -1939,14 +1930,6 @@ int mbedtls_rsa_rsassa_pkcs1_v15_sign( mbedtls_rsa_context *ctx,
     if(mode == MBEDTLS_RSA_PRIVATE && ctx->padding != MBEDTLS_RSA_PKCS_V15)
         return(MBEDTLS_ERR_RSA_BAD_INPUT_DATA);
 
-    // Create crypt instance
-    me_crypt = optiga_crypt_create(0, optiga_crypt_event_completed, NULL);
-    if (NULL == me_crypt)
-    {
-        return_status = MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
-        goto cleanup;
-    }
-
     // Mapping mbedTLS signature scheme to TRUSTM
     return_status = mbedtls_rsa_get_sig_scheme_digest_len(md_alg, &signature_scheme, &digest_length);
     if (0 != return_status)
@@ -1971,8 +1954,17 @@ int mbedtls_rsa_rsassa_pkcs1_v15_sign( mbedtls_rsa_context *ctx,
         goto cleanup;
     }
 
+    // Take a crypt instance only for the OPTIGA request, the host side work above runs without one
+    me_crypt = trustm_crypt_acquire(&p_sync);
+    if (NULL == me_crypt)
+    {
+        return_status = MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
+        goto cleanup;
+    }
+
     // Invoke optiga_crypt_rsa_sign
-    crypt_event_completed_status = OPTIGA_LIB_BUSY;
+    OPTIGA_CRYPT_SET_PRIORITY(me_crypt, TRUSTM_RSA_PRIORITY);
+    optiga_sync_begin(p_sync);
     crypt_sync_status = optiga_crypt_rsa_sign(me_crypt,
                                               signature_scheme,
                                               hash,
@@ -1989,12 +1981,8 @@ int mbedtls_rsa_rsassa_pkcs1_v15_sign( mbedtls_rsa_context *ctx,
     }
 
     //Wait until optiga_crypt_rsa_sign is completed
-    while (OPTIGA_LIB_BUSY == crypt_event_completed_status)
-    {
-        //Wait until the optiga_crypt_rsa_sign operation is completed
-    	pal_os_timer_delay_in_milliseconds(10);
-    }
-    if (crypt_event_completed_status != OPTIGA_LIB_SUCCESS )
+    optiga_sync_wait(p_sync);
+    if (p_sync->status != OPTIGA_LIB_SUCCESS )
     {
         return_status = MBEDTLS_ERR_RSA_VERIFY_FAILED;
         goto cleanup;
@@ -2012,10 +2000,11 @@ int mbedtls_rsa_rsassa_pkcs1_v15_sign( mbedtls_rsa_context *ctx,
 
 cleanup:
     pal_os_free(signature_buffer);
-    // destroy crypt instances
+    // hand the crypt instance back to the pool
     if (me_crypt != NULL)
     {
-        (void)optiga_crypt_destroy(me_crypt);
+        OPTIGA_CRYPT_SET_PRIORITY(me_crypt, OPTIGA_CMD_PRIORITY_NORMAL);
+        trustm_crypt_release(me_crypt);
     }
 
     return (return_status);
@@ -2265,6 +2254,7 @@ int mbedtls_rsa_rsassa_pkcs1_v15_verify( mbedtls_rsa_context *ctx,
     optiga_lib_status_t crypt_sync_status = OPTIGA_CRYPT_ERROR;
     public_key_from_host_t public_key;
     optiga_crypt_t * me_crypt = NULL;
+    optiga_sync_t * p_sync = NULL;
     uint8_t * bit_string_pb_key = NULL;
     uint8_t * modulus_buffer = NULL;
     uint8_t public_exponent_buffer[4] = {0x00};
@@ -2285,14 +2275,6 @@ int mbedtls_rsa_rsassa_pkcs1_v15_verify( mbedtls_rsa_context *ctx,
     if( mode == MBEDTLS_RSA_PRIVATE && ctx->padding != MBEDTLS_RSA_PKCS_V15 )
         return( MBEDTLS_ERR_RSA_BAD_INPUT_DATA );
 
-    // Create crypt instance
-    me_crypt = optiga_crypt_create(0, optiga_crypt_event_completed, NULL);
-    if (NULL == me_crypt)
-    {
-        return_status = MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
-        goto cleanup;
-    }
-
     // Mapping mbedTLS signature scheme to TRUSTM
     return_status = mbedtls_rsa_get_sig_scheme_digest_len(md_alg, &signature_scheme, &digest_length);
     if (0 != return_status)
@@ -2342,7 +2324,13 @@ int mbedtls_rsa_rsassa_pkcs1_v15_verify( mbedtls_rsa_context *ctx,
 
     public_key.public_key = bit_string_pb_key;
 
-    crypt_event_completed_status = OPTIGA_LIB_BUSY;
+    me_crypt = trustm_crypt_acquire(&p_sync);
+    if (NULL == me_crypt)
+    {
+        return_status = MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
+        goto cleanup;
+    }
+    optiga_sync_begin(p_sync);
     crypt_sync_status = optiga_crypt_rsa_verify(me_crypt,
                                                 signature_scheme,
                                                 hash,
@@ -2360,12 +2348,8 @@ int mbedtls_rsa_rsassa_pkcs1_v15_verify( mbedtls_rsa_context *ctx,
     }
 
     //Wait until optiga_crypt_rsa_verify is completed
-    while (OPTIGA_LIB_BUSY == crypt_event_completed_status)
-    {
-        //Wait until the optiga_crypt_rsa_verify operation is completed
-    	pal_os_timer_delay_in_milliseconds(10);
-    }
-    if (crypt_event_completed_status != OPTIGA_LIB_SUCCESS )
+    optiga_sync_wait(p_sync);
+    if (p_sync->status != OPTIGA_LIB_SUCCESS )
     {
         return_status = MBEDTLS_ERR_RSA_VERIFY_FAILED;
         goto cleanup;
@@ -2376,10 +2360,10 @@ cleanup:
 
     pal_os_free(modulus_buffer);
     pal_os_free(bit_string_pb_key);
-    // destroy crypt instances
+    // hand the crypt instance back to the pool
     if (me_crypt != NULL)
     {
-        (void)optiga_crypt_destroy(me_crypt);
+        trustm_crypt_release(me_crypt);
     }
 
     return (return_status);
@@ -0,0 +1,317 @@
+/**
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* @{
+*/
+
+#include "mbedtls/mbedtls_config.h"
+
+#if defined(MBEDTLS_SSL_ASYNC_PRIVATE) && defined(MBEDTLS_SSL_SRV_C)
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "mbedtls/ecp.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/platform.h"
+#include "mbedtls/platform_util.h"
+#include "mbedtls/ssl.h"
+#include "optiga_sync.h"
+#include "trustm_crypt.h"
+#include "trustm_ssl_async.h"
+
+#ifndef MBEDTLS_PRIVATE
+#define MBEDTLS_PRIVATE(member) member
+#endif
+
+/// Longest digest mbedtls signs in a ServerKeyExchange (SHA-512)
+#define TRUSTM_SSL_ASYNC_MAX_HASH_BYTES     (64U)
+/// RSA-2048: modulus, signature and encrypted premaster length
+#define TRUSTM_SSL_ASYNC_RSA_BYTES          (256U)
+
+#ifndef TRUSTM_SSL_ASYNC_RSA_PRIORITY
+/// Queue priority of RSA requests: lower than the logger's AES commands, which then run first
+#define TRUSTM_SSL_ASYNC_RSA_PRIORITY       OPTIGA_CMD_PRIORITY_LOW
+#endif
+
+typedef enum trustm_ssl_async_kind
+{
+    TRUSTM_SSL_ASYNC_ECDSA_SIGN = 0,
+    TRUSTM_SSL_ASYNC_RSA_SIGN,
+    TRUSTM_SSL_ASYNC_RSA_DECRYPT
+} trustm_ssl_async_kind_t;
+
+// One private key operation in flight. A handshake only holds one while it holds a pooled
+// crypt instance, so there are never more than TRUSTM_CRYPT_POOL_SIZE
+typedef struct trustm_ssl_async_op
+{
+    optiga_crypt_t * me;
+    optiga_sync_t * p_sync;
+    // OPTIGA reads the input when the command is sent, after the start callback returned
+    uint8_t in[TRUSTM_SSL_ASYNC_RSA_BYTES];
+    uint8_t out[TRUSTM_SSL_ASYNC_RSA_BYTES];
+    uint16_t out_len;
+    trustm_ssl_async_kind_t kind;
+    bool in_use;
+} trustm_ssl_async_op_t;
+
+static trustm_ssl_async_op_t trustm_ssl_async_ops[TRUSTM_CRYPT_POOL_SIZE];
+static trustm_ssl_async_stats_t trustm_ssl_async_counters;
+static portMUX_TYPE trustm_ssl_async_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void trustm_ssl_async_count(uint32_t * p_counter)
+{
+    portENTER_CRITICAL(&trustm_ssl_async_lock);
+    (*p_counter)++;
+    portEXIT_CRITICAL(&trustm_ssl_async_lock);
+}
+
+static trustm_ssl_async_op_t * trustm_ssl_async_claim(void)
+{
+    trustm_ssl_async_op_t * op = NULL;
+    size_t i;
+
+    portENTER_CRITICAL(&trustm_ssl_async_lock);
+    for (i = 0; (i < TRUSTM_CRYPT_POOL_SIZE) && (NULL == op); i++)
+    {
+        if (!trustm_ssl_async_ops[i].in_use)
+        {
+            op = &trustm_ssl_async_ops[i];
+            op->in_use = true;
+        }
+    }
+    portEXIT_CRITICAL(&trustm_ssl_async_lock);
+    return op;
+}
+
+// Hands the crypt instance back and frees the slot; the request must have completed
+static void trustm_ssl_async_finish(mbedtls_ssl_context * ssl, trustm_ssl_async_op_t * op)
+{
+    // The pooled instance is shared with the blocking ALT calls
+    OPTIGA_CRYPT_SET_PRIORITY(op->me, OPTIGA_CMD_PRIORITY_NORMAL);
+    trustm_crypt_release(op->me);
+    mbedtls_ssl_set_async_operation_data(ssl, NULL);
+    portENTER_CRITICAL(&trustm_ssl_async_lock);
+    op->in_use = false;
+    portEXIT_CRITICAL(&trustm_ssl_async_lock);
+}
+
+static optiga_key_id_t trustm_ssl_async_key(const mbedtls_ssl_context * ssl)
+{
+    return (optiga_key_id_t)(uintptr_t)mbedtls_ssl_conf_get_async_config_data(ssl->MBEDTLS_PRIVATE(conf));
+}
+
+// Takes an instance and starts the request of kind on it; input_len bytes of input are copied
+static int trustm_ssl_async_start(mbedtls_ssl_context * ssl, trustm_ssl_async_kind_t kind, uint8_t scheme,
+                                  const unsigned char * input, size_t input_len)
+{
+    const optiga_key_id_t key_id = trustm_ssl_async_key(ssl);
+    optiga_lib_status_t return_status = OPTIGA_CRYPT_ERROR;
+    trustm_ssl_async_op_t * op;
+    optiga_sync_t * p_sync = NULL;
+    optiga_crypt_t * me;
+
+    // Blocks only while every pooled instance is busy
+    me = trustm_crypt_acquire(&p_sync);
+    if (NULL == me)
+    {
+        trustm_ssl_async_count(&trustm_ssl_async_counters.errors);
+        return MBEDTLS_ERR_PLATFORM_HW_ACCEL_FAILED;
+    }
+    op = trustm_ssl_async_claim();
+    op->me = me;
+    op->p_sync = p_sync;
+    op->kind = kind;
+    op->out_len = sizeof(op->out);
+    memcpy(op->in, input, input_len);
+
+    optiga_sync_begin(p_sync);
+    switch (kind)
+    {
+        case TRUSTM_SSL_ASYNC_ECDSA_SIGN:
+            return_status = optiga_crypt_ecdsa_sign(me, op->in, (uint8_t)input_len, key_id, op->out, &op->out_len);
+            break;
+#ifdef OPTIGA_CRYPT_RSA_SIGN_ENABLED
+        case TRUSTM_SSL_ASYNC_RSA_SIGN:
+            OPTIGA_CRYPT_SET_PRIORITY(me, TRUSTM_SSL_ASYNC_RSA_PRIORITY);
+            return_status = optiga_crypt_rsa_sign(me, (optiga_rsa_signature_scheme_t)scheme, op->in,
+                                                  (uint8_t)input_len, key_id, op->out, &op->out_len, 0);
+            break;
+#endif
+#ifdef OPTIGA_CRYPT_RSA_DECRYPT_ENABLED
+        case TRUSTM_SSL_ASYNC_RSA_DECRYPT:
+            OPTIGA_CRYPT_SET_PRIORITY(me, TRUSTM_SSL_ASYNC_RSA_PRIORITY);
+            return_status = optiga_crypt_rsa_decrypt_and_export(me, OPTIGA_RSAES_PKCS1_V15, op->in,
+                                                                (uint16_t)input_len, NULL, 0, key_id,
+                                                                op->out, &op->out_len);
+            break;
+#endif
+        default:
+            break;
+    }
+    if (OPTIGA_LIB_SUCCESS != return_status)
+    {
+        trustm_ssl_async_finish(ssl, op);
+        trustm_ssl_async_count(&trustm_ssl_async_counters.errors);
+        return MBEDTLS_ERR_PLATFORM_HW_ACCEL_FAILED;
+    }
+    mbedtls_ssl_set_async_operation_data(ssl, op);
+    trustm_ssl_async_count(&trustm_ssl_async_counters.started);
+    return MBEDTLS_ERR_SSL_ASYNC_IN_PROGRESS;
+}
+
+static int trustm_ssl_async_sign_start(mbedtls_ssl_context * ssl, mbedtls_x509_crt * cert,
+                                       mbedtls_md_type_t md_alg, const unsigned char * hash,
+                                       size_t hash_len)
+{
+    const mbedtls_pk_type_t type = mbedtls_pk_get_type(&cert->pk);
+    uint8_t scheme = 0;
+
+    if ((MBEDTLS_PK_ECKEY == type) && (hash_len <= TRUSTM_SSL_ASYNC_MAX_HASH_BYTES))
+    {
+        return trustm_ssl_async_start(ssl, TRUSTM_SSL_ASYNC_ECDSA_SIGN, 0, hash, hash_len);
+    }
+#ifdef OPTIGA_CRYPT_RSA_SIGN_ENABLED
+    // TLS 1.2 PKCS#1 v1.5 with a digest OPTIGA knows; MD5+SHA1 of older versions stays in mbedtls
+    scheme = (MBEDTLS_MD_SHA256 == md_alg) ? OPTIGA_RSASSA_PKCS1_V15_SHA256 :
+             (MBEDTLS_MD_SHA384 == md_alg) ? OPTIGA_RSASSA_PKCS1_V15_SHA384 :
+             (MBEDTLS_MD_SHA512 == md_alg) ? OPTIGA_RSASSA_PKCS1_V15_SHA512 : 0;
+    if ((MBEDTLS_PK_RSA == type) && (0 != scheme) &&
+        (TRUSTM_SSL_ASYNC_RSA_BYTES == mbedtls_pk_get_len(&cert->pk)))
+    {
+        return trustm_ssl_async_start(ssl, TRUSTM_SSL_ASYNC_RSA_SIGN, scheme, hash, hash_len);
+    }
+#endif
+    (void)md_alg;
+    (void)scheme;
+    trustm_ssl_async_count(&trustm_ssl_async_counters.fallthrough);
+    return MBEDTLS_ERR_SSL_HW_ACCEL_FALLTHROUGH;
+}
+
+#ifdef OPTIGA_CRYPT_RSA_DECRYPT_ENABLED
+// RSA key exchange: the encrypted premaster of the ClientKeyExchange
+static int trustm_ssl_async_decrypt_start(mbedtls_ssl_context * ssl, mbedtls_x509_crt * cert,
+                                          const unsigned char * input, size_t input_len)
+{
+    if ((MBEDTLS_PK_RSA == mbedtls_pk_get_type(&cert->pk)) && (TRUSTM_SSL_ASYNC_RSA_BYTES == input_len) &&
+        (TRUSTM_SSL_ASYNC_RSA_BYTES == mbedtls_pk_get_len(&cert->pk)))
+    {
+        return trustm_ssl_async_start(ssl, TRUSTM_SSL_ASYNC_RSA_DECRYPT, 0, input, input_len);
+    }
+    trustm_ssl_async_count(&trustm_ssl_async_counters.fallthrough);
+    return MBEDTLS_ERR_SSL_HW_ACCEL_FALLTHROUGH;
+}
+#endif
+
+// mbedtls wants an ECDSA signature as from mbedtls_pk_sign(): a DER SEQUENCE around the two
+// INTEGERs OPTIGA returns. RSA signatures and the decrypted premaster are passed as they are
+static int trustm_ssl_async_resume(mbedtls_ssl_context * ssl, unsigned char * output,
+                                   size_t * output_len, size_t output_size)
+{
+    trustm_ssl_async_op_t * op = (trustm_ssl_async_op_t *)mbedtls_ssl_get_async_operation_data(ssl);
+    const bool ecdsa = (TRUSTM_SSL_ASYNC_ECDSA_SIGN == op->kind);
+    const size_t header = !ecdsa ? 0 : (op->out_len < 0x80) ? 2 : 3;
+    int return_status = 0;
+
+    if (OPTIGA_LIB_BUSY == op->p_sync->status)
+    {
+        trustm_ssl_async_count(&trustm_ssl_async_counters.in_progress);
+        return MBEDTLS_ERR_SSL_ASYNC_IN_PROGRESS;
+    }
+    if (OPTIGA_LIB_SUCCESS != op->p_sync->status)
+    {
+        return_status = MBEDTLS_ERR_PLATFORM_HW_ACCEL_FAILED;
+    }
+    else if (header + op->out_len > output_size)
+    {
+        return_status = MBEDTLS_ERR_ECP_BUFFER_TOO_SMALL;
+    }
+    else
+    {
+        if (ecdsa)
+        {
+            output[0] = 0x30;
+            if (3 == header)
+            {
+                output[1] = 0x81;
+            }
+            output[header - 1] = (uint8_t)op->out_len;
+        }
+        memcpy(&output[header], op->out, op->out_len);
+        *output_len = header + op->out_len;
+    }
+    // The premaster is a secret, do not leave it in the pool
+    mbedtls_platform_zeroize(op->out, sizeof(op->out));
+    trustm_ssl_async_finish(ssl, op);
+    trustm_ssl_async_count((0 == return_status) ? &trustm_ssl_async_counters.completed :
+                                                  &trustm_ssl_async_counters.errors);
+    return return_status;
+}
+
+// OPTIGA cannot abort a command it has received, so the instance is only handed back once
+// the operation is done
+static void trustm_ssl_async_cancel(mbedtls_ssl_context * ssl)
+{
+    trustm_ssl_async_op_t * op = (trustm_ssl_async_op_t *)mbedtls_ssl_get_async_operation_data(ssl);
+
+    (void)optiga_sync_wait(op->p_sync);
+    mbedtls_platform_zeroize(op->out, sizeof(op->out));
+    trustm_ssl_async_finish(ssl, op);
+    trustm_ssl_async_count(&trustm_ssl_async_counters.cancelled);
+}
+
+void trustm_ssl_async_setup(mbedtls_ssl_config * conf, optiga_key_id_t key_id)
+{
+    mbedtls_ssl_conf_async_private_cb(conf, trustm_ssl_async_sign_start,
+#ifdef OPTIGA_CRYPT_RSA_DECRYPT_ENABLED
+                                      trustm_ssl_async_decrypt_start,
+#else
+                                      NULL,
+#endif
+                                      trustm_ssl_async_resume, trustm_ssl_async_cancel,
+                                      (void *)(uintptr_t)key_id);
+}
+
+int trustm_ssl_async_wait(mbedtls_ssl_context * ssl, uint32_t timeout_ms)
+{
+    trustm_ssl_async_op_t * op = (trustm_ssl_async_op_t *)mbedtls_ssl_get_async_operation_data(ssl);
+
+    if ((NULL == op) || (OPTIGA_LIB_BUSY != optiga_sync_wait_timeout(op->p_sync, timeout_ms)))
+    {
+        return 0;
+    }
+    return MBEDTLS_ERR_SSL_ASYNC_IN_PROGRESS;
+}
+
+void trustm_ssl_async_get_stats(trustm_ssl_async_stats_t * p_stats)
+{
+    portENTER_CRITICAL(&trustm_ssl_async_lock);
+    *p_stats = trustm_ssl_async_counters;
+    portEXIT_CRITICAL(&trustm_ssl_async_lock);
+}
+
+#endif
+/**
+ * @}
+ */
@@ -0,0 +1,244 @@
+/**
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* @{
+*/
+
+#include "mbedtls/mbedtls_config.h"
+
+#if defined(MBEDTLS_SSL_CLI_C)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "esp_rom_crc.h"
+#include "trustm_tls_session.h"
+
+// One blob per server (serialized session followed by its CRC32), keyed by the CRC32 of the
+// host name since NVS keys are limited to 15 characters. A blob failing the CRC reads as missing.
+#define TRUSTM_TLS_SESSION_NVS_NAMESPACE    "trustm_tls"
+#define TRUSTM_TLS_SESSION_CRC_SIZE         (4U)
+#define TRUSTM_TLS_SESSION_KEY_SIZE         (16U)
+#define TRUSTM_TLS_SESSION_BLOB_SIZE        (TRUSTM_TLS_SESSION_MAX_BYTES + TRUSTM_TLS_SESSION_CRC_SIZE)
+
+static trustm_tls_session_stats_t trustm_tls_session_counters;
+static portMUX_TYPE trustm_tls_session_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void trustm_tls_session_count(uint32_t * p_counter)
+{
+    portENTER_CRITICAL(&trustm_tls_session_lock);
+    (*p_counter)++;
+    portEXIT_CRITICAL(&trustm_tls_session_lock);
+}
+
+static void trustm_tls_session_key(const char * host, char * key)
+{
+    (void)snprintf(key, TRUSTM_TLS_SESSION_KEY_SIZE, "s%08lx",
+                   (unsigned long)esp_rom_crc32_le(0, (const uint8_t *)host, strlen(host)));
+}
+
+static int trustm_tls_session_open(nvs_handle_t * p_handle)
+{
+    static bool nvs_ready = false;
+
+    if (!nvs_ready)
+    {
+        // Already initialised by the application is fine; a full or outdated partition is
+        // left to the application to erase
+        if (ESP_OK != nvs_flash_init())
+        {
+            return TRUSTM_TLS_SESSION_ERR_STORAGE;
+        }
+        nvs_ready = true;
+    }
+    return (ESP_OK == nvs_open(TRUSTM_TLS_SESSION_NVS_NAMESPACE, NVS_READWRITE, p_handle)) ?
+           0 : TRUSTM_TLS_SESSION_ERR_STORAGE;
+}
+
+// Reads the session stored under key into blob, returns its length or 0 if missing or corrupted
+static size_t trustm_tls_session_read(nvs_handle_t handle, const char * key, uint8_t * blob)
+{
+    size_t blob_length = TRUSTM_TLS_SESSION_BLOB_SIZE;
+    size_t data_length;
+    uint32_t crc;
+
+    if ((ESP_OK != nvs_get_blob(handle, key, blob, &blob_length)) ||
+        (blob_length <= TRUSTM_TLS_SESSION_CRC_SIZE))
+    {
+        return 0;
+    }
+    data_length = blob_length - TRUSTM_TLS_SESSION_CRC_SIZE;
+    crc = (uint32_t)blob[data_length] | ((uint32_t)blob[data_length + 1] << 8) |
+          ((uint32_t)blob[data_length + 2] << 16) | ((uint32_t)blob[data_length + 3] << 24);
+    return (crc == esp_rom_crc32_le(0, blob, data_length)) ? data_length : 0;
+}
+
+int trustm_tls_session_restore(mbedtls_ssl_context * ssl, const char * host)
+{
+    char key[TRUSTM_TLS_SESSION_KEY_SIZE];
+    nvs_handle_t handle;
+    mbedtls_ssl_session session;
+    uint8_t * blob;
+    size_t length = 0;
+    int ret;
+
+    blob = calloc(1, TRUSTM_TLS_SESSION_BLOB_SIZE);
+    if (NULL == blob)
+    {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+    trustm_tls_session_key(host, key);
+    ret = trustm_tls_session_open(&handle);
+    if (0 == ret)
+    {
+        length = trustm_tls_session_read(handle, key, blob);
+        nvs_close(handle);
+    }
+
+    mbedtls_ssl_session_init(&session);
+    if (0 == length)
+    {
+        ret = TRUSTM_TLS_SESSION_ERR_NOT_FOUND;
+    }
+    else
+    {
+        // A blob from an older mbedtls build fails to load and is treated as a miss
+        ret = mbedtls_ssl_session_load(&session, blob, length);
+        if (0 == ret)
+        {
+            ret = mbedtls_ssl_set_session(ssl, &session);
+        }
+    }
+    mbedtls_ssl_session_free(&session);
+    // The blob holds the master secret
+    memset(blob, 0, TRUSTM_TLS_SESSION_BLOB_SIZE);
+    free(blob);
+
+    trustm_tls_session_count((0 == ret) ? &trustm_tls_session_counters.restored :
+                                          &trustm_tls_session_counters.misses);
+    return ret;
+}
+
+int trustm_tls_session_save(const mbedtls_ssl_context * ssl, const char * host)
+{
+    char key[TRUSTM_TLS_SESSION_KEY_SIZE];
+    nvs_handle_t handle;
+    mbedtls_ssl_session session;
+    uint8_t * blob;
+    uint8_t * stored;
+    size_t length = 0;
+    uint32_t crc;
+    int ret;
+
+    blob = calloc(2, TRUSTM_TLS_SESSION_BLOB_SIZE);
+    if (NULL == blob)
+    {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+    stored = blob + TRUSTM_TLS_SESSION_BLOB_SIZE;
+
+    mbedtls_ssl_session_init(&session);
+    do
+    {
+        ret = mbedtls_ssl_get_session(ssl, &session);
+        if (0 != ret)
+        {
+            break;
+        }
+        ret = mbedtls_ssl_session_save(&session, blob, TRUSTM_TLS_SESSION_MAX_BYTES, &length);
+        if (0 != ret)
+        {
+            break;
+        }
+        crc = esp_rom_crc32_le(0, blob, length);
+        blob[length] = (uint8_t)crc;
+        blob[length + 1] = (uint8_t)(crc >> 8);
+        blob[length + 2] = (uint8_t)(crc >> 16);
+        blob[length + 3] = (uint8_t)(crc >> 24);
+
+        trustm_tls_session_key(host, key);
+        ret = trustm_tls_session_open(&handle);
+        if (0 != ret)
+        {
+            break;
+        }
+        // A resumed handshake usually keeps its session, leave the flash alone then
+        if ((length == trustm_tls_session_read(handle, key, stored)) &&
+            (0 == memcmp(blob, stored, length)))
+        {
+            nvs_close(handle);
+            trustm_tls_session_count(&trustm_tls_session_counters.unchanged);
+            break;
+        }
+        if ((ESP_OK != nvs_set_blob(handle, key, blob, length + TRUSTM_TLS_SESSION_CRC_SIZE)) ||
+            (ESP_OK != nvs_commit(handle)))
+        {
+            ret = TRUSTM_TLS_SESSION_ERR_STORAGE;
+        }
+        nvs_close(handle);
+        if (0 == ret)
+        {
+            trustm_tls_session_count(&trustm_tls_session_counters.saved);
+        }
+    } while (0);
+    mbedtls_ssl_session_free(&session);
+
+    if (0 != ret)
+    {
+        trustm_tls_session_count(&trustm_tls_session_counters.errors);
+    }
+    memset(blob, 0, 2U * TRUSTM_TLS_SESSION_BLOB_SIZE);
+    free(blob);
+    return ret;
+}
+
+void trustm_tls_session_forget(const char * host)
+{
+    char key[TRUSTM_TLS_SESSION_KEY_SIZE];
+    nvs_handle_t handle;
+
+    trustm_tls_session_key(host, key);
+    if (0 == trustm_tls_session_open(&handle))
+    {
+        if (ESP_OK == nvs_erase_key(handle, key))
+        {
+            (void)nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+}
+
+void trustm_tls_session_get_stats(trustm_tls_session_stats_t * p_stats)
+{
+    portENTER_CRITICAL(&trustm_tls_session_lock);
+    *p_stats = trustm_tls_session_counters;
+    portEXIT_CRITICAL(&trustm_tls_session_lock);
+}
+
+#endif
+/**
+ * @}
+ */
@@ -0,0 +1,379 @@
+/**
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* @{
+*/
+
+#include "mbedtls/mbedtls_config.h"
+
+#if defined(MBEDTLS_SSL_CLI_C) && defined(MBEDTLS_X509_CRT_PARSE_C)
+
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "mbedtls/sha256.h"
+#include "optiga_trust.h"
+#include "trustm_x509_cache.h"
+
+/// Certificates per cached chain, trust anchor included; longer chains are verified every time
+#define TRUSTM_X509_CACHE_CHAIN_DEPTH       (4U)
+#define TRUSTM_X509_CACHE_HASH_SIZE         (32U)
+
+typedef struct trustm_x509_cache_entry
+{
+    /// SHA-256 over the certificate hashes of the received chain and the host name
+    uint8_t key[TRUSTM_X509_CACHE_HASH_SIZE];
+    /// SHA-256 of each certificate, for trustm_x509_cache_revoke()
+    uint8_t certs[TRUSTM_X509_CACHE_CHAIN_DEPTH][TRUSTM_X509_CACHE_HASH_SIZE];
+    uint8_t cert_count;
+    bool used;
+    /// Earliest end of validity of chain and anchor
+    time_t not_after;
+    /// Verification time (esp_timer) [us]
+    int64_t verified_us;
+    /// Order of last use, the lowest is replaced
+    uint32_t last_used;
+} trustm_x509_cache_entry_t;
+
+static trustm_x509_cache_entry_t trustm_x509_cache_entries[TRUSTM_X509_CACHE_ENTRIES];
+static uint32_t trustm_x509_cache_uses;
+static trustm_x509_cache_revoked_t trustm_x509_cache_hook;
+static void * trustm_x509_cache_hook_ctx;
+static trustm_x509_cache_stats_t trustm_x509_cache_counters;
+static portMUX_TYPE trustm_x509_cache_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void trustm_x509_cache_count(uint32_t * p_counter)
+{
+    portENTER_CRITICAL(&trustm_x509_cache_lock);
+    (*p_counter)++;
+    portEXIT_CRITICAL(&trustm_x509_cache_lock);
+}
+
+static int trustm_x509_cache_sha256(const uint8_t * p_data, size_t length, uint8_t * p_hash)
+{
+    mbedtls_sha256_context ctx;
+    int ret;
+
+    mbedtls_sha256_init(&ctx);
+    ret = mbedtls_sha256_starts(&ctx, 0);
+    if (0 == ret)
+    {
+        ret = mbedtls_sha256_update(&ctx, p_data, length);
+    }
+    if (0 == ret)
+    {
+        ret = mbedtls_sha256_finish(&ctx, p_hash);
+    }
+    mbedtls_sha256_free(&ctx);
+    return ret;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date, so no time zone or libc table is involved
+static int64_t trustm_x509_cache_days(int year, int mon, int day)
+{
+    const int y = year - ((mon <= 2) ? 1 : 0);
+    const int era = ((y >= 0) ? y : (y - 399)) / 400;
+    const int yoe = y - era * 400;
+    const int doy = (153 * (mon + ((mon > 2) ? -3 : 9)) + 2) / 5 + day - 1;
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return (int64_t)era * 146097 + doe - 719468;
+}
+
+static time_t trustm_x509_cache_time(const mbedtls_x509_time * p_time)
+{
+    return (time_t)(trustm_x509_cache_days(p_time->year, p_time->mon, p_time->day) * 86400 +
+                    p_time->hour * 3600 + p_time->min * 60 + p_time->sec);
+}
+
+// Hashes each certificate of the chain and the key over them and host; false if the chain is too long
+static bool trustm_x509_cache_key(const mbedtls_x509_crt * p_chain, const char * host,
+                                  trustm_x509_cache_entry_t * p_entry)
+{
+    mbedtls_sha256_context ctx;
+    const mbedtls_x509_crt * p_crt;
+    uint8_t i;
+    int ret;
+
+    p_entry->cert_count = 0;
+    for (p_crt = p_chain; (NULL != p_crt) && (0 != p_crt->raw.len); p_crt = p_crt->next)
+    {
+        // Keep a slot for the trust anchor
+        if ((p_entry->cert_count + 1U) >= TRUSTM_X509_CACHE_CHAIN_DEPTH)
+        {
+            return false;
+        }
+        if (0 != trustm_x509_cache_sha256(p_crt->raw.p, p_crt->raw.len, p_entry->certs[p_entry->cert_count]))
+        {
+            return false;
+        }
+        p_entry->cert_count++;
+    }
+
+    mbedtls_sha256_init(&ctx);
+    ret = mbedtls_sha256_starts(&ctx, 0);
+    for (i = 0; (0 == ret) && (i < p_entry->cert_count); i++)
+    {
+        ret = mbedtls_sha256_update(&ctx, p_entry->certs[i], TRUSTM_X509_CACHE_HASH_SIZE);
+    }
+    if (0 == ret)
+    {
+        ret = mbedtls_sha256_update(&ctx, (const uint8_t *)host, strlen(host));
+    }
+    if (0 == ret)
+    {
+        ret = mbedtls_sha256_finish(&ctx, p_entry->key);
+    }
+    mbedtls_sha256_free(&ctx);
+    return (0 == ret) && (0 != p_entry->cert_count);
+}
+
+// Looks the key up; drops an entry that expired. Returns true on a usable entry
+static bool trustm_x509_cache_lookup(const uint8_t * p_key)
+{
+    const int64_t now_us = esp_timer_get_time();
+    const time_t now = time(NULL);
+    trustm_x509_cache_entry_t * p_entry;
+    bool expired = false;
+    bool hit = false;
+    size_t i;
+
+    portENTER_CRITICAL(&trustm_x509_cache_lock);
+    for (i = 0; i < TRUSTM_X509_CACHE_ENTRIES; i++)
+    {
+        p_entry = &trustm_x509_cache_entries[i];
+        if (!p_entry->used || (0 != memcmp(p_entry->key, p_key, TRUSTM_X509_CACHE_HASH_SIZE)))
+        {
+            continue;
+        }
+        if ((now >= p_entry->not_after) ||
+            ((now_us - p_entry->verified_us) >= ((int64_t)TRUSTM_X509_CACHE_MAX_AGE_S * 1000000)))
+        {
+            p_entry->used = false;
+            expired = true;
+        }
+        else
+        {
+            p_entry->last_used = ++trustm_x509_cache_uses;
+            hit = true;
+        }
+        break;
+    }
+    if (expired)
+    {
+        trustm_x509_cache_counters.expired++;
+    }
+    portEXIT_CRITICAL(&trustm_x509_cache_lock);
+    return hit;
+}
+
+static void trustm_x509_cache_insert(const trustm_x509_cache_entry_t * p_new)
+{
+    trustm_x509_cache_entry_t * p_slot = &trustm_x509_cache_entries[0];
+    size_t i;
+
+    portENTER_CRITICAL(&trustm_x509_cache_lock);
+    for (i = 0; i < TRUSTM_X509_CACHE_ENTRIES; i++)
+    {
+        if (!trustm_x509_cache_entries[i].used)
+        {
+            p_slot = &trustm_x509_cache_entries[i];
+            break;
+        }
+        if (trustm_x509_cache_entries[i].last_used < p_slot->last_used)
+        {
+            p_slot = &trustm_x509_cache_entries[i];
+        }
+    }
+    *p_slot = *p_new;
+    p_slot->used = true;
+    p_slot->last_used = ++trustm_x509_cache_uses;
+    portEXIT_CRITICAL(&trustm_x509_cache_lock);
+}
+
+static void trustm_x509_cache_drop(const uint8_t * p_key)
+{
+    size_t i;
+
+    portENTER_CRITICAL(&trustm_x509_cache_lock);
+    for (i = 0; i < TRUSTM_X509_CACHE_ENTRIES; i++)
+    {
+        if (0 == memcmp(trustm_x509_cache_entries[i].key, p_key, TRUSTM_X509_CACHE_HASH_SIZE))
+        {
+            trustm_x509_cache_entries[i].used = false;
+        }
+    }
+    portEXIT_CRITICAL(&trustm_x509_cache_lock);
+}
+
+static int trustm_x509_cache_revoked(const mbedtls_x509_crt * p_chain)
+{
+    trustm_x509_cache_revoked_t hook;
+    void * p_ctx;
+
+    portENTER_CRITICAL(&trustm_x509_cache_lock);
+    hook = trustm_x509_cache_hook;
+    p_ctx = trustm_x509_cache_hook_ctx;
+    portEXIT_CRITICAL(&trustm_x509_cache_lock);
+    return (NULL != hook) ? hook(p_ctx, p_chain) : 0;
+}
+
+void trustm_x509_cache_setup(mbedtls_ssl_config * conf)
+{
+    mbedtls_ssl_conf_authmode(conf, MBEDTLS_SSL_VERIFY_NONE);
+}
+
+int trustm_x509_cache_verify(const mbedtls_ssl_context * ssl, const char * host, uint16_t anchor_oid,
+                             uint32_t * p_flags)
+{
+    const mbedtls_x509_crt * p_chain = mbedtls_ssl_get_peer_cert(ssl);
+    const mbedtls_x509_crt * p_crt;
+    trustm_x509_cache_entry_t entry;
+    mbedtls_x509_crt anchor;
+    bool cacheable;
+    int ret;
+
+    *p_flags = 0;
+    if (NULL == p_chain)
+    {
+        *p_flags = MBEDTLS_X509_BADCERT_MISSING;
+        trustm_x509_cache_count(&trustm_x509_cache_counters.failed);
+        return MBEDTLS_ERR_X509_CERT_VERIFY_FAILED;
+    }
+
+    memset(&entry, 0, sizeof(entry));
+    cacheable = trustm_x509_cache_key(p_chain, host, &entry);
+    if (cacheable && trustm_x509_cache_lookup(entry.key))
+    {
+        if (0 != trustm_x509_cache_revoked(p_chain))
+        {
+            trustm_x509_cache_drop(entry.key);
+            trustm_x509_cache_count(&trustm_x509_cache_counters.revoked);
+            *p_flags = MBEDTLS_X509_BADCERT_REVOKED;
+            return MBEDTLS_ERR_X509_CERT_VERIFY_FAILED;
+        }
+        trustm_x509_cache_count(&trustm_x509_cache_counters.hits);
+        return 0;
+    }
+
+    // Miss: the full verification mbedtls would have run during the handshake
+    mbedtls_x509_crt_init(&anchor);
+    if (OPTIGA_LIB_SUCCESS != optiga_trust_parse_certificate(anchor_oid, &anchor))
+    {
+        mbedtls_x509_crt_free(&anchor);
+        trustm_x509_cache_count(&trustm_x509_cache_counters.failed);
+        return TRUSTM_X509_CACHE_ERR_ANCHOR;
+    }
+    ret = mbedtls_x509_crt_verify((mbedtls_x509_crt *)p_chain, &anchor, NULL, host, p_flags, NULL, NULL);
+    if ((0 == ret) && (0 != trustm_x509_cache_revoked(p_chain)))
+    {
+        *p_flags = MBEDTLS_X509_BADCERT_REVOKED;
+        ret = MBEDTLS_ERR_X509_CERT_VERIFY_FAILED;
+        trustm_x509_cache_count(&trustm_x509_cache_counters.revoked);
+    }
+    else if (0 != ret)
+    {
+        trustm_x509_cache_count(&trustm_x509_cache_counters.failed);
+    }
+    else
+    {
+        trustm_x509_cache_count(&trustm_x509_cache_counters.verified);
+        if (cacheable && (0 == trustm_x509_cache_sha256(anchor.raw.p, anchor.raw.len,
+                                                        entry.certs[entry.cert_count])))
+        {
+            entry.cert_count++;
+            entry.not_after = trustm_x509_cache_time(&anchor.valid_to);
+            for (p_crt = p_chain; (NULL != p_crt) && (0 != p_crt->raw.len); p_crt = p_crt->next)
+            {
+                if (trustm_x509_cache_time(&p_crt->valid_to) < entry.not_after)
+                {
+                    entry.not_after = trustm_x509_cache_time(&p_crt->valid_to);
+                }
+            }
+            entry.verified_us = esp_timer_get_time();
+            trustm_x509_cache_insert(&entry);
+        }
+    }
+    mbedtls_x509_crt_free(&anchor);
+    return ret;
+}
+
+void trustm_x509_cache_set_revocation_hook(trustm_x509_cache_revoked_t hook, void * p_ctx)
+{
+    portENTER_CRITICAL(&trustm_x509_cache_lock);
+    trustm_x509_cache_hook = hook;
+    trustm_x509_cache_hook_ctx = p_ctx;
+    portEXIT_CRITICAL(&trustm_x509_cache_lock);
+}
+
+void trustm_x509_cache_revoke(const mbedtls_x509_crt * p_crt)
+{
+    uint8_t hash[TRUSTM_X509_CACHE_HASH_SIZE];
+    trustm_x509_cache_entry_t * p_entry;
+    uint32_t dropped = 0;
+    size_t i;
+    uint8_t j;
+
+    if (0 != trustm_x509_cache_sha256(p_crt->raw.p, p_crt->raw.len, hash))
+    {
+        // Cannot tell which chains contain it
+        trustm_x509_cache_flush();
+        return;
+    }
+    portENTER_CRITICAL(&trustm_x509_cache_lock);
+    for (i = 0; i < TRUSTM_X509_CACHE_ENTRIES; i++)
+    {
+        p_entry = &trustm_x509_cache_entries[i];
+        for (j = 0; p_entry->used && (j < p_entry->cert_count); j++)
+        {
+            if (0 == memcmp(p_entry->certs[j], hash, TRUSTM_X509_CACHE_HASH_SIZE))
+            {
+                p_entry->used = false;
+                dropped++;
+            }
+        }
+    }
+    trustm_x509_cache_counters.revoked += dropped;
+    portEXIT_CRITICAL(&trustm_x509_cache_lock);
+}
+
+void trustm_x509_cache_flush(void)
+{
+    portENTER_CRITICAL(&trustm_x509_cache_lock);
+    memset(trustm_x509_cache_entries, 0, sizeof(trustm_x509_cache_entries));
+    portEXIT_CRITICAL(&trustm_x509_cache_lock);
+}
+
+void trustm_x509_cache_get_stats(trustm_x509_cache_stats_t * p_stats)
+{
+    portENTER_CRITICAL(&trustm_x509_cache_lock);
+    *p_stats = trustm_x509_cache_counters;
+    portEXIT_CRITICAL(&trustm_x509_cache_lock);
+}
+
+#endif
+/**
+* @}
+*/
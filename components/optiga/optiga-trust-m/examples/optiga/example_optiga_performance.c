@@ -0,0 +1,328 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2020 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file example_optiga_performance.c
+*
+* \brief   This file runs the crypt/util examples in a loop and reports their timings.
+*
+* \details Each example measures its OPTIGA operations with START_PERFORMANCE_MEASUREMENT() and
+*          READ_PERFORMANCE_MEASUREMENT(). While the report runs, every measurement is also added
+*          in microseconds to the timings of the running example. A run that fails takes no
+*          measurement and shows up as runs - ok. The report is printed twice, as a Markdown table
+*          and as CSV. Each CSV row carries the library config, the I2C speed and the current
+*          limit, so rows of different builds can be concatenated and compared.
+*
+*          Examples that change one-way state on OPTIGA (pairing, monotonic counters, protected
+*          update) or overwrite a key in use (the AES key in 0xE200) are left out, as are init,
+*          deinit and hibernate.
+*
+* \ingroup grOptigaExamples
+*
+* @{
+*/
+
+#include <stdio.h>
+#include "optiga_example.h"
+#include "optiga/optiga_util.h"
+#include "optiga/ifx_i2c/ifx_i2c_config.h"
+#include "optiga/pal/pal_os_memory.h"
+
+#ifndef OPTIGA_INIT_DEINIT_DONE_EXCLUSIVELY
+extern void example_optiga_init(void);
+extern void example_optiga_deinit(void);
+#endif
+
+extern void example_optiga_util_read_data(void);
+extern void example_optiga_util_write_data(void);
+extern void example_read_coprocessor_id(void);
+extern void example_optiga_crypt_hash(void);
+extern void example_optiga_crypt_hash_data(void);
+extern void example_optiga_crypt_tls_prf_sha256(void);
+extern void example_optiga_crypt_random(void);
+extern void example_optiga_crypt_ecc_generate_keypair(void);
+extern void example_optiga_crypt_ecdsa_sign(void);
+extern void example_optiga_crypt_ecdsa_verify(void);
+extern void example_optiga_crypt_ecdh(void);
+extern void example_optiga_crypt_rsa_generate_keypair(void);
+extern void example_optiga_crypt_rsa_sign(void);
+extern void example_optiga_crypt_rsa_verify(void);
+extern void example_optiga_crypt_rsa_encrypt_message(void);
+extern void example_optiga_crypt_rsa_encrypt_session(void);
+extern void example_optiga_crypt_rsa_decrypt_and_store(void);
+extern void example_optiga_crypt_rsa_decrypt_and_export(void);
+extern void example_optiga_crypt_symmetric_encrypt_decrypt_ecb(void);
+extern void example_optiga_crypt_symmetric_encrypt_decrypt_cbc(void);
+extern void example_optiga_crypt_symmetric_encrypt_cbcmac(void);
+extern void example_optiga_crypt_hmac(void);
+extern void example_optiga_crypt_hkdf(void);
+extern void example_optiga_hmac_verify_with_authorization_reference(void);
+extern void example_optiga_crypt_clear_auto_state(void);
+
+/** @brief Library config named in the report; set it to tell builds with an external config apart */
+#ifndef OPTIGA_EXAMPLE_PERFORMANCE_CONFIG
+    #if defined (OPTIGA_TRUST_M_V1)
+        #define OPTIGA_EXAMPLE_PERFORMANCE_CONFIG   "m_v1"
+    #elif defined (OPTIGA_LIB_EXTERNAL)
+        #define OPTIGA_EXAMPLE_PERFORMANCE_CONFIG   "external"
+    #else
+        #define OPTIGA_EXAMPLE_PERFORMANCE_CONFIG   "m_v3"
+    #endif
+#endif
+
+/// Current limitation data object (6..15 mA)
+#define OPTIGA_EXAMPLE_PERFORMANCE_CURRENT_OID      (0xE0C4)
+
+/// @cond hidden
+typedef struct optiga_example_performance_case
+{
+    const char * name;
+    void (*run)(void);
+} optiga_example_performance_case_t;
+
+static const optiga_example_performance_case_t performance_cases[] =
+{
+    {"util_read_data",              example_optiga_util_read_data},
+    {"util_write_data",             example_optiga_util_write_data},
+    {"read_coprocessor_id",         example_read_coprocessor_id},
+#ifdef OPTIGA_CRYPT_HASH_ENABLED
+    {"crypt_hash",                  example_optiga_crypt_hash},
+    {"crypt_hash_data",             example_optiga_crypt_hash_data},
+#endif
+#ifdef OPTIGA_CRYPT_TLS_PRF_SHA256_ENABLED
+    {"crypt_tls_prf_sha256",        example_optiga_crypt_tls_prf_sha256},
+#endif
+#ifdef OPTIGA_CRYPT_RANDOM_ENABLED
+    {"crypt_random",                example_optiga_crypt_random},
+#endif
+#ifdef OPTIGA_CRYPT_ECC_GENERATE_KEYPAIR_ENABLED
+    {"crypt_ecc_generate_keypair",  example_optiga_crypt_ecc_generate_keypair},
+#endif
+#ifdef OPTIGA_CRYPT_ECDSA_SIGN_ENABLED
+    {"crypt_ecdsa_sign",            example_optiga_crypt_ecdsa_sign},
+#endif
+#ifdef OPTIGA_CRYPT_ECDSA_VERIFY_ENABLED
+    {"crypt_ecdsa_verify",          example_optiga_crypt_ecdsa_verify},
+#endif
+#ifdef OPTIGA_CRYPT_ECDH_ENABLED
+    {"crypt_ecdh",                  example_optiga_crypt_ecdh},
+#endif
+#ifdef OPTIGA_CRYPT_RSA_GENERATE_KEYPAIR_ENABLED
+    {"crypt_rsa_generate_keypair",  example_optiga_crypt_rsa_generate_keypair},
+#endif
+#ifdef OPTIGA_CRYPT_RSA_SIGN_ENABLED
+    {"crypt_rsa_sign",              example_optiga_crypt_rsa_sign},
+#endif
+#ifdef OPTIGA_CRYPT_RSA_VERIFY_ENABLED
+    {"crypt_rsa_verify",            example_optiga_crypt_rsa_verify},
+#endif
+#ifdef OPTIGA_CRYPT_RSA_ENCRYPT_ENABLED
+    {"crypt_rsa_encrypt_message",   example_optiga_crypt_rsa_encrypt_message},
+    {"crypt_rsa_encrypt_session",   example_optiga_crypt_rsa_encrypt_session},
+#endif
+#ifdef OPTIGA_CRYPT_RSA_DECRYPT_ENABLED
+    {"crypt_rsa_decrypt_and_store", example_optiga_crypt_rsa_decrypt_and_store},
+    {"crypt_rsa_decrypt_and_export",example_optiga_crypt_rsa_decrypt_and_export},
+#endif
+#if defined (OPTIGA_CRYPT_SYM_ENCRYPT_ENABLED) && defined (OPTIGA_CRYPT_SYM_DECRYPT_ENABLED)
+    {"crypt_symmetric_ecb",         example_optiga_crypt_symmetric_encrypt_decrypt_ecb},
+    {"crypt_symmetric_cbc",         example_optiga_crypt_symmetric_encrypt_decrypt_cbc},
+    {"crypt_symmetric_cbcmac",      example_optiga_crypt_symmetric_encrypt_cbcmac},
+#endif
+#ifdef OPTIGA_CRYPT_HMAC_ENABLED
+    {"crypt_hmac",                  example_optiga_crypt_hmac},
+#endif
+#ifdef OPTIGA_CRYPT_HKDF_ENABLED
+    {"crypt_hkdf",                  example_optiga_crypt_hkdf},
+#endif
+#if defined (OPTIGA_CRYPT_GENERATE_AUTH_CODE_ENABLED) && defined (OPTIGA_CRYPT_HMAC_VERIFY_ENABLED)
+    {"crypt_hmac_verify",           example_optiga_hmac_verify_with_authorization_reference},
+#endif
+#if defined (OPTIGA_CRYPT_GENERATE_AUTH_CODE_ENABLED) && defined (OPTIGA_CRYPT_HMAC_VERIFY_ENABLED) && defined (OPTIGA_CRYPT_CLEAR_AUTO_STATE_ENABLED)
+    {"crypt_clear_auto_state",      example_optiga_crypt_clear_auto_state},
+#endif
+};
+
+#define PERFORMANCE_CASES   (sizeof(performance_cases) / sizeof(performance_cases[0]))
+
+static optiga_example_performance_t performance_results[PERFORMANCE_CASES];
+static char_t performance_line[160];
+
+static volatile optiga_lib_status_t optiga_lib_status;
+//lint --e{818} suppress "argument "context" is not used in the sample provided"
+static void optiga_util_callback(void * context, optiga_lib_status_t return_status)
+{
+    optiga_lib_status = return_status;
+    if (NULL != context)
+    {
+        // callback to upper layer here
+    }
+}
+
+_STATIC_H uint32_t performance_isqrt(uint64_t value)
+{
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > value)
+    {
+        bit >>= 2;
+    }
+    while (0U != bit)
+    {
+        if (value >= root + bit)
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return ((uint32_t)root);
+}
+
+_STATIC_H void performance_summary(const optiga_example_performance_t * p_result,
+                                   uint32_t * p_mean_us,
+                                   uint32_t * p_stddev_us)
+{
+    uint64_t mean;
+    uint64_t mean_sq;
+
+    *p_mean_us = 0;
+    *p_stddev_us = 0;
+    if (0U != p_result->samples)
+    {
+        mean = p_result->sum_us / p_result->samples;
+        mean_sq = p_result->sum_sq_us / p_result->samples;
+        *p_mean_us = (uint32_t)mean;
+        *p_stddev_us = (mean_sq > mean * mean) ? performance_isqrt(mean_sq - mean * mean) : 0U;
+    }
+}
+
+// Current limit in mA read from OPTIGA, 0 if it cannot be read
+_STATIC_H uint8_t performance_read_current_limit(void)
+{
+    optiga_util_t * me = NULL;
+    optiga_lib_status_t return_status = !OPTIGA_LIB_SUCCESS;
+    uint8_t current_limit = 0;
+    uint16_t bytes_to_read = sizeof(current_limit);
+
+#ifndef OPTIGA_INIT_DEINIT_DONE_EXCLUSIVELY
+    example_optiga_init();
+#endif
+    do
+    {
+        me = optiga_util_create(0, optiga_util_callback, NULL);
+        if (NULL == me)
+        {
+            break;
+        }
+        optiga_lib_status = OPTIGA_LIB_BUSY;
+        return_status = optiga_util_read_data(me, OPTIGA_EXAMPLE_PERFORMANCE_CURRENT_OID, 0,
+                                              &current_limit, &bytes_to_read);
+        WAIT_AND_CHECK_STATUS(return_status, optiga_lib_status);
+    } while (FALSE);
+    if (OPTIGA_LIB_SUCCESS != return_status)
+    {
+        current_limit = 0;
+    }
+    if (NULL != me)
+    {
+        //lint --e{534} suppress "Return value is not required to be checked"
+        optiga_util_destroy(me);
+    }
+#ifndef OPTIGA_INIT_DEINIT_DONE_EXCLUSIVELY
+    example_optiga_deinit();
+#endif
+    return (current_limit);
+}
+/// @endcond
+
+void example_optiga_performance_report(uint32_t iterations)
+{
+    uint32_t index;
+    uint32_t run;
+    uint32_t mean_us;
+    uint32_t stddev_us;
+    uint8_t current_limit;
+    optiga_example_performance_t * p_result;
+
+    for (index = 0; index < PERFORMANCE_CASES; index++)
+    {
+        p_result = &performance_results[index];
+        pal_os_memset(p_result, 0, sizeof(*p_result));
+        p_result->name = performance_cases[index].name;
+        example_performance_record_into(p_result);
+        for (run = 0; run < iterations; run++)
+        {
+            p_result->runs++;
+            performance_cases[index].run();
+        }
+    }
+    example_performance_record_into(NULL);
+    current_limit = performance_read_current_limit();
+
+    optiga_lib_print_string_with_newline("");
+    sprintf(performance_line, "OPTIGA performance: config %s, I2C %u kHz, current limit %u mA, %lu iterations",
+            OPTIGA_EXAMPLE_PERFORMANCE_CONFIG, (unsigned)IFX_I2C_FREQUENCY_KHZ, (unsigned)current_limit,
+            (unsigned long)iterations);
+    optiga_lib_print_string_with_newline(performance_line);
+    optiga_lib_print_string_with_newline("");
+    optiga_lib_print_string_with_newline("| operation | ok/runs | min us | mean us | max us | stddev us |");
+    optiga_lib_print_string_with_newline("|---|---:|---:|---:|---:|---:|");
+    for (index = 0; index < PERFORMANCE_CASES; index++)
+    {
+        p_result = &performance_results[index];
+        performance_summary(p_result, &mean_us, &stddev_us);
+        sprintf(performance_line, "| %s | %lu/%lu | %lu | %lu | %lu | %lu |", p_result->name,
+                (unsigned long)p_result->samples, (unsigned long)p_result->runs,
+                (unsigned long)p_result->min_us, (unsigned long)mean_us,
+                (unsigned long)p_result->max_us, (unsigned long)stddev_us);
+        optiga_lib_print_string_with_newline(performance_line);
+    }
+
+    optiga_lib_print_string_with_newline("");
+    optiga_lib_print_string_with_newline("config,i2c_khz,current_ma,operation,runs,ok,min_us,mean_us,max_us,stddev_us");
+    for (index = 0; index < PERFORMANCE_CASES; index++)
+    {
+        p_result = &performance_results[index];
+        performance_summary(p_result, &mean_us, &stddev_us);
+        sprintf(performance_line, "%s,%u,%u,%s,%lu,%lu,%lu,%lu,%lu,%lu", OPTIGA_EXAMPLE_PERFORMANCE_CONFIG,
+                (unsigned)IFX_I2C_FREQUENCY_KHZ, (unsigned)current_limit, p_result->name,
+                (unsigned long)p_result->runs, (unsigned long)p_result->samples,
+                (unsigned long)p_result->min_us, (unsigned long)mean_us,
+                (unsigned long)p_result->max_us, (unsigned long)stddev_us);
+        optiga_lib_print_string_with_newline(performance_line);
+    }
+}
+
+/**
+* @}
+*/
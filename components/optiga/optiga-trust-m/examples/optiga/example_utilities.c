@@ -39,9 +39,15 @@
 #include "optiga/pal/pal_os_timer.h"
 #include "optiga/common/optiga_lib_logger.h"
 #include "optiga/common/optiga_lib_return_codes.h"
+#include "optiga_example.h"
 
 char performance_buffer_string[30];
 
+/// Timings updated by example_performance_measurement(), NULL when not recording
+static optiga_example_performance_t * p_example_performance = NULL;
+/// Microsecond time at the last START_PERFORMANCE_MEASUREMENT()
+static uint32_t example_performance_start_us;
+
 #define OPTIGA_EXAMPLE_UTIL_RSA_NEGATIVE_INTEGER          (0x7F)
 #define OPTIGA_EXAMPLE_UTIL_DER_BITSTRING_TAG               (0x03)
 #define OPTIGA_EXAMPLE_UTIL_DER_NUM_UNUSED_BITS             (0x00)
@@ -164,15 +170,39 @@ optiga_lib_status_t example_check_tag_in_metadata(const uint8_t * buffer, const
     return (return_status);
 }
 
+void example_performance_record_into(optiga_example_performance_t * p_performance)
+{
+    p_example_performance = p_performance;
+}
+
 void example_performance_measurement(uint32_t* time_value, uint8_t time_reset_flag)
 {
+    uint32_t time_us;
+
     if(TRUE == time_reset_flag)
     {
         *time_value = pal_os_timer_get_time_in_milliseconds();
+        example_performance_start_us = pal_os_timer_get_time_in_microseconds();
     }
     else if(FALSE == time_reset_flag)
     {
         *time_value = pal_os_timer_get_time_in_milliseconds() - *time_value;
+        if (NULL != p_example_performance)
+        {
+            // The millisecond value above is too coarse for the fast commands
+            time_us = pal_os_timer_get_time_in_microseconds() - example_performance_start_us;
+            if ((0U == p_example_performance->samples) || (time_us < p_example_performance->min_us))
+            {
+                p_example_performance->min_us = time_us;
+            }
+            if (time_us > p_example_performance->max_us)
+            {
+                p_example_performance->max_us = time_us;
+            }
+            p_example_performance->samples++;
+            p_example_performance->sum_us += time_us;
+            p_example_performance->sum_sq_us += (uint64_t)time_us * time_us;
+        }
     }
 }
 
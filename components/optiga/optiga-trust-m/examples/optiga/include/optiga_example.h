@@ -67,6 +67,48 @@ extern void example_performance_measurement(uint32_t* time_value, uint8_t time_r
 //Stop timer and calculate performance measurement
 #define READ_PERFORMANCE_MEASUREMENT(time_taken) example_performance_measurement(&time_taken, STOPTIMER_AND_CALCULATE)
 
+/** @brief Iterations per example of the performance report (shell command "perf") */
+#ifndef OPTIGA_EXAMPLE_PERFORMANCE_ITERATIONS
+#define OPTIGA_EXAMPLE_PERFORMANCE_ITERATIONS   (10U)
+#endif
+
+/**
+ * \brief Timings of one example, gathered over the iterations of the performance report.
+ */
+typedef struct optiga_example_performance
+{
+    /// Example name, as in the report
+    const char * name;
+    /// Times the example was run
+    uint32_t runs;
+    /// Measurements taken, one per successful run
+    uint32_t samples;
+    /// Shortest measurement [us]
+    uint32_t min_us;
+    /// Longest measurement [us]
+    uint32_t max_us;
+    /// Sum of the measurements [us]
+    uint64_t sum_us;
+    /// Sum of the squared measurements, for the standard deviation [us^2]
+    uint64_t sum_sq_us;
+} optiga_example_performance_t;
+
+/**
+ * \brief Adds every following READ_PERFORMANCE_MEASUREMENT() to p_performance, in microseconds.
+ *
+ * \param[in] p_performance  Timings to update, NULL to stop recording
+ */
+extern void example_performance_record_into(optiga_example_performance_t * p_performance);
+
+/**
+ * \brief Runs the crypt/util examples iterations times each and prints min/mean/max/stddev per
+ *        example as a Markdown table and as CSV, tagged with the library config, I2C speed and
+ *        current limit so that reports of different builds can be put side by side.
+ *
+ * \param[in] iterations     Runs per example
+ */
+extern void example_optiga_performance_report(uint32_t iterations);
+
 // Check return status
 #define WAIT_AND_CHECK_STATUS(return_status, optiga_lib_status)\
                             if (OPTIGA_LIB_SUCCESS != return_status)\
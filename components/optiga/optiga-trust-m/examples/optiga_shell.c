@@ -804,6 +804,12 @@ static void optiga_shell_selftest(void)
 }
 
 
+static void optiga_shell_performance(void)
+{
+    OPTIGA_SHELL_LOG_MESSAGE("Running the crypt/util examples for the performance report...");
+    example_optiga_performance_report(OPTIGA_EXAMPLE_PERFORMANCE_ITERATIONS);
+}
+
 static void optiga_shell_show_usage(void);
 
 
@@ -813,6 +819,7 @@ optiga_example_cmd_t optiga_cmds [] =
         {"    initialize optiga                        : optiga --","init",            optiga_shell_init},
         {"    de-initialize optiga                     : optiga --","deinit",          optiga_shell_deinit},
         {"    run all tests at once                    : optiga --","selftest",        optiga_shell_selftest},
+        {"    timings of all examples (md and csv)     : optiga --","perf",            optiga_shell_performance},
         {"    read data                                : optiga --","readdata",        optiga_shell_util_read_data},
         {"    write data                               : optiga --","writedata",       optiga_shell_util_write_data},
         {"    read coprocessor id                      : optiga --","coprocid",        optiga_shell_util_read_coprocessor_id},
@@ -46,6 +46,10 @@ int32_t tool_get_user_inputs(int32_t argc, int8_t *argv[]);
 int32_t tool_set_user_inputs(manifest_t* manifest_data);
 //  Clears all inputs
 int32_t tool_clear_inputs(manifest_t* p_manifest_data);
+//  Gets the batch job list file, NULL if no batch is requested
+const int8_t * tool_get_batch_file(void);
+//  Sets the inputs that change per batch job, the other options stay as given on the command line
+void tool_set_batch_job(int8_t * couid, int8_t * target_oid, int8_t * payload_file, int8_t * output_file);
 
 #endif //_PROTECTED_UPDATE_USER_INPUT_PARSER_H_
 
@@ -51,6 +51,69 @@
 #include "pal\pal_os_memory.h"
 #include "pal\pal_logger.h"
 
+#define PAL_CRYPT_KEY_PATH_MAX      (260U)
+
+// Signing key and random generator, set up on first use and kept for all data sets of a run:
+// a batch signs every data set with the same key
+static mbedtls_pk_context signing_key;
+static int8_t signing_key_path[PAL_CRYPT_KEY_PATH_MAX];
+static uint8_t signing_key_loaded = FALSE;
+static mbedtls_entropy_context entropy;
+static mbedtls_ctr_drbg_context ctr_drbg;
+static uint8_t ctr_drbg_seeded = FALSE;
+
+static mbedtls_ctr_drbg_context * pal_crypt_get_drbg(void)
+{
+    const int8_t *pers = (const int8_t *)"mbedtls_pk_sign";
+
+    if (FALSE == ctr_drbg_seeded)
+    {
+        mbedtls_entropy_init(&entropy);
+        mbedtls_ctr_drbg_init(&ctr_drbg);
+        if(0 != mbedtls_ctr_drbg_seed(  &ctr_drbg, mbedtls_entropy_func, 
+                                        &entropy, 
+                                        (const uint8_t *)pers, 
+                                        strlen(pers)))
+        {
+            pal_logger_print_message(" Error : Failed in mbedtls_ctr_drbg_seed\n");
+            mbedtls_ctr_drbg_free(&ctr_drbg);
+            mbedtls_entropy_free(&entropy);
+            return NULL;
+        }
+        ctr_drbg_seeded = TRUE;
+    }
+    return &ctr_drbg;
+}
+
+// Parses the private key file only when it differs from the one parsed last
+static mbedtls_pk_context * pal_crypt_get_signing_key(const uint8_t * p_private_key)
+{
+    if ((TRUE == signing_key_loaded) && (0 == strcmp(signing_key_path, (const int8_t*)p_private_key)))
+    {
+        return &signing_key;
+    }
+    if (TRUE == signing_key_loaded)
+    {
+        mbedtls_pk_free(&signing_key);
+        signing_key_loaded = FALSE;
+    }
+    mbedtls_pk_init(&signing_key);
+    if (0 != mbedtls_pk_parse_keyfile(&signing_key, (const int8_t*)p_private_key, ""))
+    {
+        pal_logger_print_message(" Error : Failed in mbedtls_pk_parse_keyfile\n");
+        mbedtls_pk_free(&signing_key);
+        return NULL;
+    }
+    signing_key_loaded = TRUE;
+    // A path too long to keep never matches, so that key is parsed on every call
+    signing_key_path[0] = 0;
+    if (strlen((const int8_t*)p_private_key) < sizeof(signing_key_path))
+    {
+        strcpy(signing_key_path, (const int8_t*)p_private_key);
+    }
+    return &signing_key;
+}
+
 static uint16_t pal_crypt_calculate_sha256_hash(    const uint8_t * message,
                                             uint16_t message_len,
                                             uint8_t * digest)
@@ -103,26 +166,25 @@ pal_status_t pal_crypt_hash( pal_crypt_t* p_pal_crypt,
 pal_status_t pal_crypt_get_signature_length(uint8_t * p_private_key, uint16_t * sign_len, signature_algo_t sign_algo)
 {
     pal_status_t status = 1;
-    mbedtls_pk_context ctx;
+    mbedtls_pk_context * p_ctx;
     mbedtls_ecp_keypair * ecc_ctx;
     mbedtls_rsa_context * rsa_ctx;
     mbedtls_pk_type_t key_type;
     
-    mbedtls_pk_init(&ctx);
     do
     {
-        if (0 != mbedtls_pk_parse_keyfile(&ctx, (const int8_t*)p_private_key, ""))
+        p_ctx = pal_crypt_get_signing_key(p_private_key);
+        if (NULL == p_ctx)
         {
-            pal_logger_print_message(" Error : Failed in mbedtls_pk_parse_keyfile\n");
             break;
         }
 
-        key_type = mbedtls_pk_get_type(&ctx);
+        key_type = mbedtls_pk_get_type(p_ctx);
         if(eES_SHA == sign_algo)
         {
             if(MBEDTLS_PK_ECKEY == key_type)
             {
-                ecc_ctx = (mbedtls_ecp_keypair *)ctx.pk_ctx;
+                ecc_ctx = (mbedtls_ecp_keypair *)p_ctx->pk_ctx;
                 // Signature length is (n/8)*2 hence to get the length of R & S component, 8/2 = 4
                 // Mod operation is performed to get non divisible key size in case of secp521r1.
                 *sign_len = (uint16_t)((ecc_ctx->grp.nbits)/4 + ((ecc_ctx->grp.nbits)%4?2:0)); 
@@ -137,7 +199,7 @@ pal_status_t pal_crypt_get_signature_length(uint8_t * p_private_key, uint16_t *
         {
             if(MBEDTLS_PK_RSA == key_type)
             {
-                rsa_ctx = (mbedtls_rsa_context *)ctx.pk_ctx;
+                rsa_ctx = (mbedtls_rsa_context *)p_ctx->pk_ctx;
                 // Signature length is (n/8)*2 hence to get the length of R & S component, 8/2 = 4
                 // Mod operation is performed to get non divisible key size in case of secp521r1.
                 *sign_len = (uint16_t)rsa_ctx->len; 
@@ -156,7 +218,6 @@ pal_status_t pal_crypt_get_signature_length(uint8_t * p_private_key, uint16_t *
         status = 0;
     }while(0);
 
-    mbedtls_pk_free(&ctx);
     return status;
 }
 
@@ -170,31 +231,22 @@ pal_status_t pal_crypt_sign( pal_crypt_t* p_pal_crypt,
                     uint16_t private_key_length)
 {
     pal_status_t status = 1;
-    mbedtls_pk_context ctx;
-    mbedtls_entropy_context entropy;
-    mbedtls_ctr_drbg_context ctr_drbg;
+    mbedtls_pk_context * p_ctx;
+    mbedtls_ctr_drbg_context * p_ctr_drbg;
     uint8_t hash[32];
-    const int8_t *pers = (const int8_t *)"mbedtls_pk_sign";
     size_t signature_buff_len;
 
     do
     {
-            mbedtls_entropy_init(&entropy);
-            mbedtls_ctr_drbg_init(&ctr_drbg);
-            mbedtls_pk_init(&ctx);
-
-            if(0 != mbedtls_ctr_drbg_seed(  &ctr_drbg, mbedtls_entropy_func, 
-                                            &entropy, 
-                                            (const uint8_t *)pers, 
-                                            strlen(pers)))
+            p_ctr_drbg = pal_crypt_get_drbg();
+            if (NULL == p_ctr_drbg)
             {
-                pal_logger_print_message(" Error : Failed in mbedtls_ctr_drbg_seed\n");
                 break;
             }
-            //Read key into an array
-            if (0 != mbedtls_pk_parse_keyfile(&ctx, (const int8_t*)p_private_key, ""))
+            //Parsed once per key file
+            p_ctx = pal_crypt_get_signing_key(p_private_key);
+            if (NULL == p_ctx)
             {
-                pal_logger_print_message(" Error : Failed in mbedtls_pk_parse_keyfile\n");
                 break;
             }
 
@@ -205,16 +257,13 @@ pal_status_t pal_crypt_sign( pal_crypt_t* p_pal_crypt,
                 break;
             }
 
-            if (0 != mbedtls_pk_sign(&ctx, MBEDTLS_MD_SHA256, hash, 0, p_signature, &signature_buff_len,
-                mbedtls_ctr_drbg_random, &ctr_drbg))
+            if (0 != mbedtls_pk_sign(p_ctx, MBEDTLS_MD_SHA256, hash, 0, p_signature, &signature_buff_len,
+                mbedtls_ctr_drbg_random, p_ctr_drbg))
             {
                 pal_logger_print_message(" Error : Failed in mbedtls_pk_sign\n");
                 break;
             }
             *signature_length = (uint16_t)signature_buff_len;
-            mbedtls_pk_free(&ctx);
-            mbedtls_ctr_drbg_free(&ctr_drbg);
-            mbedtls_entropy_free(&entropy);
             status = 0;
     } while (0);
     return status;
@@ -394,34 +443,23 @@ pal_status_t pal_crypt_generate_random( pal_crypt_t* p_pal_crypt,
                                uint16_t random_data_length )
 {
     pal_status_t return_value = 1;
-    mbedtls_ctr_drbg_context ctr_drbg;
-    mbedtls_entropy_context entropy;
-    const int8_t *pers = (const int8_t *)"mbedtls_pk_sign";
-
-
-    mbedtls_ctr_drbg_init(&ctr_drbg);
-    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_context * p_ctr_drbg;
 
     do
     {
-        if(0 != mbedtls_ctr_drbg_seed(  &ctr_drbg, mbedtls_entropy_func, 
-                                        &entropy, 
-                                        (const uint8_t *)pers, 
-                                        strlen(pers)))
+        p_ctr_drbg = pal_crypt_get_drbg();
+        if (NULL == p_ctr_drbg)
         {
-            pal_logger_print_message(" Error : Failed in mbedtls_ctr_drbg_seed\n");
             break;
         }
-        if (0 != mbedtls_ctr_drbg_random(&ctr_drbg, p_random_data, random_data_length))
+        if (0 != mbedtls_ctr_drbg_random(p_ctr_drbg, p_random_data, random_data_length))
         {
-            pal_logger_print_message(" Error : Failed in mbedtls_pk_parse_keyfile\n");
+            pal_logger_print_message(" Error : Failed in mbedtls_ctr_drbg_random\n");
             break;
         }        
         return_value = 0;
     } while (FALSE);
 
-    mbedtls_ctr_drbg_free(&ctr_drbg);
-    mbedtls_entropy_free(&entropy);
     return return_value;
 }
 
@@ -41,6 +41,8 @@
 #define PRINT_C_CODE_FORMAT_ENABLED    1
 
 const uint8_t * dataset_file_path = NULL;
+// A batch writes its data sets to files only
+uint8_t dataset_to_console = 1;
 
 void pal_logger_print_byte(uint8_t datam)
 {
@@ -0,0 +1,5 @@
+set PATH=..\bin
+
+:: Metadata update of every logger in batch_jobs.txt, one process and one signing key load
+
+%PATH%\protected_update_data_set.exe payload_version=3 trust_anchor_oid=E0E3 sign_algo=ES_256 priv_key=..\samples\integrity\sample_ec_256_priv.pem payload_type=metadata content_reset=0 secret=..\samples\confidentiality\secret.txt label="test" enc_algo="AES-CCM-16-64-128" secret_oid=F1D1 batch=..\samples\batch_jobs.txt
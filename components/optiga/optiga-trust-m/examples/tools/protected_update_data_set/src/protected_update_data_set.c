@@ -82,6 +82,7 @@ uint8_t  signature_header[25];
 
 uint8_t  local_manifest_buffer[550];
 extern uint8_t * dataset_file_path;
+extern uint8_t dataset_to_console;
 
 // Prints protected update manifest and fragment to console
 static void protected_update_print_output_to_console(const protected_update_data_set_d * p_cbor_manifest)
@@ -206,7 +207,10 @@ static void protected_update_print_output_to_file(const protected_update_data_se
 void protected_update_print_output_dataset(const protected_update_data_set_d * p_cbor_manifest)
 {
     // prints to console by default
-    protected_update_print_output_to_console(p_cbor_manifest);
+    if (TRUE == dataset_to_console)
+    {
+        protected_update_print_output_to_console(p_cbor_manifest);
+    }
 
     // if the file path is provided then print to file
     if (NULL != dataset_file_path)
@@ -154,6 +154,11 @@
 #define SHORT_NAME_DATASET_OUTPUT_FILE      "dataset_to_file"TOOL_ASSIGN
 #define DEFAULT_DATASET_OUTPUT_FILE         NULL
 
+// Batch job list
+#define DESC_BATCH_FILE                     "Batch job list"
+#define SHORT_NAME_BATCH_FILE               "batch"TOOL_ASSIGN
+#define DEFAULT_BATCH_FILE                  NULL
+
 // Details
 #define DETAIL_MANIFEST                     "(1) : To create manifest , provide the following details"
 #define DETAIL_CONFIDENTIALITY              "(2) : To enable confidentiality,\"secret\" must be provided (All other options are ignored if there is no confidentiality)"
@@ -161,6 +166,7 @@
 #define DETAIL_KEY_OBJ                      "(3.2) : To update key object, \"payload_type\" should be \"key\" and provide the following details:"
 #define DETAIL_METADATA_OBJ                 "(3.3) : To update metadata object, \"payload_type\" should be \"metadata\" and provide the following details:"
 #define DETAIL_DATASET_TO_FILE              "(4) : To write dataset to file, \"dataset_to_file\" should be the file path "
+#define DETAIL_BATCH                        "(5) : To create many datasets in one run, \"batch\" should be the job list file path"
 
 #define _NEXT_		"\n\t\t\t\t      :  "
 
@@ -202,6 +208,9 @@ static struct options
 
     // FILEPATH NAME
     uint8_t *dataset_to_file_path;
+
+    // BATCH
+    uint8_t * batch_file;
 } opt;
 
 typedef struct option_property
@@ -259,6 +268,11 @@ opt_prop_t option_table[] =
     // Dataset to output file
     { "Details", DETAIL_DATASET_TO_FILE, NULL, "", 0, "", "" },
     { DESC_DATASET_OUTPUT_FILE, SHORT_NAME_DATASET_OUTPUT_FILE, &opt.dataset_to_file_path, DEFAULT_DATASET_OUTPUT_FILE, 0, "Provide the filename for output dataset to be stored", ""},
+
+    // Batch job list
+    { "Details", DETAIL_BATCH, NULL, "", 0, "", "" },
+    { DESC_BATCH_FILE, SHORT_NAME_BATCH_FILE, &opt.batch_file, DEFAULT_BATCH_FILE, 0, "Text file with one job per line : couid target_oid payload_file [output_file]",
+      "The other options apply to every job. couid \"-\" is broadcast."_NEXT_"Output defaults to <couid>_<target_oid>.txt"_NEXT_"Refer : samples/batch_jobs.txt" },
 };
 
 extern uint8_t * dataset_file_path;
@@ -920,9 +934,42 @@ int32_t tool_clear_inputs(manifest_t* p_manifest_data)
     {
         pal_os_free(p_manifest_data->p_metadata_payload);
     }
+    // Cleared so that a batch can call this again after a failed tool_set_user_inputs
+    p_manifest_data->p_confidentiality = NULL;
+    p_manifest_data->p_data_payload = NULL;
+    p_manifest_data->p_key_payload = NULL;
+    p_manifest_data->p_metadata_payload = NULL;
     return status;
 }
 
+const int8_t * tool_get_batch_file(void)
+{
+    return (const int8_t *)opt.batch_file;
+}
+
+void tool_set_batch_job(int8_t * couid, int8_t * target_oid, int8_t * payload_file, int8_t * output_file)
+{
+    // "-" keeps the data set broadcast
+    opt.couid = (0 == strcmp("-", couid)) ? NULL : (uint8_t *)couid;
+    opt.target_oid = (uint8_t *)target_oid;
+    opt.data = NULL;
+    opt.key_data = NULL;
+    opt.metadata = NULL;
+    if (0 == strcmp("key", opt.payload_type))
+    {
+        opt.key_data = (uint8_t *)payload_file;
+    }
+    else if (0 == strcmp("metadata", opt.payload_type))
+    {
+        opt.metadata = (uint8_t *)payload_file;
+    }
+    else
+    {
+        opt.data = (uint8_t *)payload_file;
+    }
+    opt.dataset_to_file_path = (uint8_t *)output_file;
+}
+
 /**
 * @}
 */
@@ -37,17 +37,23 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "pal\pal_logger.h"
 #include "protected_update_data_set.h"
 #include "protected_update_data_set_version.h"
 #include "user_input_parser.h"
 #include "pal\pal_os_memory.h"
 
-int32_t main(int32_t argc, int8_t *argv[])
+#define BATCH_LINE_LENGTH       (600U)
+#define BATCH_FIELD_LENGTH      (260U)
+
+extern uint8_t dataset_to_console;
+
+// Creates and prints one data set from the current user inputs
+static int32_t create_data_set(void)
 {
     int32_t exit_status = 1;
     manifest_t * p_manifest = NULL;
-    int8_t buffer[100];
     protected_update_data_set_d cbor_manifest = { 0 };
     cbor_manifest.data = NULL;
     cbor_manifest.fragments = NULL;
@@ -60,13 +66,6 @@ int32_t main(int32_t argc, int8_t *argv[])
             break;
         }
 
-        sprintf(buffer, "Tool Version : %s\n", PROTECTED_UPDATE_VERSION );
-        pal_logger_print_message(buffer);
-
-        if (0 != tool_get_user_inputs(argc, argv))
-        {
-            break;
-        }
         if( 0 != tool_set_user_inputs(p_manifest))
         {
             break;
@@ -101,12 +100,118 @@ int32_t main(int32_t argc, int8_t *argv[])
     }
     if (NULL != p_manifest)
     {
+        (void)tool_clear_inputs(p_manifest);
         pal_os_free(p_manifest);
     }
 
     return exit_status;
 }
 
+// Creates one data set per job of the list, each written to its own file. The signing key is
+// parsed once for the whole batch.
+// Job line : couid target_oid payload_file [output_file], '#' starts a comment
+static int32_t create_batch(const int8_t * p_job_file)
+{
+    int32_t exit_status = 1;
+    FILE * fp = NULL;
+    int8_t line[BATCH_LINE_LENGTH];
+    int8_t couid[BATCH_FIELD_LENGTH];
+    int8_t target_oid[BATCH_FIELD_LENGTH];
+    int8_t payload_file[BATCH_FIELD_LENGTH];
+    int8_t output_file[BATCH_FIELD_LENGTH + BATCH_FIELD_LENGTH];
+    int8_t buffer[BATCH_LINE_LENGTH + 50];
+    int32_t fields;
+    uint32_t line_number = 0;
+    uint32_t jobs = 0;
+    uint32_t created = 0;
+    uint32_t failed = 0;
+
+    do
+    {
+        fp = fopen(p_job_file, "r");
+        if (NULL == fp)
+        {
+            pal_logger_print_message("Error : Unable to open batch job list\n");
+            break;
+        }
+        dataset_to_console = FALSE;
+
+        while (NULL != fgets(line, sizeof(line), fp))
+        {
+            line_number++;
+            fields = sscanf(line, "%259s %259s %259s %259s", couid, target_oid, payload_file, output_file);
+            if ((fields <= 0) || ('#' == couid[0]))
+            {
+                continue;
+            }
+            if (fields < 3)
+            {
+                sprintf(buffer, "Error : Batch job list line %u is incomplete\n", line_number);
+                pal_logger_print_message(buffer);
+                failed++;
+                continue;
+            }
+            if (fields < 4)
+            {
+                sprintf(output_file, "%s_%s.txt", (0 == strcmp("-", couid)) ? (int8_t *)"broadcast" : couid, target_oid);
+            }
+            // The dataset file is appended to, start each job with a new one
+            (void)remove(output_file);
+
+            sprintf(buffer, "\nInfo : Batch job %u : %s %s %s -> %s\n", jobs + 1, couid, target_oid, payload_file, output_file);
+            pal_logger_print_message(buffer);
+            tool_set_batch_job(couid, target_oid, payload_file, output_file);
+            jobs++;
+            if (0 != create_data_set())
+            {
+                sprintf(buffer, "Error : Batch job list line %u failed\n", line_number);
+                pal_logger_print_message(buffer);
+                failed++;
+                continue;
+            }
+            created++;
+        }
+
+        sprintf(buffer, "\nInfo : Batch done, %u data sets created, %u failed\n", created, failed);
+        pal_logger_print_message(buffer);
+        exit_status = ((0 != created) && (0 == failed)) ? 0 : 1;
+    } while (0);
+
+    if (NULL != fp)
+    {
+        (void)fclose(fp);
+    }
+    return exit_status;
+}
+
+int32_t main(int32_t argc, int8_t *argv[])
+{
+    int32_t exit_status = 1;
+    int8_t buffer[100];
+
+    do
+    {
+        sprintf(buffer, "Tool Version : %s\n", PROTECTED_UPDATE_VERSION );
+        pal_logger_print_message(buffer);
+
+        if (0 != tool_get_user_inputs(argc, argv))
+        {
+            break;
+        }
+
+        if (NULL != tool_get_batch_file())
+        {
+            exit_status = create_batch(tool_get_batch_file());
+        }
+        else
+        {
+            exit_status = create_data_set();
+        }
+    } while (0);
+
+    return exit_status;
+}
+
 /**
 * @}
 */
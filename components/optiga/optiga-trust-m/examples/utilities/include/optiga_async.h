@@ -0,0 +1,203 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file optiga_async.h
+*
+* \brief   Request objects for asynchronous OPTIGA crypt calls: await, poll or continue
+*
+* \ingroup  grOptigaExamples
+*
+* @{
+*/
+
+#ifndef _OPTIGA_ASYNC_H_
+#define _OPTIGA_ASYNC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "optiga/optiga_crypt.h"
+#include "optiga_sync.h"
+
+/// Requests that can be in flight at once, one crypt instance each (CONFIG_OPTIGA_TRUST_M_ASYNC_REQUESTS)
+#ifndef OPTIGA_ASYNC_POOL_SIZE
+#define OPTIGA_ASYNC_POOL_SIZE      (2U)
+#endif
+
+/// One asynchronous OPTIGA request and the crypt instance it runs on
+typedef struct optiga_async optiga_async_t;
+
+/**
+ * \brief Continuation of a request, see optiga_async_then().
+ *
+ * Runs once, in the OPTIGA event task (or in the caller of optiga_async_then() if the request
+ * had already completed), before the waiters of the request wake up. Keep it short: it may
+ * start the next step of a chain, but must not wait for one.
+ *
+ * \param[in] p_req      Completed request, still valid until released
+ * \param[in] status     Result of the request
+ * \param[in] context    Context given to optiga_async_then()
+ */
+typedef void (*optiga_async_then_t)(optiga_async_t * p_req, optiga_lib_status_t status, void * context);
+
+/// Counters of the request pool
+typedef struct optiga_async_stats
+{
+    /// Requests started since boot
+    uint32_t started;
+    /// Most requests in flight at the same time
+    uint32_t max_in_flight;
+    /// optiga_async_acquire() calls that found no free request in time
+    uint32_t exhausted;
+} optiga_async_stats_t;
+
+/**
+ * \brief Takes a request object from the pool, blocking up to timeout_ms while all are taken.
+ *
+ * \details
+ * Each request owns a long-lived crypt instance (created on first use, see #OPTIGA_ASYNC_POOL_SIZE),
+ * so requests taken by one client run side by side: the OPTIGA command scheduler queues them
+ * and the caller does host work meanwhile. Start a call on it with #OPTIGA_ASYNC_CALL, then
+ * await, poll or continue it, and hand it back with optiga_async_release().
+ *
+ * \param[in] timeout_ms   Longest wait for a free request, 0 to fail at once
+ *
+ * \retval    Request, NULL if none was free in time or its instance could not be created
+ */
+optiga_async_t * optiga_async_acquire(uint32_t timeout_ms);
+
+/**
+ * \brief Crypt instance of the request, for the optiga_crypt_xxx call inside #OPTIGA_ASYNC_CALL.
+ *
+ * \param[in] p_req      Request
+ *
+ * \retval    Crypt instance
+ */
+optiga_crypt_t * optiga_async_crypt(optiga_async_t * p_req);
+
+/**
+ * \brief Arms the request before its asynchronous call is issued; drops a previous continuation.
+ *
+ * \param[in] p_req      Request, not in flight
+ */
+void optiga_async_begin(optiga_async_t * p_req);
+
+/**
+ * \brief Takes the return value of the asynchronous call armed by optiga_async_begin().
+ *
+ * A call that was not accepted completes the request at once with start_status, continuation
+ * included, so the caller handles both failures in one place.
+ *
+ * \param[in] p_req          Request
+ * \param[in] start_status   Return value of the optiga_crypt_xxx call
+ *
+ * \retval    start_status
+ */
+optiga_lib_status_t optiga_async_start(optiga_async_t * p_req, optiga_lib_status_t start_status);
+
+/**
+ * \brief Starts one optiga_crypt_xxx call on the request, e.g.
+ * OPTIGA_ASYNC_CALL(req, optiga_crypt_random(optiga_async_crypt(req), OPTIGA_RNG_TYPE_TRNG, iv, 16))
+ */
+#define OPTIGA_ASYNC_CALL(p_req, call) \
+    (optiga_async_begin(p_req), optiga_async_start((p_req), (call)))
+
+/**
+ * \brief Result of the request without blocking.
+ *
+ * \param[in] p_req      Request
+ *
+ * \retval    #OPTIGA_LIB_BUSY while it (or the chain continued on it) runs, else its result
+ */
+optiga_lib_status_t optiga_async_poll(const optiga_async_t * p_req);
+
+/**
+ * \brief Blocks until the request has completed or timeout_ms has passed.
+ *
+ * The request is complete once its continuation has returned without starting a next step
+ * on it, see optiga_async_then().
+ *
+ * As optiga_sync_wait_timeout(): on #OPTIGA_LIB_BUSY the request still runs and its buffers
+ * stay in use; wait again to collect the late result.
+ *
+ * \param[in] p_req        Request
+ * \param[in] timeout_ms   Longest wait, #OPTIGA_SYNC_WAIT_FOREVER for no limit
+ *
+ * \retval    Result of the request, #OPTIGA_LIB_BUSY if it has not completed in time
+ */
+optiga_lib_status_t optiga_async_wait(optiga_async_t * p_req, uint32_t timeout_ms);
+
+/**
+ * \brief Runs fn once the request has completed; at once if it already has.
+ *
+ * One continuation per started request. A continuation that starts the next step of a
+ * chain on p_req itself (its instance is free again when the continuation runs) hands the
+ * wait on: optiga_async_wait() and optiga_async_poll() report the end of the chain, the
+ * first step that fails or the last one. A step on another request
+ * (optiga_async_acquire(0)) is awaited on that one.
+ *
+ * \param[in] p_req      Request, started
+ * \param[in] fn         Continuation
+ * \param[in] context    Passed to fn
+ */
+void optiga_async_then(optiga_async_t * p_req, optiga_async_then_t fn, void * context);
+
+/**
+ * \brief Begin to callback time of the request's last completion [us].
+ *
+ * \param[in] p_req      Request
+ */
+int64_t optiga_async_latency_us(const optiga_async_t * p_req);
+
+/**
+ * \brief Hands the request back to the pool.
+ *
+ * A request still in flight goes back once it completes (after its continuation): its
+ * buffers stay in use until then, but nobody needs to wait for it.
+ *
+ * \param[in] p_req      Request, NULL is ignored
+ */
+void optiga_async_release(optiga_async_t * p_req);
+
+/**
+ * \brief Counters of the request pool.
+ *
+ * \param[out] p_stats   Counters
+ */
+void optiga_async_get_stats(optiga_async_stats_t * p_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _OPTIGA_ASYNC_H_ */
+
+/**
+* @}
+*/
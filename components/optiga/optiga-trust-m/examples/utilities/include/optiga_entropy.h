@@ -0,0 +1,136 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+* \file optiga_entropy.h
+*
+* \brief   OPTIGA TRNG entropy pool, refilled in the background and drained without waiting
+*
+* \ingroup  grOptigaExamples
+*
+* @{
+*/
+
+#ifndef _OPTIGA_ENTROPY_H_
+#define _OPTIGA_ENTROPY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "optiga/common/optiga_lib_types.h"
+#include "optiga/common/optiga_lib_return_codes.h"
+
+/// Bytes of TRNG output kept in the pool
+#ifndef OPTIGA_ENTROPY_POOL_BYTES
+#define OPTIGA_ENTROPY_POOL_BYTES       (512U)
+#endif
+
+/// Bytes requested per OPTIGA TRNG command while refilling (OPTIGA limits one command to 8..256 bytes)
+#ifndef OPTIGA_ENTROPY_REFILL_BYTES
+#define OPTIGA_ENTROPY_REFILL_BYTES     (128U)
+#endif
+
+/// Fill level below which a take wakes the refill task
+#ifndef OPTIGA_ENTROPY_LOW_WATER
+#define OPTIGA_ENTROPY_LOW_WATER        (OPTIGA_ENTROPY_POOL_BYTES / 2U)
+#endif
+
+/// FreeRTOS priority of the refill task, just above idle so refills run when nothing else does
+#ifndef OPTIGA_ENTROPY_TASK_PRIORITY
+#define OPTIGA_ENTROPY_TASK_PRIORITY    (1U)
+#endif
+
+/** @brief Entropy pool counters */
+typedef struct optiga_entropy_stats
+{
+    /// Bytes currently in the pool
+    uint32_t level;
+    /// Bytes handed out by optiga_entropy_take()
+    uint32_t served_bytes;
+    /// Takes that found too few bytes and returned FALSE
+    uint32_t misses;
+    /// Successful TRNG refill commands
+    uint32_t refills;
+    /// Failed TRNG refill commands
+    uint32_t refill_errors;
+    /// Least free stack of the refill task [bytes], 0 if it is not running
+    uint32_t stack_free_min;
+    /// Stack size of the refill task [bytes]
+    uint32_t stack_bytes;
+} optiga_entropy_stats_t;
+
+/**
+ * \brief Creates the refill task and its crypt instance and starts filling the pool.
+ *
+ * \details
+ * Call once after optiga_trust_init(). The instance runs at #OPTIGA_CMD_PRIORITY_LOW, so refills
+ * queue behind the application's own OPTIGA requests.
+ *
+ * \retval    #OPTIGA_LIB_SUCCESS the pool is filling
+ * \retval    #OPTIGA_CRYPT_ERROR the instance or the task could not be created
+ */
+optiga_lib_status_t optiga_entropy_start(void);
+
+/**
+ * \brief Copies length bytes of TRNG output out of the pool, never blocks.
+ *
+ * \details
+ * All or nothing: with fewer bytes in the pool nothing is taken, and the caller falls back to a
+ * direct TRNG command. Bytes are cleared from the pool once taken, so each is handed out once.
+ * Safe to call from several tasks.
+ *
+ * \param[out] p_out      Buffer for the random bytes
+ * \param[in]  length     Number of bytes
+ *
+ * \retval    TRUE p_out holds length random bytes
+ * \retval    FALSE the pool held fewer bytes or is not started
+ */
+bool_t optiga_entropy_take(uint8_t * p_out, uint16_t length);
+
+/**
+ * \brief Stops further refills and waits for a running refill command, e.g. before hibernate.
+ *
+ * Bytes already in the pool can still be taken.
+ */
+void optiga_entropy_pause(void);
+
+/**
+ * \brief Copies the pool counters.
+ *
+ * \param[out] p_stats    Counters
+ */
+void optiga_entropy_get_stats(optiga_entropy_stats_t * p_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _OPTIGA_ENTROPY_H_ */
+
+/**
+* @}
+*/
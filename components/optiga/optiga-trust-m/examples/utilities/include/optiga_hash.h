@@ -0,0 +1,296 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+* \file optiga_hash.h
+*
+* \brief   Streaming SHA-256 on OPTIGA or the ESP32 SHA accelerator, with updates coalesced into full APDUs
+*
+* \ingroup  grOptigaExamples
+*
+* @{
+*/
+
+#ifndef _OPTIGA_HASH_H_
+#define _OPTIGA_HASH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "optiga/optiga_crypt.h"
+#include "optiga_sync.h"
+#include "mbedtls/sha256.h"
+
+/// Bytes collected before one OPTIGA hash update, sized so the data and the imported context fit one APDU
+#ifndef OPTIGA_HASH_BUFFER_BYTES
+#define OPTIGA_HASH_BUFFER_BYTES        (1280U)
+#endif
+
+/// SHA-256 context exported by OPTIGA between two updates
+#define OPTIGA_HASH_CONTEXT_BYTES       (209U)
+
+/// SHA-256 digest length
+#define OPTIGA_HASH_DIGEST_BYTES        (32U)
+
+/// In auto mode every this many streams run on the slower engine, so its cost follows load changes
+#ifndef OPTIGA_HASH_PROBE_INTERVAL
+#define OPTIGA_HASH_PROBE_INTERVAL      (32U)
+#endif
+
+/// Logical streams one multiplexer holds
+#ifndef OPTIGA_HASH_MUX_STREAMS
+#define OPTIGA_HASH_MUX_STREAMS         (8U)
+#endif
+
+/// Bytes a multiplexed stream collects before its context is swapped in for one update command
+#ifndef OPTIGA_HASH_MUX_BUFFER_BYTES
+#define OPTIGA_HASH_MUX_BUFFER_BYTES    (512U)
+#endif
+
+/// Where a stream is hashed
+typedef enum optiga_hash_engine
+{
+    /// Inside OPTIGA, for a digest that must be computed by the secure element
+    OPTIGA_HASH_ENGINE_OPTIGA = 0,
+    /// mbedtls SHA-256 on the ESP32 (SHA accelerator)
+    OPTIGA_HASH_ENGINE_HOST = 1,
+    /// On the engine with the lower measured cost per KiB, OPTIGA queueing included
+    OPTIGA_HASH_ENGINE_AUTO = 2
+} optiga_hash_engine_t;
+
+/** @brief One hash stream, owned by the caller; keep it static, it holds the coalescing buffer */
+typedef struct optiga_hash_stream
+{
+    /// Engine picked by optiga_hash_begin(), #OPTIGA_HASH_ENGINE_OPTIGA or #OPTIGA_HASH_ENGINE_HOST
+    uint8_t engine;
+    /// TRUE once OPTIGA holds a started context for this stream
+    bool_t started;
+    /// First error of the stream, returned by every later call
+    optiga_lib_status_t status;
+    /// Bytes waiting in buffer
+    uint16_t buffered;
+    /// Bytes hashed so far
+    uint32_t length;
+    /// Time spent in update and finish calls [us]
+    uint32_t busy_us;
+    optiga_crypt_t * p_crypt;
+    optiga_sync_t sync;
+    optiga_hash_context_t context;
+    uint8_t context_buffer[OPTIGA_HASH_CONTEXT_BYTES];
+    uint8_t buffer[OPTIGA_HASH_BUFFER_BYTES];
+    mbedtls_sha256_context host;
+} optiga_hash_stream_t;
+
+/** @brief One logical stream of a multiplexer: its exported OPTIGA context and the bytes not yet sent */
+typedef struct optiga_hash_mux_stream
+{
+    /// TRUE between optiga_hash_mux_open() and optiga_hash_mux_finish()
+    bool_t open;
+    /// TRUE once context_buffer holds a started context
+    bool_t started;
+    /// First error of the stream, returned by every later call
+    optiga_lib_status_t status;
+    /// Bytes waiting in buffer
+    uint16_t buffered;
+    uint8_t context_buffer[OPTIGA_HASH_CONTEXT_BYTES];
+    uint8_t buffer[OPTIGA_HASH_MUX_BUFFER_BYTES];
+} optiga_hash_mux_stream_t;
+
+/**
+ * @brief SHA-256 streams interleaved on one OPTIGA crypt instance; keep it static.
+ *
+ * OPTIGA keeps no hash state between commands: each update imports the context from the host and exports
+ * it again. The multiplexer keeps every stream's context in host RAM and points its one hash context at
+ * the stream being sent, so any number of streams costs a single instance. Calls are serialized by a
+ * mutex and may come from several tasks.
+ */
+typedef struct optiga_hash_mux
+{
+    optiga_crypt_t * p_crypt;
+    optiga_sync_t sync;
+    /// Passed to the hash commands, its buffer swapped to the context of the stream being sent
+    optiga_hash_context_t context;
+    SemaphoreHandle_t lock;
+    StaticSemaphore_t lock_buffer;
+    /// Commands that carried a stream's context: start (out), update (in and out), finalize (in)
+    uint32_t swaps;
+    /// Streams finished with one hash command and no context
+    uint32_t one_shots;
+    optiga_hash_mux_stream_t streams[OPTIGA_HASH_MUX_STREAMS];
+} optiga_hash_mux_t;
+
+/** @brief Benchmark result of one message length */
+typedef struct optiga_hash_result
+{
+    /// Mean time of one stream on OPTIGA [us], 0 if the engine failed or is not built
+    uint32_t optiga_us;
+    /// Mean time of one stream on the host [us]
+    uint32_t host_us;
+    /// Mean time of one stream on OPTIGA, streams interleaved update by update on a multiplexer [us],
+    /// 0 if it failed or OPTIGA hashing is not built
+    uint32_t mux_us;
+    /// Context swaps per interleaved stream
+    uint32_t mux_swaps;
+} optiga_hash_result_t;
+
+/** @brief Hash engine counters */
+typedef struct optiga_hash_stats
+{
+    /// Streams finished on OPTIGA
+    uint32_t optiga_streams;
+    /// Streams finished on the host
+    uint32_t host_streams;
+    /// OPTIGA hash commands issued (start, update, finalize or one-shot)
+    uint32_t optiga_commands;
+    /// Streams that failed
+    uint32_t errors;
+} optiga_hash_stats_t;
+
+/**
+ * \brief Starts a SHA-256 stream.
+ *
+ * \details
+ * #OPTIGA_HASH_ENGINE_OPTIGA creates a crypt instance held until optiga_hash_finish() and needs
+ * OPTIGA_CRYPT_HASH_ENABLED in the library configuration; #OPTIGA_HASH_ENGINE_AUTO then only picks
+ * the host. No OPTIGA command is sent yet: the context is started with the first full buffer, and a
+ * stream shorter than #OPTIGA_HASH_BUFFER_BYTES is hashed with one command at the end.
+ *
+ * \param[out] p_stream   Stream
+ * \param[in]  engine     Engine
+ *
+ * \retval    #OPTIGA_LIB_SUCCESS the stream is ready for updates
+ * \retval    #OPTIGA_CRYPT_ERROR_INVALID_INPUT OPTIGA hashing is not built
+ * \retval    #OPTIGA_CRYPT_ERROR no crypt instance is left
+ */
+optiga_lib_status_t optiga_hash_begin(optiga_hash_stream_t * p_stream, optiga_hash_engine_t engine);
+
+/**
+ * \brief Adds length bytes to the stream.
+ *
+ * \details
+ * On OPTIGA the bytes are copied into the stream buffer and sent as one update command each time it
+ * is full, so small updates cost no I2C transaction. Blocks while that command runs.
+ *
+ * \retval    #OPTIGA_LIB_SUCCESS or the error of the failed OPTIGA command
+ */
+optiga_lib_status_t optiga_hash_update(optiga_hash_stream_t * p_stream, const uint8_t * p_data, uint32_t length);
+
+/**
+ * \brief Hashes the buffered bytes, writes the digest and releases the stream.
+ *
+ * \details
+ * The stream is released on error as well and can be started again with optiga_hash_begin().
+ *
+ * \param[in]  p_stream   Stream
+ * \param[out] p_digest   #OPTIGA_HASH_DIGEST_BYTES bytes
+ *
+ * \retval    #OPTIGA_LIB_SUCCESS or the first error of the stream
+ */
+optiga_lib_status_t optiga_hash_finish(optiga_hash_stream_t * p_stream, uint8_t * p_digest);
+
+/**
+ * \brief Creates the crypt instance of a multiplexer.
+ *
+ * \param[out] p_mux      Multiplexer
+ *
+ * \retval    #OPTIGA_LIB_SUCCESS the multiplexer is ready for optiga_hash_mux_open()
+ * \retval    #OPTIGA_CRYPT_ERROR_INVALID_INPUT OPTIGA hashing is not built
+ * \retval    #OPTIGA_CRYPT_ERROR no crypt instance is left
+ */
+optiga_lib_status_t optiga_hash_mux_init(optiga_hash_mux_t * p_mux);
+
+/**
+ * \brief Takes a free stream of the multiplexer. No OPTIGA command is sent.
+ *
+ * \param[in]  p_mux      Multiplexer
+ * \param[out] p_id       Stream index for the other optiga_hash_mux calls
+ *
+ * \retval    #OPTIGA_LIB_SUCCESS or #OPTIGA_CRYPT_ERROR if all #OPTIGA_HASH_MUX_STREAMS are open
+ */
+optiga_lib_status_t optiga_hash_mux_open(optiga_hash_mux_t * p_mux, uint8_t * p_id);
+
+/**
+ * \brief Adds length bytes to a stream of the multiplexer.
+ *
+ * \details
+ * The bytes are collected in the stream until #OPTIGA_HASH_MUX_BUFFER_BYTES are buffered, then sent with
+ * the stream's context as one update command, so small interleaved updates cost no context transfer.
+ * Blocks while that command runs.
+ *
+ * \retval    #OPTIGA_LIB_SUCCESS or the first error of the stream
+ */
+optiga_lib_status_t optiga_hash_mux_update(optiga_hash_mux_t * p_mux, uint8_t id, const uint8_t * p_data,
+                                           uint32_t length);
+
+/**
+ * \brief Hashes the buffered bytes of a stream, writes the digest and frees the stream, on error as well.
+ *
+ * \param[in]  p_mux      Multiplexer
+ * \param[in]  id         Stream
+ * \param[out] p_digest   #OPTIGA_HASH_DIGEST_BYTES bytes
+ *
+ * \retval    #OPTIGA_LIB_SUCCESS or the first error of the stream
+ */
+optiga_lib_status_t optiga_hash_mux_finish(optiga_hash_mux_t * p_mux, uint8_t id, uint8_t * p_digest);
+
+/**
+ * \brief Releases the crypt instance. Streams still open are dropped.
+ *
+ * \param[in]  p_mux      Multiplexer
+ */
+void optiga_hash_mux_deinit(optiga_hash_mux_t * p_mux);
+
+/**
+ * \brief Hashes a length byte pattern iterations times on each engine and seeds the auto costs.
+ *
+ * \details
+ * The multiplexer run hashes several streams at once, each update going to the next stream in turn.
+ *
+ * \param[in]  length      Message length
+ * \param[in]  iterations  Streams per engine
+ * \param[out] p_result    Mean times
+ *
+ * \retval    #OPTIGA_LIB_SUCCESS, or the error of the host engine
+ */
+optiga_lib_status_t optiga_hash_benchmark(uint32_t length, uint32_t iterations, optiga_hash_result_t * p_result);
+
+/**
+ * \brief Copies the engine counters.
+ *
+ * \param[out] p_stats    Counters
+ */
+void optiga_hash_get_stats(optiga_hash_stats_t * p_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _OPTIGA_HASH_H_ */
+
+/**
+* @}
+*/
@@ -0,0 +1,197 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file optiga_sync.h
+*
+* \brief   Blocking wait for asynchronous OPTIGA host library calls
+*
+* \ingroup  grOptigaExamples
+*
+* @{
+*/
+
+#ifndef _OPTIGA_SYNC_H_
+#define _OPTIGA_SYNC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef OPTIGA_SYNC_POSIX
+// Linux hosts (pal/linux): the callbacks run on the pal_os_event loop thread
+#include <semaphore.h>
+#else
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#endif
+#include "optiga/common/optiga_lib_types.h"
+#include "optiga/common/optiga_lib_return_codes.h"
+
+/// Timeout for optiga_sync_wait_timeout()/#OPTIGA_SYNC_CALL that never expires
+#define OPTIGA_SYNC_WAIT_FOREVER    (0xFFFFFFFFUL)
+
+/**
+ * \brief Completion object for one asynchronous OPTIGA instance.
+ *
+ * The instance callback stores the status and gives the binary semaphore, the
+ * caller blocks on it instead of polling the status with a fixed delay.
+ */
+typedef struct optiga_sync
+{
+#ifdef OPTIGA_SYNC_POSIX
+    /// Posted once per completed request by the instance callback
+    sem_t done;
+    /// Set once #done is initialised
+    bool_t done_ready;
+#else
+    /// Given once per completed request by the instance callback
+    SemaphoreHandle_t done;
+    /// Static storage for #done, no heap needed
+    StaticSemaphore_t done_buffer;
+#endif
+    /// Status reported by the last completed request
+    volatile optiga_lib_status_t status;
+    /// Set by optiga_sync_cancel(), cleared by optiga_sync_begin()
+    volatile bool_t cancelled;
+    /// esp_timer (POSIX: CLOCK_MONOTONIC) time at optiga_sync_begin() [us]
+    int64_t start_us;
+    /// Begin to callback time of the last completed request [us]
+    volatile int64_t last_latency_us;
+    /// Longest begin to callback time since boot or optiga_sync_reset_latency() [us]
+    volatile int64_t max_latency_us;
+    /// Shortest begin to callback time, 0 before the first completion [us]
+    volatile int64_t min_latency_us;
+    /// Completions counted in #latency_sum_us and #latency_sum_sq_us
+    volatile uint32_t latency_count;
+    /// Sum of the begin to callback times [us]
+    volatile uint64_t latency_sum_us;
+    /// Sum of the squared begin to callback times, for the standard deviation [us^2]
+    volatile uint64_t latency_sum_sq_us;
+    /// Waits that returned because the timeout expired
+    volatile uint32_t timeouts;
+    /// Completed requests since boot, kept by optiga_sync_reset_latency()
+    volatile uint32_t completions;
+} optiga_sync_t;
+
+/**
+ * \brief Arms the completion object before an asynchronous call is issued.
+ *
+ * Creates the semaphore on first use, sets status to #OPTIGA_LIB_BUSY and drops any stale completion.
+ *
+ * \param[in] p_sync     Completion object
+ */
+void optiga_sync_begin(optiga_sync_t * p_sync);
+
+/**
+ * \brief Records the status and wakes the waiting task. Call it from the instance callback.
+ *
+ * \param[in] p_sync         Completion object
+ * \param[in] return_status  Status passed to the instance callback
+ */
+void optiga_sync_signal(optiga_sync_t * p_sync, optiga_lib_status_t return_status);
+
+/**
+ * \brief Restarts the latency statistics (longest, shortest, count and sums) of the completion object.
+ *
+ * \param[in] p_sync     Completion object
+ */
+void optiga_sync_reset_latency(optiga_sync_t * p_sync);
+
+/**
+ * \brief Instance callback for optiga_crypt_create()/optiga_util_create() with a #optiga_sync_t as context.
+ *
+ * \param[in] context        Pointer to #optiga_sync_t
+ * \param[in] return_status  Status of the completed request
+ */
+void optiga_sync_callback(void * context, optiga_lib_status_t return_status);
+
+/**
+ * \brief Blocks until the request armed by optiga_sync_begin() has completed.
+ *
+ * \param[in] p_sync     Completion object
+ *
+ * \retval    Status reported by the instance callback
+ */
+optiga_lib_status_t optiga_sync_wait(optiga_sync_t * p_sync);
+
+/**
+ * \brief Blocks until the request armed by optiga_sync_begin() has completed, the timeout
+ *        expires or optiga_sync_cancel() is called.
+ *
+ * On #OPTIGA_LIB_BUSY the request is still running: the library cannot abort a command that
+ * has been sent, so the buffers passed to it stay in use and the instance keeps returning
+ * OPTIGA_*_ERROR_INSTANCE_IN_USE until its callback has run. Wait again with the same object
+ * to collect the late result.
+ *
+ * \param[in] p_sync       Completion object
+ * \param[in] timeout_ms   Longest wait, #OPTIGA_SYNC_WAIT_FOREVER for no limit
+ *
+ * \retval    Status reported by the instance callback
+ * \retval    #OPTIGA_LIB_BUSY if the request has not completed in time or the wait was cancelled
+ */
+optiga_lib_status_t optiga_sync_wait_timeout(optiga_sync_t * p_sync, uint32_t timeout_ms);
+
+/**
+ * \brief Makes the task blocked in optiga_sync_wait_timeout() return #OPTIGA_LIB_BUSY now.
+ *
+ * Only the wait is abandoned, the request itself keeps running (see optiga_sync_wait_timeout()).
+ *
+ * \param[in] p_sync     Completion object
+ */
+void optiga_sync_cancel(optiga_sync_t * p_sync);
+
+/**
+ * \brief Waits for a request whose start call returned start_status.
+ *
+ * \param[in] p_sync         Completion object armed by optiga_sync_begin()
+ * \param[in] start_status   Return value of the asynchronous API call
+ * \param[in] timeout_ms     Longest wait, #OPTIGA_SYNC_WAIT_FOREVER for no limit
+ *
+ * \retval    start_status if the call was not accepted, else as optiga_sync_wait_timeout()
+ */
+optiga_lib_status_t optiga_sync_run(optiga_sync_t * p_sync, optiga_lib_status_t start_status,
+                                    uint32_t timeout_ms);
+
+/**
+ * \brief Issues one asynchronous optiga_crypt_xxx/optiga_util_xxx call and blocks for its result.
+ *
+ * p_sync must be the callback context of the instance used by call, e.g.
+ * OPTIGA_SYNC_CALL(&sync, 100, optiga_crypt_random(me, OPTIGA_RNG_TYPE_TRNG, buf, 16))
+ */
+#define OPTIGA_SYNC_CALL(p_sync, timeout_ms, call) \
+    (optiga_sync_begin(p_sync), optiga_sync_run((p_sync), (call), (timeout_ms)))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _OPTIGA_SYNC_H_ */
+
+/**
+* @}
+*/
@@ -42,11 +42,135 @@
 extern "C" {
 #endif
 
+#include "optiga/common/optiga_lib_return_codes.h"
+#include "optiga/common/optiga_lib_types.h"
+
+/** Steps of the comms recovery ladder: data link re-sync, soft, warm and cold reset */
+#define OPTIGA_TRUST_RECOVERY_STEPS     (4U)
+
+/** Counters of the comms recovery ladder, indexed by step */
+typedef struct optiga_trust_recovery_stats
+{
+    /// Runs of each step
+    uint32_t count[OPTIGA_TRUST_RECOVERY_STEPS];
+    /// Duration of the last run of each step in microseconds
+    uint32_t last_us[OPTIGA_TRUST_RECOVERY_STEPS];
+} optiga_trust_recovery_stats_t;
+
+/** Range of the OPTIGA current limitation (data object 0xE0C4) in mA */
+#define OPTIGA_TRUST_CURRENT_LIMIT_MIN_MA   (6U)
+#define OPTIGA_TRUST_CURRENT_LIMIT_MAX_MA   (15U)
+
+/** Current limitation as last set through #optiga_trust_set_current_limit */
+typedef struct optiga_trust_current_limit
+{
+    /// Limit in mA, 0 until it is first read or written after boot
+    uint8_t milliamps;
+    /// Writes of 0xE0C4 since boot, each one an OPTIGA NVM write
+    uint32_t writes;
+    /// Duration of the last write in microseconds
+    uint32_t last_write_us;
+} optiga_trust_current_limit_t;
+
 /**
- *
+ * Opens the application on OPTIGA. An application hibernated by #optiga_trust_hibernate is
+ * restored (after deep sleep, or after any reboot with CONFIG_OPTIGA_TRUST_M_DATASTORE_NVS),
+ * otherwise or if the restore fails a new one is opened.
  */
 void optiga_trust_init(void);
 
+/**
+ * Hibernates the OPTIGA application before ESP32 deep sleep or a planned reboot. The context
+ * handle and shielded connection session are kept in the PAL datastore, so the next
+ * #optiga_trust_init restores them instead of a full open and handshake.
+ * Fails while a session is acquired or the security event counter is non-zero.
+ */
+optiga_lib_status_t optiga_trust_hibernate(void);
+
+/**
+ * Reopens the OPTIGA application after a request failed with a comms error. The open runs the
+ * reset step the failure left pending (soft, then warm, then cold reset), a failing step escalates
+ * to the next one. Retransmits and re-syncs before the failure are bounded by DL_RECOVERY_TIMEOUT_MS.
+ */
+optiga_lib_status_t optiga_trust_recover(void);
+
+/**
+ * Copies the counters of the comms recovery ladder.
+ */
+void optiga_trust_get_recovery_stats(optiga_trust_recovery_stats_t * p_stats);
+
+/**
+ * Sets the OPTIGA current limitation (0xE0C4), 6 to 15 mA. OPTIGA runs commands faster with more
+ * current: a host policy can keep it low while idle and raise it for bulk work. The value is kept
+ * in OPTIGA NVM, so it survives resets, and every change is an NVM write: an unchanged value is
+ * not written, and a policy should change it rarely (minutes, not per command).
+ * Called from #optiga_trust_init with CONFIG_OPTIGA_TRUST_M_CURRENT_LIMIT_MA.
+ */
+optiga_lib_status_t optiga_trust_set_current_limit(uint8_t milliamps);
+
+/**
+ * Copies the current limitation state.
+ */
+void optiga_trust_get_current_limit(optiga_trust_current_limit_t * p_limit);
+
+/**
+ * Takes milliamps as the value stored in 0xE0C4, known from a host-side record of an earlier
+ * boot, so the first #optiga_trust_set_current_limit after boot neither reads nor writes it when
+ * it is unchanged. Call before #optiga_trust_init; 0 or an out of range value is ignored.
+ */
+void optiga_trust_assume_current_limit(uint8_t milliamps);
+
+/** Bytes read from OPTIGA per request by #optiga_trust_read_certificate, kept on its stack */
+#define OPTIGA_TRUST_CERT_CHUNK_BYTES   (192U)
+
+/**
+ * Receives a certificate from #optiga_trust_read_certificate in order, one piece per call.
+ * der_length is the length of the whole DER certificate from its first bytes, offset the
+ * position of p_data in it. Returning FALSE stops the read.
+ */
+typedef bool_t (*optiga_trust_cert_sink_t)(void * p_context, uint16_t der_length, uint16_t offset,
+                                           const uint8_t * p_data, uint16_t length);
+
+struct mbedtls_x509_crt;
+
+/**
+ * Reads the DER certificate in data object oid in chunks of OPTIGA_TRUST_CERT_CHUNK_BYTES and
+ * passes it to sink as it arrives. A leading TLS identity header (tag 0xC0) is skipped and the
+ * read stops at the end of the certificate, so neither the object nor the certificate is ever
+ * held in full by this function.
+ */
+optiga_lib_status_t optiga_trust_read_certificate(uint16_t oid, optiga_trust_cert_sink_t sink, void * p_context);
+
+/**
+ * Reads the certificate in data object oid and adds it to p_chain with mbedtls_x509_crt_parse_der.
+ * The DER is collected in one buffer of exactly its length, freed again once parsed.
+ */
+optiga_lib_status_t optiga_trust_parse_certificate(uint16_t oid, struct mbedtls_x509_crt * p_chain);
+
+/** One data object of a personalization table for #optiga_trust_personalize */
+typedef struct optiga_trust_object
+{
+    /// Data object OID, 0 ends the table
+    uint16_t oid;
+    /// Content the object must hold, NULL to leave the content alone
+    const uint8_t * p_data;
+    /// Length of p_data
+    uint16_t length;
+    /// Metadata tags the object must carry (0x20, length, tags), NULL to leave the metadata alone
+    const uint8_t * p_metadata;
+    /// Length of p_metadata
+    uint8_t metadata_length;
+} optiga_trust_object_t;
+
+/**
+ * Brings the data objects of p_objects to the table's content and metadata. Each object is read
+ * and compared first (used size, then content in chunks of OPTIGA_TRUST_CERT_CHUNK_BYTES; only
+ * the tags listed in p_metadata), and written only where it differs, so an already personalized
+ * OPTIGA costs reads and no NVM writes. *p_written returns the number of writes.
+ * Called from #optiga_trust_init with the table in optiga_trust.c.
+ */
+optiga_lib_status_t optiga_trust_personalize(const optiga_trust_object_t * p_objects, uint8_t * p_written);
+
 #ifdef __cplusplus
 }
 #endif
@@ -69,6 +69,18 @@
  */
 #define MAX_NUM_OBJECTS      6
 
+/**
+ * @brief Number of data object values kept in the module's object cache.
+ *
+ * Certificates and public keys read from OPTIGA are kept on the heap until
+ * the object is written or destroyed through this module, so repeated
+ * attribute queries and C_FindObjects don't read them over I2C again.
+ * Set to 0 to read every value from OPTIGA.
+ */
+#ifndef PKCS11_OBJECT_CACHE_ENTRIES
+#define PKCS11_OBJECT_CACHE_ENTRIES    4
+#endif
+
 /**
  * @brief Set to 1 if a PAL destroy object is implemented.
  *
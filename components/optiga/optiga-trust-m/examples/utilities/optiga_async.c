@@ -0,0 +1,281 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file optiga_async.c
+*
+* \brief   Request objects for asynchronous OPTIGA crypt calls: await, poll or continue
+*
+* \ingroup  grOptigaExamples
+*
+* @{
+*/
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "optiga_async.h"
+
+struct optiga_async
+{
+    optiga_crypt_t * me;
+    /// Completion of the request in flight: waiters block on it
+    optiga_sync_t sync;
+    optiga_async_then_t then;
+    void * then_context;
+    bool_t in_use;
+    /// Started, until its continuation has returned
+    volatile bool_t in_flight;
+    /// Result is in; a continuation registered from now on runs at once
+    volatile bool_t completed;
+    /// Released while in flight: goes back to the pool when it is over
+    bool_t detached;
+    /// Bumped by every optiga_async_begin(): tells a chained step from the one completing
+    volatile uint32_t step;
+};
+
+static optiga_async_t optiga_async_pool[OPTIGA_ASYNC_POOL_SIZE];
+// Counts the free requests, created on the first acquire
+static SemaphoreHandle_t optiga_async_free;
+static StaticSemaphore_t optiga_async_free_buffer;
+// Guards the pool and the completion state of every request
+static portMUX_TYPE optiga_async_lock = portMUX_INITIALIZER_UNLOCKED;
+static optiga_async_stats_t optiga_async_stats;
+static uint32_t optiga_async_in_flight;
+
+/// @cond hidden
+// Caller holds optiga_async_lock
+_STATIC_H void optiga_async_put_back(optiga_async_t * p_req)
+{
+    p_req->in_use = FALSE;
+    p_req->detached = FALSE;
+    p_req->then = NULL;
+}
+
+// The request is done: run the continuation, then wake the waiters and return a detached
+// request, unless the continuation started the next step of a chain on it
+_STATIC_H void optiga_async_complete(optiga_async_t * p_req, optiga_lib_status_t status)
+{
+    optiga_async_then_t fn;
+    void * context;
+    uint32_t step;
+    bool_t done;
+    bool_t free_now = FALSE;
+
+    portENTER_CRITICAL(&optiga_async_lock);
+    step = p_req->step;
+    p_req->completed = TRUE;
+    optiga_async_in_flight--;
+    fn = p_req->then;
+    context = p_req->then_context;
+    p_req->then = NULL;
+    portEXIT_CRITICAL(&optiga_async_lock);
+
+    if (NULL != fn)
+    {
+        fn(p_req, status, context);
+    }
+
+    // A step started meanwhile is waited for instead (and completes the request itself)
+    done = (step == p_req->step) ? TRUE : FALSE;
+    if (TRUE == done)
+    {
+        optiga_sync_signal(&p_req->sync, status);
+    }
+    portENTER_CRITICAL(&optiga_async_lock);
+    if ((TRUE == done) && (step == p_req->step))
+    {
+        p_req->in_flight = FALSE;
+        free_now = p_req->detached;
+        if (TRUE == free_now)
+        {
+            optiga_async_put_back(p_req);
+        }
+    }
+    portEXIT_CRITICAL(&optiga_async_lock);
+    if (TRUE == free_now)
+    {
+        (void)xSemaphoreGive(optiga_async_free);
+    }
+}
+
+_STATIC_H void optiga_async_callback(void * context, optiga_lib_status_t return_status)
+{
+    optiga_async_complete((optiga_async_t *)context, return_status);
+}
+/// @endcond
+
+optiga_async_t * optiga_async_acquire(uint32_t timeout_ms)
+{
+    optiga_async_t * p_req = NULL;
+    TickType_t ticks;
+    uint32_t index;
+
+    portENTER_CRITICAL(&optiga_async_lock);
+    if (NULL == optiga_async_free)
+    {
+        optiga_async_free = xSemaphoreCreateCountingStatic(OPTIGA_ASYNC_POOL_SIZE, OPTIGA_ASYNC_POOL_SIZE,
+                                                           &optiga_async_free_buffer);
+    }
+    portEXIT_CRITICAL(&optiga_async_lock);
+
+    ticks = (OPTIGA_SYNC_WAIT_FOREVER == timeout_ms) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    if (pdTRUE != xSemaphoreTake(optiga_async_free, ticks))
+    {
+        portENTER_CRITICAL(&optiga_async_lock);
+        optiga_async_stats.exhausted++;
+        portEXIT_CRITICAL(&optiga_async_lock);
+        return (NULL);
+    }
+
+    portENTER_CRITICAL(&optiga_async_lock);
+    for (index = 0; index < OPTIGA_ASYNC_POOL_SIZE; index++)
+    {
+        if (FALSE == optiga_async_pool[index].in_use)
+        {
+            p_req = &optiga_async_pool[index];
+            p_req->in_use = TRUE;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&optiga_async_lock);
+
+    // Only the owner of the request gets here, so the instance is created once
+    if (NULL == p_req->me)
+    {
+        p_req->me = optiga_crypt_create(0, optiga_async_callback, p_req);
+        if (NULL == p_req->me)
+        {
+            portENTER_CRITICAL(&optiga_async_lock);
+            optiga_async_put_back(p_req);
+            portEXIT_CRITICAL(&optiga_async_lock);
+            (void)xSemaphoreGive(optiga_async_free);
+            return (NULL);
+        }
+    }
+    return (p_req);
+}
+
+optiga_crypt_t * optiga_async_crypt(optiga_async_t * p_req)
+{
+    return (p_req->me);
+}
+
+void optiga_async_begin(optiga_async_t * p_req)
+{
+    optiga_sync_begin(&p_req->sync);
+    portENTER_CRITICAL(&optiga_async_lock);
+    p_req->then = NULL;
+    p_req->in_flight = TRUE;
+    p_req->completed = FALSE;
+    p_req->step++;
+    optiga_async_stats.started++;
+    optiga_async_in_flight++;
+    if (optiga_async_in_flight > optiga_async_stats.max_in_flight)
+    {
+        optiga_async_stats.max_in_flight = optiga_async_in_flight;
+    }
+    portEXIT_CRITICAL(&optiga_async_lock);
+}
+
+optiga_lib_status_t optiga_async_start(optiga_async_t * p_req, optiga_lib_status_t start_status)
+{
+    if (OPTIGA_LIB_SUCCESS != start_status)
+    {
+        optiga_async_complete(p_req, start_status);
+    }
+    return (start_status);
+}
+
+optiga_lib_status_t optiga_async_poll(const optiga_async_t * p_req)
+{
+    return (p_req->sync.status);
+}
+
+optiga_lib_status_t optiga_async_wait(optiga_async_t * p_req, uint32_t timeout_ms)
+{
+    return (optiga_sync_wait_timeout(&p_req->sync, timeout_ms));
+}
+
+void optiga_async_then(optiga_async_t * p_req, optiga_async_then_t fn, void * context)
+{
+    bool_t run_now;
+
+    portENTER_CRITICAL(&optiga_async_lock);
+    run_now = (TRUE == p_req->completed) || (FALSE == p_req->in_flight);
+    if (FALSE == run_now)
+    {
+        p_req->then = fn;
+        p_req->then_context = context;
+    }
+    portEXIT_CRITICAL(&optiga_async_lock);
+
+    if (TRUE == run_now)
+    {
+        fn(p_req, p_req->sync.status, context);
+    }
+}
+
+int64_t optiga_async_latency_us(const optiga_async_t * p_req)
+{
+    return (p_req->sync.last_latency_us);
+}
+
+void optiga_async_release(optiga_async_t * p_req)
+{
+    bool_t free_now;
+
+    if (NULL == p_req)
+    {
+        return;
+    }
+    portENTER_CRITICAL(&optiga_async_lock);
+    free_now = (FALSE == p_req->in_flight);
+    if (TRUE == free_now)
+    {
+        optiga_async_put_back(p_req);
+    }
+    else
+    {
+        p_req->detached = TRUE;
+    }
+    portEXIT_CRITICAL(&optiga_async_lock);
+    if (TRUE == free_now)
+    {
+        (void)xSemaphoreGive(optiga_async_free);
+    }
+}
+
+void optiga_async_get_stats(optiga_async_stats_t * p_stats)
+{
+    portENTER_CRITICAL(&optiga_async_lock);
+    *p_stats = optiga_async_stats;
+    portEXIT_CRITICAL(&optiga_async_lock);
+}
+
+/**
+* @}
+*/
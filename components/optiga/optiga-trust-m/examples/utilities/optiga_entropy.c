@@ -0,0 +1,229 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+* \file optiga_entropy.c
+*
+* \brief   OPTIGA TRNG entropy pool, refilled in the background and drained without waiting
+*
+* \ingroup  grOptigaExamples
+*
+* @{
+*/
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "optiga/optiga_crypt.h"
+#include "optiga_sync.h"
+#include "optiga_entropy.h"
+
+#if (OPTIGA_ENTROPY_REFILL_BYTES < 8U) || (OPTIGA_ENTROPY_REFILL_BYTES > 256U)
+#error "OPTIGA_ENTROPY_REFILL_BYTES must be 8..256, the range of one OPTIGA TRNG command"
+#endif
+
+#define OPTIGA_ENTROPY_TASK_STACK_BYTES     (3072U)
+// Back off after a failed refill, the application sees the error on its own requests
+#define OPTIGA_ENTROPY_RETRY_MS             (100U)
+
+static uint8_t optiga_entropy_pool[OPTIGA_ENTROPY_POOL_BYTES];
+// Read index and fill level of the ring, both guarded by optiga_entropy_lock
+static uint32_t optiga_entropy_head;
+static uint32_t optiga_entropy_level;
+static optiga_entropy_stats_t optiga_entropy_counters;
+static portMUX_TYPE optiga_entropy_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static optiga_crypt_t * optiga_entropy_crypt;
+static optiga_sync_t optiga_entropy_sync;
+static TaskHandle_t optiga_entropy_task_handle;
+// Held by the refill task around each TRNG command, taken for good by optiga_entropy_pause()
+static SemaphoreHandle_t optiga_entropy_request_lock;
+static StaticSemaphore_t optiga_entropy_request_lock_buffer;
+static volatile bool_t optiga_entropy_paused;
+
+// Appends length bytes at the tail of the ring
+static void optiga_entropy_put(const uint8_t * p_data, uint32_t length)
+{
+    uint32_t tail;
+    uint32_t index;
+
+    portENTER_CRITICAL(&optiga_entropy_lock);
+    tail = (optiga_entropy_head + optiga_entropy_level) % OPTIGA_ENTROPY_POOL_BYTES;
+    for (index = 0; index < length; index++)
+    {
+        optiga_entropy_pool[(tail + index) % OPTIGA_ENTROPY_POOL_BYTES] = p_data[index];
+    }
+    optiga_entropy_level += length;
+    optiga_entropy_counters.refills++;
+    portEXIT_CRITICAL(&optiga_entropy_lock);
+}
+
+static void optiga_entropy_task(void * p_arg)
+{
+    uint8_t chunk[OPTIGA_ENTROPY_REFILL_BYTES];
+    uint32_t space;
+    uint16_t length;
+    optiga_lib_status_t return_status;
+
+    (void)p_arg;
+    while (1)
+    {
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (FALSE == optiga_entropy_paused)
+        {
+            portENTER_CRITICAL(&optiga_entropy_lock);
+            space = OPTIGA_ENTROPY_POOL_BYTES - optiga_entropy_level;
+            portEXIT_CRITICAL(&optiga_entropy_lock);
+
+            length = (uint16_t)((space < OPTIGA_ENTROPY_REFILL_BYTES) ? space : OPTIGA_ENTROPY_REFILL_BYTES);
+            if (length < 8U)
+            {
+                break;
+            }
+
+            (void)xSemaphoreTake(optiga_entropy_request_lock, portMAX_DELAY);
+            if (TRUE == optiga_entropy_paused)
+            {
+                (void)xSemaphoreGive(optiga_entropy_request_lock);
+                break;
+            }
+            return_status = OPTIGA_SYNC_CALL(&optiga_entropy_sync, OPTIGA_SYNC_WAIT_FOREVER,
+                                             optiga_crypt_random(optiga_entropy_crypt, OPTIGA_RNG_TYPE_TRNG,
+                                                                 chunk, length));
+            (void)xSemaphoreGive(optiga_entropy_request_lock);
+
+            if (OPTIGA_LIB_SUCCESS != return_status)
+            {
+                portENTER_CRITICAL(&optiga_entropy_lock);
+                optiga_entropy_counters.refill_errors++;
+                portEXIT_CRITICAL(&optiga_entropy_lock);
+                vTaskDelay(pdMS_TO_TICKS(OPTIGA_ENTROPY_RETRY_MS));
+                continue;
+            }
+            // Only this task adds bytes, so the space seen above is still there
+            optiga_entropy_put(chunk, length);
+            memset(chunk, 0, sizeof(chunk));
+        }
+    }
+}
+
+optiga_lib_status_t optiga_entropy_start(void)
+{
+    optiga_lib_status_t return_status = OPTIGA_CRYPT_ERROR;
+
+    do
+    {
+        if (NULL != optiga_entropy_task_handle)
+        {
+            return_status = OPTIGA_LIB_SUCCESS;
+            break;
+        }
+        optiga_entropy_request_lock = xSemaphoreCreateMutexStatic(&optiga_entropy_request_lock_buffer);
+        optiga_entropy_crypt = optiga_crypt_create(0, optiga_sync_callback, &optiga_entropy_sync);
+        if (NULL == optiga_entropy_crypt)
+        {
+            break;
+        }
+        // Refills are never urgent, they queue behind every other instance
+        OPTIGA_CRYPT_SET_PRIORITY(optiga_entropy_crypt, OPTIGA_CMD_PRIORITY_LOW);
+
+        if (pdPASS != xTaskCreate(optiga_entropy_task, "optiga_entropy", OPTIGA_ENTROPY_TASK_STACK_BYTES, NULL,
+                                  OPTIGA_ENTROPY_TASK_PRIORITY, &optiga_entropy_task_handle))
+        {
+            (void)optiga_crypt_destroy(optiga_entropy_crypt);
+            optiga_entropy_crypt = NULL;
+            optiga_entropy_task_handle = NULL;
+            break;
+        }
+        // First fill
+        (void)xTaskNotifyGive(optiga_entropy_task_handle);
+        return_status = OPTIGA_LIB_SUCCESS;
+    } while (FALSE);
+
+    return (return_status);
+}
+
+bool_t optiga_entropy_take(uint8_t * p_out, uint16_t length)
+{
+    bool_t taken = FALSE;
+    bool_t refill;
+    uint32_t index;
+    uint32_t position;
+
+    portENTER_CRITICAL(&optiga_entropy_lock);
+    if (optiga_entropy_level >= length)
+    {
+        for (index = 0; index < length; index++)
+        {
+            position = (optiga_entropy_head + index) % OPTIGA_ENTROPY_POOL_BYTES;
+            p_out[index] = optiga_entropy_pool[position];
+            optiga_entropy_pool[position] = 0;
+        }
+        optiga_entropy_head = (optiga_entropy_head + length) % OPTIGA_ENTROPY_POOL_BYTES;
+        optiga_entropy_level -= length;
+        optiga_entropy_counters.served_bytes += length;
+        taken = TRUE;
+    }
+    else
+    {
+        optiga_entropy_counters.misses++;
+    }
+    refill = (optiga_entropy_level < OPTIGA_ENTROPY_LOW_WATER) ? TRUE : FALSE;
+    portEXIT_CRITICAL(&optiga_entropy_lock);
+
+    if ((TRUE == refill) && (NULL != optiga_entropy_task_handle))
+    {
+        (void)xTaskNotifyGive(optiga_entropy_task_handle);
+    }
+    return (taken);
+}
+
+void optiga_entropy_pause(void)
+{
+    if (NULL != optiga_entropy_task_handle)
+    {
+        optiga_entropy_paused = TRUE;
+        // Returns once a running refill command has completed; never given back
+        (void)xSemaphoreTake(optiga_entropy_request_lock, portMAX_DELAY);
+    }
+}
+
+void optiga_entropy_get_stats(optiga_entropy_stats_t * p_stats)
+{
+    portENTER_CRITICAL(&optiga_entropy_lock);
+    *p_stats = optiga_entropy_counters;
+    p_stats->level = optiga_entropy_level;
+    portEXIT_CRITICAL(&optiga_entropy_lock);
+    p_stats->stack_bytes = OPTIGA_ENTROPY_TASK_STACK_BYTES;
+    p_stats->stack_free_min = (NULL != optiga_entropy_task_handle) ?
+                              uxTaskGetStackHighWaterMark(optiga_entropy_task_handle) : 0;
+}
+
+/**
+* @}
+*/
@@ -0,0 +1,640 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+* \file optiga_hash.c
+*
+* \brief   Streaming SHA-256 on OPTIGA or the ESP32 SHA accelerator, with updates coalesced into full APDUs
+*
+* \ingroup  grOptigaExamples
+*
+* @{
+*/
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "optiga/pal/pal_os_timer.h"
+#include "optiga_hash.h"
+
+// Weight of a new sample in the moving average is 1/2^OPTIGA_HASH_EWMA_SHIFT
+#define OPTIGA_HASH_EWMA_SHIFT          (3U)
+// Update length of the benchmark, about one log record
+#define OPTIGA_HASH_BENCH_CHUNK         (128U)
+// Streams the benchmark interleaves on the multiplexer
+#define OPTIGA_HASH_BENCH_STREAMS       ((OPTIGA_HASH_MUX_STREAMS < 4U) ? OPTIGA_HASH_MUX_STREAMS : 4U)
+
+#ifdef OPTIGA_CRYPT_HASH_ENABLED
+// What the OPTIGA commands of one stream work on: a stream's own instance and buffer, or the
+// multiplexer's instance with the context and buffer of one of its streams swapped in
+typedef struct optiga_hash_lane
+{
+    optiga_crypt_t * p_crypt;
+    optiga_sync_t * p_sync;
+    optiga_hash_context_t * p_context;
+    bool_t * p_started;
+    uint8_t * buffer;
+    uint16_t capacity;
+    uint16_t * p_buffered;
+    // Counts the commands that carry the context, NULL for a stream of its own
+    uint32_t * p_swaps;
+} optiga_hash_lane_t;
+#endif
+
+// Moving average cost per engine, indexed by OPTIGA_HASH_ENGINE_OPTIGA/HOST, 0 until measured [us per KiB]
+static uint32_t optiga_hash_ewma_us[2];
+static uint32_t optiga_hash_streams;
+static optiga_hash_stats_t optiga_hash_counters;
+static portMUX_TYPE optiga_hash_lock = portMUX_INITIALIZER_UNLOCKED;
+static optiga_hash_stream_t optiga_hash_bench_stream;
+#ifdef OPTIGA_CRYPT_HASH_ENABLED
+static optiga_hash_mux_t optiga_hash_bench_mux;
+#endif
+
+static optiga_hash_engine_t optiga_hash_select(void)
+{
+#ifdef OPTIGA_CRYPT_HASH_ENABLED
+    optiga_hash_engine_t engine;
+    optiga_hash_engine_t faster;
+
+    portENTER_CRITICAL(&optiga_hash_lock);
+    // Measure each engine once, then prefer the cheaper one and probe the other now and then
+    if (0 == optiga_hash_ewma_us[OPTIGA_HASH_ENGINE_OPTIGA])
+    {
+        engine = OPTIGA_HASH_ENGINE_OPTIGA;
+    }
+    else if (0 == optiga_hash_ewma_us[OPTIGA_HASH_ENGINE_HOST])
+    {
+        engine = OPTIGA_HASH_ENGINE_HOST;
+    }
+    else
+    {
+        faster = (optiga_hash_ewma_us[OPTIGA_HASH_ENGINE_HOST] < optiga_hash_ewma_us[OPTIGA_HASH_ENGINE_OPTIGA]) ?
+                 OPTIGA_HASH_ENGINE_HOST : OPTIGA_HASH_ENGINE_OPTIGA;
+        engine = faster;
+        if (0 == (++optiga_hash_streams % OPTIGA_HASH_PROBE_INTERVAL))
+        {
+            engine = (OPTIGA_HASH_ENGINE_HOST == faster) ? OPTIGA_HASH_ENGINE_OPTIGA : OPTIGA_HASH_ENGINE_HOST;
+        }
+    }
+    portEXIT_CRITICAL(&optiga_hash_lock);
+    return (engine);
+#else
+    return (OPTIGA_HASH_ENGINE_HOST);
+#endif
+}
+
+// Feeds the cost of a finished stream into the moving average of its engine and counts it
+static void optiga_hash_record(const optiga_hash_stream_t * p_stream)
+{
+    uint32_t cost_us;
+    uint32_t * p_ewma;
+
+    cost_us = (uint32_t)(((uint64_t)p_stream->busy_us * 1024U) / ((0U == p_stream->length) ? 1U : p_stream->length));
+    portENTER_CRITICAL(&optiga_hash_lock);
+    if (OPTIGA_LIB_SUCCESS != p_stream->status)
+    {
+        optiga_hash_counters.errors++;
+    }
+    else
+    {
+        if (OPTIGA_HASH_ENGINE_OPTIGA == p_stream->engine)
+        {
+            optiga_hash_counters.optiga_streams++;
+        }
+        else
+        {
+            optiga_hash_counters.host_streams++;
+        }
+        p_ewma = &optiga_hash_ewma_us[p_stream->engine];
+        if (0 == *p_ewma)
+        {
+            *p_ewma = (0 == cost_us) ? 1U : cost_us;
+        }
+        else
+        {
+            *p_ewma = (uint32_t)((int32_t)*p_ewma + (((int32_t)cost_us - (int32_t)*p_ewma) >> OPTIGA_HASH_EWMA_SHIFT));
+        }
+    }
+    portEXIT_CRITICAL(&optiga_hash_lock);
+}
+
+#ifdef OPTIGA_CRYPT_HASH_ENABLED
+// p_swaps: the multiplexer's context swap counter for a command that carries a context, else NULL
+static void optiga_hash_count_command(uint32_t * p_swaps)
+{
+    if (NULL != p_swaps)
+    {
+        (*p_swaps)++;
+    }
+    portENTER_CRITICAL(&optiga_hash_lock);
+    optiga_hash_counters.optiga_commands++;
+    portEXIT_CRITICAL(&optiga_hash_lock);
+}
+
+// Sends length bytes as one update command (chained into APDUs by the library), starting the context first
+static optiga_lib_status_t optiga_hash_send(const optiga_hash_lane_t * p_lane, const uint8_t * p_data,
+                                            uint32_t length)
+{
+    optiga_lib_status_t return_status = OPTIGA_LIB_SUCCESS;
+    hash_data_from_host_t data;
+
+    do
+    {
+        if (FALSE == *p_lane->p_started)
+        {
+            optiga_hash_count_command(p_lane->p_swaps);
+            return_status = OPTIGA_SYNC_CALL(p_lane->p_sync, OPTIGA_SYNC_WAIT_FOREVER,
+                                             optiga_crypt_hash_start(p_lane->p_crypt, p_lane->p_context));
+            if (OPTIGA_LIB_SUCCESS != return_status)
+            {
+                break;
+            }
+            *p_lane->p_started = TRUE;
+        }
+        data.buffer = p_data;
+        data.length = length;
+        optiga_hash_count_command(p_lane->p_swaps);
+        return_status = OPTIGA_SYNC_CALL(p_lane->p_sync, OPTIGA_SYNC_WAIT_FOREVER,
+                                         optiga_crypt_hash_update(p_lane->p_crypt, p_lane->p_context,
+                                                                  OPTIGA_CRYPT_HOST_DATA, &data));
+    } while (FALSE);
+
+    return (return_status);
+}
+
+static optiga_lib_status_t optiga_hash_update_optiga(const optiga_hash_lane_t * p_lane, const uint8_t * p_data,
+                                                     uint32_t length)
+{
+    optiga_lib_status_t return_status = OPTIGA_LIB_SUCCESS;
+    uint32_t direct;
+    uint32_t copy;
+
+    while ((length > 0) && (OPTIGA_LIB_SUCCESS == return_status))
+    {
+        // A full buffer is only sent once more data follows, a short stream then stays a single command
+        if (p_lane->capacity == *p_lane->p_buffered)
+        {
+            return_status = optiga_hash_send(p_lane, p_lane->buffer, *p_lane->p_buffered);
+            *p_lane->p_buffered = 0;
+            continue;
+        }
+        // Large updates skip the copy, keeping the tail (at least one byte) for the buffer
+        if ((0 == *p_lane->p_buffered) && (length > p_lane->capacity))
+        {
+            direct = length - (((length - 1U) % p_lane->capacity) + 1U);
+            return_status = optiga_hash_send(p_lane, p_data, direct);
+            p_data += direct;
+            length -= direct;
+            continue;
+        }
+        copy = p_lane->capacity - *p_lane->p_buffered;
+        copy = (copy < length) ? copy : length;
+        memcpy(&p_lane->buffer[*p_lane->p_buffered], p_data, copy);
+        *p_lane->p_buffered += (uint16_t)copy;
+        p_data += copy;
+        length -= copy;
+    }
+    return (return_status);
+}
+
+static optiga_lib_status_t optiga_hash_finish_optiga(const optiga_hash_lane_t * p_lane, uint8_t * p_digest)
+{
+    optiga_lib_status_t return_status = OPTIGA_LIB_SUCCESS;
+    hash_data_from_host_t data;
+
+    do
+    {
+        if (FALSE == *p_lane->p_started)
+        {
+            // Everything is still buffered, one command hashes it
+            data.buffer = p_lane->buffer;
+            data.length = *p_lane->p_buffered;
+            optiga_hash_count_command(NULL);
+            return_status = OPTIGA_SYNC_CALL(p_lane->p_sync, OPTIGA_SYNC_WAIT_FOREVER,
+                                             optiga_crypt_hash(p_lane->p_crypt, OPTIGA_HASH_TYPE_SHA_256,
+                                                               OPTIGA_CRYPT_HOST_DATA, &data, p_digest));
+            break;
+        }
+        if (*p_lane->p_buffered > 0)
+        {
+            return_status = optiga_hash_send(p_lane, p_lane->buffer, *p_lane->p_buffered);
+            if (OPTIGA_LIB_SUCCESS != return_status)
+            {
+                break;
+            }
+        }
+        optiga_hash_count_command(p_lane->p_swaps);
+        return_status = OPTIGA_SYNC_CALL(p_lane->p_sync, OPTIGA_SYNC_WAIT_FOREVER,
+                                         optiga_crypt_hash_finalize(p_lane->p_crypt, p_lane->p_context, p_digest));
+    } while (FALSE);
+
+    return (return_status);
+}
+
+static void optiga_hash_stream_lane(optiga_hash_stream_t * p_stream, optiga_hash_lane_t * p_lane)
+{
+    p_lane->p_crypt = p_stream->p_crypt;
+    p_lane->p_sync = &p_stream->sync;
+    p_lane->p_context = &p_stream->context;
+    p_lane->p_started = &p_stream->started;
+    p_lane->buffer = p_stream->buffer;
+    p_lane->capacity = OPTIGA_HASH_BUFFER_BYTES;
+    p_lane->p_buffered = &p_stream->buffered;
+    p_lane->p_swaps = NULL;
+}
+
+// Swaps the stream's context into the multiplexer's hash context; the caller holds the lock
+static optiga_hash_mux_stream_t * optiga_hash_mux_lane(optiga_hash_mux_t * p_mux, uint8_t id,
+                                                       optiga_hash_lane_t * p_lane)
+{
+    optiga_hash_mux_stream_t * p_slot = &p_mux->streams[id];
+
+    p_mux->context.context_buffer = p_slot->context_buffer;
+    p_lane->p_crypt = p_mux->p_crypt;
+    p_lane->p_sync = &p_mux->sync;
+    p_lane->p_context = &p_mux->context;
+    p_lane->p_started = &p_slot->started;
+    p_lane->buffer = p_slot->buffer;
+    p_lane->capacity = OPTIGA_HASH_MUX_BUFFER_BYTES;
+    p_lane->p_buffered = &p_slot->buffered;
+    p_lane->p_swaps = &p_mux->swaps;
+    return (p_slot);
+}
+#endif
+
+optiga_lib_status_t optiga_hash_begin(optiga_hash_stream_t * p_stream, optiga_hash_engine_t engine)
+{
+    optiga_lib_status_t return_status = OPTIGA_LIB_SUCCESS;
+
+    do
+    {
+        memset(p_stream, 0, sizeof(*p_stream));
+        if (OPTIGA_HASH_ENGINE_AUTO == engine)
+        {
+            engine = optiga_hash_select();
+        }
+        p_stream->engine = (uint8_t)engine;
+
+        if (OPTIGA_HASH_ENGINE_HOST == engine)
+        {
+            mbedtls_sha256_init(&p_stream->host);
+            if (0 != mbedtls_sha256_starts(&p_stream->host, 0))
+            {
+                return_status = OPTIGA_CRYPT_ERROR;
+            }
+            break;
+        }
+#ifdef OPTIGA_CRYPT_HASH_ENABLED
+        p_stream->context.context_buffer = p_stream->context_buffer;
+        p_stream->context.context_buffer_length = sizeof(p_stream->context_buffer);
+        p_stream->context.hash_algo = (uint8_t)OPTIGA_HASH_TYPE_SHA_256;
+        p_stream->p_crypt = optiga_crypt_create(0, optiga_sync_callback, &p_stream->sync);
+        if (NULL == p_stream->p_crypt)
+        {
+            return_status = OPTIGA_CRYPT_ERROR;
+        }
+#else
+        return_status = OPTIGA_CRYPT_ERROR_INVALID_INPUT;
+#endif
+    } while (FALSE);
+
+    p_stream->status = return_status;
+    return (return_status);
+}
+
+optiga_lib_status_t optiga_hash_update(optiga_hash_stream_t * p_stream, const uint8_t * p_data, uint32_t length)
+{
+    uint32_t start_us;
+
+    if (OPTIGA_LIB_SUCCESS == p_stream->status)
+    {
+        start_us = pal_os_timer_get_time_in_microseconds();
+        if (OPTIGA_HASH_ENGINE_HOST == p_stream->engine)
+        {
+            if (0 != mbedtls_sha256_update(&p_stream->host, p_data, length))
+            {
+                p_stream->status = OPTIGA_CRYPT_ERROR;
+            }
+        }
+#ifdef OPTIGA_CRYPT_HASH_ENABLED
+        else
+        {
+            optiga_hash_lane_t lane;
+            optiga_hash_stream_lane(p_stream, &lane);
+            p_stream->status = optiga_hash_update_optiga(&lane, p_data, length);
+        }
+#endif
+        p_stream->length += length;
+        p_stream->busy_us += pal_os_timer_get_time_in_microseconds() - start_us;
+    }
+    return (p_stream->status);
+}
+
+optiga_lib_status_t optiga_hash_finish(optiga_hash_stream_t * p_stream, uint8_t * p_digest)
+{
+    uint32_t start_us = pal_os_timer_get_time_in_microseconds();
+
+    if (OPTIGA_HASH_ENGINE_HOST == p_stream->engine)
+    {
+        if ((OPTIGA_LIB_SUCCESS == p_stream->status) && (0 != mbedtls_sha256_finish(&p_stream->host, p_digest)))
+        {
+            p_stream->status = OPTIGA_CRYPT_ERROR;
+        }
+        mbedtls_sha256_free(&p_stream->host);
+    }
+#ifdef OPTIGA_CRYPT_HASH_ENABLED
+    else
+    {
+        if (OPTIGA_LIB_SUCCESS == p_stream->status)
+        {
+            optiga_hash_lane_t lane;
+            optiga_hash_stream_lane(p_stream, &lane);
+            p_stream->status = optiga_hash_finish_optiga(&lane, p_digest);
+        }
+        if (NULL != p_stream->p_crypt)
+        {
+            (void)optiga_crypt_destroy(p_stream->p_crypt);
+            p_stream->p_crypt = NULL;
+        }
+    }
+#endif
+    p_stream->busy_us += pal_os_timer_get_time_in_microseconds() - start_us;
+    optiga_hash_record(p_stream);
+    // The buffer holds message bytes, e.g. decrypted log records
+    memset(p_stream->buffer, 0, sizeof(p_stream->buffer));
+    p_stream->buffered = 0;
+    return (p_stream->status);
+}
+
+optiga_lib_status_t optiga_hash_mux_init(optiga_hash_mux_t * p_mux)
+{
+    memset(p_mux, 0, sizeof(*p_mux));
+#ifdef OPTIGA_CRYPT_HASH_ENABLED
+    p_mux->context.context_buffer_length = OPTIGA_HASH_CONTEXT_BYTES;
+    p_mux->context.hash_algo = (uint8_t)OPTIGA_HASH_TYPE_SHA_256;
+    p_mux->lock = xSemaphoreCreateMutexStatic(&p_mux->lock_buffer);
+    p_mux->p_crypt = optiga_crypt_create(0, optiga_sync_callback, &p_mux->sync);
+    return ((NULL == p_mux->p_crypt) ? OPTIGA_CRYPT_ERROR : OPTIGA_LIB_SUCCESS);
+#else
+    return (OPTIGA_CRYPT_ERROR_INVALID_INPUT);
+#endif
+}
+
+optiga_lib_status_t optiga_hash_mux_open(optiga_hash_mux_t * p_mux, uint8_t * p_id)
+{
+    optiga_lib_status_t return_status = OPTIGA_CRYPT_ERROR;
+    uint8_t id;
+
+    if (NULL == p_mux->p_crypt)
+    {
+        return (return_status);
+    }
+    (void)xSemaphoreTake(p_mux->lock, portMAX_DELAY);
+    for (id = 0; id < OPTIGA_HASH_MUX_STREAMS; id++)
+    {
+        if (FALSE == p_mux->streams[id].open)
+        {
+            p_mux->streams[id].open = TRUE;
+            p_mux->streams[id].started = FALSE;
+            p_mux->streams[id].status = OPTIGA_LIB_SUCCESS;
+            p_mux->streams[id].buffered = 0;
+            *p_id = id;
+            return_status = OPTIGA_LIB_SUCCESS;
+            break;
+        }
+    }
+    (void)xSemaphoreGive(p_mux->lock);
+    return (return_status);
+}
+
+optiga_lib_status_t optiga_hash_mux_update(optiga_hash_mux_t * p_mux, uint8_t id, const uint8_t * p_data,
+                                           uint32_t length)
+{
+#ifdef OPTIGA_CRYPT_HASH_ENABLED
+    optiga_hash_lane_t lane;
+    optiga_hash_mux_stream_t * p_slot;
+    optiga_lib_status_t return_status;
+
+    if ((id >= OPTIGA_HASH_MUX_STREAMS) || (FALSE == p_mux->streams[id].open))
+    {
+        return (OPTIGA_CRYPT_ERROR_INVALID_INPUT);
+    }
+    (void)xSemaphoreTake(p_mux->lock, portMAX_DELAY);
+    p_slot = optiga_hash_mux_lane(p_mux, id, &lane);
+    if (OPTIGA_LIB_SUCCESS == p_slot->status)
+    {
+        p_slot->status = optiga_hash_update_optiga(&lane, p_data, length);
+    }
+    return_status = p_slot->status;
+    (void)xSemaphoreGive(p_mux->lock);
+    return (return_status);
+#else
+    return (OPTIGA_CRYPT_ERROR_INVALID_INPUT);
+#endif
+}
+
+optiga_lib_status_t optiga_hash_mux_finish(optiga_hash_mux_t * p_mux, uint8_t id, uint8_t * p_digest)
+{
+#ifdef OPTIGA_CRYPT_HASH_ENABLED
+    optiga_hash_lane_t lane;
+    optiga_hash_mux_stream_t * p_slot;
+    optiga_lib_status_t return_status;
+
+    if ((id >= OPTIGA_HASH_MUX_STREAMS) || (FALSE == p_mux->streams[id].open))
+    {
+        return (OPTIGA_CRYPT_ERROR_INVALID_INPUT);
+    }
+    (void)xSemaphoreTake(p_mux->lock, portMAX_DELAY);
+    p_slot = optiga_hash_mux_lane(p_mux, id, &lane);
+    if (OPTIGA_LIB_SUCCESS == p_slot->status)
+    {
+        if (FALSE == p_slot->started)
+        {
+            p_mux->one_shots++;
+        }
+        p_slot->status = optiga_hash_finish_optiga(&lane, p_digest);
+    }
+    return_status = p_slot->status;
+    portENTER_CRITICAL(&optiga_hash_lock);
+    if (OPTIGA_LIB_SUCCESS != return_status)
+    {
+        optiga_hash_counters.errors++;
+    }
+    else
+    {
+        optiga_hash_counters.optiga_streams++;
+    }
+    portEXIT_CRITICAL(&optiga_hash_lock);
+    // The buffer holds message bytes and the context an intermediate state of the message
+    memset(p_slot, 0, sizeof(*p_slot));
+    (void)xSemaphoreGive(p_mux->lock);
+    return (return_status);
+#else
+    return (OPTIGA_CRYPT_ERROR_INVALID_INPUT);
+#endif
+}
+
+void optiga_hash_mux_deinit(optiga_hash_mux_t * p_mux)
+{
+    if (NULL != p_mux->p_crypt)
+    {
+        (void)optiga_crypt_destroy(p_mux->p_crypt);
+        p_mux->p_crypt = NULL;
+    }
+    if (NULL != p_mux->lock)
+    {
+        vSemaphoreDelete(p_mux->lock);
+        p_mux->lock = NULL;
+    }
+    memset(p_mux->streams, 0, sizeof(p_mux->streams));
+}
+
+// Mean time of one length byte stream on engine, 0 if a stream failed
+static uint32_t optiga_hash_bench_engine(optiga_hash_engine_t engine, uint32_t length, uint32_t iterations)
+{
+    uint8_t chunk[OPTIGA_HASH_BENCH_CHUNK];
+    uint8_t digest[OPTIGA_HASH_DIGEST_BYTES];
+    optiga_hash_stream_t * p_stream = &optiga_hash_bench_stream;
+    uint32_t total_us = 0;
+    uint32_t done;
+    uint32_t part;
+    uint32_t start_us;
+    uint32_t index;
+
+    for (index = 0; index < sizeof(chunk); index++)
+    {
+        chunk[index] = (uint8_t)index;
+    }
+    for (index = 0; index < iterations; index++)
+    {
+        start_us = pal_os_timer_get_time_in_microseconds();
+        if (OPTIGA_LIB_SUCCESS != optiga_hash_begin(p_stream, engine))
+        {
+            (void)optiga_hash_finish(p_stream, digest);
+            return (0);
+        }
+        for (done = 0; done < length; done += part)
+        {
+            part = ((length - done) < sizeof(chunk)) ? (length - done) : sizeof(chunk);
+            (void)optiga_hash_update(p_stream, chunk, part);
+        }
+        if (OPTIGA_LIB_SUCCESS != optiga_hash_finish(p_stream, digest))
+        {
+            return (0);
+        }
+        total_us += pal_os_timer_get_time_in_microseconds() - start_us;
+    }
+    total_us = (0 == iterations) ? 0 : (total_us / iterations);
+    return ((0 == total_us) ? 1U : total_us);
+}
+
+#ifdef OPTIGA_CRYPT_HASH_ENABLED
+// Mean time of one length byte stream with OPTIGA_HASH_BENCH_STREAMS of them interleaved chunk by chunk on
+// the multiplexer, 0 if a stream failed
+static uint32_t optiga_hash_bench_interleaved(uint32_t length, uint32_t iterations, uint32_t * p_swaps)
+{
+    uint8_t chunk[OPTIGA_HASH_BENCH_CHUNK];
+    uint8_t digest[OPTIGA_HASH_DIGEST_BYTES];
+    uint8_t ids[OPTIGA_HASH_BENCH_STREAMS];
+    optiga_hash_mux_t * p_mux = &optiga_hash_bench_mux;
+    optiga_lib_status_t return_status;
+    uint32_t total_us = 0;
+    uint32_t done;
+    uint32_t part;
+    uint32_t start_us;
+    uint32_t index;
+    uint8_t stream;
+    uint8_t opened;
+
+    *p_swaps = 0;
+    for (index = 0; index < sizeof(chunk); index++)
+    {
+        chunk[index] = (uint8_t)index;
+    }
+    return_status = optiga_hash_mux_init(p_mux);
+    for (index = 0; (index < iterations) && (OPTIGA_LIB_SUCCESS == return_status); index++)
+    {
+        start_us = pal_os_timer_get_time_in_microseconds();
+        for (opened = 0; (opened < OPTIGA_HASH_BENCH_STREAMS) && (OPTIGA_LIB_SUCCESS == return_status); opened++)
+        {
+            return_status = optiga_hash_mux_open(p_mux, &ids[opened]);
+        }
+        opened -= (OPTIGA_LIB_SUCCESS == return_status) ? 0U : 1U;
+        for (done = 0; (done < length) && (OPTIGA_LIB_SUCCESS == return_status); done += part)
+        {
+            part = ((length - done) < sizeof(chunk)) ? (length - done) : sizeof(chunk);
+            for (stream = 0; (stream < OPTIGA_HASH_BENCH_STREAMS) && (OPTIGA_LIB_SUCCESS == return_status); stream++)
+            {
+                return_status = optiga_hash_mux_update(p_mux, ids[stream], chunk, part);
+            }
+        }
+        for (stream = 0; stream < opened; stream++)
+        {
+            if ((OPTIGA_LIB_SUCCESS != optiga_hash_mux_finish(p_mux, ids[stream], digest)) ||
+                (OPTIGA_LIB_SUCCESS != return_status))
+            {
+                return_status = OPTIGA_CRYPT_ERROR;
+            }
+        }
+        total_us += pal_os_timer_get_time_in_microseconds() - start_us;
+    }
+    if ((0 != iterations) && (OPTIGA_LIB_SUCCESS == return_status))
+    {
+        *p_swaps = p_mux->swaps / (iterations * OPTIGA_HASH_BENCH_STREAMS);
+    }
+    optiga_hash_mux_deinit(p_mux);
+    if ((OPTIGA_LIB_SUCCESS != return_status) || (0 == iterations))
+    {
+        return (0);
+    }
+    total_us /= iterations * OPTIGA_HASH_BENCH_STREAMS;
+    return ((0 == total_us) ? 1U : total_us);
+}
+#endif
+
+optiga_lib_status_t optiga_hash_benchmark(uint32_t length, uint32_t iterations, optiga_hash_result_t * p_result)
+{
+    p_result->optiga_us = 0;
+    p_result->mux_us = 0;
+    p_result->mux_swaps = 0;
+#ifdef OPTIGA_CRYPT_HASH_ENABLED
+    p_result->optiga_us = optiga_hash_bench_engine(OPTIGA_HASH_ENGINE_OPTIGA, length, iterations);
+    p_result->mux_us = optiga_hash_bench_interleaved(length, iterations, &p_result->mux_swaps);
+#endif
+    p_result->host_us = optiga_hash_bench_engine(OPTIGA_HASH_ENGINE_HOST, length, iterations);
+    return (((0 == p_result->host_us) && (0 != iterations)) ? OPTIGA_CRYPT_ERROR : OPTIGA_LIB_SUCCESS);
+}
+
+void optiga_hash_get_stats(optiga_hash_stats_t * p_stats)
+{
+    portENTER_CRITICAL(&optiga_hash_lock);
+    *p_stats = optiga_hash_counters;
+    portEXIT_CRITICAL(&optiga_hash_lock);
+}
+
+/**
+* @}
+*/
@@ -0,0 +1,221 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file optiga_sync.c
+*
+* \brief   Blocking wait for asynchronous OPTIGA host library calls
+*
+* \ingroup  grOptigaExamples
+*
+* @{
+*/
+
+#include "optiga_sync.h"
+
+#ifdef OPTIGA_SYNC_POSIX
+#include <time.h>
+
+/// @cond hidden
+static int64_t optiga_sync_now_us(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((int64_t)now.tv_sec * 1000000) + (now.tv_nsec / 1000);
+}
+
+_STATIC_H void optiga_sync_give(optiga_sync_t * p_sync)
+{
+    (void)sem_post(&p_sync->done);
+}
+
+// Drains the posts left behind: there is no binary semaphore, only a counting one
+_STATIC_H void optiga_sync_drain(optiga_sync_t * p_sync)
+{
+    while (0 == sem_trywait(&p_sync->done))
+    {
+    }
+}
+
+// Waits for one post or until timeout_us (< 0: forever); signals and timeouts just return
+_STATIC_H void optiga_sync_take(optiga_sync_t * p_sync, int64_t timeout_us)
+{
+    if (timeout_us < 0)
+    {
+        (void)sem_wait(&p_sync->done);
+        return;
+    }
+    // sem_timedwait only takes CLOCK_REALTIME deadlines
+    struct timespec deadline;
+    (void)clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += (time_t)(timeout_us / 1000000);
+    deadline.tv_nsec += (long)(timeout_us % 1000000) * 1000;
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    (void)sem_timedwait(&p_sync->done, &deadline);
+}
+/// @endcond
+#else
+#include "esp_timer.h"
+
+/// @cond hidden
+#define optiga_sync_now_us()    esp_timer_get_time()
+
+_STATIC_H void optiga_sync_give(optiga_sync_t * p_sync)
+{
+    (void)xSemaphoreGive(p_sync->done);
+}
+
+_STATIC_H void optiga_sync_drain(optiga_sync_t * p_sync)
+{
+    (void)xSemaphoreTake(p_sync->done, 0);
+}
+
+_STATIC_H void optiga_sync_take(optiga_sync_t * p_sync, int64_t timeout_us)
+{
+    // Round up so the last take does not return a tick before the deadline
+    TickType_t ticks = (timeout_us < 0) ? portMAX_DELAY
+                                        : pdMS_TO_TICKS((uint32_t)((timeout_us + 999) / 1000)) + 1;
+    (void)xSemaphoreTake(p_sync->done, ticks);
+}
+/// @endcond
+#endif
+
+void optiga_sync_begin(optiga_sync_t * p_sync)
+{
+#ifdef OPTIGA_SYNC_POSIX
+    if (FALSE == p_sync->done_ready)
+    {
+        (void)sem_init(&p_sync->done, 0, 0);
+        p_sync->done_ready = TRUE;
+    }
+#else
+    if (NULL == p_sync->done)
+    {
+        p_sync->done = xSemaphoreCreateBinaryStatic(&p_sync->done_buffer);
+    }
+#endif
+    p_sync->status = OPTIGA_LIB_BUSY;
+    p_sync->cancelled = FALSE;
+    p_sync->start_us = optiga_sync_now_us();
+    // A previous request that was abandoned may still have left a give behind
+    optiga_sync_drain(p_sync);
+}
+
+void optiga_sync_signal(optiga_sync_t * p_sync, optiga_lib_status_t return_status)
+{
+    int64_t latency_us = optiga_sync_now_us() - p_sync->start_us;
+
+    p_sync->last_latency_us = latency_us;
+    if (latency_us > p_sync->max_latency_us)
+    {
+        p_sync->max_latency_us = latency_us;
+    }
+    if ((0 == p_sync->latency_count) || (latency_us < p_sync->min_latency_us))
+    {
+        p_sync->min_latency_us = latency_us;
+    }
+    p_sync->latency_count++;
+    p_sync->latency_sum_us += (uint64_t)latency_us;
+    p_sync->latency_sum_sq_us += (uint64_t)latency_us * (uint64_t)latency_us;
+    p_sync->completions++;
+    p_sync->status = return_status;
+    optiga_sync_give(p_sync);
+}
+
+void optiga_sync_reset_latency(optiga_sync_t * p_sync)
+{
+    p_sync->max_latency_us = 0;
+    p_sync->min_latency_us = 0;
+    p_sync->latency_count = 0;
+    p_sync->latency_sum_us = 0;
+    p_sync->latency_sum_sq_us = 0;
+}
+
+void optiga_sync_callback(void * context, optiga_lib_status_t return_status)
+{
+    if (NULL != context)
+    {
+        optiga_sync_signal((optiga_sync_t *)context, return_status);
+    }
+}
+
+optiga_lib_status_t optiga_sync_wait(optiga_sync_t * p_sync)
+{
+    return (optiga_sync_wait_timeout(p_sync, OPTIGA_SYNC_WAIT_FOREVER));
+}
+
+optiga_lib_status_t optiga_sync_wait_timeout(optiga_sync_t * p_sync, uint32_t timeout_ms)
+{
+    int64_t deadline_us = optiga_sync_now_us() + ((int64_t)timeout_ms * 1000);
+    int64_t remaining_us = -1;
+
+    while ((OPTIGA_LIB_BUSY == p_sync->status) && (FALSE == p_sync->cancelled))
+    {
+        if (OPTIGA_SYNC_WAIT_FOREVER != timeout_ms)
+        {
+            remaining_us = deadline_us - optiga_sync_now_us();
+            if (remaining_us <= 0)
+            {
+                p_sync->timeouts++;
+                break;
+            }
+        }
+        optiga_sync_take(p_sync, remaining_us);
+    }
+    return (p_sync->status);
+}
+
+void optiga_sync_cancel(optiga_sync_t * p_sync)
+{
+    p_sync->cancelled = TRUE;
+#ifdef OPTIGA_SYNC_POSIX
+    if (FALSE != p_sync->done_ready)
+#else
+    if (NULL != p_sync->done)
+#endif
+    {
+        optiga_sync_give(p_sync);
+    }
+}
+
+optiga_lib_status_t optiga_sync_run(optiga_sync_t * p_sync, optiga_lib_status_t start_status,
+                                    uint32_t timeout_ms)
+{
+    if (OPTIGA_LIB_SUCCESS != start_status)
+    {
+        return (start_status);
+    }
+    return (optiga_sync_wait_timeout(p_sync, timeout_ms));
+}
+
+/**
+* @}
+*/
@@ -37,6 +37,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "optiga/optiga_util.h"
 #include "optiga/common/optiga_lib_logger.h"
 #include "optiga/pal/pal_os_event.h"
@@ -44,206 +45,345 @@
 #include "optiga/ifx_i2c/ifx_i2c_config.h"
 #include "optiga/pal/pal_ifx_i2c_config.h"
 #include "mbedtls/base64.h"
+#include "mbedtls/platform.h"
+#include "mbedtls/x509_crt.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "optiga_sync.h"
+#include "optiga_trust.h"
 
 #ifndef CONFIG_OPTIGA_TRUST_M_CERT_SLOT
 #define CONFIG_OPTIGA_TRUST_M_CERT_SLOT 0xE0E0
 #endif
 
+#ifndef CONFIG_OPTIGA_TRUST_M_CURRENT_LIMIT_MA
+#define CONFIG_OPTIGA_TRUST_M_CURRENT_LIMIT_MA OPTIGA_TRUST_CURRENT_LIMIT_MAX_MA
+#endif
+
+//Current limitation data object, one byte in mA
+#define OPTIGA_TRUST_CURRENT_LIMIT_OID  (0xE0C4)
+//Platform binding secret data object
+#define OPTIGA_TRUST_BINDING_SECRET_OID (0xE140)
+
+//Example objects of the personalization table, 1 = keep them in OPTIGA
+#ifndef OPTIGA_TRUST_PERSONALIZE_DEVICE_CERTIFICATE
+#define OPTIGA_TRUST_PERSONALIZE_DEVICE_CERTIFICATE (0)
+#endif
+#ifndef OPTIGA_TRUST_PERSONALIZE_BINDING_SECRET
+#define OPTIGA_TRUST_PERSONALIZE_BINDING_SECRET     (0)
+#endif
+
+//Metadata: outer tag, used size tag (2 bytes) and the largest metadata OPTIGA returns
+#define OPTIGA_TRUST_METADATA_TAG           (0x20)
+#define OPTIGA_TRUST_METADATA_USED_SIZE     (0xC5)
+#define OPTIGA_TRUST_METADATA_MAX_BYTES     (64)
+
+//Certificate objects may start with a TLS identity header: tag 0xC0, then 9 bytes before the DER
+#define OPTIGA_TRUST_TLS_IDENTITY_TAG       (0xC0)
+#define OPTIGA_TRUST_TLS_IDENTITY_HEADER    (9)
+//PEM is written one 64 character line (48 DER bytes) at a time
+#define OPTIGA_TRUST_PEM_LINE_BYTES         (48)
+
 pal_status_t pal_os_event_init(void);
 
 /**
  * Callback when optiga_util_xxxx operation is completed asynchronously
  */
-static volatile optiga_lib_status_t optiga_lib_status;
+static optiga_sync_t optiga_util_sync;
 static void optiga_util_callback(void * context, optiga_lib_status_t return_status)
 {
-    optiga_lib_status = return_status;
+    optiga_sync_signal(&optiga_util_sync, return_status);
 }
 
 void read_certificate_from_optiga(char * cert_pem, uint16_t * cert_pem_length);
+optiga_lib_status_t optiga_trust_read_certificate(uint16_t oid, optiga_trust_cert_sink_t sink, void * p_context);
+optiga_lib_status_t optiga_trust_parse_certificate(uint16_t oid, struct mbedtls_x509_crt * p_chain);
 void write_data_object (uint16_t oid, const uint8_t * p_data, uint16_t length);
-static void write_set_high_performance (void);
+optiga_lib_status_t optiga_trust_personalize(const optiga_trust_object_t * p_objects, uint8_t * p_written);
 void optiga_trust_init(void);
-static void write_platform_binding_secret (void) __attribute__ ((unused));
+optiga_lib_status_t optiga_trust_hibernate(void);
+optiga_lib_status_t optiga_trust_recover(void);
+void optiga_trust_get_recovery_stats(optiga_trust_recovery_stats_t * p_stats);
+optiga_lib_status_t optiga_trust_set_current_limit(uint8_t milliamps);
+void optiga_trust_get_current_limit(optiga_trust_current_limit_t * p_limit);
+void optiga_trust_assume_current_limit(uint8_t milliamps);
+static optiga_lib_status_t open_application(optiga_util_t * me_util, bool_t perform_restore);
+static bool_t hibernate_context_stored(void);
 static void write_optiga_trust_anchor(void) __attribute__ ((unused));
-static void write_device_certificate (void) __attribute__ ((unused));
 void read_trust_anchor_from_optiga(uint16_t oid, char * cert_pem, uint16_t * cert_pem_length) __attribute__ ((unused));
 
-void read_certificate_from_optiga(char * cert_pem, uint16_t * cert_pem_length)
+/*
+* Reads one piece of a data object at offset; *p_length is the buffer size on entry and the
+* bytes read on return
+*/
+static optiga_lib_status_t read_object_chunk(optiga_util_t * me_util, uint16_t oid, uint16_t offset,
+                                             uint8_t * p_buffer, uint16_t * p_length)
 {
-    size_t  ifx_cert_b64_len = 0;
-    uint8_t ifx_cert_b64_temp[1200];
-    uint16_t offset_to_write = 0, offset_to_read = 0;
-    uint16_t size_to_copy = 0;
     optiga_lib_status_t return_status;
 
+    optiga_sync_begin(&optiga_util_sync);
+    return_status = optiga_util_read_data(me_util, oid, offset, p_buffer, p_length);
+    if (OPTIGA_LIB_SUCCESS != return_status)
+    {
+        return (return_status);
+    }
+    optiga_sync_wait(&optiga_util_sync);
+    return (optiga_util_sync.status);
+}
+
+/*
+* Offset and length of the DER certificate in the first chunk of a certificate object: an
+* optional 9-byte TLS identity header (tag 0xC0), then the certificate SEQUENCE. Length 0 if
+* the chunk does not start a certificate.
+*/
+static uint16_t certificate_der_span(const uint8_t * p_chunk, uint16_t chunk_length, uint16_t * p_offset)
+{
+    uint16_t offset = (OPTIGA_TRUST_TLS_IDENTITY_TAG == p_chunk[0]) ? OPTIGA_TRUST_TLS_IDENTITY_HEADER : 0;
+    uint32_t length = 0;
+
+    *p_offset = offset;
+    if ((chunk_length < (offset + 4)) || (0x30 != p_chunk[offset]))
+    {
+        return (0);
+    }
+    switch (p_chunk[offset + 1])
+    {
+        case 0x81:
+            length = 3U + p_chunk[offset + 2];
+            break;
+        case 0x82:
+            length = 4U + (((uint32_t)p_chunk[offset + 2] << 8) | p_chunk[offset + 3]);
+            break;
+        default:
+            length = (p_chunk[offset + 1] < 0x80) ? (2U + p_chunk[offset + 1]) : 0U;
+            break;
+    }
+    return ((length + offset <= 0xFFFFU) ? (uint16_t)length : 0);
+}
+
+optiga_lib_status_t optiga_trust_read_certificate(uint16_t oid, optiga_trust_cert_sink_t sink, void * p_context)
+{
+    uint8_t chunk[OPTIGA_TRUST_CERT_CHUNK_BYTES];
+    uint16_t chunk_length = sizeof(chunk);
+    uint16_t der_offset = 0;
+    uint16_t chunk_start;
+    uint16_t der_length;
+    uint16_t done;
+    optiga_lib_status_t return_status = OPTIGA_UTIL_ERROR;
     optiga_util_t * me_util = NULL;
-    uint8_t ifx_cert_hex[1024];
-    //uint8_t ifx_cert_b64_temp[1200];
-    //size_t  ifx_cert_b64_len = 0;
-    uint16_t  ifx_cert_hex_len = sizeof(ifx_cert_hex);
-    
+
     do
     {
         //Create an instance of optiga_util to read the certificate from OPTIGA.
         me_util = optiga_util_create(0, optiga_util_callback, NULL);
-        if(!me_util)
+        if (!me_util)
         {
             optiga_lib_print_message("optiga_util_create failed !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
             break;
         }
-        optiga_lib_status = OPTIGA_LIB_BUSY;
-        return_status = optiga_util_read_data(me_util, CONFIG_OPTIGA_TRUST_M_CERT_SLOT, 0, ifx_cert_hex, &ifx_cert_hex_len);
+
+        // The first chunk holds the headers, so the length is known before any byte is passed on
+        return_status = read_object_chunk(me_util, oid, 0, chunk, &chunk_length);
         if (OPTIGA_LIB_SUCCESS != return_status)
         {
-            //optiga_util_read_data api returns error !!!
-            optiga_lib_print_message("optiga_util_read_data api returns error !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+            optiga_lib_print_message("optiga_util_read_data failed for the certificate",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
             break;
         }
-
-        while (optiga_lib_status == OPTIGA_LIB_BUSY)
-        {
-            pal_os_timer_delay_in_milliseconds(10);
-        }
-        if (OPTIGA_LIB_SUCCESS != optiga_lib_status)
+        der_length = certificate_der_span(chunk, chunk_length, &der_offset);
+        if (0 == der_length)
         {
-            //optiga_util_read_data failed
-            optiga_lib_print_message("optiga_util_read_data failed",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+            optiga_lib_print_message("no DER certificate in the object",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+            return_status = OPTIGA_UTIL_ERROR;
             break;
         }
-        //ESP_LOG_BUFFER_HEX("OPTIGA Certificate", ifx_cert_hex, ifx_cert_hex_len);
-        
-        //convert to PEM format
-        printf("read ifx cer\r\n");
-        // If the first byte is TLS identity Tag, then we need to skip the first 9 bytes
-        offset_to_read = ifx_cert_hex[0]  == 0xc0 ? 9 : 0;
-        mbedtls_base64_encode((unsigned char *)ifx_cert_b64_temp, sizeof(ifx_cert_b64_temp),
-                              &ifx_cert_b64_len,
-                              ifx_cert_hex + offset_to_read, ifx_cert_hex_len - offset_to_read);
-
-        memcpy(cert_pem, "-----BEGIN CERTIFICATE-----\n", 28);
-        offset_to_write += 28;
-        
-       
-        //Properly copy certificate and format it as pkcs expects
-        for (offset_to_read = 0; offset_to_read < ifx_cert_b64_len;)
-        {
-            // The last block of data usually is less than 64, thus we need to find the leftover
-            if ((offset_to_read + 64) >= ifx_cert_b64_len)
-                size_to_copy = ifx_cert_b64_len - offset_to_read;
-            else
-                size_to_copy = 64;
-            memcpy(cert_pem + offset_to_write, ifx_cert_b64_temp + offset_to_read, size_to_copy);
-            offset_to_write += size_to_copy;
-            offset_to_read += size_to_copy;
-            cert_pem[offset_to_write] = '\n';
-            offset_to_write++;
-        }
 
-        memcpy(cert_pem + offset_to_write, "-----END CERTIFICATE-----\n\0", 27);
-
-        *cert_pem_length = offset_to_write + 27;
-        
-        //to print certificate 
-       /* for(int i=0; i<1200; i++)
+        done = 0;
+        chunk_start = der_offset;
+        while (OPTIGA_LIB_SUCCESS == return_status)
         {
-            printf("%c", cert_pem[i]);
-        }   */    
-    } while(0);
+            uint16_t piece = (uint16_t)(chunk_length - chunk_start);
+            if (piece > (der_length - done))
+            {
+                piece = der_length - done;
+            }
+            if (FALSE == sink(p_context, der_length, done, chunk + chunk_start, piece))
+            {
+                return_status = OPTIGA_UTIL_ERROR;
+                break;
+            }
+            done += piece;
+            if (done == der_length)
+            {
+                break;
+            }
+
+            // The rest of the certificate, one chunk per read
+            chunk_start = 0;
+            chunk_length = ((uint16_t)(der_length - done) < sizeof(chunk)) ? (uint16_t)(der_length - done) : (uint16_t)sizeof(chunk);
+            return_status = read_object_chunk(me_util, oid, (uint16_t)(der_offset + done), chunk, &chunk_length);
+            if ((OPTIGA_LIB_SUCCESS == return_status) && (0 == chunk_length))
+            {
+                // The object ends before the length in its DER header
+                return_status = OPTIGA_UTIL_ERROR;
+            }
+        }
+    } while (0);
 
-    //me_util instance to be destroyed 
+    //me_util instance to be destroyed
     if (me_util)
     {
         optiga_util_destroy(me_util);
     }
+    return (return_status);
 }
 
-void read_trust_anchor_from_optiga(uint16_t oid, char * cert_pem, uint16_t * cert_pem_length)
+/*
+* PEM output of the certificate stream: DER bytes are collected up to one line and encoded
+* line by line, so no copy of the whole certificate exists in DER or base64 form
+*/
+typedef struct pem_writer
 {
-    size_t  ifx_cert_b64_len = 0;
-    uint8_t ifx_cert_b64_temp[1300];
-    uint16_t offset_to_write = 0, offset_to_read = 0;
-    uint16_t size_to_copy = 0;
-    optiga_lib_status_t return_status;
+    char * p_pem;
+    uint16_t capacity;
+    uint16_t length;
+    uint8_t line[OPTIGA_TRUST_PEM_LINE_BYTES];
+    uint8_t line_length;
+} pem_writer_t;
 
-    optiga_util_t * me_util = NULL;
-    uint8_t ifx_cert_hex[1300];
-    uint16_t  ifx_cert_hex_len = sizeof(ifx_cert_hex);
+static bool_t pem_put(pem_writer_t * p_writer, const char * p_text, uint16_t length)
+{
+    if ((p_writer->capacity - p_writer->length) < length)
+    {
+        return (FALSE);
+    }
+    memcpy(p_writer->p_pem + p_writer->length, p_text, length);
+    p_writer->length += length;
+    return (TRUE);
+}
 
-    do
+static bool_t pem_flush_line(pem_writer_t * p_writer)
+{
+    size_t written = 0;
+
+    // 64 characters, a new line and the terminating zero mbedtls_base64_encode always writes
+    if ((p_writer->capacity - p_writer->length) < (((OPTIGA_TRUST_PEM_LINE_BYTES / 3) * 4) + 2))
     {
-        //Create an instance of optiga_util to read the certificate from OPTIGA.
-        me_util = optiga_util_create(0, optiga_util_callback, NULL);
-        if(!me_util)
-        {
-            optiga_lib_print_message("optiga_util_create failed !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
-            break;
-        }
-        optiga_lib_status = OPTIGA_LIB_BUSY;   
-        return_status = optiga_util_read_data(me_util, oid, 0, ifx_cert_hex, &ifx_cert_hex_len);
-        if (OPTIGA_LIB_SUCCESS != return_status)
-        {
-            //optiga_util_read_data api returns error !!!
-            optiga_lib_print_message("optiga_util_read_data api for trust anchor returns error !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
-            break;
-        }
-            
-        while (optiga_lib_status == OPTIGA_LIB_BUSY)
+        return (FALSE);
+    }
+    if (0 != mbedtls_base64_encode((unsigned char *)(p_writer->p_pem + p_writer->length),
+                                   p_writer->capacity - p_writer->length, &written,
+                                   p_writer->line, p_writer->line_length))
+    {
+        return (FALSE);
+    }
+    p_writer->length += (uint16_t)written;
+    p_writer->p_pem[p_writer->length++] = '\n';
+    p_writer->line_length = 0;
+    return (TRUE);
+}
+
+static bool_t pem_sink(void * p_context, uint16_t der_length, uint16_t offset, const uint8_t * p_data, uint16_t length)
+{
+    pem_writer_t * p_writer = (pem_writer_t *)p_context;
+    uint16_t piece;
+
+    if ((0 == offset) && (FALSE == pem_put(p_writer, "-----BEGIN CERTIFICATE-----\n", 28)))
+    {
+        return (FALSE);
+    }
+    while (length > 0)
+    {
+        piece = OPTIGA_TRUST_PEM_LINE_BYTES - p_writer->line_length;
+        if (piece > length)
         {
-            pal_os_timer_delay_in_milliseconds(30);
+            piece = length;
         }
-        
-        if (OPTIGA_LIB_SUCCESS != optiga_lib_status)
+        memcpy(p_writer->line + p_writer->line_length, p_data, piece);
+        p_writer->line_length += (uint8_t)piece;
+        p_data += piece;
+        length -= piece;
+        offset += piece;
+        if (((OPTIGA_TRUST_PEM_LINE_BYTES == p_writer->line_length) || (offset == der_length)) &&
+            (FALSE == pem_flush_line(p_writer)))
         {
-            //optiga_util_read_data failed
-            optiga_lib_print_message("optiga_util_read_data failed for reading trust anchor",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
-            break;
+            return (FALSE);
         }
+    }
+    if (offset == der_length)
+    {
+        return (pem_put(p_writer, "-----END CERTIFICATE-----\n\0", 27));
+    }
+    return (TRUE);
+}
 
-        //ESP_LOG_BUFFER_HEX("OPTIGA Certificate", ifx_cert_hex, ifx_cert_hex_len);
-        
-       
-        //convert to PEM format
-        // If the first byte is TLS identity Tag, then we need to skip the first 9 bytes
-        offset_to_read = ifx_cert_hex[0]  == 0xc0 ? 9 : 0;
-        mbedtls_base64_encode((unsigned char *)ifx_cert_b64_temp, sizeof(ifx_cert_b64_temp),
-                              &ifx_cert_b64_len,
-                              ifx_cert_hex + offset_to_read, ifx_cert_hex_len - offset_to_read);
-
-        memcpy(cert_pem, "-----BEGIN CERTIFICATE-----\n", 28);
-        offset_to_write += 28;
-        
-        //TBD: Verify the given cert_pem length against the ifx_cert_b64_len after conversion
-        
-        //Properly copy certificate and format it as pkcs expects
-        for (offset_to_read = 0; offset_to_read < ifx_cert_b64_len;)
-        {
-            // The last block of data usually is less than 64, thus we need to find the leftover
-            if ((offset_to_read + 64) >= ifx_cert_b64_len)
-                size_to_copy = ifx_cert_b64_len - offset_to_read;
-            else
-                size_to_copy = 64;
-            memcpy(cert_pem + offset_to_write, ifx_cert_b64_temp + offset_to_read, size_to_copy);
-            offset_to_write += size_to_copy;
-            offset_to_read += size_to_copy;
-            cert_pem[offset_to_write] = '\n';
-            offset_to_write++;
-        }
+static void read_certificate_pem(uint16_t oid, char * cert_pem, uint16_t * cert_pem_length)
+{
+    pem_writer_t writer;
+
+    writer.p_pem = cert_pem;
+    writer.capacity = *cert_pem_length;
+    writer.length = 0;
+    writer.line_length = 0;
+    if (OPTIGA_LIB_SUCCESS != optiga_trust_read_certificate(oid, pem_sink, &writer))
+    {
+        optiga_lib_print_message("certificate read failed or the PEM buffer is too small",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+        writer.length = 0;
+    }
+    *cert_pem_length = writer.length;
+}
+
+void read_certificate_from_optiga(char * cert_pem, uint16_t * cert_pem_length)
+{
+    read_certificate_pem(CONFIG_OPTIGA_TRUST_M_CERT_SLOT, cert_pem, cert_pem_length);
+}
+
+void read_trust_anchor_from_optiga(uint16_t oid, char * cert_pem, uint16_t * cert_pem_length)
+{
+    read_certificate_pem(oid, cert_pem, cert_pem_length);
+}
+
+/*
+* DER input for mbedtls: the buffer is allocated once the length is known from the first chunk
+*/
+typedef struct der_buffer
+{
+    uint8_t * p_der;
+    uint16_t length;
+} der_buffer_t;
 
-        memcpy(cert_pem + offset_to_write, "-----END CERTIFICATE-----\n\0", 27);
+static bool_t der_sink(void * p_context, uint16_t der_length, uint16_t offset, const uint8_t * p_data, uint16_t length)
+{
+    der_buffer_t * p_buffer = (der_buffer_t *)p_context;
 
-        *cert_pem_length = offset_to_write + 27;
-        /*for(int i=0; i<1300; i++)
+    if (NULL == p_buffer->p_der)
+    {
+        p_buffer->p_der = mbedtls_calloc(1, der_length);
+        if (NULL == p_buffer->p_der)
         {
-            printf("%c", cert_pem[i]);
-        }*/     
-    } while(0);
+            return (FALSE);
+        }
+        p_buffer->length = der_length;
+    }
+    memcpy(p_buffer->p_der + offset, p_data, length);
+    return (TRUE);
+}
 
-    //me_util instance to be destroyed 
-    if (me_util)
+optiga_lib_status_t optiga_trust_parse_certificate(uint16_t oid, struct mbedtls_x509_crt * p_chain)
+{
+    der_buffer_t buffer = {NULL, 0};
+    optiga_lib_status_t return_status;
+
+    return_status = optiga_trust_read_certificate(oid, der_sink, &buffer);
+    if ((OPTIGA_LIB_SUCCESS == return_status) &&
+        (0 != mbedtls_x509_crt_parse_der(p_chain, buffer.p_der, buffer.length)))
     {
-        optiga_util_destroy(me_util);
+        optiga_lib_print_message("mbedtls_x509_crt_parse_der failed",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+        return_status = OPTIGA_UTIL_ERROR;
     }
+    // mbedtls_x509_crt_parse_der keeps its own copy
+    mbedtls_free(buffer.p_der);
+    return (return_status);
 }
 
 void write_data_object (uint16_t oid, const uint8_t * p_data, uint16_t length)
@@ -261,7 +401,7 @@ void write_data_object (uint16_t oid, const uint8_t * p_data, uint16_t length)
             break;
         }
 
-        optiga_lib_status = OPTIGA_LIB_BUSY;
+        optiga_sync_begin(&optiga_util_sync);
         return_status = optiga_util_write_data(me_util,
                                                oid,
                                                OPTIGA_UTIL_ERASE_AND_WRITE,
@@ -275,16 +415,12 @@ void write_data_object (uint16_t oid, const uint8_t * p_data, uint16_t length)
                 break;
             }
 
-            while (OPTIGA_LIB_BUSY == optiga_lib_status)
-            {
-                //Wait until the optiga_util_write_data operation is completed
-                pal_os_timer_delay_in_milliseconds(10);
-            }
+            optiga_sync_wait(&optiga_util_sync);
 
-            if (OPTIGA_LIB_SUCCESS != optiga_lib_status)
+            if (OPTIGA_LIB_SUCCESS != optiga_util_sync.status)
             {
                 optiga_lib_print_message("optiga_util_write_data failed",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
-                return_status = optiga_lib_status;
+                return_status = optiga_util_sync.status;
                 break;
             }
             else
@@ -302,51 +438,48 @@ void write_data_object (uint16_t oid, const uint8_t * p_data, uint16_t length)
     }
 }
 
-static void write_device_certificate (void)
-{
-    //Device certificate
-    const uint8_t certificate [] = {
-        0x30, 0x82, 0x02, 0x3E, 0x30, 0x82, 0x01, 0xE4, 0xA0, 0x03, 0x02, 0x01, 0x02, 0x02, 0x08, 0x66, 
-        0xAD, 0x36, 0x73, 0xED, 0xA4, 0x34, 0x24, 0x30, 0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 
-        0x04, 0x03, 0x02, 0x30, 0x77, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 0x06, 0x13, 0x02, 
-        0x44, 0x45, 0x31, 0x21, 0x30, 0x1F, 0x06, 0x03, 0x55, 0x04, 0x0A, 0x0C, 0x18, 0x49, 0x6E, 0x66, 
-        0x69, 0x6E, 0x65, 0x6F, 0x6E, 0x20, 0x54, 0x65, 0x63, 0x68, 0x6E, 0x6F, 0x6C, 0x6F, 0x67, 0x69, 
-        0x65, 0x73, 0x20, 0x41, 0x47, 0x31, 0x13, 0x30, 0x11, 0x06, 0x03, 0x55, 0x04, 0x0B, 0x0C, 0x0A, 
-        0x4F, 0x50, 0x54, 0x49, 0x47, 0x41, 0x28, 0x54, 0x4D, 0x29, 0x31, 0x30, 0x30, 0x2E, 0x06, 0x03, 
-        0x55, 0x04, 0x03, 0x0C, 0x27, 0x49, 0x6E, 0x66, 0x69, 0x6E, 0x65, 0x6F, 0x6E, 0x20, 0x4F, 0x50, 
-        0x54, 0x49, 0x47, 0x41, 0x28, 0x54, 0x4D, 0x29, 0x20, 0x54, 0x72, 0x75, 0x73, 0x74, 0x20, 0x4D, 
-        0x20, 0x54, 0x65, 0x73, 0x74, 0x20, 0x43, 0x41, 0x20, 0x30, 0x30, 0x30, 0x30, 0x1E, 0x17, 0x0D, 
-        0x31, 0x39, 0x30, 0x38, 0x30, 0x33, 0x31, 0x31, 0x33, 0x39, 0x30, 0x30, 0x5A, 0x17, 0x0D, 0x32, 
-        0x39, 0x30, 0x38, 0x30, 0x33, 0x31, 0x31, 0x33, 0x39, 0x30, 0x30, 0x5A, 0x30, 0x50, 0x31, 0x0B, 
-        0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 0x06, 0x13, 0x02, 0x49, 0x4E, 0x31, 0x0B, 0x30, 0x09, 0x06, 
-        0x03, 0x55, 0x04, 0x07, 0x13, 0x02, 0x4C, 0x4E, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 
-        0x0A, 0x13, 0x02, 0x4F, 0x4E, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 0x0B, 0x13, 0x02, 
-        0x4F, 0x55, 0x31, 0x1A, 0x30, 0x18, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0C, 0x11, 0x49, 0x6E, 0x66, 
-        0x69, 0x6E, 0x65, 0x6F, 0x6E, 0x5F, 0x49, 0x6F, 0x54, 0x5F, 0x4E, 0x6F, 0x64, 0x65, 0x30, 0x59, 
-        0x30, 0x13, 0x06, 0x07, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x02, 0x01, 0x06, 0x08, 0x2A, 0x86, 0x48, 
-        0xCE, 0x3D, 0x03, 0x01, 0x07, 0x03, 0x42, 0x00, 0x04, 0x55, 0x1E, 0x0A, 0xD9, 0x01, 0x19, 0xD0, 
-        0x44, 0x3E, 0xBD, 0xE4, 0x4B, 0xEC, 0xA3, 0xA2, 0xE9, 0x07, 0x08, 0xD2, 0x0A, 0x39, 0x20, 0xE1, 
-        0x0C, 0x69, 0xD7, 0xD6, 0xAE, 0xA5, 0xDD, 0x6F, 0x41, 0x42, 0xE2, 0x73, 0x51, 0x0C, 0x6D, 0xD0, 
-        0x05, 0x02, 0x60, 0x5F, 0x6D, 0x45, 0x35, 0x4F, 0xCC, 0x7F, 0x0C, 0xDB, 0x1E, 0xBB, 0xDD, 0x4D, 
-        0x8E, 0x40, 0xBC, 0x55, 0x65, 0xD2, 0x7A, 0x2F, 0x81, 0xA3, 0x81, 0x80, 0x30, 0x7E, 0x30, 0x0C, 
-        0x06, 0x03, 0x55, 0x1D, 0x13, 0x01, 0x01, 0xFF, 0x04, 0x02, 0x30, 0x00, 0x30, 0x1D, 0x06, 0x03, 
-        0x55, 0x1D, 0x0E, 0x04, 0x16, 0x04, 0x14, 0xB9, 0x46, 0xB7, 0x00, 0x01, 0xD9, 0x5E, 0xFC, 0x80, 
-        0x42, 0x0E, 0xED, 0x6A, 0xF9, 0x0B, 0x53, 0x79, 0xA7, 0x4F, 0xAE, 0x30, 0x1F, 0x06, 0x03, 0x55, 
-        0x1D, 0x23, 0x04, 0x18, 0x30, 0x16, 0x80, 0x14, 0x53, 0x1B, 0x46, 0x32, 0xF2, 0xBA, 0x1B, 0xEC, 
-        0x35, 0x23, 0xB0, 0xC6, 0x84, 0xE2, 0xBC, 0x7F, 0x11, 0xDA, 0xA2, 0x2E, 0x30, 0x0E, 0x06, 0x03, 
-        0x55, 0x1D, 0x0F, 0x01, 0x01, 0xFF, 0x04, 0x04, 0x03, 0x02, 0x07, 0x80, 0x30, 0x1E, 0x06, 0x09, 
-        0x60, 0x86, 0x48, 0x01, 0x86, 0xF8, 0x42, 0x01, 0x0D, 0x04, 0x11, 0x16, 0x0F, 0x78, 0x63, 0x61, 
-        0x20, 0x63, 0x65, 0x72, 0x74, 0x69, 0x66, 0x69, 0x63, 0x61, 0x74, 0x65, 0x30, 0x0A, 0x06, 0x08, 
-        0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02, 0x03, 0x48, 0x00, 0x30, 0x45, 0x02, 0x21, 0x00, 
-        0x98, 0x00, 0x55, 0x8D, 0x58, 0xE9, 0x24, 0xB9, 0x69, 0x1B, 0x12, 0x0D, 0x4E, 0xE0, 0xAB, 0xF3, 
-        0x00, 0xDA, 0x14, 0x3A, 0x39, 0x05, 0xE7, 0xC8, 0xCE, 0xBD, 0x07, 0x0F, 0x7D, 0x03, 0xEA, 0x54, 
-        0x02, 0x20, 0x45, 0x77, 0x6C, 0x77, 0xD0, 0xCC, 0x51, 0xF8, 0xD5, 0x77, 0x5C, 0xE7, 0xBC, 0xED, 
-        0x56, 0xD8, 0x39, 0xF9, 0x98, 0x8C, 0x06, 0xFF, 0x56, 0x73, 0x79, 0x04, 0x1E, 0x37, 0xAB, 0x5F, 
-        0x8B, 0x73, 
-    };
-    
-    write_data_object (CONFIG_OPTIGA_TRUST_M_CERT_SLOT, certificate, sizeof(certificate));
-}
+#if OPTIGA_TRUST_PERSONALIZE_DEVICE_CERTIFICATE
+//Device certificate
+static const uint8_t device_certificate [] = {
+    0x30, 0x82, 0x02, 0x3E, 0x30, 0x82, 0x01, 0xE4, 0xA0, 0x03, 0x02, 0x01, 0x02, 0x02, 0x08, 0x66, 
+    0xAD, 0x36, 0x73, 0xED, 0xA4, 0x34, 0x24, 0x30, 0x0A, 0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 
+    0x04, 0x03, 0x02, 0x30, 0x77, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 0x06, 0x13, 0x02, 
+    0x44, 0x45, 0x31, 0x21, 0x30, 0x1F, 0x06, 0x03, 0x55, 0x04, 0x0A, 0x0C, 0x18, 0x49, 0x6E, 0x66, 
+    0x69, 0x6E, 0x65, 0x6F, 0x6E, 0x20, 0x54, 0x65, 0x63, 0x68, 0x6E, 0x6F, 0x6C, 0x6F, 0x67, 0x69, 
+    0x65, 0x73, 0x20, 0x41, 0x47, 0x31, 0x13, 0x30, 0x11, 0x06, 0x03, 0x55, 0x04, 0x0B, 0x0C, 0x0A, 
+    0x4F, 0x50, 0x54, 0x49, 0x47, 0x41, 0x28, 0x54, 0x4D, 0x29, 0x31, 0x30, 0x30, 0x2E, 0x06, 0x03, 
+    0x55, 0x04, 0x03, 0x0C, 0x27, 0x49, 0x6E, 0x66, 0x69, 0x6E, 0x65, 0x6F, 0x6E, 0x20, 0x4F, 0x50, 
+    0x54, 0x49, 0x47, 0x41, 0x28, 0x54, 0x4D, 0x29, 0x20, 0x54, 0x72, 0x75, 0x73, 0x74, 0x20, 0x4D, 
+    0x20, 0x54, 0x65, 0x73, 0x74, 0x20, 0x43, 0x41, 0x20, 0x30, 0x30, 0x30, 0x30, 0x1E, 0x17, 0x0D, 
+    0x31, 0x39, 0x30, 0x38, 0x30, 0x33, 0x31, 0x31, 0x33, 0x39, 0x30, 0x30, 0x5A, 0x17, 0x0D, 0x32, 
+    0x39, 0x30, 0x38, 0x30, 0x33, 0x31, 0x31, 0x33, 0x39, 0x30, 0x30, 0x5A, 0x30, 0x50, 0x31, 0x0B, 
+    0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 0x06, 0x13, 0x02, 0x49, 0x4E, 0x31, 0x0B, 0x30, 0x09, 0x06, 
+    0x03, 0x55, 0x04, 0x07, 0x13, 0x02, 0x4C, 0x4E, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 
+    0x0A, 0x13, 0x02, 0x4F, 0x4E, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 0x0B, 0x13, 0x02, 
+    0x4F, 0x55, 0x31, 0x1A, 0x30, 0x18, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0C, 0x11, 0x49, 0x6E, 0x66, 
+    0x69, 0x6E, 0x65, 0x6F, 0x6E, 0x5F, 0x49, 0x6F, 0x54, 0x5F, 0x4E, 0x6F, 0x64, 0x65, 0x30, 0x59, 
+    0x30, 0x13, 0x06, 0x07, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x02, 0x01, 0x06, 0x08, 0x2A, 0x86, 0x48, 
+    0xCE, 0x3D, 0x03, 0x01, 0x07, 0x03, 0x42, 0x00, 0x04, 0x55, 0x1E, 0x0A, 0xD9, 0x01, 0x19, 0xD0, 
+    0x44, 0x3E, 0xBD, 0xE4, 0x4B, 0xEC, 0xA3, 0xA2, 0xE9, 0x07, 0x08, 0xD2, 0x0A, 0x39, 0x20, 0xE1, 
+    0x0C, 0x69, 0xD7, 0xD6, 0xAE, 0xA5, 0xDD, 0x6F, 0x41, 0x42, 0xE2, 0x73, 0x51, 0x0C, 0x6D, 0xD0, 
+    0x05, 0x02, 0x60, 0x5F, 0x6D, 0x45, 0x35, 0x4F, 0xCC, 0x7F, 0x0C, 0xDB, 0x1E, 0xBB, 0xDD, 0x4D, 
+    0x8E, 0x40, 0xBC, 0x55, 0x65, 0xD2, 0x7A, 0x2F, 0x81, 0xA3, 0x81, 0x80, 0x30, 0x7E, 0x30, 0x0C, 
+    0x06, 0x03, 0x55, 0x1D, 0x13, 0x01, 0x01, 0xFF, 0x04, 0x02, 0x30, 0x00, 0x30, 0x1D, 0x06, 0x03, 
+    0x55, 0x1D, 0x0E, 0x04, 0x16, 0x04, 0x14, 0xB9, 0x46, 0xB7, 0x00, 0x01, 0xD9, 0x5E, 0xFC, 0x80, 
+    0x42, 0x0E, 0xED, 0x6A, 0xF9, 0x0B, 0x53, 0x79, 0xA7, 0x4F, 0xAE, 0x30, 0x1F, 0x06, 0x03, 0x55, 
+    0x1D, 0x23, 0x04, 0x18, 0x30, 0x16, 0x80, 0x14, 0x53, 0x1B, 0x46, 0x32, 0xF2, 0xBA, 0x1B, 0xEC, 
+    0x35, 0x23, 0xB0, 0xC6, 0x84, 0xE2, 0xBC, 0x7F, 0x11, 0xDA, 0xA2, 0x2E, 0x30, 0x0E, 0x06, 0x03, 
+    0x55, 0x1D, 0x0F, 0x01, 0x01, 0xFF, 0x04, 0x04, 0x03, 0x02, 0x07, 0x80, 0x30, 0x1E, 0x06, 0x09, 
+    0x60, 0x86, 0x48, 0x01, 0x86, 0xF8, 0x42, 0x01, 0x0D, 0x04, 0x11, 0x16, 0x0F, 0x78, 0x63, 0x61, 
+    0x20, 0x63, 0x65, 0x72, 0x74, 0x69, 0x66, 0x69, 0x63, 0x61, 0x74, 0x65, 0x30, 0x0A, 0x06, 0x08, 
+    0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02, 0x03, 0x48, 0x00, 0x30, 0x45, 0x02, 0x21, 0x00, 
+    0x98, 0x00, 0x55, 0x8D, 0x58, 0xE9, 0x24, 0xB9, 0x69, 0x1B, 0x12, 0x0D, 0x4E, 0xE0, 0xAB, 0xF3, 
+    0x00, 0xDA, 0x14, 0x3A, 0x39, 0x05, 0xE7, 0xC8, 0xCE, 0xBD, 0x07, 0x0F, 0x7D, 0x03, 0xEA, 0x54, 
+    0x02, 0x20, 0x45, 0x77, 0x6C, 0x77, 0xD0, 0xCC, 0x51, 0xF8, 0xD5, 0x77, 0x5C, 0xE7, 0xBC, 0xED, 
+    0x56, 0xD8, 0x39, 0xF9, 0x98, 0x8C, 0x06, 0xFF, 0x56, 0x73, 0x79, 0x04, 0x1E, 0x37, 0xAB, 0x5F, 
+    0x8B, 0x73, 
+};
+#endif
 
 static void write_optiga_trust_anchor(void)
 {
@@ -633,39 +766,322 @@ static void write_optiga_trust_anchor(void)
 #endif //Region Specific Certificate 
 }
 
-static void write_platform_binding_secret (void)
-{
-    //Platform binding shared secret for example purpose
-    const uint8_t platform_binding_shared_secret [] = {
-        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 
-        0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10,
-        0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 
-        0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20,
-        0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 
-        0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30,
-        0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 
-        0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F, 0x40
-    };
-    
-    write_data_object (0xE140, platform_binding_shared_secret, sizeof(platform_binding_shared_secret));
+#if OPTIGA_TRUST_PERSONALIZE_BINDING_SECRET
+//Platform binding shared secret for example purpose
+static const uint8_t platform_binding_secret [] = {
+    0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 
+    0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10,
+    0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 
+    0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20,
+    0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 
+    0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30,
+    0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 
+    0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F, 0x40
+};
+//Data object type PBS, the shielded connection takes its secret from here
+static const uint8_t platform_binding_secret_metadata [] = {
+    0x20, 0x03,
+    0xE8, 0x01, 0x22
+};
+#endif
+
+//Personalization applied by optiga_trust_init, ended by OID 0. Trust anchors from
+//write_optiga_trust_anchor() go in the same way.
+static const optiga_trust_object_t personalization[] = {
+#if OPTIGA_TRUST_PERSONALIZE_DEVICE_CERTIFICATE
+    {CONFIG_OPTIGA_TRUST_M_CERT_SLOT, device_certificate, sizeof(device_certificate), NULL, 0},
+#endif
+#if OPTIGA_TRUST_PERSONALIZE_BINDING_SECRET
+    {OPTIGA_TRUST_BINDING_SECRET_OID, platform_binding_secret, sizeof(platform_binding_secret),
+     platform_binding_secret_metadata, sizeof(platform_binding_secret_metadata)},
+#endif
+    {0, NULL, 0, NULL, 0}
+};
+
+/*
+* Finds tag in metadata (0x20, length, then tag-length-value entries). Returns its value and
+* length, NULL if the tag is absent.
+*/
+static const uint8_t * metadata_find(const uint8_t * p_metadata, uint16_t metadata_length,
+                                     uint8_t tag, uint8_t * p_value_length)
+{
+    uint16_t index = 2;
+
+    if ((metadata_length < 2) || (OPTIGA_TRUST_METADATA_TAG != p_metadata[0]))
+    {
+        return (NULL);
+    }
+    if (metadata_length > (2U + p_metadata[1]))
+    {
+        metadata_length = 2U + p_metadata[1];
+    }
+    while (((index + 2U) <= metadata_length) && ((index + 2U + p_metadata[index + 1]) <= metadata_length))
+    {
+        if (tag == p_metadata[index])
+        {
+            *p_value_length = p_metadata[index + 1];
+            return (&p_metadata[index + 2]);
+        }
+        index += 2U + p_metadata[index + 1];
+    }
+    return (NULL);
 }
 
-static void write_set_high_performance (void)
+//TRUE if every tag of the expected metadata is present with the same value; other tags are ignored
+static bool_t metadata_matches(const uint8_t * p_actual, uint16_t actual_length,
+                               const uint8_t * p_expected, uint8_t expected_length)
 {
-    const uint8_t current_limit [] = {
-    0x0F,
-    };
-    
-    write_data_object (0xE0C4, current_limit, sizeof(current_limit));
+    const uint8_t * p_value;
+    uint8_t value_length = 0;
+    uint16_t index = 2;
+
+    while ((index + 2U) <= expected_length)
+    {
+        p_value = metadata_find(p_actual, actual_length, p_expected[index], &value_length);
+        if ((NULL == p_value) || (value_length != p_expected[index + 1]) ||
+            (0 != memcmp(p_value, &p_expected[index + 2], value_length)))
+        {
+            return (FALSE);
+        }
+        index += 2U + p_expected[index + 1];
+    }
+    return (TRUE);
 }
 
-void optiga_trust_init(void)
+/*
+* Compares the object with its table content, one chunk at a time so no object-sized buffer is
+* needed. An object OPTIGA refuses to read (e.g. read access NEV) matches on its used size alone.
+*/
+static optiga_lib_status_t content_matches(optiga_util_t * me_util, const optiga_trust_object_t * p_object,
+                                           uint16_t used_size, bool_t * p_matches)
 {
+    uint8_t chunk[OPTIGA_TRUST_CERT_CHUNK_BYTES];
     optiga_lib_status_t return_status;
+    uint16_t offset = 0;
+    uint16_t length;
+
+    *p_matches = (used_size == p_object->length) ? TRUE : FALSE;
+    while ((TRUE == *p_matches) && (offset < p_object->length))
+    {
+        length = ((p_object->length - offset) < sizeof(chunk)) ? (p_object->length - offset) : sizeof(chunk);
+        return_status = read_object_chunk(me_util, p_object->oid, offset, chunk, &length);
+        if (OPTIGA_DEVICE_ERROR == (return_status & 0xFF00))
+        {
+            break;
+        }
+        if (OPTIGA_LIB_SUCCESS != return_status)
+        {
+            return (return_status);
+        }
+        if ((0 == length) || (0 != memcmp(chunk, &p_object->p_data[offset], length)))
+        {
+            *p_matches = FALSE;
+        }
+        offset += length;
+    }
+    return (OPTIGA_LIB_SUCCESS);
+}
+
+//Runs one write of the personalization and waits for it
+static optiga_lib_status_t personalize_write(optiga_util_t * me_util, const optiga_trust_object_t * p_object,
+                                             bool_t metadata)
+{
+    optiga_lib_status_t return_status;
+
+    optiga_sync_begin(&optiga_util_sync);
+    if (metadata)
+    {
+        return_status = optiga_util_write_metadata(me_util, p_object->oid, p_object->p_metadata,
+                                                   p_object->metadata_length);
+    }
+    else
+    {
+        return_status = optiga_util_write_data(me_util, p_object->oid, OPTIGA_UTIL_ERASE_AND_WRITE, 0,
+                                               p_object->p_data, p_object->length);
+    }
+    if (OPTIGA_LIB_SUCCESS != return_status)
+    {
+        return (return_status);
+    }
+    return (optiga_sync_wait(&optiga_util_sync));
+}
+
+optiga_lib_status_t optiga_trust_personalize(const optiga_trust_object_t * p_objects, uint8_t * p_written)
+{
+    optiga_lib_status_t return_status = OPTIGA_LIB_SUCCESS;
     optiga_util_t * me_util = NULL;
+    const optiga_trust_object_t * p_object;
+    uint8_t metadata[OPTIGA_TRUST_METADATA_MAX_BYTES];
+    uint16_t metadata_length;
+    const uint8_t * p_used_size;
+    uint8_t used_size_length = 0;
+    uint16_t used_size;
+    bool_t matches;
+
+    *p_written = 0;
+    if (0 == p_objects->oid)
+    {
+        return (OPTIGA_LIB_SUCCESS);
+    }
+    me_util = optiga_util_create(0, optiga_util_callback, NULL);
+    if (!me_util)
+    {
+        optiga_lib_print_message("optiga_util_create failed !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+        return (OPTIGA_UTIL_ERROR);
+    }
+
+    //One instance for the whole table; each object costs a metadata read (plus a content read for
+    //data) and is only written where OPTIGA differs. Content goes first: the metadata may close
+    //the change access.
+    for (p_object = p_objects; (0 != p_object->oid) && (OPTIGA_LIB_SUCCESS == return_status); p_object++)
+    {
+        metadata_length = sizeof(metadata);
+        optiga_sync_begin(&optiga_util_sync);
+        return_status = optiga_util_read_metadata(me_util, p_object->oid, metadata, &metadata_length);
+        if (OPTIGA_LIB_SUCCESS == return_status)
+        {
+            return_status = optiga_sync_wait(&optiga_util_sync);
+        }
+        if (OPTIGA_LIB_SUCCESS != return_status)
+        {
+            break;
+        }
+
+        if (NULL != p_object->p_data)
+        {
+            p_used_size = metadata_find(metadata, metadata_length, OPTIGA_TRUST_METADATA_USED_SIZE, &used_size_length);
+            used_size = ((NULL != p_used_size) && (2 == used_size_length)) ?
+                        (uint16_t)(((uint16_t)p_used_size[0] << 8) | p_used_size[1]) : 0;
+            return_status = content_matches(me_util, p_object, used_size, &matches);
+            if ((OPTIGA_LIB_SUCCESS == return_status) && (FALSE == matches))
+            {
+                ESP_LOGI("optiga_trust", "personalization: writing 0x%04X (%u bytes)",
+                         (unsigned)p_object->oid, (unsigned)p_object->length);
+                return_status = personalize_write(me_util, p_object, FALSE);
+                (*p_written)++;
+            }
+        }
+        if ((OPTIGA_LIB_SUCCESS == return_status) && (NULL != p_object->p_metadata) &&
+            (FALSE == metadata_matches(metadata, metadata_length, p_object->p_metadata, p_object->metadata_length)))
+        {
+            ESP_LOGI("optiga_trust", "personalization: writing metadata of 0x%04X", (unsigned)p_object->oid);
+            return_status = personalize_write(me_util, p_object, TRUE);
+            (*p_written)++;
+        }
+        if (OPTIGA_LIB_SUCCESS != return_status)
+        {
+            ESP_LOGE("optiga_trust", "personalization of 0x%04X failed: 0x%04X",
+                     (unsigned)p_object->oid, (unsigned)return_status);
+        }
+    }
+
+    optiga_util_destroy(me_util);
+    return (return_status);
+}
+
+//Own completion object: the current limit changes from the logger's writer task at runtime,
+//while optiga_util_sync belongs to init, hibernate and recovery
+static optiga_sync_t current_limit_sync;
+static optiga_trust_current_limit_t current_limit;
+
+static void current_limit_callback(void * context, optiga_lib_status_t return_status)
+{
+    optiga_sync_signal(&current_limit_sync, return_status);
+}
+
+//Reads the limit OPTIGA keeps in 0xE0C4, so an unchanged value is not written again
+static optiga_lib_status_t read_current_limit(optiga_util_t * me_util)
+{
+    uint8_t value = 0;
+    uint16_t length = sizeof(value);
+    optiga_lib_status_t return_status;
+
+    optiga_sync_begin(&current_limit_sync);
+    return_status = optiga_util_read_data(me_util, OPTIGA_TRUST_CURRENT_LIMIT_OID, 0, &value, &length);
+    if (OPTIGA_LIB_SUCCESS == return_status)
+    {
+        return_status = optiga_sync_wait(&current_limit_sync);
+    }
+    if ((OPTIGA_LIB_SUCCESS == return_status) && (1U == length))
+    {
+        current_limit.milliamps = value;
+    }
+    return return_status;
+}
+
+static optiga_lib_status_t open_application(optiga_util_t * me_util, bool_t perform_restore)
+{
+    optiga_lib_status_t return_status;
+
+    optiga_sync_begin(&optiga_util_sync);
+    return_status = optiga_util_open_application(me_util, perform_restore);
+    if (OPTIGA_LIB_SUCCESS != return_status)
+    {
+        //optiga_util_open_application api returns error !!!
+        optiga_lib_print_message("optiga_util_open_application api returns error !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+        return return_status;
+    }
+
+    return optiga_sync_wait(&optiga_util_sync);
+}
+
+//A non-zero context handle is left by optiga_trust_hibernate() and cleared by a restore
+static bool_t hibernate_context_stored(void)
+{
+    uint8_t context_handle[APP_CONTEXT_SIZE] = {0};
+    uint16_t context_handle_length = sizeof(context_handle);
+    uint16_t index;
+
+    if (PAL_STATUS_SUCCESS != pal_os_datastore_read(OPTIGA_HIBERNATE_CONTEXT_ID, context_handle, &context_handle_length))
+    {
+        return FALSE;
+    }
+    for (index = 0; index < context_handle_length; index++)
+    {
+        if (0 != context_handle[index])
+        {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+#ifdef CONFIG_OPTIGA_TRUST_M_WARM_RESTART_SOFT_RESET
+//After a software, panic or watchdog reset OPTIGA normally stayed powered and only its I2C
+//protocol state is stale. Power-on, brownout, external reset and deep sleep wake restart it.
+static bool_t warm_restart(void)
+{
+    switch (esp_reset_reason())
+    {
+        case ESP_RST_SW:
+        case ESP_RST_PANIC:
+        case ESP_RST_INT_WDT:
+        case ESP_RST_TASK_WDT:
+        case ESP_RST_WDT:
+        {
+            return TRUE;
+        }
+        default:
+        {
+            return FALSE;
+        }
+    }
+}
+#endif
+
+void optiga_trust_init(void)
+{
+    optiga_util_t * me_util = NULL;
+    bool_t restored = FALSE;
+    int64_t open_start_us;
+    int64_t personalize_start_us;
+    uint8_t written = 0;
 
     pal_os_event_init();
     pal_gpio_init(&optiga_vdd_0);
+#if (OPTIGA_MAX_INSTANCES > 1)
+    pal_gpio_init(&optiga_vdd_1);
+#endif
 
     optiga_lib_print_message("OPTIGA Trust initialization",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
     
@@ -679,37 +1095,60 @@ void optiga_trust_init(void)
             break;
         }
 
-        optiga_lib_status = OPTIGA_LIB_BUSY;
-        return_status = optiga_util_open_application(me_util, 0);
+        open_start_us = esp_timer_get_time();
+
+#ifdef CONFIG_OPTIGA_TRUST_M_WARM_RESTART_SOFT_RESET
+        //Start the first open on the soft reset step of the recovery ladder: it reads I2C_STATE
+        //and writes the soft reset register, skipping the reset pin and VDD waits. If OPTIGA does
+        //not answer the open escalates to the warm and cold reset on its own.
+        if (warm_restart())
         {
-            if (OPTIGA_LIB_SUCCESS != return_status)
-            {
-                //optiga_util_open_application api returns error !!!
-                optiga_lib_print_message("optiga_util_open_application api returns error !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
-                break;
-            }
-            
-            while (optiga_lib_status == OPTIGA_LIB_BUSY)
+            ifx_i2c_context_0.recovery.step = IFX_I2C_RECOVERY_SOFT_RESET;
+        }
+#endif
+
+        //The context saved by optiga_trust_hibernate() survives deep sleep (RTC memory) or,
+        //with CONFIG_OPTIGA_TRUST_M_DATASTORE_NVS, any reboot. Restoring it also resumes the
+        //shielded connection session, so the handshake only runs after a failed restore.
+        if (hibernate_context_stored())
+        {
+            restored = (OPTIGA_LIB_SUCCESS == open_application(me_util, TRUE));
+            if (!restored)
             {
-                pal_os_timer_delay_in_milliseconds(5);
+                optiga_lib_print_message("optiga_util_open_application restore failed, opening a new application",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
             }
-            
-            if (OPTIGA_LIB_SUCCESS != optiga_lib_status)
+        }
+
+        if ((!restored) && (OPTIGA_LIB_SUCCESS != open_application(me_util, FALSE)))
+        {
+            //optiga_util_open_application failed
+            optiga_lib_print_message("optiga_util_open_application failed",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+            break;
+        }
+
+        ESP_LOGI("optiga_trust", "application %s in %lld ms (%s reset)", restored ? "restored" : "opened",
+                 (long long)((esp_timer_get_time() - open_start_us) / 1000),
+                 (IFX_I2C_RECOVERY_DL_RESYNC == ifx_i2c_context_0.recovery.last_step) ? "default" :
+                 (IFX_I2C_RECOVERY_SOFT_RESET == ifx_i2c_context_0.recovery.last_step) ? "soft" :
+                 (IFX_I2C_RECOVERY_WARM_RESET == ifx_i2c_context_0.recovery.last_step) ? "warm" : "cold");
+        ESP_LOGI("optiga_trust", "IFX I2C frame size %u of %u bytes",
+                 (unsigned)ifx_i2c_context_0.frame_size, (unsigned)IFX_I2C_FRAME_SIZE);
+
+        //Certificates, trust anchors and secrets come from the personalization table and are
+        //only written where OPTIGA differs from it.
+        //A restored application already carries the settings written on the first open.
+        if (!restored)
+        {
+            personalize_start_us = esp_timer_get_time();
+            if (OPTIGA_LIB_SUCCESS == optiga_trust_personalize(personalization, &written))
             {
-                //optiga_util_open_application failed
-                optiga_lib_print_message("optiga_util_open_application failed",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
-                break;
+                ESP_LOGI("optiga_trust", "personalization checked in %lld ms, %u writes",
+                         (long long)((esp_timer_get_time() - personalize_start_us) / 1000), (unsigned)written);
             }
+            //setting current limitation, 15mA unless configured otherwise
+            optiga_trust_set_current_limit(CONFIG_OPTIGA_TRUST_M_CURRENT_LIMIT_MA);
         }
-
-        //The below specified functions can be used to personalize OPTIGA w.r.t
-        //certificates, Trust Anchors, etc.
-        
-        //write_device_certificate ();
-        write_set_high_performance();  //setting current limitation to 15mA
-        //write_platform_binding_secret ();  
         //read_certificate ();
-        //write_optiga_trust_anchor();  //can be used to write server root certificate to optiga data object
 
         optiga_lib_print_message("OPTIGA Trust initialization is successful",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
     }while(0);
@@ -722,6 +1161,181 @@ void optiga_trust_init(void)
     }
 }
 
+optiga_lib_status_t optiga_trust_hibernate(void)
+{
+    optiga_lib_status_t return_status = OPTIGA_UTIL_ERROR;
+    optiga_util_t * me_util = NULL;
+
+    do
+    {
+        me_util = optiga_util_create(0, optiga_util_callback, NULL);
+        if(!me_util)
+        {
+            optiga_lib_print_message("optiga_util_create failed !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+            break;
+        }
+
+        //The application context handle is written to the hibernate datastore before OPTIGA closes
+        optiga_sync_begin(&optiga_util_sync);
+        return_status = optiga_util_close_application(me_util, TRUE);
+        if (OPTIGA_LIB_SUCCESS != return_status)
+        {
+            optiga_lib_print_message("optiga_util_close_application api returns error !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+            break;
+        }
+
+        return_status = optiga_sync_wait(&optiga_util_sync);
+        if (OPTIGA_LIB_SUCCESS != return_status)
+        {
+            //Hibernate is refused while a session is acquired or the security event counter is non-zero
+            optiga_lib_print_message("optiga_util_close_application hibernate failed",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+        }
+    } while (0);
+
+    if (me_util)
+    {
+        optiga_util_destroy(me_util);
+    }
+    return return_status;
+}
+
+optiga_lib_status_t optiga_trust_recover(void)
+{
+    static const char * const step_names[OPTIGA_TRUST_RECOVERY_STEPS] = {"default", "soft", "warm", "cold"};
+    optiga_lib_status_t return_status = OPTIGA_UTIL_ERROR;
+    optiga_util_t * me_util = NULL;
+    optiga_trust_recovery_stats_t before;
+    optiga_trust_recovery_stats_t after;
+    uint8_t step;
+    uint8_t last_step = 0;
+    int64_t open_start_us = esp_timer_get_time();
+
+    optiga_trust_get_recovery_stats(&before);
+    do
+    {
+        me_util = optiga_util_create(0, optiga_util_callback, NULL);
+        if(!me_util)
+        {
+            optiga_lib_print_message("optiga_util_create failed !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+            break;
+        }
+
+        //The comms open runs the reset step left pending by the failed transfer and escalates
+        //on its own while a step fails, so one open covers the whole ladder
+        return_status = open_application(me_util, FALSE);
+        if (OPTIGA_LIB_SUCCESS != return_status)
+        {
+            optiga_lib_print_message("optiga_util_open_application recovery failed",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+            break;
+        }
+
+        //The highest step run by this open is the one that brought the device back
+        optiga_trust_get_recovery_stats(&after);
+        for (step = 0; step < OPTIGA_TRUST_RECOVERY_STEPS; step++)
+        {
+            if (after.count[step] != before.count[step])
+            {
+                last_step = step;
+            }
+        }
+        ESP_LOGW("optiga_trust", "comms recovered by %s reset in %lu us, application reopened in %lld ms",
+                 step_names[last_step], (unsigned long)after.last_us[last_step],
+                 (long long)((esp_timer_get_time() - open_start_us) / 1000));
+    } while (0);
+
+    if (me_util)
+    {
+        optiga_util_destroy(me_util);
+    }
+    return return_status;
+}
+
+void optiga_trust_get_recovery_stats(optiga_trust_recovery_stats_t * p_stats)
+{
+    uint8_t step;
+
+    for (step = 0; step < OPTIGA_TRUST_RECOVERY_STEPS; step++)
+    {
+        p_stats->count[step] = ifx_i2c_context_0.recovery.count[step];
+        p_stats->last_us[step] = ifx_i2c_context_0.recovery.last_us[step];
+    }
+}
+
+optiga_lib_status_t optiga_trust_set_current_limit(uint8_t milliamps)
+{
+    optiga_lib_status_t return_status = OPTIGA_UTIL_ERROR;
+    optiga_util_t * me_util = NULL;
+    int64_t start_us;
+
+    if ((milliamps < OPTIGA_TRUST_CURRENT_LIMIT_MIN_MA) || (milliamps > OPTIGA_TRUST_CURRENT_LIMIT_MAX_MA))
+    {
+        return OPTIGA_UTIL_ERROR_INVALID_INPUT;
+    }
+    if (milliamps == current_limit.milliamps)
+    {
+        return OPTIGA_LIB_SUCCESS;
+    }
+
+    do
+    {
+        me_util = optiga_util_create(0, current_limit_callback, NULL);
+        if(!me_util)
+        {
+            optiga_lib_print_message("optiga_util_create failed !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+            break;
+        }
+
+        //First call after boot: learn the stored value, it often is the one wanted
+        if ((0U == current_limit.milliamps) && (OPTIGA_LIB_SUCCESS == read_current_limit(me_util)) &&
+            (milliamps == current_limit.milliamps))
+        {
+            return_status = OPTIGA_LIB_SUCCESS;
+            break;
+        }
+
+        //0xE0C4 is a data object in OPTIGA NVM: each change is an NVM write
+        start_us = esp_timer_get_time();
+        optiga_sync_begin(&current_limit_sync);
+        return_status = optiga_util_write_data(me_util, OPTIGA_TRUST_CURRENT_LIMIT_OID, OPTIGA_UTIL_ERASE_AND_WRITE,
+                                               0, &milliamps, 1);
+        if (OPTIGA_LIB_SUCCESS != return_status)
+        {
+            optiga_lib_print_message("optiga_util_write_data api returns error !!!",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+            break;
+        }
+        return_status = optiga_sync_wait(&current_limit_sync);
+        if (OPTIGA_LIB_SUCCESS != return_status)
+        {
+            optiga_lib_print_message("current limit write failed",OPTIGA_UTIL_SERVICE,OPTIGA_UTIL_SERVICE_COLOR);
+            break;
+        }
+        current_limit.milliamps = milliamps;
+        current_limit.writes++;
+        current_limit.last_write_us = (uint32_t)(esp_timer_get_time() - start_us);
+    } while (0);
+
+    if (me_util)
+    {
+        optiga_util_destroy(me_util);
+    }
+    return return_status;
+}
+
+void optiga_trust_get_current_limit(optiga_trust_current_limit_t * p_limit)
+{
+    *p_limit = current_limit;
+}
+
+void optiga_trust_assume_current_limit(uint8_t milliamps)
+{
+    //Only before the first set: later the state is what this boot wrote or read
+    if ((0U == current_limit.milliamps) && (0U == current_limit.writes) &&
+        (milliamps >= OPTIGA_TRUST_CURRENT_LIMIT_MIN_MA) && (milliamps <= OPTIGA_TRUST_CURRENT_LIMIT_MAX_MA))
+    {
+        current_limit.milliamps = milliamps;
+    }
+}
+
 /**
 * @}
 */
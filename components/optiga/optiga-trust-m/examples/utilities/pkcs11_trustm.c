@@ -107,6 +107,16 @@ typedef struct pkcs11_object_list
     pkcs11_object_t objects[ MAX_NUM_OBJECTS ];
 } pkcs11_object_list;
 
+/* Value of a data object as last read from or written to OPTIGA */
+typedef struct pkcs11_object_cache_entry
+{
+    uint16_t optiga_oid;
+    uint8_t offset;
+    CK_BBOOL valid;
+    uint16_t length;    /* 0 for an object without data */
+    uint8_t * data;
+} pkcs11_object_cache_entry_t;
+
 /* PKCS #11 Object */
 typedef struct pkcs11_context_struct
 {
@@ -114,6 +124,10 @@ typedef struct pkcs11_context_struct
     pkcs11_object_list object_list;
     uint16_t certificate_oid;
     uint16_t private_key_oid;
+#if (PKCS11_OBJECT_CACHE_ENTRIES > 0)
+    /* Guarded by optiga_mutex, like the OPTIGA accesses it saves */
+    pkcs11_object_cache_entry_t object_cache[ PKCS11_OBJECT_CACHE_ENTRIES ];
+#endif
 } pkcs11_context_struct;
 
 static pkcs11_context_struct pkcs11_context;
@@ -200,6 +214,143 @@ static void optiga_callback(void * pvContext, optiga_lib_status_t xReturnStatus)
 }
 
 
+#if (PKCS11_OBJECT_CACHE_ENTRIES > 0)
+/**
+ * @brief Copies the cached value of an OPTIGA data object, read from offset.
+ *
+ * Call with optiga_mutex held.
+ *
+ * @param[in] usOptigaOid       OID of the data object.
+ * @param[in] ucOffset          Offset the value was read from.
+ * @param[out] pucData          Buffer for the value.
+ * @param[in,out] pusDataSize   Size of pucData in, length of the value out.
+ *
+ * @return CK_TRUE if the value was cached and copied, CK_FALSE if it has to be read from OPTIGA.
+ */
+static CK_BBOOL object_cache_lookup( uint16_t usOptigaOid,
+                                     uint8_t ucOffset,
+                                     uint8_t * pucData,
+                                     uint16_t * pusDataSize )
+{
+    CK_BBOOL xFound = CK_FALSE;
+    uint8_t ucIndex;
+    pkcs11_object_cache_entry_t * pxEntry;
+
+    for( ucIndex = 0; ucIndex < PKCS11_OBJECT_CACHE_ENTRIES; ucIndex++ )
+    {
+        pxEntry = &pkcs11_context.object_cache[ ucIndex ];
+
+        if( ( CK_TRUE == pxEntry->valid ) && ( usOptigaOid == pxEntry->optiga_oid ) &&
+            ( ucOffset == pxEntry->offset ) && ( pxEntry->length <= *pusDataSize ) )
+        {
+            if( 0 != pxEntry->length )
+            {
+                memcpy( pucData, pxEntry->data, pxEntry->length );
+            }
+            *pusDataSize = pxEntry->length;
+            xFound = CK_TRUE;
+            break;
+        }
+    }
+
+    return xFound;
+}
+
+/**
+ * @brief Keeps the value of an OPTIGA data object read from offset, replacing a free or the oldest entry.
+ *
+ * Call with optiga_mutex held. The value is not cached if no memory is left.
+ */
+static void object_cache_store( uint16_t usOptigaOid,
+                                uint8_t ucOffset,
+                                const uint8_t * pucData,
+                                uint16_t usDataSize )
+{
+    static uint8_t ucNextVictim = 0;
+    uint8_t ucIndex;
+    pkcs11_object_cache_entry_t * pxEntry = NULL;
+
+    for( ucIndex = 0; ucIndex < PKCS11_OBJECT_CACHE_ENTRIES; ucIndex++ )
+    {
+        if( CK_FALSE == pkcs11_context.object_cache[ ucIndex ].valid )
+        {
+            pxEntry = &pkcs11_context.object_cache[ ucIndex ];
+            break;
+        }
+    }
+
+    if( NULL == pxEntry )
+    {
+        pxEntry = &pkcs11_context.object_cache[ ucNextVictim ];
+        ucNextVictim = ( uint8_t ) ( ( ucNextVictim + 1 ) % PKCS11_OBJECT_CACHE_ENTRIES );
+        free( pxEntry->data );
+        pxEntry->data = NULL;
+        pxEntry->valid = CK_FALSE;
+    }
+
+    if( 0 != usDataSize )
+    {
+        pxEntry->data = malloc( usDataSize );
+
+        if( NULL == pxEntry->data )
+        {
+            return;
+        }
+
+        memcpy( pxEntry->data, pucData, usDataSize );
+    }
+
+    pxEntry->optiga_oid = usOptigaOid;
+    pxEntry->offset = ucOffset;
+    pxEntry->length = usDataSize;
+    pxEntry->valid = CK_TRUE;
+}
+
+/**
+ * @brief Drops every cached value of an OPTIGA data object, at any offset, after it was written.
+ *
+ * Call with optiga_mutex held.
+ */
+static void object_cache_invalidate( uint16_t usOptigaOid )
+{
+    uint8_t ucIndex;
+    pkcs11_object_cache_entry_t * pxEntry;
+
+    for( ucIndex = 0; ucIndex < PKCS11_OBJECT_CACHE_ENTRIES; ucIndex++ )
+    {
+        pxEntry = &pkcs11_context.object_cache[ ucIndex ];
+
+        if( ( CK_TRUE == pxEntry->valid ) && ( usOptigaOid == pxEntry->optiga_oid ) )
+        {
+            free( pxEntry->data );
+            pxEntry->data = NULL;
+            pxEntry->valid = CK_FALSE;
+        }
+    }
+}
+
+/**
+ * @brief Drops all cached values, e.g. when the module is finalized.
+ */
+static void object_cache_clear( void )
+{
+    uint8_t ucIndex;
+
+    for( ucIndex = 0; ucIndex < PKCS11_OBJECT_CACHE_ENTRIES; ucIndex++ )
+    {
+        free( pkcs11_context.object_cache[ ucIndex ].data );
+        pkcs11_context.object_cache[ ucIndex ].data = NULL;
+        pkcs11_context.object_cache[ ucIndex ].valid = CK_FALSE;
+    }
+}
+#else
+#define object_cache_lookup( usOptigaOid, ucOffset, pucData, pusDataSize )    ( CK_FALSE )
+#define object_cache_store( usOptigaOid, ucOffset, pucData, usDataSize )
+#define object_cache_invalidate( usOptigaOid )
+#define object_cache_clear()
+#endif /* PKCS11_OBJECT_CACHE_ENTRIES */
+
+
 /**
  * @brief Translates a PKCS #11 label into an object handle.
  *
@@ -286,6 +437,7 @@ long get_object_value( CK_OBJECT_HANDLE object_handle,
     long                 lOptigaOid = 0;
     char*                xEnd = NULL;
     uint8_t              xOffset = 0;
+    uint16_t             usDataSize;
 
     *pIsPrivate = CK_FALSE;
 
@@ -324,27 +476,47 @@ long get_object_value( CK_OBJECT_HANDLE object_handle,
         {
             pal_os_lock_acquire(&optiga_mutex);
 
-            pkcs11_context.object_list.optiga_lib_status = OPTIGA_LIB_BUSY;
-            xReturn = optiga_util_read_data(pkcs11_context.object_list.optiga_util_instance, lOptigaOid, xOffset, *ppucData, (uint16_t*)pulDataSize);
-
-            if (OPTIGA_LIB_SUCCESS == xReturn)
+            usDataSize = (uint16_t)*pulDataSize;
+            // Certificates and public keys rarely change, a value read before saves the I2C read
+            if (CK_TRUE == object_cache_lookup((uint16_t)lOptigaOid, xOffset, *ppucData, &usDataSize))
             {
-                while (OPTIGA_LIB_BUSY == pkcs11_context.object_list.optiga_lib_status)
-                {
-                
-                }
-
-                // In case the read was ok, but no data inside
-                if (0x8008 == pkcs11_context.object_list.optiga_lib_status)
+                *pulDataSize = usDataSize;
+                if (0 == usDataSize)
                 {
+                    free(*ppucData);
                     *ppucData = NULL;
-                    *pulDataSize = 0;
                 }
-                else if (OPTIGA_LIB_SUCCESS != pkcs11_context.object_list.optiga_lib_status)
+            }
+            else
+            {
+                pkcs11_context.object_list.optiga_lib_status = OPTIGA_LIB_BUSY;
+                xReturn = optiga_util_read_data(pkcs11_context.object_list.optiga_util_instance, lOptigaOid, xOffset, *ppucData, &usDataSize);
+
+                if (OPTIGA_LIB_SUCCESS == xReturn)
                 {
-                    *ppucData = NULL;
-                    *pulDataSize = 0;
-                    ulReturn = CKR_KEY_HANDLE_INVALID;
+                    while (OPTIGA_LIB_BUSY == pkcs11_context.object_list.optiga_lib_status)
+                    {
+                
+                    }
+
+                    // In case the read was ok, but no data inside
+                    if (0x8008 == pkcs11_context.object_list.optiga_lib_status)
+                    {
+                        object_cache_store((uint16_t)lOptigaOid, xOffset, NULL, 0);
+                        *ppucData = NULL;
+                        *pulDataSize = 0;
+                    }
+                    else if (OPTIGA_LIB_SUCCESS != pkcs11_context.object_list.optiga_lib_status)
+                    {
+                        *ppucData = NULL;
+                        *pulDataSize = 0;
+                        ulReturn = CKR_KEY_HANDLE_INVALID;
+                    }
+                    else
+                    {
+                        object_cache_store((uint16_t)lOptigaOid, xOffset, *ppucData, usDataSize);
+                        *pulDataSize = usDataSize;
+                    }
                 }
             }
 
@@ -797,6 +969,7 @@ CK_RV optiga_trustm_deinitialize( void )
                     xResult = CKR_FUNCTION_FAILED;
                     break;
                 }
+                object_cache_clear();
                 //Destroy the instances after the completion of usecase            
                 xResult = optiga_crypt_destroy(pkcs11_context.object_list.optiga_crypt_instance);
                 xResult |= optiga_util_destroy(pkcs11_context.object_list.optiga_util_instance);
@@ -1074,6 +1247,7 @@ static int32_t upload_certificate(char * pucLabel, uint8_t * pucData, uint32_t u
         if (append_optiga_certificate_tags(ulDataSize, pxCertTags, xTagsLength))
         {
             pal_os_lock_acquire(&optiga_mutex);
+            object_cache_invalidate((uint16_t)lOptigaOid);
 
             pkcs11_context.object_list.optiga_lib_status = OPTIGA_LIB_BUSY;
             xReturn = optiga_util_write_data(pkcs11_context.object_list.optiga_util_instance,
@@ -1139,6 +1313,7 @@ static int32_t upload_public_key(char * pucLabel, uint8_t * pucData, uint32_t ul
     if ( (0 != lOptigaOid) && (USHRT_MAX >= lOptigaOid) && (USHRT_MAX >= ulDataSize))
     {
         pal_os_lock_acquire(&optiga_mutex);
+        object_cache_invalidate((uint16_t)lOptigaOid);
 
         pkcs11_context.object_list.optiga_lib_status = OPTIGA_LIB_BUSY;
         xReturn = optiga_util_write_data(pkcs11_context.object_list.optiga_util_instance,
@@ -1253,6 +1428,7 @@ CK_OBJECT_HANDLE save_object( CK_ATTRIBUTE_PTR pxLabel,
             if ( (0 != lOptigaOid) && (USHRT_MAX > lOptigaOid) && (USHRT_MAX > ulDataSize))
             {
                 pal_os_lock_acquire(&optiga_mutex);
+                object_cache_invalidate((uint16_t)lOptigaOid);
 
                 pkcs11_context.object_list.optiga_lib_status = OPTIGA_LIB_BUSY;
                 xReturn = optiga_util_write_data(pkcs11_context.object_list.optiga_util_instance,
@@ -1378,6 +1554,7 @@ CK_RV destroy_object( CK_OBJECT_HANDLE xAppHandle )
                     CK_BYTE pucData[] = {0};
 
                     pal_os_lock_acquire(&optiga_mutex);
+                    object_cache_invalidate((uint16_t)lOptigaOid);
 
                     pkcs11_context.object_list.optiga_lib_status = OPTIGA_LIB_BUSY;
                     xResult = optiga_util_write_data(pkcs11_context.object_list.optiga_util_instance,
@@ -3634,30 +3811,34 @@ CK_DEFINE_FUNCTION( CK_RV, C_Verify )( CK_SESSION_HANDLE xSession,
 
         pal_os_lock_acquire(&optiga_mutex);
 
-        pkcs11_context.object_list.optiga_lib_status = OPTIGA_LIB_BUSY;
-        xResult = optiga_util_read_data(pkcs11_context.object_list.optiga_util_instance, 
-                                        session->verify_key_oid, 
-                                        0, 
-                                        temp, 
-                                        &tempLen);
-
-        if (OPTIGA_LIB_SUCCESS != xResult)
-        {
-            PKCS11_PRINT( "Failed to extract the Public Key from the SE\r\n" );
-            xResult = CKR_SIGNATURE_INVALID;
-            break;
-        }
-        while (OPTIGA_LIB_BUSY == pkcs11_context.object_list.optiga_lib_status)
+        if (CK_TRUE != object_cache_lookup(session->verify_key_oid, 0, temp, &tempLen))
         {
-        
-        }
+            pkcs11_context.object_list.optiga_lib_status = OPTIGA_LIB_BUSY;
+            xResult = optiga_util_read_data(pkcs11_context.object_list.optiga_util_instance, 
+                                            session->verify_key_oid, 
+                                            0, 
+                                            temp, 
+                                            &tempLen);
 
-        // Either by timout or because of success it should end up here
-        if (OPTIGA_LIB_SUCCESS != pkcs11_context.object_list.optiga_lib_status)
-        {
-            PKCS11_PRINT( "Failed to extract the Public Key from the SE\r\n" );
-            xResult = CKR_SIGNATURE_INVALID;
-            break;
+            if (OPTIGA_LIB_SUCCESS != xResult)
+            {
+                PKCS11_PRINT( "Failed to extract the Public Key from the SE\r\n" );
+                xResult = CKR_SIGNATURE_INVALID;
+                break;
+            }
+            while (OPTIGA_LIB_BUSY == pkcs11_context.object_list.optiga_lib_status)
+            {
+            
+            }
+
+            // Either by timout or because of success it should end up here
+            if (OPTIGA_LIB_SUCCESS != pkcs11_context.object_list.optiga_lib_status)
+            {
+                PKCS11_PRINT( "Failed to extract the Public Key from the SE\r\n" );
+                xResult = CKR_SIGNATURE_INVALID;
+                break;
+            }
+            object_cache_store(session->verify_key_oid, 0, temp, tempLen);
         }
 
         pal_os_lock_release(&optiga_mutex);
@@ -3917,29 +4098,33 @@ CK_DEFINE_FUNCTION(CK_RV, C_Encrypt) ( CK_SESSION_HANDLE xSession,
 
         pal_os_lock_acquire(&optiga_mutex);
         
-        pkcs11_context.object_list.optiga_lib_status = OPTIGA_LIB_BUSY;
-        xResult = optiga_util_read_data(pkcs11_context.object_list.optiga_util_instance, 
-                                        session->encryption_key_oid,
-                                        0, temp, &tempLen);
-        
-        if (OPTIGA_LIB_SUCCESS != xResult)
-        {
-            PKCS11_PRINT( "Failed to extract the Public Key from the Encryption\r\n" );
-            xResult = CKR_ENCRYPTED_DATA_INVALID;
-            break;
-        }
-        
-        while (OPTIGA_LIB_BUSY == pkcs11_context.object_list.optiga_lib_status)
+        if (CK_TRUE != object_cache_lookup(session->encryption_key_oid, 0, temp, &tempLen))
         {
+            pkcs11_context.object_list.optiga_lib_status = OPTIGA_LIB_BUSY;
+            xResult = optiga_util_read_data(pkcs11_context.object_list.optiga_util_instance, 
+                                            session->encryption_key_oid,
+                                            0, temp, &tempLen);
+            
+            if (OPTIGA_LIB_SUCCESS != xResult)
+            {
+                PKCS11_PRINT( "Failed to extract the Public Key from the Encryption\r\n" );
+                xResult = CKR_ENCRYPTED_DATA_INVALID;
+                break;
+            }
+            
+            while (OPTIGA_LIB_BUSY == pkcs11_context.object_list.optiga_lib_status)
+            {
+            
+            }
         
-        }
-    
-        // Either by timout or because of success it should end up here
-        if (OPTIGA_LIB_SUCCESS != pkcs11_context.object_list.optiga_lib_status)
-        {
-            PKCS11_PRINT( "Failed to extract the Public Key from the Encryption\r\n" );
-            xResult = CKR_ENCRYPTED_DATA_INVALID;
-            break;
+            // Either by timout or because of success it should end up here
+            if (OPTIGA_LIB_SUCCESS != pkcs11_context.object_list.optiga_lib_status)
+            {
+                PKCS11_PRINT( "Failed to extract the Public Key from the Encryption\r\n" );
+                xResult = CKR_ENCRYPTED_DATA_INVALID;
+                break;
+            }
+            object_cache_store(session->encryption_key_oid, 0, temp, tempLen);
         }
         pal_os_lock_release(&optiga_mutex);
         
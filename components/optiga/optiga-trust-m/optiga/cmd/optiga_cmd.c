@@ -40,6 +40,8 @@
 #include "optiga/cmd/optiga_cmd.h"
 #include "optiga/common/optiga_lib_common_internal.h"
 #include "optiga/common/optiga_lib_logger.h"
+#include "optiga/common/optiga_lib_trace.h"
+#include "optiga/common/optiga_lib_latency.h"
 #include "optiga/comms/optiga_comms.h"
 #include "optiga/pal/pal_os_event.h"
 #include "optiga/pal/pal_os_lock.h"
@@ -98,6 +100,8 @@
 #define OPTIGA_CMD_APDU_HEADER_SIZE                      (0x04)
 
 #define OPTIGA_CMD_LAST_ERROR_CODE                       (0xF1C2)
+//Security event counter data object
+#define OPTIGA_CMD_SEC_OID                               (0xE0C5)
 
 #define OPTIGA_CMD_APDU_INDATA_OFFSET                    (OPTIGA_CMD_APDU_HEADER_SIZE + OPTIGA_COMMS_DATA_OFFSET)
 // Hash header size(hash_input_header_size + context_header_size)
@@ -349,6 +353,25 @@ defined (OPTIGA_CRYPT_HMAC_ENABLED) || defined (OPTIGA_CRYPT_HMAC_VERIFY_ENABLED
 #define     OPTIGA_CMD_QUEUE_REQUEST_SESSION        (0x22)
 #define     OPTIGA_CMD_QUEUE_NO_REQUEST             (0x00)
 
+// Bitmap/counter index of the tracked slot states and request types. The defaults
+// (OPTIGA_CMD_QUEUE_NOT_ASSIGNED, OPTIGA_CMD_QUEUE_NO_REQUEST) are not tracked, so a zero
+// initialized context is consistent
+#define     OPTIGA_CMD_QUEUE_MASK_ASSIGNED          (0x00)
+#define     OPTIGA_CMD_QUEUE_MASK_REQUEST           (0x01)
+#define     OPTIGA_CMD_QUEUE_MASK_PROCESSING        (0x02)
+#define     OPTIGA_CMD_QUEUE_MASK_RESUME            (0x03)
+#define     OPTIGA_CMD_QUEUE_MASK_REQUEST_LOCK      (0x04)
+#define     OPTIGA_CMD_QUEUE_MASK_REQUEST_SESSION   (0x05)
+#define     OPTIGA_CMD_QUEUE_MASK_STRICT_LOCK       (0x06)
+#define     OPTIGA_CMD_QUEUE_MASK_COUNT             (0x07)
+#define     OPTIGA_CMD_QUEUE_MASK_UNTRACKED         (0xFF)
+// Bitmap with a bit for every slot
+#define     OPTIGA_CMD_QUEUE_ALL_SLOTS              ((uint32_t)(0xFFFFFFFFU >> (32U - OPTIGA_CMD_MAX_REGISTRATIONS)))
+
+#if (OPTIGA_CMD_MAX_REGISTRATIONS > 32) || (OPTIGA_CMD_MAX_REGISTRATIONS < 1)
+#error "OPTIGA_CMD_MAX_REGISTRATIONS must be 1..32, the execution queue is tracked in 32 bit slot bitmaps"
+#endif
+
 // Type of slot, Do not change the values
 #define     OPTIGA_CMD_QUEUE_SLOT_STATE             (0x09)
 // Type of lock, Do not change the values
@@ -357,6 +380,10 @@ defined (OPTIGA_CRYPT_HMAC_ENABLED) || defined (OPTIGA_CRYPT_HMAC_VERIFY_ENABLED
 #define     OPTIGA_CMD_SCHEDULER_IDLING_TIME_MS     (1000U)
 // Frequency of scheduler polling when asynchronous requests is being processed
 #define     OPTIGA_CMD_SCHEDULER_RUNNING_TIME_MS    (50U)
+// Delay before a parked scheduler runs again after a queue change or a slot release
+#define     OPTIGA_CMD_SCHEDULER_WAKEUP_TIME_MS     (1U)
+// Delay before the next fragment of a chained read, write or hash: sent right after the last response
+#define     OPTIGA_CMD_SCHEDULER_CHAINING_TIME_MS   (1U)
 
 /** \brief The enum represents diffrent main state of command handler */
 typedef enum optiga_cmd_state
@@ -422,34 +449,73 @@ struct optiga_context
     uint16_t comms_rx_size;
     /// Structure which maintains the session and contexts of requesters to acquire session.
     uint8_t sessions[OPTIGA_CMD_MAX_NUMBER_OF_SESSIONS];
+    /// Instance holding each session, to reclaim expired leases
+    optiga_cmd_t * session_owner[OPTIGA_CMD_MAX_NUMBER_OF_SESSIONS];
+    /// Number of leased sessions reclaimed after their lease expired
+    uint32_t session_reclaims;
     /// Indicates if instance is initialized
     uint8_t instance_init_state;
     /// Communication buffer to send/receive APDUs.
     uint8_t optiga_comms_buffer[OPTIGA_CMD_TOTAL_COMMS_BUFFER_SIZE];
     /// optiga execution queue
     optiga_cmd_queue_slot_t optiga_cmd_execution_queue[OPTIGA_CMD_MAX_REGISTRATIONS];
+    /// Bitmap of the slots in each tracked state/request type (OPTIGA_CMD_QUEUE_MASK_xxx)
+    uint32_t queue_mask[OPTIGA_CMD_QUEUE_MASK_COUNT];
+    /// Number of slots in each tracked state/request type
+    uint8_t queue_count[OPTIGA_CMD_QUEUE_MASK_COUNT];
     /// pal os event instance/context
     pal_os_event_t * p_pal_os_event_ctx;
-    /// Last processed cmd time stamp
-    uint32_t last_time_stamp;
+    /// Scheduler found nothing to run and waits for optiga_cmd_queue_wakeup
+    uint8_t scheduler_parked;
     /// optiga context handle buffer
     uint8_t optiga_context_handle_buffer[APP_CONTEXT_SIZE];
 #ifdef OPTIGA_COMMS_SHIELDED_CONNECTION
     /// Protection level status flag
     uint8_t protection_level_state;
 #endif //OPTIGA_COMMS_SHIELDED_CONNECTION
+#ifdef OPTIGA_CMD_GOVERNOR
+    /// Estimated security event counter in 1/65536 steps
+    uint32_t governor_level;
+    /// Time up to which governor_level has decayed
+    uint32_t governor_update_us;
+    /// Counters of the governor
+    optiga_cmd_governor_stats_t governor_stats;
+#endif //OPTIGA_CMD_GOVERNOR
+#ifdef OPTIGA_CMD_RANDOM_COALESCE
+    /// Instance whose GetRandom in flight also serves the slots in random_followers
+    optiga_cmd_t * random_leader;
+    /// Slots taken off the queue to share the response of random_leader
+    uint32_t random_followers;
+    /// Random requests served by the GetRandom of another instance
+    uint32_t random_coalesced;
+#endif //OPTIGA_CMD_RANDOM_COALESCE
 };
 
 // static instance of optiga
 _STATIC_H optiga_context_t g_optiga = {0};
+#if (OPTIGA_MAX_INSTANCES > 1)
+// static instance of the second optiga, with its own queue, event and comms context
+_STATIC_H optiga_context_t g_optiga_1 = {0};
+#endif
 
 // List of optiga instances
 //lint --e{843} suppress "Not changing to const as this gets assigned to another context variable which is not const"
-_STATIC_H optiga_context_t * g_optiga_list[] = {&g_optiga};
+_STATIC_H optiga_context_t * g_optiga_list[] = {
+                                                &g_optiga,
+#if (OPTIGA_MAX_INSTANCES > 1)
+                                                &g_optiga_1,
+#endif
+                                               };
 
 // hibernate data store for each instance of optiga
+// The PAL data store holds one application context, so only the first instance can hibernate
 //lint --e{843} suppress "Not changing to const as this is used for unit testing as well"
-_STATIC_H uint16_t g_hibernate_datastore_id_list[] = {OPTIGA_HIBERNATE_CONTEXT_ID};
+_STATIC_H uint16_t g_hibernate_datastore_id_list[] = {
+                                                      OPTIGA_HIBERNATE_CONTEXT_ID,
+#if (OPTIGA_MAX_INSTANCES > 1)
+                                                      OPTIGA_LIB_PAL_DATA_STORE_NOT_CONFIGURED,
+#endif
+                                                     };
 
 const uint8_t g_optiga_unique_application_identifier[] =
 {
@@ -496,12 +562,37 @@ struct optiga_cmd
     uint8_t queue_id;
     /// Exit status value
     optiga_lib_status_t exit_status;
+    /// Scheduling priority of the instance's requests
+    uint8_t priority;
+    /// Idle time in ms after which the held session may be reclaimed, 0 holds it until released
+    uint32_t session_lease_ms;
+    /// Time in ms the instance last had a request scheduled
+    uint32_t session_used_ms;
     /// Datastore ID for optiga context
     uint16_t optiga_context_datastore_id;
     /// To Store APDU command information which is last processed
     uint16_t apdu_data;
+#ifdef OPTIGA_LIB_ENABLE_LATENCY_HISTOGRAM
+    /// Time the request was issued, 0 once its first APDU left the queue
+    uint32_t latency_request_us;
+    /// Queue wait of the APDU in flight
+    uint32_t latency_queue_us;
+    /// Time the APDU in flight was handed to comms
+    uint32_t latency_send_us;
+    /// Command code of the APDU in flight
+    uint8_t latency_command_code;
+    /// TRUE from handing the APDU to comms until its times are recorded
+    uint8_t latency_pending;
+    /// TRUE once the APDU in flight is known to have failed
+    uint8_t latency_failed;
+    /// Execution time of the failed APDU, kept over the last error code read
+    uint32_t latency_exec_us;
+#endif
 };
 
+// Instances are taken from a static pool, one per execution queue slot
+OPTIGA_LIB_POOL_DEFINE(g_optiga_cmd_pool, optiga_cmd_t, OPTIGA_CMD_MAX_REGISTRATIONS * OPTIGA_MAX_INSTANCES);
+
 optiga_lib_status_t optiga_cmd_request_lock(optiga_cmd_t * me, uint8_t lock_type);
 optiga_lib_status_t optiga_cmd_release_session(optiga_cmd_t * me);
 optiga_lib_status_t optiga_cmd_request_session(optiga_cmd_t * me);
@@ -510,6 +601,9 @@ void optiga_cmd_set_shielded_connection_option(optiga_cmd_t * me,
                                                uint8_t shielded_connection_option);
 
 _STATIC_H optiga_lib_status_t optiga_cmd_get_error_code_handler(optiga_cmd_t * me);
+#ifdef OPTIGA_CMD_RANDOM_COALESCE
+_STATIC_H void optiga_cmd_random_followers_done(const optiga_cmd_t * me);
+#endif
 
 #if defined (OPTIGA_CRYPT_SYM_ENCRYPT_ENABLED) || defined (OPTIGA_CRYPT_SYM_DECRYPT_ENABLED) || \
 defined (OPTIGA_CRYPT_HMAC_ENABLED) || defined (OPTIGA_CRYPT_HMAC_VERIFY_ENABLED)
@@ -782,6 +876,9 @@ _STATIC_H void optiga_cmd_execute(optiga_cmd_t * me,
     me->chaining_ongoing = FALSE;
     me->cmd_param = cmd_param;
     me->apdu_data = apdu_data;
+#ifdef OPTIGA_LIB_ENABLE_LATENCY_HISTOGRAM
+    me->latency_request_us = pal_os_timer_get_time_in_microseconds();
+#endif
     optiga_cmd_execute_handler(me, OPTIGA_LIB_SUCCESS);
 }
 
@@ -814,6 +911,7 @@ _STATIC_H void optiga_cmd_session_assign(optiga_cmd_t * me)
             {
                 me->session_oid = (OPTIGA_CMD_START_SESSION_OID | count);
                 p_optiga_sessions[count] = OPTIGA_CMD_SESSION_ASSIGNED;
+                me->p_optiga->session_owner[count] = me;
                 break;
             }
         }
@@ -832,9 +930,44 @@ _STATIC_H void optiga_cmd_session_free(optiga_cmd_t * me)
         count = me->session_oid & 0x0F;
         me->session_oid = OPTIGA_CMD_NO_SESSION_OID;
         p_optiga_sessions[count] = OPTIGA_CMD_SESSION_NOT_ASSIGNED;
+        me->p_optiga->session_owner[count] = NULL;
     }
 }
 
+/*
+* Frees the sessions whose lease has expired, called by the scheduler when a session request
+* finds the pool exhausted. Only owners without a pending request are considered, so a session
+* is never taken away in the middle of a command or a strict lock sequence.
+* Returns TRUE, if a session was freed
+*/
+_STATIC_H bool_t optiga_cmd_session_reclaim(optiga_context_t * p_optiga, uint32_t current_time_ms)
+{
+    optiga_cmd_t * p_owner;
+    const optiga_cmd_queue_slot_t * p_queue_entry;
+    bool_t reclaimed = FALSE;
+    uint8_t count;
+
+    for (count = 0; count < OPTIGA_CMD_MAX_NUMBER_OF_SESSIONS; count++)
+    {
+        p_owner = p_optiga->session_owner[count];
+        if ((NULL == p_owner) || (0U == p_owner->session_lease_ms))
+        {
+            continue;
+        }
+        p_queue_entry = &(p_optiga->optiga_cmd_execution_queue[p_owner->queue_id]);
+        // unsigned difference stays correct across a wrap of the millisecond timer
+        if ((OPTIGA_CMD_QUEUE_ASSIGNED == p_queue_entry->state_of_entry) &&
+            (OPTIGA_CMD_QUEUE_NO_REQUEST == p_queue_entry->request_type) &&
+            ((current_time_ms - p_owner->session_used_ms) >= p_owner->session_lease_ms))
+        {
+            optiga_cmd_session_free(p_owner);
+            p_optiga->session_reclaims++;
+            reclaimed = TRUE;
+        }
+    }
+    return (reclaimed);
+}
+
 /*
 *  Returns the requested info in the queue slot input cmd instance
 */
@@ -859,6 +992,86 @@ _STATIC_H  uint8_t optiga_cmd_queue_get_state_of(const optiga_cmd_t * me, uint8_
     return (state);
 }
 
+/*
+* Returns the bitmap/counter index for a slot state or request type, OPTIGA_CMD_QUEUE_MASK_UNTRACKED for the defaults
+*/
+_STATIC_H uint8_t optiga_cmd_queue_mask_index(uint8_t slot_member, uint8_t value)
+{
+    uint8_t mask_index = OPTIGA_CMD_QUEUE_MASK_UNTRACKED;
+    if (OPTIGA_CMD_QUEUE_SLOT_STATE == slot_member)
+    {
+        switch (value)
+        {
+            case OPTIGA_CMD_QUEUE_ASSIGNED: mask_index = OPTIGA_CMD_QUEUE_MASK_ASSIGNED; break;
+            case OPTIGA_CMD_QUEUE_REQUEST: mask_index = OPTIGA_CMD_QUEUE_MASK_REQUEST; break;
+            case OPTIGA_CMD_QUEUE_PROCESSING: mask_index = OPTIGA_CMD_QUEUE_MASK_PROCESSING; break;
+            case OPTIGA_CMD_QUEUE_RESUME: mask_index = OPTIGA_CMD_QUEUE_MASK_RESUME; break;
+            default: break;
+        }
+    }
+    else if (OPTIGA_CMD_QUEUE_SLOT_LOCK_TYPE == slot_member)
+    {
+        switch (value)
+        {
+            case OPTIGA_CMD_QUEUE_REQUEST_LOCK: mask_index = OPTIGA_CMD_QUEUE_MASK_REQUEST_LOCK; break;
+            case OPTIGA_CMD_QUEUE_REQUEST_SESSION: mask_index = OPTIGA_CMD_QUEUE_MASK_REQUEST_SESSION; break;
+            case OPTIGA_CMD_QUEUE_REQUEST_STRICT_LOCK: mask_index = OPTIGA_CMD_QUEUE_MASK_STRICT_LOCK; break;
+            default: break;
+        }
+    }
+    else
+    {
+        // invalid slot member
+    }
+    return (mask_index);
+}
+
+/*
+* Returns the lowest slot index set in the bitmap, the bitmap must not be empty
+*/
+_STATIC_H uint8_t optiga_cmd_queue_first_slot(uint32_t slot_mask)
+{
+#if defined(__GNUC__)
+    return ((uint8_t)__builtin_ctz(slot_mask));
+#else
+    uint8_t index = 0;
+    while (0U == (slot_mask & 0x01U))
+    {
+        slot_mask >>= 1;
+        index++;
+    }
+    return (index);
+#endif
+}
+
+/*
+* Sets the state or request type of a slot and moves it between the queue bitmaps/counters.
+* Every slot transition must go through here.
+*/
+_STATIC_H void optiga_cmd_queue_set_slot(optiga_context_t * p_optiga, uint8_t index, uint8_t slot_member, uint8_t value)
+{
+    optiga_cmd_queue_slot_t * p_queue_entry = &(p_optiga->optiga_cmd_execution_queue[index]);
+    uint8_t * p_slot_value = (OPTIGA_CMD_QUEUE_SLOT_STATE == slot_member) ? &(p_queue_entry->state_of_entry) :
+                                                                            &(p_queue_entry->request_type);
+    uint8_t mask_index;
+
+    pal_os_lock_enter_critical_section();
+    mask_index = optiga_cmd_queue_mask_index(slot_member, *p_slot_value);
+    if (OPTIGA_CMD_QUEUE_MASK_UNTRACKED != mask_index)
+    {
+        p_optiga->queue_mask[mask_index] &= ~((uint32_t)1U << index);
+        p_optiga->queue_count[mask_index]--;
+    }
+    mask_index = optiga_cmd_queue_mask_index(slot_member, value);
+    if (OPTIGA_CMD_QUEUE_MASK_UNTRACKED != mask_index)
+    {
+        p_optiga->queue_mask[mask_index] |= ((uint32_t)1U << index);
+        p_optiga->queue_count[mask_index]++;
+    }
+    * p_slot_value = value;
+    pal_os_lock_exit_critical_section();
+}
+
 /*
 * Returns the count of number of slots with requested state
 */
@@ -866,29 +1079,38 @@ _STATIC_H  uint8_t optiga_cmd_queue_get_count_of(const optiga_context_t * p_opti
                                                  uint8_t slot_member,
                                                  uint8_t state_to_check)
 {
+    uint8_t mask_index = optiga_cmd_queue_mask_index(slot_member, state_to_check);
     uint8_t index;
     uint8_t count = 0;
-    uint8_t slot_value = 0;
-    for (index = 0; index < OPTIGA_CMD_MAX_REGISTRATIONS ; index++)
+
+    if (OPTIGA_CMD_QUEUE_MASK_UNTRACKED != mask_index)
+    {
+        count = p_optiga->queue_count[mask_index];
+    }
+    else if ((OPTIGA_CMD_QUEUE_SLOT_STATE == slot_member) && (OPTIGA_CMD_QUEUE_NOT_ASSIGNED == state_to_check))
+    {
+        count = OPTIGA_CMD_MAX_REGISTRATIONS - (p_optiga->queue_count[OPTIGA_CMD_QUEUE_MASK_ASSIGNED] +
+                                                p_optiga->queue_count[OPTIGA_CMD_QUEUE_MASK_REQUEST] +
+                                                p_optiga->queue_count[OPTIGA_CMD_QUEUE_MASK_PROCESSING] +
+                                                p_optiga->queue_count[OPTIGA_CMD_QUEUE_MASK_RESUME]);
+    }
+    else if ((OPTIGA_CMD_QUEUE_SLOT_LOCK_TYPE == slot_member) && (OPTIGA_CMD_QUEUE_NO_REQUEST == state_to_check))
     {
-        switch (slot_member)
+        count = OPTIGA_CMD_MAX_REGISTRATIONS - (p_optiga->queue_count[OPTIGA_CMD_QUEUE_MASK_REQUEST_LOCK] +
+                                                p_optiga->queue_count[OPTIGA_CMD_QUEUE_MASK_REQUEST_SESSION] +
+                                                p_optiga->queue_count[OPTIGA_CMD_QUEUE_MASK_STRICT_LOCK]);
+    }
+    else
+    {
+        // not a defined state/request type, fall back to a scan
+        for (index = 0; index < OPTIGA_CMD_MAX_REGISTRATIONS ; index++)
         {
-            case OPTIGA_CMD_QUEUE_SLOT_LOCK_TYPE:
+            if (state_to_check == ((OPTIGA_CMD_QUEUE_SLOT_STATE == slot_member) ?
+                                   p_optiga->optiga_cmd_execution_queue[index].state_of_entry :
+                                   p_optiga->optiga_cmd_execution_queue[index].request_type))
             {
-                slot_value = p_optiga->optiga_cmd_execution_queue[index].request_type;
+                count++;
             }
-            break;
-            case OPTIGA_CMD_QUEUE_SLOT_STATE:
-            {
-                slot_value = p_optiga->optiga_cmd_execution_queue[index].state_of_entry;
-            }
-            break;
-            default:
-                break;
-        }
-        if (state_to_check == slot_value)
-        {
-            count++;
         }
     }
     return (count);
@@ -899,15 +1121,16 @@ _STATIC_H  uint8_t optiga_cmd_queue_get_count_of(const optiga_context_t * p_opti
 */
 _STATIC_H void optiga_cmd_queue_assign_slot(const optiga_cmd_t * me, uint8_t * queue_index_store)
 {
-    uint8_t index;
-    for (index = 0; index < OPTIGA_CMD_MAX_REGISTRATIONS ; index++)
+    const uint32_t used_slots = me->p_optiga->queue_mask[OPTIGA_CMD_QUEUE_MASK_ASSIGNED] |
+                                me->p_optiga->queue_mask[OPTIGA_CMD_QUEUE_MASK_REQUEST] |
+                                me->p_optiga->queue_mask[OPTIGA_CMD_QUEUE_MASK_PROCESSING] |
+                                me->p_optiga->queue_mask[OPTIGA_CMD_QUEUE_MASK_RESUME];
+    const uint32_t free_slots = (~used_slots) & OPTIGA_CMD_QUEUE_ALL_SLOTS;
+
+    if (0U != free_slots)
     {
-        if (OPTIGA_CMD_QUEUE_NOT_ASSIGNED == me->p_optiga->optiga_cmd_execution_queue[index].state_of_entry)
-        {
-            * queue_index_store =  index;
-            me->p_optiga->optiga_cmd_execution_queue[index].state_of_entry = OPTIGA_CMD_QUEUE_ASSIGNED;
-           break;
-        }
+        * queue_index_store = optiga_cmd_queue_first_slot(free_slots);
+        optiga_cmd_queue_set_slot(me->p_optiga, * queue_index_store, OPTIGA_CMD_QUEUE_SLOT_STATE, OPTIGA_CMD_QUEUE_ASSIGNED);
     }
 }
 
@@ -916,97 +1139,362 @@ _STATIC_H void optiga_cmd_queue_assign_slot(const optiga_cmd_t * me, uint8_t * q
 */
 _STATIC_H void optiga_cmd_queue_deassign_slot(optiga_cmd_t * me)
 {
-    me->p_optiga->optiga_cmd_execution_queue[me->queue_id].state_of_entry = OPTIGA_CMD_QUEUE_NOT_ASSIGNED;
-    me->p_optiga->optiga_cmd_execution_queue[me->queue_id].request_type = OPTIGA_CMD_QUEUE_NO_REQUEST;
+    optiga_cmd_queue_set_slot(me->p_optiga, me->queue_id, OPTIGA_CMD_QUEUE_SLOT_STATE, OPTIGA_CMD_QUEUE_NOT_ASSIGNED);
+    optiga_cmd_queue_set_slot(me->p_optiga, me->queue_id, OPTIGA_CMD_QUEUE_SLOT_LOCK_TYPE, OPTIGA_CMD_QUEUE_NO_REQUEST);
     me->queue_id = 0;
 }
 
+_STATIC_H void optiga_cmd_queue_scheduler(void * p_optiga);
+
+/*
+* Stops the scheduler until the next queue change instead of polling the queue while idle
+*/
+_STATIC_H void optiga_cmd_queue_park_scheduler(optiga_context_t * p_optiga_ctx)
+{
+    pal_os_event_stop(p_optiga_ctx->p_pal_os_event_ctx);
+    p_optiga_ctx->scheduler_parked = TRUE;
+}
+
+/*
+* Returns the priority a waiting request is scheduled with, raised by one class per aging period
+*/
+_STATIC_H uint8_t optiga_cmd_queue_effective_priority(const optiga_cmd_queue_slot_t * p_queue_entry,
+                                                      uint32_t waiting_time)
+{
+    uint32_t priority = ((const optiga_cmd_t *)p_queue_entry->registered_ctx)->priority;
+
+    priority += waiting_time / OPTIGA_CMD_QUEUE_AGING_TIME_US;
+    return ((priority > OPTIGA_CMD_PRIORITY_HIGH) ? OPTIGA_CMD_PRIORITY_HIGH : (uint8_t)priority);
+}
+
+#ifdef OPTIGA_CMD_GOVERNOR
+// Estimate steps of one security event and one key command
+#define OPTIGA_CMD_GOVERNOR_EVENT           (65536U)
+#define OPTIGA_CMD_GOVERNOR_CHARGE          (OPTIGA_CMD_GOVERNOR_EVENT / OPTIGA_CMD_GOVERNOR_COMMANDS)
+#define OPTIGA_CMD_GOVERNOR_DECAY_US        ((uint64_t)OPTIGA_CMD_GOVERNOR_DECAY_MS * 1000U)
+
+// Commands that use a key or secret in OPTIGA
+#ifndef OPTIGA_CMD_GOVERNOR_SENSITIVE
+#define OPTIGA_CMD_GOVERNOR_SENSITIVE(command) \
+    ((OPTIGA_CMD_ENCRYPT_SYM == (command)) || (OPTIGA_CMD_DECRYPT_SYM == (command)) || \
+     (OPTIGA_CMD_CALC_SIGN == (command)) || (OPTIGA_CMD_CALC_SSEC == (command)) || \
+     (OPTIGA_CMD_DERIVE_KEY == (command)) || (OPTIGA_CMD_DECRYPT_ASYM == (command)))
+#endif
+
+/*
+* Lets the estimate decay by one event per OPTIGA_CMD_GOVERNOR_DECAY_MS up to now; the time of the
+* remainder is kept, so frequent updates lose nothing to rounding
+*/
+_STATIC_H void optiga_cmd_governor_decay(optiga_context_t * p_optiga, uint32_t now_us)
+{
+    const uint32_t elapsed_us = now_us - p_optiga->governor_update_us;
+    const uint64_t decay = ((uint64_t)elapsed_us * OPTIGA_CMD_GOVERNOR_EVENT) / OPTIGA_CMD_GOVERNOR_DECAY_US;
+
+    if (decay >= p_optiga->governor_level)
+    {
+        p_optiga->governor_level = 0;
+        p_optiga->governor_update_us = now_us;
+    }
+    else
+    {
+        p_optiga->governor_level -= (uint32_t)decay;
+        p_optiga->governor_update_us += (uint32_t)((decay * OPTIGA_CMD_GOVERNOR_DECAY_US) / OPTIGA_CMD_GOVERNOR_EVENT);
+    }
+}
+
+/*
+* Charges a key command to the estimate and returns how long to hold it back so the estimate is at
+* most OPTIGA_CMD_GOVERNOR_LIMIT when it runs. Above the limit the estimate is capped, so key
+* commands then run at the rate it decays instead of waiting for it to drain. Called by the
+* scheduler in the critical section.
+*/
+_STATIC_H uint32_t optiga_cmd_governor_pace(optiga_context_t * p_optiga, uint8_t command, uint32_t now_us)
+{
+    const uint32_t limit = OPTIGA_CMD_GOVERNOR_LIMIT * OPTIGA_CMD_GOVERNOR_EVENT;
+    uint32_t hold_us = 0;
+
+    if (!(OPTIGA_CMD_GOVERNOR_SENSITIVE(command)))
+    {
+        return (0);
+    }
+    optiga_cmd_governor_decay(p_optiga, now_us);
+    if (p_optiga->governor_level > limit)
+    {
+        p_optiga->governor_level = limit;
+    }
+    p_optiga->governor_level += OPTIGA_CMD_GOVERNOR_CHARGE;
+    p_optiga->governor_stats.commands++;
+    if (p_optiga->governor_level > limit)
+    {
+        hold_us = (uint32_t)(((uint64_t)(p_optiga->governor_level - limit) * OPTIGA_CMD_GOVERNOR_DECAY_US) /
+                             OPTIGA_CMD_GOVERNOR_EVENT);
+        p_optiga->governor_stats.paced++;
+        p_optiga->governor_stats.paced_us += hold_us;
+    }
+    return (hold_us);
+}
+
+/*
+* Replaces the estimate with the security event counter OPTIGA returned (data object 0xE0C5)
+*/
+_STATIC_H void optiga_cmd_governor_sync(optiga_context_t * p_optiga, uint8_t sec)
+{
+    pal_os_lock_enter_critical_section();
+    p_optiga->governor_level = (uint32_t)sec * OPTIGA_CMD_GOVERNOR_EVENT;
+    p_optiga->governor_update_us = pal_os_timer_get_time_in_microseconds();
+    p_optiga->governor_stats.sec_reads++;
+    p_optiga->governor_stats.last_sec = sec;
+    pal_os_lock_exit_critical_section();
+}
+#endif //OPTIGA_CMD_GOVERNOR
+
+#ifdef OPTIGA_CMD_PROTECTION_POLICY
+/// OID range of a row for any OID
+#define OPTIGA_CMD_POLICY_ALL_OIDS          (0x0000), (0xFFFF)
+
+// Key operations keep the data in and the result out protected, writes their data. Random, hash, verify,
+// public key encryption and reads are bulk or public data and stay unprotected.
+_STATIC_H const optiga_cmd_protection_rule_t g_optiga_cmd_protection_default[] =
+{
+    {OPTIGA_CMD_POLICY_ENCRYPT_SYM,     OPTIGA_COMMS_FULL_PROTECTION,       OPTIGA_CMD_POLICY_ALL_OIDS},
+    {OPTIGA_CMD_POLICY_DECRYPT_SYM,     OPTIGA_COMMS_FULL_PROTECTION,       OPTIGA_CMD_POLICY_ALL_OIDS},
+    {OPTIGA_CMD_POLICY_DECRYPT_ASYM,    OPTIGA_COMMS_FULL_PROTECTION,       OPTIGA_CMD_POLICY_ALL_OIDS},
+    {OPTIGA_CMD_POLICY_CALC_SIGN,       OPTIGA_COMMS_FULL_PROTECTION,       OPTIGA_CMD_POLICY_ALL_OIDS},
+    {OPTIGA_CMD_POLICY_CALC_SSEC,       OPTIGA_COMMS_FULL_PROTECTION,       OPTIGA_CMD_POLICY_ALL_OIDS},
+    {OPTIGA_CMD_POLICY_DERIVE_KEY,      OPTIGA_COMMS_FULL_PROTECTION,       OPTIGA_CMD_POLICY_ALL_OIDS},
+    {OPTIGA_CMD_POLICY_GEN_KEYPAIR,     OPTIGA_COMMS_FULL_PROTECTION,       OPTIGA_CMD_POLICY_ALL_OIDS},
+    {OPTIGA_CMD_POLICY_GEN_SYM_KEY,     OPTIGA_COMMS_FULL_PROTECTION,       OPTIGA_CMD_POLICY_ALL_OIDS},
+    // Platform binding secret
+    {OPTIGA_CMD_POLICY_SET_DATA_OBJECT, OPTIGA_COMMS_FULL_PROTECTION,       0xE140, 0xE140},
+    {OPTIGA_CMD_POLICY_SET_DATA_OBJECT, OPTIGA_COMMS_COMMAND_PROTECTION,    OPTIGA_CMD_POLICY_ALL_OIDS},
+    {OPTIGA_CMD_POLICY_GET_RANDOM,      OPTIGA_COMMS_NO_PROTECTION,         OPTIGA_CMD_POLICY_ALL_OIDS},
+    {OPTIGA_CMD_POLICY_CALC_HASH,       OPTIGA_COMMS_NO_PROTECTION,         OPTIGA_CMD_POLICY_ALL_OIDS},
+    {OPTIGA_CMD_POLICY_VERIFY_SIGN,     OPTIGA_COMMS_NO_PROTECTION,         OPTIGA_CMD_POLICY_ALL_OIDS},
+    {OPTIGA_CMD_POLICY_ENCRYPT_ASYM,    OPTIGA_COMMS_NO_PROTECTION,         OPTIGA_CMD_POLICY_ALL_OIDS},
+    {OPTIGA_CMD_POLICY_GET_DATA_OBJECT, OPTIGA_COMMS_NO_PROTECTION,         OPTIGA_CMD_POLICY_ALL_OIDS},
+};
+
+_STATIC_H const optiga_cmd_protection_rule_t * volatile g_optiga_cmd_protection_rules = g_optiga_cmd_protection_default;
+_STATIC_H volatile uint8_t g_optiga_cmd_protection_count =
+    (uint8_t)(sizeof(g_optiga_cmd_protection_default) / sizeof(g_optiga_cmd_protection_default[0]));
+_STATIC_H optiga_cmd_protection_stats_t g_optiga_cmd_protection_stats;
+
+/*
+* OID the prepared command addresses, taken from its input parameters. FALSE for commands without one
+* (random, hash, encryption with a host key)
+*/
+_STATIC_H bool_t optiga_cmd_policy_oid(const optiga_cmd_t * me, uint16_t * p_oid)
+{
+    bool_t has_oid = TRUE;
+
+    switch (OPTIGA_CMD_GET_APDU_CMD(me->apdu_data))
+    {
+        case OPTIGA_CMD_GET_DATA_OBJECT:
+            *p_oid = ((const optiga_get_data_object_params_t *)me->p_input)->oid;
+        break;
+        case OPTIGA_CMD_SET_DATA_OBJECT:
+            *p_oid = ((const optiga_set_data_object_params_t *)me->p_input)->oid;
+        break;
+        case OPTIGA_CMD_CALC_SIGN:
+            *p_oid = (uint16_t)((const optiga_calc_sign_params_t *)me->p_input)->private_key_oid;
+        break;
+        case OPTIGA_CMD_CALC_SSEC:
+            *p_oid = (uint16_t)((const optiga_calc_ssec_params_t *)me->p_input)->private_key;
+        break;
+        case OPTIGA_CMD_DERIVE_KEY:
+            *p_oid = ((const optiga_derive_key_params_t *)me->p_input)->input_shared_secret_oid;
+        break;
+        case OPTIGA_CMD_GEN_KEYPAIR:
+            *p_oid = (uint16_t)((const optiga_gen_keypair_params_t *)me->p_input)->private_key_oid;
+        break;
+        case OPTIGA_CMD_ENCRYPT_SYM:
+        case OPTIGA_CMD_DECRYPT_SYM:
+            *p_oid = ((const optiga_encrypt_sym_params_t *)me->p_input)->symmetric_key_oid;
+        break;
+        case OPTIGA_CMD_VERIFY_SIGN:
+            *p_oid = ((const optiga_verify_sign_params_t *)me->p_input)->certificate_oid;
+            has_oid = (OPTIGA_CRYPT_OID_DATA == ((const optiga_verify_sign_params_t *)me->p_input)->public_key_source_type) ?
+                      TRUE : FALSE;
+        break;
+        default:
+            has_oid = FALSE;
+        break;
+    }
+    return (has_oid);
+}
+
+/*
+* Protection level of the first row matching the prepared command, OPTIGA_COMMS_NO_PROTECTION if none
+*/
+_STATIC_H uint8_t optiga_cmd_policy_level(const optiga_cmd_t * me)
+{
+    const optiga_cmd_protection_rule_t * p_rules;
+    const uint8_t command = (uint8_t)(OPTIGA_CMD_GET_APDU_CMD(me->apdu_data) & (uint8_t)(~OPTIGA_CMD_CLEAR_LAST_ERROR));
+    uint16_t oid = 0;
+    const bool_t has_oid = optiga_cmd_policy_oid(me, &oid);
+    uint8_t level = OPTIGA_COMMS_NO_PROTECTION;
+    uint8_t count;
+    uint8_t index;
+
+    pal_os_lock_enter_critical_section();
+    p_rules = g_optiga_cmd_protection_rules;
+    count = g_optiga_cmd_protection_count;
+    pal_os_lock_exit_critical_section();
+
+    for (index = 0; index < count; index++)
+    {
+        if ((OPTIGA_CMD_POLICY_ANY_COMMAND != p_rules[index].command) && (command != p_rules[index].command))
+        {
+            continue;
+        }
+        if ((TRUE == has_oid) ? ((oid >= p_rules[index].oid_first) && (oid <= p_rules[index].oid_last)) :
+                                ((0x0000U == p_rules[index].oid_first) && (0xFFFFU == p_rules[index].oid_last)))
+        {
+            level = (uint8_t)(p_rules[index].protection_level & OPTIGA_COMMS_FULL_PROTECTION);
+            break;
+        }
+    }
+    return (level);
+}
+
+/*
+* Adds the policy level to the one the caller set, before the APDU is handed to comms
+*/
+_STATIC_H void optiga_cmd_policy_apply(optiga_cmd_t * me)
+{
+    const uint8_t requested = me->protection_level;
+
+    me->protection_level |= optiga_cmd_policy_level(me);
+    pal_os_lock_enter_critical_section();
+    g_optiga_cmd_protection_stats.apdus++;
+    if (0U != (me->protection_level & OPTIGA_COMMS_FULL_PROTECTION))
+    {
+        g_optiga_cmd_protection_stats.protected_apdus++;
+    }
+    if (requested != me->protection_level)
+    {
+        g_optiga_cmd_protection_stats.raised++;
+    }
+    pal_os_lock_exit_critical_section();
+}
+
+void optiga_cmd_set_protection_policy(const optiga_cmd_protection_rule_t * p_rules, uint8_t count)
+{
+    pal_os_lock_enter_critical_section();
+    if (NULL == p_rules)
+    {
+        g_optiga_cmd_protection_rules = g_optiga_cmd_protection_default;
+        g_optiga_cmd_protection_count =
+            (uint8_t)(sizeof(g_optiga_cmd_protection_default) / sizeof(g_optiga_cmd_protection_default[0]));
+    }
+    else
+    {
+        g_optiga_cmd_protection_rules = p_rules;
+        g_optiga_cmd_protection_count = count;
+    }
+    pal_os_lock_exit_critical_section();
+}
+
+void optiga_cmd_protection_get_stats(optiga_cmd_protection_stats_t * p_stats)
+{
+    pal_os_lock_enter_critical_section();
+    *p_stats = g_optiga_cmd_protection_stats;
+    pal_os_lock_exit_critical_section();
+}
+#undef OPTIGA_CMD_POLICY_ALL_OIDS
+#endif //OPTIGA_CMD_PROTECTION_POLICY
+
 /*
 * Select next optiga cmd instance from the execution queue based on a rule
 * 1. A slot with OPTIGA_CMD_QUEUE_RESUME state should exist
 * 2. Pick the slot which has acquired the strict slot
 * 3. If no slot with OPTIGA_CMD_QUEUE_RESUME exists, slot must be in OPTIGA_CMD_QUEUE_REQUEST state
-* 4. The arrival time must be the earliest provided
 *     a. The request type is lock
 *     b. If request type is session, either session is already assigned or atleast session is available for assignment
+* 4. The effective priority (instance priority plus aging) must be the highest
+* 5. Among equal effective priorities, the arrival time must be the earliest
 */
 _STATIC_H void optiga_cmd_queue_scheduler(void * p_optiga)
 {
-    uint32_t reference_time_stamp = 0xFFFFFFFF;
     optiga_cmd_queue_slot_t * p_queue_entry;
     uint8_t index;
     uint8_t prefered_index = 0xFF;
-    uint8_t overflow_detected = FALSE;
+    uint8_t prefered_priority = OPTIGA_CMD_PRIORITY_LOW;
+    uint8_t effective_priority;
+    bool_t session_available;
+    uint32_t slot_mask;
+    uint32_t prefered_waiting_time = 0;
+    uint32_t waiting_time;
+    uint32_t current_time;
+    uint32_t hold_us = 0;
 
     optiga_context_t * p_optiga_ctx = (optiga_context_t * )p_optiga;
 
     pal_os_event_t * my_os_event = p_optiga_ctx->p_pal_os_event_ctx;
 
+    // Queue updates from other tasks must not slip in between the checks and parking
+    pal_os_lock_enter_critical_section();
+    p_optiga_ctx->scheduler_parked = FALSE;
 
     if (((0 == optiga_cmd_queue_get_count_of(p_optiga_ctx, OPTIGA_CMD_QUEUE_SLOT_STATE, OPTIGA_CMD_QUEUE_REQUEST)) &&
          (0 == optiga_cmd_queue_get_count_of(p_optiga_ctx, OPTIGA_CMD_QUEUE_SLOT_STATE, OPTIGA_CMD_QUEUE_RESUME))) ||
          ((1 == optiga_cmd_queue_get_count_of(p_optiga_ctx, OPTIGA_CMD_QUEUE_SLOT_STATE , OPTIGA_CMD_QUEUE_PROCESSING)) &&
          (0 < optiga_cmd_queue_get_count_of(p_optiga_ctx, OPTIGA_CMD_QUEUE_SLOT_LOCK_TYPE, OPTIGA_CMD_QUEUE_REQUEST_STRICT_LOCK))))
     {
-        // call self
-        pal_os_event_register_callback_oneshot(my_os_event, optiga_cmd_queue_scheduler,
-                                               p_optiga_ctx,OPTIGA_CMD_SCHEDULER_IDLING_TIME_MS);
+        optiga_cmd_queue_park_scheduler(p_optiga_ctx);
     }
     else
     {
         pal_os_event_stop(my_os_event);
-        // continue checking if no context selected and overflow detected
-        do
+        current_time = pal_os_timer_get_time_in_microseconds();
+
+        // if any slot has acquired strict lock, highest priority is given to it
+        if (1 == p_optiga_ctx->queue_count[OPTIGA_CMD_QUEUE_MASK_RESUME])
         {
-            //reset overflow detected flag and the last_time stamp
-            if(overflow_detected == TRUE)
+            // Select the slot which has acquired strict lock
+            slot_mask = p_optiga_ctx->queue_mask[OPTIGA_CMD_QUEUE_MASK_RESUME] &
+                        p_optiga_ctx->queue_mask[OPTIGA_CMD_QUEUE_MASK_STRICT_LOCK];
+            if (0U != slot_mask)
             {
-                p_optiga_ctx->last_time_stamp = 0;
-                overflow_detected = FALSE;
+                prefered_index = optiga_cmd_queue_first_slot(slot_mask);
             }
-
-            // Select optiga command based on rule
-            for (index = 0; index < OPTIGA_CMD_MAX_REGISTRATIONS; index++)
+        }
+        else
+        {
+            session_available = optiga_cmd_session_available(p_optiga_ctx);
+            if ((FALSE == session_available) &&
+                (0 < p_optiga_ctx->queue_count[OPTIGA_CMD_QUEUE_MASK_REQUEST_SESSION]))
             {
+                session_available = optiga_cmd_session_reclaim(p_optiga_ctx, pal_os_timer_get_time_in_milliseconds());
+            }
+            // Select optiga command based on rule, visiting only the requested slots
+            slot_mask = p_optiga_ctx->queue_mask[OPTIGA_CMD_QUEUE_MASK_REQUEST];
+            while (0U != slot_mask)
+            {
+                index = optiga_cmd_queue_first_slot(slot_mask);
+                slot_mask &= (slot_mask - 1U);
                 p_queue_entry = &(p_optiga_ctx->optiga_cmd_execution_queue[index]);
 
-                // if any slot has acquired strict lock, highest priority is given to it
-                if (1 == optiga_cmd_queue_get_count_of(p_optiga_ctx, OPTIGA_CMD_QUEUE_SLOT_STATE , OPTIGA_CMD_QUEUE_RESUME))
+                // lock request or session request and session available(either already assigned or available)
+                if ((OPTIGA_CMD_QUEUE_REQUEST_SESSION == p_queue_entry->request_type) &&
+                    (FALSE == session_available) &&
+                    (OPTIGA_CMD_NO_SESSION_OID == ((optiga_cmd_t *)p_queue_entry->registered_ctx)->session_oid))
                 {
-                    // Select the slot which has acquired strict lock
-                    if ((OPTIGA_CMD_QUEUE_RESUME == p_queue_entry->state_of_entry) &&
-                        (OPTIGA_CMD_QUEUE_REQUEST_STRICT_LOCK == p_queue_entry->request_type))
-                    {
-                        reference_time_stamp = p_queue_entry->arrival_time;
-                        prefered_index = index;
-                    }
-
+                    continue;
                 }
-                else
-                {
-                    // pick only requested queue slot and earliest arrival time
-                    if (p_queue_entry->state_of_entry == OPTIGA_CMD_QUEUE_REQUEST)
-                    {
-                        // remember that overflow has occurred in one of the entry
-                        if (p_queue_entry->arrival_time < p_optiga_ctx->last_time_stamp)
-                        {
-                            overflow_detected = TRUE;
-                        }
 
-                        // if lock request or session request and session available(either already assigned or available)
-                        if (((p_queue_entry->arrival_time <= reference_time_stamp) && (p_queue_entry->arrival_time >= p_optiga_ctx->last_time_stamp)) &&
-                            (((OPTIGA_CMD_QUEUE_REQUEST_SESSION == p_queue_entry->request_type) && (TRUE == optiga_cmd_session_available(p_optiga_ctx))) ||
-                            ((OPTIGA_CMD_QUEUE_REQUEST_SESSION == p_queue_entry->request_type) && (OPTIGA_CMD_NO_SESSION_OID != ((optiga_cmd_t *)p_queue_entry->registered_ctx)->session_oid)) ||
-                            (OPTIGA_CMD_QUEUE_REQUEST_LOCK == p_queue_entry->request_type) ||
-                            (OPTIGA_CMD_QUEUE_REQUEST_STRICT_LOCK == p_queue_entry->request_type)))
-                        {
-                            reference_time_stamp = p_queue_entry->arrival_time;
-                            prefered_index = index;
-                        }
-                    }
+                // unsigned difference stays correct across a wrap of the microsecond timer
+                waiting_time = current_time - p_queue_entry->arrival_time;
+                effective_priority = optiga_cmd_queue_effective_priority(p_queue_entry, waiting_time);
+                if ((0xFF == prefered_index) || (effective_priority > prefered_priority) ||
+                    ((effective_priority == prefered_priority) && (waiting_time > prefered_waiting_time)))
+                {
+                    prefered_priority = effective_priority;
+                    prefered_waiting_time = waiting_time;
+                    prefered_index = index;
                 }
             }
-        } while((0xFF == prefered_index) && (TRUE == overflow_detected));
+        }
 
         // Improve : check the index and max queue size check
         // If slot is identified then go further
@@ -1020,22 +1508,60 @@ _STATIC_H void optiga_cmd_queue_scheduler(void * p_optiga)
                 optiga_cmd_session_assign((optiga_cmd_t *)(p_optiga_ctx->optiga_cmd_execution_queue[prefered_index].registered_ctx));
                 // Improve : Change the state of the type here. This will reduce 0x0000 check
             }
+            // the lease of a held session runs from the last scheduled request
+            ((optiga_cmd_t *)p_queue_entry->registered_ctx)->session_used_ms = pal_os_timer_get_time_in_milliseconds();
 
             // schedule with selected context
             my_os_event = ((optiga_cmd_t *)(p_optiga_ctx->optiga_cmd_execution_queue[prefered_index].registered_ctx))->p_optiga->p_pal_os_event_ctx;
+#ifdef OPTIGA_CMD_GOVERNOR
+            // A held back key command keeps its slot, so the queue waits for it in order
+            hold_us = optiga_cmd_governor_pace(p_optiga_ctx,
+                                               OPTIGA_CMD_GET_APDU_CMD(((optiga_cmd_t *)p_queue_entry->registered_ctx)->apdu_data),
+                                               current_time);
+#endif
             pal_os_event_register_callback_oneshot(my_os_event,
                                                    optiga_cmd_event_trigger_execute,
                                                    ((optiga_cmd_t *)(p_optiga_ctx->optiga_cmd_execution_queue[prefered_index].registered_ctx)),
-                                                   OPTIGA_CMD_SCHEDULER_RUNNING_TIME_MS);
-            p_optiga_ctx->optiga_cmd_execution_queue[prefered_index].state_of_entry = OPTIGA_CMD_QUEUE_PROCESSING;
-            p_optiga_ctx->last_time_stamp = reference_time_stamp;
+                                                   OPTIGA_CMD_SCHEDULER_RUNNING_TIME_MS + hold_us);
+            optiga_cmd_queue_set_slot(p_optiga_ctx, prefered_index, OPTIGA_CMD_QUEUE_SLOT_STATE, OPTIGA_CMD_QUEUE_PROCESSING);
         }
         else
         {
-            pal_os_event_register_callback_oneshot( my_os_event, optiga_cmd_queue_scheduler,
-                                                    p_optiga_ctx,OPTIGA_CMD_SCHEDULER_IDLING_TIME_MS);
+            optiga_cmd_queue_park_scheduler(p_optiga_ctx);
         }
     }
+    pal_os_lock_exit_critical_section();
+}
+
+/*
+* Restarts a parked scheduler. Must be called after a slot has moved to REQUEST/RESUME or a
+* session/lock has been released. A scheduler that is not parked is either pending or has handed
+* the event to a command and gets restarted when that command releases its slot.
+*/
+_STATIC_H void optiga_cmd_queue_wakeup(optiga_context_t * p_optiga)
+{
+    pal_os_lock_enter_critical_section();
+    if (TRUE == p_optiga->scheduler_parked)
+    {
+        p_optiga->scheduler_parked = FALSE;
+        pal_os_event_register_callback_oneshot(p_optiga->p_pal_os_event_ctx, optiga_cmd_queue_scheduler,
+                                               p_optiga, OPTIGA_CMD_SCHEDULER_WAKEUP_TIME_MS);
+    }
+    pal_os_lock_exit_critical_section();
+}
+
+/*
+* Runs the scheduler right after the current command has released its slot (or strict lock step),
+* so the next queued command is dispatched as soon as the response is consumed instead of after
+* the PAL start delay. The releasing command has no event pending, so the event is free.
+*/
+_STATIC_H void optiga_cmd_queue_dispatch_next(optiga_context_t * p_optiga)
+{
+    pal_os_lock_enter_critical_section();
+    p_optiga->scheduler_parked = FALSE;
+    pal_os_event_register_callback_oneshot(p_optiga->p_pal_os_event_ctx, optiga_cmd_queue_scheduler,
+                                           p_optiga, OPTIGA_CMD_SCHEDULER_WAKEUP_TIME_MS);
+    pal_os_lock_exit_critical_section();
 }
 
 /*
@@ -1043,6 +1569,7 @@ _STATIC_H void optiga_cmd_queue_scheduler(void * p_optiga)
 */
 _STATIC_H void optiga_cmd_queue_update_slot(optiga_cmd_t * me, uint8_t request_type)
 {
+    pal_os_lock_enter_critical_section();
     if ((OPTIGA_CMD_QUEUE_REQUEST_STRICT_LOCK != me->p_optiga->optiga_cmd_execution_queue[me->queue_id].request_type) ||
        ((OPTIGA_CMD_QUEUE_REQUEST_STRICT_LOCK == me->p_optiga->optiga_cmd_execution_queue[me->queue_id].request_type) &&
        (OPTIGA_CMD_QUEUE_REQUEST_STRICT_LOCK != request_type)))
@@ -1057,14 +1584,17 @@ _STATIC_H void optiga_cmd_queue_update_slot(optiga_cmd_t * me, uint8_t request_t
     if ((OPTIGA_CMD_QUEUE_REQUEST_STRICT_LOCK == me->p_optiga->optiga_cmd_execution_queue[me->queue_id].request_type) &&
         (OPTIGA_CMD_QUEUE_REQUEST_STRICT_LOCK == request_type))
     {
-        me->p_optiga->optiga_cmd_execution_queue[me->queue_id].state_of_entry = OPTIGA_CMD_QUEUE_RESUME;
+        optiga_cmd_queue_set_slot(me->p_optiga, me->queue_id, OPTIGA_CMD_QUEUE_SLOT_STATE, OPTIGA_CMD_QUEUE_RESUME);
     }
     else
     {
-        me->p_optiga->optiga_cmd_execution_queue[me->queue_id].state_of_entry = OPTIGA_CMD_QUEUE_REQUEST;
+        optiga_cmd_queue_set_slot(me->p_optiga, me->queue_id, OPTIGA_CMD_QUEUE_SLOT_STATE, OPTIGA_CMD_QUEUE_REQUEST);
     }
     //add request type
-    me->p_optiga->optiga_cmd_execution_queue[me->queue_id].request_type = request_type;
+    optiga_cmd_queue_set_slot(me->p_optiga, me->queue_id, OPTIGA_CMD_QUEUE_SLOT_LOCK_TYPE, request_type);
+    pal_os_lock_exit_critical_section();
+
+    optiga_cmd_queue_wakeup(me->p_optiga);
 }
 
 /*
@@ -1077,11 +1607,11 @@ _STATIC_H void optiga_cmd_queue_reset_slot(const optiga_cmd_t * me)
     //add optiga_cmd ctx
     me->p_optiga->optiga_cmd_execution_queue[me->queue_id].registered_ctx = NULL;
     //add request type
-    me->p_optiga->optiga_cmd_execution_queue[me->queue_id].request_type = 0;
+    optiga_cmd_queue_set_slot(me->p_optiga, me->queue_id, OPTIGA_CMD_QUEUE_SLOT_LOCK_TYPE, OPTIGA_CMD_QUEUE_NO_REQUEST);
     // set the slot state to assigned
-    me->p_optiga->optiga_cmd_execution_queue[me->queue_id].state_of_entry = OPTIGA_CMD_QUEUE_ASSIGNED;
-    // start the event scheduler
-    pal_os_event_start(me->p_optiga->p_pal_os_event_ctx, optiga_cmd_queue_scheduler, me->p_optiga);
+    optiga_cmd_queue_set_slot(me->p_optiga, me->queue_id, OPTIGA_CMD_QUEUE_SLOT_STATE, OPTIGA_CMD_QUEUE_ASSIGNED);
+    // hand over to the next queued command
+    optiga_cmd_queue_dispatch_next(me->p_optiga);
 }
 
 
@@ -1090,8 +1620,8 @@ _STATIC_H void optiga_cmd_queue_reset_slot(const optiga_cmd_t * me)
 */
 _STATIC_H void optiga_cmd_release_strict_lock(const optiga_cmd_t * me)
 {
-    me->p_optiga->optiga_cmd_execution_queue[me->queue_id].state_of_entry = OPTIGA_CMD_QUEUE_ASSIGNED;
-    me->p_optiga->optiga_cmd_execution_queue[me->queue_id].request_type = OPTIGA_CMD_QUEUE_NO_REQUEST;
+    optiga_cmd_queue_set_slot(me->p_optiga, me->queue_id, OPTIGA_CMD_QUEUE_SLOT_STATE, OPTIGA_CMD_QUEUE_ASSIGNED);
+    optiga_cmd_queue_set_slot(me->p_optiga, me->queue_id, OPTIGA_CMD_QUEUE_SLOT_LOCK_TYPE, OPTIGA_CMD_QUEUE_NO_REQUEST);
 }
 
 optiga_lib_status_t optiga_cmd_request_session(optiga_cmd_t * me)
@@ -1103,6 +1633,8 @@ optiga_lib_status_t optiga_cmd_request_session(optiga_cmd_t * me)
 optiga_lib_status_t optiga_cmd_release_session(optiga_cmd_t * me)
 {
     optiga_cmd_session_free(me);
+    // a request waiting for a free session can run now
+    optiga_cmd_queue_wakeup(me->p_optiga);
     return (OPTIGA_CMD_SUCCESS);
 }
 
@@ -1118,6 +1650,90 @@ optiga_lib_status_t optiga_cmd_release_lock(const optiga_cmd_t * me)
     return (OPTIGA_CMD_SUCCESS);
 }
 
+void optiga_cmd_get_pool_stats(optiga_lib_pool_stats_t * p_stats)
+{
+    optiga_lib_pool_get_stats(&g_optiga_cmd_pool, p_stats);
+}
+
+uint32_t optiga_cmd_get_context_size(void)
+{
+    return ((uint32_t)sizeof(optiga_context_t));
+}
+
+#ifdef OPTIGA_CMD_GOVERNOR
+void optiga_cmd_governor_get_stats(uint8_t optiga_instance_id, optiga_cmd_governor_stats_t * p_stats)
+{
+    optiga_context_t * p_optiga;
+
+    pal_os_memset(p_stats, 0x00, sizeof(*p_stats));
+    if (optiga_instance_id < OPTIGA_MAX_INSTANCES)
+    {
+        p_optiga = g_optiga_list[optiga_instance_id];
+        pal_os_lock_enter_critical_section();
+        optiga_cmd_governor_decay(p_optiga, pal_os_timer_get_time_in_microseconds());
+        *p_stats = p_optiga->governor_stats;
+        p_stats->level = (uint8_t)((p_optiga->governor_level + OPTIGA_CMD_GOVERNOR_EVENT - 1U) / OPTIGA_CMD_GOVERNOR_EVENT);
+        pal_os_lock_exit_critical_section();
+    }
+}
+
+bool_t optiga_cmd_governor_pacing(uint8_t optiga_instance_id)
+{
+    optiga_context_t * p_optiga;
+    bool_t pacing = FALSE;
+
+    if (optiga_instance_id < OPTIGA_MAX_INSTANCES)
+    {
+        p_optiga = g_optiga_list[optiga_instance_id];
+        pal_os_lock_enter_critical_section();
+        optiga_cmd_governor_decay(p_optiga, pal_os_timer_get_time_in_microseconds());
+        pacing = ((p_optiga->governor_level + OPTIGA_CMD_GOVERNOR_CHARGE) >
+                  (OPTIGA_CMD_GOVERNOR_LIMIT * OPTIGA_CMD_GOVERNOR_EVENT)) ? TRUE : FALSE;
+        pal_os_lock_exit_critical_section();
+    }
+    return (pacing);
+}
+#endif //OPTIGA_CMD_GOVERNOR
+
+void optiga_cmd_set_priority(optiga_cmd_t * me, uint8_t priority)
+{
+    me->priority = (priority > OPTIGA_CMD_PRIORITY_HIGH) ? OPTIGA_CMD_PRIORITY_HIGH : priority;
+}
+
+void optiga_cmd_session_lease(optiga_cmd_t * me, uint32_t lease_ms)
+{
+    pal_os_lock_enter_critical_section();
+    me->session_lease_ms = lease_ms;
+    me->session_used_ms = pal_os_timer_get_time_in_milliseconds();
+    pal_os_lock_exit_critical_section();
+}
+
+void optiga_cmd_session_end(optiga_cmd_t * me)
+{
+    pal_os_lock_enter_critical_section();
+    optiga_cmd_session_free(me);
+    pal_os_lock_exit_critical_section();
+    // a request waiting for a free session can run now
+    optiga_cmd_queue_wakeup(me->p_optiga);
+}
+
+bool_t optiga_cmd_session_held(const optiga_cmd_t * me)
+{
+    return ((OPTIGA_CMD_NO_SESSION_OID != me->session_oid) ? TRUE : FALSE);
+}
+
+uint32_t optiga_cmd_session_reclaims(uint8_t optiga_instance_id)
+{
+    return ((optiga_instance_id < OPTIGA_MAX_INSTANCES) ? g_optiga_list[optiga_instance_id]->session_reclaims : 0U);
+}
+
+#ifdef OPTIGA_CMD_RANDOM_COALESCE
+uint32_t optiga_cmd_random_coalesced(uint8_t optiga_instance_id)
+{
+    return ((optiga_instance_id < OPTIGA_MAX_INSTANCES) ? g_optiga_list[optiga_instance_id]->random_coalesced : 0U);
+}
+#endif //OPTIGA_CMD_RANDOM_COALESCE
+
 _STATIC_H optiga_lib_status_t optiga_cmd_restore_context(const optiga_cmd_t * me)
 {
 #define OPTIGA_CMD_OF_CONTEXT_HANDLE_4TH_BYTE         (0x04)
@@ -1386,6 +2002,13 @@ _STATIC_H void optiga_cmd_execute_prepare_command(optiga_cmd_t * me, uint8_t * e
             case OPTIGA_CMD_EXEC_PREPARE_APDU:
             {
                 *exit_loop = TRUE;
+                OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_CMD_PREPARE, 0);
+#ifdef OPTIGA_LIB_ENABLE_LATENCY_HISTOGRAM
+                // Only the first APDU of a request waits in the queue, chained ones follow at once
+                me->latency_queue_us = (0U != me->latency_request_us) ?
+                                       (pal_os_timer_get_time_in_microseconds() - me->latency_request_us) : 0U;
+                me->latency_request_us = 0;
+#endif
                 me->exit_status = optiga_cmd_handler(me);
                 if (OPTIGA_LIB_SUCCESS != me->exit_status)
                 {
@@ -1395,11 +2018,22 @@ _STATIC_H void optiga_cmd_execute_prepare_command(optiga_cmd_t * me, uint8_t * e
                 }
                 me->p_optiga->comms_rx_size = OPTIGA_CMD_TOTAL_COMMS_BUFFER_SIZE;
 #ifdef OPTIGA_COMMS_SHIELDED_CONNECTION
+#ifdef OPTIGA_CMD_PROTECTION_POLICY
+                optiga_cmd_policy_apply(me);
+#endif
                 me->p_optiga->p_optiga_comms->protection_level = me->protection_level;
                 me->p_optiga->p_optiga_comms->protocol_version = me->protocol_version;
                 me->p_optiga->protection_level_state |= me->protection_level;
 #endif //OPTIGA_COMMS_SHIELDED_CONNECTION
                 (void)optiga_comms_set_callback_context(me->p_optiga->p_optiga_comms, me);
+                OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_CMD_SEND, me->p_optiga->optiga_comms_buffer[OPTIGA_COMMS_DATA_OFFSET]);
+#ifdef OPTIGA_LIB_ENABLE_LATENCY_HISTOGRAM
+                // Read before transceive, a protected command is encrypted in place
+                me->latency_command_code = me->p_optiga->optiga_comms_buffer[OPTIGA_COMMS_DATA_OFFSET];
+                me->latency_send_us = pal_os_timer_get_time_in_microseconds();
+                me->latency_pending = TRUE;
+                me->latency_failed = FALSE;
+#endif
                 me->exit_status = optiga_comms_transceive(me->p_optiga->p_optiga_comms,
                                                           me->p_optiga->optiga_comms_buffer,
                                                           me->p_optiga->comms_tx_size,
@@ -1425,11 +2059,40 @@ _STATIC_H void optiga_cmd_execute_prepare_command(optiga_cmd_t * me, uint8_t * e
     } while ((FALSE == *exit_loop) && (OPTIGA_CMD_EXEC_PREPARE_COMMAND == me->cmd_next_execution_state));
 }
 
+#ifdef OPTIGA_LIB_ENABLE_LATENCY_HISTOGRAM
+_STATIC_H void optiga_cmd_latency_record(optiga_cmd_t * me, uint32_t exec_us)
+{
+    OPTIGA_LIB_LATENCY(me->latency_command_code, me->latency_queue_us,
+                       pal_os_timer_get_time_in_microseconds() - me->latency_send_us,
+                       exec_us, me->latency_failed);
+    me->latency_pending = FALSE;
+}
+#endif
+
 _STATIC_H void optiga_cmd_execute_get_device_error(optiga_cmd_t * me, uint8_t * exit_loop)
 {
     do
     {
         *exit_loop = TRUE;
+#ifdef OPTIGA_CMD_LAZY_DEVICE_ERROR
+        // Only a handler that asked to be called again (read data running past the end of the
+        // object) needs the code. Other failures end with the bare OPTIGA_DEVICE_ERROR and the
+        // code stays in the Last Error Code object (0xF1C2) until the next command clears it
+        if ((OPTIGA_CMD_ERROR_CODE_PREPARE == (me->device_error_status & OPTIGA_CMD_ERROR_CODE_STATE_MASK)) &&
+            (OPTIGA_CMD_ZERO_LENGTH_OR_VALUE == (me->device_error_status & OPTIGA_CMD_ENTER_HANDLER_CALL_MASK)))
+        {
+#ifdef OPTIGA_LIB_ENABLE_LATENCY_HISTOGRAM
+            if ((TRUE == me->latency_pending) && (TRUE == me->latency_failed))
+            {
+                optiga_cmd_latency_record(me, me->latency_exec_us);
+            }
+#endif
+            me->exit_status = OPTIGA_DEVICE_ERROR;
+            me->cmd_next_execution_state = OPTIGA_CMD_EXEC_ERROR_HANDLER;
+            *exit_loop = FALSE;
+            break;
+        }
+#endif
         me->exit_status = optiga_cmd_get_error_code_handler(me);
         if (((OPTIGA_LIB_SUCCESS != me->exit_status) && !(OPTIGA_DEVICE_ERROR & me->exit_status)) ||
             ((OPTIGA_DEVICE_ERROR == me->exit_status) &&
@@ -1482,13 +2145,13 @@ _STATIC_H void optiga_cmd_execute_process_optiga_response(optiga_cmd_t * me, uin
                     *exit_loop = FALSE;
                     break;
                 }
-                // for chaining, trigger preparing of next command
+                // for chaining, trigger preparing of next command; the lock is still held
                 else
                 {
                     pal_os_event_register_callback_oneshot(me->p_optiga->p_pal_os_event_ctx,
                                                            (register_callback)optiga_cmd_event_trigger_execute,
                                                            (void*)me,
-                                                           OPTIGA_CMD_SCHEDULER_IDLING_TIME_MS);
+                                                           OPTIGA_CMD_SCHEDULER_CHAINING_TIME_MS);
                     *exit_loop = TRUE;
 
 #ifdef OPTIGA_COMMS_SHIELDED_CONNECTION
@@ -1532,6 +2195,27 @@ _STATIC_H void optiga_cmd_execute_process_response(optiga_cmd_t * me, uint8_t *
         {
             case OPTIGA_CMD_EXEC_PROCESS_OPTIGA_RESPONSE:
             {
+                OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_CMD_RESPONSE, me->p_optiga->comms_rx_size);
+#ifdef OPTIGA_LIB_ENABLE_LATENCY_HISTOGRAM
+                // A failed APDU is recorded once its outcome is known: here when entered again
+                // after the error code read, which its transceive time then includes
+                if (TRUE == me->latency_pending)
+                {
+                    if (TRUE == me->latency_failed)
+                    {
+                        optiga_cmd_latency_record(me, me->latency_exec_us);
+                    }
+                    else if (OPTIGA_CMD_APDU_FAILURE == me->p_optiga->optiga_comms_buffer[OPTIGA_COMMS_DATA_OFFSET])
+                    {
+                        me->latency_failed = TRUE;
+                        me->latency_exec_us = optiga_comms_get_exec_time(me->p_optiga->p_optiga_comms);
+                    }
+                    else
+                    {
+                        optiga_cmd_latency_record(me, optiga_comms_get_exec_time(me->p_optiga->p_optiga_comms));
+                    }
+                }
+#endif
                 optiga_cmd_execute_process_optiga_response(me, exit_loop);
                 break;
             }
@@ -1566,6 +2250,10 @@ _STATIC_H void optiga_cmd_execute_process_response(optiga_cmd_t * me, uint8_t *
             }
             case OPTIGA_CMD_STATE_EXIT:
             {
+#ifdef OPTIGA_CMD_RANDOM_COALESCE
+                optiga_cmd_random_followers_done(me);
+#endif
+                OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_CMD_DONE, me->exit_status);
                 me->handler(me->caller_context, me->exit_status);
                 *exit_loop = TRUE;
                 break;
@@ -1584,6 +2272,10 @@ _STATIC_H void optiga_cmd_execute_error_handler(const optiga_cmd_t * me, uint8_t
     {
         //lint --e{534} suppress "The return code is not checked because this is exit state."
         optiga_cmd_release_lock(me);
+#ifdef OPTIGA_CMD_RANDOM_COALESCE
+        optiga_cmd_random_followers_done(me);
+#endif
+        OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_CMD_DONE, me->exit_status);
         me->handler(me->caller_context, me->exit_status);
         *exit_loop = TRUE;
     } while (FALSE);
@@ -1660,7 +2352,7 @@ optiga_cmd_t * optiga_cmd_create(uint8_t optiga_instance_id, callback_handler_t
             break;
         }
 
-        me = (optiga_cmd_t *)pal_os_calloc(1, sizeof(optiga_cmd_t));
+        me = (optiga_cmd_t *)optiga_lib_pool_alloc(&g_optiga_cmd_pool);
         if (NULL == me)
         {
             break;
@@ -1668,18 +2360,23 @@ optiga_cmd_t * optiga_cmd_create(uint8_t optiga_instance_id, callback_handler_t
 
         me->handler = handler;
         me->caller_context = caller_context;
+        me->priority = OPTIGA_CMD_PRIORITY_NORMAL;
+        me->session_lease_ms = 0;
 
         me->p_optiga = g_optiga_list[optiga_instance_id];
         me->optiga_context_datastore_id = g_hibernate_datastore_id_list[optiga_instance_id];
 
         if (FALSE == me->p_optiga->instance_init_state)
         {
-            //create pal os event
-            me->p_optiga->p_pal_os_event_ctx = pal_os_event_create(optiga_cmd_queue_scheduler, me->p_optiga);
-            me->p_optiga->p_optiga_comms = optiga_comms_create(optiga_cmd_execute_handler, me);
-            if (NULL == me->p_optiga->p_optiga_comms)
+            //create pal os event, once per instance as each event owns a timer and task
+            if (NULL == me->p_optiga->p_pal_os_event_ctx)
+            {
+                me->p_optiga->p_pal_os_event_ctx = pal_os_event_create(optiga_cmd_queue_scheduler, me->p_optiga);
+            }
+            me->p_optiga->p_optiga_comms = optiga_comms_create(optiga_instance_id, optiga_cmd_execute_handler, me);
+            if ((NULL == me->p_optiga->p_pal_os_event_ctx) || (NULL == me->p_optiga->p_optiga_comms))
             {
-                pal_os_free(me);
+                optiga_lib_pool_free(&g_optiga_cmd_pool, me);
                 me = NULL;
                 break;
             }
@@ -1704,7 +2401,7 @@ optiga_lib_status_t optiga_cmd_destroy(optiga_cmd_t * me)
             return_status = optiga_cmd_release_session(me);
             // attach optiga cmd queue entry
             optiga_cmd_queue_deassign_slot(me);
-            pal_os_free(me);
+            optiga_lib_pool_free(&g_optiga_cmd_pool, me);
             //lint --e{838} suppress "Release session API returns success. Status is checked for future enhancements"
             return_status = OPTIGA_LIB_SUCCESS;
         }
@@ -2117,6 +2814,13 @@ _STATIC_H optiga_lib_status_t optiga_cmd_get_data_object_handler(optiga_cmd_t *
                     (p_optiga_read_data->accumulated_size == p_optiga_read_data->bytes_to_read))
                 {
                     *(p_optiga_read_data->ref_bytes_to_read) = p_optiga_read_data->accumulated_size;
+#ifdef OPTIGA_CMD_GOVERNOR
+                    if ((OPTIGA_CMD_SEC_OID == p_optiga_read_data->oid) && (0U == p_optiga_read_data->offset) &&
+                        (0U == p_optiga_read_data->data_or_metadata))
+                    {
+                        optiga_cmd_governor_sync(me->p_optiga, p_optiga_read_data->buffer[0]);
+                    }
+#endif
                     p_optiga_read_data->accumulated_size = 0;
                     p_optiga_read_data->last_read_size = 0;
                 }
@@ -2263,6 +2967,126 @@ optiga_lib_status_t optiga_cmd_set_data_object(optiga_cmd_t * me, uint8_t cmd_pa
 }
 
 #if defined (OPTIGA_CRYPT_RANDOM_ENABLED) || defined (OPTIGA_CRYPT_RSA_PRE_MASTER_SECRET_ENABLED) || defined (OPTIGA_CRYPT_GENERATE_AUTH_CODE_ENABLED)
+_STATIC_H optiga_lib_status_t optiga_cmd_get_random_handler(optiga_cmd_t * me);
+
+#ifdef OPTIGA_CMD_RANDOM_COALESCE
+/*
+* Takes the plain TRNG/DRNG requests waiting in the queue that fit into the GetRandom of me off
+* the queue, so one APDU serves them all. Returns the length to request.
+* Runs in the event context like the scheduler, which cannot pick a slot meanwhile.
+*/
+_STATIC_H uint16_t optiga_cmd_random_coalesce(optiga_cmd_t * me, const optiga_get_random_params_t * p_params)
+{
+    optiga_context_t * p_optiga = me->p_optiga;
+    const optiga_cmd_t * p_other;
+    const optiga_get_random_params_t * p_other_params;
+    uint32_t total = p_params->random_data_length;
+    uint32_t slot_mask;
+    uint8_t index;
+
+    pal_os_lock_enter_critical_section();
+    p_optiga->random_leader = me;
+    p_optiga->random_followers = 0;
+    slot_mask = p_optiga->queue_mask[OPTIGA_CMD_QUEUE_MASK_REQUEST] &
+                p_optiga->queue_mask[OPTIGA_CMD_QUEUE_MASK_REQUEST_LOCK];
+    while (0U != slot_mask)
+    {
+        index = optiga_cmd_queue_first_slot(slot_mask);
+        slot_mask &= (slot_mask - 1U);
+        p_other = (const optiga_cmd_t *)p_optiga->optiga_cmd_execution_queue[index].registered_ctx;
+        p_other_params = (const optiga_get_random_params_t *)p_other->p_input;
+        if ((optiga_cmd_get_random_handler != p_other->cmd_hdlrs) ||
+            (me->cmd_param != p_other->cmd_param) ||
+            (TRUE == p_other_params->store_in_session) ||
+            ((total + p_other_params->random_data_length) > OPTIGA_CMD_RANDOM_COALESCE_MAX_BYTES) ||
+            ((total + p_other_params->random_data_length + OPTIGA_CMD_APDU_HEADER_SIZE) > OPTIGA_MAX_COMMS_BUFFER_SIZE))
+        {
+            continue;
+        }
+#ifdef OPTIGA_COMMS_SHIELDED_CONNECTION
+        if ((me->protection_level != p_other->protection_level) || (me->protocol_version != p_other->protocol_version))
+        {
+            continue;
+        }
+#endif //OPTIGA_COMMS_SHIELDED_CONNECTION
+        total += p_other_params->random_data_length;
+        p_optiga->random_followers |= ((uint32_t)1U << index);
+        // The slot keeps its registered context, optiga_cmd_random_followers_done() ends it
+        optiga_cmd_queue_set_slot(p_optiga, index, OPTIGA_CMD_QUEUE_SLOT_STATE, OPTIGA_CMD_QUEUE_ASSIGNED);
+        optiga_cmd_queue_set_slot(p_optiga, index, OPTIGA_CMD_QUEUE_SLOT_LOCK_TYPE, OPTIGA_CMD_QUEUE_NO_REQUEST);
+    }
+    pal_os_lock_exit_critical_section();
+    return ((uint16_t)total);
+}
+
+/*
+* Hands every request that rode on the GetRandom of me its part of the response, in slot order
+* after the bytes of me
+*/
+_STATIC_H void optiga_cmd_random_split(const optiga_cmd_t * me, const optiga_get_random_params_t * p_params)
+{
+    const optiga_context_t * p_optiga = me->p_optiga;
+    const optiga_get_random_params_t * p_other_params;
+    uint32_t slot_mask = p_optiga->random_followers;
+    uint16_t offset = OPTIGA_CMD_APDU_INDATA_OFFSET + p_params->random_data_length;
+    uint8_t index;
+
+    while (0U != slot_mask)
+    {
+        index = optiga_cmd_queue_first_slot(slot_mask);
+        slot_mask &= (slot_mask - 1U);
+        p_other_params = (const optiga_get_random_params_t *)
+                         ((const optiga_cmd_t *)p_optiga->optiga_cmd_execution_queue[index].registered_ctx)->p_input;
+        pal_os_memcpy(p_other_params->random_data, p_optiga->optiga_comms_buffer + offset,
+                      p_other_params->random_data_length);
+        offset += p_other_params->random_data_length;
+    }
+}
+
+/*
+* Completes the requests that rode on the GetRandom of me once it has ended. After a failure they
+* go back into the queue and are issued on their own.
+*/
+_STATIC_H void optiga_cmd_random_followers_done(const optiga_cmd_t * me)
+{
+    optiga_context_t * p_optiga = me->p_optiga;
+    optiga_cmd_t * p_other;
+    uint32_t slot_mask;
+    uint8_t index;
+
+    pal_os_lock_enter_critical_section();
+    if (me != p_optiga->random_leader)
+    {
+        pal_os_lock_exit_critical_section();
+        return;
+    }
+    slot_mask = p_optiga->random_followers;
+    p_optiga->random_leader = NULL;
+    p_optiga->random_followers = 0;
+    pal_os_lock_exit_critical_section();
+
+    while (0U != slot_mask)
+    {
+        index = optiga_cmd_queue_first_slot(slot_mask);
+        slot_mask &= (slot_mask - 1U);
+        p_other = (optiga_cmd_t *)p_optiga->optiga_cmd_execution_queue[index].registered_ctx;
+        if (OPTIGA_LIB_SUCCESS == me->exit_status)
+        {
+            p_optiga->random_coalesced++;
+            p_other->exit_status = OPTIGA_LIB_SUCCESS;
+            p_other->cmd_sub_execution_state = OPTIGA_CMD_STATE_EXIT;
+            OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_CMD_DONE, p_other->exit_status);
+            p_other->handler(p_other->caller_context, p_other->exit_status);
+        }
+        else
+        {
+            // Still at OPTIGA_CMD_EXEC_PREPARE_APDU, it sends its own GetRandom when scheduled
+            optiga_cmd_queue_update_slot(p_other, OPTIGA_CMD_QUEUE_REQUEST_LOCK);
+        }
+    }
+}
+#endif //OPTIGA_CMD_RANDOM_COALESCE
+
 /*
 * Get Random handler
 */
@@ -2272,12 +3096,19 @@ _STATIC_H optiga_lib_status_t optiga_cmd_get_random_handler(optiga_cmd_t * me)
     optiga_get_random_params_t * p_random_params = (optiga_get_random_params_t *)me->p_input;
     optiga_lib_status_t return_status = OPTIGA_CMD_ERROR;
     uint16_t index_for_data = OPTIGA_CMD_APDU_INDATA_OFFSET;
+    uint16_t random_data_length = p_random_params->random_data_length;
 
     switch ((uint8_t)me->cmd_next_execution_state)
     {
         case OPTIGA_CMD_EXEC_PREPARE_COMMAND:
         {
             OPTIGA_CMD_LOG_MESSAGE("Sending get random command...");
+#ifdef OPTIGA_CMD_RANDOM_COALESCE
+            if (FALSE == p_random_params->store_in_session)
+            {
+                random_data_length = optiga_cmd_random_coalesce(me, p_random_params);
+            }
+#endif
             /// APDU header size + length of random
             /// OID size in case of param 0x04
             /// 0x41, Length and prepending optional data
@@ -2292,7 +3123,7 @@ _STATIC_H optiga_lib_status_t optiga_cmd_get_random_handler(optiga_cmd_t * me)
             }
             /// Copy the random data length
             optiga_common_set_uint16(&me->p_optiga->optiga_comms_buffer[index_for_data],
-                                     p_random_params->random_data_length);
+                                     random_data_length);
             index_for_data += OPTIGA_CMD_UINT16_SIZE_IN_BYTES;
 
             if (TRUE == p_random_params->store_in_session)
@@ -2343,6 +3174,12 @@ _STATIC_H optiga_lib_status_t optiga_cmd_get_random_handler(optiga_cmd_t * me)
                 pal_os_memcpy(p_random_params->random_data,
                               me->p_optiga->optiga_comms_buffer + OPTIGA_CMD_APDU_INDATA_OFFSET,
                               p_random_params->random_data_length);
+#ifdef OPTIGA_CMD_RANDOM_COALESCE
+                if (me == me->p_optiga->random_leader)
+                {
+                    optiga_cmd_random_split(me, p_random_params);
+                }
+#endif
             }
             OPTIGA_CMD_LOG_MESSAGE("Response of get random command is processed...");
             return_status = OPTIGA_LIB_SUCCESS;
@@ -4026,6 +4863,7 @@ _STATIC_H optiga_lib_status_t optiga_cmd_enc_dec_sym_handler(optiga_cmd_t * me)
         case OPTIGA_CMD_EXEC_PROCESS_RESPONSE:
         {
             OPTIGA_CMD_LOG_MESSAGE("Processing response for symmetric encrypt/decrypt command...");
+#ifdef OPTIGA_CRYPT_CLEAR_AUTO_STATE_ENABLED
             // Return success when operation mode is clear auto state
             if (OPTIGA_CMD_OPERATION_MODE_CLEAR_AUTO_STATE == p_optiga_sym_enc_dec_params->operation_mode)
             {
@@ -4033,6 +4871,7 @@ _STATIC_H optiga_lib_status_t optiga_cmd_enc_dec_sym_handler(optiga_cmd_t * me)
                 return_status = OPTIGA_LIB_SUCCESS;
                 break;
             }
+#endif
             // check if the write was successful
             if (OPTIGA_CMD_APDU_FAILURE == me->p_optiga->optiga_comms_buffer[OPTIGA_COMMS_DATA_OFFSET])
             {
@@ -4126,7 +4965,7 @@ _STATIC_H optiga_lib_status_t optiga_cmd_enc_dec_sym_handler(optiga_cmd_t * me)
                     else
                     {
                         me->cmd_sub_execution_state = OPTIGA_CMD_STATE_EXIT;
-                        pal_os_event_start(me->p_optiga->p_pal_os_event_ctx, optiga_cmd_queue_scheduler, me->p_optiga);
+                        optiga_cmd_queue_dispatch_next(me->p_optiga);
                     }
                 }
             }
@@ -4237,6 +5076,102 @@ optiga_lib_status_t optiga_cmd_encrypt_sym(optiga_cmd_t * me,
 }
 #endif //(OPTIGA_CRYPT_SYM_ENCRYPT_ENABLED) || (OPTIGA_CRYPT_HMAC_ENABLED)
 
+#if defined (OPTIGA_CRYPT_RANDOM_ENABLED) && defined (OPTIGA_CRYPT_SYM_ENCRYPT_ENABLED)
+/*
+* GetRandom half of a random IV + Encrypt Sym request. Its response hands the instance over to the
+* Encrypt Sym handler, whose command then follows as the next chained APDU under the same strict lock
+*/
+_STATIC_H optiga_lib_status_t optiga_cmd_random_encrypt_sym_handler(optiga_cmd_t * me)
+{
+    optiga_random_encrypt_sym_params_t * p_params = (optiga_random_encrypt_sym_params_t *)me->p_input;
+    optiga_lib_status_t return_status = OPTIGA_CMD_ERROR;
+    uint16_t index_for_data = OPTIGA_CMD_APDU_INDATA_OFFSET;
+
+    switch ((uint8_t)me->cmd_next_execution_state)
+    {
+        case OPTIGA_CMD_EXEC_PREPARE_COMMAND:
+        {
+            OPTIGA_CMD_LOG_MESSAGE("Sending get random command for the IV...");
+            /// Copy the random data length
+            optiga_common_set_uint16(&me->p_optiga->optiga_comms_buffer[index_for_data],
+                                     p_params->encrypt.iv_length);
+            index_for_data += OPTIGA_CMD_UINT16_SIZE_IN_BYTES;
+
+            optiga_cmd_prepare_apdu_header(OPTIGA_CMD_GET_RANDOM,
+                                           p_params->rng_type,
+                                           (index_for_data - OPTIGA_CMD_APDU_INDATA_OFFSET),
+                                           me->p_optiga->optiga_comms_buffer + OPTIGA_COMMS_DATA_OFFSET);
+
+            me->p_optiga->comms_tx_size = index_for_data - OPTIGA_COMMS_DATA_OFFSET;
+
+            return_status = OPTIGA_LIB_SUCCESS;
+        }
+        break;
+        case OPTIGA_CMD_EXEC_PROCESS_RESPONSE:
+        {
+            OPTIGA_CMD_LOG_MESSAGE("Processing response for get random command for the IV...");
+            if (OPTIGA_CMD_APDU_SUCCESS != me->p_optiga->optiga_comms_buffer[OPTIGA_COMMS_DATA_OFFSET])
+            {
+                OPTIGA_CMD_LOG_MESSAGE("Error in processing get random response...");
+                //lint --e{835} suppress "SET_DEV_ERROR_NOTIFICATION is generically written for any unsigned interger value"
+                //lint --e{845} suppress "SET_DEV_ERROR_NOTIFICATION is generically written for any unsigned interger value"
+                SET_DEV_ERROR_NOTIFICATION(OPTIGA_CMD_EXIT_HANDLER_CALL);
+                if (NULL != p_params->encrypt.out_data_length)
+                {
+                    *p_params->encrypt.out_data_length = 0;
+                }
+                break;
+            }
+            pal_os_memcpy(p_params->random_iv,
+                          me->p_optiga->optiga_comms_buffer + OPTIGA_CMD_APDU_INDATA_OFFSET,
+                          p_params->encrypt.iv_length);
+
+            // The Encrypt Sym command is prepared next, without going back to the scheduler
+            me->p_input = &p_params->encrypt;
+            me->cmd_hdlrs = optiga_cmd_enc_dec_sym_handler;
+            //lint --e{835} suppress "Upper 8 bits of apdu_data carry the operation mode"
+            me->apdu_data = OPTIGA_CMD_SET_APDU_DATA(OPTIGA_CMD_ENCRYPT_SYM, p_params->encrypt.operation_mode);
+            me->chaining_ongoing = TRUE;
+            OPTIGA_CMD_LOG_MESSAGE("Response of get random command for the IV is processed...");
+            return_status = OPTIGA_LIB_SUCCESS;
+        }
+        break;
+        default:
+            break;
+    }
+
+    return (return_status);
+}
+
+optiga_lib_status_t optiga_cmd_random_encrypt_sym(optiga_cmd_t * me,
+                                                  uint8_t cmd_param,
+                                                  optiga_random_encrypt_sym_params_t * params)
+{
+    optiga_cmd_sub_state_t next_execution_sub_state = OPTIGA_CMD_EXEC_REQUEST_STRICT_LOCK;
+    OPTIGA_CMD_LOG_MESSAGE(__FUNCTION__);
+    params->encrypt.sent_data_length = 0;
+    params->encrypt.current_sequence = OPTIGA_CMD_RESET_SEQUENCE;
+    params->encrypt.received_data_length = 0;
+
+    // A strict sequence the instance still holds (encrypt start without final) is acquired again
+    if ((OPTIGA_CMD_QUEUE_REQUEST_STRICT_LOCK == optiga_cmd_queue_get_state_of(me, OPTIGA_CMD_QUEUE_SLOT_LOCK_TYPE)) &&
+        (OPTIGA_CMD_QUEUE_PROCESSING == optiga_cmd_queue_get_state_of(me, OPTIGA_CMD_QUEUE_SLOT_STATE)))
+    {
+        next_execution_sub_state = OPTIGA_CMD_EXEC_RESET_STRICT_LOCK;
+    }
+    optiga_cmd_execute(me,
+                       cmd_param,
+                       optiga_cmd_random_encrypt_sym_handler,
+                       OPTIGA_CMD_EXEC_PREPARE_COMMAND,
+                       next_execution_sub_state,
+                       params,
+                       //lint --e{835} suppress "Upper 8 bits of apdu_data is kept as zero and is reserved for future enhancements"
+                       OPTIGA_CMD_SET_APDU_DATA(OPTIGA_CMD_GET_RANDOM, OPTIGA_CMD_ZERO_LENGTH_OR_VALUE));
+
+    return (OPTIGA_LIB_SUCCESS);
+}
+#endif //(OPTIGA_CRYPT_RANDOM_ENABLED) && (OPTIGA_CRYPT_SYM_ENCRYPT_ENABLED)
+
 #if defined (OPTIGA_CRYPT_SYM_DECRYPT_ENABLED) || defined (OPTIGA_CRYPT_HMAC_VERIFY_ENABLED) ||\
     defined (OPTIGA_CRYPT_CLEAR_AUTO_STATE_ENABLED)
 
@@ -4378,7 +5313,7 @@ _STATIC_H optiga_lib_status_t optiga_cmd_set_object_protected_handler(optiga_cmd
             else
             {
                 me->cmd_sub_execution_state = OPTIGA_CMD_STATE_EXIT;
-                pal_os_event_start(me->p_optiga->p_pal_os_event_ctx, optiga_cmd_queue_scheduler, me->p_optiga);
+                optiga_cmd_queue_dispatch_next(me->p_optiga);
             }
             OPTIGA_CMD_LOG_MESSAGE("Response of set data object command is processed...");
             return_status = OPTIGA_LIB_SUCCESS;
@@ -37,6 +37,8 @@
 
 #include "optiga/common/optiga_lib_types.h"
 #include "optiga/common/optiga_lib_common.h"
+#include "optiga/pal/pal_os_lock.h"
+#include <string.h>
 
 void optiga_common_set_uint16 (uint8_t * p_output_buffer,uint16_t two_byte_value)
 {
@@ -67,6 +69,73 @@ void optiga_common_get_uint16 (const uint8_t * p_input_buffer,uint16_t* p_two_by
     *p_two_byte_value |= (uint16_t)(*(p_input_buffer+1));
 }
 
+void * optiga_lib_pool_alloc(optiga_lib_pool_t * p_pool)
+{
+    uint8_t * p_block = NULL;
+    uint8_t index;
+
+    pal_os_lock_enter_critical_section();
+    for (index = 0; index < p_pool->block_count; index++)
+    {
+        if (0U == (p_pool->used_mask & ((uint32_t)1U << index)))
+        {
+            p_pool->used_mask |= ((uint32_t)1U << index);
+            p_pool->blocks_in_use++;
+            if (p_pool->blocks_in_use > p_pool->peak_in_use)
+            {
+                p_pool->peak_in_use = p_pool->blocks_in_use;
+            }
+            p_block = p_pool->p_blocks + ((uint32_t)index * p_pool->block_size);
+            break;
+        }
+    }
+    pal_os_lock_exit_critical_section();
+
+    if (NULL != p_block)
+    {
+        memset(p_block, 0x00, p_pool->block_size);
+    }
+    return (p_block);
+}
+
+void optiga_lib_pool_free(optiga_lib_pool_t * p_pool, const void * p_block)
+{
+    const uint8_t * p_byte = (const uint8_t *)p_block;
+    uint32_t offset;
+    uint8_t index;
+
+    do
+    {
+        if ((p_byte < p_pool->p_blocks) ||
+            (p_byte >= (p_pool->p_blocks + ((uint32_t)p_pool->block_count * p_pool->block_size))))
+        {
+            break;
+        }
+        offset = (uint32_t)(p_byte - p_pool->p_blocks);
+        if (0U != (offset % p_pool->block_size))
+        {
+            break;
+        }
+        index = (uint8_t)(offset / p_pool->block_size);
+
+        pal_os_lock_enter_critical_section();
+        if (0U != (p_pool->used_mask & ((uint32_t)1U << index)))
+        {
+            p_pool->used_mask &= ~((uint32_t)1U << index);
+            p_pool->blocks_in_use--;
+        }
+        pal_os_lock_exit_critical_section();
+    } while (FALSE);
+}
+
+void optiga_lib_pool_get_stats(const optiga_lib_pool_t * p_pool, optiga_lib_pool_stats_t * p_stats)
+{
+    p_stats->capacity = p_pool->block_count;
+    p_stats->in_use = p_pool->blocks_in_use;
+    p_stats->peak_in_use = p_pool->peak_in_use;
+    p_stats->block_size = p_pool->block_size;
+}
+
 /**
 * @}
 */
@@ -0,0 +1,212 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2020 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file    optiga_lib_latency.c
+*
+* \brief   This file implements the per command latency histograms.
+*
+* \ingroup  grOptigaLibCommon
+*
+* @{
+*/
+
+#include "optiga/common/optiga_lib_latency.h"
+#include "optiga/common/optiga_lib_logger.h"
+#include "optiga/pal/pal_os_lock.h"
+
+#ifdef OPTIGA_LIB_ENABLE_LATENCY_HISTOGRAM
+
+/// @cond hidden
+
+#define OPTIGA_LIB_LATENCY_LINE_LENGTH      (160U)
+
+_STATIC_H optiga_lib_latency_command_t optiga_lib_latency_table[OPTIGA_LIB_LATENCY_COMMANDS];
+// Entries of the table in use, filled in order of first use
+_STATIC_H uint8_t optiga_lib_latency_used = 0;
+_STATIC_H uint32_t optiga_lib_latency_dropped = 0;
+
+_STATIC_H uint8_t optiga_lib_latency_bucket(uint32_t value_us)
+{
+    uint8_t bucket = 0;
+
+    while ((value_us > 1U) && (bucket < (OPTIGA_LIB_LATENCY_BUCKETS - 1U)))
+    {
+        value_us >>= 1;
+        bucket++;
+    }
+    return (bucket);
+}
+
+_STATIC_H void optiga_lib_latency_add(optiga_lib_latency_histogram_t * p_histogram, uint32_t value_us)
+{
+    p_histogram->count++;
+    p_histogram->sum_us += value_us;
+    if (value_us > p_histogram->max_us)
+    {
+        p_histogram->max_us = value_us;
+    }
+    p_histogram->buckets[optiga_lib_latency_bucket(value_us)]++;
+}
+
+_STATIC_H void optiga_lib_latency_print(const optiga_lib_latency_command_t * p_command, uint8_t metric)
+{
+    static const char_t * const names[OPTIGA_LIB_LATENCY_METRICS] = {"queue", "xcv", "exec"};
+    char_t line[OPTIGA_LIB_LATENCY_LINE_LENGTH];
+    const optiga_lib_latency_histogram_t * p_histogram = &p_command->metric[metric];
+
+    (void)snprintf(line, sizeof(line),
+                   "[optiga latency]  : cmd 0x%02X %-4s %-5s n %lu mean %lu p50 %lu p90 %lu p99 %lu max %lu us",
+                   p_command->command_code, (TRUE == p_command->failed) ? "fail" : "", names[metric],
+                   (unsigned long)p_histogram->count,
+                   (unsigned long)((0U != p_histogram->count) ? (p_histogram->sum_us / p_histogram->count) : 0U),
+                   (unsigned long)optiga_lib_latency_percentile(p_histogram, 50),
+                   (unsigned long)optiga_lib_latency_percentile(p_histogram, 90),
+                   (unsigned long)optiga_lib_latency_percentile(p_histogram, 99),
+                   (unsigned long)p_histogram->max_us);
+    optiga_lib_print_string_with_newline(line);
+}
+
+/// @endcond
+
+void optiga_lib_latency_record(uint8_t command_code, uint32_t queue_us, uint32_t transceive_us, uint32_t exec_us,
+                               uint8_t failed)
+{
+    optiga_lib_latency_command_t * p_command = NULL;
+    uint8_t index;
+
+    pal_os_lock_enter_critical_section();
+    for (index = 0; index < optiga_lib_latency_used; index++)
+    {
+        if ((command_code == optiga_lib_latency_table[index].command_code) &&
+            (failed == optiga_lib_latency_table[index].failed))
+        {
+            p_command = &optiga_lib_latency_table[index];
+            break;
+        }
+    }
+    if ((NULL == p_command) && (optiga_lib_latency_used < OPTIGA_LIB_LATENCY_COMMANDS))
+    {
+        p_command = &optiga_lib_latency_table[optiga_lib_latency_used++];
+        p_command->command_code = command_code;
+        p_command->failed = failed;
+    }
+    if (NULL == p_command)
+    {
+        optiga_lib_latency_dropped++;
+    }
+    else
+    {
+        optiga_lib_latency_add(&p_command->metric[OPTIGA_LIB_LATENCY_QUEUE], queue_us);
+        optiga_lib_latency_add(&p_command->metric[OPTIGA_LIB_LATENCY_TRANSCEIVE], transceive_us);
+        // Commands answered without a measured execution (errors before the last fragment) are left out
+        if (0U != exec_us)
+        {
+            optiga_lib_latency_add(&p_command->metric[OPTIGA_LIB_LATENCY_EXEC], exec_us);
+        }
+    }
+    pal_os_lock_exit_critical_section();
+}
+
+uint8_t optiga_lib_latency_get(optiga_lib_latency_command_t * p_commands, uint8_t max_commands)
+{
+    uint8_t count;
+
+    pal_os_lock_enter_critical_section();
+    count = (optiga_lib_latency_used < max_commands) ? optiga_lib_latency_used : max_commands;
+    memcpy(p_commands, optiga_lib_latency_table, count * sizeof(optiga_lib_latency_command_t));
+    pal_os_lock_exit_critical_section();
+    return (count);
+}
+
+uint32_t optiga_lib_latency_percentile(const optiga_lib_latency_histogram_t * p_histogram, uint8_t percent)
+{
+    uint32_t rank;
+    uint32_t seen = 0;
+    uint8_t bucket;
+
+    if (0U == p_histogram->count)
+    {
+        return (0U);
+    }
+    // Nearest rank
+    rank = (((uint32_t)percent * p_histogram->count) + 99U) / 100U;
+    for (bucket = 0; bucket < (OPTIGA_LIB_LATENCY_BUCKETS - 1U); bucket++)
+    {
+        seen += p_histogram->buckets[bucket];
+        if (seen >= rank)
+        {
+            // Bucket upper bound, never above the largest sample
+            return ((((2UL << bucket) - 1U) < p_histogram->max_us) ? ((2UL << bucket) - 1U) : p_histogram->max_us);
+        }
+    }
+    return (p_histogram->max_us);
+}
+
+uint32_t optiga_lib_latency_get_dropped(void)
+{
+    return (optiga_lib_latency_dropped);
+}
+
+void optiga_lib_latency_dump(void)
+{
+    optiga_lib_latency_command_t command;
+    uint8_t index;
+    uint8_t metric;
+    uint8_t used;
+
+    pal_os_lock_enter_critical_section();
+    used = optiga_lib_latency_used;
+    pal_os_lock_exit_critical_section();
+
+    for (index = 0; index < used; index++)
+    {
+        // One entry at a time, printing is too slow for the critical section
+        pal_os_lock_enter_critical_section();
+        command = optiga_lib_latency_table[index];
+        pal_os_lock_exit_critical_section();
+        for (metric = 0; metric < OPTIGA_LIB_LATENCY_METRICS; metric++)
+        {
+            optiga_lib_latency_print(&command, metric);
+        }
+    }
+}
+
+void optiga_lib_latency_clear(void)
+{
+    pal_os_lock_enter_critical_section();
+    memset(optiga_lib_latency_table, 0, sizeof(optiga_lib_latency_table));
+    optiga_lib_latency_used = 0;
+    optiga_lib_latency_dropped = 0;
+    pal_os_lock_exit_critical_section();
+}
+
+#endif
+
+/**
+* @}
+*/
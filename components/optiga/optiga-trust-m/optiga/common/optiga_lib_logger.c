@@ -39,10 +39,27 @@
 #include "optiga/common/optiga_lib_logger.h"
 #include "optiga/pal/pal_logger.h"
 #include "optiga/pal/pal_os_memory.h"
+#ifdef OPTIGA_LIB_LOGGER_BINARY
+#include "optiga/pal/pal_os_lock.h"
+#include "optiga/pal/pal_os_timer.h"
+#endif
 
 
 #define OPTIGA_LOGGER_NEW_LINE_CHAR          0x0D, 0x0A
 
+#ifdef OPTIGA_LIB_LOGGER_BINARY
+    #ifndef OPTIGA_LIB_LOGGER_BINARY_RING_BYTES
+        /// Size of the binary log ring
+        #define OPTIGA_LIB_LOGGER_BINARY_RING_BYTES  (4096U)
+    #endif
+    #ifndef OPTIGA_LIB_LOGGER_BINARY_MAX_DATA
+        /// Data bytes kept per record, longer data is truncated
+        #define OPTIGA_LIB_LOGGER_BINARY_MAX_DATA    (512U)
+    #endif
+    /// Text of a message the formatter passes on, optiga_lib_text_message() prints into 400 bytes
+    #define OPTIGA_LIB_LOGGER_BINARY_MAX_TEXT        (300U)
+#endif
+
 extern pal_logger_t logger_console;
 
 /*Convert Byte to HexString */
@@ -113,6 +130,8 @@ _STATIC_H void optiga_lib_word_to_hex_string(uint16_t value,
 
 }
 
+_STATIC_H void optiga_lib_text_string_with_newline(const char_t * p_log_string);
+
 /* Converts the uint16 value to hex string format */
 _STATIC_H void optiga_lib_print_length_of_data(uint16_t value)
 {
@@ -124,10 +143,10 @@ _STATIC_H void optiga_lib_print_length_of_data(uint16_t value)
     optiga_lib_word_to_hex_string(value,uint16t_conv_buffer);
     strcat(print_buffer,(char_t *)uint16t_conv_buffer); 
     
-    optiga_lib_print_string_with_newline(print_buffer);
+    optiga_lib_text_string_with_newline(print_buffer);
 }
 
-void optiga_lib_print_string(const char_t * p_log_string)
+_STATIC_H void optiga_lib_text_string(const char_t * p_log_string)
 {
     if (NULL == p_log_string)
     {
@@ -138,7 +157,7 @@ void optiga_lib_print_string(const char_t * p_log_string)
     pal_logger_write(&logger_console, (const uint8_t *)p_log_string, strlen(p_log_string));
 }
 
-void optiga_lib_print_string_with_newline(const char_t * p_log_string)
+_STATIC_H void optiga_lib_text_string_with_newline(const char_t * p_log_string)
 {
     uint8_t new_line_characters [2] = {OPTIGA_LOGGER_NEW_LINE_CHAR};
 
@@ -154,9 +173,9 @@ void optiga_lib_print_string_with_newline(const char_t * p_log_string)
 
 }
 
-void optiga_lib_print_message(const char_t * p_log_string,
-                              const char_t * p_log_layer,
-                              const char_t * p_log_color)                                  
+_STATIC_H void optiga_lib_text_message(const char_t * p_log_string,
+                                       const char_t * p_log_layer,
+                                       const char_t * p_log_color)
 {
     uint8_t new_line_characters[2] = {OPTIGA_LOGGER_NEW_LINE_CHAR};
     char_t color_buffer[400];
@@ -173,9 +192,9 @@ void optiga_lib_print_message(const char_t * p_log_string,
     pal_logger_write(&logger_console, new_line_characters, 2);
 }
 
-void optiga_lib_print_status(const char_t * p_log_layer,
-                             const char_t * p_log_color,
-                             uint16_t return_value)
+_STATIC_H void optiga_lib_text_status(const char_t * p_log_layer,
+                                      const char_t * p_log_color,
+                                      uint16_t return_value)
 {
     uint8_t new_line_characters[2] = {OPTIGA_LOGGER_NEW_LINE_CHAR};
     uint8_t uint16t_conv_buffer[10] = {0};
@@ -213,9 +232,9 @@ void optiga_lib_print_status(const char_t * p_log_layer,
     pal_logger_write(&logger_console, new_line_characters, 2);
 }
 
-void optiga_lib_print_array_hex_format(const uint8_t * p_log_string,
-                                       uint16_t length,
-                                       const char_t * p_log_color)
+_STATIC_H void optiga_lib_text_array_hex_format(const uint8_t * p_log_string,
+                                                uint16_t length,
+                                                const char_t * p_log_color)
 {
     uint8_t temp_buffer[350];
     char_t output_buffer[400];
@@ -255,6 +274,430 @@ void optiga_lib_print_array_hex_format(const uint8_t * p_log_string,
     }
 }
 
+#ifdef OPTIGA_LIB_LOGGER_BINARY
+/// @cond hidden
+#define OPTIGA_LIB_LOGGER_CHUNK_BYTES        (256U)
+
+// Layer strings by id, OPTIGA_LIB_LOGGER_LAYER_NONE first
+static const char_t * const optiga_lib_logger_layers[] =
+{
+    "",
+    OPTIGA_UTIL_SERVICE,
+    OPTIGA_CRYPT_SERVICE,
+    OPTIGA_COMMAND_LAYER,
+    OPTIGA_COMMUNICATION_LAYER
+};
+
+// Colors by index, OPTIGA_LIB_LOGGER_COLOR_DEFAULT first
+static const char_t * const optiga_lib_logger_colors[] =
+{
+    OPTIGA_LIB_LOGGER_COLOR_DEFAULT,
+    OPTIGA_LIB_LOGGER_COLOR_RED,
+    OPTIGA_LIB_LOGGER_COLOR_GREEN,
+    OPTIGA_LIB_LOGGER_COLOR_YELLOW,
+    OPTIGA_LIB_LOGGER_COLOR_BLUE,
+    OPTIGA_LIB_LOGGER_COLOR_MAGENTA,
+    OPTIGA_LIB_LOGGER_COLOR_CYAN,
+    OPTIGA_LIB_LOGGER_COLOR_LIGHT_GREY,
+    OPTIGA_LIB_LOGGER_COLOR_LIGHT_RED,
+    OPTIGA_LIB_LOGGER_COLOR_LIGHT_GREEN,
+    OPTIGA_LIB_LOGGER_COLOR_LIGHT_YELLOW,
+    OPTIGA_LIB_LOGGER_COLOR_LIGHT_BLUE,
+    OPTIGA_LIB_LOGGER_COLOR_LIGHT_MAGENTA,
+    OPTIGA_LIB_LOGGER_COLOR_LIGHT_CYAN
+};
+
+#define OPTIGA_LIB_LOGGER_COUNT(table)       (sizeof(table) / sizeof(table[0]))
+
+static uint8_t optiga_lib_logger_ring[OPTIGA_LIB_LOGGER_BINARY_RING_BYTES];
+// Offset of the oldest record and bytes in use
+static uint32_t optiga_lib_logger_tail = 0;
+static uint32_t optiga_lib_logger_used = 0;
+static uint32_t optiga_lib_logger_records = 0;
+static uint32_t optiga_lib_logger_dropped = 0;
+static volatile bool_t optiga_lib_logger_saving = FALSE;
+
+_STATIC_H void optiga_lib_logger_copy_in(uint32_t offset, const uint8_t * p_data, uint32_t length)
+{
+    const uint32_t first = OPTIGA_LIB_LOGGER_BINARY_RING_BYTES - offset;
+
+    if (length <= first)
+    {
+        pal_os_memcpy(&optiga_lib_logger_ring[offset], p_data, length);
+    }
+    else
+    {
+        pal_os_memcpy(&optiga_lib_logger_ring[offset], p_data, first);
+        pal_os_memcpy(optiga_lib_logger_ring, &p_data[first], length - first);
+    }
+}
+
+_STATIC_H void optiga_lib_logger_copy_out(uint32_t offset, uint8_t * p_data, uint32_t length)
+{
+    const uint32_t first = OPTIGA_LIB_LOGGER_BINARY_RING_BYTES - offset;
+
+    if (length <= first)
+    {
+        pal_os_memcpy(p_data, &optiga_lib_logger_ring[offset], length);
+    }
+    else
+    {
+        pal_os_memcpy(p_data, &optiga_lib_logger_ring[offset], first);
+        pal_os_memcpy(&p_data[first], optiga_lib_logger_ring, length - first);
+    }
+}
+
+// Takes the oldest record out of the ring, lock held. p_data NULL only skips it.
+_STATIC_H void optiga_lib_logger_take_oldest(optiga_lib_logger_record_t * p_header, uint8_t * p_data)
+{
+    uint32_t size;
+
+    optiga_lib_logger_copy_out(optiga_lib_logger_tail, (uint8_t *)p_header, sizeof(*p_header));
+    if (NULL != p_data)
+    {
+        optiga_lib_logger_copy_out((optiga_lib_logger_tail + sizeof(*p_header)) % OPTIGA_LIB_LOGGER_BINARY_RING_BYTES,
+                                   p_data,
+                                   p_header->length);
+    }
+    size = sizeof(*p_header) + p_header->length;
+    optiga_lib_logger_tail = (optiga_lib_logger_tail + size) % OPTIGA_LIB_LOGGER_BINARY_RING_BYTES;
+    optiga_lib_logger_used -= size;
+    optiga_lib_logger_records--;
+}
+
+_STATIC_H uint8_t optiga_lib_logger_layer_id(const char_t * p_log_layer)
+{
+    uint8_t index;
+
+    for (index = 1; index < OPTIGA_LIB_LOGGER_COUNT(optiga_lib_logger_layers); index++)
+    {
+        if (0 == strcmp(p_log_layer, optiga_lib_logger_layers[index]))
+        {
+            return (index);
+        }
+    }
+    return (OPTIGA_LIB_LOGGER_LAYER_OTHER);
+}
+
+_STATIC_H uint8_t optiga_lib_logger_color_index(const char_t * p_log_color)
+{
+    uint8_t index;
+
+    for (index = 1; index < OPTIGA_LIB_LOGGER_COUNT(optiga_lib_logger_colors); index++)
+    {
+        if (0 == strcmp(p_log_color, optiga_lib_logger_colors[index]))
+        {
+            return (index);
+        }
+    }
+    return (0);
+}
+
+/*
+ * Appends one record: the layer string (OPTIGA_LIB_LOGGER_LAYER_OTHER only) and the data,
+ * truncated to OPTIGA_LIB_LOGGER_BINARY_MAX_DATA bytes in total.
+ */
+_STATIC_H void optiga_lib_logger_record(uint8_t type,
+                                        const char_t * p_log_layer,
+                                        const char_t * p_log_color,
+                                        const uint8_t * p_data,
+                                        uint32_t length)
+{
+    optiga_lib_logger_record_t header;
+    optiga_lib_logger_record_t oldest;
+    uint8_t layer = OPTIGA_LIB_LOGGER_LAYER_NONE;
+    uint32_t prefix = 0;
+    uint32_t size;
+    uint32_t head;
+
+    if (NULL != p_log_layer)
+    {
+        layer = optiga_lib_logger_layer_id(p_log_layer);
+        if (OPTIGA_LIB_LOGGER_LAYER_OTHER == layer)
+        {
+            prefix = strlen(p_log_layer) + 1;
+            if (prefix > OPTIGA_LIB_LOGGER_BINARY_MAX_DATA)
+            {
+                prefix = OPTIGA_LIB_LOGGER_BINARY_MAX_DATA;
+            }
+        }
+    }
+    if ((prefix + length) > OPTIGA_LIB_LOGGER_BINARY_MAX_DATA)
+    {
+        length = OPTIGA_LIB_LOGGER_BINARY_MAX_DATA - prefix;
+        type |= OPTIGA_LIB_LOGGER_RECORD_TRUNCATED;
+    }
+
+    header.time_us = pal_os_timer_get_time_in_microseconds();
+    header.length = (uint16_t)(prefix + length);
+    header.type = type;
+    header.attributes = (uint8_t)(layer | ((NULL != p_log_color) ?
+                        (optiga_lib_logger_color_index(p_log_color) << OPTIGA_LIB_LOGGER_COLOR_SHIFT) : 0));
+    size = sizeof(header) + header.length;
+
+    pal_os_lock_enter_critical_section();
+    if ((TRUE == optiga_lib_logger_saving) || (size > OPTIGA_LIB_LOGGER_BINARY_RING_BYTES))
+    {
+        optiga_lib_logger_dropped++;
+    }
+    else
+    {
+        while ((OPTIGA_LIB_LOGGER_BINARY_RING_BYTES - optiga_lib_logger_used) < size)
+        {
+            optiga_lib_logger_take_oldest(&oldest, NULL);
+            optiga_lib_logger_dropped++;
+        }
+        head = (optiga_lib_logger_tail + optiga_lib_logger_used) % OPTIGA_LIB_LOGGER_BINARY_RING_BYTES;
+        optiga_lib_logger_copy_in(head, (const uint8_t *)&header, sizeof(header));
+        head = (head + sizeof(header)) % OPTIGA_LIB_LOGGER_BINARY_RING_BYTES;
+        if (0 != prefix)
+        {
+            optiga_lib_logger_copy_in(head, (const uint8_t *)p_log_layer, prefix - 1);
+            head = (head + prefix - 1) % OPTIGA_LIB_LOGGER_BINARY_RING_BYTES;
+            optiga_lib_logger_ring[head] = 0x00;
+            head = (head + 1) % OPTIGA_LIB_LOGGER_BINARY_RING_BYTES;
+        }
+        if (0 != length)
+        {
+            optiga_lib_logger_copy_in(head, p_data, length);
+        }
+        optiga_lib_logger_used += size;
+        optiga_lib_logger_records++;
+    }
+    pal_os_lock_exit_critical_section();
+}
+/// @endcond
+
+uint32_t optiga_lib_logger_process(uint32_t max_records)
+{
+    // One consumer at a time: the formatter task; the text helpers need a NUL after the data
+    static uint8_t data[OPTIGA_LIB_LOGGER_BINARY_MAX_DATA + 1];
+    optiga_lib_logger_record_t header;
+    const char_t * p_layer;
+    const char_t * p_color;
+    const char_t * p_text;
+    uint8_t layer;
+    uint8_t color;
+    uint32_t done = 0;
+
+    while (done < max_records)
+    {
+        pal_os_lock_enter_critical_section();
+        if ((TRUE == optiga_lib_logger_saving) || (0 == optiga_lib_logger_records))
+        {
+            pal_os_lock_exit_critical_section();
+            break;
+        }
+        optiga_lib_logger_take_oldest(&header, data);
+        pal_os_lock_exit_critical_section();
+        data[header.length] = 0x00;
+        done++;
+
+        layer = header.attributes & OPTIGA_LIB_LOGGER_LAYER_MASK;
+        color = header.attributes >> OPTIGA_LIB_LOGGER_COLOR_SHIFT;
+        p_color = (color < OPTIGA_LIB_LOGGER_COUNT(optiga_lib_logger_colors)) ?
+                  optiga_lib_logger_colors[color] : OPTIGA_LIB_LOGGER_COLOR_DEFAULT;
+        p_layer = (layer < OPTIGA_LIB_LOGGER_COUNT(optiga_lib_logger_layers)) ? optiga_lib_logger_layers[layer] : "";
+        p_text = (const char_t *)data;
+        if (OPTIGA_LIB_LOGGER_LAYER_OTHER == layer)
+        {
+            // A truncated layer string has no NUL of its own, the one after the data ends it
+            p_layer = p_text;
+            p_text += strlen(p_layer);
+            if ((const uint8_t *)p_text < &data[header.length])
+            {
+                p_text++;
+            }
+        }
+
+        if (strlen(p_text) > OPTIGA_LIB_LOGGER_BINARY_MAX_TEXT)
+        {
+            data[(p_text - (const char_t *)data) + OPTIGA_LIB_LOGGER_BINARY_MAX_TEXT] = 0x00;
+        }
+
+        switch (header.type & OPTIGA_LIB_LOGGER_RECORD_MASK)
+        {
+            case OPTIGA_LIB_LOGGER_RECORD_STRING:
+            {
+                optiga_lib_text_string(p_text);
+                break;
+            }
+            case OPTIGA_LIB_LOGGER_RECORD_LINE:
+            {
+                optiga_lib_text_string_with_newline(p_text);
+                break;
+            }
+            case OPTIGA_LIB_LOGGER_RECORD_MESSAGE:
+            {
+                optiga_lib_text_message(p_text, p_layer, p_color);
+                break;
+            }
+            case OPTIGA_LIB_LOGGER_RECORD_STATUS:
+            {
+                optiga_lib_text_status(p_layer, p_color, (uint16_t)(((uint16_t)data[0] << 8) | data[1]));
+                break;
+            }
+            case OPTIGA_LIB_LOGGER_RECORD_ARRAY:
+            {
+                optiga_lib_text_array_hex_format(data, header.length, p_color);
+                break;
+            }
+            default:
+            {
+                break;
+            }
+        }
+        if (0 != (header.type & OPTIGA_LIB_LOGGER_RECORD_TRUNCATED))
+        {
+            optiga_lib_text_string_with_newline("[truncated]");
+        }
+    }
+    return (done);
+}
+
+void optiga_lib_logger_get_info(optiga_lib_logger_file_t * p_info)
+{
+    pal_os_lock_enter_critical_section();
+    p_info->magic = OPTIGA_LIB_LOGGER_MAGIC;
+    p_info->version = OPTIGA_LIB_LOGGER_VERSION;
+    p_info->record_header_size = sizeof(optiga_lib_logger_record_t);
+    p_info->records = optiga_lib_logger_records;
+    p_info->dropped = optiga_lib_logger_dropped;
+    p_info->bytes = optiga_lib_logger_used;
+    pal_os_lock_exit_critical_section();
+}
+
+int32_t optiga_lib_logger_save(optiga_lib_logger_write_t writer, void * p_context)
+{
+    static uint8_t chunk[OPTIGA_LIB_LOGGER_CHUNK_BYTES];
+    optiga_lib_logger_file_t info;
+    uint32_t offset;
+    uint32_t done = 0;
+    uint32_t length;
+    int32_t status = 0;
+
+    // Print calls and the formatter stop touching the ring once the flag is set under the lock
+    pal_os_lock_enter_critical_section();
+    optiga_lib_logger_saving = TRUE;
+    pal_os_lock_exit_critical_section();
+
+    optiga_lib_logger_get_info(&info);
+    if (0 != writer(p_context, (const uint8_t *)&info, sizeof(info)))
+    {
+        status = -1;
+    }
+    offset = optiga_lib_logger_tail;
+    while ((0 == status) && (done < info.bytes))
+    {
+        length = info.bytes - done;
+        if (length > sizeof(chunk))
+        {
+            length = sizeof(chunk);
+        }
+        optiga_lib_logger_copy_out(offset, chunk, length);
+        if (0 != writer(p_context, chunk, length))
+        {
+            status = -1;
+        }
+        offset = (offset + length) % OPTIGA_LIB_LOGGER_BINARY_RING_BYTES;
+        done += length;
+    }
+
+    pal_os_lock_enter_critical_section();
+    if (0 == status)
+    {
+        // Calls dropped while saving are reported by the next save
+        optiga_lib_logger_dropped -= info.dropped;
+        optiga_lib_logger_tail = 0;
+        optiga_lib_logger_used = 0;
+        optiga_lib_logger_records = 0;
+    }
+    optiga_lib_logger_saving = FALSE;
+    pal_os_lock_exit_critical_section();
+    return (status);
+}
+#endif // OPTIGA_LIB_LOGGER_BINARY
+
+void optiga_lib_print_string(const char_t * p_log_string)
+{
+    if (NULL == p_log_string)
+    {
+        return;
+    }
+#ifdef OPTIGA_LIB_LOGGER_BINARY
+    optiga_lib_logger_record(OPTIGA_LIB_LOGGER_RECORD_STRING, NULL, NULL,
+                             (const uint8_t *)p_log_string, strlen(p_log_string));
+#else
+    optiga_lib_text_string(p_log_string);
+#endif
+}
+
+void optiga_lib_print_string_with_newline(const char_t * p_log_string)
+{
+    if (NULL == p_log_string)
+    {
+        return;
+    }
+#ifdef OPTIGA_LIB_LOGGER_BINARY
+    optiga_lib_logger_record(OPTIGA_LIB_LOGGER_RECORD_LINE, NULL, NULL,
+                             (const uint8_t *)p_log_string, strlen(p_log_string));
+#else
+    optiga_lib_text_string_with_newline(p_log_string);
+#endif
+}
+
+void optiga_lib_print_message(const char_t * p_log_string,
+                              const char_t * p_log_layer,
+                              const char_t * p_log_color)
+{
+    if ((NULL == p_log_string) || (NULL == p_log_layer) || (NULL == p_log_color))
+    {
+        return;
+    }
+#ifdef OPTIGA_LIB_LOGGER_BINARY
+    optiga_lib_logger_record(OPTIGA_LIB_LOGGER_RECORD_MESSAGE, p_log_layer, p_log_color,
+                             (const uint8_t *)p_log_string, strlen(p_log_string));
+#else
+    optiga_lib_text_message(p_log_string, p_log_layer, p_log_color);
+#endif
+}
+
+void optiga_lib_print_status(const char_t * p_log_layer,
+                             const char_t * p_log_color,
+                             uint16_t return_value)
+{
+#ifdef OPTIGA_LIB_LOGGER_BINARY
+    uint8_t value[2];
+#endif
+
+    if ((NULL == p_log_layer) || (NULL == p_log_color))
+    {
+        return;
+    }
+#ifdef OPTIGA_LIB_LOGGER_BINARY
+    value[0] = (uint8_t)(return_value >> 8);
+    value[1] = (uint8_t)return_value;
+    optiga_lib_logger_record(OPTIGA_LIB_LOGGER_RECORD_STATUS, p_log_layer, p_log_color, value, sizeof(value));
+#else
+    optiga_lib_text_status(p_log_layer, p_log_color, return_value);
+#endif
+}
+
+void optiga_lib_print_array_hex_format(const uint8_t * p_log_string,
+                                       uint16_t length,
+                                       const char_t * p_log_color)
+{
+    if ((NULL == p_log_string) || (NULL == p_log_color))
+    {
+        return;
+    }
+#ifdef OPTIGA_LIB_LOGGER_BINARY
+    optiga_lib_logger_record(OPTIGA_LIB_LOGGER_RECORD_ARRAY, NULL, p_log_color, p_log_string, length);
+#else
+    optiga_lib_text_array_hex_format(p_log_string, length, p_log_color);
+#endif
+}
+
 /**
 * @}
 */
@@ -0,0 +1,271 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2020 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file    optiga_lib_trace.c
+*
+* \brief   This file implements the trace ring and the per command latency breakdown.
+*
+* \ingroup  grOptigaLibCommon
+*
+* @{
+*/
+
+#include "optiga/common/optiga_lib_trace.h"
+#include "optiga/common/optiga_lib_logger.h"
+#include "optiga/pal/pal_os_timer.h"
+
+#ifdef OPTIGA_LIB_ENABLE_TRACE
+
+/// @cond hidden
+
+#define OPTIGA_LIB_TRACE_LINE_LENGTH        (192U)
+
+// Accumulated times of one APDU while the ring is rendered
+typedef struct optiga_lib_trace_row
+{
+    uint32_t start_us;
+    uint32_t send_us;
+    uint32_t response_us;
+    uint32_t prl_us;
+    uint32_t bus_us;
+    uint32_t exec_us;
+    uint32_t prl_mark_us;
+    uint32_t xfer_mark_us;
+    uint32_t exec_mark_us;
+    uint16_t fragments;
+    uint16_t frames;
+    uint16_t polls;
+    uint16_t resends;
+    uint8_t command_code;
+    uint8_t sent;
+    uint8_t responded;
+    uint8_t xfer_running;
+    uint8_t exec_running;
+} optiga_lib_trace_row_t;
+
+_STATIC_H optiga_lib_trace_event_t optiga_lib_trace_ring[OPTIGA_LIB_TRACE_DEPTH];
+// Number of events recorded since the last clear, the ring holds the latest OPTIGA_LIB_TRACE_DEPTH
+_STATIC_H uint32_t optiga_lib_trace_head = 0;
+_STATIC_H volatile uint8_t optiga_lib_trace_paused = FALSE;
+
+_STATIC_H void optiga_lib_trace_print_row(const optiga_lib_trace_row_t * p_row, uint32_t end_us)
+{
+    char_t line[OPTIGA_LIB_TRACE_LINE_LENGTH];
+    uint32_t comms_us;
+    uint32_t known_us;
+    uint32_t response_us;
+
+    do
+    {
+        if (FALSE == p_row->sent)
+        {
+            break;
+        }
+        // A response that never came (comms error) ends the comms part at the notification
+        response_us = (TRUE == p_row->responded) ? p_row->response_us : end_us;
+        comms_us = response_us - p_row->send_us;
+        known_us = p_row->prl_us + p_row->bus_us + p_row->exec_us;
+
+        (void)snprintf(line, sizeof(line),
+                       "[optiga trace]    : cmd 0x%02X total %lu us: prep %lu prl %lu bus %lu exec %lu stack %lu post %lu,"
+                       " %u frag %u frames %u polls %u resends",
+                       p_row->command_code,
+                       (unsigned long)(end_us - p_row->start_us),
+                       (unsigned long)(p_row->send_us - p_row->start_us),
+                       (unsigned long)p_row->prl_us,
+                       (unsigned long)p_row->bus_us,
+                       (unsigned long)p_row->exec_us,
+                       (unsigned long)((comms_us > known_us) ? (comms_us - known_us) : 0U),
+                       (unsigned long)(end_us - response_us),
+                       p_row->fragments, p_row->frames, p_row->polls, p_row->resends);
+        optiga_lib_print_string_with_newline(line);
+    } while (FALSE);
+}
+
+_STATIC_H void optiga_lib_trace_account(optiga_lib_trace_row_t * p_row, const optiga_lib_trace_event_t * p_event)
+{
+    switch (p_event->event)
+    {
+        case OPTIGA_LIB_TRACE_CMD_SEND:
+        {
+            p_row->send_us = p_event->time_us;
+            p_row->command_code = (uint8_t)p_event->arg;
+            p_row->sent = TRUE;
+            break;
+        }
+        case OPTIGA_LIB_TRACE_CMD_RESPONSE:
+        {
+            // Processing a device error response comes here a second time
+            if (FALSE == p_row->responded)
+            {
+                p_row->response_us = p_event->time_us;
+                p_row->responded = TRUE;
+            }
+            break;
+        }
+        case OPTIGA_LIB_TRACE_PRL_PROTECT_START:
+        case OPTIGA_LIB_TRACE_PRL_UNPROTECT_START:
+        {
+            p_row->prl_mark_us = p_event->time_us;
+            break;
+        }
+        case OPTIGA_LIB_TRACE_PRL_PROTECT_END:
+        case OPTIGA_LIB_TRACE_PRL_UNPROTECT_END:
+        {
+            p_row->prl_us += p_event->time_us - p_row->prl_mark_us;
+            break;
+        }
+        case OPTIGA_LIB_TRACE_TL_TX_FRAGMENT:
+        case OPTIGA_LIB_TRACE_TL_RX_FRAGMENT:
+        {
+            p_row->fragments++;
+            break;
+        }
+        case OPTIGA_LIB_TRACE_DL_TX_FRAME:
+        {
+            p_row->frames++;
+            break;
+        }
+        case OPTIGA_LIB_TRACE_DL_RESEND:
+        case OPTIGA_LIB_TRACE_DL_RESYNC:
+        {
+            p_row->resends++;
+            break;
+        }
+        case OPTIGA_LIB_TRACE_PL_XFER_START:
+        {
+            p_row->xfer_mark_us = p_event->time_us;
+            p_row->xfer_running = TRUE;
+            break;
+        }
+        case OPTIGA_LIB_TRACE_PL_XFER_END:
+        {
+            if (TRUE == p_row->xfer_running)
+            {
+                p_row->bus_us += p_event->time_us - p_row->xfer_mark_us;
+                p_row->xfer_running = FALSE;
+            }
+            break;
+        }
+        case OPTIGA_LIB_TRACE_PL_EXEC_START:
+        {
+            p_row->exec_mark_us = p_event->time_us;
+            p_row->exec_running = TRUE;
+            break;
+        }
+        case OPTIGA_LIB_TRACE_PL_POLL:
+        {
+            p_row->polls++;
+            break;
+        }
+        case OPTIGA_LIB_TRACE_PL_READY:
+        {
+            if (TRUE == p_row->exec_running)
+            {
+                p_row->exec_us += p_event->time_us - p_row->exec_mark_us;
+                p_row->exec_running = FALSE;
+            }
+            // The read of the DATA register starts right away
+            p_row->xfer_mark_us = p_event->time_us;
+            p_row->xfer_running = TRUE;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/// @endcond
+
+void optiga_lib_trace_record(uint8_t event, uint32_t arg)
+{
+    optiga_lib_trace_event_t * p_event;
+    uint32_t index;
+
+    if (FALSE == optiga_lib_trace_paused)
+    {
+        index = __atomic_fetch_add(&optiga_lib_trace_head, 1U, __ATOMIC_RELAXED);
+        p_event = &optiga_lib_trace_ring[index % OPTIGA_LIB_TRACE_DEPTH];
+        p_event->time_us = pal_os_timer_get_time_in_microseconds();
+        p_event->arg = arg;
+        p_event->event = event;
+    }
+}
+
+void optiga_lib_trace_dump(void)
+{
+    optiga_lib_trace_row_t row;
+    uint8_t row_open = FALSE;
+    uint32_t end;
+    uint32_t index;
+    const optiga_lib_trace_event_t * p_event;
+
+    optiga_lib_trace_paused = TRUE;
+    end = __atomic_load_n(&optiga_lib_trace_head, __ATOMIC_RELAXED);
+    index = (end > OPTIGA_LIB_TRACE_DEPTH) ? (end - OPTIGA_LIB_TRACE_DEPTH) : 0U;
+
+    for (; index < end; index++)
+    {
+        p_event = &optiga_lib_trace_ring[index % OPTIGA_LIB_TRACE_DEPTH];
+        if (OPTIGA_LIB_TRACE_CMD_PREPARE == p_event->event)
+        {
+            // The next APDU of a chained command ends the previous one
+            if (TRUE == row_open)
+            {
+                optiga_lib_trace_print_row(&row, p_event->time_us);
+            }
+            memset(&row, 0, sizeof(row));
+            row.start_us = p_event->time_us;
+            row_open = TRUE;
+        }
+        else if (TRUE == row_open)
+        {
+            if (OPTIGA_LIB_TRACE_CMD_DONE == p_event->event)
+            {
+                optiga_lib_trace_print_row(&row, p_event->time_us);
+                row_open = FALSE;
+            }
+            else
+            {
+                optiga_lib_trace_account(&row, p_event);
+            }
+        }
+    }
+    optiga_lib_trace_paused = FALSE;
+}
+
+void optiga_lib_trace_clear(void)
+{
+    __atomic_store_n(&optiga_lib_trace_head, 0U, __ATOMIC_RELAXED);
+}
+
+#endif
+
+/**
+* @}
+*/
@@ -69,11 +69,17 @@ _STATIC_H void ifx_i2c_prl_close_event_handler(ifx_i2c_context_t * p_ctx,
                                                uint16_t data_len);
 #endif
 _STATIC_H optiga_lib_status_t ifx_i2c_init(ifx_i2c_context_t * p_ifx_i2c_context);
+_STATIC_H uint8_t ifx_i2c_recovery_next_step(const ifx_i2c_context_t * p_ctx, uint8_t step);
+_STATIC_H void ifx_i2c_recovery_start_step(ifx_i2c_context_t * p_ctx);
+_STATIC_H uint8_t ifx_i2c_recovery_end(ifx_i2c_context_t * p_ctx, optiga_lib_status_t event);
+_STATIC_H void ifx_i2c_stats_end_transfer(ifx_i2c_context_t * p_ctx, optiga_lib_status_t event);
 
 //lint --e{526} suppress "This API is defined in ifx_i2c_physical_layer.c file. As it is a low level API, it is not exposed in header file"
 extern optiga_lib_status_t ifx_i2c_pl_write_slave_address(ifx_i2c_context_t * p_ctx,
                                                           uint8_t slave_address,
                                                           uint8_t storage_type);
+//lint --e{526} suppress "This API is defined in ifx_i2c_physical_layer.c file. As it is a low level API, it is not exposed in header file"
+extern void ifx_i2c_pl_start_command(ifx_i2c_context_t * p_ctx, uint8_t command_code);
 /// @endcond
 
 optiga_lib_status_t ifx_i2c_open(ifx_i2c_context_t * p_ctx)
@@ -92,6 +98,12 @@ optiga_lib_status_t ifx_i2c_open(ifx_i2c_context_t * p_ctx)
                 break;
             }
             p_ctx->reset_state = IFX_I2C_STATE_RESET_PIN_LOW;
+            p_ctx->recovery.dl_active = FALSE;
+            // After a failed transfer the open runs the pending step of the recovery ladder
+            if (IFX_I2C_RECOVERY_DL_RESYNC != p_ctx->recovery.step)
+            {
+                ifx_i2c_recovery_start_step(p_ctx);
+            }
             p_ctx->do_pal_init = TRUE;
             p_ctx->state = IFX_I2C_STATE_UNINIT;
 
@@ -140,6 +152,14 @@ optiga_lib_status_t ifx_i2c_transceive(ifx_i2c_context_t * p_ctx,
     {
         p_ctx->p_upper_layer_rx_buffer = p_rx_buffer;
         p_ctx->p_upper_layer_rx_buffer_len = p_rx_buffer_len;
+        p_ctx->recovery.dl_active = FALSE;
+        // The physical layer schedules its response polls by the expected time of this command
+        if (tx_data_length > IFX_I2C_DATA_OFFSET)
+        {
+            ifx_i2c_pl_start_command(p_ctx, p_tx_data[IFX_I2C_DATA_OFFSET]);
+            p_ctx->stats_command = p_tx_data[IFX_I2C_DATA_OFFSET];
+        }
+        p_ctx->stats_retries = 0;
 #ifndef OPTIGA_COMMS_SHIELDED_CONNECTION
         api_status = ifx_i2c_tl_transceive(p_ctx,
                                            (uint8_t * )p_tx_data,
@@ -221,6 +241,16 @@ optiga_lib_status_t ifx_i2c_set_slave_address(ifx_i2c_context_t * p_ctx,
     return (api_status);
 }
 
+void ifx_i2c_get_stats(const ifx_i2c_context_t * p_ctx, ifx_i2c_stats_t * p_stats)
+{
+    memcpy(p_stats, &p_ctx->stats, sizeof(ifx_i2c_stats_t));
+}
+
+void ifx_i2c_clear_stats(ifx_i2c_context_t * p_ctx)
+{
+    memset(&p_ctx->stats, 0, sizeof(ifx_i2c_stats_t));
+}
+
 /// @cond hidden
 //lint --e{715} suppress "The arguments p_data and data_len is not used in this function 
 //                        but as per the function signature those 2 parameter should be passed"
@@ -229,6 +259,12 @@ void ifx_i2c_tl_event_handler(ifx_i2c_context_t * p_ctx,
                               const uint8_t * p_data,
                               uint16_t data_len)
 {
+    // A failed reset step escalates to the next one before the upper layer is informed
+    if (TRUE == ifx_i2c_recovery_end(p_ctx, event))
+    {
+        return;
+    }
+    ifx_i2c_stats_end_transfer(p_ctx, event);
     // If there is no upper layer handler, don't do anything and return
     if (NULL != p_ctx->upper_layer_event_handler)
     {
@@ -281,6 +317,153 @@ _STATIC_H void ifx_i2c_prl_close_event_handler(ifx_i2c_context_t * p_ctx,
     }
 }
 #endif
+//Next usable reset step after step, warm and cold reset are skipped if their pin is not wired
+_STATIC_H uint8_t ifx_i2c_recovery_next_step(const ifx_i2c_context_t * p_ctx, uint8_t step)
+{
+    uint8_t next_step = step;
+
+    if (IFX_I2C_RECOVERY_SOFT_RESET > step)
+    {
+        next_step = IFX_I2C_RECOVERY_SOFT_RESET;
+    }
+    else if ((IFX_I2C_RECOVERY_WARM_RESET > step) &&
+             (NULL != p_ctx->p_slave_reset_pin) && (NULL != p_ctx->p_slave_reset_pin->p_gpio_hw))
+    {
+        next_step = IFX_I2C_RECOVERY_WARM_RESET;
+    }
+    else if ((IFX_I2C_RECOVERY_COLD_RESET > step) &&
+             (NULL != p_ctx->p_slave_vdd_pin) && (NULL != p_ctx->p_slave_vdd_pin->p_gpio_hw))
+    {
+        next_step = IFX_I2C_RECOVERY_COLD_RESET;
+    }
+    return (next_step);
+}
+
+_STATIC_H void ifx_i2c_recovery_start_step(ifx_i2c_context_t * p_ctx)
+{
+    switch (p_ctx->recovery.step)
+    {
+        case IFX_I2C_RECOVERY_SOFT_RESET:
+        {
+            p_ctx->reset_type = (uint8_t)IFX_I2C_SOFT_RESET;
+            break;
+        }
+        case IFX_I2C_RECOVERY_WARM_RESET:
+        {
+            p_ctx->reset_type = (uint8_t)IFX_I2C_WARM_RESET;
+            break;
+        }
+        default:
+        {
+            p_ctx->reset_type = (uint8_t)IFX_I2C_COLD_RESET;
+            break;
+        }
+    }
+    p_ctx->reset_state = IFX_I2C_STATE_RESET_PIN_LOW;
+    p_ctx->recovery.last_step = p_ctx->recovery.step;
+    p_ctx->recovery.resetting = TRUE;
+    p_ctx->recovery.start_us = pal_os_timer_get_time_in_microseconds();
+    p_ctx->recovery.count[p_ctx->recovery.step]++;
+}
+
+//Accounts a finished transfer in the retry histogram of its command
+_STATIC_H void ifx_i2c_stats_end_transfer(ifx_i2c_context_t * p_ctx, optiga_lib_status_t event)
+{
+    ifx_i2c_command_stats_t * p_command = NULL;
+    uint8_t index;
+
+    do
+    {
+        // Opens and closes carry no command
+        if (0 == p_ctx->stats_command)
+        {
+            break;
+        }
+        for (index = 0; index < IFX_I2C_STATS_COMMANDS; index++)
+        {
+            p_command = &p_ctx->stats.command[index];
+            if ((p_ctx->stats_command == p_command->command_code) || (0 == p_command->command_code))
+            {
+                break;
+            }
+        }
+        // With the table full the last entry also counts the remaining commands
+        if (index < IFX_I2C_STATS_COMMANDS)
+        {
+            p_command->command_code = p_ctx->stats_command;
+        }
+        p_command->retries[(p_ctx->stats_retries < IFX_I2C_STATS_RETRY_BUCKETS) ?
+                           p_ctx->stats_retries : (IFX_I2C_STATS_RETRY_BUCKETS - 1U)]++;
+        if (IFX_I2C_STACK_SUCCESS != event)
+        {
+            p_command->failures++;
+        }
+        p_ctx->stats.transfers++;
+        p_ctx->stats_command = 0;
+    } while (FALSE);
+}
+
+//Accounts the end of a transfer or reset step. Returns TRUE if a failed reset step was escalated
+_STATIC_H uint8_t ifx_i2c_recovery_end(ifx_i2c_context_t * p_ctx, optiga_lib_status_t event)
+{
+    ifx_i2c_recovery_t * p_recovery = &p_ctx->recovery;
+    uint32_t now_us = pal_os_timer_get_time_in_microseconds();
+    uint8_t escalated = FALSE;
+
+    do
+    {
+        if (TRUE == p_recovery->resetting)
+        {
+            p_recovery->last_us[p_recovery->step] = now_us - p_recovery->start_us;
+            if (IFX_I2C_STACK_SUCCESS == event)
+            {
+                // Escalate further only if the next transfer fails as well
+                p_recovery->resetting = FALSE;
+                p_recovery->step = IFX_I2C_RECOVERY_DL_RESYNC;
+                break;
+            }
+            if (ifx_i2c_recovery_next_step(p_ctx, p_recovery->step) == p_recovery->step)
+            {
+                // Cold reset failed, the next open retries it
+                p_recovery->resetting = FALSE;
+                break;
+            }
+            p_recovery->step = ifx_i2c_recovery_next_step(p_ctx, p_recovery->step);
+            ifx_i2c_recovery_start_step(p_ctx);
+            // Reset states of a soft reset are kept by the physical layer
+            p_ctx->do_pal_init = FALSE;
+            if (IFX_I2C_STACK_SUCCESS == ifx_i2c_init(p_ctx))
+            {
+                escalated = TRUE;
+                break;
+            }
+            p_recovery->resetting = FALSE;
+            break;
+        }
+        if (TRUE == p_recovery->dl_active)
+        {
+            p_recovery->last_us[IFX_I2C_RECOVERY_DL_RESYNC] = now_us - p_recovery->dl_start_us;
+            p_recovery->dl_active = FALSE;
+        }
+        if (IFX_I2C_STATE_IDLE != p_ctx->state)
+        {
+            break;
+        }
+        if (IFX_I2C_STACK_SUCCESS == event)
+        {
+            p_recovery->step = IFX_I2C_RECOVERY_DL_RESYNC;
+            p_recovery->last_step = IFX_I2C_RECOVERY_DL_RESYNC;
+        }
+        else
+        {
+            // The failed transfer already used up the data link recovery window
+            p_recovery->step = ifx_i2c_recovery_next_step(p_ctx, p_recovery->last_step);
+        }
+    } while (FALSE);
+
+    return (escalated);
+}
+
 _STATIC_H optiga_lib_status_t ifx_i2c_init(ifx_i2c_context_t * p_ifx_i2c_context)
 {
     optiga_lib_status_t api_status = IFX_I2C_STACK_ERROR;
@@ -65,11 +65,11 @@ ifx_i2c_datastore_config_t ifx_i2c_datastore_config =
  *
  * - The following parameters in #ifx_i2c_context_t must be initialized with appropriate values <br>
  *   - <b>slave address</b> : Address of I2C slave
- *   - <b>frame_size</b> : Frame size in bytes. Minimum supported value is 16 bytes.<br> 
- *              - It is recommended not to use a value greater than the slave's frame size.
- *              - The user specified frame size is written to I2C slave's frame size register.
- *                The frame size register is read back from I2C slave.
- *                This frame value is used by the ifx-i2c protocol even if it is not equal to the user specified value.
+ *   - <b>frame_size</b> : Frame size in bytes, set to #IFX_I2C_FRAME_SIZE.<br> 
+ *              - At every open #IFX_I2C_FRAME_SIZE (the size of the frame buffers) is written to I2C slave's
+ *                frame size register. The frame size register is read back from I2C slave.
+ *                This frame value is stored here and used by the ifx-i2c protocol even if it is smaller
+ *                than the requested value.
  *
  *   - <b>frequency</b> : Frequency/speed of I2C master in KHz.
  *              - This must be lowest of the maximum frequency supported by the devices (master/slave) connected on the 
@@ -94,7 +94,7 @@ ifx_i2c_context_t ifx_i2c_context_0 =
     /// Slave address
     .slave_address = IFX_I2C_BASE_ADDR,
     /// i2c-master frequency
-    .frequency = 400,
+    .frequency = IFX_I2C_FREQUENCY_KHZ,
     /// IFX-I2C frame size
     .frame_size = IFX_I2C_FRAME_SIZE,
     /// Vdd pin
@@ -157,6 +157,39 @@ ifx_i2c_context_t ifx_i2c_context_0 =
 
 };
 
+#if (OPTIGA_MAX_INSTANCES > 2)
+    #error "IFX I2C contexts are defined for at most 2 OPTIGA instances"
+#endif
+
+#if (OPTIGA_MAX_INSTANCES > 1)
+/** @brief IFX I2C context of the second OPTIGA (optiga_instance_id 1).
+ *
+ * - Same parameters as #ifx_i2c_context_0, on optiga_pal_i2c_context_1 and its own Vdd/Reset pins.
+ * - The protocol variables, layer contexts and frame buffers start zeroed.
+ */
+//lint --e{785} suppress "Only required fields are initialized by default, the rest are handled by user of this structure"
+ifx_i2c_context_t ifx_i2c_context_1 =
+{
+    /// Slave address
+    .slave_address = IFX_I2C_BASE_ADDR,
+    /// i2c-master frequency
+    .frequency = IFX_I2C_FREQUENCY_KHZ,
+    /// IFX-I2C frame size
+    .frame_size = IFX_I2C_FRAME_SIZE,
+    /// Vdd pin
+    .p_slave_vdd_pin = &optiga_vdd_1,
+    /// Reset pin
+    .p_slave_reset_pin = &optiga_reset_1,
+    /// optiga pal i2c context
+    .p_pal_i2c_ctx = &optiga_pal_i2c_context_1,
+#ifdef OPTIGA_COMMS_SHIELDED_CONNECTION
+    /// Data store context
+    .ifx_i2c_datastore_config = &ifx_i2c_datastore_config,
+#endif
+    .pal_os_event_ctx = NULL
+};
+#endif
+
 /**
 * @}
 */
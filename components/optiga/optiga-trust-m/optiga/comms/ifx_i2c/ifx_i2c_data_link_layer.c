@@ -37,6 +37,10 @@
 
 #include "optiga/ifx_i2c/ifx_i2c_data_link_layer.h"
 #include "optiga/ifx_i2c/ifx_i2c_physical_layer.h"
+#include "optiga/common/optiga_lib_trace.h"
+#if (DL_CRC_BACKEND == DL_CRC_BACKEND_ESP32_ROM)
+#include "esp_rom_crc.h"
+#endif
 
 /// @cond hidden
 
@@ -71,7 +75,8 @@
 #define DL_FCTR_ACKNR_MASK              (0x03)
 #define DL_FCTR_ACKNR_OFFSET            (0U)
 
-// Data Link Layer frame counter max value
+// Data Link Layer frame counter max value. Frame numbers run modulo 4, but OPTIGA acknowledges with a
+// window size of one frame, so a chained packet is always sent one frame per ACK.
 #define DL_MAX_FRAME_NUM                (0x03)
 
 // Data link layer length
@@ -80,6 +85,9 @@
 // Seconds to milliseconds
 #define DL_SEC_TO_MSECS                 (1000U)
 
+// Length of the pattern used to check the selected CRC backend against the reference
+#define DL_CRC_SELF_TEST_LENGTH         (IFX_I2C_FRAME_SIZE)
+
 #if defined (OPTIGA_LIB_ENABLE_LOGGING) && defined (OPTIGA_LIB_ENABLE_COMMS_LOGGING)
 
 // Logs the message provided from OPTIGA Comms layer
@@ -174,6 +182,10 @@ _STATIC_H uint16_t ifx_i2c_dl_calc_crc_byte(uint16_t seed,
 /// Helper function to calculate CRC of a frame
 _STATIC_H uint16_t ifx_i2c_dl_calc_crc(const uint8_t * p_data,
                                                   uint16_t data_len);
+#if (DL_CRC_BACKEND != DL_CRC_BACKEND_BITWISE)
+/// Helper function to check the selected CRC backend against the bitwise reference
+_STATIC_H optiga_lib_status_t ifx_i2c_dl_crc_self_test(void);
+#endif
 /// Internal function to send frame
 _STATIC_H optiga_lib_status_t ifx_i2c_dl_send_frame_internal(ifx_i2c_context_t * p_ctx,
                                                              uint16_t frame_len,
@@ -197,6 +209,14 @@ optiga_lib_status_t ifx_i2c_dl_init(ifx_i2c_context_t * p_ctx, ifx_i2c_event_han
     LOG_DL("[IFX-DL]: Init\n");
 
     p_ctx->dl.state = DL_STATE_UNINIT;
+#if (DL_CRC_BACKEND != DL_CRC_BACKEND_BITWISE)
+    // The faster CRC backend must stay bit-exact with the reference, else every frame gets rejected
+    if (IFX_I2C_STACK_SUCCESS != ifx_i2c_dl_crc_self_test())
+    {
+        LOG_DL("[IFX-DL]: CRC backend self test failed\n");
+        return (IFX_I2C_STACK_ERROR);
+    }
+#endif
     // Initialize Physical Layer (and register event handler)
     if (IFX_I2C_STACK_SUCCESS != ifx_i2c_pl_init(p_ctx, ifx_i2c_pl_event_handler))
     {
@@ -210,8 +230,9 @@ optiga_lib_status_t ifx_i2c_dl_init(ifx_i2c_context_t * p_ctx, ifx_i2c_event_han
     p_ctx->dl.rx_seq_nr = DL_MAX_FRAME_NUM;
     p_ctx->dl.resynced = 0;
     p_ctx->dl.error = 0;
-    p_ctx->dl.p_tx_frame_buffer = p_ctx->tx_frame_buffer;
-    p_ctx->dl.p_rx_frame_buffer = p_ctx->rx_frame_buffer;
+    // Frames start after the headroom the physical layer uses for the register address
+    p_ctx->dl.p_tx_frame_buffer = p_ctx->tx_frame_buffer + IFX_I2C_DL_HEADER_OFFSET;
+    p_ctx->dl.p_rx_frame_buffer = p_ctx->rx_frame_buffer + IFX_I2C_DL_HEADER_OFFSET;
 
     return IFX_I2C_STACK_SUCCESS;
 }
@@ -268,7 +289,47 @@ _STATIC_H uint16_t ifx_i2c_dl_calc_crc_byte(uint16_t seed, uint8_t byte)
     return ((uint16_t)((((uint16_t)((((uint16_t)(h3 << 1)) ^ h4) << 4)) ^ h2) << 3)) ^ h4 ^ (seed >> 8);
 }
 
-_STATIC_H uint16_t ifx_i2c_dl_calc_crc(const uint8_t * p_data, uint16_t data_len)
+#if (DL_CRC_BACKEND == DL_CRC_BACKEND_TABLE)
+// CRC-16 (reflected polynomial 0x8408) of every byte value, i.e. ifx_i2c_dl_calc_crc_byte(0, index)
+static const uint16_t ifx_i2c_dl_crc_table[256] =
+{
+    0x0000, 0x1189, 0x2312, 0x329B, 0x4624, 0x57AD, 0x6536, 0x74BF,
+    0x8C48, 0x9DC1, 0xAF5A, 0xBED3, 0xCA6C, 0xDBE5, 0xE97E, 0xF8F7,
+    0x1081, 0x0108, 0x3393, 0x221A, 0x56A5, 0x472C, 0x75B7, 0x643E,
+    0x9CC9, 0x8D40, 0xBFDB, 0xAE52, 0xDAED, 0xCB64, 0xF9FF, 0xE876,
+    0x2102, 0x308B, 0x0210, 0x1399, 0x6726, 0x76AF, 0x4434, 0x55BD,
+    0xAD4A, 0xBCC3, 0x8E58, 0x9FD1, 0xEB6E, 0xFAE7, 0xC87C, 0xD9F5,
+    0x3183, 0x200A, 0x1291, 0x0318, 0x77A7, 0x662E, 0x54B5, 0x453C,
+    0xBDCB, 0xAC42, 0x9ED9, 0x8F50, 0xFBEF, 0xEA66, 0xD8FD, 0xC974,
+    0x4204, 0x538D, 0x6116, 0x709F, 0x0420, 0x15A9, 0x2732, 0x36BB,
+    0xCE4C, 0xDFC5, 0xED5E, 0xFCD7, 0x8868, 0x99E1, 0xAB7A, 0xBAF3,
+    0x5285, 0x430C, 0x7197, 0x601E, 0x14A1, 0x0528, 0x37B3, 0x263A,
+    0xDECD, 0xCF44, 0xFDDF, 0xEC56, 0x98E9, 0x8960, 0xBBFB, 0xAA72,
+    0x6306, 0x728F, 0x4014, 0x519D, 0x2522, 0x34AB, 0x0630, 0x17B9,
+    0xEF4E, 0xFEC7, 0xCC5C, 0xDDD5, 0xA96A, 0xB8E3, 0x8A78, 0x9BF1,
+    0x7387, 0x620E, 0x5095, 0x411C, 0x35A3, 0x242A, 0x16B1, 0x0738,
+    0xFFCF, 0xEE46, 0xDCDD, 0xCD54, 0xB9EB, 0xA862, 0x9AF9, 0x8B70,
+    0x8408, 0x9581, 0xA71A, 0xB693, 0xC22C, 0xD3A5, 0xE13E, 0xF0B7,
+    0x0840, 0x19C9, 0x2B52, 0x3ADB, 0x4E64, 0x5FED, 0x6D76, 0x7CFF,
+    0x9489, 0x8500, 0xB79B, 0xA612, 0xD2AD, 0xC324, 0xF1BF, 0xE036,
+    0x18C1, 0x0948, 0x3BD3, 0x2A5A, 0x5EE5, 0x4F6C, 0x7DF7, 0x6C7E,
+    0xA50A, 0xB483, 0x8618, 0x9791, 0xE32E, 0xF2A7, 0xC03C, 0xD1B5,
+    0x2942, 0x38CB, 0x0A50, 0x1BD9, 0x6F66, 0x7EEF, 0x4C74, 0x5DFD,
+    0xB58B, 0xA402, 0x9699, 0x8710, 0xF3AF, 0xE226, 0xD0BD, 0xC134,
+    0x39C3, 0x284A, 0x1AD1, 0x0B58, 0x7FE7, 0x6E6E, 0x5CF5, 0x4D7C,
+    0xC60C, 0xD785, 0xE51E, 0xF497, 0x8028, 0x91A1, 0xA33A, 0xB2B3,
+    0x4A44, 0x5BCD, 0x6956, 0x78DF, 0x0C60, 0x1DE9, 0x2F72, 0x3EFB,
+    0xD68D, 0xC704, 0xF59F, 0xE416, 0x90A9, 0x8120, 0xB3BB, 0xA232,
+    0x5AC5, 0x4B4C, 0x79D7, 0x685E, 0x1CE1, 0x0D68, 0x3FF3, 0x2E7A,
+    0xE70E, 0xF687, 0xC41C, 0xD595, 0xA12A, 0xB0A3, 0x8238, 0x93B1,
+    0x6B46, 0x7ACF, 0x4854, 0x59DD, 0x2D62, 0x3CEB, 0x0E70, 0x1FF9,
+    0xF78F, 0xE606, 0xD49D, 0xC514, 0xB1AB, 0xA022, 0x92B9, 0x8330,
+    0x7BC7, 0x6A4E, 0x58D5, 0x495C, 0x3DE3, 0x2C6A, 0x1EF1, 0x0F78
+};
+#endif
+
+/// Reference CRC implementation, processes the frame bit by bit
+_STATIC_H uint16_t ifx_i2c_dl_calc_crc_bitwise(const uint8_t * p_data, uint16_t data_len)
 {
     uint16_t i;
     uint16_t crc = 0;
@@ -281,6 +342,63 @@ _STATIC_H uint16_t ifx_i2c_dl_calc_crc(const uint8_t * p_data, uint16_t data_len
     return (crc);
 }
 
+_STATIC_H uint16_t ifx_i2c_dl_calc_crc(const uint8_t * p_data, uint16_t data_len)
+{
+#if (DL_CRC_BACKEND == DL_CRC_BACKEND_TABLE)
+    uint16_t i;
+    uint16_t crc = 0;
+
+    for (i = 0; i < data_len; i++)
+    {
+        crc = (crc >> 8) ^ ifx_i2c_dl_crc_table[(crc ^ p_data[i]) & 0xFF];
+    }
+
+    return (crc);
+#elif (DL_CRC_BACKEND == DL_CRC_BACKEND_ESP32_ROM)
+    // The ROM routine inverts the CRC on entry and exit, the frame CRC uses seed 0 and no final xor
+    return ((uint16_t)~esp_rom_crc16_le((uint16_t)~0U, p_data, data_len));
+#else
+    return (ifx_i2c_dl_calc_crc_bitwise(p_data, data_len));
+#endif
+}
+
+#if (DL_CRC_BACKEND != DL_CRC_BACKEND_BITWISE)
+_STATIC_H optiga_lib_status_t ifx_i2c_dl_crc_self_test(void)
+{
+    static bool_t self_test_passed = FALSE;
+    uint8_t pattern[DL_CRC_SELF_TEST_LENGTH];
+    uint16_t i;
+    uint16_t length;
+
+    if (TRUE == self_test_passed)
+    {
+        return (IFX_I2C_STACK_SUCCESS);
+    }
+
+    for (i = 0; i < DL_CRC_SELF_TEST_LENGTH; i++)
+    {
+        pattern[i] = (uint8_t)((i * 0x9D) ^ (i >> 3));
+    }
+
+    // Cover the empty frame, a control frame, odd lengths and a full frame
+    for (length = 0; length <= DL_CRC_SELF_TEST_LENGTH; length = (length < 8) ? (length + 1) : (length + 37))
+    {
+        if (ifx_i2c_dl_calc_crc(pattern, length) != ifx_i2c_dl_calc_crc_bitwise(pattern, length))
+        {
+            return (IFX_I2C_STACK_ERROR);
+        }
+    }
+    if (ifx_i2c_dl_calc_crc(pattern, DL_CRC_SELF_TEST_LENGTH) !=
+        ifx_i2c_dl_calc_crc_bitwise(pattern, DL_CRC_SELF_TEST_LENGTH))
+    {
+        return (IFX_I2C_STACK_ERROR);
+    }
+
+    self_test_passed = TRUE;
+    return (IFX_I2C_STACK_SUCCESS);
+}
+#endif
+
 _STATIC_H optiga_lib_status_t ifx_i2c_dl_send_frame_internal(ifx_i2c_context_t * p_ctx,
                                                              uint16_t frame_len,
                                                              uint8_t seqctr_value,
@@ -341,6 +459,7 @@ _STATIC_H optiga_lib_status_t ifx_i2c_dl_send_frame_internal(ifx_i2c_context_t *
     p_buffer[4 + frame_len] = (uint8_t)crc;
 
     // Transmit frame
+    OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_DL_TX_FRAME, frame_len);
     OPTIGA_IFXI2C_LOG_TRANSMIT_HEX_DATA(p_buffer,DL_HEADER_SIZE + frame_len,p_ctx)
     return (ifx_i2c_pl_send_frame(p_ctx, p_buffer, DL_HEADER_SIZE + frame_len));
 }
@@ -361,6 +480,7 @@ _STATIC_H optiga_lib_status_t ifx_i2c_dl_resync(ifx_i2c_context_t * p_ctx)
 _STATIC_H void ifx_i2c_dl_resend_frame(ifx_i2c_context_t * p_ctx, uint8_t seqctr_value)
 {
     optiga_lib_status_t status;
+    uint32_t recovery_time_us;
     // If exit timeout not violated
     uint32_t current_time_stamp = pal_os_timer_get_time_in_milliseconds();
     uint32_t time_stamp_diff = current_time_stamp - p_ctx->tl.api_start_time;
@@ -369,11 +489,28 @@ _STATIC_H void ifx_i2c_dl_resend_frame(ifx_i2c_context_t * p_ctx, uint8_t seqctr
     {
         time_stamp_diff = (0xFFFFFFFF + (current_time_stamp - p_ctx->tl.api_start_time)) + 0x01;
     }
-    if (time_stamp_diff < (TL_MAX_EXIT_TIMEOUT * DL_SEC_TO_MSECS))
+    // First step of the recovery ladder: the first error of a transfer opens a window of
+    // DL_RECOVERY_TIMEOUT_MS for retransmits and re-syncs, a longer fault is left to a reset
+    if (FALSE == p_ctx->recovery.dl_active)
+    {
+        p_ctx->recovery.dl_active = TRUE;
+        p_ctx->recovery.dl_start_us = pal_os_timer_get_time_in_microseconds();
+        p_ctx->recovery.count[IFX_I2C_RECOVERY_DL_RESYNC]++;
+    }
+    recovery_time_us = pal_os_timer_get_time_in_microseconds() - p_ctx->recovery.dl_start_us;
+    if (p_ctx->stats_retries < 0xFF)
+    {
+        p_ctx->stats_retries++;
+    }
+
+    if ((time_stamp_diff < (TL_MAX_EXIT_TIMEOUT * DL_SEC_TO_MSECS)) &&
+        (recovery_time_us < (DL_RECOVERY_TIMEOUT_MS * 1000U)))
     {
         if (DL_TRANS_REPEAT == p_ctx->dl.retransmit_counter)
         {
             LOG_DL("[IFX-DL]: Re-Sync counters\n");
+            OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_DL_RESYNC, 0);
+            p_ctx->stats.dl_resyncs++;
             p_ctx->dl.retransmit_counter = 0;
             status = ifx_i2c_dl_resync(p_ctx);
         }
@@ -381,6 +518,8 @@ _STATIC_H void ifx_i2c_dl_resend_frame(ifx_i2c_context_t * p_ctx, uint8_t seqctr
         {
             LOG_DL("[IFX-DL]: Re-TX Frame\n");
             p_ctx->dl.retransmit_counter++;
+            OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_DL_RESEND, p_ctx->dl.retransmit_counter);
+            p_ctx->stats.dl_resends++;
             p_ctx->dl.state = DL_STATE_TX;
             status = ifx_i2c_dl_send_frame_internal(p_ctx, p_ctx->dl.tx_buffer_size, seqctr_value, 1);
         }
@@ -459,6 +598,7 @@ _STATIC_H void ifx_i2c_pl_event_handler(ifx_i2c_context_t * p_ctx,
                 }
                 // Received frame from device, start analyzing
                 LOG_DL("[IFX-DL]: Received Frame of length %d\n",data_len);
+                OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_DL_RX_FRAME, data_len);
 
                 if (data_len < DL_HEADER_SIZE)
                 {    // Received length is less than minimum size
@@ -484,6 +624,10 @@ _STATIC_H void ifx_i2c_pl_event_handler(ifx_i2c_context_t * p_ctx,
             case DL_STATE_RX_DF:
             {
                 LOG_DL("[IFX-DL]: Data Frame Received\n");
+                if (crc_received != crc_calculated)
+                {
+                    p_ctx->stats.dl_crc_errors++;
+                }
                 if ((crc_received != crc_calculated) || (0 == packet_len) ||
                     (data_len != (DL_HEADER_SIZE + packet_len)) || (DL_FCTR_SEQCTR_VALUE_RFU == seqctr) ||
                     (DL_FCTR_SEQCTR_VALUE_RESYNC == seqctr))
@@ -514,11 +658,12 @@ _STATIC_H void ifx_i2c_pl_event_handler(ifx_i2c_context_t * p_ctx,
                 {
                     // NACK for transmitted frame
                     LOG_DL("[IFX-DL]: NACK received in data frame\n");
+                    p_ctx->stats.dl_nacks_received++;
                     p_ctx->dl.state = DL_STATE_RESEND;
                     break;
                 }
                 p_ctx->dl.rx_seq_nr = (p_ctx->dl.rx_seq_nr + 1) & DL_MAX_FRAME_NUM;
-                memcpy(p_ctx->dl.p_rx_frame_buffer, p_data, data_len);
+                // The physical layer read the frame into p_rx_frame_buffer already
                 p_ctx->dl.rx_buffer_size = data_len;
 
                 // Send control frame to acknowledge reception of this data frame
@@ -550,6 +695,7 @@ _STATIC_H void ifx_i2c_pl_event_handler(ifx_i2c_context_t * p_ctx,
                 {
                     // Re-Transmit frame in case of CF CRC error
                     LOG_DL("[IFX-DL]: Retransmit frame for CF CRC error\n");
+                    p_ctx->stats.dl_crc_errors++;
                     p_ctx->dl.state = DL_STATE_RESEND;
                     break;
                 }
@@ -563,6 +709,7 @@ _STATIC_H void ifx_i2c_pl_event_handler(ifx_i2c_context_t * p_ctx,
                 if (DL_FCTR_SEQCTR_VALUE_RESYNC == seqctr)
                 {    // Re-sync received
                     LOG_DL("[IFX-DL]: Re-Sync received\n");
+                    p_ctx->stats.dl_resyncs_received++;
                     p_ctx->dl.state = DL_STATE_DISCARD;
                     p_ctx->dl.resynced = 1;
                     p_ctx->dl.tx_seq_nr = DL_MAX_FRAME_NUM;
@@ -580,6 +727,7 @@ _STATIC_H void ifx_i2c_pl_event_handler(ifx_i2c_context_t * p_ctx,
                 {
                     // NACK for transmitted frame
                     LOG_DL("[IFX-DL]: NACK received\n");
+                    p_ctx->stats.dl_nacks_received++;
                     p_ctx->dl.state = DL_STATE_RESEND;
                     break;
                 }
@@ -633,6 +781,7 @@ _STATIC_H void ifx_i2c_pl_event_handler(ifx_i2c_context_t * p_ctx,
             {
                 // Sending NACK
                 LOG_DL("[IFX-DL]: Sending NACK\n");
+                p_ctx->stats.dl_nacks_sent++;
                 p_ctx->dl.state = DL_STATE_TX;
                 continue_state_machine = FALSE;
                 //lint --e{534} suppress "Error handling is not required so return value is not checked"
@@ -665,6 +814,7 @@ _STATIC_H void ifx_i2c_pl_event_handler(ifx_i2c_context_t * p_ctx,
                 else
                 {
                     LOG_DL("[IFX-DL]: Sending re-sync after fatal error\n");
+                    p_ctx->stats.dl_resyncs++;
                     // Send re-sync to slave on error
                     //lint --e{534} suppress "As this is last step, no effect of checking return code"
                     ifx_i2c_dl_resync(p_ctx);
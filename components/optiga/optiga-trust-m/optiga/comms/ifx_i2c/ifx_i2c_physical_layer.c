@@ -37,6 +37,7 @@
 
 #include "optiga/ifx_i2c/ifx_i2c_physical_layer.h"
 #include "optiga/pal/pal_os_event.h"
+#include "optiga/common/optiga_lib_trace.h"
 
 /// @cond hidden
 
@@ -57,6 +58,9 @@
 #define PL_REG_LEN_SOFT_RESET           (2U)
 #define PL_REG_LEN_BASE_ADDR            (2U)
 
+// Smallest DATA_REG_LEN accepted from the slave
+#define PL_MIN_FRAME_SIZE               (16U)
+
 // Physical Layer State Register masks
 #define PL_REG_I2C_STATE_RESPONSE_READY (0x40)
 #define PL_REG_I2C_STATE_SOFT_RESET     (0x08)
@@ -123,6 +127,8 @@ _STATIC_H void ifx_i2c_pl_write_register(ifx_i2c_context_t * p_ctx,
                                          uint8_t reg_addr,
                                          uint16_t reg_len,
                                          const uint8_t * p_content);
+/// Physical Layer low level interface function (DATA register write from the frame headroom)
+_STATIC_H void ifx_i2c_pl_write_frame(ifx_i2c_context_t * p_ctx, uint8_t * p_frame, uint16_t frame_len);
 /// Physical Layer high level interface timer callback (Status register polling)
 _STATIC_H void ifx_i2c_pl_status_poll_callback(void * p_ctx);
 /// Physical Layer intermediate state machine (Negotiation with slave)
@@ -133,6 +139,8 @@ _STATIC_H optiga_lib_status_t ifx_i2c_pl_set_bit_rate(ifx_i2c_context_t * p_ctx,
 _STATIC_H void ifx_i2c_pl_soft_reset(ifx_i2c_context_t * p_ctx);
 /// Physical Layer high level interface state machine (read/write frames)
 _STATIC_H void ifx_i2c_pl_frame_event_handler(ifx_i2c_context_t * p_ctx, optiga_lib_status_t event);
+/// Physical Layer response polling (schedule the next STATUS read or time out)
+_STATIC_H void ifx_i2c_pl_schedule_status_poll(ifx_i2c_context_t * p_ctx);
 /// Physical Layer low level interface timer callback (I2C Nack/Busy polling)
 _STATIC_H void ifx_i2c_pal_poll_callback(void * p_ctx);
 /// Physical Layer low level guard time callback
@@ -154,6 +162,9 @@ optiga_lib_status_t ifx_i2c_pl_init(ifx_i2c_context_t * p_ctx, ifx_i2c_event_han
     p_ctx->p_pal_i2c_ctx->slave_address = p_ctx->slave_address;
     p_ctx->p_pal_i2c_ctx->upper_layer_event_handler = ifx_i2c_pl_pal_event_handler;
     p_ctx->pl.retry_counter = PL_POLLING_MAX_CNT;
+    p_ctx->pl.exec_slot = PL_EXEC_TIME_SLOTS;
+    p_ctx->pl.exec_armed = FALSE;
+    p_ctx->pl.poll_interval_us = 0;
     if (TRUE == p_ctx->do_pal_init)
     {
         // Initialize I2C driver
@@ -289,15 +300,19 @@ _STATIC_H void ifx_i2c_pl_read_register(ifx_i2c_context_t * p_ctx, uint8_t reg_a
     // Prepare transmit buffer to write register address
     p_ctx->pl.buffer[0]     = reg_addr;
     p_ctx->pl.buffer_tx_len = 1;
+    p_ctx->pl.p_buffer_tx   = p_ctx->pl.buffer;
 
-    // Set low level interface variables and start transmission
+    // Set low level interface variables and start transmission. Frames are read in place, behind the
+    // headroom of the rx frame buffer where the data link layer expects them
     p_ctx->pl.buffer_rx_len   = reg_len;
+    p_ctx->pl.p_buffer_rx     = (PL_REG_DATA == reg_addr) ? (p_ctx->rx_frame_buffer + IFX_I2C_PL_HEADER_SIZE) :
+                                                            p_ctx->pl.buffer;
     p_ctx->pl.register_action = PL_ACTION_READ_REGISTER;
     p_ctx->pl.retry_counter   = PL_POLLING_MAX_CNT;
     p_ctx->pl.i2c_cmd         = PL_I2C_CMD_WRITE;
 
     //lint --e{534} suppress "This is the last statement of asynchronous function hence return value is not checked"
-    pal_i2c_write(p_ctx->p_pal_i2c_ctx, p_ctx->pl.buffer, p_ctx->pl.buffer_tx_len);
+    pal_i2c_write(p_ctx->p_pal_i2c_ctx, p_ctx->pl.p_buffer_tx, p_ctx->pl.buffer_tx_len);
 }
 
 
@@ -312,13 +327,35 @@ _STATIC_H void ifx_i2c_pl_write_register(ifx_i2c_context_t * p_ctx,
     p_ctx->pl.buffer[0] = reg_addr;
     memcpy(p_ctx->pl.buffer + 1, p_content, reg_len);
     p_ctx->pl.buffer_tx_len = 1 + reg_len;
+    p_ctx->pl.p_buffer_tx   = p_ctx->pl.buffer;
 
     // Set Physical Layer low level interface variables and start transmission
     p_ctx->pl.register_action = PL_ACTION_WRITE_REGISTER;
     p_ctx->pl.retry_counter   = PL_POLLING_MAX_CNT;
     p_ctx->pl.i2c_cmd         = PL_I2C_CMD_WRITE;
     //lint --e{534} suppress "This is the last statement of asynchronous function hence return value is not checked"
-    pal_i2c_write(p_ctx->p_pal_i2c_ctx, p_ctx->pl.buffer, p_ctx->pl.buffer_tx_len);
+    pal_i2c_write(p_ctx->p_pal_i2c_ctx, p_ctx->pl.p_buffer_tx, p_ctx->pl.buffer_tx_len);
+}
+
+/*
+* Writes a frame to the DATA register in place. The data link layer keeps IFX_I2C_PL_HEADER_SIZE
+* bytes of headroom in front of every frame, so only the register address is written there and
+* the frame is not copied into pl.buffer.
+*/
+_STATIC_H void ifx_i2c_pl_write_frame(ifx_i2c_context_t * p_ctx, uint8_t * p_frame, uint16_t frame_len)
+{
+    LOG_PL("[IFX-PL]: Write frame len %d\n", frame_len);
+
+    p_ctx->pl.p_buffer_tx    = p_frame - IFX_I2C_PL_HEADER_SIZE;
+    p_ctx->pl.p_buffer_tx[0] = PL_REG_DATA;
+    p_ctx->pl.buffer_tx_len = IFX_I2C_PL_HEADER_SIZE + frame_len;
+
+    p_ctx->pl.register_action = PL_ACTION_WRITE_REGISTER;
+    p_ctx->pl.retry_counter   = PL_POLLING_MAX_CNT;
+    p_ctx->pl.i2c_cmd         = PL_I2C_CMD_WRITE;
+    OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_PL_XFER_START, frame_len);
+    //lint --e{534} suppress "This is the last statement of asynchronous function hence return value is not checked"
+    pal_i2c_write(p_ctx->p_pal_i2c_ctx, p_ctx->pl.p_buffer_tx, p_ctx->pl.buffer_tx_len);
 }
 
 
@@ -369,7 +406,8 @@ _STATIC_H void ifx_i2c_pl_negotiation_event_handler(void * p_input_ctx)
     uint8_t continue_negotiation;
     ifx_i2c_context_t * p_ctx = (ifx_i2c_context_t * )p_input_ctx;
     uint8_t i2c_mode_value[2];
-    uint8_t max_frame_size[2] = { (uint8_t)(p_ctx->frame_size >> 8), (uint8_t)(p_ctx->frame_size) };
+    // Always ask for the full buffer size, frame_size may hold the outcome of an earlier open
+    uint8_t max_frame_size[2] = { (uint8_t)(IFX_I2C_FRAME_SIZE >> 8), (uint8_t)(IFX_I2C_FRAME_SIZE) };
     uint16_t buffer_len = 0;
     uint16_t slave_frequency;
     uint16_t slave_frame_len;
@@ -499,10 +537,11 @@ _STATIC_H void ifx_i2c_pl_negotiation_event_handler(void * p_input_ctx)
                 p_ctx->pl.negotiate_state = PL_INIT_DONE;
                 slave_frame_len = (p_ctx->pl.buffer[0] << 8) | p_ctx->pl.buffer[1];
                 // Error if slave's frame length is more than requested frame length
-                if (p_ctx->frame_size >= slave_frame_len)
+                if ((IFX_I2C_FRAME_SIZE >= slave_frame_len) && (PL_MIN_FRAME_SIZE <= slave_frame_len))
                 {
                     p_ctx->frame_size = slave_frame_len;
                     event = IFX_I2C_STACK_SUCCESS;
+                    LOG_PL("[IFX-PL]: Frame size %d\n", slave_frame_len);
                 }
                 p_buffer = NULL;
                 buffer_len = 0;
@@ -530,10 +569,120 @@ _STATIC_H void ifx_i2c_pl_negotiation_event_handler(void * p_input_ctx)
 }
 
 
-_STATIC_H void ifx_i2c_pl_frame_event_handler(ifx_i2c_context_t * p_ctx, optiga_lib_status_t event)
+void ifx_i2c_pl_start_command(ifx_i2c_context_t * p_ctx, uint8_t command_code)
+{
+    p_ctx->pl.exec_slot = (uint8_t)(command_code % PL_EXEC_TIME_SLOTS);
+    p_ctx->pl.exec_armed = FALSE;
+    p_ctx->pl.exec_last_us = 0;
+    p_ctx->pl.poll_interval_us = 0;
+}
+
+void ifx_i2c_pl_set_final_fragment(ifx_i2c_context_t * p_ctx, uint8_t final_fragment)
+{
+    // Only the last fragment starts the command in OPTIGA, earlier ones are answered by a plain ACK
+    p_ctx->pl.exec_armed = final_fragment;
+    p_ctx->pl.exec_start_us = pal_os_timer_get_time_in_microseconds();
+    p_ctx->pl.poll_interval_us = 0;
+}
+
+// Fold the start to response ready time of the running command into its table slot (1/4 weight)
+_STATIC_H void ifx_i2c_pl_learn_exec_time(ifx_i2c_context_t * p_ctx)
+{
+    uint32_t observed_us;
+    uint32_t * p_expected_us;
+
+    if ((TRUE == p_ctx->pl.exec_armed) && (0U == p_ctx->pl.exec_last_us))
+    {
+        p_ctx->pl.exec_last_us = pal_os_timer_get_time_in_microseconds() - p_ctx->pl.exec_start_us;
+    }
+    if ((TRUE == p_ctx->pl.exec_armed) && (p_ctx->pl.exec_slot < PL_EXEC_TIME_SLOTS))
+    {
+        observed_us = pal_os_timer_get_time_in_microseconds() - p_ctx->pl.exec_start_us;
+        p_expected_us = &p_ctx->pl.exec_time_us[p_ctx->pl.exec_slot];
+        if (0U == *p_expected_us)
+        {
+            *p_expected_us = observed_us;
+        }
+        else
+        {
+            *p_expected_us = (uint32_t)(((3U * (uint64_t)*p_expected_us) + observed_us) / 4U);
+        }
+        LOG_PL("[IFX-PL]: Command slot %d ready after %d us\n", p_ctx->pl.exec_slot, observed_us);
+        // Further frames of this command (response fragments, retransmissions) poll without a prediction
+        p_ctx->pl.exec_slot = PL_EXEC_TIME_SLOTS;
+    }
+    p_ctx->pl.exec_armed = FALSE;
+    p_ctx->pl.poll_interval_us = 0;
+}
+
+_STATIC_H void ifx_i2c_pl_schedule_status_poll(ifx_i2c_context_t * p_ctx)
 {
     uint32_t time_stamp_diff;
     uint32_t current_time;
+    uint32_t elapsed_us;
+    uint32_t expected_us;
+    uint32_t interval_us;
+
+    current_time = pal_os_timer_get_time_in_milliseconds();
+    time_stamp_diff = (current_time - p_ctx->dl.frame_start_time);
+    if (p_ctx->dl.frame_start_time > current_time)
+    {
+        time_stamp_diff = (0xFFFFFFFF + (current_time -
+                           p_ctx->dl.frame_start_time)) + 0x01;
+    }
+    // Give up once the data poll timeout is reached
+    if (time_stamp_diff >= p_ctx->dl.data_poll_timeout)
+    {
+        p_ctx->stats.pl_poll_timeouts++;
+        p_ctx->pl.frame_state = PL_STATE_READY;
+        p_ctx->pl.upper_layer_event_handler(p_ctx, IFX_I2C_STACK_ERROR, 0, 0);
+        return;
+    }
+
+    if (0U == p_ctx->pl.poll_interval_us)
+    {
+        // First miss: sleep until just before the learned completion time of this command
+        interval_us = PL_DATA_POLLING_MIN_US;
+        if ((TRUE == p_ctx->pl.exec_armed) && (p_ctx->pl.exec_slot < PL_EXEC_TIME_SLOTS))
+        {
+            expected_us = p_ctx->pl.exec_time_us[p_ctx->pl.exec_slot];
+            expected_us -= (expected_us / 16U);
+            elapsed_us = pal_os_timer_get_time_in_microseconds() - p_ctx->pl.exec_start_us;
+            if (0U == expected_us)
+            {
+                // Not seen yet, start at the fixed interval
+                interval_us = PL_DATA_POLLING_INVERVAL_US;
+            }
+            else if (expected_us > (elapsed_us + PL_DATA_POLLING_MIN_US))
+            {
+                interval_us = expected_us - elapsed_us;
+            }
+        }
+        p_ctx->pl.poll_interval_us = (interval_us > PL_DATA_POLLING_MIN_US) ?
+                                     PL_DATA_POLLING_MIN_US : (2U * PL_DATA_POLLING_MIN_US);
+    }
+    else
+    {
+        // Past the prediction: back off exponentially up to the fixed interval
+        interval_us = p_ctx->pl.poll_interval_us;
+        if ((TRUE == p_ctx->pl.exec_armed) && (p_ctx->pl.exec_slot < PL_EXEC_TIME_SLOTS) &&
+            (0U != p_ctx->pl.exec_time_us[p_ctx->pl.exec_slot]))
+        {
+            p_ctx->stats.pl_poll_overruns++;
+        }
+        p_ctx->pl.poll_interval_us = ((2U * interval_us) > PL_DATA_POLLING_INVERVAL_US) ?
+                                     PL_DATA_POLLING_INVERVAL_US : (2U * interval_us);
+    }
+
+    OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_PL_POLL, interval_us);
+    pal_os_event_register_callback_oneshot(p_ctx->pal_os_event_ctx,
+                                           ifx_i2c_pl_status_poll_callback,
+                                           (void * )p_ctx,
+                                           interval_us);
+}
+
+_STATIC_H void ifx_i2c_pl_frame_event_handler(ifx_i2c_context_t * p_ctx, optiga_lib_status_t event)
+{
     uint16_t frame_size;
     if (IFX_I2C_STACK_SUCCESS != event)
     {
@@ -580,31 +729,14 @@ _STATIC_H void ifx_i2c_pl_frame_event_handler(ifx_i2c_context_t * p_ctx, optiga_
                     frame_size = (p_ctx->pl.buffer[2] << 8) | p_ctx->pl.buffer[3];
                     if ((frame_size > 0) && (frame_size <= p_ctx->frame_size))
                     {
+                        OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_PL_READY, frame_size);
+                        ifx_i2c_pl_learn_exec_time(p_ctx);
                         p_ctx->pl.frame_state = PL_STATE_RXTX;
                         ifx_i2c_pl_read_register(p_ctx,PL_REG_DATA, frame_size);
                     }
                     else
                     {
-                        current_time = pal_os_timer_get_time_in_milliseconds();
-                        time_stamp_diff = (current_time - p_ctx->dl.frame_start_time);
-                        if (p_ctx->dl.frame_start_time > current_time)
-                        {
-                            time_stamp_diff = (0xFFFFFFFF + (current_time -
-                                               p_ctx->dl.frame_start_time)) + 0x01;
-                        }
-                        // Continue polling STATUS register if retry limit is not reached
-                        if (time_stamp_diff < p_ctx->dl.data_poll_timeout)
-                        {
-                            pal_os_event_register_callback_oneshot(p_ctx->pal_os_event_ctx,
-                                                                    ifx_i2c_pl_status_poll_callback,
-                                                                   (void * )p_ctx,
-                                                                   PL_DATA_POLLING_INVERVAL_US);
-                        }
-                        else
-                        {
-                            p_ctx->pl.frame_state = PL_STATE_READY;
-                            p_ctx->pl.upper_layer_event_handler(p_ctx, IFX_I2C_STACK_ERROR, 0, 0);
-                        }
+                        ifx_i2c_pl_schedule_status_poll(p_ctx);
                     }
                 }
                 // Write frame is slave is not busy
@@ -612,34 +744,12 @@ _STATIC_H void ifx_i2c_pl_frame_event_handler(ifx_i2c_context_t * p_ctx, optiga_
                 {
                     // Write frame if device is not busy, otherwise wait and poll STATUS again later
                     p_ctx->pl.frame_state = PL_STATE_RXTX;
-                    ifx_i2c_pl_write_register(p_ctx,
-                                              PL_REG_DATA,
-                                              p_ctx->pl.tx_frame_len,
-                                              (uint8_t * )p_ctx->pl.p_tx_frame);
+                    ifx_i2c_pl_write_frame(p_ctx, p_ctx->pl.p_tx_frame, p_ctx->pl.tx_frame_len);
                 }
                 // Continue checking the slave status register
                 else
                 {
-                    current_time = pal_os_timer_get_time_in_milliseconds();
-                    time_stamp_diff = (current_time - p_ctx->dl.frame_start_time);
-                    if (p_ctx->dl.frame_start_time > current_time)
-                    {
-                        time_stamp_diff = (0xFFFFFFFF + (current_time -
-                                           p_ctx->dl.frame_start_time)) + 0x01;
-                    }
-                    // Continue polling STATUS register if retry limit is not reached
-                    if (time_stamp_diff < p_ctx->dl.data_poll_timeout)
-                    {
-                        pal_os_event_register_callback_oneshot(p_ctx->pal_os_event_ctx,
-                                                               ifx_i2c_pl_status_poll_callback,
-                                                               (void * )p_ctx,
-                                                               PL_DATA_POLLING_INVERVAL_US);
-                    }
-                    else
-                    {
-                        p_ctx->pl.frame_state = PL_STATE_READY;
-                        p_ctx->pl.upper_layer_event_handler(p_ctx, IFX_I2C_STACK_ERROR, 0, 0);
-                    }
+                    ifx_i2c_pl_schedule_status_poll(p_ctx);
                 }
             }
             break;
@@ -648,8 +758,14 @@ _STATIC_H void ifx_i2c_pl_frame_event_handler(ifx_i2c_context_t * p_ctx, optiga_
             {
                 // Writing/reading of frame to/from DATA register complete
                 p_ctx->pl.frame_state = PL_STATE_READY;
+                OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_PL_XFER_END, p_ctx->pl.buffer_rx_len);
+                // OPTIGA starts executing once the last fragment of the command is written
+                if ((PL_ACTION_WRITE_FRAME == p_ctx->pl.frame_action) && (TRUE == p_ctx->pl.exec_armed))
+                {
+                    OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_PL_EXEC_START, p_ctx->pl.exec_slot);
+                }
                 p_ctx->pl.upper_layer_event_handler(p_ctx,IFX_I2C_STACK_SUCCESS,
-                                                    p_ctx->pl.buffer,
+                                                    p_ctx->pl.p_buffer_rx,
                                                     p_ctx->pl.buffer_rx_len);
             }
             break;
@@ -671,13 +787,13 @@ _STATIC_H void ifx_i2c_pal_poll_callback(void * p_ctx)
     {
         LOG_PL("[IFX-PL]: Poll Timer elapsed -> Restart TX\n");
         //lint --e{534} suppress "This is the last statement of asynchronous function hence return value is not checked"
-        pal_i2c_write(p_local_ctx->p_pal_i2c_ctx, p_local_ctx->pl.buffer, p_local_ctx->pl.buffer_tx_len);
+        pal_i2c_write(p_local_ctx->p_pal_i2c_ctx, p_local_ctx->pl.p_buffer_tx, p_local_ctx->pl.buffer_tx_len);
     }
     else if (PL_I2C_CMD_READ == p_local_ctx->pl.i2c_cmd)
     {
         LOG_PL("[IFX-PL]: Poll Timer elapsed  -> Restart Read Register -> Start TX\n");
         //lint --e{534} suppress "This is the last statement of asynchronous function hence return value is not checked"
-        pal_i2c_read(p_local_ctx->p_pal_i2c_ctx, p_local_ctx->pl.buffer, p_local_ctx->pl.buffer_rx_len);
+        pal_i2c_read(p_local_ctx->p_pal_i2c_ctx, p_local_ctx->pl.p_buffer_rx, p_local_ctx->pl.buffer_rx_len);
     }
 }
 
@@ -692,7 +808,7 @@ _STATIC_H void ifx_i2c_pl_guard_time_callback(void * p_ctx)
             LOG_PL("[IFX-PL]: GT done-> Start RX\n");
             p_local_ctx->pl.i2c_cmd = PL_I2C_CMD_READ;
             //lint --e{534} suppress "This is the last statement of asynchronous function hence return value is not checked"
-            pal_i2c_read(p_local_ctx->p_pal_i2c_ctx, p_local_ctx->pl.buffer, p_local_ctx->pl.buffer_rx_len);
+            pal_i2c_read(p_local_ctx->p_pal_i2c_ctx, p_local_ctx->pl.p_buffer_rx, p_local_ctx->pl.buffer_rx_len);
         }
         else if (PL_I2C_CMD_READ == p_local_ctx->pl.i2c_cmd)
         {
@@ -715,6 +831,7 @@ _STATIC_H void ifx_i2c_pl_pal_event_handler(void * p_ctx, optiga_lib_status_t ev
         case PAL_I2C_EVENT_ERROR:
         case PAL_I2C_EVENT_BUSY:
             // Error event usually occurs when the device is in sleep mode and needs time to wake up
+            p_local_ctx->stats.i2c_nacks++;
             if (p_local_ctx->pl.retry_counter--)
             {
                 LOG_PL("[IFX-PL]: PAL Error -> Continue polling\n");
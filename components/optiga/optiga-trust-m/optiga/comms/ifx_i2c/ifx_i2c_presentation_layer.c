@@ -39,6 +39,7 @@
 #include "optiga/ifx_i2c/ifx_i2c_transport_layer.h"
 #include "optiga/pal/pal_crypt.h"
 #include "optiga/common/optiga_lib_common.h"
+#include "optiga/common/optiga_lib_trace.h"
 #include "optiga/pal/pal_ifx_i2c_config.h"
 // include lower layer header
 /// @cond hidden
@@ -373,6 +374,7 @@ _STATIC_H optiga_lib_status_t ifx_i2c_prl_encrypt_msg(ifx_i2c_context_t * p_ctx,
         memcpy(nonce_data, &p_ctx->prl.session_key[PRL_MASTER_ENCRYPTION_NONCE_OFFSET], PRL_MASTER_NONCE_LENGTH);
         optiga_common_set_uint32(&nonce_data[PRL_MASTER_NONCE_LENGTH], seq_number);
 
+        OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_PRL_PROTECT_START, data_len);
         if (PAL_STATUS_SUCCESS != (pal_crypt_encrypt_aes128_ccm(NULL,
                                                                 p_data,
                                                                 data_len,
@@ -387,6 +389,7 @@ _STATIC_H optiga_lib_status_t ifx_i2c_prl_encrypt_msg(ifx_i2c_context_t * p_ctx,
         {
             break;
         }
+        OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_PRL_PROTECT_END, data_len);
         return_status = IFX_I2C_STACK_SUCCESS;
     } while (FALSE);
     return (return_status);
@@ -411,6 +414,7 @@ _STATIC_H optiga_lib_status_t ifx_i2c_prl_decrypt_msg(ifx_i2c_context_t * p_ctx,
         memcpy(nonce_data, &p_ctx->prl.session_key[decrypt_nonce_offset], PRL_MASTER_NONCE_LENGTH);
         optiga_common_set_uint32(&nonce_data[PRL_MASTER_NONCE_LENGTH], seq_number);
 
+        OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_PRL_UNPROTECT_START, data_len);
         if (PAL_STATUS_SUCCESS != (pal_crypt_decrypt_aes128_ccm(NULL,
                                                                 p_data,
                                                                 (data_len + IFX_I2C_PRL_MAC_SIZE),
@@ -424,6 +428,7 @@ _STATIC_H optiga_lib_status_t ifx_i2c_prl_decrypt_msg(ifx_i2c_context_t * p_ctx,
         {
             break;
         }
+        OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_PRL_UNPROTECT_END, data_len);
         return_status = IFX_I2C_STACK_SUCCESS;
     } while (FALSE);
     return (return_status);
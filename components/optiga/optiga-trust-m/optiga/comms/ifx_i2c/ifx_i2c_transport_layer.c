@@ -37,6 +37,7 @@
 
 #include "optiga/ifx_i2c/ifx_i2c_transport_layer.h"
 #include "optiga/ifx_i2c/ifx_i2c_data_link_layer.h" // include lower layer header
+#include "optiga/common/optiga_lib_trace.h"
 
 /// @cond hidden
 
@@ -90,6 +91,8 @@ _STATIC_H optiga_lib_status_t ifx_i2c_tl_resend_packets(ifx_i2c_context_t * p_ct
 _STATIC_H optiga_lib_status_t ifx_i2c_tl_send_chaining_error(ifx_i2c_context_t * p_ctx);
 _STATIC_H uint8_t ifx_i2c_tl_calculate_pctr(const ifx_i2c_context_t * p_ctx);
 _STATIC_H optiga_lib_status_t ifx_i2c_tl_check_chaining_error(uint8_t current_chaning, uint8_t previous_chaining);
+//lint --e{526} suppress "This API is defined in ifx_i2c_physical_layer.c file. As it is a low level API, it is not exposed in header file"
+extern void ifx_i2c_pl_set_final_fragment(ifx_i2c_context_t * p_ctx, uint8_t final_fragment);
 /// @endcond
 
 optiga_lib_status_t ifx_i2c_tl_init(ifx_i2c_context_t * p_ctx, ifx_i2c_event_handler_t handler)
@@ -106,7 +109,6 @@ optiga_lib_status_t ifx_i2c_tl_init(ifx_i2c_context_t * p_ctx, ifx_i2c_event_han
     p_ctx->tl.initialization_state = TRUE;
     p_ctx->tl.upper_layer_event_handler = handler;
     p_ctx->tl.state = TL_STATE_IDLE;
-    p_ctx->tl.max_packet_length = p_ctx->frame_size - (DL_HEADER_SIZE + TL_HEADER_SIZE);
 
     return (IFX_I2C_STACK_SUCCESS);
 }
@@ -134,6 +136,8 @@ optiga_lib_status_t ifx_i2c_tl_transceive(ifx_i2c_context_t * p_ctx,
             break;
         }
         p_ctx->tl.state = TL_STATE_TX;
+        // The physical layer negotiates frame_size after init, fragment by the agreed length
+        p_ctx->tl.max_packet_length = p_ctx->frame_size - (DL_HEADER_SIZE + TL_HEADER_SIZE);
         p_ctx->tl.api_start_time = pal_os_timer_get_time_in_milliseconds();
         p_ctx->tl.p_actual_packet = p_packet;
         p_ctx->tl.actual_packet_length = packet_len;
@@ -204,14 +208,15 @@ _STATIC_H optiga_lib_status_t ifx_i2c_tl_send_next_fragment(ifx_i2c_context_t *
         tl_fragment_size = p_ctx->tl.actual_packet_length - p_ctx->tl.packet_offset;
     }
     // Assign the pctr
-    //lint --e{835} suppress "IFX_I2C_DL_HEADER_OFFSET macro is defined as 0x00 and is kept for future enhancements"
     p_ctx->tx_frame_buffer[IFX_I2C_TL_HEADER_OFFSET] = (pctr | IFX_I2C_PRESENCE_BIT);
-    //copy the data
-    //lint --e{835} suppress "IFX_I2C_DL_HEADER_OFFSET macro is defined as 0x00 and is kept for future enhancements"
+    // The ACK of an earlier fragment comes back at once, only the last one waits for command execution
+    ifx_i2c_pl_set_final_fragment(p_ctx, (uint8_t)((TL_CHAINING_NO == pctr) || (TL_CHAINING_LAST == pctr)));
+    // copy the data, the only copy of the payload on its way to the bus
     memcpy(p_ctx->tx_frame_buffer+IFX_I2C_TL_HEADER_OFFSET + 1,
            p_ctx->tl.p_actual_packet + p_ctx->tl.packet_offset,
            tl_fragment_size);
     p_ctx->tl.packet_offset += tl_fragment_size;
+    OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_TL_TX_FRAGMENT, tl_fragment_size);
     //send the fragment to dl layer
     return (ifx_i2c_dl_send_frame(p_ctx,tl_fragment_size + 1));
 }
@@ -219,7 +224,6 @@ _STATIC_H optiga_lib_status_t ifx_i2c_tl_send_next_fragment(ifx_i2c_context_t *
 _STATIC_H optiga_lib_status_t ifx_i2c_tl_send_chaining_error(ifx_i2c_context_t * p_ctx)
 {
     uint16_t tl_fragment_size = 1;
-    //lint --e{835} suppress "IFX_I2C_DL_HEADER_OFFSET macro is defined as 0x00 and is kept for future enhancements"
     p_ctx->tx_frame_buffer[IFX_I2C_TL_HEADER_OFFSET] = 0x07;
     p_ctx->tl.total_recv_length = 0;
     //send the fragment to dl layer
@@ -326,6 +330,7 @@ _STATIC_H void ifx_i2c_dl_event_handler(ifx_i2c_context_t * p_ctx,
                         if (TL_CHAINING_ERROR == chaining)
                         {
                             LOG_TL("[IFX-TL]: Tx:Chaining error received while Tx\n");
+                            p_ctx->stats.tl_chaining_errors++;
                             p_ctx->tl.state = TL_STATE_RESEND;
                             break;
                         }
@@ -375,6 +380,7 @@ _STATIC_H void ifx_i2c_dl_event_handler(ifx_i2c_context_t * p_ctx,
                 // Reception of frame from Data Link layer
                 if (0 != (event & IFX_I2C_DL_EVENT_RX_SUCCESS))
                 {
+                    OPTIGA_LIB_TRACE(OPTIGA_LIB_TRACE_TL_RX_FRAGMENT, data_len);
                     // Message must contain at least the transport layer header
                     if (data_len < TL_HEADER_SIZE)
                     {
@@ -399,6 +405,7 @@ _STATIC_H void ifx_i2c_dl_event_handler(ifx_i2c_context_t * p_ctx,
                     if (IFX_I2C_STACK_SUCCESS != ifx_i2c_tl_check_chaining_error(chaining,p_ctx->tl.previous_chaining))
                     {
                         LOG_TL("[IFX-TL]: Rx : Chaining state is not correct\n");
+                        p_ctx->stats.tl_chaining_errors++;
                         p_ctx->tl.state = TL_STATE_RESEND;
                         break;
                     }
@@ -454,6 +461,7 @@ _STATIC_H void ifx_i2c_dl_event_handler(ifx_i2c_context_t * p_ctx,
                 if (data_len != (p_ctx->tl.max_packet_length + 1))
                 {
                     LOG_TL("[IFX-TL]: Chain : Data len not equal to max frame size\n");
+                    p_ctx->stats.tl_chaining_errors++;
                     p_ctx->tl.state = TL_STATE_CHAINING_ERROR;
                     break;
                 }
@@ -39,6 +39,8 @@
 #include "optiga/common/optiga_lib_logger.h"
 #include "optiga/ifx_i2c/ifx_i2c.h"
 #include "optiga/pal/pal_os_event.h"
+#include "optiga/pal/pal_os_timer.h"
+#include "optiga/pal/pal_i2c_capture.h"
 
 /// @cond hidden
 
@@ -60,16 +62,43 @@ optiga_comms_t optiga_comms = {
 #endif
                                NULL};
 
+#if (OPTIGA_MAX_INSTANCES > 1)
+optiga_comms_t optiga_comms_1 = {
+                               (void *)&ifx_i2c_context_1,
+                               NULL,
+                               NULL,
+                               0,
+                               0,
+#ifdef OPTIGA_COMMS_SHIELDED_CONNECTION
+                               0,
+                               0,
+                               0,
+#endif
+                               NULL};
+#endif
+
+// Comms instance of each OPTIGA, indexed by optiga_instance_id
+_STATIC_H optiga_comms_t * const g_optiga_comms_list[] = {
+                                                          &optiga_comms,
+#if (OPTIGA_MAX_INSTANCES > 1)
+                                                          &optiga_comms_1,
+#endif
+                                                         };
+
 _STATIC_H optiga_lib_status_t check_optiga_comms_state(optiga_comms_t *p_ctx);
 _STATIC_H void ifx_i2c_event_handler(void* p_ctx, optiga_lib_status_t event);
 
-optiga_comms_t * optiga_comms_create(callback_handler_t callback, void * context)
+optiga_comms_t * optiga_comms_create(uint8_t optiga_instance_id, callback_handler_t callback, void * context)
 {
     optiga_comms_t * p_optiga_comms = NULL;
 
     do
     {
-        p_optiga_comms = &optiga_comms;
+        if (optiga_instance_id >= (uint8_t)(sizeof(g_optiga_comms_list) / sizeof(g_optiga_comms_list[0])))
+        {
+            break;
+        }
+        p_optiga_comms = g_optiga_comms_list[optiga_instance_id];
 
         if (FALSE == p_optiga_comms->instance_init_state)
         {
@@ -162,6 +191,13 @@ optiga_lib_status_t optiga_comms_transceive(optiga_comms_t * p_ctx,
         ((ifx_i2c_context_t * )(p_ctx->p_comms_ctx))->protection_level = p_ctx->protection_level;
         ((ifx_i2c_context_t * )(p_ctx->p_comms_ctx))->protocol_version = p_ctx->protocol_version;
         ((ifx_i2c_context_t * )(p_ctx->p_comms_ctx))->manage_context_operation = p_ctx->manage_context_operation;
+        PAL_I2C_CAPTURE(((ifx_i2c_context_t * )(p_ctx->p_comms_ctx))->p_pal_i2c_ctx, PAL_I2C_CAPTURE_APDU,
+                        pal_os_timer_get_time_in_microseconds(), &p_tx_data[OPTIGA_COMMS_DATA_OFFSET],
+                        tx_data_length, p_ctx->protection_level);
+#else
+        PAL_I2C_CAPTURE(((ifx_i2c_context_t * )(p_ctx->p_comms_ctx))->p_pal_i2c_ctx, PAL_I2C_CAPTURE_APDU,
+                        pal_os_timer_get_time_in_microseconds(), &p_tx_data[OPTIGA_COMMS_DATA_OFFSET],
+                        tx_data_length, 0);
 #endif
         status = (ifx_i2c_transceive((ifx_i2c_context_t * )(p_ctx->p_comms_ctx),
                                      p_tx_data,
@@ -177,6 +213,11 @@ optiga_lib_status_t optiga_comms_transceive(optiga_comms_t * p_ctx,
 }
 
 
+uint32_t optiga_comms_get_exec_time(const optiga_comms_t * p_ctx)
+{
+    return (((const ifx_i2c_context_t * )(p_ctx->p_comms_ctx))->pl.exec_last_us);
+}
+
 optiga_lib_status_t optiga_comms_close(optiga_comms_t * p_ctx)
 {
     optiga_lib_status_t status = OPTIGA_COMMS_ERROR;
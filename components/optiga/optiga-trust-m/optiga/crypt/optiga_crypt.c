@@ -40,6 +40,12 @@
 #include "optiga/common/optiga_lib_logger.h"
 #include "optiga/common/optiga_lib_common_internal.h"
 #include "optiga/pal/pal_os_memory.h"
+#ifdef OPTIGA_UTIL_READ_CACHE_ENTRIES
+#include "optiga/optiga_util.h"
+#endif
+
+// Every instance owns an optiga cmd instance, so the cmd registrations bound the pool
+OPTIGA_LIB_POOL_DEFINE(g_optiga_crypt_pool, optiga_crypt_t, OPTIGA_CMD_MAX_REGISTRATIONS * OPTIGA_MAX_INSTANCES);
 
 /// ECDSA FIPS 186-3 without hash
 #define OPTIGA_CRYPT_ECDSA_FIPS_186_3_WITHOUT_HASH                  (0x11)
@@ -173,6 +179,10 @@ _STATIC_H optiga_lib_status_t optiga_crypt_generate_keypair(optiga_crypt_t * me,
         else
         {
             p_params->private_key_oid = (optiga_key_id_t)(* ((uint16_t* )p_private_key));
+#ifdef OPTIGA_UTIL_READ_CACHE_ENTRIES
+            // Key generation updates the metadata of the key object
+            optiga_util_read_cache_invalidate((uint16_t)p_params->private_key_oid);
+#endif
         }
 
         p_params->public_key = p_public_key;
@@ -450,6 +460,15 @@ _STATIC_H optiga_lib_status_t optiga_crypt_symmetric_mode_generic(optiga_crypt_t
 
     do
     {
+        // In place (out_data == in_data) is fine: each packet is copied into the APDU before its
+        // result is written back at the same offset. Output starting inside the input would
+        // overwrite data that is not sent yet.
+        if ((NULL != out_data) && (NULL != in_data) && (out_data > in_data) &&
+            (out_data < (in_data + in_data_length)))
+        {
+            break;
+        }
+
         // Check if instance is in use
         if (OPTIGA_LIB_INSTANCE_BUSY == me->instance_state)
         {
@@ -710,7 +729,7 @@ optiga_crypt_t * optiga_crypt_create(uint8_t optiga_instance_id,
             break;
         }
 #endif
-        me = (optiga_crypt_t *)pal_os_calloc(1, sizeof(optiga_crypt_t));
+        me = (optiga_crypt_t *)optiga_lib_pool_alloc(&g_optiga_crypt_pool);
         if (NULL == me)
         {
             break;
@@ -728,7 +747,7 @@ optiga_crypt_t * optiga_crypt_create(uint8_t optiga_instance_id,
                                        me);
         if (NULL == me->my_cmd)
         {
-            pal_os_free(me);
+            optiga_lib_pool_free(&g_optiga_crypt_pool, me);
             me = NULL;
         }
 
@@ -737,6 +756,11 @@ optiga_crypt_t * optiga_crypt_create(uint8_t optiga_instance_id,
     return (me);
 }
 
+void optiga_crypt_get_pool_stats(optiga_lib_pool_stats_t * p_stats)
+{
+    optiga_lib_pool_get_stats(&g_optiga_crypt_pool, p_stats);
+}
+
 optiga_lib_status_t optiga_crypt_destroy(optiga_crypt_t * me)
 {
     optiga_lib_status_t return_value;
@@ -756,7 +780,7 @@ optiga_lib_status_t optiga_crypt_destroy(optiga_crypt_t * me)
             break;
         }
         return_value = optiga_cmd_destroy(me->my_cmd);
-        pal_os_free(me);
+        optiga_lib_pool_free(&g_optiga_crypt_pool, me);
 
     } while (FALSE);
     return (return_value);
@@ -1393,6 +1417,79 @@ optiga_lib_status_t optiga_crypt_symmetric_encrypt(optiga_crypt_t * me,
     return (return_value);
 }
 
+#ifdef OPTIGA_CRYPT_RANDOM_ENABLED
+optiga_lib_status_t optiga_crypt_symmetric_encrypt_random_iv(optiga_crypt_t * me,
+                                                             optiga_symmetric_encryption_mode_t encryption_mode,
+                                                             optiga_rng_type_t rng_type,
+                                                             optiga_key_id_t symmetric_key_oid,
+                                                             const uint8_t * plain_data,
+                                                             uint32_t plain_data_length,
+                                                             uint8_t * iv,
+                                                             uint16_t iv_length,
+                                                             uint8_t * encrypted_data,
+                                                             uint32_t * encrypted_data_length)
+{
+    optiga_lib_status_t return_value = OPTIGA_CRYPT_ERROR;
+    optiga_random_encrypt_sym_params_t * p_params;
+    OPTIGA_CRYPT_LOG_MESSAGE(__FUNCTION__);
+    do
+    {
+#ifdef OPTIGA_LIB_DEBUG_NULL_CHECK
+        if ((NULL == me) || (NULL == me->my_cmd) || (NULL == plain_data) || (NULL == iv) ||
+            (NULL == encrypted_data) || (NULL == encrypted_data_length))
+        {
+            return_value = OPTIGA_CRYPT_ERROR_INVALID_INPUT;
+            break;
+        }
+#endif
+        if ((0U == iv_length) ||
+            ((encrypted_data > plain_data) && (encrypted_data < (plain_data + plain_data_length))))
+        {
+            return_value = OPTIGA_CRYPT_ERROR_INVALID_INPUT;
+            break;
+        }
+        if (OPTIGA_LIB_INSTANCE_BUSY == me->instance_state)
+        {
+            return_value = OPTIGA_CRYPT_ERROR_INSTANCE_IN_USE;
+            break;
+        }
+        me->instance_state = OPTIGA_LIB_INSTANCE_BUSY;
+
+        p_params = (optiga_random_encrypt_sym_params_t *)&(me->params.optiga_random_encrypt_sym_params);
+        pal_os_memset(&me->params, 0x00, sizeof(optiga_crypt_params_t));
+
+        p_params->rng_type = (uint8_t)rng_type;
+        p_params->random_iv = iv;
+        p_params->encrypt.mode = (uint8_t)encryption_mode;
+        p_params->encrypt.symmetric_key_oid = (uint16_t)symmetric_key_oid;
+        p_params->encrypt.in_data = plain_data;
+        p_params->encrypt.in_data_length = plain_data_length;
+        p_params->encrypt.iv = iv;
+        p_params->encrypt.iv_length = iv_length;
+        p_params->encrypt.out_data = encrypted_data;
+        p_params->encrypt.out_data_length = encrypted_data_length;
+        p_params->encrypt.original_sequence = OPTIGA_CRYPT_SYM_START_FINAL;
+        p_params->encrypt.operation_mode = OPTIGA_CRYPT_SYMMETRIC_ENCRYPTION;
+
+#ifdef OPTIGA_COMMS_SHIELDED_CONNECTION
+        me->protection_level |= OPTIGA_COMMS_COMMAND_PROTECTION;
+#endif //OPTIGA_COMMS_SHIELDED_CONNECTION
+        OPTIGA_PROTECTION_ENABLE(me->my_cmd, me);
+        OPTIGA_PROTECTION_SET_VERSION(me->my_cmd, me);
+
+        return_value = optiga_cmd_random_encrypt_sym(me->my_cmd,
+                                                     (uint8_t)encryption_mode,
+                                                     p_params);
+        if (OPTIGA_LIB_SUCCESS != return_value)
+        {
+            me->instance_state = OPTIGA_LIB_INSTANCE_FREE;
+        }
+    } while (FALSE);
+    optiga_crypt_reset_protection_level(me);
+    return (return_value);
+}
+#endif //OPTIGA_CRYPT_RANDOM_ENABLED
+
 optiga_lib_status_t optiga_crypt_symmetric_encrypt_start(optiga_crypt_t * me,
                                                          optiga_symmetric_encryption_mode_t encryption_mode,
                                                          optiga_key_id_t symmetric_key_oid,
@@ -2027,6 +2124,13 @@ optiga_lib_status_t optiga_crypt_symmetric_generate_key(optiga_crypt_t * me,
         p_params->key_usage = key_usage;
         p_params->export_symmetric_key = export_symmetric_key;
         p_params->symmetric_key = symmetric_key;
+#ifdef OPTIGA_UTIL_READ_CACHE_ENTRIES
+        if (FALSE == export_symmetric_key)
+        {
+            // Key generation updates the metadata of the key object
+            optiga_util_read_cache_invalidate((uint16_t)*((optiga_key_id_t *)symmetric_key));
+        }
+#endif
         
         OPTIGA_PROTECTION_ENABLE(me->my_cmd, me);
         OPTIGA_PROTECTION_SET_VERSION(me->my_cmd, me);
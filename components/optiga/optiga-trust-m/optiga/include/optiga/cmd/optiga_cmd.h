@@ -44,6 +44,18 @@ extern "C" {
 
 #include "optiga/common/optiga_lib_common.h"
 
+/// Scheduling priority, picked after every waiting request of a higher class
+#define OPTIGA_CMD_PRIORITY_LOW                 (0x00)
+/// Default scheduling priority of a new instance
+#define OPTIGA_CMD_PRIORITY_NORMAL              (0x01)
+/// Scheduling priority for latency critical requests
+#define OPTIGA_CMD_PRIORITY_HIGH                (0x02)
+
+#ifndef OPTIGA_CMD_QUEUE_AGING_TIME_US
+/// Waiting time after which a queued request is scheduled one priority class higher
+#define OPTIGA_CMD_QUEUE_AGING_TIME_US          (500000U)
+#endif
+
 /** \brief OPTIGA command instance structure type*/
 typedef struct optiga_cmd optiga_cmd_t;
 
@@ -98,6 +110,198 @@ optiga_cmd_t * optiga_cmd_create(uint8_t optiga_instance_id,
  */
 optiga_lib_status_t optiga_cmd_destroy(optiga_cmd_t * me);
 
+/**
+ * \brief Reads the occupancy of the #optiga_cmd_t instance pool.
+ *
+ * \details
+ * Reads the occupancy of the #optiga_cmd_t instance pool.
+ * - Instances are allocated from a static pool of #OPTIGA_CMD_MAX_REGISTRATIONS entries per OPTIGA instance instead of the heap.<br>
+ *
+ * \pre
+ * - None
+ *
+ * \note
+ * - None
+ *
+ * \param[out]     p_stats          Capacity, instances in use and peak since start-up
+ *
+ */
+void optiga_cmd_get_pool_stats(optiga_lib_pool_stats_t * p_stats);
+
+/**
+ * \brief Gives the size of the static context of one OPTIGA instance.
+ *
+ * \details
+ * Gives the size of the static context of one OPTIGA instance
+ * - One context per instance, each with a comms buffer of #OPTIGA_MAX_COMMS_BUFFER_SIZE plus protocol overhead.<br>
+ *
+ * \pre
+ * - None
+ *
+ * \note
+ * - None
+ *
+ * \retval         Context size in bytes
+ *
+ */
+uint32_t optiga_cmd_get_context_size(void);
+
+#ifdef OPTIGA_CMD_GOVERNOR
+/// Estimated security event counter the governor keeps key commands at or below
+#ifndef OPTIGA_CMD_GOVERNOR_LIMIT
+    #define OPTIGA_CMD_GOVERNOR_LIMIT               (4U)
+#endif
+/// Time in which OPTIGA lowers the security event counter by one
+#ifndef OPTIGA_CMD_GOVERNOR_DECAY_MS
+    #define OPTIGA_CMD_GOVERNOR_DECAY_MS            (500U)
+#endif
+/// Key commands (encrypt, decrypt, sign, shared secret, derive key) estimated as one security event, 1 to 65536
+#ifndef OPTIGA_CMD_GOVERNOR_COMMANDS
+    #define OPTIGA_CMD_GOVERNOR_COMMANDS            (32U)
+#endif
+
+/** @brief Counters of the command governor of one OPTIGA instance */
+typedef struct optiga_cmd_governor_stats
+{
+    /// Key commands scheduled
+    uint32_t commands;
+    /// Key commands held back to stay at the limit
+    uint32_t paced;
+    /// Sum of the hold times in microseconds
+    uint64_t paced_us;
+    /// Reads of the security event counter (0xE0C5) the estimate was set from
+    uint32_t sec_reads;
+    /// Value of the last read
+    uint8_t last_sec;
+    /// Current estimate, rounded up
+    uint8_t level;
+} optiga_cmd_governor_stats_t;
+
+/**
+ * \brief Reads the counters of the command governor.
+ *
+ * \details
+ * Reads the counters of the command governor.
+ * - With #OPTIGA_CMD_GOVERNOR defined, the scheduler estimates the security event counter: every key command adds
+ *   1/#OPTIGA_CMD_GOVERNOR_COMMANDS, and the estimate drops by one per #OPTIGA_CMD_GOVERNOR_DECAY_MS. A key command
+ *   that would raise it above #OPTIGA_CMD_GOVERNOR_LIMIT is held back in its queue slot until it would not, so a
+ *   burst is spread out instead of running into the delays OPTIGA adds at a raised counter.<br>
+ * - Every read of data object 0xE0C5 through the library replaces the estimate with the value OPTIGA returned.<br>
+ *
+ * \pre
+ * - None
+ *
+ * \note
+ * - Runs in the PAL critical section.
+ *
+ * \param[in]      optiga_instance_id    OPTIGA instance
+ * \param[out]     p_stats               Counters, zero for an invalid instance
+ *
+ */
+void optiga_cmd_governor_get_stats(uint8_t optiga_instance_id, optiga_cmd_governor_stats_t * p_stats);
+
+/**
+ * \brief Tells whether the governor holds back the next key command.
+ *
+ * \details
+ * Tells whether the governor holds back the next key command.
+ * - Callers with a choice use it to batch: fewer, larger key commands while it returns TRUE.<br>
+ *
+ * \pre
+ * - None
+ *
+ * \note
+ * - Runs in the PAL critical section.
+ *
+ * \param[in]      optiga_instance_id    OPTIGA instance
+ *
+ * \retval         TRUE                  The next key command would be held back
+ * \retval         FALSE                 It would run at once, or the instance is invalid
+ *
+ */
+bool_t optiga_cmd_governor_pacing(uint8_t optiga_instance_id);
+#endif //OPTIGA_CMD_GOVERNOR
+
+#ifdef OPTIGA_CMD_PROTECTION_POLICY
+#ifndef OPTIGA_COMMS_SHIELDED_CONNECTION
+    #error "OPTIGA_CMD_PROTECTION_POLICY needs OPTIGA_COMMS_SHIELDED_CONNECTION"
+#endif
+/// Command codes of #optiga_cmd_protection_rule_t (APDU command byte without the clear last error bit)
+#define OPTIGA_CMD_POLICY_ANY_COMMAND           (0x00)
+#define OPTIGA_CMD_POLICY_GET_DATA_OBJECT       (0x01)
+#define OPTIGA_CMD_POLICY_SET_DATA_OBJECT       (0x02)
+#define OPTIGA_CMD_POLICY_SET_OBJECT_PROTECTED  (0x03)
+#define OPTIGA_CMD_POLICY_GET_RANDOM            (0x0C)
+#define OPTIGA_CMD_POLICY_ENCRYPT_SYM           (0x14)
+#define OPTIGA_CMD_POLICY_DECRYPT_SYM           (0x15)
+#define OPTIGA_CMD_POLICY_ENCRYPT_ASYM          (0x1E)
+#define OPTIGA_CMD_POLICY_DECRYPT_ASYM          (0x1F)
+#define OPTIGA_CMD_POLICY_CALC_HASH             (0x30)
+#define OPTIGA_CMD_POLICY_CALC_SIGN             (0x31)
+#define OPTIGA_CMD_POLICY_VERIFY_SIGN           (0x32)
+#define OPTIGA_CMD_POLICY_CALC_SSEC             (0x33)
+#define OPTIGA_CMD_POLICY_DERIVE_KEY            (0x34)
+#define OPTIGA_CMD_POLICY_GEN_KEYPAIR           (0x38)
+#define OPTIGA_CMD_POLICY_GEN_SYM_KEY           (0x39)
+
+/** @brief One row of the protection policy: command x OID range -> protection level */
+typedef struct optiga_cmd_protection_rule
+{
+    /// OPTIGA_CMD_POLICY_xxx command code, #OPTIGA_CMD_POLICY_ANY_COMMAND for all
+    uint8_t command;
+    /// OPTIGA_COMMS_NO_PROTECTION, _COMMAND_PROTECTION, _RESPONSE_PROTECTION or _FULL_PROTECTION
+    uint8_t protection_level;
+    /// First OID of the range: data object, key or certificate the command addresses
+    uint16_t oid_first;
+    /// Last OID of the range, 0xFFFF with oid_first 0x0000 for any OID
+    uint16_t oid_last;
+} optiga_cmd_protection_rule_t;
+
+/** @brief Counters of the protection policy, all OPTIGA instances */
+typedef struct optiga_cmd_protection_stats
+{
+    /// APDUs the policy was looked up for
+    uint32_t apdus;
+    /// APDUs sent with command and/or response protection
+    uint32_t protected_apdus;
+    /// APDUs the policy protected more than the caller had asked for
+    uint32_t raised;
+} optiga_cmd_protection_stats_t;
+
+/**
+ * \brief Replaces the protection policy table.
+ *
+ * \details
+ * Replaces the protection policy table.
+ * - Before every APDU the cmd layer looks up the command code and the OID it addresses (data object of read/write,
+ *   key of encrypt/decrypt/sign/shared secret/key generation, secret of derive key, certificate of verify) in the
+ *   table. The first matching row wins; no row means no protection.<br>
+ * - The level found is added to the one the caller set with OPTIGA_UTIL/CRYPT_SET_COMMS_PROTECTION_LEVEL, so the
+ *   policy only raises protection. A caller's #OPTIGA_COMMS_RE_ESTABLISH is kept.<br>
+ * - Commands without an OID (random, hash, encrypt with a host key) match rows with any OID only.<br>
+ * - The built-in table protects key operations and writes and leaves random, hash, verify and reads unprotected.<br>
+ *
+ * \pre
+ * - None
+ *
+ * \note
+ * - The table is not copied and must stay valid. NULL restores the built-in table.
+ *
+ * \param[in]      p_rules               Rows in match order, NULL for the built-in table
+ * \param[in]      count                 Number of rows
+ *
+ */
+void optiga_cmd_set_protection_policy(const optiga_cmd_protection_rule_t * p_rules, uint8_t count);
+
+/**
+ * \brief Reads the counters of the protection policy.
+ *
+ * \param[out]     p_stats               Counters
+ *
+ */
+void optiga_cmd_protection_get_stats(optiga_cmd_protection_stats_t * p_stats);
+#endif //OPTIGA_CMD_PROTECTION_POLICY
+
 
 /**
  * \brief Releases the OPTIGA cmd lock.
@@ -119,6 +323,111 @@ optiga_lib_status_t optiga_cmd_destroy(optiga_cmd_t * me);
  */
 optiga_lib_status_t optiga_cmd_release_lock(const optiga_cmd_t * me);
 
+/**
+ * \brief Sets the scheduling priority of the instance.
+ *
+ * \details
+ * Sets the scheduling priority of the instance.
+ * - Among waiting requests, the one with the highest priority is executed next, earliest arrival first within a class.<br>
+ * - A waiting request gains one class per #OPTIGA_CMD_QUEUE_AGING_TIME_US, so low priority requests are not starved.<br>
+ * - Strict lock sequences (e.g. symmetric encryption start/continue/final) are not preempted.<br>
+ *
+ * \pre
+ * - None
+ *
+ * \note
+ * - Takes effect with the next request of the instance.
+ *
+ * \param[in] me                      Valid instance of #optiga_cmd_t created using #optiga_cmd_create.
+ * \param[in] priority                #OPTIGA_CMD_PRIORITY_LOW, #OPTIGA_CMD_PRIORITY_NORMAL or #OPTIGA_CMD_PRIORITY_HIGH.
+ *                                    Higher values are limited to #OPTIGA_CMD_PRIORITY_HIGH.
+ */
+void optiga_cmd_set_priority(optiga_cmd_t * me, uint8_t priority);
+
+/**
+ * \brief Leases the session of the instance for a sequence of commands.
+ *
+ * \details
+ * Leases the session of the instance for a sequence of commands.
+ * - A session once assigned to the instance (e.g. by a session based key generation or key derivation) stays with it
+ *   until #optiga_cmd_session_end or #optiga_cmd_destroy, so key material in the session OID serves the following
+ *   commands without being derived again.<br>
+ * - With a non zero lease, the session may be reclaimed once the instance has had no request scheduled for lease_ms
+ *   and another instance waits for a session with the pool exhausted. An owner with a pending request is never
+ *   reclaimed.<br>
+ * - A lease of 0 holds the session until it is released (default).<br>
+ *
+ * \pre
+ * - None
+ *
+ * \note
+ * - A session based command of an instance whose session was reclaimed fails as if no session had been assigned;
+ *   #optiga_cmd_session_held tells whether the session is still there.
+ *
+ * \param[in] me                      Valid instance of #optiga_cmd_t created using #optiga_cmd_create.
+ * \param[in] lease_ms                Idle time in milliseconds after which the session may be reclaimed, 0 for none.
+ */
+void optiga_cmd_session_lease(optiga_cmd_t * me, uint32_t lease_ms);
+
+/**
+ * \brief Ends the session of the instance.
+ *
+ * \details
+ * Ends the session of the instance.
+ * - Frees the session OID for other instances and wakes a request waiting for one.<br>
+ *
+ * \pre
+ * - No request of the instance is pending.
+ *
+ * \param[in] me                      Valid instance of #optiga_cmd_t created using #optiga_cmd_create.
+ */
+void optiga_cmd_session_end(optiga_cmd_t * me);
+
+/**
+ * \brief Tells whether the instance holds a session.
+ *
+ * \param[in] me                      Valid instance of #optiga_cmd_t created using #optiga_cmd_create.
+ *
+ * \retval    TRUE                    A session OID is assigned to the instance
+ * \retval    FALSE                   No session, never assigned, ended or reclaimed
+ */
+bool_t optiga_cmd_session_held(const optiga_cmd_t * me);
+
+/**
+ * \brief Returns the number of leased sessions reclaimed after their lease expired.
+ *
+ * \param[in] optiga_instance_id      OPTIGA instance
+ *
+ * \retval    Count                   Zero for an invalid instance
+ */
+uint32_t optiga_cmd_session_reclaims(uint8_t optiga_instance_id);
+
+#ifdef OPTIGA_CMD_RANDOM_COALESCE
+#ifndef OPTIGA_CRYPT_RANDOM_ENABLED
+    #error "OPTIGA_CMD_RANDOM_COALESCE needs OPTIGA_CRYPT_RANDOM_ENABLED"
+#endif
+/// Largest GetRandom the requests waiting in the queue are coalesced into (OPTIGA returns up to 256 bytes)
+#ifndef OPTIGA_CMD_RANDOM_COALESCE_MAX_BYTES
+    #define OPTIGA_CMD_RANDOM_COALESCE_MAX_BYTES    (256U)
+#endif
+
+/**
+ * \brief Returns the number of random requests served by the GetRandom of another instance.
+ *
+ * \details
+ * - With #OPTIGA_CMD_RANDOM_COALESCE defined, a GetRandom for TRNG or DRNG data also takes the random requests of
+ *   the same type that wait in the queue, up to #OPTIGA_CMD_RANDOM_COALESCE_MAX_BYTES in total, and splits the
+ *   response among them. Their callbacks run right before the one of the issuing instance. If the GetRandom fails,
+ *   they go back into the queue and are issued on their own.<br>
+ * - Requests that store the random in a session (pre-master secret, authorization code) are never coalesced.<br>
+ *
+ * \param[in] optiga_instance_id      OPTIGA instance
+ *
+ * \retval    Count                   Zero for an invalid instance
+ */
+uint32_t optiga_cmd_random_coalesced(uint8_t optiga_instance_id);
+#endif //OPTIGA_CMD_RANDOM_COALESCE
+
 
 /**
  * \brief Opens the OPTIGA Application
@@ -623,6 +932,40 @@ optiga_lib_status_t optiga_cmd_encrypt_sym(optiga_cmd_t * me,
                                            optiga_encrypt_sym_params_t * params);
 #endif
 
+#if defined (OPTIGA_CRYPT_RANDOM_ENABLED) && defined (OPTIGA_CRYPT_SYM_ENCRYPT_ENABLED)
+/**
+ * \brief Generates an IV and encrypts data with it in one request.
+ *
+ * \details
+ * Issues a GetRandom command and the Encrypt Sym command using its output as IV, back to back.
+ * - Acquires the strict sequence once, so no other request is scheduled between the two commands.
+ * - Forms the GetRandom command for iv_length bytes and copies the response to random_iv.
+ * - Forms the Encrypt Sym command with that IV and continues as #optiga_cmd_encrypt_sym (start and final).
+ * - Releases the strict sequence in case of an error or after the Encrypt Sym command is completed.
+ *
+ * \pre
+ * - Application on OPTIGA must be opened using #optiga_cmd_open_application before using this API.
+ *
+ * \note
+ * - Error codes from lower layers will be returned as it is.
+ * - A failed GetRandom ends the request without issuing the Encrypt Sym command.
+ *
+ *\param[in]  me                                      Valid instance of #optiga_cmd_t created using #optiga_cmd_create.
+ *\param[in]  cmd_param                               Param of Encrypt Sym Command APDU.
+ *                                                    - Must be valid argument, otherwise OPTIGA returns an error.
+ *\param[in]  params                                  InData of both commands, must not be NULL.
+ *
+ * \retval    #OPTIGA_LIB_SUCCESS                     Successful invocation.
+ * \retval    #OPTIGA_CMD_ERROR                       Error occurred before invoking GetRandom command.<br>
+ *                                                    Error in the asynchronous state machine.
+ * \retval    #OPTIGA_CMD_ERROR_MEMORY_INSUFFICIENT   Error due to insufficient buffer size.
+ *                                                    - Length of the buffer to copy the encrypted data is less than buffer to copy it into.
+ */
+optiga_lib_status_t optiga_cmd_random_encrypt_sym(optiga_cmd_t * me,
+                                                  uint8_t cmd_param,
+                                                  optiga_random_encrypt_sym_params_t * params);
+#endif
+
 #if defined (OPTIGA_CRYPT_SYM_DECRYPT_ENABLED) || defined (OPTIGA_CRYPT_HMAC_VERIFY_ENABLED) ||\
     defined (OPTIGA_CRYPT_CLEAR_AUTO_STATE_ENABLED)
 /**
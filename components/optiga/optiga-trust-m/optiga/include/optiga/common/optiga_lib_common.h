@@ -620,6 +620,20 @@ typedef struct optiga_symmetric_enc_dec_params
     uint8_t operation_mode;
 } optiga_encrypt_sym_params_t,optiga_decrypt_sym_params_t;
 #endif
+#if defined (OPTIGA_CRYPT_RANDOM_ENABLED) && defined (OPTIGA_CRYPT_SYM_ENCRYPT_ENABLED)
+/**
+ * \brief Specifies the data structure for a GetRandom whose output is the IV of the following EncryptSym
+ */
+typedef struct optiga_random_encrypt_sym_params
+{
+    /// EncryptSym parameters, iv refers to random_iv
+    optiga_encrypt_sym_params_t encrypt;
+    /// User buffer receiving the IV, iv_length bytes
+    uint8_t * random_iv;
+    /// Param of the GetRandom command (TRNG or DRNG)
+    uint8_t rng_type;
+} optiga_random_encrypt_sym_params_t;
+#endif
 #ifdef OPTIGA_CRYPT_SYM_GENERATE_KEY_ENABLED
 /**
  * \brief Specifies the data structure for symmetric generate key 
@@ -714,6 +728,98 @@ void optiga_common_set_uint32(uint8_t* p_output_buffer,
 void optiga_common_get_uint16(const uint8_t * p_input_buffer,
                               uint16_t* p_two_byte_value);
 
+/** @brief Fixed size block pool, backs the optiga cmd, crypt and util instances */
+typedef struct optiga_lib_pool
+{
+    /// Storage of block_count blocks of block_size bytes
+    uint8_t * p_blocks;
+    /// Size of one block
+    uint16_t block_size;
+    /// Number of blocks, at most 32
+    uint8_t block_count;
+    /// Blocks currently allocated
+    uint8_t blocks_in_use;
+    /// Highest blocks_in_use since start-up
+    uint8_t peak_in_use;
+    /// Bit n set if block n is allocated
+    uint32_t used_mask;
+} optiga_lib_pool_t;
+
+/** @brief Occupancy of an instance pool */
+typedef struct optiga_lib_pool_stats
+{
+    /// Number of instances the pool can hold
+    uint8_t capacity;
+    /// Instances currently created
+    uint8_t in_use;
+    /// Highest number of instances created at the same time
+    uint8_t peak_in_use;
+    /// Size of one instance, the pool takes capacity times this in static RAM
+    uint16_t block_size;
+} optiga_lib_pool_stats_t;
+
+/** @brief Defines a static pool of count blocks of type */
+#define OPTIGA_LIB_POOL_DEFINE(pool_name, type, count) \
+    static type pool_name##_blocks[count]; \
+    static optiga_lib_pool_t pool_name = {(uint8_t *)pool_name##_blocks, (uint16_t)sizeof(type), (uint8_t)(count), 0, 0, 0}
+
+/**
+ * \brief Allocates a zeroed block from a pool
+ *
+ * \details
+ * Allocates a zeroed block from a pool
+ * - Takes the lowest free block, without touching the heap.<br>
+ *
+ * \pre
+ * - Pool defined with #OPTIGA_LIB_POOL_DEFINE
+ *
+ * \note
+ * - Runs in the PAL critical section.
+ *
+ * \param[in,out]  p_pool          Pool to allocate from
+ *
+ * \retval         Pointer to the block, NULL if all blocks are in use
+ *
+ */
+void * optiga_lib_pool_alloc(optiga_lib_pool_t * p_pool);
+
+/**
+ * \brief Returns a block to its pool
+ *
+ * \details
+ * Returns a block to its pool
+ * - Pointers not allocated from the pool are ignored.<br>
+ *
+ * \pre
+ * - None
+ *
+ * \note
+ * - Runs in the PAL critical section.
+ *
+ * \param[in,out]  p_pool          Pool the block was allocated from
+ * \param[in]      p_block         Block returned by #optiga_lib_pool_alloc
+ *
+ */
+void optiga_lib_pool_free(optiga_lib_pool_t * p_pool, const void * p_block);
+
+/**
+ * \brief Reads the occupancy of a pool
+ *
+ * \details
+ * Reads the occupancy of a pool
+ *
+ * \pre
+ * - None
+ *
+ * \note
+ * - None
+ *
+ * \param[in]      p_pool          Pool to read
+ * \param[out]     p_stats         Capacity, blocks in use and peak
+ *
+ */
+void optiga_lib_pool_get_stats(const optiga_lib_pool_t * p_pool, optiga_lib_pool_stats_t * p_stats);
+
 #ifdef __cplusplus
 }
 #endif
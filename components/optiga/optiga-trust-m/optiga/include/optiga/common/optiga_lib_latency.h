@@ -0,0 +1,166 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2020 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file    optiga_lib_latency.h
+*
+* \brief   This file provides the per command latency histograms of the command layer.
+*
+* \details With OPTIGA_LIB_ENABLE_LATENCY_HISTOGRAM every APDU the command layer sends adds three
+*          times to the histograms of its command code (first APDU byte): the queue wait of the
+*          request, the optiga_comms_transceive time and the OPTIGA execution time measured by the
+*          physical layer. Buckets are powers of two in microseconds of the PAL timer. Unlike the
+*          trace ring, nothing is overwritten, so the counts cover every command since the last clear.
+*          Failed APDUs (status 0xFF) go to a separate entry of their command code, with the transceive
+*          time running until the command layer knows the outcome, the last error code read included.
+*
+* \ingroup grOptigaLibCommon
+*
+* @{
+*/
+
+#ifndef _OPTIGA_LIB_LATENCY_H_
+#define _OPTIGA_LIB_LATENCY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "optiga/common/optiga_lib_types.h"
+
+/** @brief Distinct command codes tracked, a code that also failed takes a second entry; further
+ *         codes are counted in #optiga_lib_latency_get_dropped */
+#ifndef OPTIGA_LIB_LATENCY_COMMANDS
+    #define OPTIGA_LIB_LATENCY_COMMANDS             (12U)
+#endif
+
+/** @brief Buckets per histogram: bucket 0 holds 0..1 us, bucket n holds 2^n..2^(n+1)-1 us, the last one the rest */
+#define OPTIGA_LIB_LATENCY_BUCKETS                  (21U)
+
+/** @brief Request issued until the command layer starts preparing the APDU (execution queue, session, lock) */
+#define OPTIGA_LIB_LATENCY_QUEUE                    (0U)
+/** @brief APDU handed to comms until the response is delivered, including bus and execution time */
+#define OPTIGA_LIB_LATENCY_TRANSCEIVE               (1U)
+/** @brief Last command fragment written until the response is ready, measured by the physical layer */
+#define OPTIGA_LIB_LATENCY_EXEC                     (2U)
+/** @brief Number of measured intervals */
+#define OPTIGA_LIB_LATENCY_METRICS                  (3U)
+
+/** @brief Histogram of one interval of one command code */
+typedef struct optiga_lib_latency_histogram
+{
+    /// Number of samples
+    uint32_t count;
+    /// Largest sample in microseconds
+    uint32_t max_us;
+    /// Sum of the samples in microseconds
+    uint64_t sum_us;
+    /// Samples per bucket
+    uint32_t buckets[OPTIGA_LIB_LATENCY_BUCKETS];
+} optiga_lib_latency_histogram_t;
+
+/** @brief Histograms of one command code */
+typedef struct optiga_lib_latency_command
+{
+    /// APDU command code, e.g. 0x94 EncryptSym, 0x8C GetRandom
+    uint8_t command_code;
+    /// TRUE for the APDUs of this code that OPTIGA answered with a failure
+    uint8_t failed;
+    /// Histograms indexed by OPTIGA_LIB_LATENCY_QUEUE, _TRANSCEIVE and _EXEC
+    optiga_lib_latency_histogram_t metric[OPTIGA_LIB_LATENCY_METRICS];
+} optiga_lib_latency_command_t;
+
+#ifdef OPTIGA_LIB_ENABLE_LATENCY_HISTOGRAM
+
+/**
+ * \brief Adds the times of one APDU to the histograms of its command code.
+ *
+ * \param[in] command_code     APDU command code
+ * \param[in] queue_us         Queue wait, 0 for the further APDUs of a chained request
+ * \param[in] transceive_us    optiga_comms_transceive time, for a failed APDU up to its error code
+ * \param[in] exec_us          OPTIGA execution time, 0 if the comms layer did not measure it
+ * \param[in] failed           TRUE if OPTIGA answered with a failure
+ */
+void optiga_lib_latency_record(uint8_t command_code, uint32_t queue_us, uint32_t transceive_us, uint32_t exec_us,
+                               uint8_t failed);
+
+/**
+ * \brief Copies the histograms of the command codes seen since the last clear, in order of first use,
+ *        successful and failed APDUs of a code as separate entries.
+ *
+ * \param[out] p_commands      Array of max_commands entries
+ * \param[in]  max_commands    Entries in p_commands
+ *
+ * \retval     Number of entries filled
+ */
+uint8_t optiga_lib_latency_get(optiga_lib_latency_command_t * p_commands, uint8_t max_commands);
+
+/**
+ * \brief Gives the upper bound of the bucket that holds the given percentile.
+ *
+ * \param[in] p_histogram      Histogram
+ * \param[in] percent          Percentile, 1 to 100
+ *
+ * \retval    Microseconds, the max sample for the last bucket, 0 for an empty histogram
+ */
+uint32_t optiga_lib_latency_percentile(const optiga_lib_latency_histogram_t * p_histogram, uint8_t percent);
+
+/**
+ * \brief Number of APDUs not recorded because all #OPTIGA_LIB_LATENCY_COMMANDS entries were taken.
+ */
+uint32_t optiga_lib_latency_get_dropped(void);
+
+/**
+ * \brief Prints count, mean, p50, p90, p99 and max of each interval, one line per command code and
+ *        outcome, failed APDUs marked "fail".
+ */
+void optiga_lib_latency_dump(void);
+
+/**
+ * \brief Empties all histograms.
+ */
+void optiga_lib_latency_clear(void);
+
+/** @brief Record point, removed at compile time unless OPTIGA_LIB_ENABLE_LATENCY_HISTOGRAM is defined */
+#define OPTIGA_LIB_LATENCY(command_code, queue_us, transceive_us, exec_us, failed) \
+    optiga_lib_latency_record((command_code), (queue_us), (transceive_us), (exec_us), (failed))
+
+#else
+
+#define OPTIGA_LIB_LATENCY(command_code, queue_us, transceive_us, exec_us, failed)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*_OPTIGA_LIB_LATENCY_H_ */
+
+/**
+* @}
+*/
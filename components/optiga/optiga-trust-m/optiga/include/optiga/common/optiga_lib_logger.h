@@ -230,6 +230,121 @@ void optiga_lib_print_array_hex_format(const uint8_t * p_log_string,
             OPTIGA_LIB_LOGGER_COLOR_DEFAULT); \
 }
 
+/*
+ * Binary logging (OPTIGA_LIB_LOGGER_BINARY)
+ *
+ * The print functions above append a compact record (time stamp, record type, layer id and the
+ * raw bytes: message text, status word or data array) to a RAM ring instead of formatting text
+ * and writing it synchronously. The text is produced later, by optiga_lib_logger_process() in a
+ * low-priority task or by tools/optiga_log_decode.py from a file written by
+ * optiga_lib_logger_save(). When the ring is full the oldest records are dropped, so the ring
+ * always holds the latest activity. All fields are little endian, as written by the ESP32.
+ */
+
+/// First word of a binary log file ("OLOG")
+#define OPTIGA_LIB_LOGGER_MAGIC                      (0x474F4C4FUL)
+/// Version of the binary log file format
+#define OPTIGA_LIB_LOGGER_VERSION                    (1U)
+
+/// optiga_lib_print_string, data: the text
+#define OPTIGA_LIB_LOGGER_RECORD_STRING              (0x01)
+/// optiga_lib_print_string_with_newline, data: the text
+#define OPTIGA_LIB_LOGGER_RECORD_LINE                (0x02)
+/// optiga_lib_print_message, data: the text
+#define OPTIGA_LIB_LOGGER_RECORD_MESSAGE             (0x03)
+/// optiga_lib_print_status, data: the return value (2 bytes, big endian)
+#define OPTIGA_LIB_LOGGER_RECORD_STATUS              (0x04)
+/// optiga_lib_print_array_hex_format, data: the array
+#define OPTIGA_LIB_LOGGER_RECORD_ARRAY               (0x05)
+/// Record type bits of #optiga_lib_logger_record_t::type
+#define OPTIGA_LIB_LOGGER_RECORD_MASK                (0x7F)
+/// Type flag: the data was cut to OPTIGA_LIB_LOGGER_BINARY_MAX_DATA bytes
+#define OPTIGA_LIB_LOGGER_RECORD_TRUNCATED           (0x80)
+
+/// Layer ids, low nibble of #optiga_lib_logger_record_t::attributes, in the order of the layer strings
+#define OPTIGA_LIB_LOGGER_LAYER_NONE                 (0x00)
+#define OPTIGA_LIB_LOGGER_LAYER_UTIL                 (0x01)
+#define OPTIGA_LIB_LOGGER_LAYER_CRYPT                (0x02)
+#define OPTIGA_LIB_LOGGER_LAYER_CMD                  (0x03)
+#define OPTIGA_LIB_LOGGER_LAYER_COMMS                (0x04)
+/// Any other layer string (examples, shell): the data starts with the layer string and a NUL
+#define OPTIGA_LIB_LOGGER_LAYER_OTHER                (0x0F)
+/// Layer id bits of #optiga_lib_logger_record_t::attributes
+#define OPTIGA_LIB_LOGGER_LAYER_MASK                 (0x0F)
+/// Color of the record, high nibble of #optiga_lib_logger_record_t::attributes: 0 is
+/// #OPTIGA_LIB_LOGGER_COLOR_DEFAULT, 1 to 13 are RED to LIGHT_CYAN in the order of the colors above
+#define OPTIGA_LIB_LOGGER_COLOR_SHIFT                (4)
+
+/** @brief Header of a binary log file */
+typedef struct optiga_lib_logger_file
+{
+    /// #OPTIGA_LIB_LOGGER_MAGIC
+    uint32_t magic;
+    /// #OPTIGA_LIB_LOGGER_VERSION
+    uint16_t version;
+    /// sizeof(optiga_lib_logger_record_t), records follow this header
+    uint16_t record_header_size;
+    /// Records in the file
+    uint32_t records;
+    /// Records lost since the previous save or process: overwritten, or made while saving
+    uint32_t dropped;
+    /// Bytes of records after this header
+    uint32_t bytes;
+} optiga_lib_logger_file_t;
+
+/** @brief Header of one record, followed by length data bytes */
+typedef struct optiga_lib_logger_record
+{
+    /// pal_os_timer time of the print call [us]
+    uint32_t time_us;
+    /// Data bytes after this header
+    uint16_t length;
+    /// OPTIGA_LIB_LOGGER_RECORD_* type, with #OPTIGA_LIB_LOGGER_RECORD_TRUNCATED
+    uint8_t type;
+    /// OPTIGA_LIB_LOGGER_LAYER_* id and color index
+    uint8_t attributes;
+} optiga_lib_logger_record_t;
+
+/**
+ * \brief Sink for optiga_lib_logger_save(), e.g. a file write.
+ *
+ * \retval  0 on success, anything else stops the save
+ */
+typedef int32_t (*optiga_lib_logger_write_t)(void * p_context, const uint8_t * p_data, uint32_t length);
+
+#ifdef OPTIGA_LIB_LOGGER_BINARY
+
+/**
+ * \brief Formats up to max_records of the oldest records as text on the logger console.
+ *
+ * \details The ring lock is held only to take each record out, so a slow console never blocks the
+ *          layers that log. Call it from a low-priority task.
+ *
+ * \param[in] max_records     Records to format at most
+ *
+ * \retval  Records formatted, 0 if the ring is empty
+ */
+uint32_t optiga_lib_logger_process(uint32_t max_records);
+
+/**
+ * \brief Writes the ring as a binary log file to the sink, oldest record first, then empties it.
+ *
+ * \details Print calls made while the save runs are not recorded; they count as dropped.
+ *
+ * \param[in] writer      Sink of the file bytes
+ * \param[in] p_context   Passed to the sink
+ *
+ * \retval  0 on success, -1 if the sink failed (the records are kept)
+ */
+int32_t optiga_lib_logger_save(optiga_lib_logger_write_t writer, void * p_context);
+
+/**
+ * \brief Gives the file header a save would write now.
+ */
+void optiga_lib_logger_get_info(optiga_lib_logger_file_t * p_info);
+
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,164 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2020 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file    optiga_lib_trace.h
+*
+* \brief   This file provides the latency trace points of the command layer and the IFX I2C stack.
+*
+* \ingroup grOptigaLibCommon
+*
+* @{
+*/
+
+#ifndef _OPTIGA_LIB_TRACE_H_
+#define _OPTIGA_LIB_TRACE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "optiga/common/optiga_lib_types.h"
+#include "optiga/pal/pal_sysview.h"
+
+/** @brief Number of events kept in the trace ring, the oldest are overwritten */
+#ifndef OPTIGA_LIB_TRACE_DEPTH
+    #define OPTIGA_LIB_TRACE_DEPTH                  (512U)
+#endif
+
+// Trace events, the argument recorded with each is given in brackets
+/** @brief Command layer: APDU preparation starts */
+#define OPTIGA_LIB_TRACE_CMD_PREPARE                (0x01)
+/** @brief Command layer: APDU handed to comms (command code) */
+#define OPTIGA_LIB_TRACE_CMD_SEND                   (0x02)
+/** @brief Command layer: response delivered by comms (response length) */
+#define OPTIGA_LIB_TRACE_CMD_RESPONSE               (0x03)
+/** @brief Command layer: caller notified (return status) */
+#define OPTIGA_LIB_TRACE_CMD_DONE                   (0x04)
+/** @brief Presentation layer: encryption of an outgoing message starts (length) */
+#define OPTIGA_LIB_TRACE_PRL_PROTECT_START          (0x10)
+/** @brief Presentation layer: encryption done (length) */
+#define OPTIGA_LIB_TRACE_PRL_PROTECT_END            (0x11)
+/** @brief Presentation layer: decryption of an incoming message starts (length) */
+#define OPTIGA_LIB_TRACE_PRL_UNPROTECT_START        (0x12)
+/** @brief Presentation layer: decryption done (length) */
+#define OPTIGA_LIB_TRACE_PRL_UNPROTECT_END          (0x13)
+/** @brief Transport layer: fragment passed to the data link layer (length) */
+#define OPTIGA_LIB_TRACE_TL_TX_FRAGMENT             (0x20)
+/** @brief Transport layer: fragment received from the data link layer (length) */
+#define OPTIGA_LIB_TRACE_TL_RX_FRAGMENT             (0x21)
+/** @brief Data link layer: frame with CRC handed to the physical layer (length, 0 for control frames) */
+#define OPTIGA_LIB_TRACE_DL_TX_FRAME                (0x30)
+/** @brief Data link layer: frame received (length) */
+#define OPTIGA_LIB_TRACE_DL_RX_FRAME                (0x31)
+/** @brief Data link layer: frame retransmitted (retransmit counter) */
+#define OPTIGA_LIB_TRACE_DL_RESEND                  (0x32)
+/** @brief Data link layer: re-sync sent (0) */
+#define OPTIGA_LIB_TRACE_DL_RESYNC                  (0x33)
+/** @brief Physical layer: frame written to the DATA register starts (length) */
+#define OPTIGA_LIB_TRACE_PL_XFER_START              (0x40)
+/** @brief Physical layer: DATA register write or read done (length) */
+#define OPTIGA_LIB_TRACE_PL_XFER_END                (0x41)
+/** @brief Physical layer: last fragment of the command written, OPTIGA executes (command slot) */
+#define OPTIGA_LIB_TRACE_PL_EXEC_START              (0x42)
+/** @brief Physical layer: status register polled again later (interval in microseconds) */
+#define OPTIGA_LIB_TRACE_PL_POLL                    (0x43)
+/** @brief Physical layer: response ready in the DATA register, read starts (length) */
+#define OPTIGA_LIB_TRACE_PL_READY                   (0x44)
+
+/** @brief One recorded trace event */
+typedef struct optiga_lib_trace_event
+{
+    /// Time stamp in microseconds
+    uint32_t time_us;
+    /// Event specific argument
+    uint32_t arg;
+    /// Event id, OPTIGA_LIB_TRACE_*
+    uint8_t event;
+} optiga_lib_trace_event_t;
+
+#ifdef OPTIGA_LIB_ENABLE_TRACE
+
+/**
+ * \brief Records a trace event with the current time in the trace ring.
+ *
+ * \details
+ * Lock free and safe to call from any task, an event recorded while #optiga_lib_trace_dump runs is dropped.
+ *
+ * \param[in] event        Event id, OPTIGA_LIB_TRACE_*
+ * \param[in] arg          Event specific argument
+ */
+void optiga_lib_trace_record(uint8_t event, uint32_t arg);
+
+/**
+ * \brief Prints one latency breakdown line per APDU for the commands still in the trace ring.
+ *
+ * \details
+ * Columns of a line (microseconds):
+ * - total : APDU preparation start to caller notification
+ * - prep  : APDU preparation in the command layer
+ * - prl   : presentation layer encryption and decryption
+ * - bus   : DATA register writes and reads on I2C
+ * - exec  : last fragment written to response ready, i.e. OPTIGA execution incl. status polls
+ * - stack : rest of the comms time (TL/DL processing, CRC, ACK frames, scheduling)
+ * - post  : response processing in the command layer
+ */
+void optiga_lib_trace_dump(void);
+
+/**
+ * \brief Drops all recorded events.
+ */
+void optiga_lib_trace_clear(void);
+
+#endif
+
+#if defined (OPTIGA_LIB_ENABLE_TRACE) && defined (PAL_SYSVIEW_ENABLED)
+/** @brief Trace point, also shown as a SystemView marker (see optiga/pal/pal_sysview.h) */
+#define OPTIGA_LIB_TRACE(event, arg) \
+    do { \
+        optiga_lib_trace_record((event), (uint32_t)(arg)); \
+        pal_sysview_trace((event), (uint32_t)(arg)); \
+    } while (0)
+#elif defined (OPTIGA_LIB_ENABLE_TRACE)
+/** @brief Trace point, removed at compile time unless OPTIGA_LIB_ENABLE_TRACE is defined */
+#define OPTIGA_LIB_TRACE(event, arg)    optiga_lib_trace_record((event), (uint32_t)(arg))
+#elif defined (PAL_SYSVIEW_ENABLED)
+/** @brief Trace point, a SystemView marker only */
+#define OPTIGA_LIB_TRACE(event, arg)    pal_sysview_trace((event), (uint32_t)(arg))
+#else
+#define OPTIGA_LIB_TRACE(event, arg)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*_OPTIGA_LIB_TRACE_H_ */
+
+/**
+* @}
+*/
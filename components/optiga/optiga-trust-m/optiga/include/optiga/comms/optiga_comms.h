@@ -84,15 +84,20 @@ typedef struct optiga_comms
 
 /** @brief optiga communication structure */
 extern optiga_comms_t optiga_comms;
+#if (OPTIGA_MAX_INSTANCES > 1)
+/** @brief optiga communication structure of the second OPTIGA */
+extern optiga_comms_t optiga_comms_1;
+#endif
 
 /**
- * \brief Provides the singleton OPTIGA instance.
+ * \brief Provides the OPTIGA comms instance of an OPTIGA device.
  *
  * \details
  * Creates an instance of #optiga_comms_t.
  * - Stores the callers context and callback handler.
  * - Allocate memory for #optiga_comms_t.
  * - Assigns OPTIGA structure based on the Optiga instance.
+ * - Each OPTIGA instance has its own comms instance and IFX I2C context.
  *
  * \pre
  * - None
@@ -100,13 +105,15 @@ extern optiga_comms_t optiga_comms;
  * \note
  * - None
  *
+ * \param[in] optiga_instance_id  Index of the OPTIGA device, less than #OPTIGA_MAX_INSTANCES
  * \param[in] callback            Pointer to callback function, must not be NULL
  * \param[in] context             Pointer to upper layer context.
  *
  * \retval    #optiga_comms_t *   On successful instance creation
- * \retval    NULL                Memory allocation failure
+ * \retval    NULL                Memory allocation failure or invalid optiga_instance_id
  */
-optiga_comms_t * optiga_comms_create(callback_handler_t callback,
+optiga_comms_t * optiga_comms_create(uint8_t optiga_instance_id,
+                                     callback_handler_t callback,
                                      void * context);
 
 /**
@@ -304,6 +311,26 @@ LIBRARY_EXPORTS optiga_lib_status_t optiga_comms_transceive(optiga_comms_t * p_c
                                                             uint8_t * p_rx_data,
                                                             uint16_t * p_rx_data_len);
 
+/**
+ * \brief Gives the OPTIGA execution time of the last transceive.
+ *
+ * \details
+ * Gives the OPTIGA execution time of the last transceive
+ * - Time from writing the last command fragment to the response being ready, as seen by the physical layer.<br>
+ * - Includes the status polling granularity.<br>
+ *
+ * \pre
+ * - None
+ *
+ * \note
+ * - Valid once the transceive completed, until the next one starts.
+ *
+ * \param[in] p_ctx                     Valid instance of #optiga_comms_t created using #optiga_comms_create
+ *
+ * \retval    Microseconds, 0 if the command did not reach execution
+ */
+uint32_t optiga_comms_get_exec_time(const optiga_comms_t * p_ctx);
+
 /**
  * \brief Closes the communication channel with OPTIGA.
  *
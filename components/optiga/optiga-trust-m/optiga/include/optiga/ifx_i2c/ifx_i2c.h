@@ -229,6 +229,32 @@ optiga_lib_status_t ifx_i2c_transceive(ifx_i2c_context_t * p_ctx,
  */
 optiga_lib_status_t ifx_i2c_close(ifx_i2c_context_t * p_ctx);
 
+/**
+ * \brief   Copies the link quality counters of a given context.
+ *
+ * \details
+ * Counts NACKs, CRC errors, retransmits, re-syncs, response polling overruns and chaining errors of
+ * all layers, plus a histogram of retries per transfer for each command code. The counters survive
+ * #ifx_i2c_open and #ifx_i2c_close.
+ *
+ * \pre
+ * - None
+ *
+ * \param[in]     p_ctx                Pointer to #ifx_i2c_context_t, must not be NULL
+ * \param[out]    p_stats              Pointer to #ifx_i2c_stats_t, must not be NULL
+ */
+void ifx_i2c_get_stats(const ifx_i2c_context_t * p_ctx, ifx_i2c_stats_t * p_stats);
+
+/**
+ * \brief   Resets the link quality counters of a given context to zero.
+ *
+ * \pre
+ * - None
+ *
+ * \param[in,out] p_ctx                Pointer to #ifx_i2c_context_t, must not be NULL
+ */
+void ifx_i2c_clear_stats(ifx_i2c_context_t * p_ctx);
+
 /**
  * \brief   Sets the slave address of the target device.
  *
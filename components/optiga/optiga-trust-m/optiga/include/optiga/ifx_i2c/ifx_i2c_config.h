@@ -60,12 +60,18 @@ extern "C" {
 #define PL_POLLING_INVERVAL_US      (1000U)
 /** @brief Physical layer: maximal attempts */
 #define PL_POLLING_MAX_CNT          (200U)
-/** @brief Physical Layer: data register polling interval in microseconds */
+/** @brief Physical Layer: data register polling interval in microseconds.
+*          Upper bound of the adaptive response polling interval */
 #define PL_DATA_POLLING_INVERVAL_US (5000U)
+/** @brief Physical Layer: first response poll interval in microseconds once the expected time has passed */
+#define PL_DATA_POLLING_MIN_US      (250U)
+/** @brief Physical Layer: slots of the learned command execution time table (indexed by command code) */
+#define PL_EXEC_TIME_SLOTS          (128U)
 /** @brief Physical Layer: guard time interval in microseconds */
 #define PL_GUARD_TIME_INTERVAL_US   (50U)
 
 /** @brief Data link layer: frame size (max supported is 277 in OPTIGA ).
+*          - The physical layer requests this length at open and uses what the slave accepts.<br>
 *          - Note: This can be configured externally to a lesser value due to platform restrictions.<br>
 *            Externally means through command line argument or project configuration or optiga_lib_config.h*/
 #ifdef IFX_I2C_FRAME_SIZE
@@ -77,6 +83,12 @@ extern "C" {
     #define IFX_I2C_FRAME_SIZE          (277U)
 #endif
 
+/** @brief Physical layer: I2C frequency in KHz negotiated with the slave at open.
+ *         Above 400 KHz the slave is switched to Fm+ mode (up to 1000 KHz) */
+#ifndef IFX_I2C_FREQUENCY_KHZ
+    #define IFX_I2C_FREQUENCY_KHZ       (400U)
+#endif
+
 /** @brief Transport Layer: header size */
 #define TL_HEADER_SIZE              (1U)
 /** @brief Data link layer: header size */
@@ -86,12 +98,48 @@ extern "C" {
 /** @brief Data link layer: Trans timeout in milliseconds*/
 #define PL_TRANS_TIMEOUT_MS         (10U)
 
+/** @brief Data link layer: frame CRC computed bit by bit (reference implementation) */
+#define DL_CRC_BACKEND_BITWISE      (0U)
+/** @brief Data link layer: frame CRC computed with a 256 entry lookup table (512 bytes of flash) */
+#define DL_CRC_BACKEND_TABLE        (1U)
+/** @brief Data link layer: frame CRC computed by the ESP32 ROM routine (esp_rom_crc16_le) */
+#define DL_CRC_BACKEND_ESP32_ROM    (2U)
+/** @brief Data link layer: selected frame CRC implementation */
+#ifndef DL_CRC_BACKEND
+    #define DL_CRC_BACKEND          DL_CRC_BACKEND_TABLE
+#endif
+
 /** @brief Transport layer: Maximum exit timeout in seconds */
 #define TL_MAX_EXIT_TIMEOUT         (180U)
 
-/** @brief Reset low time for GPIO pin toggling */
+/** @brief Data link layer: time in milliseconds a transfer may spend retransmitting and re-synchronizing
+ *         frames after its first error. The transfer then fails and the next open is a reset
+ *         (see #IFX_I2C_RECOVERY_SOFT_RESET) instead of retrying until #TL_MAX_EXIT_TIMEOUT */
+#ifndef DL_RECOVERY_TIMEOUT_MS
+    #define DL_RECOVERY_TIMEOUT_MS  (250U)
+#endif
+
+/** @brief Recovery ladder: data link layer retransmit and re-sync within #DL_RECOVERY_TIMEOUT_MS */
+#define IFX_I2C_RECOVERY_DL_RESYNC  (0U)
+/** @brief Recovery ladder: soft reset through the IFX I2C soft reset register */
+#define IFX_I2C_RECOVERY_SOFT_RESET (1U)
+/** @brief Recovery ladder: warm reset, reset pin toggled. Skipped without a reset pin */
+#define IFX_I2C_RECOVERY_WARM_RESET (2U)
+/** @brief Recovery ladder: cold reset, VDD and reset pin toggled. Skipped without a VDD pin */
+#define IFX_I2C_RECOVERY_COLD_RESET (3U)
+/** @brief Recovery ladder: number of steps */
+#define IFX_I2C_RECOVERY_STEPS      (4U)
+
+/** @brief Link statistics: commands with their own retry histogram, further commands share the last entry */
+#ifndef IFX_I2C_STATS_COMMANDS
+    #define IFX_I2C_STATS_COMMANDS  (16U)
+#endif
+/** @brief Link statistics: retry histogram buckets, transfers with 0, 1, 2 and 3 or more retries */
+#define IFX_I2C_STATS_RETRY_BUCKETS (4U)
+
+/** @brief Reset low time for GPIO pin toggling, in microseconds despite the name (2 ms) */
 #define RESET_LOW_TIME_MSEC         (2000U)
-/** @brief Start up time */
+/** @brief Start up time, in microseconds despite the name (12 ms) */
 #define STARTUP_TIME_MSEC           (12000U)
 
 /** @brief Protocol Stack: Status codes for success */
@@ -109,8 +157,12 @@ extern "C" {
 /** @brief Protocol Stack: session error */
 #define IFX_I2C_SESSION_ERROR       (0x0108)
 
+/** @brief Headroom in front of a frame for the DATA register address, lets the physical layer write frames in place */
+#define IFX_I2C_PL_HEADER_SIZE      (1U)
+/** @brief Physical layer: register access buffer, register address and the longest register content (4 bytes) */
+#define IFX_I2C_PL_REG_BUFFER_SIZE  (5U)
 /** @brief Offset of Datalink header in tx_frame_buffer */
-#define IFX_I2C_DL_HEADER_OFFSET    (0U)
+#define IFX_I2C_DL_HEADER_OFFSET    (IFX_I2C_PL_HEADER_SIZE)
 /** @brief Offset of Transport header in tx_frame_buffer */
 #define IFX_I2C_TL_HEADER_OFFSET    (IFX_I2C_DL_HEADER_OFFSET + 3)
 /** @brief Protocol Stack debug switch for physical layer (set to 0 or 1) */
@@ -193,12 +245,16 @@ typedef struct ifx_i2c_pl
 {
     // Physical Layer low level interface variables
 
-    /// Physical layer buffer
-    uint8_t buffer[IFX_I2C_FRAME_SIZE + 1];
+    /// Physical layer buffer for register accesses. Frames are read and written in the context frame buffers
+    uint8_t buffer[IFX_I2C_PL_REG_BUFFER_SIZE];
     /// Tx length
     uint16_t buffer_tx_len;
+    /// Bytes of the current write: buffer for register writes, the frame in place for DATA writes
+    uint8_t * p_buffer_tx;
     /// Rx length
     uint16_t buffer_rx_len;
+    /// Destination of the current read: buffer for registers, the rx frame buffer for DATA reads
+    uint8_t * p_buffer_rx;
     /// Action on register, read/write
     uint8_t  register_action;
     /// i2c read/i2c write
@@ -225,6 +281,21 @@ typedef struct ifx_i2c_pl
     uint8_t   negotiate_state;
     /// Soft reset requested
     uint8_t   request_soft_reset;
+
+    // Physical Layer adaptive response polling variables
+
+    /// Learned last fragment written to response ready time per command code in microseconds (0 = not seen yet)
+    uint32_t  exec_time_us[PL_EXEC_TIME_SLOTS];
+    /// Time stamp of the last command fragment sent in microseconds
+    uint32_t  exec_start_us;
+    /// Last fragment written to response ready time of the running command in microseconds (0 = not measured)
+    uint32_t  exec_last_us;
+    /// Next response poll interval in microseconds, 0 before the first poll of a command
+    uint32_t  poll_interval_us;
+    /// Table slot of the running command, #PL_EXEC_TIME_SLOTS once its time was learned
+    uint8_t   exec_slot;
+    /// TRUE while waiting for the response to the last fragment, FALSE while waiting for a fragment ACK
+    uint8_t   exec_armed;
 } ifx_i2c_pl_t;
 
 /** @brief Datalink layer structure */
@@ -403,6 +474,68 @@ typedef struct ifx_i2c_prl
 }ifx_i2c_prl_t;
 #endif
 
+/** @brief Graduated comms recovery: a failed transfer makes the next open escalate from soft to warm to
+ *         cold reset until a transfer succeeds again. Each step is counted and its last run timed */
+typedef struct ifx_i2c_recovery
+{
+    /// Reset step the next #ifx_i2c_open runs, #IFX_I2C_RECOVERY_DL_RESYNC for the default reset
+    uint8_t step;
+    /// Last reset step run, #IFX_I2C_RECOVERY_DL_RESYNC when the last transfer succeeded
+    uint8_t last_step;
+    /// A reset step of the ladder is in progress
+    uint8_t resetting;
+    /// The current transfer is retransmitting or re-synchronizing frames
+    uint8_t dl_active;
+    /// Start of the running step (or data link layer recovery) in microseconds
+    uint32_t start_us;
+    /// Start of the data link layer recovery of the current transfer in microseconds
+    uint32_t dl_start_us;
+    /// Number of runs of each step
+    uint32_t count[IFX_I2C_RECOVERY_STEPS];
+    /// Duration of the last run of each step in microseconds
+    uint32_t last_us[IFX_I2C_RECOVERY_STEPS];
+} ifx_i2c_recovery_t;
+
+/** @brief Retry histogram of one command code */
+typedef struct ifx_i2c_command_stats
+{
+    /// Command code as sent in the APDU, 0 for an unused entry
+    uint8_t command_code;
+    /// Transfers by number of data link layer retransmits and re-syncs, the last bucket counts the rest
+    uint32_t retries[IFX_I2C_STATS_RETRY_BUCKETS];
+    /// Transfers that failed
+    uint32_t failures;
+} ifx_i2c_command_stats_t;
+
+/** @brief Link quality counters of the IFX I2C stack. All counters only increase until #ifx_i2c_clear_stats */
+typedef struct ifx_i2c_stats
+{
+    /// Transfers (APDU and response) completed, successfully or not
+    uint32_t transfers;
+    /// I2C accesses not acknowledged by the slave (or bus errors) and retried by the physical layer
+    uint32_t i2c_nacks;
+    /// Status polls past the learned execution time of the command
+    uint32_t pl_poll_overruns;
+    /// Frames given up because the response was not ready within the data poll timeout
+    uint32_t pl_poll_timeouts;
+    /// Frames received with a wrong CRC
+    uint32_t dl_crc_errors;
+    /// NACK control frames sent for frames received in error
+    uint32_t dl_nacks_sent;
+    /// NACKs received for frames sent
+    uint32_t dl_nacks_received;
+    /// Frames retransmitted
+    uint32_t dl_resends;
+    /// Re-sync control frames sent
+    uint32_t dl_resyncs;
+    /// Re-sync control frames received
+    uint32_t dl_resyncs_received;
+    /// Chaining errors reported by the slave or detected in received packets
+    uint32_t tl_chaining_errors;
+    /// Retry histograms per command code, in order of first use
+    ifx_i2c_command_stats_t command[IFX_I2C_STATS_COMMANDS];
+} ifx_i2c_stats_t;
+
 /** @brief IFX I2C context structure */
 typedef struct ifx_i2c_context
 {
@@ -444,6 +577,14 @@ typedef struct ifx_i2c_context
     uint8_t reset_type;
     /// init pal
     uint8_t do_pal_init;
+    /// Graduated recovery state and counters
+    ifx_i2c_recovery_t recovery;
+    /// Link quality counters
+    ifx_i2c_stats_t stats;
+    /// Command code of the transfer in progress, 0 while no transfer is running
+    uint8_t stats_command;
+    /// Data link layer retransmits and re-syncs of the transfer in progress
+    uint8_t stats_retries;
 #ifdef OPTIGA_COMMS_SHIELDED_CONNECTION
     // protection level:
     //0(master unprotected and slave unprotected),1(master protected and slave unprotected),
@@ -465,16 +606,21 @@ typedef struct ifx_i2c_context
     /// Presentation layer context
     ifx_i2c_prl_t prl;
 #endif
-    /// IFX I2C tx frame of max length
-    uint8_t tx_frame_buffer[IFX_I2C_FRAME_SIZE+1];
-    /// IFX I2C rx frame of max length
-    uint8_t rx_frame_buffer[IFX_I2C_FRAME_SIZE+1];
+    /// IFX I2C tx frame of max length, after IFX_I2C_PL_HEADER_SIZE bytes of headroom
+    uint8_t tx_frame_buffer[IFX_I2C_PL_HEADER_SIZE + IFX_I2C_FRAME_SIZE + 1];
+    /// IFX I2C rx frame of max length, after IFX_I2C_PL_HEADER_SIZE bytes of headroom. The physical layer reads
+    /// the DATA register straight into it (also used to send control frames)
+    uint8_t rx_frame_buffer[IFX_I2C_PL_HEADER_SIZE + IFX_I2C_FRAME_SIZE + 1];
     void * pal_os_event_ctx;
 
 } ifx_i2c_context_t;
 
 /** @brief IFX I2C Instance */
 extern ifx_i2c_context_t ifx_i2c_context_0;
+#if (OPTIGA_MAX_INSTANCES > 1)
+/** @brief IFX I2C Instance of the second OPTIGA */
+extern ifx_i2c_context_t ifx_i2c_context_1;
+#endif
 
 #endif
 
@@ -73,6 +73,10 @@ typedef union optiga_crypt_params
     /// generate symmetric key params
     optiga_gen_symkey_params_t optiga_gen_sym_key_params;   
 #endif    
+#if defined (OPTIGA_CRYPT_RANDOM_ENABLED) && defined (OPTIGA_CRYPT_SYM_ENCRYPT_ENABLED)
+    /// random IV and symmetric encrypt params
+    optiga_random_encrypt_sym_params_t optiga_random_encrypt_sym_params;
+#endif
 }optiga_crypt_params_t;
 
 /** \brief OPTIGA crypt instance structure */
@@ -186,6 +190,24 @@ LIBRARY_EXPORTS optiga_crypt_t * optiga_crypt_create(uint8_t optiga_instance_id,
  */
 LIBRARY_EXPORTS optiga_lib_status_t optiga_crypt_destroy(optiga_crypt_t * me);
 
+/**
+ * \brief Reads the occupancy of the #optiga_crypt_t instance pool.
+ *
+ * \details
+ * Reads the occupancy of the #optiga_crypt_t instance pool.
+ * - Instances are allocated from a static pool of #OPTIGA_CMD_MAX_REGISTRATIONS entries per OPTIGA instance instead of the heap.<br>
+ *
+ * \pre
+ * - None
+ *
+ * \note
+ * - None
+ *
+ * \param[out]     p_stats          Capacity, instances in use and peak since start-up
+ *
+ */
+LIBRARY_EXPORTS void optiga_crypt_get_pool_stats(optiga_lib_pool_stats_t * p_stats);
+
 #ifdef OPTIGA_CRYPT_RANDOM_ENABLED
 /**
  * \brief Generates a random number.
@@ -1306,6 +1328,12 @@ LIBRARY_EXPORTS optiga_lib_status_t optiga_crypt_rsa_encrypt_session(optiga_cryp
  * - For <b>protected I2C communication</b>, Refer #OPTIGA_CRYPT_SET_COMMS_PROTECTION_LEVEL.
  *      - Default protection level for this API is #OPTIGA_COMMS_COMMAND_PROTECTION.
  * - No internal padding is performed by OPTIGA, hence plain data length must be block aligned (minimum 1 block).<br>
+ * - The input length is not limited by the APDU size. The data is sent in as many packets of the maximum
+ *   length (block aligned, up to 640 bytes of InData per APDU) as needed, back to back within this request, so large
+ *   buffers need no splitting by the caller.<br>
+ * - <b>encrypted_data</b> may be the <b>plain_data</b> buffer itself (in place): every packet is copied into
+ *   the APDU before its result is written back. Output that starts inside the plain data instead
+ *   returns #OPTIGA_CRYPT_ERROR_INVALID_INPUT.<br>
  * - Error codes from lower layers is returned as it is to the application.<br>
  *
  * \param[in]         me                                    Valid instance of #optiga_crypt_t created using #optiga_crypt_create.
@@ -1352,6 +1380,64 @@ LIBRARY_EXPORTS optiga_lib_status_t optiga_crypt_rsa_encrypt_session(optiga_cryp
                                                                     uint8_t * encrypted_data,
                                                                     uint32_t * encrypted_data_length);
 
+#ifdef OPTIGA_CRYPT_RANDOM_ENABLED
+/**
+ * \brief Generates a random IV in OPTIGA and encrypts the data with it in one request.<br>
+ *
+ * \details
+ * Generates a random IV and encrypts the input message with it using the symmetric key from OPTIGA.<br>
+ * - Invokes #optiga_cmd_random_encrypt_sym API, based on the input arguments.
+ * - Issues GetRandom for iv_length bytes and Encrypt Sym using them as IV back to back, under one strict sequence,
+ *   so the pair waits in the queue once and completes with a single callback.
+ * - Returns the IV in <b>iv</b> and the encrypted message in <b>encrypted_data</b>.
+ * - The callback registered with instance (#optiga_crypt_create) gets invoked, when the operation is asynchronously completed.
+ *
+ * \pre
+ * - The application on OPTIGA must be opened using #optiga_util_open_application.<br>
+ * - Symmetric key must be available at symmetric key OID in OPTIGA.<br>
+ *
+ * \note
+ * - Same as #optiga_crypt_random followed by #optiga_crypt_symmetric_encrypt without associated data, for the
+ *   modes taking an IV (CBC).<br>
+ * - For <b>protected I2C communication</b>, Refer #OPTIGA_CRYPT_SET_COMMS_PROTECTION_LEVEL.
+ *      - Default protection level for this API is #OPTIGA_COMMS_COMMAND_PROTECTION, applied to both commands.
+ * - <b>encrypted_data</b> may be the <b>plain_data</b> buffer itself (in place).<br>
+ * - If GetRandom fails, the encryption is not issued and the error is returned through the callback.<br>
+ * - Error codes from lower layers is returned as it is to the application.<br>
+ *
+ * \param[in]         me                                    Valid instance of #optiga_crypt_t created using #optiga_crypt_create.
+ * \param[in]         encryption_mode                       Symmetric encryption mode
+ * \param[in]         rng_type                              Type of random data generator for the IV
+ * \param[in]         symmetric_key_oid                     OPTIGA symmetric key OID
+ *                                                          - Symmetric key must be available at the specified OID.<br>
+ * \param[in]         plain_data                            Pointer to the data to be encrypted.
+ * \param[in]         plain_data_length                     Length of the data to be encrypted.
+ *                                                          - It must be block aligned, otherwise OPTIGA returns an error.<br>
+ * \param[in,out]     iv                                    Pointer to buffer to store the generated IV
+ * \param[in]         iv_length                             Length of the IV, must not be 0
+ *                                                          - It must be block aligned, otherwise OPTIGA returns an error.<br>
+ * \param[in,out]     encrypted_data                        Pointer to buffer to store encrypted data
+ * \param[in,out]     encrypted_data_length                 Pointer to length of the <b>encrypted_data</b>. Initial value set as length of buffer, later updated as the actual length of encrypted data.
+ *                                                          - In case of any error, the value is set to 0.
+ *
+ * \retval            #OPTIGA_CRYPT_SUCCESS                 Successful invocation
+ * \retval            #OPTIGA_CRYPT_ERROR_INVALID_INPUT     Wrong Input arguments provided
+ * \retval            #OPTIGA_CRYPT_ERROR_INSTANCE_IN_USE   The previous operation with the same instance is not complete
+ * \retval            #OPTIGA_DEVICE_ERROR                  Command execution failure in OPTIGA and the LSB indicates the error code.
+ *                                                          (Refer Solution Reference Manual)
+ */
+LIBRARY_EXPORTS optiga_lib_status_t optiga_crypt_symmetric_encrypt_random_iv(optiga_crypt_t * me,
+                                                                             optiga_symmetric_encryption_mode_t encryption_mode,
+                                                                             optiga_rng_type_t rng_type,
+                                                                             optiga_key_id_t symmetric_key_oid,
+                                                                             const uint8_t * plain_data,
+                                                                             uint32_t plain_data_length,
+                                                                             uint8_t * iv,
+                                                                             uint16_t iv_length,
+                                                                             uint8_t * encrypted_data,
+                                                                             uint32_t * encrypted_data_length);
+#endif //OPTIGA_CRYPT_RANDOM_ENABLED
+
 /**
  * \brief Encrypt the data using symmetric encryption scheme using ECB mode of operation.<br>
  *
@@ -1371,6 +1457,12 @@ LIBRARY_EXPORTS optiga_lib_status_t optiga_crypt_rsa_encrypt_session(optiga_cryp
  * - For <b>protected I2C communication</b>, Refer #OPTIGA_CRYPT_SET_COMMS_PROTECTION_LEVEL.
  *      - Default protection level for this API is #OPTIGA_COMMS_COMMAND_PROTECTION.
  * - No internal padding is performed by OPTIGA hence plain data length must be block aligned (minimum 1 block).<br>
+ * - The input length is not limited by the APDU size. The data is sent in as many packets of the maximum
+ *   length (block aligned, up to 640 bytes of InData per APDU) as needed, back to back within this request, so large
+ *   buffers need no splitting by the caller.<br>
+ * - <b>encrypted_data</b> may be the <b>plain_data</b> buffer itself (in place): every packet is copied into
+ *   the APDU before its result is written back. Output that starts inside the plain data instead
+ *   returns #OPTIGA_CRYPT_ERROR_INVALID_INPUT.<br>
  * - Error codes from lower layers is returned as it is to the application.<br>
  *
  * \param[in]         me                                    Valid instance of #optiga_crypt_t created using #optiga_crypt_create.
@@ -1418,6 +1510,12 @@ LIBRARY_EXPORTS optiga_lib_status_t optiga_crypt_rsa_encrypt_session(optiga_cryp
  * - For <b>protected I2C communication</b>, Refer #OPTIGA_CRYPT_SET_COMMS_PROTECTION_LEVEL.
  *      - Default protection level for this API is #OPTIGA_COMMS_COMMAND_PROTECTION.
  * - No internal padding is performed by OPTIGA, hence plain data length must be block aligned (minimum 1 block).<br>
+ * - The input length is not limited by the APDU size. The data is sent in as many packets of the maximum
+ *   length (block aligned, up to 640 bytes of InData per APDU) as needed, back to back within this request, so large
+ *   buffers need no splitting by the caller.<br>
+ * - <b>encrypted_data</b> may be the <b>plain_data</b> buffer itself (in place): every packet is copied into
+ *   the APDU before its result is written back. Output that starts inside the plain data instead
+ *   returns #OPTIGA_CRYPT_ERROR_INVALID_INPUT.<br>
  * - Error codes from lower layers is returned as it is to the application.<br>
  * - The strict sequence is terminated
  *   - In case of an error from lower layer.<br>
@@ -1487,6 +1585,12 @@ LIBRARY_EXPORTS optiga_lib_status_t optiga_crypt_rsa_encrypt_session(optiga_cryp
  * \note
  * - For <b>protected I2C communication</b>, value set in #optiga_crypt_symmetric_encrypt_start is used in this API.<br>
  * - No internal padding is performed by OPTIGA, hence plain data length must be block aligned (minimum 1 block).<br>
+ * - The input length is not limited by the APDU size. The data is sent in as many packets of the maximum
+ *   length (block aligned, up to 640 bytes of InData per APDU) as needed, back to back within this request, so large
+ *   buffers need no splitting by the caller.<br>
+ * - <b>encrypted_data</b> may be the <b>plain_data</b> buffer itself (in place): every packet is copied into
+ *   the APDU before its result is written back. Output that starts inside the plain data instead
+ *   returns #OPTIGA_CRYPT_ERROR_INVALID_INPUT.<br>
  * - Error codes from lower layers is returned as it is to the application.<br>
  * - The strict sequence is terminated in case of an error from lower layer<br>
  * - Invoking this API without successful completion of #optiga_crypt_symmetric_encrypt_start throws #OPTIGA_CMD_ERROR_INVALID_INPUT error.<br>
@@ -1535,6 +1639,12 @@ LIBRARY_EXPORTS optiga_lib_status_t optiga_crypt_rsa_encrypt_session(optiga_cryp
  * \note
  * - For <b>protected I2C communication</b>, value set in #optiga_crypt_symmetric_encrypt_start is used in this API.<br>
  * - No internal padding is performed by OPTIGA, hence plain data length must be block aligned (minimum 1 block).<br>
+ * - The input length is not limited by the APDU size. The data is sent in as many packets of the maximum
+ *   length (block aligned, up to 640 bytes of InData per APDU) as needed, back to back within this request, so large
+ *   buffers need no splitting by the caller.<br>
+ * - <b>encrypted_data</b> may be the <b>plain_data</b> buffer itself (in place): every packet is copied into
+ *   the APDU before its result is written back. Output that starts inside the plain data instead
+ *   returns #OPTIGA_CRYPT_ERROR_INVALID_INPUT.<br>
  * - Error codes from lower layers is returned as it is to the application.<br>
  * - The strict sequence is terminated in case of an error from lower layer<br>
  * - Invoking this API without successful completion of #optiga_crypt_symmetric_encrypt_start throws #OPTIGA_CMD_ERROR_INVALID_INPUT error.<br>
@@ -1586,6 +1696,9 @@ LIBRARY_EXPORTS optiga_lib_status_t optiga_crypt_rsa_encrypt_session(optiga_cryp
  *      - Default protection level for this API is #OPTIGA_COMMS_RESPONSE_PROTECTION.
  * - The API does not support MAC based encryption modes.<br>
  * - No internal padding is performed by OPTIGA, hence encrypted data length must be block aligned (minimum 1 block).<br>
+ * - The input length is not limited by the APDU size. The data is sent in as many packets of the maximum
+ *   length (block aligned, up to 640 bytes of InData per APDU) as needed, back to back within this request, so large
+ *   buffers need no splitting by the caller.<br>
  * - Error codes from lower layers is returned as it is to the application.<br>
  *
  * \param[in]         me                                    Valid instance of #optiga_crypt_t created using #optiga_crypt_create.
@@ -1649,6 +1762,9 @@ LIBRARY_EXPORTS optiga_lib_status_t optiga_crypt_rsa_encrypt_session(optiga_cryp
  * - For <b>protected I2C communication</b>, Refer #OPTIGA_CRYPT_SET_COMMS_PROTECTION_LEVEL.
  *      - Default protection level for this API is #OPTIGA_COMMS_RESPONSE_PROTECTION.
  * - No internal padding is performed by OPTIGA, hence encrypted data length must be block aligned (minimum 1 block).<br>
+ * - The input length is not limited by the APDU size. The data is sent in as many packets of the maximum
+ *   length (block aligned, up to 640 bytes of InData per APDU) as needed, back to back within this request, so large
+ *   buffers need no splitting by the caller.<br>
  * - Error codes from lower layers is returned as it is to the application.<br>
  *
  * \param[in]         me                                    Valid instance of #optiga_crypt_t created using #optiga_crypt_create.
@@ -1697,6 +1813,9 @@ LIBRARY_EXPORTS optiga_lib_status_t optiga_crypt_rsa_encrypt_session(optiga_cryp
  *      - Default protection level for this API is #OPTIGA_COMMS_RESPONSE_PROTECTION.
  * - The API does not support MAC based encryption modes.<br>
  * - No internal padding is performed by OPTIGA, hence encrypted data length must be block aligned (minimum 1 block).<br>
+ * - The input length is not limited by the APDU size. The data is sent in as many packets of the maximum
+ *   length (block aligned, up to 640 bytes of InData per APDU) as needed, back to back within this request, so large
+ *   buffers need no splitting by the caller.<br>
  * - Error codes from lower layers is returned as it is to the application.<br>
  * - The strict sequence is terminated
  *   - In case of an error from lower layer.<br>
@@ -1766,6 +1885,9 @@ LIBRARY_EXPORTS optiga_lib_status_t optiga_crypt_rsa_encrypt_session(optiga_cryp
  * \note
  * - For <b>protected I2C communication</b>, value set in #optiga_crypt_symmetric_decrypt_start is used in this API.<br>
  * - No internal padding is performed by OPTIGA, hence encrypted data length must be block aligned (minimum 1 block).<br>
+ * - The input length is not limited by the APDU size. The data is sent in as many packets of the maximum
+ *   length (block aligned, up to 640 bytes of InData per APDU) as needed, back to back within this request, so large
+ *   buffers need no splitting by the caller.<br>
  * - Error codes from lower layers is returned as it is to the application.<br>
  * - The strict sequence is terminated in case of an error from lower layer<br>
  * - Invoking this API without successful completion of #optiga_crypt_symmetric_decrypt_start throws #OPTIGA_CMD_ERROR_INVALID_INPUT error.<br>
@@ -1814,6 +1936,9 @@ LIBRARY_EXPORTS optiga_lib_status_t optiga_crypt_rsa_encrypt_session(optiga_cryp
  * \note
  * - For <b>protected I2C communication</b>, value set in #optiga_crypt_symmetric_decrypt_start is used in this API.<br>
  * - No internal padding is performed by OPTIGA, hence encrypted data length must be block aligned (minimum 1 block).<br>
+ * - The input length is not limited by the APDU size. The data is sent in as many packets of the maximum
+ *   length (block aligned, up to 640 bytes of InData per APDU) as needed, back to back within this request, so large
+ *   buffers need no splitting by the caller.<br>
  * - Error codes from lower layers is returned as it is to the application.<br>
  * - The strict sequence is terminated in case of an error from lower layer<br>
  * - Invoking this API without successful completion of #optiga_crypt_symmetric_decrypt_start throws #OPTIGA_CMD_ERROR_INVALID_INPUT error.<br>
@@ -2555,6 +2680,73 @@ LIBRARY_EXPORTS optiga_lib_status_t optiga_crypt_clear_auto_state(optiga_crypt_t
 #define OPTIGA_CRYPT_SET_COMMS_PROTOCOL_VERSION(p_instance, version) {}
 #endif
 
+/**
+ * \brief Sets the scheduling priority of CRYPT instances
+ *
+ * \details
+ * Sets the priority with which requests of the instance are picked from the OPTIGA command queue.
+ * - Instances start with #OPTIGA_CMD_PRIORITY_NORMAL (#optiga_crypt_create).<br>
+ * - Waiting requests age towards #OPTIGA_CMD_PRIORITY_HIGH, so lower priorities are delayed, not starved.<br>
+ *
+ * \pre
+ * - None
+ *
+ * \note
+ * - Applies to requests issued after the call.
+ *
+ * \param[in]      p_instance    Valid pointer to an instance
+ * \param[in]      priority      #OPTIGA_CMD_PRIORITY_LOW, #OPTIGA_CMD_PRIORITY_NORMAL or #OPTIGA_CMD_PRIORITY_HIGH
+ */
+#define OPTIGA_CRYPT_SET_PRIORITY(p_instance, priority) \
+{ \
+    optiga_cmd_set_priority((p_instance)->my_cmd, priority); \
+}
+
+/**
+ * \brief Leases the session of the crypt instance for a sequence of operations.
+ *
+ * \details
+ * Leases the session of the crypt instance for a sequence of operations.
+ * - Keeps key material derived or generated into the session OID for the following operations, e.g. a key pair
+ *   generated into the session followed by ECDH, or an HKDF into the session followed by many encryptions.<br>
+ * - With a non zero lease_ms, an instance idle for that long loses the session when another instance needs one and
+ *   none is free. 0 holds it until #OPTIGA_CRYPT_SESSION_END or #optiga_crypt_destroy.<br>
+ *
+ * \pre
+ * - None
+ *
+ * \note
+ * - Check #OPTIGA_CRYPT_SESSION_HELD before relying on session key material after an idle period.
+ *
+ * \param[in]      p_instance    Valid pointer to an instance
+ * \param[in]      lease_ms      Idle time in milliseconds after which the session may be reclaimed, 0 for none
+ */
+#define OPTIGA_CRYPT_SESSION_LEASE(p_instance, lease_ms) \
+{ \
+    optiga_cmd_session_lease((p_instance)->my_cmd, lease_ms); \
+}
+
+/**
+ * \brief Ends the session of the crypt instance, freeing the session OID for other instances.
+ *
+ * \pre
+ * - No operation of the instance is pending.
+ *
+ * \param[in]      p_instance    Valid pointer to an instance
+ */
+#define OPTIGA_CRYPT_SESSION_END(p_instance) \
+{ \
+    optiga_cmd_session_end((p_instance)->my_cmd); \
+}
+
+/**
+ * \brief Evaluates to TRUE while the crypt instance holds a session.
+ *
+ * \param[in]      p_instance    Valid pointer to an instance
+ */
+#define OPTIGA_CRYPT_SESSION_HELD(p_instance) \
+    (optiga_cmd_session_held((p_instance)->my_cmd))
+
 #ifdef __cplusplus
 }
 #endif
@@ -120,6 +120,11 @@ extern "C" {
     #define OPTIGA_LIB_DEBUG_NULL_CHECK
     /** @brief Maximum number of instance registration */
     #define OPTIGA_CMD_MAX_REGISTRATIONS                (0x06)
+    /** @brief Number of OPTIGA devices, selected by the optiga_instance_id of the create APIs.
+     *         Each device needs its own IFX I2C and PAL I2C context (at most 2 are defined) */
+    #ifndef OPTIGA_MAX_INSTANCES
+        #define OPTIGA_MAX_INSTANCES                    (1U)
+    #endif
     /** @brief Maximum buffer size required to communicate with OPTIGA */
     #define OPTIGA_MAX_COMMS_BUFFER_SIZE                (0x615) //1557 in decimal
 
@@ -84,6 +84,14 @@ struct optiga_util
     /// To provide the presentation layer protocol version to be used
     uint8_t protocol_version;
 #endif //OPTIGA_COMMS_SHIELDED_CONNECTION
+#ifdef OPTIGA_UTIL_READ_CACHE_ENTRIES
+    /// What the read cache does when the current request completes (store the read or invalidate)
+    uint8_t read_cache_op;
+    /// OID the completed write invalidates
+    uint16_t read_cache_oid;
+    /// Invalidation count when the read was issued, the read is not stored if it changed
+    uint32_t read_cache_generation;
+#endif //OPTIGA_UTIL_READ_CACHE_ENTRIES
 
 };
 /** \brief OPTIGA util instance structure type*/
@@ -179,6 +187,92 @@ LIBRARY_EXPORTS optiga_util_t * optiga_util_create(uint8_t optiga_instance_id,
  */
 LIBRARY_EXPORTS optiga_lib_status_t optiga_util_destroy(optiga_util_t * me);
 
+/**
+ * \brief Reads the occupancy of the #optiga_util_t instance pool.
+ *
+ * \details
+ * Reads the occupancy of the #optiga_util_t instance pool.
+ * - Instances are allocated from a static pool of #OPTIGA_CMD_MAX_REGISTRATIONS entries per OPTIGA instance instead of the heap.<br>
+ *
+ * \pre
+ * - None
+ *
+ * \note
+ * - None
+ *
+ * \param[out]     p_stats          Capacity, instances in use and peak since start-up
+ *
+ */
+LIBRARY_EXPORTS void optiga_util_get_pool_stats(optiga_lib_pool_stats_t * p_stats);
+
+#ifdef OPTIGA_UTIL_READ_CACHE_ENTRIES
+/// Largest read the cache stores in bytes, longer reads always go to OPTIGA
+#ifndef OPTIGA_UTIL_READ_CACHE_ENTRY_BYTES
+    #define OPTIGA_UTIL_READ_CACHE_ENTRY_BYTES      (512U)
+#endif
+
+/// Passed to #optiga_util_read_cache_invalidate to drop every entry
+#define OPTIGA_UTIL_READ_CACHE_ALL_OIDS             (0x0000)
+
+/** \brief Counters of the read cache since start-up */
+typedef struct optiga_util_read_cache_stats
+{
+    /// Reads answered from the cache
+    uint32_t hits;
+    /// Cacheable reads sent to OPTIGA
+    uint32_t misses;
+    /// Entries replaced because the cache was full
+    uint32_t evictions;
+    /// Entries dropped by writes, key generation and protected updates
+    uint32_t invalidations;
+    /// Entries currently held
+    uint8_t entries;
+    /// Number of entries, #OPTIGA_UTIL_READ_CACHE_ENTRIES
+    uint8_t capacity;
+} optiga_util_read_cache_stats_t;
+
+/**
+ * \brief Drops the cached reads of a data object.
+ *
+ * \details
+ * Drops the cached data and metadata reads of a data object.
+ * - #optiga_util_write_data, #optiga_util_write_metadata, #optiga_util_update_count, the protected update and the
+ *   key and key pair generation into an OID already call it. Use it when a data object changed by other means.<br>
+ *
+ * \pre
+ * - None
+ *
+ * \note
+ * - Runs in the PAL critical section.
+ *
+ * \param[in]      optiga_oid       OID of data object, #OPTIGA_UTIL_READ_CACHE_ALL_OIDS for all
+ *
+ */
+LIBRARY_EXPORTS void optiga_util_read_cache_invalidate(uint16_t optiga_oid);
+
+/**
+ * \brief Reads the counters of the read cache.
+ *
+ * \details
+ * Reads the counters of the read cache.
+ * - With #OPTIGA_UTIL_READ_CACHE_ENTRIES defined, #optiga_util_read_data and #optiga_util_read_metadata keep their
+ *   results, keyed by OID, offset and data or metadata, in a least recently used table of that many entries of
+ *   #OPTIGA_UTIL_READ_CACHE_ENTRY_BYTES.<br>
+ * - A hit copies the entry and invokes the callback handler before the read API returns.<br>
+ *
+ * \pre
+ * - None
+ *
+ * \note
+ * - The security event counter (0xE0C5), the global security status (0xE0C1) and the monotonic counters
+ *   (0xE120 to 0xE123) change inside OPTIGA, their data is never cached.
+ *
+ * \param[out]     p_stats          Hits, misses, evictions, invalidations and occupancy
+ *
+ */
+LIBRARY_EXPORTS void optiga_util_get_read_cache_stats(optiga_util_read_cache_stats_t * p_stats);
+#endif //OPTIGA_UTIL_READ_CACHE_ENTRIES
+
 /**
  * \brief Initializes the communication with optiga and open the application on OPTIGA.
  *
@@ -335,6 +429,9 @@ LIBRARY_EXPORTS optiga_lib_status_t optiga_util_read_metadata(optiga_util_t * me
  *\details
  * Writes the data provided by the user into the specified data object.<br>
  * - Invokes #optiga_cmd_set_data_object API, based on the input arguments to write the data to the data object.<br>
+ * - Data longer than one APDU is split into APDUs as large as #OPTIGA_MAX_COMMS_BUFFER_SIZE allows: the first with
+ *   write_type, the rest write only at the following offsets. They are sent back to back under one lock and the
+ *   callback handler is invoked once, so write a certificate or trust anchor with one call, not in pieces.<br>
  *
  *\pre
  * - The application on OPTIGA must be opened using #optiga_util_open_application before using this API.<br>
@@ -613,6 +710,28 @@ LIBRARY_EXPORTS optiga_lib_status_t optiga_util_update_count(optiga_util_t * me,
 #define OPTIGA_UTIL_SET_COMMS_PROTOCOL_VERSION(p_instance, version) {}
 #endif
 
+/**
+ * \brief Sets the scheduling priority of UTIL instances
+ *
+ * \details
+ * Sets the priority with which requests of the instance are picked from the OPTIGA command queue.
+ * - Instances start with #OPTIGA_CMD_PRIORITY_NORMAL (#optiga_util_create).<br>
+ * - Waiting requests age towards #OPTIGA_CMD_PRIORITY_HIGH, so lower priorities are delayed, not starved.<br>
+ *
+ * \pre
+ * - None
+ *
+ * \note
+ * - Applies to requests issued after the call.
+ *
+ * \param[in]      p_instance    Valid pointer to an instance
+ * \param[in]      priority      #OPTIGA_CMD_PRIORITY_LOW, #OPTIGA_CMD_PRIORITY_NORMAL or #OPTIGA_CMD_PRIORITY_HIGH
+ */
+#define OPTIGA_UTIL_SET_PRIORITY(p_instance, priority) \
+{ \
+    optiga_cmd_set_priority((p_instance)->my_cmd, priority); \
+}
+
 #ifdef __cplusplus
 }
 #endif
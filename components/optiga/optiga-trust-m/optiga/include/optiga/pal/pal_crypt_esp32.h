@@ -0,0 +1,94 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2020 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file pal_crypt_esp32.h
+*
+* \brief   This file provides the prototypes of the ESP32 PAL crypt extensions.
+*
+* \details With PAL_CRYPT_TLS_PRF_ALT the handshake PRF of the shielded connection runs in
+*          pal_crypt_esp32.c on the SHA accelerator. The mbedtls_md implementation of
+*          pal_crypt_mbedtls.c stays linked as pal_crypt_tls_prf_sha256_md() and can be selected
+*          at run time, so both backends can be timed on the same build.
+*
+* \ingroup  grPAL
+*
+* @{
+*/
+
+
+#ifndef _PAL_CRYPT_ESP32_H_
+#define _PAL_CRYPT_ESP32_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "pal_crypt.h"
+
+#ifdef PAL_CRYPT_TLS_PRF_ALT
+
+/** @brief Implementation behind pal_crypt_tls_prf_sha256() */
+typedef enum pal_crypt_prf_backend
+{
+    /// HMAC states keyed once per call on the SHA accelerator (pal_crypt_esp32.c), the default
+    PAL_CRYPT_PRF_BACKEND_SHA_HW = 0,
+    /// mbedtls_md HMAC (pal_crypt_mbedtls.c)
+    PAL_CRYPT_PRF_BACKEND_MD
+} pal_crypt_prf_backend_t;
+
+/**
+ * \brief Selects the implementation of the following pal_crypt_tls_prf_sha256() calls.
+ *
+ * \param[in] backend   Implementation
+ */
+void pal_crypt_set_prf_backend(pal_crypt_prf_backend_t backend);
+
+/**
+ * \brief pal_crypt_tls_prf_sha256() on mbedtls_md, same parameters and return values.
+ */
+pal_status_t pal_crypt_tls_prf_sha256_md(pal_crypt_t* p_pal_crypt,
+                                         const uint8_t * p_secret,
+                                         uint16_t secret_length,
+                                         const uint8_t * p_label,
+                                         uint16_t label_length,
+                                         const uint8_t * p_seed,
+                                         uint16_t seed_length,
+                                         uint8_t * p_derived_key,
+                                         uint16_t derived_key_length);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PAL_CRYPT_ESP32_H_ */
+
+/**
+* @}
+*/
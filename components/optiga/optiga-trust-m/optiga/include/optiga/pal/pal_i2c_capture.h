@@ -0,0 +1,170 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2020 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file pal_i2c_capture.h
+*
+* \brief   This file provides the capture format and prototypes of the PAL I2C transaction capture.
+*
+* \details With PAL_I2C_CAPTURE_ENABLED the port records every pal_i2c_init, pal_i2c_write,
+*          pal_i2c_read and pal_i2c_set_bitrate with a time stamp and the bytes on the bus in a RAM
+*          ring; the comms layer adds the command APDU given to optiga_comms_transceive, before
+*          shielded connection protection. The ring is saved as a capture file (this header,
+*          then the records oldest first), which the loopback PAL replays on a host.
+*          All fields are little endian, as written by the ESP32.
+*
+* \ingroup  grPAL
+*
+* @{
+*/
+
+
+#ifndef _PAL_I2C_CAPTURE_H_
+#define _PAL_I2C_CAPTURE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "pal_i2c.h"
+
+/// First word of a capture file ("ICAP")
+#define PAL_I2C_CAPTURE_MAGIC           (0x50414349UL)
+/// Version of the capture file format
+#define PAL_I2C_CAPTURE_VERSION         (1U)
+
+/// pal_i2c_init: a comms open starts, no data. Replays start at these records
+#define PAL_I2C_CAPTURE_INIT            (0x01)
+/// pal_i2c_write, data: the bytes written (register address first)
+#define PAL_I2C_CAPTURE_WRITE           (0x02)
+/// pal_i2c_read, data: the bytes read
+#define PAL_I2C_CAPTURE_READ            (0x03)
+/// pal_i2c_set_bitrate, data: the requested bitrate in kHz (2 bytes, big endian)
+#define PAL_I2C_CAPTURE_BITRATE         (0x04)
+/// optiga_comms_transceive, data: the command APDU; status: the protection level
+#define PAL_I2C_CAPTURE_APDU            (0x05)
+
+/// Record type bits of #pal_i2c_capture_record_t::type
+#define PAL_I2C_CAPTURE_TYPE_MASK       (0x0F)
+/// Position of the OPTIGA instance (0 or 1) in #pal_i2c_capture_record_t::type
+#define PAL_I2C_CAPTURE_DEVICE_SHIFT    (4U)
+
+/** @brief Header of a capture file */
+typedef struct pal_i2c_capture_file
+{
+    /// #PAL_I2C_CAPTURE_MAGIC
+    uint32_t magic;
+    /// #PAL_I2C_CAPTURE_VERSION
+    uint16_t version;
+    /// sizeof(pal_i2c_capture_record_t), records follow this header
+    uint16_t record_header_size;
+    /// Records in the file
+    uint32_t records;
+    /// Records lost since the previous save: overwritten by newer ones, or made while saving
+    uint32_t dropped;
+    /// Bytes of records after this header
+    uint32_t bytes;
+} pal_i2c_capture_file_t;
+
+/** @brief Header of one record, followed by length data bytes */
+typedef struct pal_i2c_capture_record
+{
+    /// pal_os_timer time at the start of the call [us]
+    uint32_t time_us;
+    /// Call duration, the bus transfer for writes and reads [us]
+    uint32_t duration_us;
+    /// Data bytes after this header
+    uint16_t length;
+    /// PAL_I2C_CAPTURE_* type, OPTIGA instance in the upper bits
+    uint8_t type;
+    /// Transfers: 0 on success, 1 on a bus error. APDUs: protection level
+    uint8_t status;
+} pal_i2c_capture_record_t;
+
+/**
+ * \brief Sink for pal_i2c_capture_save(), e.g. a file write.
+ *
+ * \retval  0 on success, anything else stops the save
+ */
+typedef int32_t (*pal_i2c_capture_write_t)(void * p_context, const uint8_t * p_data, uint32_t length);
+
+#ifdef PAL_I2C_CAPTURE_ENABLED
+
+/**
+ * \brief Appends a record to the capture ring, dropping the oldest records if it is full.
+ *
+ * \param[in] p_i2c_context   I2C context of the OPTIGA instance
+ * \param[in] type            PAL_I2C_CAPTURE_* record type
+ * \param[in] start_us        pal_os_timer time at the start of the call
+ * \param[in] p_data          Data bytes, NULL if length is 0
+ * \param[in] length          Number of data bytes
+ * \param[in] status          See #pal_i2c_capture_record_t::status
+ */
+void pal_i2c_capture_record(const pal_i2c_t * p_i2c_context,
+                            uint8_t type,
+                            uint32_t start_us,
+                            const uint8_t * p_data,
+                            uint16_t length,
+                            uint8_t status);
+
+/**
+ * \brief Writes the ring as a capture file to the sink, oldest record first, then empties it.
+ *
+ * \details Calls made while the save runs are not recorded; they count as dropped in the next save.
+ *
+ * \param[in] writer      Sink of the file bytes
+ * \param[in] p_context   Passed to the sink
+ *
+ * \retval  #PAL_STATUS_SUCCESS  The file was written
+ * \retval  #PAL_STATUS_FAILURE  The sink failed, the records are kept
+ */
+pal_status_t pal_i2c_capture_save(pal_i2c_capture_write_t writer, void * p_context);
+
+/**
+ * \brief Gives the file header a save would write now.
+ */
+void pal_i2c_capture_get_info(pal_i2c_capture_file_t * p_info);
+
+/** @brief Capture point, removed at compile time unless PAL_I2C_CAPTURE_ENABLED is defined */
+#define PAL_I2C_CAPTURE(p_i2c_context, type, start_us, p_data, length, status) \
+    pal_i2c_capture_record((p_i2c_context), (type), (start_us), (p_data), (length), (status))
+
+#else
+
+#define PAL_I2C_CAPTURE(p_i2c_context, type, start_us, p_data, length, status)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PAL_I2C_CAPTURE_H_ */
+
+/**
+* @}
+*/
@@ -46,10 +46,16 @@ extern "C" {
 #include "pal_i2c.h"
 #include "pal_gpio.h"
 #include "pal_os_datastore.h"
+#include "optiga/optiga_lib_config.h"
 
 extern pal_i2c_t optiga_pal_i2c_context_0;
 extern pal_gpio_t optiga_vdd_0;
 extern pal_gpio_t optiga_reset_0;
+#if (OPTIGA_MAX_INSTANCES > 1)
+extern pal_i2c_t optiga_pal_i2c_context_1;
+extern pal_gpio_t optiga_vdd_1;
+extern pal_gpio_t optiga_reset_1;
+#endif
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,131 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2020 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file pal_os_diag.h
+*
+* \brief   This file provides the prototypes of the PAL memory and task diagnostics.
+*
+* \details The port counts the bytes allocated through pal_os_malloc and pal_os_calloc (the
+*          per-instance contexts of optiga_util, optiga_crypt, optiga_cmd and the comms layer)
+*          and keeps the peak, and reports the stack high-water mark of its event tasks.
+*          The numbers are meant for sizing: stacks and heap left over once a long run has
+*          exercised every command path can be given to the application.
+*
+* \ingroup  grPAL
+*
+* @{
+*/
+
+
+#ifndef _PAL_OS_DIAG_H_
+#define _PAL_OS_DIAG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "pal.h"
+
+/** @brief Allocations through pal_os_malloc and pal_os_calloc */
+typedef struct pal_os_memory_stats
+{
+    /// Bytes allocated now, block headers not included
+    uint32_t in_use_bytes;
+    /// Largest in_use_bytes since boot or #pal_os_memory_reset_peak
+    uint32_t peak_bytes;
+    /// Blocks allocated now
+    uint32_t blocks;
+    /// Successful allocations since boot
+    uint32_t allocations;
+    /// Allocations that returned NULL
+    uint32_t failures;
+    /// Size of the allocation arena, 0 if blocks come from the libc heap
+    uint32_t arena_bytes;
+    /// Arena bytes handed to size classes so far; stays at its peak, freed blocks are reused
+    uint32_t arena_carved_bytes;
+} pal_os_memory_stats_t;
+
+/** @brief Stack of one PAL task */
+typedef struct pal_os_task_stats
+{
+    /// Task name
+    const char * name;
+    /// Stack size given at creation [bytes]
+    uint32_t stack_bytes;
+    /// Least free stack seen since the task started [bytes]
+    uint32_t stack_free_min_bytes;
+    /// Current priority
+    uint8_t priority;
+    /// Core the task is pinned to, -1 if it runs on any core
+    int8_t core;
+} pal_os_task_stats_t;
+
+/** @brief I2C transfers under the power management lock of pal_i2c */
+typedef struct pal_i2c_pm_stats
+{
+    /// Transfers since boot
+    uint32_t transfers;
+    /// Time the lock was held [us]
+    uint64_t held_us;
+} pal_i2c_pm_stats_t;
+
+/**
+ * \brief Copies the allocation counters.
+ */
+void pal_os_memory_get_stats(pal_os_memory_stats_t * p_stats);
+
+/**
+ * \brief Restarts the peak at the bytes allocated now, e.g. before a test run.
+ */
+void pal_os_memory_reset_peak(void);
+
+/**
+ * \brief Gives the stack use of the event tasks, one per OPTIGA instance.
+ *
+ * \param[out] p_stats     Array of max_tasks entries
+ * \param[in]  max_tasks   Entries in p_stats
+ *
+ * \retval  Number of entries filled
+ */
+uint8_t pal_os_event_get_task_stats(pal_os_task_stats_t * p_stats, uint8_t max_tasks);
+
+/**
+ * \brief Copies the power management lock counters of the I2C transfers, all zero if the
+ *        port holds no lock (CONFIG_OPTIGA_TRUST_M_PM_LOCK off).
+ */
+void pal_i2c_get_pm_stats(pal_i2c_pm_stats_t * p_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PAL_OS_DIAG_H_ */
+
+/**
+* @}
+*/
@@ -50,6 +50,8 @@ typedef struct pal_os_lock
 {
     uint8_t lock;
     uint8_t type;
+    /// Port specific, e.g. the RTOS mutex behind the lock. NULL until the port creates it
+    void * p_os_lock;
 } pal_os_lock_t;
 
 /**
@@ -0,0 +1,129 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2020 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file pal_sysview.h
+*
+* \brief   This file provides the SEGGER SystemView markers of the OPTIGA stack and the logger.
+*
+* \details With PAL_SYSVIEW_ENABLED the port puts performance markers (start and stop of a span,
+*          or a single point) on the SystemView timeline, next to the task switches and
+*          interrupts that SystemView records on its own: OPTIGA commands, shielded connection
+*          crypto, OPTIGA execution, I2C transfers, event callbacks and, from the application,
+*          log encryption and file system writes. Without it the markers compile to nothing.
+*
+* \ingroup  grPAL
+*
+* @{
+*/
+
+
+#ifndef _PAL_SYSVIEW_H_
+#define _PAL_SYSVIEW_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "optiga/common/optiga_lib_types.h"
+
+/// OPTIGA command, APDU preparation to caller notification (optiga_cmd)
+#define PAL_SYSVIEW_MARK_CMD                (0x00)
+/// Shielded connection encryption of an outgoing message
+#define PAL_SYSVIEW_MARK_PROTECT            (0x01)
+/// Shielded connection decryption of an incoming message
+#define PAL_SYSVIEW_MARK_UNPROTECT          (0x02)
+/// OPTIGA executes: last fragment written to response ready
+#define PAL_SYSVIEW_MARK_EXEC               (0x03)
+/// pal_i2c_write on the bus
+#define PAL_SYSVIEW_MARK_I2C_WRITE          (0x04)
+/// pal_i2c_read on the bus
+#define PAL_SYSVIEW_MARK_I2C_READ           (0x05)
+/// Callback of a PAL event run by the event task
+#define PAL_SYSVIEW_MARK_EVENT              (0x06)
+/// Data link layer frame retransmission or re-sync (point)
+#define PAL_SYSVIEW_MARK_RETRY              (0x07)
+/// Application: encryption of a log record or block group
+#define PAL_SYSVIEW_MARK_LOG_ENCRYPT        (0x10)
+/// Application: log buffer written to the file
+#define PAL_SYSVIEW_MARK_LOG_WRITE          (0x11)
+/// Application: fsync of the log file
+#define PAL_SYSVIEW_MARK_LOG_SYNC           (0x12)
+
+#ifdef PAL_SYSVIEW_ENABLED
+
+/**
+ * \brief Starts a span of the marker on the timeline of the calling task.
+ *
+ * \param[in] marker      PAL_SYSVIEW_MARK_* id
+ */
+void pal_sysview_start(uint32_t marker);
+
+/**
+ * \brief Ends the span started by #pal_sysview_start.
+ *
+ * \param[in] marker      PAL_SYSVIEW_MARK_* id
+ */
+void pal_sysview_stop(uint32_t marker);
+
+/**
+ * \brief Puts a single point of the marker on the timeline.
+ *
+ * \param[in] marker      PAL_SYSVIEW_MARK_* id
+ */
+void pal_sysview_mark(uint32_t marker);
+
+/**
+ * \brief Maps a latency trace event (OPTIGA_LIB_TRACE_*) to the markers above.
+ *
+ * \param[in] event       Trace event id
+ * \param[in] arg         Trace event argument
+ */
+void pal_sysview_trace(uint8_t event, uint32_t arg);
+
+/** @brief Marker points, removed at compile time unless PAL_SYSVIEW_ENABLED is defined */
+#define PAL_SYSVIEW_START(marker)       pal_sysview_start(marker)
+#define PAL_SYSVIEW_STOP(marker)        pal_sysview_stop(marker)
+#define PAL_SYSVIEW_MARK(marker)        pal_sysview_mark(marker)
+
+#else
+
+#define PAL_SYSVIEW_START(marker)
+#define PAL_SYSVIEW_STOP(marker)
+#define PAL_SYSVIEW_MARK(marker)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PAL_SYSVIEW_H_ */
+
+/**
+* @}
+*/
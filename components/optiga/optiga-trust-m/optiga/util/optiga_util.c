@@ -39,6 +39,12 @@
 #include "optiga/common/optiga_lib_logger.h"
 #include "optiga/common/optiga_lib_common_internal.h"
 #include "optiga/pal/pal_os_memory.h"
+#ifdef OPTIGA_UTIL_READ_CACHE_ENTRIES
+#include "optiga/pal/pal_os_lock.h"
+#endif
+
+// Every instance owns an optiga cmd instance, so the cmd registrations bound the pool
+OPTIGA_LIB_POOL_DEFINE(g_optiga_util_pool, optiga_util_t, OPTIGA_CMD_MAX_REGISTRATIONS * OPTIGA_MAX_INSTANCES);
 
 #if defined (OPTIGA_LIB_ENABLE_LOGGING) && defined (OPTIGA_LIB_ENABLE_UTIL_LOGGING)
 
@@ -83,11 +89,219 @@ extern void optiga_cmd_set_shielded_connection_option(optiga_cmd_t * me, uint8_t
 
 
 
+#ifdef OPTIGA_UTIL_READ_CACHE_ENTRIES
+
+// What the read cache does when the request of an instance completes
+#define OPTIGA_UTIL_READ_CACHE_OP_NONE          (0x00)
+#define OPTIGA_UTIL_READ_CACHE_OP_FILL          (0x01)
+#define OPTIGA_UTIL_READ_CACHE_OP_INVALIDATE    (0x02)
+
+#define OPTIGA_UTIL_READ_CACHE_BEGIN(me, op, oid) optiga_util_read_cache_begin((me), (op), (oid))
+
+typedef struct optiga_util_read_cache_entry
+{
+    // Least recently used stamp, 0 for a free entry
+    uint32_t last_use;
+    uint16_t oid;
+    uint16_t offset;
+    uint16_t length;
+    uint8_t metadata;
+    // OPTIGA returned less than asked for: data holds everything from offset to the end of the object
+    uint8_t complete;
+    uint8_t data[OPTIGA_UTIL_READ_CACHE_ENTRY_BYTES];
+} optiga_util_read_cache_entry_t;
+
+static optiga_util_read_cache_entry_t g_optiga_util_read_cache[OPTIGA_UTIL_READ_CACHE_ENTRIES];
+static optiga_util_read_cache_stats_t g_optiga_util_read_cache_stats;
+static uint32_t g_optiga_util_read_cache_clock;
+// Incremented by every invalidation: a read that overlapped one is not stored
+static volatile uint32_t g_optiga_util_read_cache_generation;
+
+// Data OPTIGA changes by itself: global security status, last error code, security event counter,
+// monotonic counters
+_STATIC_H bool_t optiga_util_read_cache_allowed(uint16_t oid,
+                                                uint8_t metadata)
+{
+    return ((0U != metadata) ||
+            ((0xE0C1U != oid) && (0xF1C2U != oid) && (0xE0C5U != oid) && ((oid < 0xE120U) || (oid > 0xE123U))));
+}
+
+_STATIC_H bool_t optiga_util_read_cache_lookup(uint16_t oid,
+                                               uint16_t offset,
+                                               uint8_t metadata,
+                                               uint8_t * p_buffer,
+                                               uint16_t * p_length)
+{
+    optiga_util_read_cache_entry_t * p_entry;
+    bool_t hit = FALSE;
+    uint8_t index;
+
+    if ((0U == *p_length) || (FALSE == optiga_util_read_cache_allowed(oid, metadata)))
+    {
+        return (FALSE);
+    }
+
+    pal_os_lock_enter_critical_section();
+    for (index = 0; index < OPTIGA_UTIL_READ_CACHE_ENTRIES; index++)
+    {
+        p_entry = &g_optiga_util_read_cache[index];
+        if ((0U != p_entry->last_use) && (oid == p_entry->oid) && (offset == p_entry->offset) &&
+            (metadata == p_entry->metadata) && ((0U != p_entry->complete) || (*p_length <= p_entry->length)))
+        {
+            // As OPTIGA would: at most *p_length bytes, fewer at the end of the object
+            if (p_entry->length < *p_length)
+            {
+                *p_length = p_entry->length;
+            }
+            pal_os_memcpy(p_buffer, p_entry->data, *p_length);
+            p_entry->last_use = ++g_optiga_util_read_cache_clock;
+            hit = TRUE;
+            break;
+        }
+    }
+    if (TRUE == hit)
+    {
+        g_optiga_util_read_cache_stats.hits++;
+    }
+    else
+    {
+        g_optiga_util_read_cache_stats.misses++;
+    }
+    pal_os_lock_exit_critical_section();
+
+    return (hit);
+}
+
+_STATIC_H void optiga_util_read_cache_store(const optiga_get_data_object_params_t * p_params,
+                                            uint32_t generation)
+{
+    optiga_util_read_cache_entry_t * p_victim = NULL;
+    optiga_util_read_cache_entry_t * p_entry;
+    const uint16_t length = *(p_params->ref_bytes_to_read);
+    uint8_t index;
+
+    if ((length > OPTIGA_UTIL_READ_CACHE_ENTRY_BYTES) ||
+        (FALSE == optiga_util_read_cache_allowed(p_params->oid, p_params->data_or_metadata)))
+    {
+        return;
+    }
+
+    pal_os_lock_enter_critical_section();
+    if (generation == g_optiga_util_read_cache_generation)
+    {
+        // The same key again, else a free entry, else the least recently used one
+        for (index = 0; index < OPTIGA_UTIL_READ_CACHE_ENTRIES; index++)
+        {
+            p_entry = &g_optiga_util_read_cache[index];
+            if ((0U != p_entry->last_use) && (p_params->oid == p_entry->oid) &&
+                (p_params->offset == p_entry->offset) && (p_params->data_or_metadata == p_entry->metadata))
+            {
+                p_victim = p_entry;
+                break;
+            }
+            if ((NULL == p_victim) || ((0U != p_victim->last_use) && (p_entry->last_use < p_victim->last_use)))
+            {
+                p_victim = p_entry;
+            }
+        }
+        if ((0U != p_victim->last_use) &&
+            ((p_params->oid != p_victim->oid) || (p_params->offset != p_victim->offset) ||
+             (p_params->data_or_metadata != p_victim->metadata)))
+        {
+            g_optiga_util_read_cache_stats.evictions++;
+        }
+        p_victim->oid = p_params->oid;
+        p_victim->offset = p_params->offset;
+        p_victim->metadata = p_params->data_or_metadata;
+        p_victim->length = length;
+        p_victim->complete = (length < p_params->bytes_to_read) ? 1U : 0U;
+        pal_os_memcpy(p_victim->data, p_params->buffer, length);
+        p_victim->last_use = ++g_optiga_util_read_cache_clock;
+    }
+    pal_os_lock_exit_critical_section();
+}
+
+// Remembers what to do on completion; a write invalidates now and again when it completes
+_STATIC_H void optiga_util_read_cache_begin(optiga_util_t * me,
+                                            uint8_t op,
+                                            uint16_t oid)
+{
+    if (OPTIGA_UTIL_READ_CACHE_OP_INVALIDATE == op)
+    {
+        optiga_util_read_cache_invalidate(oid);
+    }
+    me->read_cache_op = op;
+    me->read_cache_oid = oid;
+    me->read_cache_generation = g_optiga_util_read_cache_generation;
+}
+
+_STATIC_H void optiga_util_read_cache_complete(optiga_util_t * me,
+                                               optiga_lib_status_t event)
+{
+    if ((OPTIGA_UTIL_READ_CACHE_OP_FILL == me->read_cache_op) && (OPTIGA_LIB_SUCCESS == event))
+    {
+        optiga_util_read_cache_store(&me->params.optiga_get_data_object_params, me->read_cache_generation);
+    }
+    else if (OPTIGA_UTIL_READ_CACHE_OP_INVALIDATE == me->read_cache_op)
+    {
+        // Also after a failure, the object may have been partly written
+        optiga_util_read_cache_invalidate(me->read_cache_oid);
+    }
+    me->read_cache_op = OPTIGA_UTIL_READ_CACHE_OP_NONE;
+}
+
+void optiga_util_read_cache_invalidate(uint16_t optiga_oid)
+{
+    optiga_util_read_cache_entry_t * p_entry;
+    uint8_t index;
+
+    pal_os_lock_enter_critical_section();
+    g_optiga_util_read_cache_generation++;
+    for (index = 0; index < OPTIGA_UTIL_READ_CACHE_ENTRIES; index++)
+    {
+        p_entry = &g_optiga_util_read_cache[index];
+        if ((0U != p_entry->last_use) &&
+            ((OPTIGA_UTIL_READ_CACHE_ALL_OIDS == optiga_oid) || (optiga_oid == p_entry->oid)))
+        {
+            p_entry->last_use = 0;
+            g_optiga_util_read_cache_stats.invalidations++;
+        }
+    }
+    pal_os_lock_exit_critical_section();
+}
+
+void optiga_util_get_read_cache_stats(optiga_util_read_cache_stats_t * p_stats)
+{
+    uint8_t index;
+
+    pal_os_lock_enter_critical_section();
+    *p_stats = g_optiga_util_read_cache_stats;
+    p_stats->entries = 0;
+    for (index = 0; index < OPTIGA_UTIL_READ_CACHE_ENTRIES; index++)
+    {
+        if (0U != g_optiga_util_read_cache[index].last_use)
+        {
+            p_stats->entries++;
+        }
+    }
+    pal_os_lock_exit_critical_section();
+    p_stats->capacity = (uint8_t)OPTIGA_UTIL_READ_CACHE_ENTRIES;
+}
+
+#else
+
+#define OPTIGA_UTIL_READ_CACHE_BEGIN(me, op, oid) {}
+
+#endif //OPTIGA_UTIL_READ_CACHE_ENTRIES
+
 _STATIC_H void optiga_util_generic_event_handler(void * me,
                                                  optiga_lib_status_t event)
 {
     optiga_util_t * p_optiga_util = (optiga_util_t *)me;
 
+#ifdef OPTIGA_UTIL_READ_CACHE_ENTRIES
+    optiga_util_read_cache_complete(p_optiga_util, event);
+#endif
     p_optiga_util->instance_state = OPTIGA_LIB_INSTANCE_FREE;
     p_optiga_util->handler(p_optiga_util->caller_context, event);
 }
@@ -151,10 +365,12 @@ _STATIC_H optiga_lib_status_t optiga_util_write_data_wrapper(optiga_util_t * me,
 
         OPTIGA_PROTECTION_ENABLE(me->my_cmd, me);
         OPTIGA_PROTECTION_SET_VERSION(me->my_cmd, me);
+        OPTIGA_UTIL_READ_CACHE_BEGIN(me, OPTIGA_UTIL_READ_CACHE_OP_INVALIDATE, optiga_oid);
 
         return_value = optiga_cmd_set_data_object(me->my_cmd, write_type, (optiga_set_data_object_params_t *)p_params);
         if (OPTIGA_LIB_SUCCESS != return_value)
         {
+            OPTIGA_UTIL_READ_CACHE_BEGIN(me, OPTIGA_UTIL_READ_CACHE_OP_NONE, 0);
             me->instance_state = OPTIGA_LIB_INSTANCE_FREE;
         }
     } while (FALSE);
@@ -202,7 +418,7 @@ optiga_util_t * optiga_util_create(uint8_t optiga_instance_id,
             break;
         }
 #endif
-        me = (optiga_util_t *)pal_os_calloc(1, sizeof(optiga_util_t));
+        me = (optiga_util_t *)optiga_lib_pool_alloc(&g_optiga_util_pool);
         if (NULL == me)
         {
             break;
@@ -218,7 +434,7 @@ optiga_util_t * optiga_util_create(uint8_t optiga_instance_id,
         me->my_cmd = optiga_cmd_create(optiga_instance_id, optiga_util_generic_event_handler, me);
         if (NULL == me->my_cmd)
         {
-            pal_os_free(me);
+            optiga_lib_pool_free(&g_optiga_util_pool, me);
             me = NULL;
         }
     } while (FALSE);
@@ -226,6 +442,11 @@ optiga_util_t * optiga_util_create(uint8_t optiga_instance_id,
     return (me);
 }
 
+void optiga_util_get_pool_stats(optiga_lib_pool_stats_t * p_stats)
+{
+    optiga_lib_pool_get_stats(&g_optiga_util_pool, p_stats);
+}
+
 optiga_lib_status_t optiga_util_destroy(optiga_util_t * me)
 {
     optiga_lib_status_t return_value;
@@ -245,7 +466,7 @@ optiga_lib_status_t optiga_util_destroy(optiga_util_t * me)
             break;
         }
         return_value = optiga_cmd_destroy(me->my_cmd);
-        pal_os_free(me);
+        optiga_lib_pool_free(&g_optiga_util_pool, me);
     } while (FALSE);
     return (return_value);
 }
@@ -373,6 +594,16 @@ optiga_lib_status_t optiga_util_read_data(optiga_util_t * me,
             break;
         }
 
+#ifdef OPTIGA_UTIL_READ_CACHE_ENTRIES
+        if (TRUE == optiga_util_read_cache_lookup(optiga_oid, offset, 0, buffer, length))
+        {
+            // Completes like a request that finished at once
+            me->handler(me->caller_context, OPTIGA_LIB_SUCCESS);
+            return_value = OPTIGA_LIB_SUCCESS;
+            break;
+        }
+#endif
+
         me->instance_state = OPTIGA_LIB_INSTANCE_BUSY;
         p_params = (optiga_get_data_object_params_t *)&(me->params.optiga_get_data_object_params);
         pal_os_memset(&me->params,0x00,sizeof(optiga_util_params_t));
@@ -389,10 +620,12 @@ optiga_lib_status_t optiga_util_read_data(optiga_util_t * me,
 
         OPTIGA_PROTECTION_ENABLE(me->my_cmd, me);
         OPTIGA_PROTECTION_SET_VERSION(me->my_cmd, me);
+        OPTIGA_UTIL_READ_CACHE_BEGIN(me, OPTIGA_UTIL_READ_CACHE_OP_FILL, 0);
 
         return_value = optiga_cmd_get_data_object(me->my_cmd, p_params->data_or_metadata, p_params);
         if (OPTIGA_LIB_SUCCESS != return_value)
         {
+            OPTIGA_UTIL_READ_CACHE_BEGIN(me, OPTIGA_UTIL_READ_CACHE_OP_NONE, 0);
             me->instance_state = OPTIGA_LIB_INSTANCE_FREE;
         }
 
@@ -427,6 +660,16 @@ optiga_lib_status_t optiga_util_read_metadata(optiga_util_t * me,
             break;
         }
 
+#ifdef OPTIGA_UTIL_READ_CACHE_ENTRIES
+        if (TRUE == optiga_util_read_cache_lookup(optiga_oid, 0, 1, buffer, length))
+        {
+            // Completes like a request that finished at once
+            me->handler(me->caller_context, OPTIGA_LIB_SUCCESS);
+            return_value = OPTIGA_LIB_SUCCESS;
+            break;
+        }
+#endif
+
         me->instance_state = OPTIGA_LIB_INSTANCE_BUSY;
         p_params = (optiga_get_data_object_params_t *)&(me->params.optiga_get_data_object_params);
         pal_os_memset(&me->params,0x00,sizeof(optiga_util_params_t));
@@ -442,11 +685,13 @@ optiga_lib_status_t optiga_util_read_metadata(optiga_util_t * me,
         p_params->last_read_size = 0;
         OPTIGA_PROTECTION_ENABLE(me->my_cmd, me);
         OPTIGA_PROTECTION_SET_VERSION(me->my_cmd, me);
+        OPTIGA_UTIL_READ_CACHE_BEGIN(me, OPTIGA_UTIL_READ_CACHE_OP_FILL, 0);
 
         return_value = optiga_cmd_get_data_object(me->my_cmd, p_params->data_or_metadata,
                                                   (optiga_get_data_object_params_t *)p_params);
         if (OPTIGA_LIB_SUCCESS != return_value)
         {
+            OPTIGA_UTIL_READ_CACHE_BEGIN(me, OPTIGA_UTIL_READ_CACHE_OP_NONE, 0);
             me->instance_state = OPTIGA_LIB_INSTANCE_FREE;
         }
     } while (FALSE);
@@ -518,11 +763,13 @@ optiga_lib_status_t optiga_util_write_metadata(optiga_util_t * me,
         p_params->written_size = 0;
         OPTIGA_PROTECTION_ENABLE(me->my_cmd, me);
         OPTIGA_PROTECTION_SET_VERSION(me->my_cmd, me);
+        OPTIGA_UTIL_READ_CACHE_BEGIN(me, OPTIGA_UTIL_READ_CACHE_OP_INVALIDATE, optiga_oid);
 
         return_value = optiga_cmd_set_data_object(me->my_cmd, p_params->write_type,
                                                   (optiga_set_data_object_params_t *)p_params);
         if (OPTIGA_LIB_SUCCESS != return_value)
         {
+            OPTIGA_UTIL_READ_CACHE_BEGIN(me, OPTIGA_UTIL_READ_CACHE_OP_NONE, 0);
             me->instance_state = OPTIGA_LIB_INSTANCE_FREE;
         }
     } while (FALSE);
@@ -562,10 +809,13 @@ _STATIC_H optiga_lib_status_t optiga_util_protected_update(optiga_util_t * me,
         p_params->p_protected_update_buffer = p_buffer;
         p_params->p_protected_update_buffer_length = buffer_length;
         p_params->set_obj_protected_tag = set_obj_tag;
+        // The target OID is in the manifest
+        OPTIGA_UTIL_READ_CACHE_BEGIN(me, OPTIGA_UTIL_READ_CACHE_OP_INVALIDATE, OPTIGA_UTIL_READ_CACHE_ALL_OIDS);
 
         return_value = optiga_cmd_set_object_protected(me->my_cmd, p_params->manifest_version,p_params);
         if (OPTIGA_LIB_SUCCESS != return_value)
         {
+            OPTIGA_UTIL_READ_CACHE_BEGIN(me, OPTIGA_UTIL_READ_CACHE_OP_NONE, 0);
             me->instance_state = OPTIGA_LIB_INSTANCE_FREE;
         }
     } while (FALSE);
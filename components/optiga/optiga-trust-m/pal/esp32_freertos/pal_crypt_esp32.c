@@ -0,0 +1,632 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2020 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file pal_crypt_esp32.c
+*
+* \brief   This file implements the AES-128 CCM and TLS PRF platform abstraction layer APIs on the ESP32
+*          AES and SHA accelerators.
+*
+* \details On ESP-IDF the mbedtls_aes_xxx functions are backed by the AES peripheral (CONFIG_MBEDTLS_HARDWARE_AES).
+*          mbedtls_ccm_xxx reaches it through the generic cipher layer, which allocates a context on every
+*          setkey and feeds the engine one block per call. Here CCM is built directly on an mbedtls_aes_context
+*          on the stack: the CBC-MAC runs as chained CBC calls over whole chunks and the payload as one CTR call,
+*          so every protected APDU costs a few accelerator sessions and no heap. The context is local to the call,
+*          since frames of two OPTIGA instances are protected from different event tasks (PAL_CRYPT_AES_CCM_ALT).
+*          The handshake PRF (PAL_CRYPT_TLS_PRF_ALT) runs HMAC-SHA256 on mbedtls_sha256_xxx, backed by the SHA
+*          peripheral (CONFIG_MBEDTLS_HARDWARE_SHA), without the heap contexts of mbedtls_md. Where the peripheral
+*          can resume a saved state (SOC_SHA_SUPPORT_RESUME) the padded key blocks are hashed once per call and
+*          every HMAC starts from a copy of those states; the ESP32 cannot load a state into the engine (a copy
+*          continues in software), so there each HMAC hashes its pad block again, still on the peripheral.
+*
+* \ingroup  grPAL
+*
+* @{
+*/
+
+#include "optiga/common/optiga_lib_common.h"
+#include "optiga/pal/pal_crypt.h"
+#include "mbedtls/platform_util.h"
+
+#ifdef PAL_CRYPT_AES_CCM_ALT
+#include "mbedtls/aes.h"
+
+#if !defined(MBEDTLS_CIPHER_MODE_CBC) || !defined(MBEDTLS_CIPHER_MODE_CTR)
+#error "pal_crypt_esp32.c needs CONFIG_MBEDTLS_CIPHER_MODE_CBC and CONFIG_MBEDTLS_CIPHER_MODE_CTR"
+#endif
+
+/// AES block size
+#define PAL_CRYPT_CCM_BLOCK_SIZE            (16U)
+/// AES-128 key length in bits
+#define PAL_CRYPT_CCM_KEY_BITS              (128U)
+/// Bytes handed to the accelerator per CBC-MAC call
+#define PAL_CRYPT_CCM_MAC_CHUNK_SIZE        (64U)
+
+/// CCM context for one encrypt/decrypt call
+typedef struct pal_crypt_ccm
+{
+    /// Key schedule of the session key
+    mbedtls_aes_context aes;
+    /// Running CBC-MAC
+    uint8_t mac[PAL_CRYPT_CCM_BLOCK_SIZE];
+    /// Counter block A0 (tag) / A1... (payload)
+    uint8_t counter[PAL_CRYPT_CCM_BLOCK_SIZE];
+    /// Discarded CBC output
+    uint8_t scratch[PAL_CRYPT_CCM_MAC_CHUNK_SIZE];
+} pal_crypt_ccm_t;
+
+// CBC-MAC over data, the last partial block is zero padded
+_STATIC_H int32_t pal_crypt_ccm_mac_update(pal_crypt_ccm_t * p_ccm,
+                                           const uint8_t * p_data,
+                                           uint32_t data_length)
+{
+    int32_t ret = 0;
+    uint32_t full_length = data_length - (data_length % PAL_CRYPT_CCM_BLOCK_SIZE);
+    uint32_t chunk;
+
+    while ((0 == ret) && (full_length > 0))
+    {
+        chunk = (full_length > PAL_CRYPT_CCM_MAC_CHUNK_SIZE) ? PAL_CRYPT_CCM_MAC_CHUNK_SIZE : full_length;
+        ret = mbedtls_aes_crypt_cbc(&p_ccm->aes, MBEDTLS_AES_ENCRYPT, chunk, p_ccm->mac, p_data, p_ccm->scratch);
+        p_data += chunk;
+        full_length -= chunk;
+        data_length -= chunk;
+    }
+
+    if ((0 == ret) && (data_length > 0))
+    {
+        memset(p_ccm->scratch, 0x00, PAL_CRYPT_CCM_BLOCK_SIZE);
+        memcpy(p_ccm->scratch, p_data, data_length);
+        ret = mbedtls_aes_crypt_cbc(&p_ccm->aes, MBEDTLS_AES_ENCRYPT, PAL_CRYPT_CCM_BLOCK_SIZE,
+                                    p_ccm->mac, p_ccm->scratch, p_ccm->scratch);
+    }
+    return (ret);
+}
+
+// Key schedule, B0 and the associated data (SP 800-38C A.2.1, A.2.2), leaves A0 in counter
+_STATIC_H int32_t pal_crypt_ccm_start(pal_crypt_ccm_t * p_ccm,
+                                      const uint8_t * p_key,
+                                      const uint8_t * p_nonce,
+                                      uint16_t nonce_length,
+                                      const uint8_t * p_associated_data,
+                                      uint16_t associated_data_length,
+                                      uint8_t mac_size,
+                                      uint16_t payload_length)
+{
+    int32_t ret = -1;
+    uint8_t length_size = (uint8_t)(15U - nonce_length);
+    uint8_t block[PAL_CRYPT_CCM_BLOCK_SIZE];
+    uint8_t index;
+    uint16_t head_length;
+
+    do
+    {
+        // Nonce 7..13 bytes, tag 4..16 bytes and even, AAD below the 2 byte length encoding limit
+        if ((nonce_length < 7U) || (nonce_length > 13U) || (mac_size < 4U) || (mac_size > 16U) ||
+            (0U != (mac_size & 0x01U)) || (associated_data_length >= 0xFF00U))
+        {
+            break;
+        }
+
+        if (0 != mbedtls_aes_setkey_enc(&p_ccm->aes, p_key, PAL_CRYPT_CCM_KEY_BITS))
+        {
+            break;
+        }
+
+        // B0: flags | nonce | payload length
+        memset(block, 0x00, sizeof(block));
+        block[0] = (uint8_t)(((associated_data_length > 0U) ? 0x40U : 0x00U) |
+                             (((mac_size - 2U) / 2U) << 3) | (length_size - 1U));
+        memcpy(&block[1], p_nonce, nonce_length);
+        block[PAL_CRYPT_CCM_BLOCK_SIZE - 1U] = (uint8_t)payload_length;
+        block[PAL_CRYPT_CCM_BLOCK_SIZE - 2U] = (uint8_t)(payload_length >> 8);
+
+        memset(p_ccm->mac, 0x00, sizeof(p_ccm->mac));
+        if (0 != mbedtls_aes_crypt_cbc(&p_ccm->aes, MBEDTLS_AES_ENCRYPT, sizeof(block), p_ccm->mac, block, block))
+        {
+            break;
+        }
+
+        if (associated_data_length > 0U)
+        {
+            // First block: 2 byte length and the start of the associated data
+            head_length = (associated_data_length > (PAL_CRYPT_CCM_BLOCK_SIZE - 2U)) ?
+                          (PAL_CRYPT_CCM_BLOCK_SIZE - 2U) : associated_data_length;
+            memset(block, 0x00, sizeof(block));
+            block[0] = (uint8_t)(associated_data_length >> 8);
+            block[1] = (uint8_t)associated_data_length;
+            memcpy(&block[2], p_associated_data, head_length);
+            if (0 != mbedtls_aes_crypt_cbc(&p_ccm->aes, MBEDTLS_AES_ENCRYPT, sizeof(block),
+                                           p_ccm->mac, block, block))
+            {
+                break;
+            }
+            if (0 != pal_crypt_ccm_mac_update(p_ccm, p_associated_data + head_length,
+                                              associated_data_length - head_length))
+            {
+                break;
+            }
+        }
+
+        // A0: flags | nonce | counter 0
+        memset(p_ccm->counter, 0x00, sizeof(p_ccm->counter));
+        p_ccm->counter[0] = (uint8_t)(length_size - 1U);
+        for (index = 0; index < nonce_length; index++)
+        {
+            p_ccm->counter[1U + index] = p_nonce[index];
+        }
+        ret = 0;
+    } while (FALSE);
+
+    mbedtls_platform_zeroize(block, sizeof(block));
+    return (ret);
+}
+
+// CTR over the payload starting at A1, in place allowed
+_STATIC_H int32_t pal_crypt_ccm_ctr(pal_crypt_ccm_t * p_ccm,
+                                    const uint8_t * p_input,
+                                    uint16_t length,
+                                    uint8_t * p_output)
+{
+    uint8_t stream_block[PAL_CRYPT_CCM_BLOCK_SIZE];
+    uint8_t nonce_counter[PAL_CRYPT_CCM_BLOCK_SIZE];
+    size_t offset = 0;
+    int32_t ret;
+
+    memcpy(nonce_counter, p_ccm->counter, sizeof(nonce_counter));
+    nonce_counter[PAL_CRYPT_CCM_BLOCK_SIZE - 1U] = 0x01;
+    ret = mbedtls_aes_crypt_ctr(&p_ccm->aes, length, &offset, nonce_counter, stream_block, p_input, p_output);
+
+    mbedtls_platform_zeroize(stream_block, sizeof(stream_block));
+    return (ret);
+}
+
+// Tag = MAC xor E(A0), written to p_tag
+_STATIC_H int32_t pal_crypt_ccm_tag(pal_crypt_ccm_t * p_ccm, uint8_t mac_size, uint8_t * p_tag)
+{
+    uint8_t s0[PAL_CRYPT_CCM_BLOCK_SIZE];
+    uint8_t index;
+    int32_t ret;
+
+    ret = mbedtls_aes_crypt_ecb(&p_ccm->aes, MBEDTLS_AES_ENCRYPT, p_ccm->counter, s0);
+    for (index = 0; index < mac_size; index++)
+    {
+        p_tag[index] = p_ccm->mac[index] ^ s0[index];
+    }
+    mbedtls_platform_zeroize(s0, sizeof(s0));
+    return (ret);
+}
+
+_STATIC_H void pal_crypt_ccm_free(pal_crypt_ccm_t * p_ccm)
+{
+    mbedtls_aes_free(&p_ccm->aes);
+    mbedtls_platform_zeroize(p_ccm, sizeof(*p_ccm));
+}
+
+//lint --e{818, 715, 830} suppress "argument "p_pal_crypt" is not used in the implementation but kept for future use"
+pal_status_t pal_crypt_encrypt_aes128_ccm(pal_crypt_t* p_pal_crypt,
+                                          const uint8_t * p_plain_text,
+                                          uint16_t plain_text_length,
+                                          const uint8_t * p_encrypt_key,
+                                          const uint8_t * p_nonce,
+                                          uint16_t nonce_length,
+                                          const uint8_t * p_associated_data,
+                                          uint16_t associated_data_length,
+                                          uint8_t mac_size,
+                                          uint8_t * p_cipher_text)
+{
+    pal_status_t return_status = PAL_STATUS_FAILURE;
+    pal_crypt_ccm_t ccm;
+
+    mbedtls_aes_init(&ccm.aes);
+
+    do
+    {
+#ifdef OPTIGA_LIB_DEBUG_NULL_CHECK
+        if ((NULL == p_cipher_text) || (NULL == p_plain_text) ||
+            (NULL == p_nonce) || (NULL == p_associated_data) || (NULL == p_encrypt_key))
+        {
+            break;
+        }
+#endif
+
+        if (0 != pal_crypt_ccm_start(&ccm, p_encrypt_key, p_nonce, nonce_length,
+                                     p_associated_data, associated_data_length, mac_size, plain_text_length))
+        {
+            break;
+        }
+
+        // MAC the plain text before CTR overwrites it (the presentation layer encrypts in place)
+        if (0 != pal_crypt_ccm_mac_update(&ccm, p_plain_text, plain_text_length))
+        {
+            break;
+        }
+
+        if (0 != pal_crypt_ccm_ctr(&ccm, p_plain_text, plain_text_length, p_cipher_text))
+        {
+            break;
+        }
+
+        if (0 != pal_crypt_ccm_tag(&ccm, mac_size, p_cipher_text + plain_text_length))
+        {
+            break;
+        }
+        return_status = PAL_STATUS_SUCCESS;
+    } while (FALSE);
+
+    pal_crypt_ccm_free(&ccm);
+    return return_status;
+}
+
+//lint --e{818, 715, 830} suppress "argument "p_pal_crypt" is not used in the implementation but kept for future use"
+pal_status_t pal_crypt_decrypt_aes128_ccm(pal_crypt_t* p_pal_crypt,
+                                          const uint8_t * p_cipher_text,
+                                          uint16_t cipher_text_length,
+                                          const uint8_t * p_decrypt_key,
+                                          const uint8_t * p_nonce,
+                                          uint16_t nonce_length,
+                                          const uint8_t * p_associated_data,
+                                          uint16_t associated_data_length,
+                                          uint8_t mac_size,
+                                          uint8_t * p_plain_text)
+{
+    pal_status_t return_status = PAL_STATUS_FAILURE;
+    pal_crypt_ccm_t ccm;
+    uint8_t tag[PAL_CRYPT_CCM_BLOCK_SIZE];
+    uint8_t difference = 0;
+    uint16_t plain_text_length;
+    uint8_t index;
+
+    mbedtls_aes_init(&ccm.aes);
+
+    do
+    {
+#ifdef OPTIGA_LIB_DEBUG_NULL_CHECK
+        if ((NULL == p_plain_text) || (NULL == p_cipher_text) ||
+            (NULL == p_nonce) || (NULL == p_associated_data) || (NULL == p_decrypt_key))
+        {
+            break;
+        }
+#endif
+
+        if (cipher_text_length < mac_size)
+        {
+            break;
+        }
+        plain_text_length = cipher_text_length - mac_size;
+
+        if (0 != pal_crypt_ccm_start(&ccm, p_decrypt_key, p_nonce, nonce_length,
+                                     p_associated_data, associated_data_length, mac_size, plain_text_length))
+        {
+            break;
+        }
+
+        if (0 != pal_crypt_ccm_ctr(&ccm, p_cipher_text, plain_text_length, p_plain_text))
+        {
+            break;
+        }
+
+        if ((0 != pal_crypt_ccm_mac_update(&ccm, p_plain_text, plain_text_length)) ||
+            (0 != pal_crypt_ccm_tag(&ccm, mac_size, tag)))
+        {
+            memset(p_plain_text, 0x00, plain_text_length);
+            break;
+        }
+
+        // Constant time compare, a forged frame must not release its plain text
+        for (index = 0; index < mac_size; index++)
+        {
+            difference |= (uint8_t)(tag[index] ^ p_cipher_text[plain_text_length + index]);
+        }
+        if (0U != difference)
+        {
+            memset(p_plain_text, 0x00, plain_text_length);
+            break;
+        }
+        return_status = PAL_STATUS_SUCCESS;
+    } while (FALSE);
+
+    pal_crypt_ccm_free(&ccm);
+    mbedtls_platform_zeroize(tag, sizeof(tag));
+    return return_status;
+}
+
+#undef PAL_CRYPT_CCM_BLOCK_SIZE
+#undef PAL_CRYPT_CCM_KEY_BITS
+#undef PAL_CRYPT_CCM_MAC_CHUNK_SIZE
+#endif //PAL_CRYPT_AES_CCM_ALT
+
+#ifdef PAL_CRYPT_TLS_PRF_ALT
+#include "mbedtls/sha256.h"
+#include "soc/soc_caps.h"
+#include "optiga/pal/pal_crypt_esp32.h"
+
+/// SHA-256 block size, HMAC pad length
+#define PAL_CRYPT_PRF_BLOCK_SIZE            (64U)
+/// SHA-256 digest size
+#define PAL_CRYPT_PRF_DIGEST_SIZE           (32U)
+/// Longest label || seed, as in pal_crypt_mbedtls.c
+#define PAL_CRYPT_PRF_MAX_LABEL_SEED_LENGTH (96U)
+
+/// HMAC-SHA256 keyed once per PRF call
+typedef struct pal_crypt_prf_hmac
+{
+#if SOC_SHA_SUPPORT_RESUME
+    /// State after the inner padded key block
+    mbedtls_sha256_context inner;
+    /// State after the outer padded key block
+    mbedtls_sha256_context outer;
+#else
+    /// Key xor ipad
+    uint8_t ipad[PAL_CRYPT_PRF_BLOCK_SIZE];
+    /// Key xor opad
+    uint8_t opad[PAL_CRYPT_PRF_BLOCK_SIZE];
+#endif
+    /// Hash of the running HMAC
+    mbedtls_sha256_context work;
+    /// Inner digest
+    uint8_t digest[PAL_CRYPT_PRF_DIGEST_SIZE];
+} pal_crypt_prf_hmac_t;
+
+static volatile pal_crypt_prf_backend_t pal_crypt_prf_backend = PAL_CRYPT_PRF_BACKEND_SHA_HW;
+
+// Runs one hash from the start, or from a copy of a keyed state
+_STATIC_H int32_t pal_crypt_prf_hash_start(pal_crypt_prf_hmac_t * p_hmac,
+                                           const mbedtls_sha256_context * p_state,
+                                           const uint8_t * p_pad)
+{
+#if SOC_SHA_SUPPORT_RESUME
+    (void)p_pad;
+    mbedtls_sha256_clone(&p_hmac->work, p_state);
+    return (0);
+#else
+    int32_t ret = mbedtls_sha256_starts(&p_hmac->work, 0);
+
+    (void)p_state;
+    if (0 == ret)
+    {
+        ret = mbedtls_sha256_update(&p_hmac->work, p_pad, PAL_CRYPT_PRF_BLOCK_SIZE);
+    }
+    return (ret);
+#endif
+}
+
+// Key xor ipad / opad (RFC 2104), hashed into the keyed states where the engine can resume them
+_STATIC_H int32_t pal_crypt_prf_hmac_setup(pal_crypt_prf_hmac_t * p_hmac,
+                                           const uint8_t * p_key,
+                                           uint16_t key_length)
+{
+    uint8_t ipad[PAL_CRYPT_PRF_BLOCK_SIZE];
+    uint8_t opad[PAL_CRYPT_PRF_BLOCK_SIZE];
+    uint8_t key_digest[PAL_CRYPT_PRF_DIGEST_SIZE];
+    uint16_t index;
+    int32_t ret = 0;
+
+    if (key_length > PAL_CRYPT_PRF_BLOCK_SIZE)
+    {
+        ret = mbedtls_sha256(p_key, key_length, key_digest, 0);
+        p_key = key_digest;
+        key_length = PAL_CRYPT_PRF_DIGEST_SIZE;
+    }
+    memset(ipad, 0x36, sizeof(ipad));
+    memset(opad, 0x5C, sizeof(opad));
+    for (index = 0; index < key_length; index++)
+    {
+        ipad[index] ^= p_key[index];
+        opad[index] ^= p_key[index];
+    }
+
+#if SOC_SHA_SUPPORT_RESUME
+    if (0 == ret)
+    {
+        ret = mbedtls_sha256_starts(&p_hmac->inner, 0);
+    }
+    if (0 == ret)
+    {
+        ret = mbedtls_sha256_update(&p_hmac->inner, ipad, sizeof(ipad));
+    }
+    if (0 == ret)
+    {
+        ret = mbedtls_sha256_starts(&p_hmac->outer, 0);
+    }
+    if (0 == ret)
+    {
+        ret = mbedtls_sha256_update(&p_hmac->outer, opad, sizeof(opad));
+    }
+#else
+    memcpy(p_hmac->ipad, ipad, sizeof(ipad));
+    memcpy(p_hmac->opad, opad, sizeof(opad));
+#endif
+
+    mbedtls_platform_zeroize(ipad, sizeof(ipad));
+    mbedtls_platform_zeroize(opad, sizeof(opad));
+    mbedtls_platform_zeroize(key_digest, sizeof(key_digest));
+    return (ret);
+}
+
+// HMAC(key, data) into p_mac (PAL_CRYPT_PRF_DIGEST_SIZE bytes)
+_STATIC_H int32_t pal_crypt_prf_hmac(pal_crypt_prf_hmac_t * p_hmac,
+                                     const uint8_t * p_data,
+                                     uint16_t data_length,
+                                     uint8_t * p_mac)
+{
+#if SOC_SHA_SUPPORT_RESUME
+    const mbedtls_sha256_context * p_inner = &p_hmac->inner;
+    const mbedtls_sha256_context * p_outer = &p_hmac->outer;
+    const uint8_t * p_ipad = NULL;
+    const uint8_t * p_opad = NULL;
+#else
+    const mbedtls_sha256_context * p_inner = NULL;
+    const mbedtls_sha256_context * p_outer = NULL;
+    const uint8_t * p_ipad = p_hmac->ipad;
+    const uint8_t * p_opad = p_hmac->opad;
+#endif
+    int32_t ret = pal_crypt_prf_hash_start(p_hmac, p_inner, p_ipad);
+
+    if (0 == ret)
+    {
+        ret = mbedtls_sha256_update(&p_hmac->work, p_data, data_length);
+    }
+    if (0 == ret)
+    {
+        ret = mbedtls_sha256_finish(&p_hmac->work, p_hmac->digest);
+    }
+    if (0 == ret)
+    {
+        ret = pal_crypt_prf_hash_start(p_hmac, p_outer, p_opad);
+    }
+    if (0 == ret)
+    {
+        ret = mbedtls_sha256_update(&p_hmac->work, p_hmac->digest, sizeof(p_hmac->digest));
+    }
+    if (0 == ret)
+    {
+        ret = mbedtls_sha256_finish(&p_hmac->work, p_mac);
+    }
+    return (ret);
+}
+
+_STATIC_H void pal_crypt_prf_hmac_init(pal_crypt_prf_hmac_t * p_hmac)
+{
+#if SOC_SHA_SUPPORT_RESUME
+    mbedtls_sha256_init(&p_hmac->inner);
+    mbedtls_sha256_init(&p_hmac->outer);
+#endif
+    mbedtls_sha256_init(&p_hmac->work);
+}
+
+_STATIC_H void pal_crypt_prf_hmac_free(pal_crypt_prf_hmac_t * p_hmac)
+{
+#if SOC_SHA_SUPPORT_RESUME
+    mbedtls_sha256_free(&p_hmac->inner);
+    mbedtls_sha256_free(&p_hmac->outer);
+#endif
+    mbedtls_sha256_free(&p_hmac->work);
+    mbedtls_platform_zeroize(p_hmac, sizeof(*p_hmac));
+}
+
+void pal_crypt_set_prf_backend(pal_crypt_prf_backend_t backend)
+{
+    pal_crypt_prf_backend = backend;
+}
+
+// P_SHA256 (RFC 5246 section 5): A(i) = HMAC(secret, A(i-1)), output HMAC(secret, A(i) || label || seed)
+//lint --e{818, 715, 830} suppress "argument "p_pal_crypt" is not used in the implementation but kept for future use"
+pal_status_t pal_crypt_tls_prf_sha256(pal_crypt_t* p_pal_crypt,
+                                      const uint8_t * p_secret,
+                                      uint16_t secret_length,
+                                      const uint8_t * p_label,
+                                      uint16_t label_length,
+                                      const uint8_t * p_seed,
+                                      uint16_t seed_length,
+                                      uint8_t * p_derived_key,
+                                      uint16_t derived_key_length)
+{
+    pal_status_t return_value = PAL_STATUS_FAILURE;
+    pal_crypt_prf_hmac_t hmac;
+    // A(i) || label || seed, A(i) is replaced in place
+    uint8_t a_label_seed[PAL_CRYPT_PRF_DIGEST_SIZE + PAL_CRYPT_PRF_MAX_LABEL_SEED_LENGTH];
+    uint8_t block[PAL_CRYPT_PRF_DIGEST_SIZE];
+    uint16_t label_seed_length = label_length + seed_length;
+    uint16_t done;
+    uint16_t part;
+
+    if (PAL_CRYPT_PRF_BACKEND_MD == pal_crypt_prf_backend)
+    {
+        return (pal_crypt_tls_prf_sha256_md(p_pal_crypt, p_secret, secret_length, p_label, label_length,
+                                            p_seed, seed_length, p_derived_key, derived_key_length));
+    }
+
+    pal_crypt_prf_hmac_init(&hmac);
+
+    do
+    {
+#ifdef OPTIGA_LIB_DEBUG_NULL_CHECK
+        if ((NULL == p_secret) || (NULL == p_label) || (NULL == p_seed) || (NULL == p_derived_key))
+        {
+            break;
+        }
+#endif
+
+        if (label_seed_length > PAL_CRYPT_PRF_MAX_LABEL_SEED_LENGTH)
+        {
+            return_value = PAL_STATUS_INVALID_INPUT;
+            break;
+        }
+        memcpy(a_label_seed + PAL_CRYPT_PRF_DIGEST_SIZE, p_label, label_length);
+        memcpy(a_label_seed + PAL_CRYPT_PRF_DIGEST_SIZE + label_length, p_seed, seed_length);
+
+        if (0 != pal_crypt_prf_hmac_setup(&hmac, p_secret, secret_length))
+        {
+            break;
+        }
+
+        // A(1)
+        if (0 != pal_crypt_prf_hmac(&hmac, a_label_seed + PAL_CRYPT_PRF_DIGEST_SIZE, label_seed_length,
+                                    a_label_seed))
+        {
+            break;
+        }
+
+        for (done = 0; done < derived_key_length; done += part)
+        {
+            if (0 != pal_crypt_prf_hmac(&hmac, a_label_seed, PAL_CRYPT_PRF_DIGEST_SIZE + label_seed_length,
+                                        block))
+            {
+                break;
+            }
+            part = ((derived_key_length - done) < PAL_CRYPT_PRF_DIGEST_SIZE) ?
+                   (derived_key_length - done) : PAL_CRYPT_PRF_DIGEST_SIZE;
+            memcpy(p_derived_key + done, block, part);
+
+            // A(i + 1), not needed after the last block
+            if (((done + part) < derived_key_length) &&
+                (0 != pal_crypt_prf_hmac(&hmac, a_label_seed, PAL_CRYPT_PRF_DIGEST_SIZE, a_label_seed)))
+            {
+                break;
+            }
+        }
+        if (done >= derived_key_length)
+        {
+            return_value = PAL_STATUS_SUCCESS;
+        }
+    } while (FALSE);
+
+    pal_crypt_prf_hmac_free(&hmac);
+    mbedtls_platform_zeroize(a_label_seed, sizeof(a_label_seed));
+    mbedtls_platform_zeroize(block, sizeof(block));
+    return (return_value);
+}
+
+#undef PAL_CRYPT_PRF_BLOCK_SIZE
+#undef PAL_CRYPT_PRF_DIGEST_SIZE
+#undef PAL_CRYPT_PRF_MAX_LABEL_SEED_LENGTH
+#endif //PAL_CRYPT_TLS_PRF_ALT
+
+/**
+* @}
+*/
@@ -44,8 +44,9 @@ pal_status_t pal_gpio_init(const pal_gpio_t * p_gpio_context)
 {
 	if ((p_gpio_context != NULL) && (p_gpio_context->p_gpio_hw != NULL))
     {
-		gpio_set_direction((gpio_num_t)p_gpio_context->p_gpio_hw, GPIO_MODE_OUTPUT);
+		//Level first: the output must not glitch low, it would power down or reset a warm OPTIGA
 		gpio_set_level((gpio_num_t)p_gpio_context->p_gpio_hw, 1);
+		gpio_set_direction((gpio_num_t)p_gpio_context->p_gpio_hw, GPIO_MODE_OUTPUT);
 	}
 	
     return PAL_STATUS_SUCCESS;
@@ -37,28 +37,34 @@
 
 
 #include "optiga/pal/pal_i2c.h"
-#include "driver/i2c.h"
+#include "optiga/pal/pal_i2c_capture.h"
+#include "optiga/pal/pal_sysview.h"
+#include "optiga/pal/pal_os_diag.h"
+#include "pal_i2c_esp32.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#ifdef PAL_I2C_PM_LOCK
+#include "freertos/FreeRTOS.h"
+#include "driver/gpio.h"
+#include "esp_pm.h"
+#include "soc/soc_caps.h"
+#endif
 
 #define PAL_I2C_MASTER_TX_BUF_DISABLE   0                /*!< I2C master do not need buffer */
 #define PAL_I2C_MASTER_RX_BUF_DISABLE   0                /*!< I2C master do not need buffer */
 
 #define CONFIG_PAL_I2C_INIT_ENABLE 1
 
+#if !PAL_I2C_MASTER_BUS_API
 #define WRITE_BIT                       I2C_MASTER_WRITE /*!< I2C master write */
 #define READ_BIT                        I2C_MASTER_READ  /*!< I2C master read */
 #define ACK_CHECK_EN                    0x1              /*!< I2C master will check ack from slave*/
 #define ACK_CHECK_DIS                   0x0              /*!< I2C master will not check ack from slave */
 #define ACK_VAL                         0x0              /*!< I2C ack value */
 #define NACK_VAL                        0x1              /*!< I2C nack value */
+#endif
 
 /// @cond hidden
-typedef struct esp32_i2c_ctx {
-	uint8_t  port;
-	uint8_t	 scl_io;
-	uint8_t	 sda_io;
-	uint32_t bitrate;
-}esp32_i2c_ctx_t;
 
 /* Varibale to indicate the re-entrant count of the i2c bus acquire function*/
 static volatile uint32_t g_entry_count = 0;
@@ -66,8 +72,213 @@ static volatile uint32_t g_entry_count = 0;
 /* Pointer to the current pal i2c context*/
 static pal_i2c_t * gp_pal_i2c_current_ctx;
 
+#ifdef PAL_I2C_PM_LOCK
+/* Holds the clocks at maximum and light sleep off for one transfer. Between transfers (OPTIGA
+   executing a command, polling delays) the chip scales down and may sleep, the event timers
+   wake it */
+static esp_pm_lock_handle_t g_pm_lock = NULL;
+static portMUX_TYPE g_pm_mux = portMUX_INITIALIZER_UNLOCKED;
+static pal_i2c_pm_stats_t g_pm_stats;
+#endif
+
 /// @endcond
 
+/// @cond hidden
+#ifdef PAL_I2C_PM_LOCK
+static int64_t pal_i2c_pm_acquire(void)
+{
+	if (g_pm_lock != NULL)
+		(void)esp_pm_lock_acquire(g_pm_lock);
+	return esp_timer_get_time();
+}
+
+static void pal_i2c_pm_release(int64_t start_us)
+{
+	const int64_t held_us = esp_timer_get_time() - start_us;
+
+	if (g_pm_lock != NULL)
+		(void)esp_pm_lock_release(g_pm_lock);
+	portENTER_CRITICAL(&g_pm_mux);
+	g_pm_stats.transfers++;
+	g_pm_stats.held_us += (uint64_t)held_us;
+	portEXIT_CRITICAL(&g_pm_mux);
+}
+
+/* Light sleep must not switch the bus pins to their sleep configuration: the pull-ups keep
+   SDA and SCL idle high while the chip sleeps between transfers */
+static void pal_i2c_pm_init(const esp32_i2c_ctx_t * master_ctx)
+{
+	if (g_pm_lock == NULL)
+		(void)esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "pal_i2c", &g_pm_lock);
+#if SOC_GPIO_SUPPORT_SLP_SWITCH
+	(void)gpio_sleep_sel_dis(master_ctx->sda_io);
+	(void)gpio_sleep_sel_dis(master_ctx->scl_io);
+#endif
+}
+
+#define PAL_I2C_PM_INIT(ctx)    pal_i2c_pm_init(ctx)
+#define PAL_I2C_PM_ACQUIRE()    const int64_t pm_start_us = pal_i2c_pm_acquire()
+#define PAL_I2C_PM_RELEASE()    pal_i2c_pm_release(pm_start_us)
+#else
+#define PAL_I2C_PM_INIT(ctx)
+#define PAL_I2C_PM_ACQUIRE()
+#define PAL_I2C_PM_RELEASE()
+#endif
+/// @endcond
+
+/// @cond hidden
+/* Reports the transfer result to the registered upper layer handler */
+static pal_status_t pal_i2c_complete(const pal_i2c_t * p_i2c_context, esp_err_t ret)
+{
+	upper_layer_callback_t upper_layer_handler;
+
+	upper_layer_handler = (upper_layer_callback_t)p_i2c_context->upper_layer_event_handler;
+
+	if (ret == ESP_OK) {
+		upper_layer_handler(p_i2c_context->p_upper_layer_ctx, PAL_I2C_EVENT_SUCCESS);
+		return PAL_STATUS_SUCCESS;
+	}
+
+	upper_layer_handler(p_i2c_context->p_upper_layer_ctx, PAL_I2C_EVENT_ERROR);
+	return PAL_STATUS_FAILURE;
+}
+/// @endcond
+
+#if PAL_I2C_MASTER_BUS_API
+
+pal_status_t pal_i2c_init(const pal_i2c_t* p_i2c_context)
+{
+	esp32_i2c_ctx_t* master_ctx;
+
+	ESP_LOGI("pal_i2c", "Initialize pal_i2c_init  ");
+
+	if ((p_i2c_context == NULL) || (p_i2c_context->p_i2c_hw_config == NULL))
+		return PAL_STATUS_FAILURE;
+
+	master_ctx = (esp32_i2c_ctx_t*)p_i2c_context->p_i2c_hw_config;
+
+	// Bus and device survive an OPTIGA reset, only (re)create what is missing
+	if (master_ctx->bus == NULL) {
+		i2c_master_bus_config_t bus_conf = {
+			.i2c_port = master_ctx->port,
+			.sda_io_num = master_ctx->sda_io,
+			.scl_io_num = master_ctx->scl_io,
+			.clk_source = I2C_CLK_SRC_DEFAULT,
+			.glitch_ignore_cnt = 7,
+			.flags.enable_internal_pullup = true,
+		};
+		if (i2c_new_master_bus(&bus_conf, &master_ctx->bus) != ESP_OK) {
+			master_ctx->bus = NULL;
+			return PAL_STATUS_FAILURE;
+		}
+	}
+
+	if (master_ctx->dev == NULL) {
+		i2c_device_config_t dev_conf = {
+			.dev_addr_length = I2C_ADDR_BIT_LEN_7,
+			.device_address = p_i2c_context->slave_address,
+			.scl_speed_hz = master_ctx->bitrate,
+		};
+		if (i2c_master_bus_add_device(master_ctx->bus, &dev_conf, &master_ctx->dev) != ESP_OK) {
+			master_ctx->dev = NULL;
+			return PAL_STATUS_FAILURE;
+		}
+	}
+
+	PAL_I2C_PM_INIT(master_ctx);
+	ESP_LOGI("pal_i2c", "init successful");
+	// A comms open starts here, replays of the capture begin at this record
+	PAL_I2C_CAPTURE(p_i2c_context, PAL_I2C_CAPTURE_INIT, (uint32_t)esp_timer_get_time(), NULL, 0, 0);
+
+	return PAL_STATUS_SUCCESS;
+}
+
+pal_status_t pal_i2c_deinit(const pal_i2c_t* p_i2c_context)
+{
+	esp32_i2c_ctx_t* master_ctx;
+
+	if ((p_i2c_context == NULL) || (p_i2c_context->p_i2c_hw_config == NULL))
+		return PAL_STATUS_FAILURE;
+
+	master_ctx = (esp32_i2c_ctx_t*)p_i2c_context->p_i2c_hw_config;
+
+	if (master_ctx->dev != NULL) {
+		i2c_master_bus_rm_device(master_ctx->dev);
+		master_ctx->dev = NULL;
+	}
+	if (master_ctx->bus != NULL) {
+		i2c_del_master_bus(master_ctx->bus);
+		master_ctx->bus = NULL;
+	}
+
+	return PAL_STATUS_SUCCESS;
+}
+
+/*
+ * Transfers are issued synchronously on the pre-created device handle: the driver blocks the
+ * calling task on its own semaphore until the ISR completes the frame, no heap is touched.
+ * The upper layer handler is not run from the driver ISR because it re-enters the PAL
+ * (next read, event timer) with calls that are not ISR safe.
+ */
+pal_status_t pal_i2c_write(const pal_i2c_t * p_i2c_context, uint8_t * p_data, uint16_t length)
+{
+	esp32_i2c_ctx_t* master_ctx;
+	esp_err_t ret;
+
+	gp_pal_i2c_current_ctx = (pal_i2c_t *) p_i2c_context;
+
+	if ((p_i2c_context == NULL) || (p_i2c_context->p_i2c_hw_config == NULL))
+		return PAL_STATUS_FAILURE;
+
+	master_ctx = (esp32_i2c_ctx_t*)p_i2c_context->p_i2c_hw_config;
+	if (master_ctx->dev == NULL)
+		return PAL_STATUS_FAILURE;
+
+#ifdef PAL_I2C_CAPTURE_ENABLED
+	const uint32_t start_us = (uint32_t)esp_timer_get_time();
+#endif
+	PAL_SYSVIEW_START(PAL_SYSVIEW_MARK_I2C_WRITE);
+	PAL_I2C_PM_ACQUIRE();
+	ret = i2c_master_transmit(master_ctx->dev, p_data, length, PAL_I2C_TRANSFER_TIMEOUT_MS);
+	PAL_I2C_PM_RELEASE();
+	PAL_SYSVIEW_STOP(PAL_SYSVIEW_MARK_I2C_WRITE);
+	// Recorded before the handler runs, it may start the next transfer
+	PAL_I2C_CAPTURE(p_i2c_context, PAL_I2C_CAPTURE_WRITE, start_us, p_data, length, ret != ESP_OK);
+
+	return pal_i2c_complete(p_i2c_context, ret);
+}
+
+pal_status_t pal_i2c_read(const pal_i2c_t * p_i2c_context, uint8_t * p_data, uint16_t length)
+{
+	esp32_i2c_ctx_t* master_ctx;
+	esp_err_t ret;
+
+	gp_pal_i2c_current_ctx = (pal_i2c_t *)p_i2c_context;
+
+	if (length == 0)
+		return PAL_STATUS_FAILURE;
+
+	if ((p_i2c_context == NULL) || (p_i2c_context->p_i2c_hw_config == NULL))
+		return PAL_STATUS_FAILURE;
+
+	master_ctx = (esp32_i2c_ctx_t*)p_i2c_context->p_i2c_hw_config;
+	if (master_ctx->dev == NULL)
+		return PAL_STATUS_FAILURE;
+
+#ifdef PAL_I2C_CAPTURE_ENABLED
+	const uint32_t start_us = (uint32_t)esp_timer_get_time();
+#endif
+	PAL_SYSVIEW_START(PAL_SYSVIEW_MARK_I2C_READ);
+	PAL_I2C_PM_ACQUIRE();
+	ret = i2c_master_receive(master_ctx->dev, p_data, length, PAL_I2C_TRANSFER_TIMEOUT_MS);
+	PAL_I2C_PM_RELEASE();
+	PAL_SYSVIEW_STOP(PAL_SYSVIEW_MARK_I2C_READ);
+	PAL_I2C_CAPTURE(p_i2c_context, PAL_I2C_CAPTURE_READ, start_us, p_data, length, ret != ESP_OK);
+
+	return pal_i2c_complete(p_i2c_context, ret);
+}
+
+#else // PAL_I2C_MASTER_BUS_API
 
 pal_status_t pal_i2c_init(const pal_i2c_t* p_i2c_context)
 {
@@ -96,7 +307,9 @@ pal_status_t pal_i2c_init(const pal_i2c_t* p_i2c_context)
                        PAL_I2C_MASTER_TX_BUF_DISABLE,
                        PAL_I2C_MASTER_RX_BUF_DISABLE, 0);
 	
+    PAL_I2C_PM_INIT(master_ctx);
     ESP_LOGI("pal_i2c", "init successful");
+    PAL_I2C_CAPTURE(p_i2c_context, PAL_I2C_CAPTURE_INIT, (uint32_t)esp_timer_get_time(), NULL, 0, 0);
 #endif
 
     return PAL_STATUS_SUCCESS;
@@ -120,60 +333,56 @@ pal_status_t pal_i2c_deinit(const pal_i2c_t* p_i2c_context)
 
 pal_status_t pal_i2c_write(const pal_i2c_t * p_i2c_context, uint8_t * p_data, uint16_t length)
 {
-    pal_status_t status = PAL_STATUS_FAILURE;
-	upper_layer_callback_t upper_layer_handler;
 	int i2c_master_port;
 	esp32_i2c_ctx_t* master_ctx;
 
 	gp_pal_i2c_current_ctx = (pal_i2c_t *) p_i2c_context;
 
 	if ((p_i2c_context == NULL) || (p_i2c_context->p_i2c_hw_config == NULL))
-		return status;
+		return PAL_STATUS_FAILURE;
 
 	master_ctx = (esp32_i2c_ctx_t*)p_i2c_context->p_i2c_hw_config;
 	i2c_master_port = master_ctx->port;
 
+#ifdef PAL_I2C_CAPTURE_ENABLED
+	const uint32_t start_us = (uint32_t)esp_timer_get_time();
+#endif
 	i2c_cmd_handle_t cmd = i2c_cmd_link_create();
 
     i2c_master_start(cmd);
     i2c_master_write_byte(cmd, (p_i2c_context->slave_address << 1) | WRITE_BIT, ACK_CHECK_EN);
     i2c_master_write(cmd, p_data, length, ACK_CHECK_EN);
     i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(i2c_master_port, cmd, 1000 / portTICK_PERIOD_MS);
+    PAL_SYSVIEW_START(PAL_SYSVIEW_MARK_I2C_WRITE);
+    PAL_I2C_PM_ACQUIRE();
+    esp_err_t ret = i2c_master_cmd_begin(i2c_master_port, cmd, pdMS_TO_TICKS(PAL_I2C_TRANSFER_TIMEOUT_MS));
+    PAL_I2C_PM_RELEASE();
+    PAL_SYSVIEW_STOP(PAL_SYSVIEW_MARK_I2C_WRITE);
     i2c_cmd_link_delete(cmd);
+    PAL_I2C_CAPTURE(p_i2c_context, PAL_I2C_CAPTURE_WRITE, start_us, p_data, length, ret != ESP_OK);
 
-	upper_layer_handler = (upper_layer_callback_t)p_i2c_context->upper_layer_event_handler;
-
-	if (ret == ESP_OK) {
-        //ESP_LOG_BUFFER_HEX("pal_i2c : W:", p_data, length);
-		upper_layer_handler(p_i2c_context->p_upper_layer_ctx, PAL_I2C_EVENT_SUCCESS);
-		status = PAL_STATUS_SUCCESS;
-	} else {
-        //ESP_LOGI("pal_i2c", "W-Failure");
-        upper_layer_handler(p_i2c_context->p_upper_layer_ctx , PAL_I2C_EVENT_ERROR);
-	}
-
-    return status;
+    return pal_i2c_complete(p_i2c_context, ret);
 }
 
 pal_status_t pal_i2c_read(const pal_i2c_t * p_i2c_context, uint8_t * p_data, uint16_t length)
 {
-    pal_status_t status = PAL_STATUS_FAILURE;
-    upper_layer_callback_t upper_layer_handler;
 	int i2c_master_port;
 	esp32_i2c_ctx_t* master_ctx;
 
 	gp_pal_i2c_current_ctx = (pal_i2c_t *)p_i2c_context;
 
 	if (length == 0)
-        return status;
+        return PAL_STATUS_FAILURE;
 	
 	if ((p_i2c_context == NULL) || (p_i2c_context->p_i2c_hw_config == NULL))
-		return status;
+		return PAL_STATUS_FAILURE;
 
 	master_ctx = (esp32_i2c_ctx_t*)p_i2c_context->p_i2c_hw_config;
 	i2c_master_port = master_ctx->port;
 	
+#ifdef PAL_I2C_CAPTURE_ENABLED
+    const uint32_t start_us = (uint32_t)esp_timer_get_time();
+#endif
     i2c_cmd_handle_t cmd = i2c_cmd_link_create();
     i2c_master_start(cmd);
     i2c_master_write_byte(cmd, ( p_i2c_context->slave_address << 1 ) | READ_BIT, ACK_CHECK_EN);
@@ -182,28 +391,98 @@ pal_status_t pal_i2c_read(const pal_i2c_t * p_i2c_context, uint8_t * p_data, uin
     }
     i2c_master_read_byte(cmd, p_data + length - 1, NACK_VAL);
     i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(i2c_master_port, cmd, 1000 / portTICK_PERIOD_MS);
+    PAL_SYSVIEW_START(PAL_SYSVIEW_MARK_I2C_READ);
+    PAL_I2C_PM_ACQUIRE();
+    esp_err_t ret = i2c_master_cmd_begin(i2c_master_port, cmd, pdMS_TO_TICKS(PAL_I2C_TRANSFER_TIMEOUT_MS));
+    PAL_I2C_PM_RELEASE();
+    PAL_SYSVIEW_STOP(PAL_SYSVIEW_MARK_I2C_READ);
     i2c_cmd_link_delete(cmd);
-	
-    upper_layer_handler = (upper_layer_callback_t)p_i2c_context->upper_layer_event_handler;
-	
-	if (ret == ESP_OK) {
-        //ESP_LOG_BUFFER_HEX("pal_i2c : R:", p_data, length);
-		upper_layer_handler(p_i2c_context->p_upper_layer_ctx , PAL_I2C_EVENT_SUCCESS);
-		status = PAL_STATUS_SUCCESS;
-	} else {
-        //ESP_LOGI("pal_i2c", "R-Failure");
-        upper_layer_handler(p_i2c_context->p_upper_layer_ctx , PAL_I2C_EVENT_ERROR);
-	}
+    PAL_I2C_CAPTURE(p_i2c_context, PAL_I2C_CAPTURE_READ, start_us, p_data, length, ret != ESP_OK);
 
-    return status;
+    return pal_i2c_complete(p_i2c_context, ret);
 }
 
+#endif // PAL_I2C_MASTER_BUS_API
+
 pal_status_t pal_i2c_set_bitrate(const pal_i2c_t * p_i2c_context, uint16_t bitrate)
 {
+	esp32_i2c_ctx_t* master_ctx;
+	uint32_t bitrate_hz;
+
+	if ((p_i2c_context == NULL) || (p_i2c_context->p_i2c_hw_config == NULL))
+		return PAL_STATUS_FAILURE;
+
+	master_ctx = (esp32_i2c_ctx_t*)p_i2c_context->p_i2c_hw_config;
+
+#ifdef PAL_I2C_CAPTURE_ENABLED
+	{
+		const uint8_t requested[2] = {(uint8_t)(bitrate >> 8), (uint8_t)bitrate};
+		PAL_I2C_CAPTURE(p_i2c_context, PAL_I2C_CAPTURE_BITRATE, (uint32_t)esp_timer_get_time(),
+		                requested, sizeof(requested), 0);
+	}
+#endif
+
+	// Requests above what the ESP32 master can drive are clamped, as pal_i2c.h requires
+	if (bitrate > PAL_I2C_MASTER_MAX_FREQ_KHZ)
+		bitrate = PAL_I2C_MASTER_MAX_FREQ_KHZ;
+	bitrate_hz = (uint32_t)bitrate * 1000;
+
+	if (bitrate_hz == master_ctx->bitrate)
+		return PAL_STATUS_SUCCESS;
+
+#if PAL_I2C_MASTER_BUS_API
+	// The SCL speed is a property of the device handle: re-attach the device with the new speed
+	if (master_ctx->dev != NULL) {
+		i2c_device_config_t dev_conf = {
+			.dev_addr_length = I2C_ADDR_BIT_LEN_7,
+			.device_address = p_i2c_context->slave_address,
+			.scl_speed_hz = bitrate_hz,
+		};
+
+		if (i2c_master_bus_wait_all_done(master_ctx->bus, PAL_I2C_TRANSFER_TIMEOUT_MS) != ESP_OK)
+			return PAL_STATUS_I2C_BUSY;
+
+		i2c_master_bus_rm_device(master_ctx->dev);
+		master_ctx->dev = NULL;
+		if (i2c_master_bus_add_device(master_ctx->bus, &dev_conf, &master_ctx->dev) != ESP_OK) {
+			master_ctx->dev = NULL;
+			return PAL_STATUS_FAILURE;
+		}
+	}
+#else
+	{
+		i2c_config_t conf = {
+			.mode = I2C_MODE_MASTER,
+			.sda_io_num = master_ctx->sda_io,
+			.sda_pullup_en = GPIO_PULLUP_ENABLE,
+			.scl_io_num = master_ctx->scl_io,
+			.scl_pullup_en = GPIO_PULLUP_ENABLE,
+			.master.clk_speed = bitrate_hz,
+			.clk_flags = 0,
+		};
+		if (i2c_param_config(master_ctx->port, &conf) != ESP_OK)
+			return PAL_STATUS_FAILURE;
+	}
+#endif
+
+	ESP_LOGI("pal_i2c", "bitrate set to %u kHz", (unsigned)bitrate);
+	master_ctx->bitrate = bitrate_hz;
+
     return PAL_STATUS_SUCCESS;
 }
 
+void pal_i2c_get_pm_stats(pal_i2c_pm_stats_t * p_stats)
+{
+#ifdef PAL_I2C_PM_LOCK
+	portENTER_CRITICAL(&g_pm_mux);
+	*p_stats = g_pm_stats;
+	portEXIT_CRITICAL(&g_pm_mux);
+#else
+	p_stats->transfers = 0;
+	p_stats->held_us = 0;
+#endif
+}
+
 /**
 * @}
 */
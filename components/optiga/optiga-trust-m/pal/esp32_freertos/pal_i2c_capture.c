@@ -0,0 +1,223 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file pal_i2c_capture.c
+*
+* \brief   This file implements the PAL I2C transaction capture (PAL_I2C_CAPTURE_ENABLED).
+*
+* \details Records go to a byte ring of PAL_I2C_CAPTURE_RING_BYTES; when it is full the oldest
+*          records are dropped whole, so the ring always holds the latest traffic. Appends copy
+*          at most one frame under a spinlock and may come from the event tasks of both OPTIGA
+*          instances.
+*
+* \ingroup  grPAL
+*
+* @{
+*/
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+
+#include "optiga/pal/pal_i2c_capture.h"
+
+#ifdef PAL_I2C_CAPTURE_ENABLED
+
+#ifndef PAL_I2C_CAPTURE_RING_BYTES
+    #define PAL_I2C_CAPTURE_RING_BYTES      (16384U)
+#endif
+
+/// @cond hidden
+
+#define PAL_I2C_CAPTURE_CHUNK_BYTES         (256U)
+
+extern pal_i2c_t optiga_pal_i2c_context_0;
+
+static uint8_t g_capture_ring[PAL_I2C_CAPTURE_RING_BYTES];
+// Offset of the oldest record and bytes in use
+static uint32_t g_capture_tail = 0;
+static uint32_t g_capture_used = 0;
+static uint32_t g_capture_records = 0;
+static uint32_t g_capture_dropped = 0;
+static volatile bool g_capture_saving = false;
+static portMUX_TYPE g_capture_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void pal_i2c_capture_copy_in(uint32_t offset, const uint8_t * p_data, uint32_t length)
+{
+    const uint32_t first = PAL_I2C_CAPTURE_RING_BYTES - offset;
+
+    if (length <= first)
+    {
+        memcpy(&g_capture_ring[offset], p_data, length);
+    }
+    else
+    {
+        memcpy(&g_capture_ring[offset], p_data, first);
+        memcpy(g_capture_ring, &p_data[first], length - first);
+    }
+}
+
+static void pal_i2c_capture_copy_out(uint32_t offset, uint8_t * p_data, uint32_t length)
+{
+    const uint32_t first = PAL_I2C_CAPTURE_RING_BYTES - offset;
+
+    if (length <= first)
+    {
+        memcpy(p_data, &g_capture_ring[offset], length);
+    }
+    else
+    {
+        memcpy(p_data, &g_capture_ring[offset], first);
+        memcpy(&p_data[first], g_capture_ring, length - first);
+    }
+}
+
+// Drops the oldest record, lock held
+static void pal_i2c_capture_drop_oldest(void)
+{
+    pal_i2c_capture_record_t header;
+    uint32_t size;
+
+    pal_i2c_capture_copy_out(g_capture_tail, (uint8_t *)&header, sizeof(header));
+    size = sizeof(header) + header.length;
+    g_capture_tail = (g_capture_tail + size) % PAL_I2C_CAPTURE_RING_BYTES;
+    g_capture_used -= size;
+    g_capture_records--;
+    g_capture_dropped++;
+}
+/// @endcond
+
+void pal_i2c_capture_record(const pal_i2c_t * p_i2c_context,
+                            uint8_t type,
+                            uint32_t start_us,
+                            const uint8_t * p_data,
+                            uint16_t length,
+                            uint8_t status)
+{
+    pal_i2c_capture_record_t header;
+    const uint32_t size = sizeof(header) + length;
+    uint32_t head;
+
+    header.time_us = start_us;
+    header.duration_us = (uint32_t)esp_timer_get_time() - start_us;
+    header.length = length;
+    header.type = (uint8_t)(type | ((p_i2c_context == &optiga_pal_i2c_context_0) ?
+                                    0 : (1U << PAL_I2C_CAPTURE_DEVICE_SHIFT)));
+    header.status = status;
+
+    taskENTER_CRITICAL(&g_capture_lock);
+    if (g_capture_saving || (size > PAL_I2C_CAPTURE_RING_BYTES))
+    {
+        g_capture_dropped++;
+    }
+    else
+    {
+        while ((PAL_I2C_CAPTURE_RING_BYTES - g_capture_used) < size)
+        {
+            pal_i2c_capture_drop_oldest();
+        }
+        head = (g_capture_tail + g_capture_used) % PAL_I2C_CAPTURE_RING_BYTES;
+        pal_i2c_capture_copy_in(head, (const uint8_t *)&header, sizeof(header));
+        if (0 != length)
+        {
+            pal_i2c_capture_copy_in((head + sizeof(header)) % PAL_I2C_CAPTURE_RING_BYTES, p_data, length);
+        }
+        g_capture_used += size;
+        g_capture_records++;
+    }
+    taskEXIT_CRITICAL(&g_capture_lock);
+}
+
+void pal_i2c_capture_get_info(pal_i2c_capture_file_t * p_info)
+{
+    taskENTER_CRITICAL(&g_capture_lock);
+    p_info->magic = PAL_I2C_CAPTURE_MAGIC;
+    p_info->version = PAL_I2C_CAPTURE_VERSION;
+    p_info->record_header_size = sizeof(pal_i2c_capture_record_t);
+    p_info->records = g_capture_records;
+    p_info->dropped = g_capture_dropped;
+    p_info->bytes = g_capture_used;
+    taskEXIT_CRITICAL(&g_capture_lock);
+}
+
+pal_status_t pal_i2c_capture_save(pal_i2c_capture_write_t writer, void * p_context)
+{
+    static uint8_t chunk[PAL_I2C_CAPTURE_CHUNK_BYTES];
+    pal_i2c_capture_file_t info;
+    uint32_t offset;
+    uint32_t done = 0;
+    uint32_t length;
+    pal_status_t status = PAL_STATUS_SUCCESS;
+
+    // Appends stop touching the ring once the flag is set under the lock
+    taskENTER_CRITICAL(&g_capture_lock);
+    g_capture_saving = true;
+    taskEXIT_CRITICAL(&g_capture_lock);
+
+    pal_i2c_capture_get_info(&info);
+    if (0 != writer(p_context, (const uint8_t *)&info, sizeof(info)))
+    {
+        status = PAL_STATUS_FAILURE;
+    }
+    offset = g_capture_tail;
+    while ((PAL_STATUS_SUCCESS == status) && (done < info.bytes))
+    {
+        length = info.bytes - done;
+        if (length > sizeof(chunk))
+        {
+            length = sizeof(chunk);
+        }
+        pal_i2c_capture_copy_out(offset, chunk, length);
+        if (0 != writer(p_context, chunk, length))
+        {
+            status = PAL_STATUS_FAILURE;
+        }
+        offset = (offset + length) % PAL_I2C_CAPTURE_RING_BYTES;
+        done += length;
+    }
+
+    taskENTER_CRITICAL(&g_capture_lock);
+    if (PAL_STATUS_SUCCESS == status)
+    {
+        // Calls dropped while saving are reported by the next save
+        g_capture_dropped -= info.dropped;
+        g_capture_tail = 0;
+        g_capture_used = 0;
+        g_capture_records = 0;
+    }
+    g_capture_saving = false;
+    taskEXIT_CRITICAL(&g_capture_lock);
+    return (status);
+}
+
+#endif // PAL_I2C_CAPTURE_ENABLED
+
+/**
+* @}
+*/
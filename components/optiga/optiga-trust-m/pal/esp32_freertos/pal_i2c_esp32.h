@@ -0,0 +1,81 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2019 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file pal_i2c_esp32.h
+*
+* \brief   This file defines the ESP32 specific I2C master context shared by the pal i2c implementation and its configuration.
+*
+* \ingroup  grPAL
+*
+* @{
+*/
+
+#ifndef _PAL_I2C_ESP32_H_
+#define _PAL_I2C_ESP32_H_
+
+#include <stdint.h>
+#include "esp_idf_version.h"
+
+/// The esp_driver_i2c master bus/device API replaces the legacy command link driver from ESP-IDF v5.2
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+    #define PAL_I2C_MASTER_BUS_API      (1)
+    #include "driver/i2c_master.h"
+#else
+    #define PAL_I2C_MASTER_BUS_API      (0)
+    #include "driver/i2c.h"
+#endif
+
+/// Timeout of a single I2C frame transfer in milliseconds (277 bytes at 100 kHz take about 28 ms)
+#ifndef CONFIG_PAL_I2C_TRANSFER_TIMEOUT_MS
+    #define PAL_I2C_TRANSFER_TIMEOUT_MS     (50)
+#else
+    #define PAL_I2C_TRANSFER_TIMEOUT_MS     CONFIG_PAL_I2C_TRANSFER_TIMEOUT_MS
+#endif
+
+/// Fastest SCL the ESP32 master supports (Fm+), needs strong external pull-ups
+#define PAL_I2C_MASTER_MAX_FREQ_KHZ     (1000U)
+
+typedef struct esp32_i2c_ctx {
+	uint8_t  port;
+	uint8_t	 scl_io;
+	uint8_t	 sda_io;
+	/// Current SCL frequency in Hz, updated by pal_i2c_set_bitrate
+	uint32_t bitrate;
+#if PAL_I2C_MASTER_BUS_API
+	/// Created once by pal_i2c_init, released by pal_i2c_deinit
+	i2c_master_bus_handle_t bus;
+	/// Pre-created OPTIGA device handle, transfers do not allocate
+	i2c_master_dev_handle_t dev;
+#endif
+}esp32_i2c_ctx_t;
+
+#endif /* _PAL_I2C_ESP32_H_ */
+
+/**
+* @}
+*/
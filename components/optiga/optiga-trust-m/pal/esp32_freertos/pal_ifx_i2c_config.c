@@ -38,7 +38,7 @@
 #include "optiga/pal/pal_gpio.h"
 #include "optiga/pal/pal_i2c.h"
 #include "optiga/ifx_i2c/ifx_i2c_config.h"
-#include "driver/i2c.h"
+#include "pal_i2c_esp32.h"
 
 /*!< gpio number for I2C master clock */
  #ifndef CONFIG_PAL_I2C_MASTER_SCL_IO
@@ -82,12 +82,42 @@
 	#define PAL_I2C_MASTER_FREQ_HZ			CONFIG_PAL_I2C_MASTER_FREQ_HZ
 #endif
 
-typedef struct esp32_i2c_ctx {
-	uint8_t  port;
-	uint8_t	 scl_io;
-	uint8_t	 sda_io;
-	uint32_t bitrate;
-}esp32_i2c_ctx_t;
+#if (OPTIGA_MAX_INSTANCES > 1)
+/*!< gpio number for I2C master clock of the second OPTIGA */
+#ifndef CONFIG_PAL_I2C_1_MASTER_SCL_IO
+	#define PAL_I2C_1_MASTER_SCL_IO         19
+#else
+	#define PAL_I2C_1_MASTER_SCL_IO			CONFIG_PAL_I2C_1_MASTER_SCL_IO
+#endif
+
+/*!< gpio number for I2C master data of the second OPTIGA */
+#ifndef CONFIG_PAL_I2C_1_MASTER_SDA_IO
+	#define PAL_I2C_1_MASTER_SDA_IO         18
+#else
+	#define PAL_I2C_1_MASTER_SDA_IO			CONFIG_PAL_I2C_1_MASTER_SDA_IO
+#endif
+
+/*!< gpio number for software reset line of the second OPTIGA */
+#ifndef CONFIG_PAL_I2C_1_MASTER_RESET
+	#define PAL_I2C_1_MASTER_RESET          27
+#else
+	#define PAL_I2C_1_MASTER_RESET			CONFIG_PAL_I2C_1_MASTER_RESET
+#endif
+
+/*!< gpio number for vdd line of the second OPTIGA */
+#ifndef CONFIG_PAL_I2C_1_MASTER_VCC
+	#define PAL_I2C_1_MASTER_VCC            33
+#else
+	#define PAL_I2C_1_MASTER_VCC			CONFIG_PAL_I2C_1_MASTER_VCC
+#endif
+
+/*!< I2C port number for the second OPTIGA, must differ from PAL_I2C_MASTER_NUM */
+#ifndef CONFIG_PAL_I2C_1_MASTER_NUM
+	#define PAL_I2C_1_MASTER_NUM            I2C_NUM_1
+#else
+	#define PAL_I2C_1_MASTER_NUM			CONFIG_PAL_I2C_1_MASTER_NUM
+#endif
+#endif
 
 esp32_i2c_ctx_t	 esp32_i2c_ctx_0 = {PAL_I2C_MASTER_NUM,
                                     PAL_I2C_MASTER_SCL_IO,
@@ -127,6 +157,47 @@ pal_gpio_t optiga_reset_0 =
     (void*)PAL_I2C_MASTER_RESET
 };
 
+#if (OPTIGA_MAX_INSTANCES > 1)
+/// Second OPTIGA on its own I2C port, so both devices transfer in parallel
+esp32_i2c_ctx_t	 esp32_i2c_ctx_1 = {PAL_I2C_1_MASTER_NUM,
+                                    PAL_I2C_1_MASTER_SCL_IO,
+									PAL_I2C_1_MASTER_SDA_IO,
+									PAL_I2C_MASTER_FREQ_HZ};
+
+/**
+ * \brief PAL I2C configuration for the second OPTIGA.
+ */
+pal_i2c_t optiga_pal_i2c_context_1 =
+{
+    /// Pointer to I2C master platform specific context
+    (void*)&esp32_i2c_ctx_1,
+    /// Slave address
+    0x30,
+    /// Upper layer context
+    NULL,
+    /// Callback event handler
+    NULL
+};
+
+/**
+* \brief PAL vdd pin configuration for the second OPTIGA.
+ */
+pal_gpio_t optiga_vdd_1 =
+{
+    // Platform specific GPIO context for the pin used to toggle Vdd.
+    (void*)PAL_I2C_1_MASTER_VCC
+};
+
+/**
+ * \brief PAL reset pin configuration for the second OPTIGA.
+ */
+pal_gpio_t optiga_reset_1 =
+{
+    // Platform specific GPIO context for the pin used to toggle Reset.
+    (void*)PAL_I2C_1_MASTER_RESET
+};
+#endif
+
 /**
 * @}
 */
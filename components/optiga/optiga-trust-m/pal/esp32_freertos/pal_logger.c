@@ -43,6 +43,11 @@
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_log.h"
+#ifdef OPTIGA_LIB_LOGGER_BINARY_TASK
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "optiga/common/optiga_lib_logger.h"
+#endif
 
 //lint --e{552,714} suppress "Accessed by user of this structure" 
 pal_logger_t logger_console =
@@ -54,10 +59,43 @@ pal_logger_t logger_console =
 ///
 #define CONSOLE_PORT        0
 
+#ifdef OPTIGA_LIB_LOGGER_BINARY_TASK
+/// Records formatted per pass of the formatter task
+#define PAL_LOGGER_FORMAT_BATCH     (16U)
+/// Sleep of the formatter task once the ring is empty
+#define PAL_LOGGER_FORMAT_IDLE_MS   (100U)
+
+static TaskHandle_t pal_logger_format_task = NULL;
+
+// Formats the binary log ring on the console below every other task except idle
+static void pal_logger_format(void * p_arg)
+{
+    for (;;)
+    {
+        if (0 == optiga_lib_logger_process(PAL_LOGGER_FORMAT_BATCH))
+        {
+            vTaskDelay(pdMS_TO_TICKS(PAL_LOGGER_FORMAT_IDLE_MS));
+        }
+        else
+        {
+            taskYIELD();
+        }
+    }
+}
+#endif
+
 pal_status_t pal_logger_init(void * p_logger_context)
 {
     pal_status_t return_status = PAL_STATUS_SUCCESS;
 
+#ifdef OPTIGA_LIB_LOGGER_BINARY_TASK
+    if ((NULL == pal_logger_format_task) &&
+        (pdPASS != xTaskCreate(pal_logger_format, "optiga_log", 4096, NULL, tskIDLE_PRIORITY + 1,
+                               &pal_logger_format_task)))
+    {
+        return_status = PAL_STATUS_FAILURE;
+    }
+#endif
     return return_status;
 }
 pal_status_t pal_logger_write(void * p_logger_context, const uint8_t * p_log_data, uint32_t log_data_length)
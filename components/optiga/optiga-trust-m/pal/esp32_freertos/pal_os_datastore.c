@@ -35,7 +35,15 @@
 * @{
 */
 
+#include "sdkconfig.h"
+#include "esp_attr.h"
 #include "optiga/pal/pal_os_datastore.h"
+
+#ifdef CONFIG_OPTIGA_TRUST_M_DATASTORE_NVS
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "esp_rom_crc.h"
+#endif
 /// @cond hidden
 
 /// Size of length field 
@@ -43,11 +51,115 @@
 /// Size of data store buffer to hold the shielded connection manage context information (2 bytes length field + 64(0x40) bytes context)
 #define MANAGE_CONTEXT_BUFFER_SIZE      (0x42)
 
+#ifdef CONFIG_OPTIGA_TRUST_M_DATASTORE_NVS
+// The contexts are NVS blobs (data followed by its CRC32), so a hibernated application and
+// its shielded connection survive reboots and power loss. A blob failing the CRC reads as
+// empty and the restore falls back to a full open and handshake. The OPTIGA rejects a
+// context that does not match its own saved session.
+#define PAL_OS_DATASTORE_NVS_NAMESPACE      "optiga_ds"
+#define PAL_OS_DATASTORE_NVS_MANAGE_KEY     "manage_ctx"
+#define PAL_OS_DATASTORE_NVS_APP_KEY        "app_ctx"
+/// Size of the CRC32 trailer of a blob
+#define PAL_OS_DATASTORE_CRC_SIZE           (0x04)
+
+static pal_status_t pal_os_datastore_nvs_open(nvs_handle_t * p_handle)
+{
+    static bool_t nvs_ready = FALSE;
+    esp_err_t err;
+
+    if (FALSE == nvs_ready)
+    {
+        // Already initialised by the application is fine; a full or outdated partition is
+        // left to the application to erase
+        err = nvs_flash_init();
+        if (ESP_OK != err)
+        {
+            return PAL_STATUS_FAILURE;
+        }
+        nvs_ready = TRUE;
+    }
+    return (ESP_OK == nvs_open(PAL_OS_DATASTORE_NVS_NAMESPACE, NVS_READWRITE, p_handle)) ?
+           PAL_STATUS_SUCCESS : PAL_STATUS_FAILURE;
+}
+
+static pal_status_t pal_os_datastore_nvs_write(const char * key, const uint8_t * p_buffer, uint16_t length,
+                                               uint16_t max_length)
+{
+    pal_status_t return_status = PAL_STATUS_FAILURE;
+    uint8_t blob[MANAGE_CONTEXT_BUFFER_SIZE + PAL_OS_DATASTORE_CRC_SIZE];
+    nvs_handle_t handle;
+    uint32_t crc;
+
+    do
+    {
+        if ((length > max_length) || (PAL_STATUS_SUCCESS != pal_os_datastore_nvs_open(&handle)))
+        {
+            break;
+        }
+        memcpy(blob, p_buffer, length);
+        crc = esp_rom_crc32_le(0, p_buffer, length);
+        blob[length] = (uint8_t)crc;
+        blob[length + 1] = (uint8_t)(crc >> 8);
+        blob[length + 2] = (uint8_t)(crc >> 16);
+        blob[length + 3] = (uint8_t)(crc >> 24);
+        if ((ESP_OK == nvs_set_blob(handle, key, blob, length + PAL_OS_DATASTORE_CRC_SIZE)) &&
+            (ESP_OK == nvs_commit(handle)))
+        {
+            return_status = PAL_STATUS_SUCCESS;
+        }
+        nvs_close(handle);
+    } while (FALSE);
+    return return_status;
+}
+
+static pal_status_t pal_os_datastore_nvs_read(const char * key, uint8_t * p_buffer, uint16_t * p_buffer_length,
+                                              uint16_t max_length)
+{
+    uint8_t blob[MANAGE_CONTEXT_BUFFER_SIZE + PAL_OS_DATASTORE_CRC_SIZE];
+    size_t blob_length = sizeof(blob);
+    nvs_handle_t handle;
+    uint16_t data_length = 0;
+    uint32_t crc;
+
+    // Callers pass the capacity of p_buffer in *p_buffer_length
+    if (*p_buffer_length < max_length)
+    {
+        max_length = *p_buffer_length;
+    }
+    if (PAL_STATUS_SUCCESS != pal_os_datastore_nvs_open(&handle))
+    {
+        return PAL_STATUS_FAILURE;
+    }
+    // A missing or corrupted blob reads as empty, like the cleared RAM store
+    if ((ESP_OK == nvs_get_blob(handle, key, blob, &blob_length)) &&
+        (blob_length >= PAL_OS_DATASTORE_CRC_SIZE) &&
+        ((blob_length - PAL_OS_DATASTORE_CRC_SIZE) <= max_length))
+    {
+        data_length = (uint16_t)(blob_length - PAL_OS_DATASTORE_CRC_SIZE);
+        crc = (uint32_t)blob[data_length] | ((uint32_t)blob[data_length + 1] << 8) |
+              ((uint32_t)blob[data_length + 2] << 16) | ((uint32_t)blob[data_length + 3] << 24);
+        if (crc != esp_rom_crc32_le(0, blob, data_length))
+        {
+            data_length = 0;
+        }
+    }
+    nvs_close(handle);
+
+    memcpy(p_buffer, blob, data_length);
+    *p_buffer_length = data_length;
+    return PAL_STATUS_SUCCESS;
+}
+#else
+// The context buffers live in RTC slow memory: they survive ESP32 deep sleep, so a
+// hibernate before esp_deep_sleep_start() can be restored on wake. Power-on reset
+// clears them (length 0), which makes a restore fail and fall back to a full open.
+
 //Internal buffer to store the shielded connection manage context information (length field + Data)
-uint8_t data_store_manage_context_buffer [LENGTH_SIZE + MANAGE_CONTEXT_BUFFER_SIZE];
+RTC_DATA_ATTR uint8_t data_store_manage_context_buffer [LENGTH_SIZE + MANAGE_CONTEXT_BUFFER_SIZE];
 
 //Internal buffer to store the optiga application context data during hibernate(length field + Data)
-uint8_t data_store_app_context_buffer [LENGTH_SIZE + APP_CONTEXT_SIZE];
+RTC_DATA_ATTR uint8_t data_store_app_context_buffer [LENGTH_SIZE + APP_CONTEXT_SIZE];
+#endif
 
 //Internal buffer to store the generated platform binding shared secret on Host (length field + shared secret)
 uint8_t optiga_platform_binding_shared_secret [LENGTH_SIZE + OPTIGA_SHARED_SECRET_MAX_LENGTH] = 
@@ -95,10 +207,15 @@ pal_status_t pal_os_datastore_write(uint16_t datastore_id,
             // the manage context information in non-volatile memory 
             // to reuse for later during hard reset scenarios where the 
             // RAM gets flushed out.
+#ifdef CONFIG_OPTIGA_TRUST_M_DATASTORE_NVS
+            return_status = pal_os_datastore_nvs_write(PAL_OS_DATASTORE_NVS_MANAGE_KEY, p_buffer, length,
+                                                       MANAGE_CONTEXT_BUFFER_SIZE);
+#else
             data_store_manage_context_buffer[offset++] = (uint8_t)(length>>8);
             data_store_manage_context_buffer[offset++] = (uint8_t)(length);
             memcpy(&data_store_manage_context_buffer[offset],p_buffer,length);
             return_status = PAL_STATUS_SUCCESS;
+#endif
             break;
         }
         case OPTIGA_HIBERNATE_CONTEXT_ID:
@@ -108,10 +225,15 @@ pal_status_t pal_os_datastore_write(uint16_t datastore_id,
             // the application context information in non-volatile memory 
             // to reuse for later during hard reset scenarios where the 
             // RAM gets flushed out.
+#ifdef CONFIG_OPTIGA_TRUST_M_DATASTORE_NVS
+            return_status = pal_os_datastore_nvs_write(PAL_OS_DATASTORE_NVS_APP_KEY, p_buffer, length,
+                                                       APP_CONTEXT_SIZE);
+#else
             data_store_app_context_buffer[offset++] = (uint8_t)(length>>8);
             data_store_app_context_buffer[offset++] = (uint8_t)(length);
             memcpy(&data_store_app_context_buffer[offset],p_buffer,length);
             return_status = PAL_STATUS_SUCCESS;
+#endif
             break;
         }
         default:
@@ -157,11 +279,16 @@ pal_status_t pal_os_datastore_read(uint16_t datastore_id,
             // This has to be enhanced by user only,
             // if manage context information is stored in NVM during the hibernate, 
             // else this is not required to be enhanced.
+#ifdef CONFIG_OPTIGA_TRUST_M_DATASTORE_NVS
+            return_status = pal_os_datastore_nvs_read(PAL_OS_DATASTORE_NVS_MANAGE_KEY, p_buffer, p_buffer_length,
+                                                      MANAGE_CONTEXT_BUFFER_SIZE);
+#else
             data_length = (uint16_t) (data_store_manage_context_buffer[offset++] << 8);
             data_length |= (uint16_t)(data_store_manage_context_buffer[offset++]);
             memcpy(p_buffer, &data_store_manage_context_buffer[offset], data_length);
             *p_buffer_length = data_length;
             return_status = PAL_STATUS_SUCCESS;
+#endif
             break;
         }
         case OPTIGA_HIBERNATE_CONTEXT_ID:
@@ -170,11 +297,16 @@ pal_status_t pal_os_datastore_read(uint16_t datastore_id,
             // This has to be enhanced by user only,
             // if application context information is stored in NVM during the hibernate, 
             // else this is not required to be enhanced.
+#ifdef CONFIG_OPTIGA_TRUST_M_DATASTORE_NVS
+            return_status = pal_os_datastore_nvs_read(PAL_OS_DATASTORE_NVS_APP_KEY, p_buffer, p_buffer_length,
+                                                      APP_CONTEXT_SIZE);
+#else
             data_length = (uint16_t) (data_store_app_context_buffer[offset++] << 8);
             data_length |= (uint16_t)(data_store_app_context_buffer[offset++]);
             memcpy(p_buffer, &data_store_app_context_buffer[offset], data_length);
             *p_buffer_length = data_length;
             return_status = PAL_STATUS_SUCCESS;
+#endif
             break;
         }
         default:
@@ -36,22 +36,63 @@
 */
 
 #include "freertos/FreeRTOS.h"
-#include "freertos/timers.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "optiga/pal/pal_os_timer.h"
 #include "optiga/pal/pal_os_event.h"
 #include "optiga/pal/pal.h"
+#include "optiga/pal/pal_os_diag.h"
+#include "optiga/pal/pal_sysview.h"
+#include "optiga/optiga_lib_config.h"
 #include "stdio.h"
 
+/// One event per OPTIGA instance, each with its own timer, semaphore and task so that the
+/// blocking I2C transfers of one device do not hold back the other
+#define PAL_OS_EVENT_MAX_INSTANCES      (OPTIGA_MAX_INSTANCES)
+
+/// Event task stack in bytes (ESP-IDF FreeRTOS counts stacks in bytes). The callbacks run the
+/// whole IFX I2C stack; pal_os_event_get_task_stats shows how much of it is used
+#ifndef PAL_OS_EVENT_TASK_STACK_BYTES
+#define PAL_OS_EVENT_TASK_STACK_BYTES   (configMINIMAL_STACK_SIZE * 5)
+#endif
+
+/// Event task priority. Above the tasks that queue OPTIGA requests, so a finished transfer
+/// is handled at once
+#ifndef PAL_OS_EVENT_TASK_PRIORITY
+#define PAL_OS_EVENT_TASK_PRIORITY      (5)
+#endif
+
+/// Core the event tasks are pinned to, -1 for no affinity (also used if the chip has one core)
+#ifndef PAL_OS_EVENT_TASK_CORE
+#define PAL_OS_EVENT_TASK_CORE          (-1)
+#endif
+
+/// PAL_OS_EVENT_STATIC_ALLOCATION: event semaphores, task control blocks and stacks live in
+/// .bss instead of the heap, so pal_os_event_init cannot fail on a fragmented heap and
+/// the memory shows in the image size. The esp_timer handles have no static variant and
+/// are still allocated, once, by pal_os_event_init
+#if defined(PAL_OS_EVENT_STATIC_ALLOCATION) && !configSUPPORT_STATIC_ALLOCATION
+#error "PAL_OS_EVENT_STATIC_ALLOCATION needs configSUPPORT_STATIC_ALLOCATION"
+#endif
+
+#if (PAL_OS_EVENT_TASK_CORE >= 0) && (PAL_OS_EVENT_TASK_CORE < portNUM_PROCESSORS)
+#define PAL_OS_EVENT_TASK_AFFINITY      (PAL_OS_EVENT_TASK_CORE)
+#else
+#define PAL_OS_EVENT_TASK_AFFINITY      (tskNO_AFFINITY)
+#endif
+
 /// @cond hidden
 void pal_os_event_delayms(uint32_t time_ms);
 pal_status_t pal_os_event_init(void);
 void _pal_os_event_trigger_registered_callback( void * pvParameters );
-void vTimerCallback( TimerHandle_t __xTimer );
+static void pal_os_event_timer_expired(void * arg);
+static void pal_os_event_process(pal_os_event_t * p_pal_os_event);
 
-static pal_os_event_t pal_os_event_0 = {0};
+static pal_os_event_t pal_os_event_list[PAL_OS_EVENT_MAX_INSTANCES] = {0};
+/// Number of events handed out by pal_os_event_create
+static uint8_t pal_os_event_count = 0;
 uint32_t timeout = 0;
 
 void pal_os_event_start(pal_os_event_t * p_pal_os_event, register_callback callback, void * callback_args)
@@ -72,46 +113,79 @@ void pal_os_event_stop(pal_os_event_t * p_pal_os_event)
 
 pal_os_event_t * pal_os_event_create(register_callback callback, void * callback_args)
 {
-    if (( NULL != callback )&&( NULL != callback_args ))
+    pal_os_event_t * p_pal_os_event = NULL;
+
+    // Called once per OPTIGA instance from optiga_cmd_create, inside its critical section
+    if (pal_os_event_count < PAL_OS_EVENT_MAX_INSTANCES)
     {
-        pal_os_event_start(&pal_os_event_0,callback,callback_args);
+        p_pal_os_event = &pal_os_event_list[pal_os_event_count++];
+        if (( NULL != callback )&&( NULL != callback_args ))
+        {
+            pal_os_event_start(p_pal_os_event,callback,callback_args);
+        }
     }
-    return (&pal_os_event_0);
+    return (p_pal_os_event);
 }
 
 /// @endcond
 
-SemaphoreHandle_t xSemaphore = NULL;
-TimerHandle_t     xTrustMEventTimer = NULL;
+/// Wakes the event task of each event, given from its timer
+static SemaphoreHandle_t pal_os_event_semaphore[PAL_OS_EVENT_MAX_INSTANCES] = {NULL};
+/// Event tasks, for their stack high-water marks
+static TaskHandle_t pal_os_event_task[PAL_OS_EVENT_MAX_INSTANCES] = {NULL};
+#ifdef PAL_OS_EVENT_STATIC_ALLOCATION
+static StaticSemaphore_t pal_os_event_semaphore_buffer[PAL_OS_EVENT_MAX_INSTANCES];
+static StaticTask_t pal_os_event_task_buffer[PAL_OS_EVENT_MAX_INSTANCES];
+/// ESP-IDF counts stack depth in bytes; StackType_t is one byte there
+static StackType_t pal_os_event_task_stack[PAL_OS_EVENT_MAX_INSTANCES]
+                                          [PAL_OS_EVENT_TASK_STACK_BYTES / sizeof(StackType_t)];
+#endif
+
+#ifdef PAL_OS_EVENT_TIMER_ISR
+/**
+*  Timer callback handler, dispatched from the esp_timer interrupt (PAL_OS_EVENT_TIMER_ISR).
+*
+*  The event task wakes without a detour through the esp_timer task, which runs on its own
+*  core and priority next to every other esp_timer client.<br>
+*
+*\param[in] arg Semaphore of the expired event
+*
+*/
+static void IRAM_ATTR pal_os_event_timer_expired_isr(void * arg)
+{
+    BaseType_t woken = pdFALSE;
+
+    (void)xSemaphoreGiveFromISR( (SemaphoreHandle_t)arg, &woken );
+    if (pdFALSE != woken)
+    {
+        esp_timer_isr_dispatch_need_yield();
+    }
+}
+#endif
 
 /**
-*  Timer callback handler. 
+*  Timer callback handler.
 *
-*  This get called from the TIMER elapse event.<br>
-*  Once the timer expires, the registered callback funtion gets called from the timer event handler, if
-*  the call back is not NULL.<br>
+*  This get called from the esp_timer task once the requested delay has elapsed.<br>
+*  The registered callback is not invoked here, it would run on the esp_timer task stack
+*  and delay every other esp_timer client. The semaphore hands it over to the event task.<br>
 *
-*\param[in] args Callback argument
+*\param[in] arg Semaphore of the expired event
 *
 */
-void vTimerCallback( TimerHandle_t __xTimer )
+static void pal_os_event_timer_expired(void * arg)
 {
-    /* Optionally do something if the pxTimer parameter is NULL. */
-    configASSERT( __xTimer );
-
-    /*
-     * You can't call callback from the timer callback, this might lead to a corruption
-     * Use a semaphore instead
-     * */
-    xSemaphoreGive( xSemaphore );
+    xSemaphoreGive( (SemaphoreHandle_t)arg );
 }
 
 /// @endcond
 
-void pal_os_event_trigger_registered_callback(void)
+/// Event task body, runs the callbacks of one event as its timer expires
+static void pal_os_event_process(pal_os_event_t * p_pal_os_event)
 {
     register_callback func = NULL;
     void * func_args = NULL;
+    SemaphoreHandle_t semaphore = pal_os_event_semaphore[p_pal_os_event - pal_os_event_list];
 
     /* 
     See if we can obtain the element from the semaphore.  If the semaphore is not
@@ -120,74 +194,102 @@ void pal_os_event_trigger_registered_callback(void)
     */
     //printf("vTaskCallbackHandler\r\n");
     do {
-        if( xSemaphoreTake( xSemaphore, ( TickType_t ) portMAX_DELAY ) == pdTRUE )
+        if( xSemaphoreTake( semaphore, ( TickType_t ) portMAX_DELAY ) == pdTRUE )
         {
-            if (pal_os_event_0.callback_registered)
+            if (p_pal_os_event->callback_registered)
             {
-                func = pal_os_event_0.callback_registered;
-                pal_os_event_0.callback_registered = NULL;
-                func_args = pal_os_event_0.callback_ctx;
+                func = p_pal_os_event->callback_registered;
+                p_pal_os_event->callback_registered = NULL;
+                func_args = p_pal_os_event->callback_ctx;
+                PAL_SYSVIEW_START(PAL_SYSVIEW_MARK_EVENT);
                 func((void*)func_args);
+                PAL_SYSVIEW_STOP(PAL_SYSVIEW_MARK_EVENT);
             }
         }
     } while(1);
 }
 
+void pal_os_event_trigger_registered_callback(void)
+{
+    pal_os_event_process(&pal_os_event_list[0]);
+}
+
 void _pal_os_event_trigger_registered_callback( void * pvParameters )
 {
-    pal_os_event_trigger_registered_callback();
+    pal_os_event_process((pal_os_event_t *)pvParameters);
 }
 
 pal_status_t pal_os_event_init(void)
 {
-    pal_status_t status = PAL_STATUS_FAILURE;
+    pal_status_t status = PAL_STATUS_SUCCESS;
     BaseType_t xReturned;
-    
-    do {
+    esp_timer_handle_t timer;
+    uint8_t index;
+    char task_name[] = "otx_os_tsk0";
+
+    for (index = 0; (index < PAL_OS_EVENT_MAX_INSTANCES) && (PAL_STATUS_SUCCESS == status); index++)
+    {
+        status = PAL_STATUS_FAILURE;
+
         /* Create a semaphore and take it now */
-        xSemaphore = xSemaphoreCreateBinary();
-        if( xSemaphore == NULL )
+#ifdef PAL_OS_EVENT_STATIC_ALLOCATION
+        pal_os_event_semaphore[index] = xSemaphoreCreateBinaryStatic(&pal_os_event_semaphore_buffer[index]);
+#else
+        pal_os_event_semaphore[index] = xSemaphoreCreateBinary();
+#endif
+        if( pal_os_event_semaphore[index] == NULL )
         {
             break;
         }
 
-        xSemaphoreTake( xSemaphore, ( TickType_t ) 10 );
+        xSemaphoreTake( pal_os_event_semaphore[index], ( TickType_t ) 10 );
 
         /* Create the handler for the callbacks. */
-        xReturned = xTaskCreate(_pal_os_event_trigger_registered_callback,       /* Function that implements the task. */
-                                "otx_os_tsk",                /* Text name for the task. */
-                                configMINIMAL_STACK_SIZE*5,  /* Stack size in words, not bytes. */
-                                NULL,        /* Parameter passed into the task. */
-                                5,           /* Priority at which the task is created. */
-                                NULL );      /* Used to pass out the created task's handle. */
+        task_name[sizeof(task_name) - 2] = (char)('0' + index);
+#ifdef PAL_OS_EVENT_STATIC_ALLOCATION
+        pal_os_event_task[index] = xTaskCreateStaticPinnedToCore(_pal_os_event_trigger_registered_callback,
+                                task_name,
+                                PAL_OS_EVENT_TASK_STACK_BYTES,
+                                &pal_os_event_list[index],
+                                PAL_OS_EVENT_TASK_PRIORITY,
+                                pal_os_event_task_stack[index],
+                                &pal_os_event_task_buffer[index],
+                                PAL_OS_EVENT_TASK_AFFINITY);
+        xReturned = (NULL != pal_os_event_task[index]) ? pdPASS : pdFAIL;
+#else
+        xReturned = xTaskCreatePinnedToCore(_pal_os_event_trigger_registered_callback,  /* Function that implements the task. */
+                                task_name,                   /* Text name for the task. */
+                                PAL_OS_EVENT_TASK_STACK_BYTES,  /* Stack size in bytes on ESP-IDF. */
+                                &pal_os_event_list[index],   /* Parameter passed into the task. */
+                                PAL_OS_EVENT_TASK_PRIORITY,  /* Priority at which the task is created. */
+                                &pal_os_event_task[index],   /* Used to pass out the created task's handle. */
+                                PAL_OS_EVENT_TASK_AFFINITY); /* Core, or tskNO_AFFINITY. */
+#endif
         if( xReturned != pdPASS )
         {
             break;
         }
 
-        ESP_LOGI("pal_os_event", "Init : Create Timer");
-#if 0        
-        xTimer = xTimerCreate("otx_os_tmr",        /* Just a text name, not used by the kernel. */
-                              1 / portTICK_PERIOD_MS,    /* The timer period in ticks. */
-                              pdFALSE,         /* The timers will auto-reload themselves when they expire. */
-                              ( void * ) NULL,   /* Assign each timer a unique id equal to its array index. */
-                              vTimerCallback  /* Each timer calls the same callback when it expires. */
-                              );
+        ESP_LOGI("pal_os_event", "Init : Create Timer %u", (unsigned)index);
+        const esp_timer_create_args_t timer_args = {
+#ifdef PAL_OS_EVENT_TIMER_ISR
+            .callback = pal_os_event_timer_expired_isr,
+            .dispatch_method = ESP_TIMER_ISR,
+#else
+            .callback = pal_os_event_timer_expired,
+            .dispatch_method = ESP_TIMER_TASK,
 #endif
-        xTrustMEventTimer = xTimerCreate("otx_os_tmr2", 
-                              pdMS_TO_TICKS(10), 
-                              pdFALSE, 
-                              (void *)0, 
-                              vTimerCallback);
-
-        if( xTrustMEventTimer == NULL )
+            .arg = pal_os_event_semaphore[index],
+            .name = "otx_os_tmr",
+        };
+        if (ESP_OK != esp_timer_create(&timer_args, &timer))
         {
             break;
         }
+        pal_os_event_list[index].os_timer = timer;
         ESP_LOGI("pal_os_event", "Init : Create Timer successful");
         status = PAL_STATUS_SUCCESS;
-
-    } while(0);
+    }
                 
     return status;
 }
@@ -198,21 +300,12 @@ void pal_os_event_register_callback_oneshot(pal_os_event_t * p_pal_os_event,
                                             uint32_t time_us)
 
 {
-    if (time_us < 1000) {
-        time_us = 1000;
-    }
-    else {
-        if (time_us%1000) time_us++;
-    }
-
-    //timeout = (time_us/1000);
-    //if (time_us%1000) timeout++;
     p_pal_os_event->callback_registered = callback;
     p_pal_os_event->callback_ctx = callback_args;
 
-    //ESP_LOGI("pal_os_event", "oneShot : %d", time_us);
-    //xTimerChangePeriod( xTimer, (time_us / 1000) / portTICK_PERIOD_MS, 10);
-    xTimerChangePeriod(xTrustMEventTimer, pdMS_TO_TICKS(10), portMAX_DELAY);
+    // Only one callback is pending per event, re-registering replaces the previous deadline
+    (void)esp_timer_stop((esp_timer_handle_t)p_pal_os_event->os_timer);
+    (void)esp_timer_start_once((esp_timer_handle_t)p_pal_os_event->os_timer, time_us);
 }
 
 void pal_os_event_delayms(uint32_t time_ms)
@@ -226,6 +319,26 @@ void pal_os_event_destroy(pal_os_event_t * pal_os_event)
     
 }
 
+uint8_t pal_os_event_get_task_stats(pal_os_task_stats_t * p_stats, uint8_t max_tasks)
+{
+    uint8_t count = 0;
+    uint8_t index;
+
+    for (index = 0; (index < PAL_OS_EVENT_MAX_INSTANCES) && (count < max_tasks); index++)
+    {
+        if (NULL != pal_os_event_task[index])
+        {
+            p_stats[count].name = pcTaskGetName(pal_os_event_task[index]);
+            p_stats[count].stack_bytes = PAL_OS_EVENT_TASK_STACK_BYTES;
+            p_stats[count].stack_free_min_bytes = uxTaskGetStackHighWaterMark(pal_os_event_task[index]);
+            p_stats[count].priority = (uint8_t)uxTaskPriorityGet(pal_os_event_task[index]);
+            p_stats[count].core = (PAL_OS_EVENT_TASK_AFFINITY == tskNO_AFFINITY) ? -1 : PAL_OS_EVENT_TASK_CORE;
+            count++;
+        }
+    }
+    return (count);
+}
+
 /**
 * @}
 */
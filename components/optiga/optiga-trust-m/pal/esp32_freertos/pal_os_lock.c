@@ -35,53 +35,123 @@
 * @{
 */
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "optiga/pal/pal_os_lock.h"
 
-volatile static pal_os_lock_t pal_os_lock = {.lock = 0};//lint --e{715} suppress "p_lock is not used here as it is placeholder for future." 
+/// Longest wait of pal_os_lock_acquire for a lock held by another task
+#ifndef PAL_OS_LOCK_TIMEOUT_MS
+#define PAL_OS_LOCK_TIMEOUT_MS      (5000U)
+#endif
+
+/// @cond hidden
+/* Guards the creation of the mutexes, which happens on first use from any task or core */
+static portMUX_TYPE pal_os_lock_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Mutex behind the lock: priority inheritance, so a low priority holder does not stall
+*  a high priority waiter. Locks declared without pal_os_lock_create get it on first use. */
+static SemaphoreHandle_t pal_os_lock_get_mutex(pal_os_lock_t * p_lock)
+{
+    SemaphoreHandle_t mutex = (SemaphoreHandle_t)p_lock->p_os_lock;
+
+    if (NULL == mutex)
+    {
+        // Created outside the spinlock (it allocates); a task that lost the race frees its copy
+        SemaphoreHandle_t created = xSemaphoreCreateMutex();
+
+        taskENTER_CRITICAL(&pal_os_lock_spinlock);
+        if (NULL == p_lock->p_os_lock)
+        {
+            p_lock->p_os_lock = created;
+            created = NULL;
+        }
+        mutex = (SemaphoreHandle_t)p_lock->p_os_lock;
+        taskEXIT_CRITICAL(&pal_os_lock_spinlock);
+        if (NULL != created)
+        {
+            vSemaphoreDelete(created);
+        }
+    }
+    return mutex;
+}
+/// @endcond
 
 void pal_os_lock_create(pal_os_lock_t * p_lock, uint8_t lock_type)
 {
     p_lock->type = lock_type;
     p_lock->lock = 0;
+    p_lock->p_os_lock = NULL;
+    (void)pal_os_lock_get_mutex(p_lock);
 }
 
-//lint --e{715} suppress "p_lock is not used here as it is placeholder for future." 
 //lint --e{818} suppress "Not declared as pointer as nothing needs to be updated in the pointer."
 void pal_os_lock_destroy(pal_os_lock_t * p_lock)
 {
-    
+    SemaphoreHandle_t mutex;
+
+    taskENTER_CRITICAL(&pal_os_lock_spinlock);
+    mutex = (SemaphoreHandle_t)p_lock->p_os_lock;
+    p_lock->p_os_lock = NULL;
+    taskEXIT_CRITICAL(&pal_os_lock_spinlock);
+    if (NULL != mutex)
+    {
+        vSemaphoreDelete(mutex);
+    }
 }
 
+/*
+* Blocks until the lock is free instead of failing at once, so callers need no retry loop.
+* Fails only after PAL_OS_LOCK_TIMEOUT_MS (a holder that never releases) or without heap.
+*/
 pal_status_t pal_os_lock_acquire(pal_os_lock_t * p_lock)
 {
-    pal_status_t return_status = PAL_STATUS_FAILURE;
+    SemaphoreHandle_t mutex = pal_os_lock_get_mutex(p_lock);
 
-    if (!(p_lock->lock))
+    if ((NULL == mutex) || (pdTRUE != xSemaphoreTake(mutex, pdMS_TO_TICKS(PAL_OS_LOCK_TIMEOUT_MS))))
     {
-        p_lock->lock++;
-        if (1 != p_lock->lock)
-        {
-            p_lock->lock--;
-        }
-        return_status = PAL_STATUS_SUCCESS;
+        return PAL_STATUS_FAILURE;
     }
-    return return_status;
+    p_lock->lock = 1;
+    return PAL_STATUS_SUCCESS;
 }
 
 void pal_os_lock_release(pal_os_lock_t * p_lock)
 {
-    if (0 != p_lock->lock)
+    SemaphoreHandle_t mutex = (SemaphoreHandle_t)p_lock->p_os_lock;
+
+    if ((NULL != mutex) && (0 != p_lock->lock))
     {
-        p_lock->lock--;
+        p_lock->lock = 0;
+        (void)xSemaphoreGive(mutex);
     }
 }
 
+/*
+* The command scheduler runs on the event task while requests are queued from application tasks.
+* Recursive mutex rather than a spinlock: the section is held across pal_os_calloc and nested
+* scheduler calls, which must not run with interrupts masked. Created on first use, usually
+* optiga_cmd_create during util/crypt creation; the spinlock makes that safe from both cores.
+*/
+static StaticSemaphore_t pal_os_critical_section_buffer;
+static SemaphoreHandle_t pal_os_critical_section = NULL;
+
 void pal_os_lock_enter_critical_section()
 {
+    if (NULL == pal_os_critical_section)
+    {
+        taskENTER_CRITICAL(&pal_os_lock_spinlock);
+        if (NULL == pal_os_critical_section)
+        {
+            pal_os_critical_section = xSemaphoreCreateRecursiveMutexStatic(&pal_os_critical_section_buffer);
+        }
+        taskEXIT_CRITICAL(&pal_os_lock_spinlock);
+    }
+    (void)xSemaphoreTakeRecursive(pal_os_critical_section, portMAX_DELAY);
 }
 
 void pal_os_lock_exit_critical_section()
 {
+    (void)xSemaphoreGiveRecursive(pal_os_critical_section);
 }
 
 /**
@@ -36,21 +36,230 @@
 */
 
 #include "stdio.h"
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
 #include "optiga/pal/pal_os_memory.h"
+#include "optiga/pal/pal_os_diag.h"
+#ifdef PAL_OS_MEMORY_ARENA_CAPS
+#include "esp_heap_caps.h"
+#endif
+
+/// Bytes of the arena behind pal_os_malloc and pal_os_calloc, 0 to use the libc heap.
+/// The OPTIGA stack then never competes with WiFi and TLS for heap and cannot fragment it
+#ifndef PAL_OS_MEMORY_ARENA_BYTES
+#define PAL_OS_MEMORY_ARENA_BYTES           (0U)
+#endif
+
+/// @cond hidden
+/// Prefix of every block: its size, so pal_os_free can count it. Keeps the alignment of malloc
+typedef union pal_os_memory_header
+{
+    struct
+    {
+        uint32_t size;
+        /// Size class of an arena block
+        uint8_t size_class;
+    } info;
+    uint64_t align;
+} pal_os_memory_header_t;
+
+static pal_os_memory_stats_t pal_os_memory_counters = {0};
+static portMUX_TYPE pal_os_memory_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#if PAL_OS_MEMORY_ARENA_BYTES > 0
+/// Size classes hold blocks of 32 << n bytes (header included), up to 4 KB
+#define PAL_OS_MEMORY_CLASS_MIN_SHIFT       (5U)
+#define PAL_OS_MEMORY_CLASSES               (8U)
+#define PAL_OS_MEMORY_CLASS_BYTES(c)        ((uint32_t)1U << (PAL_OS_MEMORY_CLASS_MIN_SHIFT + (c)))
+
+/// Freed blocks of one class, linked through their first bytes
+typedef struct pal_os_memory_free_block
+{
+    struct pal_os_memory_free_block * p_next;
+} pal_os_memory_free_block_t;
+
+/*
+* Segregated free lists over a bump-allocated arena: a block is carved once for the class
+* its request rounds up to and goes back to that class's list when freed. Allocation and
+* free are O(1) with no search or coalescing, and the arena cannot fragment: each class
+* keeps at most its own peak of blocks.
+*/
+static pal_os_memory_free_block_t * pal_os_memory_free_list[PAL_OS_MEMORY_CLASSES] = {NULL};
+static uint32_t pal_os_memory_carved = 0;
+
+#ifdef PAL_OS_MEMORY_ARENA_CAPS
+/// Taken once from the heap region PAL_OS_MEMORY_ARENA_CAPS (e.g. MALLOC_CAP_SPIRAM) on first use
+static uint8_t * pal_os_memory_arena = NULL;
+#else
+static uint8_t pal_os_memory_arena[PAL_OS_MEMORY_ARENA_BYTES] __attribute__((aligned(8)));
+#endif
+
+static uint8_t pal_os_memory_class_of(uint32_t block_bytes)
+{
+    uint8_t size_class = 0;
+
+    if (block_bytes > PAL_OS_MEMORY_CLASS_BYTES(0))
+    {
+        // Rounds up to the next power of two
+        size_class = (uint8_t)(32 - __builtin_clz(block_bytes - 1) - PAL_OS_MEMORY_CLASS_MIN_SHIFT);
+    }
+    return (size_class);
+}
+
+static pal_os_memory_header_t * pal_os_memory_arena_take(uint32_t block_bytes)
+{
+    pal_os_memory_header_t * p_header = NULL;
+    const uint8_t size_class = pal_os_memory_class_of(block_bytes);
+
+#ifdef PAL_OS_MEMORY_ARENA_CAPS
+    if (NULL == pal_os_memory_arena)
+    {
+        // Allocated outside the spinlock; a task that lost the race frees its copy
+        uint8_t * p_arena = heap_caps_aligned_alloc(8, PAL_OS_MEMORY_ARENA_BYTES, PAL_OS_MEMORY_ARENA_CAPS);
+
+        portENTER_CRITICAL(&pal_os_memory_lock);
+        if (NULL == pal_os_memory_arena)
+        {
+            pal_os_memory_arena = p_arena;
+            p_arena = NULL;
+        }
+        portEXIT_CRITICAL(&pal_os_memory_lock);
+        heap_caps_free(p_arena);
+        if (NULL == pal_os_memory_arena)
+        {
+            return (NULL);
+        }
+    }
+#endif
+    if (size_class >= PAL_OS_MEMORY_CLASSES)
+    {
+        return (NULL);
+    }
+
+    portENTER_CRITICAL(&pal_os_memory_lock);
+    if (NULL != pal_os_memory_free_list[size_class])
+    {
+        p_header = (pal_os_memory_header_t *)pal_os_memory_free_list[size_class];
+        pal_os_memory_free_list[size_class] = pal_os_memory_free_list[size_class]->p_next;
+    }
+    else if (PAL_OS_MEMORY_CLASS_BYTES(size_class) <= PAL_OS_MEMORY_ARENA_BYTES - pal_os_memory_carved)
+    {
+        p_header = (pal_os_memory_header_t *)(pal_os_memory_arena + pal_os_memory_carved);
+        pal_os_memory_carved += PAL_OS_MEMORY_CLASS_BYTES(size_class);
+    }
+    portEXIT_CRITICAL(&pal_os_memory_lock);
+    if (NULL != p_header)
+    {
+        p_header->info.size_class = size_class;
+    }
+    return (p_header);
+}
+
+static void pal_os_memory_arena_give(pal_os_memory_header_t * p_header)
+{
+    pal_os_memory_free_block_t * p_block = (pal_os_memory_free_block_t *)p_header;
+    const uint8_t size_class = p_header->info.size_class;
+
+    portENTER_CRITICAL(&pal_os_memory_lock);
+    p_block->p_next = pal_os_memory_free_list[size_class];
+    pal_os_memory_free_list[size_class] = p_block;
+    portEXIT_CRITICAL(&pal_os_memory_lock);
+}
+#endif
+
+static pal_os_memory_header_t * pal_os_memory_take(uint32_t size)
+{
+    if (size > (UINT32_MAX - sizeof(pal_os_memory_header_t)))
+    {
+        return (NULL);
+    }
+#if PAL_OS_MEMORY_ARENA_BYTES > 0
+    return (pal_os_memory_arena_take(sizeof(pal_os_memory_header_t) + size));
+#else
+    return (malloc(sizeof(pal_os_memory_header_t) + size));
+#endif
+}
+
+static void * pal_os_memory_account(pal_os_memory_header_t * p_header, uint32_t size)
+{
+    portENTER_CRITICAL(&pal_os_memory_lock);
+    if (NULL == p_header)
+    {
+        pal_os_memory_counters.failures++;
+        portEXIT_CRITICAL(&pal_os_memory_lock);
+        return (NULL);
+    }
+    p_header->info.size = size;
+    pal_os_memory_counters.in_use_bytes += size;
+    pal_os_memory_counters.blocks++;
+    pal_os_memory_counters.allocations++;
+    if (pal_os_memory_counters.in_use_bytes > pal_os_memory_counters.peak_bytes)
+    {
+        pal_os_memory_counters.peak_bytes = pal_os_memory_counters.in_use_bytes;
+    }
+    portEXIT_CRITICAL(&pal_os_memory_lock);
+    return (p_header + 1);
+}
+/// @endcond
 
 void * pal_os_malloc(uint32_t block_size)
 {
-    return (malloc(block_size));
+    return (pal_os_memory_account(pal_os_memory_take(block_size), block_size));
 }
 
 void * pal_os_calloc(uint32_t number_of_blocks , uint32_t block_size)
 {
-    return (calloc(number_of_blocks, block_size));
+    const uint64_t size = (uint64_t)number_of_blocks * block_size;
+    pal_os_memory_header_t * p_header = NULL;
+
+    if (size <= UINT32_MAX)
+    {
+        p_header = pal_os_memory_take((uint32_t)size);
+    }
+    if (NULL != p_header)
+    {
+        memset(p_header + 1, 0, (size_t)size);
+    }
+    return (pal_os_memory_account(p_header, (uint32_t)size));
 }
 
 void pal_os_free(void * p_block)
 {
-    free(p_block);
+    pal_os_memory_header_t * p_header;
+
+    if (NULL == p_block)
+    {
+        return;
+    }
+    p_header = (pal_os_memory_header_t *)p_block - 1;
+    portENTER_CRITICAL(&pal_os_memory_lock);
+    pal_os_memory_counters.in_use_bytes -= p_header->info.size;
+    pal_os_memory_counters.blocks--;
+    portEXIT_CRITICAL(&pal_os_memory_lock);
+#if PAL_OS_MEMORY_ARENA_BYTES > 0
+    pal_os_memory_arena_give(p_header);
+#else
+    free(p_header);
+#endif
+}
+
+void pal_os_memory_get_stats(pal_os_memory_stats_t * p_stats)
+{
+    portENTER_CRITICAL(&pal_os_memory_lock);
+    *p_stats = pal_os_memory_counters;
+#if PAL_OS_MEMORY_ARENA_BYTES > 0
+    p_stats->arena_bytes = PAL_OS_MEMORY_ARENA_BYTES;
+    p_stats->arena_carved_bytes = pal_os_memory_carved;
+#endif
+    portEXIT_CRITICAL(&pal_os_memory_lock);
+}
+
+void pal_os_memory_reset_peak(void)
+{
+    portENTER_CRITICAL(&pal_os_memory_lock);
+    pal_os_memory_counters.peak_bytes = pal_os_memory_counters.in_use_bytes;
+    portEXIT_CRITICAL(&pal_os_memory_lock);
 }
 
 void pal_os_memcpy(void * p_destination, const void * p_source, uint32_t size)
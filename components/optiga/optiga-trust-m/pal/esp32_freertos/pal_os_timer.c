@@ -38,20 +38,39 @@
 #include "optiga/pal/pal_os_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_timer.h"
 #include "stdio.h"
 
+/// Guards the last returned microsecond value, callers may run on either core
+static portMUX_TYPE pal_os_timer_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t pal_os_timer_last_us = 0;
+
 uint32_t pal_os_timer_get_time_in_microseconds(void)
 {
-    // !!!OPTIGA_LIB_PORTING_REQUIRED
-    // This API is needed to support optiga cmd scheduler. 
-    static uint32_t count = 0;
-    // The implementation must ensure that every invocation of this API returns a unique value.
-    return (count++);
+    // This API is needed to support optiga cmd scheduler.
+    // The implementation must ensure that every invocation of this API returns a unique value,
+    // so two calls within the same microsecond are pushed apart by one.
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+
+    portENTER_CRITICAL(&pal_os_timer_lock);
+    if ((int32_t)(now_us - pal_os_timer_last_us) <= 0)
+    {
+        now_us = pal_os_timer_last_us + 1;
+    }
+    // 0xFFFFFFFF marks a free slot in the cmd execution queue
+    if (0xFFFFFFFF == now_us)
+    {
+        now_us = 0;
+    }
+    pal_os_timer_last_us = now_us;
+    portEXIT_CRITICAL(&pal_os_timer_lock);
+
+    return (now_us);
 }
 
 uint32_t pal_os_timer_get_time_in_milliseconds(void)
 {
-    return xTaskGetTickCount();
+    return ((uint32_t)(esp_timer_get_time() / 1000));
 }
 
 void pal_os_timer_delay_in_milliseconds(uint16_t milliseconds)
@@ -0,0 +1,171 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2020 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file pal_sysview.c
+*
+* \brief   This file implements the SystemView markers on ESP-IDF app_trace (PAL_SYSVIEW_ENABLED).
+*
+* \details Markers are SEGGER_SYSVIEW_MarkStart/MarkStop/Mark events. SystemView forgets marker
+*          names when a recording starts, so they are sent again with the first marker after
+*          each start.
+*
+* \ingroup  grPAL
+*
+* @{
+*/
+
+#include "SEGGER_SYSVIEW.h"
+
+#include "optiga/common/optiga_lib_trace.h"
+#include "optiga/pal/pal_sysview.h"
+
+#ifdef PAL_SYSVIEW_ENABLED
+
+/// @cond hidden
+
+static const struct
+{
+    uint32_t marker;
+    const char * p_name;
+} pal_sysview_names[] =
+{
+    { PAL_SYSVIEW_MARK_CMD,         "optiga cmd" },
+    { PAL_SYSVIEW_MARK_PROTECT,     "optiga protect" },
+    { PAL_SYSVIEW_MARK_UNPROTECT,   "optiga unprotect" },
+    { PAL_SYSVIEW_MARK_EXEC,        "optiga exec" },
+    { PAL_SYSVIEW_MARK_I2C_WRITE,   "i2c write" },
+    { PAL_SYSVIEW_MARK_I2C_READ,    "i2c read" },
+    { PAL_SYSVIEW_MARK_EVENT,       "optiga event" },
+    { PAL_SYSVIEW_MARK_RETRY,       "optiga dl retry" },
+    { PAL_SYSVIEW_MARK_LOG_ENCRYPT, "log encrypt" },
+    { PAL_SYSVIEW_MARK_LOG_WRITE,   "log write" },
+    { PAL_SYSVIEW_MARK_LOG_SYNC,    "log fsync" },
+};
+
+static volatile int pal_sysview_was_started = 0;
+
+// Sends the marker names once per recording
+static void pal_sysview_name_markers(void)
+{
+    const int started = SEGGER_SYSVIEW_IsStarted();
+    uint32_t index;
+
+    if (started && !pal_sysview_was_started)
+    {
+        for (index = 0; index < (sizeof(pal_sysview_names) / sizeof(pal_sysview_names[0])); index++)
+        {
+            SEGGER_SYSVIEW_NameMarker(pal_sysview_names[index].marker, pal_sysview_names[index].p_name);
+        }
+    }
+    pal_sysview_was_started = started;
+}
+
+/// @endcond
+
+void pal_sysview_start(uint32_t marker)
+{
+    pal_sysview_name_markers();
+    SEGGER_SYSVIEW_MarkStart(marker);
+}
+
+void pal_sysview_stop(uint32_t marker)
+{
+    SEGGER_SYSVIEW_MarkStop(marker);
+}
+
+void pal_sysview_mark(uint32_t marker)
+{
+    pal_sysview_name_markers();
+    SEGGER_SYSVIEW_Mark(marker);
+}
+
+void pal_sysview_trace(uint8_t event, uint32_t arg)
+{
+    (void)arg;
+
+    switch (event)
+    {
+        case OPTIGA_LIB_TRACE_CMD_PREPARE:
+        {
+            pal_sysview_start(PAL_SYSVIEW_MARK_CMD);
+            break;
+        }
+        case OPTIGA_LIB_TRACE_CMD_DONE:
+        {
+            pal_sysview_stop(PAL_SYSVIEW_MARK_CMD);
+            break;
+        }
+        case OPTIGA_LIB_TRACE_PRL_PROTECT_START:
+        {
+            pal_sysview_start(PAL_SYSVIEW_MARK_PROTECT);
+            break;
+        }
+        case OPTIGA_LIB_TRACE_PRL_PROTECT_END:
+        {
+            pal_sysview_stop(PAL_SYSVIEW_MARK_PROTECT);
+            break;
+        }
+        case OPTIGA_LIB_TRACE_PRL_UNPROTECT_START:
+        {
+            pal_sysview_start(PAL_SYSVIEW_MARK_UNPROTECT);
+            break;
+        }
+        case OPTIGA_LIB_TRACE_PRL_UNPROTECT_END:
+        {
+            pal_sysview_stop(PAL_SYSVIEW_MARK_UNPROTECT);
+            break;
+        }
+        case OPTIGA_LIB_TRACE_PL_EXEC_START:
+        {
+            pal_sysview_start(PAL_SYSVIEW_MARK_EXEC);
+            break;
+        }
+        case OPTIGA_LIB_TRACE_PL_READY:
+        {
+            pal_sysview_stop(PAL_SYSVIEW_MARK_EXEC);
+            break;
+        }
+        case OPTIGA_LIB_TRACE_DL_RESEND:
+        case OPTIGA_LIB_TRACE_DL_RESYNC:
+        {
+            pal_sysview_mark(PAL_SYSVIEW_MARK_RETRY);
+            break;
+        }
+        default:
+        {
+            // Frames and polls: the I2C transfers themselves are marked in pal_i2c.c
+            break;
+        }
+    }
+}
+
+#endif // PAL_SYSVIEW_ENABLED
+
+/**
+* @}
+*/
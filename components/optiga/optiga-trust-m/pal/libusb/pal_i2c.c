@@ -58,20 +58,59 @@
 #define LOG_PAL(...) //printf(__VA_ARGS__)
 #endif
 
+/// Transfers of one I2C operation still in flight (pal_i2c_usb_t.pending)
+#define PAL_I2C_USB_REQUEST         (0x01)
+#define PAL_I2C_USB_RESPONSE        (0x02)
+#define PAL_I2C_USB_STATUS          (0x04)
+
+/// Status reads while the FT260 still reports the I2C controller busy, before giving up
+#define PAL_I2C_USB_STATUS_POLL_MAX (1000)
+
 /// @cond hidden
 /*********************************************************************************************************************
  * LOCAL DATA
  *********************************************************************************************************************/
 
+/**
+ * Asynchronous transfers of one I2C operation. A read posts the IN report for the data together with the OUT
+ * read request, so both are in flight at once. Completions are handled from the pal_os_event loop, which runs
+ * libusb_handle_events while it waits for the next timer callback.
+ */
+typedef struct pal_i2c_usb
+{
+    /// Interrupt OUT: write report or read request
+    struct libusb_transfer * p_request;
+    /// Interrupt IN: report with the data read
+    struct libusb_transfer * p_response;
+    /// Control IN: FT260 I2C status feature report
+    struct libusb_transfer * p_status;
+    uint8_t request[HID_REPORT_SIZE];
+    uint8_t response[HID_REPORT_SIZE];
+    uint8_t status[LIBUSB_CONTROL_SETUP_SIZE + HID_REPORT_SIZE];
+    /// Caller buffer and length of a read, NULL for a write
+    uint8_t * p_rx_data;
+    uint16_t rx_length;
+    /// PAL_I2C_USB_* transfers submitted and not completed yet
+    uint8_t pending;
+    /// Set once a transfer failed, the operation ends with #PAL_I2C_EVENT_ERROR
+    uint8_t failed;
+    /// Set once the status shows the I2C controller idle
+    uint8_t status_done;
+    uint16_t status_polls;
+} pal_i2c_usb_t;
+
 void i2c_master_end_of_transmit_callback(void);
 void i2c_master_end_of_receive_callback(void);
+void i2c_master_error_detected_callback(void);
 void invoke_upper_layer_callback(const pal_i2c_t * p_pal_i2c_ctx, optiga_lib_status_t event);
-static uint16_t usb_i2c_poll_operation_result(pal_i2c_t * p_i2c_context);
+static void LIBUSB_CALL pal_i2c_usb_transfer_done(struct libusb_transfer * p_transfer);
 
 /* Variable to indicate the re-entrant count of the i2c bus acquire function*/
 static volatile uint32_t g_entry_count = 0;
 /* Pointer to the current pal i2c context*/
 static pal_i2c_t * gp_pal_i2c_current_ctx;
+/* Transfers of the current I2C operation*/
+static pal_i2c_usb_t g_pal_i2c_usb;
 extern pal_usb_t usb_events;
 
 /**********************************************************************************************************************
@@ -160,33 +199,188 @@ void i2c_master_arbitration_lost_callback(void)
 }
 
 
-uint16_t usb_i2c_poll_operation_result(pal_i2c_t * p_i2c_context)
+// Allocates the transfers on first use, they are reused for every operation
+static pal_status_t pal_i2c_usb_alloc(pal_i2c_usb_t * p_usb)
+{
+    if (NULL == p_usb->p_request)
+    {
+        p_usb->p_request = libusb_alloc_transfer(0);
+        p_usb->p_response = libusb_alloc_transfer(0);
+        p_usb->p_status = libusb_alloc_transfer(0);
+    }
+    if ((NULL == p_usb->p_request) || (NULL == p_usb->p_response) || (NULL == p_usb->p_status))
+    {
+        return PAL_STATUS_FAILURE;
+    }
+    return PAL_STATUS_SUCCESS;
+}
+
+// Reads the FT260 I2C status; resubmitted from the completion while the controller is busy
+static int pal_i2c_usb_submit_status(pal_i2c_usb_t * p_usb, const pal_usb_t * p_pal_usb)
+{
+    int usb_lib_status;
+
+    libusb_fill_control_setup(p_usb->status,
+                              LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_CLASS | LIBUSB_RECIPIENT_INTERFACE,
+                              HID_REQ_GET_REPORT,
+                              (HID_REPORT_TYPE_FEATURE << 8) | REPORT_ID_I2C_STATUS,
+                              USB_INTERFACE,
+                              HID_REPORT_SIZE);
+    libusb_fill_control_transfer(p_usb->p_status,
+                                 p_pal_usb->handle,
+                                 p_usb->status,
+                                 pal_i2c_usb_transfer_done,
+                                 p_usb,
+                                 USB_TIMEOUT);
+    usb_lib_status = libusb_submit_transfer(p_usb->p_status);
+    if (0 == usb_lib_status)
+    {
+        p_usb->pending |= PAL_I2C_USB_STATUS;
+    }
+    return usb_lib_status;
+}
+
+// Submits the transfers of a write (p_rx_data NULL) or a read, the IN report ahead of the request
+static pal_status_t pal_i2c_usb_start(pal_i2c_usb_t * p_usb,
+                                      const pal_usb_t * p_pal_usb,
+                                      uint8_t * p_rx_data,
+                                      uint16_t rx_length)
 {
-    uint8_t report[HID_REPORT_SIZE] = {0};
-    LOG_PAL("usb_i2c_poll_operation_result\n. ");
-    while (1)
+    p_usb->p_rx_data = p_rx_data;
+    p_usb->rx_length = rx_length;
+    p_usb->pending = 0;
+    p_usb->failed = FALSE;
+    p_usb->status_done = FALSE;
+    p_usb->status_polls = 0;
+
+    if (NULL != p_rx_data)
     {
-        if (usb_hid_get_feature(REPORT_ID_I2C_STATUS, report, &usb_events) != 5)
+        memset(p_usb->response, 0x00, sizeof(p_usb->response));
+        libusb_fill_interrupt_transfer(p_usb->p_response,
+                                       p_pal_usb->handle,
+                                       p_pal_usb->hid_ep_in,
+                                       p_usb->response,
+                                       sizeof(p_usb->response),
+                                       pal_i2c_usb_transfer_done,
+                                       p_usb,
+                                       USB_TIMEOUT);
+        if (0 != libusb_submit_transfer(p_usb->p_response))
         {
-            LOG_PAL("[IFX-HAL]: USB get I2C status failed.\n");
-            return PAL_I2C_EVENT_ERROR;
+            return PAL_STATUS_FAILURE;
         }
+        p_usb->pending |= PAL_I2C_USB_RESPONSE;
+    }
 
-        if (!(report[1] & I2C_STATUS_CONTROLLER_BUSY))
+    libusb_fill_interrupt_transfer(p_usb->p_request,
+                                   p_pal_usb->handle,
+                                   p_pal_usb->hid_ep_out,
+                                   p_usb->request,
+                                   sizeof(p_usb->request),
+                                   pal_i2c_usb_transfer_done,
+                                   p_usb,
+                                   USB_TIMEOUT);
+    if (0 != libusb_submit_transfer(p_usb->p_request))
+    {
+        if (0 == p_usb->pending)
         {
-            if (report[1] & I2C_STATUS_ERROR_CONDITION)
-            {
-                return PAL_I2C_EVENT_ERROR;
-            }
+            return PAL_STATUS_FAILURE;
+        }
+        // The IN report is already posted, the error is reported once its cancellation completes
+        p_usb->failed = TRUE;
+        //lint --e{534} suppress "The transfer completes with LIBUSB_TRANSFER_CANCELLED or its own status"
+        libusb_cancel_transfer(p_usb->p_response);
+    }
+    return PAL_STATUS_SUCCESS;
+}
+
+// Completion of any transfer of the current operation, called from libusb_handle_events
+static void LIBUSB_CALL pal_i2c_usb_transfer_done(struct libusb_transfer * p_transfer)
+{
+    pal_i2c_usb_t * p_usb = (pal_i2c_usb_t * )p_transfer->user_data;
+    const uint8_t * p_report;
+    uint8_t completed = (LIBUSB_TRANSFER_COMPLETED == p_transfer->status);
 
-            if (report[1] & I2C_STATUS_CONTROLLER_IDLE)
+    if (p_transfer == p_usb->p_request)
+    {
+        p_usb->pending &= (uint8_t)~PAL_I2C_USB_REQUEST;
+        if (!completed || (HID_REPORT_SIZE != p_transfer->actual_length))
+        {
+            LOG_PAL("[IFX-HAL]: HID write failed, transfer status %d\n", p_transfer->status);
+            p_usb->failed = TRUE;
+        }
+    }
+    else if (p_transfer == p_usb->p_response)
+    {
+        p_usb->pending &= (uint8_t)~PAL_I2C_USB_RESPONSE;
+        if (completed && (p_transfer->actual_length >= (2 + p_usb->rx_length)) &&
+            (p_usb->response[1] == p_usb->rx_length))
+        {
+            memcpy(p_usb->p_rx_data, &p_usb->response[2], p_usb->rx_length);
+        }
+        else
+        {
+            LOG_PAL("[IFX-HAL]: HID read failed, transfer status %d\n", p_transfer->status);
+            p_usb->failed = TRUE;
+        }
+    }
+    else
+    {
+        p_usb->pending &= (uint8_t)~PAL_I2C_USB_STATUS;
+        p_report = libusb_control_transfer_get_data(p_transfer);
+        if (!completed || (5 != p_transfer->actual_length))
+        {
+            LOG_PAL("[IFX-HAL]: USB get I2C status failed.\n");
+            p_usb->failed = TRUE;
+        }
+        else if (p_report[1] & I2C_STATUS_CONTROLLER_BUSY)
+        {
+            if (++p_usb->status_polls >= PAL_I2C_USB_STATUS_POLL_MAX)
             {
-                if (!(report[1] & I2C_STATUS_BUS_BUSY))
-                {
-                    return PAL_STATUS_SUCCESS;
-                }
+                p_usb->failed = TRUE;
             }
         }
+        else if (p_report[1] & I2C_STATUS_ERROR_CONDITION)
+        {
+            print_status(p_report[1]);
+            p_usb->failed = TRUE;
+        }
+        else if ((p_report[1] & I2C_STATUS_CONTROLLER_IDLE) && !(p_report[1] & I2C_STATUS_BUS_BUSY))
+        {
+            p_usb->status_done = TRUE;
+        }
+    }
+
+    if (p_usb->failed && (p_usb->pending & PAL_I2C_USB_RESPONSE))
+    {
+        // A failed request is not answered, do not wait for the IN report to time out
+        //lint --e{534} suppress "The transfer completes with LIBUSB_TRANSFER_CANCELLED or its own status"
+        libusb_cancel_transfer(p_usb->p_response);
+    }
+    if (0 != p_usb->pending)
+    {
+        return;
+    }
+
+    if (!p_usb->failed && !p_usb->status_done)
+    {
+        if (0 == pal_i2c_usb_submit_status(p_usb, (pal_usb_t * )gp_pal_i2c_current_ctx->p_i2c_hw_config))
+        {
+            return;
+        }
+        p_usb->failed = TRUE;
+    }
+
+    if (p_usb->failed)
+    {
+        i2c_master_error_detected_callback();
+    }
+    else if (NULL != p_usb->p_rx_data)
+    {
+        i2c_master_end_of_receive_callback();
+    }
+    else
+    {
+        i2c_master_end_of_transmit_callback();
     }
 }
 
@@ -248,6 +442,15 @@ pal_status_t pal_i2c_init(const pal_i2c_t * p_i2c_context)
 pal_status_t pal_i2c_deinit(const pal_i2c_t * p_i2c_context)
 {
     LOG_PAL("pal_i2c_deinit\n. ");
+    if ((NULL != g_pal_i2c_usb.p_request) && (0 == g_pal_i2c_usb.pending))
+    {
+        libusb_free_transfer(g_pal_i2c_usb.p_request);
+        libusb_free_transfer(g_pal_i2c_usb.p_response);
+        libusb_free_transfer(g_pal_i2c_usb.p_status);
+        g_pal_i2c_usb.p_request = NULL;
+        g_pal_i2c_usb.p_response = NULL;
+        g_pal_i2c_usb.p_status = NULL;
+    }
     return PAL_STATUS_SUCCESS;
 }
 
@@ -287,32 +490,26 @@ pal_status_t pal_i2c_deinit(const pal_i2c_t * p_i2c_context)
 pal_status_t pal_i2c_write(const pal_i2c_t * p_i2c_context, uint8_t * p_data, uint16_t length)
 {
     pal_status_t status = PAL_STATUS_FAILURE;
-    int32_t usb_lib_status;
-    int32_t transfered = 0;
     pal_usb_t * pal_usb;
-    uint8_t report[HID_REPORT_SIZE] = {0};
+    uint8_t * report = g_pal_i2c_usb.request;
 
     pal_usb = (pal_usb_t * ) p_i2c_context->p_i2c_hw_config;
-    report[0] = REPORT_ID_I2C_WRITE_REQ;
-    report[1] = p_i2c_context->slave_address;
-    report[2] = I2C_FLAG_START | I2C_FLAG_STOP;
-    report[3] = (uint8_t)length;
 
-    memcpy(&report[4], p_data, length);
     //Acquire the I2C bus before read/write
-
     if (PAL_STATUS_SUCCESS == pal_i2c_acquire(p_i2c_context))
     {
         gp_pal_i2c_current_ctx = (pal_i2c_t *)p_i2c_context;
 
-        //Invoke the low level i2c master driver API to write to the bus
-        usb_lib_status = libusb_interrupt_transfer(pal_usb->handle,
-                                                   pal_usb->hid_ep_out,
-                                                   report,
-                                                   sizeof(report),
-                                                   &transfered,
-                                                   USB_TIMEOUT);
-        if (usb_lib_status != 0 || transfered != HID_REPORT_SIZE)
+        memset(report, 0x00, HID_REPORT_SIZE);
+        report[0] = REPORT_ID_I2C_WRITE_REQ;
+        report[1] = p_i2c_context->slave_address;
+        report[2] = I2C_FLAG_START | I2C_FLAG_STOP;
+        report[3] = (uint8_t)length;
+        memcpy(&report[4], p_data, length);
+
+        //Submit the write report, the status is polled from its completion
+        if ((PAL_STATUS_SUCCESS != pal_i2c_usb_alloc(&g_pal_i2c_usb)) ||
+            (PAL_STATUS_SUCCESS != pal_i2c_usb_start(&g_pal_i2c_usb, pal_usb, NULL, 0)))
         {
             //If I2C Master fails to invoke the write operation, invoke upper layer event handler with error.
             //lint --e{611} suppress "void* function pointer is type casted to app_event_handler_t type"
@@ -323,15 +520,7 @@ pal_status_t pal_i2c_write(const pal_i2c_t * p_i2c_context, uint8_t * p_data, ui
         }
         else
         {
-            if (usb_i2c_poll_operation_result((pal_i2c_t *)p_i2c_context) == PAL_STATUS_SUCCESS)
-            {
-                i2c_master_end_of_transmit_callback();
-                status = PAL_STATUS_SUCCESS;
-            }
-            else
-            {
-                invoke_upper_layer_callback(gp_pal_i2c_current_ctx, PAL_I2C_EVENT_ERROR);
-            }
+            status = PAL_STATUS_SUCCESS;
         }
     }
     else
@@ -378,71 +567,47 @@ pal_status_t pal_i2c_write(const pal_i2c_t * p_i2c_context, uint8_t * p_data, ui
  */
 pal_status_t pal_i2c_read(const pal_i2c_t * p_i2c_context, uint8_t * p_data, uint16_t length)
 {
-    int32_t usb_lib_status = PAL_STATUS_FAILURE;
-    int32_t transfered;
-    uint8_t report[HID_REPORT_SIZE] = {0};
-    uint16_t rx_result;
+    pal_status_t status = PAL_STATUS_FAILURE;
     pal_usb_t * pal_usb;
+    uint8_t * report = g_pal_i2c_usb.request;
     LOG_PAL("[IFX-HAL]: I2C RX (%d)\n", length);
 
-    report[0] = REPORT_ID_I2C_READ_REQ;
-    report[1] = p_i2c_context->slave_address;
-    report[2] = I2C_FLAG_START | I2C_FLAG_STOP;
-    report[3] = (uint8_t)length;
-    report[4] = 0;
     pal_usb = (pal_usb_t * ) p_i2c_context->p_i2c_hw_config;
     //Acquire the I2C bus before read/write
     if (PAL_STATUS_SUCCESS == pal_i2c_acquire(p_i2c_context))
     {
         gp_pal_i2c_current_ctx = (pal_i2c_t *)p_i2c_context;
-        usb_lib_status = libusb_interrupt_transfer(pal_usb->handle,
-                                                   pal_usb->hid_ep_out,
-                                                   report,
-                                                   sizeof(report),
-                                                   &transfered,
-                                                   USB_TIMEOUT);
-        LOG_PAL("[IFX-HAL]: HID Write status = %d, %d\n", usb_lib_status, transfered);
-        if (usb_lib_status)
-        {
-            LOG_PAL("[IFX-HAL]: libusb_interrupt_transfer ERROR %d\n.", usb_lib_status);
-            //lint --e{611} suppress "void* function pointer is type casted to app_event_handler_t type"
-            ((upper_layer_callback_t)(p_i2c_context->upper_layer_event_handler))
-                                                       (p_i2c_context->p_upper_layer_ctx, PAL_I2C_EVENT_ERROR);
-            return usb_lib_status;
-        }
-        //Invoke the low level i2c master driver API to read from the bus
-        memset(report, 0x00, sizeof(report));
-        transfered = 0;
-        usb_lib_status = libusb_interrupt_transfer(pal_usb->handle,
-                                                   pal_usb->hid_ep_in,
-                                                   report,
-                                                   sizeof(report),
-                                                   &transfered,
-                                                   USB_TIMEOUT);
-        rx_result = usb_i2c_poll_operation_result((pal_i2c_t *)p_i2c_context);
-        if (rx_result == PAL_STATUS_SUCCESS && usb_lib_status == 0 && transfered >= (2 + length) && report[1] == length)
-        {
-            memcpy(p_data, &report[2], report[1]);
-            usb_lib_status = PAL_STATUS_SUCCESS;
-            i2c_master_end_of_receive_callback();
-        }
-        else
+
+        memset(report, 0x00, HID_REPORT_SIZE);
+        report[0] = REPORT_ID_I2C_READ_REQ;
+        report[1] = p_i2c_context->slave_address;
+        report[2] = I2C_FLAG_START | I2C_FLAG_STOP;
+        report[3] = (uint8_t)length;
+
+        //Submit the IN report for the data and the read request together
+        if ((PAL_STATUS_SUCCESS != pal_i2c_usb_alloc(&g_pal_i2c_usb)) ||
+            (PAL_STATUS_SUCCESS != pal_i2c_usb_start(&g_pal_i2c_usb, pal_usb, p_data, length)))
         {
+            LOG_PAL("[IFX-HAL]: libusb_submit_transfer ERROR\n.");
             //lint --e{611} suppress "void* function pointer is type casted to app_event_handler_t type"
             ((upper_layer_callback_t)(p_i2c_context->upper_layer_event_handler))
                                                         (p_i2c_context->p_upper_layer_ctx, PAL_I2C_EVENT_ERROR);
             //Release I2C Bus
             pal_i2c_release((void * )p_i2c_context);
         }
+        else
+        {
+            status = PAL_STATUS_SUCCESS;
+        }
     }
     else
     {
-        usb_lib_status = PAL_STATUS_I2C_BUSY;
+        status = PAL_STATUS_I2C_BUSY;
         //lint --e{611} suppress "void* function pointer is type casted to app_event_handler_t type"
         ((upper_layer_callback_t)(p_i2c_context->upper_layer_event_handler))
                                                         (p_i2c_context->p_upper_layer_ctx, PAL_I2C_EVENT_BUSY);
     }
-    return usb_lib_status;
+    return status;
 }
 
 
@@ -37,15 +37,13 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
-#include <errno.h>
 #include <time.h>
 #ifdef __WIN32__
 #include <windows.h>
-#else
-#include <signal.h>
 #endif
 #include "optiga/pal/pal_os_timer.h"
 #include "optiga/pal/pal_os_event.h"
+#include "pal_usb.h"
 
 //#define TRUSTM_PAL_EVENT_DEBUG
 
@@ -65,32 +63,36 @@
 
 #endif
 
+/// Wait of one loop iteration when no callback is registered
+#define PAL_OS_EVENT_IDLE_WAIT_US       (10000)
+/// Shorter waits are polled, a blocking wait would round them up to a full millisecond
+#define PAL_OS_EVENT_MIN_BLOCKING_US    (1000)
+
 /// @cond hidden
 
 static pal_os_event_t pal_os_event_0 = {0};
-#ifdef __WIN32__
-HANDLE gTimerQueue = NULL;
-HANDLE gTimer = NULL;
-#else
-#define CLOCKID CLOCK_REALTIME
-#define SIG SIGRTMIN
-static     timer_t timerid;
-#endif
+/// Time at which the registered callback is due, see pal_os_event_now_us
+static uint64_t pal_os_event_due_us;
+extern pal_usb_t usb_events;
 
-#ifdef __WIN32__
-VOID CALLBACK TimerRoutine(PVOID lpParam, BOOLEAN TimerOrWaitFired)
+// Monotonic time in microseconds
+static uint64_t pal_os_event_now_us(void)
 {
-	pal_os_event_trigger_registered_callback();
-	//printf("<- \r\n");
-}
+#ifdef __WIN32__
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return ((uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000) +
+           (((uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000) / (uint64_t)frequency.QuadPart);
 #else
-static void handler(int sig, siginfo_t *si, void *uc)
-{
-	TRUSTM_PAL_EVENT_DBGFN(">");
-	pal_os_event_trigger_registered_callback();
-	TRUSTM_PAL_EVENT_DBGFN("<");
-}
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
 #endif
+}
 
 void pal_os_event_start(pal_os_event_t * p_pal_os_event, register_callback callback, void * callback_args)
 {
@@ -107,186 +109,84 @@ void pal_os_event_stop(pal_os_event_t * p_pal_os_event)
     p_pal_os_event->is_event_triggered = FALSE;
 }
 
-#ifdef __WIN32__
 pal_os_event_t * pal_os_event_create(register_callback callback, void * callback_args)
-{	
-	if ((NULL != callback) && (NULL != callback_args))
-	{
-		// Create the timer queue.
-		gTimerQueue = CreateTimerQueue();
-		if (NULL == gTimerQueue)
-		{
-			printf("CreateTimerQueue failed (%d)\n", GetLastError());
-			return NULL;
-		}
-		pal_os_event_start(&pal_os_event_0, callback, callback_args);
-	}
-    
-    return (&pal_os_event_0);
-}
-
-
-void pal_os_event_trigger_registered_callback(void)
 {
-    register_callback callback;
-
-	DeleteTimerQueueTimer( gTimerQueue, gTimer, NULL );
+    TRUSTM_PAL_EVENT_DBGFN(">");
 
-    if (pal_os_event_0.callback_registered)
+    if(( NULL != callback )&&( NULL != callback_args ))
     {
-        callback = pal_os_event_0.callback_registered;
-        pal_os_event_0.callback_registered = NULL;
-        callback((void * )pal_os_event_0.callback_ctx);
+        pal_os_event_start(&pal_os_event_0,callback,callback_args);
     }
 
-}
-
-/// @endcond
-
-void pal_os_event_register_callback_oneshot(pal_os_event_t * p_pal_os_event,
-                                            register_callback callback,
-                                            void * callback_args,
-                                            uint32_t time_us)
-{
-	UINT uTimerLoad = 0;
-
-	uTimerLoad = time_us / 1000;
-
-	if (uTimerLoad == 0) 
-		uTimerLoad = 1;
-
-	//printf("oneshot %d ms\r\n", time_us);
-
-	if (gTimerQueue)
-	{
-		p_pal_os_event->callback_registered = callback;
-		p_pal_os_event->callback_ctx = callback_args;
-
-		// Set a timer to call the timer routine.
-		if (!CreateTimerQueueTimer(&gTimer, gTimerQueue,
-			(WAITORTIMERCALLBACK)TimerRoutine, &uTimerLoad, 0, 0, 0))
-		{
-			printf("CreateTimerQueueTimer failed (%d)\n", GetLastError());
-			return;
-		}
-	}
-}
-
-//lint --e{818,715} suppress "As there is no implementation, pal_os_event is not used"
-void pal_os_event_destroy(pal_os_event_t * pal_os_event)
-{ 
-	if (!DeleteTimerQueue(gTimerQueue))
-		printf("DeleteTimerQueue failed (%d)\n", GetLastError());
+    TRUSTM_PAL_EVENT_DBGFN("<");
 
-	gTimerQueue = NULL;
+    return (&pal_os_event_0);
 }
-#else
 
-pal_os_event_t * pal_os_event_create(register_callback callback, void * callback_args)
+/**
+ * One iteration of the event loop, called repeatedly by optiga_comms while an operation is in progress.
+ * Waits for USB completions until the registered callback is due, then invokes it. The PAL I2C transfers
+ * complete from libusb_handle_events here, on the caller's thread, so no signal or timer thread is involved.
+ */
+void pal_os_event_trigger_registered_callback(void)
 {
-    struct sigevent sev;
-    struct sigaction sa;
-    
+    register_callback callback;
+    struct timeval timeout;
+    uint64_t now_us = pal_os_event_now_us();
+    uint64_t wait_us = 0;
+
     TRUSTM_PAL_EVENT_DBGFN(">");
-    
-    if(( NULL != callback )&&( NULL != callback_args ))
+
+    if (NULL == pal_os_event_0.callback_registered)
+    {
+        wait_us = PAL_OS_EVENT_IDLE_WAIT_US;
+    }
+    else if (pal_os_event_due_us > now_us)
+    {
+        wait_us = pal_os_event_due_us - now_us;
+    }
+    if (wait_us < PAL_OS_EVENT_MIN_BLOCKING_US)
     {
-        /* Establishing handler for signal */
-        sa.sa_flags = SA_SIGINFO;
-        sa.sa_sigaction = handler;
-        sigemptyset(&sa.sa_mask);
-        if (sigaction(SIG, &sa, NULL) == -1)
-        {
-            printf("sigaction\n");
-            exit(1);
-        }
-
-        /* Create the timer */
-
-        sev.sigev_notify = SIGEV_SIGNAL;
-        sev.sigev_signo = SIG;
-        sev.sigev_value.sival_ptr = &timerid;
-        if (timer_create(CLOCKID, &sev, &timerid) == -1)
-        {
-            printf("error in timer_create\n");
-            exit(1);
-        }
+        wait_us = 0;
+    }
 
-        pal_os_event_start(&pal_os_event_0,callback,callback_args);
+    if (NULL != usb_events.handle)
+    {
+        // Returns on the first USB completion or when the callback is due
+        timeout.tv_sec = (long)(wait_us / 1000000);
+        timeout.tv_usec = (long)(wait_us % 1000000);
+        //lint --e{534} suppress "Transfer errors are reported through the transfer callbacks"
+        libusb_handle_events_timeout_completed(NULL, &timeout, NULL);
     }
-    
-    TRUSTM_PAL_EVENT_DBGFN("<");
-    
-    return (&pal_os_event_0);
-}
-	
-void pal_os_event_trigger_registered_callback(void)
-{
-    register_callback callback;
-    struct itimerspec its;
-
-    TRUSTM_PAL_EVENT_DBGFN(">");  
-    
-    its.it_value.tv_sec = 0;
-    its.it_value.tv_nsec = 0;
-    its.it_interval.tv_sec = 0;
-    its.it_interval.tv_nsec = 0;
-    
-    if (timer_settime(timerid, 0, &its, NULL) == -1)
+    else if (0 != wait_us)
     {
-        fprintf(stderr, "Error in timer_settime\n");
-        exit(1);
+        pal_os_timer_delay_in_milliseconds((uint16_t)(wait_us / 1000));
     }
 
-    if (pal_os_event_0.callback_registered)
+    if ((NULL != pal_os_event_0.callback_registered) && (pal_os_event_now_us() >= pal_os_event_due_us))
     {
         callback = pal_os_event_0.callback_registered;
         pal_os_event_0.callback_registered = NULL;
         callback((void * )pal_os_event_0.callback_ctx);
     }
 
-    TRUSTM_PAL_EVENT_DBGFN("<"); 
+    TRUSTM_PAL_EVENT_DBGFN("<");
 }
 
+/// @endcond
+
 void pal_os_event_register_callback_oneshot(pal_os_event_t * p_pal_os_event,
-                                             register_callback callback,
-                                             void * callback_args,
-                                             uint32_t time_us)
+                                            register_callback callback,
+                                            void * callback_args,
+                                            uint32_t time_us)
 {
-    struct itimerspec its;
-    long long freq_nanosecs;
-    int ret = 0;
-    //sigset_t mask;
-
     TRUSTM_PAL_EVENT_DBGFN(">");
-    
-    //uint8_t scheduler_timer;
+
     p_pal_os_event->callback_registered = callback;
     p_pal_os_event->callback_ctx = callback_args;
-    
-    /* Start the timer */
-    freq_nanosecs = time_us * 1000;
-    its.it_value.tv_sec = (freq_nanosecs / 1000000000);
-    its.it_value.tv_nsec = (freq_nanosecs % 1000000000);
-    its.it_interval.tv_sec = 0;
-    its.it_interval.tv_nsec = 0;
-    
-    if (( ret = timer_settime(timerid, 0, &its, NULL)) == -1)    
-    {
-        int errsv = errno;
-        fprintf(stderr,"timer_settime FAILED!!!\n");
-        if(errsv == EINVAL)
-        {
-            fprintf(stderr,"INVALID VALUE!\n");
-        }
-        else
-        {
-            fprintf(stderr,"UNKOWN ERROR: %d\n",errsv);
-        }
-        exit(1);
-    }
-    
-    TRUSTM_PAL_EVENT_DBGFN("<"); 
+    pal_os_event_due_us = pal_os_event_now_us() + time_us;
+
+    TRUSTM_PAL_EVENT_DBGFN("<");
 }
 
 //lint --e{818,715} suppress "As there is no implementation, pal_os_event is not used"
@@ -294,14 +194,12 @@ void pal_os_event_destroy(pal_os_event_t * pal_os_event)
 {
     TRUSTM_PAL_EVENT_DBGFN(">");
     if (pal_os_event != NULL)
-        pal_os_event_stop(pal_os_event);
-    if (timerid != 0)
     {
-        timer_delete(timerid);
+        pal_os_event_stop(pal_os_event);
+        pal_os_event->callback_registered = NULL;
     }
-    TRUSTM_PAL_EVENT_DBGFN("<"); 
+    TRUSTM_PAL_EVENT_DBGFN("<");
 }
-#endif
 
 /**
 * @}
@@ -34,6 +34,7 @@
 * @{
 */
 
+#include <linux/i2c.h>
 #include <linux/i2c-dev.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
@@ -53,6 +54,15 @@
 #define IFXI2C_SLAVE_ADDRESS_INIT 0xFFFF
 #define PAL_I2C_MASTER_MAX_BITRATE 100
 #define WAIT_500_MS	(500)
+
+#ifndef PAL_I2C_COMBINED_READ
+/**
+ * 1: a register address write is held back and sent with the read that follows as one I2C_RDWR
+ * transfer (repeated start, no stop in between), one ioctl per register read instead of a write()
+ * and a read(). Only for adapters and slaves that support the combined format.
+ */
+#define PAL_I2C_COMBINED_READ (0)
+#endif
 /// @cond hidden
 
 void i2c_master_end_of_transmit_callback(void);
@@ -60,19 +70,18 @@ void i2c_master_end_of_receive_callback(void);
 void invoke_upper_layer_callback (const pal_i2c_t* p_pal_i2c_ctx, optiga_lib_status_t event);
 uint16_t usb_i2c_poll_operation_result(pal_i2c_t* p_i2c_context);
 
-/* Varibale to indicate the re-entrant count of the i2c bus acquire function*/
-static volatile uint32_t g_entry_count = 0;
-
 /* Pointer to the current pal i2c context*/
 static pal_i2c_t * gp_pal_i2c_current_ctx;
 
-//lint --e{715} suppress the unused p_i2c_context variable lint error , since this is kept for future enhancements
+// I2C acquire bus function, the count is kept per bus so that OPTIGA instances on other buses run in parallel
 static pal_status_t pal_i2c_acquire(const void * p_i2c_context)
 {
-    if (0 == g_entry_count)
+    pal_linux_t * pal_linux = (pal_linux_t *)((const pal_i2c_t *)p_i2c_context)->p_i2c_hw_config;
+
+    if (0 == pal_linux->entry_count)
     {
-        g_entry_count++;
-        if (1 == g_entry_count)
+        pal_linux->entry_count++;
+        if (1 == pal_linux->entry_count)
         {
             return PAL_STATUS_SUCCESS;
         }
@@ -81,10 +90,9 @@ static pal_status_t pal_i2c_acquire(const void * p_i2c_context)
 }
 
 // I2C release bus function
-//lint --e{715} suppress the unused p_i2c_context variable lint, since this is kept for future enhancements
 static void pal_i2c_release(const void* p_i2c_context)
 {
-    g_entry_count = 0;
+    ((pal_linux_t *)((const pal_i2c_t *)p_i2c_context)->p_i2c_hw_config)->entry_count = 0;
 }
 /// @endcond
 
@@ -97,7 +105,7 @@ void invoke_upper_layer_callback (const pal_i2c_t * p_pal_i2c_ctx, optiga_lib_st
     upper_layer_handler(p_pal_i2c_ctx->p_upper_layer_ctx , event);
 
     //Release I2C Bus
-    pal_i2c_release(p_pal_i2c_ctx->p_upper_layer_ctx );
+    pal_i2c_release(p_pal_i2c_ctx);
 }
 
 /// @cond hidden
@@ -202,6 +210,16 @@ pal_status_t pal_i2c_write(const pal_i2c_t* p_i2c_context,uint8_t* p_data , uint
     {
         gp_pal_i2c_current_ctx = (pal_i2c_t *)p_i2c_context;
 
+#if PAL_I2C_COMBINED_READ
+        // A lone register address only selects the register for the next read
+        pal_linux->read_register_pending = (1 == length);
+        if (pal_linux->read_register_pending)
+        {
+            pal_linux->read_register = p_data[0];
+            invoke_upper_layer_callback(p_i2c_context, PAL_I2C_EVENT_SUCCESS);
+            return PAL_STATUS_SUCCESS;
+        }
+#endif
         //Invoke the low level i2c master driver API to write to the bus
 
 		i2c_write_status = write(pal_linux->i2c_handle, p_data, length);
@@ -218,7 +236,7 @@ pal_status_t pal_i2c_write(const pal_i2c_t* p_i2c_context,uint8_t* p_data , uint
         }
         else
         {
-        	i2c_master_end_of_transmit_callback();
+        	invoke_upper_layer_callback(p_i2c_context, PAL_I2C_EVENT_SUCCESS);
             status = PAL_STATUS_SUCCESS;
 			//transmission_completed = true;
         }
@@ -246,6 +264,26 @@ pal_status_t pal_i2c_read(const pal_i2c_t* p_i2c_context , uint8_t* p_data , uin
     if (PAL_STATUS_SUCCESS == pal_i2c_acquire(p_i2c_context))
     {    
         gp_pal_i2c_current_ctx = (pal_i2c_t *)p_i2c_context;
+#if PAL_I2C_COMBINED_READ
+		if (pal_linux->read_register_pending)
+		{
+			struct i2c_msg messages[2];
+			struct i2c_rdwr_ioctl_data transfer;
+
+			messages[0].addr = p_i2c_context->slave_address;
+			messages[0].flags = 0;
+			messages[0].len = 1;
+			messages[0].buf = &pal_linux->read_register;
+			messages[1].addr = p_i2c_context->slave_address;
+			messages[1].flags = I2C_M_RD;
+			messages[1].len = length;
+			messages[1].buf = p_data;
+			transfer.msgs = messages;
+			transfer.nmsgs = 2;
+			i2c_read_status = ioctl(pal_linux->i2c_handle, I2C_RDWR, &transfer);
+		}
+		else
+#endif
 		i2c_read_status = read(pal_linux->i2c_handle,p_data, length);
 		if (0 > i2c_read_status)
 		{
@@ -267,7 +305,7 @@ pal_status_t pal_i2c_read(const pal_i2c_t* p_i2c_context , uint8_t* p_data , uin
 			}
 #endif
 			
-			i2c_master_end_of_receive_callback();
+			invoke_upper_layer_callback(p_i2c_context, PAL_I2C_EVENT_SUCCESS);
 			i2c_read_status = PAL_STATUS_SUCCESS;
 			//reception_started = true;
         }
@@ -55,6 +55,12 @@ typedef struct pal_linux
     int i2c_handle;
     /// Pointer to store the callers handler
     void * upper_layer_event_handler;
+    /// Set while a transfer on this bus is in progress, each OPTIGA instance has its own bus
+    volatile uint32_t entry_count;
+    /// Register address held back for the next read (PAL_I2C_COMBINED_READ)
+    uint8_t read_register;
+    /// Set while read_register is to be sent with the reads
+    uint8_t read_register_pending;
 } pal_linux_t;
 
 typedef struct pal_linux_gpio {
@@ -38,11 +38,14 @@
 #include <stdint.h>
 #include <unistd.h>
 #include <stdio.h>
-#include <signal.h>
 #include <time.h>
-#include <errno.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 #include "optiga/pal/pal_os_timer.h"
 #include "optiga/pal/pal_os_event.h"
+#include "optiga/optiga_lib_config.h"
 
 //#define TRUSTM_PAL_EVENT_DEBUG = 1
 
@@ -62,22 +65,123 @@
 
 #endif
 
-#define CLOCKID CLOCK_REALTIME
-#define SIG SIGRTMIN
+/// One event per OPTIGA instance, each with its own loop thread so that the blocking I2C transfers
+/// of one device do not hold back the other
+#define PAL_OS_EVENT_MAX_INSTANCES      (OPTIGA_MAX_INSTANCES)
 
+/// @cond hidden
 
-static void handler(int sig, siginfo_t *si, void *uc)
+/*
+* The callbacks of an event run on its own loop thread, which waits in epoll on a CLOCK_MONOTONIC
+* timerfd (the registered one shot) and an eventfd (stop request). There is no signal handler, so
+* the callbacks may take locks and call any library function.
+*/
+typedef struct pal_os_event_loop
+{
+    pthread_mutex_t mutex;
+    pthread_t thread;
+    int epoll_fd;
+    int timer_fd;
+    int stop_fd;
+    /// Time at which the registered callback is due, in ns of CLOCK_MONOTONIC
+    uint64_t due_ns;
+    /// Set once the descriptors exist and the thread runs
+    uint8_t started;
+} pal_os_event_loop_t;
+
+static pal_os_event_t pal_os_event_list[PAL_OS_EVENT_MAX_INSTANCES] = {0};
+static pal_os_event_loop_t pal_os_event_loops[PAL_OS_EVENT_MAX_INSTANCES];
+/// Number of events handed out by pal_os_event_create
+static uint8_t pal_os_event_count = 0;
+
+static void pal_os_event_process(pal_os_event_t * p_pal_os_event);
+
+static pal_os_event_loop_t * pal_os_event_loop_of(const pal_os_event_t * p_pal_os_event)
 {
-	TRUSTM_PAL_EVENT_DBGFN(">");    
-	pal_os_event_trigger_registered_callback();
-	TRUSTM_PAL_EVENT_DBGFN("<");    
+    return (&pal_os_event_loops[p_pal_os_event - pal_os_event_list]);
 }
 
+static uint64_t pal_os_event_now_ns(void)
+{
+    struct timespec now;
 
-/// @cond hidden
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+static void * pal_os_event_loop(void * arg)
+{
+    pal_os_event_t * p_pal_os_event = (pal_os_event_t * )arg;
+    pal_os_event_loop_t * p_loop = pal_os_event_loop_of(p_pal_os_event);
+    struct epoll_event events[2];
+    uint64_t expirations;
+    int count;
+    int i;
+
+    for (;;)
+    {
+        count = epoll_wait(p_loop->epoll_fd, events, 2, -1);
+        if (count < 0)
+        {
+            continue;
+        }
+        for (i = 0; i < count; i++)
+        {
+            if (p_loop->stop_fd == events[i].data.fd)
+            {
+                return NULL;
+            }
+            if (sizeof(expirations) == read(p_loop->timer_fd, &expirations, sizeof(expirations)))
+            {
+                pal_os_event_process(p_pal_os_event);
+            }
+        }
+    }
+}
+
+// Creates the descriptors and starts the loop thread of an event once
+static int pal_os_event_loop_start(pal_os_event_t * p_pal_os_event)
+{
+    pal_os_event_loop_t * p_loop = pal_os_event_loop_of(p_pal_os_event);
+    struct epoll_event event = {0};
+
+    if (p_loop->started)
+    {
+        return 0;
+    }
 
-static pal_os_event_t pal_os_event_0 = {0};
-static 	timer_t timerid;
+    pthread_mutex_init(&p_loop->mutex, NULL);
+    p_loop->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    p_loop->stop_fd = eventfd(0, EFD_CLOEXEC);
+    p_loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if ((p_loop->timer_fd < 0) || (p_loop->stop_fd < 0) || (p_loop->epoll_fd < 0))
+    {
+        TRUSTM_PAL_EVENT_ERRFN("timerfd/eventfd/epoll_create1");
+        return -1;
+    }
+
+    event.events = EPOLLIN;
+    event.data.fd = p_loop->timer_fd;
+    if (0 != epoll_ctl(p_loop->epoll_fd, EPOLL_CTL_ADD, p_loop->timer_fd, &event))
+    {
+        TRUSTM_PAL_EVENT_ERRFN("epoll_ctl");
+        return -1;
+    }
+    event.data.fd = p_loop->stop_fd;
+    if (0 != epoll_ctl(p_loop->epoll_fd, EPOLL_CTL_ADD, p_loop->stop_fd, &event))
+    {
+        TRUSTM_PAL_EVENT_ERRFN("epoll_ctl");
+        return -1;
+    }
+
+    if (0 != pthread_create(&p_loop->thread, NULL, pal_os_event_loop, p_pal_os_event))
+    {
+        TRUSTM_PAL_EVENT_ERRFN("pthread_create");
+        return -1;
+    }
+    p_loop->started = TRUE;
+    return 0;
+}
 
 void pal_os_event_start(pal_os_event_t * p_pal_os_event, register_callback callback, void * callback_args)
 {
@@ -103,117 +207,62 @@ void pal_os_event_stop(pal_os_event_t * p_pal_os_event)
 
 }
 
-void pal_os_event_disarm(void)
-{
-	struct itimerspec its;
-
-	TRUSTM_PAL_EVENT_DBGFN(">");    
-	its.it_value.tv_sec = 0;
-	its.it_value.tv_nsec = 0;
-	its.it_interval.tv_sec = 0;
-	its.it_interval.tv_nsec = 0;
-	
-	if (timer_settime(timerid, 0, &its, NULL) == -1)
-	{
-		printf("Error in timer_settime\n");
-	    exit(1);
-	}
-
-	TRUSTM_PAL_EVENT_DBGFN("<");    
-} 
-
-void pal_os_event_arm(void)
-{   
-	struct itimerspec its;
-
-	TRUSTM_PAL_EVENT_DBGFN(">");    
-	its.it_value.tv_sec = 0;
-	its.it_value.tv_nsec = 1000000;
-	its.it_interval.tv_sec = 0;
-	its.it_interval.tv_nsec = 294967296;
-	
-	if (timer_settime(timerid, 0, &its, NULL) == -1)
-	{
-		printf("Error in timer_settime\n");
-	    exit(1);
-	}
-
-	TRUSTM_PAL_EVENT_DBGFN("<");    
-} 
-
-void pal_os_event_destroy1(void)
-{
-    TRUSTM_PAL_EVENT_DBGFN(">");    
-    timer_delete(timerid);
-    TRUSTM_PAL_EVENT_DBGFN("<");    
-}
-
 pal_os_event_t * pal_os_event_create(register_callback callback, void * callback_args)
 {
-    struct sigevent sev;
-    struct sigaction sa;
+    pal_os_event_t * p_pal_os_event = NULL;
 
     TRUSTM_PAL_EVENT_DBGFN(">");    
-	
-    if(( NULL != callback )&&( NULL != callback_args ))
-    {
-		/* Establishing handler for signal */
-		
-        sa.sa_flags = SA_SIGINFO;
-        sa.sa_sigaction = handler;
-        sigemptyset(&sa.sa_mask);
-        if (sigaction(SIG, &sa, NULL) == -1)
-        {
-            printf("sigaction\n");
-            exit(1);
-        }
-
-        /* Create the timer */
 
-        sev.sigev_notify = SIGEV_SIGNAL;
-        sev.sigev_signo = SIG;
-        sev.sigev_value.sival_ptr = &timerid;
-        if (timer_create(CLOCKID, &sev, &timerid) == -1)
+    // Called once per OPTIGA instance from optiga_cmd_create
+    if (pal_os_event_count < PAL_OS_EVENT_MAX_INSTANCES)
+    {
+        p_pal_os_event = &pal_os_event_list[pal_os_event_count++];
+        if(( NULL != callback )&&( NULL != callback_args ))
         {
-            printf("timer_create\n");
-            exit(1);
+            pal_os_event_start(p_pal_os_event,callback,callback_args);
         }
-
-        pal_os_event_start(&pal_os_event_0,callback,callback_args);
     }
 
     TRUSTM_PAL_EVENT_DBGFN("<");    
     
-    return (&pal_os_event_0);
+    return (p_pal_os_event);
 }
 
-void pal_os_event_trigger_registered_callback(void)
+// Runs the registered callback of an event if it is due
+static void pal_os_event_process(pal_os_event_t * p_pal_os_event)
 {
-    register_callback callback;
-    struct itimerspec its;
+    pal_os_event_loop_t * p_loop = pal_os_event_loop_of(p_pal_os_event);
+    register_callback callback = NULL;
+    void * callback_ctx = NULL;
 
     TRUSTM_PAL_EVENT_DBGFN(">");  
-    
-    its.it_value.tv_sec = 0;
-    its.it_value.tv_nsec = 0;
-    its.it_interval.tv_sec = 0;
-    its.it_interval.tv_nsec = 0;
-    
-    if (timer_settime(timerid, 0, &its, NULL) == -1)
+
+    if (!p_loop->started)
     {
-        fprintf(stderr, "Error in timer_settime\n");
-        exit(1);
+        return;
     }
+    pthread_mutex_lock(&p_loop->mutex);
+    // A one shot registered again after the expiry is due later, the timerfd fires again for it
+    if ((NULL != p_pal_os_event->callback_registered) && (pal_os_event_now_ns() >= p_loop->due_ns))
+    {
+        callback = p_pal_os_event->callback_registered;
+        callback_ctx = p_pal_os_event->callback_ctx;
+        p_pal_os_event->callback_registered = NULL;
+    }
+    pthread_mutex_unlock(&p_loop->mutex);
 
-    if (pal_os_event_0.callback_registered)
+    if (NULL != callback)
     {
-        callback = pal_os_event_0.callback_registered;
-        pal_os_event_0.callback_registered = NULL;
-        callback((void * )pal_os_event_0.callback_ctx);
+        callback(callback_ctx);
     }
 
     TRUSTM_PAL_EVENT_DBGFN("<"); 
 }
+
+void pal_os_event_trigger_registered_callback(void)
+{
+    pal_os_event_process(&pal_os_event_list[0]);
+}
 /// @endcond
 
 void pal_os_event_register_callback_oneshot(pal_os_event_t * p_pal_os_event,
@@ -221,46 +270,62 @@ void pal_os_event_register_callback_oneshot(pal_os_event_t * p_pal_os_event,
                                              void * callback_args,
                                              uint32_t time_us)
 {
-    struct itimerspec its;
-    long long freq_nanosecs;
-    int ret = 0;
-    //sigset_t mask;
+    pal_os_event_loop_t * p_loop = pal_os_event_loop_of(p_pal_os_event);
+    struct itimerspec its = {0};
+    uint64_t delay_ns = (uint64_t)time_us * 1000;
 
     TRUSTM_PAL_EVENT_DBGFN(">");
-    
-    //uint8_t scheduler_timer;
+
+    // A zero it_value disarms the timerfd, the shortest one shot is 1 ns
+    if (0 == delay_ns)
+    {
+        delay_ns = 1;
+    }
+    its.it_value.tv_sec = (time_t)(delay_ns / 1000000000ULL);
+    its.it_value.tv_nsec = (long)(delay_ns % 1000000000ULL);
+
+    if (0 != pal_os_event_loop_start(p_pal_os_event))
+    {
+        exit(1);
+    }
+    pthread_mutex_lock(&p_loop->mutex);
     p_pal_os_event->callback_registered = callback;
     p_pal_os_event->callback_ctx = callback_args;
-    
-    /* Start the timer */
-    freq_nanosecs = time_us * 1000;
-    its.it_value.tv_sec = (freq_nanosecs / 1000000000);
-    its.it_value.tv_nsec = (freq_nanosecs % 1000000000);
-    its.it_interval.tv_sec = 0;
-    its.it_interval.tv_nsec = 0;
-    
-    if (( ret = timer_settime(timerid, 0, &its, NULL)) == -1)    
+    p_loop->due_ns = pal_os_event_now_ns() + delay_ns;
+    if (timerfd_settime(p_loop->timer_fd, 0, &its, NULL) == -1)
     {
-        int errsv = errno;
-        fprintf(stderr,"timer_settime FAILED!!!\n");
-        if(errsv == EINVAL)
-        {
-            fprintf(stderr,"INVALID VALUE!\n");
-        }
-        else
-        {
-            fprintf(stderr,"UNKOWN ERROR: %d\n",errsv);
-        }
+        TRUSTM_PAL_EVENT_ERRFN("timerfd_settime");
         exit(1);
     }
+    pthread_mutex_unlock(&p_loop->mutex);
     
     TRUSTM_PAL_EVENT_DBGFN("<"); 
 }
 //lint --e{818,715} suppress "As there is no implementation, pal_os_event is not used"
 void pal_os_event_destroy(pal_os_event_t * pal_os_event)
 {
+    pal_os_event_loop_t * p_loop;
+    uint64_t stop = 1;
+
     TRUSTM_PAL_EVENT_DBGFN(">");    
-    timer_delete(timerid);
+    if (NULL == pal_os_event)
+    {
+        return;
+    }
+    p_loop = pal_os_event_loop_of(pal_os_event);
+    // From a callback the loop thread cannot join itself, it keeps running
+    if (p_loop->started && !pthread_equal(pthread_self(), p_loop->thread))
+    {
+        if (sizeof(stop) == write(p_loop->stop_fd, &stop, sizeof(stop)))
+        {
+            pthread_join(p_loop->thread, NULL);
+            close(p_loop->epoll_fd);
+            close(p_loop->timer_fd);
+            close(p_loop->stop_fd);
+            pthread_mutex_destroy(&p_loop->mutex);
+            p_loop->started = FALSE;
+        }
+    }
     TRUSTM_PAL_EVENT_DBGFN("<");    
 
 }
@@ -34,8 +34,15 @@
 * @{
 */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE     // PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP
+#endif
+#include <pthread.h>
 #include "optiga/pal/pal_os_lock.h"
 
+/// Guards the library state shared by the OPTIGA instances, whose events run on separate threads
+static pthread_mutex_t pal_os_lock_critical_section = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
 void pal_os_lock_create(pal_os_lock_t * p_lock, uint8_t lock_type)
 {
     p_lock->type = lock_type;
@@ -75,10 +82,12 @@ void pal_os_lock_release(pal_os_lock_t * p_lock)
 
 void pal_os_lock_enter_critical_section()
 {
+    pthread_mutex_lock(&pal_os_lock_critical_section);
 }
 
 void pal_os_lock_exit_critical_section()
 {
+    pthread_mutex_unlock(&pal_os_lock_critical_section);
 }
 
 /**
@@ -38,6 +38,7 @@
 #include "optiga/pal/pal_gpio.h"
 #include "optiga/pal/pal_i2c.h"
 #include "optiga/ifx_i2c/ifx_i2c_config.h"
+#include "optiga/optiga_lib_config.h"
 
 #include "pal_linux.h"
 
@@ -82,6 +83,37 @@ pal_gpio_t optiga_reset_0 =
     (void*)&pin_reset
 };
 
+#if (OPTIGA_MAX_INSTANCES > 1)
+/*
+* Second OPTIGA (optiga_instance_id 1) on its own adapter. A channel of an I2C mux shows up as an
+* adapter of its own (/dev/i2c-N of the i2c-mux driver), so it is selected the same way.
+* Its Vdd and Reset are not wired, the cold reset of this instance is skipped.
+*/
+pal_linux_t linux_events_1 = {"/dev/i2c-3", 0};
+
+pal_i2c_t optiga_pal_i2c_context_1 =
+{
+    /// Pointer to I2C master platform specific context
+    (void*)&linux_events_1,
+    /// Slave address
+    0x30,
+    /// Upper layer context
+    NULL,
+    /// Callback event handler
+    NULL
+};
+
+pal_gpio_t optiga_vdd_1 =
+{
+    NULL
+};
+
+pal_gpio_t optiga_reset_1 =
+{
+    NULL
+};
+#endif
+
 /**
 * @}
 */
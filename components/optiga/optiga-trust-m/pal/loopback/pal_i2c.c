@@ -0,0 +1,803 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2020 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file pal_i2c.c
+*
+* \brief   This file implements the platform abstraction layer APIs for I2C.
+*
+* \details There is no bus: writes and reads go to an emulated OPTIGA that keeps the
+*          registers, runs the slave side of the data link and transport layers and answers
+*          each APDU as soon as its last fragment arrives. The answers are canned (pattern
+*          data, dummy digests, input XOR 0xA5 for ciphers) with the lengths and tags the
+*          command layer checks, so only the host side of the stack does real work. Like the
+*          linux port, the upper layer handler is called before pal_i2c_write/read return.
+*          In replay mode every call is answered from the capture (pal_i2c_replay.c). In timed
+*          mode each transfer moves the simulated clock on by its wire time and a response is
+*          only reported ready once the execution time of its command has passed
+*          (pal_loopback_timing.c).
+*
+* \ingroup  grPAL
+* @{
+*/
+
+#include <string.h>
+#include <time.h>
+
+#include "optiga/pal/pal_i2c.h"
+#include "optiga/ifx_i2c/ifx_i2c_config.h"
+#include "pal_loopback.h"
+
+/// @cond hidden
+
+// Registers of the OPTIGA I2C interface
+#define LB_REG_DATA                     (0x80)
+#define LB_REG_DATA_REG_LEN             (0x81)
+#define LB_REG_I2C_STATE                (0x82)
+#define LB_REG_BASE_ADDR                (0x83)
+#define LB_REG_MAX_SCL_FREQU            (0x84)
+#define LB_REG_SOFT_RESET               (0x88)
+#define LB_REG_I2C_MODE                 (0x89)
+
+#define LB_STATE_BUSY                   (0x80)
+#define LB_STATE_SOFT_RESET             (0x08)
+#define LB_STATE_RESPONSE_READY         (0x40)
+#define LB_MODE_SM_FM                   (0x03)
+#define LB_MODE_FM_PLUS                 (0x04)
+#define LB_MIN_FRAME_SIZE               (16U)
+
+// Data link frame: FCTR, LEN (2), data, CRC (2)
+#define LB_FCTR_CONTROL                 (0x80)
+#define LB_SEQCTR_MASK                  (0x60)
+#define LB_SEQCTR_NACK                  (0x20)
+#define LB_SEQCTR_RESYNC                (0x40)
+#define LB_FRNR_MASK                    (0x0C)
+#define LB_ACKNR_MASK                   (0x03)
+#define LB_MAX_FRAME_NUM                (0x03)
+
+// Transport layer PCTR
+#define LB_PCTR_CHAIN_MASK              (0x07)
+#define LB_PCTR_PRESENCE                (0x08)
+#define LB_CHAIN_NONE                   (0x00)
+#define LB_CHAIN_FIRST                  (0x01)
+#define LB_CHAIN_INTERMEDIATE           (0x02)
+#define LB_CHAIN_LAST                   (0x04)
+
+// APDU, command codes without the clear last error bit
+#define LB_APDU_HEADER_SIZE             (4U)
+#define LB_APDU_CLEAR_LAST_ERROR        (0x80)
+#define LB_CMD_GET_DATA                 (0x01)
+#define LB_CMD_SET_DATA                 (0x02)
+#define LB_CMD_GET_RANDOM               (0x0C)
+#define LB_CMD_ENCRYPT_SYM              (0x14)
+#define LB_CMD_DECRYPT_SYM              (0x15)
+#define LB_CMD_CALC_HASH                (0x30)
+#define LB_CMD_OPEN_APPLICATION         (0x70)
+#define LB_CMD_CLOSE_APPLICATION        (0x71)
+#define LB_STA_SUCCESS                  (0x00)
+#define LB_STA_FAILURE                  (0xFF)
+#define LB_OID_LAST_ERROR               (0xF1C2)
+
+// Device error codes (last error code data object)
+#define LB_ERROR_INVALID_PARAM_FIELD    (0x03)
+#define LB_ERROR_INVALID_LENGTH         (0x04)
+#define LB_ERROR_DATA_OBJECT_BOUNDARY   (0x08)
+#define LB_ERROR_INVALID_COMMAND        (0x0A)
+
+// Hash and symmetric sequence tags
+#define LB_SEQ_START_FINAL              (0x01)
+#define LB_SEQ_FINAL                    (0x03)
+#define LB_HASH_CONTEXT_IN              (0x06)
+#define LB_HASH_CONTEXT_OUT             (0x07)
+#define LB_HASH_CONTEXT_LENGTH          (209U)
+#define LB_SYM_OUT_DATA_TAG             (0x61)
+
+#define LB_FRAME_MAX                    (IFX_I2C_FRAME_SIZE)
+#define LB_APDU_MAX                     (OPTIGA_MAX_COMMS_BUFFER_SIZE + 16U)
+
+typedef struct pal_loopback_device
+{
+    uint16_t frame_size;
+    uint8_t i2c_mode;
+    uint8_t reg;
+    uint8_t tx_seq;
+    uint8_t rx_seq;
+    // Next frame a read of PL_REG_DATA returns, and the last data frame sent (for a NACK)
+    uint8_t out_frame[LB_FRAME_MAX];
+    uint16_t out_len;
+    uint8_t last_frame[LB_FRAME_MAX];
+    uint16_t last_len;
+    uint8_t awaiting_ack;
+    // Transport layer reassembly and the pending response, SCTR included
+    uint8_t request[LB_APDU_MAX];
+    uint16_t request_len;
+    uint8_t response[LB_APDU_MAX];
+    uint16_t response_len;
+    uint16_t response_offset;
+    uint8_t presence;
+    uint8_t last_error;
+    // Simulated time the pending response becomes readable (timed mode)
+    uint64_t ready_ns;
+} pal_loopback_device_t;
+
+static pal_loopback_device_t g_device;
+static uint8_t g_device_ready = FALSE;
+static pal_loopback_stats_t g_stats;
+
+static uint64_t pal_loopback_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+
+// Same CRC-16 as the data link layer (reflected 0x8408, seed 0)
+static uint16_t pal_loopback_crc(const uint8_t * p_data, uint16_t length)
+{
+    uint16_t crc = 0;
+    uint16_t i;
+    uint8_t bit;
+
+    for (i = 0; i < length; i++)
+    {
+        crc ^= p_data[i];
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1U) ? (uint16_t)((crc >> 1) ^ 0x8408U) : (uint16_t)(crc >> 1);
+        }
+    }
+    return (crc);
+}
+
+static void pal_loopback_fill_pattern(uint8_t * p_data, uint16_t length, uint8_t seed)
+{
+    uint16_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        p_data[i] = (uint8_t)((i * 31U) + seed);
+    }
+}
+
+static uint16_t pal_loopback_frame(uint8_t * p_frame, uint8_t fctr, const uint8_t * p_data, uint16_t length)
+{
+    uint16_t crc;
+
+    p_frame[0] = fctr;
+    p_frame[1] = (uint8_t)(length >> 8);
+    p_frame[2] = (uint8_t)length;
+    if (0 != length)
+    {
+        memcpy(&p_frame[3], p_data, length);
+    }
+    crc = pal_loopback_crc(p_frame, (uint16_t)(3 + length));
+    p_frame[3 + length] = (uint8_t)(crc >> 8);
+    p_frame[4 + length] = (uint8_t)crc;
+    return ((uint16_t)(DL_HEADER_SIZE + length));
+}
+
+static void pal_loopback_queue_ack(void)
+{
+    g_device.out_len = pal_loopback_frame(g_device.out_frame, (uint8_t)(LB_FCTR_CONTROL | g_device.rx_seq),
+                                          NULL, 0);
+}
+
+// Next transport fragment of the response as a data frame
+static void pal_loopback_queue_fragment(void)
+{
+    uint8_t packet[LB_FRAME_MAX];
+    const uint16_t max_packet = (uint16_t)(g_device.frame_size - (DL_HEADER_SIZE + 1U));
+    uint16_t remaining = (uint16_t)(g_device.response_len - g_device.response_offset);
+    uint16_t chunk = (remaining > max_packet) ? max_packet : remaining;
+    uint8_t chain;
+    uint8_t fctr;
+
+    if (0 == g_device.response_offset)
+    {
+        chain = (chunk == remaining) ? LB_CHAIN_NONE : LB_CHAIN_FIRST;
+    }
+    else
+    {
+        chain = (chunk == remaining) ? LB_CHAIN_LAST : LB_CHAIN_INTERMEDIATE;
+    }
+    packet[0] = (uint8_t)(chain | g_device.presence);
+    memcpy(&packet[1], &g_device.response[g_device.response_offset], chunk);
+    g_device.response_offset = (uint16_t)(g_device.response_offset + chunk);
+
+    g_device.tx_seq = (uint8_t)((g_device.tx_seq + 1) & LB_MAX_FRAME_NUM);
+    fctr = (uint8_t)((g_device.tx_seq << 2) | g_device.rx_seq);
+    g_device.out_len = pal_loopback_frame(g_device.out_frame, fctr, packet, (uint16_t)(chunk + 1));
+    memcpy(g_device.last_frame, g_device.out_frame, g_device.out_len);
+    g_device.last_len = g_device.out_len;
+    g_device.awaiting_ack = TRUE;
+    g_stats.frames_sent++;
+}
+
+// --------------------
+// APDU handlers: p_in is the command data, the response data goes to p_out
+// --------------------
+static uint8_t pal_loopback_get_data(uint8_t param, const uint8_t * p_in, uint16_t in_len,
+                                     uint8_t * p_out, uint16_t * p_out_len)
+{
+    uint16_t oid;
+    uint16_t offset;
+    uint16_t length;
+
+    if (in_len < 2)
+    {
+        return (LB_ERROR_INVALID_LENGTH);
+    }
+    oid = (uint16_t)((p_in[0] << 8) | p_in[1]);
+    if (0 != param)
+    {
+        // Metadata: an empty metadata constructed TLV
+        p_out[0] = 0x20;
+        p_out[1] = 0x00;
+        *p_out_len = 2;
+        return (0);
+    }
+    if (LB_OID_LAST_ERROR == oid)
+    {
+        p_out[0] = g_device.last_error;
+        *p_out_len = (0 != g_device.last_error) ? 1 : 0;
+        g_device.last_error = 0;
+        return (0);
+    }
+    if (in_len < 6)
+    {
+        return (LB_ERROR_INVALID_LENGTH);
+    }
+    offset = (uint16_t)((p_in[2] << 8) | p_in[3]);
+    length = (uint16_t)((p_in[4] << 8) | p_in[5]);
+    if (offset >= PAL_LOOPBACK_OBJECT_SIZE)
+    {
+        return (LB_ERROR_DATA_OBJECT_BOUNDARY);
+    }
+    if (length > (PAL_LOOPBACK_OBJECT_SIZE - offset))
+    {
+        length = (uint16_t)(PAL_LOOPBACK_OBJECT_SIZE - offset);
+    }
+    pal_loopback_fill_pattern(p_out, length, (uint8_t)(oid + offset));
+    *p_out_len = length;
+    return (0);
+}
+
+// Hash: sequence TLV, then an optional context in (0x06) and context out request (0x07)
+static uint8_t pal_loopback_calc_hash(const uint8_t * p_in, uint16_t in_len,
+                                      uint8_t * p_out, uint16_t * p_out_len)
+{
+    uint16_t index;
+    uint8_t sequence;
+    uint8_t export_context = FALSE;
+
+    if (in_len < 3)
+    {
+        return (LB_ERROR_INVALID_LENGTH);
+    }
+    sequence = p_in[0];
+    index = (uint16_t)(3 + ((p_in[1] << 8) | p_in[2]));
+    while ((index + 3U) <= in_len)
+    {
+        if (LB_HASH_CONTEXT_OUT == p_in[index])
+        {
+            export_context = TRUE;
+        }
+        index = (uint16_t)(index + 3 + ((p_in[index + 1] << 8) | p_in[index + 2]));
+    }
+
+    *p_out_len = 0;
+    if ((LB_SEQ_START_FINAL == sequence) || (LB_SEQ_FINAL == sequence))
+    {
+        p_out[0] = LB_SEQ_START_FINAL;
+        p_out[1] = 0x00;
+        p_out[2] = 0x20;
+        pal_loopback_fill_pattern(&p_out[3], 0x20, sequence);
+        *p_out_len = 3 + 0x20;
+    }
+    else if (TRUE == export_context)
+    {
+        p_out[0] = LB_HASH_CONTEXT_IN;
+        p_out[1] = (uint8_t)(LB_HASH_CONTEXT_LENGTH >> 8);
+        p_out[2] = (uint8_t)LB_HASH_CONTEXT_LENGTH;
+        pal_loopback_fill_pattern(&p_out[3], LB_HASH_CONTEXT_LENGTH, sequence);
+        *p_out_len = 3 + LB_HASH_CONTEXT_LENGTH;
+    }
+    return (0);
+}
+
+static uint16_t pal_loopback_mac_length(uint8_t mode)
+{
+    switch (mode)
+    {
+        case 0x0A:  // CBC-MAC
+        case 0x0B:  // CMAC
+            return (16);
+        case 0x20:  // HMAC SHA-256
+            return (32);
+        case 0x21:  // HMAC SHA-384
+            return (48);
+        case 0x22:  // HMAC SHA-512
+            return (64);
+        default:
+            return (0);
+    }
+}
+
+// Symmetric encrypt/decrypt: OID (2), sequence TLV with the data, optional TLVs (IV, AD, total length)
+static uint8_t pal_loopback_sym(uint8_t cmd, uint8_t mode, const uint8_t * p_in, uint16_t in_len,
+                                uint8_t * p_out, uint16_t * p_out_len)
+{
+    uint16_t data_len;
+    uint16_t mac_len = pal_loopback_mac_length(mode);
+    uint16_t i;
+    uint8_t sequence;
+
+    if (in_len < 5)
+    {
+        return (LB_ERROR_INVALID_LENGTH);
+    }
+    sequence = p_in[2];
+    data_len = (uint16_t)((p_in[3] << 8) | p_in[4]);
+    if ((5U + data_len) > in_len)
+    {
+        return (LB_ERROR_INVALID_LENGTH);
+    }
+
+    *p_out_len = 0;
+    if (0 != mac_len)
+    {
+        // MACs come out of the final step only; HMAC verify returns no data
+        if (((LB_SEQ_START_FINAL != sequence) && (LB_SEQ_FINAL != sequence)) || (LB_CMD_DECRYPT_SYM == cmd))
+        {
+            return (0);
+        }
+        data_len = mac_len;
+    }
+    p_out[0] = LB_SYM_OUT_DATA_TAG;
+    p_out[1] = (uint8_t)(data_len >> 8);
+    p_out[2] = (uint8_t)data_len;
+    if (0 != mac_len)
+    {
+        pal_loopback_fill_pattern(&p_out[3], data_len, mode);
+    }
+    else
+    {
+        for (i = 0; i < data_len; i++)
+        {
+            p_out[3 + i] = (uint8_t)(p_in[5 + i] ^ 0xA5);
+        }
+    }
+    *p_out_len = (uint16_t)(3 + data_len);
+    return (0);
+}
+
+// Runs a reassembled request (SCTR already stripped) and queues its response
+static void pal_loopback_execute(const uint8_t * p_apdu, uint16_t length)
+{
+    uint8_t * p_response = &g_device.response[(0 != g_device.presence) ? 1 : 0];
+    uint8_t * p_out = &p_response[LB_APDU_HEADER_SIZE];
+    uint16_t out_len = 0;
+    uint16_t in_len = 0;
+    uint8_t error = 0;
+    uint8_t cmd = 0;
+    uint64_t time_ns;
+    uint8_t param;
+
+    g_stats.apdus++;
+    if (length < LB_APDU_HEADER_SIZE)
+    {
+        error = LB_ERROR_INVALID_LENGTH;
+    }
+    else
+    {
+        cmd = p_apdu[0];
+        param = p_apdu[1];
+        in_len = (uint16_t)((p_apdu[2] << 8) | p_apdu[3]);
+        if (0 != (cmd & LB_APDU_CLEAR_LAST_ERROR))
+        {
+            g_device.last_error = 0;
+        }
+        if ((LB_APDU_HEADER_SIZE + in_len) != length)
+        {
+            error = LB_ERROR_INVALID_LENGTH;
+        }
+        else
+        {
+            p_apdu += LB_APDU_HEADER_SIZE;
+            switch (cmd & (uint8_t)~LB_APDU_CLEAR_LAST_ERROR)
+            {
+                case LB_CMD_OPEN_APPLICATION:
+                case LB_CMD_CLOSE_APPLICATION:
+                case LB_CMD_SET_DATA:
+                    break;
+                case LB_CMD_GET_DATA:
+                    error = pal_loopback_get_data(param, p_apdu, in_len, p_out, &out_len);
+                    break;
+                case LB_CMD_GET_RANDOM:
+                    if (in_len < 2)
+                    {
+                        error = LB_ERROR_INVALID_LENGTH;
+                        break;
+                    }
+                    out_len = (uint16_t)((p_apdu[0] << 8) | p_apdu[1]);
+                    if (out_len > (LB_APDU_MAX - (LB_APDU_HEADER_SIZE + 1U)))
+                    {
+                        out_len = 0;
+                        error = LB_ERROR_INVALID_PARAM_FIELD;
+                        break;
+                    }
+                    pal_loopback_fill_pattern(p_out, out_len, param);
+                    break;
+                case LB_CMD_CALC_HASH:
+                    error = pal_loopback_calc_hash(p_apdu, in_len, p_out, &out_len);
+                    break;
+                case LB_CMD_ENCRYPT_SYM:
+                case LB_CMD_DECRYPT_SYM:
+                    error = pal_loopback_sym((uint8_t)(cmd & (uint8_t)~LB_APDU_CLEAR_LAST_ERROR), param,
+                                             p_apdu, in_len, p_out, &out_len);
+                    break;
+                default:
+                    error = LB_ERROR_INVALID_COMMAND;
+                    break;
+            }
+        }
+    }
+
+    if (0 != error)
+    {
+        g_device.last_error = error;
+        out_len = 0;
+    }
+    p_response[0] = (0 != error) ? LB_STA_FAILURE : LB_STA_SUCCESS;
+    p_response[1] = 0x00;
+    p_response[2] = (uint8_t)(out_len >> 8);
+    p_response[3] = (uint8_t)out_len;
+    g_device.response_len = (uint16_t)((p_response - g_device.response) + LB_APDU_HEADER_SIZE + out_len);
+    g_device.response_offset = 0;
+    if (TRUE == pal_loopback_timing_active())
+    {
+        time_ns = pal_loopback_timing_execute((uint8_t)(cmd & (uint8_t)~LB_APDU_CLEAR_LAST_ERROR), in_len);
+        g_stats.execute_ns += time_ns;
+        g_device.ready_ns = pal_loopback_timing_now_ns() + time_ns;
+    }
+}
+
+// Transport layer payload of an accepted data frame
+static void pal_loopback_receive_packet(const uint8_t * p_packet, uint16_t length)
+{
+    const uint8_t chain = p_packet[0] & LB_PCTR_CHAIN_MASK;
+
+    if ((LB_CHAIN_NONE == chain) || (LB_CHAIN_FIRST == chain))
+    {
+        g_device.request_len = 0;
+        g_device.presence = p_packet[0] & LB_PCTR_PRESENCE;
+    }
+    if ((g_device.request_len + length - 1U) > sizeof(g_device.request))
+    {
+        g_device.request_len = 0;
+        return;
+    }
+    memcpy(&g_device.request[g_device.request_len], &p_packet[1], length - 1U);
+    g_device.request_len = (uint16_t)(g_device.request_len + length - 1U);
+    if ((LB_CHAIN_NONE != chain) && (LB_CHAIN_LAST != chain))
+    {
+        return;
+    }
+
+    if ((0 != g_device.presence) && (g_device.request_len > 0))
+    {
+        // Answer with the SCTR of the request (no protection applied by the emulator)
+        g_device.response[0] = g_device.request[0];
+        pal_loopback_execute(&g_device.request[1], (uint16_t)(g_device.request_len - 1));
+    }
+    else
+    {
+        pal_loopback_execute(g_device.request, g_device.request_len);
+    }
+    g_device.request_len = 0;
+}
+
+static void pal_loopback_receive_frame(const uint8_t * p_frame, uint16_t length)
+{
+    uint16_t packet_len;
+    uint16_t crc;
+    uint8_t fctr;
+    uint8_t frnr;
+
+    if (length < DL_HEADER_SIZE)
+    {
+        g_stats.frame_errors++;
+        return;
+    }
+    packet_len = (uint16_t)((p_frame[1] << 8) | p_frame[2]);
+    crc = (uint16_t)((p_frame[length - 2] << 8) | p_frame[length - 1]);
+    if (((DL_HEADER_SIZE + packet_len) != length) || (pal_loopback_crc(p_frame, (uint16_t)(length - 2)) != crc))
+    {
+        g_stats.frame_errors++;
+        return;
+    }
+
+    fctr = p_frame[0];
+    if (0 != (fctr & LB_FCTR_CONTROL))
+    {
+        switch (fctr & LB_SEQCTR_MASK)
+        {
+            case LB_SEQCTR_RESYNC:
+                g_device.tx_seq = LB_MAX_FRAME_NUM;
+                g_device.rx_seq = LB_MAX_FRAME_NUM;
+                g_device.out_len = 0;
+                g_device.awaiting_ack = FALSE;
+                g_device.request_len = 0;
+                g_device.response_len = 0;
+                g_device.response_offset = 0;
+                break;
+            case LB_SEQCTR_NACK:
+                if (0 != g_device.last_len)
+                {
+                    memcpy(g_device.out_frame, g_device.last_frame, g_device.last_len);
+                    g_device.out_len = g_device.last_len;
+                }
+                break;
+            default:
+                if ((fctr & LB_ACKNR_MASK) == g_device.tx_seq)
+                {
+                    g_device.awaiting_ack = FALSE;
+                }
+                break;
+        }
+        return;
+    }
+
+    g_stats.frames_received++;
+    frnr = (uint8_t)((fctr & LB_FRNR_MASK) >> 2);
+    if ((0 == packet_len) || (frnr != ((g_device.rx_seq + 1) & LB_MAX_FRAME_NUM)))
+    {
+        // Repeated frame (our ACK got lost): acknowledge it again
+        pal_loopback_queue_ack();
+        return;
+    }
+    g_device.rx_seq = frnr;
+    pal_loopback_queue_ack();
+    pal_loopback_receive_packet(&p_frame[3], packet_len);
+}
+
+static void pal_loopback_write_register(const uint8_t * p_data, uint16_t length)
+{
+    uint16_t frame_size;
+
+    g_device.reg = p_data[0];
+    if (length < 2)
+    {
+        return;
+    }
+    switch (p_data[0])
+    {
+        case LB_REG_DATA:
+            pal_loopback_receive_frame(&p_data[1], (uint16_t)(length - 1));
+            break;
+        case LB_REG_DATA_REG_LEN:
+            if (length >= 3)
+            {
+                frame_size = (uint16_t)((p_data[1] << 8) | p_data[2]);
+                if (frame_size < LB_MIN_FRAME_SIZE)
+                {
+                    frame_size = LB_MIN_FRAME_SIZE;
+                }
+                g_device.frame_size = (frame_size > LB_FRAME_MAX) ? LB_FRAME_MAX : frame_size;
+            }
+            break;
+        case LB_REG_I2C_MODE:
+            g_device.i2c_mode = p_data[length - 1] & 0x07;
+            break;
+        case LB_REG_SOFT_RESET:
+            pal_loopback_device_reset();
+            break;
+        default:
+            // Base address: the emulator answers to any address
+            break;
+    }
+}
+
+static uint16_t pal_loopback_read_register(uint8_t * p_data, uint16_t length)
+{
+    uint8_t value[4] = {0};
+    uint16_t value_len = 0;
+    uint16_t frequency;
+    bool_t executing;
+
+    if (LB_REG_DATA == g_device.reg)
+    {
+        value_len = (length < g_device.out_len) ? length : g_device.out_len;
+        memcpy(p_data, g_device.out_frame, value_len);
+        memset(&p_data[value_len], 0, length - value_len);
+        g_device.out_len = 0;
+        return (length);
+    }
+
+    switch (g_device.reg)
+    {
+        case LB_REG_I2C_STATE:
+            executing = (TRUE == pal_loopback_timing_active()) &&
+                        (pal_loopback_timing_now_ns() < g_device.ready_ns);
+            if ((0 == g_device.out_len) && (FALSE == g_device.awaiting_ack) && (FALSE == executing) &&
+                (g_device.response_offset < g_device.response_len))
+            {
+                pal_loopback_queue_fragment();
+            }
+            value[0] = (uint8_t)(LB_STATE_SOFT_RESET | ((0 != g_device.out_len) ? LB_STATE_RESPONSE_READY : 0) |
+                                 ((TRUE == executing) ? LB_STATE_BUSY : 0));
+            value[2] = (uint8_t)(g_device.out_len >> 8);
+            value[3] = (uint8_t)g_device.out_len;
+            value_len = 4;
+            break;
+        case LB_REG_DATA_REG_LEN:
+            value[0] = (uint8_t)(g_device.frame_size >> 8);
+            value[1] = (uint8_t)g_device.frame_size;
+            value_len = 2;
+            break;
+        case LB_REG_MAX_SCL_FREQU:
+            frequency = (LB_MODE_FM_PLUS == g_device.i2c_mode) ? 1000 : 400;
+            value[2] = (uint8_t)(frequency >> 8);
+            value[3] = (uint8_t)frequency;
+            value_len = 4;
+            break;
+        case LB_REG_I2C_MODE:
+            value[1] = g_device.i2c_mode;
+            value_len = 2;
+            break;
+        default:
+            break;
+    }
+    if (value_len > length)
+    {
+        value_len = length;
+    }
+    memcpy(p_data, value, value_len);
+    memset(&p_data[value_len], 0, length - value_len);
+    return (length);
+}
+
+static void pal_loopback_complete(const pal_i2c_t * p_i2c_context, uint64_t start_ns)
+{
+    g_stats.device_ns += pal_loopback_now_ns() - start_ns;
+    //lint --e{611} suppress "void* function pointer is type casted to upper_layer_callback_t  type"
+    ((upper_layer_callback_t)(p_i2c_context->upper_layer_event_handler))(p_i2c_context->p_upper_layer_ctx,
+                                                                         PAL_I2C_EVENT_SUCCESS);
+}
+/// @endcond
+
+void pal_loopback_device_reset(void)
+{
+    memset(&g_device, 0, sizeof(g_device));
+    g_device.frame_size = LB_FRAME_MAX;
+    g_device.i2c_mode = LB_MODE_SM_FM;
+    g_device.tx_seq = LB_MAX_FRAME_NUM;
+    g_device.rx_seq = LB_MAX_FRAME_NUM;
+    g_device_ready = TRUE;
+}
+
+void pal_loopback_get_stats(pal_loopback_stats_t * p_stats)
+{
+    *p_stats = g_stats;
+}
+
+void pal_loopback_reset_stats(void)
+{
+    memset(&g_stats, 0, sizeof(g_stats));
+}
+
+void pal_loopback_add_delay(uint32_t time_us)
+{
+    g_stats.requested_delay_us += time_us;
+}
+
+void pal_loopback_add_event(void)
+{
+    g_stats.events++;
+}
+
+//lint --e{715} suppress "There is no I2C master to set up"
+pal_status_t pal_i2c_init(const pal_i2c_t * p_i2c_context)
+{
+    if (TRUE == pal_loopback_replay_active())
+    {
+        return (pal_loopback_replay_i2c(p_i2c_context, PAL_I2C_CAPTURE_INIT, NULL, 0));
+    }
+    if (FALSE == g_device_ready)
+    {
+        pal_loopback_device_reset();
+    }
+    return PAL_STATUS_SUCCESS;
+}
+
+pal_status_t pal_i2c_deinit(const pal_i2c_t * p_i2c_context)
+{
+    return PAL_STATUS_SUCCESS;
+}
+
+pal_status_t pal_i2c_write(const pal_i2c_t * p_i2c_context, uint8_t * p_data, uint16_t length)
+{
+    const uint64_t start_ns = pal_loopback_now_ns();
+
+    if (TRUE == pal_loopback_replay_active())
+    {
+        return (pal_loopback_replay_i2c(p_i2c_context, PAL_I2C_CAPTURE_WRITE, p_data, length));
+    }
+    if (0 == length)
+    {
+        return PAL_STATUS_FAILURE;
+    }
+    g_stats.i2c_writes++;
+    g_stats.bytes_written += length;
+    if (TRUE == pal_loopback_timing_active())
+    {
+        // The device sees the bytes once they are on the wire
+        g_stats.wire_ns += pal_loopback_timing_transfer(length);
+    }
+    pal_loopback_write_register(p_data, length);
+    pal_loopback_complete(p_i2c_context, start_ns);
+    return PAL_STATUS_SUCCESS;
+}
+
+pal_status_t pal_i2c_read(const pal_i2c_t * p_i2c_context, uint8_t * p_data, uint16_t length)
+{
+    const uint64_t start_ns = pal_loopback_now_ns();
+
+    if (TRUE == pal_loopback_replay_active())
+    {
+        return (pal_loopback_replay_i2c(p_i2c_context, PAL_I2C_CAPTURE_READ, p_data, length));
+    }
+    g_stats.i2c_reads++;
+    g_stats.bytes_read += pal_loopback_read_register(p_data, length);
+    if (TRUE == pal_loopback_timing_active())
+    {
+        g_stats.wire_ns += pal_loopback_timing_transfer(length);
+    }
+    pal_loopback_complete(p_i2c_context, start_ns);
+    return PAL_STATUS_SUCCESS;
+}
+
+//lint --e{715} suppress "The emulated bus runs at any bitrate, timed mode takes it for the wire time"
+pal_status_t pal_i2c_set_bitrate(const pal_i2c_t * p_i2c_context, uint16_t bitrate)
+{
+    if (TRUE == pal_loopback_replay_active())
+    {
+        return (pal_loopback_replay_i2c(p_i2c_context, PAL_I2C_CAPTURE_BITRATE, NULL, 0));
+    }
+    pal_loopback_timing_set_bitrate(bitrate);
+    if (0 != p_i2c_context->upper_layer_event_handler)
+    {
+        //lint --e{611} suppress "void* function pointer is type casted to upper_layer_callback_t  type"
+        ((upper_layer_callback_t)(p_i2c_context->upper_layer_event_handler))(p_i2c_context->p_upper_layer_ctx,
+                                                                             PAL_I2C_EVENT_SUCCESS);
+    }
+    return PAL_STATUS_SUCCESS;
+}
+
+/**
+* @}
+*/
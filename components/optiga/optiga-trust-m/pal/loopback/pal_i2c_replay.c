@@ -0,0 +1,280 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2020 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+* \file pal_i2c_replay.c
+*
+* \brief   This file implements the replay mode of the loopback I2C PAL.
+*
+* \details Instead of the emulated OPTIGA, pal_i2c_init/write/read/set_bitrate take the next
+*          record of one OPTIGA instance from a capture file (pal_i2c_capture.h): reads return
+*          the captured bytes and status, writes are compared with the captured bytes. The
+*          timer PAL reports the time of the next record, so the stack sees the captured
+*          timing and takes the same retry and timeout decisions. A call that meets a record
+*          of another kind marks the replay as diverged: from then on every transfer fails and
+*          the clock runs on by 1 ms per reading, so the stack gives up through its own timeouts.
+*
+* \ingroup  grPAL
+* @{
+*/
+
+#include <string.h>
+
+#include "optiga/pal/pal_i2c.h"
+#include "optiga/pal/pal_i2c_capture.h"
+#include "pal_loopback.h"
+
+/// @cond hidden
+
+#define PAL_REPLAY_HEADER_SIZE          (20U)
+#define PAL_REPLAY_RECORD_SIZE          (12U)
+
+typedef struct pal_replay
+{
+    const uint8_t * p_capture;
+    uint32_t length;
+    // Offset of the next record of the replayed instance, length when none is left
+    uint32_t next;
+    uint32_t last_time_us;
+    uint8_t device;
+    bool_t active;
+    pal_loopback_replay_stats_t stats;
+} pal_replay_t;
+
+static pal_replay_t g_replay;
+
+static uint16_t pal_replay_get_u16(const uint8_t * p_data)
+{
+    return ((uint16_t)(p_data[0] | ((uint16_t)p_data[1] << 8)));
+}
+
+static uint32_t pal_replay_get_u32(const uint8_t * p_data)
+{
+    return ((uint32_t)p_data[0] | ((uint32_t)p_data[1] << 8) |
+            ((uint32_t)p_data[2] << 16) | ((uint32_t)p_data[3] << 24));
+}
+
+// Decodes the record at offset, FALSE if it is cut short
+static bool_t pal_replay_decode(uint32_t offset, pal_i2c_capture_record_t * p_record)
+{
+    const uint8_t * p_header = &g_replay.p_capture[offset];
+
+    if ((g_replay.length - offset) < PAL_REPLAY_RECORD_SIZE)
+    {
+        return (FALSE);
+    }
+    p_record->time_us = pal_replay_get_u32(&p_header[0]);
+    p_record->duration_us = pal_replay_get_u32(&p_header[4]);
+    p_record->length = pal_replay_get_u16(&p_header[8]);
+    p_record->type = p_header[10];
+    p_record->status = p_header[11];
+    return (((g_replay.length - offset - PAL_REPLAY_RECORD_SIZE) >= p_record->length) ? TRUE : FALSE);
+}
+
+// Moves g_replay.next to the first record of the replayed instance at or after offset
+static void pal_replay_seek(uint32_t offset)
+{
+    pal_i2c_capture_record_t record;
+
+    while (TRUE == pal_replay_decode(offset, &record))
+    {
+        if ((record.type >> PAL_I2C_CAPTURE_DEVICE_SHIFT) == g_replay.device)
+        {
+            g_replay.next = offset;
+            return;
+        }
+        offset += PAL_REPLAY_RECORD_SIZE + record.length;
+    }
+    g_replay.next = g_replay.length;
+}
+
+static void pal_replay_diverge(uint8_t call, uint8_t found)
+{
+    if (FALSE == g_replay.stats.diverged)
+    {
+        g_replay.stats.diverged = TRUE;
+        g_replay.stats.diverged_offset = g_replay.next;
+        g_replay.stats.diverged_call = call;
+        g_replay.stats.diverged_found = found;
+    }
+}
+
+static void pal_replay_complete(const pal_i2c_t * p_i2c_context, pal_status_t status)
+{
+    if (0 != p_i2c_context->upper_layer_event_handler)
+    {
+        //lint --e{611} suppress "void* function pointer is type casted to upper_layer_callback_t  type"
+        ((upper_layer_callback_t)(p_i2c_context->upper_layer_event_handler))(p_i2c_context->p_upper_layer_ctx,
+            (PAL_STATUS_SUCCESS == status) ? PAL_I2C_EVENT_SUCCESS : PAL_I2C_EVENT_ERROR);
+    }
+}
+/// @endcond
+
+pal_status_t pal_loopback_replay_start(const uint8_t * p_capture, uint32_t length, uint8_t device)
+{
+    memset(&g_replay, 0, sizeof(g_replay));
+    if ((length < PAL_REPLAY_HEADER_SIZE) ||
+        (PAL_I2C_CAPTURE_MAGIC != pal_replay_get_u32(&p_capture[0])) ||
+        (PAL_I2C_CAPTURE_VERSION != pal_replay_get_u16(&p_capture[4])) ||
+        (PAL_REPLAY_RECORD_SIZE != pal_replay_get_u16(&p_capture[6])))
+    {
+        return (PAL_STATUS_FAILURE);
+    }
+    g_replay.p_capture = p_capture;
+    g_replay.length = length;
+    g_replay.device = device;
+    g_replay.active = TRUE;
+    pal_replay_seek(PAL_REPLAY_HEADER_SIZE);
+    return (PAL_STATUS_SUCCESS);
+}
+
+void pal_loopback_replay_stop(void)
+{
+    g_replay.active = FALSE;
+}
+
+void pal_loopback_replay_resume(void)
+{
+    g_replay.active = (NULL != g_replay.p_capture) ? TRUE : FALSE;
+}
+
+bool_t pal_loopback_replay_active(void)
+{
+    return (g_replay.active);
+}
+
+bool_t pal_loopback_replay_peek(pal_i2c_capture_record_t * p_record, const uint8_t ** pp_data)
+{
+    if ((FALSE == g_replay.active) || (TRUE == g_replay.stats.diverged) ||
+        (FALSE == pal_replay_decode(g_replay.next, p_record)))
+    {
+        return (FALSE);
+    }
+    p_record->type &= PAL_I2C_CAPTURE_TYPE_MASK;
+    if (NULL != pp_data)
+    {
+        *pp_data = &g_replay.p_capture[g_replay.next + PAL_REPLAY_RECORD_SIZE];
+    }
+    return (TRUE);
+}
+
+void pal_loopback_replay_skip(void)
+{
+    pal_i2c_capture_record_t record;
+
+    if (TRUE == pal_replay_decode(g_replay.next, &record))
+    {
+        g_replay.last_time_us = record.time_us + record.duration_us;
+        g_replay.stats.records++;
+        g_replay.stats.end_us = g_replay.last_time_us;
+        pal_replay_seek(g_replay.next + PAL_REPLAY_RECORD_SIZE + record.length);
+    }
+}
+
+uint32_t pal_loopback_replay_time_us(void)
+{
+    pal_i2c_capture_record_t record;
+
+    // Between records the stack runs at the captured moment of the next one
+    if (TRUE == pal_loopback_replay_peek(&record, NULL))
+    {
+        return (record.time_us);
+    }
+    g_replay.last_time_us += 1000U;
+    return (g_replay.last_time_us);
+}
+
+void pal_loopback_replay_get_stats(pal_loopback_replay_stats_t * p_stats)
+{
+    *p_stats = g_replay.stats;
+}
+
+pal_status_t pal_loopback_replay_i2c(const pal_i2c_t * p_i2c_context,
+                                     uint8_t call,
+                                     uint8_t * p_data,
+                                     uint16_t length)
+{
+    pal_i2c_capture_record_t record;
+    const uint8_t * p_captured;
+    pal_status_t status;
+
+    if (FALSE == pal_loopback_replay_peek(&record, &p_captured))
+    {
+        // Diverged before, or the capture is used up: the stack asked for more than was recorded
+        pal_replay_diverge(call, 0);
+        pal_replay_complete(p_i2c_context, PAL_STATUS_FAILURE);
+        return (PAL_STATUS_FAILURE);
+    }
+    if (record.type != call)
+    {
+        if (PAL_I2C_CAPTURE_BITRATE == call)
+        {
+            // Bitrate changes the port did not record cost nothing on the bus
+            pal_replay_complete(p_i2c_context, PAL_STATUS_SUCCESS);
+            return (PAL_STATUS_SUCCESS);
+        }
+        pal_replay_diverge(call, record.type);
+        pal_replay_complete(p_i2c_context, PAL_STATUS_FAILURE);
+        return (PAL_STATUS_FAILURE);
+    }
+
+    status = (0 == record.status) ? PAL_STATUS_SUCCESS : PAL_STATUS_FAILURE;
+    switch (call)
+    {
+        case PAL_I2C_CAPTURE_WRITE:
+        {
+            g_replay.stats.transfers++;
+            g_replay.stats.bus_us += record.duration_us;
+            if ((record.length != length) || (0 != memcmp(p_captured, p_data, length)))
+            {
+                g_replay.stats.write_mismatches++;
+            }
+            break;
+        }
+        case PAL_I2C_CAPTURE_READ:
+        {
+            g_replay.stats.transfers++;
+            g_replay.stats.bus_us += record.duration_us;
+            memset(p_data, 0, length);
+            memcpy(p_data, p_captured, (record.length < length) ? record.length : length);
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+    pal_loopback_replay_skip();
+    if (PAL_I2C_CAPTURE_INIT != call)
+    {
+        pal_replay_complete(p_i2c_context, status);
+    }
+    return (status);
+}
+
+/**
+* @}
+*/
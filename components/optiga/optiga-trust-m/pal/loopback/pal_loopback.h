@@ -0,0 +1,295 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2020 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file pal_loopback.h
+*
+* \brief   This file provides the prototype declarations of the loopback PAL (host, no OPTIGA attached).
+*
+* \details The I2C PAL answers from an in-memory model of the OPTIGA register interface
+*          (PL_REG_DATA, PL_REG_I2C_STATE, ...): it runs the slave side of the data link
+*          and transport layers and returns canned APDU responses at once. The event PAL
+*          ignores the requested delays; the caller drives the stack by calling
+*          pal_os_event_process() until the request completes. Everything then measured
+*          is CPU time spent in optiga_cmd and the ifx_i2c layers.
+*          After pal_loopback_replay_start() the I2C and timer PALs play back a capture of
+*          the ESP32 port instead (pal_i2c_replay.c). After pal_loopback_timing_start() the
+*          PALs run on a simulated clock with bus and execution times (pal_loopback_timing.c).
+*
+* \ingroup  grPAL
+* @{
+*/
+
+#ifndef _PAL_LOOPBACK_H_
+#define _PAL_LOOPBACK_H_
+
+#include "optiga/pal/pal.h"
+#include "optiga/pal/pal_i2c.h"
+#include "optiga/pal/pal_i2c_capture.h"
+
+/// Size of every emulated data object, reads past it end with an out of boundary error
+#define PAL_LOOPBACK_OBJECT_SIZE        (1728U)
+
+/** @brief Traffic seen by the emulated OPTIGA */
+typedef struct pal_loopback_stats
+{
+    /// pal_i2c_write() calls
+    uint32_t i2c_writes;
+    /// pal_i2c_read() calls
+    uint32_t i2c_reads;
+    /// Bytes written, register addresses included
+    uint32_t bytes_written;
+    /// Bytes read
+    uint32_t bytes_read;
+    /// Data frames written to PL_REG_DATA by the master
+    uint32_t frames_received;
+    /// Data frames handed to the master (ACK control frames not counted)
+    uint32_t frames_sent;
+    /// Complete APDUs executed
+    uint32_t apdus;
+    /// Frames dropped for a bad CRC or length
+    uint32_t frame_errors;
+    /// Callbacks run by pal_os_event_process()
+    uint32_t events;
+    /// Sum of the delays the stack asked the event PAL for [us], i.e. time a real bus would idle
+    uint64_t requested_delay_us;
+    /// Time spent in the emulated OPTIGA itself [ns], to subtract from measurements of the stack
+    uint64_t device_ns;
+    /// Simulated wire time of the transfers [ns], timed mode only
+    uint64_t wire_ns;
+    /// Simulated execution time of the APDUs [ns], timed mode only
+    uint64_t execute_ns;
+} pal_loopback_stats_t;
+
+/**
+ * \brief Runs the registered event callbacks until none is pending.
+ *
+ * \retval  Number of callbacks run
+ */
+uint32_t pal_os_event_process(void);
+
+/**
+ * \brief Counts a delay asked for by the stack (event PAL, internal).
+ */
+void pal_loopback_add_delay(uint32_t time_us);
+
+/**
+ * \brief Counts a callback run by the event PAL (internal).
+ */
+void pal_loopback_add_event(void);
+
+/**
+ * \brief Powers the emulated OPTIGA off and on: registers, sequence numbers and pending frames are reset.
+ */
+void pal_loopback_device_reset(void);
+
+/**
+ * \brief Copies the traffic counters.
+ */
+void pal_loopback_get_stats(pal_loopback_stats_t * p_stats);
+
+/**
+ * \brief Clears the traffic counters.
+ */
+void pal_loopback_reset_stats(void);
+
+/** @brief Outcome of a capture replay */
+typedef struct pal_loopback_replay_stats
+{
+    /// Records consumed, by the PAL and by pal_loopback_replay_skip()
+    uint32_t records;
+    /// Writes and reads answered from the capture
+    uint32_t transfers;
+    /// Captured bus time of those transfers [us]
+    uint64_t bus_us;
+    /// Captured end of the last record consumed [us]
+    uint32_t end_us;
+    /// Writes whose bytes differ from the captured ones
+    uint32_t write_mismatches;
+    /// TRUE once a PAL call met a record of another kind, or no record at all
+    bool_t diverged;
+    /// File offset of the record met, the file length if the capture was used up
+    uint32_t diverged_offset;
+    /// PAL_I2C_CAPTURE_* type of the call
+    uint8_t diverged_call;
+    /// PAL_I2C_CAPTURE_* type of the record met, 0 if none was left
+    uint8_t diverged_found;
+} pal_loopback_replay_stats_t;
+
+/**
+ * \brief Starts replaying a capture file of one OPTIGA instance.
+ *
+ * \details The file must stay valid while the replay runs. Replay starts at the first
+ *          record of the instance; the caller moves to a #PAL_I2C_CAPTURE_INIT record with
+ *          pal_loopback_replay_peek() and pal_loopback_replay_skip() before opening the stack.
+ *
+ * \param[in] p_capture   Capture file
+ * \param[in] length      File length
+ * \param[in] device      OPTIGA instance (0 or 1) whose records are replayed
+ *
+ * \retval  #PAL_STATUS_SUCCESS  Replay started
+ * \retval  #PAL_STATUS_FAILURE  Not a capture file of this format version
+ */
+pal_status_t pal_loopback_replay_start(const uint8_t * p_capture, uint32_t length, uint8_t device);
+
+/**
+ * \brief Pauses the replay, the PALs go back to the emulated OPTIGA. The position is kept.
+ */
+void pal_loopback_replay_stop(void);
+
+/**
+ * \brief Continues a paused replay at the kept position.
+ */
+void pal_loopback_replay_resume(void);
+
+/**
+ * \brief TRUE from pal_loopback_replay_start() or pal_loopback_replay_resume() until pal_loopback_replay_stop().
+ */
+bool_t pal_loopback_replay_active(void);
+
+/**
+ * \brief Gives the next record of the replayed instance without consuming it.
+ *
+ * \param[out] p_record  Record header, type without the instance bits
+ * \param[out] pp_data   Record data, may be NULL
+ *
+ * \retval  TRUE if there is a next record and the replay has not diverged
+ */
+bool_t pal_loopback_replay_peek(pal_i2c_capture_record_t * p_record, const uint8_t ** pp_data);
+
+/**
+ * \brief Consumes the next record, e.g. an #PAL_I2C_CAPTURE_APDU record taken by the caller.
+ */
+void pal_loopback_replay_skip(void);
+
+/**
+ * \brief Current replay time [us] for the timer PAL (internal).
+ */
+uint32_t pal_loopback_replay_time_us(void);
+
+/**
+ * \brief Answers a PAL I2C call from the next record (internal).
+ *
+ * \param[in] p_i2c_context  I2C context of the call
+ * \param[in] call           PAL_I2C_CAPTURE_* type of the call
+ * \param[in] p_data         Bytes written, or buffer for the bytes read
+ * \param[in] length         Data length
+ *
+ * \retval  Captured status of the call, #PAL_STATUS_FAILURE on divergence
+ */
+pal_status_t pal_loopback_replay_i2c(const pal_i2c_t * p_i2c_context,
+                                     uint8_t call,
+                                     uint8_t * p_data,
+                                     uint16_t length);
+
+/**
+ * \brief Copies the replay counters, counted since pal_loopback_replay_start().
+ */
+void pal_loopback_replay_get_stats(pal_loopback_replay_stats_t * p_stats);
+
+/** @brief Execution time of one APDU command code (timed mode) */
+typedef struct pal_loopback_command_time
+{
+    /// APDU command code; 0x00 ends the table and gives the time of every other command
+    uint8_t command;
+    /// From the last request fragment to the response being ready [us]
+    uint32_t base_us;
+    /// Added per started 16 bytes of command data [us]
+    uint32_t block_us;
+} pal_loopback_command_time_t;
+
+/** @brief Timing model of the bus and the emulated OPTIGA (timed mode) */
+typedef struct pal_loopback_timing
+{
+    /// I2C clock [kHz], 0 for the bitrate the stack sets
+    uint16_t bitrate_khz;
+    /// Per transfer on top of the bytes: start, stop and driver turnaround [us]
+    uint32_t transfer_us;
+    /// Command times, ended by a 0x00 row; NULL for #pal_loopback_trust_m_times
+    const pal_loopback_command_time_t * p_commands;
+} pal_loopback_timing_t;
+
+/// Default command times, rough OPTIGA Trust M V3 figures
+extern const pal_loopback_command_time_t pal_loopback_trust_m_times[];
+
+/**
+ * \brief Runs the PALs on the simulated clock with the given model, until pal_loopback_timing_stop().
+ *
+ * \details The clock keeps its value across stop and start; it starts at 0.
+ *          The model must stay valid while timed mode runs.
+ */
+void pal_loopback_timing_start(const pal_loopback_timing_t * p_timing);
+
+/**
+ * \brief Leaves timed mode: the timer PAL goes back to CLOCK_MONOTONIC, transfers take no time.
+ */
+void pal_loopback_timing_stop(void);
+
+/**
+ * \brief TRUE from pal_loopback_timing_start() until pal_loopback_timing_stop().
+ */
+bool_t pal_loopback_timing_active(void);
+
+/**
+ * \brief Simulated time [ns].
+ */
+uint64_t pal_loopback_timing_now_ns(void);
+
+/**
+ * \brief Moves the simulated clock on, for host work between requests (flash, CPU).
+ */
+void pal_loopback_timing_advance(uint64_t time_ns);
+
+/**
+ * \brief Moves the simulated clock on to time_ns unless it is already past it.
+ */
+void pal_loopback_timing_wait_until(uint64_t time_ns);
+
+/**
+ * \brief Bitrate set by the stack, used unless the model has its own (I2C PAL, internal).
+ */
+void pal_loopback_timing_set_bitrate(uint16_t bitrate_khz);
+
+/**
+ * \brief Moves the clock on by the wire time of a transfer of length bytes (I2C PAL, internal).
+ *
+ * \retval  Wire time [ns]
+ */
+uint64_t pal_loopback_timing_transfer(uint16_t length);
+
+/**
+ * \brief Execution time of an APDU with length bytes of command data (I2C PAL, internal).
+ *
+ * \retval  Execution time [ns]
+ */
+uint64_t pal_loopback_timing_execute(uint8_t command, uint16_t length);
+
+#endif /* _PAL_LOOPBACK_H_ */
+
+/**
+* @}
+*/
@@ -0,0 +1,148 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2020 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+* \file pal_loopback_timing.c
+*
+* \brief   This file implements the timed mode of the loopback PAL.
+*
+* \details A simulated clock replaces CLOCK_MONOTONIC for the timer PAL. Every I2C transfer
+*          moves it on by its wire time at the bus bitrate, the emulated OPTIGA holds each
+*          response back for the execution time of its command code, and the event PAL
+*          jumps to the due time of a callback before running it. Host work between requests
+*          (flash writes, CPU time) is added by the caller. The stack keeps its own polling,
+*          guard times and timeouts, so they cost what they would cost on the bus.
+*
+* \ingroup  grPAL
+* @{
+*/
+
+#include "optiga/ifx_i2c/ifx_i2c_config.h"
+#include "pal_loopback.h"
+
+/// @cond hidden
+
+// 8 data bits and the ACK bit per byte on the wire
+#define PAL_TIMING_BITS_PER_BYTE        (9U)
+#define PAL_TIMING_BLOCK_BYTES          (16U)
+
+static const pal_loopback_timing_t * g_timing = NULL;
+static uint64_t g_now_ns = 0;
+static uint16_t g_stack_bitrate_khz = IFX_I2C_FREQUENCY_KHZ;
+/// @endcond
+
+/*
+ * Rough OPTIGA Trust M V3 figures at the default current limit. Replace them with the exec
+ * column of the firmware's latency histograms (optiga_lib_latency_dump()) for the current
+ * limit and the key sizes actually used.
+ */
+const pal_loopback_command_time_t pal_loopback_trust_m_times[] =
+{
+    { 0x01,  1000,   10 },  // GetDataObject
+    { 0x02,  5000,  150 },  // SetDataObject (NVM write)
+    { 0x0C,  2000,  100 },  // GetRandom
+    { 0x14,  1500,  200 },  // EncryptSym
+    { 0x15,  1500,  200 },  // DecryptSym
+    { 0x30,   800,   20 },  // CalcHash
+    { 0x70, 10000,    0 },  // OpenApplication
+    { 0x71,  5000,    0 },  // CloseApplication
+    { 0x00, 20000,    0 },  // Everything else (key generation, signatures, ...)
+};
+
+void pal_loopback_timing_start(const pal_loopback_timing_t * p_timing)
+{
+    g_timing = p_timing;
+}
+
+void pal_loopback_timing_stop(void)
+{
+    g_timing = NULL;
+}
+
+bool_t pal_loopback_timing_active(void)
+{
+    return ((NULL != g_timing) ? TRUE : FALSE);
+}
+
+uint64_t pal_loopback_timing_now_ns(void)
+{
+    return (g_now_ns);
+}
+
+void pal_loopback_timing_advance(uint64_t time_ns)
+{
+    g_now_ns += time_ns;
+}
+
+void pal_loopback_timing_wait_until(uint64_t time_ns)
+{
+    if (time_ns > g_now_ns)
+    {
+        g_now_ns = time_ns;
+    }
+}
+
+void pal_loopback_timing_set_bitrate(uint16_t bitrate_khz)
+{
+    g_stack_bitrate_khz = bitrate_khz;
+}
+
+uint64_t pal_loopback_timing_transfer(uint16_t length)
+{
+    uint16_t bitrate_khz = g_stack_bitrate_khz;
+    uint64_t time_ns;
+
+    if (0 != g_timing->bitrate_khz)
+    {
+        bitrate_khz = g_timing->bitrate_khz;
+    }
+    // Address byte included; 1 kHz is one bit per ms, 1000000 ns
+    time_ns = ((uint64_t)(length + 1U) * PAL_TIMING_BITS_PER_BYTE * 1000000U) / bitrate_khz;
+    time_ns += (uint64_t)g_timing->transfer_us * 1000U;
+    g_now_ns += time_ns;
+    return (time_ns);
+}
+
+uint64_t pal_loopback_timing_execute(uint8_t command, uint16_t length)
+{
+    const pal_loopback_command_time_t * p_row = g_timing->p_commands;
+    const uint32_t blocks = (length + PAL_TIMING_BLOCK_BYTES - 1U) / PAL_TIMING_BLOCK_BYTES;
+
+    if (NULL == p_row)
+    {
+        p_row = pal_loopback_trust_m_times;
+    }
+
+    while ((0x00 != p_row->command) && (command != p_row->command))
+    {
+        p_row++;
+    }
+    return (((uint64_t)p_row->base_us + ((uint64_t)p_row->block_us * blocks)) * 1000U);
+}
+
+/**
+* @}
+*/
@@ -0,0 +1,125 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2020 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file pal_os_event.c
+*
+* \brief   This file implements the platform abstraction layer APIs for os event/scheduler.
+*
+* \details Zero latency: a registered callback is due at once, whatever time_us says, and
+*          runs from pal_os_event_process() in the caller's thread. Callbacks that register
+*          the next step are run by the same loop, so the stack does not recurse.
+*          In timed mode the simulated clock jumps to the due time of a callback before it runs.
+*
+* \ingroup  grPAL
+* @{
+*/
+
+#include "optiga/pal/pal_os_event.h"
+#include "pal_loopback.h"
+
+/// @cond hidden
+
+static pal_os_event_t pal_os_event_0 = {0};
+// Simulated due time of the registered callback (timed mode)
+static uint64_t pal_os_event_due_ns = 0;
+
+void pal_os_event_start(pal_os_event_t * p_pal_os_event, register_callback callback, void * callback_args)
+{
+    if (FALSE == p_pal_os_event->is_event_triggered)
+    {
+        p_pal_os_event->is_event_triggered = TRUE;
+        pal_os_event_register_callback_oneshot(p_pal_os_event, callback, callback_args, 1000);
+    }
+}
+
+void pal_os_event_stop(pal_os_event_t * p_pal_os_event)
+{
+    //lint --e{714} suppress "The API pal_os_event_stop is not exposed in header file but used as extern in optiga_cmd.c"
+    p_pal_os_event->is_event_triggered = FALSE;
+}
+
+pal_os_event_t * pal_os_event_create(register_callback callback, void * callback_args)
+{
+    if ((NULL != callback) && (NULL != callback_args))
+    {
+        pal_os_event_start(&pal_os_event_0, callback, callback_args);
+    }
+    return (&pal_os_event_0);
+}
+
+void pal_os_event_trigger_registered_callback(void)
+{
+    register_callback callback;
+
+    if (NULL != pal_os_event_0.callback_registered)
+    {
+        callback = pal_os_event_0.callback_registered;
+        pal_os_event_0.callback_registered = NULL;
+        pal_loopback_add_event();
+        if (TRUE == pal_loopback_timing_active())
+        {
+            pal_loopback_timing_wait_until(pal_os_event_due_ns);
+        }
+        callback((void * )pal_os_event_0.callback_ctx);
+    }
+}
+/// @endcond
+
+void pal_os_event_register_callback_oneshot(pal_os_event_t * p_pal_os_event,
+                                             register_callback callback,
+                                             void * callback_args,
+                                             uint32_t time_us)
+{
+    // One event per instance as on the other ports: a new registration replaces a pending one
+    p_pal_os_event->callback_registered = callback;
+    p_pal_os_event->callback_ctx = callback_args;
+    pal_loopback_add_delay(time_us);
+    pal_os_event_due_ns = pal_loopback_timing_now_ns() + ((uint64_t)time_us * 1000U);
+}
+
+uint32_t pal_os_event_process(void)
+{
+    uint32_t count = 0;
+
+    while (NULL != pal_os_event_0.callback_registered)
+    {
+        pal_os_event_trigger_registered_callback();
+        count++;
+    }
+    return (count);
+}
+
+//lint --e{818,715} suppress "As there is no implementation, pal_os_event is not used"
+void pal_os_event_destroy(pal_os_event_t * pal_os_event)
+{
+    pal_os_event->callback_registered = NULL;
+}
+
+/**
+* @}
+*/
@@ -0,0 +1,106 @@
+/**
+* \copyright
+* MIT License
+*
+* Copyright (c) 2020 Infineon Technologies AG
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE
+*
+* \endcopyright
+*
+* \author Infineon Technologies AG
+*
+* \file pal_os_timer.c
+*
+* \brief   This file implements the platform abstraction layer APIs for timer.
+*
+* \details CLOCK_MONOTONIC for the stack's timeouts. Delays return at once and are only
+*          counted, like the event PAL delays. In replay mode the time comes from the capture,
+*          in timed mode from the simulated clock, which a delay moves on.
+*
+* \ingroup  grPAL
+* @{
+*/
+
+#include <time.h>
+
+#include "optiga/pal/pal_os_timer.h"
+#include "pal_loopback.h"
+
+/// @cond hidden
+static uint64_t pal_os_timer_now_us(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (((uint64_t)now.tv_sec * 1000000U) + ((uint64_t)now.tv_nsec / 1000U));
+}
+/// @endcond
+
+uint32_t pal_os_timer_get_time_in_microseconds(void)
+{
+    if (TRUE == pal_loopback_replay_active())
+    {
+        return (pal_loopback_replay_time_us());
+    }
+    if (TRUE == pal_loopback_timing_active())
+    {
+        return ((uint32_t)(pal_loopback_timing_now_ns() / 1000U));
+    }
+    // Wraps like the 32-bit microsecond timers of the MCU ports, the stack uses unsigned differences
+    return ((uint32_t)pal_os_timer_now_us());
+}
+
+uint32_t pal_os_timer_get_time_in_milliseconds(void)
+{
+    if (TRUE == pal_loopback_replay_active())
+    {
+        return (pal_loopback_replay_time_us() / 1000U);
+    }
+    if (TRUE == pal_loopback_timing_active())
+    {
+        return ((uint32_t)(pal_loopback_timing_now_ns() / 1000000U));
+    }
+    return ((uint32_t)(pal_os_timer_now_us() / 1000U));
+}
+
+void pal_os_timer_delay_in_milliseconds(uint16_t milliseconds)
+{
+    pal_loopback_add_delay((uint32_t)milliseconds * 1000U);
+    if (TRUE == pal_loopback_timing_active())
+    {
+        pal_loopback_timing_advance((uint64_t)milliseconds * 1000000U);
+    }
+}
+
+//lint --e{714} suppress "This function is used for to support multiple platform "
+pal_status_t pal_timer_init(void)
+{
+    return PAL_STATUS_SUCCESS;
+}
+
+//lint --e{714} suppress "This function is used for to support multiple platform "
+pal_status_t pal_timer_deinit(void)
+{
+    return PAL_STATUS_SUCCESS;
+}
+
+/**
+* @}
+*/
@@ -42,6 +42,11 @@
 #include "mbedtls/md.h"
 #include "mbedtls/ssl.h"
 #include "mbedtls/version.h"
+#ifdef PAL_CRYPT_TLS_PRF_ALT
+#include "optiga/pal/pal_crypt_esp32.h"
+// pal_crypt_esp32.c owns pal_crypt_tls_prf_sha256(), this one is its mbedtls_md backend
+#define pal_crypt_tls_prf_sha256 pal_crypt_tls_prf_sha256_md
+#endif
 
 #define PAL_CRYPT_MAX_LABEL_SEED_LENGTH     (96U)
 //lint --e{818, 715, 830} suppress "argument "p_pal_crypt" is not used in the implementation but kept for future use"
@@ -164,7 +169,11 @@ pal_status_t pal_crypt_tls_prf_sha256(pal_crypt_t* p_pal_crypt,
     #undef PAL_CRYPT_DIGEST_MAX_SIZE
     return return_value;
 }
+#ifdef PAL_CRYPT_TLS_PRF_ALT
+#undef pal_crypt_tls_prf_sha256
+#endif
 
+#ifndef PAL_CRYPT_AES_CCM_ALT
 //lint --e{818, 715, 830} suppress "argument "p_pal_crypt" is not used in the implementation but kept for future use"
 pal_status_t pal_crypt_encrypt_aes128_ccm(pal_crypt_t* p_pal_crypt,
                                           const uint8_t * p_plain_text,
@@ -277,6 +286,7 @@ pal_status_t pal_crypt_decrypt_aes128_ccm(pal_crypt_t* p_pal_crypt,
     #undef AES128_KEY_BITS_SIZE
     return return_status;
 }
+#endif //PAL_CRYPT_AES_CCM_ALT
 
 pal_status_t pal_crypt_version(uint8_t * p_crypt_lib_version_info, uint16_t * length)
 {
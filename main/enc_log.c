@@ -0,0 +1,4130 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Encrypt plaintext records inside OPTIGA and append them to storage.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    enc_log.c
+ * @brief   Encrypted log writer task (OPTIGA AES-CBC + FATFS)
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "optiga/optiga_crypt.h"
+#include "optiga/optiga_util.h"
+#include "optiga/common/optiga_lib_common.h"
+#include "optiga/pal/pal_sysview.h"
+#include "optiga_entropy.h"
+#include "optiga_sync.h"
+#include "optiga_trust.h"
+
+#include "enc_log.h"
+#include "log_store.h"
+#include "log_ring.h"
+#include "log_mount.h"
+#include "log_persona.h"
+#include "log_time.h"
+#include "log_diag.h"
+#if LOG_PERSONA_CACHE
+#include "esp_rom_crc.h"
+#endif
+#if LOG_MERKLE_MODE
+#include "log_merkle.h"
+#include "mbedtls/sha256.h"
+#endif
+#if LOG_BATCH_COMPRESS
+#include "log_lz.h"
+#endif
+#if LOG_BATCH_DELTA
+#include "log_delta.h"
+#include "log_record.h"
+#endif
+#if LOG_READ_CACHE
+#include "log_cache.h"
+#endif
+#if LOG_ISR_SUBMIT
+#include "esp_attr.h"
+#include "log_isr.h"
+#endif
+#if LOG_PSRAM && !LOG_ISR_SUBMIT
+#include "esp_attr.h"
+#endif
+#if LOG_ZONE_MAP
+#include "log_zone.h"
+#endif
+#if LOG_PM
+#include "log_pm.h"
+#endif
+#if LOG_BATCH_AUTOTUNE
+#include "log_tune.h"
+#endif
+
+#if LOG_HYBRID_MODE
+#include "esp_random.h"
+#include "mbedtls/aes.h"
+#endif
+#if LOG_RECORD_GCM
+#include "mbedtls/gcm.h"
+#endif
+#if LOG_CTR_MODE
+#include "log_simd.h"
+#endif
+#if LOG_HYBRID_MODE && LOG_SEQ_PERSIST == LOG_SEQ_PERSIST_OPTIGA
+#include "log_seq.h"
+#endif
+#if LOG_HYBRID_MODE || LOG_INTEGRITY_MODE == 1
+#include "mbedtls/platform_util.h"
+#endif
+
+#if LOG_MERKLE_MODE && !defined(OPTIGA_CRYPT_ECDSA_SIGN_ENABLED)
+#error "LOG_MERKLE_MODE needs OPTIGA ECDSA signing (not in the encrypted logger profile)"
+#endif
+
+// Writer task notification bits
+#define WRITER_NOTIFY_DATA   (1u << 0)
+#define WRITER_NOTIFY_FLUSH  (1u << 1)
+#define WRITER_NOTIFY_CLEAR  (1u << 2)
+#define WRITER_NOTIFY_SYNC   (1u << 3)
+#define WRITER_NOTIFY_POLICY (1u << 4)
+#define WRITER_NOTIFY_COMMIT (1u << 5)
+
+// Append latency histogram: bucket 0 is < 1 ms, bucket b covers [2^(b-1), 2^b) ms,
+// the last one everything longer
+#define APPEND_LAT_BUCKETS   18
+
+// Bulk buffers: PSRAM .bss with LOG_PSRAM, see bulk_buffer_bytes()
+#if LOG_PSRAM
+#define BULK_ATTR EXT_RAM_BSS_ATTR
+#else
+#define BULK_ATTR
+#endif
+
+#if LOG_CURRENT_POLICY && ((LOG_CURRENT_IDLE_MA < OPTIGA_TRUST_CURRENT_LIMIT_MIN_MA) || \
+                           (LOG_CURRENT_BUSY_MA > OPTIGA_TRUST_CURRENT_LIMIT_MAX_MA) || \
+                           (LOG_CURRENT_IDLE_MA > LOG_CURRENT_BUSY_MA))
+#error "LOG_CURRENT_IDLE_MA..LOG_CURRENT_BUSY_MA must lie within 6..15 mA"
+#endif
+
+// --------------------
+// Globals
+// --------------------
+static const char *TAG = "ENC_LOG";
+#if LOG_BATCH_MODE
+#if LOG_INTEGRITY_MODE
+// previous tag || block group || tag: the MAC input and the appended bytes share one buffer
+BULK_ATTR static uint8_t s_batch_frame[LOG_MAC_TAG_BYTES + BLOCK_GROUP_MAX_HDR_BYTES + BATCH_PT_MAX_BYTES +
+                                      LOG_MAC_TAG_BYTES];
+static uint8_t *const s_batch_group = s_batch_frame + LOG_MAC_TAG_BYTES;
+#elif LOG_BATCH_PIPELINE
+// Block group buffers handed between the writer (encrypt) and the storage task (append)
+typedef struct {
+    uint8_t data[BLOCK_GROUP_MAX_HDR_BYTES + BATCH_PT_MAX_BYTES];
+    size_t len;
+    uint32_t seq;                       // first record of the group, as in s_batch->seq
+    uint32_t uptime_ms;
+    uint32_t records;
+#if LOG_ZONE_MAP
+    log_zone_t zone;                    // records of the group, as in s_batch->zone
+#endif
+#if LOG_CHANNELS > 1
+    uint8_t channel;
+#endif
+} log_group_buf_t;
+BULK_ATTR static log_group_buf_t s_group_bufs[2];
+static uint8_t *s_batch_group = NULL;   // data of the buffer being encrypted into
+static QueueHandle_t s_group_free = NULL;   // buffers the writer may encrypt into
+static QueueHandle_t s_group_full = NULL;   // encrypted groups waiting for the storage task
+static TaskHandle_t s_store_task = NULL;
+static uint32_t s_store_errors = 0;     // records lost to append errors (storage task)
+static uint32_t s_pipeline_waits = 0;   // groups that waited for a free buffer
+#else
+BULK_ATTR static uint8_t s_batch_group[BLOCK_GROUP_MAX_HDR_BYTES + BATCH_PT_MAX_BYTES];
+#endif
+#if LOG_CHANNELS > 1
+// Each channel queues its group in its own buffer; groups are encrypted out of place
+BULK_ATTR static uint8_t s_channel_pt[LOG_CHANNELS][BATCH_PT_MAX_BYTES];
+#if !LOG_BATCH_PIPELINE
+// IV || the groups of one flush_batches() pass back to back: every channel encrypts under
+// LOG_KEY_OID, so they go to OPTIGA as one CBC stream (flush_joint())
+BULK_ATTR static uint8_t s_joint[AES_IV_BYTES + LOG_CHANNELS * BATCH_PT_MAX_BYTES];
+static uint32_t s_joint_flushes = 0;    // encrypt requests that carried several groups
+static uint32_t s_joint_groups = 0;     // groups they carried
+#endif
+#elif LOG_BATCH_PIPELINE
+// The group buffer is only picked at the flush
+BULK_ATTR static uint8_t s_batch_pt[BATCH_PT_MAX_BYTES];
+#elif LOG_INTEGRITY_MODE
+// Records are queued where their ciphertext goes, behind the group header, and encrypted
+// in place: each plaintext byte is written once and each ciphertext byte once
+static uint8_t *const s_batch_pt = s_batch_frame + LOG_MAC_TAG_BYTES + BLOCK_GROUP_HDR_BYTES;
+#else
+static uint8_t *const s_batch_pt = s_batch_group + BLOCK_GROUP_HDR_BYTES;
+#endif
+#if LOG_BATCH_COMPRESS
+BULK_ATTR static uint8_t s_batch_lz[BATCH_PT_MAX_BYTES];
+static uint32_t s_lz_tried = 0;         // groups offered to the compressor
+static uint32_t s_lz_groups = 0;        // groups written compressed
+static uint32_t s_lz_in_bytes = 0;      // group plaintext before / after compression (padded)
+static uint32_t s_lz_out_bytes = 0;
+static uint32_t s_lz_us = 0;            // time spent compressing
+#endif
+#if LOG_BATCH_DELTA
+BULK_ATTR static uint8_t s_batch_delta[BATCH_PT_MAX_BYTES];
+static log_delta_batch_t s_delta;       // fields of the queued records
+static bool s_delta_ok = false;         // every queued record re-encodes byte for byte
+static uint32_t s_delta_tried = 0;      // groups of sample records offered to the encoder
+static uint32_t s_delta_groups = 0;     // groups written delta encoded
+static uint32_t s_delta_in_bytes = 0;   // group plaintext before / after encoding (padded)
+static uint32_t s_delta_out_bytes = 0;
+#endif
+// Block group being queued, one per channel
+typedef struct {
+    uint8_t *pt;                // plaintext of the queued records
+    size_t count;
+    size_t used;                // plaintext bytes queued in pt
+    uint32_t seq;               // seq / uptime of the first record in the group
+    uint32_t uptime_ms;
+    uint32_t ring_pos;          // ring position of the first record (group commit)
+#if LOG_ZONE_MAP
+    log_zone_t zone;            // zone map of the queued records
+#endif
+} log_batch_t;
+static log_batch_t s_batches[LOG_CHANNELS];
+static log_batch_t *s_batch = &s_batches[0];    // the group being queued or flushed
+#endif
+
+static optiga_crypt_t *s_crypt = NULL;
+static optiga_util_t *s_util = NULL;
+static optiga_sync_t s_optiga_sync;
+#if LOG_PERSONA_CACHE
+static log_persona_t s_persona;         // this boot's view, stored at the end of enc_log_init
+static bool s_persona_used = false;     // a check was skipped on the record's word
+#endif
+
+// Metadata written to the AES key slot: enables AES key usage in LOG_KEY_OID
+static const uint8_t s_key_metadata[] = {0x20, 0x06, 0xD0, 0x01, 0x00, 0xD3, 0x01, 0x00};
+#if LOG_HYBRID_MODE || LOG_INTEGRITY_MODE == 1
+// Type PRESSEC, change never, execute always, read never: the secret only feeds
+// HKDF/HMAC inside OPTIGA and no one on the bus can replace it
+static const uint8_t s_secret_metadata[] = {0x20, 0x0C, 0xE8, 0x01, 0x21, 0xD0, 0x01, 0xFF,
+                                            0xD3, 0x01, 0x00, 0xD1, 0x01, 0xFF};
+#endif
+
+static log_ring_t s_ring;
+static TaskHandle_t s_writer_task = NULL;
+#if LOG_CURRENT_POLICY
+static volatile bool s_current_boost = false;
+static bool s_current_high = false;     // LOG_CURRENT_BUSY_MA set (writer task only)
+static int64_t s_current_busy_ms = 0;   // last time the policy saw work
+#endif
+#if LOG_WARM_POLICY
+static bool s_warm_expected = false;    // atomic: a record is announced at s_warm_expect_ms
+static uint32_t s_warm_expect_ms = 0;
+static uint32_t s_warm_records_ms = 0;  // last writer pass that took records
+static uint32_t s_warmups = 0;
+static uint32_t s_warm_skipped = 0;
+#endif
+static SemaphoreHandle_t s_file_lock = NULL;
+static SemaphoreHandle_t s_sync_done = NULL;
+static uint32_t s_submitted = 0;        // atomic: any task may submit
+// OPTIGA bring-up: done once set, ok when the key checks passed as well
+#define READY_EVENT_DONE     (1u << 0)
+#define READY_EVENT_OK       (1u << 1)
+// Storage mounted and opened (by enc_log_init, while the writer brings OPTIGA up)
+#define READY_EVENT_STORE    (1u << 2)
+#define READY_EVENT_STORE_OK (1u << 3)
+static EventGroupHandle_t s_ready_events = NULL;
+static enc_log_optiga_init_t s_optiga_init = NULL;
+static int64_t s_boot_start_us = 0;     // enc_log_init() entry
+static uint32_t s_boot_storage_ms = 0;  // mount, store open and its scan
+static uint32_t s_boot_mount_ms = 0;    // of that, the mount
+static uint32_t s_boot_open_ms = 0;     // and log_store_open()
+static uint32_t s_boot_optiga_ms = 0;   // bring-up, instances and key checks
+#if LOG_RING_POLICY == LOG_RING_BLOCK
+#define RING_EVENT_ROOM (1u << 0)
+static EventGroupHandle_t s_ring_events = NULL;
+static uint32_t s_room_waiters = 0;     // producers blocked on a full ring (atomic)
+#endif
+static uint32_t s_submit_blocked = 0;   // submits that found the ring full and waited (atomic)
+static uint32_t s_submit_timeouts = 0;  // of those, records dropped after LOG_RING_BLOCK_MS (atomic)
+
+// Group commit: tasks waiting in enc_log_wait_commit() until their ticket is durable
+typedef struct {
+    SemaphoreHandle_t done;
+    StaticSemaphore_t done_buf;
+    uint32_t ticket;
+    bool used;                          // cleared by whoever wakes or abandons the wait
+} commit_waiter_t;
+static commit_waiter_t s_commit_waiters[LOG_COMMIT_WAITERS];
+static SemaphoreHandle_t s_commit_lock = NULL;
+static volatile uint32_t s_committed = 0;   // tickets up to this one are in the synced store
+static uint32_t s_commit_waits = 0;     // enc_log_wait_commit() calls that had to wait
+static uint32_t s_commit_groups = 0;    // writer syncs that woke at least one of them
+static uint32_t s_records_written = 0;
+static uint32_t s_write_errors = 0;
+static uint32_t s_priority_records = 0;
+static uint32_t s_bytes_written = 0;    // log bytes appended (records, headers, tags)
+static bool s_maint_due = true;         // log_store_maintain() has work (open may leave some)
+static uint32_t s_maint_steps = 0;      // log_store_maintain() steps run by the writer
+static uint32_t s_append_lat[APPEND_LAT_BUCKETS];
+static uint32_t s_append_lat_count = 0;
+static uint64_t s_append_lat_sum_ms = 0;
+static uint32_t s_append_lat_max_ms = 0;
+static enc_log_append_cb_t s_append_cb = NULL;
+static void *s_append_ctx = NULL;
+#if LOG_BATCH_MAX_LATENCY_MS > 0
+static uint32_t s_deadline_flushes = 0;
+#endif
+#if LOG_BATCH_AUTOTUNE
+static bool s_tune_sync = false;        // a group was appended: sync and time it this pass
+#endif
+
+#if LOG_IV_MODE && !LOG_BATCH_MODE
+static uint8_t s_iv_nonce[IV_NONCE_BYTES];
+static bool s_iv_nonce_valid = false;   // false until a nonce is drawn (boot, clear, new epoch)
+static uint64_t s_iv_counter = 0;
+#if !LOG_HYBRID_MODE
+static uint8_t s_iv_cache[LOG_IV_BATCH * AES_IV_BYTES];
+static uint32_t s_iv_cached = 0;
+static uint32_t s_iv_next = 0;
+#endif
+#endif
+
+#if LOG_CTR_MODE
+// Keystream ring, lane aligned for the vector XOR (log_simd.h)
+BULK_ATTR static uint8_t s_ks[LOG_CTR_CACHE_BLOCKS * AES_BLOCK_BYTES] __attribute__((aligned(16)));
+static uint32_t s_ks_head = 0;          // next block a record takes
+static uint32_t s_ks_count = 0;         // blocks cached from s_ks_head on
+static uint64_t s_ks_counter = 0;       // counter of the block at s_ks_head
+#if LOG_CTR_MODE == LOG_CTR_PACKED
+static uint32_t s_ks_used = 0;          // bytes of the block at s_ks_head already taken
+#endif
+static uint8_t s_ks_nonce[IV_NONCE_BYTES];
+static bool s_ks_nonce_valid = false;   // false until a nonce is drawn (boot)
+static bool s_ks_stalled = false;       // idle refill failed, retried on the record path
+static uint32_t s_ks_inline = 0;        // records that found too few blocks cached
+#endif
+
+#if LOG_HYBRID_MODE
+#if LOG_RECORD_GCM
+typedef mbedtls_gcm_context host_key_t;
+#else
+typedef mbedtls_aes_context host_key_t;
+#endif
+static host_key_t s_epoch_aes[2];       // data keys: current and standby
+static host_key_t *s_host_aes = &s_epoch_aes[0];    // key of the current epoch
+#if LOG_RECORD_GCM
+static uint8_t s_epoch_aad[EPOCH_AAD_BYTES];        // current epoch header, in every tag
+#endif
+static uint8_t s_next_salt[EPOCH_SALT_BYTES];   // salt of the standby key
+static bool s_next_ready = false;       // standby key derived for the next epoch
+static bool s_next_failed = false;      // idle derivation failed, next switch derives inline
+static uint32_t s_key_epochs = 0;       // epochs started since boot
+static uint32_t s_key_inline = 0;       // of those, key derived on the record path
+static bool s_epoch_active = false;     // false until a data key is derived (boot, clear)
+static uint32_t s_epoch_id = 0;         // continues from the log's newest indexed header
+static uint32_t s_epoch_records = 0;
+static uint32_t s_epoch_offset = INDEX_NO_EPOCH;    // file offset of the current header
+#endif
+
+#if LOG_FORMAT_HEADER
+static bool s_format_due = true;        // next append goes behind a format header
+static uint32_t s_format_offset = INDEX_NO_EPOCH;   // file offset of the current header
+#endif
+
+#if LOG_MERKLE_MODE
+static log_merkle_t s_merkle;           // open window, leaves not yet under a signed root
+static log_merkle_t s_merkle_signed;    // last signed window, kept for proof export
+static uint8_t s_merkle_root_record[MERKLE_ROOT_BYTES];
+static bool s_merkle_have_signed = false;
+#endif
+
+// --------------------
+// Store Access
+// --------------------
+// Every store call runs under the file lock, so the store I/O lock (LOG_PM) keeps the
+// clocks up exactly as long
+static void file_lock(void)
+{
+    xSemaphoreTake(s_file_lock, portMAX_DELAY);
+#if LOG_PM
+    log_pm_io_begin();
+#endif
+}
+
+static void file_unlock(void)
+{
+#if LOG_PM
+    log_pm_io_end();
+#endif
+    xSemaphoreGive(s_file_lock);
+}
+
+// --------------------
+// OPTIGA Helpers
+// --------------------
+// Blocks on the completion semaphore given by optiga_sync_callback(). A request
+// that misses LOG_OPTIGA_TIMEOUT_MS is reported, then waited out: it still writes
+// into the caller's (stack) buffers and holds s_crypt/s_util until its callback.
+// A comms failure still fails the request, but the link is reset and the
+// application reopened right away so the next request goes through.
+static bool optiga_wait(void)
+{
+    optiga_lib_status_t ret = optiga_sync_wait_timeout(&s_optiga_sync, LOG_OPTIGA_TIMEOUT_MS);
+    if (ret == OPTIGA_LIB_BUSY) {
+        ESP_LOGW(TAG, "OPTIGA request still running after %u ms", (unsigned)LOG_OPTIGA_TIMEOUT_MS);
+        ret = optiga_sync_wait(&s_optiga_sync);
+    }
+    if (ret == OPTIGA_COMMS_ERROR || ret == OPTIGA_COMMS_ERROR_FATAL) {
+        ESP_LOGW(TAG, "OPTIGA comms error 0x%04X, recovering", ret);
+        if (optiga_trust_recover() != OPTIGA_LIB_SUCCESS) {
+            ESP_LOGE(TAG, "OPTIGA comms recovery failed, retried on the next error");
+        }
+    }
+    return (ret == OPTIGA_LIB_SUCCESS);
+}
+
+static bool optiga_rng_fill(uint8_t *out, uint16_t len)
+{
+    // TRNG bytes fetched at idle time; a TRNG command only when the pool runs dry
+    if (optiga_entropy_take(out, len)) {
+        return true;
+    }
+    optiga_sync_begin(&s_optiga_sync);
+    if (optiga_crypt_random(s_crypt, OPTIGA_RNG_TYPE_TRNG, out, len) != OPTIGA_LIB_SUCCESS) {
+        return false;
+    }
+    return optiga_wait();
+}
+
+static bool optiga_crypto_init(void)
+{
+    s_crypt = optiga_crypt_create(0, optiga_sync_callback, &s_optiga_sync);
+    if (s_crypt == NULL) {
+        ESP_LOGE(TAG, "optiga_crypt_create failed");
+        return false;
+    }
+    // Record encryption must not queue behind keygen/TLS work from other instances
+    OPTIGA_CRYPT_SET_PRIORITY(s_crypt, OPTIGA_CMD_PRIORITY_HIGH);
+
+    s_util = optiga_util_create(0, optiga_sync_callback, &s_optiga_sync);
+    if (s_util == NULL) {
+        ESP_LOGE(TAG, "optiga_util_create failed");
+        return false;
+    }
+
+    return true;
+}
+
+static bool optiga_key_ready(void)
+{
+    uint8_t metadata[64];
+    uint16_t metadata_len = sizeof(metadata);
+    const uint16_t oid = LOG_KEY_OID;
+
+    optiga_sync_begin(&s_optiga_sync);
+    optiga_lib_status_t ret = optiga_util_read_metadata(
+        s_util,
+        oid,
+        metadata,
+        &metadata_len);
+    if (ret != OPTIGA_LIB_SUCCESS) {
+        return false;
+    }
+    if (!optiga_wait()) {
+        return false;
+    }
+    if (metadata_len == 0) {
+        return false;
+    }
+
+    ESP_LOGI(TAG, "OPTIGA key metadata length: %u", (unsigned)metadata_len);
+    return true;
+}
+
+static bool optiga_write_e200_metadata(void)
+{
+    const uint16_t oid = LOG_KEY_OID;
+
+    // Metadata config enables AES key usage in slot 0xE200
+    ESP_LOGI(TAG, "Writing metadata for OPTIGA key slot 0xE200");
+    optiga_sync_begin(&s_optiga_sync);
+    optiga_lib_status_t ret = optiga_util_write_metadata(
+        s_util,
+        oid,
+        s_key_metadata,
+        sizeof(s_key_metadata));
+    if (ret != OPTIGA_LIB_SUCCESS) {
+        ESP_LOGE(TAG, "optiga_util_write_metadata start failed: 0x%04X", ret);
+        return false;
+    }
+    if (!optiga_wait()) {
+        ESP_LOGE(TAG, "optiga_util_write_metadata failed");
+        return false;
+    }
+    return true;
+}
+
+// --------------------
+// Personalization Record
+// --------------------
+// Objects an earlier boot found set up, from the NVS record: their metadata is not read
+// again. The layout hash covers the OIDs and metadata this firmware sets up, so a build
+// that provisions differently checks everything once.
+static bool persona_has(uint8_t object)
+{
+#if LOG_PERSONA_CACHE
+    if ((s_persona.objects & object) != 0) {
+        s_persona_used = true;
+        return true;
+    }
+#else
+    (void)object;
+#endif
+    return false;
+}
+
+static void persona_found(uint8_t object)
+{
+#if LOG_PERSONA_CACHE
+    s_persona.objects |= object;
+#else
+    (void)object;
+#endif
+}
+
+#if LOG_PERSONA_CACHE
+static uint32_t persona_layout(void)
+{
+    uint8_t oids[6] = {(uint8_t)(LOG_KEY_OID >> 8), (uint8_t)LOG_KEY_OID};
+    uint32_t crc = esp_rom_crc32_le(0, s_key_metadata, sizeof(s_key_metadata));
+#if LOG_HYBRID_MODE
+    oids[2] = (uint8_t)(LOG_HYBRID_SECRET_OID >> 8);
+    oids[3] = (uint8_t)LOG_HYBRID_SECRET_OID;
+#endif
+#if LOG_INTEGRITY_MODE == 1
+    oids[4] = (uint8_t)(LOG_MAC_SECRET_OID >> 8);
+    oids[5] = (uint8_t)LOG_MAC_SECRET_OID;
+#endif
+#if LOG_HYBRID_MODE || LOG_INTEGRITY_MODE == 1
+    crc = esp_rom_crc32_le(crc, s_secret_metadata, sizeof(s_secret_metadata));
+#endif
+    return esp_rom_crc32_le(crc, oids, sizeof(oids));
+}
+
+static void persona_begin(void)
+{
+    s_persona = *log_persona_get();
+    if (s_persona.layout != persona_layout()) {
+        s_persona.layout = persona_layout();
+        s_persona.objects = 0;
+    }
+}
+
+static void persona_store(void)
+{
+#if LOG_CURRENT_POLICY
+    // The policy changes 0xE0C4 at run time, so no value is known at the next boot
+    s_persona.current_limit_ma = 0;
+#else
+    optiga_trust_current_limit_t limit;
+    optiga_trust_get_current_limit(&limit);
+    s_persona.current_limit_ma = limit.milliamps;
+#endif
+    if (!log_persona_update(&s_persona)) {
+        ESP_LOGW(TAG, "personalization record not stored, next boot checks OPTIGA again");
+    }
+}
+#endif
+
+// First OPTIGA failure (not comms) on an object the record vouched for: the record is
+// cleared, so the next boot checks and provisions in full, and the key slot is checked now
+static void persona_revalidate(void)
+{
+#if LOG_PERSONA_CACHE
+    const optiga_lib_status_t status = s_optiga_sync.status;
+    if (!s_persona_used || status == OPTIGA_COMMS_ERROR || status == OPTIGA_COMMS_ERROR_FATAL) {
+        return;
+    }
+    s_persona_used = false;
+    s_persona.objects = 0;
+    (void)log_persona_update(&s_persona);
+    if (optiga_key_ready()) {
+        ESP_LOGW(TAG, "OPTIGA failed 0x%04X with the key set up, record cleared", status);
+    } else {
+        ESP_LOGE(TAG, "OPTIGA key slot not set up, stale record cleared: reboot to provision");
+    }
+#endif
+}
+
+static bool optiga_generate_key_if_enabled(void)
+{
+    if (GENERATE_KEY_ON_BOOT) {
+        ESP_LOGW(TAG, "GENERATE_KEY_ON_BOOT=1 (will overwrite key)");
+        if (!optiga_write_e200_metadata()) {
+            return false;
+        }
+    } else {
+        if (persona_has(LOG_PERSONA_KEY)) {
+            ESP_LOGI(TAG, "Using existing OPTIGA key (OID 0xE200), set up per NVS record");
+            return true;
+        }
+        if (optiga_key_ready()) {
+            ESP_LOGI(TAG, "Using existing OPTIGA key (OID 0xE200)");
+            persona_found(LOG_PERSONA_KEY);
+            return true;
+        }
+
+        ESP_LOGI(TAG, "OPTIGA key not ready. Initializing...");
+        if (!optiga_write_e200_metadata()) {
+            return false;
+        }
+    }
+
+    // Generate and store the AES-128 key inside OPTIGA
+    ESP_LOGI(TAG, "Generating AES-128 key in OPTIGA (OID 0xE200)...");
+    optiga_sync_begin(&s_optiga_sync);
+    optiga_key_id_t key_id = OPTIGA_KEY_ID_SECRET_BASED;
+    optiga_lib_status_t ret = optiga_crypt_symmetric_generate_key(
+        s_crypt,
+        OPTIGA_SYMMETRIC_AES_128,
+        (uint8_t)OPTIGA_KEY_USAGE_ENCRYPTION,
+        FALSE,
+        &key_id);
+    if (ret != OPTIGA_LIB_SUCCESS) {
+        ESP_LOGE(TAG, "optiga_crypt_symmetric_generate_key start failed: 0x%04X", ret);
+        return false;
+    }
+    if (!optiga_wait()) {
+        ESP_LOGE(TAG, "optiga_crypt_symmetric_generate_key failed");
+        return false;
+    }
+    ESP_LOGI(TAG, "AES key generated in OPTIGA");
+#if LOG_READ_CACHE
+    log_cache_wipe();
+#endif
+#if LOG_PERSONA_CACHE
+    s_persona.key_epoch++;
+#endif
+    persona_found(LOG_PERSONA_KEY);
+    return true;
+}
+
+// --------------------
+// Storage Helpers
+// --------------------
+static uint32_t snapshot_dropped(const enc_log_snapshot_t *snap)
+{
+#if LOG_CHANNELS > 1
+    if (snap->channel != 0) {
+        return log_channel_dropped(snap->channel);
+    }
+#endif
+    return log_store_dropped();
+}
+
+// Bytes dropped from the front since snap was opened shift its offsets down
+static uint32_t snapshot_shift(const enc_log_snapshot_t *snap)
+{
+    return snapshot_dropped(snap) - snap->base;
+}
+
+#if !LOG_BATCH_MODE
+// Variable-length records carry the plaintext length in front of the IV
+static void put_record_header(uint8_t *record, size_t pt_len)
+{
+#if LOG_RECORD_VARLEN
+    record[0] = RECORD_VARLEN_MAGIC;
+    record[1] = (uint8_t)pt_len;
+#else
+    (void)record;
+    (void)pt_len;
+#endif
+}
+#endif
+
+#if LOG_RECORD_CRC
+// Plaintext checksum: CRC-32 of the unit's first len - RECORD_CRC_BYTES plaintext bytes
+// (padding included) into its last RECORD_CRC_BYTES, little endian
+static void crc_put(uint8_t *unit, size_t len)
+{
+    const size_t body = len - RECORD_CRC_BYTES;
+    const uint32_t crc = esp_rom_crc32_le(0, unit, (uint32_t)body);
+    unit[body] = (uint8_t)crc;
+    unit[body + 1] = (uint8_t)(crc >> 8);
+    unit[body + 2] = (uint8_t)(crc >> 16);
+    unit[body + 3] = (uint8_t)(crc >> 24);
+}
+#endif
+
+#if LOG_IV_MODE && !LOG_BATCH_MODE
+// --------------------
+// Counter-Derived IVs
+// --------------------
+// Counter block: nonce (8B) || counter (8B, big endian). Encrypting it with the record key
+// yields an unpredictable IV without spending a TRNG command per record.
+static void iv_counter_block(uint8_t *block, uint64_t counter)
+{
+    memcpy(block, s_iv_nonce, IV_NONCE_BYTES);
+    for (int i = 0; i < 8; i++) {
+        block[IV_NONCE_BYTES + i] = (uint8_t)(counter >> (56 - 8 * i));
+    }
+}
+
+static bool next_record_iv(uint8_t *iv)
+{
+#if LOG_HYBRID_MODE
+    // Nonce and counter are reset by start_key_epoch()
+    uint8_t block[AES_IV_BYTES];
+    iv_counter_block(block, s_iv_counter);
+    if (mbedtls_aes_crypt_ecb(s_host_aes, MBEDTLS_AES_ENCRYPT, block, iv) != 0) {
+        return false;
+    }
+    s_iv_counter++;
+    return true;
+#else
+    if (!s_iv_nonce_valid) {
+        if (!optiga_rng_fill(s_iv_nonce, sizeof(s_iv_nonce))) {
+            return false;
+        }
+        s_iv_counter = 0;
+        s_iv_cached = 0;
+        s_iv_next = 0;
+        s_iv_nonce_valid = true;
+    }
+
+    // Derive LOG_IV_BATCH IVs with one ECB command and hand them out one by one
+    if (s_iv_next == s_iv_cached) {
+        uint8_t blocks[LOG_IV_BATCH * AES_IV_BYTES];
+        for (uint32_t i = 0; i < LOG_IV_BATCH; i++) {
+            iv_counter_block(blocks + i * AES_IV_BYTES, s_iv_counter + i);
+        }
+
+        uint32_t out_len = sizeof(s_iv_cache);
+        optiga_sync_begin(&s_optiga_sync);
+        optiga_lib_status_t ret = optiga_crypt_symmetric_encrypt_ecb(
+            s_crypt, OPTIGA_KEY_ID_SECRET_BASED, blocks, sizeof(blocks),
+            s_iv_cache, &out_len);
+        if (ret != OPTIGA_LIB_SUCCESS || !optiga_wait() || out_len != sizeof(s_iv_cache)) {
+            ESP_LOGE(TAG, "IV derivation (ECB) failed");
+            return false;
+        }
+        s_iv_counter += LOG_IV_BATCH;
+        s_iv_cached = LOG_IV_BATCH;
+        s_iv_next = 0;
+    }
+
+    memcpy(iv, s_iv_cache + s_iv_next * AES_IV_BYTES, AES_IV_BYTES);
+    s_iv_next++;
+    return true;
+#endif
+}
+#endif
+
+#if LOG_CTR_MODE
+// --------------------
+// Keystream Cache (CTR)
+// --------------------
+// Counter block: nonce (8B) || counter (8B, big endian), the same layout as the IVs of
+// LOG_IV_MODE (which is why the two modes exclude each other)
+static void ks_counter_block(uint8_t *block, uint64_t counter)
+{
+    memcpy(block, s_ks_nonce, IV_NONCE_BYTES);
+    for (int i = 0; i < 8; i++) {
+        block[IV_NONCE_BYTES + i] = (uint8_t)(counter >> (56 - 8 * i));
+    }
+}
+
+// Append up to LOG_CTR_REFILL_BLOCKS keystream blocks to the cache with one OPTIGA ECB
+// command, encrypted in place in the ring. False on an error or with the cache full.
+static bool ks_refill(void)
+{
+    if (!s_ks_nonce_valid) {
+        if (!optiga_rng_fill(s_ks_nonce, sizeof(s_ks_nonce))) {
+            return false;
+        }
+        s_ks_nonce_valid = true;
+    }
+    const uint32_t tail = (s_ks_head + s_ks_count) % LOG_CTR_CACHE_BLOCKS;
+    uint32_t n = LOG_CTR_CACHE_BLOCKS - s_ks_count;
+    if (n > LOG_CTR_CACHE_BLOCKS - tail) {
+        n = LOG_CTR_CACHE_BLOCKS - tail;
+    }
+    if (n > LOG_CTR_REFILL_BLOCKS) {
+        n = LOG_CTR_REFILL_BLOCKS;
+    }
+    if (n == 0) {
+        return false;
+    }
+
+    uint8_t *blocks = s_ks + tail * AES_BLOCK_BYTES;
+    for (uint32_t i = 0; i < n; i++) {
+        ks_counter_block(blocks + i * AES_BLOCK_BYTES, s_ks_counter + s_ks_count + i);
+    }
+    uint32_t out_len = n * AES_BLOCK_BYTES;
+    optiga_sync_begin(&s_optiga_sync);
+    optiga_lib_status_t ret = optiga_crypt_symmetric_encrypt_ecb(
+        s_crypt, OPTIGA_KEY_ID_SECRET_BASED, blocks, n * AES_BLOCK_BYTES, blocks, &out_len);
+    if (ret != OPTIGA_LIB_SUCCESS || !optiga_wait() || out_len != n * AES_BLOCK_BYTES) {
+        // Not counted as cached: the same counters are tried again
+        ESP_LOGE(TAG, "keystream (ECB) failed");
+        return false;
+    }
+    s_ks_count += n;
+    return true;
+}
+
+#if LOG_CTR_MODE == LOG_CTR_PACKED
+// XOR the record with the next cached keystream bytes, from where the last record
+// stopped; used bytes are wiped and a block leaves the cache once all of it is used
+static bool encrypt_record_ctr(const uint8_t *plaintext, size_t pt_len,
+                               uint8_t *record, size_t record_cap, size_t *record_len)
+{
+    // Ciphertext bytes: the plaintext, and its checksum with LOG_RECORD_CRC
+    const size_t ct_len = RECORD_PT_BYTES(pt_len);
+    if (pt_len == 0 || pt_len > PLAINTEXT_MAX ||
+        record_cap < (RECORD_HDR_BYTES + AES_IV_BYTES + ct_len)) {
+        return false;
+    }
+#if LOG_RECORD_CRC
+    uint8_t unit[RECORD_PT_BYTES(PLAINTEXT_MAX)];
+    memcpy(unit, plaintext, pt_len);
+    crc_put(unit, ct_len);
+    plaintext = unit;
+#endif
+    const uint32_t end = s_ks_used + (uint32_t)ct_len;
+    const uint32_t blocks = (end + AES_BLOCK_BYTES - 1) / AES_BLOCK_BYTES;
+
+    if (s_ks_count < blocks) {
+        s_ks_inline++;
+        while (s_ks_count < blocks) {
+            if (!ks_refill()) {
+                persona_revalidate();
+                return false;
+            }
+        }
+        s_ks_stalled = false;
+    }
+
+    // Keystream byte position of the first byte: counter * 16 + bytes used of its block
+    uint8_t *pos = record + RECORD_HDR_BYTES;
+    uint8_t *data = pos + AES_IV_BYTES;
+    const uint64_t first = s_ks_counter * AES_BLOCK_BYTES + s_ks_used;
+    memcpy(pos, s_ks_nonce, IV_NONCE_BYTES);
+    for (int i = 0; i < 8; i++) {
+        pos[IV_NONCE_BYTES + i] = (uint8_t)(first >> (56 - 8 * i));
+    }
+    // The bytes are contiguous in the ring up to its end, then go on at its start
+    size_t ks_pos = s_ks_head * AES_BLOCK_BYTES + s_ks_used;
+    for (size_t done = 0; done < ct_len; ks_pos = 0) {
+        const size_t run = (ct_len - done < sizeof(s_ks) - ks_pos) ? ct_len - done
+                                                                    : sizeof(s_ks) - ks_pos;
+        log_simd_xor(data + done, plaintext + done, s_ks + ks_pos, run);
+        memset(s_ks + ks_pos, 0, run);
+        done += run;
+    }
+    const uint32_t done = end / AES_BLOCK_BYTES;
+    s_ks_head = (s_ks_head + done) % LOG_CTR_CACHE_BLOCKS;
+    s_ks_count -= done;
+    s_ks_counter += done;
+    s_ks_used = end % AES_BLOCK_BYTES;
+
+    // Record format: header (2B) + keystream position (16B) + ciphertext (ct_len bytes)
+    put_record_header(record, pt_len);
+    *record_len = RECORD_HDR_BYTES + AES_IV_BYTES + ct_len;
+    return true;
+}
+#else
+// XOR the zero-padded record with the next cached keystream blocks; each block is wiped
+// once used and its counter is never handed out again
+static bool encrypt_record_ctr(const uint8_t *plaintext, size_t pt_len,
+                               uint8_t *record, size_t record_cap, size_t *record_len)
+{
+    const size_t padded = RECORD_PT_BYTES(pt_len);
+    if (pt_len > PLAINTEXT_MAX || record_cap < (RECORD_HDR_BYTES + AES_IV_BYTES + padded)) {
+        return false;
+    }
+    const uint32_t blocks = (uint32_t)(padded / AES_BLOCK_BYTES);
+    size_t in_len = pt_len;
+#if LOG_RECORD_CRC
+    // The checksum covers the zero padding: XOR a padded copy that ends with it
+    uint8_t unit[RECORD_PT_BYTES(PLAINTEXT_MAX)];
+    memcpy(unit, plaintext, pt_len);
+    memset(unit + pt_len, 0, padded - pt_len);
+    crc_put(unit, padded);
+    plaintext = unit;
+    in_len = padded;
+#endif
+
+    // A burst past the cache waits for its own ECB command, like a CBC record would
+    if (s_ks_count < blocks) {
+        s_ks_inline++;
+        while (s_ks_count < blocks) {
+            if (!ks_refill()) {
+                persona_revalidate();
+                return false;
+            }
+        }
+        s_ks_stalled = false;
+    }
+
+    uint8_t *ctr = record + RECORD_HDR_BYTES;
+    uint8_t *data = ctr + AES_IV_BYTES;
+    ks_counter_block(ctr, s_ks_counter);
+    // One pass per contiguous run of the ring: plaintext ^ keystream, then the keystream
+    // alone where the zero padding goes
+    uint32_t slot = s_ks_head;
+    for (size_t done = 0; done < padded; slot = 0) {
+        const size_t ring_left = (LOG_CTR_CACHE_BLOCKS - slot) * AES_BLOCK_BYTES;
+        const size_t run = (padded - done < ring_left) ? padded - done : ring_left;
+        const size_t pt_run = (in_len <= done) ? 0 : (in_len - done < run) ? in_len - done : run;
+        uint8_t *ks = s_ks + slot * AES_BLOCK_BYTES;
+        log_simd_xor(data + done, plaintext + done, ks, pt_run);
+        log_simd_copy(data + done + pt_run, ks + pt_run, run - pt_run);
+        memset(ks, 0, run);
+        done += run;
+    }
+    s_ks_head = (s_ks_head + blocks) % LOG_CTR_CACHE_BLOCKS;
+    s_ks_count -= blocks;
+    s_ks_counter += blocks;
+
+    // Record format: [header (2B)] + counter block (16B) + ciphertext (64B, or padded length)
+    put_record_header(record, pt_len);
+    *record_len = RECORD_HDR_BYTES + AES_IV_BYTES + padded;
+    return true;
+}
+#endif
+#endif
+
+#if !LOG_BATCH_MODE && !LOG_HYBRID_MODE && !LOG_CTR_MODE
+static bool encrypt_record(const uint8_t *plaintext, size_t pt_len,
+                           uint8_t *record, size_t record_cap, size_t *record_len)
+{
+    const size_t padded = RECORD_PT_BYTES(pt_len);
+    if (pt_len > PLAINTEXT_MAX || record_cap < (RECORD_HDR_BYTES + AES_IV_BYTES + padded)) {
+        return false;
+    }
+
+    // The record is built in place: IV, then the zero-padded plaintext behind it,
+    // which OPTIGA encrypts in place
+    uint8_t *iv = record + RECORD_HDR_BYTES;
+    uint8_t *data = iv + AES_IV_BYTES;
+
+#if LOG_IV_MODE
+    const bool have_iv = next_record_iv(iv);
+    if (!have_iv) {
+        ESP_LOGE(TAG, "IV generation failed");
+        return false;
+    }
+#else
+    // Random IV (one per record): TRNG bytes fetched at idle time, else generated by OPTIGA
+    // together with the encryption below
+    const bool have_iv = optiga_entropy_take(iv, AES_IV_BYTES);
+#endif
+
+    memcpy(data, plaintext, pt_len);
+    memset(data + pt_len, 0, padded - pt_len);
+#if LOG_RECORD_CRC
+    crc_put(data, padded);
+#endif
+
+    uint32_t cipher_len = (uint32_t)padded;
+    optiga_lib_status_t ret;
+    optiga_sync_begin(&s_optiga_sync);
+    // OPTIGA performs AES-CBC using the key in slot 0xE200
+    if (have_iv) {
+        ret = optiga_crypt_symmetric_encrypt(
+            s_crypt,
+            OPTIGA_SYMMETRIC_CBC,
+            OPTIGA_KEY_ID_SECRET_BASED,
+            data,
+            padded,
+            iv,
+            AES_IV_BYTES,
+            NULL,
+            0,
+            data,
+            &cipher_len);
+    } else {
+        // GetRandom and EncryptSym back to back under one lock: one queue wait, one wake-up
+        ret = optiga_crypt_symmetric_encrypt_random_iv(
+            s_crypt,
+            OPTIGA_SYMMETRIC_CBC,
+            OPTIGA_RNG_TYPE_TRNG,
+            OPTIGA_KEY_ID_SECRET_BASED,
+            data,
+            padded,
+            iv,
+            AES_IV_BYTES,
+            data,
+            &cipher_len);
+    }
+    if (ret != OPTIGA_LIB_SUCCESS) {
+        ESP_LOGE(TAG, "optiga_crypt_symmetric_encrypt start failed: 0x%04X", ret);
+        return false;
+    }
+    if (!optiga_wait()) {
+        ESP_LOGE(TAG, "optiga_crypt_symmetric_encrypt failed");
+        persona_revalidate();
+        return false;
+    }
+    if (cipher_len != padded) {
+        ESP_LOGE(TAG, "unexpected ciphertext length: %lu", (unsigned long)cipher_len);
+        return false;
+    }
+
+    // Record format: [header (2B)] + IV (16B) + Ciphertext (64B, or padded length)
+    put_record_header(record, pt_len);
+    *record_len = RECORD_HDR_BYTES + AES_IV_BYTES + padded;
+    return true;
+}
+#endif
+
+// Sparse index entry for the append just written to channel (records starting at seq)
+static void index_last_append(uint8_t channel, uint32_t seq, uint32_t uptime_ms, uint32_t records)
+{
+#if LOG_HYBRID_MODE
+    const uint32_t epoch_offset = s_epoch_offset;
+#elif LOG_FORMAT_HEADER
+    const uint32_t epoch_offset = s_format_offset;
+#else
+    const uint32_t epoch_offset = INDEX_NO_EPOCH;
+#endif
+    file_lock();
+#if LOG_CHANNELS > 1
+    if (channel != 0) {
+        log_channel_index(channel, seq, uptime_ms, log_time_base_ms(), records);
+        file_unlock();
+        return;
+    }
+#else
+    (void)channel;
+#endif
+    log_store_index(seq, uptime_ms, epoch_offset, log_time_base_ms(), records);
+    file_unlock();
+}
+
+#if LOG_ZONE_MAP
+// Zone map of the records in the append just written
+static void zone_last_append(const log_zone_t *zone)
+{
+    file_lock();
+    log_store_zone_add(zone);
+    file_unlock();
+}
+#endif
+
+#if LOG_FORMAT_HEADER
+// Format header of this build
+void enc_log_format_header(uint8_t header[FORMAT_HDR_BYTES])
+{
+    const uint32_t flags = LOG_FORMAT_FLAGS;
+    memset(header, 0, FORMAT_HDR_BYTES);
+    memcpy(header, FORMAT_HDR_MAGIC, FORMAT_HDR_MAGIC_BYTES);
+    uint8_t *f = header + FORMAT_HDR_MAGIC_BYTES;
+    f[0] = (uint8_t)LOG_FORMAT_VERSION;
+    f[1] = (uint8_t)(LOG_FORMAT_VERSION >> 8);
+    for (int i = 0; i < 4; i++) {
+        f[2 + i] = (uint8_t)(flags >> (8 * i));
+    }
+    f[6] = (uint8_t)PLAINTEXT_MAX;
+    f[7] = (uint8_t)(PLAINTEXT_MAX >> 8);
+}
+
+// Under file_lock: put a format header ahead of the next len bytes when it is due, in a
+// new segment if the two would not fit in this one. Every new file gets one.
+static bool format_header_write(size_t len)
+{
+    if (log_store_rotate_due((s_format_due ? FORMAT_HDR_BYTES : 0) + len)) {
+        if (!log_store_rotate()) {
+            return false;
+        }
+        s_format_due = true;
+    }
+    if (!s_format_due) {
+        return true;
+    }
+    uint8_t header[FORMAT_HDR_BYTES];
+    enc_log_format_header(header);
+    if (!log_store_append(header, sizeof(header))) {
+        return false;
+    }
+    s_format_offset = log_store_last_offset();
+    s_format_due = false;
+    s_bytes_written += sizeof(header);
+    return true;
+}
+
+// At boot: the data goes on behind the newest format header (the one the last index entry
+// names) if it matches this build and sits in the open file; a new header otherwise. With
+// hybrid keys the index names epoch headers, so every boot writes one.
+static void format_resume(void)
+{
+#if !LOG_HYBRID_MODE
+    log_store_entry_t entry;
+    uint8_t want[FORMAT_HDR_BYTES];
+    uint8_t header[FORMAT_HDR_BYTES];
+    enc_log_format_header(want);
+    if (log_store_seek(LOG_STORE_SEEK_POSITION, log_store_size(), &entry) &&
+        entry.epoch_position != INDEX_NO_EPOCH &&
+        log_store_read(entry.epoch_position, header, sizeof(header)) == sizeof(header) &&
+        memcmp(header, want, sizeof(header)) == 0) {
+        s_format_offset = log_store_file_offset(entry.epoch_position);
+        s_format_due = (s_format_offset == INDEX_NO_EPOCH);
+    }
+#endif
+}
+#endif
+
+// Append to the log of channel (0: the store)
+static bool write_log_bytes(uint8_t channel, const uint8_t *data, size_t len)
+{
+    file_lock();
+#if LOG_FORMAT_HEADER
+    bool ok = (channel != 0) || format_header_write(len);
+#else
+    bool ok = true;
+#endif
+#if LOG_CHANNELS > 1
+    ok = ok && ((channel != 0) ? log_channel_append(channel, data, len) : log_store_append(data, len));
+#else
+    (void)channel;
+    ok = ok && log_store_append(data, len);
+#endif
+    file_unlock();
+    if (ok) {
+        s_bytes_written += (uint32_t)len;
+    }
+    return ok;
+}
+
+// Submit to append time of the oldest record in the append just written
+static void append_latency_add(uint32_t uptime_ms)
+{
+    const uint32_t ms = (uint32_t)(esp_timer_get_time() / 1000) - uptime_ms;
+    uint32_t b = 0;
+    while (b < APPEND_LAT_BUCKETS - 1 && (ms >> b) != 0) {
+        b++;
+    }
+    s_append_lat[b]++;
+    s_append_lat_count++;
+    s_append_lat_sum_ms += ms;
+    if (ms > s_append_lat_max_ms) {
+        s_append_lat_max_ms = ms;
+    }
+}
+
+// Upper bound of the bucket holding the p-th percentile, capped at the maximum seen
+static uint32_t append_latency_percentile_ms(uint32_t p)
+{
+    const uint32_t n = s_append_lat_count;
+    if (n == 0) {
+        return 0;
+    }
+    const uint32_t rank = (uint32_t)(((uint64_t)n * p + 99) / 100);
+    uint32_t seen = 0;
+    for (uint32_t b = 0; b < APPEND_LAT_BUCKETS; b++) {
+        seen += s_append_lat[b];
+        if (seen >= rank) {
+            const uint32_t bound = (b == 0) ? 0 : (1u << b) - 1;
+            return (bound < s_append_lat_max_ms) ? bound : s_append_lat_max_ms;
+        }
+    }
+    return s_append_lat_max_ms;
+}
+
+#if LOG_HYBRID_MODE || LOG_INTEGRITY_MODE == 1
+// --------------------
+// Secrets (HKDF in hybrid mode, HMAC in integrity mode)
+// --------------------
+// Metadata holds the one-byte tag with value (e.g. E8 01 21)
+static bool metadata_has(const uint8_t *metadata, uint16_t len, uint8_t tag, uint8_t value)
+{
+    for (uint16_t i = 2; i + 2 < len; i++) {
+        if (metadata[i] == tag && metadata[i + 1] == 0x01 && metadata[i + 2] == value) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 1: secret set up, 0: not provisioned, -1: error. A secret of an older build
+// without the change lock (D0 01 FF) gets it here and keeps its value.
+static int optiga_secret_ready(uint16_t oid)
+{
+    uint8_t metadata[64];
+    uint16_t metadata_len = sizeof(metadata);
+
+    optiga_sync_begin(&s_optiga_sync);
+    if (optiga_util_read_metadata(s_util, oid, metadata,
+                                  &metadata_len) != OPTIGA_LIB_SUCCESS) {
+        return 0;
+    }
+    if (!optiga_wait()) {
+        return 0;
+    }
+
+    // Look for data object type = PRESSEC (E8 01 21)
+    if (!metadata_has(metadata, metadata_len, 0xE8, 0x21)) {
+        return 0;
+    }
+    if (metadata_has(metadata, metadata_len, 0xD0, 0xFF)) {
+        return 1;
+    }
+    ESP_LOGI(TAG, "Locking secret in OID 0x%04X", oid);
+    optiga_sync_begin(&s_optiga_sync);
+    if (optiga_util_write_metadata(s_util, oid, s_secret_metadata,
+                                   sizeof(s_secret_metadata)) != OPTIGA_LIB_SUCCESS ||
+        !optiga_wait()) {
+        ESP_LOGE(TAG, "secret metadata write failed");
+        return -1;
+    }
+    return 1;
+}
+
+static bool optiga_provision_secret(uint16_t oid, uint16_t len)
+{
+    uint8_t secret[64];
+
+    if (len > sizeof(secret)) {
+        return false;
+    }
+    ESP_LOGI(TAG, "Provisioning secret in OID 0x%04X", oid);
+    if (!optiga_rng_fill(secret, len)) {
+        ESP_LOGE(TAG, "secret generation failed");
+        return false;
+    }
+
+    optiga_sync_begin(&s_optiga_sync);
+    optiga_lib_status_t ret = optiga_util_write_data(
+        s_util, oid, OPTIGA_UTIL_ERASE_AND_WRITE, 0, secret, len);
+    mbedtls_platform_zeroize(secret, sizeof(secret));
+    if (ret != OPTIGA_LIB_SUCCESS || !optiga_wait()) {
+        ESP_LOGE(TAG, "secret write failed");
+        return false;
+    }
+
+    optiga_sync_begin(&s_optiga_sync);
+    ret = optiga_util_write_metadata(s_util, oid,
+                                     s_secret_metadata, sizeof(s_secret_metadata));
+    if (ret != OPTIGA_LIB_SUCCESS || !optiga_wait()) {
+        ESP_LOGE(TAG, "secret metadata write failed");
+        return false;
+    }
+    return true;
+}
+#endif
+
+#if LOG_MERKLE_MODE
+// --------------------
+// Merkle Tree (one signed root per window of appends)
+// --------------------
+// Sign the root of the open window and append the root record. On failure the
+// window stays open and the next append or sync tries again.
+static bool write_merkle_root(void)
+{
+    uint8_t record[MERKLE_ROOT_BYTES];
+    uint8_t digest[LOG_MERKLE_HASH_BYTES];
+    uint8_t *sig = record + MERKLE_ROOT_SIGNED_BYTES + 1;
+    uint16_t sig_len = MERKLE_SIG_MAX_BYTES;
+    const uint32_t first_seq = s_merkle.info[0].seq;
+
+    if (s_merkle.count == 0) {
+        return true;
+    }
+    memset(record, 0, sizeof(record));
+    memcpy(record, MERKLE_ROOT_MAGIC, MERKLE_ROOT_MAGIC_BYTES);
+    record[MERKLE_ROOT_MAGIC_BYTES + 0] = (uint8_t)(first_seq);
+    record[MERKLE_ROOT_MAGIC_BYTES + 1] = (uint8_t)(first_seq >> 8);
+    record[MERKLE_ROOT_MAGIC_BYTES + 2] = (uint8_t)(first_seq >> 16);
+    record[MERKLE_ROOT_MAGIC_BYTES + 3] = (uint8_t)(first_seq >> 24);
+    record[MERKLE_ROOT_MAGIC_BYTES + 4] = (uint8_t)(s_merkle.count);
+    record[MERKLE_ROOT_MAGIC_BYTES + 5] = (uint8_t)(s_merkle.count >> 8);
+    if (!log_merkle_root(&s_merkle, record + MERKLE_ROOT_SIGNED_BYTES - LOG_MERKLE_HASH_BYTES) ||
+        mbedtls_sha256(record, MERKLE_ROOT_SIGNED_BYTES, digest, 0) != 0) {
+        ESP_LOGE(TAG, "merkle root hash failed");
+        return false;
+    }
+
+    // The only OPTIGA request per window: appends are hashed on the ESP32
+    optiga_sync_begin(&s_optiga_sync);
+    optiga_lib_status_t ret = optiga_crypt_ecdsa_sign(s_crypt, digest, sizeof(digest),
+                                                      (optiga_key_id_t)LOG_MERKLE_KEY_OID,
+                                                      sig, &sig_len);
+    if (ret != OPTIGA_LIB_SUCCESS || !optiga_wait() || sig_len > MERKLE_SIG_MAX_BYTES) {
+        ESP_LOGE(TAG, "merkle root sign failed");
+        return false;
+    }
+    record[MERKLE_ROOT_SIGNED_BYTES] = (uint8_t)sig_len;
+
+    if (!write_log_bytes(0, record, sizeof(record))) {
+        return false;
+    }
+    file_lock();
+    memcpy(&s_merkle_signed, &s_merkle, sizeof(s_merkle_signed));
+    memcpy(s_merkle_root_record, record, sizeof(record));
+    s_merkle_have_signed = true;
+    file_unlock();
+
+    ESP_LOGI(TAG, "merkle root signed: %lu leaves from seq %lu",
+             (unsigned long)s_merkle.count, (unsigned long)first_seq);
+    log_merkle_init(&s_merkle);
+    return true;
+}
+
+// Add the bytes just appended as the next leaf; a full window is signed right away
+static void merkle_add_leaf(const uint8_t *data, size_t len, uint32_t seq, uint32_t records)
+{
+    if (s_merkle.count >= LOG_MERKLE_LEAVES && !write_merkle_root()) {
+        LOG_DIAG(ESP_LOG_ERROR, TAG, "merkle window full, seq %lu not covered", (unsigned long)seq);
+        return;
+    }
+    log_merkle_leaf_t info = {.seq = seq, .len = (uint16_t)len, .records = (uint16_t)records};
+    file_lock();
+    info.offset = log_store_last_position();
+    file_unlock();
+
+    if (!log_merkle_append(&s_merkle, data, len, &info)) {
+        LOG_DIAG(ESP_LOG_ERROR, TAG, "merkle leaf failed, seq %lu not covered", (unsigned long)seq);
+        return;
+    }
+    if (s_merkle.count == LOG_MERKLE_LEAVES) {
+        write_merkle_root();
+    }
+}
+#endif
+
+#if LOG_HYBRID_MODE
+// --------------------
+// Hybrid Mode (OPTIGA-derived key, host AES)
+// --------------------
+static host_key_t *standby_aes(void)
+{
+    return (s_host_aes == &s_epoch_aes[0]) ? &s_epoch_aes[1] : &s_epoch_aes[0];
+}
+
+// Derive the next epoch's data key inside OPTIGA into the standby context. Runs while
+// the writer is idle, so the current key keeps serving appends and the switch itself
+// needs no OPTIGA command.
+static bool prepare_next_epoch(void)
+{
+    static const uint8_t info[] = EPOCH_KEY_INFO;
+    uint8_t key[16];
+
+    if (!optiga_rng_fill(s_next_salt, EPOCH_SALT_BYTES)) {
+        ESP_LOGE(TAG, "epoch salt generation failed");
+        return false;
+    }
+
+    optiga_sync_begin(&s_optiga_sync);
+    optiga_lib_status_t ret = optiga_crypt_hkdf(
+        s_crypt, OPTIGA_HKDF_SHA_256, LOG_HYBRID_SECRET_OID,
+        s_next_salt, EPOCH_SALT_BYTES, info, sizeof(info),
+        sizeof(key), TRUE, key);
+    if (ret != OPTIGA_LIB_SUCCESS || !optiga_wait()) {
+        ESP_LOGE(TAG, "optiga_crypt_hkdf failed");
+        persona_revalidate();
+        return false;
+    }
+
+#if LOG_RECORD_GCM
+    int rc = mbedtls_gcm_setkey(standby_aes(), MBEDTLS_CIPHER_ID_AES, key, 128);
+#else
+    int rc = mbedtls_aes_setkey_enc(standby_aes(), key, 128);
+#endif
+    mbedtls_platform_zeroize(key, sizeof(key));
+    if (rc != 0) {
+        ESP_LOGE(TAG, "data key setup failed: %d", rc);
+        return false;
+    }
+    s_next_ready = true;
+    return true;
+}
+
+// Continue the epoch ids after the newest epoch header the sparse index points to, so
+// ids stay unique across boots (from 0 without an index)
+static void epoch_id_resume(void)
+{
+    log_store_entry_t entry;
+    uint8_t header[EPOCH_HDR_MAGIC_BYTES + 4];
+
+    if (log_store_seek(LOG_STORE_SEEK_POSITION, log_store_size(), &entry) &&
+        entry.epoch_position != INDEX_NO_EPOCH &&
+        log_store_read(entry.epoch_position, header, sizeof(header)) == sizeof(header) &&
+        memcmp(header, EPOCH_HDR_MAGIC, EPOCH_HDR_MAGIC_BYTES) == 0) {
+        const uint8_t *id = header + EPOCH_HDR_MAGIC_BYTES;
+        s_epoch_id = ((uint32_t)id[0] | ((uint32_t)id[1] << 8) | ((uint32_t)id[2] << 16) |
+                      ((uint32_t)id[3] << 24)) + 1;
+    }
+}
+
+// Switch to the standby key (derived here if the writer found no idle time for it) and
+// append the epoch header that identifies it.
+static bool start_key_epoch(void)
+{
+    uint8_t header[EPOCH_HDR_BYTES];
+    uint8_t *salt = header + EPOCH_SALT_OFFSET;
+
+    if (!s_next_ready) {
+        s_key_inline++;
+        if (!prepare_next_epoch()) {
+            return false;
+        }
+    }
+
+    memset(header, 0, sizeof(header));
+    memcpy(header, EPOCH_HDR_MAGIC, EPOCH_HDR_MAGIC_BYTES);
+    header[EPOCH_HDR_MAGIC_BYTES + 0] = (uint8_t)(s_epoch_id);
+    header[EPOCH_HDR_MAGIC_BYTES + 1] = (uint8_t)(s_epoch_id >> 8);
+    header[EPOCH_HDR_MAGIC_BYTES + 2] = (uint8_t)(s_epoch_id >> 16);
+    header[EPOCH_HDR_MAGIC_BYTES + 3] = (uint8_t)(s_epoch_id >> 24);
+#if LOG_SEQ_PERSIST == LOG_SEQ_PERSIST_OPTIGA
+    // Sequence reservation the epoch starts under (the OPTIGA counter value)
+    const uint32_t seq_ceiling = log_seq_reserved();
+    for (int i = 0; i < 4; i++) {
+        header[EPOCH_HDR_MAGIC_BYTES + 4 + i] = (uint8_t)(seq_ceiling >> (8 * i));
+    }
+#endif
+    memcpy(salt, s_next_salt, EPOCH_SALT_BYTES);
+
+    if (!write_log_bytes(0, header, sizeof(header))) {
+        return false;
+    }
+    file_lock();
+    s_epoch_offset = log_store_last_offset();
+    file_unlock();
+    // The header is in the log: records from here on use its key
+    s_host_aes = standby_aes();
+    s_next_ready = false;
+    s_next_failed = false;
+#if LOG_RECORD_GCM
+    memcpy(s_epoch_aad, header, EPOCH_AAD_BYTES);
+#endif
+
+#if LOG_IV_MODE
+    // Fresh key: the IV counter restarts under a nonce taken from the epoch salt
+    memcpy(s_iv_nonce, salt, IV_NONCE_BYTES);
+    s_iv_counter = 0;
+    s_iv_nonce_valid = true;
+#endif
+#if LOG_READ_CACHE
+    // Plaintext read under retired keys does not outlive them
+    log_cache_wipe();
+#endif
+    ESP_LOGI(TAG, "key epoch %lu started", (unsigned long)s_epoch_id);
+    s_key_epochs++;
+    s_epoch_id++;
+    s_epoch_records = 0;
+    s_epoch_active = true;
+    return true;
+}
+
+#if LOG_RECORD_GCM
+// Nonce of the next record: epoch id (from the header) || record number in the epoch
+static void gcm_record_nonce(uint8_t *nonce)
+{
+    memcpy(nonce, s_epoch_aad + EPOCH_HDR_MAGIC_BYTES, 4);
+    for (int i = 0; i < 8; i++) {
+        nonce[4 + i] = (uint8_t)((uint64_t)s_epoch_records >> (56 - 8 * i));
+    }
+}
+#endif
+
+static bool encrypt_record_host(const uint8_t *plaintext, size_t pt_len,
+                                uint8_t *record, size_t record_cap, size_t *record_len)
+{
+    const size_t padded = RECORD_PT_BYTES(pt_len);
+    if (pt_len > PLAINTEXT_MAX || record_cap < (RECORD_HDR_BYTES + RECORD_IV_BYTES + padded)) {
+        return false;
+    }
+
+    // A GCM nonce must not repeat under the key: a new epoch before the counter wraps
+    if (!s_epoch_active ||
+        (LOG_KEY_ROTATE_RECORDS > 0 && s_epoch_records >= LOG_KEY_ROTATE_RECORDS) ||
+        (LOG_RECORD_GCM && s_epoch_records == UINT32_MAX)) {
+        if (!start_key_epoch()) {
+            s_epoch_active = false;
+            return false;
+        }
+    }
+
+#if LOG_RECORD_GCM
+    uint8_t aad[EPOCH_AAD_BYTES + RECORD_HDR_BYTES];
+    uint8_t *nonce = record + RECORD_HDR_BYTES;
+    uint8_t *tag = nonce + GCM_NONCE_BYTES;
+    uint8_t *data = tag + GCM_TAG_BYTES;
+
+    // One pass on the AES engine: ciphertext and tag over it, the epoch and the header
+    put_record_header(record, pt_len);
+    memcpy(aad, s_epoch_aad, EPOCH_AAD_BYTES);
+    memcpy(aad + EPOCH_AAD_BYTES, record, RECORD_HDR_BYTES);
+    gcm_record_nonce(nonce);
+    memcpy(data, plaintext, pt_len);
+#if LOG_RECORD_CRC
+    crc_put(data, padded);
+#endif
+    if (mbedtls_gcm_crypt_and_tag(s_host_aes, MBEDTLS_GCM_ENCRYPT, padded, nonce, GCM_NONCE_BYTES,
+                                  aad, sizeof(aad), data, data, GCM_TAG_BYTES, tag) != 0) {
+        return false;
+    }
+#else
+    uint8_t iv[AES_IV_BYTES];
+    uint8_t *record_iv = record + RECORD_HDR_BYTES;
+    uint8_t *data = record_iv + AES_IV_BYTES;
+#if LOG_IV_MODE
+    if (!next_record_iv(record_iv)) {
+        return false;
+    }
+#else
+    // Host RNG for the IV: no OPTIGA command left on the per-record path
+    esp_fill_random(record_iv, AES_IV_BYTES);
+#endif
+    // Plaintext goes where its ciphertext belongs and is encrypted in place
+    memcpy(data, plaintext, pt_len);
+    memset(data + pt_len, 0, padded - pt_len);
+#if LOG_RECORD_CRC
+    crc_put(data, padded);
+#endif
+    memcpy(iv, record_iv, sizeof(iv));
+    if (mbedtls_aes_crypt_cbc(s_host_aes, MBEDTLS_AES_ENCRYPT, padded, iv, data, data) != 0) {
+        return false;
+    }
+
+    put_record_header(record, pt_len);
+#endif
+    *record_len = RECORD_HDR_BYTES + RECORD_IV_BYTES + padded;
+    s_epoch_records++;
+    return true;
+}
+#endif
+
+#if LOG_BATCH_MODE
+#if LOG_BATCH_COMPRESS
+// LZ4 the queued plaintext into s_batch_lz (padded by encrypt_batch). Returns the
+// compressed length, 0 if that would not save a block (the group is stored as is).
+static size_t compress_batch(uint32_t raw_total)
+{
+    const int64_t t0 = esp_timer_get_time();
+    const size_t n = log_lz_compress(s_batch->pt, s_batch->used, s_batch_lz, sizeof(s_batch_lz));
+    s_lz_us += (uint32_t)(esp_timer_get_time() - t0);
+    s_lz_tried++;
+
+    const uint32_t padded = GROUP_PT_BYTES(n);
+    s_lz_in_bytes += raw_total;
+    if (n == 0 || padded >= raw_total) {
+        s_lz_out_bytes += raw_total;
+        return 0;
+    }
+    s_lz_out_bytes += padded;
+    s_lz_groups++;
+    return n;
+}
+#endif
+
+#if LOG_BATCH_DELTA
+// Keep the record's fields for the delta encoder while the group can still use it
+static void delta_add(const uint8_t *data, size_t len)
+{
+    log_record_fields_t f;
+    uint8_t canon[PLAINTEXT_MAX];
+    if (s_batch->count == 0) {
+        s_delta_ok = true;
+        s_delta.count = 0;
+    }
+    if (!s_delta_ok) {
+        return;
+    }
+    // The reader rebuilds records with log_record_encode(): anything else stays as is
+    s_delta_ok = log_record_fields(data, len, &f) &&
+                 (s_batch->count == 0 || f.format == s_delta.format) &&
+                 log_record_encode(canon, sizeof(canon), f.format, f.seq, f.uptime_ms) == len &&
+                 memcmp(canon, data, len) == 0;
+    if (s_delta_ok) {
+        s_delta.format = f.format;
+        s_delta.seq[s_delta.count] = f.seq;
+        s_delta.uptime_ms[s_delta.count] = f.uptime_ms;
+        s_delta.count++;
+    }
+}
+
+// Delta-encode the queued records into s_batch_delta (padded by encrypt_batch). Returns
+// the encoded length, 0 if the group is not all sample records or would not save a block.
+static size_t delta_batch(uint32_t raw_total)
+{
+    if (!s_delta_ok) {
+        return 0;
+    }
+    const size_t n = log_delta_encode(&s_delta, LOG_BATCH_DELTA == 2, s_batch_delta,
+                                      sizeof(s_batch_delta));
+    s_delta_tried++;
+
+    const uint32_t padded = GROUP_PT_BYTES(n);
+    s_delta_in_bytes += raw_total;
+    if (n == 0 || padded >= raw_total) {
+        s_delta_out_bytes += raw_total;
+        return 0;
+    }
+    s_delta_out_bytes += padded;
+    s_delta_groups++;
+    return n;
+}
+#endif
+
+#if LOG_INTEGRITY_MODE == 2
+// AES-CMAC under the log key of the first frame_len bytes of s_batch_frame, truncated
+// into tag. Start takes every whole block but the last, final the last 1..16 bytes,
+// which OPTIGA pads and masks as CMAC defines: the group is already block-aligned
+// behind the chained tag and header, so nothing is copied. The command layer packs
+// start into as few APDUs as for the CBC pass and keeps both under one strict sequence.
+static bool cmac_frame(size_t frame_len, uint8_t *tag)
+{
+    const uint32_t head = (uint32_t)(((frame_len - 1) / AES_BLOCK_BYTES) * AES_BLOCK_BYTES);
+    uint8_t mac[AES_BLOCK_BYTES];
+    uint32_t mac_len = sizeof(mac);
+
+    PAL_SYSVIEW_START(PAL_SYSVIEW_MARK_LOG_ENCRYPT);
+    optiga_sync_begin(&s_optiga_sync);
+    optiga_lib_status_t ret = optiga_crypt_symmetric_encrypt_start(
+        s_crypt, OPTIGA_SYMMETRIC_CMAC, OPTIGA_KEY_ID_SECRET_BASED, s_batch_frame, head,
+        NULL, 0, NULL, 0, 0, mac, &mac_len);
+    bool ok = (ret == OPTIGA_LIB_SUCCESS) && optiga_wait();
+    if (ok) {
+        mac_len = sizeof(mac);
+        optiga_sync_begin(&s_optiga_sync);
+        ret = optiga_crypt_symmetric_encrypt_final(s_crypt, s_batch_frame + head,
+                                                   (uint32_t)frame_len - head, mac, &mac_len);
+        ok = (ret == OPTIGA_LIB_SUCCESS) && optiga_wait() && mac_len == sizeof(mac);
+    }
+    PAL_SYSVIEW_STOP(PAL_SYSVIEW_MARK_LOG_ENCRYPT);
+    if (ok) {
+        memcpy(tag, mac, LOG_MAC_TAG_BYTES);
+    }
+    return ok;
+}
+#endif
+
+// A block group ready for OPTIGA: plaintext padded and checksummed, and its header
+typedef struct {
+    uint8_t *pt;
+    uint32_t total;             // padded plaintext bytes = ciphertext bytes
+    size_t hdr_len;
+#if LOG_BATCH_COMPRESS
+    size_t lz_len;              // compressed content bytes, 0 = stored plain
+#endif
+#if LOG_BATCH_DELTA
+    size_t delta_len;           // delta encoded content bytes, 0 = stored plain
+#endif
+} group_plan_t;
+
+// Pick the plaintext of the records queued in s_batch (delta encoded, compressed or as
+// queued), pad it and put the checksum at the end
+static void stage_batch(group_plan_t *plan)
+{
+    uint8_t *plaintext = s_batch->pt;
+    size_t content = s_batch->used;
+    size_t hdr_len = BLOCK_GROUP_HDR_BYTES;
+#if LOG_BATCH_DELTA
+    // A few bytes per sample record instead of the whole record
+    const size_t delta_len = delta_batch(GROUP_PT_BYTES(content));
+    if (delta_len > 0) {
+        plaintext = s_batch_delta;
+        content = delta_len;
+    }
+    plan->delta_len = delta_len;
+#endif
+#if LOG_BATCH_COMPRESS
+    // Fewer blocks to encrypt, send over I2C and store
+#if LOG_BATCH_DELTA
+    const size_t lz_len = (delta_len > 0) ? 0 : compress_batch(GROUP_PT_BYTES(content));
+#else
+    const size_t lz_len = compress_batch(GROUP_PT_BYTES(content));
+#endif
+    if (lz_len > 0) {
+        plaintext = s_batch_lz;
+        content = lz_len;
+        hdr_len = BLOCK_GROUP_LZ_HDR_BYTES;
+    }
+    plan->lz_len = lz_len;
+#endif
+    // Zero-pad to the AES block size (fixed records already are), checksum at the end
+    const uint32_t total = GROUP_PT_BYTES(content);
+    memset(plaintext + content, 0, total - content);
+#if LOG_RECORD_CRC
+    crc_put(plaintext, total);
+#endif
+    plan->pt = plaintext;
+    plan->total = total;
+    plan->hdr_len = hdr_len;
+}
+
+// Header of the group in s_batch up to its IV
+static void put_group_header(uint8_t *group, const group_plan_t *plan)
+{
+    group[0] = BLOCK_GROUP_MAGIC0;
+    group[2] = (uint8_t)s_batch->count;
+#if LOG_RECORD_VARLEN
+    group[1] = BLOCK_GROUP_MAGIC1_VAR;
+    group[3] = (uint8_t)(plan->total / AES_BLOCK_BYTES);
+#else
+    group[1] = BLOCK_GROUP_MAGIC1;
+    group[3] = 0;
+#endif
+#if LOG_BATCH_COMPRESS
+    if (plan->lz_len > 0) {
+        group[1] = BLOCK_GROUP_MAGIC1_LZ;
+        group[3] = (uint8_t)(plan->total / AES_BLOCK_BYTES);
+        group[4] = (uint8_t)plan->lz_len;
+        group[5] = (uint8_t)(plan->lz_len >> 8);
+    }
+#endif
+#if LOG_BATCH_DELTA
+    if (plan->delta_len > 0) {
+        group[1] = BLOCK_GROUP_MAGIC1_DELTA;
+        group[3] = (uint8_t)(plan->total / AES_BLOCK_BYTES);
+    }
+#endif
+}
+
+// AES-CBC of len bytes under LOG_KEY_OID in one request: the command layer splits it into
+// as few APDUs as the 640-byte symmetric limit allows and sends them back to back under
+// one strict sequence, OPTIGA keeps the CBC chaining state in between
+static bool batch_cbc_encrypt(const uint8_t *plaintext, uint32_t len, const uint8_t *iv,
+                              uint8_t *ciphertext)
+{
+    uint32_t cipher_len = len;
+    PAL_SYSVIEW_START(PAL_SYSVIEW_MARK_LOG_ENCRYPT);
+    optiga_sync_begin(&s_optiga_sync);
+    optiga_lib_status_t ret = optiga_crypt_symmetric_encrypt(
+        s_crypt, OPTIGA_SYMMETRIC_CBC, OPTIGA_KEY_ID_SECRET_BASED,
+        plaintext, len, iv, AES_IV_BYTES, NULL, 0,
+        ciphertext, &cipher_len);
+    const bool encrypted = (ret == OPTIGA_LIB_SUCCESS) && optiga_wait();
+    PAL_SYSVIEW_STOP(PAL_SYSVIEW_MARK_LOG_ENCRYPT);
+    if (ret != OPTIGA_LIB_SUCCESS) {
+        ESP_LOGE(TAG, "batch encrypt start failed: 0x%04X", ret);
+        return false;
+    }
+    if (!encrypted) {
+        ESP_LOGE(TAG, "batch encrypt failed");
+        persona_revalidate();
+        return false;
+    }
+    if (cipher_len != len) {
+        ESP_LOGE(TAG, "unexpected ciphertext length: %lu", (unsigned long)cipher_len);
+        return false;
+    }
+    return true;
+}
+
+// Encrypt all queued records as one CBC stream (one IV) into the block group at
+// s_batch_group, MAC included; its length goes to *group_len
+static bool encrypt_batch(size_t *group_len_out)
+{
+    group_plan_t plan;
+    stage_batch(&plan);
+    uint8_t *iv = s_batch_group + plan.hdr_len - AES_IV_BYTES;
+    // Same bytes as s_batch->pt for a plain group of one channel outside the pipeline:
+    // encrypted in place
+    uint8_t *ciphertext = s_batch_group + plan.hdr_len;
+
+    // One TRNG IV per block group instead of per record
+    if (!optiga_rng_fill(iv, AES_IV_BYTES)) {
+        ESP_LOGE(TAG, "IV generation failed");
+        return false;
+    }
+    if (!batch_cbc_encrypt(plan.pt, plan.total, iv, ciphertext)) {
+        return false;
+    }
+    put_group_header(s_batch_group, &plan);
+
+    size_t group_len = plan.hdr_len + plan.total;
+#if LOG_INTEGRITY_MODE == 1
+    // One HMAC per group over the previous tag (in front of the group) and the group,
+    // so a changed, dropped or reordered group breaks the chain
+    uint8_t *tag = s_batch_group + group_len;
+    uint32_t tag_len = LOG_MAC_TAG_BYTES;
+    s_batch_group[0] = BLOCK_GROUP_MAGIC0_MAC;
+    optiga_sync_begin(&s_optiga_sync);
+    const optiga_lib_status_t ret = optiga_crypt_hmac(s_crypt, OPTIGA_HMAC_SHA_256, LOG_MAC_SECRET_OID,
+                                                      s_batch_frame, LOG_MAC_TAG_BYTES + group_len, tag,
+                                                      &tag_len);
+    if (ret != OPTIGA_LIB_SUCCESS || !optiga_wait() || tag_len != LOG_MAC_TAG_BYTES) {
+        ESP_LOGE(TAG, "block group MAC failed");
+        persona_revalidate();
+        return false;
+    }
+    group_len += LOG_MAC_TAG_BYTES;
+#elif LOG_INTEGRITY_MODE == 2
+    // Encrypt-then-MAC: CMAC over the previous tag and the group just encrypted
+    s_batch_group[0] = BLOCK_GROUP_MAGIC0_CMAC;
+    if (!cmac_frame(LOG_MAC_TAG_BYTES + group_len, s_batch_group + group_len)) {
+        ESP_LOGE(TAG, "block group CMAC failed");
+        persona_revalidate();
+        return false;
+    }
+    group_len += LOG_MAC_TAG_BYTES;
+#endif
+    *group_len_out = group_len;
+    return true;
+}
+
+// Append an encrypted block group to channel and account for it (writer task, or the
+// storage task with LOG_BATCH_PIPELINE)
+static bool append_group(uint8_t channel, const uint8_t *group, size_t group_len, uint32_t seq,
+                         uint32_t uptime_ms, uint32_t records, const log_zone_t *zone)
+{
+    if (!write_log_bytes(channel, group, group_len)) {
+        return false;
+    }
+    index_last_append(channel, seq, uptime_ms, records);
+#if LOG_ZONE_MAP
+    // Zone maps summarise the store's segments
+    if (channel == 0) {
+        zone_last_append(zone);
+    }
+#else
+    (void)zone;
+#endif
+    append_latency_add(uptime_ms);
+#if LOG_MERKLE_MODE
+    merkle_add_leaf(group, group_len, seq, records);
+#endif
+
+    LOG_DIAG(ESP_LOG_DEBUG, TAG, "block group written: %u records", (unsigned)records);
+    s_records_written += records;
+    if (s_append_cb) {
+        s_append_cb(seq, records, s_append_ctx);
+    }
+    return true;
+}
+
+#if LOG_BATCH_PIPELINE
+// Storage stage: appends the groups the writer has encrypted, in order, and hands
+// each buffer back
+static void store_task(void *arg)
+{
+    (void)arg;
+    log_group_buf_t *buf;
+
+    while (true) {
+        xQueueReceive(s_group_full, &buf, portMAX_DELAY);
+#if LOG_ZONE_MAP
+        const log_zone_t *zone = &buf->zone;
+#else
+        const log_zone_t *zone = NULL;
+#endif
+#if LOG_CHANNELS > 1
+        const uint8_t channel = buf->channel;
+#else
+        const uint8_t channel = 0;
+#endif
+        if (!append_group(channel, buf->data, buf->len, buf->seq, buf->uptime_ms, buf->records,
+                          zone)) {
+            LOG_DIAG(ESP_LOG_ERROR, TAG, "block group append failed");
+            s_store_errors += buf->records;
+        }
+        xQueueSend(s_group_free, &buf, portMAX_DELAY);
+    }
+}
+
+// Wait until every group handed to the storage task is appended
+static void pipeline_drain(void)
+{
+    log_group_buf_t *bufs[2];
+
+    for (size_t i = 0; i < 2; i++) {
+        xQueueReceive(s_group_free, &bufs[i], portMAX_DELAY);
+    }
+    for (size_t i = 0; i < 2; i++) {
+        xQueueSend(s_group_free, &bufs[i], 0);
+    }
+}
+#endif
+
+// Encrypt the records queued in s_batch as one block group and append it (with
+// LOG_BATCH_PIPELINE, hand it to the storage task and return while it is written)
+static bool flush_batch(void)
+{
+    if (s_batch->count == 0) {
+        return true;
+    }
+    const uint8_t channel = (uint8_t)(s_batch - s_batches);
+
+    size_t group_len = 0;
+#if LOG_BATCH_PIPELINE
+    // Both buffers busy means storage is the slower stage: wait for it
+    log_group_buf_t *buf;
+    if (xQueueReceive(s_group_free, &buf, 0) != pdTRUE) {
+        s_pipeline_waits++;
+        xQueueReceive(s_group_free, &buf, portMAX_DELAY);
+    }
+    s_batch_group = buf->data;
+    if (!encrypt_batch(&group_len)) {
+        xQueueSend(s_group_free, &buf, 0);
+        return false;
+    }
+    buf->len = group_len;
+    buf->seq = s_batch->seq;
+    buf->uptime_ms = s_batch->uptime_ms;
+    buf->records = (uint32_t)s_batch->count;
+#if LOG_ZONE_MAP
+    buf->zone = s_batch->zone;
+#endif
+#if LOG_CHANNELS > 1
+    buf->channel = channel;
+#else
+    (void)channel;
+#endif
+    xQueueSend(s_group_full, &buf, portMAX_DELAY);
+#else
+#if LOG_ZONE_MAP
+    const log_zone_t *zone = &s_batch->zone;
+#else
+    const log_zone_t *zone = NULL;
+#endif
+#if LOG_BATCH_AUTOTUNE
+    const int64_t start_us = esp_timer_get_time();
+#endif
+    if (!encrypt_batch(&group_len) ||
+        !append_group(channel, s_batch_group, group_len, s_batch->seq, s_batch->uptime_ms,
+                      (uint32_t)s_batch->count, zone)) {
+        return false;
+    }
+#if LOG_BATCH_AUTOTUNE
+    log_tune_group((uint32_t)s_batch->count, (uint32_t)(esp_timer_get_time() - start_us));
+    s_tune_sync = true;
+#endif
+#if LOG_INTEGRITY_MODE
+    // Only a written tag moves the chain on
+    memcpy(s_batch_frame, s_batch_group + group_len - LOG_MAC_TAG_BYTES, LOG_MAC_TAG_BYTES);
+#endif
+#endif
+    s_batch->count = 0;
+    s_batch->used = 0;
+    return true;
+}
+
+#if LOG_BATCH_MAX_LATENCY_MS > 0
+// How long a group may wait: LOG_BATCH_MAX_LATENCY_MS or the tuner's deadline, or
+// LOG_BATCH_PACED_LATENCY_MS while the OPTIGA governor holds key commands back (a part
+// filled group would only wait there)
+static uint32_t batch_latency_ms(void)
+{
+#if LOG_BATCH_AUTOTUNE
+    uint32_t latency_ms = log_tune_deadline_ms();
+#else
+    uint32_t latency_ms = LOG_BATCH_MAX_LATENCY_MS;
+#endif
+#ifdef OPTIGA_CMD_GOVERNOR
+    if (optiga_cmd_governor_pacing(0)) {
+        latency_ms = LOG_BATCH_PACED_LATENCY_MS;
+    }
+#endif
+    return latency_ms;
+}
+
+// Milliseconds until the oldest record of a non-empty group is due
+static uint32_t group_delay_ms(const log_batch_t *batch, uint32_t latency_ms)
+{
+    const uint32_t age_ms = (uint32_t)(esp_timer_get_time() / 1000) - batch->uptime_ms;
+    return (age_ms >= latency_ms) ? 0 : latency_ms - age_ms;
+}
+
+// Milliseconds until the oldest queued record of any channel is due, UINT32_MAX if every
+// group is empty
+static uint32_t batch_delay_ms(void)
+{
+    uint32_t delay_ms = UINT32_MAX;
+    uint32_t latency_ms = 0;
+    for (size_t c = 0; c < LOG_CHANNELS; c++) {
+        if (s_batches[c].count == 0) {
+            continue;
+        }
+        if (delay_ms == UINT32_MAX) {
+            latency_ms = batch_latency_ms();
+        }
+        const uint32_t ms = group_delay_ms(&s_batches[c], latency_ms);
+        delay_ms = (ms < delay_ms) ? ms : delay_ms;
+    }
+    return delay_ms;
+}
+#endif
+
+#if LOG_CHANNELS > 1 && !LOG_BATCH_PIPELINE
+// Drop the records queued in s_batch as write errors
+static void batch_lost(void)
+{
+    s_write_errors += (uint32_t)s_batch->count;
+    s_batch->count = 0;
+    s_batch->used = 0;
+}
+
+// Flush the groups of the channels in due[] (two or more) with one encrypt request instead
+// of one each. Each group keeps its header and goes to its own file; its IV is the
+// ciphertext block in front of it in the stream, so it still decrypts on its own.
+// Records of a group that fails count as write errors. False if one failed.
+static bool flush_joint(const uint8_t *due, size_t n)
+{
+    group_plan_t plans[LOG_CHANNELS];
+    uint32_t len = 0;
+    uint32_t records = 0;
+    for (size_t i = 0; i < n; i++) {
+        s_batch = &s_batches[due[i]];
+        stage_batch(&plans[i]);
+        // Compressed groups share one staging buffer: copy each before the next
+        memcpy(s_joint + AES_IV_BYTES + len, plans[i].pt, plans[i].total);
+        len += plans[i].total;
+        records += (uint32_t)s_batch->count;
+    }
+
+#if LOG_BATCH_AUTOTUNE
+    const int64_t start_us = esp_timer_get_time();
+#endif
+    bool encrypted = optiga_rng_fill(s_joint, AES_IV_BYTES);
+    if (!encrypted) {
+        ESP_LOGE(TAG, "IV generation failed");
+    } else {
+        encrypted = batch_cbc_encrypt(s_joint + AES_IV_BYTES, len, s_joint, s_joint + AES_IV_BYTES);
+    }
+    if (!encrypted) {
+        for (size_t i = 0; i < n; i++) {
+            s_batch = &s_batches[due[i]];
+            batch_lost();
+        }
+        return false;
+    }
+
+    bool ok = true;
+    uint32_t offset = 0;        // of the group's IV in s_joint
+    for (size_t i = 0; i < n; i++) {
+        const uint8_t channel = due[i];
+        s_batch = &s_batches[channel];
+        put_group_header(s_batch_group, &plans[i]);
+        memcpy(s_batch_group + plans[i].hdr_len - AES_IV_BYTES, s_joint + offset,
+               AES_IV_BYTES + plans[i].total);
+        offset += plans[i].total;
+#if LOG_ZONE_MAP
+        const log_zone_t *zone = &s_batch->zone;
+#else
+        const log_zone_t *zone = NULL;
+#endif
+        if (!append_group(channel, s_batch_group, plans[i].hdr_len + plans[i].total, s_batch->seq,
+                          s_batch->uptime_ms, (uint32_t)s_batch->count, zone)) {
+            batch_lost();
+            ok = false;
+            continue;
+        }
+        s_batch->count = 0;
+        s_batch->used = 0;
+    }
+#if LOG_BATCH_AUTOTUNE
+    log_tune_group(records, (uint32_t)(esp_timer_get_time() - start_us));
+    s_tune_sync = true;
+#else
+    (void)records;
+#endif
+    s_joint_flushes++;
+    s_joint_groups += (uint32_t)n;
+    return ok;
+}
+#endif
+
+// Flush the queued group of every channel, or with due_only those past their deadline.
+// Records of a group that fails count as write errors. False if one failed.
+static bool flush_batches(bool due_only)
+{
+#if LOG_BATCH_MAX_LATENCY_MS > 0
+    const uint32_t latency_ms = due_only ? batch_latency_ms() : 0;
+#else
+    (void)due_only;
+#endif
+#if LOG_CHANNELS > 1 && !LOG_BATCH_PIPELINE
+    // Groups of several channels that are due together share one encrypt request
+    uint8_t due[LOG_CHANNELS];
+    size_t n = 0;
+    for (size_t c = 0; c < LOG_CHANNELS; c++) {
+        const log_batch_t *batch = &s_batches[c];
+        if (batch->count == 0) {
+            continue;
+        }
+#if LOG_BATCH_MAX_LATENCY_MS > 0
+        if (due_only && group_delay_ms(batch, latency_ms) > 0) {
+            continue;
+        }
+#endif
+        due[n++] = (uint8_t)c;
+    }
+    if (n > 1) {
+        return flush_joint(due, n);
+    }
+#endif
+    bool ok = true;
+    for (size_t c = 0; c < LOG_CHANNELS; c++) {
+        s_batch = &s_batches[c];
+#if LOG_BATCH_MAX_LATENCY_MS > 0
+        if (due_only && s_batch->count > 0 && group_delay_ms(s_batch, latency_ms) > 0) {
+            continue;
+        }
+#endif
+        if (!flush_batch()) {
+            s_write_errors += (uint32_t)s_batch->count;
+            s_batch->count = 0;
+            s_batch->used = 0;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+static bool queue_batch_record(const log_ring_slot_t *rec)
+{
+    const uint8_t *plaintext = rec->data;
+    const size_t pt_len = rec->len;
+    if (pt_len > PLAINTEXT_MAX) {
+        return false;
+    }
+    // Each channel fills its own group
+    s_batch = &s_batches[LOG_RING_CHANNEL(rec->flags) % LOG_CHANNELS];
+    if (s_batch->count == 0) {
+        // Peeked: tail has already moved past it
+        s_batch->ring_pos = s_ring.tail - 1;
+        s_batch->seq = rec->seq;
+        s_batch->uptime_ms = rec->uptime_ms;
+#if LOG_ZONE_MAP
+        log_zone_reset(&s_batch->zone);
+#endif
+    }
+#if LOG_BATCH_DELTA
+    delta_add(plaintext, pt_len);
+#endif
+#if LOG_ZONE_MAP
+    log_zone_add(&s_batch->zone, plaintext, pt_len, rec->seq, rec->uptime_ms, log_time_base_ms(),
+                 rec->flags & LOG_RING_FLAG_PRIORITY);
+#endif
+
+    uint8_t *slot = s_batch->pt + s_batch->used;
+#if LOG_RECORD_VARLEN
+    slot[0] = (uint8_t)pt_len;
+    memcpy(slot + 1, plaintext, pt_len);
+    s_batch->used += 1 + pt_len;
+#else
+    memset(slot, 0, PLAINTEXT_MAX);
+    memcpy(slot, plaintext, pt_len);
+    s_batch->used += PLAINTEXT_MAX;
+#endif
+    s_batch->count++;
+
+    // An alarm does not wait for the rest of its group
+#if LOG_BATCH_AUTOTUNE
+    const size_t group_records = log_tune_batch();
+#else
+    const size_t group_records = LOG_BATCH_RECORDS;
+#endif
+    if (s_batch->count < group_records && !(rec->flags & LOG_RING_FLAG_PRIORITY)) {
+        return true;
+    }
+#if LOG_CHANNELS > 1
+    // The groups of the other channels were queued before the alarm: they go with it
+    if (rec->flags & LOG_RING_FLAG_PRIORITY) {
+        return flush_batches(false);
+    }
+#endif
+    return flush_batch();
+}
+#endif
+
+static void clear_log_file(void)
+{
+#if LOG_BATCH_MODE
+    for (size_t c = 0; c < LOG_CHANNELS; c++) {
+        s_batches[c].count = 0;
+        s_batches[c].used = 0;
+    }
+#endif
+#if LOG_BATCH_PIPELINE
+    // Groups already encrypted go to the old file, before it is truncated
+    pipeline_drain();
+#endif
+#if LOG_INTEGRITY_MODE
+    // The MAC chain restarts with the empty log
+    memset(s_batch_frame, 0, LOG_MAC_TAG_BYTES);
+#endif
+#if LOG_MERKLE_MODE
+    // Proofs into the truncated file are gone with it
+    log_merkle_init(&s_merkle);
+    file_lock();
+    s_merkle_have_signed = false;
+    file_unlock();
+#endif
+#if LOG_HYBRID_MODE
+    // The truncated file needs a new epoch header before the next record
+    s_epoch_active = false;
+#endif
+#if LOG_IV_MODE && !LOG_BATCH_MODE
+    // New file, new IV nonce
+    s_iv_nonce_valid = false;
+#endif
+    file_lock();
+#if LOG_FORMAT_HEADER
+    s_format_due = true;
+    s_format_offset = INDEX_NO_EPOCH;
+#endif
+    bool ok = log_store_clear();
+#if LOG_CHANNELS > 1
+    ok = log_channel_clear() && ok;
+#endif
+    file_unlock();
+#if LOG_READ_CACHE
+    // No plaintext of the dropped records stays behind
+    log_cache_wipe();
+#endif
+    if (!ok) {
+        ESP_LOGE(TAG, "failed to clear log file.");
+        return;
+    }
+    ESP_LOGI(TAG, "log cleared.");
+}
+
+// --------------------
+// Group Commit
+// --------------------
+static bool ticket_committed(uint32_t ticket)
+{
+    return (int32_t)(s_committed - ticket) >= 0;
+}
+
+// Writer: the records before ring position `through` are in the synced store (or
+// counted as write errors); wake the tasks waiting for them. True if some task still
+// waits for a later record
+static bool commit_advance(uint32_t through)
+{
+    bool woke = false;
+    bool waiting = false;
+
+    xSemaphoreTake(s_commit_lock, portMAX_DELAY);
+    s_committed = through;
+    for (size_t i = 0; i < LOG_COMMIT_WAITERS; i++) {
+        commit_waiter_t *w = &s_commit_waiters[i];
+        if (w->used && ticket_committed(w->ticket)) {
+            w->used = false;
+            xSemaphoreGive(w->done);
+            woke = true;
+        } else if (w->used) {
+            waiting = true;
+        }
+    }
+    if (woke) {
+        s_commit_groups++;
+    }
+    xSemaphoreGive(s_commit_lock);
+    return waiting;
+}
+
+// Records popped but still queued in a block group are not durable yet
+static uint32_t commit_position(void)
+{
+#if LOG_BATCH_MODE
+    uint32_t pos = s_ring.tail;
+    for (size_t c = 0; c < LOG_CHANNELS; c++) {
+        if (s_batches[c].count > 0 && (int32_t)(s_batches[c].ring_pos - pos) < 0) {
+            pos = s_batches[c].ring_pos;
+        }
+    }
+    return pos;
+#else
+    return s_ring.tail;
+#endif
+}
+
+// --------------------
+// OPTIGA Bring-up
+// --------------------
+// Everything that talks to OPTIGA before the first record: the application's own
+// bring-up (optiga_trust_init and what depends on it), instances, key and secret checks
+static bool optiga_bringup_steps(void)
+{
+    if (s_optiga_init != NULL && !s_optiga_init()) {
+        return false;
+    }
+    if (!optiga_crypto_init()) {
+        return false;
+    }
+#if LOG_PERSONA_CACHE
+    persona_begin();
+#endif
+    if (!optiga_generate_key_if_enabled()) {
+        ESP_LOGE(TAG, "optiga key init failed");
+        return false;
+    }
+#if LOG_HYBRID_MODE
+    if (!persona_has(LOG_PERSONA_HYBRID_SECRET)) {
+        const int ready = optiga_secret_ready(LOG_HYBRID_SECRET_OID);
+        if (ready < 0 || (ready == 0 && !optiga_provision_secret(LOG_HYBRID_SECRET_OID, LOG_HYBRID_SECRET_BYTES))) {
+            ESP_LOGE(TAG, "optiga secret init failed");
+            return false;
+        }
+        persona_found(LOG_PERSONA_HYBRID_SECRET);
+    }
+#if LOG_RECORD_GCM
+    mbedtls_gcm_init(&s_epoch_aes[0]);
+    mbedtls_gcm_init(&s_epoch_aes[1]);
+#else
+    mbedtls_aes_init(&s_epoch_aes[0]);
+    mbedtls_aes_init(&s_epoch_aes[1]);
+#endif
+#endif
+#if LOG_INTEGRITY_MODE == 1
+    if (!persona_has(LOG_PERSONA_MAC_SECRET)) {
+        const int ready = optiga_secret_ready(LOG_MAC_SECRET_OID);
+        if (ready < 0 || (ready == 0 && !optiga_provision_secret(LOG_MAC_SECRET_OID, LOG_MAC_SECRET_BYTES))) {
+            ESP_LOGE(TAG, "optiga MAC secret init failed");
+            return false;
+        }
+        persona_found(LOG_PERSONA_MAC_SECRET);
+    }
+#endif
+#if LOG_PERSONA_CACHE
+    persona_store();
+#endif
+
+#if LOG_CURRENT_POLICY
+    // Start low; the writer raises the limit when work arrives
+    if (optiga_trust_set_current_limit(LOG_CURRENT_IDLE_MA) != OPTIGA_LIB_SUCCESS) {
+        ESP_LOGW(TAG, "OPTIGA current limit not set, policy continues from the stored value");
+    }
+#endif
+#ifdef OPTIGA_CMD_GOVERNOR
+    // The read sets the governor's estimate to the security event counter OPTIGA holds
+    uint8_t sec = 0;
+    uint16_t sec_len = sizeof(sec);
+    optiga_sync_begin(&s_optiga_sync);
+    if (optiga_util_read_data(s_util, 0xE0C5, 0, &sec, &sec_len) != OPTIGA_LIB_SUCCESS ||
+        !optiga_wait()) {
+        ESP_LOGW(TAG, "OPTIGA security event counter not read, governor starts from 0");
+    } else if (sec > 0) {
+        ESP_LOGI(TAG, "OPTIGA security event counter %u", (unsigned)sec);
+    }
+#endif
+    return true;
+}
+
+static bool optiga_bringup(void)
+{
+    const int64_t start = esp_timer_get_time();
+    const bool ok = optiga_bringup_steps();
+    s_boot_optiga_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+    return ok;
+}
+
+// Both boot phases are over: report their times, and with LOG_LAZY_OPTIGA what running
+// them side by side saved against one after the other
+static bool bringup_finish(bool ok)
+{
+    xEventGroupSetBits(s_ready_events, READY_EVENT_DONE | (ok ? READY_EVENT_OK : 0));
+    if (ok) {
+        const int64_t now = esp_timer_get_time();
+        const uint32_t took_ms = (uint32_t)((now - s_boot_start_us) / 1000);
+        const uint32_t serial_ms = s_boot_storage_ms + s_boot_optiga_ms;
+        ESP_LOGI(TAG, "OPTIGA ready after %lld ms, %lu records waiting",
+                 (long long)(now / 1000), (unsigned long)log_ring_count(&s_ring));
+        ESP_LOGI(TAG, "boot: storage %lu ms, OPTIGA %lu ms, both done in %lu ms (%lu ms saved)",
+                 (unsigned long)s_boot_storage_ms, (unsigned long)s_boot_optiga_ms,
+                 (unsigned long)took_ms,
+                 (unsigned long)((serial_ms > took_ms) ? serial_ms - took_ms : 0));
+    } else {
+        ESP_LOGE(TAG, "OPTIGA or storage bring-up failed, records are not written");
+    }
+    return ok;
+}
+
+#if LOG_DIAG_SUMMARY_MS > 0
+// --------------------
+// Diagnostics summary
+// --------------------
+// Counters at the start of the summary window (LOG_DIAG_SUMMARY_MS)
+typedef struct {
+    uint32_t records;
+    uint32_t bytes;
+    uint32_t dropped;
+    uint32_t errors;
+} diag_counts_t;
+
+static diag_counts_t s_diag_base;
+static uint32_t s_diag_start_ms = 0;
+
+static void diag_counts(diag_counts_t *c)
+{
+    c->records = s_records_written;
+    c->bytes = s_bytes_written;
+    c->dropped = s_ring.dropped + __atomic_load_n(&s_submit_timeouts, __ATOMIC_RELAXED);
+    c->errors = s_write_errors;
+#if LOG_BATCH_PIPELINE
+    c->errors += s_store_errors;
+#endif
+}
+
+// Milliseconds until the summary is due, UINT32_MAX while nothing happened in the window
+static uint32_t diag_summary_delay_ms(void)
+{
+    diag_counts_t now;
+    diag_counts(&now);
+    if (memcmp(&now, &s_diag_base, sizeof(now)) == 0) {
+        return UINT32_MAX;
+    }
+    const uint32_t elapsed = (uint32_t)(esp_timer_get_time() / 1000) - s_diag_start_ms;
+    return (elapsed >= LOG_DIAG_SUMMARY_MS) ? 0 : LOG_DIAG_SUMMARY_MS - elapsed;
+}
+
+// One line for the window in place of a line per record or group. A window with
+// nothing written restarts, so the count covers the time records were arriving.
+static void diag_summary(void)
+{
+    const uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    diag_counts_t now;
+    diag_counts(&now);
+    if (memcmp(&now, &s_diag_base, sizeof(now)) == 0) {
+        s_diag_start_ms = now_ms;
+        return;
+    }
+    const uint32_t elapsed = now_ms - s_diag_start_ms;
+    if (elapsed < LOG_DIAG_SUMMARY_MS) {
+        return;
+    }
+    ESP_LOGI(TAG, "%lu records, %lu bytes in the last %lu.%lu s (dropped %lu, errors %lu)",
+             (unsigned long)(now.records - s_diag_base.records),
+             (unsigned long)(now.bytes - s_diag_base.bytes), (unsigned long)(elapsed / 1000),
+             (unsigned long)(elapsed % 1000 / 100), (unsigned long)(now.dropped - s_diag_base.dropped),
+             (unsigned long)(now.errors - s_diag_base.errors));
+    s_diag_base = now;
+    s_diag_start_ms = now_ms;
+}
+#endif
+
+// --------------------
+// Writer Task
+// --------------------
+static void write_one_record(const log_ring_slot_t *slot)
+{
+#if LOG_BATCH_MODE
+    if (!queue_batch_record(slot)) {
+        LOG_DIAG(ESP_LOG_ERROR, TAG, "batch flush failed");
+        s_write_errors += (uint32_t)s_batch->count;
+        s_batch->count = 0;
+        s_batch->used = 0;
+    }
+#else
+    // Record format: IV (16B) + Ciphertext (64B) = 80B, or header + padded ciphertext
+    uint8_t record[RECORD_MAX_BYTES];
+    size_t record_len = 0;
+#if LOG_ZONE_MAP
+    // From the plaintext, before it is encrypted in place
+    log_zone_t zone;
+    log_zone_reset(&zone);
+    log_zone_add(&zone, slot->data, slot->len, slot->seq, slot->uptime_ms, log_time_base_ms(),
+                 slot->flags & LOG_RING_FLAG_PRIORITY);
+#endif
+#if LOG_HYBRID_MODE
+    // Every segment opens with its own epoch header, so dropping the oldest
+    // segment never strands the records of the next one
+    const size_t next_len = RECORD_HDR_BYTES + RECORD_IV_BYTES + RECORD_PT_BYTES(slot->len);
+    file_lock();
+    if (log_store_rotate_due(EPOCH_HDR_BYTES + next_len) && log_store_rotate()) {
+        s_epoch_active = false;
+#if LOG_FORMAT_HEADER
+        s_format_due = true;
+#endif
+    }
+    file_unlock();
+    PAL_SYSVIEW_START(PAL_SYSVIEW_MARK_LOG_ENCRYPT);
+    const bool encrypted = encrypt_record_host(slot->data, slot->len, record, sizeof(record), &record_len);
+#elif LOG_CTR_MODE
+    PAL_SYSVIEW_START(PAL_SYSVIEW_MARK_LOG_ENCRYPT);
+    const bool encrypted = encrypt_record_ctr(slot->data, slot->len, record, sizeof(record),
+                                              &record_len);
+#else
+    PAL_SYSVIEW_START(PAL_SYSVIEW_MARK_LOG_ENCRYPT);
+    const bool encrypted = encrypt_record(slot->data, slot->len, record, sizeof(record), &record_len);
+#endif
+    PAL_SYSVIEW_STOP(PAL_SYSVIEW_MARK_LOG_ENCRYPT);
+    if (!encrypted) {
+        LOG_DIAG(ESP_LOG_ERROR, TAG, "encrypt_record failed");
+        s_write_errors++;
+        return;
+    }
+    const uint8_t channel = LOG_RING_CHANNEL(slot->flags) % LOG_CHANNELS;
+    if (!write_log_bytes(channel, record, record_len)) {
+        s_write_errors++;
+        return;
+    }
+    index_last_append(channel, slot->seq, slot->uptime_ms, 1);
+#if LOG_ZONE_MAP
+    if (channel == 0) {
+        zone_last_append(&zone);
+    }
+#endif
+    append_latency_add(slot->uptime_ms);
+#if LOG_MERKLE_MODE
+    merkle_add_leaf(record, record_len, slot->seq, 1);
+#endif
+    s_records_written++;
+    if (s_append_cb) {
+        s_append_cb(slot->seq, 1, s_append_ctx);
+    }
+#endif
+}
+
+#if LOG_CURRENT_POLICY
+// Raises the limit at once when work backs up, lowers it only after a quiet hold
+static void current_policy_update(void)
+{
+    const uint32_t depth = log_ring_count(&s_ring);
+    const int64_t now_ms = esp_timer_get_time() / 1000;
+    const bool busy = s_current_boost || depth >= LOG_CURRENT_BUSY_DEPTH;
+
+    if (busy) {
+        s_current_busy_ms = now_ms;
+    }
+    if (busy && !s_current_high) {
+        if (optiga_trust_set_current_limit(LOG_CURRENT_BUSY_MA) == OPTIGA_LIB_SUCCESS) {
+            s_current_high = true;
+            ESP_LOGI(TAG, "OPTIGA current limit %u mA (ring %lu%s)", (unsigned)LOG_CURRENT_BUSY_MA,
+                     (unsigned long)depth, s_current_boost ? ", boost" : "");
+        }
+    } else if (!busy && s_current_high && depth == 0 &&
+               now_ms - s_current_busy_ms >= LOG_CURRENT_HOLD_MS) {
+        if (optiga_trust_set_current_limit(LOG_CURRENT_IDLE_MA) == OPTIGA_LIB_SUCCESS) {
+            s_current_high = false;
+            ESP_LOGI(TAG, "OPTIGA current limit %u mA (idle)", (unsigned)LOG_CURRENT_IDLE_MA);
+        }
+    }
+}
+
+// Time until the limit may drop, UINT32_MAX if it is already low
+static uint32_t current_policy_delay_ms(void)
+{
+    if (!s_current_high) {
+        return UINT32_MAX;
+    }
+    const int64_t quiet_ms = esp_timer_get_time() / 1000 - s_current_busy_ms;
+    return (quiet_ms >= LOG_CURRENT_HOLD_MS) ? 0 : (uint32_t)(LOG_CURRENT_HOLD_MS - quiet_ms);
+}
+#endif
+
+#if LOG_WARM_POLICY
+// Time since the writer's instance last started a request
+static uint32_t warm_quiet_ms(uint32_t now_ms)
+{
+    return now_ms - (uint32_t)(s_optiga_sync.start_us / 1000);
+}
+
+// Time until an announced record's warm-up, negative once it is due
+static int32_t warm_expect_lead_ms(uint32_t now_ms)
+{
+    return (int32_t)(s_warm_expect_ms - LOG_WARM_LEAD_MS - now_ms);
+}
+
+// Time until the next warm-up, UINT32_MAX if none is planned
+static uint32_t warm_delay_ms(void)
+{
+    const uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    uint32_t delay = UINT32_MAX;
+#if LOG_WARM_POLICY == LOG_WARM_KEEPALIVE
+    if (now_ms - s_warm_records_ms < LOG_WARM_HOLD_MS) {
+        const uint32_t quiet = warm_quiet_ms(now_ms);
+        delay = (quiet >= LOG_WARM_PERIOD_MS) ? 0 : LOG_WARM_PERIOD_MS - quiet;
+    }
+#endif
+    if (__atomic_load_n(&s_warm_expected, __ATOMIC_ACQUIRE)) {
+        const int32_t lead = warm_expect_lead_ms(now_ms);
+        if (lead <= 0) {
+            delay = 0;
+        } else if ((uint32_t)lead < delay) {
+            delay = (uint32_t)lead;
+        }
+    }
+    return delay;
+}
+
+// One throwaway TRNG request when OPTIGA has gone quiet within the hold after the last
+// records, or is about to be needed by an announced one
+static void warm_update(bool took_records)
+{
+    const uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    bool due = false;
+
+    if (took_records) {
+        s_warm_records_ms = now_ms;
+    }
+#if LOG_WARM_POLICY == LOG_WARM_KEEPALIVE
+    due = now_ms - s_warm_records_ms < LOG_WARM_HOLD_MS &&
+          warm_quiet_ms(now_ms) >= LOG_WARM_PERIOD_MS;
+#endif
+    if (__atomic_load_n(&s_warm_expected, __ATOMIC_ACQUIRE) && warm_expect_lead_ms(now_ms) <= 0) {
+        __atomic_store_n(&s_warm_expected, false, __ATOMIC_RELAXED);
+        if (warm_quiet_ms(now_ms) >= LOG_WARM_PERIOD_MS) {
+            due = true;
+        } else {
+            s_warm_skipped++;
+        }
+    }
+    if (!due) {
+        return;
+    }
+
+    uint8_t scratch[LOG_WARM_RANDOM_BYTES];
+    optiga_sync_begin(&s_optiga_sync);
+    if (optiga_crypt_random(s_crypt, OPTIGA_RNG_TYPE_TRNG, scratch, sizeof(scratch)) ==
+            OPTIGA_LIB_SUCCESS &&
+        optiga_wait()) {
+        s_warmups++;
+    }
+}
+#endif
+
+#if LOG_ISR_SUBMIT
+// Records of interrupt handlers join the ring when the writer gets to them
+static void isr_drain(void)
+{
+    const uint32_t moved = log_isr_drain(&s_ring);
+    __atomic_fetch_add(&s_submitted, moved, __ATOMIC_RELAXED);
+}
+#endif
+
+static void writer_task(void *arg)
+{
+    (void)arg;
+    uint32_t bits = 0;
+    // A waiter's record was claimed by its producer but not yet in the ring at the last
+    // commit: commit again when it arrives
+    bool commit_pending = false;
+
+#if LOG_LAZY_OPTIGA
+    // Records submitted in the meantime wait in the ring. Storage comes up on the task
+    // that called enc_log_init(), at the same time: join it before the first write.
+    // Without either nothing can be written: the task stays suspended, notifications to
+    // it are kept but never served.
+    const bool optiga_up = optiga_bringup();
+    const EventBits_t store = xEventGroupWaitBits(s_ready_events, READY_EVENT_STORE, pdFALSE,
+                                                  pdTRUE, portMAX_DELAY);
+    if (!bringup_finish(optiga_up && (store & READY_EVENT_STORE_OK) != 0)) {
+        vTaskSuspend(NULL);
+    }
+#endif
+
+    while (true) {
+        // Sleep until new work, or until the time-based sync policy is due
+        file_lock();
+        uint32_t delay_ms = log_store_poll_delay_ms();
+#if LOG_CHANNELS > 1
+        const uint32_t channel_ms = log_channel_poll_delay_ms();
+        if (channel_ms < delay_ms) {
+            delay_ms = channel_ms;
+        }
+#endif
+        file_unlock();
+#if LOG_BATCH_MAX_LATENCY_MS > 0
+        const uint32_t batch_ms = batch_delay_ms();
+        if (batch_ms < delay_ms) {
+            delay_ms = batch_ms;
+        }
+#endif
+#if LOG_CURRENT_POLICY
+        const uint32_t current_ms = current_policy_delay_ms();
+        if (current_ms < delay_ms) {
+            delay_ms = current_ms;
+        }
+#endif
+#if LOG_WARM_POLICY
+        const uint32_t warm_ms = warm_delay_ms();
+        if (warm_ms < delay_ms) {
+            delay_ms = warm_ms;
+        }
+#endif
+        if (s_maint_due && delay_ms > LOG_MAINT_STEP_MS) {
+            delay_ms = LOG_MAINT_STEP_MS;
+        }
+#if LOG_DIAG_SUMMARY_MS > 0
+        const uint32_t diag_ms = diag_summary_delay_ms();
+        if (diag_ms < delay_ms) {
+            delay_ms = diag_ms;
+        }
+#endif
+#if LOG_CTR_MODE
+        // Back for the next refill step after a tick
+        if (s_ks_count < LOG_CTR_CACHE_BLOCKS && !s_ks_stalled) {
+            delay_ms = 0;
+        }
+#endif
+        const TickType_t wait = (delay_ms == UINT32_MAX) ? portMAX_DELAY
+                                                         : pdMS_TO_TICKS(delay_ms) + 1;
+        bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, wait);
+#if LOG_DIAG_SUMMARY_MS > 0
+        // Before this pass's records: an idle wait restarts the window at the wake-up
+        diag_summary();
+#endif
+#if LOG_BATCH_AUTOTUNE
+        log_tune_arrivals(__atomic_load_n(&s_submitted, __ATOMIC_RELAXED), esp_timer_get_time());
+#endif
+
+        if (bits & WRITER_NOTIFY_CLEAR) {
+            clear_log_file();
+            s_maint_due = true;
+            // Waiters for dropped records are released, not left to time out
+            commit_pending = commit_advance(s_ring.tail);
+        }
+#if LOG_CURRENT_POLICY
+        // Before the ring is drained, so a backlog is encrypted at the higher limit
+        current_policy_update();
+#endif
+
+        // A priority record makes everything written before it durable too
+        bool urgent = false;
+        // Encrypted straight from the ring slot; it goes back to producers once written
+        // or queued in the block group
+        const log_ring_slot_t *rec;
+#if LOG_ISR_SUBMIT
+        isr_drain();
+#endif
+#if LOG_WARM_POLICY
+        bool took_records = false;
+#endif
+        while ((rec = log_ring_peek(&s_ring)) != NULL) {
+            if (!(rec->flags & LOG_RING_FLAG_CANCELLED)) {
+                if (rec->flags & LOG_RING_FLAG_PRIORITY) {
+                    urgent = true;
+                    s_priority_records++;
+                }
+                write_one_record(rec);
+#if LOG_WARM_POLICY
+                took_records = true;
+#endif
+            }
+            log_ring_release(&s_ring, rec);
+#if LOG_RING_POLICY == LOG_RING_BLOCK
+            if (__atomic_load_n(&s_room_waiters, __ATOMIC_RELAXED) > 0) {
+                xEventGroupSetBits(s_ring_events, RING_EVENT_ROOM);
+            }
+#endif
+#if LOG_ISR_SUBMIT
+            // Handler records left over when the ring filled up come next
+            if (log_ring_count(&s_ring) == 0) {
+                isr_drain();
+            }
+#endif
+        }
+#if LOG_WARM_POLICY
+        // Records just taken used OPTIGA: a warm-up is only sent into a quiet spell
+        warm_update(took_records);
+#endif
+
+#if LOG_BATCH_MODE
+        bool flush = commit_pending ||
+                     (bits & (WRITER_NOTIFY_FLUSH | WRITER_NOTIFY_SYNC | WRITER_NOTIFY_COMMIT)) != 0;
+        bool due = false;
+#if LOG_BATCH_MAX_LATENCY_MS > 0
+        if (!flush && batch_delay_ms() == 0) {
+            due = true;
+            s_deadline_flushes++;
+        }
+#endif
+        if (flush || due) {
+            flush_batches(!flush);
+        }
+#endif
+#if LOG_MERKLE_MODE
+        // A sync (e.g. before deep sleep) leaves no append without a signed root
+        if (bits & WRITER_NOTIFY_SYNC) {
+            write_merkle_root();
+        }
+#endif
+
+        // One sync commits the records of every producer taken so far
+        bool commit = (bits & (WRITER_NOTIFY_SYNC | WRITER_NOTIFY_COMMIT)) || urgent ||
+                      commit_pending;
+#if LOG_BATCH_AUTOTUNE
+        // The durability bound the tuner holds to ends at the sync of each group
+        commit = commit || s_tune_sync;
+        const int64_t sync_start_us = esp_timer_get_time();
+#endif
+#if LOG_BATCH_PIPELINE
+        // The store sync covers only the groups the storage task has appended
+        if (commit) {
+            pipeline_drain();
+        }
+#endif
+        file_lock();
+        if (commit) {
+            log_store_sync();
+#if LOG_CHANNELS > 1
+            log_channel_sync();
+#endif
+        } else {
+            log_store_poll();
+#if LOG_CHANNELS > 1
+            log_channel_poll();
+#endif
+        }
+        file_unlock();
+#if LOG_BATCH_AUTOTUNE
+        if (s_tune_sync) {
+            log_tune_sync((uint32_t)(esp_timer_get_time() - sync_start_us));
+            s_tune_sync = false;
+        }
+#endif
+        if (commit) {
+            commit_pending = commit_advance(commit_position());
+        }
+
+        if (bits & WRITER_NOTIFY_SYNC) {
+            xSemaphoreGive(s_sync_done);
+        }
+
+#if LOG_TIER_SD || (LOG_STORAGE_RAW && LOG_RAW_PREERASE_SECTORS > 0)
+        // A rotation leaves the closed segment to move to the card; the raw head moving
+        // into a new sector takes one from the pre-erase pool
+        if (!s_maint_due) {
+            file_lock();
+            s_maint_due = log_store_maint_pending() > 0;
+            file_unlock();
+        }
+#endif
+        // Store upkeep (files of a clear, retention over the cap, SD tier moves, raw pre-erase):
+        // one bounded step per pass, after the records, with a wait in between so ingest and
+        // other tasks run
+#if LOG_HYBRID_MODE
+        // Next epoch's key while the current one serves appends; producers keep filling
+        // the ring meanwhile, the next pass drains it
+        if (s_epoch_active && !s_next_ready && !s_next_failed) {
+            s_next_failed = !prepare_next_epoch();
+        }
+#endif
+#if LOG_CTR_MODE
+        // Keystream for the next burst, one ECB command per pass while no record waits
+        if (s_ks_count < LOG_CTR_CACHE_BLOCKS && !s_ks_stalled && log_ring_count(&s_ring) == 0) {
+            s_ks_stalled = !ks_refill();
+        }
+#endif
+        if (s_maint_due) {
+            file_lock();
+            if (log_store_maint_pending() > 0) {
+                s_maint_steps++;
+            }
+            s_maint_due = log_store_maintain();
+            file_unlock();
+        }
+    }
+}
+
+// Mount and open the store (the raw store scans its sectors here), pick up the MAC chain
+// and start the storage task: independent of OPTIGA, see LOG_LAZY_OPTIGA
+#if LOG_COMPACT
+// --------------------
+// Compaction
+// --------------------
+// Room for a run of groups as they are stored (IV || ciphertext each): their records fit
+// one full group, plus an IV, at most one block of padding and a checksum per group
+#define COMPACT_RUN_BYTES \
+    (BATCH_PT_MAX_BYTES + LOG_BATCH_RECORDS * (AES_IV_BYTES + AES_BLOCK_BYTES + RECORD_CRC_BYTES))
+#define COMPACT_PEEK_BYTES  FORMAT_HDR_MAGIC_BYTES      // tells every unit kind apart
+#define GROUP_PREFIX_BYTES  (BLOCK_GROUP_HDR_BYTES - AES_IV_BYTES)
+
+#if LOG_RECORD_VARLEN
+#define COMPACT_PLAIN_MAGIC1 BLOCK_GROUP_MAGIC1_VAR
+#else
+#define COMPACT_PLAIN_MAGIC1 BLOCK_GROUP_MAGIC1
+#endif
+
+typedef enum {
+    COMPACT_UNIT_NONE,          // not a unit of this build's layout
+    COMPACT_UNIT_HEADER,        // format header
+    COMPACT_UNIT_PLAIN,         // plain block group: merged
+    COMPACT_UNIT_OTHER,         // compressed or delta group: copied as it is
+} compact_unit_t;
+
+typedef struct {
+    uint32_t offset;            // segment offset of the first group
+    uint32_t used;              // bytes in s_compact_run
+    uint32_t records;
+    uint32_t groups;
+    uint8_t prefix[LOG_BATCH_RECORDS][GROUP_PREFIX_BYTES];  // magic, count, blocks of each
+} compact_run_t;
+
+static TaskHandle_t s_compact_task = NULL;
+static optiga_crypt_t *s_compact_crypt = NULL;
+static optiga_sync_t s_compact_sync;
+BULK_ATTR static uint8_t s_compact_run[COMPACT_RUN_BYTES];   // the groups of a run, prefixes cut off
+BULK_ATTR static uint8_t s_compact_pt[COMPACT_RUN_BYTES];    // the run decrypted
+BULK_ATTR static uint8_t s_compact_group[BLOCK_GROUP_MAX_HDR_BYTES + BATCH_PT_MAX_BYTES];
+static const uint8_t s_compact_iv[AES_IV_BYTES] = {0};
+static compact_run_t s_compact;
+static uint32_t s_compact_next_id = 0;  // closed segments below it were looked at
+static uint32_t s_compact_segments = 0; // segments swapped
+static uint32_t s_compact_groups_in = 0;    // plain groups merged ...
+static uint32_t s_compact_groups_out = 0;   // ... into these
+static uint32_t s_compact_saved = 0;    // log bytes saved
+static uint32_t s_compact_deferred = 0; // swaps dropped (snapshot open, segment gone, I/O)
+
+static bool compact_read(uint32_t id, uint32_t offset, void *buf, size_t len)
+{
+    file_lock();
+    const size_t got = log_store_segment_read(id, offset, buf, len);
+    file_unlock();
+    return got == len;
+}
+
+static bool compact_append(const uint8_t *unit, size_t len, uint32_t old_offset, bool header)
+{
+    file_lock();
+    const bool ok = log_store_rewrite_append(unit, len, old_offset, header);
+    file_unlock();
+    return ok;
+}
+
+// Kind and stored length of the unit starting at p (COMPACT_PEEK_BYTES of it)
+static compact_unit_t compact_kind(const uint8_t *p, uint32_t *len)
+{
+    if (memcmp(p, FORMAT_HDR_MAGIC, FORMAT_HDR_MAGIC_BYTES) == 0) {
+        *len = FORMAT_HDR_BYTES;
+        return COMPACT_UNIT_HEADER;
+    }
+    if (p[0] != BLOCK_GROUP_MAGIC0 || p[2] == 0) {
+        return COMPACT_UNIT_NONE;
+    }
+    switch (p[1]) {
+    case COMPACT_PLAIN_MAGIC1:
+        if (p[2] > LOG_BATCH_RECORDS) {
+            return COMPACT_UNIT_NONE;
+        }
+#if LOG_RECORD_VARLEN
+        *len = BLOCK_GROUP_HDR_BYTES + (uint32_t)p[3] * AES_BLOCK_BYTES;
+#else
+        *len = BLOCK_GROUP_HDR_BYTES + (uint32_t)p[2] * PLAINTEXT_MAX;
+#endif
+        return COMPACT_UNIT_PLAIN;
+#if LOG_BATCH_COMPRESS
+    case BLOCK_GROUP_MAGIC1_LZ:
+        *len = BLOCK_GROUP_LZ_HDR_BYTES + (uint32_t)p[3] * AES_BLOCK_BYTES;
+        return COMPACT_UNIT_OTHER;
+#endif
+#if LOG_BATCH_DELTA
+    case BLOCK_GROUP_MAGIC1_DELTA:
+        *len = BLOCK_GROUP_HDR_BYTES + (uint32_t)p[3] * AES_BLOCK_BYTES;
+        return COMPACT_UNIT_OTHER;
+#endif
+    default:
+        return COMPACT_UNIT_NONE;
+    }
+}
+
+// As compact_kind(), NONE for a group no writer of this build makes
+static compact_unit_t compact_unit(const uint8_t *p, uint32_t *len)
+{
+    const compact_unit_t kind = compact_kind(p, len);
+    return (*len > sizeof(s_compact_group)) ? COMPACT_UNIT_NONE : kind;
+}
+
+// The header names this build's layout; data ahead of any header is in the legacy one
+static bool compact_header_ok(const uint8_t *header)
+{
+#if LOG_FORMAT_HEADER
+    uint8_t own[FORMAT_HDR_BYTES];
+    enc_log_format_header(own);
+    return memcmp(header, own, FORMAT_HDR_BYTES) == 0;
+#else
+    (void)header;
+    return false;
+#endif
+}
+
+// Worth a rewrite: enough plain groups, mostly small, and every unit in this build's
+// layout. Reads the segment a window at a time and looks at the unit heads only.
+static bool compact_survey(const log_store_segment_t *seg)
+{
+    bool layout_ok = (LOG_FORMAT_LEGACY_FLAGS == LOG_FORMAT_FLAGS);
+    uint32_t groups = 0;
+    uint32_t records = 0;
+    uint32_t off = 0;
+    while (off < seg->bytes) {
+        const size_t got = (seg->bytes - off < sizeof(s_compact_run)) ? seg->bytes - off
+                                                                      : sizeof(s_compact_run);
+        if (!compact_read(seg->id, off, s_compact_run, got)) {
+            return false;
+        }
+        const bool tail = (off + got == seg->bytes);
+        uint32_t pos = 0;
+        while (pos < got) {
+            // A head the window cuts goes to the next window
+            if (got - pos < COMPACT_PEEK_BYTES && !tail) {
+                break;
+            }
+            uint32_t len = 0;
+            const uint8_t *p = s_compact_run + pos;
+            const compact_unit_t kind =
+                (got - pos < COMPACT_PEEK_BYTES) ? COMPACT_UNIT_NONE : compact_unit(p, &len);
+            if (kind == COMPACT_UNIT_NONE) {
+                return false;
+            }
+            if (kind == COMPACT_UNIT_HEADER) {
+                if (got - pos < FORMAT_HDR_BYTES && !tail) {
+                    break;
+                }
+                layout_ok = (got - pos >= FORMAT_HDR_BYTES) && compact_header_ok(p);
+            } else if (!layout_ok) {
+                return false;
+            } else if (kind == COMPACT_UNIT_PLAIN) {
+                groups++;
+                records += p[2];
+            }
+            pos += len;
+        }
+        if (pos == 0) {
+            return false;
+        }
+        off += pos;
+    }
+    return off == seg->bytes && groups >= LOG_COMPACT_MIN_GROUPS &&
+           (uint64_t)records * 100 <= (uint64_t)groups * LOG_BATCH_RECORDS * LOG_COMPACT_FILL_PCT;
+}
+
+static bool compact_wait(optiga_lib_status_t start)
+{
+    if (start != OPTIGA_LIB_SUCCESS) {
+        return false;
+    }
+    optiga_lib_status_t ret = optiga_sync_wait_timeout(&s_compact_sync, LOG_OPTIGA_TIMEOUT_MS);
+    if (ret == OPTIGA_LIB_BUSY) {
+        // Still writing into the buffers: wait it out
+        ret = optiga_sync_wait(&s_compact_sync);
+    }
+    return ret == OPTIGA_LIB_SUCCESS;
+}
+
+#if LOG_RECORD_CRC
+// The checksum at the end of a decrypted group of len bytes matches its plaintext
+static bool compact_crc_ok(const uint8_t *pt, uint32_t len)
+{
+    const uint32_t body = len - RECORD_CRC_BYTES;
+    const uint32_t crc = esp_rom_crc32_le(0, pt, body);
+    return pt[body] == (uint8_t)crc && pt[body + 1] == (uint8_t)(crc >> 8) &&
+           pt[body + 2] == (uint8_t)(crc >> 16) && pt[body + 3] == (uint8_t)(crc >> 24);
+}
+#endif
+
+// Decrypt the run with one request, repack its records into one group and encrypt that
+// with one more: the command layer sends each as back to back max-size APDUs
+static bool compact_merge(void)
+{
+    const compact_run_t *run = &s_compact;
+    // Zero IV with each group's IV in front of its ciphertext, as the streaming reader
+    // does: the block decrypted from an IV is dropped
+    uint32_t out_len = run->used;
+    optiga_sync_begin(&s_compact_sync);
+    if (!compact_wait(optiga_crypt_symmetric_decrypt(
+            s_compact_crypt, OPTIGA_SYMMETRIC_CBC, OPTIGA_KEY_ID_SECRET_BASED, s_compact_run,
+            run->used, s_compact_iv, AES_IV_BYTES, NULL, 0, s_compact_pt, &out_len)) ||
+        out_len != run->used) {
+        ESP_LOGE(TAG, "compaction decrypt failed");
+        return false;
+    }
+
+    uint8_t *pt = s_compact_group + BLOCK_GROUP_HDR_BYTES;
+    uint32_t used = 0;
+    uint32_t in = 0;
+    for (uint32_t g = 0; g < run->groups; g++) {
+        const uint8_t *prefix = run->prefix[g];
+        const uint8_t *src = s_compact_pt + in + AES_IV_BYTES;
+#if LOG_RECORD_VARLEN
+        const uint32_t ct_len = (uint32_t)prefix[3] * AES_BLOCK_BYTES;
+        // The group's entries without its padding and checksum
+#if LOG_RECORD_CRC
+        if (ct_len < AES_BLOCK_BYTES || !compact_crc_ok(src, ct_len)) {
+            ESP_LOGE(TAG, "compaction: checksum mismatch at +%lu", (unsigned long)in);
+            return false;
+        }
+#endif
+        const uint32_t body = ct_len - RECORD_CRC_BYTES;
+        uint32_t len = 0;
+        for (uint32_t r = 0; r < prefix[2]; r++) {
+            if (len >= body || src[len] > PLAINTEXT_MAX || len + 1 + src[len] > body) {
+                ESP_LOGE(TAG, "compaction: bad group at +%lu", (unsigned long)in);
+                return false;
+            }
+            len += 1 + src[len];
+        }
+#else
+        const uint32_t ct_len = (uint32_t)prefix[2] * PLAINTEXT_MAX;
+        const uint32_t len = ct_len;
+#endif
+        memcpy(pt + used, src, len);
+        used += len;
+        in += AES_IV_BYTES + ct_len;
+    }
+#if LOG_RECORD_VARLEN
+    const uint32_t total = GROUP_PT_BYTES(used);
+    memset(pt + used, 0, total - used);
+#if LOG_RECORD_CRC
+    crc_put(pt, total);
+#endif
+#else
+    const uint32_t total = used;
+#endif
+
+    uint8_t *iv = s_compact_group + GROUP_PREFIX_BYTES;
+    optiga_sync_begin(&s_compact_sync);
+    if (!compact_wait(optiga_crypt_random(s_compact_crypt, OPTIGA_RNG_TYPE_TRNG, iv, AES_IV_BYTES))) {
+        ESP_LOGE(TAG, "compaction IV generation failed");
+        return false;
+    }
+    out_len = total;
+    optiga_sync_begin(&s_compact_sync);
+    if (!compact_wait(optiga_crypt_symmetric_encrypt(
+            s_compact_crypt, OPTIGA_SYMMETRIC_CBC, OPTIGA_KEY_ID_SECRET_BASED, pt, total, iv,
+            AES_IV_BYTES, NULL, 0, pt, &out_len)) ||
+        out_len != total) {
+        ESP_LOGE(TAG, "compaction encrypt failed");
+        return false;
+    }
+    s_compact_group[0] = BLOCK_GROUP_MAGIC0;
+    s_compact_group[1] = COMPACT_PLAIN_MAGIC1;
+    s_compact_group[2] = (uint8_t)run->records;
+#if LOG_RECORD_VARLEN
+    s_compact_group[3] = (uint8_t)(total / AES_BLOCK_BYTES);
+#else
+    s_compact_group[3] = 0;
+#endif
+    return compact_append(s_compact_group, BLOCK_GROUP_HDR_BYTES + total, run->offset, false);
+}
+
+// Write the groups collected in s_compact: one as it is, more as one merged group
+static bool compact_flush(void)
+{
+    compact_run_t *run = &s_compact;
+    bool ok = true;
+    if (run->groups == 1) {
+        memcpy(s_compact_group, run->prefix[0], GROUP_PREFIX_BYTES);
+        memcpy(s_compact_group + GROUP_PREFIX_BYTES, s_compact_run, run->used);
+        ok = compact_append(s_compact_group, GROUP_PREFIX_BYTES + run->used, run->offset, false);
+    } else if (run->groups > 1) {
+        ok = compact_merge();
+        if (ok) {
+            s_compact_groups_in += run->groups;
+            s_compact_groups_out++;
+        }
+    }
+    run->groups = 0;
+    run->records = 0;
+    run->used = 0;
+    return ok;
+}
+
+// Copy closed segment seg unit by unit with its plain groups merged, then swap it in
+static bool compact_copy(const log_store_segment_t *seg)
+{
+    file_lock();
+    bool ok = log_store_rewrite_begin(seg->id);
+    uint32_t mark = ok ? log_store_rewrite_mark(0) : UINT32_MAX;
+    file_unlock();
+    if (!ok) {
+        return false;
+    }
+
+    compact_run_t *run = &s_compact;
+    run->groups = 0;
+    run->records = 0;
+    run->used = 0;
+    uint32_t off = 0;
+    while (ok && off < seg->bytes) {
+        uint8_t peek[COMPACT_PEEK_BYTES];
+        uint32_t len = 0;
+        compact_unit_t kind = COMPACT_UNIT_NONE;
+        if (compact_read(seg->id, off, peek, sizeof(peek))) {
+            kind = compact_unit(peek, &len);
+        }
+        if (kind == COMPACT_UNIT_NONE || len > seg->bytes - off) {
+            ok = false;
+            break;
+        }
+        // A run ends at an indexed group, so the entry keeps pointing at its first record
+        const bool indexed = (off >= mark);
+        if (indexed) {
+            file_lock();
+            mark = log_store_rewrite_mark(off + 1);
+            file_unlock();
+        }
+        if (kind != COMPACT_UNIT_PLAIN || indexed ||
+            run->records + peek[2] > LOG_BATCH_RECORDS ||
+            run->used + len - GROUP_PREFIX_BYTES > sizeof(s_compact_run)) {
+            ok = compact_flush();
+        }
+        if (!ok) {
+            break;
+        }
+        if (kind == COMPACT_UNIT_PLAIN) {
+            if (run->groups == 0) {
+                run->offset = off;
+            }
+            memcpy(run->prefix[run->groups], peek, GROUP_PREFIX_BYTES);
+            ok = compact_read(seg->id, off + GROUP_PREFIX_BYTES, s_compact_run + run->used,
+                              len - GROUP_PREFIX_BYTES);
+            run->used += len - GROUP_PREFIX_BYTES;
+            run->records += peek[2];
+            run->groups++;
+        } else {
+            ok = compact_read(seg->id, off, s_compact_group, len) &&
+                 compact_append(s_compact_group, len, off, kind == COMPACT_UNIT_HEADER);
+        }
+        off += len;
+    }
+    ok = ok && compact_flush();
+
+    file_lock();
+    if (ok) {
+        ok = log_store_rewrite_commit();
+    } else {
+        log_store_rewrite_abort();
+    }
+    log_store_segment_t now;
+    if (ok && log_store_segment_next(seg->id, &now) && now.id == seg->id && now.bytes < seg->bytes) {
+        s_compact_saved += seg->bytes - now.bytes;
+    }
+    file_unlock();
+    return ok;
+}
+
+// Low-priority task: looks at each closed segment once and rewrites the ones worth it
+static void compact_task(void *arg)
+{
+    (void)arg;
+    if (!enc_log_wait_ready(UINT32_MAX)) {
+        s_compact_task = NULL;
+        vTaskDelete(NULL);
+        return;
+    }
+    s_compact_crypt = optiga_crypt_create(0, optiga_sync_callback, &s_compact_sync);
+    if (s_compact_crypt == NULL) {
+        ESP_LOGE(TAG, "compaction: optiga_crypt_create failed");
+        s_compact_task = NULL;
+        vTaskDelete(NULL);
+        return;
+    }
+    // Behind the writer's requests and anything else queued for the chip
+    OPTIGA_CRYPT_SET_PRIORITY(s_compact_crypt, OPTIGA_CMD_PRIORITY_LOW);
+
+    while (true) {
+        log_store_segment_t seg;
+        file_lock();
+        const bool have = log_store_segment_next(s_compact_next_id, &seg);
+        file_unlock();
+        if (!have) {
+            vTaskDelay(pdMS_TO_TICKS(LOG_COMPACT_POLL_MS));
+            continue;
+        }
+        if (compact_survey(&seg)) {
+            if (compact_copy(&seg)) {
+                s_compact_segments++;
+            } else {
+                // Tried again after a poll period (a snapshot may have been open)
+                s_compact_deferred++;
+                vTaskDelay(pdMS_TO_TICKS(LOG_COMPACT_POLL_MS));
+                continue;
+            }
+        }
+        s_compact_next_id = seg.id + 1;
+    }
+}
+#endif // LOG_COMPACT
+
+static bool storage_start(void)
+{
+    const int64_t start = esp_timer_get_time();
+    if (log_mount_storage() != ESP_OK) {
+        ESP_LOGE(TAG, "mount failed. Check partition table.");
+        return false;
+    }
+    const int64_t mounted = esp_timer_get_time();
+    s_boot_mount_ms = (uint32_t)((mounted - start) / 1000);
+    if (!log_store_open()) {
+        return false;
+    }
+#if LOG_CHANNELS > 1
+    if (!log_channel_open()) {
+        return false;
+    }
+#endif
+    s_boot_open_ms = (uint32_t)((esp_timer_get_time() - mounted) / 1000);
+#if LOG_HYBRID_MODE
+    epoch_id_resume();
+#endif
+#if LOG_FORMAT_HEADER
+    format_resume();
+#endif
+#if LOG_INTEGRITY_MODE
+    // Continue the MAC chain from the tag at the end of the log
+    const uint32_t log_size = log_store_size();
+    if (log_size >= LOG_MAC_TAG_BYTES &&
+        log_store_read(log_size - LOG_MAC_TAG_BYTES, s_batch_frame, LOG_MAC_TAG_BYTES) != LOG_MAC_TAG_BYTES) {
+        memset(s_batch_frame, 0, LOG_MAC_TAG_BYTES);
+    }
+#endif
+#if LOG_BATCH_PIPELINE
+    s_group_free = xQueueCreate(2, sizeof(log_group_buf_t *));
+    s_group_full = xQueueCreate(2, sizeof(log_group_buf_t *));
+    if (s_group_free == NULL || s_group_full == NULL) {
+        ESP_LOGE(TAG, "pipeline queue create failed");
+        return false;
+    }
+    for (size_t i = 0; i < 2; i++) {
+        log_group_buf_t *buf = &s_group_bufs[i];
+        xQueueSend(s_group_free, &buf, 0);
+    }
+#if (LOG_STORE_CORE >= 0) && (LOG_STORE_CORE < portNUM_PROCESSORS)
+    const BaseType_t store_core = LOG_STORE_CORE;
+#else
+    const BaseType_t store_core = tskNO_AFFINITY;
+#endif
+    if (xTaskCreatePinnedToCore(store_task, "enc_log_st", LOG_STORE_STACK_BYTES, NULL,
+                                LOG_STORE_PRIORITY, &s_store_task, store_core) != pdPASS) {
+        ESP_LOGE(TAG, "storage task create failed");
+        return false;
+    }
+#endif
+#if LOG_COMPACT
+    // Waits for the OPTIGA bring-up itself
+    if (xTaskCreate(compact_task, "enc_log_cp", LOG_COMPACT_STACK_BYTES, NULL,
+                    LOG_COMPACT_PRIORITY, &s_compact_task) != pdPASS) {
+        ESP_LOGE(TAG, "compaction task create failed");
+        return false;
+    }
+#endif
+
+    s_boot_storage_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+    return true;
+}
+
+static bool writer_start(void)
+{
+#if (LOG_WRITER_CORE >= 0) && (LOG_WRITER_CORE < portNUM_PROCESSORS)
+    const BaseType_t core = LOG_WRITER_CORE;
+#else
+    const BaseType_t core = tskNO_AFFINITY;
+#endif
+    if (xTaskCreatePinnedToCore(writer_task, "enc_log_wr", LOG_WRITER_STACK_BYTES, NULL,
+                                LOG_WRITER_PRIORITY, &s_writer_task, core) != pdPASS) {
+        ESP_LOGE(TAG, "writer task create failed");
+        return false;
+    }
+    return true;
+}
+
+// --------------------
+// Public API
+// --------------------
+bool enc_log_init(enc_log_optiga_init_t optiga_init)
+{
+    s_boot_start_us = esp_timer_get_time();
+    s_optiga_init = optiga_init;
+    s_ready_events = xEventGroupCreate();
+    if (s_ready_events == NULL) {
+        ESP_LOGE(TAG, "ready event group create failed");
+        return false;
+    }
+    log_ring_init(&s_ring);
+#if LOG_BATCH_MODE
+    for (size_t c = 0; c < LOG_CHANNELS; c++) {
+#if LOG_CHANNELS > 1
+        s_batches[c].pt = s_channel_pt[c];
+#else
+        s_batches[c].pt = s_batch_pt;
+#endif
+    }
+#endif
+#if LOG_ISR_SUBMIT
+    log_isr_init();
+#endif
+#if LOG_BATCH_AUTOTUNE
+    log_tune_init();
+#endif
+    s_file_lock = xSemaphoreCreateMutex();
+    s_sync_done = xSemaphoreCreateBinary();
+    s_commit_lock = xSemaphoreCreateMutex();
+    if (s_file_lock == NULL || s_sync_done == NULL || s_commit_lock == NULL) {
+        ESP_LOGE(TAG, "file lock create failed");
+        return false;
+    }
+    for (size_t i = 0; i < LOG_COMMIT_WAITERS; i++) {
+        s_commit_waiters[i].done = xSemaphoreCreateBinaryStatic(&s_commit_waiters[i].done_buf);
+    }
+#if LOG_RING_POLICY == LOG_RING_BLOCK
+    s_ring_events = xEventGroupCreate();
+    if (s_ring_events == NULL) {
+        ESP_LOGE(TAG, "ring event group create failed");
+        return false;
+    }
+#endif
+#if LOG_LAZY_OPTIGA
+    // The writer first: OPTIGA comes up on it while this task mounts the storage
+    if (!writer_start()) {
+        return false;
+    }
+    const bool stored = storage_start();
+    xEventGroupSetBits(s_ready_events, READY_EVENT_STORE | (stored ? READY_EVENT_STORE_OK : 0));
+    return stored;
+#else
+    if (!storage_start() || !bringup_finish(optiga_bringup())) {
+        return false;
+    }
+    return writer_start();
+#endif
+}
+
+void enc_log_expect(uint32_t in_ms)
+{
+#if LOG_WARM_POLICY
+    s_warm_expect_ms = (uint32_t)(esp_timer_get_time() / 1000) + in_ms;
+    __atomic_store_n(&s_warm_expected, true, __ATOMIC_RELEASE);
+    if (s_writer_task != NULL) {
+        xTaskNotify(s_writer_task, WRITER_NOTIFY_POLICY, eSetBits);
+    }
+#else
+    (void)in_ms;
+#endif
+}
+
+void enc_log_set_current_boost(bool on)
+{
+#if LOG_CURRENT_POLICY
+    s_current_boost = on;
+    if (s_writer_task != NULL) {
+        xTaskNotify(s_writer_task, WRITER_NOTIFY_POLICY, eSetBits);
+    }
+#else
+    (void)on;
+#endif
+}
+
+#if LOG_RING_POLICY == LOG_RING_BLOCK
+// The ring is full: retry each time the writer takes a record, for up to LOG_RING_BLOCK_MS
+static uint8_t *reserve_wait_room(size_t len, uint32_t uptime_ms, uint8_t flags, uint32_t *pos)
+{
+    const TickType_t start = xTaskGetTickCount();
+    const TickType_t limit = pdMS_TO_TICKS(LOG_RING_BLOCK_MS);
+    uint8_t *buf = NULL;
+
+    __atomic_fetch_add(&s_submit_blocked, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&s_room_waiters, 1, __ATOMIC_RELAXED);
+    // The writer may have been asleep with records from before the ring filled up
+    xTaskNotify(s_writer_task, WRITER_NOTIFY_DATA, eSetBits);
+    while (true) {
+        // Cleared before the retry, so a slot freed after it still ends the wait below
+        xEventGroupClearBits(s_ring_events, RING_EVENT_ROOM);
+        buf = log_ring_reserve(&s_ring, len, uptime_ms, flags, pos);
+        if (buf != NULL) {
+            break;
+        }
+        const TickType_t waited = xTaskGetTickCount() - start;
+        if (waited >= limit) {
+            break;
+        }
+        xEventGroupWaitBits(s_ring_events, RING_EVENT_ROOM, pdFALSE, pdTRUE, limit - waited);
+    }
+    __atomic_fetch_sub(&s_room_waiters, 1, __ATOMIC_RELAXED);
+    if (buf == NULL) {
+        __atomic_fetch_add(&s_submit_timeouts, 1, __ATOMIC_RELAXED);
+    }
+    return buf;
+}
+#endif
+
+// Claim a ring slot for channel under LOG_RING_POLICY; NULL when the record is not taken
+static uint8_t *reserve_slot(size_t len, bool priority, uint8_t channel, uint32_t *pos)
+{
+    const uint32_t uptime_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    const uint8_t flags = (priority ? LOG_RING_FLAG_PRIORITY : 0) | LOG_RING_FLAG_CHANNEL(channel);
+    uint8_t *buf = log_ring_reserve(&s_ring, len, uptime_ms, flags, pos);
+#if LOG_RING_POLICY == LOG_RING_BLOCK
+    if (buf == NULL && len <= PLAINTEXT_MAX) {
+        buf = reserve_wait_room(len, uptime_ms, flags, pos);
+    }
+#endif
+    return buf;
+}
+
+bool enc_log_submit(const void *record, size_t len, uint32_t seq, bool priority)
+{
+    return enc_log_submit_ticket(record, len, seq, priority, NULL);
+}
+
+static bool submit_to(uint8_t channel, const void *record, size_t len, uint32_t seq,
+                      bool priority, uint32_t *ticket)
+{
+    uint32_t pos;
+    uint8_t *buf = reserve_slot(len, priority, channel, &pos);
+    if (buf == NULL) {
+        return false;
+    }
+    memcpy(buf, record, len);
+    enc_log_commit(pos + 1, len, seq);
+    if (ticket != NULL) {
+        *ticket = pos + 1;
+    }
+    return true;
+}
+
+bool enc_log_submit_ticket(const void *record, size_t len, uint32_t seq, bool priority,
+                           uint32_t *ticket)
+{
+    return submit_to(0, record, len, seq, priority, ticket);
+}
+
+#if LOG_CHANNELS > 1
+bool enc_log_submit_channel(uint8_t channel, const void *record, size_t len, uint32_t seq,
+                            bool priority, uint32_t *ticket)
+{
+    if (channel >= LOG_CHANNELS) {
+        return false;
+    }
+    return submit_to(channel, record, len, seq, priority, ticket);
+}
+#endif
+
+void *enc_log_reserve(size_t len, bool priority, uint32_t *handle)
+{
+    uint32_t pos;
+    uint8_t *buf = reserve_slot(len, priority, 0, &pos);
+    if (buf != NULL) {
+        *handle = pos + 1;
+    }
+    return buf;
+}
+
+void enc_log_commit(uint32_t handle, size_t len, uint32_t seq)
+{
+    log_ring_commit(&s_ring, handle - 1, len, seq);
+    __atomic_fetch_add(&s_submitted, 1, __ATOMIC_RELAXED);
+    xTaskNotify(s_writer_task, WRITER_NOTIFY_DATA, eSetBits);
+}
+
+#if LOG_ISR_SUBMIT
+IRAM_ATTR bool enc_log_submit_from_isr(const void *record, size_t len, bool priority,
+                                       BaseType_t *woken)
+{
+    bool notify;
+    if (!log_isr_push(record, len, priority ? LOG_RING_FLAG_PRIORITY : 0, &notify)) {
+        return false;
+    }
+    // Before enc_log_init() the records wait for the writer's first pass
+    if (notify && s_writer_task != NULL) {
+        xTaskNotifyFromISR(s_writer_task, WRITER_NOTIFY_DATA, eSetBits, woken);
+    }
+    return true;
+}
+#endif
+
+void enc_log_cancel(uint32_t handle)
+{
+    log_ring_cancel(&s_ring, handle - 1);
+    // Records committed behind it were held up by the open slot
+    xTaskNotify(s_writer_task, WRITER_NOTIFY_DATA, eSetBits);
+}
+
+bool enc_log_wait_commit(uint32_t ticket, uint32_t timeout_ms)
+{
+    commit_waiter_t *w = NULL;
+
+    xSemaphoreTake(s_commit_lock, portMAX_DELAY);
+    if (ticket_committed(ticket)) {
+        xSemaphoreGive(s_commit_lock);
+        return true;
+    }
+    for (size_t i = 0; i < LOG_COMMIT_WAITERS && w == NULL; i++) {
+        if (!s_commit_waiters[i].used) {
+            w = &s_commit_waiters[i];
+        }
+    }
+    if (w == NULL) {
+        xSemaphoreGive(s_commit_lock);
+        ESP_LOGW(TAG, "more than %u commit waiters", (unsigned)LOG_COMMIT_WAITERS);
+        return false;
+    }
+    w->ticket = ticket;
+    w->used = true;
+    s_commit_waits++;
+    xSemaphoreGive(s_commit_lock);
+
+    // Waiters that arrive while the writer is busy share its next sync
+    xTaskNotify(s_writer_task, WRITER_NOTIFY_COMMIT, eSetBits);
+    if (xSemaphoreTake(w->done, pdMS_TO_TICKS(timeout_ms)) == pdTRUE) {
+        return true;
+    }
+
+    xSemaphoreTake(s_commit_lock, portMAX_DELAY);
+    const bool woken = !w->used;
+    if (woken) {
+        // Given between the timeout and the lock: take it so the slot starts clean
+        xSemaphoreTake(w->done, 0);
+    }
+    w->used = false;
+    xSemaphoreGive(s_commit_lock);
+    return woken;
+}
+
+bool enc_log_wait_ready(uint32_t timeout_ms)
+{
+    if (s_ready_events == NULL) {
+        return false;
+    }
+    const TickType_t wait = (timeout_ms == UINT32_MAX) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    const EventBits_t bits = xEventGroupWaitBits(s_ready_events, READY_EVENT_DONE, pdFALSE,
+                                                 pdTRUE, wait);
+    return (bits & READY_EVENT_OK) != 0;
+}
+
+void enc_log_flush(void)
+{
+    xTaskNotify(s_writer_task, WRITER_NOTIFY_FLUSH, eSetBits);
+}
+
+void enc_log_clear(void)
+{
+    xTaskNotify(s_writer_task, WRITER_NOTIFY_CLEAR, eSetBits);
+}
+
+bool enc_log_sync(uint32_t timeout_ms)
+{
+    // Drop a completion left over from an earlier sync that timed out
+    xSemaphoreTake(s_sync_done, 0);
+    xTaskNotify(s_writer_task, WRITER_NOTIFY_SYNC, eSetBits);
+    return xSemaphoreTake(s_sync_done, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+void enc_log_print_hex(void)
+{
+    enc_log_snapshot_t snap;
+    enc_log_snapshot_open(&snap);
+    if (snap.size == 0) {
+        ESP_LOGI(TAG, "log is empty.");
+    } else {
+        // Chunk by chunk: the writer only waits for one read at a time
+        ESP_LOGI(TAG, "raw file content (hex):");
+        uint8_t buf[32];
+        uint32_t pos = 0;
+        while (pos < snap.size) {
+            const size_t n = enc_log_snapshot_read(&snap, pos, buf, sizeof(buf));
+            if (n == 0) {
+                break;
+            }
+            ESP_LOG_BUFFER_HEX_LEVEL(TAG, buf, n, ESP_LOG_INFO);
+            pos += (uint32_t)n;
+        }
+    }
+    enc_log_snapshot_close(&snap);
+}
+
+uint32_t enc_log_size(void)
+{
+    file_lock();
+    log_store_sync();
+    const uint32_t size = log_store_size();
+    file_unlock();
+    return size;
+}
+
+void enc_log_snapshot_open(enc_log_snapshot_t *snap)
+{
+    file_lock();
+    // Buffered records are only readable once written out
+    log_store_sync();
+    log_store_pin(true);
+    snap->channel = 0;
+    snap->base = log_store_dropped();
+    snap->size = log_store_size();
+    memset(&snap->map, 0, sizeof(snap->map));
+    file_unlock();
+}
+
+#if LOG_CHANNELS > 1
+void enc_log_snapshot_open_channel(enc_log_snapshot_t *snap, uint8_t channel)
+{
+    if (channel == 0 || channel >= LOG_CHANNELS) {
+        enc_log_snapshot_open(snap);
+        return;
+    }
+    file_lock();
+    log_channel_sync();
+    log_channel_pin(channel, true);
+    snap->channel = channel;
+    snap->base = log_channel_dropped(channel);
+    snap->size = log_channel_size(channel);
+    memset(&snap->map, 0, sizeof(snap->map));
+    file_unlock();
+}
+
+bool enc_log_channel_info(uint8_t channel, log_channel_info_t *info)
+{
+    if (channel == 0 || channel >= LOG_CHANNELS) {
+        return false;
+    }
+    file_lock();
+    log_channel_info(channel, info);
+    file_unlock();
+    return true;
+}
+#endif
+
+size_t enc_log_snapshot_read(void *snapshot, uint32_t offset, void *buf, size_t len)
+{
+    const enc_log_snapshot_t *snap = (const enc_log_snapshot_t *)snapshot;
+    if (offset >= snap->size) {
+        return 0;
+    }
+    if (len > snap->size - offset) {
+        len = snap->size - offset;
+    }
+
+    size_t n = 0;
+    file_lock();
+    // Data the store had to drop anyway (no space, ring wrap, clear) reads as the end
+    const uint32_t shift = snapshot_shift(snap);
+    if (offset >= shift) {
+#if LOG_CHANNELS > 1
+        n = (snap->channel != 0) ? log_channel_read(snap->channel, offset - shift, buf, len)
+                                 : log_store_read(offset - shift, buf, len);
+#else
+        n = log_store_read(offset - shift, buf, len);
+#endif
+    }
+    file_unlock();
+    return n;
+}
+
+const void *enc_log_snapshot_view(enc_log_snapshot_t *snap, uint32_t offset, size_t *len)
+{
+    const void *p = NULL;
+    size_t n = 0;
+    // Channel segments are files: copy through enc_log_snapshot_read()
+    if (offset < snap->size && snap->channel == 0) {
+        file_lock();
+        const uint32_t shift = snapshot_shift(snap);
+        if (offset >= shift) {
+            p = log_store_view(&snap->map, offset - shift, &n);
+        }
+        file_unlock();
+    }
+    if (n > snap->size - offset) {
+        n = snap->size - offset;
+    }
+    if (n > *len) {
+        n = *len;
+    }
+    *len = n;
+    return (n > 0) ? p : NULL;
+}
+
+bool enc_log_snapshot_zone(const enc_log_snapshot_t *snap, uint32_t offset, log_store_zone_t *zone)
+{
+    file_lock();
+    const uint32_t shift = snapshot_shift(snap);
+    const bool found = snap->channel == 0 && offset >= shift && log_store_zone(offset - shift, zone);
+    file_unlock();
+    if (found) {
+        zone->position += shift;
+        zone->end += shift;
+    }
+    return found;
+}
+
+bool enc_log_segment_next(uint32_t id, log_store_segment_t *seg)
+{
+    file_lock();
+    const bool found = log_store_segment_next(id, seg);
+    file_unlock();
+    return found;
+}
+
+size_t enc_log_segment_read(uint32_t id, uint32_t offset, void *buf, size_t len)
+{
+    file_lock();
+    const size_t n = log_store_segment_read(id, offset, buf, len);
+    file_unlock();
+    return n;
+}
+
+bool enc_log_snapshot_kept(const enc_log_snapshot_t *snap, uint32_t offset)
+{
+    file_lock();
+    const bool kept = offset >= snapshot_shift(snap);
+    file_unlock();
+    return kept;
+}
+
+bool enc_log_snapshot_seek(const enc_log_snapshot_t *snap, log_store_seek_t by, uint32_t value,
+                           log_store_entry_t *entry)
+{
+    file_lock();
+    const uint32_t shift = snapshot_shift(snap);
+    bool found = false;
+    if (by != LOG_STORE_SEEK_POSITION || value >= shift) {
+        const uint32_t key = (by == LOG_STORE_SEEK_POSITION) ? value - shift : value;
+#if LOG_CHANNELS > 1
+        found = (snap->channel != 0) ? log_channel_seek(snap->channel, by, key, entry)
+                                     : log_store_seek(by, key, entry);
+#else
+        found = log_store_seek(by, key, entry);
+#endif
+    }
+    file_unlock();
+    if (found) {
+        entry->position += shift;
+        entry->next_position += shift;
+        if (entry->epoch_position != INDEX_NO_EPOCH) {
+            entry->epoch_position += shift;
+        }
+    }
+    return found;
+}
+
+void enc_log_snapshot_close(enc_log_snapshot_t *snap)
+{
+    file_lock();
+    log_store_unmap(&snap->map);
+#if LOG_CHANNELS > 1
+    if (snap->channel != 0) {
+        log_channel_pin(snap->channel, false);
+    } else {
+        log_store_pin(false);
+    }
+#else
+    log_store_pin(false);
+#endif
+    file_unlock();
+    snap->size = 0;
+}
+
+#if LOG_MERKLE_MODE
+bool enc_log_print_proof(uint32_t seq)
+{
+    uint8_t path[LOG_MERKLE_MAX_DEPTH][LOG_MERKLE_HASH_BYTES];
+    const log_merkle_t *t = &s_merkle_signed;
+    bool ok = false;
+
+    file_lock();
+    // Buffered appends are only readable once written out
+    log_store_sync();
+    uint32_t index = 0;
+    while (s_merkle_have_signed && index < t->count &&
+           (seq < t->info[index].seq || seq - t->info[index].seq >= t->info[index].records)) {
+        index++;
+    }
+    if (!s_merkle_have_signed || index == t->count) {
+        ESP_LOGW(TAG, "seq %lu is not in the last signed window", (unsigned long)seq);
+    } else {
+        const log_merkle_leaf_t *leaf = &t->info[index];
+        const size_t path_len = log_merkle_proof(t, index, path, LOG_MERKLE_MAX_DEPTH);
+        const uint8_t *root = s_merkle_root_record + MERKLE_ROOT_SIGNED_BYTES - LOG_MERKLE_HASH_BYTES;
+        ok = log_merkle_verify(t->leaves[index], index, t->count, path, path_len, root);
+
+        ESP_LOGI(TAG, "proof for seq %lu: leaf %lu of %lu, %u bytes at offset %lu (%s)",
+                 (unsigned long)seq, (unsigned long)index, (unsigned long)t->count,
+                 (unsigned)leaf->len, (unsigned long)leaf->offset, ok ? "verified" : "BROKEN");
+        ESP_LOGI(TAG, "root record:");
+        ESP_LOG_BUFFER_HEX_LEVEL(TAG, s_merkle_root_record,
+                                 MERKLE_ROOT_SIGNED_BYTES + 1 + s_merkle_root_record[MERKLE_ROOT_SIGNED_BYTES],
+                                 ESP_LOG_INFO);
+        ESP_LOGI(TAG, "record:");
+        uint8_t buf[32];
+        for (uint32_t pos = 0; pos < leaf->len; ) {
+            const size_t want = (leaf->len - pos < sizeof(buf)) ? leaf->len - pos : sizeof(buf);
+            const size_t n = log_store_read(leaf->offset + pos, buf, want);
+            if (n == 0) {
+                break;
+            }
+            ESP_LOG_BUFFER_HEX_LEVEL(TAG, buf, n, ESP_LOG_INFO);
+            pos += (uint32_t)n;
+        }
+        ESP_LOGI(TAG, "audit path (%u hashes, leaf level first):", (unsigned)path_len);
+        for (size_t i = 0; i < path_len; i++) {
+            ESP_LOG_BUFFER_HEX_LEVEL(TAG, path[i], LOG_MERKLE_HASH_BYTES, ESP_LOG_INFO);
+        }
+    }
+    file_unlock();
+    return ok;
+}
+#endif
+
+void enc_log_set_append_cb(enc_log_append_cb_t cb, void *ctx)
+{
+    s_append_ctx = ctx;
+    s_append_cb = cb;
+}
+
+// Static buffers of this module in the configured mode, for right-sizing RAM
+// The buffers marked BULK_ATTR
+static uint32_t bulk_buffer_bytes(void)
+{
+    uint32_t bytes = 0;
+#if LOG_BATCH_MODE
+#if LOG_CHANNELS > 1
+    bytes += sizeof(s_channel_pt);
+#if !LOG_BATCH_PIPELINE
+    bytes += sizeof(s_joint);
+#endif
+#elif LOG_BATCH_PIPELINE
+    bytes += sizeof(s_batch_pt);
+#endif
+#if LOG_INTEGRITY_MODE
+    bytes += sizeof(s_batch_frame);
+#elif LOG_BATCH_PIPELINE
+    bytes += sizeof(s_group_bufs);
+#else
+    bytes += sizeof(s_batch_group);
+#endif
+#if LOG_BATCH_COMPRESS
+    bytes += sizeof(s_batch_lz);
+#endif
+#if LOG_BATCH_DELTA
+    bytes += sizeof(s_batch_delta);
+#endif
+#if LOG_COMPACT
+    bytes += sizeof(s_compact_run) + sizeof(s_compact_pt) + sizeof(s_compact_group);
+#endif
+#endif
+#if LOG_CTR_MODE
+    bytes += sizeof(s_ks);
+#endif
+#if LOG_READ_CACHE
+    bytes += log_cache_buffer_bytes();
+#endif
+    return bytes;
+}
+
+static uint32_t static_buffer_bytes(void)
+{
+    uint32_t bytes = sizeof(s_ring) + bulk_buffer_bytes();
+#if LOG_BATCH_DELTA
+    bytes += sizeof(s_delta);
+#endif
+#if LOG_IV_MODE && !LOG_BATCH_MODE && !LOG_HYBRID_MODE
+    bytes += sizeof(s_iv_cache);
+#endif
+#if LOG_MERKLE_MODE
+    bytes += sizeof(s_merkle) + sizeof(s_merkle_signed);
+#endif
+#if LOG_ISR_SUBMIT
+    bytes += log_isr_buffer_bytes();
+#endif
+    return bytes;
+}
+
+void enc_log_get_stats(enc_log_stats_t *stats)
+{
+    stats->submitted = __atomic_load_n(&s_submitted, __ATOMIC_RELAXED);
+    stats->dropped = s_ring.dropped + s_submit_timeouts;
+    stats->ring_evicted = s_ring.evicted;
+    stats->ring_downsampled = s_ring.downsampled;
+    stats->submit_blocked = s_submit_blocked;
+    stats->submit_timeouts = s_submit_timeouts;
+    stats->ring_depth = log_ring_count(&s_ring);
+    stats->ring_high_water = s_ring.high_water;
+    stats->records_written = s_records_written;
+    stats->bytes_written = s_bytes_written;
+    stats->write_errors = s_write_errors;
+    stats->store_syncs = 0;
+    stats->store_free = 0;
+    stats->maint_pending = 0;
+    stats->maint_steps = s_maint_steps;
+#if LOG_HYBRID_MODE
+    stats->key_epochs = s_key_epochs;
+    stats->key_inline = s_key_inline;
+#else
+    stats->key_epochs = 0;
+    stats->key_inline = 0;
+#endif
+#if LOG_CTR_MODE
+    stats->ks_cached = s_ks_count;
+    stats->ks_inline = s_ks_inline;
+#else
+    stats->ks_cached = 0;
+    stats->ks_inline = 0;
+#endif
+    stats->erase_min = 0;
+    stats->erase_max = 0;
+    stats->inline_erases = 0;
+    stats->replica_lag = 0;
+    stats->replica_segment = 0;
+    stats->replica_offset = 0;
+    if (s_file_lock != NULL) {
+        file_lock();
+        stats->write_errors += log_store_lost();
+        stats->store_syncs = log_store_syncs();
+        stats->store_free = log_store_free();
+        stats->maint_pending = log_store_maint_pending();
+        (void)log_store_wear(&stats->erase_min, &stats->erase_max);
+        stats->inline_erases = log_store_inline_erases();
+        log_store_replica_t replica;
+        (void)log_store_replica(&replica);
+        stats->replica_lag = replica.lag_bytes;
+        stats->replica_segment = replica.segment;
+        stats->replica_offset = replica.offset;
+        file_unlock();
+    }
+#if LOG_BATCH_PIPELINE
+    stats->write_errors += s_store_errors;
+    stats->pipeline_waits = s_pipeline_waits;
+    stats->store_stack_free = (s_store_task != NULL) ? uxTaskGetStackHighWaterMark(s_store_task) : 0;
+#else
+    stats->pipeline_waits = 0;
+    stats->store_stack_free = 0;
+#endif
+    stats->optiga_requests = s_optiga_sync.completions;
+    stats->optiga_last_us = (uint32_t)s_optiga_sync.last_latency_us;
+    stats->optiga_max_us = (uint32_t)s_optiga_sync.max_latency_us;
+    stats->optiga_min_us = (uint32_t)s_optiga_sync.min_latency_us;
+    stats->optiga_timeouts = s_optiga_sync.timeouts;
+#if LOG_BATCH_COMPRESS
+    stats->lz_tried = s_lz_tried;
+    stats->lz_groups = s_lz_groups;
+    stats->lz_in_bytes = s_lz_in_bytes;
+    stats->lz_out_bytes = s_lz_out_bytes;
+    stats->lz_us = s_lz_us;
+#else
+    stats->lz_tried = 0;
+    stats->lz_groups = 0;
+    stats->lz_in_bytes = 0;
+    stats->lz_out_bytes = 0;
+    stats->lz_us = 0;
+#endif
+#if LOG_COMPACT
+    stats->compact_segments = s_compact_segments;
+    stats->compact_groups_in = s_compact_groups_in;
+    stats->compact_groups_out = s_compact_groups_out;
+    stats->compact_saved = s_compact_saved;
+    stats->compact_deferred = s_compact_deferred;
+    stats->compact_stack_free =
+        (s_compact_task != NULL) ? uxTaskGetStackHighWaterMark(s_compact_task) : 0;
+#else
+    stats->compact_segments = 0;
+    stats->compact_groups_in = 0;
+    stats->compact_groups_out = 0;
+    stats->compact_saved = 0;
+    stats->compact_deferred = 0;
+    stats->compact_stack_free = 0;
+#endif
+#if LOG_BATCH_DELTA
+    stats->delta_tried = s_delta_tried;
+    stats->delta_groups = s_delta_groups;
+    stats->delta_in_bytes = s_delta_in_bytes;
+    stats->delta_out_bytes = s_delta_out_bytes;
+#else
+    stats->delta_tried = 0;
+    stats->delta_groups = 0;
+    stats->delta_in_bytes = 0;
+    stats->delta_out_bytes = 0;
+#endif
+    stats->priority_records = s_priority_records;
+    stats->commit_waits = s_commit_waits;
+    stats->commit_groups = s_commit_groups;
+#if LOG_BATCH_MAX_LATENCY_MS > 0
+    stats->deadline_flushes = s_deadline_flushes;
+#else
+    stats->deadline_flushes = 0;
+#endif
+#if LOG_CHANNELS > 1 && !LOG_BATCH_PIPELINE
+    stats->joint_flushes = s_joint_flushes;
+    stats->joint_groups = s_joint_groups;
+#else
+    stats->joint_flushes = 0;
+    stats->joint_groups = 0;
+#endif
+    optiga_trust_current_limit_t limit;
+    optiga_trust_get_current_limit(&limit);
+    stats->current_ma = limit.milliamps;
+    stats->current_writes = limit.writes;
+#if LOG_WARM_POLICY
+    stats->warmups = s_warmups;
+    stats->warm_skipped = s_warm_skipped;
+#else
+    stats->warmups = 0;
+    stats->warm_skipped = 0;
+#endif
+    stats->writer_stack_free = (s_writer_task != NULL) ? uxTaskGetStackHighWaterMark(s_writer_task) : 0;
+    stats->buffer_bytes = static_buffer_bytes();
+    stats->buffer_psram_bytes = LOG_PSRAM ? bulk_buffer_bytes() : 0;
+    stats->boot_mount_ms = s_boot_mount_ms;
+    stats->boot_open_ms = s_boot_open_ms;
+#if LOG_ISR_SUBMIT
+    log_isr_get_counts(&stats->isr_queued, &stats->isr_dropped);
+    stats->isr_depth = log_isr_count();
+#else
+    stats->isr_queued = 0;
+    stats->isr_dropped = 0;
+    stats->isr_depth = 0;
+#endif
+#if LOG_BATCH_AUTOTUNE
+    log_tune_point_t tune;
+    log_tune_get(&tune);
+    stats->tune_batch = tune.batch_records;
+    stats->tune_deadline_ms = tune.deadline_ms;
+    stats->tune_arrival_mrps = tune.arrival_mrps;
+    stats->tune_capacity_rps = tune.capacity_rps;
+    stats->tune_durable_ms = tune.durable_ms;
+#else
+    stats->tune_batch = 0;
+    stats->tune_deadline_ms = 0;
+    stats->tune_arrival_mrps = 0;
+    stats->tune_capacity_rps = 0;
+    stats->tune_durable_ms = 0;
+#endif
+    stats->appends = s_append_lat_count;
+    stats->append_mean_ms = (s_append_lat_count > 0)
+                                ? (uint32_t)(s_append_lat_sum_ms / s_append_lat_count) : 0;
+    stats->append_p99_ms = append_latency_percentile_ms(99);
+    stats->append_max_ms = s_append_lat_max_ms;
+
+    // The callback may update the sums in between; good enough for a report
+    const uint32_t n = s_optiga_sync.latency_count;
+    stats->optiga_samples = n;
+    stats->optiga_mean_us = 0;
+    stats->optiga_jitter_us = 0;
+    if (n > 0) {
+        const double mean = (double)s_optiga_sync.latency_sum_us / n;
+        const double var = (double)s_optiga_sync.latency_sum_sq_us / n - mean * mean;
+        stats->optiga_mean_us = (uint32_t)mean;
+        stats->optiga_jitter_us = (var > 0.0) ? (uint32_t)sqrt(var) : 0;
+    }
+}
+
+void enc_log_reset_latency(void)
+{
+    optiga_sync_reset_latency(&s_optiga_sync);
+    memset(s_append_lat, 0, sizeof(s_append_lat));
+    s_append_lat_count = 0;
+    s_append_lat_sum_ms = 0;
+    s_append_lat_max_ms = 0;
+}
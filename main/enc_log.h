@@ -0,0 +1,289 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Producer-facing API of the encrypted log writer.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    enc_log.h
+ * @brief   Encrypted log writer (OPTIGA AES-CBC + FATFS)
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    enc_log_submit() only copies the record into a lock-free ring.
+ *          A dedicated writer task encrypts in OPTIGA and appends to storage,
+ *          so producers never block on OPTIGA or on fwrite.
+ *******************************************************************************/
+#ifndef ENC_LOG_H
+#define ENC_LOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+#include "log_store.h"
+#if LOG_CHANNELS > 1
+#include "log_channel.h"
+#endif
+#if LOG_ISR_SUBMIT
+#include "freertos/FreeRTOS.h"
+#endif
+
+typedef struct {
+    uint32_t submitted;         // records accepted by enc_log_submit()
+    uint32_t dropped;           // records rejected (ring full / too long, block timeouts)
+    uint32_t ring_evicted;      // old records discarded for new ones (LOG_RING_DROP_OLDEST)
+    uint32_t ring_downsampled;  // normal records thinned out (LOG_RING_DOWNSAMPLE)
+    uint32_t submit_blocked;    // submits that waited for a slot (LOG_RING_BLOCK)
+    uint32_t submit_timeouts;   // of those, dropped after LOG_RING_BLOCK_MS (also in dropped)
+    uint32_t ring_depth;        // records currently waiting in the ring
+    uint32_t ring_high_water;   // max ring fill level since boot
+    uint32_t records_written;   // records encrypted and appended
+    uint32_t bytes_written;     // log bytes appended (records, headers, tags)
+    uint32_t appends;           // appends in the append latency figures (records, or block groups)
+    uint32_t append_mean_ms;    // mean submit to append time of the oldest record of an append
+    uint32_t append_p99_ms;     // its 99th percentile (upper bound of a log2 bucket)
+    uint32_t append_max_ms;     // its maximum
+    uint32_t store_syncs;       // syncs that made appends durable (fsync, raw page program)
+    uint32_t store_free;        // bytes that fit before old data is dropped (log_store_free())
+    uint32_t maint_pending;     // store upkeep steps left (files of a clear, raw retention, SD tier moves)
+    uint32_t maint_steps;       // upkeep steps run by the writer since boot
+    uint32_t key_epochs;        // hybrid mode: key epochs started since boot
+    uint32_t key_inline;        // of those, key derived on the record path (no idle time before)
+    uint32_t ks_cached;         // CTR mode: keystream blocks cached for the next records
+    uint32_t ks_inline;         // records that found too few blocks and waited for OPTIGA
+    uint32_t erase_min;         // raw store: fewest erases of a sector (log_store_wear())
+    uint32_t erase_max;         // raw store: most erases of a sector, 0 for FATFS
+    uint32_t inline_erases;     // raw store: sector erases on the append path (pool empty)
+    uint32_t replica_lag;       // SD tier: bytes durable in flash, not yet synced on the card
+    uint32_t replica_segment;   // SD tier checkpoint: segment being copied ...
+    uint32_t replica_offset;    // ... and its bytes synced on the card (LOG_TIER_REPLICATE)
+    uint32_t optiga_requests;   // OPTIGA requests completed by the writer instance since boot
+    uint32_t write_errors;      // records lost to encrypt or storage errors
+    uint32_t optiga_last_us;    // start to callback time of the last OPTIGA request
+    uint32_t optiga_max_us;     // longest OPTIGA request since boot (or latency reset)
+    uint32_t optiga_min_us;     // shortest OPTIGA request since boot (or latency reset)
+    uint32_t optiga_mean_us;    // mean OPTIGA request time
+    uint32_t optiga_jitter_us;  // standard deviation of the OPTIGA request time
+    uint32_t optiga_samples;    // OPTIGA requests in min/mean/jitter
+    uint32_t optiga_timeouts;   // requests that ran past LOG_OPTIGA_TIMEOUT_MS
+    uint32_t lz_tried;          // block groups offered to the compressor (LOG_BATCH_COMPRESS)
+    uint32_t lz_groups;         // block groups written compressed
+    uint32_t lz_in_bytes;       // group plaintext bytes offered to the compressor
+    uint32_t lz_out_bytes;      // bytes encrypted for them (padded, raw if not smaller)
+    uint32_t lz_us;             // CPU time spent compressing
+    uint32_t delta_tried;       // sample record groups offered to the delta encoder (LOG_BATCH_DELTA)
+    uint32_t delta_groups;      // block groups written delta encoded
+    uint32_t delta_in_bytes;    // group plaintext bytes offered to the delta encoder
+    uint32_t delta_out_bytes;   // bytes encrypted for them (padded, raw if not smaller)
+    uint32_t compact_segments;  // closed segments rewritten by the compactor (LOG_COMPACT)
+    uint32_t compact_groups_in; // plain block groups merged ...
+    uint32_t compact_groups_out;    // ... into these
+    uint32_t compact_saved;     // log bytes the rewrites saved
+    uint32_t compact_deferred;  // rewrites dropped at the swap (snapshot open, I/O), tried again
+    uint32_t compact_stack_free;    // least free compaction task stack seen, bytes
+    uint32_t priority_records;  // priority records taken from the ring (each flushed and synced)
+    uint32_t commit_waits;      // enc_log_wait_commit() calls that had to wait
+    uint32_t commit_groups;     // writer syncs that ended those waits (waits per sync = grouping)
+    uint32_t deadline_flushes;  // block groups flushed by LOG_BATCH_MAX_LATENCY_MS
+    uint32_t joint_flushes;     // encrypt requests that carried the groups of several channels
+    uint32_t joint_groups;      // block groups they carried
+    uint32_t current_ma;        // OPTIGA current limit, 0 if not known yet
+    uint32_t current_writes;    // current limit changes since boot (OPTIGA NVM writes)
+    uint32_t warmups;           // keep-warm requests sent by the writer (LOG_WARM_POLICY)
+    uint32_t warm_skipped;      // announced records that found OPTIGA in use, no warm-up needed
+    uint32_t writer_stack_free; // least free writer task stack seen, bytes
+    uint32_t pipeline_waits;    // block groups that waited for the storage task (LOG_BATCH_PIPELINE)
+    uint32_t store_stack_free;  // least free storage task stack seen, bytes (LOG_BATCH_PIPELINE)
+    uint32_t buffer_bytes;      // static ring and batch buffers of the configured mode
+    uint32_t buffer_psram_bytes; // of those, in PSRAM (LOG_PSRAM)
+    uint32_t boot_mount_ms;     // enc_log_init(): file system mount (0 for the raw store)
+    uint32_t boot_open_ms;      // enc_log_init(): store open and recovery of the log end
+    uint32_t isr_queued;        // records queued by enc_log_submit_from_isr() (LOG_ISR_SUBMIT)
+    uint32_t isr_dropped;       // of its calls, rejected (per-core buffer full / too long)
+    uint32_t isr_depth;         // records waiting in the per-core buffers
+    uint32_t tune_batch;        // block group size chosen by the tuner (LOG_BATCH_AUTOTUNE)
+    uint32_t tune_deadline_ms;  // its group deadline
+    uint32_t tune_arrival_mrps; // ingest rate it measured, records per 1000 s
+    uint32_t tune_capacity_rps; // records/s the writer sustains at tune_batch
+    uint32_t tune_durable_ms;   // predicted worst submit to durable time
+} enc_log_stats_t;
+
+// OPTIGA bring-up of the application (optiga_trust_init() and what depends on it), run
+// by enc_log before it creates its instances and checks the key. False stops logging.
+typedef bool (*enc_log_optiga_init_t)(void);
+
+// Mount and open the log and start the writer task. optiga_init (may be NULL), the OPTIGA
+// instances and the key checks run on the writer task with LOG_LAZY_OPTIGA, at the same
+// time as the mount here; records submitted once this returns wait in the ring until both
+// are done. Otherwise they run here, after the mount, before it returns.
+bool enc_log_init(enc_log_optiga_init_t optiga_init);
+
+// Wait until the OPTIGA and storage bring-up of enc_log_init() is over (UINT32_MAX: no limit). True once
+// it succeeded; false on failure, timeout or before enc_log_init(). Anything else using OPTIGA
+// waits for this.
+bool enc_log_wait_ready(uint32_t timeout_ms);
+
+// Queue one plaintext record (<= PLAINTEXT_MAX bytes). A full ring is handled by
+// LOG_RING_POLICY: only LOG_RING_BLOCK waits, for at most LOG_RING_BLOCK_MS.
+// seq is the producer's record number, kept in the sparse index next to the log.
+// priority (alarms): the writer appends it without waiting for the block group to
+// fill and syncs the store; records queued before it go out with it.
+// Any number of tasks may submit; the cost is a lock-free enqueue.
+bool enc_log_submit(const void *record, size_t len, uint32_t seq, bool priority);
+
+// enc_log_submit() that also returns the record's commit ticket for enc_log_wait_commit().
+bool enc_log_submit_ticket(const void *record, size_t len, uint32_t seq, bool priority,
+                           uint32_t *ticket);
+
+#if LOG_FORMAT_HEADER
+// Format header this build opens its log files with (enc_log_config.h).
+void enc_log_format_header(uint8_t header[FORMAT_HDR_BYTES]);
+#endif
+
+#if LOG_CHANNELS > 1
+// enc_log_submit_ticket() into the log of channel (0..LOG_CHANNELS-1, 0 is the log above;
+// ticket may be NULL). Channels share the ring, the writer and the OPTIGA requests; each
+// has its own files, index and retention (log_channel.h). seq numbers the channel's
+// records in its index. A priority record also flushes the groups of the other channels.
+bool enc_log_submit_channel(uint8_t channel, const void *record, size_t len, uint32_t seq,
+                            bool priority, uint32_t *ticket);
+
+// Segment range, size and losses of side channel 1..LOG_CHANNELS-1; false for others.
+bool enc_log_channel_info(uint8_t channel, log_channel_info_t *info);
+#endif
+
+// Zero-copy submit: reserve a ring slot for a record of up to len bytes and return its
+// buffer, which the writer later encrypts from in place. NULL under backpressure, as
+// enc_log_submit() would fail (LOG_RING_BLOCK waits first): the producer can skip
+// formatting the record. *handle is also the record's ticket for enc_log_wait_commit().
+// End every reservation promptly with enc_log_commit() (len bytes written) or
+// enc_log_cancel(), without blocking in between: records reserved after it wait for it.
+void *enc_log_reserve(size_t len, bool priority, uint32_t *handle);
+void enc_log_commit(uint32_t handle, size_t len, uint32_t seq);
+void enc_log_cancel(uint32_t handle);
+
+#if LOG_ISR_SUBMIT
+// Queue one record (<= LOG_ISR_RECORD_MAX bytes) from an interrupt handler (IRAM, any
+// core, nested handlers too). It waits in a buffer of the calling core until the writer
+// moves it into the ring: the record's uptime comes from the cycle count taken here, its
+// sequence number from log_seq_next() then. The first record after the writer has
+// drained the buffers notifies it; *woken is set as by xTaskNotifyFromISR(). False when
+// the buffer of the core is full. No ticket: a handler cannot wait for the commit.
+bool enc_log_submit_from_isr(const void *record, size_t len, bool priority, BaseType_t *woken);
+#endif
+
+// Block until the record of `ticket` and everything submitted before it is in the synced
+// store (group commit: the writer takes the records of all producers, then syncs once
+// for every waiting task). A record lost to a write error, a clear or an eviction
+// (LOG_RING_DROP_OLDEST) also ends the wait; the stats count it. False on timeout or with more than LOG_COMMIT_WAITERS
+// tasks waiting.
+bool enc_log_wait_commit(uint32_t ticket, uint32_t timeout_ms);
+
+// Ask the writer task to encrypt and write any pending batch.
+void enc_log_flush(void);
+
+// Write everything submitted so far (including a pending batch) and fsync it.
+// Blocks the caller until done; false on timeout.
+bool enc_log_sync(uint32_t timeout_ms);
+
+// Ask the writer task to drop pending records and truncate the log file.
+void enc_log_clear(void);
+
+// Dump the raw log file as hex (safe while the writer is running).
+void enc_log_print_hex(void);
+
+// Bytes in the log after syncing pending records.
+uint32_t enc_log_size(void);
+
+// Fixed view of the log for long reads (export, query, hex dump) while the writer
+// keeps appending: the bytes synced at open, at offsets that stay put until the
+// close. Retention that would delete them waits meanwhile (log_store_pin()).
+typedef struct {
+    uint32_t base;              // log_store_dropped() at open
+    uint32_t size;              // readable bytes [0, size)
+    log_store_map_t map;        // flash window of enc_log_snapshot_view()
+    uint8_t channel;            // 0: the log, else a side channel (LOG_CHANNELS)
+} enc_log_snapshot_t;
+
+// Sync pending records and open a snapshot of the log. Close every snapshot.
+void enc_log_snapshot_open(enc_log_snapshot_t *snap);
+
+#if LOG_CHANNELS > 1
+// Snapshot of the log of channel 1..LOG_CHANNELS-1 (0 opens the log as above). The calls
+// below work on it alike; views and zones are not available (NULL, false).
+void enc_log_snapshot_open_channel(enc_log_snapshot_t *snap, uint8_t channel);
+#endif
+
+// Read snapshot bytes at offset, a log_reader_read_t with the snapshot as read_ctx.
+// Returns bytes read: 0 past the end, or if the store had to drop the data anyway
+// (out of space, raw ring wrap, clear).
+size_t enc_log_snapshot_read(void *snapshot, uint32_t offset, void *buf, size_t len);
+
+// Snapshot bytes at offset in place (log_store_view()), no copy: at most *len on
+// entry, the count on return. NULL if the store cannot map or the data is gone;
+// fall back to enc_log_snapshot_read(). The bytes stay mapped until the next view
+// or the close, but are only trustworthy while enc_log_snapshot_kept(offset) holds.
+const void *enc_log_snapshot_view(enc_log_snapshot_t *snap, uint32_t offset, size_t *len);
+
+// True while the snapshot bytes from offset on are still in the store. Check after
+// using a view: a drop the store could not defer may have erased the bytes meanwhile.
+bool enc_log_snapshot_kept(const enc_log_snapshot_t *snap, uint32_t offset);
+
+// Sparse index lookup (see log_store_seek()) in snapshot offsets, for positions
+// passed in and returned alike.
+bool enc_log_snapshot_seek(const enc_log_snapshot_t *snap, log_store_seek_t by, uint32_t value,
+                           log_store_entry_t *entry);
+
+// Sealed segment holding snapshot offset (see log_store_zone()), in snapshot offsets.
+bool enc_log_snapshot_zone(const enc_log_snapshot_t *snap, uint32_t offset, log_store_zone_t *zone);
+
+// Release the snapshot; retention it held back runs at the store's next check.
+void enc_log_snapshot_close(enc_log_snapshot_t *snap);
+
+// Sealed segments (LOG_ROTATE) by id, for shipping them whole (see
+// log_store_segment_next()). Ids keep counting up across clears. Hold a snapshot open
+// meanwhile so retention does not drop the segment being read.
+bool enc_log_segment_next(uint32_t id, log_store_segment_t *seg);
+size_t enc_log_segment_read(uint32_t id, uint32_t offset, void *buf, size_t len);
+
+#if LOG_MERKLE_MODE
+// Print the inclusion proof of record seq (last signed window only): the signed root
+// record, the appended bytes holding the record and the audit path. False if seq is
+// not covered or the path does not check out.
+bool enc_log_print_proof(uint32_t seq);
+#endif
+
+void enc_log_get_stats(enc_log_stats_t *stats);
+
+// Hold the OPTIGA current limit at LOG_CURRENT_BUSY_MA during bulk OPTIGA work outside the
+// writer (readback, export); the writer applies it. No effect without LOG_CURRENT_POLICY.
+void enc_log_set_current_boost(bool on);
+
+// A record is expected in in_ms: the writer warms OPTIGA up LOG_WARM_LEAD_MS before, so it
+// is encrypted at steady-state latency after a pause. Replaces an earlier announcement;
+// call it when the next sample is scheduled. No effect without LOG_WARM_POLICY.
+void enc_log_expect(uint32_t in_ms);
+
+// Called on the writer task (the storage task with LOG_BATCH_PIPELINE) after each append
+// (a record or a block group): count records starting at first_seq are in the store.
+// For measurements such as the benchmark app (bench/); set it while nothing is queued,
+// NULL to remove.
+typedef void (*enc_log_append_cb_t)(uint32_t first_seq, uint32_t count, void *ctx);
+void enc_log_set_append_cb(enc_log_append_cb_t cb, void *ctx);
+
+// Restart the OPTIGA latency figures (max/min/mean/jitter) and the append latency of the stats.
+void enc_log_reset_latency(void);
+
+#endif // ENC_LOG_H
@@ -0,0 +1,1695 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Compile-time configuration shared by the logger modules.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    enc_log_config.h
+ * @brief   Encrypted logger build configuration
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+#ifndef ENC_LOG_CONFIG_H
+#define ENC_LOG_CONFIG_H
+
+// Defaults below come from the "Encrypted logger config" menu (main/Kconfig.projbuild)
+// where it has the option; a -D on the command line still wins over both
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+// --------------------
+// Storage
+// --------------------
+// 0 = internal SPI flash (FATFS + wear levelling)
+// 1 = SD card via SDMMC (FATFS)
+#ifndef LOG_STORAGE_SDMMC
+#ifdef CONFIG_ENC_LOG_STORAGE_SDMMC
+#define LOG_STORAGE_SDMMC 1
+#else
+#define LOG_STORAGE_SDMMC 0
+#endif
+#endif
+
+// Internal flash file system: 0 = FATFS + wear levelling, 1 = LittleFS (joltwallet/littlefs,
+// main/idf_component.yml). LittleFS writes copy-on-write and commits its metadata
+// atomically on fsync, so an append costs no FAT or directory rewrite and a power cut
+// leaves the file at its last sync. The same file store (log_store_fat.c) runs on either.
+#ifndef LOG_STORAGE_LITTLEFS
+#ifdef CONFIG_ENC_LOG_STORAGE_FLASH_LITTLEFS
+#define LOG_STORAGE_LITTLEFS 1
+#else
+#define LOG_STORAGE_LITTLEFS 0
+#endif
+#endif
+
+#if LOG_STORAGE_LITTLEFS && LOG_STORAGE_SDMMC
+#error "LOG_STORAGE_LITTLEFS needs the internal flash partition (LOG_STORAGE_SDMMC 0)"
+#endif
+
+// SD bus: 4-bit at high speed (40 MHz) when D1-D3 are wired. The mount steps down to
+// the default clock and then to 1-bit if the card does not come up, so a board
+// wired for 1-bit mode still works with these defaults.
+#ifndef LOG_SDMMC_BUS_WIDTH
+#ifdef CONFIG_ENC_LOG_SDMMC_BUS_WIDTH
+#define LOG_SDMMC_BUS_WIDTH CONFIG_ENC_LOG_SDMMC_BUS_WIDTH
+#else
+#define LOG_SDMMC_BUS_WIDTH 4
+#endif
+#endif
+#ifndef LOG_SDMMC_HIGHSPEED
+#if defined(CONFIG_ENC_LOG_STORAGE_SDMMC) && !defined(CONFIG_ENC_LOG_SDMMC_HIGHSPEED)
+#define LOG_SDMMC_HIGHSPEED 0
+#else
+#define LOG_SDMMC_HIGHSPEED 1
+#endif
+#endif
+
+#if LOG_SDMMC_BUS_WIDTH != 1 && LOG_SDMMC_BUS_WIDTH != 4
+#error "LOG_SDMMC_BUS_WIDTH must be 1 or 4"
+#endif
+
+// FAT allocation unit on the card; the appender writes whole units at a time
+#define LOG_SDMMC_AU_BYTES  (16 * 1024)
+
+#if LOG_STORAGE_SDMMC
+#define LOG_MOUNT_POINT   "/sdcard"
+#elif LOG_STORAGE_LITTLEFS
+#define LOG_MOUNT_POINT   "/littlefs"
+#else
+#define LOG_MOUNT_POINT   "/spiflash"
+#endif
+
+#define LOG_FILE_PATH     LOG_MOUNT_POINT "/enc_log.bin"
+// I2C capture file of the 'i' command (CONFIG_OPTIGA_TRUST_M_I2C_CAPTURE)
+#define LOG_CAPTURE_PATH  LOG_MOUNT_POINT "/i2c_cap.bin"
+// OPTIGA binary log file of the 'o' command (CONFIG_OPTIGA_TRUST_M_BINARY_LOG)
+#define LOG_OPTIGA_LOG_PATH  LOG_MOUNT_POINT "/optiga_log.bin"
+
+// Log store backend
+// 0 = file on FATFS or LittleFS (LOG_FILE_PATH)
+// 1 = raw append-only log written straight to the flash partition (no FATFS / WL);
+//     internal flash only. Switching backends discards the existing log.
+#ifndef LOG_STORAGE_RAW
+#ifdef CONFIG_ENC_LOG_STORAGE_FLASH_RAW
+#define LOG_STORAGE_RAW 1
+#else
+#define LOG_STORAGE_RAW 0
+#endif
+#endif
+
+#if LOG_STORAGE_RAW && LOG_STORAGE_SDMMC
+#error "LOG_STORAGE_RAW needs the internal flash partition (LOG_STORAGE_SDMMC 0)"
+#endif
+#if LOG_STORAGE_RAW && LOG_STORAGE_LITTLEFS
+#error "pick one backend: LOG_STORAGE_RAW or LOG_STORAGE_LITTLEFS"
+#endif
+
+#define LOG_RAW_PARTITION_LABEL "storage"
+
+// Raw log format: the partition is a ring of 4 KB erase sectors, each holding 16
+// pages of 256B (one flash program page). Every page starts with a header:
+// magic (2B) | flags (1B) | payload bytes (1B) | page seq (4B, LE) |
+// CRC32 of the header fields and payload (4B, LE)
+#define RAW_SECTOR_BYTES        4096
+#define RAW_PAGE_BYTES          256
+#define RAW_PAGE_HDR_BYTES      12
+#define RAW_PAGE_PAYLOAD_BYTES  (RAW_PAGE_BYTES - RAW_PAGE_HDR_BYTES)
+#define RAW_PAGE_MAGIC0         'L'
+#define RAW_PAGE_MAGIC1         'P'
+#define RAW_PAGE_FLAG_START     0x01    // first page after a clear
+
+// Readers of the raw store (readback, export, query, hex dump) see the partition through
+// esp_partition_mmap() instead of esp_partition_read() into a bounce buffer: page headers
+// are checked and payload copied straight from flash through the cache, and export sends
+// frames from the mapping itself. Each reader maps one window of LOG_RAW_MAP_WINDOW_BYTES
+// at a time (whole sectors), which bounds the MMU pages in use; one 64 KB MMU page on
+// ESP32 when the partition is 64 KB aligned.
+#ifndef LOG_RAW_MMAP
+#define LOG_RAW_MMAP 1
+#endif
+#ifndef LOG_RAW_MAP_WINDOW_BYTES
+#define LOG_RAW_MAP_WINDOW_BYTES (16 * RAW_SECTOR_BYTES)
+#endif
+
+#if LOG_RAW_MMAP && (LOG_RAW_MAP_WINDOW_BYTES % RAW_SECTOR_BYTES) != 0
+#error "LOG_RAW_MAP_WINDOW_BYTES must be a multiple of RAW_SECTOR_BYTES"
+#endif
+
+// Raw store wear: erases per sector are counted in RAM (log_store_wear(), 's') and saved
+// to NVS ("enc_log"/"raw_wear") every LOG_RAW_WEAR_SAVE_ERASES erases, so a reset loses
+// at most that many (0 = not counted). The first LOG_RAW_WEAR_SECTORS sectors are
+// tracked (256 = 1 MB); a sector erased by retention is not erased again when the ring
+// reaches it in the same boot.
+#ifndef LOG_RAW_WEAR_SAVE_ERASES
+#define LOG_RAW_WEAR_SAVE_ERASES 64
+#endif
+#ifndef LOG_RAW_WEAR_SECTORS
+#define LOG_RAW_WEAR_SECTORS    256
+#endif
+
+// Raw store pre-erase: keep the next LOG_RAW_PREERASE_SECTORS sectors ahead of the write
+// position erased, one sector per store upkeep step (log_store_maintain(), writer idle
+// time), so appends only program pages and the 4 KB erase (~45 ms) leaves the append
+// path. A pool sector that still holds the oldest live data is dropped early, so the
+// ring keeps that much less history; it waits while a reader has the log pinned. An
+// append that still finds its sector dirty (pool drained by a burst) erases inline, counted
+// as inline_erases in 's'/'j'. Only the first LOG_RAW_WEAR_SECTORS sectors can be
+// pre-erased. 0 = erase when the first page of a sector is programmed.
+#ifndef LOG_RAW_PREERASE_SECTORS
+#define LOG_RAW_PREERASE_SECTORS 2
+#endif
+
+// Flash wear report ('s', 'j'): bytes appended to the log store against bytes programmed
+// and erased on LOG_WEAR_PARTITION_LABEL, counted by link-time wrappers of
+// esp_partition_write/_raw and esp_partition_erase_range (main/CMakeLists.txt), so FATFS
+// and wear_levelling traffic is included. The lifetime projection spreads the erases
+// evenly over the partition and assumes LOG_FLASH_ENDURANCE_CYCLES erases per sector
+// (NOR flash datasheets give 100000).
+#define LOG_WEAR_PARTITION_LABEL "storage"
+#ifndef LOG_FLASH_ENDURANCE_CYCLES
+#define LOG_FLASH_ENDURANCE_CYCLES 100000
+#endif
+
+// The log file stays open; records are buffered in RAM and written in one go.
+// Buffer-sized writes start on a file offset that is a multiple of the buffer
+// size, so each one is a single aligned multi-sector (SD: multi-block) write.
+#ifndef LOG_APPEND_BUF_BYTES
+#if LOG_STORAGE_SDMMC
+#define LOG_APPEND_BUF_BYTES    LOG_SDMMC_AU_BYTES
+#else
+#define LOG_APPEND_BUF_BYTES    4096    // one FAT cluster on the flash partition
+#endif
+#endif
+
+// Alignment of the appender buffer. FATFS hands whole-sector writes straight to the
+// disk driver, and the SDMMC host only DMAs from a buffer in internal RAM that is
+// word (cache line on newer chips) aligned; any other buffer goes through a bounce
+// buffer one sector per command. Sector alignment covers every chip.
+#ifndef LOG_APPEND_BUF_ALIGN
+#if LOG_STORAGE_SDMMC
+#define LOG_APPEND_BUF_ALIGN    512
+#else
+#define LOG_APPEND_BUF_ALIGN    4
+#endif
+#endif
+
+#if LOG_STORAGE_SDMMC && (LOG_APPEND_BUF_BYTES % LOG_SDMMC_AU_BYTES) != 0
+#error "LOG_APPEND_BUF_BYTES must be a whole number of SD allocation units"
+#endif
+
+// Preallocated segment (0 = plain file that grows with every append).
+// > 0: the log file is created at this fixed size with a 512B header holding the
+// end of valid data, and records are written in place, so FAT clusters are only
+// allocated once when the segment is created.
+#ifndef LOG_SEGMENT_BYTES
+#define LOG_SEGMENT_BYTES       0
+#endif
+
+// Rewriting the header of a copy-on-write file copies its block on every sync
+#if LOG_SEGMENT_BYTES > 0 && LOG_STORAGE_LITTLEFS
+#error "LOG_SEGMENT_BYTES is for FATFS; LittleFS appends without cluster allocation"
+#endif
+
+// Segment header format (first sector of the file):
+// magic "ENCLOGSG" (8B) | version (2B, LE) | header bytes (2B, LE) |
+// segment bytes (4B, LE) | data end offset (4B, LE) | sequence ceiling (4B, LE, 0 unless
+// LOG_SEQ_PERSIST 2: the OPTIGA counter value no record of the segment is above) |
+// zero (rest of the sector)
+#define SEGMENT_HDR_MAGIC       "ENCLOGSG"
+#define SEGMENT_HDR_MAGIC_BYTES 8
+#define SEGMENT_HDR_VERSION     1
+#define SEGMENT_HDR_BYTES       512
+
+// Segment rotation (FATFS store)
+// 0 = one log file (LOG_FILE_PATH)
+// 1 = numbered segments (enc_log_0001.bin, ...) listed in a manifest; a new segment is
+//     started when the current one is full and the oldest is deleted once more than
+//     LOG_RETAIN_SEGMENTS exist. Needs long file names (CONFIG_FATFS_LFN_*).
+#ifndef LOG_ROTATE
+#define LOG_ROTATE 0
+#endif
+
+#define LOG_SEGMENT_PATH_FMT    LOG_MOUNT_POINT "/enc_log_%04lu.bin"
+#define LOG_MANIFEST_PATH       LOG_MOUNT_POINT "/enc_log.man"
+
+// A segment is full at this many data bytes (preallocated segments: when the
+// segment is full) or at this many appends (0 = no record limit)
+#ifndef LOG_ROTATE_BYTES
+#define LOG_ROTATE_BYTES        (64 * 1024)
+#endif
+#ifndef LOG_ROTATE_RECORDS
+#define LOG_ROTATE_RECORDS      0
+#endif
+#ifndef LOG_RETAIN_SEGMENTS
+#define LOG_RETAIN_SEGMENTS     8
+#endif
+
+// Manifest format (16B):
+// magic "ELMF" (4B) | oldest live segment id (4B, LE) | current segment id (4B, LE) |
+// CRC32 of the first 12 bytes (4B, LE)
+#define MANIFEST_MAGIC          "ELMF"
+#define MANIFEST_BYTES          16
+
+#if LOG_ROTATE && LOG_STORAGE_RAW
+#error "LOG_ROTATE applies to the FATFS store only"
+#endif
+
+// Tiered storage (FATFS store): records collect in the RAM append buffer, segments are
+// written to the `storage` partition (low latency, 1 MB) and closed segments move to the
+// SD card (large, slower, removable) mounted at LOG_TIER_MOUNT_POINT
+// 0 = one tier (LOG_MOUNT_POINT)
+// 1 = the writer copies the oldest closed segment and its index to the card, as stored
+//     (still encrypted), LOG_TIER_COPY_BYTES per upkeep step, then deletes the flash copy.
+//     Reads find each segment in its tier. While the card is missing or fails, segments
+//     stay in flash and the move is retried every LOG_TIER_RETRY_MS.
+#ifndef LOG_TIER_SD
+#define LOG_TIER_SD 0
+#endif
+
+#define LOG_TIER_MOUNT_POINT        "/sdcard"
+#define LOG_TIER_SEGMENT_PATH_FMT   LOG_TIER_MOUNT_POINT "/enc_log_%04lu.bin"
+#define LOG_TIER_INDEX_PATH_FMT     LOG_TIER_MOUNT_POINT "/enc_log_%04lu.idx"
+
+// One read from flash and one sequential write to the card per upkeep step; whole SD
+// allocation units, from a 512B aligned buffer the SDMMC host DMAs from directly
+#ifndef LOG_TIER_COPY_BYTES
+#define LOG_TIER_COPY_BYTES     LOG_SDMMC_AU_BYTES
+#endif
+#ifndef LOG_TIER_RETRY_MS
+#define LOG_TIER_RETRY_MS       10000
+#endif
+
+#if LOG_TIER_SD && (!LOG_ROTATE || LOG_STORAGE_SDMMC)
+#error "LOG_TIER_SD needs LOG_ROTATE with segments in internal flash (LOG_STORAGE_SDMMC 0)"
+#endif
+#if LOG_TIER_SD && (LOG_TIER_COPY_BYTES % 512) != 0
+#error "LOG_TIER_COPY_BYTES must be a multiple of the 512B sector"
+#endif
+
+// Mirrored tier (LOG_TIER_SD): the open segment is replicated to the card as well, not
+// only closed ones. Once LOG_TIER_COPY_BYTES past the card copy are durable in flash
+// (synced), an upkeep step appends them to the card copy and syncs it, so commit latency
+// stays that of the internal flash and the card trails by less than one batch plus the
+// unsynced tail. The card copy's synced size is the replication checkpoint: after a reset
+// or a card swap-in the copy resumes from it. At rotation only the tail is left to copy
+// before the flash copy goes. Lag and checkpoint are in 's' and 'j'.
+// 0 = a segment is copied once it is closed.
+#ifndef LOG_TIER_REPLICATE
+#define LOG_TIER_REPLICATE 0
+#endif
+
+#if LOG_TIER_REPLICATE && (!LOG_TIER_SD || LOG_SEGMENT_BYTES > 0)
+#error "LOG_TIER_REPLICATE needs LOG_TIER_SD and growing segment files (LOG_SEGMENT_BYTES 0)"
+#endif
+
+// Sparse index (FATFS store): a sidecar file next to each log file with one entry
+// every LOG_INDEX_EVERY records and one for the first record of a file, so a reader
+// can binary-search a seq or time and seek straight to it (0 = no index)
+#ifndef LOG_INDEX_EVERY
+#define LOG_INDEX_EVERY         32
+#endif
+
+#define LOG_INDEX_PATH          LOG_MOUNT_POINT "/enc_log.idx"
+#define LOG_INDEX_PATH_FMT      LOG_MOUNT_POINT "/enc_log_%04lu.idx"
+
+// Index entry format (24B, all LE):
+// record seq (4B) | uptime ms (4B) | file offset of the record or block group (4B) |
+// file offset of the epoch header it is encrypted under (hybrid mode), else of the format
+// header it is written in (4B, INDEX_NO_EPOCH if none) | wall clock base: Unix ms at uptime 0 of the boot (8B, 0 = not set)
+// The record's wall time is base + uptime, so time queries need no decryption.
+#define INDEX_ENTRY_BYTES       24
+#define INDEX_NO_EPOCH          0xFFFFFFFFu
+
+// Zone maps (LOG_ROTATE): each sealed segment gets a summary of its records in a
+// plaintext slot of LOG_ZONE_PATH: seq range, uptime and wall time range, record count,
+// the kinds of record it holds and the value range of each channel (aggregate and raw
+// records, log_agg.h). Queries skip a segment whose summary rules out a match without
+// decrypting it. A segment reopened after a reboot has no complete summary and is
+// always scanned. The summaries tell ranges, not values: leave this at 0 where even
+// ranges must stay encrypted.
+#ifndef LOG_ZONE_MAP
+#define LOG_ZONE_MAP 0
+#endif
+#ifndef LOG_ZONE_CHANNELS
+#define LOG_ZONE_CHANNELS       8
+#endif
+
+// Bloom filter per zone over the values of LOG_ZONE_BLOOM_KEYS in JSON records (e.g.
+// "code":"E42" or "src":7), so a search for one value decrypts only the segments that
+// may hold it (0 = no filter). About 10 bits per distinct value in a segment keep false
+// candidates near 1%.
+#ifndef LOG_ZONE_BLOOM_BITS
+#define LOG_ZONE_BLOOM_BITS     512
+#endif
+#ifndef LOG_ZONE_BLOOM_HASHES
+#define LOG_ZONE_BLOOM_HASHES   3
+#endif
+#ifndef LOG_ZONE_BLOOM_KEYS
+#define LOG_ZONE_BLOOM_KEYS     "code", "src"
+#endif
+
+#define LOG_ZONE_PATH           LOG_MOUNT_POINT "/enc_log.zon"
+
+// Zone slot format (one per live segment, at (id % LOG_RETAIN_SEGMENTS) * ZONE_SLOT_BYTES,
+// all LE): magic "ELZM" (4B) | segment id (4B) | first seq (4B) | last seq (4B) |
+// records (4B) | record kinds (4B, LOG_ZONE_KIND_*) | min uptime ms (4B) |
+// max uptime ms (4B) | min wall ms (8B) | max wall ms (8B, 0 = no record with a set clock) |
+// channels with a value (4B, bit per channel) | min, max per channel (8B each) |
+// Bloom filter (LOG_ZONE_BLOOM_BITS / 8 B) | CRC32 of the slot before it (4B)
+#define ZONE_SLOT_MAGIC         "ELZM"
+#define ZONE_SLOT_BYTES         (52 + 8 * LOG_ZONE_CHANNELS + LOG_ZONE_BLOOM_BITS / 8 + 4)
+
+#if LOG_ZONE_MAP && !LOG_ROTATE
+#error "LOG_ZONE_MAP needs LOG_ROTATE (summaries are per segment)"
+#endif
+#if LOG_ZONE_MAP && (LOG_ZONE_CHANNELS < 1 || LOG_ZONE_CHANNELS > 32)
+#error "LOG_ZONE_CHANNELS must be 1..32"
+#endif
+#if LOG_ZONE_BLOOM_BITS % 8 != 0 || (LOG_ZONE_BLOOM_BITS > 0 && LOG_ZONE_BLOOM_HASHES < 1)
+#error "LOG_ZONE_BLOOM_BITS must be a multiple of 8, with at least one hash"
+#endif
+
+// Retention: the oldest data goes whole, live data is never rewritten (0 = off)
+// LOG_RETAIN_BYTES: cap on live log data. With LOG_ROTATE the oldest segments are deleted
+//   before a new segment would take the log past it; the raw store erases its oldest
+//   sector once the live pages hold more (the erased sector also ends the boot scan).
+// LOG_RETAIN_AGE_S: with LOG_ROTATE, a closed segment whose newest indexed record is
+//   older than this (wall clock, log_time.h) is deleted at boot and at every rotation.
+//   Segments of boots without a set clock never expire by age.
+// With LOG_ROTATE the oldest segments are also deleted while the file system has no
+// room for the next segment, so a full store keeps appending at the same rate.
+#ifndef LOG_RETAIN_BYTES
+#define LOG_RETAIN_BYTES        0
+#endif
+#ifndef LOG_RETAIN_AGE_S
+#define LOG_RETAIN_AGE_S        0
+#endif
+
+#if LOG_RETAIN_BYTES > 0 && !LOG_ROTATE && !LOG_STORAGE_RAW
+#error "LOG_RETAIN_BYTES needs LOG_ROTATE (FATFS) or LOG_STORAGE_RAW"
+#endif
+#if LOG_RETAIN_AGE_S > 0 && (!LOG_ROTATE || LOG_INDEX_EVERY == 0)
+#error "LOG_RETAIN_AGE_S needs LOG_ROTATE and the sparse index (LOG_INDEX_EVERY)"
+#endif
+
+// Commit markers (FATFS store): every sync appends a marker to a sidecar journal
+// (enc_log.cmt next to enc_log.bin) covering the bytes written since the previous
+// one. At open only the newest markers and the bytes they cover are checked, and
+// an uncommitted or torn tail is cut off, so recovery time does not grow with the
+// log (0 = off)
+#ifndef LOG_COMMIT_MARKERS
+#define LOG_COMMIT_MARKERS      0
+#endif
+
+#define COMMIT_PATH_EXT         ".cmt"
+
+// Commit marker format (20B, all LE):
+// commit seq (4B) | data end file offset (4B) | bytes committed (4B) |
+// CRC32 of those bytes (4B) | CRC32 of the first 16 bytes (4B)
+#define COMMIT_ENTRY_BYTES      20
+#define COMMIT_SCAN_ENTRIES     4   // markers tried from the tail before giving up
+
+// Sync policy (fsync makes records durable; 0 disables a trigger)
+#ifndef LOG_SYNC_EVERY_RECORDS
+#define LOG_SYNC_EVERY_RECORDS  16
+#endif
+#ifndef LOG_SYNC_INTERVAL_MS
+#define LOG_SYNC_INTERVAL_MS    1000
+#endif
+
+// --------------------
+// Console
+// --------------------
+#define LOG_UART_NUM      UART_NUM_0
+#define LOG_UART_BAUD     115200
+
+// Console transport (log_console.h): the commands, query output and the binary export
+// 0 = UART LOG_UART_NUM at LOG_UART_BAUD, the export may switch up to LOG_EXPORT_MAX_BAUD
+// 1 = USB-Serial-JTAG (ESP32-S3/C3/C6/H2): full-speed USB, no baud rate, the export runs
+//     at the USB rate with the same frames. Set CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG so
+//     ESP_LOG output goes the same way (it is routed through the driver)
+#ifndef LOG_CONSOLE_USB
+#define LOG_CONSOLE_USB 0
+#endif
+#define LOG_CONSOLE_USB_TX_TIMEOUT_MS 1000  // USB: a host that stops reading loses the rest
+
+// The console waits on the UART driver's event queue: a command runs as soon as its
+// byte arrives and nothing wakes while idle. Arguments follow the command letter on
+// the same line ("b 500"), the rest of the line may trail by LOG_CONSOLE_ARG_MS.
+#define LOG_CONSOLE_RX_BUF_BYTES 1024       // UART / USB-Serial-JTAG driver RX ring buffer
+#define LOG_CONSOLE_EVENT_QUEUE  16         // UART driver events (data, overflow)
+#ifndef LOG_CONSOLE_ARG_MS
+#define LOG_CONSOLE_ARG_MS       50
+#endif
+
+// Binary export (console 'x', host side: tools/enc_log_export.py)
+#define LOG_EXPORT_CHUNK_BYTES  1024        // payload bytes per data frame
+#define LOG_EXPORT_MAX_BAUD     2000000     // highest baud a host may request
+#define LOG_EXPORT_TX_BUF_BYTES 4096        // UART / USB-Serial-JTAG driver TX ring buffer
+#define LOG_EXPORT_REQ_TIMEOUT_MS 2000      // wait for the request after 'x'
+#define LOG_EXPORT_SWITCH_MS    50          // settle time after a baud change
+
+// HTTP upload (console 'v', host side: tools/enc_log_upload_server.py)
+// 1 = stream the encrypted log bytes to LOG_UPLOAD_URL as chunked POSTs, straight from
+//     the store (flash mapping on the raw store), resuming where the server left off.
+//     The application must bring up a network interface (Wi-Fi/Ethernet). 0 = off
+#ifndef LOG_UPLOAD
+#define LOG_UPLOAD 0
+#endif
+
+#ifndef LOG_UPLOAD_URL
+#define LOG_UPLOAD_URL          "http://192.168.4.2:8070/enc_log"
+#endif
+
+#define LOG_UPLOAD_CHUNK_BYTES  4096        // HTTP chunk at most (one flash view)
+#define LOG_UPLOAD_POST_BYTES   (64 * 1024) // body per POST; the server commits each one
+#define LOG_UPLOAD_TIMEOUT_MS   10000
+#define LOG_UPLOAD_RETRIES      3           // failed POSTs in a row before giving up
+
+// Replication over ESP-NOW (console '8', log_repl.h)
+// 1 = ship sealed segments (LOG_ROTATE), as stored and still encrypted, to a gateway
+//     ESP32 in radio range, in windowed bursts of ESP-NOW frames. The gateway runs the
+//     same firmware ('8 g'), keeps the segments per device under LOG_REPL_DIR and tells
+//     each device the first segment it lacks, so a walk-by resumes where the last one
+//     ended. No IP network and no access point needed. 0 = off
+#ifndef LOG_REPL
+#define LOG_REPL 0
+#endif
+
+#ifndef LOG_REPL_CHANNEL
+#define LOG_REPL_CHANNEL        1           // Wi-Fi channel of both ends
+#endif
+#define LOG_REPL_WINDOW         16          // data frames sent ahead of the last ack
+#define LOG_REPL_ACK_MS         150         // no ack by then: resend from the acked offset
+#define LOG_REPL_RETRIES        8           // timeouts in a row before the device gives up
+#define LOG_REPL_HELLO_MS       200         // device: hello broadcast period ...
+#define LOG_REPL_DISCOVER_MS    5000        // ... until a gateway answers
+#define LOG_REPL_IDLE_MS        3000        // gateway: a session without frames ends
+#define LOG_REPL_GATEWAY_S      600         // gateway: default listen time, 0 = until reset
+#define LOG_REPL_DIR            LOG_MOUNT_POINT "/repl"
+
+#if LOG_REPL && !LOG_ROTATE
+#error "LOG_REPL needs LOG_ROTATE: it ships sealed segments"
+#endif
+
+// OPTIGA protected update (console '5', host side: tools/optiga_update_pack.py)
+// 1 = apply a protected update data set (manifest and fragments from
+//     examples/tools/protected_update_data_set) read in place from the
+//     LOG_UPDATE_PARTITION partition through a flash mapping, without a RAM copy. With a
+//     download, each fragment goes to OPTIGA as soon as it has landed in the partition
+//     while the rest is still coming in. Needs a network interface for the download
+//     (see LOG_UPLOAD). 0 = off
+#ifndef LOG_UPDATE
+#define LOG_UPDATE 0
+#endif
+
+#ifndef LOG_UPDATE_URL
+#define LOG_UPDATE_URL          "http://192.168.4.2:8070/optiga_update.bin"
+#endif
+
+#define LOG_UPDATE_PARTITION    "optiga_upd"    // data partition, subtype 0x40 (partitions.csv)
+#define LOG_UPDATE_CHUNK_BYTES  1024            // HTTP read and flash write unit
+#define LOG_UPDATE_TIMEOUT_MS   10000           // HTTP, and wait for the next fragment
+
+// Deep sleep (console 'z'): the log is synced and OPTIGA hibernated first; the timer
+// wake restores the OPTIGA application and appends one record
+#define LOG_DEEP_SLEEP_MS       10000
+
+// Deep-sleep logger (after 'z'; a reset other than a timer wake ends the cycle)
+// 0 = a timer wake appends one record and stays up with the console (default)
+// 1 = a timer wake encodes one reading into RTC memory (log_sleep.h) and sleeps again
+//     without mounting storage or waking OPTIGA. Every LOG_SLEEP_FLUSH_WAKES-th wake,
+//     or when the next reading might not fit, restores OPTIGA from its hibernate
+//     context, encrypts the staged readings in one go (block groups in batch mode),
+//     syncs and sleeps again. A staged reading's uptime_ms is RTC time since power-on,
+//     which keeps counting through deep sleep
+#ifndef LOG_SLEEP_STAGE
+#define LOG_SLEEP_STAGE 0
+#endif
+
+#ifndef LOG_SLEEP_FLUSH_WAKES
+#define LOG_SLEEP_FLUSH_WAKES   16
+#endif
+#define LOG_SLEEP_STAGE_BYTES   2048        // of the 8 KB RTC slow memory
+
+#if LOG_SLEEP_STAGE_BYTES > 65535
+#error "LOG_SLEEP_STAGE_BYTES too large for the staging header"
+#endif
+
+// --------------------
+// Record format
+// --------------------
+#define AES_IV_BYTES      16
+#define AES_BLOCK_BYTES   16
+#define PLAINTEXT_MAX     64    // multiple of AES_BLOCK_BYTES
+
+// 0 = every record is zero-padded to PLAINTEXT_MAX (80B records, Part 3 format)
+// 1 = variable-length records, padded to the next AES block:
+//     magic 'R' (1B) | plaintext bytes (1B) | IV (16B) | ciphertext (16/32/48/64B,
+//     up to 80B with LOG_RECORD_CRC)
+//     The reader takes the ciphertext length and the plaintext length from the header.
+#ifndef LOG_RECORD_VARLEN
+#define LOG_RECORD_VARLEN 0
+#endif
+
+#define RECORD_VARLEN_MAGIC     'R'
+
+// 1 = plaintext checksum: the writer puts the CRC-32 (ESP32 ROM esp_rom_crc32_le, LE) of
+//     each record's or block group's plaintext in its last 4 plaintext bytes, behind
+//     the zero padding, and readers drop a unit whose checksum does not match right
+//     after decrypting it (wrong key, corrupted or misaligned ciphertext) instead of
+//     parsing garbage. Needs LOG_RECORD_VARLEN: the 64B Part 3 records have no room.
+//     Costs up to one AES block per unit when the checksum does not fit the padding.
+#ifndef LOG_RECORD_CRC
+#define LOG_RECORD_CRC 0
+#endif
+
+#define LOG_CRC_BYTES           4
+#define RECORD_CRC_BYTES        (LOG_RECORD_CRC ? LOG_CRC_BYTES : 0)
+
+#if LOG_RECORD_VARLEN
+#define RECORD_HDR_BYTES        2
+// Plaintext bytes after padding, checksum included (at least one block; no padding in
+// packed CTR mode or with AES-GCM)
+#define RECORD_PT_BYTES(len) \
+    (LOG_CTR_MODE == LOG_CTR_PACKED || LOG_RECORD_GCM ? (len) + RECORD_CRC_BYTES :           \
+     (len) + RECORD_CRC_BYTES == 0 ? AES_BLOCK_BYTES :                                       \
+     (((len) + RECORD_CRC_BYTES + AES_BLOCK_BYTES - 1) / AES_BLOCK_BYTES) * AES_BLOCK_BYTES)
+#else
+#define RECORD_HDR_BYTES        0
+#define RECORD_PT_BYTES(len)    PLAINTEXT_MAX
+#endif
+
+// Bytes between the record header and the ciphertext: the IV, or nonce and tag (AES-GCM)
+#define RECORD_IV_BYTES         (LOG_RECORD_GCM ? GCM_NONCE_BYTES + GCM_TAG_BYTES : AES_IV_BYTES)
+
+#define RECORD_MAX_BYTES        (RECORD_HDR_BYTES + RECORD_IV_BYTES + RECORD_PT_BYTES(PLAINTEXT_MAX))
+
+// Record payload produced by the sample producer (main.c)
+// 0 = JSON text {"seq":..,"uptime_ms":..} (Part 3 format)
+// 1 = schema id (1B) | CBOR map {RECORD_KEY_SEQ: seq, RECORD_KEY_UPTIME_MS: uptime ms}
+//     (log_cbor.h). JSON records start with '{', so the first byte tells them apart.
+//     Pair with LOG_RECORD_VARLEN, otherwise records are still padded to 64B.
+#ifndef LOG_RECORD_CBOR
+#define LOG_RECORD_CBOR 0
+#endif
+
+#define RECORD_SCHEMA_SAMPLE    0x01    // seq + uptime sample record
+#define RECORD_SCHEMA_AGG       0x02    // channel window min/max/mean/count (log_agg.h, packed only)
+#define RECORD_SCHEMA_RAW       0x03    // channel sample around an event (log_agg.h, packed only)
+#define RECORD_KEY_SEQ          1
+#define RECORD_KEY_UPTIME_MS    2
+
+// 1 = packed record of a compile-time schema (log_schema.h): schema id (0x80 | id, 1B)
+//     | fields at fixed offsets, little-endian. The sample is 13 bytes (seq u32,
+//     uptime_ms u64), written and read without any formatting or map parsing.
+//     Like CBOR, pair with LOG_RECORD_VARLEN to store one AES block per record.
+#ifndef LOG_RECORD_PACKED
+#define LOG_RECORD_PACKED 0
+#endif
+
+#if LOG_RECORD_PACKED && LOG_RECORD_CBOR
+#error "LOG_RECORD_PACKED and LOG_RECORD_CBOR are exclusive"
+#endif
+
+// 1 = aggregation stage (log_agg.h) for high-rate channels: producers feed samples with
+//     log_agg_sample() and only a min/max/mean/count record per channel and window
+//     (LOG_AGG_WINDOW_MS by default) reaches the writer. A sample outside the channel's
+//     thresholds also passes LOG_AGG_PRE_SAMPLES kept samples before it, itself (as a
+//     priority record) and the next LOG_AGG_POST_SAMPLES samples through raw. Both are
+//     packed records (RECORD_SCHEMA_AGG/RAW), whatever LOG_RECORD_FORMAT is.
+#ifndef LOG_AGG_MODE
+#define LOG_AGG_MODE 0
+#endif
+#ifndef LOG_AGG_CHANNELS
+#define LOG_AGG_CHANNELS 8
+#endif
+#ifndef LOG_AGG_WINDOW_MS
+#define LOG_AGG_WINDOW_MS 1000
+#endif
+#ifndef LOG_AGG_PRE_SAMPLES
+#define LOG_AGG_PRE_SAMPLES 8
+#endif
+#ifndef LOG_AGG_POST_SAMPLES
+#define LOG_AGG_POST_SAMPLES 32
+#endif
+
+#if LOG_AGG_MODE && (LOG_AGG_CHANNELS < 1 || LOG_AGG_CHANNELS > 256)
+#error "LOG_AGG_CHANNELS must be 1..256 (u8 channel field)"
+#endif
+#if LOG_AGG_MODE && LOG_AGG_PRE_SAMPLES < 1
+#error "LOG_AGG_PRE_SAMPLES must be at least 1"
+#endif
+
+// Sample record format (log_record.h)
+#define RECORD_FORMAT_JSON      0
+#define RECORD_FORMAT_CBOR      1
+#define RECORD_FORMAT_PACKED    2
+#define LOG_RECORD_FORMAT \
+    (LOG_RECORD_PACKED ? RECORD_FORMAT_PACKED : LOG_RECORD_CBOR ? RECORD_FORMAT_CBOR : RECORD_FORMAT_JSON)
+
+// 0 = one IV + one encrypt command per record (80B records, Part 3 format)
+// 1 = queue records in RAM and encrypt them as one CBC block group
+#ifndef LOG_BATCH_MODE
+#ifdef CONFIG_ENC_LOG_ENCRYPT_BATCH
+#define LOG_BATCH_MODE 1
+#else
+#define LOG_BATCH_MODE 0
+#endif
+#endif
+
+// Records per block group (batch mode only)
+#ifndef LOG_BATCH_RECORDS
+#define LOG_BATCH_RECORDS 8
+#endif
+
+// Longest a queued record waits for its block group to fill (batch mode, 0 = until
+// full or flushed). Appended records are then synced within LOG_SYNC_INTERVAL_MS, so
+// a normal record is durable within the sum of the two (plus OPTIGA time).
+// Priority records (enc_log_submit(..., true)) flush the group and sync at once.
+#ifndef LOG_BATCH_MAX_LATENCY_MS
+#define LOG_BATCH_MAX_LATENCY_MS 0
+#endif
+
+// Deadline instead of LOG_BATCH_MAX_LATENCY_MS while the OPTIGA command governor
+// (CONFIG_OPTIGA_TRUST_M_SEC_GOVERNOR) holds key commands back: groups fill up and go
+// out as fewer encrypt commands rather than part empty into the governor's queue
+#ifndef LOG_BATCH_PACED_LATENCY_MS
+#define LOG_BATCH_PACED_LATENCY_MS (4 * LOG_BATCH_MAX_LATENCY_MS)
+#endif
+
+#if LOG_BATCH_MAX_LATENCY_MS > 0 && !LOG_BATCH_MODE
+#error "LOG_BATCH_MAX_LATENCY_MS needs LOG_BATCH_MODE"
+#endif
+#if LOG_BATCH_MAX_LATENCY_MS > 0 && LOG_BATCH_PACED_LATENCY_MS < LOG_BATCH_MAX_LATENCY_MS
+#error "LOG_BATCH_PACED_LATENCY_MS must be at least LOG_BATCH_MAX_LATENCY_MS"
+#endif
+
+// Self-tuning block groups (batch mode only, log_tune.h)
+// 0 = groups of LOG_BATCH_RECORDS, deadline LOG_BATCH_MAX_LATENCY_MS (default)
+// 1 = the writer fits the cost of a group (encrypt and append: fixed + per record) and
+//     of a sync from the last LOG_TUNE_WINDOW groups, measures the ingest rate, and
+//     after every group picks the group size (1..LOG_BATCH_RECORDS) and deadline with
+//     the highest throughput whose predicted submit to durable time, queueing behind
+//     earlier groups included, stays within LOG_BATCH_DURABLE_MS. Each group is synced
+//     as it is appended. LOG_BATCH_MAX_LATENCY_MS is the deadline until the first fit.
+#ifndef LOG_BATCH_AUTOTUNE
+#define LOG_BATCH_AUTOTUNE 0
+#endif
+#ifndef LOG_BATCH_DURABLE_MS
+#define LOG_BATCH_DURABLE_MS    2000
+#endif
+#ifndef LOG_TUNE_WINDOW
+#define LOG_TUNE_WINDOW         16      // groups, exponential forgetting
+#endif
+#ifndef LOG_TUNE_RATE_MS
+#define LOG_TUNE_RATE_MS        500     // shortest interval of an ingest rate sample
+#endif
+#if LOG_BATCH_AUTOTUNE && (!LOG_BATCH_MODE || LOG_BATCH_MAX_LATENCY_MS == 0)
+#error "LOG_BATCH_AUTOTUNE needs LOG_BATCH_MODE and a starting LOG_BATCH_MAX_LATENCY_MS"
+#endif
+#if LOG_BATCH_AUTOTUNE && LOG_BATCH_MAX_LATENCY_MS > LOG_BATCH_DURABLE_MS
+#error "LOG_BATCH_MAX_LATENCY_MS above LOG_BATCH_DURABLE_MS"
+#endif
+#if LOG_BATCH_AUTOTUNE && LOG_TUNE_WINDOW < 2
+#error "LOG_TUNE_WINDOW must be at least 2 groups"
+#endif
+
+// Block group pipeline (batch mode only)
+// 0 = off (default), the writer encrypts a group, then appends it
+// 1 = two stages: the writer encrypts group N while the enc_log_st task appends group
+//     N-1. The two group buffers are handed over by pointer, so the steady-state rate
+//     is set by the slower of OPTIGA and storage instead of their sum. Costs one more
+//     group buffer and the task stack. A sync or a priority record waits for the
+//     storage stage before the store is synced
+#ifndef LOG_BATCH_PIPELINE
+#define LOG_BATCH_PIPELINE 0
+#endif
+
+#define LOG_STORE_STACK_BYTES   4096
+// Equal to the writer by default, so neither stage starves the other
+#ifndef LOG_STORE_PRIORITY
+#define LOG_STORE_PRIORITY      LOG_WRITER_PRIORITY
+#endif
+#ifndef LOG_STORE_CORE
+#define LOG_STORE_CORE          LOG_WRITER_CORE
+#endif
+
+#if LOG_BATCH_PIPELINE && !LOG_BATCH_MODE
+#error "LOG_BATCH_PIPELINE needs LOG_BATCH_MODE"
+#endif
+// The tuner times encrypt and append of a group together and syncs after each one
+#if LOG_BATCH_PIPELINE && LOG_BATCH_AUTOTUNE
+#error "LOG_BATCH_PIPELINE cannot be combined with LOG_BATCH_AUTOTUNE"
+#endif
+
+// Record IV source (per-record and hybrid modes; batch mode uses one TRNG IV per group)
+// 0 = random IV per record (OPTIGA TRNG, or host RNG in hybrid mode)
+// 1 = IV = AES-ECB(nonce (8B) || counter (8B)) with the record key; one TRNG nonce
+//     per boot/clear (per key epoch in hybrid mode)
+#ifndef LOG_IV_MODE
+#ifdef CONFIG_ENC_LOG_IV_COUNTER
+#define LOG_IV_MODE 1
+#else
+#define LOG_IV_MODE 0
+#endif
+#endif
+
+// IVs derived per OPTIGA ECB command (LOG_IV_MODE 1, OPTIGA encryption only)
+#define LOG_IV_BATCH      8
+#define IV_NONCE_BYTES    8
+
+// Per-record cipher (LOG_BATCH_MODE 0, OPTIGA encryption)
+// 0 = AES-CBC, one OPTIGA request per record (default)
+// 1 = AES-CTR from a keystream cache: the writer computes keystream blocks
+//     AES-ECB(nonce (8B) || counter (8B, big endian)) ahead, one OPTIGA ECB command of
+//     up to LOG_CTR_REFILL_BLOCKS per idle pass, and a record is XORed with the next
+//     cached blocks. The record keeps its format; where the IV goes it holds the counter
+//     block of its first keystream block. A counter is used once: one TRNG nonce per
+//     boot, the counter only moves forward, and a record that finds too few blocks
+//     cached (burst longer than the cache) computes them on the spot
+// 2 = as 1, packed (needs LOG_RECORD_VARLEN): records take the keystream byte by byte,
+//     so the ciphertext is exactly as long as the plaintext and the next record goes on
+//     in the same keystream block. Where the IV goes a record holds nonce (8B) ||
+//     keystream byte position (8B, big endian) of its first byte: the counter of that
+//     block times 16 plus the bytes of it used before. Empty records are not accepted
+#define LOG_CTR_PACKED 2
+#ifndef LOG_CTR_MODE
+#define LOG_CTR_MODE 0
+#endif
+
+#define LOG_CTR_CACHE_BLOCKS    256     // 4 KB: 64 full or 256 one-block records
+#define LOG_CTR_REFILL_BLOCKS   40      // 640 bytes, one APDU per ECB command
+
+#if LOG_CTR_CACHE_BLOCKS < PLAINTEXT_MAX / AES_BLOCK_BYTES
+#error "LOG_CTR_CACHE_BLOCKS must hold the keystream of one record"
+#endif
+
+// Keystream XOR of the CTR writer and reader (log_simd.h)
+// 1 = on ESP32-S3, 128-bit PIE vector kernels, checked against the scalar ones on first
+//     use; other targets and the host tools keep the scalar kernels (default)
+// 0 = scalar kernels, 32-bit words where the buffers allow
+#ifndef LOG_SIMD
+#define LOG_SIMD 1
+#endif
+
+// Block group format:
+// magic (2B) | record count (1B) | reserved (1B) | IV (16B) | ciphertext (count * 64B)
+// With LOG_RECORD_VARLEN the magic is "BV", the reserved byte holds the ciphertext
+// length in AES blocks, and the plaintext is a sequence of length (1B) | record
+// entries, zero-padded to the block size.
+#define BLOCK_GROUP_MAGIC0      'B'
+#define BLOCK_GROUP_MAGIC1      'G'
+#define BLOCK_GROUP_MAGIC1_VAR  'V'
+#define BLOCK_GROUP_HDR_BYTES   (4 + AES_IV_BYTES)
+
+// Plaintext bytes of a variable-length, compressed or delta group with len bytes of
+// content: zero-padded to the AES block size, checksum (LOG_RECORD_CRC) at the end
+#define GROUP_PT_BYTES(len) \
+    ((((len) + RECORD_CRC_BYTES + AES_BLOCK_BYTES - 1) / AES_BLOCK_BYTES) * AES_BLOCK_BYTES)
+
+#if LOG_RECORD_VARLEN
+#define BATCH_PT_MAX_BYTES      GROUP_PT_BYTES(LOG_BATCH_RECORDS * (1 + PLAINTEXT_MAX))
+#else
+#define BATCH_PT_MAX_BYTES      (LOG_BATCH_RECORDS * PLAINTEXT_MAX)
+#endif
+
+#if BATCH_PT_MAX_BYTES / AES_BLOCK_BYTES > 255
+#error "LOG_BATCH_RECORDS too large for the block group header"
+#endif
+
+// Block group integrity (batch mode only)
+// 0 = no MAC (default)
+// 1 = one OPTIGA HMAC-SHA256 per block group, chained to the previous group's tag:
+//     tag = HMAC(secret, previous tag || group header || ciphertext), appended to the
+//     group. The magic starts with 'M' instead of 'B'. The chain starts from 32 zero
+//     bytes after a clear and continues from the last tag in the log after a reboot
+// 2 = encrypt-then-MAC with OPTIGA AES-CMAC under the log key (LOG_KEY_OID): same chain
+//     and layout, tag = CMAC(key, previous tag || group header || ciphertext) truncated
+//     to LOG_CMAC_TAG_BYTES. The magic starts with 'C'. No secret object to provision,
+//     and the MAC is a start/continue/final sequence of AES blocks instead of a SHA pass
+#ifndef LOG_INTEGRITY_MODE
+#define LOG_INTEGRITY_MODE 0
+#endif
+
+// Data object holding the HMAC secret (provisioned on first boot, type PRESSEC)
+#define LOG_MAC_SECRET_OID      0xF1D1
+#define LOG_MAC_SECRET_BYTES    32
+#define BLOCK_GROUP_MAGIC0_MAC  'M'
+
+// Stored CMAC tag bytes (truncated from the 16-byte AES-CMAC, NIST SP 800-38B allows
+// down to 8 for this rate of groups)
+#ifndef LOG_CMAC_TAG_BYTES
+#define LOG_CMAC_TAG_BYTES      8
+#endif
+#define BLOCK_GROUP_MAGIC0_CMAC 'C'
+
+// Tag appended to each group and chained into the next one
+#if LOG_INTEGRITY_MODE == 2
+#define LOG_MAC_TAG_BYTES       LOG_CMAC_TAG_BYTES
+#else
+#define LOG_MAC_TAG_BYTES       32
+#endif
+
+#if LOG_INTEGRITY_MODE && !LOG_BATCH_MODE
+#error "LOG_INTEGRITY_MODE needs LOG_BATCH_MODE"
+#endif
+#if LOG_INTEGRITY_MODE > 2
+#error "LOG_INTEGRITY_MODE must be 0, 1 or 2"
+#endif
+#if LOG_CMAC_TAG_BYTES < 8 || LOG_CMAC_TAG_BYTES > AES_BLOCK_BYTES
+#error "LOG_CMAC_TAG_BYTES must be 8..16"
+#endif
+
+// Block group compression (batch mode only)
+// 0 = off (default), block groups as above
+// 1 = the group plaintext is LZ4-compressed (log_lz.h) before encryption. A compressed
+//     group has magic1 'Z', the ciphertext length in AES blocks in the reserved byte and
+//     the compressed length (2B LE) in front of the IV; the plaintext inside is the
+//     same record layout as an uncompressed group. A group that would not save at
+//     least one AES block is written uncompressed.
+#ifndef LOG_BATCH_COMPRESS
+#define LOG_BATCH_COMPRESS 0
+#endif
+
+// Compressor hash table: 2^bits 16-bit entries (8 bits = 512 B)
+#ifndef LOG_LZ_HASH_BITS
+#define LOG_LZ_HASH_BITS 8
+#endif
+
+#define BLOCK_GROUP_MAGIC1_LZ   'Z'
+#define BLOCK_GROUP_LZ_HDR_BYTES (BLOCK_GROUP_HDR_BYTES + 2)
+
+#if LOG_BATCH_COMPRESS
+#define BLOCK_GROUP_MAX_HDR_BYTES BLOCK_GROUP_LZ_HDR_BYTES
+#else
+#define BLOCK_GROUP_MAX_HDR_BYTES BLOCK_GROUP_HDR_BYTES
+#endif
+
+#if LOG_BATCH_COMPRESS && !LOG_BATCH_MODE
+#error "LOG_BATCH_COMPRESS needs LOG_BATCH_MODE"
+#endif
+#if LOG_LZ_HASH_BITS < 4 || LOG_LZ_HASH_BITS > 12
+#error "LOG_LZ_HASH_BITS must be 4..12"
+#endif
+
+// Block group delta encoding (batch mode only, sample records)
+// 0 = off (default)
+// 1 = a group of sample records (log_record.h) is stored as the first record's seq
+//     and uptime plus zig-zag varint deltas to the previous record (log_delta.h),
+//     typically 3 bytes per record instead of 11 (CBOR) or ~35 (JSON)
+// 2 = as 1, but columnar: all seq deltas, then all uptime deltas
+// A delta group has magic1 'D' and the ciphertext length in AES blocks in the reserved
+// byte. The reader rebuilds the records byte for byte, so a group is only delta
+// encoded if every record is exactly what log_record_encode() writes; otherwise (or
+// if it would not save an AES block) it falls back to LZ4 or the plain layout.
+#ifndef LOG_BATCH_DELTA
+#define LOG_BATCH_DELTA 0
+#endif
+
+#define BLOCK_GROUP_MAGIC1_DELTA 'D'
+
+#if LOG_BATCH_DELTA && !LOG_BATCH_MODE
+#error "LOG_BATCH_DELTA needs LOG_BATCH_MODE"
+#endif
+#if LOG_BATCH_DELTA < 0 || LOG_BATCH_DELTA > 2
+#error "LOG_BATCH_DELTA must be 0, 1 or 2"
+#endif
+
+// --------------------
+// Merkle tree (single-record proofs)
+// --------------------
+// 0 = no tree (default)
+// 1 = every append (record, or block group in batch mode) is a leaf of an RFC 6962
+//     Merkle tree hashed on the ESP32; each window of LOG_MERKLE_LEAVES leaves (or
+//     fewer at a sync) is closed by a root record signed with OPTIGA ECDSA. Needs
+//     the full OPTIGA profile (no ECC in the encrypted logger profile)
+#ifndef LOG_MERKLE_MODE
+#define LOG_MERKLE_MODE 0
+#endif
+
+// Leaves per signed root (power of two, ~44 B RAM per leaf for each of the open and
+// the last signed window)
+#ifndef LOG_MERKLE_LEAVES
+#define LOG_MERKLE_LEAVES 64
+#endif
+
+// Signing key: the factory device key, its certificate (0xE0E0) lets an auditor verify
+#ifndef LOG_MERKLE_KEY_OID
+#define LOG_MERKLE_KEY_OID 0xE0F0
+#endif
+
+// Root record format (160B, two fixed records so the file stays 80B aligned):
+// magic "ENCLOGMR" (8B) | first seq (4B, LE) | leaves (2B, LE) | reserved (2B) |
+// root (32B) | signature length (1B) | signature (OPTIGA r/s DER, <= 72B) | zero.
+// The signature is over SHA-256 of the first 48 bytes
+#define MERKLE_ROOT_MAGIC       "ENCLOGMR"
+#define MERKLE_ROOT_MAGIC_BYTES 8
+#define MERKLE_ROOT_SIGNED_BYTES 48
+#define MERKLE_SIG_MAX_BYTES    72
+#define MERKLE_ROOT_BYTES       (2 * (AES_IV_BYTES + PLAINTEXT_MAX))
+
+#if (LOG_MERKLE_LEAVES & (LOG_MERKLE_LEAVES - 1)) != 0 || LOG_MERKLE_LEAVES > 1024
+#error "LOG_MERKLE_LEAVES must be a power of two up to 1024"
+#endif
+
+// The MAC chain moves on only with a written tag, and a root record closes the leaves
+// appended before it: both need the group written before the next one is made
+#if LOG_BATCH_PIPELINE && (LOG_INTEGRITY_MODE || LOG_MERKLE_MODE)
+#error "LOG_BATCH_PIPELINE cannot be combined with LOG_INTEGRITY_MODE or LOG_MERKLE_MODE"
+#endif
+
+// --------------------
+// Hybrid mode
+// --------------------
+// 0 = every record is encrypted by OPTIGA (default)
+// 1 = OPTIGA derives a short-lived data key (HKDF-SHA256) and the ESP32 AES engine
+//     encrypts the records; only the key epoch and its salt are written to the log
+#ifndef LOG_HYBRID_MODE
+#ifdef CONFIG_ENC_LOG_ENCRYPT_HYBRID
+#define LOG_HYBRID_MODE 1
+#else
+#define LOG_HYBRID_MODE 0
+#endif
+#endif
+
+// Data object holding the HKDF secret (provisioned on first boot, type PRESSEC)
+#define LOG_HYBRID_SECRET_OID   0xF1D0
+#define LOG_HYBRID_SECRET_BYTES 64
+
+// Records encrypted per data key before a new epoch starts (0 = only at boot, clear and,
+// with LOG_ROTATE, each new segment). The next key is derived ahead, at idle time.
+#ifndef LOG_KEY_ROTATE_RECORDS
+#define LOG_KEY_ROTATE_RECORDS 256
+#endif
+
+// Host cipher for the records of an epoch
+// 0 = AES-CBC, IV || ciphertext as OPTIGA writes them (default)
+// 1 = AES-GCM (ESP32 AES engine through mbedtls GCM): one pass encrypts and authenticates,
+//     no padding. Needs LOG_RECORD_VARLEN:
+//     magic 'R' (1B) | plaintext bytes (1B) | nonce (12B) | tag (16B) | ciphertext (0..64B)
+//     The nonce is the epoch id (4B, LE) || the record's number in the epoch (8B, BE), so
+//     it never repeats under a key. The tag also covers the first 16 bytes of the epoch
+//     header (magic, id, sequence ceiling) and the record header: a record moved to another
+//     epoch or with an altered length fails, and readers drop it unparsed.
+#define LOG_HYBRID_CBC 0
+#define LOG_HYBRID_GCM 1
+#ifndef LOG_HYBRID_CIPHER
+#define LOG_HYBRID_CIPHER LOG_HYBRID_CBC
+#endif
+
+#define LOG_RECORD_GCM          (LOG_HYBRID_MODE && LOG_HYBRID_CIPHER == LOG_HYBRID_GCM)
+#define GCM_NONCE_BYTES         12
+#define GCM_TAG_BYTES           16
+
+// Epoch header format (80B, same size as a fixed record so the file stays 80B aligned;
+// with LOG_RECORD_VARLEN the reader tells it apart from a record by its first byte):
+// magic "ENCLOGKE" (8B) | epoch id (4B, LE) | sequence ceiling (4B, LE, as in the segment
+// header, 0 unless LOG_SEQ_PERSIST 2) | salt (32B) | zero (32B)
+#define EPOCH_HDR_MAGIC         "ENCLOGKE"
+#define EPOCH_HDR_MAGIC_BYTES   8
+#define EPOCH_SALT_OFFSET       (EPOCH_HDR_MAGIC_BYTES + 8)
+#define EPOCH_SALT_BYTES        32
+// HKDF info for the data key (8B incl. the terminating zero)
+#define EPOCH_KEY_INFO          "enc_log"
+#define EPOCH_HDR_BYTES         (AES_IV_BYTES + PLAINTEXT_MAX)
+// Epoch header bytes in the AAD of every AES-GCM record of the epoch
+#define EPOCH_AAD_BYTES         (EPOCH_HDR_MAGIC_BYTES + 8)
+
+#if LOG_HYBRID_MODE && LOG_BATCH_MODE
+#error "LOG_HYBRID_MODE and LOG_BATCH_MODE cannot be combined"
+#endif
+#if LOG_CTR_MODE && (LOG_BATCH_MODE || LOG_HYBRID_MODE || LOG_IV_MODE)
+#error "LOG_CTR_MODE cannot be combined with LOG_BATCH_MODE, LOG_HYBRID_MODE or LOG_IV_MODE"
+#endif
+#if LOG_CTR_MODE == LOG_CTR_PACKED && !LOG_RECORD_VARLEN
+#error "LOG_CTR_MODE 2 needs LOG_RECORD_VARLEN: the header carries the ciphertext length"
+#endif
+#if LOG_HYBRID_CIPHER == LOG_HYBRID_GCM && !(LOG_HYBRID_MODE && LOG_RECORD_VARLEN)
+#error "LOG_HYBRID_CIPHER 1 needs LOG_HYBRID_MODE and LOG_RECORD_VARLEN"
+#endif
+#if LOG_RECORD_GCM && LOG_IV_MODE
+#error "LOG_HYBRID_CIPHER 1 cannot be combined with LOG_IV_MODE: GCM nonces are counters already"
+#endif
+#if LOG_RECORD_CRC && !LOG_RECORD_VARLEN
+#error "LOG_RECORD_CRC needs LOG_RECORD_VARLEN: fixed 64B records have no room for the checksum"
+#endif
+
+// --------------------
+// Format header
+// --------------------
+// Log data names its own layout, so an update that changes the record format never
+// rewrites the log: each file the writer starts (first file, segment, clear) opens with a
+// format header, and after a boot one is written ahead of the first unit unless the newest
+// header already matches the build. Data before a header stays in the layout it was
+// written in and is read in place. Readers take the layout from the last header they
+// passed (or the one the index entry names); data with no header before it (logs from
+// before format headers, version 0) is read as LOG_FORMAT_LEGACY_FLAGS.
+// 1 = format headers (default); 0 = headerless logs, read as the build's layout
+#ifndef LOG_FORMAT_HEADER
+#define LOG_FORMAT_HEADER 1
+#endif
+
+// Format header (80B, same size as a fixed record so the file stays 80B aligned):
+// magic "ENCLOGFV" (8B) | format version (2B, LE) | layout flags (4B, LE) |
+// record plaintext bytes (2B, LE, PLAINTEXT_MAX) | zero (64B)
+#define FORMAT_HDR_MAGIC        "ENCLOGFV"
+#define FORMAT_HDR_MAGIC_BYTES  8
+#define FORMAT_HDR_BYTES        (AES_IV_BYTES + PLAINTEXT_MAX)
+#define LOG_FORMAT_VERSION      1
+
+// Layout flags: what a reader must know to cut the data into units and decrypt them.
+// 0 is the Part 3 layout: fixed IV (16B) || CBC ciphertext (64B) records.
+#define LOG_FORMAT_VARLEN       0x0001u     // LOG_RECORD_VARLEN
+#define LOG_FORMAT_GROUPS       0x0002u     // LOG_BATCH_MODE block groups
+#define LOG_FORMAT_LZ           0x0004u     // compressed groups (LOG_BATCH_COMPRESS)
+#define LOG_FORMAT_DELTA        0x0008u     // delta groups (LOG_BATCH_DELTA)
+#define LOG_FORMAT_CTR          0x0010u     // LOG_CTR_MODE 1
+#define LOG_FORMAT_CTR_PACKED   0x0020u     // LOG_CTR_MODE 2
+#define LOG_FORMAT_HYBRID       0x0040u     // LOG_HYBRID_MODE epoch keys
+#define LOG_FORMAT_CRC          0x0080u     // LOG_RECORD_CRC plaintext checksums
+#define LOG_FORMAT_GCM          0x0100u     // LOG_HYBRID_CIPHER 1 AES-GCM records
+
+#define LOG_FORMAT_FLAGS                                                        \
+    ((LOG_RECORD_VARLEN ? LOG_FORMAT_VARLEN : 0) |                              \
+     (LOG_BATCH_MODE ? LOG_FORMAT_GROUPS : 0) |                                 \
+     (LOG_BATCH_COMPRESS ? LOG_FORMAT_LZ : 0) |                                 \
+     (LOG_BATCH_DELTA ? LOG_FORMAT_DELTA : 0) |                                 \
+     (LOG_CTR_MODE == LOG_CTR_PACKED ? LOG_FORMAT_CTR_PACKED :                  \
+      LOG_CTR_MODE ? LOG_FORMAT_CTR : 0) |                                      \
+     (LOG_HYBRID_MODE ? LOG_FORMAT_HYBRID : 0) |                                \
+     (LOG_RECORD_CRC ? LOG_FORMAT_CRC : 0) |                                    \
+     (LOG_RECORD_GCM ? LOG_FORMAT_GCM : 0))
+
+// Layout of data ahead of any format header. Set it to read a log written by an older
+// build with other record options, e.g. 0 for Part 3 records in a LOG_RECORD_VARLEN build.
+#ifndef LOG_FORMAT_LEGACY_FLAGS
+#define LOG_FORMAT_LEGACY_FLAGS LOG_FORMAT_FLAGS
+#endif
+
+// --------------------
+// Compaction
+// --------------------
+// Deadline and priority flushes leave many part-filled block groups, each with its own
+// header, IV and padding. With compaction a low-priority task (enc_log_cp) rewrites
+// closed segments whose groups are mostly small: runs of adjacent plain groups are
+// decrypted with one OPTIGA request, their records repacked into full groups (up to
+// LOG_BATCH_RECORDS each) and encrypted with one request per group, all from its own
+// OPTIGA instance at OPTIGA_CMD_PRIORITY_LOW so the writer's requests go first. The copy
+// and its index are written next to the segment and swapped in under the file lock; a
+// group an index entry points at starts a new group, so every entry carries over. Format
+// headers, compressed and delta groups are copied as they are. A swap waits while a
+// snapshot is open (the offsets behind the segment move), and a swap cut short by a reset
+// is finished or dropped at the next open.
+// 0 = off (default)
+// 1 = compact closed segments of the log (channel 0)
+#ifndef LOG_COMPACT
+#define LOG_COMPACT 0
+#endif
+
+// A segment is compacted when it holds at least LOG_COMPACT_MIN_GROUPS plain groups that
+// are on average at most LOG_COMPACT_FILL_PCT % full
+#ifndef LOG_COMPACT_MIN_GROUPS
+#define LOG_COMPACT_MIN_GROUPS  8
+#endif
+#ifndef LOG_COMPACT_FILL_PCT
+#define LOG_COMPACT_FILL_PCT    50
+#endif
+// How often the task looks for newly closed segments
+#ifndef LOG_COMPACT_POLL_MS
+#define LOG_COMPACT_POLL_MS     30000
+#endif
+#define LOG_COMPACT_STACK_BYTES 4096
+// Below the writer (LOG_WRITER_PRIORITY): it only runs while the writer waits
+#ifndef LOG_COMPACT_PRIORITY
+#define LOG_COMPACT_PRIORITY    1
+#endif
+
+#define LOG_COMPACT_SEGMENT_PATH_FMT    LOG_MOUNT_POINT "/enc_log_%04lu.cmp"
+#define LOG_COMPACT_INDEX_PATH_FMT      LOG_MOUNT_POINT "/enc_log_%04lu.cix"
+
+#if LOG_COMPACT && (!LOG_BATCH_MODE || !LOG_ROTATE || LOG_INDEX_EVERY == 0)
+#error "LOG_COMPACT needs LOG_BATCH_MODE and LOG_ROTATE with the sparse index"
+#endif
+#if LOG_COMPACT && (LOG_SEGMENT_BYTES > 0 || LOG_TIER_SD)
+#error "LOG_COMPACT needs growing segment files in one tier (LOG_SEGMENT_BYTES 0, LOG_TIER_SD 0)"
+#endif
+// A MAC chain or Merkle leaves cover the groups as written, an upload cursor their offsets
+#if LOG_COMPACT && (LOG_INTEGRITY_MODE || LOG_MERKLE_MODE || LOG_UPLOAD)
+#error "LOG_COMPACT cannot be combined with LOG_INTEGRITY_MODE, LOG_MERKLE_MODE or LOG_UPLOAD"
+#endif
+#if LOG_COMPACT && (LOG_COMPACT_FILL_PCT < 1 || LOG_COMPACT_FILL_PCT > 100)
+#error "LOG_COMPACT_FILL_PCT must be 1..100"
+#endif
+
+// --------------------
+// Channels
+// --------------------
+// Independent logs fed by one writer (enc_log_submit_channel()). Channel 0 is the log
+// configured above; channels 1..LOG_CHANNELS-1 (e.g. audit, debug) each get their own
+// segment files LOG_MOUNT_POINT "/<name>_NNNN.bin", sparse index sidecars and retention
+// (log_channel.h), encrypted by the same OPTIGA requests: in batch mode each channel fills
+// its own block groups, so a group never mixes channels and a quiet channel does not cut
+// the groups of a busy one short. Each side channel keeps one append buffer
+// (LOG_APPEND_BUF_BYTES) in RAM, and in batch mode a group of plaintext.
+// 1 = one log (default)
+#ifndef LOG_CHANNELS
+#define LOG_CHANNELS 1
+#endif
+
+// One entry per channel, channel 0 first (its name only labels it; its files are the
+// log's). Names are file name prefixes: letters and digits, not "enc_log".
+#ifndef LOG_CHANNEL_NAMES
+#define LOG_CHANNEL_NAMES       "telemetry", "audit", "debug"
+#endif
+
+// One entry per side channel (1, 2, ...): segment data bytes before the next file is
+// started (preallocated segments, LOG_SEGMENT_BYTES > 0, rotate when full instead), the
+// segments kept (2..LOG_CHANNEL_SEGMENTS_MAX, the open one included), and the age in
+// seconds after which a closed segment goes (newest indexed record, wall clock; 0 = no
+// limit, and segments of boots without a set clock never expire)
+#ifndef LOG_CHANNEL_SEGMENT_BYTES
+#define LOG_CHANNEL_SEGMENT_BYTES   (32 * 1024), (16 * 1024)
+#endif
+#ifndef LOG_CHANNEL_RETAIN_SEGMENTS
+#define LOG_CHANNEL_RETAIN_SEGMENTS 16, 4
+#endif
+#ifndef LOG_CHANNEL_RETAIN_AGE_S
+#define LOG_CHANNEL_RETAIN_AGE_S    0, (7 * 24 * 3600)
+#endif
+#define LOG_CHANNEL_SEGMENTS_MAX    16
+
+#if LOG_CHANNELS < 1 || LOG_CHANNELS > 16
+#error "LOG_CHANNELS must be 1..16 (4 bits of the ring slot flags)"
+#endif
+#if LOG_CHANNELS > 1 && (LOG_STORAGE_RAW || LOG_INDEX_EVERY == 0)
+#error "LOG_CHANNELS > 1 needs the file store (LOG_STORAGE_RAW 0) and its sparse index"
+#endif
+// Epoch headers, MAC chains, Merkle windows and delta state follow one log
+#if LOG_CHANNELS > 1 && (LOG_HYBRID_MODE || LOG_INTEGRITY_MODE || LOG_MERKLE_MODE || \
+                         LOG_BATCH_DELTA)
+#error "LOG_CHANNELS > 1 cannot be combined with LOG_HYBRID_MODE, LOG_INTEGRITY_MODE, LOG_MERKLE_MODE or LOG_BATCH_DELTA"
+#endif
+
+// --------------------
+// Reader
+// --------------------
+// Ciphertext bytes per decrypt request of the streaming reader (console 'd'). Back to
+// back records and block groups are decrypted as one CBC stream, IVs included: each
+// ciphertext block only needs the block before it, so only the IV blocks come out as
+// garbage. One run is decrypted while the next is read from storage.
+#ifndef LOG_READER_RUN_BYTES
+#define LOG_READER_RUN_BYTES    1024
+#endif
+
+#if LOG_READER_RUN_BYTES % AES_BLOCK_BYTES != 0
+#error "LOG_READER_RUN_BYTES must be a multiple of AES_BLOCK_BYTES"
+#endif
+#if LOG_BATCH_MODE && LOG_READER_RUN_BYTES < AES_IV_BYTES + BATCH_PT_MAX_BYTES
+#error "LOG_READER_RUN_BYTES must hold a whole block group"
+#endif
+
+// Range queries (log_query.c) seek with the sparse index and decrypt from there, so
+// their cost follows the result size. The console waits this long for the query line.
+#ifndef LOG_QUERY_LINE_TIMEOUT_MS
+#define LOG_QUERY_LINE_TIMEOUT_MS   15000
+#endif
+
+// Decrypted units kept for later scans (log_cache.h): dashboards that query overlapping
+// recent windows get the records they saw before without a decrypt request
+// 1 = 4-way LRU cache of LOG_READ_CACHE_BYTES of plaintext (PSRAM with LOG_PSRAM), wiped
+//     by a clear, a new key epoch (hybrid mode), a protected update and the '9' command
+// 0 = every scan decrypts (default)
+#ifndef LOG_READ_CACHE
+#define LOG_READ_CACHE 0
+#endif
+#ifndef LOG_READ_CACHE_BYTES
+#define LOG_READ_CACHE_BYTES    (16 * 1024)
+#endif
+// A slot holds the largest unit the build writes; larger units of other layouts are
+// decrypted every time
+#if LOG_BATCH_MODE
+#define READ_CACHE_SLOT_BYTES   BATCH_PT_MAX_BYTES
+#else
+#define READ_CACHE_SLOT_BYTES   GROUP_PT_BYTES(PLAINTEXT_MAX)
+#endif
+#define READ_CACHE_WAYS         4
+#define READ_CACHE_SETS         (LOG_READ_CACHE_BYTES / (READ_CACHE_SLOT_BYTES * READ_CACHE_WAYS))
+#if LOG_READ_CACHE && READ_CACHE_SETS == 0
+#error "LOG_READ_CACHE_BYTES must hold 4 units (block groups in batch mode)"
+#endif
+
+// --------------------
+// Wall clock
+// --------------------
+// Records carry uptime only; the wall clock base goes into the sparse index (log_time.h).
+// The system clock is set by the 'w' command or by SNTP, and the RTC keeps it through
+// deep sleep. Earlier clock values count as not set.
+#define LOG_TIME_VALID_AFTER_S  1735689600u     // 2025-01-01T00:00:00Z
+
+// 1 = start SNTP (esp_netif_sntp) at boot; the application must bring up a network
+//     interface (Wi-Fi/Ethernet) for it to sync. 0 = manual time only (default)
+#ifndef LOG_TIME_SNTP
+#define LOG_TIME_SNTP 0
+#endif
+
+#ifndef LOG_TIME_SNTP_SERVER
+#define LOG_TIME_SNTP_SERVER    "pool.ntp.org"
+#endif
+
+// --------------------
+// Writer task
+// --------------------
+// Ring buffer slots between producers and the writer task (power of two)
+#ifndef LOG_RING_SLOTS
+#define LOG_RING_SLOTS 32
+#endif
+
+// What enc_log_submit() does when the ring is full (the writer is behind, e.g. OPTIGA
+// busy with a TLS handshake or flash erasing):
+// LOG_RING_DROP_NEWEST (default) rejects the new record
+// LOG_RING_BLOCK waits up to LOG_RING_BLOCK_MS for a slot, then rejects it. Producer
+//   tasks only, never the writer's own callbacks
+// LOG_RING_DROP_OLDEST discards the oldest waiting record for the new one (not a
+//   priority record, and not one a producer is still copying)
+// LOG_RING_DOWNSAMPLE keeps every priority record but only 1 in LOG_RING_DOWNSAMPLE_KEEP
+//   normal records once LOG_RING_DOWNSAMPLE_DEPTH slots are in use, so a burst thins out
+//   before the ring is full; a full ring rejects the new record
+#define LOG_RING_DROP_NEWEST    0
+#define LOG_RING_BLOCK          1
+#define LOG_RING_DROP_OLDEST    2
+#define LOG_RING_DOWNSAMPLE     3
+#ifndef LOG_RING_POLICY
+#define LOG_RING_POLICY LOG_RING_DROP_NEWEST
+#endif
+#ifndef LOG_RING_BLOCK_MS
+#define LOG_RING_BLOCK_MS       100
+#endif
+#ifndef LOG_RING_DOWNSAMPLE_DEPTH
+#define LOG_RING_DOWNSAMPLE_DEPTH (LOG_RING_SLOTS / 2)
+#endif
+#ifndef LOG_RING_DOWNSAMPLE_KEEP
+#define LOG_RING_DOWNSAMPLE_KEEP 4
+#endif
+
+#if LOG_RING_POLICY < LOG_RING_DROP_NEWEST || LOG_RING_POLICY > LOG_RING_DOWNSAMPLE
+#error "LOG_RING_POLICY must be one of LOG_RING_DROP_NEWEST, _BLOCK, _DROP_OLDEST, _DOWNSAMPLE"
+#endif
+
+// 1 = enc_log_submit_from_isr(): interrupt handlers queue compact records (at most
+//     LOG_ISR_RECORD_MAX bytes) in a lock-free buffer of LOG_ISR_SLOTS entries per core.
+//     The handler only takes the CPU cycle count; the writer turns it into uptime and
+//     takes the sequence number when it moves the records into the ring, and is notified
+//     once per burst. Timestamps assume a fixed CPU clock (no DFS or light sleep).
+#ifndef LOG_ISR_SUBMIT
+#define LOG_ISR_SUBMIT 0
+#endif
+#ifndef LOG_ISR_SLOTS
+#define LOG_ISR_SLOTS 64
+#endif
+#ifndef LOG_ISR_RECORD_MAX
+#define LOG_ISR_RECORD_MAX 16
+#endif
+// A handler reads esp_timer again after this long on the cycle count alone, well inside
+// the counter wrap (about 17 s at 240 MHz)
+#ifndef LOG_ISR_RESYNC_MS
+#define LOG_ISR_RESYNC_MS 1000
+#endif
+
+#if LOG_ISR_SUBMIT && (LOG_ISR_SLOTS & (LOG_ISR_SLOTS - 1)) != 0
+#error "LOG_ISR_SLOTS must be a power of two"
+#endif
+#if LOG_ISR_SUBMIT && (LOG_ISR_RECORD_MAX > PLAINTEXT_MAX || LOG_ISR_RECORD_MAX > 255)
+#error "LOG_ISR_RECORD_MAX must fit a ring slot (PLAINTEXT_MAX)"
+#endif
+
+// Tasks that can wait in enc_log_wait_commit() at the same time
+#ifndef LOG_COMMIT_WAITERS
+#define LOG_COMMIT_WAITERS 4
+#endif
+
+#define LOG_WRITER_STACK_BYTES  4096
+// Below the OPTIGA event tasks (CONFIG_OPTIGA_TRUST_M_EVENT_TASK_PRIORITY, 5 by default),
+// which must run as soon as a transfer finishes
+#ifndef LOG_WRITER_PRIORITY
+#define LOG_WRITER_PRIORITY     4
+#endif
+// Core of the writer task, -1 for no affinity. The writer waits on OPTIGA and then writes
+// FATFS: the reference dual-core layout puts it on core 0 with WiFi and flash access and
+// the OPTIGA event tasks on core 1 (CONFIG_OPTIGA_TRUST_M_EVENT_TASK_CORE).
+#ifndef LOG_WRITER_CORE
+#define LOG_WRITER_CORE         (-1)
+#endif
+
+// Store upkeep that can take seconds in one go (deleting the segment files of a clear,
+// raw retention after the cap was lowered) runs as one step per writer pass, at most one
+// step every LOG_MAINT_STEP_MS, so the writer blocks in between and the task watchdog,
+// ingest and lower-priority tasks keep running.
+#ifndef LOG_MAINT_STEP_MS
+#define LOG_MAINT_STEP_MS       20
+#endif
+
+// OPTIGA requests taking longer than this are reported (and counted in the 's' stats)
+#ifndef LOG_OPTIGA_TIMEOUT_MS
+#define LOG_OPTIGA_TIMEOUT_MS   1000
+#endif
+
+// OPTIGA current limit policy (data object 0xE0C4, optiga_trust_set_current_limit()).
+// OPTIGA executes commands faster at a higher limit and draws more while doing so.
+// 1 = the writer raises the limit to LOG_CURRENT_BUSY_MA once LOG_CURRENT_BUSY_DEPTH
+//     records wait in the ring or a boost is on (readback, query, export), and lowers it
+//     to LOG_CURRENT_IDLE_MA after LOG_CURRENT_HOLD_MS without either
+// 0 = keep CONFIG_OPTIGA_TRUST_M_CURRENT_LIMIT_MA (default)
+// Every change is an OPTIGA NVM write; the hold keeps them to two per LOG_CURRENT_HOLD_MS.
+// Set CONFIG_OPTIGA_TRUST_M_CURRENT_LIMIT_MA to LOG_CURRENT_IDLE_MA so a boot writes nothing.
+#ifndef LOG_CURRENT_POLICY
+#define LOG_CURRENT_POLICY 0
+#endif
+#ifndef LOG_CURRENT_IDLE_MA
+#define LOG_CURRENT_IDLE_MA     6
+#endif
+#ifndef LOG_CURRENT_BUSY_MA
+#define LOG_CURRENT_BUSY_MA     15
+#endif
+#ifndef LOG_CURRENT_BUSY_DEPTH
+#define LOG_CURRENT_BUSY_DEPTH  (LOG_RING_SLOTS / 4)
+#endif
+#ifndef LOG_CURRENT_HOLD_MS
+#define LOG_CURRENT_HOLD_MS     60000
+#endif
+
+// OPTIGA keep-warm. After a quiet spell OPTIGA has dropped into its sleep mode and the
+// host side has gone idle, so the first request (the first record after a pause) takes
+// longer than the steady state. A warm-up is the lightest request there is: 8 TRNG bytes
+// on the writer's own instance, thrown away.
+// 0 = off (default)
+// 1 = keep-alive: a warm-up whenever the writer's instance has been quiet for
+//     LOG_WARM_PERIOD_MS, for up to LOG_WARM_HOLD_MS after the last record. Short gaps
+//     in a burst stay warm; a longer pause lets OPTIGA sleep. One request per period
+//     while held (LOG_WARM_HOLD_MS / LOG_WARM_PERIOD_MS per pause at most).
+// 2 = scheduled: warm-ups only ahead of announced activity (enc_log_expect())
+// With either, a producer that knows when it samples next calls enc_log_expect() and the
+// writer warms OPTIGA LOG_WARM_LEAD_MS before then, unless it was used within
+// LOG_WARM_PERIOD_MS of that point.
+#define LOG_WARM_OFF            0
+#define LOG_WARM_KEEPALIVE      1
+#define LOG_WARM_SCHEDULED      2
+#ifndef LOG_WARM_POLICY
+#define LOG_WARM_POLICY LOG_WARM_OFF
+#endif
+// Quiet time after which OPTIGA counts as cold; keep it below the point where the first
+// request slows down (measure with 'b' after pauses of different lengths)
+#ifndef LOG_WARM_PERIOD_MS
+#define LOG_WARM_PERIOD_MS      500
+#endif
+#ifndef LOG_WARM_HOLD_MS
+#define LOG_WARM_HOLD_MS        10000
+#endif
+// Warm-up ahead of an announced record: covers the warm-up itself and the wake-up
+#ifndef LOG_WARM_LEAD_MS
+#define LOG_WARM_LEAD_MS        20
+#endif
+#define LOG_WARM_RANDOM_BYTES   8       // smallest TRNG request OPTIGA takes
+
+// Power management (esp_pm, needs CONFIG_PM_ENABLE; light sleep also needs
+// CONFIG_FREERTOS_USE_TICKLESS_IDLE).
+// 1 = app_main configures dynamic frequency scaling between LOG_PM_MIN_MHZ and
+//     LOG_PM_MAX_MHZ (and automatic light sleep with LOG_PM_LIGHT_SLEEP). The clocks
+//     are held at maximum only while the logger has the store open for I/O; OPTIGA
+//     I2C transfers take their own lock (CONFIG_OPTIGA_TRUST_M_PM_LOCK). Waits on
+//     OPTIGA command completion block on semaphores and timers, so the chip sleeps
+//     through the execution time of a command.
+// 0 = no esp_pm configuration, the CPU stays at CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ (default)
+// The log_isr cycle count timing assumes a fixed CPU clock: no LOG_ISR_SUBMIT with it.
+#ifndef LOG_PM
+#define LOG_PM 0
+#endif
+#ifndef LOG_PM_MAX_MHZ
+#define LOG_PM_MAX_MHZ          CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+#endif
+#ifndef LOG_PM_MIN_MHZ
+#define LOG_PM_MIN_MHZ          CONFIG_XTAL_FREQ
+#endif
+#ifndef LOG_PM_LIGHT_SLEEP
+#define LOG_PM_LIGHT_SLEEP      1
+#endif
+// Supply and currents of the energy estimate in the 'b' benchmark: clocks held at
+// maximum, awake at LOG_PM_MIN_MHZ, light sleep. Measure them on the board; the
+// defaults are ESP32 datasheet figures plus an idle OPTIGA.
+#ifndef LOG_PM_SUPPLY_MV
+#define LOG_PM_SUPPLY_MV        3300
+#endif
+#ifndef LOG_PM_ACTIVE_MA
+#define LOG_PM_ACTIVE_MA        50
+#endif
+#ifndef LOG_PM_IDLE_MA
+#define LOG_PM_IDLE_MA          15
+#endif
+#ifndef LOG_PM_SLEEP_MA
+#define LOG_PM_SLEEP_MA         1
+#endif
+#if LOG_PM && !defined(CONFIG_PM_ENABLE)
+#error "LOG_PM needs CONFIG_PM_ENABLE"
+#endif
+#if LOG_PM && LOG_ISR_SUBMIT
+#error "LOG_PM changes the CPU clock the LOG_ISR_SUBMIT timing is based on"
+#endif
+#if LOG_PM && LOG_PM_MIN_MHZ > LOG_PM_MAX_MHZ
+#error "LOG_PM_MIN_MHZ above LOG_PM_MAX_MHZ"
+#endif
+
+// External RAM (WROVER and other modules with PSRAM)
+// 1 = the writer's bulk buffers go to PSRAM .bss (EXT_RAM_BSS_ATTR): block group
+//     plaintext and ciphertext of every channel, compression and delta scratch, the
+//     keystream cache, the compaction runs and the read cache (LOG_READ_CACHE). Internal
+//     RAM keeps the ring (producers and interrupt drain), the SD tier copy buffer (SDMMC
+//     DMA) and the raw store's page buffer; OPTIGA's I2C buffers are the component's
+//     own. Lets LOG_BATCH_RECORDS and
+//     LOG_CTR_CACHE_BLOCKS grow to tens of KB next to WiFi and TLS, at the cost of cache
+//     misses on every pass over them: compare with the benchmark app (BENCH_PSRAM).
+//     Needs CONFIG_SPIRAM and CONFIG_SPIRAM_ALLOW_BSS_SEG_EXTERNAL_MEMORY
+// 0 = everything in internal RAM (default)
+#ifndef LOG_PSRAM
+#define LOG_PSRAM 0
+#endif
+#if LOG_PSRAM && !defined(CONFIG_SPIRAM_ALLOW_BSS_SEG_EXTERNAL_MEMORY)
+#error "LOG_PSRAM needs CONFIG_SPIRAM and CONFIG_SPIRAM_ALLOW_BSS_SEG_EXTERNAL_MEMORY"
+#endif
+
+// Sample records appended by the 'b' latency benchmark
+#ifndef LOG_BENCH_RECORDS
+#define LOG_BENCH_RECORDS       200
+#endif
+
+// Records per producer task of the 'n' group commit test (3 tasks)
+#ifndef LOG_GROUP_COMMIT_RECORDS
+#define LOG_GROUP_COMMIT_RECORDS 16
+#endif
+
+// Synthetic load generator of the '4' soak command (log_load.h)
+// 0 = off (default)
+// 1 = LOG_LOAD_PRODUCERS tasks submit sample records through enc_log_submit() on the
+//     built-in profiles (periodic sensor, bursty, mixed sizes, rare alarms), scaled by a
+//     rate in percent. Every LOG_LOAD_REPORT_S it prints "LOAD {json}": offered against
+//     appended load, drops and submit to append latency percentiles of the window, and
+//     flags drift against the first LOG_LOAD_BASELINE_WINDOWS windows
+#ifndef LOG_LOADGEN
+#define LOG_LOADGEN 0
+#endif
+#ifndef LOG_LOAD_PRODUCERS
+#define LOG_LOAD_PRODUCERS      4       // tasks, the profiles in turn
+#endif
+#ifndef LOG_LOAD_REPORT_S
+#define LOG_LOAD_REPORT_S       60
+#endif
+#ifndef LOG_LOAD_BASELINE_WINDOWS
+#define LOG_LOAD_BASELINE_WINDOWS 3
+#endif
+#ifndef LOG_LOAD_DRIFT_PCT
+#define LOG_LOAD_DRIFT_PCT      25      // p99 up or delivered share down this much
+#endif
+#ifndef LOG_LOAD_DRIFT_WINDOWS
+#define LOG_LOAD_DRIFT_WINDOWS  3       // in a row before it counts
+#endif
+#ifndef LOG_LOAD_HEAP_DRIFT_BYTES
+#define LOG_LOAD_HEAP_DRIFT_BYTES 4096  // fitted heap loss over the run that counts as a leak
+#endif
+#ifndef LOG_LOAD_TRACK
+#define LOG_LOAD_TRACK          512     // submit times kept for records in flight
+#endif
+#if LOG_LOADGEN && (LOG_LOAD_PRODUCERS < 1 || LOG_LOAD_PRODUCERS > 8)
+#error "LOG_LOAD_PRODUCERS must be 1..8"
+#endif
+#if LOG_LOADGEN && (LOG_LOAD_TRACK & (LOG_LOAD_TRACK - 1)) != 0
+#error "LOG_LOAD_TRACK must be a power of two"
+#endif
+#if LOG_LOADGEN && (LOG_LOAD_REPORT_S < 1 || LOG_LOAD_BASELINE_WINDOWS < 1)
+#error "LOG_LOAD_REPORT_S and LOG_LOAD_BASELINE_WINDOWS must be at least 1"
+#endif
+
+// Boot self-test (log_selftest.h), also run by the '0' command
+// 0 = off (default)
+// 1 = at every boot but deep sleep wakes: LOG_SELFTEST_AES_COMMANDS OPTIGA encrypts,
+//     LOG_SELFTEST_I2C_READS one-byte reads and LOG_SELFTEST_STORE_BYTES written and read
+//     back on the log storage, timed against the device's baseline in NVS. A step under
+//     LOG_SELFTEST_ALARM_PCT of the baseline throughput, or more I2C link resends than
+//     LOG_SELFTEST_MAX_RESENDS, appends a priority alarm record
+#ifndef LOG_SELFTEST
+#define LOG_SELFTEST 0
+#endif
+#ifndef LOG_SELFTEST_AES_COMMANDS
+#define LOG_SELFTEST_AES_COMMANDS 16
+#endif
+#ifndef LOG_SELFTEST_I2C_READS
+#define LOG_SELFTEST_I2C_READS  16
+#endif
+#ifndef LOG_SELFTEST_STORE_BYTES
+#define LOG_SELFTEST_STORE_BYTES 4096   // one flash sector
+#endif
+#ifndef LOG_SELFTEST_ALARM_PCT
+#define LOG_SELFTEST_ALARM_PCT  70
+#endif
+#ifndef LOG_SELFTEST_MAX_RESENDS
+#define LOG_SELFTEST_MAX_RESENDS 0
+#endif
+#if LOG_SELFTEST && (LOG_SELFTEST_AES_COMMANDS < 1 || LOG_SELFTEST_I2C_READS < 1 || \
+                     LOG_SELFTEST_STORE_BYTES < 1)
+#error "LOG_SELFTEST_AES_COMMANDS, LOG_SELFTEST_I2C_READS and LOG_SELFTEST_STORE_BYTES must be at least 1"
+#endif
+#if LOG_SELFTEST && (LOG_SELFTEST_ALARM_PCT < 1 || LOG_SELFTEST_ALARM_PCT > 100)
+#error "LOG_SELFTEST_ALARM_PCT must be 1..100"
+#endif
+
+// Crash injection in the store paths (log_crash.h), for recovery tests such as the
+// benchmark app's crash cycles (bench/, BENCH_CRASH_CYCLES)
+// 0 = off (default), the crash points compile to nothing
+// 1 = an armed crash point resets the chip: esp_restart(), after driving
+//     LOG_CRASH_GPIO high for LOG_CRASH_GPIO_HOLD_MS when it is set (an external switch
+//     that cuts the storage supply, so the card or flash sees a real power loss)
+#ifndef LOG_CRASH_TEST
+#define LOG_CRASH_TEST 0
+#endif
+#ifndef LOG_CRASH_GPIO
+#define LOG_CRASH_GPIO          -1      // -1: software reset only
+#endif
+#ifndef LOG_CRASH_GPIO_HOLD_MS
+#define LOG_CRASH_GPIO_HOLD_MS  50
+#endif
+
+// Diagnostics on the record and block group paths (log_diag.h)
+// LOG_DIAG_LEVEL: highest esp_log level of the LOG_DIAG() sites compiled in, 0 (none) ..
+//     5 (verbose). Per-group lines are debug (4): out by default. Errors on these paths
+//     print at most once per LOG_DIAG_RATE_MS per site, with the count held back
+// LOG_DIAG_SUMMARY_MS: the writer prints "N records, B bytes in the last S s" (with drops
+//     and errors) this often while records arrive; 0 = no summary
+#ifndef LOG_DIAG_LEVEL
+#define LOG_DIAG_LEVEL          3       // ESP_LOG_INFO
+#endif
+#ifndef LOG_DIAG_RATE_MS
+#define LOG_DIAG_RATE_MS        1000
+#endif
+#ifndef LOG_DIAG_SUMMARY_MS
+#define LOG_DIAG_SUMMARY_MS     10000
+#endif
+#if LOG_DIAG_LEVEL < 0 || LOG_DIAG_LEVEL > 5
+#error "LOG_DIAG_LEVEL must be 0..5"
+#endif
+
+// Calls per path and curve of the 'e' ECDSA verify / ECDH offload benchmark
+#ifndef LOG_OFFLOAD_BENCH_ITERATIONS
+#define LOG_OFFLOAD_BENCH_ITERATIONS 8
+#endif
+
+// Message length and streams per engine of the 'h' SHA-256 benchmark, OPTIGA vs ESP32
+#ifndef LOG_HASH_BENCH_BYTES
+#define LOG_HASH_BENCH_BYTES    4096
+#endif
+#ifndef LOG_HASH_BENCH_ITERATIONS
+#define LOG_HASH_BENCH_ITERATIONS 4
+#endif
+
+// Shielded connection handshakes per PRF backend in the 'h' benchmark (OPTIGA_TRUST_M_PAL_PRF_HW)
+#ifndef LOG_HANDSHAKE_BENCH_ITERATIONS
+#define LOG_HANDSHAKE_BENCH_ITERATIONS 8
+#endif
+
+// --------------------
+// OPTIGA key
+// --------------------
+#define LOG_KEY_OID       0xE200
+
+// 1 = generate a fresh key in OPTIGA on every boot (overwrites slot)
+// 0 = use existing key in OPTIGA key slot (0xE200)
+#ifndef GENERATE_KEY_ON_BOOT
+#ifdef CONFIG_ENC_LOG_GENERATE_KEY_ON_BOOT
+#define GENERATE_KEY_ON_BOOT 1
+#else
+#define GENERATE_KEY_ON_BOOT 0
+#endif
+#endif
+
+// 1 = enc_log_init() returns before OPTIGA is up: bring-up, instances and key checks run on
+//     the writer task while the storage is mounted (I2C and SPI flash/SDMMC side by side),
+//     records submitted meanwhile wait in the ring (LOG_RING_SLOTS deep)
+// 0 = enc_log_init() mounts the storage, then brings OPTIGA up, nothing can be submitted before
+#ifndef LOG_LAZY_OPTIGA
+#define LOG_LAZY_OPTIGA 1
+#endif
+
+// 2 = as 1, but the ceiling is an OPTIGA monotonic counter (LOG_SEQ_COUNTER_OID): one
+//     optiga_util_update_count() advances it by LOG_SEQ_BLOCK (at most 255, the largest
+//     step of one command), a boot reads it once. The counter cannot be set back, so
+//     numbers stay unique even if NVS or the log is restored from an older copy. The
+//     ceiling is written to the segment and epoch headers (log_seq_reserved())
+// 1 = record sequence numbers continue across reboots (log_seq.h): NVS keeps a ceiling
+//     reserved LOG_SEQ_BLOCK numbers ahead, one NVS write per block, a reset skips the
+//     unused rest of the block
+// 0 = the sequence only survives deep sleep (RTC memory) and restarts at 1 otherwise
+#define LOG_SEQ_PERSIST_OPTIGA 2
+#ifndef LOG_SEQ_PERSIST
+#define LOG_SEQ_PERSIST 1
+#endif
+#ifndef LOG_SEQ_BLOCK
+#if LOG_SEQ_PERSIST == LOG_SEQ_PERSIST_OPTIGA
+#define LOG_SEQ_BLOCK 255
+#else
+#define LOG_SEQ_BLOCK 256
+#endif
+#endif
+// Monotonic counter the sequence is anchored to (0xE120..0xE123). Its threshold ends the
+// numbering: set it above the records the device will ever write.
+#ifndef LOG_SEQ_COUNTER_OID
+#define LOG_SEQ_COUNTER_OID 0xE120
+#endif
+#if LOG_SEQ_PERSIST && LOG_SEQ_BLOCK < 1
+#error "LOG_SEQ_BLOCK must be at least 1"
+#endif
+#if LOG_SEQ_PERSIST == LOG_SEQ_PERSIST_OPTIGA && LOG_SEQ_BLOCK > 255
+#error "LOG_SEQ_BLOCK is one optiga_util_update_count() step with LOG_SEQ_PERSIST 2: at most 255"
+#endif
+#if LOG_SEQ_PERSIST == LOG_SEQ_PERSIST_OPTIGA && \
+    (LOG_SEQ_COUNTER_OID < 0xE120 || LOG_SEQ_COUNTER_OID > 0xE123)
+#error "LOG_SEQ_COUNTER_OID must be a monotonic counter, 0xE120..0xE123"
+#endif
+
+// 1 = keep what OPTIGA was found set up with in an NVS record (log_persona.h): later boots
+//     skip the metadata reads of the key and secret slots and the 0xE0C4 read, the first
+//     failing request clears the record
+// 0 = check OPTIGA in full on every boot
+#ifndef LOG_PERSONA_CACHE
+#define LOG_PERSONA_CACHE 1
+#endif
+
+#endif // ENC_LOG_CONFIG_H
@@ -0,0 +1,253 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Windowed aggregation of high-rate channels ahead of the writer.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_agg.c
+ * @brief   Per-channel min/max/mean/count windows with raw capture around events
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "enc_log.h"
+#include "log_agg.h"
+#include "log_record.h"
+#include "log_seq.h"
+
+#if LOG_AGG_MODE
+
+#define AGG_RECORD_MAX  32      // packed aggregate (28 bytes) or raw sample (18 bytes)
+
+typedef struct {
+    uint32_t window_ms;
+    int32_t low;
+    int32_t high;
+    // Open window
+    uint64_t window_start;
+    uint32_t count;
+    int64_t sum;
+    int32_t min;
+    int32_t max;
+    // Samples not yet passed through raw, oldest at hist_pos - hist_count
+    int32_t hist_value[LOG_AGG_PRE_SAMPLES];
+    uint64_t hist_ms[LOG_AGG_PRE_SAMPLES];
+    uint32_t hist_pos;
+    uint32_t hist_count;
+    uint32_t post_left;         // samples still passed through raw after an event
+} agg_channel_t;
+
+// A record picked under the lock and encoded / submitted after it
+typedef struct {
+    bool aggregate;
+    bool priority;
+    uint64_t uptime_ms;
+    uint16_t count;
+    int32_t min;
+    int32_t max;
+    int32_t mean;
+} agg_out_t;
+
+// --------------------
+// Globals
+// --------------------
+static agg_channel_t s_channels[LOG_AGG_CHANNELS];
+static portMUX_TYPE s_agg_lock = portMUX_INITIALIZER_UNLOCKED;
+static log_agg_stats_t s_stats;
+static bool s_init = false;
+
+// --------------------
+// Helpers (call with s_agg_lock held)
+// --------------------
+static void channel_defaults(void)
+{
+    for (int i = 0; i < LOG_AGG_CHANNELS; i++) {
+        s_channels[i].window_ms = LOG_AGG_WINDOW_MS;
+        s_channels[i].low = 1;
+        s_channels[i].high = 0;
+    }
+    s_init = true;
+}
+
+static void close_window(agg_channel_t *c, agg_out_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->aggregate = true;
+    out->uptime_ms = c->window_start;
+    out->count = (uint16_t)c->count;
+    out->min = c->min;
+    out->max = c->max;
+    out->mean = (int32_t)(c->sum / (int64_t)c->count);
+    c->count = 0;
+}
+
+static void raw_out(agg_out_t *out, int32_t value, uint64_t uptime_ms, bool priority)
+{
+    memset(out, 0, sizeof(*out));
+    out->priority = priority;
+    out->uptime_ms = uptime_ms;
+    out->min = value;
+}
+
+// --------------------
+// Submission (outside the lock)
+// --------------------
+static void submit(uint8_t channel, const agg_out_t *outs, uint32_t n)
+{
+    uint32_t aggregates = 0;
+    uint32_t raw = 0;
+    uint32_t dropped = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        const agg_out_t *o = &outs[i];
+        const uint32_t seq = log_seq_next();
+        uint8_t msg[AGG_RECORD_MAX];
+        const size_t len = o->aggregate
+            ? log_record_encode_agg(msg, sizeof(msg), seq, o->uptime_ms, channel, o->count,
+                                    o->min, o->max, o->mean)
+            : log_record_encode_raw(msg, sizeof(msg), seq, o->uptime_ms, channel, o->min);
+        if (len == 0 || !enc_log_submit(msg, len, seq, o->priority)) {
+            dropped++;
+        } else if (o->aggregate) {
+            aggregates++;
+        } else {
+            raw++;
+        }
+    }
+
+    portENTER_CRITICAL(&s_agg_lock);
+    s_stats.aggregates += aggregates;
+    s_stats.raw += raw;
+    s_stats.dropped += dropped;
+    portEXIT_CRITICAL(&s_agg_lock);
+}
+
+// --------------------
+// Public API
+// --------------------
+bool log_agg_configure(uint8_t channel, uint32_t window_ms, int32_t low, int32_t high)
+{
+    if (channel >= LOG_AGG_CHANNELS || window_ms == 0) {
+        return false;
+    }
+    portENTER_CRITICAL(&s_agg_lock);
+    if (!s_init) {
+        channel_defaults();
+    }
+    s_channels[channel].window_ms = window_ms;
+    s_channels[channel].low = low;
+    s_channels[channel].high = high;
+    portEXIT_CRITICAL(&s_agg_lock);
+    return true;
+}
+
+bool log_agg_sample(uint8_t channel, int32_t value, uint64_t uptime_ms)
+{
+    // Closed window, the kept samples and the event at most
+    agg_out_t outs[LOG_AGG_PRE_SAMPLES + 2];
+    uint32_t n = 0;
+
+    if (channel >= LOG_AGG_CHANNELS) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&s_agg_lock);
+    if (!s_init) {
+        channel_defaults();
+    }
+    agg_channel_t *c = &s_channels[channel];
+    s_stats.samples++;
+
+    // A later window (or a full count) closes the open one
+    const uint64_t start = uptime_ms - uptime_ms % c->window_ms;
+    if (c->count > 0 && (start != c->window_start || c->count == UINT16_MAX)) {
+        close_window(c, &outs[n++]);
+    }
+    if (c->count == 0) {
+        c->window_start = start;
+        c->sum = 0;
+        c->min = value;
+        c->max = value;
+    }
+    c->count++;
+    c->sum += value;
+    if (value < c->min) {
+        c->min = value;
+    }
+    if (value > c->max) {
+        c->max = value;
+    }
+
+    const bool event = c->low <= c->high && (value < c->low || value > c->high);
+    if (event) {
+        s_stats.events++;
+        for (uint32_t i = c->hist_count; i > 0; i--) {
+            const uint32_t at = (c->hist_pos + LOG_AGG_PRE_SAMPLES - i) % LOG_AGG_PRE_SAMPLES;
+            raw_out(&outs[n++], c->hist_value[at], c->hist_ms[at], false);
+        }
+        c->hist_count = 0;
+        raw_out(&outs[n++], value, uptime_ms, true);
+        c->post_left = LOG_AGG_POST_SAMPLES;
+    } else if (c->post_left > 0) {
+        c->post_left--;
+        raw_out(&outs[n++], value, uptime_ms, false);
+    } else {
+        c->hist_value[c->hist_pos] = value;
+        c->hist_ms[c->hist_pos] = uptime_ms;
+        c->hist_pos = (c->hist_pos + 1) % LOG_AGG_PRE_SAMPLES;
+        if (c->hist_count < LOG_AGG_PRE_SAMPLES) {
+            c->hist_count++;
+        }
+    }
+    portEXIT_CRITICAL(&s_agg_lock);
+
+    submit(channel, outs, n);
+    return true;
+}
+
+void log_agg_flush(uint64_t now_ms)
+{
+    for (int i = 0; i < LOG_AGG_CHANNELS; i++) {
+        agg_out_t out;
+        bool closed = false;
+
+        portENTER_CRITICAL(&s_agg_lock);
+        agg_channel_t *c = &s_channels[i];
+        if (c->count > 0 && now_ms >= c->window_start + c->window_ms) {
+            close_window(c, &out);
+            closed = true;
+        }
+        portEXIT_CRITICAL(&s_agg_lock);
+
+        if (closed) {
+            submit((uint8_t)i, &out, 1);
+        }
+    }
+}
+
+void log_agg_get_stats(log_agg_stats_t *out)
+{
+    portENTER_CRITICAL(&s_agg_lock);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_agg_lock);
+}
+
+#endif // LOG_AGG_MODE
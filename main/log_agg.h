@@ -0,0 +1,65 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Windowed aggregation of high-rate channels ahead of the writer.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_agg.h
+ * @brief   Per-channel min/max/mean/count windows with raw capture around events
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Samples never reach the ring one by one: each channel folds them into
+ *          a window aligned to uptime, and the first sample of a later window
+ *          submits the closed window as one RECORD_SCHEMA_AGG record. A sample
+ *          outside the channel's [low, high] band is an event: the last
+ *          LOG_AGG_PRE_SAMPLES samples, the event itself (priority) and the next
+ *          LOG_AGG_POST_SAMPLES samples are also submitted as RECORD_SCHEMA_RAW
+ *          records. Every sample still counts in its window.
+ *******************************************************************************/
+#ifndef LOG_AGG_H
+#define LOG_AGG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+typedef struct {
+    uint32_t samples;           // samples fed to log_agg_sample()
+    uint32_t aggregates;        // window records submitted
+    uint32_t raw;               // raw sample records submitted
+    uint32_t events;            // samples outside the thresholds
+    uint32_t dropped;           // records enc_log_submit() refused
+} log_agg_stats_t;
+
+#if LOG_AGG_MODE
+
+// Window and event band of a channel; samples below low or above high are events.
+// low > high disables events. False for a channel >= LOG_AGG_CHANNELS or window_ms 0.
+bool log_agg_configure(uint8_t channel, uint32_t window_ms, int32_t low, int32_t high);
+
+// Any task: fold one sample taken at uptime_ms into its channel. Samples of a channel
+// come in time order. False for an unknown channel.
+bool log_agg_sample(uint8_t channel, int32_t value, uint64_t uptime_ms);
+
+// Submit the windows that ended by now_ms; a quiet channel's last window otherwise
+// waits for its next sample
+void log_agg_flush(uint64_t now_ms);
+
+void log_agg_get_stats(log_agg_stats_t *out);
+
+#endif // LOG_AGG_MODE
+
+#endif // LOG_AGG_H
@@ -0,0 +1,688 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Keep-open, sector-buffered file appender with a sync policy.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_appender.c
+ * @brief   Buffered log file appender
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#if LOG_STORAGE_SDMMC
+#include "esp_memory_utils.h"
+#endif
+
+#include "optiga/pal/pal_sysview.h"
+
+#include "log_appender.h"
+#include "log_crash.h"
+
+#if (LOG_APPEND_BUF_BYTES % 512) != 0
+#error "LOG_APPEND_BUF_BYTES must be a multiple of the 512B FAT sector"
+#endif
+
+#if LOG_SEGMENT_BYTES > 0
+#if (LOG_SEGMENT_BYTES % 512) != 0 || LOG_SEGMENT_BYTES <= SEGMENT_HDR_BYTES
+#error "LOG_SEGMENT_BYTES must be a multiple of 512 and larger than the segment header"
+#endif
+#endif
+
+#define DATA_START LOG_APPENDER_DATA_START
+
+// Bytes of the segment header that carry fields (the rest of the sector stays zero)
+#define SEGMENT_HDR_FIELD_BYTES (SEGMENT_HDR_MAGIC_BYTES + 2 + 2 + 4 + 4 + 4)
+
+static const char *TAG = "LOG_APP";
+
+#if LOG_SEGMENT_BYTES > 0 || LOG_COMMIT_MARKERS
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+#endif
+
+#if LOG_SEGMENT_BYTES > 0
+// --------------------
+// Segment Header
+// --------------------
+static void put_le16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t get_le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static bool header_write(FILE *f, uint32_t end, uint32_t seq_ceiling)
+{
+    uint8_t hdr[SEGMENT_HDR_FIELD_BYTES];
+    memcpy(hdr, SEGMENT_HDR_MAGIC, SEGMENT_HDR_MAGIC_BYTES);
+    put_le16(hdr + 8, SEGMENT_HDR_VERSION);
+    put_le16(hdr + 10, SEGMENT_HDR_BYTES);
+    put_le32(hdr + 12, LOG_SEGMENT_BYTES);
+    put_le32(hdr + 16, end);
+    put_le32(hdr + 20, seq_ceiling);
+    return fseek(f, 0, SEEK_SET) == 0 && fwrite(hdr, 1, sizeof(hdr), f) == sizeof(hdr);
+}
+
+// Rewrite the header fields in place and return the file position to the data end.
+// The header sector is already allocated, so this never grows the file.
+static bool segment_write_header(log_appender_t *app)
+{
+    bool ok = header_write(app->f, app->end, app->seq_ceiling);
+    ok = (fseek(app->f, (long)app->end, SEEK_SET) == 0) && ok;
+    if (!ok) {
+        ESP_LOGE(TAG, "segment header write failed");
+    }
+    return ok;
+}
+
+// Existing segment: take the data end offset from its header.
+static bool segment_parse(FILE *f, const char *path, uint32_t *end)
+{
+    uint8_t hdr[SEGMENT_HDR_FIELD_BYTES];
+    if (fseek(f, 0, SEEK_SET) != 0 || fread(hdr, 1, sizeof(hdr), f) != sizeof(hdr)) {
+        return false;
+    }
+    if (memcmp(hdr, SEGMENT_HDR_MAGIC, SEGMENT_HDR_MAGIC_BYTES) != 0 ||
+        get_le16(hdr + 8) != SEGMENT_HDR_VERSION || get_le16(hdr + 10) != SEGMENT_HDR_BYTES ||
+        get_le32(hdr + 12) != LOG_SEGMENT_BYTES) {
+        ESP_LOGW(TAG, "%s is not a %u byte segment", path, (unsigned)LOG_SEGMENT_BYTES);
+        return false;
+    }
+
+    *end = get_le32(hdr + 16);
+    if (*end < DATA_START || *end > LOG_SEGMENT_BYTES) {
+        ESP_LOGW(TAG, "%s: segment end offset %u out of range", path, (unsigned)*end);
+        return false;
+    }
+    return true;
+}
+
+static bool segment_load(log_appender_t *app)
+{
+    uint32_t end = 0;
+    if (!segment_parse(app->f, app->path, &end)) {
+        ESP_LOGW(TAG, "recreating %s", app->path);
+        return false;
+    }
+    app->end = end;
+    return fseek(app->f, (long)end, SEEK_SET) == 0;
+}
+
+// New segment: write the header sector and fill the file to its full size so
+// every FAT cluster is allocated now rather than on the append path.
+static bool segment_create(log_appender_t *app)
+{
+    if (app->f) {
+        fclose(app->f);
+    }
+#if LOG_COMMIT_MARKERS
+    // Markers of the old file describe data that is about to be overwritten
+    remove(app->cmt_path);
+#endif
+    app->f = fopen(app->path, "w+b");
+    if (!app->f) {
+        ESP_LOGE(TAG, "failed to create %s", app->path);
+        return false;
+    }
+    setvbuf(app->f, NULL, _IONBF, 0);
+
+    const int64_t t0 = esp_timer_get_time();
+    memset(app->buf, 0, SEGMENT_HDR_BYTES);
+    bool ok = fwrite(app->buf, 1, SEGMENT_HDR_BYTES, app->f) == SEGMENT_HDR_BYTES;
+
+    // 0xFF matches erased flash, so unused space never looks like ciphertext
+    memset(app->buf, 0xFF, sizeof(app->buf));
+    for (uint32_t off = SEGMENT_HDR_BYTES; ok && off < LOG_SEGMENT_BYTES;) {
+        const size_t chunk = (LOG_SEGMENT_BYTES - off < sizeof(app->buf))
+                                 ? (size_t)(LOG_SEGMENT_BYTES - off)
+                                 : sizeof(app->buf);
+        ok = fwrite(app->buf, 1, chunk, app->f) == chunk;
+        off += (uint32_t)chunk;
+    }
+
+    app->end = DATA_START;
+    ok = ok && segment_write_header(app) && fsync(fileno(app->f)) == 0;
+    if (!ok) {
+        ESP_LOGE(TAG, "failed to preallocate %u bytes for %s (storage full?)",
+                 (unsigned)LOG_SEGMENT_BYTES, app->path);
+        fclose(app->f);
+        app->f = NULL;
+        return false;
+    }
+    ESP_LOGI(TAG, "preallocated %u byte segment in %lld ms", (unsigned)LOG_SEGMENT_BYTES,
+             (long long)((esp_timer_get_time() - t0) / 1000));
+    return true;
+}
+#endif
+
+#if LOG_COMMIT_MARKERS
+// --------------------
+// Commit Journal
+// --------------------
+// enc_log.bin -> enc_log.cmt
+static void commit_path(char *out, size_t n, const char *path)
+{
+    snprintf(out, n, "%s", path);
+    char *dot = strrchr(out, '.');
+    char *slash = strrchr(out, '/');
+    if (dot && (!slash || dot > slash)) {
+        *dot = '\0';
+    }
+    const size_t len = strlen(out);
+    snprintf(out + len, n - len, "%s", COMMIT_PATH_EXT);
+}
+
+static void commit_close(log_appender_t *app)
+{
+    if (app->cmt) {
+        fclose(app->cmt);
+        app->cmt = NULL;
+    }
+}
+
+// Append a marker for everything written since the previous one. Called after
+// the data fsync, so a marker never covers bytes that are not durable.
+static bool commit_write(log_appender_t *app)
+{
+    uint8_t e[COMMIT_ENTRY_BYTES];
+    put_le32(e, app->commit_seq);
+    put_le32(e + 4, app->end);
+    put_le32(e + 8, app->end - app->commit_end);
+    put_le32(e + 12, app->commit_crc);
+    put_le32(e + 16, esp_rom_crc32_le(0, e, 16));
+
+    if (!app->cmt || fwrite(e, 1, sizeof(e), app->cmt) != sizeof(e) ||
+        fflush(app->cmt) != 0 || fsync(fileno(app->cmt)) != 0) {
+        // The next marker covers this range too
+        ESP_LOGE(TAG, "commit marker write failed");
+        return false;
+    }
+    app->commit_seq++;
+    app->commit_end = app->end;
+    app->commit_crc = 0;
+    return true;
+}
+
+static bool commit_verify(log_appender_t *app, uint32_t from, uint32_t len, uint32_t crc)
+{
+    uint32_t c = 0;
+    if (fseek(app->f, (long)from, SEEK_SET) != 0) {
+        return false;
+    }
+    while (len > 0) {
+        const size_t chunk = (len < sizeof(app->buf)) ? len : sizeof(app->buf);
+        if (fread(app->buf, 1, chunk, app->f) != chunk) {
+            return false;
+        }
+        c = esp_rom_crc32_le(c, app->buf, chunk);
+        len -= (uint32_t)chunk;
+    }
+    return c == crc;
+}
+
+// Cut the data file back to end (bytes past the newest valid marker).
+static bool truncate_data(log_appender_t *app, uint32_t end)
+{
+    app->end = end;
+#if LOG_SEGMENT_BYTES > 0
+    return segment_write_header(app) && fsync(fileno(app->f)) == 0;
+#else
+    return ftruncate(fileno(app->f), (off_t)end) == 0 && fsync(fileno(app->f)) == 0;
+#endif
+}
+
+// Find the newest marker that matches the data and drop everything after it.
+// Only the last COMMIT_SCAN_ENTRIES markers and the bytes they cover are read,
+// so this costs the same for a short and a long log.
+static void commit_recover(log_appender_t *app)
+{
+    app->cmt = fopen(app->cmt_path, "r+b");
+    if (!app->cmt) {
+        app->cmt = fopen(app->cmt_path, "w+b");
+    }
+    if (!app->cmt) {
+        ESP_LOGW(TAG, "failed to open commit journal %s", app->cmt_path);
+        return;
+    }
+
+    fseek(app->cmt, 0, SEEK_END);
+    const long jbytes = ftell(app->cmt);
+    long pos = jbytes - (jbytes % COMMIT_ENTRY_BYTES);
+    bool found = false;
+    for (int i = 0; i < COMMIT_SCAN_ENTRIES && pos >= COMMIT_ENTRY_BYTES; i++) {
+        uint8_t e[COMMIT_ENTRY_BYTES];
+        pos -= COMMIT_ENTRY_BYTES;
+        if (fseek(app->cmt, pos, SEEK_SET) != 0 || fread(e, 1, sizeof(e), app->cmt) != sizeof(e)) {
+            break;
+        }
+        const uint32_t end = get_le32(e + 4);
+        const uint32_t len = get_le32(e + 8);
+        if (get_le32(e + 16) != esp_rom_crc32_le(0, e, 16) || end > app->end ||
+            (uint64_t)len + DATA_START > end ||
+            !commit_verify(app, end - len, len, get_le32(e + 12))) {
+            continue;
+        }
+
+        if (app->end > end) {
+            ESP_LOGW(TAG, "%s: dropping %u uncommitted bytes", app->path,
+                     (unsigned)(app->end - end));
+            if (!truncate_data(app, end)) {
+                ESP_LOGE(TAG, "%s: tail truncate failed", app->path);
+            }
+        }
+        app->commit_seq = get_le32(e) + 1;
+        pos += COMMIT_ENTRY_BYTES;
+        found = true;
+        break;
+    }
+
+    if (!found) {
+        if (jbytes > 0) {
+            ESP_LOGW(TAG, "%s: no valid commit marker, keeping %u bytes", app->path,
+                     (unsigned)(app->end - DATA_START));
+        }
+        pos = 0;
+    }
+    if (pos != jbytes) {
+        fflush(app->cmt);
+        ftruncate(fileno(app->cmt), (off_t)pos);
+    }
+    fseek(app->cmt, 0, SEEK_END);
+    fseek(app->f, (long)app->end, SEEK_SET);
+
+    app->commit_end = app->end;
+    app->commit_crc = 0;
+    if (!found) {
+        // Baseline marker: the data kept above is taken as committed
+        commit_write(app);
+    }
+}
+
+#if LOG_SEGMENT_BYTES > 0
+// Drop the journal and start a new one at the current end (segment emptied in place).
+static void commit_reset(log_appender_t *app)
+{
+    commit_close(app);
+    remove(app->cmt_path);
+    commit_recover(app);
+}
+#endif
+#endif
+
+// Fill level at which the buffer is written: up to the next file offset that is a
+// multiple of the buffer size. After a sync wrote a partial buffer the next write
+// is shorter and the following ones are aligned again.
+static size_t write_limit(const log_appender_t *app)
+{
+    return LOG_APPEND_BUF_BYTES - (app->end % LOG_APPEND_BUF_BYTES);
+}
+
+// Push the RAM buffer into the file (no fsync).
+static bool write_buffer(log_appender_t *app)
+{
+    if (app->used == 0) {
+        return true;
+    }
+
+    PAL_SYSVIEW_START(PAL_SYSVIEW_MARK_LOG_WRITE);
+    size_t n = fwrite(app->buf, 1, app->used, app->f);
+    PAL_SYSVIEW_STOP(PAL_SYSVIEW_MARK_LOG_WRITE);
+    if (n != app->used) {
+        ESP_LOGE(TAG, "short write: %u of %u bytes", (unsigned)n, (unsigned)app->used);
+        app->lost += app->buffered;
+        app->unsynced -= app->buffered;
+        app->used = 0;
+        app->buffered = 0;
+        return false;
+    }
+#if LOG_COMMIT_MARKERS
+    app->commit_crc = esp_rom_crc32_le(app->commit_crc, app->buf, app->used);
+#endif
+    app->end += (uint32_t)app->used;
+    app->used = 0;
+    app->buffered = 0;
+    LOG_CRASH_POINT(LOG_CRASH_APPEND);
+    return true;
+}
+
+static bool open_data(log_appender_t *app, const char *path)
+{
+#if LOG_SEGMENT_BYTES > 0
+    app->f = fopen(path, "r+b");
+    if (app->f) {
+        setvbuf(app->f, NULL, _IONBF, 0);
+        if (segment_load(app)) {
+            return true;
+        }
+    }
+    return segment_create(app);
+#else
+    app->f = fopen(path, "a+b");
+    if (!app->f) {
+        ESP_LOGE(TAG, "failed to open %s for append", path);
+        return false;
+    }
+    // We do our own sector-sized buffering; skip the stdio copy
+    setvbuf(app->f, NULL, _IONBF, 0);
+    fseek(app->f, 0, SEEK_END);
+    app->end = (uint32_t)ftell(app->f);
+    return true;
+#endif
+}
+
+bool log_appender_open(log_appender_t *app, const char *path)
+{
+    memset(app, 0, sizeof(*app));
+    app->path = path;
+#if LOG_STORAGE_SDMMC
+    if (!esp_ptr_dma_capable(app->buf)) {
+        ESP_LOGW(TAG, "append buffer is not DMA-capable, SD writes go through a bounce buffer");
+    }
+#endif
+#if LOG_COMMIT_MARKERS
+    commit_path(app->cmt_path, sizeof(app->cmt_path), path);
+#endif
+    if (!open_data(app, path)) {
+        return false;
+    }
+#if LOG_COMMIT_MARKERS
+    commit_recover(app);
+#endif
+    app->synced_end = app->end;
+    return true;
+}
+
+void log_appender_close(log_appender_t *app)
+{
+    if (!app->f) {
+        return;
+    }
+    log_appender_sync(app);
+    fclose(app->f);
+    app->f = NULL;
+#if LOG_COMMIT_MARKERS
+    commit_close(app);
+#endif
+}
+
+bool log_appender_append(log_appender_t *app, const void *data, size_t len)
+{
+    if (!app->f) {
+        return false;
+    }
+
+#if LOG_SEGMENT_BYTES > 0
+    if (len > LOG_SEGMENT_BYTES - app->end - app->used) {
+        if (!app->full) {
+            ESP_LOGW(TAG, "log segment full, dropping records until cleared");
+            app->full = true;
+        }
+        app->lost++;
+        return false;
+    }
+#endif
+
+    if (app->unsynced == 0) {
+        app->unsynced_since_us = esp_timer_get_time();
+    }
+    app->last_offset = app->end + (uint32_t)app->used;
+
+    // A record may straddle a boundary: the part up to it goes out with this buffer
+    const uint8_t *p = data;
+    size_t left = len;
+    while (left > 0) {
+        const size_t limit = write_limit(app);
+        const size_t n = (left < limit - app->used) ? left : limit - app->used;
+        memcpy(app->buf + app->used, p, n);
+        app->used += n;
+        p += n;
+        left -= n;
+        if (app->used == limit && !write_buffer(app)) {
+            return false;
+        }
+    }
+    app->buffered++;
+    app->unsynced++;
+
+    if (LOG_SYNC_EVERY_RECORDS > 0 && app->unsynced >= LOG_SYNC_EVERY_RECORDS) {
+        return log_appender_sync(app);
+    }
+    return true;
+}
+
+bool log_appender_sync(log_appender_t *app)
+{
+    if (!app->f) {
+        return false;
+    }
+
+    bool ok = write_buffer(app);
+    if (app->unsynced == 0) {
+        return ok;
+    }
+
+#if LOG_SEGMENT_BYTES > 0
+    // The file size never changes; the header carries the end of valid data
+    if (!segment_write_header(app)) {
+        ok = false;
+    }
+#endif
+
+    // fsync commits the FAT and directory entry; until then other readers see the old size
+    PAL_SYSVIEW_START(PAL_SYSVIEW_MARK_LOG_SYNC);
+    const int synced = fsync(fileno(app->f));
+    PAL_SYSVIEW_STOP(PAL_SYSVIEW_MARK_LOG_SYNC);
+    if (synced != 0) {
+        ESP_LOGE(TAG, "fsync failed");
+        ok = false;
+    } else {
+        app->syncs++;
+    }
+    LOG_CRASH_POINT(LOG_CRASH_SYNC);
+#if LOG_COMMIT_MARKERS
+    // The marker is the commit point: data past the last one is dropped at open
+    if (ok && app->end != app->commit_end && !commit_write(app)) {
+        ok = false;
+    }
+#endif
+    if (ok) {
+        app->synced_end = app->end;
+    }
+    app->unsynced = 0;
+    return ok;
+}
+
+bool log_appender_poll(log_appender_t *app)
+{
+    if (log_appender_poll_delay_ms(app) != 0) {
+        return true;
+    }
+    return log_appender_sync(app);
+}
+
+uint32_t log_appender_poll_delay_ms(const log_appender_t *app)
+{
+    if (LOG_SYNC_INTERVAL_MS == 0 || app->unsynced == 0) {
+        return UINT32_MAX;
+    }
+
+    const int64_t age_ms = (esp_timer_get_time() - app->unsynced_since_us) / 1000;
+    if (age_ms >= LOG_SYNC_INTERVAL_MS) {
+        return 0;
+    }
+    return (uint32_t)(LOG_SYNC_INTERVAL_MS - age_ms);
+}
+
+bool log_appender_truncate(log_appender_t *app)
+{
+#if LOG_SEGMENT_BYTES > 0
+    if (app->f) {
+        // Keep the allocation: an empty segment is just a reset end offset
+        app->used = 0;
+        app->buffered = 0;
+        app->unsynced = 0;
+        app->full = false;
+        app->end = DATA_START;
+        app->synced_end = DATA_START;
+        if (segment_write_header(app) && fsync(fileno(app->f)) == 0) {
+#if LOG_COMMIT_MARKERS
+            commit_reset(app);
+#endif
+            return true;
+        }
+    }
+#if LOG_COMMIT_MARKERS
+    commit_close(app);
+#endif
+    const uint32_t lost = app->lost;
+    const uint32_t syncs = app->syncs;
+    const bool ok = log_appender_open(app, app->path);
+    app->lost = lost;
+    app->syncs = syncs;
+    return ok;
+#else
+    if (app->f) {
+        fclose(app->f);
+        app->f = NULL;
+    }
+#if LOG_COMMIT_MARKERS
+    commit_close(app);
+    remove(app->cmt_path);
+#endif
+
+    FILE *f = fopen(app->path, "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "failed to truncate %s", app->path);
+        return false;
+    }
+    fclose(f);
+
+    const uint32_t lost = app->lost;
+    const uint32_t syncs = app->syncs;
+    if (!log_appender_open(app, app->path)) {
+        return false;
+    }
+    app->lost = lost;
+    app->syncs = syncs;
+    return true;
+#endif
+}
+
+void log_appender_data_range(const log_appender_t *app, uint32_t *start, uint32_t *end)
+{
+    *start = DATA_START;
+    *end = app->end;
+}
+
+size_t log_appender_read(log_appender_t *app, uint32_t offset, void *buf, size_t len)
+{
+    if (!app->f || offset >= app->end - DATA_START) {
+        return 0;
+    }
+    if (len > app->end - DATA_START - offset) {
+        len = app->end - DATA_START - offset;
+    }
+
+    size_t n = 0;
+    if (fseek(app->f, (long)(DATA_START + offset), SEEK_SET) == 0) {
+        n = fread(buf, 1, len, app->f);
+    }
+    // Segments are written in place, so the position must be back at the data end
+    fseek(app->f, (long)app->end, SEEK_SET);
+    return n;
+}
+
+void log_appender_remove(const char *path)
+{
+    remove(path);
+#if LOG_COMMIT_MARKERS
+    char cmt[sizeof(((log_appender_t *)0)->cmt_path)];
+    commit_path(cmt, sizeof(cmt), path);
+    remove(cmt);
+#endif
+}
+
+#if LOG_SEGMENT_BYTES > 0
+bool log_appender_recycle(const char *from, const char *to)
+{
+    FILE *f = fopen(from, "r+b");
+    if (!f) {
+        return false;
+    }
+    uint32_t end = 0;
+    // Emptied before the rename: a reset in between leaves an empty file under the
+    // old name, never old records under the new one
+    bool ok = segment_parse(f, from, &end) && header_write(f, DATA_START, 0) &&
+              fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = (fclose(f) == 0) && ok;
+#if LOG_COMMIT_MARKERS
+    char cmt[sizeof(((log_appender_t *)0)->cmt_path)];
+    commit_path(cmt, sizeof(cmt), from);
+    remove(cmt);
+    commit_path(cmt, sizeof(cmt), to);
+    remove(cmt);
+#endif
+    remove(to);
+    ok = ok && rename(from, to) == 0;
+    if (!ok) {
+        ESP_LOGW(TAG, "could not reuse %s as %s", from, to);
+    }
+    return ok;
+}
+#endif
+
+bool log_appender_probe(const char *path, uint32_t *bytes)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+
+    uint32_t end = 0;
+#if LOG_SEGMENT_BYTES > 0
+    bool ok = segment_parse(f, path, &end);
+#else
+    bool ok = fseek(f, 0, SEEK_END) == 0;
+    if (ok) {
+        end = (uint32_t)ftell(f);
+    }
+#endif
+    fclose(f);
+    *bytes = ok ? end - DATA_START : 0;
+    return ok;
+}
@@ -0,0 +1,124 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Keep-open, sector-buffered file appender with a sync policy.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_appender.h
+ * @brief   Buffered log file appender
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Records are collected in a RAM buffer (multiple of a FAT sector) and
+ *          written with one fwrite when it fills. fsync() runs every
+ *          LOG_SYNC_EVERY_RECORDS records, LOG_SYNC_INTERVAL_MS after the oldest
+ *          unsynced record, or on log_appender_sync(). Not thread-safe: the
+ *          caller serialises access.
+ *
+ * @note    With LOG_SEGMENT_BYTES > 0 the file is preallocated once at that size
+ *          and written in place; the data end offset lives in the segment header
+ *          and is rewritten on every sync.
+ *
+ * @note    With LOG_COMMIT_MARKERS every sync that commits new data appends a
+ *          marker to the file's commit journal, and log_appender_open() cuts the
+ *          file back to the newest marker whose CRC matches the data.
+ *******************************************************************************/
+#ifndef LOG_APPENDER_H
+#define LOG_APPENDER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "enc_log_config.h"
+
+// File offset of the first record byte
+#if LOG_SEGMENT_BYTES > 0
+#define LOG_APPENDER_DATA_START SEGMENT_HDR_BYTES
+#else
+#define LOG_APPENDER_DATA_START 0
+#endif
+
+typedef struct {
+    // Passed to FATFS as is: first, so the alignment costs no padding in front of it.
+    // Keep the appender in internal RAM (.bss) so the SD host can DMA from it.
+    uint8_t buf[LOG_APPEND_BUF_BYTES] __attribute__((aligned(LOG_APPEND_BUF_ALIGN)));
+    FILE *f;
+    const char *path;
+    size_t used;                // bytes waiting in buf
+    uint32_t end;               // file offset where buf will be written (end of data)
+    uint32_t synced_end;        // file offset up to which data is covered by fsync()
+    uint32_t last_offset;       // file offset of the last append
+    bool full;                  // segment has no room for the last append
+    uint32_t buffered;          // appends waiting in buf
+    uint32_t unsynced;          // appends not yet covered by fsync()
+    int64_t unsynced_since_us;  // time of the oldest unsynced append
+    uint32_t lost;              // appends lost to failed writes
+    uint32_t syncs;             // fsync() calls that covered appends
+#if LOG_SEGMENT_BYTES > 0
+    uint32_t seq_ceiling;       // set by the owner, written to the segment header on sync
+#endif
+#if LOG_COMMIT_MARKERS
+    FILE *cmt;                  // commit journal
+    char cmt_path[48];
+    uint32_t commit_seq;        // seq of the next marker
+    uint32_t commit_end;        // data end covered by the last marker
+    uint32_t commit_crc;        // CRC32 of the bytes written since then
+#endif
+} log_appender_t;
+
+// Open (create) the file for append. Keeps it open until log_appender_close().
+bool log_appender_open(log_appender_t *app, const char *path);
+void log_appender_close(log_appender_t *app);
+
+// Buffer one record; writes and syncs according to the policy.
+bool log_appender_append(log_appender_t *app, const void *data, size_t len);
+
+// Write the buffer to the file and fsync() it (directory entry and FAT included).
+bool log_appender_sync(log_appender_t *app);
+
+// Sync if LOG_SYNC_INTERVAL_MS has passed since the oldest unsynced record.
+bool log_appender_poll(log_appender_t *app);
+
+// Milliseconds until log_appender_poll() has work, UINT32_MAX if nothing is pending.
+uint32_t log_appender_poll_delay_ms(const log_appender_t *app);
+
+// Drop buffered data and truncate the file to zero length (to an empty segment
+// when preallocated; the allocation is kept).
+bool log_appender_truncate(log_appender_t *app);
+
+// Read record data starting at offset (relative to the data start). The write
+// position is kept, so this can be mixed with appends.
+size_t log_appender_read(log_appender_t *app, uint32_t offset, void *buf, size_t len);
+
+// Delete a closed log file together with its commit journal.
+void log_appender_remove(const char *path);
+
+#if LOG_SEGMENT_BYTES > 0
+// Turn the closed preallocated segment from into an empty segment named to, keeping
+// its clusters: a header write and a rename instead of a delete and a new preallocation.
+// False if from is not a segment of this size or the rename failed.
+bool log_appender_recycle(const char *from, const char *to);
+#endif
+
+// Record data bytes in a closed log file (not open in an appender). False if
+// the file is missing or not in the configured format.
+bool log_appender_probe(const char *path, uint32_t *bytes);
+
+// File offsets of the record data [start, end). Call log_appender_sync() first
+// so the range covers everything that was appended.
+void log_appender_data_range(const log_appender_t *app, uint32_t *start, uint32_t *end);
+
+#endif // LOG_APPENDER_H
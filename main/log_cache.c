@@ -0,0 +1,177 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Keep decrypted records and block groups for repeated queries.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_cache.c
+ * @brief   Bounded LRU cache of decrypted units for the streaming reader
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include "log_cache.h"
+
+#if LOG_READ_CACHE
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// Plaintext slots: PSRAM .bss with LOG_PSRAM, like the writer's bulk buffers
+#if LOG_PSRAM
+#define CACHE_ATTR EXT_RAM_BSS_ATTR
+#else
+#define CACHE_ATTR
+#endif
+
+#define CACHE_SLOTS     (READ_CACHE_SETS * READ_CACHE_WAYS)
+
+typedef struct {
+    log_cache_key_t key;
+    uint16_t len;               // plaintext bytes, 0 = free
+    uint32_t used;              // s_clock at the last hit or put
+} cache_tag_t;
+
+// --------------------
+// Globals
+// --------------------
+CACHE_ATTR static uint8_t s_data[CACHE_SLOTS][READ_CACHE_SLOT_BYTES];
+static cache_tag_t s_tags[CACHE_SLOTS];
+static uint32_t s_clock = 0;
+static log_cache_stats_t s_stats;
+// Created on first use: readers, the writer (key epochs) and the console all wipe
+static SemaphoreHandle_t s_lock = NULL;
+static StaticSemaphore_t s_lock_buf;
+static portMUX_TYPE s_init_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void cache_lock(void)
+{
+    portENTER_CRITICAL(&s_init_mux);
+    if (s_lock == NULL) {
+        s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+    }
+    portEXIT_CRITICAL(&s_init_mux);
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+}
+
+static void cache_unlock(void)
+{
+    xSemaphoreGive(s_lock);
+}
+
+// Slot of key and len in its set, -1 if none
+static int cache_find(const log_cache_key_t *key, uint32_t len)
+{
+    const uint32_t first = (key->crc % READ_CACHE_SETS) * READ_CACHE_WAYS;
+    for (uint32_t i = first; i < first + READ_CACHE_WAYS; i++) {
+        if (s_tags[i].len == len && s_tags[i].key.crc == key->crc &&
+            memcmp(s_tags[i].key.iv, key->iv, sizeof(key->iv)) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+// --------------------
+// Public API
+// --------------------
+void log_cache_key(const uint8_t *body, uint32_t len, log_cache_key_t *key)
+{
+    memset(key->iv, 0, sizeof(key->iv));
+    memcpy(key->iv, body, (len < sizeof(key->iv)) ? len : sizeof(key->iv));
+    key->crc = esp_rom_crc32_le(0, body, len);
+}
+
+bool log_cache_get(const log_cache_key_t *key, uint8_t *pt, uint32_t len)
+{
+    if (len == 0 || len > READ_CACHE_SLOT_BYTES) {
+        return false;
+    }
+    cache_lock();
+    const int slot = cache_find(key, len);
+    if (slot >= 0) {
+        memcpy(pt, s_data[slot], len);
+        s_tags[slot].used = ++s_clock;
+        s_stats.hits++;
+    } else {
+        s_stats.misses++;
+    }
+    cache_unlock();
+    return slot >= 0;
+}
+
+void log_cache_put(const log_cache_key_t *key, const uint8_t *pt, uint32_t len)
+{
+    if (len == 0 || len > READ_CACHE_SLOT_BYTES) {
+        return;
+    }
+    cache_lock();
+    int slot = cache_find(key, len);
+    if (slot < 0) {
+        // A free slot of the set, else its least recently used one
+        const uint32_t first = (key->crc % READ_CACHE_SETS) * READ_CACHE_WAYS;
+        slot = (int)first;
+        for (uint32_t i = first; i < first + READ_CACHE_WAYS; i++) {
+            if (s_tags[i].len == 0) {
+                slot = (int)i;
+                break;
+            }
+            if (s_tags[i].used < s_tags[slot].used) {
+                slot = (int)i;
+            }
+        }
+        if (s_tags[slot].len != 0) {
+            s_stats.evictions++;
+        } else {
+            s_stats.entries++;
+        }
+        s_tags[slot].key = *key;
+        s_tags[slot].len = (uint16_t)len;
+        memcpy(s_data[slot], pt, len);
+    }
+    s_tags[slot].used = ++s_clock;
+    cache_unlock();
+}
+
+void log_cache_wipe(void)
+{
+    cache_lock();
+    memset(s_data, 0, sizeof(s_data));
+    memset(s_tags, 0, sizeof(s_tags));
+    s_clock = 0;
+    s_stats.entries = 0;
+    s_stats.wipes++;
+    cache_unlock();
+}
+
+void log_cache_get_stats(log_cache_stats_t *stats)
+{
+    cache_lock();
+    *stats = s_stats;
+    cache_unlock();
+    stats->slots = CACHE_SLOTS;
+}
+
+uint32_t log_cache_buffer_bytes(void)
+{
+    return sizeof(s_data);
+}
+
+#endif // LOG_READ_CACHE
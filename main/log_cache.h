@@ -0,0 +1,72 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Keep decrypted records and block groups for repeated queries.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_cache.h
+ * @brief   Bounded LRU cache of decrypted units for the streaming reader
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Units are found by what is stored, not where: CRC32 of the IV (or
+ *          nonce) and ciphertext plus the first IV bytes. Snapshot offsets move
+ *          with retention, compaction and channels; the unit's own bytes do not,
+ *          and a rewritten unit has a fresh IV, so it simply misses.
+ *          READ_CACHE_SETS sets of READ_CACHE_WAYS slots of READ_CACHE_SLOT_BYTES,
+ *          least recently used slot of the set replaced. Thread safe (one mutex);
+ *          the plaintext is zeroed by log_cache_wipe().
+ *******************************************************************************/
+#ifndef LOG_CACHE_H
+#define LOG_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+typedef struct {
+    uint32_t crc;               // CRC32 of IV || ciphertext
+    uint8_t iv[8];              // their first bytes
+} log_cache_key_t;
+
+typedef struct {
+    uint32_t hits;              // units served from the cache
+    uint32_t misses;            // lookups that had to decrypt
+    uint32_t evictions;         // units replaced by newer ones
+    uint32_t wipes;             // log_cache_wipe() calls
+    uint32_t entries;           // units held now
+    uint32_t slots;             // units it can hold
+} log_cache_stats_t;
+
+#if LOG_READ_CACHE
+// Key of the unit whose log bytes from its IV on are body[0, len)
+void log_cache_key(const uint8_t *body, uint32_t len, log_cache_key_t *key);
+
+// Plaintext of the unit: its len bytes to pt. False on a miss.
+bool log_cache_get(const log_cache_key_t *key, uint8_t *pt, uint32_t len);
+
+// Keep the plaintext of a decrypted unit (ignored above READ_CACHE_SLOT_BYTES)
+void log_cache_put(const log_cache_key_t *key, const uint8_t *pt, uint32_t len);
+
+// Zero and drop every unit: the log was cleared, its key changed, or on demand
+void log_cache_wipe(void);
+
+void log_cache_get_stats(log_cache_stats_t *stats);
+
+// Bytes of the plaintext slots (PSRAM with LOG_PSRAM)
+uint32_t log_cache_buffer_bytes(void);
+#endif
+
+#endif // LOG_CACHE_H
@@ -0,0 +1,189 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Compact binary record serializer for the logging path.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_cbor.c
+ * @brief   Minimal CBOR encoder (RFC 8949)
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <string.h>
+
+#include "log_cbor.h"
+
+#define CBOR_MAJOR_UINT     0x00
+#define CBOR_MAJOR_NINT     0x20
+#define CBOR_MAJOR_BYTES    0x40
+#define CBOR_MAJOR_MAP      0xA0
+#define CBOR_MAJOR_MASK     0xE0
+#define CBOR_INFO_MASK      0x1F
+
+#define CBOR_INFO_UINT8     0x18
+#define CBOR_INFO_UINT16    0x19
+#define CBOR_INFO_UINT32    0x1A
+#define CBOR_INFO_UINT64    0x1B
+
+void log_cbor_init(log_cbor_t *c, uint8_t *buf, size_t cap)
+{
+    c->buf = buf;
+    c->cap = cap;
+    c->len = 0;
+    c->overflow = false;
+}
+
+static bool reserve(log_cbor_t *c, size_t n)
+{
+    if (c->overflow || c->cap - c->len < n) {
+        c->overflow = true;
+        return false;
+    }
+    return true;
+}
+
+void log_cbor_put_raw(log_cbor_t *c, uint8_t byte)
+{
+    if (reserve(c, 1)) {
+        c->buf[c->len++] = byte;
+    }
+}
+
+// Initial byte plus the shortest big-endian argument that holds value
+static void put_head(log_cbor_t *c, uint8_t major, uint64_t value)
+{
+    uint8_t info;
+    size_t n;
+    if (value < CBOR_INFO_UINT8) {
+        log_cbor_put_raw(c, (uint8_t)(major | value));
+        return;
+    } else if (value <= 0xFF) {
+        info = CBOR_INFO_UINT8;
+        n = 1;
+    } else if (value <= 0xFFFF) {
+        info = CBOR_INFO_UINT16;
+        n = 2;
+    } else if (value <= 0xFFFFFFFFu) {
+        info = CBOR_INFO_UINT32;
+        n = 4;
+    } else {
+        info = CBOR_INFO_UINT64;
+        n = 8;
+    }
+
+    if (!reserve(c, 1 + n)) {
+        return;
+    }
+    c->buf[c->len++] = major | info;
+    for (size_t i = 0; i < n; i++) {
+        c->buf[c->len++] = (uint8_t)(value >> (8 * (n - 1 - i)));
+    }
+}
+
+void log_cbor_put_map(log_cbor_t *c, uint32_t pairs)
+{
+    put_head(c, CBOR_MAJOR_MAP, pairs);
+}
+
+void log_cbor_put_uint(log_cbor_t *c, uint64_t value)
+{
+    put_head(c, CBOR_MAJOR_UINT, value);
+}
+
+void log_cbor_put_int(log_cbor_t *c, int64_t value)
+{
+    if (value >= 0) {
+        put_head(c, CBOR_MAJOR_UINT, (uint64_t)value);
+    } else {
+        // Major type 1 encodes -1 - n
+        put_head(c, CBOR_MAJOR_NINT, (uint64_t)(-1 - value));
+    }
+}
+
+void log_cbor_put_bytes(log_cbor_t *c, const uint8_t *data, size_t len)
+{
+    put_head(c, CBOR_MAJOR_BYTES, len);
+    if (len > 0 && reserve(c, len)) {
+        memcpy(c->buf + c->len, data, len);
+        c->len += len;
+    }
+}
+
+size_t log_cbor_finish(const log_cbor_t *c)
+{
+    return c->overflow ? 0 : c->len;
+}
+
+void log_cbor_reader_init(log_cbor_reader_t *r, const uint8_t *buf, size_t len)
+{
+    r->buf = buf;
+    r->len = len;
+    r->pos = 0;
+    r->error = false;
+}
+
+uint8_t log_cbor_get_raw(log_cbor_reader_t *r)
+{
+    if (r->error || r->pos >= r->len) {
+        r->error = true;
+        return 0;
+    }
+    return r->buf[r->pos++];
+}
+
+// Initial byte of the given major type and its argument (definite lengths only)
+static bool get_head(log_cbor_reader_t *r, uint8_t major, uint64_t *value)
+{
+    const uint8_t initial = log_cbor_get_raw(r);
+    const uint8_t info = initial & CBOR_INFO_MASK;
+    if (r->error || (initial & CBOR_MAJOR_MASK) != major || info > CBOR_INFO_UINT64) {
+        r->error = true;
+        return false;
+    }
+    if (info < CBOR_INFO_UINT8) {
+        *value = info;
+        return true;
+    }
+    const size_t n = (size_t)1 << (info - CBOR_INFO_UINT8);
+    if (r->len - r->pos < n) {
+        r->error = true;
+        return false;
+    }
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; i++) {
+        v = (v << 8) | r->buf[r->pos++];
+    }
+    *value = v;
+    return true;
+}
+
+bool log_cbor_get_map(log_cbor_reader_t *r, uint32_t *pairs)
+{
+    uint64_t v;
+    if (!get_head(r, CBOR_MAJOR_MAP, &v) || v > UINT32_MAX) {
+        r->error = true;
+        return false;
+    }
+    *pairs = (uint32_t)v;
+    return true;
+}
+
+bool log_cbor_get_uint(log_cbor_reader_t *r, uint64_t *value)
+{
+    return get_head(r, CBOR_MAJOR_UINT, value);
+}
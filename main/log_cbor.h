@@ -0,0 +1,77 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Compact binary record serializer for the logging path.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_cbor.h
+ * @brief   Minimal CBOR encoder (RFC 8949)
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Trimmed, bounds-checked version of the encoder in
+ *          optiga-trust-m/examples/tools/protected_update_data_set (cbor.c):
+ *          unsigned/negative integers, byte strings and map headers only.
+ *          Writing past the buffer sets an overflow flag instead of failing
+ *          every call, so a record is built first and checked once. The
+ *          reader takes the same subset back (maps and unsigned integers) with
+ *          a sticky error flag.
+ *******************************************************************************/
+#ifndef LOG_CBOR_H
+#define LOG_CBOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint8_t *buf;
+    size_t cap;
+    size_t len;
+    bool overflow;
+} log_cbor_t;
+
+void log_cbor_init(log_cbor_t *c, uint8_t *buf, size_t cap);
+
+// Raw byte (record header fields in front of the CBOR item)
+void log_cbor_put_raw(log_cbor_t *c, uint8_t byte);
+
+// Map with `pairs` key/value items following
+void log_cbor_put_map(log_cbor_t *c, uint32_t pairs);
+
+void log_cbor_put_uint(log_cbor_t *c, uint64_t value);
+void log_cbor_put_int(log_cbor_t *c, int64_t value);
+void log_cbor_put_bytes(log_cbor_t *c, const uint8_t *data, size_t len);
+
+// Encoded length, or 0 if the buffer overflowed
+size_t log_cbor_finish(const log_cbor_t *c);
+
+typedef struct {
+    const uint8_t *buf;
+    size_t len;
+    size_t pos;
+    bool error;
+} log_cbor_reader_t;
+
+void log_cbor_reader_init(log_cbor_reader_t *r, const uint8_t *buf, size_t len);
+
+// Raw byte (record header fields in front of the CBOR item)
+uint8_t log_cbor_get_raw(log_cbor_reader_t *r);
+
+// Map header; false (and error set) for any other item
+bool log_cbor_get_map(log_cbor_reader_t *r, uint32_t *pairs);
+
+bool log_cbor_get_uint(log_cbor_reader_t *r, uint64_t *value);
+
+#endif // LOG_CBOR_H
@@ -0,0 +1,518 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Side log channels: own segment files, index and retention.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_channel.c
+ * @brief   Segmented file logs of channels 1..LOG_CHANNELS-1
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    A cut-down log_store_fat.c per channel, sharing its index, seek and
+ *          retention helpers (log_segment.h): no manifest (a channel keeps at
+ *          most LOG_CHANNEL_SEGMENTS_MAX files, so the directory scan at open
+ *          is short), no SD tier, zone maps or spare segments, and a clear
+ *          deletes the files at once.
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include "log_channel.h"
+
+#if LOG_CHANNELS > 1
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+
+#include "enc_log.h"
+#include "log_appender.h"
+#include "log_segment.h"
+#include "log_time.h"
+#endif
+
+static const char *const s_names[] = {LOG_CHANNEL_NAMES};
+_Static_assert(sizeof(s_names) / sizeof(s_names[0]) >= LOG_CHANNELS,
+               "LOG_CHANNEL_NAMES needs a name per channel");
+
+#if LOG_CHANNELS > 1
+#define SIDE_CHANNELS   (LOG_CHANNELS - 1)
+
+static const uint32_t s_segment_bytes[] = {LOG_CHANNEL_SEGMENT_BYTES};
+static const uint32_t s_retain_segments[] = {LOG_CHANNEL_RETAIN_SEGMENTS};
+static const uint32_t s_retain_age_s[] = {LOG_CHANNEL_RETAIN_AGE_S};
+_Static_assert(sizeof(s_segment_bytes) / sizeof(s_segment_bytes[0]) >= SIDE_CHANNELS &&
+               sizeof(s_retain_segments) / sizeof(s_retain_segments[0]) >= SIDE_CHANNELS &&
+               sizeof(s_retain_age_s) / sizeof(s_retain_age_s[0]) >= SIDE_CHANNELS,
+               "LOG_CHANNEL_SEGMENT_BYTES / _RETAIN_SEGMENTS / _RETAIN_AGE_S need an entry per side channel");
+
+typedef struct {
+    log_appender_t app;         // first: keeps the buffer alignment free of padding
+    char path[48];              // segment open in app (the appender keeps the pointer)
+    FILE *idx;                  // its index sidecar
+    uint32_t idx_records;       // records since the last index entry
+    bool idx_first;             // next indexed record is the first since the segment opened
+    uint32_t format_offset;     // file offset of its format header, INDEX_NO_EPOCH if none
+    FILE *rd_file;              // read handle on a closed segment, kept between reads
+    uint32_t rd_id;
+    uint32_t first_id;          // oldest live segment
+    uint32_t last_id;           // segment open in app
+    uint32_t closed_bytes[LOG_CHANNEL_SEGMENTS_MAX];    // data bytes, by id % N
+    uint32_t dropped;
+    uint32_t pins;
+    uint32_t rotations;
+    uint32_t lost_closed;       // appender losses of closed segments
+} channel_t;
+
+// --------------------
+// Globals
+// --------------------
+static const char *TAG = "LOG_CHANNEL";
+static channel_t s_channels[SIDE_CHANNELS];
+
+// --------------------
+// Segments
+// --------------------
+static channel_t *channel(uint8_t ch)
+{
+    return (ch >= 1 && ch < LOG_CHANNELS) ? &s_channels[ch - 1] : NULL;
+}
+
+static void file_path(char *out, size_t n, uint8_t ch, uint32_t id, const char *ext)
+{
+    snprintf(out, n, LOG_MOUNT_POINT "/%s_%04lu.%s", s_names[ch], (unsigned long)id, ext);
+}
+
+static uint32_t data_limit(uint8_t ch)
+{
+#if LOG_SEGMENT_BYTES > 0
+    // Preallocated segments rotate when full
+    (void)ch;
+    return LOG_SEGMENT_BYTES - SEGMENT_HDR_BYTES;
+#else
+    return s_segment_bytes[ch - 1];
+#endif
+}
+
+static uint32_t retain_segments(uint8_t ch)
+{
+    const uint32_t n = s_retain_segments[ch - 1];
+    return (n < 2) ? 2 : (n > LOG_CHANNEL_SEGMENTS_MAX) ? LOG_CHANNEL_SEGMENTS_MAX : n;
+}
+
+static void close_read_handle(channel_t *c)
+{
+    if (c->rd_file) {
+        fclose(c->rd_file);
+        c->rd_file = NULL;
+    }
+}
+
+static void index_close(channel_t *c)
+{
+    if (c->idx) {
+        fclose(c->idx);
+        c->idx = NULL;
+    }
+}
+
+static void index_sync(channel_t *c)
+{
+    if (c->idx && fflush(c->idx) == 0) {
+        fsync(fileno(c->idx));
+    }
+}
+
+static void remove_segment(uint8_t ch, uint32_t id)
+{
+    channel_t *c = channel(ch);
+    char path[sizeof(c->path)];
+    if (c->rd_file && c->rd_id == id) {
+        close_read_handle(c);
+    }
+    file_path(path, sizeof(path), ch, id, "bin");
+    log_appender_remove(path);
+    file_path(path, sizeof(path), ch, id, "idx");
+    remove(path);
+}
+
+static uint32_t current_bytes(const channel_t *c)
+{
+    uint32_t start = 0;
+    uint32_t end = 0;
+    log_appender_data_range(&c->app, &start, &end);
+    return (end - start) + (uint32_t)c->app.used;
+}
+
+static bool open_current(uint8_t ch)
+{
+    channel_t *c = channel(ch);
+    char path[sizeof(c->path)];
+    file_path(c->path, sizeof(c->path), ch, c->last_id, "bin");
+    if (!log_appender_open(&c->app, c->path)) {
+        return false;
+    }
+    file_path(path, sizeof(path), ch, c->last_id, "idx");
+    c->idx = fopen(path, "ab");
+    if (!c->idx) {
+        ESP_LOGW(TAG, "failed to open index %s", path);
+    }
+    c->idx_records = 0;
+    c->idx_first = true;
+    c->format_offset = INDEX_NO_EPOCH;
+#if LOG_FORMAT_HEADER
+    // A new segment opens with the format header; an old one keeps the layout it has
+    uint8_t want[FORMAT_HDR_BYTES];
+    uint8_t header[FORMAT_HDR_BYTES];
+    enc_log_format_header(want);
+    if (current_bytes(c) == 0) {
+        if (log_appender_append(&c->app, want, sizeof(want))) {
+            c->format_offset = c->app.last_offset;
+        }
+    } else if (log_appender_read(&c->app, 0, header, sizeof(header)) == sizeof(header) &&
+               memcmp(header, want, sizeof(header)) == 0) {
+        c->format_offset = LOG_APPENDER_DATA_START;
+    }
+#endif
+    return true;
+}
+
+static void index_path(uint8_t ch, uint32_t id, char *out, size_t n)
+{
+    file_path(out, n, ch, id, "idx");
+}
+
+// The channel's segments for the log_segment.h helpers
+static void channel_segments(uint8_t ch, log_segments_t *segs)
+{
+    const channel_t *c = channel(ch);
+    segs->ch = ch;
+    segs->first_id = c->first_id;
+    segs->last_id = c->last_id;
+    segs->closed_bytes = c->closed_bytes;
+    segs->slots = LOG_CHANNEL_SEGMENTS_MAX;
+    segs->app = &c->app;
+    segs->idx = c->idx;
+    segs->index_path = index_path;
+}
+
+// Id range of the channel's files in the directory; older files past the segment count
+// (the limit was lowered) are deleted
+static void scan_segments(uint8_t ch)
+{
+    channel_t *c = channel(ch);
+    const size_t name_len = strlen(s_names[ch]);
+    uint32_t lo = 0;
+    uint32_t hi = 0;
+    DIR *dir = opendir(LOG_MOUNT_POINT);
+    if (dir) {
+        struct dirent *de;
+        while ((de = readdir(dir)) != NULL) {
+            unsigned long id = 0;
+            int used = 0;
+            if (strncmp(de->d_name, s_names[ch], name_len) == 0 && de->d_name[name_len] == '_' &&
+                sscanf(de->d_name + name_len + 1, "%lu%n", &id, &used) == 1 &&
+                strcmp(de->d_name + name_len + 1 + used, ".bin") == 0 && id > 0) {
+                lo = (lo == 0 || id < lo) ? (uint32_t)id : lo;
+                hi = (id > hi) ? (uint32_t)id : hi;
+            }
+        }
+        closedir(dir);
+    }
+
+    if (hi == 0) {
+        c->first_id = c->last_id = 1;
+        return;
+    }
+    const uint32_t keep = retain_segments(ch);
+    c->last_id = hi;
+    c->first_id = (hi - lo >= keep) ? hi - keep + 1 : lo;
+    for (uint32_t id = lo; id < c->first_id; id++) {
+        remove_segment(ch, id);
+    }
+}
+
+// --------------------
+// Retention
+// --------------------
+static void retain(uint8_t ch)
+{
+    channel_t *c = channel(ch);
+    const uint32_t keep = retain_segments(ch);
+    const uint64_t now_ms = (s_retain_age_s[ch - 1] > 0) ? log_time_now_ms() : 0;
+    for (;;) {
+        log_segments_t segs;
+        channel_segments(ch, &segs);
+        if (!log_segment_retire(&segs, keep, s_retain_age_s[ch - 1], now_ms, c->pins > 0)) {
+            break;
+        }
+        const uint32_t id = c->first_id++;
+        c->dropped += c->closed_bytes[id % LOG_CHANNEL_SEGMENTS_MAX];
+        remove_segment(ch, id);
+        ESP_LOGI(TAG, "%s: retention deleted segment %lu", s_names[ch], (unsigned long)id);
+    }
+}
+
+static bool rotate(uint8_t ch)
+{
+    channel_t *c = channel(ch);
+    c->closed_bytes[c->last_id % LOG_CHANNEL_SEGMENTS_MAX] = current_bytes(c);
+    log_appender_close(&c->app);
+    index_sync(c);
+    index_close(c);
+    c->lost_closed += c->app.lost;
+
+    c->last_id++;
+    c->rotations++;
+    retain(ch);
+    // Leftover from before a clear; the new segment starts empty
+    remove_segment(ch, c->last_id);
+    if (!open_current(ch)) {
+        return false;
+    }
+    ESP_LOGI(TAG, "%s: rotated to segment %lu (live %lu..%lu)", s_names[ch],
+             (unsigned long)c->last_id, (unsigned long)c->first_id, (unsigned long)c->last_id);
+    return true;
+}
+#endif // LOG_CHANNELS > 1
+
+// --------------------
+// Public API
+// --------------------
+const char *log_channel_name(uint8_t ch)
+{
+    return (ch < LOG_CHANNELS) ? s_names[ch] : "?";
+}
+
+#if LOG_CHANNELS > 1
+bool log_channel_open(void)
+{
+    bool ok = true;
+    for (uint8_t ch = 1; ch < LOG_CHANNELS; ch++) {
+        channel_t *c = channel(ch);
+        scan_segments(ch);
+        for (uint32_t id = c->first_id; id < c->last_id; id++) {
+            char path[sizeof(c->path)];
+            file_path(path, sizeof(path), ch, id, "bin");
+            if (!log_appender_probe(path, &c->closed_bytes[id % LOG_CHANNEL_SEGMENTS_MAX])) {
+                c->closed_bytes[id % LOG_CHANNEL_SEGMENTS_MAX] = 0;
+            }
+        }
+        if (!open_current(ch)) {
+            ESP_LOGE(TAG, "%s: failed to open segment %lu", s_names[ch], (unsigned long)c->last_id);
+            ok = false;
+            continue;
+        }
+#if LOG_FORMAT_HEADER
+        // Written by a build with another record layout: new records start a new segment
+        if (c->format_offset == INDEX_NO_EPOCH && current_bytes(c) > 0) {
+            ESP_LOGI(TAG, "%s: segment %lu is in another format", s_names[ch],
+                     (unsigned long)c->last_id);
+            ok = rotate(ch) && ok;
+        }
+#endif
+        retain(ch);
+        ESP_LOGI(TAG, "%s: segments %lu..%lu, %lu bytes", s_names[ch], (unsigned long)c->first_id,
+                 (unsigned long)c->last_id, (unsigned long)log_channel_size(ch));
+    }
+    return ok;
+}
+
+bool log_channel_append(uint8_t ch, const void *data, size_t len)
+{
+    channel_t *c = channel(ch);
+    if (c == NULL) {
+        return false;
+    }
+    const uint32_t bytes = current_bytes(c);
+    if (bytes > 0 && bytes + len > data_limit(ch) && !rotate(ch)) {
+        return false;
+    }
+    return log_appender_append(&c->app, data, len);
+}
+
+bool log_channel_index(uint8_t ch, uint32_t seq, uint32_t uptime_ms, uint64_t wall_base_ms,
+                       uint32_t records)
+{
+    channel_t *c = channel(ch);
+    if (c == NULL || !c->idx) {
+        return false;
+    }
+
+    bool ok = true;
+    if (c->idx_first || c->idx_records >= LOG_INDEX_EVERY) {
+        const log_segment_entry_t e = {seq, uptime_ms, c->app.last_offset, c->format_offset,
+                                       wall_base_ms};
+        ok = log_segment_index_write(c->idx, &e);
+        c->idx_records = 0;
+        c->idx_first = false;
+    }
+    c->idx_records += records;
+    return ok;
+}
+
+bool log_channel_seek(uint8_t ch, log_store_seek_t by, uint32_t value, log_store_entry_t *entry)
+{
+    if (channel(ch) == NULL) {
+        return false;
+    }
+    log_segments_t segs;
+    channel_segments(ch, &segs);
+    return log_segment_seek(&segs, by, value, entry);
+}
+
+bool log_channel_sync(void)
+{
+    bool ok = true;
+    for (size_t i = 0; i < SIDE_CHANNELS; i++) {
+        ok = log_appender_sync(&s_channels[i].app) && ok;
+        index_sync(&s_channels[i]);
+    }
+    return ok;
+}
+
+bool log_channel_poll(void)
+{
+    bool ok = true;
+    for (size_t i = 0; i < SIDE_CHANNELS; i++) {
+        channel_t *c = &s_channels[i];
+        if (log_appender_poll_delay_ms(&c->app) == 0) {
+            ok = log_appender_sync(&c->app) && ok;
+            index_sync(c);
+        } else {
+            ok = log_appender_poll(&c->app) && ok;
+        }
+    }
+    return ok;
+}
+
+uint32_t log_channel_poll_delay_ms(void)
+{
+    uint32_t delay_ms = UINT32_MAX;
+    for (size_t i = 0; i < SIDE_CHANNELS; i++) {
+        const uint32_t ms = log_appender_poll_delay_ms(&s_channels[i].app);
+        delay_ms = (ms < delay_ms) ? ms : delay_ms;
+    }
+    return delay_ms;
+}
+
+bool log_channel_clear(void)
+{
+    bool ok = true;
+    for (uint8_t ch = 1; ch < LOG_CHANNELS; ch++) {
+        channel_t *c = channel(ch);
+        c->dropped += log_channel_size(ch);
+        log_appender_close(&c->app);
+        c->lost_closed += c->app.lost;
+        close_read_handle(c);
+        index_close(c);
+        // Ids keep counting up so no name is reused by a reader
+        for (uint32_t id = c->first_id; id <= c->last_id; id++) {
+            remove_segment(ch, id);
+        }
+        c->first_id = c->last_id = c->last_id + 1;
+        remove_segment(ch, c->last_id);
+        ok = open_current(ch) && ok;
+    }
+    return ok;
+}
+
+uint32_t log_channel_size(uint8_t ch)
+{
+    const channel_t *c = channel(ch);
+    if (c == NULL) {
+        return 0;
+    }
+    log_segments_t segs;
+    channel_segments(ch, &segs);
+    uint32_t size = log_segment_bytes(&segs, c->last_id);
+    for (uint32_t id = c->first_id; id < c->last_id; id++) {
+        size += c->closed_bytes[id % LOG_CHANNEL_SEGMENTS_MAX];
+    }
+    return size;
+}
+
+size_t log_channel_read(uint8_t ch, uint32_t offset, void *buf, size_t len)
+{
+    channel_t *c = channel(ch);
+    if (c == NULL) {
+        return 0;
+    }
+    // Closed segments first, oldest to newest
+    for (uint32_t id = c->first_id; id < c->last_id; id++) {
+        const uint32_t seg_bytes = c->closed_bytes[id % LOG_CHANNEL_SEGMENTS_MAX];
+        if (offset >= seg_bytes) {
+            offset -= seg_bytes;
+            continue;
+        }
+
+        if (!c->rd_file || c->rd_id != id) {
+            char path[sizeof(c->path)];
+            close_read_handle(c);
+            file_path(path, sizeof(path), ch, id, "bin");
+            c->rd_file = fopen(path, "rb");
+            c->rd_id = id;
+            if (!c->rd_file) {
+                return 0;
+            }
+        }
+        if (len > seg_bytes - offset) {
+            len = seg_bytes - offset;
+        }
+        if (fseek(c->rd_file, (long)(LOG_APPENDER_DATA_START + offset), SEEK_SET) != 0) {
+            return 0;
+        }
+        return fread(buf, 1, len, c->rd_file);
+    }
+    return log_appender_read(&c->app, offset, buf, len);
+}
+
+uint32_t log_channel_dropped(uint8_t ch)
+{
+    const channel_t *c = channel(ch);
+    return (c != NULL) ? c->dropped : 0;
+}
+
+void log_channel_pin(uint8_t ch, bool pin)
+{
+    channel_t *c = channel(ch);
+    if (c == NULL) {
+        return;
+    }
+    if (pin) {
+        c->pins++;
+    } else if (c->pins > 0) {
+        c->pins--;
+    }
+}
+
+void log_channel_info(uint8_t ch, log_channel_info_t *info)
+{
+    const channel_t *c = channel(ch);
+    memset(info, 0, sizeof(*info));
+    if (c == NULL) {
+        return;
+    }
+    info->first_id = c->first_id;
+    info->last_id = c->last_id;
+    info->bytes = log_channel_size(ch);
+    info->dropped = c->dropped;
+    info->rotations = c->rotations;
+    info->lost = c->lost_closed + c->app.lost;
+}
+#endif
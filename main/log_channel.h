@@ -0,0 +1,99 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Side log channels: own segment files, index and retention.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_channel.h
+ * @brief   Segmented file logs of channels 1..LOG_CHANNELS-1
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Channel 0 is the log store (log_store.h); these calls take channels
+ *          1..LOG_CHANNELS-1. Each is a run of numbered segment files [first,
+ *          last] named after the channel, the last one open for append, each
+ *          with a sparse index sidecar in the store's entry format. A new
+ *          segment opens with the build's format header; an open segment in
+ *          another format is closed at open. The id range is recovered from the
+ *          directory at open. Retention drops the
+ *          oldest segment when a new one would exceed the channel's segment
+ *          count, and closed segments past the channel's age (unless pinned).
+ *          Offsets are as for log_store_read(): 0 is the oldest live byte.
+ *          Not thread-safe: the caller serialises access.
+ *******************************************************************************/
+#ifndef LOG_CHANNEL_H
+#define LOG_CHANNEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+#include "log_store.h"
+
+typedef struct {
+    uint32_t first_id;          // oldest live segment
+    uint32_t last_id;           // segment open for append
+    uint32_t bytes;             // live data bytes (log_channel_size())
+    uint32_t dropped;           // bytes dropped by retention and clears since open
+    uint32_t rotations;         // segments started since open
+    uint32_t lost;              // appends lost to failed writes
+} log_channel_info_t;
+
+// Name of channel ch (0..LOG_CHANNELS-1), from LOG_CHANNEL_NAMES.
+const char *log_channel_name(uint8_t ch);
+
+#if LOG_CHANNELS > 1
+// Open every side channel and recover its segment range (after the mount).
+bool log_channel_open(void);
+
+// Append log bytes to channel ch; starts the next segment when this one is full.
+bool log_channel_append(uint8_t ch, const void *data, size_t len);
+
+// Sparse index of channel ch for its last append, as log_store_index().
+bool log_channel_index(uint8_t ch, uint32_t seq, uint32_t uptime_ms, uint64_t wall_base_ms,
+                       uint32_t records);
+
+// Sparse index lookup in channel ch, as log_store_seek().
+bool log_channel_seek(uint8_t ch, log_store_seek_t by, uint32_t value, log_store_entry_t *entry);
+
+// Make everything appended to any channel durable.
+bool log_channel_sync(void);
+
+// Sync the channels whose LOG_SYNC_INTERVAL_MS has passed.
+bool log_channel_poll(void);
+
+// Milliseconds until log_channel_poll() has work, UINT32_MAX if nothing is pending.
+uint32_t log_channel_poll_delay_ms(void);
+
+// Drop every side channel's data; segment ids keep counting up.
+bool log_channel_clear(void);
+
+// Bytes of channel ch data. Call log_channel_sync() first to include buffered appends.
+uint32_t log_channel_size(uint8_t ch);
+
+// Read channel ch bytes starting at offset. Returns bytes read.
+size_t log_channel_read(uint8_t ch, uint32_t offset, void *buf, size_t len);
+
+// Bytes dropped from the front of channel ch since open, as log_store_dropped().
+uint32_t log_channel_dropped(uint8_t ch);
+
+// Nested pin of channel ch for snapshot readers: its age retention waits. The segment
+// count limit still applies.
+void log_channel_pin(uint8_t ch, bool pin);
+
+void log_channel_info(uint8_t ch, log_channel_info_t *info);
+#endif
+
+#endif // LOG_CHANNEL_H
@@ -0,0 +1,204 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : One byte stream for the console and the export, UART or native USB.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_console.c
+ * @brief   Console transport: UART driver or USB-Serial-JTAG driver
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+
+#include "log_console.h"
+
+#if LOG_CONSOLE_USB
+#include "soc/soc_caps.h"
+#include "driver/usb_serial_jtag.h"
+#if __has_include("driver/usb_serial_jtag_vfs.h")
+#include "driver/usb_serial_jtag_vfs.h"
+#define console_vfs_use_driver usb_serial_jtag_vfs_use_driver
+#else
+#include "esp_vfs_usb_serial_jtag.h"
+#define console_vfs_use_driver esp_vfs_usb_serial_jtag_use_driver
+#endif
+#if !SOC_USB_SERIAL_JTAG_SUPPORTED
+#error "LOG_CONSOLE_USB needs a target with USB-Serial-JTAG (ESP32-S3/C3/C6/H2)"
+#endif
+#else
+#include "driver/uart.h"
+#endif
+
+// --------------------
+// Globals
+// --------------------
+#if LOG_CONSOLE_USB
+static const char *TAG = "LOG_CONSOLE";
+static int s_pending = -1;                  // byte taken by log_console_wait_input()
+#else
+static QueueHandle_t s_uart_queue = NULL;   // UART driver events for the console
+#endif
+
+// --------------------
+// Public API
+// --------------------
+#if LOG_CONSOLE_USB
+void log_console_init(void)
+{
+    usb_serial_jtag_driver_config_t config = USB_SERIAL_JTAG_DRIVER_CONFIG_DEFAULT();
+    config.rx_buffer_size = LOG_CONSOLE_RX_BUF_BYTES;
+    config.tx_buffer_size = LOG_EXPORT_TX_BUF_BYTES;
+    if (usb_serial_jtag_driver_install(&config) != ESP_OK) {
+        ESP_LOGE(TAG, "USB-Serial-JTAG driver not installed");
+        return;
+    }
+    // ESP_LOG output queues behind the frames in the same TX buffer instead of racing
+    // the driver for the FIFO
+    console_vfs_use_driver();
+}
+
+// The driver has no event queue: wait for a byte and keep it for the next read
+bool log_console_wait_input(void)
+{
+    uint8_t ch;
+    if (s_pending < 0 && usb_serial_jtag_read_bytes(&ch, 1, portMAX_DELAY) == 1) {
+        s_pending = ch;
+    }
+    return true;
+}
+
+size_t log_console_read(void *buf, size_t len, TickType_t wait)
+{
+    uint8_t *p = buf;
+    size_t got = 0;
+    if (len > 0 && s_pending >= 0) {
+        p[got++] = (uint8_t)s_pending;
+        s_pending = -1;
+        wait = 0;
+    }
+    if (got < len) {
+        const int n = usb_serial_jtag_read_bytes(p + got, (uint32_t)(len - got), wait);
+        if (n > 0) {
+            got += (size_t)n;
+        }
+    }
+    return got;
+}
+
+void log_console_write(const void *buf, size_t len)
+{
+    const uint8_t *p = buf;
+    while (len > 0) {
+        const int n = usb_serial_jtag_write_bytes(p, len,
+                                                  pdMS_TO_TICKS(LOG_CONSOLE_USB_TX_TIMEOUT_MS));
+        if (n <= 0) {
+            // No host reading: the frames are lost anyway, the host asks again
+            return;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+}
+
+void log_console_wait_tx(void)
+{
+    // ESP_LOG goes through the same TX buffer (see init), behind what is queued
+}
+
+void log_console_flush_input(void)
+{
+    uint8_t drop[64];
+    s_pending = -1;
+    while (usb_serial_jtag_read_bytes(drop, sizeof(drop), 0) > 0) {
+    }
+}
+
+void log_console_set_baud(uint32_t baud)
+{
+    (void)baud;
+}
+#else
+void log_console_init(void)
+{
+    const uart_config_t uart_config = {
+        .baud_rate = LOG_UART_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+
+    // TX ring buffer for the binary export; console logging does not use the driver.
+    // The event queue wakes log_console_wait_input() on input
+    uart_driver_install(LOG_UART_NUM, LOG_CONSOLE_RX_BUF_BYTES, LOG_EXPORT_TX_BUF_BYTES,
+                        LOG_CONSOLE_EVENT_QUEUE, &s_uart_queue, 0);
+    uart_param_config(LOG_UART_NUM, &uart_config);
+    uart_set_pin(LOG_UART_NUM, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE,
+                 UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+}
+
+// Waits on the UART event queue. Bytes a command already read on (export, query line)
+// leave events that find nothing: the caller reads with no wait after this.
+bool log_console_wait_input(void)
+{
+    while (true) {
+        uart_event_t event;
+        if (xQueueReceive(s_uart_queue, &event, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (event.type == UART_FIFO_OVF || event.type == UART_BUFFER_FULL) {
+            uart_flush_input(LOG_UART_NUM);
+            xQueueReset(s_uart_queue);
+            return false;
+        }
+        if (event.type == UART_DATA) {
+            return true;
+        }
+    }
+}
+
+size_t log_console_read(void *buf, size_t len, TickType_t wait)
+{
+    const int n = uart_read_bytes(LOG_UART_NUM, buf, (uint32_t)len, wait);
+    return (n > 0) ? (size_t)n : 0;
+}
+
+void log_console_write(const void *buf, size_t len)
+{
+    uart_write_bytes(LOG_UART_NUM, buf, len);
+}
+
+void log_console_wait_tx(void)
+{
+    uart_wait_tx_done(LOG_UART_NUM, portMAX_DELAY);
+}
+
+void log_console_flush_input(void)
+{
+    uart_flush_input(LOG_UART_NUM);
+}
+
+void log_console_set_baud(uint32_t baud)
+{
+    uart_set_baudrate(LOG_UART_NUM, baud);
+}
+#endif
@@ -0,0 +1,60 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : One byte stream for the console and the export, UART or native USB.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_console.h
+ * @brief   Console transport: UART driver or USB-Serial-JTAG driver
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    LOG_CONSOLE_USB selects the transport at build time. The console
+ *          commands and the framed export (log_export.h) only see this
+ *          interface, so the protocol is the same on both; the USB side has
+ *          no line rate and runs the export at full-speed USB.
+ *******************************************************************************/
+#ifndef LOG_CONSOLE_H
+#define LOG_CONSOLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "enc_log_config.h"
+
+// Install the driver (RX and TX ring buffers). Call once at start.
+void log_console_init(void);
+
+// Block until console input arrives. False if input overflowed and was dropped.
+bool log_console_wait_input(void);
+
+// Up to len bytes, waiting up to wait ticks for the first; bytes read
+size_t log_console_read(void *buf, size_t len, TickType_t wait);
+
+// Queue bytes into the driver's TX ring buffer, blocking while it is full
+void log_console_write(const void *buf, size_t len);
+
+// Wait until the queued bytes are on the wire
+void log_console_wait_tx(void);
+
+// Drop buffered input
+void log_console_flush_input(void);
+
+// Switch the line rate (UART only, after log_console_wait_tx())
+void log_console_set_baud(uint32_t baud);
+
+#endif // LOG_CONSOLE_H
@@ -0,0 +1,138 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Reset the logger inside its store paths to test crash recovery.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_crash.c
+ * @brief   Crash points in the log store and their injected resets
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <string.h>
+
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_rom_sys.h"
+#include "esp_system.h"
+
+#include "log_crash.h"
+
+#if LOG_CRASH_TEST
+
+#define CRASH_MAGIC     0x43525348u     // "CRSH"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t point;
+} crash_state_t;
+
+// --------------------
+// Globals
+// --------------------
+static const char *TAG = "LOG_CRASH";
+// Not initialised at boot: tells the next boot where the reset came from
+static RTC_NOINIT_ATTR crash_state_t s_state;
+
+static const char *const s_names[LOG_CRASH_POINTS] = { "append", "sync", "index", "rotate", "compact" };
+static uint32_t s_hits[LOG_CRASH_POINTS];
+static volatile int32_t s_armed = -1;   // point, -1: none
+static uint32_t s_countdown = 0;
+
+// --------------------
+// Public API
+// --------------------
+bool log_crash_init(log_crash_point_t *point)
+{
+    const bool fired = s_state.magic == CRASH_MAGIC && s_state.point < LOG_CRASH_POINTS &&
+                       esp_reset_reason() == ESP_RST_SW;
+    if (fired) {
+        *point = (log_crash_point_t)s_state.point;
+    }
+    s_state.magic = 0;
+#if LOG_CRASH_GPIO >= 0
+    const gpio_config_t io = {
+        .pin_bit_mask = 1ULL << LOG_CRASH_GPIO,
+        .mode = GPIO_MODE_OUTPUT,
+    };
+    gpio_config(&io);
+    gpio_set_level(LOG_CRASH_GPIO, 0);
+#endif
+    return fired;
+}
+
+void log_crash_hits(uint32_t hits[LOG_CRASH_POINTS])
+{
+    memcpy(hits, s_hits, sizeof(s_hits));
+}
+
+void log_crash_reset_hits(void)
+{
+    memset(s_hits, 0, sizeof(s_hits));
+}
+
+bool log_crash_arm(uint32_t mask, log_crash_point_t *point)
+{
+    uint32_t candidates[LOG_CRASH_POINTS];
+    unsigned n = 0;
+    for (unsigned p = 0; p < LOG_CRASH_POINTS; p++) {
+        if ((mask & (1u << p)) && s_hits[p] > 0) {
+            candidates[n++] = p;
+        }
+    }
+    if (n == 0) {
+        return false;
+    }
+    const uint32_t p = candidates[esp_random() % n];
+    // As often again as in the run before, so it fires about as far into the next one
+    s_countdown = 1 + esp_random() % s_hits[p];
+    s_armed = (int32_t)p;
+    *point = (log_crash_point_t)p;
+    ESP_LOGI(TAG, "armed: %s, pass %lu", s_names[p], (unsigned long)s_countdown);
+    return true;
+}
+
+void log_crash_disarm(void)
+{
+    s_armed = -1;
+}
+
+void log_crash_hit(log_crash_point_t point)
+{
+    s_hits[point]++;
+    if (s_armed != (int32_t)point || --s_countdown > 0) {
+        return;
+    }
+    s_state.point = point;
+    s_state.magic = CRASH_MAGIC;
+#if LOG_CRASH_GPIO >= 0
+    // The switch cuts the storage supply; reset anyway if the chip is still up after it
+    gpio_set_level(LOG_CRASH_GPIO, 1);
+    esp_rom_delay_us(LOG_CRASH_GPIO_HOLD_MS * 1000);
+#endif
+    esp_restart();
+}
+
+const char *log_crash_point_name(log_crash_point_t point)
+{
+    return (point < LOG_CRASH_POINTS) ? s_names[point] : "?";
+}
+
+#endif // LOG_CRASH_TEST
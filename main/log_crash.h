@@ -0,0 +1,80 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Reset the logger inside its store paths to test crash recovery.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_crash.h
+ * @brief   Crash points in the log store and their injected resets
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    The stores call LOG_CRASH_POINT() at the places where a power loss
+ *          leaves the most to recover: data written but not synced, data synced
+ *          without its commit marker or index entries, a page programmed over an
+ *          erased sector, a segment closed before the next one is open. Nothing is
+ *          compiled in without LOG_CRASH_TEST. Once armed, the chosen point resets
+ *          the chip on its n-th pass (software reset, or LOG_CRASH_GPIO first asks
+ *          an external switch to cut the storage supply). Which point fired is kept
+ *          in RTC memory for the next boot: a cut of the whole board loses it.
+ *******************************************************************************/
+#ifndef LOG_CRASH_H
+#define LOG_CRASH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+typedef enum {
+    LOG_CRASH_APPEND,           // data written (FAT cache, or a full raw page) but not synced
+    LOG_CRASH_SYNC,             // sync: data durable, commit marker or last page not yet
+    LOG_CRASH_INDEX,            // data synced, index entries not yet
+    LOG_CRASH_ROTATE,           // segment closed and manifest written, next one not open
+                                // (raw store: a sector erased, its first page not programmed)
+    LOG_CRASH_COMPACT,          // compacted copy durable, old segment deleted, copy not renamed
+    LOG_CRASH_POINTS,
+} log_crash_point_t;
+
+#define LOG_CRASH_ALL ((1u << LOG_CRASH_POINTS) - 1)
+
+#if LOG_CRASH_TEST
+
+#define LOG_CRASH_POINT(point) log_crash_hit(point)
+
+// Configure LOG_CRASH_GPIO. True if this boot follows an injected crash; *point is
+// where it fired. Call once, before enc_log_init().
+bool log_crash_init(log_crash_point_t *point);
+
+// Passes through each point since the last reset of the counts
+void log_crash_hits(uint32_t hits[LOG_CRASH_POINTS]);
+void log_crash_reset_hits(void);
+
+// Arm a random point of mask among those passed since the last reset of the counts, to
+// fire on a random pass within as many passes again. False if none of them was passed.
+bool log_crash_arm(uint32_t mask, log_crash_point_t *point);
+void log_crash_disarm(void);
+
+// Store paths (writer task, file lock held): count the pass, reset if it is due
+void log_crash_hit(log_crash_point_t point);
+
+const char *log_crash_point_name(log_crash_point_t point);
+
+#else
+
+#define LOG_CRASH_POINT(point) ((void)0)
+
+#endif // LOG_CRASH_TEST
+
+#endif // LOG_CRASH_H
@@ -0,0 +1,151 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Delta-encode the sample records of a block group.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_delta.c
+ * @brief   Base + zig-zag varint delta encoding of seq / uptime columns
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include "log_delta.h"
+
+// Longest LEB128 encoding of a 64-bit value
+#define DELTA_VARINT_MAX_BYTES  10
+
+typedef struct {
+    uint8_t *buf;
+    size_t cap;
+    size_t len;
+    bool overflow;              // sticky: set once a value did not fit
+} delta_writer_t;
+
+typedef struct {
+    const uint8_t *buf;
+    size_t len;
+    size_t pos;
+    bool error;                 // sticky: truncated or over-long varint
+} delta_reader_t;
+
+// --------------------
+// Varints
+// --------------------
+static void put_varint(delta_writer_t *w, uint64_t value)
+{
+    do {
+        if (w->len == w->cap) {
+            w->overflow = true;
+            return;
+        }
+        const uint8_t low = (uint8_t)(value & 0x7F);
+        value >>= 7;
+        w->buf[w->len++] = (uint8_t)(low | (value ? 0x80 : 0));
+    } while (value);
+}
+
+// Small positive and negative steps both stay small: 0, -1, 1, -2 -> 0, 1, 2, 3
+static void put_delta(delta_writer_t *w, uint64_t prev, uint64_t cur)
+{
+    const int64_t d = (int64_t)(cur - prev);
+    put_varint(w, ((uint64_t)d << 1) ^ (uint64_t)(d >> 63));
+}
+
+static uint64_t get_varint(delta_reader_t *r)
+{
+    uint64_t value = 0;
+    for (unsigned i = 0; i < DELTA_VARINT_MAX_BYTES; i++) {
+        if (r->pos == r->len) {
+            break;
+        }
+        const uint8_t b = r->buf[r->pos++];
+        value |= (uint64_t)(b & 0x7F) << (7 * i);
+        if ((b & 0x80) == 0) {
+            return value;
+        }
+    }
+    r->error = true;
+    return 0;
+}
+
+static uint64_t get_delta(delta_reader_t *r, uint64_t prev)
+{
+    const uint64_t z = get_varint(r);
+    return prev + ((z >> 1) ^ (uint64_t)-(int64_t)(z & 1));
+}
+
+// --------------------
+// Public API
+// --------------------
+size_t log_delta_encode(const log_delta_batch_t *b, bool columnar, uint8_t *dst, size_t cap)
+{
+    if (b->count == 0 || b->count > LOG_BATCH_RECORDS || cap == 0) {
+        return 0;
+    }
+    delta_writer_t w = {.buf = dst, .cap = cap, .len = 0, .overflow = false};
+    dst[w.len++] = (uint8_t)((columnar ? LOG_DELTA_FLAG_COLUMNAR : 0) |
+                             (b->format == RECORD_FORMAT_CBOR ? LOG_DELTA_FLAG_CBOR : 0) |
+                             (b->format == RECORD_FORMAT_PACKED ? LOG_DELTA_FLAG_PACKED : 0));
+    put_varint(&w, b->seq[0]);
+    put_varint(&w, b->uptime_ms[0]);
+    if (columnar) {
+        for (size_t i = 1; i < b->count; i++) {
+            put_delta(&w, b->seq[i - 1], b->seq[i]);
+        }
+        for (size_t i = 1; i < b->count; i++) {
+            put_delta(&w, b->uptime_ms[i - 1], b->uptime_ms[i]);
+        }
+    } else {
+        for (size_t i = 1; i < b->count; i++) {
+            put_delta(&w, b->seq[i - 1], b->seq[i]);
+            put_delta(&w, b->uptime_ms[i - 1], b->uptime_ms[i]);
+        }
+    }
+    return w.overflow ? 0 : w.len;
+}
+
+bool log_delta_decode(const uint8_t *src, size_t len, size_t count, log_delta_batch_t *b)
+{
+    if (count == 0 || count > LOG_BATCH_RECORDS || len == 0 ||
+        (src[0] & ~(LOG_DELTA_FLAG_COLUMNAR | LOG_DELTA_FLAG_CBOR | LOG_DELTA_FLAG_PACKED)) != 0 ||
+        ((src[0] & LOG_DELTA_FLAG_CBOR) && (src[0] & LOG_DELTA_FLAG_PACKED))) {
+        return false;
+    }
+    delta_reader_t r = {.buf = src, .len = len, .pos = 1, .error = false};
+    const bool columnar = (src[0] & LOG_DELTA_FLAG_COLUMNAR) != 0;
+    b->format = (src[0] & LOG_DELTA_FLAG_PACKED) ? RECORD_FORMAT_PACKED
+              : (src[0] & LOG_DELTA_FLAG_CBOR)   ? RECORD_FORMAT_CBOR
+                                                 : RECORD_FORMAT_JSON;
+    b->count = count;
+    b->seq[0] = get_varint(&r);
+    b->uptime_ms[0] = get_varint(&r);
+    if (columnar) {
+        for (size_t i = 1; i < count; i++) {
+            b->seq[i] = get_delta(&r, b->seq[i - 1]);
+        }
+        for (size_t i = 1; i < count; i++) {
+            b->uptime_ms[i] = get_delta(&r, b->uptime_ms[i - 1]);
+        }
+    } else {
+        for (size_t i = 1; i < count; i++) {
+            b->seq[i] = get_delta(&r, b->seq[i - 1]);
+            b->uptime_ms[i] = get_delta(&r, b->uptime_ms[i - 1]);
+        }
+    }
+    return !r.error;
+}
@@ -0,0 +1,56 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Delta-encode the sample records of a block group.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_delta.h
+ * @brief   Base + zig-zag varint delta encoding of seq / uptime columns
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Plaintext of a 'D' block group:
+ *          flags (1B) | seq[0] (varint) | uptime_ms[0] (varint) | deltas of records
+ *          1..count-1 to the previous record, zig-zag varints (LEB128, 7 bits per
+ *          byte), either seq, uptime per record (row) or all seq then all uptime
+ *          deltas (columnar). The record count is in the group header. No ESP-IDF
+ *          dependencies: also built into the Linux host exporter.
+ *******************************************************************************/
+#ifndef LOG_DELTA_H
+#define LOG_DELTA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+#define LOG_DELTA_FLAG_COLUMNAR 0x01    // deltas column by column
+#define LOG_DELTA_FLAG_CBOR     0x02    // records are CBOR (else JSON text)
+#define LOG_DELTA_FLAG_PACKED   0x04    // records are packed (log_schema.h)
+
+typedef struct {
+    uint64_t seq[LOG_BATCH_RECORDS];
+    uint64_t uptime_ms[LOG_BATCH_RECORDS];
+    size_t count;
+    uint8_t format;             // RECORD_FORMAT_* of the records
+} log_delta_batch_t;
+
+// Encode the batch into dst. Returns the encoded length, 0 if it does not fit in cap.
+size_t log_delta_encode(const log_delta_batch_t *b, bool columnar, uint8_t *dst, size_t cap);
+
+// Decode count records (trailing zero padding is ignored). False on a malformed group.
+bool log_delta_decode(const uint8_t *src, size_t len, size_t count, log_delta_batch_t *b);
+
+#endif // LOG_DELTA_H
@@ -0,0 +1,57 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Rate-limited diagnostics for the record and block group paths.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_diag.c
+ * @brief   Hot-path log lines: compile-time level, per-site rate limit
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+#include "log_diag.h"
+
+// --------------------
+// Globals
+// --------------------
+// Sites are shared by the writer, storage and compaction tasks
+static portMUX_TYPE s_diag_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// --------------------
+// Public API
+// --------------------
+bool log_diag_allow(log_diag_site_t *site, uint32_t interval_ms, uint32_t *held)
+{
+    const uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    bool allow = false;
+    portENTER_CRITICAL(&s_diag_mux);
+    if (!site->used || now_ms - site->last_ms >= interval_ms) {
+        *held = site->held;
+        site->held = 0;
+        site->last_ms = now_ms;
+        site->used = true;
+        allow = true;
+    } else {
+        site->held++;
+    }
+    portEXIT_CRITICAL(&s_diag_mux);
+    return allow;
+}
@@ -0,0 +1,69 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Rate-limited diagnostics for the record and block group paths.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_diag.h
+ * @brief   Hot-path log lines: compile-time level, per-site rate limit
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    A line on the console at 115200 baud takes longer than encrypting the
+ *          record it reports. LOG_DIAG() sites above LOG_DIAG_LEVEL compile to
+ *          nothing; the others print at most once per LOG_DIAG_RATE_MS each and
+ *          count what they hold back, shown with the next line that gets out.
+ *          The writer prints a summary every LOG_DIAG_SUMMARY_MS instead of a
+ *          line per record or group.
+ *******************************************************************************/
+#ifndef LOG_DIAG_H
+#define LOG_DIAG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_log.h"
+
+#include "enc_log_config.h"
+
+// Rate limit of one call site (LOG_DIAG() keeps one per site)
+typedef struct {
+    uint32_t last_ms;           // uptime of the last line let through
+    uint32_t held;              // lines held back since
+    bool used;
+} log_diag_site_t;
+
+// True if site may print now; *held is the count it held back since its last line
+// (then reset). Safe from any task.
+bool log_diag_allow(log_diag_site_t *site, uint32_t interval_ms, uint32_t *held);
+
+// level: ESP_LOG_ERROR .. ESP_LOG_VERBOSE. Sites above LOG_DIAG_LEVEL are removed at
+// compile time, arguments included.
+#define LOG_DIAG(level, tag, fmt, ...)                                                     \
+    do {                                                                                   \
+        if ((level) <= LOG_DIAG_LEVEL) {                                                   \
+            static log_diag_site_t diag_site_;                                             \
+            uint32_t diag_held_;                                                           \
+            if (log_diag_allow(&diag_site_, LOG_DIAG_RATE_MS, &diag_held_)) {              \
+                if (diag_held_ > 0) {                                                      \
+                    ESP_LOG_LEVEL_LOCAL(level, tag, fmt " (%lu more held back)",           \
+                                        ##__VA_ARGS__, (unsigned long)diag_held_);         \
+                } else {                                                                   \
+                    ESP_LOG_LEVEL_LOCAL(level, tag, fmt, ##__VA_ARGS__);                   \
+                }                                                                          \
+            }                                                                              \
+        }                                                                                  \
+    } while (0)
+
+#endif // LOG_DIAG_H
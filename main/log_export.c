@@ -0,0 +1,227 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Binary bulk export of the log over the console (UART or USB).
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_export.c
+ * @brief   Framed binary log export
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "enc_log.h"
+#include "log_console.h"
+#include "log_export.h"
+
+static const char *TAG = "LOG_EXPORT";
+static uint8_t s_chunk[LOG_EXPORT_CHUNK_BYTES];
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+static bool read_request(uint8_t *req)
+{
+    size_t got = 0;
+    const TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(LOG_EXPORT_REQ_TIMEOUT_MS);
+    while (got < EXPORT_REQ_BYTES) {
+        const TickType_t now = xTaskGetTickCount();
+        if ((int32_t)(deadline - now) <= 0) {
+            return false;
+        }
+        got += log_console_read(req + got, EXPORT_REQ_BYTES - got, deadline - now);
+    }
+    return true;
+}
+
+// The driver copies into its TX ring buffer and drains it from its ISR, so reading
+// the next chunk overlaps with the bytes still on the wire. A frame goes
+// out in pieces: header, payload pieces (each into the running CRC), CRC.
+static uint32_t frame_begin(uint8_t type, uint32_t offset, uint16_t len)
+{
+    uint8_t hdr[EXPORT_HDR_BYTES];
+
+    hdr[0] = EXPORT_SYNC0;
+    hdr[1] = EXPORT_SYNC1;
+    hdr[2] = type;
+    hdr[3] = (uint8_t)len;
+    hdr[4] = (uint8_t)(len >> 8);
+    put_le32(hdr + 5, offset);
+    log_console_write(hdr, sizeof(hdr));
+    return esp_rom_crc32_le(0, hdr + 2, EXPORT_HDR_BYTES - 2);
+}
+
+static uint32_t frame_piece(uint32_t crc, const uint8_t *payload, size_t len)
+{
+    if (len > 0) {
+        log_console_write(payload, len);
+    }
+    return esp_rom_crc32_le(crc, payload, len);
+}
+
+static void frame_end(uint32_t crc)
+{
+    uint8_t crc_le[4];
+    put_le32(crc_le, crc);
+    log_console_write(crc_le, sizeof(crc_le));
+}
+
+static void send_frame(uint8_t type, uint32_t offset, const uint8_t *payload, uint16_t len)
+{
+    frame_end(frame_piece(frame_begin(type, offset, len), payload, len));
+}
+
+// One data frame of len bytes at offset. On the raw store the payload is sent from
+// the flash mapping page by page, without a copy; log_console_write() has copied each
+// piece before the next view moves the window. False if the bytes are gone: the frame
+// is completed with zeros and a CRC the host rejects, so nothing bogus is written.
+static bool send_data(enc_log_snapshot_t *snap, uint32_t offset, uint16_t len)
+{
+    uint32_t crc = frame_begin(EXPORT_FRAME_DATA, offset, len);
+    uint32_t pos = offset;
+    bool ok = true;
+
+    while (pos < offset + len) {
+        size_t n = offset + len - pos;
+        const uint8_t *p = enc_log_snapshot_view(snap, pos, &n);
+        if (p == NULL) {
+            n = enc_log_snapshot_read(snap, pos, s_chunk, n);
+            p = s_chunk;
+        }
+        if (n == 0) {
+            ok = false;
+            break;
+        }
+        crc = frame_piece(crc, p, n);
+        pos += (uint32_t)n;
+    }
+    // A drop the store could not defer may have erased mapped bytes while they were sent
+    ok = ok && enc_log_snapshot_kept(snap, offset);
+    if (!ok) {
+        memset(s_chunk, 0, sizeof(s_chunk));
+        while (pos < offset + len) {
+            const size_t n = (offset + len - pos < sizeof(s_chunk)) ? offset + len - pos
+                                                                     : sizeof(s_chunk);
+            crc = frame_piece(crc, s_chunk, n);
+            pos += (uint32_t)n;
+        }
+        crc = ~crc;
+    }
+    frame_end(crc);
+    return ok;
+}
+
+static void set_baud(uint32_t baud)
+{
+    log_console_wait_tx();
+    log_console_set_baud(baud);
+    // Give the host time to reopen its port at the new rate
+    vTaskDelay(pdMS_TO_TICKS(LOG_EXPORT_SWITCH_MS));
+    log_console_flush_input();
+}
+
+void log_export_run(void)
+{
+    uint8_t req[EXPORT_REQ_BYTES];
+    if (!read_request(req)) {
+        ESP_LOGW(TAG, "no export request received");
+        return;
+    }
+    if (req[0] != EXPORT_REQ_MAGIC0 || req[1] != EXPORT_REQ_MAGIC1 ||
+        get_le32(req + 10) != esp_rom_crc32_le(0, req, 10)) {
+        ESP_LOGW(TAG, "bad export request");
+        return;
+    }
+
+    uint32_t baud = get_le32(req + 2);
+    uint32_t offset = get_le32(req + 6);
+    // USB has no line rate to switch: the ACK keeps the host at the console rate
+    if (LOG_CONSOLE_USB || baud < LOG_UART_BAUD || baud > LOG_EXPORT_MAX_BAUD) {
+        baud = LOG_UART_BAUD;
+    }
+
+    // Records written during the export go to the next one; the writer keeps
+    // appending meanwhile and retention waits for the close
+    enc_log_snapshot_t snap;
+    enc_log_snapshot_open(&snap);
+    const uint32_t size = snap.size;
+    if (offset > size) {
+        offset = size;
+    }
+
+    const esp_log_level_t level = esp_log_level_get("*");
+    esp_log_level_set("*", ESP_LOG_NONE);
+
+    uint8_t ack[8];
+    put_le32(ack, size);
+    put_le32(ack + 4, baud);
+    send_frame(EXPORT_FRAME_ACK, offset, ack, sizeof(ack));
+    if (baud != LOG_UART_BAUD) {
+        set_baud(baud);
+    }
+
+    const uint32_t start = offset;
+    bool ok = true;
+    while (offset < size) {
+        size_t want = size - offset;
+        if (want > sizeof(s_chunk)) {
+            want = sizeof(s_chunk);
+        }
+        if (!send_data(&snap, offset, (uint16_t)want)) {
+            ok = false;
+            break;
+        }
+        offset += (uint32_t)want;
+    }
+
+    uint8_t end[4];
+    put_le32(end, size);
+    send_frame(ok ? EXPORT_FRAME_END : EXPORT_FRAME_ERR, offset, end, sizeof(end));
+    enc_log_snapshot_close(&snap);
+    if (baud != LOG_UART_BAUD) {
+        set_baud(LOG_UART_BAUD);
+    } else {
+        log_console_wait_tx();
+    }
+
+    esp_log_level_set("*", level);
+    if (ok) {
+#if LOG_CONSOLE_USB
+        ESP_LOGI(TAG, "exported %u bytes over USB", (unsigned)(offset - start));
+#else
+        ESP_LOGI(TAG, "exported %u bytes at %u baud", (unsigned)(offset - start), (unsigned)baud);
+#endif
+    } else {
+        ESP_LOGE(TAG, "export stopped: read failed at offset %u", (unsigned)offset);
+    }
+}
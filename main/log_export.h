@@ -0,0 +1,58 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Binary bulk export of the log over the console (UART or USB).
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_export.h
+ * @brief   Framed binary log export
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Protocol (all integers LE, CRC32 = zlib/IEEE):
+ *          1. Host sends 'x', then a request:
+ *             "XR" (2B) | baud (4B) | start offset (4B) | CRC32 of the first 10B (4B)
+ *          2. Device answers at the console baud with an ACK frame
+ *             (payload: log size (4B) | accepted baud (4B)), then both sides
+ *             switch to the accepted baud.
+ *          3. Device sends DATA frames from the start offset to the end, then an
+ *             END frame (payload: log size), and returns to the console baud.
+ *          Frame: 0xA5 0x5A | type (1B) | payload bytes (2B) | log offset (4B) |
+ *                 payload | CRC32 of type..payload (4B)
+ *          To resume, the host repeats the request with the last good offset.
+ *          ESP_LOG output is muted while frames are on the wire.
+ *          Over USB-Serial-JTAG (LOG_CONSOLE_USB) the frames are the same; the
+ *          ACK always accepts the console baud, so neither side switches.
+ *******************************************************************************/
+#ifndef LOG_EXPORT_H
+#define LOG_EXPORT_H
+
+#include <stdint.h>
+
+#define EXPORT_SYNC0        0xA5
+#define EXPORT_SYNC1        0x5A
+#define EXPORT_FRAME_ACK    0x01
+#define EXPORT_FRAME_DATA   0x02
+#define EXPORT_FRAME_END    0x03
+#define EXPORT_FRAME_ERR    0x04
+
+#define EXPORT_REQ_MAGIC0   'X'
+#define EXPORT_REQ_MAGIC1   'R'
+#define EXPORT_REQ_BYTES    14
+#define EXPORT_HDR_BYTES    9
+
+// Run one export session (console command 'x'). Blocks until done.
+void log_export_run(void);
+
+#endif // LOG_EXPORT_H
@@ -0,0 +1,214 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Interrupt-safe staging of compact records ahead of the record ring.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_isr.c
+ * @brief   Per-core lock-free buffers filled from interrupt handlers
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+#include "log_isr.h"
+#include "log_seq.h"
+
+#if LOG_ISR_SUBMIT
+
+#if LOG_ISR_RESYNC_MS < 1 || LOG_ISR_RESYNC_MS > 4000
+#error "LOG_ISR_RESYNC_MS must be 1..4000 (inside half the cycle counter wrap)"
+#endif
+
+#define ISR_MASK        (LOG_ISR_SLOTS - 1u)
+#define ISR_ENTRY_REF   0x80    // ref_us is esp_timer at cycles; not a LOG_RING_FLAG_*
+
+typedef struct {
+    volatile uint32_t turn;     // position + 1 once published
+    uint32_t cycles;            // cycle count of the core at submit
+    int64_t ref_us;             // esp_timer at cycles, with ISR_ENTRY_REF
+    uint8_t len;
+    uint8_t flags;              // LOG_RING_FLAG_* | ISR_ENTRY_REF
+    uint8_t data[LOG_ISR_RECORD_MAX];
+} isr_entry_t;
+
+typedef struct {
+    isr_entry_t entries[LOG_ISR_SLOTS];
+    volatile uint32_t head;     // next position to claim (handlers of the core, compare-and-swap)
+    volatile uint32_t tail;     // next position to drain (draining task)
+    volatile uint32_t notify_due;   // no wake-up sent since the last drain (atomic)
+    volatile uint32_t ref_due;  // the next entry takes esp_timer (set by every drain)
+    uint32_t ref_cycles;        // handler side: cycle count of the last reference
+    uint32_t drain_cycles;      // draining side: reference the next entries are timed by ...
+    int64_t drain_us;           // ... and its uptime
+} isr_buffer_t;
+
+// --------------------
+// Globals
+// --------------------
+static isr_buffer_t s_isr[portNUM_PROCESSORS];
+static uint32_t s_cycles_per_us = 1;
+static uint32_t s_resync_cycles = 0;    // 0 before log_isr_init(): every entry takes esp_timer
+static uint32_t s_queued = 0;           // atomic: handlers of every core
+static uint32_t s_dropped = 0;
+
+// --------------------
+// Public API
+// --------------------
+void log_isr_init(void)
+{
+    s_cycles_per_us = esp_rom_get_cpu_ticks_per_us();
+    s_resync_cycles = (uint32_t)LOG_ISR_RESYNC_MS * 1000u * s_cycles_per_us;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        s_isr[core].ref_due = 1;
+        s_isr[core].notify_due = 1;
+    }
+}
+
+IRAM_ATTR bool log_isr_push(const void *data, size_t len, uint8_t flags, bool *notify)
+{
+    const uint32_t cycles = esp_cpu_get_cycle_count();
+    isr_buffer_t *buf = &s_isr[esp_cpu_get_core_id()];
+
+    *notify = false;
+    if (len > LOG_ISR_RECORD_MAX) {
+        __atomic_fetch_add(&s_dropped, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    // A nested handler may claim between the load and the swap; the drain never frees
+    // an entry it has not read, so a stale tail only errs towards full
+    uint32_t head = __atomic_load_n(&buf->head, __ATOMIC_RELAXED);
+    do {
+        if (head - __atomic_load_n(&buf->tail, __ATOMIC_ACQUIRE) >= LOG_ISR_SLOTS) {
+            __atomic_fetch_add(&s_dropped, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&buf->head, &head, head + 1, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    isr_entry_t *entry = &buf->entries[head & ISR_MASK];
+    entry->cycles = cycles;
+    entry->flags = flags;
+    // The first entry of a burst, or one a while after the last reference, pairs the
+    // cycle count with esp_timer; the rest are timed from it by the drain
+    if (buf->ref_due || cycles - buf->ref_cycles >= s_resync_cycles) {
+        buf->ref_due = 0;
+        entry->ref_us = esp_timer_get_time();
+        entry->cycles = esp_cpu_get_cycle_count();
+        entry->flags |= ISR_ENTRY_REF;
+        buf->ref_cycles = entry->cycles;
+    }
+    memcpy(entry->data, data, len);
+    entry->len = (uint8_t)len;
+
+    // Publish the entry contents before its turn
+    __atomic_store_n(&entry->turn, head + 1, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&s_queued, 1, __ATOMIC_RELAXED);
+    *notify = __atomic_exchange_n(&buf->notify_due, 0, __ATOMIC_ACQ_REL) != 0;
+    return true;
+}
+
+// Uptime of the oldest entry of buf; the cycle difference is signed, as a nested
+// handler may have taken a newer reference than the entry's own count
+static int64_t entry_uptime_us(const isr_buffer_t *buf, const isr_entry_t *entry)
+{
+    if (entry->flags & ISR_ENTRY_REF) {
+        return entry->ref_us;
+    }
+    return buf->drain_us + (int32_t)(entry->cycles - buf->drain_cycles) / (int32_t)s_cycles_per_us;
+}
+
+uint32_t log_isr_drain(log_ring_t *ring)
+{
+    uint32_t moved = 0;
+
+    // Before the entries are read: a handler publishing after this wakes the task again
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        __atomic_store_n(&s_isr[core].notify_due, 1, __ATOMIC_RELEASE);
+        __atomic_store_n(&s_isr[core].ref_due, 1, __ATOMIC_RELEASE);
+    }
+
+    while (log_ring_count(ring) < LOG_RING_SLOTS) {
+        isr_buffer_t *next = NULL;
+        const isr_entry_t *next_entry = NULL;
+        int64_t next_us = 0;
+
+        // Oldest published entry of any core; a core stops at an entry still being filled
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            isr_buffer_t *buf = &s_isr[core];
+            const uint32_t tail = buf->tail;
+            const isr_entry_t *entry = &buf->entries[tail & ISR_MASK];
+            if (__atomic_load_n(&entry->turn, __ATOMIC_ACQUIRE) != tail + 1) {
+                continue;
+            }
+            const int64_t us = entry_uptime_us(buf, entry);
+            if (next == NULL || us < next_us) {
+                next = buf;
+                next_entry = entry;
+                next_us = us;
+            }
+        }
+        if (next == NULL) {
+            break;
+        }
+
+        if (next_entry->flags & ISR_ENTRY_REF) {
+            next->drain_cycles = next_entry->cycles;
+            next->drain_us = next_entry->ref_us;
+        }
+        // Rejected records (downsampled, or a producer task took the last slot) are
+        // counted by the ring
+        if (log_ring_push(ring, next_entry->data, next_entry->len, log_seq_next(),
+                          (uint32_t)(next_us / 1000), next_entry->flags & ~ISR_ENTRY_REF, NULL)) {
+            moved++;
+        }
+        // Release so a handler only reuses the entry after the copy
+        __atomic_store_n(&next->tail, next->tail + 1, __ATOMIC_RELEASE);
+    }
+    return moved;
+}
+
+uint32_t log_isr_count(void)
+{
+    uint32_t count = 0;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        count += __atomic_load_n(&s_isr[core].head, __ATOMIC_RELAXED) -
+                 __atomic_load_n(&s_isr[core].tail, __ATOMIC_RELAXED);
+    }
+    return count;
+}
+
+void log_isr_get_counts(uint32_t *queued, uint32_t *dropped)
+{
+    *queued = __atomic_load_n(&s_queued, __ATOMIC_RELAXED);
+    *dropped = __atomic_load_n(&s_dropped, __ATOMIC_RELAXED);
+}
+
+uint32_t log_isr_buffer_bytes(void)
+{
+    return sizeof(s_isr);
+}
+
+#endif // LOG_ISR_SUBMIT
@@ -0,0 +1,68 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Interrupt-safe staging of compact records ahead of the record ring.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_isr.h
+ * @brief   Per-core lock-free buffers filled from interrupt handlers
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Each core has its own buffer, so only the handlers of one core (which
+ *          may nest) compete for it: a handler claims an entry by a
+ *          compare-and-swap on head and publishes it through the entry's turn.
+ *          Exactly one task drains all buffers into the record ring. Entries
+ *          carry the core's cycle count; one in a burst (and one every
+ *          LOG_ISR_RESYNC_MS) also carries esp_timer, and the drain turns the
+ *          cycle counts into uptime from it.
+ *******************************************************************************/
+#ifndef LOG_ISR_H
+#define LOG_ISR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+#include "log_ring.h"
+
+#if LOG_ISR_SUBMIT
+
+// Before the first log_isr_push()
+void log_isr_init(void);
+
+// Interrupt handler (IRAM): queue one record of at most LOG_ISR_RECORD_MAX bytes in the
+// buffer of the calling core. flags are LOG_RING_FLAG_*. *notify is set for the first
+// record since the last drain: the caller wakes the draining task. False when the
+// record is too long or the buffer is full (counted as a drop).
+bool log_isr_push(const void *data, size_t len, uint8_t flags, bool *notify);
+
+// Draining task: move records into ring, oldest first across the cores, until the
+// buffers are empty or the ring has no free slot. Each record gets its uptime here and
+// a sequence number from log_seq_next(). Returns the records the ring accepted.
+uint32_t log_isr_drain(log_ring_t *ring);
+
+// Records waiting in the buffers of all cores
+uint32_t log_isr_count(void);
+
+// Records queued and dropped by interrupt handlers since boot
+void log_isr_get_counts(uint32_t *queued, uint32_t *dropped);
+
+// Static buffer bytes
+uint32_t log_isr_buffer_bytes(void);
+
+#endif // LOG_ISR_SUBMIT
+
+#endif // LOG_ISR_H
@@ -0,0 +1,606 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Sustained synthetic load for soak and throughput runs.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_load.c
+ * @brief   Virtual producers on the real submit API, with load and drift reports
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#include "enc_log.h"
+#include "log_load.h"
+#include "log_record.h"
+#include "log_seq.h"
+
+#if LOG_LOADGEN
+
+static const char *TAG = "LOG_LOAD";
+
+// --------------------
+// Constants
+// --------------------
+// Latency histogram: bucket i counts [2^i, 2^(i+1)) us, the last one everything above
+#define LOAD_HIST_BUCKETS       24
+#define LOAD_STACK_BYTES        4096
+#define LOAD_PRIORITY           (LOG_WRITER_PRIORITY - 1)
+#define LOAD_STOP_TIMEOUT_MS    10000
+
+typedef enum {
+    LOAD_PERIODIC,
+    LOAD_POISSON,
+} load_arrival_t;
+
+// One virtual producer. A burst replaces the base arrivals while it lasts.
+typedef struct {
+    const char *name;
+    load_arrival_t arrival;
+    uint32_t rate_mhz;          // base rate, records per 1000 s
+    uint32_t burst_every_s;     // 0: no bursts
+    uint16_t burst_records;
+    uint16_t burst_hz;
+    uint8_t size_min;           // bytes, uniform in [min, max]; 0..0 is the sample
+    uint8_t size_max;           // record as encoded
+    uint16_t priority_permille;
+} load_profile_t;
+
+static const load_profile_t s_profiles[] = {
+    { "ld_sensor", LOAD_PERIODIC, 10000, 0, 0, 0, 0, 0, 0 },
+    { "ld_burst", LOAD_POISSON, 2000, 30, 64, 200, 16, PLAINTEXT_MAX, 0 },
+    { "ld_mixed", LOAD_POISSON, 1000, 0, 0, 0, 1, PLAINTEXT_MAX, 10 },
+    { "ld_alarm", LOAD_POISSON, 20, 0, 0, 0, 0, 0, 1000 },
+};
+#define LOAD_PROFILES (sizeof(s_profiles) / sizeof(s_profiles[0]))
+
+typedef struct {
+    const load_profile_t *profile;
+    TaskHandle_t task;
+    uint32_t offered;           // records the schedule called for
+    uint32_t accepted;          // of them, taken by enc_log_submit()
+    uint32_t dropped;           // refused (ring policy)
+    uint32_t priority;
+    uint32_t lag_max_us;        // furthest behind schedule since the last report
+} load_producer_t;
+
+// Window or run totals
+typedef struct {
+    uint32_t offered;
+    uint32_t accepted;
+    uint32_t dropped;
+    uint32_t appended;
+    uint32_t hist[LOAD_HIST_BUCKETS];
+    uint32_t max_us;
+} load_counts_t;
+
+typedef struct {
+    uint32_t seq;
+    uint32_t submit_us;         // low bits of esp_timer, differences wrap correctly
+} load_track_t;
+
+// --------------------
+// Globals
+// --------------------
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static load_producer_t s_producers[LOG_LOAD_PRODUCERS];
+static load_track_t s_track[LOG_LOAD_TRACK];        // by seq, under s_lock
+static load_counts_t s_appends;                     // appended share, under s_lock
+static SemaphoreHandle_t s_done = NULL;
+static TaskHandle_t s_ctl_task = NULL;
+static volatile bool s_running = false;
+static volatile bool s_stop = false;
+static int64_t s_end_us = 0;                        // 0: no end
+static uint32_t s_rate_pct = 100;
+
+// Drift against the baseline windows
+typedef struct {
+    uint32_t windows;
+    double base_p99_us;
+    double base_delivered;      // appended / offered
+    uint32_t p99_run;           // windows in a row over the bound
+    uint32_t delivered_run;
+    bool latency;               // sticky once seen
+    bool throughput;
+    bool heap;
+    uint32_t latency_window;    // first window of the drift
+    uint32_t throughput_window;
+    // Least squares of free heap over run time
+    double sx, sy, sxx, sxy;
+    uint32_t heap_samples;
+} load_drift_t;
+
+static load_drift_t s_drift;
+
+// --------------------
+// Measurement
+// --------------------
+// Writer task: the records of this run among first_seq.. are in the store
+static void on_append(uint32_t first_seq, uint32_t count, void *ctx)
+{
+    (void)ctx;
+    const uint32_t now_us = (uint32_t)esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t seq = first_seq + i;
+        load_track_t *t = &s_track[seq & (LOG_LOAD_TRACK - 1)];
+        if (t->seq != seq || t->submit_us == 0) {
+            continue;   // not ours, or pushed out of the table by later records
+        }
+        const uint32_t us = now_us - t->submit_us;
+        t->submit_us = 0;
+        unsigned b = 0;
+        while (b + 1 < LOAD_HIST_BUCKETS && (us >> (b + 1)) != 0) {
+            b++;
+        }
+        s_appends.hist[b]++;
+        s_appends.appended++;
+        if (us > s_appends.max_us) {
+            s_appends.max_us = us;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+// Latency at permille of a histogram, interpolated in its bucket
+static uint32_t hist_percentile_us(const uint32_t *hist, uint32_t total, unsigned permille)
+{
+    if (total == 0) {
+        return 0;
+    }
+    const uint64_t rank = ((uint64_t)total * permille + 999) / 1000;
+    uint64_t seen = 0;
+    for (unsigned b = 0; b < LOAD_HIST_BUCKETS; b++) {
+        if (seen + hist[b] >= rank) {
+            const double lo = (b == 0) ? 0.0 : (double)(1u << b);
+            const double hi = (double)(1u << (b + 1));
+            return (uint32_t)(lo + (hi - lo) * (double)(rank - seen) / hist[b]);
+        }
+        seen += hist[b];
+    }
+    return UINT32_MAX;
+}
+
+// --------------------
+// Producers
+// --------------------
+static double uniform01(void)
+{
+    // (0, 1]: log() below never sees 0
+    return ((double)esp_random() + 1.0) / 4294967296.0;
+}
+
+// Wait until the uptime due_us, or the run stops. Less than a tick ahead goes at once,
+// so rates above the tick rate come out in short runs at the right mean.
+static void wait_until(int64_t due_us)
+{
+    while (!s_stop) {
+        const int64_t ahead_us = due_us - esp_timer_get_time();
+        if (ahead_us < (int64_t)portTICK_PERIOD_MS * 1000) {
+            return;
+        }
+        ulTaskNotifyTake(pdTRUE, (TickType_t)(ahead_us / (portTICK_PERIOD_MS * 1000)));
+    }
+}
+
+static void submit_one(load_producer_t *p)
+{
+    const load_profile_t *prof = p->profile;
+    const uint32_t seq = log_seq_next();
+    uint8_t msg[PLAINTEXT_MAX];
+    size_t len = log_record_encode(msg, sizeof(msg), LOG_RECORD_FORMAT, seq,
+                                   (uint64_t)(esp_timer_get_time() / 1000));
+    if (prof->size_max > 0) {
+        const size_t size = prof->size_min + esp_random() % (prof->size_max - prof->size_min + 1u);
+        if (size > len) {
+            memset(msg + len, 0, size - len);
+        }
+        len = size;
+    }
+    const bool priority = prof->priority_permille > 0 &&
+                          esp_random() % 1000 < prof->priority_permille;
+
+    portENTER_CRITICAL(&s_lock);
+    load_track_t *t = &s_track[seq & (LOG_LOAD_TRACK - 1)];
+    t->seq = seq;
+    t->submit_us = (uint32_t)esp_timer_get_time() | 1;   // 0 is an empty entry
+    portEXIT_CRITICAL(&s_lock);
+
+    p->offered++;
+    if (enc_log_submit(msg, len, seq, priority)) {
+        p->accepted++;
+        if (priority) {
+            p->priority++;
+        }
+    } else {
+        p->dropped++;
+        portENTER_CRITICAL(&s_lock);
+        if (t->seq == seq) {
+            t->submit_us = 0;
+        }
+        portEXIT_CRITICAL(&s_lock);
+    }
+}
+
+static void producer_task(void *arg)
+{
+    load_producer_t *p = (load_producer_t *)arg;
+    const load_profile_t *prof = p->profile;
+    const double mean_us = 1e9 / ((double)prof->rate_mhz * s_rate_pct / 100.0);
+    const double burst_us = prof->burst_hz ? 1e6 * 100.0 / ((double)prof->burst_hz * s_rate_pct) : 0;
+    int64_t next_us = esp_timer_get_time();
+    int64_t burst_due_us = prof->burst_every_s ? next_us + (int64_t)prof->burst_every_s * 1000000 : 0;
+    uint32_t burst_left = 0;
+
+    while (!s_stop) {
+        if (burst_left > 0) {
+            next_us += (int64_t)burst_us;
+            burst_left--;
+        } else {
+            next_us += (int64_t)(prof->arrival == LOAD_PERIODIC ? mean_us : -log(uniform01()) * mean_us);
+            if (burst_due_us != 0 && next_us >= burst_due_us) {
+                next_us = burst_due_us;
+                burst_left = prof->burst_records - 1;
+                burst_due_us += (int64_t)prof->burst_every_s * 1000000;
+            }
+        }
+        if (s_end_us != 0 && next_us >= s_end_us) {
+            break;
+        }
+        wait_until(next_us);
+        if (s_stop) {
+            break;
+        }
+        const int64_t lag_us = esp_timer_get_time() - next_us;
+        if (lag_us > (int64_t)p->lag_max_us) {
+            p->lag_max_us = (uint32_t)lag_us;
+        }
+        submit_one(p);
+    }
+    xSemaphoreGive(s_done);
+    vTaskDelete(NULL);
+}
+
+// --------------------
+// Reports
+// --------------------
+// Counts of all producers and the appends so far; lag_max_us is taken and restarted
+static void take_counts(load_counts_t *out, uint32_t *lag_max_us)
+{
+    memset(out, 0, sizeof(*out));
+    *lag_max_us = 0;
+    for (unsigned i = 0; i < LOG_LOAD_PRODUCERS; i++) {
+        load_producer_t *p = &s_producers[i];
+        out->offered += p->offered;
+        out->accepted += p->accepted;
+        out->dropped += p->dropped;
+        if (p->lag_max_us > *lag_max_us) {
+            *lag_max_us = p->lag_max_us;
+        }
+        p->lag_max_us = 0;
+    }
+    portENTER_CRITICAL(&s_lock);
+    out->appended = s_appends.appended;
+    memcpy(out->hist, s_appends.hist, sizeof(out->hist));
+    out->max_us = s_appends.max_us;
+    s_appends.max_us = 0;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+// cur - prev into window; the max is already per window
+static void counts_delta(const load_counts_t *cur, const load_counts_t *prev, load_counts_t *window)
+{
+    window->offered = cur->offered - prev->offered;
+    window->accepted = cur->accepted - prev->accepted;
+    window->dropped = cur->dropped - prev->dropped;
+    window->appended = cur->appended - prev->appended;
+    for (unsigned b = 0; b < LOAD_HIST_BUCKETS; b++) {
+        window->hist[b] = cur->hist[b] - prev->hist[b];
+    }
+    window->max_us = cur->max_us;
+}
+
+// Compare a window with the first LOG_LOAD_BASELINE_WINDOWS: p99 or delivered share
+// off by LOG_LOAD_DRIFT_PCT for LOG_LOAD_DRIFT_WINDOWS windows in a row, or free heap
+// falling over the run by more than LOG_LOAD_HEAP_DRIFT_BYTES (least-squares fit, so
+// one large allocation does not count)
+static void drift_update(uint32_t p99_us, double delivered, double t_h, uint32_t heap_free)
+{
+    load_drift_t *d = &s_drift;
+    d->windows++;
+    if (d->windows <= LOG_LOAD_BASELINE_WINDOWS) {
+        d->base_p99_us += (double)p99_us / LOG_LOAD_BASELINE_WINDOWS;
+        d->base_delivered += delivered / LOG_LOAD_BASELINE_WINDOWS;
+    } else {
+        const bool p99_off = p99_us > d->base_p99_us * (100 + LOG_LOAD_DRIFT_PCT) / 100.0;
+        const bool delivered_off = delivered < d->base_delivered * (100 - LOG_LOAD_DRIFT_PCT) / 100.0;
+        d->p99_run = p99_off ? d->p99_run + 1 : 0;
+        d->delivered_run = delivered_off ? d->delivered_run + 1 : 0;
+        if (!d->latency && d->p99_run >= LOG_LOAD_DRIFT_WINDOWS) {
+            d->latency = true;
+            d->latency_window = d->windows + 1 - LOG_LOAD_DRIFT_WINDOWS;
+        }
+        if (!d->throughput && d->delivered_run >= LOG_LOAD_DRIFT_WINDOWS) {
+            d->throughput = true;
+            d->throughput_window = d->windows + 1 - LOG_LOAD_DRIFT_WINDOWS;
+        }
+    }
+    d->sx += t_h;
+    d->sy += heap_free;
+    d->sxx += t_h * t_h;
+    d->sxy += t_h * heap_free;
+    d->heap_samples++;
+}
+
+// Fitted free heap change in bytes per hour, 0 until three samples
+static double heap_slope_bph(void)
+{
+    const load_drift_t *d = &s_drift;
+    const double n = d->heap_samples;
+    const double den = n * d->sxx - d->sx * d->sx;
+    if (d->heap_samples < 3 || den <= 0) {
+        return 0;
+    }
+    return (n * d->sxy - d->sx * d->sy) / den;
+}
+
+static void drift_names(char *buf, size_t cap)
+{
+    snprintf(buf, cap, "%s%s%s%s%s", s_drift.latency ? "latency" : "",
+             (s_drift.latency && (s_drift.throughput || s_drift.heap)) ? "," : "",
+             s_drift.throughput ? "throughput" : "",
+             (s_drift.throughput && s_drift.heap) ? "," : "", s_drift.heap ? "heap" : "");
+}
+
+static void report_window(uint32_t window, double t_s, double window_s, const load_counts_t *w,
+                          uint32_t lag_max_us)
+{
+    enc_log_stats_t st;
+    enc_log_get_stats(&st);
+    const uint32_t heap_free = esp_get_free_heap_size();
+    const uint32_t p50 = hist_percentile_us(w->hist, w->appended, 500);
+    const uint32_t p95 = hist_percentile_us(w->hist, w->appended, 950);
+    const uint32_t p99 = hist_percentile_us(w->hist, w->appended, 990);
+    drift_update(p99, w->offered ? (double)w->appended / w->offered : 1.0, t_s / 3600.0, heap_free);
+    const double slope = heap_slope_bph();
+    if (!s_drift.heap && slope < 0 && -slope * t_s / 3600.0 > LOG_LOAD_HEAP_DRIFT_BYTES) {
+        s_drift.heap = true;
+    }
+    char drift[32];
+    drift_names(drift, sizeof(drift));
+
+    printf("LOAD {\"window\":%lu,\"t_s\":%.0f,\"window_s\":%.1f,\"rate_pct\":%lu,"
+           "\"offered\":%lu,\"accepted\":%lu,\"dropped\":%lu,\"appended\":%lu,"
+           "\"offered_rps\":%.2f,\"achieved_rps\":%.2f,\"p50_us\":%lu,\"p95_us\":%lu,"
+           "\"p99_us\":%lu,\"max_us\":%lu,\"lag_max_ms\":%lu,\"ring_high_water\":%lu,"
+           "\"heap_free\":%lu,\"heap_bph\":%.0f,\"drift\":\"%s\"}\n",
+           (unsigned long)window, t_s, window_s, (unsigned long)s_rate_pct,
+           (unsigned long)w->offered, (unsigned long)w->accepted, (unsigned long)w->dropped,
+           (unsigned long)w->appended, window_s > 0 ? w->offered / window_s : 0.0,
+           window_s > 0 ? w->appended / window_s : 0.0, (unsigned long)p50, (unsigned long)p95,
+           (unsigned long)p99, (unsigned long)w->max_us, (unsigned long)(lag_max_us / 1000),
+           (unsigned long)st.ring_high_water, (unsigned long)heap_free, slope, drift);
+}
+
+static void report_done(double t_s, const load_counts_t *total, const enc_log_stats_t *before,
+                        uint32_t max_us)
+{
+    enc_log_stats_t st;
+    enc_log_get_stats(&st);
+    char drift[32];
+    drift_names(drift, sizeof(drift));
+    uint32_t priority = 0;
+    for (unsigned i = 0; i < LOG_LOAD_PRODUCERS; i++) {
+        priority += s_producers[i].priority;
+    }
+    // Accepted records never seen appended: evicted, write errors, or out of the table
+    const uint32_t lost = total->accepted > total->appended ? total->accepted - total->appended : 0;
+
+    printf("LOAD_DONE {\"t_s\":%.0f,\"producers\":%u,\"rate_pct\":%lu,\"offered\":%lu,"
+           "\"accepted\":%lu,\"dropped\":%lu,\"priority\":%lu,\"appended\":%lu,\"lost\":%lu,"
+           "\"offered_rps\":%.2f,\"achieved_rps\":%.2f,\"p50_us\":%lu,\"p95_us\":%lu,"
+           "\"p99_us\":%lu,\"p999_us\":%lu,\"max_us\":%lu,\"ring_evicted\":%lu,"
+           "\"write_errors\":%lu,\"heap_bph\":%.0f,\"drift\":\"%s\"}\n",
+           t_s, (unsigned)LOG_LOAD_PRODUCERS, (unsigned long)s_rate_pct,
+           (unsigned long)total->offered, (unsigned long)total->accepted,
+           (unsigned long)total->dropped, (unsigned long)priority,
+           (unsigned long)total->appended, (unsigned long)lost,
+           t_s > 0 ? total->offered / t_s : 0.0, t_s > 0 ? total->appended / t_s : 0.0,
+           (unsigned long)hist_percentile_us(total->hist, total->appended, 500),
+           (unsigned long)hist_percentile_us(total->hist, total->appended, 950),
+           (unsigned long)hist_percentile_us(total->hist, total->appended, 990),
+           (unsigned long)(total->appended >= 1000
+                               ? hist_percentile_us(total->hist, total->appended, 999) : 0),
+           (unsigned long)max_us, (unsigned long)(st.ring_evicted - before->ring_evicted),
+           (unsigned long)(st.write_errors - before->write_errors), heap_slope_bph(), drift);
+    if (s_drift.latency) {
+        ESP_LOGW(TAG, "latency drift from window %lu: p99 above %.0f us",
+                 (unsigned long)s_drift.latency_window,
+                 s_drift.base_p99_us * (100 + LOG_LOAD_DRIFT_PCT) / 100.0);
+    }
+    if (s_drift.throughput) {
+        ESP_LOGW(TAG, "throughput drift from window %lu: under %.0f%% of offered appended",
+                 (unsigned long)s_drift.throughput_window,
+                 s_drift.base_delivered * (100 - LOG_LOAD_DRIFT_PCT));
+    }
+    if (s_drift.heap) {
+        ESP_LOGW(TAG, "heap drift: free heap falls %.0f bytes/h", -heap_slope_bph());
+    }
+}
+
+// --------------------
+// Run
+// --------------------
+static void ctl_task(void *arg)
+{
+    (void)arg;
+    enc_log_stats_t before;
+    load_counts_t prev, cur, window;
+    uint32_t lag_max_us;
+
+    enc_log_get_stats(&before);
+    memset(&prev, 0, sizeof(prev));
+    const int64_t start_us = esp_timer_get_time();
+    int64_t window_us = start_us;
+    uint32_t windows = 0;
+    uint32_t max_us = 0;
+    bool ended = false;
+
+    while (!ended) {
+        const int64_t report_us = window_us + (int64_t)LOG_LOAD_REPORT_S * 1000000;
+        int64_t due_us = report_us;
+        if (s_end_us != 0 && s_end_us < due_us) {
+            due_us = s_end_us;
+        }
+        while (!s_stop && esp_timer_get_time() < due_us) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS((due_us - esp_timer_get_time()) / 1000) + 1);
+        }
+        ended = s_stop || (s_end_us != 0 && esp_timer_get_time() >= s_end_us);
+        if (ended) {
+            // Producers first, then what they left in the ring and the batch
+            s_stop = true;
+            for (unsigned i = 0; i < LOG_LOAD_PRODUCERS; i++) {
+                if (s_producers[i].task != NULL) {
+                    xTaskNotifyGive(s_producers[i].task);
+                }
+            }
+            for (unsigned i = 0; i < LOG_LOAD_PRODUCERS; i++) {
+                if (s_producers[i].task != NULL &&
+                    xSemaphoreTake(s_done, pdMS_TO_TICKS(LOAD_STOP_TIMEOUT_MS)) != pdTRUE) {
+                    ESP_LOGW(TAG, "producer did not stop");
+                }
+            }
+            if (!enc_log_sync(LOAD_STOP_TIMEOUT_MS)) {
+                ESP_LOGW(TAG, "log sync timed out, latest records not counted");
+            }
+        }
+        const int64_t now_us = esp_timer_get_time();
+        take_counts(&cur, &lag_max_us);
+        counts_delta(&cur, &prev, &window);
+        if (window.max_us > max_us) {
+            max_us = window.max_us;
+        }
+        // A partial last window under a tenth of the period says little: only in the total
+        if (!ended || now_us - window_us >= (int64_t)LOG_LOAD_REPORT_S * 100000) {
+            report_window(++windows, (double)(now_us - start_us) / 1e6,
+                          (double)(now_us - window_us) / 1e6, &window, lag_max_us);
+        }
+        prev = cur;
+        window_us = now_us;
+    }
+
+    enc_log_set_append_cb(NULL, NULL);
+    report_done((double)(esp_timer_get_time() - start_us) / 1e6, &cur, &before, max_us);
+    vSemaphoreDelete(s_done);
+    s_done = NULL;
+    s_ctl_task = NULL;
+    s_running = false;
+    vTaskDelete(NULL);
+}
+
+// --------------------
+// Public API
+// --------------------
+bool log_load_start(uint32_t seconds, uint32_t rate_pct)
+{
+    if (s_running || rate_pct == 0) {
+        return false;
+    }
+    s_done = xSemaphoreCreateCounting(LOG_LOAD_PRODUCERS, 0);
+    if (s_done == NULL) {
+        return false;
+    }
+    s_running = true;
+    s_stop = false;
+    s_rate_pct = rate_pct;
+    memset(&s_drift, 0, sizeof(s_drift));
+    memset(s_track, 0, sizeof(s_track));
+    memset(&s_appends, 0, sizeof(s_appends));
+    memset(s_producers, 0, sizeof(s_producers));
+
+    // The append callback is only set while nothing is queued
+    if (!enc_log_sync(LOAD_STOP_TIMEOUT_MS)) {
+        ESP_LOGW(TAG, "log sync timed out, not started");
+        vSemaphoreDelete(s_done);
+        s_done = NULL;
+        s_running = false;
+        return false;
+    }
+    enc_log_set_append_cb(on_append, NULL);
+    s_end_us = seconds ? esp_timer_get_time() + (int64_t)seconds * 1000000 : 0;
+
+    unsigned started = 0;
+    for (unsigned i = 0; i < LOG_LOAD_PRODUCERS; i++) {
+        load_producer_t *p = &s_producers[i];
+        p->profile = &s_profiles[i % LOAD_PROFILES];
+        if (xTaskCreate(producer_task, p->profile->name, LOAD_STACK_BYTES, p, LOAD_PRIORITY,
+                        &p->task) != pdPASS) {
+            p->task = NULL;
+            ESP_LOGW(TAG, "%s not started", p->profile->name);
+            continue;
+        }
+        started++;
+    }
+    if (started == 0 ||
+        xTaskCreate(ctl_task, "ld_ctl", LOAD_STACK_BYTES, NULL, LOAD_PRIORITY, &s_ctl_task) != pdPASS) {
+        // Producers that did start see s_stop and end; their gives go with the semaphore
+        s_stop = true;
+        for (unsigned i = 0; i < LOG_LOAD_PRODUCERS; i++) {
+            if (s_producers[i].task != NULL) {
+                xTaskNotifyGive(s_producers[i].task);
+                xSemaphoreTake(s_done, pdMS_TO_TICKS(LOAD_STOP_TIMEOUT_MS));
+            }
+        }
+        enc_log_sync(LOAD_STOP_TIMEOUT_MS);
+        enc_log_set_append_cb(NULL, NULL);
+        vSemaphoreDelete(s_done);
+        s_done = NULL;
+        s_running = false;
+        return false;
+    }
+    ESP_LOGI(TAG, "%u producers at %lu%% for %lu s (0: until stopped), report every %u s",
+             started, (unsigned long)rate_pct, (unsigned long)seconds, (unsigned)LOG_LOAD_REPORT_S);
+    return true;
+}
+
+void log_load_stop(void)
+{
+    if (s_running && s_ctl_task != NULL) {
+        s_stop = true;
+        xTaskNotifyGive(s_ctl_task);
+    }
+}
+
+bool log_load_running(void)
+{
+    return s_running;
+}
+
+#endif // LOG_LOADGEN
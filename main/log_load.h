@@ -0,0 +1,53 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Sustained synthetic load for soak and throughput runs.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_load.h
+ * @brief   Virtual producers on the real submit API, with load and drift reports
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Each producer task follows one profile: periodic or Poisson arrivals,
+ *          optional bursts, a record size range and a share of priority records.
+ *          Records are sample records cut or zero-padded to the drawn size, with
+ *          seqs from log_seq_next(). Latency is submit to the writer's append (its
+ *          block group in batch mode), taken in the enc_log append callback, which
+ *          the run owns: nothing else may set it meanwhile. Offered load is what
+ *          the profiles schedule; a producer that falls behind its schedule submits
+ *          at once and the lag is reported.
+ *******************************************************************************/
+#ifndef LOG_LOAD_H
+#define LOG_LOAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+#if LOG_LOADGEN
+
+// Start a run of seconds (0: until log_load_stop()) at rate_pct percent of the profile
+// rates. False if a run is going or its tasks cannot be created.
+bool log_load_start(uint32_t seconds, uint32_t rate_pct);
+
+// End the running run early; its final report follows from the run's task
+void log_load_stop(void);
+
+bool log_load_running(void);
+
+#endif // LOG_LOADGEN
+
+#endif // LOG_LOAD_H
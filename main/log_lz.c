@@ -0,0 +1,206 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Compress block group plaintext before encryption.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_lz.c
+ * @brief   LZ4 block format compressor / decompressor with bounded RAM
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <stdbool.h>
+#include <string.h>
+
+#include "enc_log_config.h"
+#include "log_lz.h"
+
+// LZ4 block format limits: matches are at least 4 bytes, the last 5 bytes are
+// literals and the last match starts at least 12 bytes before the end
+#define LZ_MIN_MATCH        4
+#define LZ_LAST_LITERALS    5
+#define LZ_MATCH_LIMIT      12
+#define LZ_MAX_OFFSET       0xFFFF
+#define LZ_RUN_MASK         0x0F
+#define LZ_HASH_SIZE        (1u << LOG_LZ_HASH_BITS)
+
+// --------------------
+// Globals
+// --------------------
+// Input position + 1 of the last 4-byte sequence with each hash (0 = empty)
+static uint16_t s_table[LZ_HASH_SIZE];
+
+static uint32_t read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t hash4(const uint8_t *p)
+{
+    return (read32(p) * 2654435761u) >> (32 - LOG_LZ_HASH_BITS);
+}
+
+// Token nibble overflow: 255-byte continuation bytes, then the rest
+static uint8_t *put_length(uint8_t *op, const uint8_t *end, size_t n)
+{
+    for (; n >= 255; n -= 255) {
+        if (op >= end) {
+            return NULL;
+        }
+        *op++ = 255;
+    }
+    if (op >= end) {
+        return NULL;
+    }
+    *op++ = (uint8_t)n;
+    return op;
+}
+
+// One sequence: token, literals, then (if match_len) offset and match length
+static uint8_t *put_sequence(uint8_t *op, const uint8_t *end, const uint8_t *lit, size_t lit_len,
+                             size_t offset, size_t match_len)
+{
+    if (op >= end) {
+        return NULL;
+    }
+    uint8_t *token = op++;
+    const size_t ml = match_len ? match_len - LZ_MIN_MATCH : 0;
+    *token = (uint8_t)(((lit_len < LZ_RUN_MASK) ? lit_len : LZ_RUN_MASK) << 4);
+    if (lit_len >= LZ_RUN_MASK && !(op = put_length(op, end, lit_len - LZ_RUN_MASK))) {
+        return NULL;
+    }
+    if ((size_t)(end - op) < lit_len) {
+        return NULL;
+    }
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+    if (match_len == 0) {
+        return op;
+    }
+
+    *token |= (uint8_t)((ml < LZ_RUN_MASK) ? ml : LZ_RUN_MASK);
+    if (end - op < 2) {
+        return NULL;
+    }
+    *op++ = (uint8_t)offset;
+    *op++ = (uint8_t)(offset >> 8);
+    if (ml >= LZ_RUN_MASK && !(op = put_length(op, end, ml - LZ_RUN_MASK))) {
+        return NULL;
+    }
+    return op;
+}
+
+size_t log_lz_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap)
+{
+    if (len > LZ_MAX_OFFSET) {
+        return 0;
+    }
+    const uint8_t *const end = dst + cap;
+    uint8_t *op = dst;
+    size_t anchor = 0;
+
+    if (len > LZ_MATCH_LIMIT) {
+        memset(s_table, 0, sizeof(s_table));
+        const size_t match_start_max = len - LZ_MATCH_LIMIT;
+        const size_t match_end_max = len - LZ_LAST_LITERALS;
+        size_t ip = 0;
+        while (ip < match_start_max) {
+            const uint32_t h = hash4(src + ip);
+            const size_t ref = s_table[h];
+            s_table[h] = (uint16_t)(ip + 1);
+            if (ref == 0 || read32(src + ref - 1) != read32(src + ip)) {
+                ip++;
+                continue;
+            }
+            const size_t match = ref - 1;
+            size_t ml = LZ_MIN_MATCH;
+            while (ip + ml < match_end_max && src[match + ml] == src[ip + ml]) {
+                ml++;
+            }
+            op = put_sequence(op, end, src + anchor, ip - anchor, ip - match, ml);
+            if (op == NULL) {
+                return 0;
+            }
+            ip += ml;
+            anchor = ip;
+        }
+    }
+
+    op = put_sequence(op, end, src + anchor, len - anchor, 0, 0);
+    return op ? (size_t)(op - dst) : 0;
+}
+
+// Length continuation bytes after a full token nibble
+static bool get_length(const uint8_t **ip, const uint8_t *end, size_t *n)
+{
+    uint8_t b;
+    do {
+        if (*ip >= end) {
+            return false;
+        }
+        b = *(*ip)++;
+        *n += b;
+    } while (b == 255);
+    return true;
+}
+
+size_t log_lz_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap)
+{
+    const uint8_t *ip = src;
+    const uint8_t *const end = src + len;
+    size_t out = 0;
+
+    while (ip < end) {
+        const uint8_t token = *ip++;
+        size_t lit_len = token >> 4;
+        if (lit_len == LZ_RUN_MASK && !get_length(&ip, end, &lit_len)) {
+            return 0;
+        }
+        if ((size_t)(end - ip) < lit_len || cap - out < lit_len) {
+            return 0;
+        }
+        memcpy(dst + out, ip, lit_len);
+        ip += lit_len;
+        out += lit_len;
+        if (ip == end) {
+            // The last sequence has no match
+            return out;
+        }
+
+        if (end - ip < 2) {
+            return 0;
+        }
+        const size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        size_t ml = token & LZ_RUN_MASK;
+        if (ml == LZ_RUN_MASK && !get_length(&ip, end, &ml)) {
+            return 0;
+        }
+        ml += LZ_MIN_MATCH;
+        if (offset == 0 || offset > out || cap - out < ml) {
+            return 0;
+        }
+        // Byte by byte: the match may overlap its own output (runs)
+        for (size_t i = 0; i < ml; i++, out++) {
+            dst[out] = dst[out - offset];
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Compress block group plaintext before encryption.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_lz.h
+ * @brief   LZ4 block format compressor / decompressor with bounded RAM
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Greedy single-probe matcher: one hash table of LOG_LZ_HASH_BITS
+ *          16-bit positions (512 B at 8 bits) and no heap. The output is a plain
+ *          LZ4 block (no frame), so host tools can use any LZ4 library
+ *          (lz4.block.decompress). Inputs are at most 64 KB. The compressor is
+ *          not reentrant (one table); the decompressor has no state.
+ *******************************************************************************/
+#ifndef LOG_LZ_H
+#define LOG_LZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Compress len bytes into dst. Returns the compressed length, 0 if it does not fit in cap.
+size_t log_lz_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap);
+
+// Decompress one block. Returns the output length, 0 on a malformed block or overflow.
+size_t log_lz_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap);
+
+#endif // LOG_LZ_H
@@ -0,0 +1,197 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Merkle tree over log appends for logarithmic single-record proofs.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_merkle.c
+ * @brief   Incremental SHA-256 Merkle tree (RFC 6962 hashing)
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <string.h>
+
+#include "mbedtls/sha256.h"
+
+#include "log_merkle.h"
+
+#define MERKLE_LEAF_PREFIX  0x00
+#define MERKLE_NODE_PREFIX  0x01
+
+static bool hash_node(const uint8_t *left, const uint8_t *right, uint8_t *out)
+{
+    uint8_t buf[1 + 2 * LOG_MERKLE_HASH_BYTES];
+    buf[0] = MERKLE_NODE_PREFIX;
+    memcpy(buf + 1, left, LOG_MERKLE_HASH_BYTES);
+    memcpy(buf + 1 + LOG_MERKLE_HASH_BYTES, right, LOG_MERKLE_HASH_BYTES);
+    return mbedtls_sha256(buf, sizeof(buf), out, 0) == 0;
+}
+
+static bool hash_leaf(const uint8_t *data, size_t len, uint8_t *out)
+{
+    static const uint8_t prefix = MERKLE_LEAF_PREFIX;
+    mbedtls_sha256_context ctx;
+
+    mbedtls_sha256_init(&ctx);
+    bool ok = mbedtls_sha256_starts(&ctx, 0) == 0 &&
+              mbedtls_sha256_update(&ctx, &prefix, 1) == 0 &&
+              mbedtls_sha256_update(&ctx, data, len) == 0 &&
+              mbedtls_sha256_finish(&ctx, out) == 0;
+    mbedtls_sha256_free(&ctx);
+    return ok;
+}
+
+// Largest power of two below n (n >= 2): the RFC 6962 split point
+static uint32_t split_point(uint32_t n)
+{
+    uint32_t k = 1;
+    while ((k << 1) < n) {
+        k <<= 1;
+    }
+    return k;
+}
+
+// Root of leaves [lo, lo + n)
+static bool subtree_hash(const log_merkle_t *t, uint32_t lo, uint32_t n, uint8_t *out)
+{
+    if (n == 1) {
+        memcpy(out, t->leaves[lo], LOG_MERKLE_HASH_BYTES);
+        return true;
+    }
+    uint8_t left[LOG_MERKLE_HASH_BYTES];
+    uint8_t right[LOG_MERKLE_HASH_BYTES];
+    const uint32_t k = split_point(n);
+    return subtree_hash(t, lo, k, left) && subtree_hash(t, lo + k, n - k, right) &&
+           hash_node(left, right, out);
+}
+
+// Appends PATH(m, D[lo:lo+n]) to path, deepest sibling first
+static bool audit_path(const log_merkle_t *t, uint32_t m, uint32_t lo, uint32_t n,
+                       uint8_t path[][LOG_MERKLE_HASH_BYTES], size_t max, size_t *len)
+{
+    if (n == 1) {
+        return true;
+    }
+    const uint32_t k = split_point(n);
+    bool ok = (m < k) ? audit_path(t, m, lo, k, path, max, len)
+                      : audit_path(t, m - k, lo + k, n - k, path, max, len);
+    if (!ok || *len >= max) {
+        return false;
+    }
+    ok = (m < k) ? subtree_hash(t, lo + k, n - k, path[*len])
+                 : subtree_hash(t, lo, k, path[*len]);
+    (*len)++;
+    return ok;
+}
+
+void log_merkle_init(log_merkle_t *t)
+{
+    t->count = 0;
+}
+
+bool log_merkle_append(log_merkle_t *t, const uint8_t *data, size_t len,
+                       const log_merkle_leaf_t *info)
+{
+    if (t->count >= LOG_MERKLE_LEAVES) {
+        return false;
+    }
+    uint8_t *leaf = t->leaves[t->count];
+    if (!hash_leaf(data, len, leaf)) {
+        return false;
+    }
+    t->info[t->count] = *info;
+
+    // Merge equal-sized subtrees like a binary carry, at most log2(n) hashes
+    uint8_t h[LOG_MERKLE_HASH_BYTES];
+    memcpy(h, leaf, sizeof(h));
+    uint32_t level = 0;
+    while (t->count & (1u << level)) {
+        if (!hash_node(t->frontier[level], h, h)) {
+            return false;
+        }
+        level++;
+    }
+    memcpy(t->frontier[level], h, sizeof(h));
+    t->count++;
+    return true;
+}
+
+bool log_merkle_root(const log_merkle_t *t, uint8_t *root)
+{
+    if (t->count == 0) {
+        return false;
+    }
+    // Fold the frontier from the smallest (rightmost) subtree up
+    bool have = false;
+    for (uint32_t level = 0; level <= LOG_MERKLE_MAX_DEPTH; level++) {
+        if (!(t->count & (1u << level))) {
+            continue;
+        }
+        if (!have) {
+            memcpy(root, t->frontier[level], LOG_MERKLE_HASH_BYTES);
+            have = true;
+        } else if (!hash_node(t->frontier[level], root, root)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t log_merkle_proof(const log_merkle_t *t, uint32_t index,
+                        uint8_t path[][LOG_MERKLE_HASH_BYTES], size_t max)
+{
+    size_t len = 0;
+    if (index >= t->count || !audit_path(t, index, 0, t->count, path, max, &len)) {
+        return 0;
+    }
+    return len;
+}
+
+bool log_merkle_verify(const uint8_t *leaf, uint32_t index, uint32_t count,
+                       const uint8_t path[][LOG_MERKLE_HASH_BYTES], size_t path_len,
+                       const uint8_t *root)
+{
+    if (index >= count) {
+        return false;
+    }
+    uint8_t r[LOG_MERKLE_HASH_BYTES];
+    uint32_t fn = index;
+    uint32_t sn = count - 1;
+    memcpy(r, leaf, sizeof(r));
+
+    for (size_t i = 0; i < path_len; i++) {
+        if (sn == 0) {
+            return false;
+        }
+        if ((fn & 1) || fn == sn) {
+            if (!hash_node(path[i], r, r)) {
+                return false;
+            }
+            // Skip the levels where this node has no right sibling
+            while (!(fn & 1) && fn != 0) {
+                fn >>= 1;
+                sn >>= 1;
+            }
+        } else if (!hash_node(r, path[i], r)) {
+            return false;
+        }
+        fn >>= 1;
+        sn >>= 1;
+    }
+    return sn == 0 && memcmp(r, root, sizeof(r)) == 0;
+}
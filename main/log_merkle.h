@@ -0,0 +1,76 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Merkle tree over log appends for logarithmic single-record proofs.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_merkle.h
+ * @brief   Incremental SHA-256 Merkle tree (RFC 6962 hashing)
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Leaf = SHA-256(0x00 || appended bytes), node = SHA-256(0x01 || left ||
+ *          right), so a leaf can never be passed off as a node. The frontier of
+ *          perfect subtree roots gives the root after every append without
+ *          rehashing; an inclusion proof is rebuilt from the stored leaves.
+ *          Hashing runs on mbedtls, i.e. the ESP32 SHA accelerator.
+ *******************************************************************************/
+#ifndef LOG_MERKLE_H
+#define LOG_MERKLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+#define LOG_MERKLE_HASH_BYTES   32
+// Audit path length for LOG_MERKLE_LEAVES <= 1024
+#define LOG_MERKLE_MAX_DEPTH    10
+
+typedef struct {
+    uint32_t seq;               // producer seq of the (first) record in the append
+    uint32_t offset;            // log offset of the appended bytes
+    uint16_t len;               // appended bytes
+    uint16_t records;           // records in the append (block group size in batch mode)
+} log_merkle_leaf_t;
+
+typedef struct {
+    uint8_t leaves[LOG_MERKLE_LEAVES][LOG_MERKLE_HASH_BYTES];
+    log_merkle_leaf_t info[LOG_MERKLE_LEAVES];
+    // frontier[i] is the perfect subtree of 2^i leaves while bit i of count is set
+    uint8_t frontier[LOG_MERKLE_MAX_DEPTH + 1][LOG_MERKLE_HASH_BYTES];
+    uint32_t count;
+} log_merkle_t;
+
+void log_merkle_init(log_merkle_t *t);
+
+// Hash the appended bytes into a leaf and add it. False when full or on a hash error.
+bool log_merkle_append(log_merkle_t *t, const uint8_t *data, size_t len,
+                       const log_merkle_leaf_t *info);
+
+// Root over all leaves so far (count must be > 0)
+bool log_merkle_root(const log_merkle_t *t, uint8_t *root);
+
+// Audit path of leaf `index`, bottom-up. Returns the number of hashes, 0 on error
+// (a single-leaf tree also has an empty path).
+size_t log_merkle_proof(const log_merkle_t *t, uint32_t index,
+                        uint8_t path[][LOG_MERKLE_HASH_BYTES], size_t max);
+
+// Check an audit path against a root (RFC 9162 2.1.3.2), as an auditor would
+bool log_merkle_verify(const uint8_t *leaf, uint32_t index, uint32_t count,
+                       const uint8_t path[][LOG_MERKLE_HASH_BYTES], size_t path_len,
+                       const uint8_t *root);
+
+#endif // LOG_MERKLE_H
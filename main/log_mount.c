@@ -0,0 +1,178 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Mount the log storage picked by LOG_STORAGE_*.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_mount.c
+ * @brief   SD card / wear-levelled FATFS / raw partition mount
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include "esp_log.h"
+#include "esp_vfs.h"
+#include "esp_vfs_fat.h"
+#include "wear_levelling.h"
+#if LOG_STORAGE_LITTLEFS
+#include "esp_littlefs.h"
+#endif
+#include "sdmmc_cmd.h"
+#include "driver/sdmmc_host.h"
+
+#include "log_mount.h"
+
+#define LOG_MOUNT_PARTITION_LABEL "storage"
+
+// --------------------
+// Globals
+// --------------------
+static const char *TAG = "LOG_MOUNT";
+#if !LOG_STORAGE_SDMMC && !LOG_STORAGE_RAW && !LOG_STORAGE_LITTLEFS
+static wl_handle_t s_wl_handle = WL_INVALID_HANDLE;
+#endif
+#if LOG_STORAGE_SDMMC || LOG_TIER_SD
+static sdmmc_card_t *s_sd_card = NULL;
+#endif
+
+#if LOG_STORAGE_SDMMC || LOG_TIER_SD
+// --------------------
+// Helpers
+// --------------------
+static esp_err_t mount_sd(const char *mount_point, bool allow_format)
+{
+    // Fastest first; 1-bit at the default clock matches the Part 1 wiring
+    static const struct {
+        int width;
+        int freq_khz;
+    } attempts[] = {
+        {LOG_SDMMC_BUS_WIDTH, LOG_SDMMC_HIGHSPEED ? SDMMC_FREQ_HIGHSPEED : SDMMC_FREQ_DEFAULT},
+        {LOG_SDMMC_BUS_WIDTH, SDMMC_FREQ_DEFAULT},
+        {1, SDMMC_FREQ_DEFAULT},
+    };
+    const size_t n_attempts = sizeof(attempts) / sizeof(attempts[0]);
+
+    esp_err_t err = ESP_FAIL;
+    for (size_t i = 0; i < n_attempts; i++) {
+        if (i > 0 && attempts[i].width == attempts[i - 1].width &&
+            attempts[i].freq_khz == attempts[i - 1].freq_khz) {
+            continue;
+        }
+
+        // Only the last attempt may format: a failed read over a bad bus must not
+        // wipe a card that is fine in 1-bit mode
+        const esp_vfs_fat_sdmmc_mount_config_t mount_config = {
+            .format_if_mount_failed = allow_format && (i == n_attempts - 1),
+            .max_files = 4,
+            .allocation_unit_size = LOG_SDMMC_AU_BYTES,
+        };
+
+        sdmmc_host_t host = SDMMC_HOST_DEFAULT();
+        host.max_freq_khz = attempts[i].freq_khz;
+        sdmmc_slot_config_t slot_config = SDMMC_SLOT_CONFIG_DEFAULT();
+        slot_config.width = attempts[i].width;
+        slot_config.flags |= SDMMC_SLOT_FLAG_INTERNAL_PULLUP;
+
+        err = esp_vfs_fat_sdmmc_mount(
+            mount_point, &host, &slot_config, &mount_config, &s_sd_card);
+        if (err == ESP_OK) {
+            ESP_LOGI(TAG, "SD card mounted: %d-bit, %d kHz", attempts[i].width,
+                     attempts[i].freq_khz);
+            return ESP_OK;
+        }
+        ESP_LOGW(TAG, "SD mount failed at %d-bit, %d kHz (err=0x%x)", attempts[i].width,
+                 attempts[i].freq_khz, err);
+    }
+    ESP_LOGE(TAG, "Failed to mount SD card (err=0x%x)", err);
+    return err;
+}
+#endif
+
+// --------------------
+// Public API
+// --------------------
+esp_err_t log_mount_storage(void)
+{
+#if LOG_STORAGE_SDMMC
+    return mount_sd(LOG_MOUNT_POINT, true);
+#elif LOG_STORAGE_RAW
+    // The raw log store opens the partition itself; there is no file system
+    ESP_LOGI(TAG, "raw log store on partition '%s'", LOG_RAW_PARTITION_LABEL);
+    return ESP_OK;
+#else
+#if LOG_STORAGE_LITTLEFS
+    // Finds the partition by label, so the "fat" subtype of partitions.csv does
+    // not matter; a FATFS image there is not LittleFS and gets formatted
+    const esp_vfs_littlefs_conf_t conf = {
+        .base_path = LOG_MOUNT_POINT,
+        .partition_label = LOG_MOUNT_PARTITION_LABEL,
+        .format_if_mount_failed = true,
+    };
+
+    esp_err_t err = esp_vfs_littlefs_register(&conf);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to mount LittleFS (err=0x%x)", err);
+    }
+#else
+    const esp_vfs_fat_mount_config_t mount_config = {
+        .format_if_mount_failed = true,
+        .max_files = 4,
+        .allocation_unit_size = 4096,
+    };
+
+    esp_err_t err = esp_vfs_fat_spiflash_mount_rw_wl(
+        LOG_MOUNT_POINT, LOG_MOUNT_PARTITION_LABEL, &mount_config, &s_wl_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to mount FATFS (err=0x%x)", err);
+    }
+#endif
+#if LOG_TIER_SD
+    // Logging starts without the card; the store retries it (log_mount_tier())
+    if (err == ESP_OK && log_mount_tier() != ESP_OK) {
+        ESP_LOGW(TAG, "no SD tier, closed segments stay in flash for now");
+    }
+#endif
+    return err;
+#endif
+}
+
+esp_err_t log_mount_info(uint64_t *total_bytes, uint64_t *free_bytes)
+{
+#if LOG_STORAGE_LITTLEFS
+    size_t total = 0;
+    size_t used = 0;
+    const esp_err_t err = esp_littlefs_info(LOG_MOUNT_PARTITION_LABEL, &total, &used);
+    *total_bytes = total;
+    *free_bytes = (err == ESP_OK && used < total) ? total - used : 0;
+    return err;
+#else
+    return esp_vfs_fat_info(LOG_MOUNT_POINT, total_bytes, free_bytes);
+#endif
+}
+
+#if LOG_TIER_SD
+esp_err_t log_mount_tier(void)
+{
+    if (s_sd_card) {
+        // A card pulled and pushed back needs a fresh init
+        esp_vfs_fat_sdcard_unmount(LOG_TIER_MOUNT_POINT, s_sd_card);
+        s_sd_card = NULL;
+    }
+    // Never format here: the card holds the older part of the log
+    return mount_sd(LOG_TIER_MOUNT_POINT, false);
+}
+#endif
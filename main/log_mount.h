@@ -0,0 +1,46 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Mount the log storage picked by LOG_STORAGE_*.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_mount.h
+ * @brief   SD card / wear-levelled FATFS / raw partition mount, SD tier
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Shared by the demo app and the benchmark app (bench/).
+ *******************************************************************************/
+#ifndef LOG_MOUNT_H
+#define LOG_MOUNT_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "enc_log_config.h"
+
+// Mount LOG_MOUNT_POINT (nothing to mount for the raw store). Called by enc_log_init().
+esp_err_t log_mount_storage(void);
+
+// Size and free space of the file system at LOG_MOUNT_POINT (FATFS or LittleFS)
+esp_err_t log_mount_info(uint64_t *total_bytes, uint64_t *free_bytes);
+
+#if LOG_TIER_SD
+// Mount the SD card of the cold tier at LOG_TIER_MOUNT_POINT, first unmounting it if it
+// was mounted. Never formats. Called at mount and by the store after a card error.
+esp_err_t log_mount_tier(void);
+#endif
+
+#endif // LOG_MOUNT_H
@@ -0,0 +1,71 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Small device state the logger keeps across resets.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_nvs.c
+ * @brief   NVS brought up once for every module of the logger that keeps state in it
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "nvs_flash.h"
+
+#include "log_nvs.h"
+
+// --------------------
+// Globals
+// --------------------
+static const char *TAG = "LOG_NVS";
+// Callers run on the app, writer and console tasks: the first ones race to initialise
+static SemaphoreHandle_t s_lock = NULL;
+static StaticSemaphore_t s_lock_buf;
+static portMUX_TYPE s_lock_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool s_ready = false;
+
+// --------------------
+// Public API
+// --------------------
+bool log_nvs_init(void)
+{
+    portENTER_CRITICAL(&s_lock_mux);
+    if (s_lock == NULL) {
+        s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+    }
+    portEXIT_CRITICAL(&s_lock_mux);
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (!s_ready) {
+        const esp_err_t err = nvs_flash_init();
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "nvs_flash_init failed: %s", esp_err_to_name(err));
+        }
+        s_ready = (err == ESP_OK);
+    }
+    const bool ready = s_ready;
+    xSemaphoreGive(s_lock);
+    return ready;
+}
+
+bool log_nvs_open(const char *name, nvs_handle_t *handle)
+{
+    return log_nvs_init() && nvs_open(name, NVS_READWRITE, handle) == ESP_OK;
+}
@@ -0,0 +1,39 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Small device state the logger keeps across resets.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_nvs.h
+ * @brief   NVS brought up once for every module of the logger that keeps state in it
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    The first call initialises NVS; NVS already initialised by the OPTIGA
+ *          datastore is fine. Safe from any task.
+ *******************************************************************************/
+#ifndef LOG_NVS_H
+#define LOG_NVS_H
+
+#include <stdbool.h>
+
+#include "nvs.h"
+
+// Initialise NVS if no one did yet. False if it is not usable.
+bool log_nvs_init(void);
+
+// log_nvs_init(), then open namespace read-write; nvs_close() the handle.
+bool log_nvs_open(const char *name, nvs_handle_t *handle);
+
+#endif // LOG_NVS_H
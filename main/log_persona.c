@@ -0,0 +1,132 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Boot without re-checking an OPTIGA that was already set up.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_persona.c
+ * @brief   Personalization record in NVS: what OPTIGA was found set up with
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <stddef.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_rom_crc.h"
+#include "nvs.h"
+
+#include "log_nvs.h"
+#include "log_persona.h"
+
+#define PERSONA_NAMESPACE   "enc_log"
+#define PERSONA_KEY         "persona"
+#define PERSONA_VERSION     1
+
+// NVS blob: the record, the device it belongs to and a CRC32 over both
+typedef struct {
+    uint16_t version;
+    uint8_t mac[6];
+    log_persona_t persona;
+    uint32_t crc;
+} persona_blob_t;
+
+// --------------------
+// Globals
+// --------------------
+static const char *TAG = "LOG_PERSONA";
+static log_persona_t s_persona;
+static bool s_loaded = false;
+
+// --------------------
+// Helpers
+// --------------------
+static void blob_fill(persona_blob_t *blob, const log_persona_t *persona)
+{
+    memset(blob, 0, sizeof(*blob));
+    blob->version = PERSONA_VERSION;
+    esp_efuse_mac_get_default(blob->mac);
+    // Field by field: padding in the caller's copy must not reach the CRC
+    blob->persona.layout = persona->layout;
+    blob->persona.key_epoch = persona->key_epoch;
+    blob->persona.objects = persona->objects;
+    blob->persona.current_limit_ma = persona->current_limit_ma;
+    blob->crc = esp_rom_crc32_le(0, (const uint8_t *)blob, offsetof(persona_blob_t, crc));
+}
+
+static void persona_load(void)
+{
+    persona_blob_t blob;
+    persona_blob_t expect;
+    size_t len = sizeof(blob);
+    nvs_handle_t handle;
+
+    memset(&s_persona, 0, sizeof(s_persona));
+    s_loaded = true;
+    if (!log_nvs_open(PERSONA_NAMESPACE, &handle)) {
+        return;
+    }
+    const esp_err_t err = nvs_get_blob(handle, PERSONA_KEY, &blob, &len);
+    nvs_close(handle);
+    if (err != ESP_OK || len != sizeof(blob)) {
+        return;
+    }
+
+    // Same content rebuilt on this device: version, MAC and CRC must all match
+    blob_fill(&expect, &blob.persona);
+    if (memcmp(&blob, &expect, sizeof(blob)) != 0) {
+        ESP_LOGW(TAG, "record from another device or firmware, ignored");
+        return;
+    }
+    s_persona = blob.persona;
+}
+
+// --------------------
+// Public API
+// --------------------
+const log_persona_t *log_persona_get(void)
+{
+    if (!s_loaded) {
+        persona_load();
+    }
+    return &s_persona;
+}
+
+bool log_persona_update(const log_persona_t *persona)
+{
+    persona_blob_t blob;
+    nvs_handle_t handle;
+
+    const log_persona_t *now = log_persona_get();
+    if (persona->layout == now->layout && persona->key_epoch == now->key_epoch &&
+        persona->objects == now->objects && persona->current_limit_ma == now->current_limit_ma) {
+        return true;
+    }
+    if (!log_nvs_open(PERSONA_NAMESPACE, &handle)) {
+        return false;
+    }
+    blob_fill(&blob, persona);
+    const bool ok = nvs_set_blob(handle, PERSONA_KEY, &blob, sizeof(blob)) == ESP_OK &&
+                    nvs_commit(handle) == ESP_OK;
+    nvs_close(handle);
+    if (ok) {
+        s_persona = blob.persona;
+    }
+    return ok;
+}
@@ -0,0 +1,55 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Boot without re-checking an OPTIGA that was already set up.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_persona.h
+ * @brief   Personalization record in NVS: what OPTIGA was found set up with
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    One small NVS blob, bound to this ESP32 (base MAC) and guarded by a
+ *          CRC. It only says what an earlier boot verified; enc_log decides what
+ *          to trust, compares the layout hash and clears the objects when OPTIGA
+ *          disagrees with the record.
+ *******************************************************************************/
+#ifndef LOG_PERSONA_H
+#define LOG_PERSONA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+// Objects found set up in OPTIGA (log_persona_t.objects)
+#define LOG_PERSONA_KEY             0x01    // AES key slot LOG_KEY_OID
+#define LOG_PERSONA_HYBRID_SECRET   0x02    // LOG_HYBRID_SECRET_OID
+#define LOG_PERSONA_MAC_SECRET      0x04    // LOG_MAC_SECRET_OID
+
+typedef struct {
+    uint32_t layout;            // hash of the OPTIGA setup the firmware that wrote it expects
+    uint32_t key_epoch;         // keys generated in LOG_KEY_OID on this device
+    uint8_t objects;            // LOG_PERSONA_* verified
+    uint8_t current_limit_ma;   // value last stored in 0xE0C4, 0 = unknown
+} log_persona_t;
+
+// The record of this device, read from NVS on the first call. All zero when there is
+// none, it fails its CRC or was written on another ESP32.
+const log_persona_t *log_persona_get(void);
+
+// Store persona if it differs from the record (one NVS write, none when unchanged)
+bool log_persona_update(const log_persona_t *persona);
+
+#endif // LOG_PERSONA_H
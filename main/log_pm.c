@@ -0,0 +1,181 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Run at low clocks and light sleep between storage and OPTIGA transfers.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_pm.c
+ * @brief   esp_pm configuration, store I/O lock and energy estimate
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "optiga/pal/pal_os_diag.h"
+
+#include "log_pm.h"
+
+#if LOG_PM
+
+static const char *TAG = "LOG_PM";
+
+// --------------------
+// Globals
+// --------------------
+static esp_pm_lock_handle_t s_io_lock = NULL;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t s_io_depth = 0;         // nested log_pm_io_begin() calls, all tasks
+static int64_t s_io_start_us = 0;       // when the depth left 0
+static uint32_t s_io_sections = 0;
+static uint64_t s_io_us = 0;
+#ifdef CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+static int64_t s_sleep_start_us = 0;
+static uint32_t s_sleeps = 0;
+static uint64_t s_sleep_us = 0;
+#endif
+
+// --------------------
+// Light Sleep
+// --------------------
+#ifdef CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+// Both run from the idle task with interrupts off; esp_timer keeps counting in light
+// sleep, so the difference is the time actually slept (an early wake included)
+static IRAM_ATTR esp_err_t sleep_enter(int64_t sleep_time_us, void *arg)
+{
+    s_sleep_start_us = esp_timer_get_time();
+    return ESP_OK;
+}
+
+static IRAM_ATTR esp_err_t sleep_exit(int64_t sleep_time_us, void *arg)
+{
+    s_sleeps++;
+    s_sleep_us += (uint64_t)(esp_timer_get_time() - s_sleep_start_us);
+    return ESP_OK;
+}
+#endif
+
+// --------------------
+// Public API
+// --------------------
+bool log_pm_init(void)
+{
+    const esp_pm_config_t config = {
+        .max_freq_mhz = LOG_PM_MAX_MHZ,
+        .min_freq_mhz = LOG_PM_MIN_MHZ,
+        .light_sleep_enable = LOG_PM_LIGHT_SLEEP,
+    };
+    esp_err_t err = esp_pm_configure(&config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_pm_configure failed: %s", esp_err_to_name(err));
+        return false;
+    }
+    err = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "enc_log_io", &s_io_lock);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "store I/O lock not created: %s", esp_err_to_name(err));
+        return false;
+    }
+#ifdef CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+    esp_pm_sleep_cbs_register_config_t cbs = {
+        .enter_cb = sleep_enter,
+        .exit_cb = sleep_exit,
+    };
+    if (esp_pm_light_sleep_register_cbs(&cbs) != ESP_OK) {
+        ESP_LOGW(TAG, "light sleep not measured, counted as idle");
+    }
+#endif
+    ESP_LOGI(TAG, "%d..%d MHz, light sleep %s", LOG_PM_MIN_MHZ, LOG_PM_MAX_MHZ,
+             LOG_PM_LIGHT_SLEEP ? "on" : "off");
+    return true;
+}
+
+void log_pm_io_begin(void)
+{
+    if (s_io_lock == NULL) {
+        return;
+    }
+    esp_pm_lock_acquire(s_io_lock);
+    portENTER_CRITICAL(&s_lock);
+    if (s_io_depth++ == 0) {
+        s_io_start_us = esp_timer_get_time();
+        s_io_sections++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void log_pm_io_end(void)
+{
+    if (s_io_lock == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    if (s_io_depth > 0 && --s_io_depth == 0) {
+        s_io_us += (uint64_t)(esp_timer_get_time() - s_io_start_us);
+    }
+    portEXIT_CRITICAL(&s_lock);
+    esp_pm_lock_release(s_io_lock);
+}
+
+void log_pm_get_stats(log_pm_stats_t *stats)
+{
+    pal_i2c_pm_stats_t i2c;
+    pal_i2c_get_pm_stats(&i2c);
+
+    portENTER_CRITICAL(&s_lock);
+    stats->uptime_us = (uint64_t)esp_timer_get_time();
+    stats->io_sections = s_io_sections;
+    stats->io_us = s_io_us;
+    // A section still open counts up to now
+    if (s_io_depth > 0) {
+        stats->io_us += stats->uptime_us - (uint64_t)s_io_start_us;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    stats->i2c_transfers = i2c.transfers;
+    stats->i2c_us = i2c.held_us;
+#ifdef CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+    // Written with interrupts off on the sleeping core; a torn read is off by one sleep
+    stats->sleeps = s_sleeps;
+    stats->sleep_us = s_sleep_us;
+#else
+    stats->sleeps = 0;
+    stats->sleep_us = 0;
+#endif
+}
+
+double log_pm_energy_uj(const log_pm_stats_t *from, const log_pm_stats_t *to)
+{
+    const double elapsed_us = (double)(to->uptime_us - from->uptime_us);
+    // I2C transfers and store I/O of different tasks may overlap: an upper bound
+    double active_us = (double)(to->io_us - from->io_us) + (double)(to->i2c_us - from->i2c_us);
+    const double sleep_us = (double)(to->sleep_us - from->sleep_us);
+    if (active_us > elapsed_us - sleep_us) {
+        active_us = elapsed_us - sleep_us;
+    }
+    double idle_us = elapsed_us - active_us - sleep_us;
+    if (idle_us < 0) {
+        idle_us = 0;
+    }
+    // mA x us x mV = 1e-6 uJ
+    const double charge = active_us * LOG_PM_ACTIVE_MA + idle_us * LOG_PM_IDLE_MA +
+                          sleep_us * LOG_PM_SLEEP_MA;
+    return charge * LOG_PM_SUPPLY_MV / 1e6;
+}
+
+#endif // LOG_PM
@@ -0,0 +1,64 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Run at low clocks and light sleep between storage and OPTIGA transfers.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_pm.h
+ * @brief   esp_pm configuration, store I/O lock and energy estimate
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    One ESP_PM_CPU_FREQ_MAX lock is held while the logger has the store
+ *          open for I/O (it also keeps the APB clock of SDMMC and SPI flash up and
+ *          light sleep out). The PAL holds its own lock over each I2C transfer.
+ *          Time under either lock counts as active in the energy estimate, time in
+ *          light sleep (CONFIG_PM_LIGHT_SLEEP_CALLBACKS) as sleep, the rest as idle.
+ *******************************************************************************/
+#ifndef LOG_PM_H
+#define LOG_PM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+typedef struct {
+    uint64_t uptime_us;         // esp_timer at the snapshot
+    uint32_t io_sections;       // store I/O sections under the lock
+    uint64_t io_us;             // time the store I/O lock was held
+    uint32_t i2c_transfers;     // OPTIGA I2C transfers under the PAL lock
+    uint64_t i2c_us;            // time the PAL lock was held
+    uint32_t sleeps;            // light sleeps (0 without CONFIG_PM_LIGHT_SLEEP_CALLBACKS)
+    uint64_t sleep_us;          // time in light sleep
+} log_pm_stats_t;
+
+#if LOG_PM
+
+// Configure esp_pm and create the store I/O lock. Call once at boot before enc_log_init().
+bool log_pm_init(void);
+
+// Hold the clocks at maximum for store I/O; calls nest, also across tasks
+void log_pm_io_begin(void);
+void log_pm_io_end(void);
+
+void log_pm_get_stats(log_pm_stats_t *stats);
+
+// Estimated energy in uJ between two snapshots, from LOG_PM_SUPPLY_MV and the
+// LOG_PM_*_MA currents
+double log_pm_energy_uj(const log_pm_stats_t *from, const log_pm_stats_t *to);
+
+#endif // LOG_PM
+
+#endif // LOG_PM_H
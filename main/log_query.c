@@ -0,0 +1,365 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Decrypt the records of a seq or uptime range.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_query.c
+ * @brief   Random-access range queries over the encrypted log
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "enc_log.h"
+#include "log_query.h"
+#include "log_record.h"
+
+typedef struct {
+    log_store_seek_t by;
+    uint32_t from;
+    uint32_t to;
+    bool stop_past_range;       // keys only grow from the start (indexed start)
+    bool past_range;            // query_record() met the first record past the range
+    bool by_channel;            // channel query: aggregate / raw records of channel ...
+    uint8_t channel;
+    int32_t lo;                 // ... with values in [lo, hi]
+    int32_t hi;
+    const char *key;            // key query: JSON records with "key": value
+    const char *value;
+    size_t value_len;
+    uint64_t wall_base_ms;      // time queries: boot of the records before base_until
+    uint32_t base_until;
+    bool have_base;
+    log_query_emit_t emit;
+    void *ctx;
+    log_query_stats_t *stats;
+    enc_log_snapshot_t snap;    // offsets of the scan and the lookups
+} query_t;
+
+// --------------------
+// Globals
+// --------------------
+static const char *TAG = "LOG_QUERY";
+
+// --------------------
+// Records
+// --------------------
+// Wall time (ms) of a record, 0 if its boot had no clock. Records up to the next index
+// entry share the boot of the entry at or before them: one lookup per index entry.
+static uint64_t record_time_ms(query_t *q, uint32_t offset, uint64_t uptime_ms)
+{
+    if (!q->have_base || offset >= q->base_until) {
+        log_store_entry_t e;
+        const bool found = enc_log_snapshot_seek(&q->snap, LOG_STORE_SEEK_POSITION, offset, &e);
+        q->wall_base_ms = found ? e.wall_base_ms : 0;
+        q->base_until = found ? e.next_position : UINT32_MAX;
+        q->have_base = true;
+    }
+    return (q->wall_base_ms != 0) ? q->wall_base_ms + uptime_ms : 0;
+}
+
+// Aggregate / raw record of the channel whose values reach into [lo, hi]
+static bool channel_match(const query_t *q, const log_record_fields_t *f)
+{
+    return (f->schema == RECORD_SCHEMA_AGG || f->schema == RECORD_SCHEMA_RAW) &&
+           f->channel == q->channel && f->max >= q->lo && f->min <= q->hi;
+}
+
+static void emit_record(query_t *q, const log_reader_record_t *rec, const log_record_fields_t *f)
+{
+    q->stats->matched++;
+    if (f->format == RECORD_FORMAT_JSON) {
+        q->emit((const char *)rec->data, f->text_len, q->ctx);
+    } else if (f->schema != RECORD_SCHEMA_SAMPLE) {
+        // Aggregate / raw channel record: uptime is the window start of an aggregate
+        char json[160];
+        const int n = snprintf(json, sizeof(json),
+                               "{\"seq\":%llu,\"uptime_ms\":%llu,\"ch\":%u,\"n\":%u,"
+                               "\"min\":%ld,\"max\":%ld,\"mean\":%ld}",
+                               (unsigned long long)f->seq, (unsigned long long)f->uptime_ms,
+                               (unsigned)f->channel, (unsigned)f->count, (long)f->min,
+                               (long)f->max, (long)f->mean);
+        if (n > 0 && (size_t)n < sizeof(json)) {
+            q->emit(json, (size_t)n, q->ctx);
+        }
+    } else {
+        // Same text as a JSON-format record
+        char json[PLAINTEXT_MAX];
+        const int n = snprintf(json, sizeof(json), "{\"seq\":%llu,\"uptime_ms\":%llu}",
+                               (unsigned long long)f->seq, (unsigned long long)f->uptime_ms);
+        if (n > 0 && (size_t)n < sizeof(json)) {
+            q->emit(json, (size_t)n, q->ctx);
+        }
+    }
+}
+
+// Key query: any JSON payload, with or without seq and uptime (text_len is set either way)
+static bool key_record(query_t *q, const log_reader_record_t *rec)
+{
+    log_record_fields_t f;
+    const bool parsed = log_record_fields(rec->data, rec->len, &f);
+    const char *value;
+    size_t value_len;
+    if (rec->len > 0 && rec->data[0] == '{' &&
+        log_record_json_field(rec->data, f.text_len, q->key, &value, &value_len) &&
+        value_len == q->value_len && memcmp(value, q->value, value_len) == 0) {
+        emit_record(q, rec, &f);
+    } else if (parsed) {
+        q->stats->skipped++;
+    } else {
+        q->stats->unparsed++;
+    }
+    return true;
+}
+
+static bool query_record(const log_reader_record_t *rec, void *ctx)
+{
+    query_t *q = (query_t *)ctx;
+    if (q->key != NULL) {
+        return key_record(q, rec);
+    }
+    log_record_fields_t f;
+    if (!log_record_fields(rec->data, rec->len, &f)) {
+        q->stats->unparsed++;
+        return true;
+    }
+    if (q->by_channel) {
+        if (channel_match(q, &f)) {
+            emit_record(q, rec, &f);
+        } else {
+            q->stats->skipped++;
+        }
+        return true;
+    }
+
+    uint64_t key;
+    uint64_t from = q->from;
+    uint64_t to = q->to;
+    if (q->by == LOG_STORE_SEEK_TIME) {
+        key = record_time_ms(q, rec->offset, f.uptime_ms);
+        from *= 1000;
+        to = to * 1000 + 999;
+        if (key == 0) {
+            q->stats->skipped++;
+            return true;
+        }
+    } else {
+        key = (q->by == LOG_STORE_SEEK_SEQ) ? f.seq : f.uptime_ms;
+    }
+    if (key > to) {
+        q->stats->skipped++;
+        q->past_range = q->stop_past_range;
+        return !q->stop_past_range;
+    }
+    if (key < from) {
+        q->stats->skipped++;
+        return true;
+    }
+
+    emit_record(q, rec, &f);
+    return true;
+}
+
+// --------------------
+// Segment Skipping
+// --------------------
+#if LOG_ZONE_MAP
+// False if the zone map of a sealed segment rules out every record of the query
+static bool zone_may_match(const query_t *q, const log_zone_t *z)
+{
+    if (z->records == 0) {
+        return false;
+    }
+    if (q->key != NULL) {
+        return log_zone_may_contain(z, q->key, q->value, q->value_len);
+    }
+    if (q->by_channel) {
+        if (q->channel >= LOG_ZONE_CHANNELS) {
+            return (z->kinds & (LOG_ZONE_KIND_AGG | LOG_ZONE_KIND_RAW)) != 0;
+        }
+        return (z->channels & (1u << q->channel)) && z->ch_max[q->channel] >= q->lo &&
+               z->ch_min[q->channel] <= q->hi;
+    }
+    switch (q->by) {
+    case LOG_STORE_SEEK_SEQ:
+        return z->last_seq >= q->from && z->first_seq <= q->to;
+    case LOG_STORE_SEEK_UPTIME:
+        return z->max_uptime_ms >= q->from && z->min_uptime_ms <= q->to;
+    case LOG_STORE_SEEK_TIME:
+        // Records of boots without a set clock match no time query
+        return z->max_wall_ms != 0 && z->max_wall_ms >= (uint64_t)q->from * 1000 &&
+               z->min_wall_ms <= (uint64_t)q->to * 1000 + 999;
+    default:
+        return true;
+    }
+}
+#endif
+
+static bool zone_excludes(const query_t *q, const log_store_zone_t *z)
+{
+#if LOG_ZONE_MAP
+    return z->summarised && !zone_may_match(q, &z->zone);
+#else
+    (void)q;
+    (void)z;
+    return false;
+#endif
+}
+
+// Scan from start (encrypted under the epoch header at epoch) to the end of the snapshot,
+// passing over the sealed segments the zone maps rule out. Each run of segments in
+// between is one reader scan.
+static bool query_scan(query_t *q, uint32_t epoch, uint32_t start)
+{
+    log_query_stats_t *stats = q->stats;
+    uint32_t pos = start;
+    bool ok = true;
+
+    while (ok && !q->past_range && pos < q->snap.size) {
+        log_store_zone_t z;
+        if (enc_log_snapshot_zone(&q->snap, pos, &z) && zone_excludes(q, &z)) {
+            stats->zones_skipped++;
+            pos = z.end;
+            // A segment starts with its own epoch header (hybrid mode)
+            epoch = INDEX_NO_EPOCH;
+            continue;
+        }
+        uint32_t end = pos;
+        while (end < q->snap.size) {
+            if (!enc_log_snapshot_zone(&q->snap, end, &z)) {
+                // The open segment runs to the end
+                end = q->snap.size;
+                break;
+            }
+            if (zone_excludes(q, &z)) {
+                break;
+            }
+            end = z.end;
+        }
+        if (end > q->snap.size) {
+            end = q->snap.size;
+        }
+
+        log_reader_stats_t run;
+        ok = log_reader_scan(enc_log_snapshot_read, &q->snap, epoch, pos, end, query_record, q, &run);
+        stats->reader.records += run.records;
+        stats->reader.units += run.units;
+        stats->reader.requests += run.requests;
+        stats->reader.cached += run.cached;
+        stats->reader.bytes += run.bytes;
+        stats->reader.errors += run.errors;
+        stats->reader.bad_checksums += run.bad_checksums;
+        stats->reader.bad_tags += run.bad_tags;
+        stats->reader.elapsed_us += run.elapsed_us;
+        pos = end;
+        epoch = INDEX_NO_EPOCH;
+    }
+    return ok;
+}
+
+// --------------------
+// Public API
+// --------------------
+bool log_query_run(log_store_seek_t by, uint32_t from, uint32_t to,
+                   log_query_emit_t emit, void *ctx, log_query_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if (from > to) {
+        return false;
+    }
+
+    query_t q = {
+        .by = by,
+        .from = from,
+        .to = to,
+        .have_base = false,
+        .emit = emit,
+        .ctx = ctx,
+        .stats = stats,
+    };
+    enc_log_snapshot_open(&q.snap);
+
+    log_store_entry_t entry = {0};
+    stats->indexed = enc_log_snapshot_seek(&q.snap, by, from, &entry);
+    if (!stats->indexed) {
+        entry.position = 0;
+        entry.epoch_position = INDEX_NO_EPOCH;
+    }
+    stats->start = entry.position;
+    q.stop_past_range = stats->indexed;
+
+    const bool ok = query_scan(&q, entry.epoch_position, entry.position);
+    enc_log_snapshot_close(&q.snap);
+    ESP_LOGD(TAG, "start %lu (%s): %lu matched, %lu skipped, %lu segments skipped",
+             (unsigned long)stats->start, stats->indexed ? "index" : "scan",
+             (unsigned long)stats->matched, (unsigned long)stats->skipped,
+             (unsigned long)stats->zones_skipped);
+    return ok;
+}
+
+bool log_query_channel(uint8_t channel, int32_t lo, int32_t hi, log_query_emit_t emit,
+                       void *ctx, log_query_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if (lo > hi) {
+        return false;
+    }
+
+    query_t q = {
+        .by_channel = true,
+        .channel = channel,
+        .lo = lo,
+        .hi = hi,
+        .emit = emit,
+        .ctx = ctx,
+        .stats = stats,
+    };
+    enc_log_snapshot_open(&q.snap);
+    const bool ok = query_scan(&q, INDEX_NO_EPOCH, 0);
+    enc_log_snapshot_close(&q.snap);
+    ESP_LOGD(TAG, "channel %u: %lu matched, %lu skipped, %lu segments skipped", (unsigned)channel,
+             (unsigned long)stats->matched, (unsigned long)stats->skipped,
+             (unsigned long)stats->zones_skipped);
+    return ok;
+}
+
+bool log_query_key(const char *key, const char *value, log_query_emit_t emit, void *ctx,
+                   log_query_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    query_t q = {
+        .key = key,
+        .value = value,
+        .value_len = strlen(value),
+        .emit = emit,
+        .ctx = ctx,
+        .stats = stats,
+    };
+    enc_log_snapshot_open(&q.snap);
+    const bool ok = query_scan(&q, INDEX_NO_EPOCH, 0);
+    enc_log_snapshot_close(&q.snap);
+    ESP_LOGD(TAG, "%s=%s: %lu matched, %lu skipped, %lu segments skipped", key, value,
+             (unsigned long)stats->matched, (unsigned long)stats->skipped,
+             (unsigned long)stats->zones_skipped);
+    return ok;
+}
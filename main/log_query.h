@@ -0,0 +1,74 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Decrypt the records of a seq, uptime or wall time range.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_query.h
+ * @brief   Random-access range queries over the encrypted log
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    The sparse index (log_store_seek()) gives the record or block group
+ *          to start decrypting at, and the scan stops at the first record past
+ *          the range: at most LOG_INDEX_EVERY records are decrypted and thrown
+ *          away on top of the result. Without an index (raw store,
+ *          LOG_INDEX_EVERY 0) the whole log is scanned and filtered, and an
+ *          uptime range then matches the records of every boot. Wall time comes
+ *          from the index (boot base + record uptime), so a time query needs the
+ *          index and matches no records of boots without a set clock. With zone
+ *          maps (LOG_ZONE_MAP) sealed segments whose summary rules out the range
+ *          or channel values (or, for a key query, whose Bloom filter lacks the
+ *          value) are not decrypted at all.
+ *******************************************************************************/
+#ifndef LOG_QUERY_H
+#define LOG_QUERY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "log_reader.h"
+#include "log_store.h"
+
+typedef struct {
+    uint32_t matched;           // records passed to emit
+    uint32_t skipped;           // records decrypted outside the range
+    uint32_t unparsed;          // records without a seq/uptime field
+    uint32_t start;             // log offset the scan started at
+    bool indexed;               // start came from the index
+    log_reader_stats_t reader;
+    uint32_t zones_skipped;     // sealed segments passed over on their zone map
+} log_query_stats_t;
+
+// One matching record as JSON text (not NUL-terminated, valid during the call)
+typedef void (*log_query_emit_t)(const char *json, size_t len, void *ctx);
+
+// Decrypt the records with from <= seq (or uptime ms, newest boot, or wall time in
+// Unix s) <= to, in log order. False if the scan failed; the records emitted so far stand.
+bool log_query_run(log_store_seek_t by, uint32_t from, uint32_t to,
+                   log_query_emit_t emit, void *ctx, log_query_stats_t *stats);
+
+// Decrypt the aggregate and raw records of channel (log_agg.h) with values reaching
+// into [lo, hi], in log order. Without zone maps every record is decrypted.
+bool log_query_channel(uint8_t channel, int32_t lo, int32_t hi, log_query_emit_t emit,
+                       void *ctx, log_query_stats_t *stats);
+
+// Decrypt the JSON records whose "key" field is value (a string without its quotes, or a
+// number as written), in log order. For keys of LOG_ZONE_BLOOM_KEYS only the sealed
+// segments whose Bloom filter may hold the value are decrypted.
+bool log_query_key(const char *key, const char *value, log_query_emit_t emit, void *ctx,
+                   log_query_stats_t *stats);
+
+#endif // LOG_QUERY_H
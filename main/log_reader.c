@@ -0,0 +1,812 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Stream the log back and decrypt it in bulk.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_reader.c
+ * @brief   Streaming bulk decryption reader
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+
+#include "optiga/optiga_crypt.h"
+#include "optiga_sync.h"
+
+#if LOG_HYBRID_MODE
+#include "mbedtls/aes.h"
+#include "mbedtls/gcm.h"
+#include "mbedtls/platform_util.h"
+#endif
+
+#include "log_reader.h"
+#if LOG_CTR_MODE
+#include "log_simd.h"
+#endif
+#if LOG_BATCH_COMPRESS
+#include "log_lz.h"
+#endif
+#if LOG_BATCH_DELTA
+#include "log_delta.h"
+#include "log_record.h"
+#endif
+#if LOG_READ_CACHE
+#include "log_cache.h"
+#endif
+
+// Smallest unit worth parsing: enough for the 8-byte header magics
+#define READER_MIN_UNIT_BYTES   8
+#define READER_RUN_UNITS        (LOG_READER_RUN_BYTES / (AES_IV_BYTES + AES_BLOCK_BYTES))
+// Largest unit in log bytes: a block group with header and tag, or a root record
+#define READER_STAGE_BYTES      (LOG_READER_RUN_BYTES + MERKLE_ROOT_BYTES)
+// Magic and length in front of a variable-length record
+#define READER_VARLEN_HDR_BYTES 2
+
+// Storage class of the scan state: plain statics on the device, one scan at a time. The
+// host exporter builds it __thread and runs one scan per worker thread.
+#ifndef LOG_READER_TLS
+#define LOG_READER_TLS
+#endif
+
+// Layouts this build can decrypt: CTR and hybrid keys only its own; the OPTIGA CBC
+// layouts (fixed or variable records, plain, compressed or delta groups, with or without
+// checksums) any of them
+#if LOG_CTR_MODE || LOG_HYBRID_MODE
+#define READER_FORMATS_EXACT    1
+#define READER_FORMATS          LOG_FORMAT_FLAGS
+#else
+#define READER_FORMATS_EXACT    0
+#define READER_FORMATS                                                          \
+    (LOG_FORMAT_VARLEN | LOG_FORMAT_GROUPS | LOG_FORMAT_CRC |                   \
+     (LOG_BATCH_COMPRESS ? LOG_FORMAT_LZ : 0) | (LOG_BATCH_DELTA ? LOG_FORMAT_DELTA : 0))
+#endif
+
+// One record or block group in a run
+typedef struct {
+    uint32_t offset;            // log offset of the unit
+    uint16_t ct_pos;            // first ciphertext byte in the run (after its IV)
+    uint16_t ct_len;
+    uint8_t count;              // records (block group) or plaintext bytes (varlen record)
+    uint16_t lz_len;            // compressed plaintext bytes of a 'Z' block group, else 0
+    bool delta;                 // 'D' block group: records are rebuilt from the deltas
+    bool forged;                // AES-GCM record whose tag did not verify
+    bool cached;                // plaintext from the read cache, at ct_pos in out
+#if LOG_READ_CACHE
+    log_cache_key_t key;
+#endif
+} reader_unit_t;
+
+// IV || ciphertext of consecutive units, decrypted as one CBC stream. Units found in the
+// read cache take no part: their plaintext is stacked at the back of out instead.
+typedef struct {
+    uint8_t in[LOG_READER_RUN_BYTES];
+    uint8_t out[LOG_READER_RUN_BYTES];
+    reader_unit_t units[READER_RUN_UNITS];
+    uint32_t used;
+    uint32_t cached;            // plaintext bytes at the back of out
+    uint32_t out_len;
+    uint32_t n_units;
+    uint32_t format;            // LOG_FORMAT_* layout of its units
+} reader_run_t;
+
+// --------------------
+// Globals
+// --------------------
+static const char *TAG = "LOG_READER";
+#if !LOG_CTR_MODE && !LOG_RECORD_GCM
+// Any IV will do: the first block of a run is a unit's IV, never plaintext
+static const uint8_t s_run_iv[AES_IV_BYTES] = {0};
+#endif
+
+static LOG_READER_TLS reader_run_t s_runs[2];
+static LOG_READER_TLS uint8_t s_stage[READER_STAGE_BYTES];     // log bytes [s_stage_offset, + s_stage_len)
+static LOG_READER_TLS uint32_t s_stage_offset = 0;
+static LOG_READER_TLS uint32_t s_stage_len = 0;
+static LOG_READER_TLS log_reader_read_t s_read = NULL;
+static LOG_READER_TLS void *s_read_ctx = NULL;
+static LOG_READER_TLS uint32_t s_end = 0;
+static LOG_READER_TLS log_reader_stats_t *s_stats = NULL;
+static LOG_READER_TLS uint32_t s_format = LOG_FORMAT_LEGACY_FLAGS;    // layout at the fill cursor
+
+static LOG_READER_TLS optiga_crypt_t *s_crypt = NULL;
+static LOG_READER_TLS optiga_sync_t s_sync;
+
+#if LOG_BATCH_COMPRESS
+static LOG_READER_TLS uint8_t s_lz_out[BATCH_PT_MAX_BYTES];
+#endif
+#if LOG_BATCH_DELTA
+static LOG_READER_TLS log_delta_batch_t s_delta;
+static LOG_READER_TLS uint8_t s_delta_rec[PLAINTEXT_MAX];
+#endif
+
+#if LOG_RECORD_GCM
+static LOG_READER_TLS mbedtls_gcm_context s_aes;
+static LOG_READER_TLS uint8_t s_epoch_aad[EPOCH_AAD_BYTES];    // epoch header bytes the tags cover
+#elif LOG_HYBRID_MODE
+static LOG_READER_TLS mbedtls_aes_context s_aes;
+#endif
+#if LOG_HYBRID_MODE
+static LOG_READER_TLS bool s_key_ready = false;        // false until the first epoch header
+#endif
+#if LOG_CTR_MODE == LOG_CTR_PACKED
+// Counter blocks of the run in flight, turned into its keystream by one ECB request. A
+// packed record may start and end inside a block: up to two blocks more than its bytes.
+static LOG_READER_TLS uint8_t s_ks[LOG_READER_RUN_BYTES + READER_RUN_UNITS * AES_BLOCK_BYTES] __attribute__((aligned(16)));
+static LOG_READER_TLS uint32_t s_ks_len = 0;
+#elif LOG_CTR_MODE
+// Counter blocks of the run in flight, turned into its keystream by one ECB request
+static LOG_READER_TLS uint8_t s_ks[LOG_READER_RUN_BYTES] __attribute__((aligned(16)));
+static LOG_READER_TLS uint32_t s_ks_len = 0;
+#endif
+
+// --------------------
+// Staging
+// --------------------
+// need contiguous log bytes at offset, refilled from the source in one large read
+static const uint8_t *stage_peek(uint32_t offset, size_t need)
+{
+    if (need > s_end - offset) {
+        return NULL;
+    }
+    if (offset < s_stage_offset || offset + need > s_stage_offset + s_stage_len) {
+        const uint32_t left = s_end - offset;
+        const size_t want = (left < sizeof(s_stage)) ? left : sizeof(s_stage);
+        size_t got = 0;
+        while (got < want) {
+            const size_t n = s_read(s_read_ctx, offset + (uint32_t)got, s_stage + got, want - got);
+            if (n == 0) {
+                break;
+            }
+            got += n;
+        }
+        s_stage_offset = offset;
+        s_stage_len = (uint32_t)got;
+        if (got < need) {
+            return NULL;
+        }
+    }
+    return s_stage + (offset - s_stage_offset);
+}
+
+// --------------------
+// Formats
+// --------------------
+// Take the layout from a format header; false if this build cannot read it
+static bool format_apply(const uint8_t *header, uint32_t offset)
+{
+    const uint8_t *f = header + FORMAT_HDR_MAGIC_BYTES;
+    const uint16_t version = (uint16_t)(f[0] | (f[1] << 8));
+    const uint32_t flags = (uint32_t)f[2] | ((uint32_t)f[3] << 8) | ((uint32_t)f[4] << 16) |
+                           ((uint32_t)f[5] << 24);
+    const uint16_t record_bytes = (uint16_t)(f[6] | (f[7] << 8));
+    // Later versions only add fields after these
+    if (version == 0 || record_bytes != PLAINTEXT_MAX ||
+        (READER_FORMATS_EXACT ? flags != LOG_FORMAT_FLAGS
+                              : (flags & ~(uint32_t)READER_FORMATS) != 0)) {
+        ESP_LOGE(TAG, "format v%u layout 0x%04lx (%u byte records) at offset %lu: "
+                 "this reader is built for layout 0x%04lx", (unsigned)version,
+                 (unsigned long)flags, (unsigned)record_bytes, (unsigned long)offset,
+                 (unsigned long)LOG_FORMAT_FLAGS);
+        return false;
+    }
+    s_format = flags;
+    return true;
+}
+
+// Bytes between a record's header and its ciphertext in layout format
+static uint32_t iv_bytes(uint32_t format)
+{
+    return (format & LOG_FORMAT_GCM) ? GCM_NONCE_BYTES + GCM_TAG_BYTES : AES_IV_BYTES;
+}
+
+// Plaintext checksum bytes at the end of each unit in layout format
+static uint32_t crc_bytes(uint32_t format)
+{
+    return (format & LOG_FORMAT_CRC) ? LOG_CRC_BYTES : 0;
+}
+
+// Plaintext bytes behind the ciphertext of a variable-length record of len bytes
+static uint32_t varlen_ct_bytes(uint32_t len, uint32_t format)
+{
+    len += crc_bytes(format);
+    if (format & (LOG_FORMAT_CTR_PACKED | LOG_FORMAT_GCM)) {
+        return len;
+    }
+    return (len == 0) ? AES_BLOCK_BYTES
+                      : ((len + AES_BLOCK_BYTES - 1) / AES_BLOCK_BYTES) * AES_BLOCK_BYTES;
+}
+
+// The checksum at the end of the decrypted unit (len bytes) matches its plaintext
+static bool crc_ok(const uint8_t *pt, uint32_t len)
+{
+    if (len < LOG_CRC_BYTES) {
+        return false;
+    }
+    const uint32_t body = len - LOG_CRC_BYTES;
+    const uint32_t crc = esp_rom_crc32_le(0, pt, body);
+    return pt[body] == (uint8_t)crc && pt[body + 1] == (uint8_t)(crc >> 8) &&
+           pt[body + 2] == (uint8_t)(crc >> 16) && pt[body + 3] == (uint8_t)(crc >> 24);
+}
+
+#if LOG_HYBRID_MODE
+// Same HKDF as the writer: the salt in the epoch header gives the data key back
+static bool derive_epoch_key(const uint8_t *header)
+{
+    static const uint8_t info[] = EPOCH_KEY_INFO;
+    uint8_t key[16];
+
+    s_key_ready = false;
+    optiga_lib_status_t ret = OPTIGA_SYNC_CALL(&s_sync, LOG_OPTIGA_TIMEOUT_MS,
+        optiga_crypt_hkdf(s_crypt, OPTIGA_HKDF_SHA_256, LOG_HYBRID_SECRET_OID,
+                          header + EPOCH_SALT_OFFSET, EPOCH_SALT_BYTES, info, sizeof(info),
+                          sizeof(key), TRUE, key));
+    if (ret != OPTIGA_LIB_SUCCESS) {
+        ESP_LOGE(TAG, "optiga_crypt_hkdf failed: 0x%04X", ret);
+        return false;
+    }
+#if LOG_RECORD_GCM
+    memcpy(s_epoch_aad, header, EPOCH_AAD_BYTES);
+    const int rc = mbedtls_gcm_setkey(&s_aes, MBEDTLS_CIPHER_ID_AES, key, 128);
+#else
+    const int rc = mbedtls_aes_setkey_dec(&s_aes, key, 128);
+#endif
+    mbedtls_platform_zeroize(key, sizeof(key));
+    s_key_ready = (rc == 0);
+    return s_key_ready;
+}
+#endif
+
+// --------------------
+// Runs
+// --------------------
+// Add the unit at *cursor to the run, skipping headers. False once the run is complete
+// (full, end of data, key or layout change, or error); *cursor stays on the unit not taken.
+static bool take_unit(reader_run_t *r, uint32_t *cursor, bool *error)
+{
+    while (*cursor < s_end) {
+        const uint8_t *p = stage_peek(*cursor, READER_MIN_UNIT_BYTES);
+        if (p == NULL) {
+            ESP_LOGW(TAG, "torn tail at offset %lu", (unsigned long)*cursor);
+            *error = true;
+            return false;
+        }
+        if (memcmp(p, MERKLE_ROOT_MAGIC, MERKLE_ROOT_MAGIC_BYTES) == 0) {
+            *cursor += (s_end - *cursor < MERKLE_ROOT_BYTES) ? s_end - *cursor : MERKLE_ROOT_BYTES;
+            continue;
+        }
+        if (memcmp(p, EPOCH_HDR_MAGIC, EPOCH_HDR_MAGIC_BYTES) == 0) {
+#if LOG_HYBRID_MODE
+            // The units taken so far are under the previous key
+            if (r->n_units > 0) {
+                return false;
+            }
+            p = stage_peek(*cursor, EPOCH_HDR_BYTES);
+            if (p == NULL || !derive_epoch_key(p)) {
+                *error = true;
+                return false;
+            }
+#endif
+            *cursor += EPOCH_HDR_BYTES;
+            continue;
+        }
+        if (memcmp(p, FORMAT_HDR_MAGIC, FORMAT_HDR_MAGIC_BYTES) == 0) {
+            p = stage_peek(*cursor, FORMAT_HDR_BYTES);
+            if (p == NULL) {
+                ESP_LOGW(TAG, "torn tail at offset %lu", (unsigned long)*cursor);
+                *error = true;
+                return false;
+            }
+            const uint32_t before = s_format;
+            if (!format_apply(p, *cursor)) {
+                *error = true;
+                return false;
+            }
+            // The units taken so far are in the previous layout
+            if (r->n_units > 0 && s_format != r->format) {
+                s_format = before;
+                return false;
+            }
+            r->format = s_format;
+            *cursor += FORMAT_HDR_BYTES;
+            continue;
+        }
+
+        const bool varlen = (r->format & LOG_FORMAT_VARLEN) != 0;
+        uint32_t hdr_len = 0;
+        uint32_t tail_len = 0;
+        uint32_t ct_len;
+        uint8_t count;
+        uint16_t lz_len = 0;
+        bool delta = false;
+        if (r->format & LOG_FORMAT_GROUPS) {
+            const uint8_t magic1 = varlen ? BLOCK_GROUP_MAGIC1_VAR : BLOCK_GROUP_MAGIC1;
+            const bool lz = (r->format & LOG_FORMAT_LZ) && p[1] == BLOCK_GROUP_MAGIC1_LZ;
+            delta = (r->format & LOG_FORMAT_DELTA) && p[1] == BLOCK_GROUP_MAGIC1_DELTA;
+            const bool tagged = (p[0] == BLOCK_GROUP_MAGIC0_MAC || p[0] == BLOCK_GROUP_MAGIC0_CMAC);
+            if ((p[0] != BLOCK_GROUP_MAGIC0 && !tagged) ||
+                (p[1] != magic1 && !lz && !delta)) {
+                ESP_LOGE(TAG, "no block group at offset %lu", (unsigned long)*cursor);
+                *error = true;
+                return false;
+            }
+            hdr_len = (lz ? BLOCK_GROUP_LZ_HDR_BYTES : BLOCK_GROUP_HDR_BYTES) - AES_IV_BYTES;
+            tail_len = tagged ? LOG_MAC_TAG_BYTES : 0;
+            count = p[2];
+            ct_len = (varlen || lz || delta) ? (uint32_t)p[3] * AES_BLOCK_BYTES
+                                             : (uint32_t)count * PLAINTEXT_MAX;
+            if (lz) {
+                lz_len = (uint16_t)(p[4] | (p[5] << 8));
+                if (lz_len == 0 || lz_len + crc_bytes(r->format) > ct_len) {
+                    ESP_LOGE(TAG, "bad compressed group at offset %lu", (unsigned long)*cursor);
+                    *error = true;
+                    return false;
+                }
+            }
+        } else if (varlen) {
+            if (p[0] != RECORD_VARLEN_MAGIC || p[1] > PLAINTEXT_MAX) {
+                ESP_LOGE(TAG, "no record at offset %lu", (unsigned long)*cursor);
+                *error = true;
+                return false;
+            }
+            hdr_len = READER_VARLEN_HDR_BYTES;
+            count = p[1];
+            ct_len = varlen_ct_bytes(count, r->format);
+        } else {
+            count = 0;
+            ct_len = PLAINTEXT_MAX;
+        }
+        const uint32_t prefix_len = iv_bytes(r->format);
+        const uint32_t body_len = prefix_len + ct_len;
+        if ((ct_len == 0 && !(r->format & LOG_FORMAT_GCM)) || body_len > LOG_READER_RUN_BYTES) {
+            ESP_LOGE(TAG, "bad unit length at offset %lu", (unsigned long)*cursor);
+            *error = true;
+            return false;
+        }
+        if (r->used + r->cached + body_len > LOG_READER_RUN_BYTES ||
+            r->n_units == READER_RUN_UNITS) {
+            return false;
+        }
+        p = stage_peek(*cursor, hdr_len + body_len + tail_len);
+        if (p == NULL) {
+            ESP_LOGW(TAG, "torn tail at offset %lu", (unsigned long)*cursor);
+            *error = true;
+            return false;
+        }
+#if LOG_HYBRID_MODE
+        if (!s_key_ready) {
+            // Before the first epoch header of the range: the key is unknown
+            s_stats->errors++;
+            *cursor += hdr_len + body_len + tail_len;
+            continue;
+        }
+#endif
+        reader_unit_t *u = &r->units[r->n_units++];
+        u->offset = *cursor;
+        u->ct_len = (uint16_t)ct_len;
+        u->count = count;
+        u->lz_len = lz_len;
+        u->delta = delta;
+        u->forged = false;
+        u->cached = false;
+#if LOG_READ_CACHE
+        // Decrypted by an earlier scan: no part of the run's request
+        log_cache_key(p + hdr_len, body_len, &u->key);
+        if (log_cache_get(&u->key, r->out + LOG_READER_RUN_BYTES - r->cached - ct_len, ct_len)) {
+            r->cached += ct_len;
+            u->ct_pos = (uint16_t)(LOG_READER_RUN_BYTES - r->cached);
+            u->cached = true;
+            s_stats->cached++;
+        }
+#endif
+        if (!u->cached) {
+            memcpy(r->in + r->used, p + hdr_len, body_len);
+            u->ct_pos = (uint16_t)(r->used + prefix_len);
+            r->used += body_len;
+        }
+        *cursor += hdr_len + body_len + tail_len;
+        return true;
+    }
+    return false;
+}
+
+static void fill_run(reader_run_t *r, uint32_t *cursor, bool *error)
+{
+    r->used = 0;
+    r->cached = 0;
+    r->n_units = 0;
+    r->format = s_format;
+    while (take_unit(r, cursor, error)) {
+    }
+}
+
+#if LOG_CTR_MODE
+// Counter block of the unit's first block (stored where the IV goes) plus add
+static void ctr_block_add(uint8_t *block, const uint8_t *first, uint32_t add)
+{
+    memcpy(block, first, AES_BLOCK_BYTES);
+    uint64_t carry = add;
+    for (int i = AES_BLOCK_BYTES - 1; i >= IV_NONCE_BYTES && carry != 0; i--) {
+        carry += block[i];
+        block[i] = (uint8_t)carry;
+        carry >>= 8;
+    }
+}
+#endif
+
+#if LOG_CTR_MODE == LOG_CTR_PACKED
+// Keystream byte position of the unit's first byte (stored where the IV goes)
+static uint64_t ctr_position(const uint8_t *field)
+{
+    uint64_t pos = 0;
+    for (int i = IV_NONCE_BYTES; i < AES_BLOCK_BYTES; i++) {
+        pos = (pos << 8) | field[i];
+    }
+    return pos;
+}
+#endif
+
+// Start decrypting the run; OPTIGA works on it while the caller reads the next one
+static bool run_start(reader_run_t *r)
+{
+#if LOG_READ_CACHE
+    // Every unit came from the cache
+    if (r->used == 0) {
+        r->out_len = 0;
+        return true;
+    }
+#endif
+    s_stats->requests++;
+#if LOG_CTR_MODE
+    // The keystream of every unit, back to back, in one ECB request
+    s_ks_len = 0;
+    for (uint32_t n = 0; n < r->n_units; n++) {
+        const reader_unit_t *u = &r->units[n];
+        if (u->cached) {
+            continue;
+        }
+        const uint8_t *first = r->in + u->ct_pos - AES_IV_BYTES;
+#if LOG_CTR_MODE == LOG_CTR_PACKED
+        // Counter block of the first byte: the nonce and the position / 16
+        uint8_t block[AES_BLOCK_BYTES];
+        const uint64_t pos = ctr_position(first);
+        memcpy(block, first, IV_NONCE_BYTES);
+        for (int i = 0; i < 8; i++) {
+            block[IV_NONCE_BYTES + i] = (uint8_t)((pos / AES_BLOCK_BYTES) >> (56 - 8 * i));
+        }
+        const uint32_t blocks =
+            (uint32_t)((pos % AES_BLOCK_BYTES + u->ct_len + AES_BLOCK_BYTES - 1) / AES_BLOCK_BYTES);
+        for (uint32_t b = 0; b < blocks; b++) {
+            ctr_block_add(s_ks + s_ks_len, block, b);
+            s_ks_len += AES_BLOCK_BYTES;
+        }
+#else
+        for (uint32_t b = 0; b < u->ct_len / AES_BLOCK_BYTES; b++) {
+            ctr_block_add(s_ks + s_ks_len, first, b);
+            s_ks_len += AES_BLOCK_BYTES;
+        }
+#endif
+    }
+    r->out_len = s_ks_len;
+    optiga_sync_begin(&s_sync);
+    return optiga_crypt_symmetric_encrypt_ecb(s_crypt, OPTIGA_KEY_ID_SECRET_BASED, s_ks, s_ks_len,
+                                              s_ks, &r->out_len) == OPTIGA_LIB_SUCCESS;
+#elif LOG_RECORD_GCM
+    // Each record on its own: its nonce, its tag and, as AAD, the epoch and its header
+    uint8_t aad[EPOCH_AAD_BYTES + READER_VARLEN_HDR_BYTES];
+    memcpy(aad, s_epoch_aad, EPOCH_AAD_BYTES);
+    aad[EPOCH_AAD_BYTES] = RECORD_VARLEN_MAGIC;
+    for (uint32_t n = 0; n < r->n_units; n++) {
+        reader_unit_t *u = &r->units[n];
+        if (u->cached) {
+            continue;
+        }
+        const uint8_t *nonce = r->in + u->ct_pos - GCM_NONCE_BYTES - GCM_TAG_BYTES;
+        aad[EPOCH_AAD_BYTES + 1] = u->count;
+        const int rc = mbedtls_gcm_auth_decrypt(&s_aes, u->ct_len, nonce, GCM_NONCE_BYTES, aad,
+                                                sizeof(aad), nonce + GCM_NONCE_BYTES, GCM_TAG_BYTES,
+                                                r->in + u->ct_pos, r->out + u->ct_pos);
+        if (rc == MBEDTLS_ERR_GCM_AUTH_FAILED) {
+            u->forged = true;
+        } else if (rc != 0) {
+            return false;
+        }
+    }
+    r->out_len = r->used;
+    return true;
+#elif LOG_HYBRID_MODE
+    uint8_t iv[AES_IV_BYTES];
+    memcpy(iv, s_run_iv, sizeof(iv));
+    r->out_len = r->used;
+    return mbedtls_aes_crypt_cbc(&s_aes, MBEDTLS_AES_DECRYPT, r->used, iv, r->in, r->out) == 0;
+#else
+    // One request: the command layer chains it into max-size APDUs
+    r->out_len = r->used;
+    optiga_sync_begin(&s_sync);
+    return optiga_crypt_symmetric_decrypt(s_crypt, OPTIGA_SYMMETRIC_CBC, OPTIGA_KEY_ID_SECRET_BASED,
+                                          r->in, r->used, s_run_iv, AES_IV_BYTES, NULL, 0,
+                                          r->out, &r->out_len) == OPTIGA_LIB_SUCCESS;
+#endif
+}
+
+static bool run_wait(reader_run_t *r)
+{
+#if LOG_READ_CACHE
+    if (r->used == 0) {
+        return true;
+    }
+#endif
+#if !LOG_HYBRID_MODE
+    optiga_lib_status_t ret = optiga_sync_wait_timeout(&s_sync, LOG_OPTIGA_TIMEOUT_MS);
+    if (ret == OPTIGA_LIB_BUSY) {
+        ESP_LOGW(TAG, "OPTIGA decrypt still running after %u ms", (unsigned)LOG_OPTIGA_TIMEOUT_MS);
+        ret = optiga_sync_wait(&s_sync);
+    }
+    if (ret != OPTIGA_LIB_SUCCESS) {
+        return false;
+    }
+#endif
+#if LOG_CTR_MODE
+    if (r->out_len != s_ks_len) {
+        return false;
+    }
+    uint32_t k = 0;
+    for (uint32_t n = 0; n < r->n_units; n++) {
+        const reader_unit_t *u = &r->units[n];
+        if (u->cached) {
+            continue;
+        }
+#if LOG_CTR_MODE == LOG_CTR_PACKED
+        // The unit's blocks start at its first byte's block: skip what earlier records used
+        const uint32_t skip =
+            (uint32_t)(ctr_position(r->in + u->ct_pos - AES_IV_BYTES) % AES_BLOCK_BYTES);
+        const uint32_t blocks = (skip + u->ct_len + AES_BLOCK_BYTES - 1) / AES_BLOCK_BYTES;
+        log_simd_xor(r->out + u->ct_pos, r->in + u->ct_pos, s_ks + k + skip, u->ct_len);
+        k += blocks * AES_BLOCK_BYTES;
+#else
+        log_simd_xor(r->out + u->ct_pos, r->in + u->ct_pos, s_ks + k, u->ct_len);
+        k += u->ct_len;
+#endif
+    }
+    return true;
+#else
+    return r->out_len == r->used;
+#endif
+}
+
+#if LOG_READ_CACHE
+// Keep the plaintext of the units the run decrypted for later scans
+static void run_cache(const reader_run_t *r)
+{
+    for (uint32_t n = 0; n < r->n_units; n++) {
+        const reader_unit_t *u = &r->units[n];
+        if (!u->cached && !u->forged) {
+            log_cache_put(&u->key, r->out + u->ct_pos, u->ct_len);
+        }
+    }
+}
+#endif
+
+#if LOG_BATCH_DELTA
+// Rebuild the records of a 'D' block group; false if the callback asked to stop
+static bool emit_delta_group(const reader_unit_t *u, const uint8_t *pt, uint32_t pt_len,
+                             bool varlen, log_reader_cb_t cb, void *ctx)
+{
+    log_reader_record_t rec = {.offset = u->offset};
+    if (!log_delta_decode(pt, pt_len, u->count, &s_delta)) {
+        ESP_LOGW(TAG, "bad delta group at offset %lu", (unsigned long)u->offset);
+        s_stats->errors++;
+        return true;
+    }
+    for (uint32_t i = 0; i < u->count; i++) {
+        // Zero-padded like a fixed-size slot
+        memset(s_delta_rec, 0, sizeof(s_delta_rec));
+        const size_t n = log_record_encode(s_delta_rec, sizeof(s_delta_rec), s_delta.format,
+                                           s_delta.seq[i], s_delta.uptime_ms[i]);
+        if (n == 0) {
+            s_stats->errors++;
+            break;
+        }
+        rec.len = varlen ? (uint16_t)n : PLAINTEXT_MAX;
+        rec.data = s_delta_rec;
+        rec.index = (uint16_t)i;
+        s_stats->records++;
+        if (!cb(&rec, ctx)) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+// Hand the run's records to the callback; false if it asked to stop
+static bool run_emit(const reader_run_t *r, log_reader_cb_t cb, void *ctx)
+{
+    const bool varlen = (r->format & LOG_FORMAT_VARLEN) != 0;
+    for (uint32_t n = 0; n < r->n_units; n++) {
+        const reader_unit_t *u = &r->units[n];
+        const uint8_t *pt = r->out + u->ct_pos;
+        log_reader_record_t rec = {.offset = u->offset};
+
+        s_stats->units++;
+        // Caught here, a wrong key or a damaged unit never reaches the parsers
+        if (u->forged) {
+            ESP_LOGW(TAG, "authentication failed at offset %lu", (unsigned long)u->offset);
+            s_stats->bad_tags++;
+            s_stats->errors++;
+            continue;
+        }
+        if ((r->format & LOG_FORMAT_CRC) && !crc_ok(pt, u->ct_len)) {
+            ESP_LOGW(TAG, "checksum mismatch at offset %lu", (unsigned long)u->offset);
+            s_stats->bad_checksums++;
+            s_stats->errors++;
+            continue;
+        }
+        uint32_t pt_len = u->ct_len - crc_bytes(r->format);
+        if (!(r->format & LOG_FORMAT_GROUPS)) {
+            rec.len = varlen ? u->count : PLAINTEXT_MAX;
+            rec.data = pt;
+            s_stats->records++;
+            if (!cb(&rec, ctx)) {
+                return false;
+            }
+            continue;
+        }
+#if LOG_BATCH_DELTA
+        if (u->delta) {
+            if (!emit_delta_group(u, pt, pt_len, varlen, cb, ctx)) {
+                return false;
+            }
+            continue;
+        }
+#endif
+#if LOG_BATCH_COMPRESS
+        if (u->lz_len > 0) {
+            pt_len = (uint32_t)log_lz_decompress(pt, u->lz_len, s_lz_out, sizeof(s_lz_out));
+            pt = s_lz_out;
+        }
+#endif
+        if (varlen ? pt_len == 0 : pt_len < (uint32_t)u->count * PLAINTEXT_MAX) {
+            ESP_LOGW(TAG, "bad block group plaintext at offset %lu", (unsigned long)u->offset);
+            s_stats->errors++;
+            continue;
+        }
+        uint32_t pos = 0;
+        for (uint32_t i = 0; i < u->count; i++) {
+            if (varlen) {
+                if (pos >= pt_len || pt[pos] > PLAINTEXT_MAX || pos + 1 + pt[pos] > pt_len) {
+                    s_stats->errors++;
+                    break;
+                }
+                rec.len = pt[pos];
+                rec.data = pt + pos + 1;
+                pos += 1 + rec.len;
+            } else {
+                rec.len = PLAINTEXT_MAX;
+                rec.data = pt + pos;
+                pos += PLAINTEXT_MAX;
+            }
+            rec.index = (uint16_t)i;
+            s_stats->records++;
+            if (!cb(&rec, ctx)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// --------------------
+// Public API
+// --------------------
+bool log_reader_scan(log_reader_read_t read, void *read_ctx, uint32_t epoch, uint32_t start,
+                     uint32_t end, log_reader_cb_t cb, void *ctx, log_reader_stats_t *stats)
+{
+    const int64_t t0 = esp_timer_get_time();
+    memset(stats, 0, sizeof(*stats));
+    if (start > end) {
+        return false;
+    }
+    s_stats = stats;
+    s_read = read;
+    s_read_ctx = read_ctx;
+    s_end = end;
+    s_stage_offset = 0;
+    s_stage_len = 0;
+
+    // Own instance for the scan: decrypts never queue behind the writer's s_crypt state
+    s_crypt = optiga_crypt_create(0, optiga_sync_callback, &s_sync);
+    if (s_crypt == NULL) {
+        ESP_LOGE(TAG, "optiga_crypt_create failed");
+        return false;
+    }
+    bool error = false;
+    s_format = LOG_FORMAT_LEGACY_FLAGS;
+#if LOG_RECORD_GCM
+    mbedtls_gcm_init(&s_aes);
+#elif LOG_HYBRID_MODE
+    mbedtls_aes_init(&s_aes);
+#endif
+#if LOG_HYBRID_MODE
+    s_key_ready = false;
+    if (epoch != INDEX_NO_EPOCH && epoch < start) {
+        const uint8_t *header = stage_peek(epoch, EPOCH_HDR_BYTES);
+        if (header == NULL || memcmp(header, EPOCH_HDR_MAGIC, EPOCH_HDR_MAGIC_BYTES) != 0 ||
+            !derive_epoch_key(header)) {
+            ESP_LOGW(TAG, "no epoch header at offset %lu", (unsigned long)epoch);
+            error = true;
+        }
+    }
+#else
+    // Outside hybrid mode the index names the format header the data is written in
+    if (epoch != INDEX_NO_EPOCH && epoch < start) {
+        const uint8_t *header = stage_peek(epoch, FORMAT_HDR_BYTES);
+        if (header != NULL && memcmp(header, FORMAT_HDR_MAGIC, FORMAT_HDR_MAGIC_BYTES) == 0 &&
+            !format_apply(header, epoch)) {
+            error = true;
+        }
+    }
+#endif
+
+    uint32_t cursor = start;
+    reader_run_t *cur = &s_runs[0];
+    reader_run_t *next = &s_runs[1];
+    if (!error) {
+        fill_run(cur, &cursor, &error);
+    } else {
+        cur->n_units = 0;
+    }
+    while (cur->n_units > 0) {
+        if (!run_start(cur)) {
+            ESP_LOGE(TAG, "decrypt start failed");
+            error = true;
+            break;
+        }
+        // Prefetch: read and stage the next run while this one is decrypted
+        fill_run(next, &cursor, &error);
+        if (!run_wait(cur)) {
+            ESP_LOGE(TAG, "decrypt failed");
+            error = true;
+            break;
+        }
+#if LOG_READ_CACHE
+        run_cache(cur);
+#endif
+        if (!run_emit(cur, cb, ctx)) {
+            break;
+        }
+        reader_run_t *done = cur;
+        cur = next;
+        next = done;
+    }
+
+#if LOG_RECORD_GCM
+    mbedtls_gcm_free(&s_aes);
+#elif LOG_HYBRID_MODE
+    mbedtls_aes_free(&s_aes);
+#endif
+    (void)optiga_crypt_destroy(s_crypt);
+    s_crypt = NULL;
+    stats->bytes = cursor - start;
+    stats->elapsed_us = (uint32_t)(esp_timer_get_time() - t0);
+    return !error;
+}
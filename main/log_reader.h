@@ -0,0 +1,74 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Stream the log back and decrypt it in bulk.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_reader.h
+ * @brief   Streaming bulk decryption reader
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Understands every format the writer is built for (enc_log_config.h):
+ *          fixed or variable-length records, block groups (MAC tags are skipped,
+ *          not checked), hybrid epoch headers and Merkle root records. Format
+ *          headers switch the layout as the scan passes them, so data written by
+ *          builds with other record options is read in place: any OPTIGA CBC
+ *          layout, or exactly the build's with CTR or hybrid keys. Not
+ *          reentrant: one scan at a time (per thread with LOG_READER_TLS).
+ *******************************************************************************/
+#ifndef LOG_READER_H
+#define LOG_READER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+typedef struct {
+    uint32_t offset;            // log offset of the record or of its block group
+    uint16_t index;             // record number in the block group (0 for single records)
+    uint16_t len;               // plaintext bytes (fixed-size records: PLAINTEXT_MAX, zero-padded)
+    const uint8_t *data;        // valid during the callback only
+} log_reader_record_t;
+
+typedef struct {
+    uint32_t records;           // records passed to the callback
+    uint32_t units;             // records and block groups decrypted
+    uint32_t requests;          // decrypt requests (OPTIGA, or host AES in hybrid mode)
+    uint32_t cached;            // units served from the read cache (LOG_READ_CACHE), no request
+    uint32_t bytes;             // log bytes scanned
+    uint32_t errors;            // units that could not be decrypted or parsed
+    uint32_t bad_checksums;     // of these, units dropped on a plaintext checksum mismatch
+    uint32_t bad_tags;          // of these, AES-GCM records dropped on a tag mismatch
+    uint32_t elapsed_us;        // scan time
+} log_reader_stats_t;
+
+// Raw log bytes at offset, e.g. enc_log_snapshot_read(). Returns bytes read.
+typedef size_t (*log_reader_read_t)(void *read_ctx, uint32_t offset, void *buf, size_t len);
+
+// Called in log order for every record; return false to stop the scan
+typedef bool (*log_reader_cb_t)(const log_reader_record_t *rec, void *ctx);
+
+// Decrypt the log bytes [start, end); start must be the start of a record, block
+// group or header. In hybrid mode the key comes from the epoch header at epoch
+// (INDEX_NO_EPOCH: from the first header at or after start); otherwise the layout
+// comes from the format header at epoch (INDEX_NO_EPOCH: LOG_FORMAT_LEGACY_FLAGS until
+// the first header at or after start). False on an OPTIGA or
+// parse error (stats are filled in either way).
+bool log_reader_scan(log_reader_read_t read, void *read_ctx, uint32_t epoch, uint32_t start,
+                     uint32_t end, log_reader_cb_t cb, void *ctx, log_reader_stats_t *stats);
+
+#endif // LOG_READER_H
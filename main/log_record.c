@@ -0,0 +1,219 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Write and parse the producer's sample records.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_record.c
+ * @brief   Sample record fields (JSON, CBOR or packed, see LOG_RECORD_FORMAT)
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <stdio.h>
+#include <string.h>
+
+#include "enc_log_config.h"
+#include "log_cbor.h"
+#include "log_record.h"
+#include "log_schema.h"
+
+// sample_t, sample_pack(), sample_unpack()
+LOG_SCHEMA_CODEC(SAMPLE, sample)
+// agg_t / raw_sample_t and their pack/unpack (log_agg.c records)
+LOG_SCHEMA_CODEC(AGG, agg)
+LOG_SCHEMA_CODEC(RAW, raw_sample)
+
+// Unsigned value of "key": in a JSON record; the producer writes no whitespace
+static bool json_uint(const char *text, size_t len, const char *key, uint64_t *value)
+{
+    const size_t key_len = strlen(key);
+    for (size_t i = 0; i + key_len < len; i++) {
+        if (memcmp(text + i, key, key_len) != 0) {
+            continue;
+        }
+        size_t j = i + key_len;
+        if (text[j] < '0' || text[j] > '9') {
+            return false;
+        }
+        uint64_t v = 0;
+        while (j < len && text[j] >= '0' && text[j] <= '9') {
+            v = v * 10 + (uint64_t)(text[j] - '0');
+            j++;
+        }
+        *value = v;
+        return true;
+    }
+    return false;
+}
+
+size_t log_record_encode(uint8_t *buf, size_t cap, uint8_t format, uint64_t seq,
+                         uint64_t uptime_ms)
+{
+    if (format == RECORD_FORMAT_PACKED) {
+        const sample_t rec = {.seq = (uint32_t)seq, .uptime_ms = uptime_ms};
+        return (seq <= UINT32_MAX) ? sample_pack(buf, cap, &rec) : 0;
+    }
+    if (format != RECORD_FORMAT_CBOR) {
+        const int n = snprintf((char *)buf, cap, "{\"seq\":%llu,\"uptime_ms\":%llu}",
+                               (unsigned long long)seq, (unsigned long long)uptime_ms);
+        return (n > 0 && (size_t)n < cap) ? (size_t)n : 0;
+    }
+    // Schema id, then the CBOR map (11B for a 49-day uptime vs ~35B of JSON)
+    log_cbor_t c;
+    log_cbor_init(&c, buf, cap);
+    log_cbor_put_raw(&c, RECORD_SCHEMA_SAMPLE);
+    log_cbor_put_map(&c, 2);
+    log_cbor_put_uint(&c, RECORD_KEY_SEQ);
+    log_cbor_put_uint(&c, seq);
+    log_cbor_put_uint(&c, RECORD_KEY_UPTIME_MS);
+    log_cbor_put_uint(&c, uptime_ms);
+    return log_cbor_finish(&c);
+}
+
+size_t log_record_encode_agg(uint8_t *buf, size_t cap, uint64_t seq, uint64_t window_ms,
+                             uint8_t channel, uint16_t count, int32_t min, int32_t max,
+                             int32_t mean)
+{
+    const agg_t rec = {.seq = (uint32_t)seq, .uptime_ms = window_ms, .channel = channel,
+                       .count = count, .min = (uint32_t)min, .max = (uint32_t)max,
+                       .mean = (uint32_t)mean};
+    return (seq <= UINT32_MAX) ? agg_pack(buf, cap, &rec) : 0;
+}
+
+size_t log_record_encode_raw(uint8_t *buf, size_t cap, uint64_t seq, uint64_t uptime_ms,
+                             uint8_t channel, int32_t value)
+{
+    const raw_sample_t rec = {.seq = (uint32_t)seq, .uptime_ms = uptime_ms, .channel = channel,
+                              .value = (uint32_t)value};
+    return (seq <= UINT32_MAX) ? raw_sample_pack(buf, cap, &rec) : 0;
+}
+
+// Aggregate and raw channel records; false for any other packed schema
+static bool channel_fields(const uint8_t *data, size_t len, log_record_fields_t *out)
+{
+    if (data[0] == LOG_SCHEMA_AGG_ID) {
+        agg_t rec;
+        if (!agg_unpack(data, len, &rec)) {
+            return false;
+        }
+        out->schema = RECORD_SCHEMA_AGG;
+        out->seq = rec.seq;
+        out->uptime_ms = rec.uptime_ms;
+        out->channel = rec.channel;
+        out->count = rec.count;
+        out->min = (int32_t)rec.min;
+        out->max = (int32_t)rec.max;
+        out->mean = (int32_t)rec.mean;
+        return true;
+    }
+    raw_sample_t rec;
+    if (!raw_sample_unpack(data, len, &rec)) {
+        return false;
+    }
+    out->schema = RECORD_SCHEMA_RAW;
+    out->seq = rec.seq;
+    out->uptime_ms = rec.uptime_ms;
+    out->channel = rec.channel;
+    out->count = 1;
+    out->min = (int32_t)rec.value;
+    out->max = out->min;
+    out->mean = out->min;
+    return true;
+}
+
+bool log_record_fields(const uint8_t *data, size_t len, log_record_fields_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->schema = RECORD_SCHEMA_SAMPLE;
+    if (len > 0 && data[0] == '{') {
+        // Fixed-size records are zero-padded
+        const uint8_t *nul = memchr(data, 0, len);
+        out->text_len = nul ? (size_t)(nul - data) : len;
+        return json_uint((const char *)data, out->text_len, "\"seq\":", &out->seq) &&
+               json_uint((const char *)data, out->text_len, "\"uptime_ms\":", &out->uptime_ms);
+    }
+    if (len > 0 && (data[0] & LOG_SCHEMA_ID_PACKED)) {
+        out->format = RECORD_FORMAT_PACKED;
+        if (data[0] != LOG_SCHEMA_SAMPLE_ID) {
+            return channel_fields(data, len, out);
+        }
+        sample_t rec;
+        if (!sample_unpack(data, len, &rec)) {
+            return false;
+        }
+        out->seq = rec.seq;
+        out->uptime_ms = rec.uptime_ms;
+        return true;
+    }
+
+    log_cbor_reader_t r;
+    log_cbor_reader_init(&r, data, len);
+    uint32_t pairs = 0;
+    if (log_cbor_get_raw(&r) != RECORD_SCHEMA_SAMPLE || !log_cbor_get_map(&r, &pairs)) {
+        return false;
+    }
+    out->format = RECORD_FORMAT_CBOR;
+    bool have_seq = false;
+    bool have_uptime = false;
+    for (uint32_t i = 0; i < pairs; i++) {
+        uint64_t key;
+        uint64_t value;
+        if (!log_cbor_get_uint(&r, &key) || !log_cbor_get_uint(&r, &value)) {
+            return false;
+        }
+        if (key == RECORD_KEY_SEQ) {
+            out->seq = value;
+            have_seq = true;
+        } else if (key == RECORD_KEY_UPTIME_MS) {
+            out->uptime_ms = value;
+            have_uptime = true;
+        }
+    }
+    return have_seq && have_uptime;
+}
+
+bool log_record_json_field(const uint8_t *data, size_t len, const char *key,
+                           const char **value, size_t *value_len)
+{
+    const char *text = (const char *)data;
+    const size_t key_len = strlen(key);
+    for (size_t i = 0; i + key_len + 3 < len; i++) {
+        if (text[i] != '"' || memcmp(text + i + 1, key, key_len) != 0 ||
+            text[i + 1 + key_len] != '"' || text[i + 2 + key_len] != ':') {
+            continue;
+        }
+        size_t j = i + key_len + 3;
+        size_t end = j;
+        if (text[j] == '"') {
+            j++;
+            end = j;
+            while (end < len && text[end] != '"') {
+                end++;
+            }
+        } else {
+            while (end < len && text[end] != ',' && text[end] != '}' && text[end] != ' ' &&
+                   text[end] != '\0') {
+                end++;
+            }
+        }
+        *value = text + j;
+        *value_len = end - j;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,72 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Write and parse the producer's sample records.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_record.h
+ * @brief   Sample record fields (JSON, CBOR or packed, see LOG_RECORD_FORMAT)
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    No ESP-IDF dependencies: also built into the Linux host exporter
+ *          (tools/enc_log_host).
+ *******************************************************************************/
+#ifndef LOG_RECORD_H
+#define LOG_RECORD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+typedef struct {
+    uint64_t seq;
+    uint64_t uptime_ms;         // aggregate: window start
+    uint8_t format;             // RECORD_FORMAT_*
+    uint8_t schema;             // RECORD_SCHEMA_*: sample, aggregate or raw channel sample
+    size_t text_len;            // JSON: text length without the zero padding
+    uint8_t channel;            // aggregate / raw: channel (log_agg.h)
+    uint16_t count;             // aggregate: samples in the window, raw: 1
+    int32_t min;                // aggregate: window min/max/mean, raw: the value in all three
+    int32_t max;
+    int32_t mean;
+} log_record_fields_t;
+
+// Sample record as the producer writes it in format (RECORD_FORMAT_*): CBOR (schema
+// id + map, see LOG_RECORD_CBOR), packed (log_schema.h, seq must fit in 32 bits) or
+// JSON text {"seq":..,"uptime_ms":..} without the terminating NUL (written if it
+// fits). Returns the length, 0 if it does not fit in cap.
+size_t log_record_encode(uint8_t *buf, size_t cap, uint8_t format, uint64_t seq,
+                         uint64_t uptime_ms);
+
+// Packed channel records of the aggregation stage (log_agg.h). Return the length, 0 if
+// it does not fit in cap or seq does not fit in 32 bits.
+size_t log_record_encode_agg(uint8_t *buf, size_t cap, uint64_t seq, uint64_t window_ms,
+                             uint8_t channel, uint16_t count, int32_t min, int32_t max,
+                             int32_t mean);
+size_t log_record_encode_raw(uint8_t *buf, size_t cap, uint64_t seq, uint64_t uptime_ms,
+                             uint8_t channel, int32_t value);
+
+// seq and uptime of a decrypted sample, aggregate or raw channel record, and the
+// channel values of the latter two. False for other payloads.
+bool log_record_fields(const uint8_t *data, size_t len, log_record_fields_t *out);
+
+// Value of "key": in a JSON record of len bytes: a string without its quotes, or the
+// text up to the next ',', '}' or space. False if the key is missing.
+bool log_record_json_field(const uint8_t *data, size_t len, const char *key,
+                           const char **value, size_t *value_len);
+
+#endif // LOG_RECORD_H
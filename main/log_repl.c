@@ -0,0 +1,668 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Replicate the encrypted log to a peer ESP32 over ESP-NOW.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_repl.c
+ * @brief   Windowed ESP-NOW transfer of sealed segments, resumed by segment id
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "esp_event.h"
+#include "esp_idf_version.h"
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_now.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#include "enc_log.h"
+#include "log_nvs.h"
+#include "log_repl.h"
+
+#if LOG_REPL
+
+#define REPL_DATA_BYTES     (ESP_NOW_MAX_DATA_LEN - REPL_HDR_BYTES)
+#define REPL_WINDOW_BYTES   ((uint32_t)LOG_REPL_WINDOW * REPL_DATA_BYTES)
+#define REPL_QUEUE_LEN      (LOG_REPL_WINDOW + 4)
+#define REPL_TX_SLOTS       4       // frames handed to ESP-NOW, send callback pending
+#define REPL_PATH_BYTES     64
+
+// A received frame, queued by the receive callback for the task running the transfer
+typedef struct {
+    uint8_t mac[ESP_NOW_ETH_ALEN];
+    uint8_t type;
+    uint8_t flags;
+    uint32_t id;
+    uint32_t value;
+    uint16_t len;
+    uint8_t data[REPL_DATA_BYTES];
+} repl_frame_t;
+
+typedef enum {
+    REPL_SENT,                  // the gateway stored the segment
+    REPL_GONE,                  // segment no longer readable (cleared meanwhile)
+    REPL_FAILED,                // gateway out of reach or refusing the segment
+} repl_status_t;
+
+// Gateway end of one device's transfer
+typedef struct {
+    uint8_t mac[ESP_NOW_ETH_ALEN];
+    bool active;
+    int64_t last_us;            // last frame from the device
+    FILE *file;                 // part file of segment id
+    uint32_t id;                // segment being received, 0 = none
+    uint32_t held;              // its bytes in order
+    uint32_t crc;
+    uint32_t done_id;           // last segment stored; its END is acked again
+    uint32_t since_ack;         // frames taken since the last ack
+    uint32_t gap_id;            // segment and held of the last gap ack, UINT32_MAX = none
+    uint32_t gap_at;
+    uint32_t segments;          // stored in this session
+    uint32_t bytes;
+} repl_session_t;
+
+// --------------------
+// Globals
+// --------------------
+static const char *TAG = "LOG_REPL";
+static const uint8_t s_broadcast[ESP_NOW_ETH_ALEN] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+static QueueHandle_t s_rx = NULL;
+static StaticQueue_t s_rx_queue;
+static uint8_t s_rx_storage[REPL_QUEUE_LEN * sizeof(repl_frame_t)];
+static SemaphoreHandle_t s_tx_slots = NULL;
+static StaticSemaphore_t s_tx_slots_buf;
+static bool s_wifi_ours = false;        // Wi-Fi brought up here: stopped after each run
+static volatile uint32_t s_rx_dropped = 0;
+static volatile uint32_t s_tx_failed = 0;
+// Device: segment bytes [s_buf_off, s_buf_off + s_buf_len) of s_buf_id
+static uint8_t s_buf[REPL_WINDOW_BYTES];
+static uint32_t s_buf_id = 0;
+static uint32_t s_buf_off = 0;
+static uint32_t s_buf_len = 0;
+static uint32_t s_resent = 0;           // data frames sent again (this run)
+static repl_session_t s_gw;
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+// --------------------
+// Radio
+// --------------------
+// Wi-Fi task: queue the frame for the transfer loop, never block here
+static void repl_recv(const esp_now_recv_info_t *info, const uint8_t *data, int len)
+{
+    repl_frame_t f;
+
+    if (len < REPL_HDR_BYTES || len > REPL_HDR_BYTES + REPL_DATA_BYTES ||
+        data[0] != REPL_MAGIC0 || data[1] != REPL_MAGIC1) {
+        return;
+    }
+    memcpy(f.mac, info->src_addr, sizeof(f.mac));
+    f.type = data[2];
+    f.flags = data[3];
+    f.id = get_le32(data + 4);
+    f.value = get_le32(data + 8);
+    f.len = (uint16_t)(len - REPL_HDR_BYTES);
+    memcpy(f.data, data + REPL_HDR_BYTES, f.len);
+    if (xQueueSend(s_rx, &f, 0) != pdTRUE) {
+        s_rx_dropped++;
+    }
+}
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 5, 0)
+static void repl_sent(const esp_now_send_info_t *info, esp_now_send_status_t status)
+#else
+static void repl_sent(const uint8_t *mac, esp_now_send_status_t status)
+#endif
+{
+    // Unicast: no MAC ack after the retries. The protocol resends what is missing.
+    if (status != ESP_NOW_SEND_SUCCESS) {
+        s_tx_failed++;
+    }
+    xSemaphoreGive(s_tx_slots);
+}
+
+static bool add_peer(const uint8_t *mac)
+{
+    esp_now_peer_info_t peer;
+
+    if (esp_now_is_peer_exist(mac)) {
+        return true;
+    }
+    memset(&peer, 0, sizeof(peer));
+    memcpy(peer.peer_addr, mac, ESP_NOW_ETH_ALEN);
+    peer.channel = 0;           // the current one, LOG_REPL_CHANNEL unless an AP holds another
+    peer.ifidx = WIFI_IF_STA;
+    // Link encryption would only cover the last hop of bytes that are encrypted already
+    peer.encrypt = false;
+    return esp_now_add_peer(&peer) == ESP_OK;
+}
+
+static bool radio_start(void)
+{
+    wifi_mode_t mode;
+
+    if (s_rx == NULL) {
+        s_rx = xQueueCreateStatic(REPL_QUEUE_LEN, sizeof(repl_frame_t), s_rx_storage, &s_rx_queue);
+        s_tx_slots = xSemaphoreCreateCountingStatic(REPL_TX_SLOTS, REPL_TX_SLOTS, &s_tx_slots_buf);
+    }
+    xQueueReset(s_rx);
+    while (uxSemaphoreGetCount(s_tx_slots) < REPL_TX_SLOTS) {
+        xSemaphoreGive(s_tx_slots);
+    }
+
+    // No network of the application: bring up the station interface for ESP-NOW only
+    if (!s_wifi_ours && esp_wifi_get_mode(&mode) == ESP_ERR_WIFI_NOT_INIT) {
+        const wifi_init_config_t config = WIFI_INIT_CONFIG_DEFAULT();
+        (void)log_nvs_init();
+        (void)esp_netif_init();
+        const esp_err_t err = esp_event_loop_create_default();
+        if ((err != ESP_OK && err != ESP_ERR_INVALID_STATE) || esp_wifi_init(&config) != ESP_OK ||
+            esp_wifi_set_storage(WIFI_STORAGE_RAM) != ESP_OK ||
+            esp_wifi_set_mode(WIFI_MODE_STA) != ESP_OK) {
+            ESP_LOGE(TAG, "Wi-Fi init failed");
+            return false;
+        }
+        s_wifi_ours = true;
+    }
+    if (s_wifi_ours && esp_wifi_start() != ESP_OK) {
+        ESP_LOGE(TAG, "Wi-Fi start failed");
+        return false;
+    }
+    // A station connected to an access point stays on the AP's channel
+    if (esp_wifi_set_channel(LOG_REPL_CHANNEL, WIFI_SECOND_CHAN_NONE) != ESP_OK) {
+        ESP_LOGW(TAG, "cannot switch to channel %u (connected to an AP?)", (unsigned)LOG_REPL_CHANNEL);
+    }
+    if (esp_now_init() != ESP_OK || esp_now_register_recv_cb(repl_recv) != ESP_OK ||
+        esp_now_register_send_cb(repl_sent) != ESP_OK || !add_peer(s_broadcast)) {
+        ESP_LOGE(TAG, "ESP-NOW init failed");
+        esp_now_deinit();
+        return false;
+    }
+    s_rx_dropped = 0;
+    s_tx_failed = 0;
+    return true;
+}
+
+static void radio_stop(void)
+{
+    esp_now_deinit();
+    if (s_wifi_ours) {
+        esp_wifi_stop();
+    }
+}
+
+static bool repl_send(const uint8_t *mac, uint8_t type, uint8_t flags, uint32_t id, uint32_t value,
+                      const void *data, size_t len)
+{
+    uint8_t frame[REPL_HDR_BYTES + REPL_DATA_BYTES];
+
+    frame[0] = REPL_MAGIC0;
+    frame[1] = REPL_MAGIC1;
+    frame[2] = type;
+    frame[3] = flags;
+    put_le32(frame + 4, id);
+    put_le32(frame + 8, value);
+    if (len > 0) {
+        memcpy(frame + REPL_HDR_BYTES, data, len);
+    }
+    // ESP-NOW copies the frame; the slots keep its TX queue from running out
+    if (xSemaphoreTake(s_tx_slots, pdMS_TO_TICKS(LOG_REPL_ACK_MS)) != pdTRUE) {
+        return false;
+    }
+    if (esp_now_send(mac, frame, REPL_HDR_BYTES + len) != ESP_OK) {
+        xSemaphoreGive(s_tx_slots);
+        return false;
+    }
+    return true;
+}
+
+// Next frame of type from mac (and segment id unless 0) within timeout_ms
+static bool repl_wait(const uint8_t *mac, uint8_t type, uint32_t id, uint32_t timeout_ms,
+                      repl_frame_t *f)
+{
+    const int64_t end_us = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    for (;;) {
+        const int64_t left_us = end_us - esp_timer_get_time();
+        if (left_us <= 0 || xQueueReceive(s_rx, f, pdMS_TO_TICKS(left_us / 1000 + 1)) != pdTRUE) {
+            return false;
+        }
+        if (f->type == type && (mac == NULL || memcmp(f->mac, mac, ESP_NOW_ETH_ALEN) == 0) &&
+            (id == 0 || f->id == id)) {
+            return true;
+        }
+    }
+}
+
+// --------------------
+// Device
+// --------------------
+// Segment bytes [offset, offset + len), read a window at a time; NULL if they are gone
+static const uint8_t *segment_bytes(uint32_t id, uint32_t offset, uint32_t len)
+{
+    if (id != s_buf_id || offset < s_buf_off || offset + len > s_buf_off + s_buf_len) {
+        s_buf_id = id;
+        s_buf_off = offset;
+        s_buf_len = (uint32_t)enc_log_segment_read(id, offset, s_buf, sizeof(s_buf));
+        if (s_buf_len < len) {
+            s_buf_id = 0;
+            return NULL;
+        }
+    }
+    return s_buf + (offset - s_buf_off);
+}
+
+// Broadcast hellos until a gateway answers with the first segment it lacks
+static bool discover(uint32_t newest, uint8_t *gateway, uint32_t *next)
+{
+    repl_frame_t f;
+    const int64_t end_us = esp_timer_get_time() + (int64_t)LOG_REPL_DISCOVER_MS * 1000;
+
+    while (esp_timer_get_time() < end_us) {
+        repl_send(s_broadcast, REPL_FRAME_HELLO, 0, 0, newest, NULL, 0);
+        if (repl_wait(NULL, REPL_FRAME_RESUME, 0, LOG_REPL_HELLO_MS, &f)) {
+            memcpy(gateway, f.mac, ESP_NOW_ETH_ALEN);
+            *next = f.value;
+            return add_peer(gateway);
+        }
+    }
+    return false;
+}
+
+// Go-back-N over one segment: bursts up to the window past the last ack, resends from
+// the acked offset on a gap or a timeout, then END with the CRC of the whole segment
+static repl_status_t send_segment(const uint8_t *gateway, const log_store_segment_t *seg)
+{
+    uint32_t acked = 0;
+    uint32_t sent = 0;
+    uint32_t crc = 0;
+    uint32_t crc_len = 0;
+    uint32_t rewound = UINT32_MAX;  // offset of the last go-back on a gap ack
+    unsigned timeouts = 0;
+    unsigned restarts = 0;
+    repl_frame_t f;
+
+    for (;;) {
+        while (sent < seg->bytes && sent < acked + REPL_WINDOW_BYTES) {
+            uint32_t n = seg->bytes - sent;
+            if (n > REPL_DATA_BYTES) {
+                n = REPL_DATA_BYTES;
+            }
+            const uint8_t *p = segment_bytes(seg->id, sent, n);
+            if (p == NULL) {
+                return REPL_GONE;
+            }
+            // Every byte goes out in order once before any resend
+            if (sent == crc_len) {
+                crc = esp_rom_crc32_le(crc, p, n);
+                crc_len += n;
+            } else {
+                s_resent++;
+            }
+            const bool last = sent + n >= seg->bytes || sent + n >= acked + REPL_WINDOW_BYTES;
+            if (!repl_send(gateway, REPL_FRAME_DATA, last ? REPL_FLAG_ACK : 0, seg->id, sent, p, n)) {
+                return REPL_FAILED;
+            }
+            sent += n;
+        }
+        if (acked == seg->bytes && !repl_send(gateway, REPL_FRAME_END, 0, seg->id, crc, NULL, 0)) {
+            return REPL_FAILED;
+        }
+
+        if (!repl_wait(gateway, REPL_FRAME_ACK, seg->id, LOG_REPL_ACK_MS, &f)) {
+            if (++timeouts > LOG_REPL_RETRIES) {
+                return REPL_FAILED;
+            }
+            sent = acked;
+            continue;
+        }
+        timeouts = 0;
+        if (f.flags & REPL_FLAG_DONE) {
+            return REPL_SENT;
+        }
+        if (f.flags & REPL_FLAG_BAD) {
+            ESP_LOGW(TAG, "segment %lu refused by the gateway, sending it again",
+                     (unsigned long)seg->id);
+            if (++restarts > LOG_REPL_RETRIES) {
+                return REPL_FAILED;
+            }
+            acked = 0;
+            sent = 0;
+            crc = 0;
+            crc_len = 0;
+            rewound = UINT32_MAX;
+            continue;
+        }
+        // A gap ack is the gateway's position: go back there once, the frames still in
+        // flight from before draw more of the same
+        if ((f.flags & REPL_FLAG_GAP) && f.value != rewound && f.value <= sent) {
+            acked = f.value;
+            sent = f.value;
+            rewound = f.value;
+        } else if (!(f.flags & REPL_FLAG_GAP) && f.value > acked && f.value <= sent) {
+            acked = f.value;
+            rewound = UINT32_MAX;
+        }
+    }
+}
+
+// --------------------
+// Gateway
+// --------------------
+static void device_dir(const uint8_t *mac, char *path, size_t size)
+{
+    snprintf(path, size, LOG_REPL_DIR "/%02x%02x%02x%02x%02x%02x", mac[0], mac[1], mac[2], mac[3],
+             mac[4], mac[5]);
+}
+
+static void segment_path(const uint8_t *mac, uint32_t id, bool part, char *path, size_t size)
+{
+    char dir[REPL_PATH_BYTES];
+    device_dir(mac, dir, sizeof(dir));
+    snprintf(path, size, "%s/%08lx.%s", dir, (unsigned long)id, part ? "prt" : "bin");
+}
+
+// First segment id of the device the gateway lacks: past the newest stored, 0 = none stored
+static uint32_t gateway_next(const uint8_t *mac)
+{
+    char dir[REPL_PATH_BYTES];
+    uint32_t newest = 0;
+
+    device_dir(mac, dir, sizeof(dir));
+    DIR *d = opendir(dir);
+    if (d == NULL) {
+        return 0;
+    }
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        unsigned long id;
+        char ext[4];
+        if (sscanf(e->d_name, "%8lx.%3s", &id, ext) == 2 && strcasecmp(ext, "bin") == 0 &&
+            id > newest) {
+            newest = (uint32_t)id;
+        }
+    }
+    closedir(d);
+    return (newest > 0) ? newest + 1 : 0;
+}
+
+static void gateway_ack(uint8_t flags, uint32_t id, uint32_t value)
+{
+    repl_send(s_gw.mac, REPL_FRAME_ACK, flags, id, value, NULL, 0);
+    s_gw.since_ack = 0;
+}
+
+// Drop the segment being received (a later DATA at offset 0 starts it over)
+static void gateway_drop(void)
+{
+    char path[REPL_PATH_BYTES];
+
+    if (s_gw.file != NULL) {
+        fclose(s_gw.file);
+        s_gw.file = NULL;
+        segment_path(s_gw.mac, s_gw.id, true, path, sizeof(path));
+        remove(path);
+    }
+    s_gw.id = 0;
+}
+
+static void gateway_end_session(void)
+{
+    if (!s_gw.active) {
+        return;
+    }
+    gateway_drop();
+    esp_now_del_peer(s_gw.mac);
+    ESP_LOGI(TAG, "%02x:%02x:%02x:%02x:%02x:%02x: %lu segments, %lu bytes", s_gw.mac[0], s_gw.mac[1],
+             s_gw.mac[2], s_gw.mac[3], s_gw.mac[4], s_gw.mac[5], (unsigned long)s_gw.segments,
+             (unsigned long)s_gw.bytes);
+    s_gw.active = false;
+}
+
+// One device at a time: a hello from another waits until the session goes idle
+static void gateway_hello(const repl_frame_t *f)
+{
+    char dir[REPL_PATH_BYTES];
+
+    if (s_gw.active && memcmp(s_gw.mac, f->mac, ESP_NOW_ETH_ALEN) != 0) {
+        return;
+    }
+    gateway_end_session();
+    memset(&s_gw, 0, sizeof(s_gw));
+    memcpy(s_gw.mac, f->mac, ESP_NOW_ETH_ALEN);
+    s_gw.gap_id = UINT32_MAX;
+    device_dir(f->mac, dir, sizeof(dir));
+    mkdir(dir, 0775);
+    if (!add_peer(f->mac)) {
+        return;
+    }
+    s_gw.active = true;
+    s_gw.last_us = esp_timer_get_time();
+    const uint32_t next = gateway_next(f->mac);
+    ESP_LOGI(TAG, "%s: newest sealed segment %lu, sending from %lu", dir, (unsigned long)f->value,
+             (unsigned long)next);
+    repl_send(s_gw.mac, REPL_FRAME_RESUME, 0, 0, next, NULL, 0);
+}
+
+static void gateway_data(const repl_frame_t *f)
+{
+    char path[REPL_PATH_BYTES];
+
+    if (f->value == 0) {
+        gateway_drop();
+        segment_path(s_gw.mac, f->id, true, path, sizeof(path));
+        s_gw.file = fopen(path, "wb");
+        if (s_gw.file == NULL) {
+            gateway_ack(REPL_FLAG_BAD, f->id, 0);
+            return;
+        }
+        s_gw.id = f->id;
+        s_gw.held = 0;
+        s_gw.crc = 0;
+        s_gw.gap_id = UINT32_MAX;
+    }
+    if (s_gw.file == NULL || f->id != s_gw.id || f->value != s_gw.held) {
+        // Not the next in order: dropped, one gap ack per position
+        const uint32_t held = (s_gw.file != NULL && f->id == s_gw.id) ? s_gw.held : 0;
+        if (s_gw.gap_id != f->id || s_gw.gap_at != held) {
+            s_gw.gap_id = f->id;
+            s_gw.gap_at = held;
+            gateway_ack(REPL_FLAG_GAP, f->id, held);
+        }
+        return;
+    }
+    if (fwrite(f->data, 1, f->len, s_gw.file) != f->len) {
+        ESP_LOGE(TAG, "write of segment %lu failed", (unsigned long)f->id);
+        gateway_drop();
+        gateway_ack(REPL_FLAG_BAD, f->id, 0);
+        return;
+    }
+    s_gw.crc = esp_rom_crc32_le(s_gw.crc, f->data, f->len);
+    s_gw.held += f->len;
+    s_gw.gap_id = UINT32_MAX;
+    if ((f->flags & REPL_FLAG_ACK) || ++s_gw.since_ack >= LOG_REPL_WINDOW / 2) {
+        gateway_ack(0, f->id, s_gw.held);
+    }
+}
+
+// Complete segment: durable, then renamed, so a stored .bin is always whole
+static void gateway_end(const repl_frame_t *f)
+{
+    char part[REPL_PATH_BYTES];
+    char path[REPL_PATH_BYTES];
+
+    if (s_gw.file == NULL && f->id == s_gw.done_id) {
+        gateway_ack(REPL_FLAG_DONE, f->id, 0);     // the first DONE got lost
+        return;
+    }
+    if (s_gw.file == NULL || f->id != s_gw.id) {
+        gateway_ack(REPL_FLAG_GAP, f->id, (f->id == s_gw.id) ? s_gw.held : 0);
+        return;
+    }
+    if (f->value != s_gw.crc) {
+        ESP_LOGW(TAG, "segment %lu: CRC mismatch", (unsigned long)f->id);
+        gateway_drop();
+        gateway_ack(REPL_FLAG_BAD, f->id, 0);
+        return;
+    }
+    const bool synced = fflush(s_gw.file) == 0 && fsync(fileno(s_gw.file)) == 0;
+    fclose(s_gw.file);
+    s_gw.file = NULL;
+    segment_path(s_gw.mac, f->id, true, part, sizeof(part));
+    segment_path(s_gw.mac, f->id, false, path, sizeof(path));
+    remove(path);
+    if (!synced || rename(part, path) != 0) {
+        ESP_LOGE(TAG, "segment %lu not stored", (unsigned long)f->id);
+        remove(part);
+        s_gw.id = 0;
+        gateway_ack(REPL_FLAG_BAD, f->id, 0);
+        return;
+    }
+    s_gw.done_id = f->id;
+    s_gw.id = 0;
+    s_gw.segments++;
+    s_gw.bytes += s_gw.held;
+    gateway_ack(REPL_FLAG_DONE, f->id, s_gw.held);
+}
+
+// --------------------
+// Public API
+// --------------------
+void log_repl_run(const char *args)
+{
+    log_store_segment_t seg;
+    uint8_t gateway[ESP_NOW_ETH_ALEN];
+    uint32_t newest = 0;
+    uint32_t next = 0;
+    uint32_t segments = 0;
+    uint32_t bytes = 0;
+    repl_status_t status = REPL_SENT;
+
+    if (!radio_start()) {
+        return;
+    }
+    // Retention waits while the segments are sent; the compactor does not swap them
+    enc_log_snapshot_t snap;
+    enc_log_snapshot_open(&snap);
+    for (uint32_t id = 0; enc_log_segment_next(id, &seg); id = seg.id + 1) {
+        newest = seg.id;
+    }
+    if (!discover(newest, gateway, &next)) {
+        enc_log_snapshot_close(&snap);
+        radio_stop();
+        ESP_LOGW(TAG, "no gateway answered on channel %u", (unsigned)LOG_REPL_CHANNEL);
+        return;
+    }
+    if (strcmp(args, "0") == 0) {
+        next = 0;
+    } else if (next > 0 && enc_log_segment_next(next, &seg) && seg.id > next) {
+        ESP_LOGW(TAG, "segments %lu..%lu were dropped before they were replicated",
+                 (unsigned long)next, (unsigned long)(seg.id - 1));
+    }
+    s_resent = 0;
+    s_buf_id = 0;
+
+    for (uint32_t id = next; status != REPL_FAILED && enc_log_segment_next(id, &seg); id = seg.id + 1) {
+        if (seg.bytes == 0) {
+            continue;
+        }
+        status = send_segment(gateway, &seg);
+        if (status == REPL_SENT) {
+            segments++;
+            bytes += seg.bytes;
+        } else if (status == REPL_GONE) {
+            ESP_LOGW(TAG, "segment %lu dropped while it was sent", (unsigned long)seg.id);
+        }
+    }
+    enc_log_snapshot_close(&snap);
+    radio_stop();
+
+    ESP_LOGI(TAG, "replicated %lu segments (%lu bytes), %lu frames resent, %lu send failures, "
+             "%lu frames dropped", (unsigned long)segments, (unsigned long)bytes,
+             (unsigned long)s_resent, (unsigned long)s_tx_failed, (unsigned long)s_rx_dropped);
+    if (status == REPL_FAILED) {
+        ESP_LOGE(TAG, "replication stopped, run '8' again to resume");
+    } else {
+        ESP_LOGI(TAG, "gateway is up to date (newest sealed segment %lu; the open one goes once "
+                 "sealed)", (unsigned long)newest);
+    }
+}
+
+void log_repl_gateway(uint32_t seconds)
+{
+    repl_frame_t f;
+
+    if (!radio_start()) {
+        return;
+    }
+    mkdir(LOG_REPL_DIR, 0775);
+    memset(&s_gw, 0, sizeof(s_gw));
+    ESP_LOGI(TAG, "gateway on channel %u for %lu s (0: until reset), segments under %s",
+             (unsigned)LOG_REPL_CHANNEL, (unsigned long)seconds, LOG_REPL_DIR);
+
+    const int64_t end_us = esp_timer_get_time() + (int64_t)seconds * 1000000;
+    while (seconds == 0 || esp_timer_get_time() < end_us) {
+        if (xQueueReceive(s_rx, &f, pdMS_TO_TICKS(LOG_REPL_IDLE_MS / 4)) != pdTRUE) {
+            if (s_gw.active && esp_timer_get_time() - s_gw.last_us > (int64_t)LOG_REPL_IDLE_MS * 1000) {
+                gateway_end_session();
+            }
+            continue;
+        }
+        if (f.type == REPL_FRAME_HELLO) {
+            gateway_hello(&f);
+            continue;
+        }
+        if (!s_gw.active || memcmp(f.mac, s_gw.mac, ESP_NOW_ETH_ALEN) != 0) {
+            continue;
+        }
+        s_gw.last_us = esp_timer_get_time();
+        if (f.type == REPL_FRAME_DATA) {
+            gateway_data(&f);
+        } else if (f.type == REPL_FRAME_END) {
+            gateway_end(&f);
+        }
+    }
+    gateway_end_session();
+    radio_stop();
+}
+
+#endif // LOG_REPL
@@ -0,0 +1,71 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Replicate the encrypted log to a peer ESP32 over ESP-NOW.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_repl.h
+ * @brief   Windowed ESP-NOW transfer of sealed segments, resumed by segment id
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Protocol (all integers LE, one frame per ESP-NOW packet):
+ *          Frame: 'E' 'R' | type (1B) | flags (1B) | segment id (4B) | value (4B) |
+ *                 payload (data frames only)
+ *          1. The device broadcasts HELLO (value: newest sealed segment id, 0 = none)
+ *             on LOG_REPL_CHANNEL until a gateway answers RESUME (value: first
+ *             segment id it lacks from this device, 0 = none held). From then on
+ *             both ends talk unicast, so the MAC layer acks and retries each frame.
+ *          2. Per sealed segment from there on, the device sends DATA frames (value:
+ *             offset in the segment) up to LOG_REPL_WINDOW frames past the last
+ *             ACK (value: bytes the gateway holds in order). The last frame of a
+ *             burst asks for an ack (REPL_FLAG_ACK); the gateway also acks every
+ *             half window, and at once with REPL_FLAG_GAP when a frame is not the
+ *             next in order (it drops it). The device resends from the acked offset
+ *             on a gap, or when no ack came within LOG_REPL_ACK_MS.
+ *          3. With every byte acked, the device sends END (value: CRC32 of the
+ *             segment, zlib/IEEE). The gateway checks it, makes the segment
+ *             durable and acks with REPL_FLAG_DONE, or with REPL_FLAG_BAD and the
+ *             segment starts over. DATA at offset 0 always starts a segment over.
+ *          The bytes are those of the log store: records, block groups and epoch
+ *          headers stay encrypted, nothing is decrypted on either end.
+ *******************************************************************************/
+#ifndef LOG_REPL_H
+#define LOG_REPL_H
+
+#include <stdint.h>
+
+#define REPL_MAGIC0         'E'
+#define REPL_MAGIC1         'R'
+#define REPL_FRAME_HELLO    0x01
+#define REPL_FRAME_RESUME   0x02
+#define REPL_FRAME_DATA     0x03
+#define REPL_FRAME_ACK      0x04
+#define REPL_FRAME_END      0x05
+
+#define REPL_FLAG_ACK       0x01    // DATA: answer with an ACK
+#define REPL_FLAG_GAP       0x02    // ACK: a frame out of order was dropped
+#define REPL_FLAG_DONE      0x04    // ACK: segment stored
+#define REPL_FLAG_BAD       0x08    // ACK: CRC mismatch or write error, start over
+
+#define REPL_HDR_BYTES      12
+
+// Device: ship the sealed segments the gateway lacks (console '8'); args "0" sends
+// every sealed segment again. Blocks until done or no gateway answers.
+void log_repl_run(const char *args);
+
+// Gateway: receive segments from devices for seconds (0: until reset) (console '8 g').
+void log_repl_gateway(uint32_t seconds);
+
+#endif // LOG_REPL_H
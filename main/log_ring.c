@@ -0,0 +1,220 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Lock-free multi-producer/single-consumer ring of plaintext records.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_ring.c
+ * @brief   MPSC record ring buffer
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <string.h>
+
+#include "log_ring.h"
+
+#if LOG_RING_POLICY == LOG_RING_DROP_OLDEST
+#include "freertos/FreeRTOS.h"
+
+// Held while a record is copied out or discarded, so a producer never discards the
+// slot the writer is copying
+static portMUX_TYPE s_ring_mux = portMUX_INITIALIZER_UNLOCKED;
+#define RING_LOCK()     portENTER_CRITICAL(&s_ring_mux)
+#define RING_UNLOCK()   portEXIT_CRITICAL(&s_ring_mux)
+#else
+#define RING_LOCK()
+#define RING_UNLOCK()
+#endif
+
+#define RING_MASK (LOG_RING_SLOTS - 1u)
+
+void log_ring_init(log_ring_t *ring)
+{
+    memset(ring, 0, sizeof(*ring));
+    for (uint32_t i = 0; i < LOG_RING_SLOTS; i++) {
+        ring->slots[i].turn = i;
+    }
+}
+
+#if LOG_RING_POLICY == LOG_RING_DROP_OLDEST
+// Discard the oldest record to make room. Not a priority record, and not a slot that
+// is claimed but still being filled: the new record is dropped instead. Nor when the
+// slot at head is one the consumer still reads in place (log_ring_peek()): the queue
+// itself is not full then
+static bool ring_evict(log_ring_t *ring, uint32_t head)
+{
+    bool evicted = false;
+
+    RING_LOCK();
+    const uint32_t tail = ring->tail;
+    log_ring_slot_t *slot = &ring->slots[tail & RING_MASK];
+    if (head - tail >= LOG_RING_SLOTS &&
+        __atomic_load_n(&slot->turn, __ATOMIC_ACQUIRE) == tail + 1 &&
+        !(slot->flags & LOG_RING_FLAG_PRIORITY)) {
+        __atomic_store_n(&slot->turn, tail + LOG_RING_SLOTS, __ATOMIC_RELEASE);
+        __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+        evicted = true;
+    }
+    RING_UNLOCK();
+    if (evicted) {
+        __atomic_fetch_add(&ring->evicted, 1, __ATOMIC_RELAXED);
+    }
+    return evicted;
+}
+#endif
+
+uint8_t *log_ring_reserve(log_ring_t *ring, size_t len, uint32_t uptime_ms, uint8_t flags,
+                          uint32_t *pos)
+{
+    if (len > PLAINTEXT_MAX) {
+        __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+#if LOG_RING_POLICY == LOG_RING_DOWNSAMPLE
+    // Above the depth, keep 1 in LOG_RING_DOWNSAMPLE_KEEP normal records
+    if (!(flags & LOG_RING_FLAG_PRIORITY) && log_ring_count(ring) >= LOG_RING_DOWNSAMPLE_DEPTH &&
+        __atomic_fetch_add(&ring->sampled, 1, __ATOMIC_RELAXED) % LOG_RING_DOWNSAMPLE_KEEP != 0) {
+        __atomic_fetch_add(&ring->downsampled, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+#endif
+
+    // Claim a position: its slot is free once the consumer has moved it to this turn
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    log_ring_slot_t *slot;
+    while (true) {
+        slot = &ring->slots[head & RING_MASK];
+        const int32_t diff = (int32_t)(__atomic_load_n(&slot->turn, __ATOMIC_ACQUIRE) - head);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ring->head, &head, head + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Still holds the record from one lap ago
+#if LOG_RING_POLICY == LOG_RING_DROP_OLDEST
+            if (ring_evict(ring, head)) {
+                head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+                continue;
+            }
+#endif
+#if LOG_RING_POLICY != LOG_RING_BLOCK
+            __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+#endif
+            return NULL;
+        } else {
+            head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->uptime_ms = uptime_ms;
+    slot->flags = flags;
+    *pos = head;
+    return slot->data;
+}
+
+void log_ring_commit(log_ring_t *ring, uint32_t pos, size_t len, uint32_t seq)
+{
+    log_ring_slot_t *slot = &ring->slots[pos & RING_MASK];
+    slot->seq = seq;
+    slot->len = (uint8_t)len;
+
+    // Publish the slot contents before its turn
+    __atomic_store_n(&slot->turn, pos + 1, __ATOMIC_RELEASE);
+
+    const uint32_t used = pos + 1 - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    uint32_t high = __atomic_load_n(&ring->high_water, __ATOMIC_RELAXED);
+    while (used > high &&
+           !__atomic_compare_exchange_n(&ring->high_water, &high, used, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void log_ring_cancel(log_ring_t *ring, uint32_t pos)
+{
+    log_ring_slot_t *slot = &ring->slots[pos & RING_MASK];
+    slot->flags |= LOG_RING_FLAG_CANCELLED;
+    log_ring_commit(ring, pos, 0, 0);
+}
+
+bool log_ring_push(log_ring_t *ring, const uint8_t *data, size_t len,
+                   uint32_t seq, uint32_t uptime_ms, uint8_t flags, uint32_t *ticket)
+{
+    uint32_t pos;
+    uint8_t *buf = log_ring_reserve(ring, len, uptime_ms, flags, &pos);
+    if (buf == NULL) {
+        return false;
+    }
+    memcpy(buf, data, len);
+    log_ring_commit(ring, pos, len, seq);
+    if (ticket != NULL) {
+        *ticket = pos + 1;
+    }
+    return true;
+}
+
+bool log_ring_take(log_ring_t *ring, log_ring_slot_t *out)
+{
+    RING_LOCK();
+    const uint32_t tail = ring->tail;
+    log_ring_slot_t *slot = &ring->slots[tail & RING_MASK];
+    // Empty, or claimed by a producer that is still copying
+    if (__atomic_load_n(&slot->turn, __ATOMIC_ACQUIRE) != tail + 1) {
+        RING_UNLOCK();
+        return false;
+    }
+    out->seq = slot->seq;
+    out->uptime_ms = slot->uptime_ms;
+    out->len = slot->len;
+    out->flags = slot->flags;
+    memcpy(out->data, slot->data, slot->len);
+
+    // Release so a producer only reuses the slot after the copy
+    __atomic_store_n(&slot->turn, tail + LOG_RING_SLOTS, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+    RING_UNLOCK();
+    return true;
+}
+
+const log_ring_slot_t *log_ring_peek(log_ring_t *ring)
+{
+    RING_LOCK();
+    const uint32_t tail = ring->tail;
+    log_ring_slot_t *slot = &ring->slots[tail & RING_MASK];
+    if (__atomic_load_n(&slot->turn, __ATOMIC_ACQUIRE) != tail + 1) {
+        RING_UNLOCK();
+        return NULL;
+    }
+    // Past tail, so an evicting producer no longer looks at it; its turn still
+    // keeps the next lap out
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+    RING_UNLOCK();
+    return slot;
+}
+
+void log_ring_release(log_ring_t *ring, const log_ring_slot_t *slot)
+{
+    log_ring_slot_t *s = &ring->slots[slot - ring->slots];
+    __atomic_store_n(&s->turn, s->turn - 1 + LOG_RING_SLOTS, __ATOMIC_RELEASE);
+}
+
+uint32_t log_ring_count(const log_ring_t *ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) -
+           __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,104 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Lock-free multi-producer/single-consumer ring of plaintext records.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_ring.h
+ * @brief   MPSC record ring buffer
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Any number of tasks may call log_ring_push() or log_ring_reserve();
+ *          exactly one context may call log_ring_take() or log_ring_peek(). No
+ *          locks are taken: a producer claims a slot by a compare-and-swap on
+ *          head and publishes it through the slot's turn counter, so the
+ *          consumer stops at a slot that is claimed but not yet filled. With
+ *          LOG_RING_DROP_OLDEST a producer may also move tail to discard the
+ *          oldest record; taking and discarding then hold a short critical
+ *          section.
+ *******************************************************************************/
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+#if (LOG_RING_SLOTS & (LOG_RING_SLOTS - 1)) != 0
+#error "LOG_RING_SLOTS must be a power of two"
+#endif
+
+#define LOG_RING_FLAG_PRIORITY  0x01    // write and sync without waiting for a batch
+#define LOG_RING_FLAG_CANCELLED 0x02    // reservation given up: the consumer skips it
+#define LOG_RING_FLAG_CHANNEL(ch)   ((uint8_t)((ch) << 2))  // log channel, bits 2..5
+#define LOG_RING_CHANNEL(flags)     (((flags) >> 2) & 0x0F)
+
+typedef struct {
+    volatile uint32_t turn;     // position + 1 once filled, position + LOG_RING_SLOTS once free
+    uint32_t seq;               // producer sequence number (sparse index)
+    uint32_t uptime_ms;         // submit time (sparse index)
+    uint8_t len;
+    uint8_t flags;              // LOG_RING_FLAG_*, LOG_RING_FLAG_CHANNEL()
+    uint8_t data[PLAINTEXT_MAX];
+} log_ring_slot_t;
+
+typedef struct {
+    log_ring_slot_t slots[LOG_RING_SLOTS];
+    volatile uint32_t head;     // next position to claim (producers, compare-and-swap)
+    volatile uint32_t tail;     // written by consumer (and evicting producers, under the lock)
+    volatile uint32_t high_water;   // max observed fill level (producer side)
+    volatile uint32_t dropped;  // pushes rejected because the ring was full
+    volatile uint32_t evicted;  // old records discarded for new ones (LOG_RING_DROP_OLDEST)
+    volatile uint32_t downsampled;  // normal records thinned out (LOG_RING_DOWNSAMPLE)
+    volatile uint32_t sampled;  // normal records offered above the downsample depth
+} log_ring_t;
+
+void log_ring_init(log_ring_t *ring);
+
+// Producer: copy one record into the ring, applying LOG_RING_POLICY. Returns false
+// when the record is rejected: too large for a slot (counted as a drop), thinned out
+// (downsampled) or the ring is full (a drop, except with LOG_RING_BLOCK where the
+// caller retries). *ticket (if not NULL) is the record's position + 1: the consumer
+// has taken it once tail reaches it.
+bool log_ring_push(log_ring_t *ring, const uint8_t *data, size_t len,
+                   uint32_t seq, uint32_t uptime_ms, uint8_t flags, uint32_t *ticket);
+
+// Producer, zero-copy: claim a slot for up to len bytes like log_ring_push() and return
+// its data buffer, NULL when rejected. *pos is the claimed position (ticket - 1). The
+// slot must be ended with log_ring_commit() or log_ring_cancel() without blocking in
+// between: the consumer stops at it, and records claimed after it wait too.
+uint8_t *log_ring_reserve(log_ring_t *ring, size_t len, uint32_t uptime_ms, uint8_t flags,
+                          uint32_t *pos);
+
+// Publish a reserved slot holding len bytes (at most the reserved length).
+void log_ring_commit(log_ring_t *ring, uint32_t pos, size_t len, uint32_t seq);
+
+// Publish a reserved slot as LOG_RING_FLAG_CANCELLED: it still takes its turn, without data.
+void log_ring_cancel(log_ring_t *ring, uint32_t pos);
+
+// Consumer: copy out and remove the oldest record. False when empty.
+bool log_ring_take(log_ring_t *ring, log_ring_slot_t *out);
+
+// Consumer, zero-copy: remove the oldest record from the queue but keep its slot, so it
+// is read in place. NULL when empty. Producers do not reuse the slot, and it counts as
+// taken (tail has passed it), until log_ring_release().
+const log_ring_slot_t *log_ring_peek(log_ring_t *ring);
+void log_ring_release(log_ring_t *ring, const log_ring_slot_t *slot);
+
+uint32_t log_ring_count(const log_ring_t *ring);
+
+#endif // LOG_RING_H
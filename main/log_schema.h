@@ -0,0 +1,168 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Declare packed record layouts at compile time.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_schema.h
+ * @brief   Record schemas (X-macros): field list, packed size, block and group sizes
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    A schema is a list of X(type, name) fields in wire order. The packed
+ *          record is schema id (1B) || fields, little-endian, no padding between
+ *          them. LOG_SCHEMA_CODEC() expands one schema into a struct and a
+ *          pack/unpack pair with constant offsets, and checks its sizes against
+ *          the record and block group formats at compile time. No ESP-IDF
+ *          dependencies: also built into the Linux host exporter.
+ *******************************************************************************/
+#ifndef LOG_SCHEMA_H
+#define LOG_SCHEMA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+// --------------------
+// Schemas
+// --------------------
+// Packed schema ids have the top bit set: JSON starts with '{', CBOR with a
+// RECORD_SCHEMA_* id below 0x80
+#define LOG_SCHEMA_ID_PACKED        0x80
+
+// Sample record (main.c producer, LOG_RECORD_PACKED): 13 bytes, one AES block
+#define LOG_SCHEMA_SAMPLE_ID        (LOG_SCHEMA_ID_PACKED | RECORD_SCHEMA_SAMPLE)
+#define LOG_SCHEMA_SAMPLE_FIELDS(X) \
+    X(u32, seq)                     \
+    X(u64, uptime_ms)
+
+// Channel window aggregate (log_agg.c): 28 bytes, two AES blocks. uptime_ms is the
+// window start; min/max/mean carry int32 values in two's complement
+#define LOG_SCHEMA_AGG_ID           (LOG_SCHEMA_ID_PACKED | RECORD_SCHEMA_AGG)
+#define LOG_SCHEMA_AGG_FIELDS(X)    \
+    X(u32, seq)                     \
+    X(u64, uptime_ms)               \
+    X(u8, channel)                  \
+    X(u16, count)                   \
+    X(u32, min)                     \
+    X(u32, max)                     \
+    X(u32, mean)
+
+// Raw channel sample passed through around an event (log_agg.c): 18 bytes
+#define LOG_SCHEMA_RAW_ID           (LOG_SCHEMA_ID_PACKED | RECORD_SCHEMA_RAW)
+#define LOG_SCHEMA_RAW_FIELDS(X)    \
+    X(u32, seq)                     \
+    X(u64, uptime_ms)               \
+    X(u8, channel)                  \
+    X(u32, value)
+
+// --------------------
+// Field types
+// --------------------
+#define LOG_SCHEMA_CTYPE_u8     uint8_t
+#define LOG_SCHEMA_CTYPE_u16    uint16_t
+#define LOG_SCHEMA_CTYPE_u32    uint32_t
+#define LOG_SCHEMA_CTYPE_u64    uint64_t
+
+#define LOG_SCHEMA_SIZE_u8      1
+#define LOG_SCHEMA_SIZE_u16     2
+#define LOG_SCHEMA_SIZE_u32     4
+#define LOG_SCHEMA_SIZE_u64     8
+
+// --------------------
+// Sizes (constant expressions, usable in #if)
+// --------------------
+#define LOG_SCHEMA_FIELD_SIZE_(type, name) + LOG_SCHEMA_SIZE_##type
+
+// Packed bytes: schema id + fields
+#define LOG_SCHEMA_BYTES(S)         (1 LOG_SCHEMA_##S##_FIELDS(LOG_SCHEMA_FIELD_SIZE_))
+
+// Packed bytes rounded up to whole AES blocks
+#define LOG_SCHEMA_BLOCK_BYTES(S) \
+    (((LOG_SCHEMA_BYTES(S) + AES_BLOCK_BYTES - 1) / AES_BLOCK_BYTES) * AES_BLOCK_BYTES)
+
+// Encrypted plaintext of one record (PLAINTEXT_MAX unless LOG_RECORD_VARLEN)
+#define LOG_SCHEMA_PT_BYTES(S)      RECORD_PT_BYTES(LOG_SCHEMA_BYTES(S))
+
+// Stored bytes of one per-record entry: header, IV (GCM: nonce and tag), ciphertext
+#define LOG_SCHEMA_RECORD_BYTES(S)  (RECORD_HDR_BYTES + RECORD_IV_BYTES + LOG_SCHEMA_PT_BYTES(S))
+
+// Block group plaintext with LOG_BATCH_RECORDS records of the schema
+#if LOG_RECORD_VARLEN
+#define LOG_SCHEMA_GROUP_PT_BYTES(S) GROUP_PT_BYTES(LOG_BATCH_RECORDS * (1 + LOG_SCHEMA_BYTES(S)))
+#else
+#define LOG_SCHEMA_GROUP_PT_BYTES(S) (LOG_BATCH_RECORDS * PLAINTEXT_MAX)
+#endif
+
+// Records of the schema the block group buffer (BATCH_PT_MAX_BYTES) could hold
+#if LOG_RECORD_VARLEN
+#define LOG_SCHEMA_GROUP_CAPACITY(S) ((BATCH_PT_MAX_BYTES - RECORD_CRC_BYTES) / (1 + LOG_SCHEMA_BYTES(S)))
+#else
+#define LOG_SCHEMA_GROUP_CAPACITY(S) (BATCH_PT_MAX_BYTES / PLAINTEXT_MAX)
+#endif
+
+// --------------------
+// Codec generator
+// --------------------
+#define LOG_SCHEMA_MEMBER_(type, name)  LOG_SCHEMA_CTYPE_##type name;
+#define LOG_SCHEMA_PUT_(type, name) \
+    for (size_t i_ = 0; i_ < LOG_SCHEMA_SIZE_##type; i_++) {       \
+        *p_++ = (uint8_t)((uint64_t)rec->name >> (8 * i_));         \
+    }
+#define LOG_SCHEMA_GET_(type, name) \
+    rec->name = 0;                                                   \
+    for (size_t i_ = 0; i_ < LOG_SCHEMA_SIZE_##type; i_++) {       \
+        rec->name |= (LOG_SCHEMA_CTYPE_##type)((LOG_SCHEMA_CTYPE_##type)*p_++ << (8 * i_)); \
+    }
+
+// Struct name##_t and the functions (fixed size, unrolled by the compiler)
+//   size_t name##_pack(uint8_t *buf, size_t cap, const name##_t *rec)
+//       packed length, 0 if it does not fit in cap
+//   bool name##_unpack(const uint8_t *buf, size_t len, name##_t *rec)
+//       false unless buf starts with the schema id and holds all fields;
+//       trailing bytes (zero padding of fixed-size records) are ignored
+#define LOG_SCHEMA_CODEC(S, name)                                                        \
+    _Static_assert(LOG_SCHEMA_##S##_ID >= LOG_SCHEMA_ID_PACKED && LOG_SCHEMA_##S##_ID <= 0xFF, \
+                   #S ": packed schema ids are 0x80..0xFF");                            \
+    _Static_assert(LOG_SCHEMA_BLOCK_BYTES(S) % AES_BLOCK_BYTES == 0 &&                   \
+                       LOG_SCHEMA_BLOCK_BYTES(S) <= PLAINTEXT_MAX,                       \
+                   #S ": packed record exceeds PLAINTEXT_MAX");                          \
+    _Static_assert(LOG_SCHEMA_GROUP_PT_BYTES(S) <= BATCH_PT_MAX_BYTES,                   \
+                   #S ": block group of LOG_BATCH_RECORDS records exceeds BATCH_PT_MAX_BYTES"); \
+    typedef struct {                                                                     \
+        LOG_SCHEMA_##S##_FIELDS(LOG_SCHEMA_MEMBER_)                                      \
+    } name##_t;                                                                          \
+    static size_t name##_pack(uint8_t *buf, size_t cap, const name##_t *rec)             \
+    {                                                                                    \
+        if (cap < LOG_SCHEMA_BYTES(S)) {                                                 \
+            return 0;                                                                    \
+        }                                                                                \
+        uint8_t *p_ = buf;                                                               \
+        *p_++ = LOG_SCHEMA_##S##_ID;                                                     \
+        LOG_SCHEMA_##S##_FIELDS(LOG_SCHEMA_PUT_)                                         \
+        return LOG_SCHEMA_BYTES(S);                                                      \
+    }                                                                                    \
+    static bool name##_unpack(const uint8_t *buf, size_t len, name##_t *rec)             \
+    {                                                                                    \
+        if (len < LOG_SCHEMA_BYTES(S) || buf[0] != LOG_SCHEMA_##S##_ID) {                \
+            return false;                                                                \
+        }                                                                                \
+        const uint8_t *p_ = buf + 1;                                                     \
+        LOG_SCHEMA_##S##_FIELDS(LOG_SCHEMA_GET_)                                         \
+        return true;                                                                     \
+    }
+
+#endif // LOG_SCHEMA_H
@@ -0,0 +1,86 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Log store backend on FATFS files (SPI flash + WL, or SD card).
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_segment.h
+ * @brief   Sparse index, seek and retention over a run of segment files
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Implemented in log_store_fat.c for its own segments and used by the
+ *          side channels (log_channel.c). A run is segments [first, last], the
+ *          last one open in an appender; closed ones have their data bytes in
+ *          a ring of slots by id % slots. Without rotation first = last = 0.
+ *          Each segment has an index sidecar of INDEX_ENTRY_BYTES entries.
+ *******************************************************************************/
+#ifndef LOG_SEGMENT_H
+#define LOG_SEGMENT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "enc_log_config.h"
+#include "log_appender.h"
+#include "log_store.h"
+
+typedef struct {
+    uint32_t seq;
+    uint32_t uptime_ms;
+    uint32_t offset;            // file offset in the segment
+    uint32_t epoch_offset;      // file offset of the format header it is written in
+    uint64_t wall_base_ms;
+} log_segment_entry_t;
+
+// A run of segments, filled in by its owner before each call
+typedef struct {
+    uint8_t ch;                 // owner's channel (0: the store), passed to index_path
+    uint32_t first_id;          // oldest live segment
+    uint32_t last_id;           // segment open in app
+    const uint32_t *closed_bytes;   // data bytes of closed segments, by id % slots
+    uint32_t slots;
+    const log_appender_t *app;
+    FILE *idx;                  // index sidecar of the open segment, NULL if none
+    void (*index_path)(uint8_t ch, uint32_t id, char *out, size_t n);
+} log_segments_t;
+
+// Log offset (as for log_store_read) of the first data byte of segment id.
+uint32_t log_segment_base(const log_segments_t *segs, uint32_t id);
+
+// Data bytes of segment id that are in the file.
+uint32_t log_segment_bytes(const log_segments_t *segs, uint32_t id);
+
+// Index of segment id for reading; *count is the number of entries that point into
+// data already in the file (entries may lead the data after a power loss).
+FILE *log_segment_index_open(const log_segments_t *segs, uint32_t id, uint32_t *count);
+
+// Entry i of an index file; false if unreadable or not pointing at data.
+bool log_segment_index_read(FILE *f, uint32_t i, log_segment_entry_t *e);
+
+// Append an entry to an index file.
+bool log_segment_index_write(FILE *f, const log_segment_entry_t *e);
+
+// Sparse index lookup over the run, as log_store_seek().
+bool log_segment_seek(const log_segments_t *segs, log_store_seek_t by, uint32_t value,
+                      log_store_entry_t *out);
+
+// The oldest segment has to go: keep or more segments, or, unless pinned, its newest
+// indexed record is more than age_s (0: no limit) before now_ms (0: clock not set).
+bool log_segment_retire(const log_segments_t *segs, uint32_t keep, uint32_t age_s,
+                        uint64_t now_ms, bool pinned);
+
+#endif // LOG_SEGMENT_H
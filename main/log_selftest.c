@@ -0,0 +1,404 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Find boards that got slower in the field before they fall behind.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_selftest.c
+ * @brief   Boot self-test: OPTIGA AES, I2C round trips and storage against a baseline
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include "log_selftest.h"
+
+#if LOG_SELFTEST
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+#include "optiga/optiga_crypt.h"
+#include "optiga/optiga_util.h"
+#include "optiga/ifx_i2c/ifx_i2c.h"
+#include "optiga_sync.h"
+
+#include "enc_log.h"
+#include "log_nvs.h"
+#include "log_seq.h"
+
+#define SELFTEST_NAMESPACE  "enc_log"
+#define SELFTEST_KEY        "selftest"
+#define SELFTEST_VERSION    1
+// Security event counter: one byte, readable in every lifecycle state
+#define SELFTEST_I2C_OID    0xE0C5
+#define SELFTEST_PATH       LOG_MOUNT_POINT "/selftest.tmp"
+
+// NVS blob: the baseline, what it was measured with and a CRC32 over both
+typedef struct {
+    uint16_t version;
+    uint16_t aes_commands;
+    uint16_t i2c_reads;
+    uint8_t raw_store;
+    uint8_t reserved;
+    uint32_t store_bytes;
+    log_selftest_times_t times;
+    uint32_t crc;
+} selftest_blob_t;
+
+// --------------------
+// Globals
+// --------------------
+static const char *TAG = "LOG_SELFTEST";
+static optiga_crypt_t *s_crypt = NULL;
+static optiga_util_t *s_util = NULL;
+static optiga_sync_t s_sync;
+static uint8_t s_buf[LOG_SELFTEST_STORE_BYTES];
+static log_selftest_result_t s_result;
+static bool s_ran = false;
+
+// --------------------
+// Baseline
+// --------------------
+static void blob_fill(selftest_blob_t *blob, const log_selftest_times_t *times)
+{
+    memset(blob, 0, sizeof(*blob));
+    blob->version = SELFTEST_VERSION;
+    blob->aes_commands = LOG_SELFTEST_AES_COMMANDS;
+    blob->i2c_reads = LOG_SELFTEST_I2C_READS;
+    blob->raw_store = LOG_STORAGE_RAW;
+    blob->store_bytes = LOG_SELFTEST_STORE_BYTES;
+    // Field by field: padding in the caller's copy must not reach the CRC
+    blob->times.aes_us = times->aes_us;
+    blob->times.i2c_us = times->i2c_us;
+    blob->times.write_us = times->write_us;
+    blob->times.read_us = times->read_us;
+    blob->times.resends = times->resends;
+    blob->crc = esp_rom_crc32_le(0, (const uint8_t *)blob, offsetof(selftest_blob_t, crc));
+}
+
+// All zero when there is none, it fails its CRC or was taken with other test sizes
+static void baseline_load(log_selftest_times_t *times)
+{
+    selftest_blob_t blob;
+    selftest_blob_t expect;
+    size_t len = sizeof(blob);
+    nvs_handle_t handle;
+
+    memset(times, 0, sizeof(*times));
+    if (!log_nvs_open(SELFTEST_NAMESPACE, &handle)) {
+        return;
+    }
+    const esp_err_t err = nvs_get_blob(handle, SELFTEST_KEY, &blob, &len);
+    nvs_close(handle);
+    if (err != ESP_OK || len != sizeof(blob)) {
+        return;
+    }
+    blob_fill(&expect, &blob.times);
+    if (memcmp(&blob, &expect, sizeof(blob)) != 0) {
+        ESP_LOGW(TAG, "baseline of another firmware or test size, ignored");
+        return;
+    }
+    *times = blob.times;
+}
+
+static bool baseline_store(const log_selftest_times_t *times)
+{
+    selftest_blob_t blob;
+    nvs_handle_t handle;
+
+    if (!log_nvs_open(SELFTEST_NAMESPACE, &handle)) {
+        return false;
+    }
+    blob_fill(&blob, times);
+    const bool ok = nvs_set_blob(handle, SELFTEST_KEY, &blob, sizeof(blob)) == ESP_OK &&
+                    nvs_commit(handle) == ESP_OK;
+    nvs_close(handle);
+    return ok;
+}
+
+// --------------------
+// Steps
+// --------------------
+// Data link frames sent again or received corrupt. Physical layer NACKs are left out:
+// OPTIGA answers them while it wakes from its low power state.
+static uint32_t link_errors(void)
+{
+    ifx_i2c_stats_t link;
+    ifx_i2c_get_stats(&ifx_i2c_context_0, &link);
+    return link.dl_resends + link.dl_crc_errors;
+}
+
+static bool counter_read(void)
+{
+    uint8_t sec;
+    uint16_t len = sizeof(sec);
+    return OPTIGA_SYNC_CALL(&s_sync, LOG_OPTIGA_TIMEOUT_MS,
+                            optiga_util_read_data(s_util, SELFTEST_I2C_OID, 0, &sec, &len)) ==
+           OPTIGA_LIB_SUCCESS;
+}
+
+static bool time_i2c(uint32_t *us)
+{
+    const int64_t t0 = esp_timer_get_time();
+    for (unsigned i = 0; i < LOG_SELFTEST_I2C_READS; i++) {
+        if (!counter_read()) {
+            return false;
+        }
+    }
+    *us = (uint32_t)(esp_timer_get_time() - t0);
+    return true;
+}
+
+static bool time_aes(uint32_t *us)
+{
+    uint8_t block[AES_BLOCK_BYTES] = {0};
+    uint8_t iv[AES_IV_BYTES] = {0};
+    uint8_t out[AES_BLOCK_BYTES];
+
+    const int64_t t0 = esp_timer_get_time();
+    for (unsigned i = 0; i < LOG_SELFTEST_AES_COMMANDS; i++) {
+        uint32_t out_len = sizeof(out);
+        block[0] = (uint8_t)i;
+        if (OPTIGA_SYNC_CALL(&s_sync, LOG_OPTIGA_TIMEOUT_MS,
+                             optiga_crypt_symmetric_encrypt(s_crypt, OPTIGA_SYMMETRIC_CBC,
+                                                            OPTIGA_KEY_ID_SECRET_BASED, block,
+                                                            sizeof(block), iv, sizeof(iv), NULL,
+                                                            0, out, &out_len)) !=
+                OPTIGA_LIB_SUCCESS ||
+            out_len != sizeof(out)) {
+            return false;
+        }
+    }
+    *us = (uint32_t)(esp_timer_get_time() - t0);
+    return true;
+}
+
+#if LOG_STORAGE_RAW
+// No file system: the log's first bytes, read through a snapshot. Writing would cost an
+// erase of a log sector, so write_us stays 0.
+static bool time_store(uint32_t *write_us, uint32_t *read_us)
+{
+    enc_log_snapshot_t snap;
+
+    *write_us = 0;
+    *read_us = 0;
+    enc_log_snapshot_open(&snap);
+    if (snap.size >= sizeof(s_buf)) {
+        const int64_t t0 = esp_timer_get_time();
+        const size_t n = enc_log_snapshot_read(&snap, 0, s_buf, sizeof(s_buf));
+        *read_us = (uint32_t)(esp_timer_get_time() - t0);
+        if (n != sizeof(s_buf)) {
+            *read_us = 0;
+        }
+    }
+    enc_log_snapshot_close(&snap);
+    return true;
+}
+#else
+// A scratch file on the log's file system (card or flash): written, synced, read back
+static bool time_store(uint32_t *write_us, uint32_t *read_us)
+{
+    const uint8_t seed = (uint8_t)esp_timer_get_time();
+    for (size_t i = 0; i < sizeof(s_buf); i++) {
+        s_buf[i] = (uint8_t)(i * 7u + seed);
+    }
+
+    int64_t t0 = esp_timer_get_time();
+    FILE *f = fopen(SELFTEST_PATH, "wb");
+    bool ok = f != NULL && fwrite(s_buf, 1, sizeof(s_buf), f) == sizeof(s_buf) &&
+              fflush(f) == 0 && fsync(fileno(f)) == 0;
+    if (f != NULL) {
+        ok = (fclose(f) == 0) && ok;
+    }
+    *write_us = (uint32_t)(esp_timer_get_time() - t0);
+
+    if (ok) {
+        memset(s_buf, 0, sizeof(s_buf));
+        t0 = esp_timer_get_time();
+        f = fopen(SELFTEST_PATH, "rb");
+        ok = f != NULL && fread(s_buf, 1, sizeof(s_buf), f) == sizeof(s_buf);
+        if (f != NULL) {
+            fclose(f);
+        }
+        *read_us = (uint32_t)(esp_timer_get_time() - t0);
+        for (size_t i = 0; ok && i < sizeof(s_buf); i++) {
+            ok = s_buf[i] == (uint8_t)(i * 7u + seed);
+        }
+    }
+    remove(SELFTEST_PATH);
+    if (!ok) {
+        ESP_LOGW(TAG, "scratch file %s not written and read back", SELFTEST_PATH);
+    }
+    return ok;
+}
+#endif
+
+// --------------------
+// Verdict
+// --------------------
+// Throughput of a step in % of its baseline (100 if either was not measured)
+static uint32_t step_pct(uint32_t base_us, uint32_t now_us)
+{
+    if (base_us == 0 || now_us == 0) {
+        return 100;
+    }
+    return (uint32_t)(((uint64_t)base_us * 100u) / now_us);
+}
+
+static void judge(log_selftest_result_t *res)
+{
+    const uint32_t now[4] = {res->now.aes_us, res->now.i2c_us, res->now.write_us, res->now.read_us};
+    const uint32_t base[4] = {res->baseline.aes_us, res->baseline.i2c_us, res->baseline.write_us,
+                              res->baseline.read_us};
+    uint32_t worst = 100;
+
+    for (unsigned i = 0; i < 4; i++) {
+        const uint32_t pct = step_pct(base[i], now[i]);
+        if (pct < LOG_SELFTEST_ALARM_PCT) {
+            res->slow |= (uint8_t)(LOG_SELFTEST_SLOW_AES << i);
+        }
+        if (pct < worst) {
+            worst = pct;
+        }
+    }
+    res->worst_pct = (uint8_t)worst;
+    if (res->now.resends > LOG_SELFTEST_MAX_RESENDS) {
+        res->slow |= LOG_SELFTEST_LINK_RESENDS;
+    }
+}
+
+// Priority JSON record, readable in every record format: {"seq":..,"uptime_ms":..,
+// "selftest":flags,"pct":worst}
+static void raise_alarm(const log_selftest_result_t *res)
+{
+    char msg[PLAINTEXT_MAX];
+    const uint32_t seq = log_seq_next();
+    const int len = snprintf(msg, sizeof(msg), "{\"seq\":%lu,\"uptime_ms\":%llu,\"selftest\":%u,"
+                             "\"pct\":%u}", (unsigned long)seq,
+                             (unsigned long long)(esp_timer_get_time() / 1000),
+                             (unsigned)res->slow, (unsigned)res->worst_pct);
+    if (len <= 0 || (size_t)len >= sizeof(msg) || !enc_log_submit(msg, (size_t)len, seq, true)) {
+        ESP_LOGW(TAG, "alarm record not submitted");
+    }
+}
+
+// --------------------
+// Public API
+// --------------------
+uint8_t log_selftest_run(bool rebaseline)
+{
+    log_selftest_result_t res;
+
+    memset(&res, 0, sizeof(res));
+    if (s_crypt == NULL) {
+        // OPTIGA is brought up by the logger (LOG_LAZY_OPTIGA: on its writer task)
+        if (!enc_log_wait_ready(UINT32_MAX)) {
+            return LOG_SELFTEST_FAILED;
+        }
+        s_util = optiga_util_create(0, optiga_sync_callback, &s_sync);
+        s_crypt = optiga_crypt_create(0, optiga_sync_callback, &s_sync);
+        if (s_util == NULL || s_crypt == NULL) {
+            ESP_LOGE(TAG, "optiga instances not created");
+            if (s_util != NULL) {
+                (void)optiga_util_destroy(s_util);
+                s_util = NULL;
+            }
+            return LOG_SELFTEST_FAILED;
+        }
+    }
+
+    // One untimed read first: OPTIGA may be waking from its low power state
+    bool ok = counter_read();
+    const uint32_t errors = link_errors();
+    ok = ok && time_i2c(&res.now.i2c_us) && time_aes(&res.now.aes_us);
+    ok = time_store(&res.now.write_us, &res.now.read_us) && ok;
+    res.now.resends = link_errors() - errors;
+    if (!ok) {
+        res.slow |= LOG_SELFTEST_FAILED;
+    }
+
+    baseline_load(&res.baseline);
+    const bool have_baseline = res.baseline.aes_us != 0;
+    bool completed = false;
+    if (ok && (rebaseline || !have_baseline)) {
+        res.baselined = baseline_store(&res.now);
+        if (res.baselined) {
+            res.baseline = res.now;
+        }
+    } else if (ok && ((res.baseline.write_us == 0 && res.now.write_us != 0) ||
+                      (res.baseline.read_us == 0 && res.now.read_us != 0))) {
+        // A step the baseline run could not measure (raw store: the log was shorter than
+        // the test) takes its time from the first run that does
+        log_selftest_times_t filled = res.baseline;
+        if (filled.write_us == 0) {
+            filled.write_us = res.now.write_us;
+        }
+        if (filled.read_us == 0) {
+            filled.read_us = res.now.read_us;
+        }
+        completed = baseline_store(&filled);
+        if (completed) {
+            res.baseline = filled;
+        }
+    }
+    judge(&res);
+
+    ESP_LOGI(TAG, "aes %u x %lu us, i2c %u x %lu us, write %lu us, read %lu us (%u B), "
+             "link resends %lu", (unsigned)LOG_SELFTEST_AES_COMMANDS,
+             (unsigned long)(res.now.aes_us / LOG_SELFTEST_AES_COMMANDS),
+             (unsigned)LOG_SELFTEST_I2C_READS,
+             (unsigned long)(res.now.i2c_us / LOG_SELFTEST_I2C_READS),
+             (unsigned long)res.now.write_us, (unsigned long)res.now.read_us,
+             (unsigned)LOG_SELFTEST_STORE_BYTES, (unsigned long)res.now.resends);
+    if (res.baselined) {
+        ESP_LOGI(TAG, "stored as the baseline of this device");
+    } else if (completed) {
+        ESP_LOGI(TAG, "storage step added to the baseline of this device");
+    } else if (!have_baseline) {
+        ESP_LOGW(TAG, "no baseline yet: a complete run stores one");
+    } else if (res.slow != 0) {
+        ESP_LOGW(TAG, "degraded (0x%02X): slowest step at %u%% of the baseline "
+                 "(aes %lu us, i2c %lu us, write %lu us, read %lu us)", (unsigned)res.slow,
+                 (unsigned)res.worst_pct, (unsigned long)res.baseline.aes_us,
+                 (unsigned long)res.baseline.i2c_us, (unsigned long)res.baseline.write_us,
+                 (unsigned long)res.baseline.read_us);
+    }
+    if (res.slow != 0) {
+        raise_alarm(&res);
+    }
+
+    s_result = res;
+    s_ran = true;
+    return res.slow;
+}
+
+bool log_selftest_get(log_selftest_result_t *res)
+{
+    if (!s_ran) {
+        return false;
+    }
+    *res = s_result;
+    return true;
+}
+
+#endif // LOG_SELFTEST
@@ -0,0 +1,75 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Find boards that got slower in the field before they fall behind.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_selftest.h
+ * @brief   Boot self-test: OPTIGA AES, I2C round trips and storage against a baseline
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Times LOG_SELFTEST_AES_COMMANDS one-block AES-CBC encrypts under the log
+ *          key, LOG_SELFTEST_I2C_READS reads of the one-byte security event counter
+ *          and a write, sync and read back of LOG_SELFTEST_STORE_BYTES in a scratch
+ *          file next to the log (raw store: a read of the log's first bytes, no
+ *          write). The first complete run of a device is stored in NVS as its
+ *          baseline; a storage step it could not measure (raw store: log shorter
+ *          than the test) is filled in by the first run that does. A step below
+ *          LOG_SELFTEST_ALARM_PCT of the baseline's throughput, or more I2C link
+ *          resends than LOG_SELFTEST_MAX_RESENDS, sets its flag and appends a
+ *          priority alarm record to the log.
+ *******************************************************************************/
+#ifndef LOG_SELFTEST_H
+#define LOG_SELFTEST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+// Flags of a run (log_selftest_result_t.slow)
+#define LOG_SELFTEST_SLOW_AES       0x01
+#define LOG_SELFTEST_SLOW_I2C       0x02
+#define LOG_SELFTEST_SLOW_WRITE     0x04
+#define LOG_SELFTEST_SLOW_READ      0x08
+#define LOG_SELFTEST_LINK_RESENDS   0x10    // resends above LOG_SELFTEST_MAX_RESENDS
+#define LOG_SELFTEST_FAILED         0x20    // a step did not complete
+
+typedef struct {
+    uint32_t aes_us;            // all AES commands
+    uint32_t i2c_us;            // all counter reads
+    uint32_t write_us;          // scratch file written and synced, 0 = not measured
+    uint32_t read_us;           // read back, 0 = not measured
+    uint32_t resends;           // I2C data link resends and CRC errors during the run
+} log_selftest_times_t;
+
+typedef struct {
+    log_selftest_times_t now;
+    log_selftest_times_t baseline;  // all zero: none stored yet
+    uint8_t slow;               // LOG_SELFTEST_* flags
+    uint8_t worst_pct;          // lowest throughput of a step in % of its baseline
+    bool baselined;             // this run was stored as the baseline
+} log_selftest_result_t;
+
+#if LOG_SELFTEST
+// Run the self-test now (needs OPTIGA, waits for enc_log_wait_ready()). rebaseline
+// stores the run as the device's baseline if every step completed. Returns the flags.
+uint8_t log_selftest_run(bool rebaseline);
+
+// Result of the last run since boot; false if none ran
+bool log_selftest_get(log_selftest_result_t *res);
+#endif
+
+#endif // LOG_SELFTEST_H
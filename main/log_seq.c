@@ -0,0 +1,236 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Record sequence numbers that never repeat on this device.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_seq.c
+ * @brief   Record sequence counter, persisted as a ceiling reserved in NVS or OPTIGA
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <stdbool.h>
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "nvs.h"
+
+#include "log_nvs.h"
+#include "log_seq.h"
+
+#if LOG_SEQ_PERSIST == LOG_SEQ_PERSIST_OPTIGA
+#include "optiga/optiga_util.h"
+#include "optiga_sync.h"
+
+#include "enc_log.h"
+#endif
+
+#define SEQ_NAMESPACE   "enc_log"
+#define SEQ_KEY         "seq_ceiling"
+
+// --------------------
+// Globals
+// --------------------
+static const char *TAG = "LOG_SEQ";
+// Kept in RTC memory so the sequence continues across deep sleep cycles
+static RTC_DATA_ATTR uint32_t s_seq = 0;
+static RTC_DATA_ATTR uint32_t s_ceiling = 0;    // last value stored in NVS / OPTIGA
+#if LOG_SEQ_PERSIST
+static SemaphoreHandle_t s_ceiling_lock = NULL;
+static StaticSemaphore_t s_ceiling_lock_buf;
+#endif
+#if LOG_SEQ_PERSIST == LOG_SEQ_PERSIST_OPTIGA
+static RTC_DATA_ATTR bool s_anchored = false;   // s_ceiling is the OPTIGA counter value
+static optiga_util_t *s_util = NULL;
+static optiga_sync_t s_sync;
+#endif
+
+// --------------------
+// Helpers
+// --------------------
+#if LOG_SEQ_PERSIST == LOG_SEQ_PERSIST_OPTIGA
+// Counter value: the first 4 bytes (big-endian) of the counter object, the threshold follows
+static bool counter_read(uint32_t *value)
+{
+    uint8_t data[8];
+    uint16_t len = sizeof(data);
+    const optiga_lib_status_t ret =
+        OPTIGA_SYNC_CALL(&s_sync, LOG_OPTIGA_TIMEOUT_MS,
+                         optiga_util_read_data(s_util, LOG_SEQ_COUNTER_OID, 0, data, &len));
+    if (ret != OPTIGA_LIB_SUCCESS || len < 4) {
+        ESP_LOGW(TAG, "counter 0x%04X not read: 0x%04X", LOG_SEQ_COUNTER_OID, ret);
+        return false;
+    }
+    *value = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) |
+             (uint32_t)data[3];
+    return true;
+}
+
+// Under s_ceiling_lock: move the ceiling above s_seq on the OPTIGA counter. The first
+// call of a boot reads the counter and continues above it.
+static bool counter_reserve(void)
+{
+    if (s_util == NULL) {
+        // OPTIGA is brought up by the logger (LOG_LAZY_OPTIGA: on its writer task)
+        if (!enc_log_wait_ready(UINT32_MAX)) {
+            return false;
+        }
+        s_util = optiga_util_create(0, optiga_sync_callback, &s_sync);
+        if (s_util == NULL) {
+            ESP_LOGE(TAG, "optiga_util_create failed");
+            return false;
+        }
+    }
+    if (!s_anchored) {
+        uint32_t value;
+        if (!counter_read(&value)) {
+            return false;
+        }
+        // Numbers up to the counter may have been used before the reset
+        if (value > s_seq) {
+            __atomic_store_n(&s_seq, value, __ATOMIC_RELAXED);
+        }
+        s_ceiling = value;
+        s_anchored = true;
+        ESP_LOGI(TAG, "sequence continues after %lu (counter 0x%04X)",
+                 (unsigned long)s_seq, LOG_SEQ_COUNTER_OID);
+    }
+    // More than one step only after numbers were handed out without the counter
+    while (s_seq >= s_ceiling) {
+        const optiga_lib_status_t ret =
+            OPTIGA_SYNC_CALL(&s_sync, LOG_OPTIGA_TIMEOUT_MS,
+                             optiga_util_update_count(s_util, LOG_SEQ_COUNTER_OID, LOG_SEQ_BLOCK));
+        if (ret != OPTIGA_LIB_SUCCESS) {
+            // Threshold reached or no answer: the counter value is read again next time
+            ESP_LOGW(TAG, "counter 0x%04X not advanced: 0x%04X", LOG_SEQ_COUNTER_OID, ret);
+            s_anchored = false;
+            return false;
+        }
+        s_ceiling += LOG_SEQ_BLOCK;
+    }
+    return true;
+}
+#elif LOG_SEQ_PERSIST
+static bool ceiling_store(uint32_t ceiling)
+{
+    nvs_handle_t handle;
+    if (!log_nvs_open(SEQ_NAMESPACE, &handle)) {
+        return false;
+    }
+    const bool ok = nvs_set_u32(handle, SEQ_KEY, ceiling) == ESP_OK && nvs_commit(handle) == ESP_OK;
+    nvs_close(handle);
+    return ok;
+}
+#endif
+
+// --------------------
+// Public API
+// --------------------
+void log_seq_init(void)
+{
+#if LOG_SEQ_PERSIST
+    s_ceiling_lock = xSemaphoreCreateMutexStatic(&s_ceiling_lock_buf);
+    if (esp_reset_reason() == ESP_RST_DEEPSLEEP) {
+        return;
+    }
+#endif
+#if LOG_SEQ_PERSIST == LOG_SEQ_PERSIST_OPTIGA
+    // The counter is read by the first log_seq_next(), once OPTIGA is up
+    s_seq = 0;
+    s_ceiling = 0;
+    s_anchored = false;
+#elif LOG_SEQ_PERSIST
+    // Numbers up to the ceiling may have been used before the reset: continue above it
+    nvs_handle_t handle;
+    uint32_t ceiling = 0;
+    if (log_nvs_open(SEQ_NAMESPACE, &handle)) {
+        if (nvs_get_u32(handle, SEQ_KEY, &ceiling) != ESP_OK) {
+            ceiling = 0;
+        }
+        nvs_close(handle);
+    }
+    s_seq = ceiling;
+    s_ceiling = ceiling;
+    ESP_LOGI(TAG, "sequence continues after %lu", (unsigned long)ceiling);
+#endif
+}
+
+uint32_t log_seq_next(void)
+{
+#if LOG_SEQ_PERSIST == LOG_SEQ_PERSIST_OPTIGA
+    // Reading the counter can move s_seq up, so a number is only taken below a ceiling
+    uint32_t seq = __atomic_load_n(&s_seq, __ATOMIC_RELAXED);
+    for (;;) {
+        if (seq < __atomic_load_n(&s_ceiling, __ATOMIC_ACQUIRE)) {
+            if (__atomic_compare_exchange_n(&s_seq, &seq, seq + 1, true, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                return seq + 1;
+            }
+            continue;
+        }
+        // Producers at the ceiling wait for the one reserving the next block
+        xSemaphoreTake(s_ceiling_lock, portMAX_DELAY);
+        if (s_seq >= s_ceiling && !counter_reserve()) {
+            ESP_LOGW(TAG, "no counter reservation past %lu, numbers may repeat after a reset",
+                     (unsigned long)s_seq);
+            // As with NVS: numbering goes on, the next try is a block later
+            s_ceiling = s_seq + LOG_SEQ_BLOCK;
+        }
+        // Publish what counter_reserve() wrote under the lock
+        __atomic_store_n(&s_ceiling, s_ceiling, __ATOMIC_RELEASE);
+        seq = __atomic_load_n(&s_seq, __ATOMIC_RELAXED);
+        xSemaphoreGive(s_ceiling_lock);
+    }
+#else
+    const uint32_t seq = __atomic_add_fetch(&s_seq, 1, __ATOMIC_RELAXED);
+#if LOG_SEQ_PERSIST
+    if (seq > __atomic_load_n(&s_ceiling, __ATOMIC_ACQUIRE)) {
+        // Producers past the ceiling wait for the one writing the next
+        xSemaphoreTake(s_ceiling_lock, portMAX_DELAY);
+        if (seq > s_ceiling) {
+            const uint32_t ceiling = seq + LOG_SEQ_BLOCK - 1;
+            if (!ceiling_store(ceiling)) {
+                ESP_LOGW(TAG, "ceiling %lu not stored, numbers may repeat after a reset",
+                         (unsigned long)ceiling);
+            }
+            // Also on failure: the next try is a block later, not on every record
+            __atomic_store_n(&s_ceiling, ceiling, __ATOMIC_RELEASE);
+        }
+        xSemaphoreGive(s_ceiling_lock);
+    }
+#endif
+    return seq;
+#endif
+}
+
+uint32_t log_seq_last(void)
+{
+    return __atomic_load_n(&s_seq, __ATOMIC_RELAXED);
+}
+
+uint32_t log_seq_reserved(void)
+{
+#if LOG_SEQ_PERSIST == LOG_SEQ_PERSIST_OPTIGA
+    return s_anchored ? __atomic_load_n(&s_ceiling, __ATOMIC_ACQUIRE) : 0;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,58 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Record sequence numbers that never repeat on this device.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_seq.h
+ * @brief   Record sequence counter, persisted as a ceiling reserved in NVS or OPTIGA
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    NVS holds a ceiling: no number above it has been handed out. Crossing
+ *          it writes a new one LOG_SEQ_BLOCK further, so one NVS write covers a
+ *          block of records, and a boot restores the counter from the ceiling
+ *          with one read, skipping what the last boot left unused. Through deep
+ *          sleep the counter stays in RTC memory and NVS is not read at all.
+ *
+ * @note    LOG_SEQ_PERSIST 2 keeps the ceiling in an OPTIGA monotonic counter
+ *          instead: one update_count command reserves LOG_SEQ_BLOCK numbers and
+ *          the first reservation of a boot reads the counter. OPTIGA comes up
+ *          with the logger, so numbers taken before it (deep-sleep staging) are
+ *          covered by the first reservation after it.
+ *******************************************************************************/
+#ifndef LOG_SEQ_H
+#define LOG_SEQ_H
+
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+// Restore the counter (RTC memory after deep sleep, else the NVS ceiling). Call once
+// before the first log_seq_next().
+void log_seq_init(void);
+
+// Next sequence number, from any task. The one crossing the ceiling writes the next
+// ceiling first; a failed write is logged and numbering goes on.
+uint32_t log_seq_next(void);
+
+// Last number handed out, 0 before the first record ever
+uint32_t log_seq_last(void);
+
+// Ceiling read from or reserved on the OPTIGA counter (LOG_SEQ_PERSIST 2): no number
+// handed out so far is above it. 0 while the counter has not been read, or after a
+// failed reservation until the next one succeeds.
+uint32_t log_seq_reserved(void);
+
+#endif // LOG_SEQ_H
@@ -0,0 +1,282 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Bulk XOR and copy for the CTR keystream, vectorised on ESP32-S3.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_simd.c
+ * @brief   XOR / copy kernels: ESP32-S3 PIE with scalar fallback
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "enc_log_config.h"
+#include "log_simd.h"
+
+#if LOG_SIMD && defined(CONFIG_IDF_TARGET_ESP32S3)
+#define SIMD_PIE 1
+#else
+#define SIMD_PIE 0
+#endif
+
+#define SIMD_LANE           16      // bytes per PIE q register
+#define SIMD_MIN_BYTES      32      // shorter buffers stay scalar: the head alone may eat a lane
+#define SIMD_CHECK_BYTES    96
+
+// Word access to byte buffers, exempt from strict aliasing
+typedef uint32_t __attribute__((may_alias)) simd_word_t;
+
+// --------------------
+// Globals
+// --------------------
+#if SIMD_PIE
+static const char *TAG = "LOG_SIMD";
+static int8_t s_vector = -1;        // -1: not checked yet
+#endif
+
+// --------------------
+// Scalar kernels
+// --------------------
+static void xor_scalar(uint8_t *dst, const uint8_t *a, const uint8_t *b, size_t len)
+{
+    size_t i = 0;
+    if ((((uintptr_t)dst | (uintptr_t)a | (uintptr_t)b) & 3) == 0) {
+        for (; i + 4 <= len; i += 4) {
+            *(simd_word_t *)(dst + i) =
+                *(const simd_word_t *)(a + i) ^ *(const simd_word_t *)(b + i);
+        }
+    }
+    for (; i < len; i++) {
+        dst[i] = a[i] ^ b[i];
+    }
+}
+
+// --------------------
+// PIE kernels
+// --------------------
+#if SIMD_PIE
+// Lanes the vector loop may take from src: after each lane it has already loaded the
+// aligned 16 bytes that follow, which must still hold a byte of the buffer
+static size_t pie_lanes(const uint8_t *src, size_t len, size_t lanes)
+{
+    const uintptr_t first = (uintptr_t)src & ~(uintptr_t)(SIMD_LANE - 1);
+    const size_t fit = ((uintptr_t)src + len - 1 - first) / SIMD_LANE;
+    return (fit < lanes) ? fit : lanes;
+}
+
+// dst 16-byte aligned, lanes > 0. EE.LD.128.USAR loads the aligned lane around the
+// address and keeps its offset in SAR_BYTE, EE.SRC.Q.QUP funnels two lanes into the
+// unaligned 16 bytes. Each source sets SAR_BYTE just before its own funnel.
+static void pie_xor(uint8_t *dst, const uint8_t *a, const uint8_t *b, size_t lanes)
+{
+    __asm__ volatile(
+        "ee.ld.128.usar.ip  q0, %[a], 16\n"
+        "ee.ld.128.usar.ip  q2, %[b], 16\n"
+        "1:\n"
+        "ee.ld.128.usar.ip  q1, %[a], 16\n"
+        "ee.src.q.qup       q4, q0, q1\n"
+        "ee.ld.128.usar.ip  q3, %[b], 16\n"
+        "ee.src.q.qup       q5, q2, q3\n"
+        "ee.xorq            q6, q4, q5\n"
+        "ee.vst.128.ip      q6, %[dst], 16\n"
+        "addi               %[n], %[n], -1\n"
+        "bnez               %[n], 1b\n"
+        : [dst] "+r"(dst), [a] "+r"(a), [b] "+r"(b), [n] "+r"(lanes)
+        :
+        : "memory");
+}
+
+static void pie_copy(uint8_t *dst, const uint8_t *src, size_t lanes)
+{
+    __asm__ volatile(
+        "ee.ld.128.usar.ip  q0, %[s], 16\n"
+        "1:\n"
+        "ee.ld.128.usar.ip  q1, %[s], 16\n"
+        "ee.src.q.qup       q2, q0, q1\n"
+        "ee.vst.128.ip      q2, %[dst], 16\n"
+        "addi               %[n], %[n], -1\n"
+        "bnez               %[n], 1b\n"
+        : [dst] "+r"(dst), [s] "+r"(src), [n] "+r"(lanes)
+        :
+        : "memory");
+}
+
+// Scalar head up to an aligned destination, vector lanes, scalar tail
+static void xor_vector(uint8_t *dst, const uint8_t *a, const uint8_t *b, size_t len)
+{
+    const size_t head = (SIMD_LANE - ((uintptr_t)dst & (SIMD_LANE - 1))) & (SIMD_LANE - 1);
+    xor_scalar(dst, a, b, head);
+    dst += head;
+    a += head;
+    b += head;
+    len -= head;
+    const size_t lanes = pie_lanes(b, len, pie_lanes(a, len, len / SIMD_LANE));
+    if (lanes > 0) {
+        pie_xor(dst, a, b, lanes);
+        dst += lanes * SIMD_LANE;
+        a += lanes * SIMD_LANE;
+        b += lanes * SIMD_LANE;
+        len -= lanes * SIMD_LANE;
+    }
+    xor_scalar(dst, a, b, len);
+}
+
+static void copy_vector(uint8_t *dst, const uint8_t *src, size_t len)
+{
+    const size_t head = (SIMD_LANE - ((uintptr_t)dst & (SIMD_LANE - 1))) & (SIMD_LANE - 1);
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    len -= head;
+    const size_t lanes = pie_lanes(src, len, len / SIMD_LANE);
+    if (lanes > 0) {
+        pie_copy(dst, src, lanes);
+        dst += lanes * SIMD_LANE;
+        src += lanes * SIMD_LANE;
+        len -= lanes * SIMD_LANE;
+    }
+    memcpy(dst, src, len);
+}
+
+// Every source and destination offset within a lane, lengths around the lane and
+// head boundaries, and in place as the CTR writer calls it
+static bool vector_check(void)
+{
+    uint8_t a[SIMD_CHECK_BYTES + 2 * SIMD_LANE];
+    uint8_t b[SIMD_CHECK_BYTES + 2 * SIMD_LANE];
+    uint8_t want[SIMD_CHECK_BYTES + 2 * SIMD_LANE];
+    uint8_t got[SIMD_CHECK_BYTES + 2 * SIMD_LANE];
+    for (size_t i = 0; i < sizeof(a); i++) {
+        a[i] = (uint8_t)(i * 0x9D + 7);
+        b[i] = (uint8_t)((i * 0x3B) ^ (i >> 2));
+    }
+    for (size_t off = 0; off < SIMD_LANE; off++) {
+        for (size_t len = SIMD_MIN_BYTES; len <= SIMD_CHECK_BYTES; len += 7) {
+            const size_t boff = (off * 5 + 3) % SIMD_LANE;
+            xor_scalar(want, a + off, b + boff, len);
+            memset(got, 0, sizeof(got));
+            xor_vector(got + off, a + off, b + boff, len);
+            if (memcmp(want, got + off, len) != 0) {
+                return false;
+            }
+            memcpy(got, a, sizeof(got));
+            xor_vector(got + off, got + off, b + boff, len);
+            if (memcmp(want, got + off, len) != 0) {
+                return false;
+            }
+            memset(got, 0, sizeof(got));
+            copy_vector(got + boff, b + off, len);
+            if (memcmp(b + off, got + boff, len) != 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+#endif
+
+// --------------------
+// Public API
+// --------------------
+bool log_simd_vector(void)
+{
+#if SIMD_PIE
+    if (s_vector < 0) {
+        s_vector = vector_check() ? 1 : 0;
+        if (!s_vector) {
+            ESP_LOGW(TAG, "PIE kernels differ from the scalar ones, using scalar");
+        }
+    }
+    return s_vector > 0;
+#else
+    return false;
+#endif
+}
+
+void log_simd_xor(uint8_t *dst, const uint8_t *a, const uint8_t *b, size_t len)
+{
+#if SIMD_PIE
+    if (len >= SIMD_MIN_BYTES && log_simd_vector()) {
+        xor_vector(dst, a, b, len);
+        return;
+    }
+#endif
+    xor_scalar(dst, a, b, len);
+}
+
+void log_simd_copy(uint8_t *dst, const uint8_t *src, size_t len)
+{
+#if SIMD_PIE
+    if (len >= SIMD_MIN_BYTES && log_simd_vector()) {
+        copy_vector(dst, src, len);
+        return;
+    }
+#endif
+    memcpy(dst, src, len);
+}
+
+bool log_simd_bench(uint32_t bytes, unsigned iterations, log_simd_bench_t *res)
+{
+    // Room to align each buffer and put the destination 2 bytes past it, as a record's
+    // ciphertext behind its 2-byte header and 16-byte counter block
+    uint8_t *mem = malloc(3 * (bytes + 2 * SIMD_LANE));
+    if (mem == NULL) {
+        return false;
+    }
+    uint8_t *base = (uint8_t *)(((uintptr_t)mem + SIMD_LANE - 1) & ~(uintptr_t)(SIMD_LANE - 1));
+    const size_t stride = ((bytes + SIMD_LANE - 1) / SIMD_LANE + 1) * SIMD_LANE;
+    uint8_t *dst = base + 2;
+    uint8_t *src = base + stride + 2;
+    uint8_t *ks = base + 2 * stride;
+    for (uint32_t i = 0; i < bytes; i++) {
+        src[i] = (uint8_t)i;
+        ks[i] = (uint8_t)(i * 0x9D);
+    }
+
+    memset(res, 0, sizeof(*res));
+    res->vector = log_simd_vector();
+    res->bytes = bytes;
+    int64_t t = esp_timer_get_time();
+    for (unsigned i = 0; i < iterations; i++) {
+        xor_scalar(dst, dst, ks, bytes);
+    }
+    res->xor_scalar_us = (uint32_t)(esp_timer_get_time() - t);
+    t = esp_timer_get_time();
+    for (unsigned i = 0; i < iterations; i++) {
+        log_simd_xor(dst, dst, ks, bytes);
+    }
+    res->xor_us = (uint32_t)(esp_timer_get_time() - t);
+    t = esp_timer_get_time();
+    for (unsigned i = 0; i < iterations; i++) {
+        memcpy(dst, src, bytes);
+    }
+    res->copy_memcpy_us = (uint32_t)(esp_timer_get_time() - t);
+    t = esp_timer_get_time();
+    for (unsigned i = 0; i < iterations; i++) {
+        log_simd_copy(dst, src, bytes);
+    }
+    res->copy_us = (uint32_t)(esp_timer_get_time() - t);
+
+    free(mem);
+    return true;
+}
@@ -0,0 +1,59 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Bulk XOR and copy for the CTR keystream, vectorised on ESP32-S3.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_simd.h
+ * @brief   XOR / copy kernels: ESP32-S3 PIE with scalar fallback
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    With LOG_SIMD on ESP32-S3 the bulk of a buffer goes through the PIE
+ *          128-bit registers: 16-byte aligned stores, sources at any alignment
+ *          (EE.LD.128.USAR + EE.SRC.Q). Heads and tails, and every other target,
+ *          use the scalar kernels. The first call checks the vector kernels
+ *          against the scalar ones and keeps the scalar ones if they differ.
+ *          PIE is a coprocessor: call from tasks only, not from ISRs.
+ *******************************************************************************/
+#ifndef LOG_SIMD_H
+#define LOG_SIMD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    bool vector;                // PIE kernels in use
+    uint32_t bytes;             // per call; the destination starts 2 bytes past alignment
+    uint32_t xor_scalar_us;     // all iterations
+    uint32_t xor_us;
+    uint32_t copy_memcpy_us;
+    uint32_t copy_us;
+} log_simd_bench_t;
+
+// dst = a ^ b over len bytes. dst may be a or b, but must not overlap them otherwise.
+void log_simd_xor(uint8_t *dst, const uint8_t *a, const uint8_t *b, size_t len);
+
+// Copy len bytes; the buffers must not overlap.
+void log_simd_copy(uint8_t *dst, const uint8_t *src, size_t len);
+
+// True once the vector kernels passed their check (false on other targets or with LOG_SIMD 0).
+bool log_simd_vector(void);
+
+// Time the scalar and the selected kernels, and memcpy, on buffers of bytes laid out like a
+// record (destination 2 bytes past alignment, keystream aligned). False if out of memory.
+bool log_simd_bench(uint32_t bytes, unsigned iterations, log_simd_bench_t *res);
+
+#endif // LOG_SIMD_H
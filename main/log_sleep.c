@@ -0,0 +1,152 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Collect readings across deep sleep wakes without storage or OPTIGA.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_sleep.c
+ * @brief   RTC memory staging of encoded records for the deep-sleep logger
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+
+#include "enc_log.h"
+#include "log_sleep.h"
+
+#define SLEEP_STAGE_MAGIC       0x534C5047u     // "SLPG"
+#define SLEEP_ENTRY_HDR_BYTES   5               // len, seq
+
+typedef struct {
+    uint32_t magic;
+    uint32_t crc;                       // over count, used and the used data
+    uint16_t count;
+    uint16_t used;
+    uint8_t data[LOG_SLEEP_STAGE_BYTES];
+} sleep_stage_t;
+
+// --------------------
+// Globals
+// --------------------
+static const char *TAG = "LOG_SLEEP";
+// Not initialised at boot: kept through deep sleep and resets other than power-on
+static RTC_NOINIT_ATTR sleep_stage_t s_stage;
+
+// --------------------
+// Helpers
+// --------------------
+static uint32_t stage_crc(void)
+{
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&s_stage.count, sizeof(s_stage.count));
+    crc = esp_rom_crc32_le(crc, (const uint8_t *)&s_stage.used, sizeof(s_stage.used));
+    return esp_rom_crc32_le(crc, s_stage.data, s_stage.used);
+}
+
+static void stage_seal(void)
+{
+    s_stage.crc = stage_crc();
+    s_stage.magic = SLEEP_STAGE_MAGIC;
+}
+
+// --------------------
+// Public API
+// --------------------
+void log_sleep_init(void)
+{
+    if (s_stage.magic == SLEEP_STAGE_MAGIC && s_stage.used <= sizeof(s_stage.data) &&
+        s_stage.crc == stage_crc()) {
+        if (s_stage.count > 0) {
+            ESP_LOGI(TAG, "%u staged records kept (%u bytes)", (unsigned)s_stage.count,
+                     (unsigned)s_stage.used);
+        }
+        return;
+    }
+    s_stage.count = 0;
+    s_stage.used = 0;
+    stage_seal();
+}
+
+bool log_sleep_stage(const void *record, size_t len, uint32_t seq)
+{
+    if (len == 0 || len > PLAINTEXT_MAX ||
+        s_stage.used + SLEEP_ENTRY_HDR_BYTES + len > sizeof(s_stage.data)) {
+        return false;
+    }
+    uint8_t *p = s_stage.data + s_stage.used;
+    p[0] = (uint8_t)len;
+    p[1] = (uint8_t)seq;
+    p[2] = (uint8_t)(seq >> 8);
+    p[3] = (uint8_t)(seq >> 16);
+    p[4] = (uint8_t)(seq >> 24);
+    memcpy(p + SLEEP_ENTRY_HDR_BYTES, record, len);
+    s_stage.used += (uint16_t)(SLEEP_ENTRY_HDR_BYTES + len);
+    s_stage.count++;
+    stage_seal();
+    return true;
+}
+
+uint32_t log_sleep_staged(void)
+{
+    return s_stage.count;
+}
+
+bool log_sleep_flush_due(void)
+{
+    return s_stage.count >= LOG_SLEEP_FLUSH_WAKES ||
+           s_stage.used + SLEEP_ENTRY_HDR_BYTES + PLAINTEXT_MAX > sizeof(s_stage.data);
+}
+
+uint32_t log_sleep_flush(uint32_t timeout_ms)
+{
+    size_t pos = 0;
+    uint32_t submitted = 0;
+
+    while (submitted < s_stage.count) {
+        const uint8_t *p = s_stage.data + pos;
+        const size_t len = p[0];
+        const uint32_t seq = (uint32_t)p[1] | ((uint32_t)p[2] << 8) | ((uint32_t)p[3] << 16) |
+                             ((uint32_t)p[4] << 24);
+        const uint8_t *record = p + SLEEP_ENTRY_HDR_BYTES;
+        // More records than ring slots: let the writer empty it, then go on
+        if (!enc_log_submit(record, len, seq, false) &&
+            (!enc_log_sync(timeout_ms) || !enc_log_submit(record, len, seq, false))) {
+            ESP_LOGW(TAG, "ring full, %lu staged records left for the next flush",
+                     (unsigned long)(s_stage.count - submitted));
+            break;
+        }
+        pos += SLEEP_ENTRY_HDR_BYTES + len;
+        submitted++;
+    }
+    if (submitted == 0) {
+        return 0;
+    }
+    if (!enc_log_sync(timeout_ms)) {
+        ESP_LOGW(TAG, "log sync timed out, staged records kept");
+        return 0;
+    }
+
+    memmove(s_stage.data, s_stage.data + pos, s_stage.used - pos);
+    s_stage.used -= (uint16_t)pos;
+    s_stage.count -= (uint16_t)submitted;
+    stage_seal();
+    return submitted;
+}
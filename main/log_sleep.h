@@ -0,0 +1,57 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Collect readings across deep sleep wakes without storage or OPTIGA.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_sleep.h
+ * @brief   RTC memory staging of encoded records for the deep-sleep logger
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Staged records are len (1B) || seq (4B LE) || encoded record, packed
+ *          in RTC slow memory that is not initialised by the bootloader, so they
+ *          survive deep sleep and software, panic and watchdog resets. A CRC over
+ *          the area tells kept contents from the noise of a power-on. A record
+ *          leaves the area only after enc_log_sync() has it on storage.
+ *******************************************************************************/
+#ifndef LOG_SLEEP_H
+#define LOG_SLEEP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+// Keep the staged records if their CRC matches, else start empty. Call once at boot
+// before the others.
+void log_sleep_init(void);
+
+// Append one encoded record. False when it does not fit.
+bool log_sleep_stage(const void *record, size_t len, uint32_t seq);
+
+// Records waiting in RTC memory
+uint32_t log_sleep_staged(void);
+
+// True once LOG_SLEEP_FLUSH_WAKES records are staged or a full-size record might not
+// fit any more
+bool log_sleep_flush_due(void);
+
+// Submit the staged records to enc_log in order (syncing when the ring is full), sync,
+// and drop them. Returns the records written; after a failed sync all stay staged
+// and the next flush may store some of them twice (same seq).
+uint32_t log_sleep_flush(uint32_t timeout_ms);
+
+#endif // LOG_SLEEP_H
@@ -0,0 +1,225 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Storage backend interface used by the encrypted log writer.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_store.h
+ * @brief   Log store (FATFS file or raw flash partition)
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    The backend is chosen at compile time with LOG_STORAGE_RAW:
+ *          log_store_fat.c (buffered file appender on FATFS, or on LittleFS with
+ *          LOG_STORAGE_LITTLEFS) or log_store_raw.c (append-only pages on the
+ *          flash partition). Both present the log as
+ *          one byte stream of records. Not thread-safe: the caller serialises
+ *          access.
+ *******************************************************************************/
+#ifndef LOG_STORE_H
+#define LOG_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+#include "log_zone.h"
+
+// Open the store and recover the current end of the log.
+bool log_store_open(void);
+
+// Append log bytes; written and synced according to the LOG_SYNC_* policy.
+bool log_store_append(const void *data, size_t len);
+
+// Sparse index: the last append holds `records` records starting at seq, logged
+// at uptime_ms in a boot whose wall clock base is wall_base_ms (log_time.h).
+// Writes an index entry when due (no-op for the raw store).
+bool log_store_index(uint32_t seq, uint32_t uptime_ms, uint32_t epoch_offset,
+                     uint64_t wall_base_ms, uint32_t records);
+
+// Zone map (LOG_ZONE_MAP): fold the zone of the last append's records into the open
+// segment's, saved when the segment is sealed (no-op otherwise).
+void log_store_zone_add(const log_zone_t *zone);
+
+typedef struct {
+    uint32_t position;          // log offset of the segment's first data byte
+    uint32_t end;               // log offset past its last
+    bool summarised;            // zone covers every record of the segment
+    log_zone_t zone;
+} log_store_zone_t;
+
+// Sealed segment holding log offset position. False for the open segment, and without
+// zone maps (raw store, LOG_ZONE_MAP 0).
+bool log_store_zone(uint32_t position, log_store_zone_t *out);
+
+// File offset at which the last append starts (0 for the raw store).
+uint32_t log_store_last_offset(void);
+
+// Log offset (as for log_store_read) at which the last append starts. Moves down
+// when the oldest data is dropped (rotation, raw sector recycling).
+uint32_t log_store_last_position(void);
+
+// File offset in the open file of log offset position, as log_store_last_offset() gives
+// it; INDEX_NO_EPOCH if position lies before the open file (0 for the raw store).
+uint32_t log_store_file_offset(uint32_t position);
+
+typedef enum {
+    LOG_STORE_SEEK_SEQ,         // last entry with seq <= value
+    LOG_STORE_SEEK_UPTIME,      // last entry with uptime <= value, within the newest boot
+    LOG_STORE_SEEK_TIME,        // last entry with wall time <= value (Unix s), clock set
+    LOG_STORE_SEEK_POSITION,    // last entry at or before log offset value
+} log_store_seek_t;
+
+typedef struct {
+    uint32_t seq;
+    uint32_t uptime_ms;
+    uint32_t position;          // log offset of the indexed record or block group
+    uint32_t epoch_position;    // log offset of its epoch header, INDEX_NO_EPOCH if none
+    uint64_t wall_base_ms;      // Unix ms at uptime 0 of its boot, 0 if the clock was not set
+    uint32_t next_position;     // log offset of the next entry (records up to it share the boot)
+} log_store_entry_t;
+
+// Sparse index lookup: where to start decrypting for value. False if there is no
+// index (raw store) or no entry at or below value; read from offset 0 then.
+bool log_store_seek(log_store_seek_t by, uint32_t value, log_store_entry_t *entry);
+
+// Make everything appended so far durable.
+bool log_store_sync(void);
+
+// Sync if LOG_SYNC_INTERVAL_MS has passed since the oldest unsynced append.
+bool log_store_poll(void);
+
+// Milliseconds until log_store_poll() has work, UINT32_MAX if nothing is pending.
+uint32_t log_store_poll_delay_ms(void);
+
+// True if appending len bytes would start a new segment (always false for the
+// raw store). Lets the writer start a new key epoch at the segment start.
+bool log_store_rotate_due(size_t len);
+
+// Close the current segment and start the next one (no-op for the raw store).
+bool log_store_rotate(void);
+
+// Drop the whole log.
+bool log_store_clear(void);
+
+// Bytes of log data. Call log_store_sync() first to include buffered appends.
+uint32_t log_store_size(void);
+
+// Read log bytes starting at offset (0 = oldest byte). Returns bytes read.
+size_t log_store_read(uint32_t offset, void *buf, size_t len);
+
+// Window of the raw partition mapped for one reader (LOG_RAW_MMAP); the FATFS store
+// never maps. Zero-initialise, and release with log_store_unmap().
+typedef struct {
+    uint32_t handle;            // esp_partition_mmap_handle_t
+    const uint8_t *base;        // first mapped page
+    uint32_t first_page;
+    uint32_t pages;             // 0 = nothing mapped
+} log_store_map_t;
+
+// Log bytes at offset in place, up to the end of the flash page that holds them:
+// *len is the count. Valid until the next call on map, or until the bytes are
+// dropped (log_store_dropped() moves past them). NULL if the store cannot map
+// (FATFS, LOG_RAW_MMAP 0) or offset is past the end; use log_store_read() then.
+const void *log_store_view(log_store_map_t *map, uint32_t offset, size_t *len);
+
+// Unmap the window of map, if any.
+void log_store_unmap(log_store_map_t *map);
+
+// Bytes dropped from the front of the log since open (retention, clear). Offset
+// 0 moves by this much, so log_store_dropped() + offset is a stable position.
+uint32_t log_store_dropped(void);
+
+// Nested pin for readers of a snapshot: while pinned, retention by bytes and age
+// waits. Drops the store cannot defer (FATFS out of space or segment slots, the
+// raw ring wrapping) and log_store_clear() still happen.
+void log_store_pin(bool pin);
+
+// Closed (sealed) segments of LOG_ROTATE, by id. Offsets here are data offsets in the
+// segment. The raw store has none (all false).
+typedef struct {
+    uint32_t id;
+    uint32_t bytes;             // data bytes
+} log_store_segment_t;
+
+// Closed segment with the lowest id >= id. False if there is none.
+bool log_store_segment_next(uint32_t id, log_store_segment_t *seg);
+
+// Read data bytes of closed segment id. Returns bytes read.
+size_t log_store_segment_read(uint32_t id, uint32_t offset, void *buf, size_t len);
+
+// Segment rewrite (LOG_COMPACT): a closed segment is copied unit by unit into a file next
+// to it, then swapped in with its index. One rewrite at a time.
+
+// Start the copy of closed segment id. False if it is not closed or the file system has
+// no room for the copy.
+bool log_store_rewrite_begin(uint32_t id);
+
+// Data offset of the first index entry of the segment at or after offset, UINT32_MAX if
+// none. A unit of the copy must start at each: the entry moves to it.
+uint32_t log_store_rewrite_mark(uint32_t offset);
+
+// Append the unit that replaces the segment's data from old_offset on. header: the unit is
+// a format or epoch header that index entries name.
+bool log_store_rewrite_append(const void *data, size_t len, uint32_t old_offset, bool header);
+
+// Swap the copy in for the segment. False, and the copy dropped, if the segment is gone,
+// a snapshot is pinned (log_store_pin()) or the copy could not be made durable. Log
+// offsets behind the segment move down by what it saved.
+bool log_store_rewrite_commit(void);
+
+// Drop the copy.
+void log_store_rewrite_abort(void);
+
+// One bounded step of background work (segment files of a clear, raw retention over
+// the cap, moving a closed segment to the SD tier). True while more is left; the
+// writer runs one step per idle pass.
+bool log_store_maintain(void);
+
+// Steps log_store_maintain() has left: segment files, raw sectors or segments to
+// move to the SD tier.
+uint32_t log_store_maint_pending(void);
+
+// SD tier replication state (LOG_TIER_SD): bytes durable in flash that the card does not
+// hold yet, and the checkpoint, the segment being copied and its bytes synced on the card.
+typedef struct {
+    uint32_t lag_bytes;
+    uint32_t segment;
+    uint32_t offset;
+} log_store_replica_t;
+
+// False without an SD tier (everything zero).
+bool log_store_replica(log_store_replica_t *replica);
+
+// Appends lost to failed writes.
+uint32_t log_store_lost(void);
+
+// Syncs that made appends durable (fsync, or a page program for the raw store).
+uint32_t log_store_syncs(void);
+
+// Lowest and highest erase count of the raw partition sectors since counting began
+// (LOG_RAW_WEAR_SAVE_ERASES). False for the FATFS store, where wear levelling or the
+// card controller spreads the erases.
+bool log_store_wear(uint32_t *min_erases, uint32_t *max_erases);
+
+// Sector erases on the append path: the raw store's pre-erase pool was empty
+// (LOG_RAW_PREERASE_SECTORS). 0 for the FATFS store.
+uint32_t log_store_inline_erases(void);
+
+// Bytes that can still be appended before the store drops old data or fills:
+// free file system space (FATFS) or unprogrammed pages (raw). Capped at UINT32_MAX.
+uint32_t log_store_free(void);
+
+#endif // LOG_STORE_H
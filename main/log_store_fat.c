@@ -0,0 +1,1860 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Log store backend on FATFS files (SPI flash + WL, or SD card).
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_store_fat.c
+ * @brief   FATFS log store
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    With LOG_ROTATE the log is a run of numbered segment files
+ *          [first, last]; only the last one is open for append. The manifest
+ *          holds the two ids, so rotation and retention never scan the log.
+ *          Each log file has its own sparse index sidecar (LOG_INDEX_EVERY).
+ *          With LOG_TIER_SD segments [first, hot) are on the SD card and
+ *          [hot, last] in flash; the oldest flash segment moves next.
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include "log_store.h"
+
+#if !LOG_STORAGE_RAW
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+
+#include "esp_vfs_fat.h"
+
+#include "log_appender.h"
+#include "log_crash.h"
+#include "log_mount.h"
+#include "log_segment.h"
+#include "log_wear.h"
+
+#if LOG_SEGMENT_BYTES > 0 && LOG_SEQ_PERSIST == LOG_SEQ_PERSIST_OPTIGA
+#include "log_seq.h"
+#endif
+#if LOG_ROTATE
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+#if LOG_RETAIN_AGE_S > 0
+#include "log_time.h"
+#endif
+#if LOG_TIER_SD
+#include "esp_timer.h"
+#endif
+#if LOG_ZONE_MAP
+#include "log_zone.h"
+#endif
+
+#if LOG_ROTATE || LOG_INDEX_EVERY > 0
+static const char *TAG = "LOG_STORE";
+#endif
+
+static log_appender_t s_appender;
+static uint32_t s_dropped = 0;          // bytes dropped from the front since open
+
+#if LOG_INDEX_EVERY > 0
+static FILE *s_idx = NULL;              // sidecar of the file open in s_appender
+static uint32_t s_idx_records = 0;      // records since the last index entry
+static bool s_idx_first = true;         // next indexed record is the first since open
+#endif
+
+#if LOG_INDEX_EVERY > 0
+// --------------------
+// Sparse Index
+// --------------------
+static void index_close(void)
+{
+    if (s_idx) {
+        fclose(s_idx);
+        s_idx = NULL;
+    }
+}
+
+// mode "ab" keeps the entries of a reopened file, "wb" starts an empty index
+static void index_open(const char *path, const char *mode)
+{
+    index_close();
+    s_idx = fopen(path, mode);
+    if (!s_idx) {
+        ESP_LOGW(TAG, "failed to open index %s", path);
+    }
+    s_idx_records = 0;
+    s_idx_first = true;
+}
+
+static void index_sync(void)
+{
+    // Called after the data sync, so entries never lead the durable log by much;
+    // readers still ignore offsets past the end of the data
+    LOG_CRASH_POINT(LOG_CRASH_INDEX);
+    if (s_idx && fflush(s_idx) == 0) {
+        fsync(fileno(s_idx));
+    }
+}
+#endif
+
+#if LOG_ROTATE
+#if LOG_SEGMENT_BYTES > 0
+// Preallocated segments rotate when full
+#define SEGMENT_DATA_LIMIT (LOG_SEGMENT_BYTES - SEGMENT_HDR_BYTES)
+#else
+#define SEGMENT_DATA_LIMIT LOG_ROTATE_BYTES
+#endif
+
+// LOG_ROTATE_RECORDS counts in record-sized units (a block group counts as several)
+#define RECORD_BYTES (AES_IV_BYTES + PLAINTEXT_MAX)
+#define RECORD_UNITS(len) (((uint32_t)(len) + RECORD_BYTES - 1) / RECORD_BYTES)
+
+static uint32_t s_first_id = 1;         // oldest live segment
+static uint32_t s_last_id = 1;          // segment open in s_appender
+static uint32_t s_closed_bytes[LOG_RETAIN_SEGMENTS];   // data bytes, by id % N
+static uint32_t s_cur_records = 0;      // record units in the current segment
+static uint32_t s_lost_closed = 0;      // appender losses of closed segments
+static uint32_t s_syncs_closed = 0;     // appender syncs of closed segments
+static char s_cur_path[48];
+
+// Read handle on a closed segment, kept between reads
+static FILE *s_rd_file = NULL;
+static uint32_t s_rd_id = 0;
+
+static uint32_t s_pins = 0;             // log_store_pin() depth: optional retention waits
+
+// Segments of a clear still to delete, one per log_store_maintain() step (none if lo > hi)
+static uint32_t s_reclaim_lo = 1;
+static uint32_t s_reclaim_hi = 0;
+
+#if LOG_SEGMENT_BYTES > 0
+// Dropped preallocated segment kept for the next rotation (0 = none): the ring of
+// segment files reuses its clusters instead of deleting and filling a new file
+static uint32_t s_spare_id = 0;
+#endif
+
+#if LOG_TIER_SD
+static uint32_t s_hot_id = 1;           // oldest segment in flash, older ones are on the card
+static FILE *s_mig_src = NULL;          // move of segment s_hot_id in progress
+static FILE *s_mig_dst = NULL;
+static bool s_tier_ok = true;           // false after a card error: remount first
+static int64_t s_tier_retry_us = 0;     // no move before this time (esp_timer)
+static uint8_t s_tier_buf[LOG_TIER_COPY_BYTES] __attribute__((aligned(512)));
+#if LOG_TIER_REPLICATE
+static uint32_t s_mig_bytes = 0;        // checkpoint: bytes of s_hot_id synced on the card
+#endif
+#endif
+
+// --------------------
+// Segments and Manifest
+// --------------------
+// Path of segment id in the tier that holds it
+static void segment_path(char *out, size_t n, uint32_t id)
+{
+#if LOG_TIER_SD
+    if (id < s_hot_id) {
+        snprintf(out, n, LOG_TIER_SEGMENT_PATH_FMT, (unsigned long)id);
+        return;
+    }
+#endif
+    snprintf(out, n, LOG_SEGMENT_PATH_FMT, (unsigned long)id);
+}
+
+#if LOG_INDEX_EVERY > 0
+static void index_path(char *out, size_t n, uint32_t id)
+{
+#if LOG_TIER_SD
+    if (id < s_hot_id) {
+        snprintf(out, n, LOG_TIER_INDEX_PATH_FMT, (unsigned long)id);
+        return;
+    }
+#endif
+    snprintf(out, n, LOG_INDEX_PATH_FMT, (unsigned long)id);
+}
+#endif
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+static bool manifest_write(void)
+{
+    uint8_t m[MANIFEST_BYTES];
+    memcpy(m, MANIFEST_MAGIC, 4);
+    put_le32(m + 4, s_first_id);
+    put_le32(m + 8, s_last_id);
+    put_le32(m + 12, esp_rom_crc32_le(0, m, 12));
+
+    FILE *f = fopen(LOG_MANIFEST_PATH, "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "failed to write manifest");
+        return false;
+    }
+    bool ok = fwrite(m, 1, sizeof(m), f) == sizeof(m);
+    ok = (fclose(f) == 0) && ok;
+    return ok;
+}
+
+static bool manifest_load(void)
+{
+    uint8_t m[MANIFEST_BYTES];
+    FILE *f = fopen(LOG_MANIFEST_PATH, "rb");
+    if (!f) {
+        return false;
+    }
+    const bool read_ok = fread(m, 1, sizeof(m), f) == sizeof(m);
+    fclose(f);
+    if (!read_ok || memcmp(m, MANIFEST_MAGIC, 4) != 0 ||
+        get_le32(m + 12) != esp_rom_crc32_le(0, m, 12)) {
+        return false;
+    }
+
+    const uint32_t first = get_le32(m + 4);
+    const uint32_t last = get_le32(m + 8);
+    if (first == 0 || last < first || last - first >= LOG_RETAIN_SEGMENTS) {
+        return false;
+    }
+    s_first_id = first;
+    s_last_id = last;
+    return true;
+}
+
+// Manifest missing or damaged: recover the id range from the directory (both tiers)
+static void manifest_rebuild(void)
+{
+#if LOG_TIER_SD
+    static const char *const dirs[] = {LOG_MOUNT_POINT, LOG_TIER_MOUNT_POINT};
+#else
+    static const char *const dirs[] = {LOG_MOUNT_POINT};
+#endif
+    uint32_t lo = 0;
+    uint32_t hi = 0;
+    for (size_t d = 0; d < sizeof(dirs) / sizeof(dirs[0]); d++) {
+        DIR *dir = opendir(dirs[d]);
+        if (!dir) {
+            continue;
+        }
+        struct dirent *de;
+        while ((de = readdir(dir)) != NULL) {
+            unsigned long id = 0;
+            if (sscanf(de->d_name, "enc_log_%lu.bin", &id) == 1 && id > 0) {
+                lo = (lo == 0 || id < lo) ? (uint32_t)id : lo;
+                hi = (id > hi) ? (uint32_t)id : hi;
+            }
+        }
+        closedir(dir);
+    }
+
+    if (hi == 0) {
+        s_first_id = s_last_id = 1;
+    } else {
+        s_last_id = hi;
+        s_first_id = (hi - lo >= LOG_RETAIN_SEGMENTS) ? hi - LOG_RETAIN_SEGMENTS + 1 : lo;
+    }
+    ESP_LOGW(TAG, "manifest rebuilt: segments %lu..%lu", (unsigned long)s_first_id,
+             (unsigned long)s_last_id);
+    manifest_write();
+}
+
+static void close_read_handle(void)
+{
+    if (s_rd_file) {
+        fclose(s_rd_file);
+        s_rd_file = NULL;
+    }
+}
+
+#if LOG_COMPACT
+// --------------------
+// Segment Rewrite
+// --------------------
+static uint32_t s_rw_id = 0;            // segment being copied, 0 = none
+static FILE *s_rw_data = NULL;          // the copy and its index
+static FILE *s_rw_idx = NULL;
+static FILE *s_rw_old_idx = NULL;       // index of the segment, entries moved as units arrive
+static uint32_t s_rw_old_count = 0;
+static uint32_t s_rw_next = 0;          // next entry of s_rw_old_idx to move
+static uint32_t s_rw_bytes = 0;         // data bytes of the copy
+static uint32_t s_rw_hdr_old = INDEX_NO_EPOCH;  // newest header: file offset in the segment
+static uint32_t s_rw_hdr_new = INDEX_NO_EPOCH;  // and in the copy
+
+static void rewrite_paths(uint32_t id, char *data, char *idx, size_t n)
+{
+    snprintf(data, n, LOG_COMPACT_SEGMENT_PATH_FMT, (unsigned long)id);
+    snprintf(idx, n, LOG_COMPACT_INDEX_PATH_FMT, (unsigned long)id);
+}
+
+static void rewrite_close(void)
+{
+    FILE **files[] = {&s_rw_data, &s_rw_idx, &s_rw_old_idx};
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        if (*files[i]) {
+            fclose(*files[i]);
+            *files[i] = NULL;
+        }
+    }
+}
+
+// Copy files of segment id, index first: a copy index without its data file is what a
+// swap past its commit point leaves (rewrite_recover())
+static void rewrite_remove(uint32_t id)
+{
+    char data[sizeof(s_cur_path)];
+    char idx[sizeof(s_cur_path)];
+    if (s_rw_id == id) {
+        rewrite_close();
+        s_rw_id = 0;
+    }
+    rewrite_paths(id, data, idx, sizeof(data));
+    remove(idx);
+    remove(data);
+}
+#endif // LOG_COMPACT
+
+// Flash copy of segment id, whichever tier holds it
+static void remove_hot_files(uint32_t id)
+{
+    char path[sizeof(s_cur_path)];
+    snprintf(path, sizeof(path), LOG_SEGMENT_PATH_FMT, (unsigned long)id);
+    log_appender_remove(path);
+#if LOG_INDEX_EVERY > 0
+    snprintf(path, sizeof(path), LOG_INDEX_PATH_FMT, (unsigned long)id);
+    remove(path);
+#endif
+#if LOG_COMPACT
+    rewrite_remove(id);
+#endif
+}
+
+#if LOG_TIER_SD
+static void remove_cold_files(uint32_t id)
+{
+    char path[sizeof(s_cur_path)];
+    snprintf(path, sizeof(path), LOG_TIER_SEGMENT_PATH_FMT, (unsigned long)id);
+    remove(path);
+#if LOG_INDEX_EVERY > 0
+    snprintf(path, sizeof(path), LOG_TIER_INDEX_PATH_FMT, (unsigned long)id);
+    remove(path);
+#endif
+}
+#endif
+
+// Both tiers: leftovers of an interrupted move or clear may be in either
+static void remove_segment(uint32_t id)
+{
+    if (s_rd_file && s_rd_id == id) {
+        close_read_handle();
+    }
+    remove_hot_files(id);
+#if LOG_TIER_SD
+    remove_cold_files(id);
+#endif
+}
+
+static bool segment_exists(uint32_t id)
+{
+    char path[sizeof(s_cur_path)];
+    struct stat st;
+    snprintf(path, sizeof(path), LOG_SEGMENT_PATH_FMT, (unsigned long)id);
+    if (stat(path, &st) == 0) {
+        return true;
+    }
+#if LOG_TIER_SD
+    snprintf(path, sizeof(path), LOG_TIER_SEGMENT_PATH_FMT, (unsigned long)id);
+    return stat(path, &st) == 0;
+#else
+    return false;
+#endif
+}
+
+#if LOG_ZONE_MAP
+// --------------------
+// Zone Maps
+// --------------------
+static log_zone_t s_zone_open;          // records appended to the open segment
+static bool s_zone_whole = false;       // s_zone_open holds all of them (opened empty)
+static log_zone_t s_zones[LOG_RETAIN_SEGMENTS];     // sealed segments, by id % N
+static uint32_t s_zone_ids[LOG_RETAIN_SEGMENTS];    // segment of each, 0 = none
+
+// Cache the saved zones of the sealed live segments
+static void zone_load(void)
+{
+    memset(s_zone_ids, 0, sizeof(s_zone_ids));
+    FILE *f = fopen(LOG_ZONE_PATH, "rb");
+    if (!f) {
+        return;
+    }
+    uint8_t slot[ZONE_SLOT_BYTES];
+    for (uint32_t id = s_first_id; id < s_last_id; id++) {
+        const uint32_t i = id % LOG_RETAIN_SEGMENTS;
+        if (fseek(f, (long)(i * ZONE_SLOT_BYTES), SEEK_SET) == 0 &&
+            fread(slot, 1, sizeof(slot), f) == sizeof(slot) &&
+            log_zone_unpack(slot, id, &s_zones[i])) {
+            s_zone_ids[i] = id;
+        }
+    }
+    fclose(f);
+}
+
+// Save the zone of the open segment as it is sealed. A segment reopened after a reboot
+// gets an empty slot, so a slot of an older segment with the same id % N never stands in
+static void zone_seal(void)
+{
+    const uint32_t i = s_last_id % LOG_RETAIN_SEGMENTS;
+    uint8_t slot[ZONE_SLOT_BYTES];
+    memset(slot, 0, sizeof(slot));
+    if (s_zone_whole) {
+        log_zone_pack(&s_zone_open, s_last_id, slot);
+    }
+
+    s_zone_ids[i] = 0;
+    FILE *f = fopen(LOG_ZONE_PATH, "r+b");
+    if (!f) {
+        f = fopen(LOG_ZONE_PATH, "w+b");
+    }
+    if (!f) {
+        ESP_LOGW(TAG, "zone map of segment %lu not saved", (unsigned long)s_last_id);
+        return;
+    }
+    bool ok = fseek(f, (long)(i * ZONE_SLOT_BYTES), SEEK_SET) == 0 &&
+              fwrite(slot, 1, sizeof(slot), f) == sizeof(slot);
+    ok = (fclose(f) == 0) && ok;
+    if (ok && s_zone_whole) {
+        s_zones[i] = s_zone_open;
+        s_zone_ids[i] = s_last_id;
+    }
+}
+#endif // LOG_ZONE_MAP
+
+static bool open_current(void)
+{
+    segment_path(s_cur_path, sizeof(s_cur_path), s_last_id);
+    if (!log_appender_open(&s_appender, s_cur_path)) {
+        return false;
+    }
+#if LOG_INDEX_EVERY > 0
+    char path[sizeof(s_cur_path)];
+    index_path(path, sizeof(path), s_last_id);
+    index_open(path, "ab");
+#endif
+    uint32_t start = 0;
+    uint32_t end = 0;
+    log_appender_data_range(&s_appender, &start, &end);
+    // After a reboot the count is rebuilt from the data size
+    s_cur_records = RECORD_UNITS(end - start);
+#if LOG_ZONE_MAP
+    log_zone_reset(&s_zone_open);
+    s_zone_whole = (end == start);
+#endif
+    return true;
+}
+
+static uint32_t current_bytes(void)
+{
+    uint32_t start = 0;
+    uint32_t end = 0;
+    log_appender_data_range(&s_appender, &start, &end);
+    return (end - start) + (uint32_t)s_appender.used;
+}
+#endif // LOG_ROTATE
+
+// --------------------
+// Segment Runs (log_segment.h)
+// --------------------
+uint32_t log_segment_base(const log_segments_t *segs, uint32_t id)
+{
+    uint32_t base = 0;
+    for (uint32_t i = segs->first_id; i < id; i++) {
+        base += segs->closed_bytes[i % segs->slots];
+    }
+    return base;
+}
+
+uint32_t log_segment_bytes(const log_segments_t *segs, uint32_t id)
+{
+    if (id != segs->last_id) {
+        return segs->closed_bytes[id % segs->slots];
+    }
+    uint32_t start = 0;
+    uint32_t end = 0;
+    log_appender_data_range(segs->app, &start, &end);
+    return (end > start) ? end - start : 0;
+}
+
+#if LOG_INDEX_EVERY > 0
+bool log_segment_index_read(FILE *f, uint32_t i, log_segment_entry_t *e)
+{
+    uint8_t raw[INDEX_ENTRY_BYTES];
+    if (fseek(f, (long)(i * INDEX_ENTRY_BYTES), SEEK_SET) != 0 ||
+        fread(raw, 1, sizeof(raw), f) != sizeof(raw)) {
+        return false;
+    }
+    uint32_t fields[4];
+    for (int k = 0; k < 4; k++) {
+        fields[k] = (uint32_t)raw[4 * k] | ((uint32_t)raw[4 * k + 1] << 8) |
+                    ((uint32_t)raw[4 * k + 2] << 16) | ((uint32_t)raw[4 * k + 3] << 24);
+    }
+    e->seq = fields[0];
+    e->uptime_ms = fields[1];
+    e->offset = fields[2];
+    e->epoch_offset = fields[3];
+    e->wall_base_ms = 0;
+    for (int b = 7; b >= 0; b--) {
+        e->wall_base_ms = (e->wall_base_ms << 8) | raw[16 + b];
+    }
+#if LOG_APPENDER_DATA_START > 0
+    if (e->offset < LOG_APPENDER_DATA_START) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool log_segment_index_write(FILE *f, const log_segment_entry_t *e)
+{
+    const uint32_t fields[4] = {e->seq, e->uptime_ms, e->offset, e->epoch_offset};
+    uint8_t raw[INDEX_ENTRY_BYTES];
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 4; b++) {
+            raw[4 * i + b] = (uint8_t)(fields[i] >> (8 * b));
+        }
+    }
+    for (int b = 0; b < 8; b++) {
+        raw[16 + b] = (uint8_t)(e->wall_base_ms >> (8 * b));
+    }
+    return fwrite(raw, 1, sizeof(raw), f) == sizeof(raw);
+}
+
+FILE *log_segment_index_open(const log_segments_t *segs, uint32_t id, uint32_t *count)
+{
+    char path[48];
+    segs->index_path(segs->ch, id, path, sizeof(path));
+    if (id == segs->last_id && segs->idx) {
+        fflush(segs->idx);
+    }
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    *count = (size > 0) ? (uint32_t)size / INDEX_ENTRY_BYTES : 0;
+
+    // Drop the entries at the end that point past the data
+    const uint32_t bytes = log_segment_bytes(segs, id);
+    log_segment_entry_t e;
+    while (*count > 0 && (!log_segment_index_read(f, *count - 1, &e) ||
+                          e.offset - LOG_APPENDER_DATA_START >= bytes)) {
+        (*count)--;
+    }
+    return f;
+}
+
+static uint32_t entry_position(const log_segments_t *segs, uint32_t id,
+                               const log_segment_entry_t *e)
+{
+    return log_segment_base(segs, id) + e->offset - LOG_APPENDER_DATA_START;
+}
+
+static void entry_to_log(const log_segments_t *segs, uint32_t id, const log_segment_entry_t *e,
+                         log_store_entry_t *out)
+{
+    const uint32_t base = log_segment_base(segs, id);
+    out->seq = e->seq;
+    out->uptime_ms = e->uptime_ms;
+    out->position = base + e->offset - LOG_APPENDER_DATA_START;
+    out->epoch_position = (e->epoch_offset == INDEX_NO_EPOCH)
+                              ? INDEX_NO_EPOCH
+                              : base + e->epoch_offset - LOG_APPENDER_DATA_START;
+    out->wall_base_ms = e->wall_base_ms;
+}
+
+// Log offset of the entry after entry i, or the segment end if i is its last entry.
+// A boot starts with an indexed record, so records before it share entry i's boot.
+static uint32_t entry_next_position(const log_segments_t *segs, FILE *f, uint32_t id,
+                                    uint32_t i, uint32_t count)
+{
+    log_segment_entry_t next;
+    if (i + 1 < count && log_segment_index_read(f, i + 1, &next)) {
+        return entry_position(segs, id, &next);
+    }
+    return log_segment_base(segs, id) + log_segment_bytes(segs, id);
+}
+
+// Ordering of the keys that only grow along the log (clock steps aside). An entry
+// without a wall clock counts as past any time: the search then starts earlier.
+static bool entry_at_or_below(const log_segments_t *segs, log_store_seek_t by, uint32_t id,
+                              const log_segment_entry_t *e, uint32_t value)
+{
+    switch (by) {
+    case LOG_STORE_SEEK_TIME:
+        return e->wall_base_ms != 0 && e->wall_base_ms + e->uptime_ms <= (uint64_t)value * 1000;
+    case LOG_STORE_SEEK_POSITION:
+        return entry_position(segs, id, e) <= value;
+    default:
+        return e->seq <= value;
+    }
+}
+
+// Binary search in the newest segment whose first entry is at or below value
+static bool seek_ordered(const log_segments_t *segs, log_store_seek_t by, uint32_t value,
+                         log_store_entry_t *out)
+{
+    for (uint32_t id = segs->last_id + 1; id-- > segs->first_id; ) {
+        uint32_t count = 0;
+        FILE *f = log_segment_index_open(segs, id, &count);
+        if (!f) {
+            continue;
+        }
+        log_segment_entry_t e;
+        if (count == 0 || !log_segment_index_read(f, 0, &e) ||
+            !entry_at_or_below(segs, by, id, &e, value)) {
+            fclose(f);
+            continue;
+        }
+        // Invariant: entry lo is at or below value, entries from hi on are above it
+        uint32_t lo = 0;
+        uint32_t hi = count;
+        while (hi - lo > 1) {
+            const uint32_t mid = lo + (hi - lo) / 2;
+            if (log_segment_index_read(f, mid, &e) && entry_at_or_below(segs, by, id, &e, value)) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        const bool ok = log_segment_index_read(f, lo, &e);
+        if (ok) {
+            entry_to_log(segs, id, &e, out);
+            out->next_position = entry_next_position(segs, f, id, lo, count);
+        }
+        fclose(f);
+        return ok;
+    }
+    return false;
+}
+
+// Uptime restarts at every boot, so walk back from the newest entry: the cost is
+// the entries after the target, and a boot boundary ends the walk
+static bool seek_uptime(const log_segments_t *segs, uint32_t uptime_ms, log_store_entry_t *out)
+{
+    bool have = false;
+    uint32_t newer_uptime = UINT32_MAX;
+    for (uint32_t id = segs->last_id + 1; id-- > segs->first_id; ) {
+        uint32_t count = 0;
+        FILE *f = log_segment_index_open(segs, id, &count);
+        if (!f) {
+            continue;
+        }
+        log_segment_entry_t e;
+        uint32_t next = log_segment_base(segs, id) + log_segment_bytes(segs, id);
+        for (uint32_t i = count; i-- > 0; ) {
+            if (!log_segment_index_read(f, i, &e) || e.uptime_ms > newer_uptime) {
+                // Earlier boot: the newest boot starts at the entry already kept
+                fclose(f);
+                return have;
+            }
+            entry_to_log(segs, id, &e, out);
+            out->next_position = next;
+            next = out->position;
+            have = true;
+            if (e.uptime_ms <= uptime_ms) {
+                fclose(f);
+                return true;
+            }
+            newer_uptime = e.uptime_ms;
+        }
+        fclose(f);
+    }
+    return have;
+}
+
+bool log_segment_seek(const log_segments_t *segs, log_store_seek_t by, uint32_t value,
+                      log_store_entry_t *out)
+{
+    return (by == LOG_STORE_SEEK_UPTIME) ? seek_uptime(segs, value, out)
+                                         : seek_ordered(segs, by, value, out);
+}
+#endif // LOG_INDEX_EVERY > 0
+
+bool log_segment_retire(const log_segments_t *segs, uint32_t keep, uint32_t age_s,
+                        uint64_t now_ms, bool pinned)
+{
+    if (segs->first_id >= segs->last_id) {
+        return false;
+    }
+    if (segs->last_id - segs->first_id >= keep) {
+        return true;
+    }
+#if LOG_INDEX_EVERY > 0
+    if (pinned || age_s == 0 || now_ms == 0) {
+        return false;
+    }
+    uint32_t count = 0;
+    FILE *f = log_segment_index_open(segs, segs->first_id, &count);
+    if (!f) {
+        return false;
+    }
+    log_segment_entry_t e;
+    const bool have = count > 0 && log_segment_index_read(f, count - 1, &e);
+    fclose(f);
+    return have && e.wall_base_ms != 0 &&
+           e.wall_base_ms + e.uptime_ms + (uint64_t)age_s * 1000 < now_ms;
+#else
+    (void)age_s;
+    (void)now_ms;
+    (void)pinned;
+    return false;
+#endif
+}
+
+// --------------------
+// Log Positions
+// --------------------
+#if LOG_ROTATE
+#define CURRENT_ID s_last_id
+#else
+#define CURRENT_ID 0
+#endif
+
+#if LOG_INDEX_EVERY > 0
+static void store_index_path(uint8_t ch, uint32_t id, char *out, size_t n)
+{
+    (void)ch;
+#if LOG_ROTATE
+    index_path(out, n, id);
+#else
+    (void)id;
+    snprintf(out, n, "%s", LOG_INDEX_PATH);
+#endif
+}
+#endif
+
+// The store's segments for the log_segment.h helpers
+static void store_segments(log_segments_t *segs)
+{
+    segs->ch = 0;
+#if LOG_ROTATE
+    segs->first_id = s_first_id;
+    segs->last_id = s_last_id;
+    segs->closed_bytes = s_closed_bytes;
+    segs->slots = LOG_RETAIN_SEGMENTS;
+#else
+    segs->first_id = 0;
+    segs->last_id = 0;
+    segs->closed_bytes = NULL;
+    segs->slots = 1;
+#endif
+    segs->app = &s_appender;
+#if LOG_INDEX_EVERY > 0
+    segs->idx = s_idx;
+    segs->index_path = store_index_path;
+#else
+    segs->idx = NULL;
+    segs->index_path = NULL;
+#endif
+}
+
+static uint32_t segment_base(uint32_t id)
+{
+    log_segments_t segs;
+    store_segments(&segs);
+    return log_segment_base(&segs, id);
+}
+
+#if LOG_ROTATE
+// --------------------
+// Retention
+// --------------------
+// File system space a new segment takes: its data plus a cluster of slack for the
+// header, cluster rounding and its index
+#if LOG_SEGMENT_BYTES > 0
+#define SEGMENT_FS_BYTES ((uint64_t)LOG_SEGMENT_BYTES + LOG_APPEND_BUF_BYTES)
+#else
+#define SEGMENT_FS_BYTES ((uint64_t)SEGMENT_DATA_LIMIT + LOG_APPEND_BUF_BYTES)
+#endif
+
+static bool fs_has_room_for_segment(void)
+{
+#if LOG_SEGMENT_BYTES > 0
+    if (s_spare_id != 0) {
+        return true;    // the next segment reuses the spare
+    }
+#endif
+    uint64_t total = 0;
+    uint64_t free_bytes = 0;
+    if (log_mount_info(&total, &free_bytes) != ESP_OK) {
+        return true;    // unknown: let the create fail rather than drop data
+    }
+    return free_bytes >= SEGMENT_FS_BYTES;
+}
+
+#if LOG_TIER_SD
+static void tier_abort(void);
+#endif
+
+// Drop the oldest segment. Manifest first: after a crash the new range is
+// authoritative and a dropped segment is cleaned up at the next open.
+static void drop_oldest(void)
+{
+    const uint32_t dropped = s_first_id++;
+#if LOG_SEGMENT_BYTES > 0 && LOG_TIER_SD
+    const bool in_flash = dropped >= s_hot_id;
+#elif LOG_SEGMENT_BYTES > 0
+    const bool in_flash = true;
+#endif
+    s_dropped += s_closed_bytes[dropped % LOG_RETAIN_SEGMENTS];
+    manifest_write();
+#if LOG_TIER_SD
+    if (s_hot_id < s_first_id) {
+        // A flash segment went before it reached the card
+        tier_abort();
+        s_hot_id = s_first_id;
+    }
+#endif
+#if LOG_SEGMENT_BYTES > 0
+    if (s_spare_id == 0 && in_flash) {
+        // Its clusters become the next segment; only the sidecars go now
+        if (s_rd_file && s_rd_id == dropped) {
+            close_read_handle();
+        }
+#if LOG_INDEX_EVERY > 0
+        char path[sizeof(s_cur_path)];
+        snprintf(path, sizeof(path), LOG_INDEX_PATH_FMT, (unsigned long)dropped);
+        remove(path);
+#endif
+        s_spare_id = dropped;
+        ESP_LOGI(TAG, "retention: segment %lu kept for reuse", (unsigned long)dropped);
+        return;
+    }
+#endif
+    remove_segment(dropped);
+    ESP_LOGI(TAG, "retention: deleted segment %lu", (unsigned long)dropped);
+}
+
+#if LOG_TIER_SD
+// --------------------
+// SD Tier
+// --------------------
+// Partial copy on the card is removed; the flash copy stays live
+static void tier_abort(void)
+{
+    if (s_mig_src) {
+        fclose(s_mig_src);
+        s_mig_src = NULL;
+    }
+    if (s_mig_dst) {
+        fclose(s_mig_dst);
+        s_mig_dst = NULL;
+        remove_cold_files(s_hot_id);
+    }
+#if LOG_TIER_REPLICATE
+    s_mig_bytes = 0;
+#endif
+}
+
+// Data bytes of segment id that are durable in flash
+static uint32_t tier_durable(uint32_t id)
+{
+    if (id == s_last_id) {
+        return s_appender.synced_end - LOG_APPENDER_DATA_START;
+    }
+    return s_closed_bytes[id % LOG_RETAIN_SEGMENTS];
+}
+
+static void tier_fail(const char *what)
+{
+    ESP_LOGW(TAG, "SD tier: %s, segment %lu stays in flash, retry in %u ms", what,
+             (unsigned long)s_hot_id, (unsigned)LOG_TIER_RETRY_MS);
+    tier_abort();
+    s_tier_ok = false;
+    s_tier_retry_us = esp_timer_get_time() + (int64_t)LOG_TIER_RETRY_MS * 1000;
+}
+
+#if LOG_INDEX_EVERY > 0
+// Whole-file copy of a small sidecar (the index)
+static bool tier_copy_file(const char *from, const char *to)
+{
+    FILE *src = fopen(from, "rb");
+    if (!src) {
+        return true;    // no index for this segment
+    }
+    FILE *dst = fopen(to, "wb");
+    bool ok = dst != NULL;
+    size_t n;
+    while (ok && (n = fread(s_tier_buf, 1, sizeof(s_tier_buf), src)) > 0) {
+        ok = fwrite(s_tier_buf, 1, n, dst) == n;
+    }
+    ok = ok && !ferror(src);
+    fclose(src);
+    if (dst) {
+        ok = fflush(dst) == 0 && fsync(fileno(dst)) == 0 && ok;
+        ok = (fclose(dst) == 0) && ok;
+    }
+    return ok;
+}
+#endif
+
+static bool tier_begin(void)
+{
+    char path[sizeof(s_cur_path)];
+    if (!s_tier_ok) {
+        close_read_handle();
+        if (log_mount_tier() != ESP_OK) {
+            tier_fail("no card");
+            return false;
+        }
+        s_tier_ok = true;
+    }
+
+    // The card holds the oldest data: when it is full, its oldest segment goes
+    uint64_t total = 0;
+    uint64_t free_bytes = 0;
+    while (true) {
+        if (esp_vfs_fat_info(LOG_TIER_MOUNT_POINT, &total, &free_bytes) != ESP_OK) {
+            tier_fail("card not readable");
+            return false;
+        }
+        if (free_bytes >= SEGMENT_FS_BYTES) {
+            break;
+        }
+        if (s_first_id == s_hot_id) {
+            tier_fail("card full");
+            return false;
+        }
+        drop_oldest();
+    }
+
+#if LOG_TIER_REPLICATE
+    // Resume from the checkpoint, the synced size of a copy left by an earlier boot or
+    // card. The source is opened by tier_step(): the appender while the segment is open.
+    struct stat st;
+    snprintf(path, sizeof(path), LOG_TIER_SEGMENT_PATH_FMT, (unsigned long)s_hot_id);
+    s_mig_bytes = 0;
+    if (stat(path, &st) == 0 && (uint32_t)st.st_size <= tier_durable(s_hot_id)) {
+        s_mig_bytes = (uint32_t)st.st_size;
+    }
+    s_mig_dst = fopen(path, (s_mig_bytes > 0) ? "ab" : "wb");
+    if (!s_mig_dst) {
+        tier_fail("open failed");
+        return false;
+    }
+    if (s_mig_bytes > 0) {
+        ESP_LOGI(TAG, "SD tier: segment %lu resumes at %lu bytes", (unsigned long)s_hot_id,
+                 (unsigned long)s_mig_bytes);
+    }
+#else
+    snprintf(path, sizeof(path), LOG_SEGMENT_PATH_FMT, (unsigned long)s_hot_id);
+    s_mig_src = fopen(path, "rb");
+    snprintf(path, sizeof(path), LOG_TIER_SEGMENT_PATH_FMT, (unsigned long)s_hot_id);
+    s_mig_dst = fopen(path, "wb");
+    if (!s_mig_src || !s_mig_dst) {
+        tier_fail("open failed");
+        return false;
+    }
+#endif
+    return true;
+}
+
+#if LOG_TIER_REPLICATE
+// Open segment: one LOG_TIER_COPY_BYTES batch of synced data is appended to the card copy
+// and synced, which moves the checkpoint. True while another whole batch is ready.
+static bool tier_replicate(void)
+{
+    if (tier_durable(s_hot_id) < s_mig_bytes + LOG_TIER_COPY_BYTES) {
+        return false;
+    }
+    if (!s_mig_dst) {
+        return tier_begin();
+    }
+    if (log_appender_read(&s_appender, s_mig_bytes, s_tier_buf, LOG_TIER_COPY_BYTES) !=
+        LOG_TIER_COPY_BYTES) {
+        tier_fail("flash read failed");
+        return false;
+    }
+    if (fwrite(s_tier_buf, 1, LOG_TIER_COPY_BYTES, s_mig_dst) != LOG_TIER_COPY_BYTES ||
+        fflush(s_mig_dst) != 0 || fsync(fileno(s_mig_dst)) != 0) {
+        tier_fail("write failed");
+        return false;
+    }
+    s_mig_bytes += LOG_TIER_COPY_BYTES;
+    return tier_durable(s_hot_id) >= s_mig_bytes + LOG_TIER_COPY_BYTES;
+}
+
+// Closed segment: the rest is read from its flash file, from the checkpoint on
+static bool tier_open_source(void)
+{
+    char path[sizeof(s_cur_path)];
+    snprintf(path, sizeof(path), LOG_SEGMENT_PATH_FMT, (unsigned long)s_hot_id);
+    s_mig_src = fopen(path, "rb");
+    if (!s_mig_src || fseek(s_mig_src, (long)s_mig_bytes, SEEK_SET) != 0) {
+        tier_fail("open failed");
+        return false;
+    }
+    return true;
+}
+#endif
+
+// Copy done: the card copy is durable before the flash copy goes, so a crash in
+// between leaves both and the next open repeats the move
+static bool tier_finish(void)
+{
+    const uint32_t id = s_hot_id;
+    bool ok = fflush(s_mig_dst) == 0 && fsync(fileno(s_mig_dst)) == 0;
+    ok = (fclose(s_mig_dst) == 0) && ok;
+    s_mig_dst = NULL;
+    fclose(s_mig_src);
+    s_mig_src = NULL;
+#if LOG_INDEX_EVERY > 0
+    if (ok) {
+        char from[sizeof(s_cur_path)];
+        char to[sizeof(s_cur_path)];
+        snprintf(from, sizeof(from), LOG_INDEX_PATH_FMT, (unsigned long)id);
+        snprintf(to, sizeof(to), LOG_TIER_INDEX_PATH_FMT, (unsigned long)id);
+        ok = tier_copy_file(from, to);
+    }
+#endif
+    if (!ok) {
+        remove_cold_files(id);
+        tier_fail("write failed");
+        return false;
+    }
+
+    // Readers switch to the card copy
+    if (s_rd_file && s_rd_id == id) {
+        close_read_handle();
+    }
+    s_hot_id++;
+#if LOG_TIER_REPLICATE
+    s_mig_bytes = 0;
+#endif
+    remove_hot_files(id);
+    ESP_LOGI(TAG, "segment %lu moved to the SD tier", (unsigned long)id);
+    return true;
+}
+
+// One bounded step of moving the oldest closed flash segment to the card: open, one
+// LOG_TIER_COPY_BYTES chunk, or finish. True while segments are left to move.
+static bool tier_step(void)
+{
+    if (esp_timer_get_time() < s_tier_retry_us) {
+        return false;
+    }
+#if LOG_TIER_REPLICATE
+    if (s_hot_id == s_last_id) {
+        return tier_replicate();
+    }
+#endif
+    if (s_hot_id >= s_last_id) {
+        return false;
+    }
+    if (!s_mig_dst) {
+        return tier_begin();
+    }
+#if LOG_TIER_REPLICATE
+    if (!s_mig_src && !tier_open_source()) {
+        return false;
+    }
+#endif
+    const size_t n = fread(s_tier_buf, 1, sizeof(s_tier_buf), s_mig_src);
+    if (n > 0 && fwrite(s_tier_buf, 1, n, s_mig_dst) != n) {
+        tier_fail("write failed");
+        return false;
+    }
+#if LOG_TIER_REPLICATE
+    s_mig_bytes += (uint32_t)n;
+#endif
+    if (n == sizeof(s_tier_buf)) {
+        return true;
+    }
+    if (ferror(s_mig_src)) {
+        tier_fail("flash read failed");
+        return false;
+    }
+    return tier_finish() && s_hot_id < s_last_id;
+}
+
+// Move the oldest flash segment now, for room in flash. False if none moved.
+static bool tier_move_one(void)
+{
+    const uint32_t id = s_hot_id;
+    while (s_hot_id == id && tier_step()) {
+    }
+    return s_hot_id > id;
+}
+
+// Moves go oldest first, so the first segment found in flash starts the hot tier
+static void tier_open(void)
+{
+    char path[sizeof(s_cur_path)];
+    struct stat st;
+    s_hot_id = s_first_id;
+    while (s_hot_id < s_last_id) {
+        snprintf(path, sizeof(path), LOG_SEGMENT_PATH_FMT, (unsigned long)s_hot_id);
+        if (stat(path, &st) == 0) {
+            break;
+        }
+        s_hot_id++;
+    }
+#if !LOG_TIER_REPLICATE
+    // A move cut short by a reset is repeated (no-op without a card); a replica resumes
+    // from its checkpoint instead (tier_begin())
+    remove_cold_files(s_hot_id);
+#endif
+}
+#endif // LOG_TIER_SD
+
+// Delete the oldest segments while over a limit, one whole file at a time. With
+// starting set, segment s_last_id is about to be created (rotation), else it is open.
+// While pinned only the segment count
+// (s_closed_bytes slots) and free space force a delete; the byte and age limits
+// catch up at the next rotation after the unpin.
+static void retain_segments(bool starting)
+{
+#if LOG_RETAIN_AGE_S > 0
+    const uint64_t now_ms = log_time_now_ms();
+#else
+    const uint64_t now_ms = 0;
+#endif
+#if LOG_TIER_SD
+    // Flash full: closed segments go to the card before anything is deleted
+    while (starting && !fs_has_room_for_segment() && tier_move_one()) {
+    }
+#endif
+    while (s_first_id < s_last_id) {
+        log_segments_t segs;
+        store_segments(&segs);
+        bool drop = false;
+#if LOG_RETAIN_BYTES > 0
+        // A new segment counts as full: it may fill before the next check
+        const uint32_t live = log_segment_base(&segs, s_last_id) +
+                              (starting ? SEGMENT_DATA_LIMIT : current_bytes());
+        drop = live > LOG_RETAIN_BYTES && s_pins == 0;
+#endif
+        drop = drop || log_segment_retire(&segs, LOG_RETAIN_SEGMENTS, LOG_RETAIN_AGE_S, now_ms,
+                                          s_pins > 0);
+        drop = drop || (starting && !fs_has_room_for_segment());
+        if (!drop) {
+            break;
+        }
+        drop_oldest();
+    }
+}
+#endif // LOG_ROTATE
+
+#if LOG_COMPACT
+// A reset during a swap: past the commit point (old segment deleted) the copy takes its
+// place, before it the copy is dropped
+static void rewrite_recover(uint32_t id)
+{
+    char data[sizeof(s_cur_path)];
+    char idx[sizeof(s_cur_path)];
+    char path[sizeof(s_cur_path)];
+    struct stat st;
+    rewrite_paths(id, data, idx, sizeof(data));
+    segment_path(path, sizeof(path), id);
+    if (stat(data, &st) == 0) {
+        if (stat(path, &st) == 0) {
+            rewrite_remove(id);
+            return;
+        }
+        rename(data, path);
+        ESP_LOGW(TAG, "compaction of segment %lu finished at open", (unsigned long)id);
+    }
+    if (stat(idx, &st) == 0) {
+        index_path(path, sizeof(path), id);
+        remove(path);
+        rename(idx, path);
+    }
+}
+#endif
+
+// --------------------
+// Log Store API
+// --------------------
+bool log_store_open(void)
+{
+#if LOG_ROTATE
+    if (!manifest_load()) {
+        manifest_rebuild();
+    }
+    // A crash between manifest update and delete can leave the previous oldest behind,
+    // a crash during a reclaim the newest segments of the cleared range
+    s_reclaim_hi = s_first_id - 1;
+    s_reclaim_lo = s_first_id;
+    while (s_reclaim_lo > 1 && segment_exists(s_reclaim_lo - 1)) {
+        s_reclaim_lo--;
+    }
+#if LOG_TIER_SD
+    tier_open();
+#endif
+    for (uint32_t id = s_first_id; id < s_last_id; id++) {
+        char path[sizeof(s_cur_path)];
+#if LOG_COMPACT
+        rewrite_recover(id);
+#endif
+        segment_path(path, sizeof(path), id);
+        if (!log_appender_probe(path, &s_closed_bytes[id % LOG_RETAIN_SEGMENTS])) {
+            s_closed_bytes[id % LOG_RETAIN_SEGMENTS] = 0;
+        }
+    }
+#if LOG_ZONE_MAP
+    zone_load();
+#endif
+    if (!open_current()) {
+        return false;
+    }
+    retain_segments(false);
+    return true;
+#else
+#if LOG_INDEX_EVERY > 0
+    index_open(LOG_INDEX_PATH, "ab");
+#endif
+    return log_appender_open(&s_appender, LOG_FILE_PATH);
+#endif
+}
+
+bool log_store_append(const void *data, size_t len)
+{
+    log_wear_add_logical(len);
+#if LOG_ROTATE
+    if (log_store_rotate_due(len) && !log_store_rotate()) {
+        return false;
+    }
+    s_cur_records += RECORD_UNITS(len);
+#endif
+#if LOG_SEGMENT_BYTES > 0 && LOG_SEQ_PERSIST == LOG_SEQ_PERSIST_OPTIGA
+    // No record appended from here is numbered above the reservation at this point
+    s_appender.seq_ceiling = log_seq_reserved();
+#endif
+    return log_appender_append(&s_appender, data, len);
+}
+
+bool log_store_index(uint32_t seq, uint32_t uptime_ms, uint32_t epoch_offset,
+                     uint64_t wall_base_ms, uint32_t records)
+{
+#if LOG_INDEX_EVERY > 0
+    if (!s_idx) {
+        return false;
+    }
+
+    bool ok = true;
+    if (s_idx_first || s_idx_records >= LOG_INDEX_EVERY) {
+        const log_segment_entry_t e = {seq, uptime_ms, s_appender.last_offset, epoch_offset,
+                                       wall_base_ms};
+        ok = log_segment_index_write(s_idx, &e);
+        s_idx_records = 0;
+        s_idx_first = false;
+    }
+    s_idx_records += records;
+    return ok;
+#else
+    (void)seq;
+    (void)uptime_ms;
+    (void)epoch_offset;
+    (void)wall_base_ms;
+    (void)records;
+    return true;
+#endif
+}
+
+void log_store_zone_add(const log_zone_t *zone)
+{
+#if LOG_ZONE_MAP
+    log_zone_merge(&s_zone_open, zone);
+#else
+    (void)zone;
+#endif
+}
+
+bool log_store_zone(uint32_t position, log_store_zone_t *out)
+{
+#if LOG_ZONE_MAP
+    uint32_t base = 0;
+    for (uint32_t id = s_first_id; id < s_last_id; id++) {
+        const uint32_t i = id % LOG_RETAIN_SEGMENTS;
+        const uint32_t end = base + s_closed_bytes[i];
+        if (position >= base && position < end) {
+            out->position = base;
+            out->end = end;
+            out->summarised = (s_zone_ids[i] == id);
+            if (out->summarised) {
+                out->zone = s_zones[i];
+            }
+            return true;
+        }
+        base = end;
+    }
+#else
+    (void)position;
+    (void)out;
+#endif
+    return false;
+}
+
+uint32_t log_store_last_offset(void)
+{
+    return s_appender.last_offset;
+}
+
+uint32_t log_store_last_position(void)
+{
+    return segment_base(CURRENT_ID) + s_appender.last_offset - LOG_APPENDER_DATA_START;
+}
+
+uint32_t log_store_file_offset(uint32_t position)
+{
+    const uint32_t base = segment_base(CURRENT_ID);
+    return (position >= base) ? position - base + LOG_APPENDER_DATA_START : INDEX_NO_EPOCH;
+}
+
+bool log_store_seek(log_store_seek_t by, uint32_t value, log_store_entry_t *entry)
+{
+#if LOG_INDEX_EVERY > 0
+    log_segments_t segs;
+    store_segments(&segs);
+    return log_segment_seek(&segs, by, value, entry);
+#else
+    (void)by;
+    (void)value;
+    (void)entry;
+    return false;
+#endif
+}
+
+bool log_store_sync(void)
+{
+    bool ok = log_appender_sync(&s_appender);
+#if LOG_INDEX_EVERY > 0
+    index_sync();
+#endif
+    return ok;
+}
+
+bool log_store_poll(void)
+{
+#if LOG_INDEX_EVERY > 0
+    if (log_appender_poll_delay_ms(&s_appender) == 0) {
+        return log_store_sync();
+    }
+#endif
+    return log_appender_poll(&s_appender);
+}
+
+uint32_t log_store_poll_delay_ms(void)
+{
+    return log_appender_poll_delay_ms(&s_appender);
+}
+
+bool log_store_rotate_due(size_t len)
+{
+#if LOG_ROTATE
+    const uint32_t bytes = current_bytes();
+    if (bytes > 0 && bytes + len > SEGMENT_DATA_LIMIT) {
+        return true;
+    }
+    return LOG_ROTATE_RECORDS > 0 && s_cur_records > 0 &&
+           s_cur_records + RECORD_UNITS(len) > LOG_ROTATE_RECORDS;
+#else
+    (void)len;
+    return false;
+#endif
+}
+
+bool log_store_rotate(void)
+{
+#if LOG_ROTATE
+    log_appender_close(&s_appender);
+#if LOG_INDEX_EVERY > 0
+    index_sync();
+    index_close();
+#endif
+    s_closed_bytes[s_last_id % LOG_RETAIN_SEGMENTS] = current_bytes();
+#if LOG_ZONE_MAP
+    zone_seal();
+#endif
+    s_lost_closed += s_appender.lost;
+    s_syncs_closed += s_appender.syncs;
+
+    s_last_id++;
+    retain_segments(true);
+    manifest_write();
+    LOG_CRASH_POINT(LOG_CRASH_ROTATE);
+
+    // Leftover from before a clear or a lost manifest; the new segment starts empty
+    remove_segment(s_last_id);
+#if LOG_SEGMENT_BYTES > 0
+    if (s_spare_id != 0) {
+        char from[sizeof(s_cur_path)];
+        char to[sizeof(s_cur_path)];
+        snprintf(from, sizeof(from), LOG_SEGMENT_PATH_FMT, (unsigned long)s_spare_id);
+        snprintf(to, sizeof(to), LOG_SEGMENT_PATH_FMT, (unsigned long)s_last_id);
+        if (!log_appender_recycle(from, to)) {
+            log_appender_remove(from);
+        }
+        s_spare_id = 0;
+    }
+#endif
+    if (!open_current()) {
+        return false;
+    }
+    ESP_LOGI(TAG, "rotated to segment %lu (live %lu..%lu)", (unsigned long)s_last_id,
+             (unsigned long)s_first_id, (unsigned long)s_last_id);
+    return true;
+#else
+    return true;
+#endif
+}
+
+bool log_store_clear(void)
+{
+    s_dropped += log_store_size();
+#if LOG_ROTATE
+    log_appender_close(&s_appender);
+    s_lost_closed += s_appender.lost;
+    s_syncs_closed += s_appender.syncs;
+    close_read_handle();
+#if LOG_INDEX_EVERY > 0
+    index_close();
+#endif
+    // The manifest drops the segments at once; ids keep counting up so no name is reused
+    // by a reader. The files go one per log_store_maintain() step, so a long log does
+    // not stall the writer in a run of deletes
+    if (s_reclaim_lo > s_reclaim_hi) {
+        s_reclaim_lo = s_first_id;
+    }
+    s_reclaim_hi = s_last_id;
+#if LOG_TIER_SD
+    tier_abort();
+    s_hot_id = s_last_id + 1;
+#endif
+    s_first_id = s_last_id = s_last_id + 1;
+    manifest_write();
+    remove_segment(s_last_id);
+    return open_current();
+#else
+#if LOG_INDEX_EVERY > 0
+    index_open(LOG_INDEX_PATH, "wb");
+#endif
+    return log_appender_truncate(&s_appender);
+#endif
+}
+
+uint32_t log_store_size(void)
+{
+    uint32_t start = 0;
+    uint32_t end = 0;
+    log_appender_data_range(&s_appender, &start, &end);
+    uint32_t size = (end > start) ? end - start : 0;
+#if LOG_ROTATE
+    for (uint32_t id = s_first_id; id < s_last_id; id++) {
+        size += s_closed_bytes[id % LOG_RETAIN_SEGMENTS];
+    }
+#endif
+    return size;
+}
+
+size_t log_store_read(uint32_t offset, void *buf, size_t len)
+{
+#if LOG_ROTATE
+    // Closed segments first, oldest to newest
+    for (uint32_t id = s_first_id; id < s_last_id; id++) {
+        const uint32_t seg_bytes = s_closed_bytes[id % LOG_RETAIN_SEGMENTS];
+        if (offset >= seg_bytes) {
+            offset -= seg_bytes;
+            continue;
+        }
+
+        if (!s_rd_file || s_rd_id != id) {
+            char path[sizeof(s_cur_path)];
+            close_read_handle();
+            segment_path(path, sizeof(path), id);
+            s_rd_file = fopen(path, "rb");
+            s_rd_id = id;
+            if (!s_rd_file) {
+                return 0;
+            }
+        }
+        if (len > seg_bytes - offset) {
+            len = seg_bytes - offset;
+        }
+        if (fseek(s_rd_file, (long)(LOG_APPENDER_DATA_START + offset), SEEK_SET) != 0) {
+            return 0;
+        }
+        return fread(buf, 1, len, s_rd_file);
+    }
+#endif
+    return log_appender_read(&s_appender, offset, buf, len);
+}
+
+// Segments are files: readers copy through log_store_read()
+const void *log_store_view(log_store_map_t *map, uint32_t offset, size_t *len)
+{
+    *len = 0;
+    return NULL;
+}
+
+void log_store_unmap(log_store_map_t *map)
+{
+}
+
+uint32_t log_store_dropped(void)
+{
+    return s_dropped;
+}
+
+bool log_store_maintain(void)
+{
+#if LOG_ROTATE
+    if (s_reclaim_lo > s_reclaim_hi) {
+#if LOG_TIER_SD
+        return tier_step();
+#else
+        return false;
+#endif
+    }
+    remove_segment(s_reclaim_lo++);
+    if (s_reclaim_lo > s_reclaim_hi) {
+        ESP_LOGI(TAG, "clear: old segments deleted");
+#if LOG_TIER_SD
+        return s_hot_id < s_last_id;
+#else
+        return false;
+#endif
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint32_t log_store_maint_pending(void)
+{
+#if LOG_ROTATE
+    uint32_t pending = (s_reclaim_lo <= s_reclaim_hi) ? s_reclaim_hi - s_reclaim_lo + 1 : 0;
+#if LOG_TIER_SD
+    pending += s_last_id - s_hot_id;    // closed segments still in flash
+#endif
+#if LOG_TIER_REPLICATE
+    // A whole batch of the open segment is ready for the card
+    if (s_hot_id == s_last_id && tier_durable(s_hot_id) >= s_mig_bytes + LOG_TIER_COPY_BYTES) {
+        pending++;
+    }
+#endif
+    return pending;
+#else
+    return 0;
+#endif
+}
+
+bool log_store_segment_next(uint32_t id, log_store_segment_t *seg)
+{
+#if LOG_ROTATE
+    if (id < s_first_id) {
+        id = s_first_id;
+    }
+    if (id >= s_last_id) {
+        return false;
+    }
+    seg->id = id;
+    seg->bytes = s_closed_bytes[id % LOG_RETAIN_SEGMENTS];
+    return true;
+#else
+    (void)id;
+    (void)seg;
+    return false;
+#endif
+}
+
+size_t log_store_segment_read(uint32_t id, uint32_t offset, void *buf, size_t len)
+{
+#if LOG_ROTATE
+    const uint32_t bytes = s_closed_bytes[id % LOG_RETAIN_SEGMENTS];
+    if (id < s_first_id || id >= s_last_id || offset >= bytes) {
+        return 0;
+    }
+    if (len > bytes - offset) {
+        len = bytes - offset;
+    }
+    return log_store_read(segment_base(id) + offset, buf, len);
+#else
+    (void)id;
+    (void)offset;
+    (void)buf;
+    (void)len;
+    return 0;
+#endif
+}
+
+bool log_store_rewrite_begin(uint32_t id)
+{
+#if LOG_COMPACT
+    if (s_rw_id != 0) {
+        rewrite_remove(s_rw_id);
+    }
+    if (id < s_first_id || id >= s_last_id) {
+        return false;
+    }
+    // The old segment stays until the swap: room for a copy as large
+    uint64_t total = 0;
+    uint64_t free_bytes = 0;
+    if (log_mount_info(&total, &free_bytes) == ESP_OK &&
+        free_bytes < (uint64_t)s_closed_bytes[id % LOG_RETAIN_SEGMENTS] + SEGMENT_FS_BYTES) {
+        return false;
+    }
+    char data[sizeof(s_cur_path)];
+    char idx[sizeof(s_cur_path)];
+    rewrite_paths(id, data, idx, sizeof(data));
+    s_rw_id = id;
+    // Data file first, see rewrite_remove()
+    s_rw_data = fopen(data, "wb");
+    s_rw_idx = s_rw_data ? fopen(idx, "wb") : NULL;
+    log_segments_t segs;
+    store_segments(&segs);
+    s_rw_old_idx = log_segment_index_open(&segs, id, &s_rw_old_count);
+    if (!s_rw_data || !s_rw_idx) {
+        ESP_LOGW(TAG, "failed to create compacted copy of segment %lu", (unsigned long)id);
+        rewrite_remove(id);
+        return false;
+    }
+    s_rw_old_count = s_rw_old_idx ? s_rw_old_count : 0;
+    s_rw_next = 0;
+    s_rw_bytes = 0;
+    s_rw_hdr_old = INDEX_NO_EPOCH;
+    s_rw_hdr_new = INDEX_NO_EPOCH;
+    return true;
+#else
+    (void)id;
+    return false;
+#endif
+}
+
+uint32_t log_store_rewrite_mark(uint32_t offset)
+{
+#if LOG_COMPACT
+    log_segment_entry_t e;
+    for (uint32_t i = s_rw_next; i < s_rw_old_count; i++) {
+        if (log_segment_index_read(s_rw_old_idx, i, &e) &&
+            e.offset - LOG_APPENDER_DATA_START >= offset) {
+            return e.offset - LOG_APPENDER_DATA_START;
+        }
+    }
+#else
+    (void)offset;
+#endif
+    return UINT32_MAX;
+}
+
+bool log_store_rewrite_append(const void *data, size_t len, uint32_t old_offset, bool header)
+{
+#if LOG_COMPACT
+    if (s_rw_id == 0) {
+        return false;
+    }
+    const uint32_t new_offset = LOG_APPENDER_DATA_START + s_rw_bytes;
+    old_offset += LOG_APPENDER_DATA_START;
+    if (header) {
+        s_rw_hdr_old = old_offset;
+        s_rw_hdr_new = new_offset;
+    }
+    // Entries of the data this unit replaces: the one at its start moves with it, any
+    // inside it (the caller did not cut there) are dropped
+    log_segment_entry_t e;
+    bool ok = true;
+    while (ok && s_rw_next < s_rw_old_count && log_segment_index_read(s_rw_old_idx, s_rw_next, &e) &&
+           e.offset <= old_offset) {
+        s_rw_next++;
+        if (e.offset != old_offset) {
+            continue;
+        }
+        e.epoch_offset = (e.epoch_offset == s_rw_hdr_old) ? s_rw_hdr_new : INDEX_NO_EPOCH;
+        e.offset = new_offset;
+        ok = log_segment_index_write(s_rw_idx, &e);
+    }
+    ok = ok && fwrite(data, 1, len, s_rw_data) == len;
+    s_rw_bytes += (uint32_t)len;
+    return ok;
+#else
+    (void)data;
+    (void)len;
+    (void)old_offset;
+    (void)header;
+    return false;
+#endif
+}
+
+bool log_store_rewrite_commit(void)
+{
+#if LOG_COMPACT
+    const uint32_t id = s_rw_id;
+    if (id == 0) {
+        return false;
+    }
+    // Offsets behind the segment move: not under a snapshot reader
+    bool ok = id >= s_first_id && id < s_last_id && s_pins == 0;
+    ok = ok && fflush(s_rw_data) == 0 && fsync(fileno(s_rw_data)) == 0;
+    ok = ok && fflush(s_rw_idx) == 0 && fsync(fileno(s_rw_idx)) == 0;
+    if (!ok) {
+        rewrite_remove(id);
+        return false;
+    }
+    rewrite_close();
+    s_rw_id = 0;
+    if (s_rd_file && s_rd_id == id) {
+        close_read_handle();
+    }
+
+    char data[sizeof(s_cur_path)];
+    char idx[sizeof(s_cur_path)];
+    char path[sizeof(s_cur_path)];
+    rewrite_paths(id, data, idx, sizeof(data));
+    segment_path(path, sizeof(path), id);
+    // Commit point: once the old segment is gone, a reset finishes the swap at open
+    if (remove(path) != 0) {
+        rewrite_remove(id);
+        return false;
+    }
+    LOG_CRASH_POINT(LOG_CRASH_COMPACT);
+    const bool renamed = rename(data, path) == 0;
+    index_path(path, sizeof(path), id);
+    remove(path);
+    if (rename(idx, path) != 0 || !renamed) {
+        ESP_LOGE(TAG, "compaction of segment %lu: rename failed, finished at the next open",
+                 (unsigned long)id);
+    }
+    ESP_LOGI(TAG, "compacted segment %lu: %lu -> %lu bytes", (unsigned long)id,
+             (unsigned long)s_closed_bytes[id % LOG_RETAIN_SEGMENTS], (unsigned long)s_rw_bytes);
+    s_closed_bytes[id % LOG_RETAIN_SEGMENTS] = s_rw_bytes;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void log_store_rewrite_abort(void)
+{
+#if LOG_COMPACT
+    if (s_rw_id != 0) {
+        rewrite_remove(s_rw_id);
+    }
+#endif
+}
+
+void log_store_pin(bool pin)
+{
+#if LOG_ROTATE
+    if (pin) {
+        s_pins++;
+    } else if (s_pins > 0) {
+        s_pins--;
+    }
+#else
+    (void)pin;
+#endif
+}
+
+bool log_store_replica(log_store_replica_t *replica)
+{
+    memset(replica, 0, sizeof(*replica));
+#if LOG_TIER_SD
+    for (uint32_t id = s_hot_id; id <= s_last_id; id++) {
+        replica->lag_bytes += tier_durable(id);
+    }
+    replica->segment = s_hot_id;
+#if LOG_TIER_REPLICATE
+    // Without replication a segment's card copy is synced only once it is complete
+    replica->offset = s_mig_bytes;
+    replica->lag_bytes -= s_mig_bytes;
+#endif
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint32_t log_store_lost(void)
+{
+#if LOG_ROTATE
+    return s_lost_closed + s_appender.lost;
+#else
+    return s_appender.lost;
+#endif
+}
+
+uint32_t log_store_syncs(void)
+{
+#if LOG_ROTATE
+    return s_syncs_closed + s_appender.syncs;
+#else
+    return s_appender.syncs;
+#endif
+}
+
+bool log_store_wear(uint32_t *min_erases, uint32_t *max_erases)
+{
+    *min_erases = 0;
+    *max_erases = 0;
+    return false;
+}
+
+uint32_t log_store_inline_erases(void)
+{
+    return 0;
+}
+
+uint32_t log_store_free(void)
+{
+    uint64_t total = 0;
+    uint64_t free_bytes = 0;
+    if (log_mount_info(&total, &free_bytes) != ESP_OK) {
+        free_bytes = 0;
+    }
+#if LOG_TIER_SD
+    // Flash is emptied onto the card, so both count
+    uint64_t cold_total = 0;
+    uint64_t cold_free = 0;
+    if (s_tier_ok && esp_vfs_fat_info(LOG_TIER_MOUNT_POINT, &cold_total, &cold_free) == ESP_OK) {
+        free_bytes += cold_free;
+    }
+#endif
+#if LOG_SEGMENT_BYTES > 0
+    // The preallocated file takes no more file system space as it fills
+    uint32_t start = 0;
+    uint32_t end = 0;
+    log_appender_data_range(&s_appender, &start, &end);
+    end += (uint32_t)s_appender.used;
+    if (end < LOG_SEGMENT_BYTES) {
+        free_bytes += LOG_SEGMENT_BYTES - end;
+    }
+#endif
+    return (free_bytes > UINT32_MAX) ? UINT32_MAX : (uint32_t)free_bytes;
+}
+
+#endif // !LOG_STORAGE_RAW
@@ -0,0 +1,1020 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Append-only log written straight to the flash partition (no FATFS).
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_store_raw.c
+ * @brief   Raw partition log store
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    The partition is used as a ring of erase sectors. Pages are filled in
+ *          RAM and programmed once, in order; a sector is erased just before its
+ *          first page is programmed, so every sector is erased once per lap and
+ *          the oldest sector is dropped when the ring is full (or, with
+ *          LOG_RETAIN_BYTES, erased as soon as the live data exceeds the cap). At
+ *          boot the write position is recovered from the page sequence numbers.
+ *          Erases are counted per sector and saved to NVS now and then
+ *          (LOG_RAW_WEAR_SAVE_ERASES).
+ *          Readers go through windows mapped with esp_partition_mmap()
+ *          (LOG_RAW_MMAP); flash writes and erases keep the cache coherent.
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include "log_store.h"
+
+#if LOG_STORAGE_RAW
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#if LOG_RAW_WEAR_SAVE_ERASES > 0
+#include "nvs.h"
+#include "log_nvs.h"
+#endif
+
+#include "optiga/pal/pal_sysview.h"
+
+#include "log_crash.h"
+#include "log_wear.h"
+
+#if (RAW_SECTOR_BYTES % RAW_PAGE_BYTES) != 0 || RAW_PAGE_PAYLOAD_BYTES > 255
+#error "raw log page must divide the sector and carry at most 255 payload bytes"
+#endif
+
+#define PAGES_PER_SECTOR (RAW_SECTOR_BYTES / RAW_PAGE_BYTES)
+
+// Page holds the tail of an append started on the previous page
+#define RAW_PAGE_FLAG_CONT 0x02
+
+#define WEAR_NAMESPACE  "enc_log"
+#define WEAR_KEY        "raw_wear"
+
+typedef struct {
+    uint8_t flags;
+    uint8_t len;
+    uint32_t seq;
+} raw_page_info_t;
+
+typedef struct {
+    const esp_partition_t *part;
+    uint32_t pages;             // page slots in the partition
+    uint32_t head_page;         // next slot to program
+    uint32_t next_seq;          // sequence number of the next programmed page
+    uint32_t start_page;        // first slot of the live log
+    uint32_t start_seq;         // sequence number of that page
+    bool empty;                 // nothing programmed since boot on a blank ring or clear
+    uint32_t size;              // payload bytes in programmed live pages
+    uint8_t page[RAW_PAGE_BYTES];   // page being filled (header + payload)
+    size_t used;                // payload bytes in page
+    uint32_t page_appends;      // appends that end in page
+    bool start_pending;         // next page gets RAW_PAGE_FLAG_START
+    bool cont_pending;          // next page gets RAW_PAGE_FLAG_CONT
+    uint32_t unsynced;          // appends waiting in page
+    int64_t unsynced_since_us;  // time of the oldest of them
+    uint32_t lost;              // appends lost to failed programs
+    uint32_t programs;          // pages programmed since boot
+    uint32_t inline_erases;     // sector erases in program_page(): pool sector not ready
+    bool preerase_stalled;      // a pool erase failed: retried after the next program
+    uint32_t dropped;           // payload bytes dropped from the front since boot
+    uint32_t pins;              // log_store_pin() depth: retention waits
+    uint32_t last_position;     // log offset at which the last append starts
+    uint32_t rd_page;           // read cursor: slot ...
+    uint32_t rd_offset;         // ... and the log offset of its first payload byte
+    bool rd_valid;
+    log_store_map_t rd_map;     // window of log_store_read()
+} raw_store_t;
+
+static const char *TAG = "LOG_RAW";
+static raw_store_t s_raw;
+static uint8_t s_scan[RAW_PAGE_BYTES];  // page read back by page_load()
+
+// Sectors erased this boot and not programmed since (retention): the ring skips their erase
+static uint8_t s_blank[(LOG_RAW_WEAR_SECTORS + 7) / 8];
+#if LOG_RAW_WEAR_SAVE_ERASES > 0
+static uint32_t s_wear[LOG_RAW_WEAR_SECTORS];  // erases per sector
+static uint32_t s_wear_sectors = 0;            // sectors tracked in s_wear
+static uint32_t s_wear_unsaved = 0;            // erases since the last NVS save
+#endif
+
+// --------------------
+// Page Helpers
+// --------------------
+static uint32_t next_page(uint32_t page)
+{
+    return (page + 1 < s_raw.pages) ? page + 1 : 0;
+}
+
+// CRC over the header fields before the CRC itself, then the payload
+static uint32_t page_crc(const uint8_t *page, uint8_t len)
+{
+    uint32_t crc = esp_rom_crc32_le(0, page, 8);
+    return esp_rom_crc32_le(crc, page + RAW_PAGE_HDR_BYTES, len);
+}
+
+// Header and CRC check of a page image. False for erased, torn or foreign pages.
+static bool page_check(const uint8_t *page, raw_page_info_t *info)
+{
+    if (page[0] != RAW_PAGE_MAGIC0 || page[1] != RAW_PAGE_MAGIC1 ||
+        page[3] > RAW_PAGE_PAYLOAD_BYTES) {
+        return false;
+    }
+
+    const uint32_t crc = (uint32_t)page[8] | ((uint32_t)page[9] << 8) |
+                         ((uint32_t)page[10] << 16) | ((uint32_t)page[11] << 24);
+    if (crc != page_crc(page, page[3])) {
+        return false;
+    }
+    info->flags = page[2];
+    info->len = page[3];
+    info->seq = (uint32_t)page[4] | ((uint32_t)page[5] << 8) |
+                ((uint32_t)page[6] << 16) | ((uint32_t)page[7] << 24);
+    return true;
+}
+
+// Read a page slot into s_scan. False for erased, torn or foreign pages.
+static bool page_load(uint32_t page, raw_page_info_t *info)
+{
+    if (esp_partition_read(s_raw.part, (size_t)page * RAW_PAGE_BYTES, s_scan,
+                           RAW_PAGE_BYTES) != ESP_OK) {
+        return false;
+    }
+    return page_check(s_scan, info);
+}
+
+#if LOG_RAW_MMAP
+#define MAP_WINDOW_PAGES (LOG_RAW_MAP_WINDOW_BYTES / RAW_PAGE_BYTES)
+
+// Page slot in map, moving the window when the slot is outside it
+static const uint8_t *page_map(log_store_map_t *map, uint32_t page)
+{
+    if (map->pages == 0 || page < map->first_page || page - map->first_page >= map->pages) {
+        log_store_unmap(map);
+        const uint32_t first = page - page % MAP_WINDOW_PAGES;
+        const uint32_t pages = (s_raw.pages - first < MAP_WINDOW_PAGES) ? s_raw.pages - first
+                                                                         : MAP_WINDOW_PAGES;
+        const void *base;
+        esp_partition_mmap_handle_t handle;
+        if (esp_partition_mmap(s_raw.part, (size_t)first * RAW_PAGE_BYTES,
+                               (size_t)pages * RAW_PAGE_BYTES, ESP_PARTITION_MMAP_DATA, &base,
+                               &handle) != ESP_OK) {
+            ESP_LOGW(TAG, "mmap of pages %lu+%lu failed", (unsigned long)first,
+                     (unsigned long)pages);
+            return NULL;
+        }
+        map->handle = (uint32_t)handle;
+        map->base = (const uint8_t *)base;
+        map->first_page = first;
+        map->pages = pages;
+    }
+    return map->base + (size_t)(page - map->first_page) * RAW_PAGE_BYTES;
+}
+#endif
+
+// Page slot for a reader: in place through map (LOG_RAW_MMAP), else read into s_scan
+static const uint8_t *page_read(log_store_map_t *map, uint32_t page, raw_page_info_t *info)
+{
+#if LOG_RAW_MMAP
+    const uint8_t *p = page_map(map, page);
+    return (p != NULL && page_check(p, info)) ? p : NULL;
+#else
+    return page_load(page, info) ? s_scan : NULL;
+#endif
+}
+
+// Programmed since the last clear and not yet dropped by the ring
+static bool page_live(const raw_page_info_t *info)
+{
+    return (int32_t)(info->seq - s_raw.start_seq) >= 0 &&
+           (int32_t)(s_raw.next_seq - info->seq) > 0;
+}
+
+static bool page_erased(uint32_t page)
+{
+    if (esp_partition_read(s_raw.part, (size_t)page * RAW_PAGE_BYTES, s_scan,
+                           RAW_PAGE_BYTES) != ESP_OK) {
+        return false;
+    }
+    for (size_t i = 0; i < RAW_PAGE_BYTES; i++) {
+        if (s_scan[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Move start_page past pages that do not begin an append.
+static void skip_cont_pages(void)
+{
+    raw_page_info_t info;
+    while (s_raw.start_page != s_raw.head_page && page_load(s_raw.start_page, &info) &&
+           page_live(&info) && (info.flags & RAW_PAGE_FLAG_CONT)) {
+        s_raw.size -= info.len;
+        s_raw.start_page = next_page(s_raw.start_page);
+        s_raw.start_seq = info.seq + 1;
+    }
+}
+
+// --------------------
+// Sector Wear
+// --------------------
+static bool sector_blank(uint32_t sector)
+{
+    return sector < LOG_RAW_WEAR_SECTORS && (s_blank[sector / 8] & (1u << (sector % 8)));
+}
+
+static void sector_set_blank(uint32_t sector, bool blank)
+{
+    if (sector < LOG_RAW_WEAR_SECTORS) {
+        if (blank) {
+            s_blank[sector / 8] |= (uint8_t)(1u << (sector % 8));
+        } else {
+            s_blank[sector / 8] &= (uint8_t)~(1u << (sector % 8));
+        }
+    }
+}
+
+#if LOG_RAW_WEAR_SAVE_ERASES > 0
+// Counts of an earlier boot; they start at zero when the partition changed size
+static void wear_load(void)
+{
+    nvs_handle_t handle;
+    const uint32_t sectors = s_raw.pages / PAGES_PER_SECTOR;
+    s_wear_sectors = (sectors < LOG_RAW_WEAR_SECTORS) ? sectors : LOG_RAW_WEAR_SECTORS;
+    memset(s_wear, 0, sizeof(s_wear));
+    s_wear_unsaved = 0;
+    if (sectors > LOG_RAW_WEAR_SECTORS) {
+        ESP_LOGW(TAG, "erase counts kept for the first %u of %u sectors",
+                 (unsigned)LOG_RAW_WEAR_SECTORS, (unsigned)sectors);
+    }
+    if (!log_nvs_open(WEAR_NAMESPACE, &handle)) {
+        return;
+    }
+    size_t len = s_wear_sectors * sizeof(s_wear[0]);
+    if (nvs_get_blob(handle, WEAR_KEY, s_wear, &len) != ESP_OK ||
+        len != s_wear_sectors * sizeof(s_wear[0])) {
+        memset(s_wear, 0, sizeof(s_wear));
+    }
+    nvs_close(handle);
+}
+
+static void wear_save(void)
+{
+    nvs_handle_t handle;
+    s_wear_unsaved = 0;     // also on failure: retried LOG_RAW_WEAR_SAVE_ERASES later
+    if (!log_nvs_open(WEAR_NAMESPACE, &handle)) {
+        return;
+    }
+    if (nvs_set_blob(handle, WEAR_KEY, s_wear, s_wear_sectors * sizeof(s_wear[0])) != ESP_OK ||
+        nvs_commit(handle) != ESP_OK) {
+        ESP_LOGW(TAG, "erase counts not saved");
+    }
+    nvs_close(handle);
+}
+#endif
+
+// Erase one sector and count it
+static bool sector_erase(uint32_t sector)
+{
+    if (esp_partition_erase_range(s_raw.part, (size_t)sector * RAW_SECTOR_BYTES,
+                                  RAW_SECTOR_BYTES) != ESP_OK) {
+        sector_set_blank(sector, false);
+        return false;
+    }
+    sector_set_blank(sector, true);
+#if LOG_RAW_WEAR_SAVE_ERASES > 0
+    if (sector < s_wear_sectors) {
+        s_wear[sector]++;
+        if (++s_wear_unsaved >= LOG_RAW_WEAR_SAVE_ERASES) {
+            wear_save();
+        }
+    }
+#endif
+    return true;
+}
+
+// The ring has come round to the oldest sector: forget it before it is erased.
+static void drop_oldest_sector(void)
+{
+    const uint32_t first = (s_raw.start_page / PAGES_PER_SECTOR) * PAGES_PER_SECTOR;
+    const uint32_t size = s_raw.size;
+    raw_page_info_t info;
+    for (uint32_t i = 0; i < PAGES_PER_SECTOR; i++) {
+        if (page_load(first + i, &info) && page_live(&info)) {
+            s_raw.size -= info.len;
+        }
+    }
+
+    s_raw.start_page = (first + PAGES_PER_SECTOR) % s_raw.pages;
+    s_raw.start_seq = page_load(s_raw.start_page, &info) ? info.seq : s_raw.next_seq;
+    skip_cont_pages();
+    s_raw.dropped += size - s_raw.size;
+    // Offsets are relative to the oldest byte, which just moved
+    s_raw.rd_valid = false;
+}
+
+#if LOG_RETAIN_BYTES > 0
+// The live pages hold more than LOG_RETAIN_BYTES and the oldest sector is not the one
+// of slot (just programmed). Waits while pinned; only the ring wrap then drops data.
+static bool retain_due(uint32_t slot)
+{
+    return s_raw.pins == 0 && s_raw.size > LOG_RETAIN_BYTES &&
+           s_raw.start_page / PAGES_PER_SECTOR != slot / PAGES_PER_SECTOR;
+}
+
+// Erase the oldest sector. The erase is what makes the drop persistent: the boot scan
+// stops at an erased sector. One per call: a cap far below the live size (lowered
+// between boots) is worked off by log_store_maintain() instead of one long erase run.
+static void retain_sector(void)
+{
+    const uint32_t sector = s_raw.start_page / PAGES_PER_SECTOR;
+    drop_oldest_sector();
+    if (!sector_erase(sector)) {
+        ESP_LOGW(TAG, "retention erase failed at sector %u", (unsigned)sector);
+    }
+}
+
+// Slot of the last programmed page
+static uint32_t last_slot(void)
+{
+    return (s_raw.head_page + s_raw.pages - 1) % s_raw.pages;
+}
+#endif
+
+#if LOG_RAW_PREERASE_SECTORS > 0
+// --------------------
+// Pre-erase
+// --------------------
+// Pool sectors still to erase, in write order from the first sector the head has not
+// started; *next is the first of them. The pool never reaches the sector of the last
+// programmed page. The live range ends at the head, so the first live pool sector is the
+// oldest: it is dropped before its erase, or, while pinned, it and the rest wait.
+static uint32_t preerase_scan(uint32_t *next)
+{
+    const uint32_t sectors = s_raw.pages / PAGES_PER_SECTOR;
+    const uint32_t pool = (LOG_RAW_PREERASE_SECTORS < sectors - 1) ? LOG_RAW_PREERASE_SECTORS
+                                                                   : sectors - 1;
+    uint32_t sector = ((s_raw.head_page + PAGES_PER_SECTOR - 1) / PAGES_PER_SECTOR) % sectors;
+    uint32_t count = 0;
+    for (uint32_t k = 0; k < pool; k++, sector = (sector + 1) % sectors) {
+        // No blank bit past LOG_RAW_WEAR_SECTORS: the erase would be repeated inline
+        if (sector >= LOG_RAW_WEAR_SECTORS || sector_blank(sector)) {
+            continue;
+        }
+        if (!s_raw.empty && sector == s_raw.start_page / PAGES_PER_SECTOR && s_raw.pins > 0) {
+            break;
+        }
+        if (count++ == 0) {
+            *next = sector;
+        }
+    }
+    return count;
+}
+
+// One pool sector per call: an erase blocks the caller for tens of ms
+static void preerase_step(void)
+{
+    uint32_t sector;
+    if (s_raw.preerase_stalled || preerase_scan(&sector) == 0) {
+        return;
+    }
+    if (!s_raw.empty && sector == s_raw.start_page / PAGES_PER_SECTOR) {
+        drop_oldest_sector();
+    }
+    if (!sector_erase(sector)) {
+        ESP_LOGW(TAG, "pre-erase failed at sector %u", (unsigned)sector);
+        s_raw.preerase_stalled = true;
+    }
+}
+
+// The blank bits do not survive a reset: take pool sectors that read back erased
+static void preerase_recover(void)
+{
+    uint32_t sector;
+    while (preerase_scan(&sector) > 0) {
+        for (uint32_t i = 0; i < PAGES_PER_SECTOR; i++) {
+            if (!page_erased(sector * PAGES_PER_SECTOR + i)) {
+                return;
+            }
+        }
+        sector_set_blank(sector, true);
+    }
+}
+#endif
+
+// Program the RAM page into the head slot and start a new one.
+static bool program_page(void)
+{
+    const uint32_t slot = s_raw.head_page;
+    bool ok = true;
+
+    // Erase and program, the raw store counterpart of a FAT write
+    PAL_SYSVIEW_START(PAL_SYSVIEW_MARK_LOG_WRITE);
+    const uint32_t sector = slot / PAGES_PER_SECTOR;
+    if ((slot % PAGES_PER_SECTOR) == 0) {
+        if (!s_raw.empty && sector == s_raw.start_page / PAGES_PER_SECTOR) {
+            drop_oldest_sector();
+        }
+        // Retention or the pre-erase pool already erased it: a second erase would only
+        // add wear
+        if (!sector_blank(sector)) {
+            s_raw.inline_erases++;
+            ok = sector_erase(sector);
+        }
+        LOG_CRASH_POINT(LOG_CRASH_ROTATE);
+    }
+    sector_set_blank(sector, false);
+
+    uint8_t *p = s_raw.page;
+    p[0] = RAW_PAGE_MAGIC0;
+    p[1] = RAW_PAGE_MAGIC1;
+    p[2] = (uint8_t)((s_raw.start_pending ? RAW_PAGE_FLAG_START : 0) |
+                     (s_raw.cont_pending ? RAW_PAGE_FLAG_CONT : 0));
+    p[3] = (uint8_t)s_raw.used;
+    for (int i = 0; i < 4; i++) {
+        p[4 + i] = (uint8_t)(s_raw.next_seq >> (8 * i));
+    }
+    const uint32_t crc = page_crc(p, p[3]);
+    for (int i = 0; i < 4; i++) {
+        p[8 + i] = (uint8_t)(crc >> (8 * i));
+    }
+    // Whole page program; the unused tail stays erased
+    memset(p + RAW_PAGE_HDR_BYTES + s_raw.used, 0xFF, RAW_PAGE_PAYLOAD_BYTES - s_raw.used);
+
+    ok = ok && esp_partition_write(s_raw.part, (size_t)slot * RAW_PAGE_BYTES, p,
+                                   RAW_PAGE_BYTES) == ESP_OK;
+    PAL_SYSVIEW_STOP(PAL_SYSVIEW_MARK_LOG_WRITE);
+
+    // A failed program may leave the slot half written, so never reuse it
+    s_raw.head_page = next_page(slot);
+    if (ok) {
+        if (s_raw.empty) {
+            s_raw.start_page = slot;
+            s_raw.start_seq = s_raw.next_seq;
+            s_raw.empty = false;
+        }
+        s_raw.next_seq++;
+        s_raw.programs++;
+        s_raw.size += (uint32_t)s_raw.used;
+        s_raw.start_pending = false;
+        s_raw.preerase_stalled = false;
+#if LOG_RETAIN_BYTES > 0
+        if (retain_due(slot)) {
+            retain_sector();
+        }
+#endif
+    } else {
+        ESP_LOGE(TAG, "page program failed at slot %u", (unsigned)slot);
+        s_raw.lost += s_raw.page_appends;
+    }
+    s_raw.cont_pending = false;
+    s_raw.used = 0;
+    s_raw.page_appends = 0;
+    return ok;
+}
+
+// --------------------
+// Boot Recovery
+// --------------------
+static void recover(void)
+{
+    const uint32_t sectors = s_raw.pages / PAGES_PER_SECTOR;
+    raw_page_info_t info;
+
+    // Head sector: the one whose first page has the newest sequence number
+    bool found = false;
+    uint32_t head_sector = 0;
+    uint32_t head_seq = 0;
+    for (uint32_t s = 0; s < sectors; s++) {
+        if (page_load(s * PAGES_PER_SECTOR, &info) &&
+            (!found || (int32_t)(info.seq - head_seq) > 0)) {
+            found = true;
+            head_sector = s;
+            head_seq = info.seq;
+        }
+    }
+    if (!found) {
+        ESP_LOGI(TAG, "no log found, starting a new one");
+        s_raw.next_seq = 1;
+        s_raw.start_seq = 1;
+        s_raw.empty = true;
+        return;
+    }
+
+    // Oldest sector: walk back while sequence numbers keep decreasing, stopping at a clear
+    page_load(head_sector * PAGES_PER_SECTOR, &info);
+    uint32_t start_sector = head_sector;
+    uint32_t start_seq = head_seq;
+    uint8_t start_flags = info.flags;
+    for (uint32_t n = 1; n < sectors && !(start_flags & RAW_PAGE_FLAG_START); n++) {
+        const uint32_t prev = (start_sector + sectors - 1) % sectors;
+        if (!page_load(prev * PAGES_PER_SECTOR, &info) ||
+            (int32_t)(start_seq - info.seq) <= 0) {
+            break;
+        }
+        start_sector = prev;
+        start_seq = info.seq;
+        start_flags = info.flags;
+    }
+
+    // Write position: after the last good page of the head sector, past any torn slot
+    uint32_t last = head_sector * PAGES_PER_SECTOR;
+    uint32_t last_seq = head_seq;
+    for (uint32_t i = 1; i < PAGES_PER_SECTOR; i++) {
+        const uint32_t slot = head_sector * PAGES_PER_SECTOR + i;
+        if (page_load(slot, &info) && (int32_t)(info.seq - last_seq) > 0) {
+            last = slot;
+            last_seq = info.seq;
+        }
+    }
+    s_raw.head_page = next_page(last);
+    while ((s_raw.head_page % PAGES_PER_SECTOR) != 0 && !page_erased(s_raw.head_page)) {
+        s_raw.head_page = next_page(s_raw.head_page);
+    }
+    s_raw.next_seq = last_seq + 1;
+
+    s_raw.start_page = start_sector * PAGES_PER_SECTOR;
+    s_raw.start_seq = start_seq;
+    s_raw.empty = false;
+    s_raw.size = 0;
+    for (uint32_t slot = s_raw.start_page; slot != s_raw.head_page; slot = next_page(slot)) {
+        if (page_load(slot, &info) && page_live(&info)) {
+            s_raw.size += info.len;
+        }
+    }
+    skip_cont_pages();
+
+    ESP_LOGI(TAG, "recovered %u bytes, next page seq %u", (unsigned)s_raw.size,
+             (unsigned)s_raw.next_seq);
+}
+
+// --------------------
+// Log Store API
+// --------------------
+bool log_store_open(void)
+{
+    memset(&s_raw, 0, sizeof(s_raw));
+    s_raw.part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                          LOG_RAW_PARTITION_LABEL);
+    if (s_raw.part == NULL) {
+        ESP_LOGE(TAG, "partition '%s' not found", LOG_RAW_PARTITION_LABEL);
+        return false;
+    }
+    if (s_raw.part->size < 2 * RAW_SECTOR_BYTES) {
+        ESP_LOGE(TAG, "partition '%s' too small", LOG_RAW_PARTITION_LABEL);
+        s_raw.part = NULL;
+        return false;
+    }
+    // Whole sectors only
+    s_raw.pages = (s_raw.part->size / RAW_SECTOR_BYTES) * PAGES_PER_SECTOR;
+
+    const int64_t t0 = esp_timer_get_time();
+    memset(s_blank, 0, sizeof(s_blank));
+#if LOG_RAW_WEAR_SAVE_ERASES > 0
+    wear_load();
+#endif
+    recover();
+#if LOG_RAW_PREERASE_SECTORS > 0
+    preerase_recover();
+#endif
+    ESP_LOGI(TAG, "scan of %u KB took %lld ms", (unsigned)(s_raw.part->size / 1024),
+             (long long)((esp_timer_get_time() - t0) / 1000));
+    return true;
+}
+
+bool log_store_append(const void *data, size_t len)
+{
+    if (s_raw.part == NULL) {
+        return false;
+    }
+    log_wear_add_logical(len);
+
+    // Appends that fit a page never straddle one, so a sector drop cuts between appends
+    if (len <= RAW_PAGE_PAYLOAD_BYTES && len > RAW_PAGE_PAYLOAD_BYTES - s_raw.used &&
+        !program_page()) {
+        s_raw.lost++;
+        return false;
+    }
+
+    if (s_raw.used == 0) {
+        s_raw.unsynced_since_us = esp_timer_get_time();
+    }
+    s_raw.last_position = s_raw.size + (uint32_t)s_raw.used;
+
+    const uint8_t *src = (const uint8_t *)data;
+    while (len > 0) {
+        size_t n = RAW_PAGE_PAYLOAD_BYTES - s_raw.used;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(s_raw.page + RAW_PAGE_HDR_BYTES + s_raw.used, src, n);
+        s_raw.used += n;
+        src += n;
+        len -= n;
+
+        if (s_raw.used == RAW_PAGE_PAYLOAD_BYTES) {
+            if (len == 0) {
+                s_raw.page_appends++;
+            }
+            LOG_CRASH_POINT(LOG_CRASH_APPEND);
+            if (!program_page()) {
+                if (len > 0) {
+                    s_raw.lost++;
+                }
+                return false;
+            }
+            s_raw.cont_pending = (len > 0);
+        }
+    }
+
+    if (s_raw.used == 0) {
+        // Ended exactly on a page boundary: nothing left in RAM
+        s_raw.unsynced = 0;
+        return true;
+    }
+    s_raw.page_appends++;
+    s_raw.unsynced++;
+
+    if (LOG_SYNC_EVERY_RECORDS > 0 && s_raw.unsynced >= LOG_SYNC_EVERY_RECORDS) {
+        return log_store_sync();
+    }
+    return true;
+}
+
+bool log_store_sync(void)
+{
+    if (s_raw.part == NULL) {
+        return false;
+    }
+    s_raw.unsynced = 0;
+    if (s_raw.used > 0) {
+        LOG_CRASH_POINT(LOG_CRASH_SYNC);
+    }
+    // Programs a partial page; the rest of that slot is given up
+    return (s_raw.used == 0) || program_page();
+}
+
+bool log_store_poll(void)
+{
+    if (log_store_poll_delay_ms() != 0) {
+        return true;
+    }
+    return log_store_sync();
+}
+
+uint32_t log_store_poll_delay_ms(void)
+{
+    if (LOG_SYNC_INTERVAL_MS == 0 || s_raw.used == 0) {
+        return UINT32_MAX;
+    }
+
+    const int64_t age_ms = (esp_timer_get_time() - s_raw.unsynced_since_us) / 1000;
+    if (age_ms >= LOG_SYNC_INTERVAL_MS) {
+        return 0;
+    }
+    return (uint32_t)(LOG_SYNC_INTERVAL_MS - age_ms);
+}
+
+bool log_store_index(uint32_t seq, uint32_t uptime_ms, uint32_t epoch_offset,
+                     uint64_t wall_base_ms, uint32_t records)
+{
+    // No file system for a sidecar; the page sequence numbers order the log
+    (void)seq;
+    (void)uptime_ms;
+    (void)epoch_offset;
+    (void)wall_base_ms;
+    (void)records;
+    return true;
+}
+
+void log_store_zone_add(const log_zone_t *zone)
+{
+    (void)zone;
+}
+
+bool log_store_zone(uint32_t position, log_store_zone_t *out)
+{
+    (void)position;
+    (void)out;
+    return false;
+}
+
+uint32_t log_store_last_offset(void)
+{
+    return 0;
+}
+
+uint32_t log_store_last_position(void)
+{
+    return s_raw.last_position;
+}
+
+uint32_t log_store_file_offset(uint32_t position)
+{
+    (void)position;
+    return 0;
+}
+
+bool log_store_seek(log_store_seek_t by, uint32_t value, log_store_entry_t *entry)
+{
+    // No sidecar index on the raw partition
+    (void)by;
+    (void)value;
+    (void)entry;
+    return false;
+}
+
+bool log_store_rotate_due(size_t len)
+{
+    (void)len;
+    return false;
+}
+
+bool log_store_rotate(void)
+{
+    return true;
+}
+
+bool log_store_clear(void)
+{
+    if (s_raw.part == NULL) {
+        return false;
+    }
+
+    s_raw.used = 0;
+    s_raw.page_appends = 0;
+    s_raw.unsynced = 0;
+    s_raw.cont_pending = false;
+    s_raw.rd_valid = false;
+
+    // Start a fresh sector with an empty START page; older sectors are outside the
+    // live range from now on (one erase instead of the whole partition)
+    if ((s_raw.head_page % PAGES_PER_SECTOR) != 0) {
+        s_raw.head_page = ((s_raw.head_page / PAGES_PER_SECTOR + 1) * PAGES_PER_SECTOR) %
+                          s_raw.pages;
+    }
+    s_raw.start_page = s_raw.head_page;
+    s_raw.start_seq = s_raw.next_seq;
+    s_raw.empty = true;
+    s_raw.dropped += s_raw.size;
+    s_raw.size = 0;
+    s_raw.start_pending = true;
+    return program_page();
+}
+
+uint32_t log_store_size(void)
+{
+    return s_raw.size;
+}
+
+// Payload of the live page holding offset, from offset on (*avail bytes). Moves the
+// read cursor to that page.
+static const uint8_t *locate(log_store_map_t *map, uint32_t offset, size_t *avail)
+{
+    if (s_raw.part == NULL || s_raw.empty || offset >= s_raw.size) {
+        return NULL;
+    }
+    if (!s_raw.rd_valid || offset < s_raw.rd_offset) {
+        s_raw.rd_page = s_raw.start_page;
+        s_raw.rd_offset = 0;
+        s_raw.rd_valid = true;
+    }
+
+    raw_page_info_t info;
+    while (s_raw.rd_page != s_raw.head_page) {
+        const uint8_t *page = page_read(map, s_raw.rd_page, &info);
+        if (page == NULL || !page_live(&info)) {
+            s_raw.rd_page = next_page(s_raw.rd_page);
+            continue;
+        }
+        if (offset >= s_raw.rd_offset + info.len) {
+            s_raw.rd_offset += info.len;
+            s_raw.rd_page = next_page(s_raw.rd_page);
+            continue;
+        }
+        *avail = s_raw.rd_offset + info.len - offset;
+        return page + RAW_PAGE_HDR_BYTES + (offset - s_raw.rd_offset);
+    }
+    return NULL;
+}
+
+size_t log_store_read(uint32_t offset, void *buf, size_t len)
+{
+    uint8_t *out = (uint8_t *)buf;
+    size_t done = 0;
+    while (done < len) {
+        size_t n;
+        const uint8_t *p = locate(&s_raw.rd_map, offset + (uint32_t)done, &n);
+        if (p == NULL) {
+            break;
+        }
+        if (n > len - done) {
+            n = len - done;
+        }
+        memcpy(out + done, p, n);
+        done += n;
+    }
+    return done;
+}
+
+const void *log_store_view(log_store_map_t *map, uint32_t offset, size_t *len)
+{
+    *len = 0;
+#if LOG_RAW_MMAP
+    return locate(map, offset, len);
+#else
+    // Pages are read into the shared s_scan: nothing stays in place
+    return NULL;
+#endif
+}
+
+void log_store_unmap(log_store_map_t *map)
+{
+#if LOG_RAW_MMAP
+    if (map->pages > 0) {
+        esp_partition_munmap((esp_partition_mmap_handle_t)map->handle);
+        map->pages = 0;
+    }
+#endif
+}
+
+uint32_t log_store_dropped(void)
+{
+    return s_raw.dropped;
+}
+
+// No segment files: the partition is one ring of pages
+bool log_store_segment_next(uint32_t id, log_store_segment_t *seg)
+{
+    (void)id;
+    (void)seg;
+    return false;
+}
+
+size_t log_store_segment_read(uint32_t id, uint32_t offset, void *buf, size_t len)
+{
+    (void)id;
+    (void)offset;
+    (void)buf;
+    (void)len;
+    return 0;
+}
+
+bool log_store_rewrite_begin(uint32_t id)
+{
+    (void)id;
+    return false;
+}
+
+uint32_t log_store_rewrite_mark(uint32_t offset)
+{
+    (void)offset;
+    return UINT32_MAX;
+}
+
+bool log_store_rewrite_append(const void *data, size_t len, uint32_t old_offset, bool header)
+{
+    (void)data;
+    (void)len;
+    (void)old_offset;
+    (void)header;
+    return false;
+}
+
+bool log_store_rewrite_commit(void)
+{
+    return false;
+}
+
+void log_store_rewrite_abort(void)
+{
+}
+
+bool log_store_maintain(void)
+{
+    if (s_raw.part == NULL) {
+        return false;
+    }
+#if LOG_RETAIN_BYTES > 0
+    // Retention first: its erases also fill the pool when the ring has wrapped
+    if (!s_raw.empty && retain_due(last_slot())) {
+        retain_sector();
+        return log_store_maint_pending() > 0;
+    }
+#endif
+#if LOG_RAW_PREERASE_SECTORS > 0
+    preerase_step();
+#endif
+    return log_store_maint_pending() > 0;
+}
+
+uint32_t log_store_maint_pending(void)
+{
+    uint32_t pending = 0;
+    if (s_raw.part == NULL) {
+        return 0;
+    }
+#if LOG_RETAIN_BYTES > 0
+    // Sectors of payload over the cap
+    const uint32_t sector_bytes = PAGES_PER_SECTOR * RAW_PAGE_PAYLOAD_BYTES;
+    if (!s_raw.empty && retain_due(last_slot())) {
+        pending += (s_raw.size - LOG_RETAIN_BYTES + sector_bytes - 1) / sector_bytes;
+    }
+#endif
+#if LOG_RAW_PREERASE_SECTORS > 0
+    uint32_t sector;
+    if (!s_raw.preerase_stalled) {
+        pending += preerase_scan(&sector);
+    }
+#endif
+    return pending;
+}
+
+void log_store_pin(bool pin)
+{
+    if (pin) {
+        s_raw.pins++;
+    } else if (s_raw.pins > 0) {
+        s_raw.pins--;
+    }
+}
+
+bool log_store_replica(log_store_replica_t *replica)
+{
+    // No SD tier behind the raw partition
+    memset(replica, 0, sizeof(*replica));
+    return false;
+}
+
+uint32_t log_store_lost(void)
+{
+    return s_raw.lost;
+}
+
+uint32_t log_store_syncs(void)
+{
+    return s_raw.programs;
+}
+
+bool log_store_wear(uint32_t *min_erases, uint32_t *max_erases)
+{
+    *min_erases = 0;
+    *max_erases = 0;
+#if LOG_RAW_WEAR_SAVE_ERASES > 0
+    if (s_raw.part == NULL || s_wear_sectors == 0) {
+        return false;
+    }
+    *min_erases = UINT32_MAX;
+    for (uint32_t i = 0; i < s_wear_sectors; i++) {
+        *min_erases = (s_wear[i] < *min_erases) ? s_wear[i] : *min_erases;
+        *max_erases = (s_wear[i] > *max_erases) ? s_wear[i] : *max_erases;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint32_t log_store_inline_erases(void)
+{
+    return s_raw.inline_erases;
+}
+
+uint32_t log_store_free(void)
+{
+    if (s_raw.part == NULL) {
+        return 0;
+    }
+    // Slots from the head up to the oldest live sector; the head sector's erase recycles it
+    uint32_t live_pages = 0;
+    if (!s_raw.empty) {
+        live_pages = (s_raw.head_page + s_raw.pages - s_raw.start_page) % s_raw.pages;
+    }
+    uint32_t free_bytes = (s_raw.pages - live_pages) * RAW_PAGE_PAYLOAD_BYTES - (uint32_t)s_raw.used;
+#if LOG_RETAIN_BYTES > 0
+    const uint32_t cap = (s_raw.size < LOG_RETAIN_BYTES) ? LOG_RETAIN_BYTES - s_raw.size : 0;
+    if (free_bytes > cap) {
+        free_bytes = cap;
+    }
+#endif
+    return free_bytes;
+}
+
+#endif // LOG_STORAGE_RAW
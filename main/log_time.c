@@ -0,0 +1,117 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Wall clock for the log index.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_time.c
+ * @brief   Wall clock base (Unix ms at uptime 0), SNTP or set by hand
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <sys/time.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+#if LOG_TIME_SNTP
+#include "esp_netif_sntp.h"
+#endif
+
+#include "log_time.h"
+
+// --------------------
+// Globals
+// --------------------
+static const char *TAG = "LOG_TIME";
+// 64-bit: set from the SNTP task, read by the writer task
+static portMUX_TYPE s_time_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint64_t s_base_ms = 0;
+
+// --------------------
+// Base
+// --------------------
+// Recompute the base from the system clock; the clock only moves when it is set
+static void update_base(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    uint64_t base = 0;
+    if (tv.tv_sec >= (time_t)LOG_TIME_VALID_AFTER_S) {
+        const uint64_t now_ms = (uint64_t)tv.tv_sec * 1000 + (uint64_t)tv.tv_usec / 1000;
+        base = now_ms - (uint64_t)(esp_timer_get_time() / 1000);
+    }
+    portENTER_CRITICAL(&s_time_lock);
+    s_base_ms = base;
+    portEXIT_CRITICAL(&s_time_lock);
+}
+
+#if LOG_TIME_SNTP
+static void sntp_synced(struct timeval *tv)
+{
+    (void)tv;
+    update_base();
+    ESP_LOGI(TAG, "SNTP sync: base %llu ms", (unsigned long long)log_time_base_ms());
+}
+#endif
+
+// --------------------
+// Public API
+// --------------------
+void log_time_init(void)
+{
+    update_base();
+    if (log_time_base_ms() == 0) {
+        ESP_LOGI(TAG, "wall clock not set ('w' or SNTP)");
+    }
+#if LOG_TIME_SNTP
+    esp_sntp_config_t config = ESP_NETIF_SNTP_DEFAULT_CONFIG(LOG_TIME_SNTP_SERVER);
+    config.sync_cb = sntp_synced;
+    if (esp_netif_sntp_init(&config) != ESP_OK) {
+        ESP_LOGW(TAG, "SNTP start failed");
+    }
+#endif
+}
+
+uint64_t log_time_base_ms(void)
+{
+    portENTER_CRITICAL(&s_time_lock);
+    const uint64_t base = s_base_ms;
+    portEXIT_CRITICAL(&s_time_lock);
+    return base;
+}
+
+uint64_t log_time_now_ms(void)
+{
+    const uint64_t base = log_time_base_ms();
+    return (base != 0) ? base + (uint64_t)(esp_timer_get_time() / 1000) : 0;
+}
+
+bool log_time_set(uint32_t unix_s)
+{
+    if (unix_s < LOG_TIME_VALID_AFTER_S) {
+        return false;
+    }
+    const struct timeval tv = {.tv_sec = (time_t)unix_s, .tv_usec = 0};
+    if (settimeofday(&tv, NULL) != 0) {
+        return false;
+    }
+    update_base();
+    return true;
+}
@@ -0,0 +1,48 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Wall clock for the log index.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_time.h
+ * @brief   Wall clock base (Unix ms at uptime 0), SNTP or set by hand
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Records keep their 32-bit uptime; a record's wall time is the boot's
+ *          base plus its uptime. The base is computed once whenever the clock is
+ *          set (boot, SNTP sync, 'w' command), so the writer only reads a cached
+ *          64-bit value per index entry.
+ *******************************************************************************/
+#ifndef LOG_TIME_H
+#define LOG_TIME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+// Pick up a clock kept by the RTC through deep sleep and start SNTP (LOG_TIME_SNTP)
+void log_time_init(void);
+
+// Unix ms at uptime 0 of this boot, 0 while the clock is not set
+uint64_t log_time_base_ms(void);
+
+// Unix ms now, 0 while the clock is not set
+uint64_t log_time_now_ms(void);
+
+// Set the system clock (Unix seconds). False for a time before LOG_TIME_VALID_AFTER_S.
+bool log_time_set(uint32_t unix_s);
+
+#endif // LOG_TIME_H
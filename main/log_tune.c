@@ -0,0 +1,246 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Pick the block group size and deadline from measured costs and ingest.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_tune.c
+ * @brief   Online block group size and deadline controller of the writer task
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <stdbool.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "log_tune.h"
+
+#if LOG_BATCH_AUTOTUNE
+
+// --------------------
+// Constants
+// --------------------
+#define TUNE_KEEP           (1.0 - 1.0 / LOG_TUNE_WINDOW)   // forgetting factor per group
+#define TUNE_RATE_GAIN      0.25                            // EWMA gain of a rate sample
+#define TUNE_RHO_MAX        0.95                            // busier counts as overload
+
+// --------------------
+// Globals
+// --------------------
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Decayed sums of the group cost fit: weight, n, n^2, cost, n*cost (cost in us)
+static double s_w, s_sn, s_snn, s_sc, s_snc;
+static double s_sync_us = 0;        // sync EWMA, 0 until the first sync
+static double s_rate = 0;           // records/s EWMA
+static bool s_rate_valid = false;
+static uint32_t s_rate_count = 0;   // submit counter at the last rate sample
+static int64_t s_rate_us = 0;
+
+static log_tune_point_t s_point;    // published under s_lock
+
+// --------------------
+// Model
+// --------------------
+// Fitted group cost a + b*n in us; false until two groups have been measured
+static bool fit(double *a, double *b)
+{
+    if (s_w < 1.5) {
+        return false;
+    }
+    const double mean_n = s_sn / s_w;
+    const double mean_c = s_sc / s_w;
+    const double var_n = s_snn / s_w - mean_n * mean_n;
+    *b = 0;
+    if (var_n > 0.25) {
+        *b = (s_snc / s_w - mean_n * mean_c) / var_n;
+    }
+    *a = mean_c - *b * mean_n;
+    // All groups (nearly) one size, or a fit with a negative part: take the whole mean
+    // cost as per record, which overstates small groups and so errs towards batching
+    if (var_n <= 0.25 || *a < 0 || *b < 0) {
+        *a = 0;
+        *b = mean_c / (mean_n > 0 ? mean_n : 1);
+    }
+    return true;
+}
+
+// Predicted worst submit to durable time in us of groups of n at rate r, and through
+// *slack_us what is left of LOG_BATCH_DURABLE_MS for a record waiting in its group.
+// The group itself is served after its last record arrives, then queues behind the
+// earlier ones (M/D/1 mean wait) at utilisation r*service/n.
+static double predict(double a, double b, uint32_t n, double r, double *slack_us)
+{
+    const double service = a + b * n + s_sync_us;
+    const double rho = r * service / 1e6 / n;
+    double wait = 0;
+    if (rho >= TUNE_RHO_MAX) {
+        wait = 1e12;
+    } else if (rho > 0) {
+        wait = service * rho / (2.0 * (1.0 - rho));
+    }
+    *slack_us = LOG_BATCH_DURABLE_MS * 1000.0 - service - wait;
+    return service + wait;
+}
+
+// Pick the group size with the most records per second of writer time whose records
+// all reach the store within LOG_BATCH_DURABLE_MS; under overload the largest group
+static void choose(void)
+{
+    double a, b;
+    if (!s_rate_valid || !fit(&a, &b)) {
+        return;
+    }
+    const double r = s_rate;
+    uint32_t best_n = LOG_BATCH_RECORDS;
+    double best_score = -1, best_slack = 0, best_durable = 0;
+    for (uint32_t n = 1; n <= LOG_BATCH_RECORDS; n++) {
+        double slack;
+        const double durable = predict(a, b, n, r, &slack);
+        if (slack < 0) {
+            continue;
+        }
+        // At a low rate the deadline ends the group before it fills
+        double filled = 1.0 + r * slack / 1e6;
+        if (filled > n) {
+            filled = n;
+        }
+        const double score = filled / (a + b * filled + s_sync_us);
+        // Ties go to the smaller group: same throughput, less held in RAM
+        if (score > best_score * 1.001) {
+            best_score = score;
+            best_n = n;
+            best_slack = slack;
+            best_durable = durable;
+        }
+    }
+    double deadline_us = best_slack;
+    if (best_score < 0) {
+        // Nothing meets the bound: the largest group has the most headroom; flush as
+        // soon as what is left of the bound after its service runs out
+        double slack;
+        best_durable = predict(a, b, best_n, r, &slack);
+        deadline_us = LOG_BATCH_DURABLE_MS * 1000.0 - (a + b * best_n + s_sync_us);
+    }
+    if (deadline_us < 1000.0) {
+        deadline_us = 1000.0;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    // Move at most a factor of two per group so one odd cost sample cannot swing it
+    uint32_t n = best_n;
+    if (n > s_point.batch_records * 2) {
+        n = s_point.batch_records * 2;
+    } else if (n < s_point.batch_records / 2) {
+        n = s_point.batch_records / 2;
+    }
+    if (n < 1) {
+        n = 1;
+    }
+    const uint32_t deadline_ms = (uint32_t)(deadline_us / 1000.0);
+    if (n != s_point.batch_records || deadline_ms != s_point.deadline_ms) {
+        s_point.changes++;
+    }
+    s_point.batch_records = n;
+    s_point.deadline_ms = deadline_ms;
+    s_point.arrival_mrps = (uint32_t)(r * 1000.0);
+    s_point.group_fixed_us = (uint32_t)a;
+    s_point.record_us = (uint32_t)b;
+    s_point.sync_us = (uint32_t)s_sync_us;
+    s_point.capacity_rps = (uint32_t)(n * 1e6 / (a + b * n + s_sync_us));
+    s_point.durable_ms = best_durable < 4e9 ? (uint32_t)(best_durable / 1000.0) : UINT32_MAX;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+// --------------------
+// Public API
+// --------------------
+void log_tune_init(void)
+{
+    s_w = s_sn = s_snn = s_sc = s_snc = 0;
+    s_sync_us = 0;
+    s_rate = 0;
+    s_rate_valid = false;
+    s_rate_us = 0;
+    portENTER_CRITICAL(&s_lock);
+    memset(&s_point, 0, sizeof(s_point));
+    s_point.batch_records = LOG_BATCH_RECORDS;
+    s_point.deadline_ms = LOG_BATCH_MAX_LATENCY_MS;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void log_tune_group(uint32_t records, uint32_t cost_us)
+{
+    if (records == 0) {
+        return;
+    }
+    const double n = records;
+    const double c = cost_us;
+    s_w = s_w * TUNE_KEEP + 1.0;
+    s_sn = s_sn * TUNE_KEEP + n;
+    s_snn = s_snn * TUNE_KEEP + n * n;
+    s_sc = s_sc * TUNE_KEEP + c;
+    s_snc = s_snc * TUNE_KEEP + n * c;
+    portENTER_CRITICAL(&s_lock);
+    s_point.groups++;
+    portEXIT_CRITICAL(&s_lock);
+    choose();
+}
+
+void log_tune_sync(uint32_t cost_us)
+{
+    s_sync_us = s_sync_us == 0 ? cost_us : s_sync_us + (cost_us - s_sync_us) / LOG_TUNE_WINDOW;
+}
+
+void log_tune_arrivals(uint32_t submitted, int64_t now_us)
+{
+    if (s_rate_us == 0) {
+        s_rate_count = submitted;
+        s_rate_us = now_us;
+        return;
+    }
+    const int64_t elapsed_us = now_us - s_rate_us;
+    if (elapsed_us < (int64_t)LOG_TUNE_RATE_MS * 1000) {
+        return;
+    }
+    const double sample = (double)(submitted - s_rate_count) * 1e6 / (double)elapsed_us;
+    s_rate = s_rate_valid ? s_rate + TUNE_RATE_GAIN * (sample - s_rate) : sample;
+    s_rate_valid = true;
+    s_rate_count = submitted;
+    s_rate_us = now_us;
+}
+
+uint32_t log_tune_batch(void)
+{
+    return s_point.batch_records;
+}
+
+uint32_t log_tune_deadline_ms(void)
+{
+    return s_point.deadline_ms;
+}
+
+void log_tune_get(log_tune_point_t *out)
+{
+    portENTER_CRITICAL(&s_lock);
+    *out = s_point;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+#endif // LOG_BATCH_AUTOTUNE
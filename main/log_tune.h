@@ -0,0 +1,76 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Pick the block group size and deadline from measured costs and ingest.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_tune.h
+ * @brief   Online block group size and deadline controller of the writer task
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    A group of n records costs a + b*n (encrypt and append, fitted by least
+ *          squares with exponential forgetting over the recent groups) plus one
+ *          sync s. With ingest rate r the writer is busy rho = r*(a+b*n+s)/n of the
+ *          time, and a group waits about (a+b*n+s)*rho/(2*(1-rho)) behind the ones
+ *          before it (M/D/1). What is left of LOG_BATCH_DURABLE_MS after service
+ *          and queueing is the deadline a record may wait for its group, which then
+ *          holds min(n, 1 + r*deadline) records. The operating point is the n whose
+ *          groups give the most records per second of writer time with that slack
+ *          not negative; when none is feasible (overload) it is the largest group.
+ *          Writer task only, apart from log_tune_get().
+ *******************************************************************************/
+#ifndef LOG_TUNE_H
+#define LOG_TUNE_H
+
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+typedef struct {
+    uint32_t batch_records;     // group size in use
+    uint32_t deadline_ms;       // longest a record waits for its group to fill
+    uint32_t arrival_mrps;      // ingest rate estimate, records per 1000 s
+    uint32_t group_fixed_us;    // fitted cost of a group: fixed part ...
+    uint32_t record_us;         // ... plus this per record (encrypt and append)
+    uint32_t sync_us;           // mean store sync after a group
+    uint32_t capacity_rps;      // records/s the writer sustains at batch_records
+    uint32_t durable_ms;        // predicted worst submit to durable time, 0 until fitted
+    uint32_t groups;            // groups measured
+    uint32_t changes;           // operating point changes
+} log_tune_point_t;
+
+#if LOG_BATCH_AUTOTUNE
+
+// Start from LOG_BATCH_RECORDS and LOG_BATCH_MAX_LATENCY_MS
+void log_tune_init(void);
+
+// One group of records encrypted and appended in cost_us; picks the next operating point
+void log_tune_group(uint32_t records, uint32_t cost_us);
+
+// The store sync after a group took cost_us
+void log_tune_sync(uint32_t cost_us);
+
+// Records submitted since boot, as seen at now_us; a rate sample every LOG_TUNE_RATE_MS
+void log_tune_arrivals(uint32_t submitted, int64_t now_us);
+
+uint32_t log_tune_batch(void);
+uint32_t log_tune_deadline_ms(void);
+
+// Any task: the current operating point and its inputs
+void log_tune_get(log_tune_point_t *out);
+
+#endif // LOG_BATCH_AUTOTUNE
+
+#endif // LOG_TUNE_H
@@ -0,0 +1,306 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Key and metadata rotation by OPTIGA protected update, pushed over the air.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_update.c
+ * @brief   Protected update streamed from a flash partition into OPTIGA
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_crt_bundle.h"
+#include "esp_http_client.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+
+#include "optiga/optiga_util.h"
+#include "optiga_sync.h"
+
+#include "enc_log.h"
+#include "log_update.h"
+#if LOG_READ_CACHE
+#include "log_cache.h"
+#endif
+
+#if LOG_UPDATE
+
+#define UPDATE_SUBTYPE          0x40
+#define UPDATE_STACK_BYTES      4096
+
+// Download into the partition, shared with the applying task
+typedef struct {
+    const esp_partition_t *part;
+    const char *url;
+    TaskHandle_t waiter;        // applying task, notified per chunk and at the end
+    volatile uint32_t landed;   // bytes written to the partition
+    volatile bool done;         // download ended (landed is final)
+    bool ok;                    // the whole body arrived
+    uint32_t length;            // Content-Length, 0: unknown
+    int64_t elapsed_us;
+} update_dl_t;
+
+// --------------------
+// Globals
+// --------------------
+static const char *TAG = "LOG_UPDATE";
+static uint8_t s_chunk[LOG_UPDATE_CHUNK_BYTES];
+static optiga_util_t *s_util = NULL;
+static optiga_sync_t s_sync;
+
+// --------------------
+// Download
+// --------------------
+// Erases each sector just before its first byte is written, so the partition is never
+// erased ahead of the download
+static bool dl_write(update_dl_t *dl, const uint8_t *data, size_t len)
+{
+    const uint32_t sector = dl->part->erase_size;
+    const uint32_t end = dl->landed + (uint32_t)len;
+    if (end > dl->part->size) {
+        ESP_LOGE(TAG, "data set larger than the partition (%lu bytes)",
+                 (unsigned long)dl->part->size);
+        return false;
+    }
+    for (uint32_t s = (dl->landed + sector - 1) / sector * sector; s < end; s += sector) {
+        if (esp_partition_erase_range(dl->part, s, sector) != ESP_OK) {
+            return false;
+        }
+    }
+    return esp_partition_write(dl->part, dl->landed, data, len) == ESP_OK;
+}
+
+static void dl_task(void *arg)
+{
+    update_dl_t *dl = (update_dl_t *)arg;
+    const int64_t start_us = esp_timer_get_time();
+    const esp_http_client_config_t config = {
+        .url = dl->url,
+        .timeout_ms = LOG_UPDATE_TIMEOUT_MS,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (client != NULL && esp_http_client_open(client, 0) == ESP_OK) {
+        const int64_t length = esp_http_client_fetch_headers(client);
+        const int code = esp_http_client_get_status_code(client);
+        dl->length = (length > 0) ? (uint32_t)length : 0;
+        bool ok = code == 200;
+        if (!ok) {
+            ESP_LOGW(TAG, "server answered %d", code);
+        }
+        while (ok) {
+            const int n = esp_http_client_read(client, (char *)s_chunk, sizeof(s_chunk));
+            if (n <= 0) {
+                ok = n == 0 && esp_http_client_is_complete_data_received(client);
+                break;
+            }
+            ok = dl_write(dl, s_chunk, (size_t)n);
+            if (ok) {
+                dl->landed += (uint32_t)n;
+                xTaskNotifyGive(dl->waiter);
+            }
+        }
+        dl->ok = ok;
+        esp_http_client_close(client);
+    }
+    if (client != NULL) {
+        esp_http_client_cleanup(client);
+    }
+    dl->elapsed_us = esp_timer_get_time() - start_us;
+    dl->done = true;
+    xTaskNotifyGive(dl->waiter);
+    vTaskDelete(NULL);
+}
+
+// Wait until the bytes up to end are in the partition; false if the download ended or
+// stalled before
+static bool dl_wait(update_dl_t *dl, uint32_t end, int64_t *waited_us)
+{
+    const int64_t start_us = esp_timer_get_time();
+    bool ok = true;
+    while (ok && dl->landed < end && !dl->done) {
+        ok = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOG_UPDATE_TIMEOUT_MS)) > 0;
+    }
+    *waited_us += esp_timer_get_time() - start_us;
+    return dl->landed >= end;
+}
+
+// --------------------
+// Apply
+// --------------------
+static bool optiga_call(optiga_lib_status_t start_status, const char *what, unsigned fragment,
+                        int64_t *busy_us)
+{
+    const int64_t start_us = esp_timer_get_time();
+    const optiga_lib_status_t ret = optiga_sync_run(&s_sync, start_status, LOG_OPTIGA_TIMEOUT_MS);
+    *busy_us += esp_timer_get_time() - start_us;
+    if (ret != OPTIGA_LIB_SUCCESS) {
+        ESP_LOGE(TAG, "%s %u failed: 0x%04X", what, fragment, ret);
+        return false;
+    }
+    return true;
+}
+
+// Feed the data set from the mapped partition to OPTIGA, each part once it has landed
+static bool apply(update_dl_t *dl, const uint8_t *base, int64_t *busy_us, int64_t *waited_us)
+{
+    if (!dl_wait(dl, sizeof(log_update_hdr_t), waited_us)) {
+        ESP_LOGE(TAG, "no data set header");
+        return false;
+    }
+    log_update_hdr_t hdr;
+    memcpy(&hdr, base, sizeof(hdr));
+    const uint32_t total = sizeof(hdr) + hdr.manifest_len + hdr.payload_len;
+    if (hdr.magic != UPDATE_MAGIC || hdr.format != UPDATE_FORMAT || hdr.manifest_len == 0 ||
+        hdr.fragment_len == 0 || hdr.payload_len == 0 || total > dl->part->size ||
+        (dl->length > 0 && total > dl->length)) {
+        ESP_LOGE(TAG, "not a protected update data set (tools/optiga_update_pack.py)");
+        return false;
+    }
+    const unsigned fragments = (hdr.payload_len + hdr.fragment_len - 1) / hdr.fragment_len;
+    ESP_LOGI(TAG, "manifest %u bytes, %u fragments, %lu bytes", (unsigned)hdr.manifest_len,
+             fragments, (unsigned long)hdr.payload_len);
+
+    uint32_t offset = sizeof(hdr);
+    if (!dl_wait(dl, offset + hdr.manifest_len, waited_us)) {
+        ESP_LOGE(TAG, "download ended in the manifest");
+        return false;
+    }
+    optiga_sync_begin(&s_sync);
+    if (!optiga_call(optiga_util_protected_update_start(s_util, hdr.manifest_version,
+                                                        base + offset, hdr.manifest_len),
+                     "manifest", 0, busy_us)) {
+        return false;
+    }
+    offset += hdr.manifest_len;
+
+    // OPTIGA works on fragment i while the download task writes the ones after it
+    for (unsigned i = 1; i <= fragments; i++) {
+        const uint32_t left = sizeof(hdr) + hdr.manifest_len + hdr.payload_len - offset;
+        const uint16_t len = (left < hdr.fragment_len) ? (uint16_t)left : hdr.fragment_len;
+        const bool last = i == fragments;
+        bool ok = dl_wait(dl, offset + len, waited_us);
+        if (!ok) {
+            ESP_LOGE(TAG, "download ended before fragment %u", i);
+        } else {
+            optiga_sync_begin(&s_sync);
+            ok = last ? optiga_call(optiga_util_protected_update_final(s_util, base + offset, len),
+                                    "fragment", i, busy_us)
+                      : optiga_call(optiga_util_protected_update_continue(s_util, base + offset, len),
+                                    "fragment", i, busy_us);
+        }
+        if (!ok) {
+            // Release the strict sequence; OPTIGA keeps the object as it was
+            if (!last) {
+                optiga_sync_begin(&s_sync);
+                (void)optiga_sync_run(&s_sync, optiga_util_protected_update_final(s_util, NULL, 0),
+                                      LOG_OPTIGA_TIMEOUT_MS);
+            }
+            return false;
+        }
+        offset += len;
+    }
+    return true;
+}
+
+// --------------------
+// Public API
+// --------------------
+void log_update_run(const char *args)
+{
+    static update_dl_t dl;
+    const bool local = strcmp(args, "-") == 0;
+
+    memset(&dl, 0, sizeof(dl));
+    dl.part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, UPDATE_SUBTYPE,
+                                       LOG_UPDATE_PARTITION);
+    if (dl.part == NULL) {
+        ESP_LOGE(TAG, "no partition %s (partitions.csv)", LOG_UPDATE_PARTITION);
+        return;
+    }
+    if (s_util == NULL) {
+        if (!enc_log_wait_ready(UINT32_MAX)) {
+            return;
+        }
+        s_util = optiga_util_create(0, optiga_sync_callback, &s_sync);
+        if (s_util == NULL) {
+            ESP_LOGE(TAG, "optiga_util_create failed");
+            return;
+        }
+    }
+
+    // Mapped once: flash writes of the download invalidate the cache of what they cover
+    const void *base;
+    esp_partition_mmap_handle_t map;
+    if (esp_partition_mmap(dl.part, 0, dl.part->size, ESP_PARTITION_MMAP_DATA, &base, &map) !=
+        ESP_OK) {
+        ESP_LOGE(TAG, "partition %s not mapped", LOG_UPDATE_PARTITION);
+        return;
+    }
+
+    const int64_t start_us = esp_timer_get_time();
+    dl.waiter = xTaskGetCurrentTaskHandle();
+    if (local) {
+        dl.landed = dl.part->size;
+        dl.done = true;
+        dl.ok = true;
+    } else {
+        dl.url = (args[0] != '\0') ? args : LOG_UPDATE_URL;
+        (void)ulTaskNotifyTake(pdTRUE, 0);
+        if (xTaskCreate(dl_task, "log_upd_dl", UPDATE_STACK_BYTES, &dl, tskIDLE_PRIORITY + 2,
+                        NULL) != pdPASS) {
+            ESP_LOGE(TAG, "download task not created");
+            esp_partition_munmap(map);
+            return;
+        }
+        ESP_LOGI(TAG, "downloading %s into %s", dl.url, LOG_UPDATE_PARTITION);
+    }
+
+    int64_t busy_us = 0;
+    int64_t waited_us = 0;
+    const bool ok = apply(&dl, (const uint8_t *)base, &busy_us, &waited_us);
+    // The download task owns dl and s_chunk until it is done
+    while (!dl.done) {
+        (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+    }
+    esp_partition_munmap(map);
+#if LOG_READ_CACHE
+    // The data set may have replaced the log key: drop what was read under the old one
+    if (ok) {
+        log_cache_wipe();
+    }
+#endif
+
+    const int64_t elapsed_us = esp_timer_get_time() - start_us;
+    if (!local && !dl.ok) {
+        ESP_LOGW(TAG, "download incomplete: %lu bytes", (unsigned long)dl.landed);
+    }
+    ESP_LOGI(TAG, "protected update %s in %lu ms: download %lu ms, OPTIGA %lu ms, "
+             "%lu ms waiting for data",
+             ok ? "applied" : "FAILED", (unsigned long)(elapsed_us / 1000),
+             (unsigned long)(dl.elapsed_us / 1000), (unsigned long)(busy_us / 1000),
+             (unsigned long)(waited_us / 1000));
+}
+
+#endif // LOG_UPDATE
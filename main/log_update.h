@@ -0,0 +1,62 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Key and metadata rotation by OPTIGA protected update, pushed over the air.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_update.h
+ * @brief   Protected update streamed from a flash partition into OPTIGA
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Data set layout in LOG_UPDATE_PARTITION (tools/optiga_update_pack.py
+ *          writes it from the output of protected_update_data_set): a
+ *          log_update_hdr_t, the manifest, then the fragments back to back, each
+ *          fragment_len bytes but the last. OPTIGA checks the manifest signature
+ *          against its trust anchor and every fragment against the digest chained
+ *          in the one before, so the container carries no checksum of its own;
+ *          the trust anchor and the target object metadata must be provisioned.
+ *          Fragments are passed to optiga_util_protected_update_continue() and
+ *          _final() as pointers into the flash mapping.
+ *******************************************************************************/
+#ifndef LOG_UPDATE_H
+#define LOG_UPDATE_H
+
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+#define UPDATE_MAGIC            0x5055504Fu     // "OPUP"
+#define UPDATE_FORMAT           1
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             // UPDATE_MAGIC
+    uint8_t format;             // UPDATE_FORMAT
+    uint8_t manifest_version;   // optiga_util_protected_update_start() argument
+    uint16_t manifest_len;
+    uint16_t fragment_len;      // every fragment but the last (640 from the tool)
+    uint16_t reserved;
+    uint32_t payload_len;       // fragment bytes in total
+} log_update_hdr_t;
+
+#if LOG_UPDATE
+
+// Console '5': download the data set from args (a URL; empty: LOG_UPDATE_URL) into the
+// partition and apply it fragment by fragment as it lands. args "-" applies the data set
+// already in the partition. Blocks until done.
+void log_update_run(const char *args);
+
+#endif // LOG_UPDATE
+
+#endif // LOG_UPDATE_H
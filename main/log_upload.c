@@ -0,0 +1,342 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Upload the encrypted log over HTTP without decrypting it.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_upload.c
+ * @brief   Resumable chunked HTTP upload of the stored (encrypted) log bytes
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "esp_crt_bundle.h"
+#include "esp_http_client.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "nvs.h"
+
+#include "enc_log.h"
+#include "log_nvs.h"
+#include "log_upload.h"
+
+#if LOG_UPLOAD
+
+#define UPLOAD_NAMESPACE    "enc_log"
+#define UPLOAD_KEY          "upload"
+
+// Where the next upload starts, kept across resets (NVS blob)
+typedef struct {
+    uint32_t total;             // stream bytes the server committed
+    uint32_t seq;               // sparse index entry the end is anchored to
+    uint32_t uptime_ms;         // its uptime, tells a reused seq apart
+    uint32_t skip;              // end = entry position + skip
+    uint8_t anchored;           // 0: no index entry (raw store), RAM position only
+} upload_cursor_t;
+
+typedef enum {
+    UPLOAD_OK,                  // committed
+    UPLOAD_CONFLICT,            // server holds a different length (in committed)
+    UPLOAD_GONE,                // log bytes dropped while sending
+    UPLOAD_FAILED,              // network or server error
+} upload_status_t;
+
+// --------------------
+// Globals
+// --------------------
+static const char *TAG = "LOG_UPLOAD";
+static uint8_t s_chunk[LOG_UPLOAD_CHUNK_BYTES];
+static upload_cursor_t s_cursor;
+static bool s_cursor_loaded = false;
+// End of the upload as log_store_dropped() + offset, valid for this boot
+static uint32_t s_end_pos = 0;
+static bool s_end_valid = false;
+static uint32_t s_committed;    // X-Log-Committed of the last answer
+static bool s_have_committed;
+
+// --------------------
+// Cursor
+// --------------------
+static void cursor_load(void)
+{
+    nvs_handle_t handle;
+    size_t len = sizeof(s_cursor);
+
+    memset(&s_cursor, 0, sizeof(s_cursor));
+    s_cursor_loaded = true;
+    if (!log_nvs_open(UPLOAD_NAMESPACE, &handle)) {
+        return;
+    }
+    if (nvs_get_blob(handle, UPLOAD_KEY, &s_cursor, &len) != ESP_OK || len != sizeof(s_cursor)) {
+        memset(&s_cursor, 0, sizeof(s_cursor));
+    }
+    nvs_close(handle);
+}
+
+// Remember offset as the end of the upload: in RAM, and anchored to the index entry
+// at or before it for the next boot
+static void cursor_save(const enc_log_snapshot_t *snap, uint32_t offset)
+{
+    log_store_entry_t entry;
+    nvs_handle_t handle;
+
+    s_end_pos = snap->base + offset;
+    s_end_valid = true;
+    s_cursor.anchored = enc_log_snapshot_seek(snap, LOG_STORE_SEEK_POSITION, offset, &entry);
+    s_cursor.seq = s_cursor.anchored ? entry.seq : 0;
+    s_cursor.uptime_ms = s_cursor.anchored ? entry.uptime_ms : 0;
+    s_cursor.skip = s_cursor.anchored ? offset - entry.position : 0;
+    if (!log_nvs_open(UPLOAD_NAMESPACE, &handle)) {
+        return;
+    }
+    if (nvs_set_blob(handle, UPLOAD_KEY, &s_cursor, sizeof(s_cursor)) != ESP_OK ||
+        nvs_commit(handle) != ESP_OK) {
+        ESP_LOGW(TAG, "upload position not stored, the next boot starts a new stream");
+    }
+    nvs_close(handle);
+}
+
+// Snapshot offset the last upload ended at; false if it is no longer in the log
+static bool cursor_offset(const enc_log_snapshot_t *snap, uint32_t *offset)
+{
+    log_store_entry_t entry;
+
+    if (s_end_valid) {
+        if (s_end_pos < snap->base || s_end_pos - snap->base > snap->size) {
+            return false;
+        }
+        *offset = s_end_pos - snap->base;
+        return true;
+    }
+    if (!s_cursor.anchored ||
+        !enc_log_snapshot_seek(snap, LOG_STORE_SEEK_SEQ, s_cursor.seq, &entry) ||
+        entry.seq != s_cursor.seq || entry.uptime_ms != s_cursor.uptime_ms ||
+        entry.position + s_cursor.skip > snap->size) {
+        return false;
+    }
+    *offset = entry.position + s_cursor.skip;
+    return true;
+}
+
+// --------------------
+// HTTP
+// --------------------
+static esp_err_t http_event(esp_http_client_event_t *evt)
+{
+    if (evt->event_id == HTTP_EVENT_ON_HEADER &&
+        strcasecmp(evt->header_key, UPLOAD_HDR_COMMITTED) == 0) {
+        s_committed = (uint32_t)strtoul(evt->header_value, NULL, 10);
+        s_have_committed = true;
+    }
+    return ESP_OK;
+}
+
+static bool http_send(esp_http_client_handle_t client, const void *data, size_t len)
+{
+    const char *p = (const char *)data;
+    while (len > 0) {
+        const int n = esp_http_client_write(client, p, (int)len);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+// One chunk of the body: hex size line, the bytes, CRLF
+static bool http_chunk(esp_http_client_handle_t client, const void *data, size_t len)
+{
+    char line[12];
+    const int n = snprintf(line, sizeof(line), "%x\r\n", (unsigned)len);
+    return http_send(client, line, (size_t)n) && http_send(client, data, len) &&
+           http_send(client, "\r\n", 2);
+}
+
+// Send snapshot bytes [offset, offset + len) as one POST. On the raw store the chunks
+// are written from the flash mapping, without a copy; esp_http_client_write() has
+// handed each one to the socket (or TLS) before the next view moves the window.
+static upload_status_t post_range(enc_log_snapshot_t *snap, uint32_t offset, uint32_t len,
+                                  uint32_t total, bool restart)
+{
+    uint8_t mac[6];
+    char device[13];
+    char total_text[12];
+    upload_status_t status = UPLOAD_FAILED;
+
+    esp_efuse_mac_get_default(mac);
+    snprintf(device, sizeof(device), "%02x%02x%02x%02x%02x%02x", mac[0], mac[1], mac[2], mac[3],
+             mac[4], mac[5]);
+    snprintf(total_text, sizeof(total_text), "%lu", (unsigned long)total);
+    s_have_committed = false;
+
+    const esp_http_client_config_t config = {
+        .url = LOG_UPLOAD_URL,
+        .method = HTTP_METHOD_POST,
+        .timeout_ms = LOG_UPLOAD_TIMEOUT_MS,
+        .event_handler = http_event,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (client == NULL) {
+        return UPLOAD_FAILED;
+    }
+    esp_http_client_set_header(client, "Content-Type", "application/octet-stream");
+    esp_http_client_set_header(client, UPLOAD_HDR_DEVICE, device);
+    esp_http_client_set_header(client, UPLOAD_HDR_TOTAL, total_text);
+    if (restart) {
+        esp_http_client_set_header(client, UPLOAD_HDR_RESTART, "1");
+    }
+
+    // Negative length: Transfer-Encoding: chunked, the chunks are framed here
+    if (esp_http_client_open(client, -1) != ESP_OK) {
+        esp_http_client_cleanup(client);
+        return UPLOAD_FAILED;
+    }
+    bool sent = true;
+    uint32_t pos = offset;
+    while (sent && pos < offset + len) {
+        size_t n = offset + len - pos;
+        if (n > sizeof(s_chunk)) {
+            n = sizeof(s_chunk);
+        }
+        const uint8_t *p = enc_log_snapshot_view(snap, pos, &n);
+        if (p == NULL) {
+            n = enc_log_snapshot_read(snap, pos, s_chunk, n);
+            p = s_chunk;
+        }
+        if (n == 0) {
+            status = UPLOAD_GONE;
+            sent = false;
+            break;
+        }
+        sent = http_chunk(client, p, n);
+        pos += (uint32_t)n;
+    }
+    // A drop the store could not defer may have erased mapped bytes while they were sent:
+    // close without the last chunk, so the server discards the body
+    if (sent && !enc_log_snapshot_kept(snap, offset)) {
+        status = UPLOAD_GONE;
+        sent = false;
+    }
+    if (sent && http_send(client, "0\r\n\r\n", 5) && esp_http_client_fetch_headers(client) >= 0) {
+        const int code = esp_http_client_get_status_code(client);
+        if (s_have_committed && code == 200) {
+            status = UPLOAD_OK;
+        } else if (s_have_committed && code == 409) {
+            status = UPLOAD_CONFLICT;
+        } else {
+            ESP_LOGW(TAG, "server answered %d", code);
+        }
+    }
+    esp_http_client_close(client);
+    esp_http_client_cleanup(client);
+    return status;
+}
+
+// --------------------
+// Public API
+// --------------------
+void log_upload_run(const char *args)
+{
+    if (!s_cursor_loaded) {
+        cursor_load();
+    }
+
+    // Records written during the upload go to the next one; retention waits for the close
+    enc_log_snapshot_t snap;
+    enc_log_snapshot_open(&snap);
+
+    uint32_t offset = 0;
+    bool restart = strcmp(args, "0") == 0 || s_cursor.total == 0;
+    if (!restart && !cursor_offset(&snap, &offset)) {
+        ESP_LOGW(TAG, "end of the last upload is no longer in the log, starting a new stream");
+        restart = true;
+    }
+    if (restart) {
+        offset = 0;
+        s_cursor.total = 0;
+    }
+
+    const uint32_t start = offset;
+    unsigned failures = 0;
+    bool gone = false;
+    while (offset < snap.size && failures < LOG_UPLOAD_RETRIES && !gone) {
+        uint32_t len = snap.size - offset;
+        if (len > LOG_UPLOAD_POST_BYTES) {
+            len = LOG_UPLOAD_POST_BYTES;
+        }
+        switch (post_range(&snap, offset, len, s_cursor.total, restart)) {
+        case UPLOAD_OK:
+            // More than sent if an earlier answer was lost and the body was a resend
+            if (s_committed < s_cursor.total || s_committed - s_cursor.total > snap.size - offset) {
+                ESP_LOGW(TAG, "server at %lu, device at %lu: starting a new stream",
+                         (unsigned long)s_committed, (unsigned long)s_cursor.total);
+                offset = 0;
+                s_cursor.total = 0;
+                restart = true;
+                failures++;
+                break;
+            }
+            offset += s_committed - s_cursor.total;
+            s_cursor.total = s_committed;
+            restart = false;
+            failures = 0;
+            cursor_save(&snap, offset);
+            break;
+        case UPLOAD_CONFLICT:
+            // The server is behind: resend from its end while those bytes are in the log
+            if (s_committed < s_cursor.total && s_cursor.total - s_committed <= offset) {
+                offset -= s_cursor.total - s_committed;
+                s_cursor.total = s_committed;
+            } else {
+                ESP_LOGW(TAG, "server at %lu, device at %lu: starting a new stream",
+                         (unsigned long)s_committed, (unsigned long)s_cursor.total);
+                offset = 0;
+                s_cursor.total = 0;
+                restart = true;
+            }
+            failures++;
+            break;
+        case UPLOAD_GONE:
+            gone = true;
+            break;
+        default:
+            failures++;
+            break;
+        }
+    }
+    enc_log_snapshot_close(&snap);
+
+    if (offset >= snap.size) {
+        ESP_LOGI(TAG, "uploaded %lu bytes, server holds %lu", (unsigned long)(offset - start),
+                 (unsigned long)s_cursor.total);
+    } else if (gone) {
+        ESP_LOGE(TAG, "upload stopped: log data dropped at offset %lu", (unsigned long)offset);
+    } else {
+        ESP_LOGE(TAG, "upload stopped at offset %lu of %lu, run 'v' again to resume",
+                 (unsigned long)offset, (unsigned long)snap.size);
+    }
+}
+
+#endif // LOG_UPLOAD
@@ -0,0 +1,52 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Upload the encrypted log over HTTP without decrypting it.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_upload.h
+ * @brief   Resumable chunked HTTP upload of the stored (encrypted) log bytes
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Protocol: the device POSTs the log bytes as they are stored (records,
+ *          block groups, epoch headers, all encrypted) to LOG_UPLOAD_URL with
+ *          Transfer-Encoding: chunked, at most LOG_UPLOAD_POST_BYTES per POST.
+ *          Request headers:
+ *            X-Log-Device    base MAC as 12 hex digits
+ *            X-Log-Total     bytes of the stream the device believes the server holds
+ *            X-Log-Restart   "1": the body starts a new stream (first upload, or
+ *                            the bytes after the server's end are gone)
+ *          The server appends a complete body only (a broken connection adds
+ *          nothing) and answers X-Log-Committed: its stream length. 200 when the
+ *          body was appended; bytes it already held are skipped, so a resend after
+ *          a lost answer is harmless. 409 when X-Log-Total is past its end: the
+ *          device steps back to the committed length and sends again.
+ *          Where the next upload starts is kept in RAM for this boot and as a
+ *          sparse index anchor (seq, uptime of an entry + bytes past it) in NVS,
+ *          so it survives a reset on stores with an index.
+ *******************************************************************************/
+#ifndef LOG_UPLOAD_H
+#define LOG_UPLOAD_H
+
+#define UPLOAD_HDR_DEVICE       "X-Log-Device"
+#define UPLOAD_HDR_TOTAL        "X-Log-Total"
+#define UPLOAD_HDR_RESTART      "X-Log-Restart"
+#define UPLOAD_HDR_COMMITTED    "X-Log-Committed"
+
+// Upload the log from where the last upload ended to the end of a snapshot (console
+// 'v'). args "0" starts a new stream at the oldest byte. Blocks until done.
+void log_upload_run(const char *args);
+
+#endif // LOG_UPLOAD_H
@@ -0,0 +1,168 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Flash write amplification and lifetime estimate of the log partition.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_wear.c
+ * @brief   Logical vs programmed vs erased bytes on the storage partition
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <string.h>
+
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+#include "log_wear.h"
+
+#define WEAR_SECONDS_PER_DAY    86400.0
+#define WEAR_DAYS_PER_YEAR      365.25
+
+// --------------------
+// Globals
+// --------------------
+// Written by the writer task, FATFS callers and the console; 64-bit counters
+static portMUX_TYPE s_wear_lock = portMUX_INITIALIZER_UNLOCKED;
+static const esp_partition_t *s_part = NULL;    // LOG_WEAR_PARTITION_LABEL, once seen
+static uint64_t s_logical = 0;
+static uint64_t s_programmed = 0;
+static uint64_t s_erased = 0;
+static uint32_t s_appends = 0;
+static uint32_t s_writes = 0;
+static uint32_t s_erases = 0;
+
+// --------------------
+// Partition wrappers
+// --------------------
+// Linked with -Wl,--wrap (main/CMakeLists.txt): every caller outside esp_partition,
+// wear_levelling included, lands here first
+esp_err_t __real_esp_partition_write(const esp_partition_t *part, size_t dst_offset,
+                                     const void *src, size_t size);
+esp_err_t __real_esp_partition_write_raw(const esp_partition_t *part, size_t dst_offset,
+                                         const void *src, size_t size);
+esp_err_t __real_esp_partition_erase_range(const esp_partition_t *part, size_t offset,
+                                           size_t size);
+
+// Partition pointers are stable, so the label is compared only until the first match
+static bool is_log_partition(const esp_partition_t *part)
+{
+    if (part == s_part) {
+        return true;
+    }
+    if (s_part == NULL && part != NULL && strcmp(part->label, LOG_WEAR_PARTITION_LABEL) == 0) {
+        s_part = part;
+        return true;
+    }
+    return false;
+}
+
+static void count_write(const esp_partition_t *part, size_t size)
+{
+    portENTER_CRITICAL(&s_wear_lock);
+    if (is_log_partition(part)) {
+        s_programmed += size;
+        s_writes++;
+    }
+    portEXIT_CRITICAL(&s_wear_lock);
+}
+
+esp_err_t __wrap_esp_partition_write(const esp_partition_t *part, size_t dst_offset,
+                                     const void *src, size_t size)
+{
+    const esp_err_t err = __real_esp_partition_write(part, dst_offset, src, size);
+    if (err == ESP_OK) {
+        count_write(part, size);
+    }
+    return err;
+}
+
+esp_err_t __wrap_esp_partition_write_raw(const esp_partition_t *part, size_t dst_offset,
+                                         const void *src, size_t size)
+{
+    const esp_err_t err = __real_esp_partition_write_raw(part, dst_offset, src, size);
+    if (err == ESP_OK) {
+        count_write(part, size);
+    }
+    return err;
+}
+
+esp_err_t __wrap_esp_partition_erase_range(const esp_partition_t *part, size_t offset,
+                                           size_t size)
+{
+    const esp_err_t err = __real_esp_partition_erase_range(part, offset, size);
+    if (err == ESP_OK) {
+        portENTER_CRITICAL(&s_wear_lock);
+        if (is_log_partition(part)) {
+            s_erased += size;
+            s_erases++;
+        }
+        portEXIT_CRITICAL(&s_wear_lock);
+    }
+    return err;
+}
+
+// --------------------
+// Public API
+// --------------------
+void log_wear_add_logical(size_t len)
+{
+    portENTER_CRITICAL(&s_wear_lock);
+    s_logical += len;
+    s_appends++;
+    portEXIT_CRITICAL(&s_wear_lock);
+}
+
+void log_wear_get_stats(log_wear_stats_t *stats, uint32_t used_cycles)
+{
+    memset(stats, 0, sizeof(*stats));
+    portENTER_CRITICAL(&s_wear_lock);
+    stats->logical_bytes = s_logical;
+    stats->programmed_bytes = s_programmed;
+    stats->erased_bytes = s_erased;
+    stats->appends = s_appends;
+    stats->writes = s_writes;
+    stats->erases = s_erases;
+    const esp_partition_t *part = s_part;
+    portEXIT_CRITICAL(&s_wear_lock);
+
+    if (part == NULL) {
+        part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                        LOG_WEAR_PARTITION_LABEL);
+    }
+    stats->partition_bytes = (part != NULL) ? (uint32_t)part->size : 0;
+    stats->elapsed_s = (uint32_t)(esp_timer_get_time() / 1000000);
+    stats->used_cycles = used_cycles;
+    if (stats->logical_bytes > 0) {
+        stats->write_amp = (double)stats->programmed_bytes / (double)stats->logical_bytes;
+        stats->erase_amp = (double)stats->erased_bytes / (double)stats->logical_bytes;
+    }
+
+    // Erased bytes over the partition size is full-partition erase cycles; wear levelling
+    // and the raw ring both spread them, so that is the cycle count of each sector
+    if (stats->erased_bytes == 0 || stats->partition_bytes == 0 || stats->elapsed_s == 0) {
+        return;
+    }
+    stats->cycles_per_day = (double)stats->erased_bytes / (double)stats->partition_bytes *
+                            WEAR_SECONDS_PER_DAY / (double)stats->elapsed_s;
+    const double left = (used_cycles < LOG_FLASH_ENDURANCE_CYCLES) ?
+                        (double)(LOG_FLASH_ENDURANCE_CYCLES - used_cycles) : 0.0;
+    stats->years_left = left / (stats->cycles_per_day * WEAR_DAYS_PER_YEAR);
+    stats->projected = true;
+}
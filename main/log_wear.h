@@ -0,0 +1,62 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Flash write amplification and lifetime estimate of the log partition.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_wear.h
+ * @brief   Logical vs programmed vs erased bytes on the storage partition
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Logical bytes are what the log store is asked to append. Programmed and
+ *          erased bytes are counted below FATFS and wear_levelling by linker wrappers
+ *          of the esp_partition write and erase calls, for LOG_WEAR_PARTITION_LABEL
+ *          only (NVS and other partitions are not counted). An SD card store has no
+ *          flash view: its physical counts stay 0.
+ *******************************************************************************/
+#ifndef LOG_WEAR_H
+#define LOG_WEAR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+typedef struct {
+    uint64_t logical_bytes;     // bytes passed to log_store_append()
+    uint64_t programmed_bytes;  // bytes programmed into the partition
+    uint64_t erased_bytes;      // bytes erased on the partition
+    uint32_t appends;           // log_store_append() calls
+    uint32_t writes;            // esp_partition_write/_raw calls
+    uint32_t erases;            // esp_partition_erase_range calls
+    uint32_t partition_bytes;   // size of LOG_WEAR_PARTITION_LABEL, 0 if not found
+    uint32_t elapsed_s;         // counting time (since boot)
+    double write_amp;           // programmed / logical bytes
+    double erase_amp;           // erased / logical bytes
+    double cycles_per_day;      // erase cycles per sector per day at the rate since boot
+    uint32_t used_cycles;       // cycles already used, as passed in
+    bool projected;             // false until something was erased: no lifetime yet
+    double years_left;          // (endurance - used) / yearly cycles
+} log_wear_stats_t;
+
+// Count len bytes appended to the log store (called by both store backends)
+void log_wear_add_logical(size_t len);
+
+// Counters and projection. used_cycles is the most erased sector's count when known
+// (raw store, log_store_wear()), else 0: the projection then assumes fresh flash.
+void log_wear_get_stats(log_wear_stats_t *stats, uint32_t used_cycles);
+
+#endif // LOG_WEAR_H
@@ -0,0 +1,275 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Plaintext summaries of sealed segments for query skipping.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_zone.c
+ * @brief   Zone maps: seq, time, record kind and channel value ranges
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <string.h>
+
+#include "esp_rom_crc.h"
+
+#include "log_record.h"
+#include "log_zone.h"
+
+#if LOG_ZONE_MAP
+
+// --------------------
+// Helpers
+// --------------------
+static void put_le(uint8_t *p, uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint64_t get_le(const uint8_t *p, int bytes)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; i++) {
+        v |= (uint64_t)p[i] << (8 * i);
+    }
+    return v;
+}
+
+#if LOG_ZONE_BLOOM_BITS > 0
+static const char *const s_bloom_keys[] = { LOG_ZONE_BLOOM_KEYS };
+
+// FNV-1a (64-bit) of key '=' value; the halves drive the double hashing of the filter
+static uint64_t bloom_hash(const char *key, const char *value, size_t value_len)
+{
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (const char *p = key; *p != '\0'; p++) {
+        h = (h ^ (uint8_t)*p) * 0x100000001B3ull;
+    }
+    h = (h ^ '=') * 0x100000001B3ull;
+    for (size_t i = 0; i < value_len; i++) {
+        h = (h ^ (uint8_t)value[i]) * 0x100000001B3ull;
+    }
+    return h;
+}
+
+// Bit k of the value's LOG_ZONE_BLOOM_HASHES bits
+static uint32_t bloom_bit(uint64_t h, uint32_t k)
+{
+    const uint32_t h1 = (uint32_t)h;
+    const uint32_t h2 = (uint32_t)(h >> 32) | 1u;
+    return (h1 + k * h2) % LOG_ZONE_BLOOM_BITS;
+}
+
+static void bloom_add(log_zone_t *zone, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < sizeof(s_bloom_keys) / sizeof(s_bloom_keys[0]); i++) {
+        const char *value;
+        size_t value_len;
+        if (!log_record_json_field(data, len, s_bloom_keys[i], &value, &value_len)) {
+            continue;
+        }
+        const uint64_t h = bloom_hash(s_bloom_keys[i], value, value_len);
+        for (uint32_t k = 0; k < LOG_ZONE_BLOOM_HASHES; k++) {
+            const uint32_t bit = bloom_bit(h, k);
+            zone->bloom[bit / 8] |= (uint8_t)(1u << (bit % 8));
+        }
+    }
+}
+#endif
+
+static void channel_add(log_zone_t *zone, uint8_t channel, int32_t min, int32_t max)
+{
+    if (channel >= LOG_ZONE_CHANNELS) {
+        return;
+    }
+    const uint32_t bit = 1u << channel;
+    if (!(zone->channels & bit)) {
+        zone->channels |= bit;
+        zone->ch_min[channel] = min;
+        zone->ch_max[channel] = max;
+        return;
+    }
+    if (min < zone->ch_min[channel]) {
+        zone->ch_min[channel] = min;
+    }
+    if (max > zone->ch_max[channel]) {
+        zone->ch_max[channel] = max;
+    }
+}
+
+// --------------------
+// Public API
+// --------------------
+void log_zone_reset(log_zone_t *zone)
+{
+    memset(zone, 0, sizeof(*zone));
+}
+
+void log_zone_add(log_zone_t *zone, const uint8_t *data, size_t len, uint32_t seq,
+                  uint32_t uptime_ms, uint64_t wall_base_ms, bool priority)
+{
+    log_zone_t one;
+    log_zone_reset(&one);
+    one.records = 1;
+    one.first_seq = one.last_seq = seq;
+    one.min_uptime_ms = one.max_uptime_ms = uptime_ms;
+    if (wall_base_ms != 0) {
+        one.min_wall_ms = one.max_wall_ms = wall_base_ms + uptime_ms;
+    }
+
+    log_record_fields_t f;
+    if (!log_record_fields(data, len, &f)) {
+        one.kinds = LOG_ZONE_KIND_OTHER;
+    } else if (f.schema == RECORD_SCHEMA_AGG || f.schema == RECORD_SCHEMA_RAW) {
+        one.kinds = (f.schema == RECORD_SCHEMA_AGG) ? LOG_ZONE_KIND_AGG : LOG_ZONE_KIND_RAW;
+        channel_add(&one, f.channel, f.min, f.max);
+    } else {
+        one.kinds = LOG_ZONE_KIND_SAMPLE;
+    }
+#if LOG_ZONE_BLOOM_BITS > 0
+    // Any JSON payload, with or without seq and uptime (text_len is set either way)
+    if (len > 0 && data[0] == '{') {
+        bloom_add(&one, data, f.text_len);
+    }
+#endif
+    if (priority) {
+        one.kinds |= LOG_ZONE_KIND_PRIORITY;
+    }
+    log_zone_merge(zone, &one);
+}
+
+void log_zone_merge(log_zone_t *into, const log_zone_t *from)
+{
+    if (from->records == 0) {
+        return;
+    }
+    if (into->records == 0) {
+        *into = *from;
+        return;
+    }
+    into->records += from->records;
+    if (from->first_seq < into->first_seq) {
+        into->first_seq = from->first_seq;
+    }
+    if (from->last_seq > into->last_seq) {
+        into->last_seq = from->last_seq;
+    }
+    if (from->min_uptime_ms < into->min_uptime_ms) {
+        into->min_uptime_ms = from->min_uptime_ms;
+    }
+    if (from->max_uptime_ms > into->max_uptime_ms) {
+        into->max_uptime_ms = from->max_uptime_ms;
+    }
+    if (from->max_wall_ms != 0) {
+        if (into->max_wall_ms == 0 || from->min_wall_ms < into->min_wall_ms) {
+            into->min_wall_ms = from->min_wall_ms;
+        }
+        if (from->max_wall_ms > into->max_wall_ms) {
+            into->max_wall_ms = from->max_wall_ms;
+        }
+    }
+    into->kinds |= from->kinds;
+    for (int ch = 0; ch < LOG_ZONE_CHANNELS; ch++) {
+        if (from->channels & (1u << ch)) {
+            channel_add(into, (uint8_t)ch, from->ch_min[ch], from->ch_max[ch]);
+        }
+    }
+#if LOG_ZONE_BLOOM_BITS > 0
+    for (size_t i = 0; i < sizeof(into->bloom); i++) {
+        into->bloom[i] |= from->bloom[i];
+    }
+#endif
+}
+
+void log_zone_pack(const log_zone_t *zone, uint32_t id, uint8_t *slot)
+{
+    memcpy(slot, ZONE_SLOT_MAGIC, 4);
+    put_le(slot + 4, id, 4);
+    put_le(slot + 8, zone->first_seq, 4);
+    put_le(slot + 12, zone->last_seq, 4);
+    put_le(slot + 16, zone->records, 4);
+    put_le(slot + 20, zone->kinds, 4);
+    put_le(slot + 24, zone->min_uptime_ms, 4);
+    put_le(slot + 28, zone->max_uptime_ms, 4);
+    put_le(slot + 32, zone->min_wall_ms, 8);
+    put_le(slot + 40, zone->max_wall_ms, 8);
+    put_le(slot + 48, zone->channels, 4);
+    for (int ch = 0; ch < LOG_ZONE_CHANNELS; ch++) {
+        put_le(slot + 52 + 8 * ch, (uint32_t)zone->ch_min[ch], 4);
+        put_le(slot + 56 + 8 * ch, (uint32_t)zone->ch_max[ch], 4);
+    }
+#if LOG_ZONE_BLOOM_BITS > 0
+    memcpy(slot + 52 + 8 * LOG_ZONE_CHANNELS, zone->bloom, sizeof(zone->bloom));
+#endif
+    put_le(slot + ZONE_SLOT_BYTES - 4, esp_rom_crc32_le(0, slot, ZONE_SLOT_BYTES - 4), 4);
+}
+
+bool log_zone_unpack(const uint8_t *slot, uint32_t id, log_zone_t *zone)
+{
+    if (memcmp(slot, ZONE_SLOT_MAGIC, 4) != 0 || get_le(slot + 4, 4) != id ||
+        get_le(slot + ZONE_SLOT_BYTES - 4, 4) != esp_rom_crc32_le(0, slot, ZONE_SLOT_BYTES - 4)) {
+        return false;
+    }
+    zone->first_seq = (uint32_t)get_le(slot + 8, 4);
+    zone->last_seq = (uint32_t)get_le(slot + 12, 4);
+    zone->records = (uint32_t)get_le(slot + 16, 4);
+    zone->kinds = (uint32_t)get_le(slot + 20, 4);
+    zone->min_uptime_ms = (uint32_t)get_le(slot + 24, 4);
+    zone->max_uptime_ms = (uint32_t)get_le(slot + 28, 4);
+    zone->min_wall_ms = get_le(slot + 32, 8);
+    zone->max_wall_ms = get_le(slot + 40, 8);
+    zone->channels = (uint32_t)get_le(slot + 48, 4);
+    for (int ch = 0; ch < LOG_ZONE_CHANNELS; ch++) {
+        zone->ch_min[ch] = (int32_t)(uint32_t)get_le(slot + 52 + 8 * ch, 4);
+        zone->ch_max[ch] = (int32_t)(uint32_t)get_le(slot + 56 + 8 * ch, 4);
+    }
+#if LOG_ZONE_BLOOM_BITS > 0
+    memcpy(zone->bloom, slot + 52 + 8 * LOG_ZONE_CHANNELS, sizeof(zone->bloom));
+#endif
+    return true;
+}
+
+bool log_zone_may_contain(const log_zone_t *zone, const char *key, const char *value,
+                          size_t value_len)
+{
+#if LOG_ZONE_BLOOM_BITS > 0
+    for (size_t i = 0; i < sizeof(s_bloom_keys) / sizeof(s_bloom_keys[0]); i++) {
+        if (strcmp(s_bloom_keys[i], key) != 0) {
+            continue;
+        }
+        const uint64_t h = bloom_hash(key, value, value_len);
+        for (uint32_t k = 0; k < LOG_ZONE_BLOOM_HASHES; k++) {
+            const uint32_t bit = bloom_bit(h, k);
+            if (!(zone->bloom[bit / 8] & (1u << (bit % 8)))) {
+                return false;
+            }
+        }
+        return true;
+    }
+#else
+    (void)zone;
+    (void)value;
+    (void)value_len;
+#endif
+    (void)key;
+    return true;
+}
+
+#endif // LOG_ZONE_MAP
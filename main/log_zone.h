@@ -0,0 +1,87 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Plaintext summaries of sealed segments for query skipping.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    log_zone.h
+ * @brief   Zone maps: seq, time, record kind and channel value ranges
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    The writer folds every record into the zone of its append from the
+ *          plaintext it is about to encrypt; the store merges the zones of the
+ *          appends into the open segment's and saves it when the segment is
+ *          sealed (LOG_ZONE_MAP). The Bloom filter holds key=value of the
+ *          configured JSON keys; a lookup sets no false negatives, only false
+ *          candidates.
+ *******************************************************************************/
+#ifndef LOG_ZONE_H
+#define LOG_ZONE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "enc_log_config.h"
+
+// Record kinds
+#define LOG_ZONE_KIND_SAMPLE    0x01    // sample records
+#define LOG_ZONE_KIND_AGG       0x02    // aggregates (RECORD_SCHEMA_AGG)
+#define LOG_ZONE_KIND_RAW       0x04    // raw channel samples (RECORD_SCHEMA_RAW)
+#define LOG_ZONE_KIND_OTHER     0x08    // payloads without seq and uptime fields
+#define LOG_ZONE_KIND_PRIORITY  0x10    // priority records
+
+typedef struct {
+    uint32_t records;           // 0: empty, the ranges are not set
+    uint32_t first_seq;         // lowest and highest seq
+    uint32_t last_seq;
+    uint32_t min_uptime_ms;
+    uint32_t max_uptime_ms;
+    uint64_t min_wall_ms;       // Unix ms, records of boots with a set clock only
+    uint64_t max_wall_ms;       // 0: no such record
+    uint32_t kinds;             // LOG_ZONE_KIND_*
+    uint32_t channels;          // bit per channel with a value in ch_min / ch_max
+    int32_t ch_min[LOG_ZONE_CHANNELS];
+    int32_t ch_max[LOG_ZONE_CHANNELS];
+#if LOG_ZONE_BLOOM_BITS > 0
+    uint8_t bloom[LOG_ZONE_BLOOM_BITS / 8];     // values of LOG_ZONE_BLOOM_KEYS
+#endif
+} log_zone_t;
+
+#if LOG_ZONE_MAP
+
+void log_zone_reset(log_zone_t *zone);
+
+// Fold one plaintext record, numbered seq and logged at uptime_ms in a boot whose wall
+// clock base is wall_base_ms (0 = not set), into zone
+void log_zone_add(log_zone_t *zone, const uint8_t *data, size_t len, uint32_t seq,
+                  uint32_t uptime_ms, uint64_t wall_base_ms, bool priority);
+
+void log_zone_merge(log_zone_t *into, const log_zone_t *from);
+
+// Slot of segment id (ZONE_SLOT_BYTES, format in enc_log_config.h)
+void log_zone_pack(const log_zone_t *zone, uint32_t id, uint8_t *slot);
+
+// False if the slot is damaged, empty or of another segment
+bool log_zone_unpack(const uint8_t *slot, uint32_t id, log_zone_t *zone);
+
+// False only if zone surely holds no JSON record with "key": value. True for a key
+// outside LOG_ZONE_BLOOM_KEYS.
+bool log_zone_may_contain(const log_zone_t *zone, const char *key, const char *value,
+                          size_t value_len);
+
+#endif // LOG_ZONE_MAP
+
+#endif // LOG_ZONE_H
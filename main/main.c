@@ -34,440 +34,1777 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#include "esp_attr.h"
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_rtc_time.h"
+#include "esp_sleep.h"
+#include "esp_system.h"
 #include "esp_timer.h"
-#include "esp_vfs.h"
-#include "esp_vfs_fat.h"
-#include "driver/uart.h"
-#include "wear_levelling.h"
-#include "sdmmc_cmd.h"
-#include "driver/sdmmc_host.h"
 
 #include "optiga/optiga_crypt.h"
 #include "optiga/optiga_util.h"
-#include "optiga/common/optiga_lib_common.h"
+#include "optiga/cmd/optiga_cmd.h"
+#include "optiga/common/optiga_lib_latency.h"
+#include "optiga/common/optiga_lib_logger.h"
+#include "optiga/common/optiga_lib_trace.h"
+#include "optiga/ifx_i2c/ifx_i2c.h"
+#include "optiga/pal/pal_crypt_esp32.h"
+#include "optiga/pal/pal_i2c_capture.h"
+#include "optiga/pal/pal_logger.h"
+#include "optiga/pal/pal_os_diag.h"
+#include "optiga_async.h"
+#include "optiga_entropy.h"
+#include "optiga_hash.h"
+#include "optiga_sync.h"
+#include "optiga_trust.h"
+#ifndef CONFIG_OPTIGA_TRUST_M_LOGGING_PROFILE
+#include "trustm_offload.h"
+#ifdef CONFIG_OPTIGA_TRUST_M_ECDH_KEY_POOL
+#include "trustm_ecdh_pool.h"
+#endif
+#endif
+
+#include "enc_log.h"
+#include "log_agg.h"
+#include "log_console.h"
+#include "log_export.h"
+#include "log_load.h"
+#include "log_upload.h"
+#include "log_persona.h"
+#include "log_pm.h"
+#include "log_query.h"
+#include "log_reader.h"
+#include "log_record.h"
+#include "log_repl.h"
+#if LOG_READ_CACHE
+#include "log_cache.h"
+#endif
+#if LOG_SELFTEST
+#include "log_selftest.h"
+#endif
+#include "log_seq.h"
+#include "log_sleep.h"
+#include "log_time.h"
+#include "log_update.h"
+#include "log_wear.h"
 
 // --------------------
-// Config
+// Globals
 // --------------------
-// 0 = internal SPI flash (FATFS + wear levelling)
-// 1 = SD card via SDMMC (FATFS)
-#ifndef LOG_STORAGE_SDMMC
-#define LOG_STORAGE_SDMMC 0
+static const char *TAG = "ENC_LOG";
+
+// Counters at the previous report, for the throughput since then
+typedef struct {
+    int64_t us;
+    uint32_t records;
+    uint32_t bytes;
+} stats_window_t;
+
+static stats_window_t s_stats_console;  // 's'
+static stats_window_t s_stats_scrape;   // 'j', kept apart so 's' does not shorten its window
+
+static int s_console_pending = -1;          // byte read ahead by console_args()
+
+// Producer tasks of the 'n' group commit test
+typedef struct {
+    const char *name;
+    SemaphoreHandle_t done;
+    unsigned records;
+    uint32_t submitted;
+    uint32_t committed;
+    uint64_t submit_us;         // sum of enc_log_submit_ticket() times
+    uint64_t commit_us;         // sum of submit to commit times
+    uint32_t commit_max_us;
+} group_commit_producer_t;
+
+// --------------------
+// Console
+// --------------------
+static void print_usage(void)
+{
+    ESP_LOGI(TAG, "Commands (arguments on the same line, e.g. 'a 10'):");
+    ESP_LOGI(TAG, "  a [N] - append N encrypted records (1)");
+    ESP_LOGI(TAG, "  b [N] - OPTIGA latency jitter benchmark (N sample records, %u)", (unsigned)LOG_BENCH_RECORDS);
+    ESP_LOGI(TAG, "  c - clear log file");
+    ESP_LOGI(TAG, "  d - decrypt the whole log (streaming reader, records/s)");
+#ifndef CONFIG_OPTIGA_TRUST_M_LOGGING_PROFILE
+    ESP_LOGI(TAG, "  e - ECDSA verify / ECDH benchmark, OPTIGA vs ESP32 (seeds the auto offload policy)");
+#endif
+#if LOG_BATCH_MODE
+    ESP_LOGI(TAG, "  f - flush pending batch");
+#endif
+#ifdef OPTIGA_LIB_ENABLE_LATENCY_HISTOGRAM
+    ESP_LOGI(TAG, "  g - per-command OPTIGA latency histograms (queue, transceive, exec), then clear");
+#endif
+#ifdef PAL_CRYPT_TLS_PRF_ALT
+    ESP_LOGI(TAG, "  h - SHA-256 benchmark, OPTIGA vs ESP32 (%u bytes), handshake PRF backends",
+             (unsigned)LOG_HASH_BENCH_BYTES);
+#else
+    ESP_LOGI(TAG, "  h - SHA-256 benchmark, OPTIGA vs ESP32 (%u bytes)", (unsigned)LOG_HASH_BENCH_BYTES);
+#endif
+#ifdef PAL_I2C_CAPTURE_ENABLED
+    ESP_LOGI(TAG, "  i - save the I2C capture to %s (tools/optiga_replay), then clear it", LOG_CAPTURE_PATH);
 #endif
+    ESP_LOGI(TAG, "  j - writer statistics as one line \"STATS {json}\" (fleet monitoring)");
+    ESP_LOGI(TAG, "  k - memory: task stack high-water marks, OPTIGA heap peak, static buffers");
+    ESP_LOGI(TAG, "  l - reset I2C link counters");
+#if LOG_MERKLE_MODE
+    ESP_LOGI(TAG, "  m - sync, then print the inclusion proof of the last record");
+#endif
+    ESP_LOGI(TAG, "  n [N] - group commit test: 3 producer tasks x N records (%u), each waits for its commit",
+             (unsigned)LOG_GROUP_COMMIT_RECORDS);
+#ifdef OPTIGA_LIB_LOGGER_BINARY
+    ESP_LOGI(TAG, "  o - save the OPTIGA binary log to %s (tools/optiga_log_decode.py), then clear it",
+             LOG_OPTIGA_LOG_PATH);
+#endif
+    ESP_LOGI(TAG, "  p - print raw file (hex)");
+    ESP_LOGI(TAG, "  q - range query: 's FROM TO' (seq), 't SECONDS' (last seconds of uptime)");
+    ESP_LOGI(TAG, "      'w FROM TO' (wall clock, Unix seconds) or 'c CHANNEL MIN MAX' (aggregate and raw");
+    ESP_LOGI(TAG, "      channel values) or 'k KEY VALUE' (JSON field), after q or on the next line");
+    ESP_LOGI(TAG, "  r - reboot (OPTIGA hibernate)");
+    ESP_LOGI(TAG, "  s - writer statistics and flash wear");
+#ifdef OPTIGA_LIB_ENABLE_TRACE
+    ESP_LOGI(TAG, "  t - OPTIGA latency trace per command (then cleared)");
+#endif
+    ESP_LOGI(TAG, "  u [N] - append N priority (alarm) records, written and synced at once (1)");
+#if LOG_UPLOAD
+    ESP_LOGI(TAG, "  v [0] - upload the encrypted log to %s, from the last upload's end (0: new stream)",
+             LOG_UPLOAD_URL);
+#endif
+    ESP_LOGI(TAG, "  w - set the wall clock to Unix seconds (e.g. date +%%s on the host), after w or on the next line");
+    ESP_LOGI(TAG, "  x - binary export (tools/enc_log_export.py)");
+    ESP_LOGI(TAG, "  y - sync log to storage");
+#if LOG_SLEEP_STAGE
+    ESP_LOGI(TAG, "  z - deep-sleep logger: a reading every %u ms, written every %u wakes",
+             (unsigned)LOG_DEEP_SLEEP_MS, (unsigned)LOG_SLEEP_FLUSH_WAKES);
+#else
+    ESP_LOGI(TAG, "  z - deep sleep %u ms (OPTIGA hibernate)", (unsigned)LOG_DEEP_SLEEP_MS);
+#endif
+#if LOG_AGG_MODE
+    ESP_LOGI(TAG, "  3 [N] - aggregation demo: N s of a 100 Hz test signal with spikes (10)");
+#endif
+#if LOG_LOADGEN
+    ESP_LOGI(TAG, "  4 [S] [PCT] - soak: %u virtual producers for S s (0: until 4 again) at PCT%% of",
+             (unsigned)LOG_LOAD_PRODUCERS);
+    ESP_LOGI(TAG, "      their rates (100), \"LOAD {json}\" every %u s; 4 while running stops it",
+             (unsigned)LOG_LOAD_REPORT_S);
+#endif
+#if LOG_UPDATE
+    ESP_LOGI(TAG, "  5 [URL] - OPTIGA protected update: download a data set into %s (%s) and",
+             LOG_UPDATE_PARTITION, LOG_UPDATE_URL);
+    ESP_LOGI(TAG, "      apply it as it lands; 5 - applies the data set already in the partition");
+#endif
+#if LOG_CHANNELS > 1
+    ESP_LOGI(TAG, "  6 CH [N] - append N records to log channel CH (1..%u, 1); 6 CH d - decrypt it",
+             (unsigned)(LOG_CHANNELS - 1));
+#endif
+    ESP_LOGI(TAG, "  7 [N] - async requests: N IV + encrypt chains one at a time, then %u in flight (8)",
+             (unsigned)OPTIGA_ASYNC_POOL_SIZE);
+#if LOG_REPL
+    ESP_LOGI(TAG, "  8 [0] - replicate sealed segments to an ESP-NOW gateway, from the first it lacks");
+    ESP_LOGI(TAG, "      (0: all again); 8 g [S] - be the gateway for S s (%u, 0: until reset)",
+             (unsigned)LOG_REPL_GATEWAY_S);
+#endif
+#if LOG_READ_CACHE
+    ESP_LOGI(TAG, "  9 - wipe the read cache (plaintext kept from earlier queries and readbacks)");
+#endif
+#if LOG_SELFTEST
+    ESP_LOGI(TAG, "  0 [b] - run the self-test against the baseline (b: store it as the new baseline)");
+#endif
+}
 
-#define LOG_SDMMC_BUS_WIDTH 1
+// Records and bytes written per second since the previous call with w (since boot at first)
+static double stats_window_advance(stats_window_t *w, const enc_log_stats_t *st,
+                                   double *records_per_s, double *bytes_per_s)
+{
+    const int64_t now_us = esp_timer_get_time();
+    const double seconds = (double)(now_us - w->us) / 1e6;
+    *records_per_s = 0.0;
+    *bytes_per_s = 0.0;
+    if (seconds > 0.0) {
+        *records_per_s = (double)(st->records_written - w->records) / seconds;
+        *bytes_per_s = (double)(st->bytes_written - w->bytes) / seconds;
+    }
+    w->us = now_us;
+    w->records = st->records_written;
+    w->bytes = st->bytes_written;
+    return seconds;
+}
 
+// One line for the fleet monitoring scraper; keys are stable, new ones are only appended
+static void print_stats_json(void)
+{
+    enc_log_stats_t st;
+    enc_log_get_stats(&st);
+    double records_per_s;
+    double bytes_per_s;
+    const double window_s = stats_window_advance(&s_stats_scrape, &st, &records_per_s, &bytes_per_s);
+    log_wear_stats_t wear;
+    log_wear_get_stats(&wear, st.erase_max);
+    char years[16] = "null";
+    if (wear.projected) {
+        snprintf(years, sizeof(years), "%.2f", wear.years_left);
+    }
+    printf("STATS {\"uptime_ms\":%lld,\"submitted\":%lu,\"records_written\":%lu,"
+           "\"bytes_written\":%lu,\"dropped\":%lu,\"write_errors\":%lu,"
+           "\"optiga_requests\":%lu,\"optiga_mean_us\":%lu,\"optiga_timeouts\":%lu,"
+           "\"appends\":%lu,\"append_mean_ms\":%lu,\"append_p99_ms\":%lu,\"append_max_ms\":%lu,"
+           "\"store_syncs\":%lu,\"ring_depth\":%lu,\"ring_high_water\":%lu,\"ring_slots\":%u,"
+           "\"store_free\":%lu,\"ring_policy\":%u,\"ring_evicted\":%lu,\"ring_downsampled\":%lu,"
+           "\"submit_blocked\":%lu,\"submit_timeouts\":%lu,\"maint_pending\":%lu,"
+           "\"window_s\":%.1f,\"records_per_s\":%.2f,\"bytes_per_s\":%.1f,"
+           "\"logical_bytes\":%llu,\"flash_programmed\":%llu,\"flash_erased\":%llu,"
+           "\"write_amp\":%.3f,\"erase_cycles_per_day\":%.4f,\"flash_years\":%s,"
+           "\"inline_erases\":%lu,\"replica_lag\":%lu,\"replica_segment\":%lu,"
+           "\"replica_offset\":%lu,\"boot_mount_ms\":%lu,\"boot_open_ms\":%lu,"
+           "\"isr_queued\":%lu,\"isr_dropped\":%lu,\"isr_depth\":%lu,"
+           "\"tune_batch\":%lu,\"tune_deadline_ms\":%lu,\"tune_arrival_mrps\":%lu,"
+           "\"tune_capacity_rps\":%lu,\"tune_durable_ms\":%lu}\n",
+           (long long)(esp_timer_get_time() / 1000), (unsigned long)st.submitted,
+           (unsigned long)st.records_written, (unsigned long)st.bytes_written,
+           (unsigned long)st.dropped, (unsigned long)st.write_errors,
+           (unsigned long)st.optiga_requests, (unsigned long)st.optiga_mean_us,
+           (unsigned long)st.optiga_timeouts, (unsigned long)st.appends,
+           (unsigned long)st.append_mean_ms, (unsigned long)st.append_p99_ms,
+           (unsigned long)st.append_max_ms, (unsigned long)st.store_syncs,
+           (unsigned long)st.ring_depth, (unsigned long)st.ring_high_water,
+           (unsigned)LOG_RING_SLOTS, (unsigned long)st.store_free,
+           (unsigned)LOG_RING_POLICY, (unsigned long)st.ring_evicted,
+           (unsigned long)st.ring_downsampled, (unsigned long)st.submit_blocked,
+           (unsigned long)st.submit_timeouts, (unsigned long)st.maint_pending,
+           window_s, records_per_s, bytes_per_s, (unsigned long long)wear.logical_bytes,
+           (unsigned long long)wear.programmed_bytes, (unsigned long long)wear.erased_bytes,
+           wear.write_amp, wear.cycles_per_day, years, (unsigned long)st.inline_erases,
+           (unsigned long)st.replica_lag, (unsigned long)st.replica_segment,
+           (unsigned long)st.replica_offset, (unsigned long)st.boot_mount_ms,
+           (unsigned long)st.boot_open_ms, (unsigned long)st.isr_queued,
+           (unsigned long)st.isr_dropped, (unsigned long)st.isr_depth,
+           (unsigned long)st.tune_batch, (unsigned long)st.tune_deadline_ms,
+           (unsigned long)st.tune_arrival_mrps, (unsigned long)st.tune_capacity_rps,
+           (unsigned long)st.tune_durable_ms);
+}
+
+// Write amplification and lifetime at the ingest rate since boot (log_wear.h)
+static void print_wear(uint32_t used_cycles)
+{
+    log_wear_stats_t wear;
+    log_wear_get_stats(&wear, used_cycles);
 #if LOG_STORAGE_SDMMC
-#define LOG_MOUNT_POINT   "/sdcard"
+    ESP_LOGI(TAG, "flash wear: log on SD card, %llu bytes appended (no flash view)",
+             (unsigned long long)wear.logical_bytes);
 #else
-#define LOG_MOUNT_POINT   "/spiflash"
+    ESP_LOGI(TAG, "flash wear (%s): appended=%llu programmed=%llu (%lu writes) "
+             "erased=%llu (%lu erases) bytes",
+             LOG_STORAGE_RAW ? "raw" : (LOG_STORAGE_LITTLEFS ? "littlefs" : "fatfs+wl"),
+             (unsigned long long)wear.logical_bytes,
+             (unsigned long long)wear.programmed_bytes, (unsigned long)wear.writes,
+             (unsigned long long)wear.erased_bytes, (unsigned long)wear.erases);
+    ESP_LOGI(TAG, "write amplification x%.2f erase x%.2f, ingest %.1f bytes/s over %lu s",
+             wear.write_amp, wear.erase_amp,
+             wear.elapsed_s ? (double)wear.logical_bytes / wear.elapsed_s : 0.0,
+             (unsigned long)wear.elapsed_s);
+    if (wear.projected) {
+        ESP_LOGI(TAG, "%.4f erase cycles/sector/day over %lu KB: %.1f years to %u cycles "
+                 "(%lu used)", wear.cycles_per_day, (unsigned long)(wear.partition_bytes / 1024),
+                 wear.years_left, (unsigned)LOG_FLASH_ENDURANCE_CYCLES,
+                 (unsigned long)wear.used_cycles);
+    } else {
+        ESP_LOGI(TAG, "no erases yet on '%s': no lifetime projection",
+                 LOG_WEAR_PARTITION_LABEL);
+    }
 #endif
+}
 
-#define LOG_FILE_PATH     LOG_MOUNT_POINT "/enc_log.bin"
-#define LOG_UART_NUM      UART_NUM_0
-#define LOG_UART_BAUD     115200
+static void print_stats(void)
+{
+    enc_log_stats_t st;
+    enc_log_get_stats(&st);
+    double records_per_s;
+    double bytes_per_s;
+    const double window_s = stats_window_advance(&s_stats_console, &st, &records_per_s, &bytes_per_s);
+    ESP_LOGI(TAG, "submitted=%lu written=%lu dropped=%lu errors=%lu",
+             (unsigned long)st.submitted, (unsigned long)st.records_written,
+             (unsigned long)st.dropped, (unsigned long)st.write_errors);
+    ESP_LOGI(TAG, "bytes written=%lu syncs=%lu store free=%lu bytes optiga requests=%lu",
+             (unsigned long)st.bytes_written, (unsigned long)st.store_syncs,
+             (unsigned long)st.store_free, (unsigned long)st.optiga_requests);
+    ESP_LOGI(TAG, "store upkeep steps=%lu pending=%lu",
+             (unsigned long)st.maint_steps, (unsigned long)st.maint_pending);
+#if LOG_ISR_SUBMIT
+    ESP_LOGI(TAG, "interrupt records queued=%lu dropped=%lu waiting=%lu",
+             (unsigned long)st.isr_queued, (unsigned long)st.isr_dropped,
+             (unsigned long)st.isr_depth);
+#endif
+#if LOG_BATCH_AUTOTUNE
+    ESP_LOGI(TAG, "group tuner: %lu records, deadline %lu ms, ingest %.2f rec/s, "
+             "capacity %lu rec/s, durable in %lu ms",
+             (unsigned long)st.tune_batch, (unsigned long)st.tune_deadline_ms,
+             st.tune_arrival_mrps / 1000.0, (unsigned long)st.tune_capacity_rps,
+             (unsigned long)st.tune_durable_ms);
+#endif
+#if LOG_AGG_MODE
+    log_agg_stats_t agg;
+    log_agg_get_stats(&agg);
+    ESP_LOGI(TAG, "aggregation samples=%lu aggregates=%lu raw=%lu events=%lu dropped=%lu",
+             (unsigned long)agg.samples, (unsigned long)agg.aggregates, (unsigned long)agg.raw,
+             (unsigned long)agg.events, (unsigned long)agg.dropped);
+#endif
+#if LOG_PM
+    log_pm_stats_t pm;
+    log_pm_get_stats(&pm);
+    ESP_LOGI(TAG, "clocks held: store I/O %lu x %llu ms, I2C %lu x %llu ms; light sleep %lu x %llu ms",
+             (unsigned long)pm.io_sections, (unsigned long long)(pm.io_us / 1000),
+             (unsigned long)pm.i2c_transfers, (unsigned long long)(pm.i2c_us / 1000),
+             (unsigned long)pm.sleeps, (unsigned long long)(pm.sleep_us / 1000));
+#endif
+#if LOG_TIER_SD
+    ESP_LOGI(TAG, "SD tier lag=%lu bytes checkpoint segment %lu at %lu bytes",
+             (unsigned long)st.replica_lag, (unsigned long)st.replica_segment,
+             (unsigned long)st.replica_offset);
+#endif
+#if LOG_HYBRID_MODE
+    ESP_LOGI(TAG, "key epochs=%lu derived on the record path=%lu",
+             (unsigned long)st.key_epochs, (unsigned long)st.key_inline);
+#endif
+#if LOG_CTR_MODE
+    ESP_LOGI(TAG, "keystream blocks cached=%lu/%u records computed inline=%lu",
+             (unsigned long)st.ks_cached, (unsigned)LOG_CTR_CACHE_BLOCKS,
+             (unsigned long)st.ks_inline);
+#endif
+#if LOG_STORAGE_RAW && LOG_RAW_WEAR_SAVE_ERASES > 0
+    ESP_LOGI(TAG, "raw sector erases min=%lu max=%lu",
+             (unsigned long)st.erase_min, (unsigned long)st.erase_max);
+#endif
+#if LOG_STORAGE_RAW
+    ESP_LOGI(TAG, "raw erases on the append path=%lu (pre-erase pool %u sectors)",
+             (unsigned long)st.inline_erases, (unsigned)LOG_RAW_PREERASE_SECTORS);
+#endif
+    print_wear(st.erase_max);
+    ESP_LOGI(TAG, "append latency mean=%lu ms p99<=%lu ms max=%lu ms (%lu appends)",
+             (unsigned long)st.append_mean_ms, (unsigned long)st.append_p99_ms,
+             (unsigned long)st.append_max_ms, (unsigned long)st.appends);
+    ESP_LOGI(TAG, "throughput %.2f records/s %.1f bytes/s over the last %.1f s",
+             records_per_s, bytes_per_s, window_s);
+    ESP_LOGI(TAG, "ring depth=%lu high_water=%lu/%u",
+             (unsigned long)st.ring_depth, (unsigned long)st.ring_high_water,
+             (unsigned)LOG_RING_SLOTS);
+#if LOG_RING_POLICY == LOG_RING_BLOCK
+    ESP_LOGI(TAG, "ring policy block %u ms: blocked=%lu timeouts=%lu dropped=%lu",
+             (unsigned)LOG_RING_BLOCK_MS, (unsigned long)st.submit_blocked,
+             (unsigned long)st.submit_timeouts, (unsigned long)st.dropped);
+#elif LOG_RING_POLICY == LOG_RING_DROP_OLDEST
+    ESP_LOGI(TAG, "ring policy drop oldest: evicted=%lu dropped=%lu",
+             (unsigned long)st.ring_evicted, (unsigned long)st.dropped);
+#elif LOG_RING_POLICY == LOG_RING_DOWNSAMPLE
+    ESP_LOGI(TAG, "ring policy downsample 1/%u above %u: downsampled=%lu dropped=%lu",
+             (unsigned)LOG_RING_DOWNSAMPLE_KEEP, (unsigned)LOG_RING_DOWNSAMPLE_DEPTH,
+             (unsigned long)st.ring_downsampled, (unsigned long)st.dropped);
+#else
+    ESP_LOGI(TAG, "ring policy drop newest: dropped=%lu", (unsigned long)st.dropped);
+#endif
+    ESP_LOGI(TAG, "optiga latency last=%lu us max=%lu us timeouts=%lu",
+             (unsigned long)st.optiga_last_us, (unsigned long)st.optiga_max_us,
+             (unsigned long)st.optiga_timeouts);
+    ESP_LOGI(TAG, "optiga current limit=%lu mA changes=%lu",
+             (unsigned long)st.current_ma, (unsigned long)st.current_writes);
+#if LOG_WARM_POLICY
+    ESP_LOGI(TAG, "optiga keep-warm policy=%u warmups=%lu skipped=%lu", (unsigned)LOG_WARM_POLICY,
+             (unsigned long)st.warmups, (unsigned long)st.warm_skipped);
+#endif
+#if LOG_BATCH_PIPELINE
+    // Waits mean storage, not OPTIGA, sets the rate
+    ESP_LOGI(TAG, "priority records=%lu deadline flushes=%lu pipeline waits=%lu",
+             (unsigned long)st.priority_records, (unsigned long)st.deadline_flushes,
+             (unsigned long)st.pipeline_waits);
+#elif LOG_BATCH_MODE
+    ESP_LOGI(TAG, "priority records=%lu deadline flushes=%lu",
+             (unsigned long)st.priority_records, (unsigned long)st.deadline_flushes);
+#else
+    ESP_LOGI(TAG, "priority records=%lu", (unsigned long)st.priority_records);
+#endif
+    ESP_LOGI(TAG, "group commit waits=%lu syncs=%lu",
+             (unsigned long)st.commit_waits, (unsigned long)st.commit_groups);
+#if LOG_BATCH_COMPRESS
+    // Ratio against CPU cost: the bytes saved are OPTIGA, I2C and flash time saved
+    ESP_LOGI(TAG, "compression groups=%lu/%lu in=%lu out=%lu bytes (%lu%%) cpu=%lu us/group",
+             (unsigned long)st.lz_groups, (unsigned long)st.lz_tried,
+             (unsigned long)st.lz_in_bytes, (unsigned long)st.lz_out_bytes,
+             (unsigned long)(st.lz_in_bytes ? (uint64_t)st.lz_out_bytes * 100 / st.lz_in_bytes : 0),
+             (unsigned long)(st.lz_tried ? st.lz_us / st.lz_tried : 0));
+#endif
+#if LOG_BATCH_DELTA
+    ESP_LOGI(TAG, "delta groups=%lu/%lu in=%lu out=%lu bytes (%lu%%)",
+             (unsigned long)st.delta_groups, (unsigned long)st.delta_tried,
+             (unsigned long)st.delta_in_bytes, (unsigned long)st.delta_out_bytes,
+             (unsigned long)(st.delta_in_bytes ?
+                             (uint64_t)st.delta_out_bytes * 100 / st.delta_in_bytes : 0));
+#endif
+#if LOG_COMPACT
+    ESP_LOGI(TAG, "compaction segments=%lu groups=%lu->%lu saved=%lu bytes deferred=%lu "
+             "stack free=%lu",
+             (unsigned long)st.compact_segments, (unsigned long)st.compact_groups_in,
+             (unsigned long)st.compact_groups_out, (unsigned long)st.compact_saved,
+             (unsigned long)st.compact_deferred, (unsigned long)st.compact_stack_free);
+#endif
+#if LOG_READ_CACHE
+    log_cache_stats_t cache;
+    log_cache_get_stats(&cache);
+    ESP_LOGI(TAG, "read cache units=%lu/%lu hits=%lu misses=%lu evictions=%lu wipes=%lu",
+             (unsigned long)cache.entries, (unsigned long)cache.slots, (unsigned long)cache.hits,
+             (unsigned long)cache.misses, (unsigned long)cache.evictions,
+             (unsigned long)cache.wipes);
+#endif
+#if LOG_SELFTEST
+    log_selftest_result_t self;
+    if (log_selftest_get(&self)) {
+        ESP_LOGI(TAG, "self-test flags=0x%02X slowest=%u%% aes=%lu/%lu us i2c=%lu/%lu us "
+                 "write=%lu/%lu us read=%lu/%lu us resends=%lu (now/baseline)", (unsigned)self.slow,
+                 (unsigned)self.worst_pct, (unsigned long)self.now.aes_us,
+                 (unsigned long)self.baseline.aes_us, (unsigned long)self.now.i2c_us,
+                 (unsigned long)self.baseline.i2c_us, (unsigned long)self.now.write_us,
+                 (unsigned long)self.baseline.write_us, (unsigned long)self.now.read_us,
+                 (unsigned long)self.baseline.read_us, (unsigned long)self.now.resends);
+    }
+#endif
+#if LOG_CHANNELS > 1
+#if LOG_BATCH_MODE
+    // Requests saved: groups minus flushes
+    ESP_LOGI(TAG, "joint channel flushes=%lu groups=%lu", (unsigned long)st.joint_flushes,
+             (unsigned long)st.joint_groups);
+#endif
+    for (uint8_t c = 1; c < LOG_CHANNELS; c++) {
+        log_channel_info_t chi;
+        enc_log_channel_info(c, &chi);
+        ESP_LOGI(TAG, "channel %s segments %lu..%lu bytes=%lu dropped=%lu rotations=%lu lost=%lu",
+                 log_channel_name(c), (unsigned long)chi.first_id, (unsigned long)chi.last_id,
+                 (unsigned long)chi.bytes, (unsigned long)chi.dropped,
+                 (unsigned long)chi.rotations, (unsigned long)chi.lost);
+    }
+#endif
 
-#define AES_IV_BYTES      16
-#define PLAINTEXT_MAX     64
+    optiga_lib_pool_stats_t crypt_pool;
+    optiga_lib_pool_stats_t util_pool;
+    optiga_crypt_get_pool_stats(&crypt_pool);
+    optiga_util_get_pool_stats(&util_pool);
+    ESP_LOGI(TAG, "optiga instances crypt=%u (peak %u) util=%u (peak %u) of %u",
+             crypt_pool.in_use, crypt_pool.peak_in_use, util_pool.in_use,
+             util_pool.peak_in_use, crypt_pool.capacity);
 
-// 1 = generate a fresh key in OPTIGA on every boot (overwrites slot)
-// 0 = use existing key in OPTIGA key slot (0xE200)
-#ifndef GENERATE_KEY_ON_BOOT
-#define GENERATE_KEY_ON_BOOT 0
+#ifdef OPTIGA_CMD_GOVERNOR
+    optiga_cmd_governor_stats_t governor;
+    optiga_cmd_governor_get_stats(0, &governor);
+    ESP_LOGI(TAG, "optiga governor sec~%u/%u key commands=%lu paced=%lu (%llu ms) sec reads=%lu last=%u",
+             governor.level, (unsigned)OPTIGA_CMD_GOVERNOR_LIMIT, (unsigned long)governor.commands,
+             (unsigned long)governor.paced, (unsigned long long)(governor.paced_us / 1000),
+             (unsigned long)governor.sec_reads, governor.last_sec);
+#endif
+#ifdef OPTIGA_CMD_PROTECTION_POLICY
+    optiga_cmd_protection_stats_t protection;
+    optiga_cmd_protection_get_stats(&protection);
+    ESP_LOGI(TAG, "optiga protection policy apdus=%lu protected=%lu raised by policy=%lu",
+             (unsigned long)protection.apdus, (unsigned long)protection.protected_apdus,
+             (unsigned long)protection.raised);
+#endif
+#ifdef OPTIGA_CMD_RANDOM_COALESCE
+    ESP_LOGI(TAG, "optiga random requests coalesced=%lu", (unsigned long)optiga_cmd_random_coalesced(0));
+#endif
+#ifdef OPTIGA_UTIL_READ_CACHE_ENTRIES
+    optiga_util_read_cache_stats_t read_cache;
+    optiga_util_get_read_cache_stats(&read_cache);
+    ESP_LOGI(TAG, "optiga read cache entries=%u/%u hits=%lu misses=%lu evictions=%lu invalidations=%lu",
+             read_cache.entries, read_cache.capacity, (unsigned long)read_cache.hits,
+             (unsigned long)read_cache.misses, (unsigned long)read_cache.evictions,
+             (unsigned long)read_cache.invalidations);
 #endif
 
-// --------------------
-// Globals
-// --------------------
-static const char *TAG = "ENC_LOG";
-static wl_handle_t s_wl_handle = WL_INVALID_HANDLE;
-static uint32_t s_log_seq = 0;
-#if LOG_STORAGE_SDMMC
-static sdmmc_card_t *s_sd_card = NULL;
+    optiga_entropy_stats_t pool;
+    optiga_entropy_get_stats(&pool);
+    ESP_LOGI(TAG, "entropy pool level=%lu/%u served=%lu bytes misses=%lu refills=%lu errors=%lu",
+             (unsigned long)pool.level, (unsigned)OPTIGA_ENTROPY_POOL_BYTES,
+             (unsigned long)pool.served_bytes, (unsigned long)pool.misses,
+             (unsigned long)pool.refills, (unsigned long)pool.refill_errors);
+
+    optiga_hash_stats_t hash;
+    optiga_hash_get_stats(&hash);
+    ESP_LOGI(TAG, "hash streams optiga=%lu host=%lu optiga_commands=%lu errors=%lu",
+             (unsigned long)hash.optiga_streams, (unsigned long)hash.host_streams,
+             (unsigned long)hash.optiga_commands, (unsigned long)hash.errors);
+
+#ifdef CONFIG_OPTIGA_TRUST_M_ECDH_KEY_POOL
+    trustm_ecdh_pool_stats_t keys;
+    trustm_ecdh_pool_get_stats(&keys);
+    ESP_LOGI(TAG, "ecdh key pool ready=%lu/%u hits=%lu misses=%lu refills=%lu errors=%lu reclaimed=%lu",
+             (unsigned long)keys.ready, (unsigned)TRUSTM_ECDH_POOL_SIZE,
+             (unsigned long)keys.hits, (unsigned long)keys.misses, (unsigned long)keys.refills,
+             (unsigned long)keys.refill_errors, (unsigned long)keys.reclaimed);
 #endif
 
-static optiga_crypt_t *s_crypt = NULL;
-static optiga_util_t *s_util = NULL;
-static volatile optiga_lib_status_t s_optiga_status;
+    optiga_trust_recovery_stats_t rec;
+    optiga_trust_get_recovery_stats(&rec);
+    ESP_LOGI(TAG, "optiga recovery resync=%lu (%lu us) soft=%lu (%lu us) warm=%lu (%lu us) cold=%lu (%lu us)",
+             (unsigned long)rec.count[0], (unsigned long)rec.last_us[0],
+             (unsigned long)rec.count[1], (unsigned long)rec.last_us[1],
+             (unsigned long)rec.count[2], (unsigned long)rec.last_us[2],
+             (unsigned long)rec.count[3], (unsigned long)rec.last_us[3]);
 
-// --------------------
-// OPTIGA Helpers
-// --------------------
-void pal_os_timer_delay_in_milliseconds(uint16_t milliseconds);
+    ifx_i2c_stats_t link;
+    ifx_i2c_get_stats(&ifx_i2c_context_0, &link);
+    ESP_LOGI(TAG, "i2c link transfers=%lu nacks=%lu crc=%lu nack_tx=%lu nack_rx=%lu resend=%lu "
+             "resync_tx=%lu resync_rx=%lu chain=%lu poll_overrun=%lu poll_timeout=%lu",
+             (unsigned long)link.transfers, (unsigned long)link.i2c_nacks,
+             (unsigned long)link.dl_crc_errors, (unsigned long)link.dl_nacks_sent,
+             (unsigned long)link.dl_nacks_received, (unsigned long)link.dl_resends,
+             (unsigned long)link.dl_resyncs, (unsigned long)link.dl_resyncs_received,
+             (unsigned long)link.tl_chaining_errors, (unsigned long)link.pl_poll_overruns,
+             (unsigned long)link.pl_poll_timeouts);
+    for (unsigned i = 0; i < IFX_I2C_STATS_COMMANDS; i++) {
+        const ifx_i2c_command_stats_t *cmd = &link.command[i];
+        if (cmd->command_code == 0) {
+            break;
+        }
+        ESP_LOGI(TAG, "  cmd 0x%02X retries 0:%lu 1:%lu 2:%lu 3+:%lu failed=%lu",
+                 cmd->command_code, (unsigned long)cmd->retries[0],
+                 (unsigned long)cmd->retries[1], (unsigned long)cmd->retries[2],
+                 (unsigned long)cmd->retries[3], (unsigned long)cmd->failures);
+    }
+}
 
-static void optiga_callback(void *context, optiga_lib_status_t return_status)
+// priority: alarm record, written and synced without waiting for a batch
+static void append_encrypted_record(bool priority)
 {
-    (void)context;
-    s_optiga_status = return_status;
+    int64_t uptime_ms = esp_timer_get_time() / 1000;
+    const uint32_t seq = log_seq_next();
+#if LOG_RECORD_CBOR || LOG_RECORD_PACKED
+    // Encoded straight into the ring slot the writer encrypts from; nothing to encode
+    // when the ring has no room
+    uint32_t handle;
+    uint8_t *msg = enc_log_reserve(PLAINTEXT_MAX, priority, &handle);
+    if (msg == NULL) {
+        ESP_LOGW(TAG, "record dropped (ring full): seq=%lu", (unsigned long)seq);
+        return;
+    }
+    const size_t written = log_record_encode(msg, PLAINTEXT_MAX, LOG_RECORD_FORMAT, seq,
+                                             (uint64_t)uptime_ms);
+    if (written == 0) {
+        enc_log_cancel(handle);
+        ESP_LOGE(TAG, "record encoding failed");
+        return;
+    }
+    enc_log_commit(handle, written, seq);
+    ESP_LOGI(TAG, "submitted%s: seq=%lu uptime_ms=%lld (%u bytes %s)",
+             priority ? " (priority)" : "", (unsigned long)seq, (long long)uptime_ms,
+             (unsigned)written, LOG_RECORD_PACKED ? "packed" : "CBOR");
+#else
+    char msg[PLAINTEXT_MAX];
+    const size_t written = log_record_encode((uint8_t *)msg, sizeof(msg), RECORD_FORMAT_JSON,
+                                             seq, (uint64_t)uptime_ms);
+    if (written == 0) {
+        ESP_LOGE(TAG, "record encoding failed");
+        return;
+    }
+
+    // Hand the plaintext to the writer task; encryption happens off this task
+    if (!enc_log_submit(msg, written, seq, priority)) {
+        ESP_LOGW(TAG, "record dropped (ring full): %s", msg);
+        return;
+    }
+    ESP_LOGI(TAG, "submitted%s: %s", priority ? " (priority)" : "", msg);
+#endif
 }
 
-static bool optiga_wait(void)
+// Sync the log and hibernate OPTIGA before the CPU goes down
+static bool prepare_power_down(void)
 {
-    while (s_optiga_status == OPTIGA_LIB_BUSY) {
-        pal_os_timer_delay_in_milliseconds(5);
+    if (!enc_log_sync(5000)) {
+        ESP_LOGW(TAG, "log sync timed out, staying up.");
+        return false;
     }
-    return (s_optiga_status == OPTIGA_LIB_SUCCESS);
+    // No background TRNG refill may be queued while the application context is saved
+    optiga_entropy_pause();
+    // Without a hibernated context the next boot just pays a full application open
+    if (optiga_trust_hibernate() != OPTIGA_LIB_SUCCESS) {
+        ESP_LOGW(TAG, "OPTIGA hibernate failed.");
+    }
+    return true;
 }
 
-static bool optiga_rng_fill(uint8_t *out, uint16_t len)
+// Only returns if the log could not be synced
+static void enter_deep_sleep(void)
 {
-    s_optiga_status = OPTIGA_LIB_BUSY;
-    if (optiga_crypt_random(s_crypt, OPTIGA_RNG_TYPE_TRNG, out, len) != OPTIGA_LIB_SUCCESS) {
-        return false;
+    if (!prepare_power_down()) {
+        return;
     }
-    return optiga_wait();
+    ESP_LOGI(TAG, "deep sleep for %u ms", (unsigned)LOG_DEEP_SLEEP_MS);
+    esp_sleep_enable_timer_wakeup((uint64_t)LOG_DEEP_SLEEP_MS * 1000);
+    esp_deep_sleep_start();
 }
 
-static bool optiga_crypto_init(void)
+#if LOG_SLEEP_STAGE
+// Timer wake of the deep-sleep logger: stage this wake's reading in RTC memory and
+// sleep again before storage or OPTIGA are touched. Returns when it is time to flush.
+static void sleep_stage_wake(void)
 {
-    s_crypt = optiga_crypt_create(0, optiga_callback, NULL);
-    if (s_crypt == NULL) {
-        ESP_LOGE(TAG, "optiga_crypt_create failed");
-        return false;
+    const uint64_t rtc_ms = esp_rtc_get_time_us() / 1000;
+    const uint32_t seq = log_seq_next();
+    uint8_t msg[PLAINTEXT_MAX];
+    const size_t written = log_record_encode(msg, sizeof(msg), LOG_RECORD_FORMAT, seq, rtc_ms);
+    if (written == 0 || !log_sleep_stage(msg, written, seq)) {
+        ESP_LOGE(TAG, "reading not staged: seq=%lu", (unsigned long)seq);
     }
+    if (log_sleep_flush_due()) {
+        return;
+    }
+    ESP_LOGI(TAG, "%lu readings staged, awake %lld us", (unsigned long)log_sleep_staged(),
+             (long long)esp_timer_get_time());
+    esp_sleep_enable_timer_wakeup((uint64_t)LOG_DEEP_SLEEP_MS * 1000);
+    esp_deep_sleep_start();
+}
+#endif
 
-    s_util = optiga_util_create(0, optiga_callback, NULL);
-    if (s_util == NULL) {
-        ESP_LOGE(TAG, "optiga_util_create failed");
-        return false;
+// Appends records sample records and reports the spread of the OPTIGA request times,
+// to compare builds with and without CONFIG_OPTIGA_TRUST_M_COMMS_IRAM
+static void run_latency_benchmark(unsigned records)
+{
+    enc_log_stats_t st;
+    if (!enc_log_sync(5000)) {
+        ESP_LOGW(TAG, "benchmark: log sync timed out.");
+        return;
+    }
+    enc_log_reset_latency();
+#if LOG_PM
+    log_pm_stats_t pm_before, pm_after;
+    log_pm_get_stats(&pm_before);
+#endif
+    for (unsigned i = 0; i < records; i++) {
+        // Leave room in the ring so no sample is dropped
+        enc_log_get_stats(&st);
+        while (st.ring_depth >= LOG_RING_SLOTS - 1) {
+            vTaskDelay(1);
+            enc_log_get_stats(&st);
+        }
+        append_encrypted_record(false);
+    }
+    if (!enc_log_sync(5000)) {
+        ESP_LOGW(TAG, "benchmark: log sync timed out.");
     }
 
-    return true;
+    enc_log_get_stats(&st);
+#ifdef CONFIG_OPTIGA_TRUST_M_COMMS_IRAM
+    const char *placement = "IRAM";
+#else
+    const char *placement = "flash";
+#endif
+    ESP_LOGI(TAG, "benchmark (comms in %s): %lu requests min=%lu us mean=%lu us max=%lu us jitter=%lu us",
+             placement, (unsigned long)st.optiga_samples, (unsigned long)st.optiga_min_us,
+             (unsigned long)st.optiga_mean_us, (unsigned long)st.optiga_max_us,
+             (unsigned long)st.optiga_jitter_us);
+#if LOG_PM
+    // Includes the final sync; currents from LOG_PM_*_MA, not measured
+    log_pm_get_stats(&pm_after);
+    const uint64_t elapsed_us = pm_after.uptime_us - pm_before.uptime_us;
+    const double energy_uj = log_pm_energy_uj(&pm_before, &pm_after);
+    ESP_LOGI(TAG, "benchmark energy: %.1f uJ per record (est.), clocks held %llu%% light sleep %llu%% of %llu ms",
+             records ? energy_uj / records : 0.0,
+             (unsigned long long)(elapsed_us ? (pm_after.io_us - pm_before.io_us +
+                                                pm_after.i2c_us - pm_before.i2c_us) * 100 / elapsed_us : 0),
+             (unsigned long long)(elapsed_us ? (pm_after.sleep_us - pm_before.sleep_us) * 100 / elapsed_us : 0),
+             (unsigned long long)(elapsed_us / 1000));
+#endif
 }
 
-static bool optiga_key_ready(void)
+static void group_commit_producer(void *arg)
 {
-    uint8_t metadata[64];
-    uint16_t metadata_len = sizeof(metadata);
-    const uint16_t oid = 0xE200;
+    group_commit_producer_t *p = (group_commit_producer_t *)arg;
 
-    s_optiga_status = OPTIGA_LIB_BUSY;
-    optiga_lib_status_t ret = optiga_util_read_metadata(
-        s_util,
-        oid,
-        metadata,
-        &metadata_len);
-    if (ret != OPTIGA_LIB_SUCCESS) {
-        return false;
+    for (unsigned i = 0; i < p->records; i++) {
+        const uint32_t seq = log_seq_next();
+        uint8_t msg[PLAINTEXT_MAX];
+        const size_t len = log_record_encode(msg, sizeof(msg), LOG_RECORD_FORMAT, seq,
+                                             (uint64_t)(esp_timer_get_time() / 1000));
+        uint32_t ticket;
+        const int64_t start_us = esp_timer_get_time();
+        if (len == 0 || !enc_log_submit_ticket(msg, len, seq, false, &ticket)) {
+            continue;
+        }
+        const int64_t queued_us = esp_timer_get_time();
+        p->submitted++;
+        p->submit_us += (uint64_t)(queued_us - start_us);
+        if (enc_log_wait_commit(ticket, 5000)) {
+            const uint32_t commit_us = (uint32_t)(esp_timer_get_time() - start_us);
+            p->committed++;
+            p->commit_us += commit_us;
+            if (commit_us > p->commit_max_us) {
+                p->commit_max_us = commit_us;
+            }
+        }
     }
-    if (!optiga_wait()) {
-        return false;
+    xSemaphoreGive(p->done);
+    vTaskDelete(NULL);
+}
+
+// Three tasks log at once and each waits for every record to be durable. The writer
+// takes the records of all of them and commits them with one sync, so waits per sync
+// shows how well commits are grouped
+static void run_group_commit_test(unsigned records)
+{
+    static const char *const names[] = { "gc_sensor", "gc_network", "gc_health" };
+    group_commit_producer_t producers[3];
+    enc_log_stats_t before, after;
+
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(3, 0);
+    if (done == NULL) {
+        return;
     }
-    if (metadata_len == 0) {
-        return false;
+    enc_log_get_stats(&before);
+    const int64_t start_us = esp_timer_get_time();
+    unsigned started = 0;
+    for (unsigned i = 0; i < 3; i++) {
+        memset(&producers[i], 0, sizeof(producers[i]));
+        producers[i].name = names[i];
+        producers[i].done = done;
+        producers[i].records = records;
+        if (xTaskCreate(group_commit_producer, names[i], 4096, &producers[i],
+                        LOG_WRITER_PRIORITY - 1, NULL) == pdPASS) {
+            started++;
+        }
+    }
+    for (unsigned i = 0; i < started; i++) {
+        xSemaphoreTake(done, portMAX_DELAY);
     }
+    const int64_t elapsed_us = esp_timer_get_time() - start_us;
+    vSemaphoreDelete(done);
+    enc_log_get_stats(&after);
 
-    ESP_LOGI(TAG, "OPTIGA key metadata length: %u", (unsigned)metadata_len);
-    return true;
+    for (unsigned i = 0; i < started; i++) {
+        const group_commit_producer_t *p = &producers[i];
+        ESP_LOGI(TAG, "%-10s committed=%lu/%lu submit mean=%lu us commit mean=%lu us max=%lu us",
+                 p->name, (unsigned long)p->committed, (unsigned long)p->submitted,
+                 (unsigned long)(p->submitted ? p->submit_us / p->submitted : 0),
+                 (unsigned long)(p->committed ? p->commit_us / p->committed : 0),
+                 (unsigned long)p->commit_max_us);
+    }
+    const uint32_t waits = after.commit_waits - before.commit_waits;
+    const uint32_t syncs = after.commit_groups - before.commit_groups;
+    ESP_LOGI(TAG, "group commit: %lu waits in %lu syncs (%.2f per sync), %lu store syncs, %lld ms",
+             (unsigned long)waits, (unsigned long)syncs, syncs ? (double)waits / syncs : 0.0,
+             (unsigned long)(after.store_syncs - before.store_syncs), (long long)(elapsed_us / 1000));
 }
 
-static bool optiga_write_e200_metadata(void)
+#if LOG_AGG_MODE
+// Two channels at 100 Hz: a triangle wave with a spike every 2 s on channel 0 and a
+// flat level on channel 1. Reports how many records reached the writer per sample
+static void run_agg_demo(unsigned seconds)
 {
-    static const uint8_t e200_metadata[] = {0x20, 0x06, 0xD0, 0x01,
-                                            0x00, 0xD3, 0x01, 0x00};
-    const uint16_t oid = 0xE200;
+    log_agg_stats_t before, after;
 
-    // Metadata config enables AES key usage in slot 0xE200
-    ESP_LOGI(TAG, "Writing metadata for OPTIGA key slot 0xE200");
-    s_optiga_status = OPTIGA_LIB_BUSY;
-    optiga_lib_status_t ret = optiga_util_write_metadata(
-        s_util,
-        oid,
-        e200_metadata,
-        sizeof(e200_metadata));
-    if (ret != OPTIGA_LIB_SUCCESS) {
-        ESP_LOGE(TAG, "optiga_util_write_metadata start failed: 0x%04X", ret);
-        return false;
+    log_agg_configure(0, LOG_AGG_WINDOW_MS, -100, 2000);
+    log_agg_configure(1, LOG_AGG_WINDOW_MS, 1, 0);
+    log_agg_get_stats(&before);
+    for (unsigned i = 0; i < seconds * 100; i++) {
+        const uint64_t now_ms = (uint64_t)(esp_timer_get_time() / 1000);
+        const int32_t tri = (int32_t)(i % 100) * 20;
+        log_agg_sample(0, (i % 200 == 150) ? 5000 : (tri <= 1000 ? tri : 2000 - tri), now_ms);
+        log_agg_sample(1, 500 + (int32_t)(i % 3), now_ms);
+        vTaskDelay(pdMS_TO_TICKS(10));
     }
-    if (!optiga_wait()) {
-        ESP_LOGE(TAG, "optiga_util_write_metadata failed");
-        return false;
+    log_agg_flush(UINT64_MAX);
+    if (!enc_log_sync(5000)) {
+        ESP_LOGW(TAG, "aggregation: log sync timed out.");
+    }
+
+    log_agg_get_stats(&after);
+    const uint32_t samples = after.samples - before.samples;
+    const uint32_t records = (after.aggregates - before.aggregates) + (after.raw - before.raw);
+    ESP_LOGI(TAG, "aggregation: %lu samples -> %lu aggregates + %lu raw (%lu events, %lu dropped), "
+             "%.1f samples per record",
+             (unsigned long)samples, (unsigned long)(after.aggregates - before.aggregates),
+             (unsigned long)(after.raw - before.raw), (unsigned long)(after.events - before.events),
+             (unsigned long)(after.dropped - before.dropped),
+             records ? (double)samples / records : 0.0);
+}
+#endif
+
+#if LOG_LOADGEN
+// Start a soak run of the synthetic load generator, or stop the one running
+static void run_soak(const char *args)
+{
+    if (log_load_running()) {
+        log_load_stop();
+        ESP_LOGI(TAG, "soak stopping, final report follows.");
+        return;
+    }
+    unsigned long seconds = 0;
+    unsigned long pct = 100;
+    if (sscanf(args, "%lu %lu", &seconds, &pct) < 1) {
+        seconds = 0;
     }
+    if (pct == 0 || pct > 10000 || !log_load_start((uint32_t)seconds, (uint32_t)pct)) {
+        ESP_LOGW(TAG, "soak not started.");
+    }
+}
+#endif
+
+// JSON records as text, anything else (CBOR) as hex
+static void print_plaintext(const char *what, const uint8_t *data, size_t len)
+{
+    if (len > 0 && data[0] == '{') {
+        ESP_LOGI(TAG, "%s: %.*s", what, (int)strnlen((const char *)data, len), (const char *)data);
+        return;
+    }
+    ESP_LOGI(TAG, "%s (%u bytes):", what, (unsigned)len);
+    ESP_LOG_BUFFER_HEX_LEVEL(TAG, data, len, ESP_LOG_INFO);
+}
+
+typedef struct {
+    uint8_t last[PLAINTEXT_MAX];
+    uint16_t last_len;
+} readback_t;
+
+static bool readback_record(const log_reader_record_t *rec, void *ctx)
+{
+    readback_t *rb = (readback_t *)ctx;
+    memcpy(rb->last, rec->data, rec->len);
+    rb->last_len = rec->len;
     return true;
 }
 
-static bool optiga_generate_key_if_enabled(void)
+// Decrypts the whole log with the streaming reader and reports the readback rate
+static void run_readback(void)
 {
-    if (GENERATE_KEY_ON_BOOT) {
-        ESP_LOGW(TAG, "GENERATE_KEY_ON_BOOT=1 (will overwrite key)");
-        if (!optiga_write_e200_metadata()) {
-            return false;
+    readback_t rb = {.last_len = 0};
+    log_reader_stats_t st;
+    enc_log_snapshot_t snap;
+    enc_log_snapshot_open(&snap);
+    const bool ok = log_reader_scan(enc_log_snapshot_read, &snap, INDEX_NO_EPOCH, 0, snap.size,
+                                    readback_record, &rb, &st);
+    enc_log_snapshot_close(&snap);
+    const uint32_t rate = (st.elapsed_us > 0)
+                              ? (uint32_t)((uint64_t)st.records * 1000000u / st.elapsed_us) : 0;
+    ESP_LOGI(TAG, "readback%s: %lu records (%lu units, %lu decrypt requests, %lu errors, "
+             "%lu bad checksums, %lu bad tags), %lu bytes in %lu ms = %lu records/s",
+             ok ? "" : " stopped", (unsigned long)st.records, (unsigned long)st.units,
+             (unsigned long)st.requests, (unsigned long)st.errors,
+             (unsigned long)st.bad_checksums, (unsigned long)st.bad_tags, (unsigned long)st.bytes,
+             (unsigned long)(st.elapsed_us / 1000), (unsigned long)rate);
+    if (rb.last_len > 0) {
+        print_plaintext("last record", rb.last, rb.last_len);
+    }
+}
+
+#if LOG_CHANNELS > 1
+static uint32_t s_channel_seq[LOG_CHANNELS];
+
+// "CH [N]" appends N JSON records to channel CH, "CH d" decrypts the channel
+static void run_channel(const char *args)
+{
+    unsigned long ch = 0;
+    char what[8] = "";
+    if (sscanf(args, "%lu %7s", &ch, what) < 1 || ch == 0 || ch >= LOG_CHANNELS) {
+        ESP_LOGW(TAG, "channel 1..%u expected", (unsigned)(LOG_CHANNELS - 1));
+        return;
+    }
+    if (what[0] == 'd' || what[0] == 'D') {
+        readback_t rb = {.last_len = 0};
+        log_reader_stats_t st;
+        enc_log_snapshot_t snap;
+        enc_log_snapshot_open_channel(&snap, (uint8_t)ch);
+        const bool ok = log_reader_scan(enc_log_snapshot_read, &snap, INDEX_NO_EPOCH, 0,
+                                        snap.size, readback_record, &rb, &st);
+        enc_log_snapshot_close(&snap);
+        ESP_LOGI(TAG, "channel %s%s: %lu records (%lu errors), %lu bytes",
+                 log_channel_name((uint8_t)ch), ok ? "" : " stopped", (unsigned long)st.records,
+                 (unsigned long)st.errors, (unsigned long)st.bytes);
+        if (rb.last_len > 0) {
+            print_plaintext("last record", rb.last, rb.last_len);
         }
-    } else {
-        if (optiga_key_ready()) {
-            ESP_LOGI(TAG, "Using existing OPTIGA key (OID 0xE200)");
-            return true;
+        return;
+    }
+    unsigned long n = 0;
+    if (what[0] == '\0' || sscanf(what, "%lu", &n) != 1 || n == 0 || n > UINT16_MAX) {
+        n = 1;
+    }
+    unsigned sent = 0;
+    for (; n > 0; n--) {
+        const uint32_t seq = ++s_channel_seq[ch];
+        char msg[PLAINTEXT_MAX];
+        const size_t written = log_record_encode((uint8_t *)msg, sizeof(msg), RECORD_FORMAT_JSON,
+                                                 seq, (uint64_t)(esp_timer_get_time() / 1000));
+        if (written == 0 ||
+            !enc_log_submit_channel((uint8_t)ch, msg, written, seq, false, NULL)) {
+            break;
         }
+        sent++;
+    }
+    ESP_LOGI(TAG, "channel %s: %u records submitted%s", log_channel_name((uint8_t)ch), sent,
+             (n > 0) ? ", ring full" : "");
+}
+#endif
 
-        ESP_LOGI(TAG, "OPTIGA key not ready. Initializing...");
-        if (!optiga_write_e200_metadata()) {
-            return false;
+// Next console byte, the read-ahead one first; waits up to wait ticks for the driver
+static bool console_byte(uint8_t *ch, TickType_t wait)
+{
+    if (s_console_pending >= 0) {
+        *ch = (uint8_t)s_console_pending;
+        s_console_pending = -1;
+        return true;
+    }
+    return log_console_read(ch, 1, wait) == 1;
+}
+
+// One line from the console, without the line ending and leading blanks; false on timeout.
+// Blocks in the driver until a byte arrives or the time is up.
+static bool read_line(char *line, size_t cap, uint32_t timeout_ms)
+{
+    const int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    size_t len = 0;
+    int64_t now;
+    while ((now = esp_timer_get_time()) < deadline) {
+        uint8_t ch;
+        if (!console_byte(&ch, pdMS_TO_TICKS((deadline - now) / 1000) + 1)) {
+            continue;
+        }
+        if (ch == '\r' || ch == '\n') {
+            if (len == 0) {
+                continue;
+            }
+            line[len] = '\0';
+            return true;
+        }
+        if ((len > 0 || ch != ' ') && len + 1 < cap) {
+            line[len++] = (char)ch;
         }
     }
+    return false;
+}
 
-    // Generate and store the AES-128 key inside OPTIGA
-    ESP_LOGI(TAG, "Generating AES-128 key in OPTIGA (OID 0xE200)...");
-    s_optiga_status = OPTIGA_LIB_BUSY;
-    optiga_key_id_t key_id = OPTIGA_KEY_ID_SECRET_BASED;
-    optiga_lib_status_t ret = optiga_crypt_symmetric_generate_key(
-        s_crypt,
-        OPTIGA_SYMMETRIC_AES_128,
-        (uint8_t)OPTIGA_KEY_USAGE_ENCRYPTION,
-        FALSE,
-        &key_id);
-    if (ret != OPTIGA_LIB_SUCCESS) {
-        ESP_LOGE(TAG, "optiga_crypt_symmetric_generate_key start failed: 0x%04X", ret);
-        return false;
+// Arguments after a command letter: the rest of its line when a blank follows at once
+// ("a 10"), else an empty string and the byte is left for the next command. Commands
+// without arguments never look, so bytes after 'x' stay with the export request.
+static void console_args(char *args, size_t cap)
+{
+    uint8_t ch;
+    args[0] = '\0';
+    if (!console_byte(&ch, 0)) {
+        return;
     }
-    if (!optiga_wait()) {
-        ESP_LOGE(TAG, "optiga_crypt_symmetric_generate_key failed");
-        return false;
+    if (ch != ' ') {
+        s_console_pending = ch;
+        return;
+    }
+    if (!read_line(args, cap, LOG_CONSOLE_ARG_MS)) {
+        args[0] = '\0';
     }
-    ESP_LOGI(TAG, "AES key generated in OPTIGA");
-    return true;
 }
 
-// --------------------
-// Storage Helpers
-// --------------------
-static void print_usage(void)
+// Count argument of a command; fallback if none is given or it does not parse
+static unsigned console_count(const char *args, unsigned fallback)
 {
-    ESP_LOGI(TAG, "Commands:");
-    ESP_LOGI(TAG, "  a - append encrypted record");
-    ESP_LOGI(TAG, "  c - clear log file");
-    ESP_LOGI(TAG, "  p - print raw file (hex)");
+    unsigned long n = 0;
+    return (sscanf(args, "%lu", &n) == 1 && n > 0 && n <= UINT16_MAX) ? (unsigned)n : fallback;
 }
 
-static void print_log_file_hex(void)
+// Matching records go out raw, one JSON object per line, for the host to collect
+static void query_emit(const char *json, size_t len, void *ctx)
 {
-    FILE *f = fopen(LOG_FILE_PATH, "rb");
-    if (!f) {
-        ESP_LOGI(TAG, "no existing log file found.");
-        return;
+    (void)ctx;
+    log_console_write(json, len);
+    log_console_write("\n", 1);
+}
+
+// Decrypt requests a query still made, and the units the read cache spared it
+static void query_cache_report(const log_query_stats_t *st)
+{
+#if LOG_READ_CACHE
+    ESP_LOGI(TAG, "read cache: %lu units cached, %lu decrypt requests",
+             (unsigned long)st->reader.cached, (unsigned long)st->reader.requests);
+#else
+    (void)st;
+#endif
+}
+
+// args: the query given after 'q' on the same line, else it is prompted for
+static void run_query(const char *args)
+{
+    char line[32];
+    if (args[0] != '\0') {
+        snprintf(line, sizeof(line), "%s", args);
+    } else {
+        ESP_LOGI(TAG, "query: 's FROM TO', 't SECONDS', 'w FROM TO', 'c CHANNEL MIN MAX' or 'k KEY VALUE'");
+        if (!read_line(line, sizeof(line), LOG_QUERY_LINE_TIMEOUT_MS)) {
+            ESP_LOGW(TAG, "no query entered.");
+            return;
+        }
     }
 
-    ESP_LOGI(TAG, "raw file content (hex):");
-    uint8_t buf[32];
-    size_t n = 0;
-    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
-        ESP_LOG_BUFFER_HEX_LEVEL(TAG, buf, n, ESP_LOG_INFO);
+    unsigned long a = 0;
+    unsigned long b = 0;
+    unsigned ch = 0;
+    long lo = 0;
+    long hi = 0;
+    char key[16];
+    char value[16];
+    log_store_seek_t by;
+    uint32_t from;
+    uint32_t to;
+    if (sscanf(line, "s %lu %lu", &a, &b) == 2) {
+        by = LOG_STORE_SEEK_SEQ;
+        from = (uint32_t)a;
+        to = (uint32_t)b;
+    } else if (sscanf(line, "w %lu %lu", &a, &b) == 2) {
+        by = LOG_STORE_SEEK_TIME;
+        from = (uint32_t)a;
+        to = (uint32_t)b;
+    } else if (sscanf(line, "c %u %ld %ld", &ch, &lo, &hi) == 3 && ch <= UINT8_MAX) {
+        log_query_stats_t st;
+        const bool ok = log_query_channel((uint8_t)ch, (int32_t)lo, (int32_t)hi, query_emit, NULL, &st);
+        ESP_LOGI(TAG, "query%s: %lu channel %u records, %lu decrypted outside the range, "
+                 "%lu segments skipped, %lu log bytes in %lu ms", ok ? "" : " stopped",
+                 (unsigned long)st.matched, ch, (unsigned long)st.skipped,
+                 (unsigned long)st.zones_skipped, (unsigned long)st.reader.bytes,
+                 (unsigned long)(st.reader.elapsed_us / 1000));
+        query_cache_report(&st);
+        return;
+    } else if (sscanf(line, "k %15s %15s", key, value) == 2) {
+        log_query_stats_t st;
+        const bool ok = log_query_key(key, value, query_emit, NULL, &st);
+        ESP_LOGI(TAG, "query%s: %lu records with %s=%s, %lu others decrypted, %lu segments "
+                 "skipped, %lu log bytes in %lu ms", ok ? "" : " stopped",
+                 (unsigned long)st.matched, key, value, (unsigned long)st.skipped,
+                 (unsigned long)st.zones_skipped, (unsigned long)st.reader.bytes,
+                 (unsigned long)(st.reader.elapsed_us / 1000));
+        query_cache_report(&st);
+        return;
+    } else if (sscanf(line, "t %lu", &a) == 1) {
+        // Index uptimes are 32-bit milliseconds of the current boot
+        const uint64_t now_ms = (uint64_t)(esp_timer_get_time() / 1000);
+        const uint64_t span_ms = (uint64_t)a * 1000;
+        by = LOG_STORE_SEEK_UPTIME;
+        to = (now_ms > UINT32_MAX) ? UINT32_MAX : (uint32_t)now_ms;
+        from = (span_ms >= to) ? 0 : to - (uint32_t)span_ms;
+    } else {
+        ESP_LOGW(TAG, "bad query: %s", line);
+        return;
     }
-    fclose(f);
+
+    log_query_stats_t st;
+    const bool ok = log_query_run(by, from, to, query_emit, NULL, &st);
+    ESP_LOGI(TAG, "query%s: %lu records from offset %lu (%s), %lu decrypted outside the "
+             "range, %lu segments skipped, %lu log bytes in %lu ms", ok ? "" : " stopped",
+             (unsigned long)st.matched, (unsigned long)st.start,
+             st.indexed ? "index" : "full scan", (unsigned long)st.skipped,
+             (unsigned long)st.zones_skipped, (unsigned long)st.reader.bytes,
+             (unsigned long)(st.reader.elapsed_us / 1000));
+    query_cache_report(&st);
 }
 
-static bool encrypt_record(const uint8_t *plaintext, size_t pt_len,
-                           uint8_t *record, size_t record_len)
+static void set_wall_clock(const char *args)
 {
-    if (record_len < (AES_IV_BYTES + PLAINTEXT_MAX)) {
-        return false;
+    char line[16];
+    unsigned long unix_s = 0;
+    if (args[0] != '\0') {
+        snprintf(line, sizeof(line), "%s", args);
+    } else {
+        ESP_LOGI(TAG, "Unix seconds:");
+        if (!read_line(line, sizeof(line), LOG_QUERY_LINE_TIMEOUT_MS)) {
+            line[0] = '\0';
+        }
+    }
+    if (sscanf(line, "%lu", &unix_s) != 1 || !log_time_set((uint32_t)unix_s)) {
+        ESP_LOGW(TAG, "wall clock not changed.");
+        return;
     }
+    // New index entries carry the base from here on; earlier ones keep theirs
+    ESP_LOGI(TAG, "wall clock set: %lu s, base %llu ms", unix_s,
+             (unsigned long long)log_time_base_ms());
+}
 
-    uint8_t iv[AES_IV_BYTES];
-    uint8_t ciphertext[PLAINTEXT_MAX];
+#if defined(PAL_CRYPT_TLS_PRF_ALT) && defined(OPTIGA_COMMS_SHIELDED_CONNECTION)
+// Mean time of one PRF call with the sizes of the handshake: 64 byte secret, 32 byte
+// random, 40 byte session keys. 0 if a call failed
+static uint32_t prf_bench(unsigned iterations)
+{
+    static const char label[] = "Platform Binding";
+    uint8_t secret[64];
+    uint8_t random[32];
+    uint8_t keys[40];
+    memset(secret, 0xA5, sizeof(secret));
+    memset(random, 0x5A, sizeof(random));
 
-    // Generate random IV using OPTIGA TRNG (one per record)
-    if (!optiga_rng_fill(iv, sizeof(iv))) {
-        ESP_LOGE(TAG, "IV generation failed");
-        return false;
+    const int64_t start = esp_timer_get_time();
+    for (unsigned i = 0; i < iterations; i++) {
+        if (pal_crypt_tls_prf_sha256(NULL, secret, sizeof(secret), (const uint8_t *)label,
+                                     sizeof(label) - 1, random, sizeof(random), keys,
+                                     sizeof(keys)) != PAL_STATUS_SUCCESS) {
+            return 0;
+        }
     }
+    return (uint32_t)((esp_timer_get_time() - start) / iterations);
+}
 
-    uint8_t pt_buf[PLAINTEXT_MAX];
-    memset(pt_buf, 0, sizeof(pt_buf));
-    memcpy(pt_buf, plaintext, pt_len);
-
-    uint32_t cipher_len = sizeof(ciphertext);
-    s_optiga_status = OPTIGA_LIB_BUSY;
-    // OPTIGA performs AES-CBC using the key in slot 0xE200
-    optiga_lib_status_t ret = optiga_crypt_symmetric_encrypt(
-        s_crypt,
-        OPTIGA_SYMMETRIC_CBC,
-        OPTIGA_KEY_ID_SECRET_BASED,
-        pt_buf,
-        sizeof(pt_buf),
-        iv,
-        sizeof(iv),
-        NULL,
-        0,
-        ciphertext,
-        &cipher_len);
-    if (ret != OPTIGA_LIB_SUCCESS) {
-        ESP_LOGE(TAG, "optiga_crypt_symmetric_encrypt start failed: 0x%04X", ret);
-        return false;
+// Mean time of a protected read of the security event counter on a re-established
+// channel: the full handshake (PRF included) and one protected APDU. 0 if one failed
+static uint32_t handshake_bench(optiga_util_t *util, optiga_sync_t *sync, unsigned iterations)
+{
+    int64_t total_us = 0;
+    for (unsigned i = 0; i < iterations; i++) {
+        uint8_t sec = 0;
+        uint16_t sec_len = sizeof(sec);
+        const int64_t start = esp_timer_get_time();
+        OPTIGA_UTIL_SET_COMMS_PROTECTION_LEVEL(util,
+                                               OPTIGA_COMMS_FULL_PROTECTION | OPTIGA_COMMS_RE_ESTABLISH);
+        if (OPTIGA_SYNC_CALL(sync, LOG_OPTIGA_TIMEOUT_MS,
+                             optiga_util_read_data(util, 0xE0C5, 0, &sec, &sec_len)) !=
+            OPTIGA_LIB_SUCCESS) {
+            return 0;
+        }
+        total_us += esp_timer_get_time() - start;
     }
-    if (!optiga_wait()) {
-        ESP_LOGE(TAG, "optiga_crypt_symmetric_encrypt failed");
-        return false;
+    return (uint32_t)(total_us / iterations);
+}
+
+static void run_handshake_benchmark(void)
+{
+    static optiga_util_t *util = NULL;
+    static optiga_sync_t sync;
+    static const struct {
+        pal_crypt_prf_backend_t backend;
+        const char *name;
+    } backends[] = {
+        { PAL_CRYPT_PRF_BACKEND_SHA_HW, "sha-hw" },
+        { PAL_CRYPT_PRF_BACKEND_MD, "mbedtls-md" },
+    };
+
+    if (!enc_log_wait_ready(LOG_OPTIGA_TIMEOUT_MS)) {
+        ESP_LOGW(TAG, "handshake benchmark: OPTIGA not ready");
+        return;
     }
-    if (cipher_len != sizeof(ciphertext)) {
-        ESP_LOGE(TAG, "unexpected ciphertext length: %lu", (unsigned long)cipher_len);
-        return false;
+    if (util == NULL) {
+        util = optiga_util_create(0, optiga_sync_callback, &sync);
+        if (util == NULL) {
+            ESP_LOGW(TAG, "handshake benchmark: optiga_util_create failed");
+            return;
+        }
     }
-
-    // Record format: IV (16B) + Ciphertext (64B) = 80B
-    memcpy(record, iv, sizeof(iv));
-    memcpy(record + sizeof(iv), ciphertext, sizeof(ciphertext));
-    return true;
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+        pal_crypt_set_prf_backend(backends[i].backend);
+        const uint32_t prf_us = prf_bench(LOG_HANDSHAKE_BENCH_ITERATIONS);
+        const uint32_t handshake_us = handshake_bench(util, &sync, LOG_HANDSHAKE_BENCH_ITERATIONS);
+        // 0 us means the PRF or a handshake failed
+        ESP_LOGI(TAG, "handshake prf=%-10s prf=%lu us handshake+read=%lu us (%u runs)",
+                 backends[i].name, (unsigned long)prf_us, (unsigned long)handshake_us,
+                 (unsigned)LOG_HANDSHAKE_BENCH_ITERATIONS);
+    }
+    pal_crypt_set_prf_backend(PAL_CRYPT_PRF_BACKEND_SHA_HW);
 }
+#endif
 
-static void append_encrypted_record(void)
+static void run_hash_benchmark(void)
 {
-    char msg[PLAINTEXT_MAX];
-    int64_t uptime_ms = esp_timer_get_time() / 1000;
-    s_log_seq++;
-    int written = snprintf(msg, sizeof(msg),
-                           "{\"seq\":%lu,\"uptime_ms\":%lld}",
-                           (unsigned long)s_log_seq,
-                           (long long)uptime_ms);
-    if (written < 0) {
-        ESP_LOGE(TAG, "snprintf failed");
+    optiga_hash_result_t res;
+    if (optiga_hash_benchmark(LOG_HASH_BENCH_BYTES, LOG_HASH_BENCH_ITERATIONS, &res) != OPTIGA_LIB_SUCCESS) {
+        ESP_LOGW(TAG, "hash benchmark failed");
         return;
     }
+    // 0 us means OPTIGA hashing failed or is not built (encrypted logger profile)
+    ESP_LOGI(TAG, "sha256 %u bytes: optiga=%lu us host=%lu us mux=%lu us (%lu swaps/stream)",
+             (unsigned)LOG_HASH_BENCH_BYTES, (unsigned long)res.optiga_us, (unsigned long)res.host_us,
+             (unsigned long)res.mux_us, (unsigned long)res.mux_swaps);
+#if defined(PAL_CRYPT_TLS_PRF_ALT) && defined(OPTIGA_COMMS_SHIELDED_CONNECTION)
+    run_handshake_benchmark();
+#endif
+}
+
+// One TRNG IV, then an AES-CBC record under it: the second step is started by the
+// first one's continuation on the same request, so waiting on it waits for both
+typedef struct {
+    optiga_async_t *req;
+    uint8_t iv[AES_IV_BYTES];
+    uint8_t block[PLAINTEXT_MAX];
+    uint32_t block_len;
+} async_chain_t;
 
-    // Record format: IV (16B) + Ciphertext (64B) = 80B
-    uint8_t record[AES_IV_BYTES + PLAINTEXT_MAX];
-    if (!encrypt_record((const uint8_t *)msg, (size_t)written, record, sizeof(record))) {
-        ESP_LOGE(TAG, "encrypt_record failed");
+static void async_chain_encrypt(optiga_async_t *req, optiga_lib_status_t status, void *ctx)
+{
+    async_chain_t *c = (async_chain_t *)ctx;
+    if (status != OPTIGA_LIB_SUCCESS) {
         return;
     }
+    c->block_len = sizeof(c->block);
+    OPTIGA_ASYNC_CALL(req, optiga_crypt_symmetric_encrypt(
+        optiga_async_crypt(req), OPTIGA_SYMMETRIC_CBC, OPTIGA_KEY_ID_SECRET_BASED, c->block,
+        sizeof(c->block), c->iv, sizeof(c->iv), NULL, 0, c->block, &c->block_len));
+}
 
-    FILE *f = fopen(LOG_FILE_PATH, "ab");
-    if (!f) {
-        ESP_LOGE(TAG, "failed to open log file for append");
+// False if no request was free in time
+static bool async_chain_start(async_chain_t *c, unsigned n)
+{
+    c->req = optiga_async_acquire(LOG_OPTIGA_TIMEOUT_MS);
+    if (c->req == NULL) {
+        return false;
+    }
+    memset(c->block, 0, sizeof(c->block));
+    snprintf((char *)c->block, sizeof(c->block), "{\"async\":%u}", n);
+    OPTIGA_ASYNC_CALL(c->req, optiga_crypt_random(optiga_async_crypt(c->req), OPTIGA_RNG_TYPE_TRNG,
+                                                  c->iv, sizeof(c->iv)));
+    optiga_async_then(c->req, async_chain_encrypt, c);
+    return true;
+}
+
+// Result of the chain, request released
+static bool async_chain_finish(async_chain_t *c)
+{
+    const bool ok = optiga_async_wait(c->req, LOG_OPTIGA_TIMEOUT_MS) == OPTIGA_LIB_SUCCESS &&
+                    c->block_len == sizeof(c->block);
+    optiga_async_release(c->req);
+    c->req = NULL;
+    return ok;
+}
+
+// IV + encrypt chains awaited one by one, then OPTIGA_ASYNC_POOL_SIZE of them in flight
+// at once: the host prepares and collects requests while OPTIGA works on the queue
+static void run_async_demo(unsigned chains)
+{
+    static async_chain_t c[OPTIGA_ASYNC_POOL_SIZE];
+    unsigned failed = 0;
+
+    if (!enc_log_wait_ready(LOG_OPTIGA_TIMEOUT_MS)) {
+        ESP_LOGW(TAG, "async demo: OPTIGA not ready");
         return;
     }
+    int64_t t0 = esp_timer_get_time();
+    for (unsigned i = 0; i < chains; i++) {
+        // A chain that timed out may still use its buffers: stop there
+        if (!async_chain_start(&c[0], i) || !async_chain_finish(&c[0])) {
+            failed++;
+            break;
+        }
+    }
+    const int64_t serial_us = esp_timer_get_time() - t0;
 
-    fwrite(record, 1, sizeof(record), f);
-    fclose(f);
+    t0 = esp_timer_get_time();
+    for (unsigned done = 0; done < chains && failed == 0;) {
+        const unsigned wave = (chains - done < OPTIGA_ASYNC_POOL_SIZE) ? chains - done
+                                                                        : OPTIGA_ASYNC_POOL_SIZE;
+        unsigned started = 0;
+        while (started < wave && async_chain_start(&c[started], done + started)) {
+            started++;
+        }
+        for (unsigned j = 0; j < started; j++) {
+            if (!async_chain_finish(&c[j])) {
+                failed++;
+            }
+        }
+        failed += wave - started;
+        done += wave;
+    }
+    const int64_t async_us = esp_timer_get_time() - t0;
 
-    ESP_LOGI(TAG, "encrypted: %s", msg);
+    optiga_async_stats_t st;
+    optiga_async_get_stats(&st);
+    ESP_LOGI(TAG, "async %u chains (TRNG IV + CBC %u B): one at a time %lu us, up to %u in flight "
+             "%lu us (max in flight %lu, %u failed)", chains, (unsigned)PLAINTEXT_MAX,
+             (unsigned long)serial_us, (unsigned)OPTIGA_ASYNC_POOL_SIZE, (unsigned long)async_us,
+             (unsigned long)st.max_in_flight, failed);
 }
 
-static void clear_log_file(void)
+static void print_stack(const char *name, uint32_t stack_bytes, uint32_t free_min)
 {
-    FILE *f = fopen(LOG_FILE_PATH, "wb");
-    if (!f) {
-        ESP_LOGE(TAG, "failed to open log file for clearing.");
-        return;
+    ESP_LOGI(TAG, "stack %-14s used max=%lu of %lu bytes (free min %lu)", name,
+             (unsigned long)(stack_bytes - free_min), (unsigned long)stack_bytes,
+             (unsigned long)free_min);
+}
+
+// High-water marks hold since boot: read them after a run that used every command path
+static void print_memory(void)
+{
+    pal_os_task_stats_t tasks[OPTIGA_MAX_INSTANCES];
+    const uint8_t n = pal_os_event_get_task_stats(tasks, OPTIGA_MAX_INSTANCES);
+    for (uint8_t i = 0; i < n; i++) {
+        print_stack(tasks[i].name, tasks[i].stack_bytes, tasks[i].stack_free_min_bytes);
+        ESP_LOGI(TAG, "task  %-14s prio=%u core=%d", tasks[i].name, (unsigned)tasks[i].priority,
+                 (int)tasks[i].core);
+    }
+    enc_log_stats_t st;
+    enc_log_get_stats(&st);
+    print_stack("enc_log_wr", LOG_WRITER_STACK_BYTES, st.writer_stack_free);
+    ESP_LOGI(TAG, "task  %-14s prio=%u core=%d", "enc_log_wr", (unsigned)LOG_WRITER_PRIORITY,
+             (LOG_WRITER_CORE >= 0 && LOG_WRITER_CORE < portNUM_PROCESSORS) ? LOG_WRITER_CORE : -1);
+#if LOG_BATCH_PIPELINE
+    print_stack("enc_log_st", LOG_STORE_STACK_BYTES, st.store_stack_free);
+    ESP_LOGI(TAG, "task  %-14s prio=%u core=%d", "enc_log_st", (unsigned)LOG_STORE_PRIORITY,
+             (LOG_STORE_CORE >= 0 && LOG_STORE_CORE < portNUM_PROCESSORS) ? LOG_STORE_CORE : -1);
+#endif
+#ifdef PAL_OS_EVENT_TIMER_ISR
+    ESP_LOGI(TAG, "optiga event timers: esp_timer interrupt");
+#else
+    ESP_LOGI(TAG, "optiga event timers: esp_timer task");
+#endif
+    optiga_entropy_stats_t pool;
+    optiga_entropy_get_stats(&pool);
+    if (pool.stack_free_min > 0) {
+        print_stack("optiga_entropy", pool.stack_bytes, pool.stack_free_min);
     }
-    fclose(f);
-    ESP_LOGI(TAG, "log cleared.");
+    print_stack("main", CONFIG_ESP_MAIN_TASK_STACK_SIZE, uxTaskGetStackHighWaterMark(NULL));
+
+    pal_os_memory_stats_t heap;
+    pal_os_memory_get_stats(&heap);
+    ESP_LOGI(TAG, "optiga heap in use=%lu peak=%lu bytes blocks=%lu allocs=%lu failures=%lu",
+             (unsigned long)heap.in_use_bytes, (unsigned long)heap.peak_bytes,
+             (unsigned long)heap.blocks, (unsigned long)heap.allocations,
+             (unsigned long)heap.failures);
+    if (heap.arena_bytes > 0) {
+        ESP_LOGI(TAG, "optiga arena carved=%lu of %lu bytes", (unsigned long)heap.arena_carved_bytes,
+                 (unsigned long)heap.arena_bytes);
+    }
+    ESP_LOGI(TAG, "system heap free=%lu min=%lu bytes", (unsigned long)esp_get_free_heap_size(),
+             (unsigned long)esp_get_minimum_free_heap_size());
+
+    // Static RAM: per-instance contexts and the instance pools (capacity x instance size)
+    optiga_lib_pool_stats_t cmd_pool, crypt_pool, util_pool;
+    optiga_cmd_get_pool_stats(&cmd_pool);
+    optiga_crypt_get_pool_stats(&crypt_pool);
+    optiga_util_get_pool_stats(&util_pool);
+    ESP_LOGI(TAG, "optiga static context=%lu x %u i2c=%u pools cmd=%u x %u crypt=%u x %u util=%u x %u bytes",
+             (unsigned long)optiga_cmd_get_context_size(), (unsigned)OPTIGA_MAX_INSTANCES,
+             (unsigned)sizeof(ifx_i2c_context_0), cmd_pool.capacity, cmd_pool.block_size,
+             crypt_pool.capacity, crypt_pool.block_size, util_pool.capacity, util_pool.block_size);
+#ifdef PAL_I2C_CAPTURE_ENABLED
+    ESP_LOGI(TAG, "i2c capture ring=%u bytes", (unsigned)PAL_I2C_CAPTURE_RING_BYTES);
+#endif
+    ESP_LOGI(TAG, "log static buffers=%lu bytes (ring %u slots, %lu in PSRAM)",
+             (unsigned long)st.buffer_bytes, (unsigned)LOG_RING_SLOTS,
+             (unsigned long)st.buffer_psram_bytes);
 }
 
-static esp_err_t mount_storage(void)
+#if defined(PAL_I2C_CAPTURE_ENABLED) || defined(OPTIGA_LIB_LOGGER_BINARY)
+static int32_t capture_write(void *ctx, const uint8_t *data, uint32_t len)
 {
-#if LOG_STORAGE_SDMMC
-    const esp_vfs_fat_sdmmc_mount_config_t mount_config = {
-        .format_if_mount_failed = true,
-        .max_files = 4,
-        .allocation_unit_size = 16 * 1024,
-    };
+    return fwrite(data, 1, len, (FILE *)ctx) == len ? 0 : -1;
+}
+#endif
 
-    sdmmc_host_t host = SDMMC_HOST_DEFAULT();
-    sdmmc_slot_config_t slot_config = SDMMC_SLOT_CONFIG_DEFAULT();
-    slot_config.width = LOG_SDMMC_BUS_WIDTH;
-    slot_config.flags |= SDMMC_SLOT_FLAG_INTERNAL_PULLUP;
+#ifdef PAL_I2C_CAPTURE_ENABLED
 
-    esp_err_t err = esp_vfs_fat_sdmmc_mount(
-        LOG_MOUNT_POINT, &host, &slot_config, &mount_config, &s_sd_card);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to mount SD card (err=0x%x)", err);
+static void save_i2c_capture(void)
+{
+#if LOG_STORAGE_RAW
+    ESP_LOGW(TAG, "no file system with the raw log store, capture not saved.");
+#else
+    pal_i2c_capture_file_t info;
+    pal_i2c_capture_get_info(&info);
+
+    FILE *f = fopen(LOG_CAPTURE_PATH, "wb");
+    if (f == NULL) {
+        ESP_LOGW(TAG, "cannot open %s", LOG_CAPTURE_PATH);
+        return;
     }
-    return err;
+    // Capture goes on while the file is written; those calls count as dropped in the next save
+    const pal_status_t status = pal_i2c_capture_save(capture_write, f);
+    if (fclose(f) != 0 || status != PAL_STATUS_SUCCESS) {
+        ESP_LOGW(TAG, "capture save failed, records kept.");
+        return;
+    }
+    ESP_LOGI(TAG, "capture saved: %lu records, %lu bytes, %lu dropped -> %s",
+             (unsigned long)info.records, (unsigned long)info.bytes,
+             (unsigned long)info.dropped, LOG_CAPTURE_PATH);
+#endif
+}
+#endif
+
+#ifdef OPTIGA_LIB_LOGGER_BINARY
+static void save_optiga_log(void)
+{
+#if LOG_STORAGE_RAW
+    ESP_LOGW(TAG, "no file system with the raw log store, OPTIGA log not saved.");
 #else
-    const esp_vfs_fat_mount_config_t mount_config = {
-        .format_if_mount_failed = true,
-        .max_files = 4,
-        .allocation_unit_size = 4096,
-    };
+    optiga_lib_logger_file_t info;
+    optiga_lib_logger_get_info(&info);
 
-    esp_err_t err = esp_vfs_fat_spiflash_mount_rw_wl(
-        LOG_MOUNT_POINT, "storage", &mount_config, &s_wl_handle);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to mount FATFS (err=0x%x)", err);
+    FILE *f = fopen(LOG_OPTIGA_LOG_PATH, "wb");
+    if (f == NULL) {
+        ESP_LOGW(TAG, "cannot open %s", LOG_OPTIGA_LOG_PATH);
+        return;
+    }
+    // OPTIGA layers logging during the save (the file write itself) count as dropped next time
+    const int32_t status = optiga_lib_logger_save(capture_write, f);
+    if (fclose(f) != 0 || status != 0) {
+        ESP_LOGW(TAG, "OPTIGA log save failed, records kept.");
+        return;
     }
-    return err;
+    ESP_LOGI(TAG, "OPTIGA log saved: %lu records, %lu bytes, %lu dropped -> %s",
+             (unsigned long)info.records, (unsigned long)info.bytes,
+             (unsigned long)info.dropped, LOG_OPTIGA_LOG_PATH);
 #endif
 }
+#endif
 
-static void setup_uart(void)
+#ifndef CONFIG_OPTIGA_TRUST_M_LOGGING_PROFILE
+static void run_offload_benchmark(void)
 {
-    const uart_config_t uart_config = {
-        .baud_rate = LOG_UART_BAUD,
-        .data_bits = UART_DATA_8_BITS,
-        .parity = UART_PARITY_DISABLE,
-        .stop_bits = UART_STOP_BITS_1,
-        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
-        .source_clk = UART_SCLK_DEFAULT,
+    static const struct {
+        mbedtls_ecp_group_id gid;
+        const char *name;
+    } curves[] = {
+        {MBEDTLS_ECP_DP_SECP256R1, "P-256"},
+        {MBEDTLS_ECP_DP_SECP384R1, "P-384"},
+        {MBEDTLS_ECP_DP_BP256R1, "BP-256"},
     };
+    static const char *const ops[TRUSTM_OFFLOAD_OPS] = {"ecdsa verify", "ecdh"};
+
+    for (unsigned op = 0; op < TRUSTM_OFFLOAD_OPS; op++) {
+        for (size_t i = 0; i < sizeof(curves) / sizeof(curves[0]); i++) {
+            trustm_offload_result_t res;
+            int ret = trustm_offload_benchmark((trustm_offload_op_t)op, curves[i].gid,
+                                               LOG_OFFLOAD_BENCH_ITERATIONS, &res);
+            if (ret != 0) {
+                ESP_LOGW(TAG, "%s %s: benchmark failed (-0x%04X)", ops[op], curves[i].name, -ret);
+                continue;
+            }
+            // 0 us means that path failed
+            ESP_LOGI(TAG, "%s %s: optiga=%lu us host=%lu us", ops[op], curves[i].name,
+                     (unsigned long)res.optiga_us, (unsigned long)res.host_us);
+        }
+    }
+}
+#endif
+
+static void run_command(uint8_t ch)
+{
+    char args[LOG_UPDATE ? 128 : 32];   // '5' takes a URL
 
-    uart_driver_install(LOG_UART_NUM, 1024, 0, 0, NULL, 0);
-    uart_param_config(LOG_UART_NUM, &uart_config);
-    uart_set_pin(LOG_UART_NUM, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE,
-                 UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    switch (ch) {
+    case 'a':
+    case 'A':
+    case '1':
+        console_args(args, sizeof(args));
+        for (unsigned n = console_count(args, 1); n > 0; n--) {
+            append_encrypted_record(false);
+        }
+        break;
+    case 'b':
+    case 'B':
+        console_args(args, sizeof(args));
+        run_latency_benchmark(console_count(args, LOG_BENCH_RECORDS));
+        break;
+    case 'c':
+    case 'C':
+    case '2':
+        enc_log_clear();
+        break;
+    case 'd':
+    case 'D':
+        enc_log_set_current_boost(true);
+        run_readback();
+        enc_log_set_current_boost(false);
+        break;
+    case 'p':
+    case 'P':
+        enc_log_print_hex();
+        break;
+    case 'w':
+    case 'W':
+        console_args(args, sizeof(args));
+        set_wall_clock(args);
+        break;
+    case 'q':
+    case 'Q':
+        console_args(args, sizeof(args));
+        enc_log_set_current_boost(true);
+        run_query(args);
+        enc_log_set_current_boost(false);
+        break;
+#if LOG_BATCH_MODE
+    case 'f':
+    case 'F':
+        enc_log_flush();
+        break;
+#endif
+#ifdef OPTIGA_LIB_ENABLE_LATENCY_HISTOGRAM
+    case 'g':
+    case 'G':
+        optiga_lib_latency_dump();
+        if (optiga_lib_latency_get_dropped() > 0) {
+            ESP_LOGW(TAG, "%lu APDUs not recorded, more than %u command codes",
+                     (unsigned long)optiga_lib_latency_get_dropped(),
+                     (unsigned)OPTIGA_LIB_LATENCY_COMMANDS);
+        }
+        optiga_lib_latency_clear();
+        break;
+#endif
+    case 'h':
+    case 'H':
+        run_hash_benchmark();
+        break;
+#ifdef PAL_I2C_CAPTURE_ENABLED
+    case 'i':
+    case 'I':
+        save_i2c_capture();
+        break;
+#endif
+#ifdef OPTIGA_LIB_LOGGER_BINARY
+    case 'o':
+    case 'O':
+        save_optiga_log();
+        break;
+#endif
+#ifndef CONFIG_OPTIGA_TRUST_M_LOGGING_PROFILE
+    case 'e':
+    case 'E':
+        run_offload_benchmark();
+        break;
+#endif
+    case 'j':
+    case 'J':
+        print_stats_json();
+        break;
+    case 'k':
+    case 'K':
+        print_memory();
+        break;
+    case 'l':
+    case 'L':
+        ifx_i2c_clear_stats(&ifx_i2c_context_0);
+        ESP_LOGI(TAG, "I2C link counters reset.");
+        break;
+    case 'r':
+    case 'R':
+        if (prepare_power_down()) {
+            esp_restart();
+        }
+        break;
+    case 's':
+    case 'S':
+        print_stats();
+        break;
+#ifdef OPTIGA_LIB_ENABLE_TRACE
+    case 't':
+    case 'T':
+        optiga_lib_trace_dump();
+        optiga_lib_trace_clear();
+        break;
+#endif
+#if LOG_MERKLE_MODE
+    case 'm':
+    case 'M':
+        // The sync signs the open window, so the last record is always covered
+        if (!enc_log_sync(5000)) {
+            ESP_LOGW(TAG, "log sync timed out.");
+        } else if (!enc_log_print_proof(log_seq_last())) {
+            ESP_LOGW(TAG, "no proof for seq %lu", (unsigned long)log_seq_last());
+        }
+        break;
+#endif
+    case 'n':
+    case 'N':
+        console_args(args, sizeof(args));
+        run_group_commit_test(console_count(args, LOG_GROUP_COMMIT_RECORDS));
+        break;
+#if LOG_AGG_MODE
+    case '3':
+        console_args(args, sizeof(args));
+        run_agg_demo(console_count(args, 10));
+        break;
+#endif
+#if LOG_LOADGEN
+    case '4':
+        console_args(args, sizeof(args));
+        run_soak(args);
+        break;
+#endif
+#if LOG_UPDATE
+    case '5':
+        console_args(args, sizeof(args));
+        log_update_run(args);
+        break;
+#endif
+#if LOG_CHANNELS > 1
+    case '6':
+        console_args(args, sizeof(args));
+        run_channel(args);
+        break;
+#endif
+    case '7':
+        console_args(args, sizeof(args));
+        run_async_demo(console_count(args, 8));
+        break;
+#if LOG_REPL
+    case '8':
+        console_args(args, sizeof(args));
+        if (args[0] == 'g' || args[0] == 'G') {
+            unsigned long seconds = LOG_REPL_GATEWAY_S;
+            sscanf(args + 1, "%lu", &seconds);
+            log_repl_gateway((uint32_t)seconds);
+        } else {
+            log_repl_run(args);
+        }
+        break;
+#endif
+#if LOG_READ_CACHE
+    case '9':
+        log_cache_wipe();
+        ESP_LOGI(TAG, "read cache wiped.");
+        break;
+#endif
+#if LOG_SELFTEST
+    case '0':
+        console_args(args, sizeof(args));
+        (void)log_selftest_run(args[0] == 'b' || args[0] == 'B');
+        break;
+#endif
+    case 'u':
+    case 'U':
+        console_args(args, sizeof(args));
+        for (unsigned n = console_count(args, 1); n > 0; n--) {
+            append_encrypted_record(true);
+        }
+        break;
+#if LOG_UPLOAD
+    case 'v':
+    case 'V':
+        console_args(args, sizeof(args));
+        log_upload_run(args);
+        break;
+#endif
+    case 'x':
+    case 'X':
+        enc_log_set_current_boost(true);
+        log_export_run();
+        enc_log_set_current_boost(false);
+        break;
+    case 'y':
+    case 'Y':
+        if (enc_log_sync(5000)) {
+            ESP_LOGI(TAG, "log synced.");
+        } else {
+            ESP_LOGW(TAG, "log sync timed out.");
+        }
+        break;
+    case 'z':
+    case 'Z':
+        enter_deep_sleep();
+        break;
+    case ' ':
+    case '\r':
+    case '\n':
+        break;
+    default:
+        ESP_LOGW(TAG, "unknown command: %c", ch);
+        print_usage();
+        break;
+    }
 }
 
+// Sleeps in the console driver while the console is idle and runs a command as soon as
+// its byte is in. Commands that read on (export, query line) take their bytes from the
+// driver directly.
 static void command_loop(void)
 {
-    uint8_t ch;
     while (true) {
-        int len = uart_read_bytes(LOG_UART_NUM, &ch, 1, 100 / portTICK_PERIOD_MS);
-        if (len <= 0) {
+        if (!log_console_wait_input()) {
+            ESP_LOGW(TAG, "console input overflow, dropped.");
             continue;
         }
-
-        switch (ch) {
-        case 'a':
-        case 'A':
-        case '1':
-            append_encrypted_record();
-            break;
-        case 'c':
-        case 'C':
-        case '2':
-            clear_log_file();
-            break;
-        case 'p':
-        case 'P':
-            print_log_file_hex();
-            break;
-        case '\r':
-        case '\n':
-            break;
-        default:
-            ESP_LOGW(TAG, "unknown command: %c", ch);
-            print_usage();
-            break;
+        uint8_t ch;
+        while (console_byte(&ch, 0)) {
+            run_command(ch);
         }
+    }
+}
 
+// OPTIGA init is required before RNG/crypto usage; enc_log runs this before its key checks
+static bool start_optiga(void)
+{
+#if LOG_PERSONA_CACHE
+    // 0xE0C4 as an earlier boot left it: an unchanged limit is neither read nor written
+    optiga_trust_assume_current_limit(log_persona_get()->current_limit_ma);
+#endif
+    optiga_trust_init();
+    if (optiga_entropy_start() != OPTIGA_LIB_SUCCESS) {
+        ESP_LOGW(TAG, "entropy pool not started, IVs use direct TRNG commands");
+    }
+#ifdef CONFIG_OPTIGA_TRUST_M_ECDH_KEY_POOL
+    if (trustm_ecdh_pool_start() != OPTIGA_LIB_SUCCESS) {
+        ESP_LOGW(TAG, "ECDH key pool not started, handshakes generate key pairs on demand");
     }
+#endif
+    return true;
 }
 
 void app_main(void)
 {
-    setup_uart();
+    log_console_init();
     ESP_LOGI(TAG, "Encrypted data logging demo (ESP-IDF)");
 
-    if (mount_storage() != ESP_OK) {
-        ESP_LOGE(TAG, "mount failed. Check partition table.");
+    // Before the first record: the index takes the wall clock base from here
+    log_time_init();
+    log_seq_init();
+#if LOG_SLEEP_STAGE
+    log_sleep_init();
+    if (esp_reset_reason() == ESP_RST_DEEPSLEEP) {
+        sleep_stage_wake();
+    }
+#endif
+
+#ifdef OPTIGA_LIB_LOGGER_BINARY_TASK
+    // Starts the task that prints the OPTIGA binary log, before the first record
+    if (pal_logger_init(NULL) != PAL_STATUS_SUCCESS) {
+        ESP_LOGW(TAG, "OPTIGA log formatter not started, use 'o' to save the log");
+    }
+#endif
+
+#if LOG_PM
+    // Before the writer and the OPTIGA event tasks start taking locks
+    if (!log_pm_init()) {
+        ESP_LOGW(TAG, "power management not configured, clocks stay at maximum");
+    }
+#endif
+
+    // Mounts the storage; OPTIGA comes up on the writer task at the same time
+    // (LOG_LAZY_OPTIGA), records from here on wait in the ring until both are ready
+    if (!enc_log_init(start_optiga)) {
+        ESP_LOGE(TAG, "log init failed");
         return;
     }
 
-    // OPTIGA init is required before RNG/crypto usage
-    extern void optiga_trust_init(void);
-    optiga_trust_init();
+#if LOG_SLEEP_STAGE
+    // The readings of the last wakes, or of a cycle a reset cut short, in one go
+    const uint32_t staged = log_sleep_staged();
+    if (staged > 0) {
+        const uint32_t flushed = log_sleep_flush(5000);
+        ESP_LOGI(TAG, "%lu of %lu staged readings written: %lld ms", (unsigned long)flushed,
+                 (unsigned long)staged, (long long)(esp_timer_get_time() / 1000));
+    }
+    if (esp_reset_reason() == ESP_RST_DEEPSLEEP) {
+        enter_deep_sleep();
+    }
+#else
+    if (esp_reset_reason() == ESP_RST_DEEPSLEEP) {
+        // esp_timer starts with the app, so ROM and bootloader time is not included
+        append_encrypted_record(false);
+        const bool synced = enc_log_sync(5000);
+        ESP_LOGI(TAG, "wake to first record %s: %lld ms", synced ? "synced" : "submitted",
+                 (long long)(esp_timer_get_time() / 1000));
+    }
+#endif
 
-    if (!optiga_crypto_init()) {
+    enc_log_print_hex();
+    // Console commands use OPTIGA directly
+    if (!enc_log_wait_ready(UINT32_MAX)) {
         ESP_LOGE(TAG, "optiga init failed");
         return;
     }
-    if (!optiga_generate_key_if_enabled()) {
-        ESP_LOGE(TAG, "optiga key init failed");
-        return;
+#if LOG_SELFTEST
+    // Not on wakes: a duty cycle pays for every OPTIGA command and flash write
+    if (esp_reset_reason() != ESP_RST_DEEPSLEEP) {
+        (void)log_selftest_run(false);
     }
-
-    print_log_file_hex();
+#endif
     print_usage();
     command_loop();
 }
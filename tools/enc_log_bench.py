@@ -0,0 +1,350 @@
+#!/usr/bin/env python3
+"""Build, flash and run the logger benchmark app (bench/) in every mode.
+
+Each mode/storage combination is a separate build of bench/. The app prints one
+"BENCH {json}" line per pass; this script keeps the median pass per combination
+and writes all of them to one JSON file. With --baseline the results are compared
+to an earlier file and the exit status is 1 if anything got slower than
+--tolerance allows.
+
+    pip install pyserial
+    python tools/enc_log_bench.py /dev/ttyUSB0 -o bench.json
+    python tools/enc_log_bench.py /dev/ttyUSB0 --storage flash,littlefs,raw,sd -o bench.json
+    python tools/enc_log_bench.py /dev/ttyUSB0 -o new.json --baseline bench.json
+    python tools/enc_log_bench.py /dev/ttyUSB0 --modes batch --current 6,9,12,15
+
+With --current every pass runs at each OPTIGA current limit and the results are
+kept per limit ("batch/flash/6mA"). Each limit change is an OPTIGA NVM write.
+
+Backend comparison: --compare runs the same workloads on flash (FATFS), littlefs and
+raw, at several record sizes and sync policies, with an injected power cut at the end
+of each build, and prints a table per workload. --sizes, --sync, --batch and
+--power-cut pick the parts separately:
+
+    python tools/enc_log_bench.py /dev/ttyUSB0 --compare -o backends.json
+    python tools/enc_log_bench.py /dev/ttyUSB0 --modes batch --batch 4,16 --sync 0,1
+
+Energy: --pm builds the logger under esp_pm (light sleep, clocks held only during
+storage and I2C transfers) and adds the estimated uJ per record; --interval paces the
+records (ms between two) like a battery-powered logger instead of flooding the ring:
+
+    python tools/enc_log_bench.py /dev/ttyUSB0 --modes batch --pm --interval 100
+
+PSRAM: --psram puts the logger's bulk buffers in external RAM (LOG_PSRAM, a module with
+PSRAM). Result keys stay the same, so the internal RAM run is the baseline:
+
+    python tools/enc_log_bench.py /dev/ttyUSB0 --modes batch --batch 64 -o internal.json
+    python tools/enc_log_bench.py /dev/ttyUSB0 --modes batch --batch 64 --psram \
+        -o psram.json --baseline internal.json
+
+Crash safety: --crash N ends each build with N resets at random points of the append,
+sync, index and rotation paths (LOG_CRASH_TEST). Each boot checks the log and reports
+its recovery time and the records lost; the totals are kept as "<combo>/crash" and
+compared like the passes. Any lost synced record, seq gap or undecryptable unit makes
+the exit status 1, baseline or not:
+
+    python tools/enc_log_bench.py /dev/ttyUSB0 --storage flash,raw --crash 50 -o crash.json
+
+Variants: each --config is one more build of every mode/storage combination with those
+Kconfig options set (comma-separated, CONFIG_ optional), optionally named "name:options".
+The mode and storage are options of the same menu (main/Kconfig.projbuild), so any
+option of it or of components/optiga (bus speed, shielded connection protection policy,
+library profile) can be compared. Results are kept as "<combo>/<name>". --list prints
+the builds without running them:
+
+    python tools/enc_log_bench.py /dev/ttyUSB0 --modes batch \
+        --config i2c400:OPTIGA_TRUST_M_I2C_FREQ_KHZ=400 \
+        --config i2c1000:OPTIGA_TRUST_M_I2C_FREQ_KHZ=1000 \
+        --config shielded:OPTIGA_TRUST_M_PROTECTION_POLICY=y \
+        --config full:OPTIGA_TRUST_M_LOGGING_PROFILE=n -o variants.json
+    python tools/enc_log_bench.py /dev/ttyUSB0 --storage sd --config sd1:ENC_LOG_SDMMC_BUS_WIDTH_1=y --list
+
+Run from the repository root with the ESP-IDF environment exported. Close
+idf.py monitor first; only one program can own the port.
+"""
+import argparse
+import json
+import subprocess
+import sys
+import time
+
+import serial
+
+MODES = ("record", "batch", "hybrid")
+STORAGES = ("flash", "littlefs", "raw", "sd")
+
+# --compare defaults
+COMPARE_STORAGE = "flash,littlefs,raw"
+COMPARE_SIZES = "16,64"
+COMPARE_SYNC = "0,1,16"
+
+# Metric, True if larger is better
+COMPARED = (
+    ("records_per_s", True),
+    ("log_bytes_per_record", False),
+    ("optiga_requests_per_record", False),
+    ("latency_us.p99", False),
+    ("write_amplification", False),
+    ("uj_per_record", False),
+    ("recover_ms_mean", False),
+    ("recover_ms_max", False),
+    ("lost_unsynced_mean", False),
+    ("xor_us", False),
+    ("copy_us", False),
+)
+
+
+def parse_variants(configs):
+    """--config values as (name, options) pairs; no --config is the one unnamed variant
+    of the menu defaults."""
+    if not configs:
+        return [("", "")]
+    variants = []
+    for config in configs:
+        name, sep, options = config.partition(":")
+        if not sep:
+            name, options = "", config
+        items = [o.strip() for o in options.split(",") if o.strip()]
+        if not items or any("=" not in o for o in items):
+            sys.exit(f"--config {config}: expected [name:]OPTION=value,...")
+        if not name:
+            name = "-".join(o.removeprefix("CONFIG_").replace("=", "_") for o in items).lower()
+        variants.append((name, ",".join(items)))
+    if len({name for name, _ in variants}) != len(variants):
+        sys.exit("--config names must be unique")
+    return variants
+
+
+def build_dir(mode, storage, batch, variant, args):
+    return (f"build/bench-{mode}-{storage}" + (f"-b{batch}" if batch else "")
+            + (f"-{variant[0]}" if variant[0] else "")
+            + ("-pm" if args.pm else "") + ("-psram" if args.psram else ""))
+
+
+def build_and_flash(port, mode, storage, batch, variant, args):
+    cmd = ["idf.py", "-C", "bench", "-B", build_dir(mode, storage, batch, variant, args),
+           f"-DBENCH_MODE={mode}", f"-DBENCH_STORAGE={storage}", f"-DBENCH_CONFIG={variant[1]}",
+           f"-DBENCH_CURRENT={args.current}",
+           f"-DBENCH_BATCH={batch}", f"-DBENCH_RECORD_SIZES={args.sizes}",
+           f"-DBENCH_SYNC_EVERY={args.sync}", f"-DBENCH_POWER_CUT={int(args.power_cut)}",
+           f"-DBENCH_PM={int(args.pm)}", f"-DBENCH_PSRAM={int(args.psram)}",
+           f"-DBENCH_INTERVAL={args.interval}",
+           f"-DBENCH_CRASH_CYCLES={args.crash}",
+           "-p", port, "build", "flash"]
+    print(" ".join(cmd), flush=True)
+    subprocess.run(cmd, check=True)
+
+
+def collect_passes(port, timeout_s):
+    """Reset the board and return the parsed BENCH lines up to BENCH_DONE, the
+    BENCH_CUT line of the boot after the injected power cut, the BENCH_CRASH_DONE
+    totals of the crash cycles and the BENCH_SIMD kernel timings (None without them)."""
+    passes = []
+    cut = None
+    crash = None
+    simd = None
+    with serial.Serial(port, 115200, timeout=1) as ser:
+        # EN low then high through RTS, as esptool does
+        ser.dtr = False
+        ser.rts = True
+        time.sleep(0.1)
+        ser.rts = False
+        deadline = time.monotonic() + timeout_s
+        while time.monotonic() < deadline:
+            line = ser.readline().decode("utf-8", "replace").strip()
+            if line.startswith("BENCH_DONE"):
+                return passes, cut, crash, simd
+            if line.startswith("BENCH_CUT {"):
+                cut = json.loads(line[len("BENCH_CUT "):])
+                print(f"  power cut: {cut['synced_bytes']} bytes synced, "
+                      f"{cut['recovered_bytes']} recovered in {cut['boot_open_ms']} ms",
+                      flush=True)
+            elif line.startswith("BENCH_CRASH {"):
+                c = json.loads(line[len("BENCH_CRASH "):])
+                print(f"  crash {c['cycle']} at {c['point']}: recovery {c['recover_ms']} ms, "
+                      f"{c['lost_unsynced']} unsynced lost"
+                      + ("" if c["consistent"] else
+                         f", INCONSISTENT ({c['lost_synced']} synced lost, {c['gaps']} gaps, "
+                         f"{c['errors']} errors)"), flush=True)
+            elif line.startswith("BENCH_SIMD {"):
+                simd = json.loads(line[len("BENCH_SIMD "):])
+                print(f"  xor {simd['xor_scalar_mb_s']} -> {simd['xor_mb_s']} MB/s, copy "
+                      f"{simd['memcpy_mb_s']} -> {simd['copy_mb_s']} MB/s"
+                      + (" (PIE)" if simd["vector"] else ""), flush=True)
+            elif line.startswith("BENCH_CRASH_DONE {"):
+                crash = json.loads(line[len("BENCH_CRASH_DONE "):])
+            elif line.startswith("BENCH {"):
+                passes.append(json.loads(line[len("BENCH "):]))
+                print(f"  pass {passes[-1]['pass']} at {passes[-1]['current_ma']} mA: "
+                      f"{passes[-1]['records_per_s']} records/s", flush=True)
+    raise TimeoutError("no BENCH_DONE within %d s" % timeout_s)
+
+
+def median_pass(passes):
+    """The pass with the median throughput (keeps its latencies consistent)."""
+    ranked = sorted(passes, key=lambda p: p["records_per_s"])
+    return ranked[(len(ranked) - 1) // 2]
+
+
+def workload_key(p, args):
+    """Key suffix of a pass: only the dimensions that were swept, so keys of a plain run
+    match earlier baselines."""
+    parts = []
+    if args.sizes:
+        parts.append(f"{p['record_size']}B")
+    if args.sync:
+        parts.append(f"sync{p['sync_every']}")
+    if args.current:
+        parts.append(f"{p['current_ma']}mA")
+    return "".join("/" + x for x in parts)
+
+
+def summary(results):
+    """One row per result, so backends line up for the same workload."""
+    rows = sorted(results.items(), key=lambda kv: (kv[0].split("/", 2)[2:], kv[0]))
+    print(f"{'combination':34} {'rec/s':>8} {'p50 us':>8} {'p99 us':>8} {'max us':>8} "
+          f"{'wr amp':>7} {'erase/rec':>9} {'mount ms':>8} {'open ms':>8}")
+    for key, r in rows:
+        if "records_per_s" in r:
+            lat = r["latency_us"]
+            print(f"{key:34} {r['records_per_s']:>8} {lat['p50']:>8} {lat['p99']:>8} "
+                  f"{lat['max']:>8} {r['write_amplification']:>7} "
+                  f"{r['flash_erased_per_record']:>9} {r.get('boot_mount_ms', '-'):>8} "
+                  f"{r.get('boot_open_ms', '-'):>8}")
+        elif "xor_us" in r:
+            print(f"{key:34} xor {r['xor_scalar_mb_s']} -> {r['xor_mb_s']} MB/s, copy "
+                  f"{r['memcpy_mb_s']} -> {r['copy_mb_s']} MB/s "
+                  f"({'PIE' if r['vector'] else 'scalar'}, {r['bytes']} bytes)")
+        elif "recover_ms_mean" in r:
+            print(f"{key:34} {r['fired']}/{r['cycles']} crashes: recovery {r['recover_ms_mean']} ms "
+                  f"mean, {r['recover_ms_max']} max, {r['lost_unsynced_mean']} unsynced lost "
+                  f"mean, {r['inconsistent']} inconsistent")
+        else:
+            print(f"{key:34} cut after {r['synced_records']}+{r['unsynced_records']} records: "
+                  f"mount {r['boot_mount_ms']} ms, recovery {r['boot_open_ms']} ms, "
+                  f"{r['lost_synced_bytes']} synced bytes lost")
+
+
+def metric(result, name):
+    value = result
+    for key in name.split("."):
+        value = value.get(key)
+        if value is None:
+            return None   # baseline from before the metric existed
+    return value
+
+
+def compare(results, baseline, tolerance):
+    worse = []
+    for key, new in results.items():
+        old = baseline.get(key)
+        if old is None:
+            continue
+        for name, larger_better in COMPARED:
+            a = metric(old, name)
+            b = metric(new, name)
+            if not a or b is None:
+                continue
+            change = (b - a) / a
+            bad = -change if larger_better else change
+            flag = "  REGRESSION" if bad > tolerance else ""
+            print(f"{key:18} {name:28} {a:>12} -> {b:<12} {change:+.1%}{flag}")
+            if flag:
+                worse.append((key, name))
+    return worse
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("port")
+    ap.add_argument("-o", "--output", default="bench.json")
+    ap.add_argument("--modes", default=",".join(MODES))
+    ap.add_argument("--storage", default="flash,raw", help="sd needs a card wired up")
+    ap.add_argument("--sizes", default="", help="record sizes in bytes, e.g. 16,64")
+    ap.add_argument("--sync", default="", help="records per sync, e.g. 0,1,16 (0: once per pass)")
+    ap.add_argument("--batch", default="",
+                    help="block group sizes of batch mode (LOG_BATCH_RECORDS), e.g. 4,8,16")
+    ap.add_argument("--power-cut", action="store_true",
+                    help="end each build with an injected reset and measure the recovery")
+    ap.add_argument("--compare", action="store_true",
+                    help=f"backend comparison: --storage {COMPARE_STORAGE} --sizes "
+                         f"{COMPARE_SIZES} --sync {COMPARE_SYNC} --power-cut")
+    ap.add_argument("--current", default="",
+                    help="OPTIGA current limits in mA to sweep, e.g. 6,9,12,15")
+    ap.add_argument("--pm", action="store_true",
+                    help="esp_pm build (CONFIG_PM_ENABLE, light sleep), reports uJ per record")
+    ap.add_argument("--psram", action="store_true",
+                    help="bulk buffers in PSRAM (LOG_PSRAM, CONFIG_SPIRAM), same result keys")
+    ap.add_argument("--interval", default="", help="ms between two records (default: none)")
+    ap.add_argument("--crash", type=int, default=0,
+                    help="crash cycles at the end of each build (LOG_CRASH_TEST), e.g. 50")
+    ap.add_argument("--config", action="append", default=[],
+                    help="one more variant with these Kconfig options, [name:]OPTION=value,...")
+    ap.add_argument("--list", action="store_true",
+                    help="print the builds (combination, directory, options) and exit")
+    ap.add_argument("--timeout", type=int, default=300, help="seconds per combination")
+    ap.add_argument("--baseline", help="earlier output file to compare against")
+    ap.add_argument("--tolerance", type=float, default=0.10,
+                    help="allowed relative change before a metric counts as a regression")
+    args = ap.parse_args()
+    if args.compare:
+        args.storage = COMPARE_STORAGE if args.storage == ap.get_default("storage") else args.storage
+        args.sizes = args.sizes or COMPARE_SIZES
+        args.sync = args.sync or COMPARE_SYNC
+        args.power_cut = True
+
+    builds = []
+    for mode in args.modes.split(","):
+        batches = args.batch.split(",") if args.batch and mode == "batch" else [""]
+        for storage in args.storage.split(","):
+            if mode not in MODES or storage not in STORAGES:
+                sys.exit(f"unknown combination {mode}/{storage}")
+            for batch in batches:
+                for variant in parse_variants(args.config):
+                    combo = (f"{mode}/{storage}" + (f"/b{batch}" if batch else "")
+                             + (f"/{variant[0]}" if variant[0] else ""))
+                    builds.append((combo, mode, storage, batch, variant))
+    if args.list:
+        for combo, mode, storage, batch, variant in builds:
+            print(f"{combo:32} {build_dir(mode, storage, batch, variant, args):40} {variant[1]}")
+        return
+
+    results = {}
+    inconsistent = []
+    for combo, mode, storage, batch, variant in builds:
+        build_and_flash(args.port, mode, storage, batch, variant, args)
+        passes, cut, crash, simd = collect_passes(args.port, args.timeout)
+        if not passes:
+            sys.exit(f"{combo}: no results")
+        groups = {}
+        for p in passes:
+            groups.setdefault(workload_key(p, args), []).append(p)
+        for suffix, group in groups.items():
+            results[combo + suffix] = median_pass(group)
+        if cut is not None:
+            results[combo + "/power_cut"] = cut
+        if simd is not None:
+            results[combo + "/simd"] = simd
+        if crash is not None:
+            results[combo + "/crash"] = crash
+            if crash["inconsistent"]:
+                inconsistent.append(combo)
+
+    with open(args.output, "w") as f:
+        json.dump(results, f, indent=2, sort_keys=True)
+    print(f"wrote {args.output}")
+    summary(results)
+
+    failed = bool(inconsistent)
+    if inconsistent:
+        print("log inconsistent after a crash: " + ", ".join(inconsistent))
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        failed = bool(compare(results, baseline, args.tolerance)) or failed
+    if failed:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""Export the encrypted log from the ESP32 over the console UART.
+
+Host side of the binary export (console command 'x', see main/log_export.h for
+the frame format). Frames are CRC-checked and written to the output file at
+their log offset; on a bad frame or timeout the export is re-requested from the
+last good offset.
+
+    pip install pyserial
+    python tools/enc_log_export.py /dev/ttyUSB0 -o enc_log.bin
+    python tools/enc_log_export.py /dev/ttyUSB0 -o enc_log.bin --resume
+    python tools/enc_log_export.py /dev/ttyACM0 -o enc_log.bin   # LOG_CONSOLE_USB
+
+Close idf.py monitor first; only one program can own the port.
+"""
+import argparse
+import os
+import struct
+import sys
+import time
+import zlib
+
+import serial
+
+SYNC = b"\xa5\x5a"
+FRAME_ACK = 0x01
+FRAME_DATA = 0x02
+FRAME_END = 0x03
+FRAME_ERR = 0x04
+
+
+class FrameError(Exception):
+    pass
+
+
+def build_request(baud, offset):
+    body = b"XR" + struct.pack("<II", baud, offset)
+    return b"x" + body + struct.pack("<I", zlib.crc32(body))
+
+
+def read_exact(ser, n):
+    data = ser.read(n)
+    if len(data) != n:
+        raise FrameError("timeout")
+    return data
+
+
+def read_frame(ser, hunt_bytes=4096):
+    """Return (type, offset, payload). Skips console text before the sync bytes."""
+    window = b""
+    for _ in range(hunt_bytes):
+        b = ser.read(1)
+        if not b:
+            raise FrameError("timeout waiting for frame")
+        window = (window + b)[-2:]
+        if window == SYNC:
+            break
+    else:
+        raise FrameError("no frame sync")
+
+    hdr = read_exact(ser, 7)
+    ftype, length, offset = struct.unpack("<BHI", hdr)
+    payload = read_exact(ser, length)
+    (crc,) = struct.unpack("<I", read_exact(ser, 4))
+    if crc != zlib.crc32(hdr + payload):
+        raise FrameError("CRC mismatch at offset %d" % offset)
+    return ftype, offset, payload
+
+
+def drain(ser, quiet_s=0.3):
+    """Read until the line has been silent for quiet_s (device finishing a stream)."""
+    last = time.monotonic()
+    while time.monotonic() - last < quiet_s:
+        if ser.read(ser.in_waiting or 1):
+            last = time.monotonic()
+
+
+def export_once(ser, args, out, offset):
+    """One request/stream session. Returns (next offset, done)."""
+    ser.baudrate = args.baud
+    ser.reset_input_buffer()
+    ser.write(build_request(args.export_baud, offset))
+
+    ftype, _, payload = read_frame(ser)
+    if ftype != FRAME_ACK:
+        raise FrameError("expected ACK, got type %d" % ftype)
+    size, baud = struct.unpack("<II", payload)
+    if baud != ser.baudrate:
+        ser.baudrate = baud
+
+    if offset == 0 or args.verbose:
+        print("log size %d bytes, streaming from %d at %d baud" % (size, offset, baud))
+
+    started = time.monotonic()
+    try:
+        while True:
+            ftype, foff, payload = read_frame(ser)
+            if ftype == FRAME_DATA:
+                if foff != offset:
+                    raise FrameError("gap: expected offset %d, got %d" % (offset, foff))
+                out.seek(foff)
+                out.write(payload)
+                offset += len(payload)
+                if args.verbose:
+                    print("\r%d / %d" % (offset, size), end="", flush=True)
+            elif ftype == FRAME_END:
+                elapsed = max(time.monotonic() - started, 1e-3)
+                print("\ndone: %d bytes, %.1f KB/s" % (offset, offset / 1024 / elapsed))
+                return offset, True
+            elif ftype == FRAME_ERR:
+                raise FrameError("device reported a read error at %d" % foff)
+            else:
+                raise FrameError("unexpected frame type %d" % ftype)
+    finally:
+        ser.baudrate = args.baud
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("port")
+    ap.add_argument("-o", "--output", default="enc_log.bin")
+    ap.add_argument("--baud", type=int, default=115200, help="console baud rate")
+    ap.add_argument("--export-baud", type=int, default=921600,
+                    help="baud rate requested for the transfer")
+    ap.add_argument("--resume", action="store_true",
+                    help="continue from the current size of the output file")
+    ap.add_argument("--retries", type=int, default=5)
+    ap.add_argument("-v", "--verbose", action="store_true")
+    args = ap.parse_args()
+
+    offset = 0
+    mode = "wb"
+    if args.resume and os.path.exists(args.output):
+        offset = os.path.getsize(args.output)
+        mode = "r+b"
+
+    with serial.Serial(args.port, args.baud, timeout=1.0) as ser, open(args.output, mode) as out:
+        for attempt in range(args.retries + 1):
+            try:
+                offset, done = export_once(ser, args, out, offset)
+                if done:
+                    out.truncate(offset)
+                    return 0
+            except FrameError as e:
+                out.flush()
+                print("\nattempt %d: %s, resuming from %d" % (attempt + 1, e, offset),
+                      file=sys.stderr)
+                # Let the device finish the current stream and drop back to console baud
+                drain(ser)
+                ser.baudrate = args.baud
+                time.sleep(0.1)
+    print("export failed after %d attempts" % (args.retries + 1), file=sys.stderr)
+    return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
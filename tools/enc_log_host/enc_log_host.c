@@ -0,0 +1,457 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Decrypt raw log images on a Linux gateway with its own OPTIGA.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    enc_log_host.c
+ * @brief   Linux host exporter: enc_log images to CSV
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Runs the firmware's streaming reader (main/log_reader.c) against
+ *          image files copied off the SD card, through the OPTIGA library on
+ *          pal/linux. The gateway's OPTIGA must hold the same AES key at
+ *          LOG_KEY_OID (and the hybrid secret), and the tool must be built with
+ *          the firmware's LOG_* options (CMakeLists.txt, ENC_LOG_DEFINES).
+ *          Segments decrypt on their own, so worker threads take one each and
+ *          the main thread writes their CSV in segment order.
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "optiga/optiga_util.h"
+#include "optiga_sync.h"
+#include "pal_linux.h"
+
+#include "log_appender.h"
+#include "log_reader.h"
+#include "log_record.h"
+
+// Rotated segments are passed oldest first (enc_log_0000.bin, enc_log_0001.bin, ...)
+#define HOST_MAX_IMAGES         64
+#define HOST_OUT_BUF_BYTES      (256 * 1024)
+#define HOST_OPEN_TIMEOUT_MS    5000
+// Each worker's scan holds an OPTIGA instance, next to the util instance of main
+#define HOST_MAX_JOBS           (OPTIGA_CMD_MAX_REGISTRATIONS - 1)
+// Segments decrypted ahead of the one being written, per worker
+#define HOST_REORDER_AHEAD      2
+
+typedef struct {
+    const char *path;
+    FILE *f;
+    uint32_t base;              // log offset of the first data byte
+    uint32_t bytes;             // data bytes (log_appender_probe)
+} host_image_t;
+
+typedef struct {
+    FILE *out;
+    uint32_t unparsed;
+} host_csv_t;
+
+// One segment's scan, held in the reorder buffer until the segments before it are written
+typedef struct {
+    char *csv;                  // its CSV rows (open_memstream)
+    size_t csv_len;
+    uint32_t unparsed;
+    log_reader_stats_t st;
+    bool ok;
+    bool done;
+} host_segment_t;
+
+// --------------------
+// Globals
+// --------------------
+static const char *TAG = "ENC_LOG_HOST";
+
+// I2C device of the target config (pal/linux/target/*/pal_ifx_i2c_config.c)
+extern pal_linux_t linux_events;
+
+static host_image_t s_images[HOST_MAX_IMAGES];
+static size_t s_image_count = 0;
+static optiga_sync_t s_sync;
+
+static host_segment_t s_segments[HOST_MAX_IMAGES];
+static pthread_mutex_t s_segment_mux = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_segment_cond = PTHREAD_COND_INITIALIZER;
+static size_t s_segment_next = 0;       // next segment a worker takes
+static size_t s_segment_written = 0;    // segments written out, in order
+static size_t s_segment_window = 0;     // segments taken ahead of the writer
+static bool s_segment_stop = false;     // output failed: take no more
+
+// --------------------
+// Images
+// --------------------
+static bool images_open(char *const *paths, size_t count, uint32_t *total)
+{
+    uint32_t base = 0;
+    for (size_t i = 0; i < count; i++) {
+        host_image_t *img = &s_images[i];
+        img->path = paths[i];
+        if (!log_appender_probe(img->path, &img->bytes)) {
+            ESP_LOGE(TAG, "%s: not a log image for this build", img->path);
+            return false;
+        }
+        img->f = fopen(img->path, "rb");
+        if (!img->f) {
+            ESP_LOGE(TAG, "%s: cannot open", img->path);
+            return false;
+        }
+        img->base = base;
+        base += img->bytes;
+        s_image_count = i + 1;
+    }
+    *total = base;
+    return true;
+}
+
+static void images_close(void)
+{
+    for (size_t i = 0; i < s_image_count; i++) {
+        fclose(s_images[i].f);
+    }
+    s_image_count = 0;
+}
+
+// log_reader_read_t over the images as one stream; a read stops at an image end
+static size_t images_read(void *read_ctx, uint32_t offset, void *buf, size_t len)
+{
+    for (size_t i = 0; i < s_image_count; i++) {
+        const host_image_t *img = &s_images[i];
+        if (offset < img->base || offset - img->base >= img->bytes) {
+            continue;
+        }
+        const uint32_t pos = offset - img->base;
+        const size_t left = img->bytes - pos;
+        if (fseek(img->f, (long)(LOG_APPENDER_DATA_START + pos), SEEK_SET) != 0) {
+            return 0;
+        }
+        return fread(buf, 1, (len < left) ? len : left, img->f);
+    }
+    return 0;
+}
+
+// log_reader_read_t over one image (read_ctx), safe next to the other workers' reads
+static size_t image_read(void *read_ctx, uint32_t offset, void *buf, size_t len)
+{
+    const host_image_t *img = (const host_image_t *)read_ctx;
+    if (offset < img->base || offset - img->base >= img->bytes) {
+        return 0;
+    }
+    const uint32_t pos = offset - img->base;
+    const size_t left = img->bytes - pos;
+    const ssize_t n = pread(fileno(img->f), buf, (len < left) ? len : left,
+                            (off_t)(LOG_APPENDER_DATA_START + pos));
+    return (n > 0) ? (size_t)n : 0;
+}
+
+// --------------------
+// CSV output
+// --------------------
+// One typed column each, so the file loads straight into pandas/DuckDB/Arrow:
+// seq and uptime_ms are empty for records that are not sample records
+static void csv_header(FILE *out)
+{
+    fputs("seq,uptime_ms,log_offset,record_index,plaintext_len,format,payload\n", out);
+}
+
+static void csv_hex(FILE *out, const uint8_t *data, size_t len)
+{
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < len; i++) {
+        fputc(digits[data[i] >> 4], out);
+        fputc(digits[data[i] & 0x0F], out);
+    }
+}
+
+static bool csv_record(const log_reader_record_t *rec, void *ctx)
+{
+    host_csv_t *csv = (host_csv_t *)ctx;
+    log_record_fields_t f;
+    const bool sample = log_record_fields(rec->data, rec->len, &f);
+
+    if (sample) {
+        fprintf(csv->out, "%llu,%llu,", (unsigned long long)f.seq,
+                (unsigned long long)f.uptime_ms);
+    } else {
+        csv->unparsed++;
+        fputs(",,", csv->out);
+    }
+    fprintf(csv->out, "%lu,%u,%u,", (unsigned long)rec->offset, (unsigned)rec->index,
+            (unsigned)rec->len);
+
+    if (sample && f.format == RECORD_FORMAT_JSON) {
+        // JSON text as a quoted field, quotes doubled
+        fputs("json,\"", csv->out);
+        for (size_t i = 0; i < f.text_len; i++) {
+            if (rec->data[i] == '"') {
+                fputc('"', csv->out);
+            }
+            fputc(rec->data[i], csv->out);
+        }
+        fputs("\"\n", csv->out);
+    } else {
+        fputs(!sample ? "hex," : (f.format == RECORD_FORMAT_CBOR) ? "cbor," :
+              (f.schema == RECORD_SCHEMA_AGG) ? "agg," :
+              (f.schema == RECORD_SCHEMA_RAW) ? "raw," : "packed,", csv->out);
+        csv_hex(csv->out, rec->data, rec->len);
+        fputc('\n', csv->out);
+    }
+    return !ferror(csv->out);
+}
+
+// --------------------
+// Segment workers
+// --------------------
+// Take the next segment within the reorder window and scan it into its own buffer. Every
+// segment opens with its format (and epoch) header, so each scan starts from scratch and
+// derives its segment's keys once; the reader state is per thread (LOG_READER_TLS).
+static void *segment_worker(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&s_segment_mux);
+        while (!s_segment_stop && s_segment_next < s_image_count &&
+               s_segment_next >= s_segment_written + s_segment_window) {
+            pthread_cond_wait(&s_segment_cond, &s_segment_mux);
+        }
+        if (s_segment_stop || s_segment_next >= s_image_count) {
+            pthread_mutex_unlock(&s_segment_mux);
+            return NULL;
+        }
+        const size_t i = s_segment_next++;
+        pthread_mutex_unlock(&s_segment_mux);
+
+        host_image_t *img = &s_images[i];
+        host_segment_t *seg = &s_segments[i];
+        host_csv_t csv = {.out = open_memstream(&seg->csv, &seg->csv_len), .unparsed = 0};
+        if (csv.out == NULL) {
+            ESP_LOGE(TAG, "%s: no memory for its output", img->path);
+        } else {
+            seg->ok = log_reader_scan(image_read, img, INDEX_NO_EPOCH, img->base,
+                                      img->base + img->bytes, csv_record, &csv, &seg->st);
+            seg->ok = (fclose(csv.out) == 0) && seg->ok;
+            seg->unparsed = csv.unparsed;
+            if (!seg->ok) {
+                ESP_LOGW(TAG, "%s: scan stopped at offset %lu", img->path,
+                         (unsigned long)(img->base + seg->st.bytes));
+            }
+        }
+
+        pthread_mutex_lock(&s_segment_mux);
+        seg->done = true;
+        pthread_cond_broadcast(&s_segment_cond);
+        pthread_mutex_unlock(&s_segment_mux);
+    }
+}
+
+// Scan the segments on jobs workers and write their CSV in segment order as each one
+// completes. A segment that stops leaves the others readable; false if any did.
+static bool scan_parallel(size_t jobs, host_csv_t *csv, log_reader_stats_t *st)
+{
+    pthread_t workers[HOST_MAX_JOBS];
+    size_t started = 0;
+    bool ok = true;
+    const int64_t t0 = esp_timer_get_time();
+
+    memset(st, 0, sizeof(*st));
+    s_segment_window = jobs * HOST_REORDER_AHEAD;
+    for (; started < jobs; started++) {
+        if (pthread_create(&workers[started], NULL, segment_worker, NULL) != 0) {
+            break;
+        }
+    }
+    if (started == 0) {
+        ESP_LOGE(TAG, "pthread_create failed");
+        return false;
+    }
+
+    for (size_t i = 0; i < s_image_count; i++) {
+        host_segment_t *seg = &s_segments[i];
+        pthread_mutex_lock(&s_segment_mux);
+        while (!seg->done) {
+            pthread_cond_wait(&s_segment_cond, &s_segment_mux);
+        }
+        pthread_mutex_unlock(&s_segment_mux);
+
+        if (seg->csv_len > 0 && fwrite(seg->csv, 1, seg->csv_len, csv->out) != seg->csv_len) {
+            ok = false;
+        }
+        free(seg->csv);
+        seg->csv = NULL;
+        ok = ok && seg->ok;
+        csv->unparsed += seg->unparsed;
+        st->records += seg->st.records;
+        st->units += seg->st.units;
+        st->requests += seg->st.requests;
+        st->bytes += seg->st.bytes;
+        st->errors += seg->st.errors;
+        st->bad_checksums += seg->st.bad_checksums;
+        st->bad_tags += seg->st.bad_tags;
+
+        pthread_mutex_lock(&s_segment_mux);
+        s_segment_written = i + 1;
+        s_segment_stop = ferror(csv->out) != 0;
+        pthread_cond_broadcast(&s_segment_cond);
+        pthread_mutex_unlock(&s_segment_mux);
+        if (s_segment_stop) {
+            break;
+        }
+    }
+
+    for (size_t w = 0; w < started; w++) {
+        pthread_join(workers[w], NULL);
+    }
+    // Segments left behind by a failed output
+    for (size_t i = 0; i < s_image_count; i++) {
+        free(s_segments[i].csv);
+        s_segments[i].csv = NULL;
+    }
+    st->elapsed_us = (uint32_t)(esp_timer_get_time() - t0);
+    return ok;
+}
+
+// --------------------
+// OPTIGA
+// --------------------
+static optiga_util_t *optiga_open(void)
+{
+    optiga_util_t *util = optiga_util_create(0, optiga_sync_callback, &s_sync);
+    if (util == NULL) {
+        ESP_LOGE(TAG, "optiga_util_create failed");
+        return NULL;
+    }
+    const optiga_lib_status_t ret = OPTIGA_SYNC_CALL(&s_sync, HOST_OPEN_TIMEOUT_MS,
+                                                     optiga_util_open_application(util, 0));
+    if (ret != OPTIGA_LIB_SUCCESS) {
+        ESP_LOGE(TAG, "optiga_util_open_application failed: 0x%04X (%s)", ret,
+                 linux_events.i2c_if);
+        (void)optiga_util_destroy(util);
+        return NULL;
+    }
+    return util;
+}
+
+static void optiga_close(optiga_util_t *util)
+{
+    const optiga_lib_status_t ret = OPTIGA_SYNC_CALL(&s_sync, HOST_OPEN_TIMEOUT_MS,
+                                                     optiga_util_close_application(util, 0));
+    if (ret != OPTIGA_LIB_SUCCESS) {
+        ESP_LOGW(TAG, "optiga_util_close_application failed: 0x%04X", ret);
+    }
+    (void)optiga_util_destroy(util);
+}
+
+// --------------------
+// Main
+// --------------------
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [-d /dev/i2c-N] [-o out.csv] [-j workers] enc_log.bin "
+            "[more segments, oldest first]\n"
+            "  -j  segments decrypted in parallel (1..%d, default: cores); 1 reads the\n"
+            "      segments as one stream\n",
+            prog, HOST_MAX_JOBS);
+}
+
+int main(int argc, char **argv)
+{
+    const char *out_path = NULL;
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+    while ((opt = getopt(argc, argv, "d:o:j:h")) != -1) {
+        switch (opt) {
+        case 'd':
+            linux_events.i2c_if = optarg;
+            break;
+        case 'o':
+            out_path = optarg;
+            break;
+        case 'j':
+            jobs = strtol(optarg, NULL, 10);
+            if (jobs < 1) {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return (opt == 'h') ? 0 : 2;
+        }
+    }
+    const size_t count = (size_t)(argc - optind);
+    if (count == 0 || count > HOST_MAX_IMAGES) {
+        usage(argv[0]);
+        return 2;
+    }
+    jobs = (jobs < 1) ? 1 : (jobs > HOST_MAX_JOBS) ? HOST_MAX_JOBS : jobs;
+    jobs = ((size_t)jobs > count) ? (long)count : jobs;
+
+    uint32_t total = 0;
+    if (!images_open(argv + optind, count, &total)) {
+        images_close();
+        return 1;
+    }
+
+    host_csv_t csv = {.out = stdout, .unparsed = 0};
+    if (out_path && !(csv.out = fopen(out_path, "w"))) {
+        ESP_LOGE(TAG, "%s: cannot create", out_path);
+        images_close();
+        return 1;
+    }
+    static char out_buf[HOST_OUT_BUF_BYTES];
+    setvbuf(csv.out, out_buf, _IOFBF, sizeof(out_buf));
+
+    optiga_util_t *util = optiga_open();
+    if (util == NULL) {
+        images_close();
+        return 1;
+    }
+
+    csv_header(csv.out);
+    log_reader_stats_t st;
+    const bool ok = (jobs > 1) ? scan_parallel((size_t)jobs, &csv, &st)
+                               : log_reader_scan(images_read, NULL, INDEX_NO_EPOCH, 0, total,
+                                                 csv_record, &csv, &st);
+    const bool written = (fflush(csv.out) == 0) && !ferror(csv.out);
+    if (csv.out != stdout) {
+        fclose(csv.out);
+    }
+    optiga_close(util);
+    images_close();
+
+    const double secs = st.elapsed_us / 1e6;
+    ESP_LOGI(TAG, "%s: %lu records (%lu not sample records, %lu units, %lu decrypt requests, "
+             "%lu errors, %lu bad checksums, %lu bad tags) from %lu bytes in %.2f s = %.0f records/s, "
+             "%.1f KB/s", ok ? "done" : "stopped", (unsigned long)st.records,
+             (unsigned long)csv.unparsed, (unsigned long)st.units, (unsigned long)st.requests,
+             (unsigned long)st.errors, (unsigned long)st.bad_checksums, (unsigned long)st.bad_tags,
+             (unsigned long)st.bytes, secs, (secs > 0) ? st.records / secs : 0.0,
+             (secs > 0) ? st.bytes / secs / 1024.0 : 0.0);
+    if (!written) {
+        ESP_LOGE(TAG, "output write failed");
+    }
+    return (ok && written) ? 0 : 1;
+}
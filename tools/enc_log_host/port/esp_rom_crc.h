@@ -0,0 +1,31 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : ESP32 ROM CRC on a Linux host, for the shared main/ sources.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    esp_rom_crc.h
+ * @brief   Host stand-in for esp_rom_crc32_le()
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+#ifndef ENC_LOG_HOST_ESP_ROM_CRC_H
+#define ENC_LOG_HOST_ESP_ROM_CRC_H
+
+#include <stdint.h>
+
+// Same result as the ROM routine (and zlib.crc32): the CRC is inverted on entry and exit
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len);
+
+#endif // ENC_LOG_HOST_ESP_ROM_CRC_H
@@ -0,0 +1,31 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : ESP-IDF timer on a Linux host, for the shared main/ sources.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    esp_timer.h
+ * @brief   Host stand-in for esp_timer_get_time() (CLOCK_MONOTONIC)
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *******************************************************************************/
+#ifndef ENC_LOG_HOST_ESP_TIMER_H
+#define ENC_LOG_HOST_ESP_TIMER_H
+
+#include <stdint.h>
+
+// Microseconds since an arbitrary start
+int64_t esp_timer_get_time(void);
+
+#endif // ENC_LOG_HOST_ESP_TIMER_H
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Receive encrypted log uploads from ESP32 devices over HTTP.
+
+Host side of the HTTP upload (console command 'v', see main/log_upload.h for the
+protocol). Each device gets a directory named after its MAC; a stream is one
+file, stream-N.bin, byte-identical to the device log from where the stream
+started, ready for tools/enc_log_host. A body is appended only once it has
+been received completely; bytes already held are skipped.
+
+    python tools/enc_log_upload_server.py -d uploads
+    python tools/enc_log_upload_server.py -d uploads --port 8070
+"""
+import argparse
+import os
+import re
+import sys
+import threading
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+MAX_BODY = 1 << 20
+DEVICE_RE = re.compile(r"^[0-9a-f]{12}$")
+
+lock = threading.Lock()
+
+
+class BadRequest(Exception):
+    pass
+
+
+def stream_path(root, device, new):
+    """Newest stream file of the device, or the next one when new."""
+    folder = os.path.join(root, device)
+    os.makedirs(folder, exist_ok=True)
+    numbers = [int(m.group(1)) for m in
+               (re.match(r"^stream-(\d+)\.bin$", name) for name in os.listdir(folder)) if m]
+    last = max(numbers, default=-1)
+    n = last + 1 if new or last < 0 else last
+    return os.path.join(folder, "stream-%u.bin" % n)
+
+
+class UploadHandler(BaseHTTPRequestHandler):
+    server_version = "enc_log_upload/1.0"
+
+    def read_chunked(self):
+        body = bytearray()
+        while True:
+            line = self.rfile.readline(64)
+            if not line.endswith(b"\r\n"):
+                raise BadRequest("broken chunk size line")
+            size = int(line.split(b";")[0], 16)
+            if size == 0:
+                # Trailers, up to the empty line
+                while self.rfile.readline(1024) not in (b"\r\n", b""):
+                    pass
+                return bytes(body)
+            if len(body) + size > MAX_BODY:
+                raise BadRequest("body larger than %u bytes" % MAX_BODY)
+            chunk = self.rfile.read(size)
+            if len(chunk) != size or self.rfile.read(2) != b"\r\n":
+                raise BadRequest("short chunk")
+            body += chunk
+
+    def read_body(self):
+        if self.headers.get("Transfer-Encoding", "").lower() == "chunked":
+            return self.read_chunked()
+        length = int(self.headers.get("Content-Length", "0"))
+        if length > MAX_BODY:
+            raise BadRequest("body larger than %u bytes" % MAX_BODY)
+        body = self.rfile.read(length)
+        if len(body) != length:
+            raise BadRequest("short body")
+        return body
+
+    def answer(self, code, committed):
+        self.send_response(code)
+        self.send_header("X-Log-Committed", str(committed))
+        self.send_header("Content-Length", "0")
+        self.end_headers()
+
+    def do_POST(self):
+        device = self.headers.get("X-Log-Device", "").lower()
+        try:
+            if not DEVICE_RE.match(device):
+                raise BadRequest("missing or bad X-Log-Device")
+            total = int(self.headers.get("X-Log-Total", "0"))
+            restart = self.headers.get("X-Log-Restart") == "1"
+            # Nothing is written unless the whole body arrived
+            body = self.read_body()
+        except (BadRequest, ValueError) as e:
+            self.send_error(400, str(e))
+            return
+
+        with lock:
+            path = stream_path(self.server.root, device, restart)
+            held = os.path.getsize(path) if os.path.exists(path) else 0
+            if total > held:
+                self.answer(409, held)
+                return
+            new = body[held - total:]
+            if new:
+                with open(path, "ab") as f:
+                    f.write(new)
+                    f.flush()
+                    os.fsync(f.fileno())
+            committed = held + len(new)
+        self.log_message("%s %s: +%u bytes, %u held", device, os.path.basename(path),
+                         len(new), committed)
+        self.answer(200, committed)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("-d", "--dir", default="uploads", help="output directory (uploads)")
+    parser.add_argument("--host", default="0.0.0.0", help="address to listen on (0.0.0.0)")
+    parser.add_argument("--port", type=int, default=8070, help="TCP port (8070)")
+    args = parser.parse_args()
+
+    os.makedirs(args.dir, exist_ok=True)
+    server = ThreadingHTTPServer((args.host, args.port), UploadHandler)
+    server.root = args.dir
+    print("listening on %s:%u, streams in %s" % (args.host, args.port, args.dir))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
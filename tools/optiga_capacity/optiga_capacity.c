@@ -0,0 +1,600 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Predict whether a logging rate keeps up, before it is rolled out.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    optiga_capacity.c
+ * @brief   Capacity planning: the logger's writer loop in simulated time
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    pal/loopback in timed mode: the I2C transfers cost their wire time at
+ *          the bus bitrate, the emulated OPTIGA answers after the execution time of
+ *          each command code, and the stack's own polling and delays move the
+ *          simulated clock. A producer pushes records into the firmware's ring
+ *          (main/log_ring.c) at the offered rate; the writer takes them as
+ *          enc_log.c does for the LOG_* options of the build (per-record CBC, IV
+ *          derivation, CTR keystream cache, block groups, pipeline), sends the
+ *          same OPTIGA requests through optiga_crypt, optiga_cmd and ifx_i2c, and
+ *          charges the raw store's page programs and sector erases. The first
+ *          run keeps the ring full and gives the sustainable rate; then one run per
+ *          offered rate gives drops, ring depth and append latency.
+ *          One line "CAPACITY {json}" per run, then "CAPACITY_DONE".
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "optiga/ifx_i2c/ifx_i2c_config.h"
+#include "optiga/optiga_crypt.h"
+#include "optiga/optiga_util.h"
+#include "pal_loopback.h"
+
+#include "enc_log_config.h"
+#include "log_ring.h"
+
+#if LOG_RING_POLICY == LOG_RING_DROP_OLDEST
+#error "LOG_RING_DROP_OLDEST needs FreeRTOS critical sections, not modelled"
+#endif
+
+#define CAP_DEFAULT_SECONDS     60
+#define CAP_DEFAULT_TRANSFER_US 50      // ESP32 I2C driver: command link setup and ISR per transfer
+#define CAP_DEFAULT_PAGE_US     700     // SPI NOR page program, typical
+#define CAP_DEFAULT_ERASE_US    45000   // SPI NOR 4 KB sector erase, typical
+#define CAP_PAGES_PER_SECTOR    (RAW_SECTOR_BYTES / RAW_PAGE_BYTES)
+#define CAP_MAX_RATES           8
+
+// OPTIGA requests the writer makes in this build
+#define CAP_USES_CBC            (LOG_BATCH_MODE || !LOG_CTR_MODE)
+#define CAP_USES_TRNG           (LOG_BATCH_MODE || (!LOG_CTR_MODE && LOG_IV_MODE == 0))
+#define CAP_USES_ECB            (!LOG_BATCH_MODE && (LOG_CTR_MODE || LOG_IV_MODE == 1))
+// Largest request: a block group, or a keystream refill
+#define CAP_BUF_BYTES \
+    ((BATCH_PT_MAX_BYTES > LOG_CTR_REFILL_BLOCKS * AES_BLOCK_BYTES ? BATCH_PT_MAX_BYTES       \
+                                                                   : LOG_CTR_REFILL_BLOCKS * AES_BLOCK_BYTES) + \
+     2 * AES_BLOCK_BYTES)
+
+typedef struct {
+    uint32_t seconds;           // simulated time per run
+    uint16_t record_bytes;      // plaintext per record
+    uint32_t cpu_us;            // host CPU per OPTIGA request (stack, driver, task switches)
+    uint32_t page_us;
+    uint32_t erase_us;
+    double rates[CAP_MAX_RATES];
+    size_t rate_count;          // 0: 50/80/95/105% of the sustainable rate
+} cap_options_t;
+
+typedef struct {
+    uint32_t appended;
+    uint32_t dropped;           // ring full (or LOG_RING_BLOCK_MS passed)
+    uint32_t downsampled;
+    uint32_t max_depth;
+    uint32_t final_depth;
+    uint32_t requests;          // OPTIGA requests
+    uint64_t elapsed_ns;
+    uint64_t optiga_ns;         // from request start to callback, CPU time included
+    uint64_t cpu_ns;
+    uint64_t flash_ns;
+    uint64_t latency_sum_ns;    // push to append
+    uint64_t latency_max_ns;
+    pal_loopback_stats_t stats;
+} cap_result_t;
+
+// --------------------
+// Globals
+// --------------------
+static cap_options_t s_opt = {
+    .seconds = CAP_DEFAULT_SECONDS,
+    .record_bytes = PLAINTEXT_MAX,
+    .cpu_us = 0,
+    .page_us = CAP_DEFAULT_PAGE_US,
+    .erase_us = CAP_DEFAULT_ERASE_US,
+};
+static pal_loopback_timing_t s_timing = {
+    .bitrate_khz = 0,
+    .transfer_us = CAP_DEFAULT_TRANSFER_US,
+    .p_commands = NULL,
+};
+
+static volatile optiga_lib_status_t s_status;
+static optiga_util_t *s_util;
+static optiga_crypt_t *s_crypt;
+static log_ring_t s_ring;
+static cap_result_t s_res;
+
+// Producer: arrival of record seq at s_start_ns + seq * s_period_ns
+static uint64_t s_start_ns;
+static uint64_t s_end_ns;
+static uint64_t s_period_ns;    // 0: keep the ring full (sustainable rate run)
+static uint32_t s_next_seq;
+
+// Writer state, as in enc_log.c
+static uint32_t s_iv_cached;    // LOG_IV_MODE 1: derived IVs left
+static uint32_t s_ks_blocks;    // LOG_CTR_MODE: keystream blocks cached
+static uint32_t s_group_count;  // batch mode: records in the group buffer
+static uint32_t s_group_bytes;
+#if LOG_BATCH_MODE
+static uint32_t s_group_seq[LOG_BATCH_RECORDS];
+#endif
+static uint64_t s_store_free_ns;    // LOG_BATCH_PIPELINE: storage stage busy until
+static uint32_t s_page_fill;    // raw store: payload bytes in the open page
+static uint32_t s_pages;        // raw store: pages programmed
+
+static uint8_t s_pt[CAP_BUF_BYTES];
+static uint8_t s_ct[CAP_BUF_BYTES];
+
+// --------------------
+// OPTIGA
+// --------------------
+static void cap_callback(void *context, optiga_lib_status_t return_status)
+{
+    s_status = return_status;
+}
+
+// Drives the request to completion; in timed mode every event moves the clock
+static optiga_lib_status_t cap_wait(optiga_lib_status_t start_status)
+{
+    if (start_status != OPTIGA_LIB_SUCCESS) {
+        return start_status;
+    }
+    while (s_status == OPTIGA_LIB_BUSY) {
+        if (pal_os_event_process() == 0 && s_status == OPTIGA_LIB_BUSY) {
+            return OPTIGA_LIB_BUSY;
+        }
+    }
+    return s_status;
+}
+
+static uint64_t cap_now(void)
+{
+    return pal_loopback_timing_now_ns();
+}
+
+static void cap_request_begin(uint64_t *start)
+{
+    *start = cap_now();
+    pal_loopback_timing_advance((uint64_t)s_opt.cpu_us * 1000u);
+    s_res.cpu_ns += (uint64_t)s_opt.cpu_us * 1000u;
+    s_status = OPTIGA_LIB_BUSY;
+}
+
+static bool cap_request_end(uint64_t start, optiga_lib_status_t ret)
+{
+    s_res.requests++;
+    s_res.optiga_ns += cap_now() - start;
+    if (ret != OPTIGA_LIB_SUCCESS) {
+        fprintf(stderr, "OPTIGA request failed: 0x%04X\n", ret);
+        return false;
+    }
+    return true;
+}
+
+#if CAP_USES_TRNG
+static bool optiga_trng(uint8_t *out, uint16_t len)
+{
+    uint64_t start;
+    cap_request_begin(&start);
+    return cap_request_end(start, cap_wait(optiga_crypt_random(s_crypt, OPTIGA_RNG_TYPE_TRNG,
+                                                               out, len)));
+}
+#endif
+
+#if CAP_USES_ECB
+static bool optiga_ecb(uint32_t blocks)
+{
+    uint32_t out_len = blocks * AES_BLOCK_BYTES;
+    uint64_t start;
+    cap_request_begin(&start);
+    return cap_request_end(start, cap_wait(optiga_crypt_symmetric_encrypt_ecb(
+        s_crypt, OPTIGA_KEY_ID_SECRET_BASED, s_pt, blocks * AES_BLOCK_BYTES, s_ct, &out_len)));
+}
+#endif
+
+#if CAP_USES_CBC
+static bool optiga_cbc(const uint8_t *iv, uint32_t len)
+{
+    uint32_t out_len = sizeof(s_ct);
+    uint64_t start;
+    cap_request_begin(&start);
+    return cap_request_end(start, cap_wait(optiga_crypt_symmetric_encrypt(
+        s_crypt, OPTIGA_SYMMETRIC_CBC, OPTIGA_KEY_ID_SECRET_BASED, s_pt, len, iv, AES_IV_BYTES,
+        NULL, 0, s_ct, &out_len)));
+}
+#endif
+
+// --------------------
+// Storage
+// --------------------
+// Raw store: pages are programmed once full, a sector is erased before its first page
+static uint64_t flash_append(uint32_t bytes)
+{
+    uint64_t time_ns = 0;
+    s_page_fill += bytes;
+    while (s_page_fill >= RAW_PAGE_PAYLOAD_BYTES) {
+        s_page_fill -= RAW_PAGE_PAYLOAD_BYTES;
+        if (s_pages % CAP_PAGES_PER_SECTOR == 0) {
+            time_ns += (uint64_t)s_opt.erase_us * 1000u;
+        }
+        time_ns += (uint64_t)s_opt.page_us * 1000u;
+        s_pages++;
+    }
+    s_res.flash_ns += time_ns;
+    return time_ns;
+}
+
+static void record_appended(uint32_t seq, uint64_t at_ns)
+{
+    const uint64_t latency = (s_period_ns == 0) ? 0 : at_ns - (s_start_ns + seq * s_period_ns);
+    s_res.appended++;
+    s_res.latency_sum_ns += latency;
+    if (latency > s_res.latency_max_ns) {
+        s_res.latency_max_ns = latency;
+    }
+}
+
+// --------------------
+// Producer
+// --------------------
+static uint64_t arrival_ns(uint32_t seq)
+{
+    return s_start_ns + (uint64_t)seq * s_period_ns;
+}
+
+// Pushes every record due by now, as the producer task would have
+static void produce(void)
+{
+    const uint64_t now = cap_now();
+    uint8_t data[PLAINTEXT_MAX] = {0};
+
+    if (s_period_ns == 0) {
+        while (log_ring_count(&s_ring) < LOG_RING_SLOTS) {
+            log_ring_push(&s_ring, data, s_opt.record_bytes, s_next_seq++, 0, 0, NULL);
+        }
+        return;
+    }
+    while (arrival_ns(s_next_seq) <= now && arrival_ns(s_next_seq) < s_end_ns) {
+        const uint32_t uptime_ms = (uint32_t)(arrival_ns(s_next_seq) / 1000000u);
+        if (log_ring_push(&s_ring, data, s_opt.record_bytes, s_next_seq, uptime_ms, 0, NULL)) {
+            s_next_seq++;
+            continue;
+        }
+#if LOG_RING_POLICY == LOG_RING_BLOCK
+        // The producer waits for a slot; the records after it wait behind it
+        if (now - arrival_ns(s_next_seq) < (uint64_t)LOG_RING_BLOCK_MS * 1000000u) {
+            return;
+        }
+        s_res.dropped++;
+#endif
+        s_next_seq++;
+    }
+}
+
+// --------------------
+// Writer
+// --------------------
+#if LOG_BATCH_MODE
+static uint32_t group_pt_bytes(void)
+{
+#if LOG_RECORD_VARLEN
+    return ((s_group_bytes + AES_BLOCK_BYTES - 1) / AES_BLOCK_BYTES) * AES_BLOCK_BYTES;
+#else
+    return s_group_count * PLAINTEXT_MAX;
+#endif
+}
+
+static bool group_write(void)
+{
+    uint8_t iv[AES_IV_BYTES];
+    const uint32_t pt_bytes = group_pt_bytes();
+
+    if (!optiga_trng(iv, sizeof(iv)) || !optiga_cbc(iv, pt_bytes)) {
+        return false;
+    }
+    const uint64_t store_ns = flash_append(BLOCK_GROUP_HDR_BYTES + pt_bytes);
+#if LOG_BATCH_PIPELINE
+    // Hand the buffer over once the storage stage is done with the previous group
+    pal_loopback_timing_wait_until(s_store_free_ns);
+    s_store_free_ns = cap_now() + store_ns;
+    const uint64_t appended_ns = s_store_free_ns;
+#else
+    pal_loopback_timing_advance(store_ns);
+    const uint64_t appended_ns = cap_now();
+#endif
+    for (uint32_t i = 0; i < s_group_count; i++) {
+        record_appended(s_group_seq[i], appended_ns);
+    }
+    s_group_count = 0;
+    s_group_bytes = 0;
+    return true;
+}
+
+// Moves ring records into the group buffer; encrypts a full or overdue group.
+// False when there was nothing to do
+static bool writer_step(bool *failed)
+{
+    log_ring_slot_t slot;
+    while (s_group_count < LOG_BATCH_RECORDS && log_ring_take(&s_ring, &slot)) {
+        s_group_seq[s_group_count++] = slot.seq;
+        s_group_bytes += 1u + slot.len;
+    }
+    bool due = (s_group_count == LOG_BATCH_RECORDS);
+#if LOG_BATCH_MAX_LATENCY_MS > 0
+    due = due || (s_group_count > 0 && s_period_ns != 0 &&
+                  cap_now() >= arrival_ns(s_group_seq[0]) +
+                                   (uint64_t)LOG_BATCH_MAX_LATENCY_MS * 1000000u);
+#endif
+    if (!due) {
+        return false;
+    }
+    *failed = !group_write();
+    return true;
+}
+
+static uint64_t writer_deadline(void)
+{
+#if LOG_BATCH_MAX_LATENCY_MS > 0
+    if (s_group_count > 0) {
+        return arrival_ns(s_group_seq[0]) + (uint64_t)LOG_BATCH_MAX_LATENCY_MS * 1000000u;
+    }
+#endif
+    return UINT64_MAX;
+}
+#else
+static bool record_encrypt(uint32_t pt_bytes)
+{
+#if LOG_CTR_MODE
+    // Blocks missing from the cache are computed on the spot, LOG_CTR_REFILL_BLOCKS at a time
+    const uint32_t blocks = (pt_bytes + AES_BLOCK_BYTES - 1) / AES_BLOCK_BYTES;
+    while (s_ks_blocks < blocks) {
+        if (!optiga_ecb(LOG_CTR_REFILL_BLOCKS)) {
+            return false;
+        }
+        s_ks_blocks += LOG_CTR_REFILL_BLOCKS;
+    }
+    s_ks_blocks -= blocks;
+    return true;
+#else
+    uint8_t iv[AES_IV_BYTES] = {0};
+#if LOG_IV_MODE == 1
+    if (s_iv_cached == 0) {
+        if (!optiga_ecb(LOG_IV_BATCH)) {
+            return false;
+        }
+        s_iv_cached = LOG_IV_BATCH;
+    }
+    s_iv_cached--;
+#else
+    if (!optiga_trng(iv, sizeof(iv))) {
+        return false;
+    }
+#endif
+    return optiga_cbc(iv, pt_bytes);
+#endif
+}
+
+static bool writer_step(bool *failed)
+{
+    log_ring_slot_t slot;
+    if (!log_ring_take(&s_ring, &slot)) {
+#if LOG_CTR_MODE
+        // Idle pass: one refill command while the cache has room for it
+        if (s_ks_blocks + LOG_CTR_REFILL_BLOCKS <= LOG_CTR_CACHE_BLOCKS) {
+            *failed = !optiga_ecb(LOG_CTR_REFILL_BLOCKS);
+            s_ks_blocks += LOG_CTR_REFILL_BLOCKS;
+            return true;
+        }
+#endif
+        return false;
+    }
+    const uint32_t pt_bytes = RECORD_PT_BYTES(slot.len);
+    if (!record_encrypt(pt_bytes)) {
+        *failed = true;
+        return true;
+    }
+    pal_loopback_timing_advance(flash_append(RECORD_HDR_BYTES + AES_IV_BYTES + pt_bytes));
+    record_appended(slot.seq, cap_now());
+    return true;
+}
+
+static uint64_t writer_deadline(void)
+{
+    return UINT64_MAX;
+}
+#endif
+
+// --------------------
+// Runs
+// --------------------
+static bool run(double rate, uint32_t records)
+{
+    bool failed = false;
+
+    memset(&s_res, 0, sizeof(s_res));
+    log_ring_init(&s_ring);
+    s_iv_cached = 0;
+    s_ks_blocks = 0;
+    s_group_count = 0;
+    s_group_bytes = 0;
+    s_page_fill = 0;
+    s_pages = 0;
+    s_next_seq = 0;
+    s_start_ns = cap_now();
+    s_store_free_ns = s_start_ns;
+    s_period_ns = (rate > 0) ? (uint64_t)(1e9 / rate) : 0;
+    s_end_ns = s_start_ns + (uint64_t)s_opt.seconds * 1000000000u;
+    pal_loopback_reset_stats();
+
+    while (!failed) {
+        produce();
+        if (s_period_ns == 0 ? s_res.appended >= records : cap_now() >= s_end_ns) {
+            break;
+        }
+        if (!writer_step(&failed)) {
+            // Idle until the next record or the group deadline
+            uint64_t next = arrival_ns(s_next_seq);
+            if (next > writer_deadline()) {
+                next = writer_deadline();
+            }
+            pal_loopback_timing_wait_until((next < s_end_ns) ? next : s_end_ns);
+        }
+    }
+    s_res.elapsed_ns = cap_now() - s_start_ns;
+    s_res.dropped += s_ring.dropped;
+    // The sustainable rate run offers records until one fits: thinning is not a loss there
+    s_res.downsampled = (s_period_ns == 0) ? 0 : s_ring.downsampled;
+    s_res.max_depth = s_ring.high_water;
+    s_res.final_depth = log_ring_count(&s_ring);
+    pal_loopback_get_stats(&s_res.stats);
+    return !failed;
+}
+
+static void print_run(const char *kind, double rate)
+{
+    const double n = (s_res.appended > 0) ? (double)s_res.appended : 1.0;
+    const double secs = (double)s_res.elapsed_ns / 1e9;
+    const bool keeps_up = s_res.dropped == 0 && s_res.downsampled == 0 &&
+                          s_res.final_depth < LOG_RING_SLOTS;
+
+    printf("CAPACITY {\"run\":\"%s\",\"offered_per_s\":%.1f,\"simulated_s\":%.2f,"
+           "\"appended\":%u,\"appended_per_s\":%.1f,\"dropped\":%u,\"downsampled\":%u,"
+           "\"ring\":{\"slots\":%u,\"max_depth\":%u,\"final_depth\":%u},"
+           "\"latency_us\":{\"mean\":%.0f,\"max\":%.0f},"
+           "\"per_record_us\":{\"optiga\":%.0f,\"wire\":%.0f,\"execute\":%.0f,\"cpu\":%.0f,"
+           "\"flash\":%.0f},\"optiga_requests_per_record\":%.3f,\"i2c_transfers_per_record\":%.1f,\"keeps_up\":%s}\n",
+           kind, rate, secs, s_res.appended, s_res.appended / secs, s_res.dropped,
+           s_res.downsampled, (unsigned)LOG_RING_SLOTS, s_res.max_depth, s_res.final_depth,
+           s_res.latency_sum_ns / n / 1000.0, s_res.latency_max_ns / 1000.0,
+           s_res.optiga_ns / n / 1000.0, s_res.stats.wire_ns / n / 1000.0,
+           s_res.stats.execute_ns / n / 1000.0, s_res.cpu_ns / n / 1000.0,
+           s_res.flash_ns / n / 1000.0, s_res.requests / n,
+           (s_res.stats.i2c_writes + s_res.stats.i2c_reads) / n,
+           (s_period_ns == 0) ? "null" : (keeps_up ? "true" : "false"));
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [-r records_per_s]... [-t seconds] [-l record_bytes] [-f i2c_khz]\n"
+            "          [-x transfer_us] [-c cpu_us] [-p page_us] [-e erase_us]\n"
+            "  -r  offered rate, repeatable (default: 50/80/95/105%% of the sustainable rate)\n"
+            "  -t  simulated seconds per run (%u)\n"
+            "  -l  plaintext bytes per record (%u)\n"
+            "  -f  I2C clock in kHz (default: the stack's, %u)\n"
+            "  -x  time per I2C transfer on top of its bytes, us (%u)\n"
+            "  -c  host CPU time per OPTIGA request, us (0)\n"
+            "  -p  flash page program time, us (%u)\n"
+            "  -e  flash sector erase time, us (%u)\n",
+            prog, CAP_DEFAULT_SECONDS, PLAINTEXT_MAX, (unsigned)IFX_I2C_FREQUENCY_KHZ,
+            CAP_DEFAULT_TRANSFER_US, CAP_DEFAULT_PAGE_US, CAP_DEFAULT_ERASE_US);
+}
+
+static bool parse_options(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "r:t:l:f:x:c:p:e:h")) != -1) {
+        switch (c) {
+        case 'r':
+            if (s_opt.rate_count == CAP_MAX_RATES || atof(optarg) <= 0) {
+                return false;
+            }
+            s_opt.rates[s_opt.rate_count++] = atof(optarg);
+            break;
+        case 't':
+            s_opt.seconds = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'l':
+            s_opt.record_bytes = (uint16_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'f':
+            s_timing.bitrate_khz = (uint16_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'x':
+            s_timing.transfer_us = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            s_opt.cpu_us = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'p':
+            s_opt.page_us = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'e':
+            s_opt.erase_us = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            return false;
+        }
+    }
+    return s_opt.seconds > 0 && s_opt.record_bytes > 0 && s_opt.record_bytes <= PLAINTEXT_MAX;
+}
+
+// --------------------
+// Main
+// --------------------
+int main(int argc, char **argv)
+{
+    if (!parse_options(argc, argv)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    pal_loopback_timing_start(&s_timing);
+    s_util = optiga_util_create(0, cap_callback, NULL);
+    s_crypt = optiga_crypt_create(0, cap_callback, NULL);
+    if (s_util == NULL || s_crypt == NULL) {
+        fprintf(stderr, "optiga instance create failed\n");
+        return 1;
+    }
+    s_status = OPTIGA_LIB_BUSY;
+    optiga_lib_status_t ret = cap_wait(optiga_util_open_application(s_util, 0));
+    if (ret != OPTIGA_LIB_SUCCESS) {
+        fprintf(stderr, "optiga_util_open_application failed: 0x%04X\n", ret);
+        return 1;
+    }
+
+    // Ring kept full: the writer never waits, its rate is the most the build sustains
+    const uint32_t saturation_records = 64u * LOG_BATCH_RECORDS + 8u * LOG_RING_SLOTS;
+    if (!run(0, saturation_records)) {
+        return 1;
+    }
+    print_run("sustainable", 0);
+    const double sustainable = s_res.appended / ((double)s_res.elapsed_ns / 1e9);
+
+    if (s_opt.rate_count == 0) {
+        static const double fractions[] = { 0.50, 0.80, 0.95, 1.05 };
+        for (size_t i = 0; i < sizeof(fractions) / sizeof(fractions[0]); i++) {
+            s_opt.rates[s_opt.rate_count++] = sustainable * fractions[i];
+        }
+    }
+    int failed = 0;
+    for (size_t i = 0; i < s_opt.rate_count; i++) {
+        if (!run(s_opt.rates[i], 0)) {
+            failed = 1;
+            break;
+        }
+        print_run("offered", s_opt.rates[i]);
+    }
+    printf("CAPACITY_DONE\n");
+
+    s_status = OPTIGA_LIB_BUSY;
+    (void)cap_wait(optiga_util_close_application(s_util, 0));
+    (void)optiga_crypt_destroy(s_crypt);
+    (void)optiga_util_destroy(s_util);
+    return failed;
+}
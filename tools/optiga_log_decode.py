@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""Decode an OPTIGA binary log file to text.
+
+Host side of the binary logging mode of optiga_lib_logger
+(CONFIG_OPTIGA_TRUST_M_BINARY_LOG): the console command 'o' saves the RAM ring
+as optiga_log.bin, see optiga_lib_logger.h for the record format. Lines are
+printed in the layout of the text logger, prefixed with the time stamp.
+
+    python tools/optiga_log_decode.py optiga_log.bin
+    python tools/optiga_log_decode.py optiga_log.bin --no-color
+"""
+import argparse
+import struct
+import sys
+
+MAGIC = 0x474F4C4F
+FILE_HEADER = struct.Struct("<IHHIII")
+RECORD_HEADER = struct.Struct("<IHBB")
+
+RECORD_STRING = 0x01
+RECORD_LINE = 0x02
+RECORD_MESSAGE = 0x03
+RECORD_STATUS = 0x04
+RECORD_ARRAY = 0x05
+RECORD_TRUNCATED = 0x80
+
+LAYERS = {
+    0x00: "",
+    0x01: "[optiga util]     : ",
+    0x02: "[optiga crypt]    : ",
+    0x03: "[optiga cmd]      : ",
+    0x04: "[optiga comms]    : ",
+}
+LAYER_OTHER = 0x0F
+COLORS = [0, 31, 32, 33, 34, 35, 36, 90, 91, 92, 93, 94, 95, 96]
+ARRAY_BYTES_PER_LINE = 32
+
+
+def decode(data, color):
+    if len(data) < FILE_HEADER.size:
+        raise ValueError("file too short")
+    magic, version, header_size, records, dropped, size = FILE_HEADER.unpack_from(data)
+    if magic != MAGIC:
+        raise ValueError("not an OPTIGA binary log (magic 0x%08X)" % magic)
+    if version != 1 or header_size != RECORD_HEADER.size:
+        raise ValueError("unsupported version %u, record header %u bytes" % (version, header_size))
+    print("# %u records, %u bytes, %u dropped before the oldest record" % (records, size, dropped))
+
+    offset = FILE_HEADER.size
+    end = min(len(data), offset + size)
+    count = 0
+    while offset + RECORD_HEADER.size <= end:
+        time_us, length, rtype, attributes = RECORD_HEADER.unpack_from(data, offset)
+        offset += RECORD_HEADER.size
+        body = data[offset:offset + length]
+        offset += length
+        count += 1
+
+        layer_id = attributes & 0x0F
+        esc = COLORS[attributes >> 4] if (attributes >> 4) < len(COLORS) else 0
+        layer = LAYERS.get(layer_id, "")
+        if layer_id == LAYER_OTHER:
+            name, _, body = body.partition(b"\x00")
+            layer = name.decode("latin-1")
+        on = "\x1b[%um" % esc if color else ""
+        off = "\x1b[0m" if color else ""
+        stamp = "%10.6f " % (time_us / 1e6)
+        kind = rtype & 0x7F
+
+        if kind in (RECORD_STRING, RECORD_LINE):
+            print(stamp + body.decode("latin-1").rstrip("\r\n"))
+        elif kind == RECORD_MESSAGE:
+            print(stamp + on + layer + body.decode("latin-1").rstrip("\r\n") + off)
+        elif kind == RECORD_STATUS:
+            value = struct.unpack(">H", body[:2])[0] if len(body) >= 2 else 0
+            text = "Passed" if value == 0 else "Failed with return value - 0x%04X" % value
+            print(stamp + on + layer + text + off)
+        elif kind == RECORD_ARRAY:
+            print(stamp + "%37s0x%04X" % ("Length of data - ", length))
+            for i in range(0, length, ARRAY_BYTES_PER_LINE):
+                chunk = body[i:i + ARRAY_BYTES_PER_LINE]
+                print(" " * 11 + on + " ".join("%02X" % b for b in chunk) + off)
+        else:
+            print(stamp + "unknown record type 0x%02X, %u bytes" % (rtype, length))
+        if rtype & RECORD_TRUNCATED:
+            print(" " * 11 + "[truncated]")
+
+    if count != records:
+        print("# %u of %u records decoded, file is truncated" % (count, records), file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("file", help="binary log saved by the 'o' console command")
+    parser.add_argument("--no-color", action="store_true", help="omit the ANSI color codes")
+    args = parser.parse_args()
+
+    with open(args.file, "rb") as f:
+        data = f.read()
+    try:
+        decode(data, not args.no_color)
+    except ValueError as e:
+        print("error: %s" % e, file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
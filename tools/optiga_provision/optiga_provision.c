@@ -0,0 +1,317 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Personalize many OPTIGA devices at once on a factory station.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    optiga_provision.c
+ * @brief   Parallel fleet provisioning through pal/linux, one worker per bus
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    Each bus (/dev/i2c-N, or the adapter of an I2C mux channel) gets its
+ *          own worker process running the OPTIGA library as instance 0, so any
+ *          number of devices is provisioned at once: the library keeps its
+ *          state in globals and in-process instances are limited to
+ *          OPTIGA_MAX_INSTANCES. A worker writes the 0xE200 key slot metadata,
+ *          generates the AES-128 key there, optionally writes a certificate and
+ *          reports the time of each step to the parent over a pipe. The parent
+ *          prints one line per device and the aggregate throughput.
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "optiga/optiga_crypt.h"
+#include "optiga/optiga_util.h"
+#include "optiga_sync.h"
+#include "pal_linux.h"
+
+#define PROVISION_MAX_BUSES         32
+#define PROVISION_KEY_OID           0xE200      // LOG_KEY_OID of the firmware
+#define PROVISION_CERT_OID          0xE0E1      // first free certificate slot
+#define PROVISION_CERT_MAX_BYTES    1728        // certificate data object size
+#define PROVISION_TIMEOUT_MS        5000
+
+typedef enum {
+    STEP_OPEN,
+    STEP_METADATA,
+    STEP_KEY,
+    STEP_CERT,
+    STEP_CLOSE,
+    STEP_COUNT
+} provision_step_t;
+
+// Sent by a worker to the parent once its device is done or has failed
+typedef struct {
+    uint64_t step_us[STEP_COUNT];
+    uint64_t total_us;
+    uint16_t status;            // OPTIGA return code of the failed step, 0 = done
+    uint8_t failed_step;        // provision_step_t, STEP_COUNT when none failed
+} provision_result_t;
+
+typedef struct {
+    const char *bus;
+    pid_t pid;
+    int fd;                     // read end of the worker's result pipe
+    provision_result_t result;
+    bool reported;
+} provision_worker_t;
+
+// --------------------
+// Globals
+// --------------------
+static const char *const s_step_names[STEP_COUNT] = {"open", "metadata", "key", "cert", "close"};
+
+// Metadata written to the AES key slot: enables AES key usage in 0xE200 (as enc_log.c)
+static const uint8_t s_key_metadata[] = {0x20, 0x06, 0xD0, 0x01, 0x00, 0xD3, 0x01, 0x00};
+
+// I2C device of the target config (pal/linux/target/*/pal_ifx_i2c_config.c)
+extern pal_linux_t linux_events;
+
+static provision_worker_t s_workers[PROVISION_MAX_BUSES];
+static size_t s_worker_count = 0;
+static uint8_t s_cert[PROVISION_CERT_MAX_BYTES];
+static size_t s_cert_len = 0;
+static uint16_t s_cert_oid = PROVISION_CERT_OID;
+
+// --------------------
+// Helpers
+// --------------------
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static bool cert_load(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return false;
+    }
+    s_cert_len = fread(s_cert, 1, sizeof(s_cert), f);
+    const bool too_long = fgetc(f) != EOF;
+    fclose(f);
+    if (s_cert_len == 0 || too_long) {
+        fprintf(stderr, "%s: empty or larger than %u bytes\n", path, PROVISION_CERT_MAX_BYTES);
+        return false;
+    }
+    return true;
+}
+
+// --------------------
+// Worker
+// --------------------
+// Runs one step and records its time; false (with the status in res) when it failed
+static bool step_run(provision_result_t *res, provision_step_t step, optiga_sync_t *sync,
+                     optiga_lib_status_t start_status)
+{
+    const uint64_t t0 = now_us();
+    const optiga_lib_status_t ret = optiga_sync_run(sync, start_status, PROVISION_TIMEOUT_MS);
+    res->step_us[step] = now_us() - t0;
+    if (ret != OPTIGA_LIB_SUCCESS) {
+        res->status = ret;
+        res->failed_step = (uint8_t)step;
+        return false;
+    }
+    return true;
+}
+
+#define STEP(res, step, sync, call) \
+    (optiga_sync_begin(sync), step_run((res), (step), (sync), (call)))
+
+static void provision_device(provision_result_t *res)
+{
+    static optiga_sync_t sync;
+    optiga_key_id_t key_id = OPTIGA_KEY_ID_SECRET_BASED;
+    const uint64_t t0 = now_us();
+
+    memset(res, 0, sizeof(*res));
+    res->failed_step = STEP_COUNT;
+
+    optiga_util_t *util = optiga_util_create(0, optiga_sync_callback, &sync);
+    optiga_crypt_t *crypt = optiga_crypt_create(0, optiga_sync_callback, &sync);
+    if (util == NULL || crypt == NULL) {
+        res->status = 0xFFFF;
+        res->failed_step = STEP_OPEN;
+    } else if (STEP(res, STEP_OPEN, &sync, optiga_util_open_application(util, 0))) {
+        (void)(STEP(res, STEP_METADATA, &sync,
+                    optiga_util_write_metadata(util, PROVISION_KEY_OID, s_key_metadata,
+                                               sizeof(s_key_metadata))) &&
+               STEP(res, STEP_KEY, &sync,
+                    optiga_crypt_symmetric_generate_key(crypt, OPTIGA_SYMMETRIC_AES_128,
+                                                        (uint8_t)OPTIGA_KEY_USAGE_ENCRYPTION,
+                                                        FALSE, &key_id)) &&
+               (s_cert_len == 0 ||
+                STEP(res, STEP_CERT, &sync,
+                     optiga_util_write_data(util, s_cert_oid, OPTIGA_UTIL_ERASE_AND_WRITE, 0,
+                                            s_cert, (uint16_t)s_cert_len))));
+        // Close even after a failed step; a close failure only counts when all else passed
+        provision_result_t close_res = *res;
+        if (!STEP(&close_res, STEP_CLOSE, &sync, optiga_util_close_application(util, 0)) &&
+            res->failed_step == STEP_COUNT) {
+            *res = close_res;
+        }
+        res->step_us[STEP_CLOSE] = close_res.step_us[STEP_CLOSE];
+    }
+    if (crypt != NULL) {
+        (void)optiga_crypt_destroy(crypt);
+    }
+    if (util != NULL) {
+        (void)optiga_util_destroy(util);
+    }
+    res->total_us = now_us() - t0;
+}
+
+static bool worker_start(provision_worker_t *w)
+{
+    int fds[2];
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        return false;
+    }
+    w->pid = fork();
+    if (w->pid < 0) {
+        perror("fork");
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (w->pid == 0) {
+        // Worker: only its own bus, the library state is private to this process
+        provision_result_t res;
+        close(fds[0]);
+        linux_events.i2c_if = w->bus;
+        provision_device(&res);
+        const bool sent = write(fds[1], &res, sizeof(res)) == (ssize_t)sizeof(res);
+        _exit((sent && res.failed_step == STEP_COUNT) ? 0 : 1);
+    }
+    close(fds[1]);
+    w->fd = fds[0];
+    return true;
+}
+
+static void worker_collect(provision_worker_t *w)
+{
+    ssize_t n;
+    do {
+        n = read(w->fd, &w->result, sizeof(w->result));
+    } while (n < 0 && errno == EINTR);
+    w->reported = n == (ssize_t)sizeof(w->result);
+    close(w->fd);
+    (void)waitpid(w->pid, NULL, 0);
+}
+
+// --------------------
+// Report
+// --------------------
+static void report_device(const provision_worker_t *w)
+{
+    if (!w->reported) {
+        printf("%-14s FAILED worker exited without a result\n", w->bus);
+        return;
+    }
+    const provision_result_t *r = &w->result;
+    if (r->failed_step == STEP_COUNT) {
+        printf("%-14s ok     %8.1f ms", w->bus, r->total_us / 1000.0);
+    } else {
+        printf("%-14s FAILED %8.1f ms (%s: 0x%04X)", w->bus, r->total_us / 1000.0,
+               s_step_names[r->failed_step], r->status);
+    }
+    for (int s = 0; s < STEP_COUNT; s++) {
+        if (r->step_us[s] != 0) {
+            printf("  %s %.1f", s_step_names[s], r->step_us[s] / 1000.0);
+        }
+    }
+    putchar('\n');
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [-c cert.der] [-O cert_oid] /dev/i2c-N [more buses, one device each]\n",
+            prog);
+}
+
+// --------------------
+// Main
+// --------------------
+int main(int argc, char **argv)
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "c:O:h")) != -1) {
+        switch (opt) {
+        case 'c':
+            if (!cert_load(optarg)) {
+                return 1;
+            }
+            break;
+        case 'O':
+            s_cert_oid = (uint16_t)strtoul(optarg, NULL, 16);
+            break;
+        default:
+            usage(argv[0]);
+            return (opt == 'h') ? 0 : 2;
+        }
+    }
+    s_worker_count = (size_t)(argc - optind);
+    if (s_worker_count == 0 || s_worker_count > PROVISION_MAX_BUSES) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // Nothing buffered may be copied into the workers
+    fflush(stdout);
+    const uint64_t t0 = now_us();
+    size_t started = 0;
+    for (size_t i = 0; i < s_worker_count; i++) {
+        s_workers[i].bus = argv[optind + (int)i];
+        if (!worker_start(&s_workers[i])) {
+            break;
+        }
+        started++;
+    }
+    for (size_t i = 0; i < started; i++) {
+        worker_collect(&s_workers[i]);
+    }
+    const uint64_t wall_us = now_us() - t0;
+
+    size_t done = 0;
+    uint64_t device_us = 0;
+    for (size_t i = 0; i < started; i++) {
+        report_device(&s_workers[i]);
+        if (s_workers[i].reported) {
+            device_us += s_workers[i].result.total_us;
+            done += s_workers[i].result.failed_step == STEP_COUNT;
+        }
+    }
+    const double wall_s = wall_us / 1e6;
+    printf("%zu of %zu devices provisioned in %.2f s = %.1f devices/min, %.2f s of device time "
+           "(%.1fx in parallel)\n",
+           done, s_worker_count, wall_s, (wall_s > 0) ? done * 60.0 / wall_s : 0.0,
+           device_us / 1e6, (wall_us > 0) ? (double)device_us / wall_us : 0.0);
+    return (done == s_worker_count) ? 0 : 1;
+}
@@ -0,0 +1,314 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Replays an I2C capture of the firmware against the host OPTIGA stack.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    optiga_replay.c
+ * @brief   Deterministic replay of a pal_i2c capture on pal/loopback
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    The capture (CONFIG_OPTIGA_TRUST_M_I2C_CAPTURE, console 'i') holds every
+ *          PAL I2C call and each command APDU given to optiga_comms_transceive.
+ *          Each APDU is sent again through the comms stack (presentation, transport,
+ *          data link and physical layers); pal/loopback answers the reads from the
+ *          capture, checks the writes against it and gives the stack the captured
+ *          time. A stack change that alters the bus traffic shows as a write
+ *          mismatch or a divergence at the APDU it affects. One line "REPLAY {json}"
+ *          per APDU, then "REPLAY_DONE {json}".
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "optiga/comms/optiga_comms.h"
+#include "optiga/pal/pal_os_datastore.h"
+#include "optiga/pal/pal_os_event.h"
+#include "pal_loopback.h"
+
+#define REPLAY_RX_BYTES         (OPTIGA_MAX_COMMS_BUFFER_SIZE + OPTIGA_COMMS_DATA_OFFSET + 16U)
+
+static const char *const s_record_names[] = {"none", "init", "write", "read", "bitrate", "apdu"};
+
+typedef struct {
+    uint32_t sessions;
+    uint32_t apdus;
+    uint32_t failed;            // APDUs the replayed stack did not complete
+    uint32_t skipped;           // transfer records outside a replayed APDU
+    uint64_t captured_us;       // sum of the captured APDU times
+    uint64_t bus_us;
+    uint64_t host_ns;
+} replay_totals_t;
+
+// --------------------
+// Globals
+// --------------------
+static volatile optiga_lib_status_t s_status;
+static uint8_t s_tx[REPLAY_RX_BYTES];
+static uint8_t s_rx[REPLAY_RX_BYTES];
+
+// --------------------
+// Helpers
+// --------------------
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static const char *record_name(uint8_t type)
+{
+    return type < sizeof(s_record_names) / sizeof(s_record_names[0]) ? s_record_names[type] : "?";
+}
+
+static void replay_callback(void *context, optiga_lib_status_t return_status)
+{
+    s_status = return_status;
+}
+
+// Drives the comms request to completion, the loopback PAL runs nothing on its own
+static optiga_lib_status_t replay_wait(optiga_lib_status_t start_status)
+{
+    if (start_status != OPTIGA_LIB_SUCCESS) {
+        return start_status;
+    }
+    while (s_status == OPTIGA_LIB_BUSY) {
+        if (pal_os_event_process() == 0 && s_status == OPTIGA_LIB_BUSY) {
+            return OPTIGA_LIB_BUSY;
+        }
+    }
+    return s_status;
+}
+
+static uint8_t *load_file(const char *path, uint32_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = size > 0 ? malloc((size_t)size) : NULL;
+    if (buf == NULL || fread(buf, 1, (size_t)size, f) != (size_t)size) {
+        fprintf(stderr, "%s: cannot read\n", path);
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *len = (uint32_t)size;
+    return buf;
+}
+
+static int parse_secret(const char *hex, uint8_t *out, uint16_t cap, uint16_t *len)
+{
+    const size_t n = strlen(hex);
+    if (n == 0 || (n % 2) != 0 || n / 2 > cap) {
+        return -1;
+    }
+    for (size_t i = 0; i < n / 2; i++) {
+        unsigned v;
+        if (sscanf(&hex[2 * i], "%2x", &v) != 1) {
+            return -1;
+        }
+        out[i] = (uint8_t)v;
+    }
+    *len = (uint16_t)(n / 2);
+    return 0;
+}
+
+// Skips transfers up to the next record of the wanted type; FALSE at the end or on an INIT
+static bool_t seek_record(uint8_t wanted, replay_totals_t *totals, pal_i2c_capture_record_t *rec,
+                          const uint8_t **data)
+{
+    while (pal_loopback_replay_peek(rec, data)) {
+        if (rec->type == wanted) {
+            return TRUE;
+        }
+        if (rec->type == PAL_I2C_CAPTURE_INIT) {
+            return FALSE;
+        }
+        totals->skipped++;
+        pal_loopback_replay_skip();
+    }
+    return FALSE;
+}
+
+static void replay_apdu(optiga_comms_t *comms, const pal_i2c_capture_record_t *rec, const uint8_t *apdu,
+                        replay_totals_t *totals)
+{
+    pal_loopback_replay_stats_t before, after;
+    uint16_t rx_len = sizeof(s_rx);
+
+    pal_loopback_replay_get_stats(&before);
+    pal_loopback_replay_skip();
+    memcpy(&s_tx[OPTIGA_COMMS_DATA_OFFSET], apdu, rec->length);
+    comms->protection_level = rec->status;
+    comms->protocol_version = OPTIGA_COMMS_PROTOCOL_VERSION_PRE_SHARED_SECRET;
+
+    s_status = OPTIGA_LIB_BUSY;
+    const uint64_t start = now_ns();
+    const optiga_lib_status_t ret = replay_wait(optiga_comms_transceive(comms, s_tx, rec->length, s_rx, &rx_len));
+    const uint64_t host_ns = now_ns() - start;
+    pal_loopback_replay_get_stats(&after);
+
+    const uint32_t captured_us = after.end_us - rec->time_us;
+    const uint32_t bus_us = (uint32_t)(after.bus_us - before.bus_us);
+    totals->apdus++;
+    totals->captured_us += captured_us;
+    totals->bus_us += bus_us;
+    totals->host_ns += host_ns;
+    if (ret != OPTIGA_LIB_SUCCESS) {
+        totals->failed++;
+    }
+
+    // Response status is the first byte after the comms offset
+    printf("REPLAY {\"apdu\":%lu,\"cmd\":\"0x%02X\",\"param\":\"0x%02X\",\"bytes\":%u,\"protection\":%u,"
+           "\"time_us\":%lu,\"captured_us\":%lu,\"bus_us\":%lu,\"transfers\":%lu,\"mismatches\":%lu,"
+           "\"host_us\":%.1f,\"status\":\"0x%04X\",\"sta\":\"0x%02X\"}\n",
+           (unsigned long)totals->apdus, rec->length > 0 ? apdu[0] : 0, rec->length > 1 ? apdu[1] : 0,
+           (unsigned)rec->length, (unsigned)rec->status, (unsigned long)rec->time_us,
+           (unsigned long)captured_us, (unsigned long)bus_us,
+           (unsigned long)(after.transfers - before.transfers),
+           (unsigned long)(after.write_mismatches - before.write_mismatches),
+           (double)host_ns / 1000.0, (unsigned)ret,
+           (ret == OPTIGA_LIB_SUCCESS && rx_len > 0) ? s_rx[OPTIGA_COMMS_DATA_OFFSET] : 0xFF);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [-d 0|1] [-k binding_secret_hex] i2c_cap.bin\n"
+            "  -d  OPTIGA instance to replay (default 0)\n"
+            "  -k  platform binding secret of the device, if not the pal/linux default\n",
+            prog);
+}
+
+// --------------------
+// Main
+// --------------------
+int main(int argc, char **argv)
+{
+    uint8_t device = 0;
+    uint8_t secret[OPTIGA_SHARED_SECRET_MAX_LENGTH];
+    uint16_t secret_len = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:k:h")) != -1) {
+        switch (opt) {
+        case 'd':
+            device = (uint8_t)atoi(optarg);
+            break;
+        case 'k':
+            if (parse_secret(optarg, secret, sizeof(secret), &secret_len) != 0) {
+                fprintf(stderr, "binding secret: even number of hex digits, at most %u bytes\n",
+                        (unsigned)sizeof(secret));
+                return 2;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind + 1 != argc || device > 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    uint32_t len = 0;
+    uint8_t *capture = load_file(argv[optind], &len);
+    if (capture == NULL) {
+        return 1;
+    }
+    if (pal_loopback_replay_start(capture, len, device) != PAL_STATUS_SUCCESS) {
+        fprintf(stderr, "%s: not a capture file of version %u\n", argv[optind], (unsigned)PAL_I2C_CAPTURE_VERSION);
+        free(capture);
+        return 1;
+    }
+    if (secret_len > 0 &&
+        pal_os_datastore_write(OPTIGA_PLATFORM_BINDING_SHARED_SECRET_ID, secret, secret_len) != PAL_STATUS_SUCCESS) {
+        fprintf(stderr, "binding secret not set\n");
+        free(capture);
+        return 1;
+    }
+
+    optiga_comms_t *comms = optiga_comms_create(0, replay_callback, NULL);
+    if (comms == NULL) {
+        fprintf(stderr, "optiga_comms_create failed\n");
+        free(capture);
+        return 1;
+    }
+    comms->p_pal_os_event_ctx = pal_os_event_create(NULL, NULL);
+
+    replay_totals_t totals = {0};
+    pal_i2c_capture_record_t rec;
+    const uint8_t *data;
+    bool_t open = FALSE;
+
+    // A capture starts wherever the ring wrapped: replay from the first comms open on
+    while (seek_record(PAL_I2C_CAPTURE_INIT, &totals, &rec, &data)) {
+        if (open) {
+            // The firmware reopened (reset recovery): close on the emulator, outside the capture
+            pal_loopback_replay_stop();
+            s_status = OPTIGA_LIB_BUSY;
+            (void)replay_wait(optiga_comms_close(comms));
+            pal_loopback_replay_resume();
+        }
+        s_status = OPTIGA_LIB_BUSY;
+        const optiga_lib_status_t ret = replay_wait(optiga_comms_open(comms));
+        open = TRUE;
+        totals.sessions++;
+        if (ret != OPTIGA_LIB_SUCCESS) {
+            fprintf(stderr, "session %lu: comms open failed: 0x%04X\n", (unsigned long)totals.sessions, ret);
+            break;
+        }
+        while (seek_record(PAL_I2C_CAPTURE_APDU, &totals, &rec, &data)) {
+            replay_apdu(comms, &rec, data, &totals);
+        }
+        pal_loopback_replay_stats_t st;
+        pal_loopback_replay_get_stats(&st);
+        if (st.diverged) {
+            break;
+        }
+    }
+
+    pal_loopback_replay_stats_t st;
+    pal_loopback_replay_get_stats(&st);
+    if (st.diverged) {
+        fprintf(stderr, "diverged at offset %lu: stack called %s, capture has %s\n",
+                (unsigned long)st.diverged_offset, record_name(st.diverged_call), record_name(st.diverged_found));
+    }
+    printf("REPLAY_DONE {\"sessions\":%lu,\"apdus\":%lu,\"failed\":%lu,\"records\":%lu,\"skipped\":%lu,"
+           "\"transfers\":%lu,\"mismatches\":%lu,\"diverged\":%s,"
+           "\"captured_us\":%llu,\"bus_us\":%llu,\"host_us\":%.0f}\n",
+           (unsigned long)totals.sessions, (unsigned long)totals.apdus, (unsigned long)totals.failed,
+           (unsigned long)st.records, (unsigned long)totals.skipped, (unsigned long)st.transfers,
+           (unsigned long)st.write_mismatches, st.diverged ? "true" : "false",
+           (unsigned long long)totals.captured_us, (unsigned long long)totals.bus_us,
+           (double)totals.host_ns / 1000.0);
+
+    pal_loopback_replay_stop();
+    free(capture);
+    return (st.diverged || st.write_mismatches > 0 || totals.failed > 0) ? 1 : 0;
+}
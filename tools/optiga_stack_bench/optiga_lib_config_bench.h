@@ -0,0 +1,18 @@
+/**
+ * \file optiga_lib_config_bench.h
+ *
+ * \brief   Library configuration of the stack benchmark (OPTIGA_LIB_EXTERNAL).
+ *
+ * \details The default Trust M V3 feature set without the shielded connection: pal/loopback
+ *          does not run the presentation layer handshake, and symmetric encryption always
+ *          asks for command protection. Record protection (AES-CCM) is thus not measured.
+ */
+
+#ifndef _OPTIGA_LIB_CONFIG_BENCH_H_
+#define _OPTIGA_LIB_CONFIG_BENCH_H_
+
+#include "optiga_lib_config_m_v3.h"
+
+#undef OPTIGA_COMMS_SHIELDED_CONNECTION
+
+#endif /* _OPTIGA_LIB_CONFIG_BENCH_H_ */
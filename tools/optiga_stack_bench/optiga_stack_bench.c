@@ -0,0 +1,228 @@
+/********************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2024-2025 TESA
+ * All rights reserved.</center></h2>
+ *
+ * This source code and any compilation or derivative thereof is the
+ * proprietary information of TESA and is confidential in nature.
+ *
+ ********************************************************************************
+ * Project : OPTIGA Secure Data Logging Tutorial Series
+ ********************************************************************************
+ * Module  : Part 2 - Encrypted Data Logging (Key in OPTIGA)
+ * Purpose : Software cost of the OPTIGA host library, without bus or device time.
+ * Design  : See README.md for explanation
+ ********************************************************************************
+ * @file    optiga_stack_bench.c
+ * @brief   Host benchmark of optiga_cmd and ifx_i2c on pal/loopback
+ * @author  TESA Workshop Team
+ * @date    January 10, 2026
+ * @version 2.0.0
+ *
+ * @note    pal/loopback answers every I2C transfer from memory at once and its
+ *          event PAL ignores the requested delays, so the time a request takes
+ *          here is CPU time in optiga_util/optiga_crypt, optiga_cmd and the
+ *          ifx_i2c layers. Time spent in the emulated OPTIGA is measured by the
+ *          PAL and subtracted. Each case runs at two sizes; the difference gives
+ *          the cost per byte, the rest is the cost per command. One line
+ *          "BENCH {json}" per case, then "BENCH_DONE".
+ *******************************************************************************/
+
+/* -------------------------------------------------------------------- */
+/* Includes                                                             */
+/* -------------------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "optiga/optiga_crypt.h"
+#include "optiga/optiga_util.h"
+#include "pal_loopback.h"
+
+#ifndef STACK_BENCH_ITERATIONS
+#define STACK_BENCH_ITERATIONS  2000
+#endif
+#define STACK_BENCH_WARMUP      50
+#define STACK_BENCH_READ_OID    0xE0E0      // device certificate slot, any OID reads pattern data
+#define STACK_BENCH_MAX_BYTES   1024
+
+typedef enum {
+    CASE_READ_DATA,
+    CASE_HASH,
+    CASE_ENCRYPT_ECB,
+} bench_case_t;
+
+typedef struct {
+    const char *name;
+    bench_case_t id;
+    uint16_t small_bytes;
+    uint16_t large_bytes;
+} bench_def_t;
+
+typedef struct {
+    double stack_ns;            // per command, emulated device time removed
+    pal_loopback_stats_t stats; // sums over the timed iterations
+} bench_run_t;
+
+// --------------------
+// Globals
+// --------------------
+static const bench_def_t s_cases[] = {
+    { "read_data",   CASE_READ_DATA,   16, STACK_BENCH_MAX_BYTES },
+    { "hash_sha256", CASE_HASH,        64, STACK_BENCH_MAX_BYTES },
+    { "encrypt_ecb", CASE_ENCRYPT_ECB, 16, STACK_BENCH_MAX_BYTES },
+};
+
+static volatile optiga_lib_status_t s_status;
+static optiga_util_t *s_util;
+static optiga_crypt_t *s_crypt;
+static uint8_t s_in[STACK_BENCH_MAX_BYTES];
+static uint8_t s_out[STACK_BENCH_MAX_BYTES + 64];
+
+// --------------------
+// Helpers
+// --------------------
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void bench_callback(void *context, optiga_lib_status_t return_status)
+{
+    s_status = return_status;
+}
+
+// Drives the request to completion: the loopback PAL runs nothing on its own
+static optiga_lib_status_t bench_wait(optiga_lib_status_t start_status)
+{
+    if (start_status != OPTIGA_LIB_SUCCESS) {
+        return start_status;
+    }
+    while (s_status == OPTIGA_LIB_BUSY) {
+        if (pal_os_event_process() == 0 && s_status == OPTIGA_LIB_BUSY) {
+            // Nothing scheduled and no callback: the stack lost the request
+            return OPTIGA_LIB_BUSY;
+        }
+    }
+    return s_status;
+}
+
+static optiga_lib_status_t run_once(bench_case_t id, uint16_t bytes)
+{
+    optiga_lib_status_t ret;
+
+    s_status = OPTIGA_LIB_BUSY;
+    switch (id) {
+    case CASE_READ_DATA: {
+        uint16_t length = bytes;
+        ret = bench_wait(optiga_util_read_data(s_util, STACK_BENCH_READ_OID, 0, s_out, &length));
+        break;
+    }
+    case CASE_HASH: {
+        const hash_data_from_host_t data = { s_in, bytes };
+        ret = bench_wait(optiga_crypt_hash(s_crypt, OPTIGA_HASH_TYPE_SHA_256, OPTIGA_CRYPT_HOST_DATA,
+                                           &data, s_out));
+        break;
+    }
+    case CASE_ENCRYPT_ECB:
+    default: {
+        uint32_t length = sizeof(s_out);
+        ret = bench_wait(optiga_crypt_symmetric_encrypt_ecb(s_crypt, OPTIGA_KEY_ID_SECRET_BASED,
+                                                            s_in, bytes, s_out, &length));
+        break;
+    }
+    }
+    return ret;
+}
+
+static int run_case(const bench_def_t *def, uint16_t bytes, bench_run_t *run)
+{
+    for (int i = 0; i < STACK_BENCH_WARMUP; i++) {
+        const optiga_lib_status_t ret = run_once(def->id, bytes);
+        if (ret != OPTIGA_LIB_SUCCESS) {
+            fprintf(stderr, "%s (%u bytes) failed: 0x%04X\n", def->name, (unsigned)bytes, ret);
+            return -1;
+        }
+    }
+
+    pal_loopback_reset_stats();
+    const uint64_t start = now_ns();
+    for (int i = 0; i < STACK_BENCH_ITERATIONS; i++) {
+        const optiga_lib_status_t ret = run_once(def->id, bytes);
+        if (ret != OPTIGA_LIB_SUCCESS) {
+            fprintf(stderr, "%s (%u bytes) failed: 0x%04X\n", def->name, (unsigned)bytes, ret);
+            return -1;
+        }
+    }
+    const uint64_t elapsed = now_ns() - start;
+    pal_loopback_get_stats(&run->stats);
+    run->stack_ns = (double)(elapsed - run->stats.device_ns) / STACK_BENCH_ITERATIONS;
+    return 0;
+}
+
+static void print_case(const bench_def_t *def, const bench_run_t *small, const bench_run_t *large)
+{
+    const double n = STACK_BENCH_ITERATIONS;
+    const double ns_per_byte = (large->stack_ns - small->stack_ns) /
+                               (double)(def->large_bytes - def->small_bytes);
+    const double ns_per_cmd = small->stack_ns - ns_per_byte * def->small_bytes;
+    const pal_loopback_stats_t *s = &large->stats;
+
+    printf("BENCH {\"case\":\"%s\",\"iterations\":%d,"
+           "\"small\":{\"bytes\":%u,\"ns\":%.0f},\"large\":{\"bytes\":%u,\"ns\":%.0f},"
+           "\"ns_per_cmd\":%.0f,\"ns_per_byte\":%.2f,"
+           "\"large_per_cmd\":{\"apdus\":%.2f,\"i2c_writes\":%.1f,\"i2c_reads\":%.1f,"
+           "\"frames_out\":%.1f,\"frames_in\":%.1f,\"events\":%.1f,\"bus_wait_us\":%.0f}}\n",
+           def->name, STACK_BENCH_ITERATIONS,
+           (unsigned)def->small_bytes, small->stack_ns, (unsigned)def->large_bytes, large->stack_ns,
+           ns_per_cmd, ns_per_byte,
+           s->apdus / n, s->i2c_writes / n, s->i2c_reads / n,
+           s->frames_received / n, s->frames_sent / n, s->events / n,
+           (double)s->requested_delay_us / n);
+}
+
+// --------------------
+// Main
+// --------------------
+int main(void)
+{
+    int failed = 0;
+
+    for (size_t i = 0; i < sizeof(s_in); i++) {
+        s_in[i] = (uint8_t)i;
+    }
+
+    s_util = optiga_util_create(0, bench_callback, NULL);
+    s_crypt = optiga_crypt_create(0, bench_callback, NULL);
+    if (s_util == NULL || s_crypt == NULL) {
+        fprintf(stderr, "optiga instance create failed\n");
+        return 1;
+    }
+    s_status = OPTIGA_LIB_BUSY;
+    optiga_lib_status_t ret = bench_wait(optiga_util_open_application(s_util, 0));
+    if (ret != OPTIGA_LIB_SUCCESS) {
+        fprintf(stderr, "optiga_util_open_application failed: 0x%04X\n", ret);
+        return 1;
+    }
+
+    for (size_t i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++) {
+        bench_run_t small, large;
+        if (run_case(&s_cases[i], s_cases[i].small_bytes, &small) != 0 ||
+            run_case(&s_cases[i], s_cases[i].large_bytes, &large) != 0) {
+            failed = 1;
+            continue;
+        }
+        print_case(&s_cases[i], &small, &large);
+    }
+    printf("BENCH_DONE\n");
+
+    s_status = OPTIGA_LIB_BUSY;
+    (void)bench_wait(optiga_util_close_application(s_util, 0));
+    (void)optiga_crypt_destroy(s_crypt);
+    (void)optiga_util_destroy(s_util);
+    return failed;
+}
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""Pack a protected update data set for the logger's streaming updater.
+
+Reads the output file of examples/tools/protected_update_data_set (the C arrays
+manifest_data[] and fragment_01[], fragment_02[], ...) and writes the partition
+image main/log_update.h describes: a 16-byte header, the manifest, then the
+fragments back to back. Serve it over HTTP for console '5', or write it to the
+partition directly and apply it with '5 -':
+
+    python tools/optiga_update_pack.py key_update.txt -o optiga_update.bin
+    python -m http.server 8070
+    parttool.py write_partition --partition-name optiga_upd --input optiga_update.bin
+"""
+import argparse
+import re
+import struct
+import sys
+
+UPDATE_MAGIC = 0x5055504F   # "OPUP"
+UPDATE_FORMAT = 1
+PARTITION_BYTES = 64 * 1024  # optiga_upd in partitions.csv
+
+ARRAY = re.compile(r"uint8_t\s+(\w+)\s*\[\s*\]\s*=\s*\{([^}]*)\}")
+
+
+def parse_arrays(text):
+    arrays = {}
+    for name, body in ARRAY.findall(text):
+        arrays[name] = bytes(int(v, 16) for v in re.findall(r"0x([0-9A-Fa-f]{1,2})", body))
+    return arrays
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("dataset", help="output file of protected_update_data_set")
+    ap.add_argument("-o", "--output", default="optiga_update.bin")
+    ap.add_argument("--manifest-version", type=int, default=1)
+    args = ap.parse_args()
+
+    with open(args.dataset) as f:
+        arrays = parse_arrays(f.read())
+    manifest = arrays.get("manifest_data")
+    names = sorted(n for n in arrays if re.fullmatch(r"fragment_\d+", n))
+    if not manifest or not names:
+        sys.exit(f"{args.dataset}: no manifest_data[] and fragment_NN[] arrays")
+    fragments = [arrays[n] for n in names]
+    if [int(n[len("fragment_"):]) for n in names] != list(range(1, len(names) + 1)):
+        sys.exit(f"{args.dataset}: fragments not numbered 1..{len(names)}")
+    # The device cuts the payload at fragment_len, so only the last one may be shorter
+    fragment_len = len(fragments[0])
+    if any(len(f) != fragment_len for f in fragments[:-1]) or len(fragments[-1]) > fragment_len:
+        sys.exit(f"{args.dataset}: fragments differ in length before the last one")
+
+    payload = b"".join(fragments)
+    header = struct.pack("<IBBHHHI", UPDATE_MAGIC, UPDATE_FORMAT, args.manifest_version,
+                         len(manifest), fragment_len, 0, len(payload))
+    image = header + manifest + payload
+    if len(image) > PARTITION_BYTES:
+        sys.exit(f"{len(image)} bytes, the partition holds {PARTITION_BYTES}")
+    with open(args.output, "wb") as f:
+        f.write(image)
+    print(f"wrote {args.output}: manifest {len(manifest)} bytes, {len(fragments)} fragments, "
+          f"{len(payload)} bytes")
+
+
+if __name__ == "__main__":
+    main()